@@ -1,5 +1,6 @@
 #include "fixtures/tree_factory.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <functional>
 #include <stdexcept>
@@ -104,6 +105,7 @@ tree_fixture make_static_fixture(tree_family family, std::size_t node_count) {
             .node_count = 1,
             .leaf_count = 1,
             .async_leaf_count = 0,
+            .depth = 1,
         };
     }
 
@@ -114,6 +116,55 @@ tree_fixture make_static_fixture(tree_family family, std::size_t node_count) {
     fixture.node_count = node_count;
     fixture.leaf_count = (node_count + 1u) / 2u;
     fixture.async_leaf_count = 0;
+    fixture.depth = levels;
+    return fixture;
+}
+
+// A complete tree in heap order: node i has children i * fanout + 1 through i * fanout + fanout, so
+// any node count works and depth follows from fan-out. As in make_static_subtree, every child but
+// the last keeps its composite going, so each tick visits every node.
+fixture_node make_fanout_subtree(tree_family family,
+                                 std::size_t index,
+                                 std::size_t node_count,
+                                 std::size_t fanout,
+                                 std::size_t depth,
+                                 bool success,
+                                 std::size_t& leaf_index,
+                                 std::size_t& max_depth) {
+    max_depth = std::max(max_depth, depth);
+    const std::size_t first_child = index * fanout + 1u;
+    if (first_child >= node_count) {
+        return make_boolean_leaf(success, leaf_index++);
+    }
+
+    const std::size_t end_child = std::min(first_child + fanout, node_count);
+    const fixture_node_kind kind = static_composite_kind(family, depth);
+    fixture_node node{.kind = kind};
+    node.children.reserve(end_child - first_child);
+    for (std::size_t child = first_child; child < end_child; ++child) {
+        const bool child_success = child + 1u == end_child ? success : kind == fixture_node_kind::seq;
+        node.children.push_back(
+            make_fanout_subtree(family, child, node_count, fanout, depth + 1u, child_success, leaf_index, max_depth));
+    }
+    return node;
+}
+
+tree_fixture make_fanout_fixture(tree_family family, std::size_t node_count, std::size_t fanout) {
+    if (node_count == 0u) {
+        throw std::invalid_argument("fan-out fixture: node count must be positive");
+    }
+    if (fanout < 2u) {
+        throw std::invalid_argument("fan-out fixture: fan-out must be at least 2");
+    }
+
+    std::size_t leaf_index = 0;
+    std::size_t max_depth = 0;
+    tree_fixture fixture;
+    fixture.root = make_fanout_subtree(family, 0u, node_count, fanout, 0u, true, leaf_index, max_depth);
+    fixture.node_count = node_count;
+    fixture.leaf_count = leaf_index;
+    fixture.async_leaf_count = 0;
+    fixture.depth = max_depth + 1u;
     return fixture;
 }
 
@@ -159,23 +210,48 @@ tree_fixture make_reactive_fixture(std::size_t node_count) {
         .node_count = node_count,
         .leaf_count = (node_count + 1u) / 2u,
         .async_leaf_count = 1,
+        .depth = branch_levels + 1u,
     };
 }
 
-}  // namespace
+// Swaps every succeeding condition for one that also reads the blackboard.
+void use_blackboard_read_conditions(fixture_node& node) {
+    if (node.kind == fixture_node_kind::cond && node.leaf_name == "cond_ok") {
+        node.leaf_name = "cond_bb_ok";
+    }
+    for (fixture_node& child : node.children) {
+        use_blackboard_read_conditions(child);
+    }
+}
 
-tree_fixture make_fixture(const scenario_definition& scenario) {
+tree_fixture make_scenario_fixture(const scenario_definition& scenario) {
     switch (scenario.kind) {
         case benchmark_kind::single_leaf:
         case benchmark_kind::memory_gc:
         case benchmark_kind::async_contract:
+        case benchmark_kind::planner:
+        case benchmark_kind::lisp_eval:
+        case benchmark_kind::memory_footprint:
         case benchmark_kind::static_tick:
+        case benchmark_kind::open_loop:
         case benchmark_kind::compile_lifecycle:
             return make_static_fixture(scenario.family, scenario.tree_size_nodes);
         case benchmark_kind::reactive_interrupt:
             return make_reactive_fixture(scenario.tree_size_nodes);
+        case benchmark_kind::scaling:
+            return make_fanout_fixture(scenario.family, scenario.tree_size_nodes, scenario.fanout);
     }
     throw std::invalid_argument("tree fixture: unsupported scenario kind");
 }
 
+}  // namespace
+
+tree_fixture make_fixture(const scenario_definition& scenario) {
+    tree_fixture fixture = make_scenario_fixture(scenario);
+    if (scenario.blackboard_reads) {
+        use_blackboard_read_conditions(fixture.root);
+    }
+    return fixture;
+}
+
 }  // namespace muesli_bt::bench
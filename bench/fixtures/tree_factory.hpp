@@ -18,8 +18,8 @@ enum class fixture_node_kind {
 
 struct fixture_node {
     fixture_node_kind kind = fixture_node_kind::seq;
-    std::string leaf_name;
-    std::vector<fixture_node> children;
+    std::string leaf_name{};
+    std::vector<fixture_node> children{};
 };
 
 struct tree_fixture {
@@ -27,6 +27,8 @@ struct tree_fixture {
     std::size_t node_count = 0;
     std::size_t leaf_count = 0;
     std::size_t async_leaf_count = 0;
+    // Levels from the root to the deepest leaf, counting both.
+    std::size_t depth = 0;
 };
 
 tree_fixture make_fixture(const scenario_definition& scenario);
@@ -145,6 +145,19 @@ void csv_writer::write_summaries(const std::filesystem::path& output_dir,
                         "dropped_completion_count",
                         "dropped_completion_rate",
                         "semantic_errors",
+                        "cpu_cycles",
+                        "cpu_instructions",
+                        "l1d_read_misses",
+                        "llc_misses",
+                        "branch_misses",
+                        "tree_depth",
+                        "tree_fanout",
+                        "instance_count",
+                        "ns_per_node_tick",
+                        "instance_bytes",
+                        "instance_create_ns",
+                        "gc_objects_per_op",
+                        "alloc_bytes_per_op",
                         "notes"});
 
         for (const run_summary_row& row : run_rows) {
@@ -217,6 +230,19 @@ void csv_writer::write_summaries(const std::filesystem::path& output_dir,
                             format_value(row.dropped_completion_count),
                             format_value(row.dropped_completion_rate),
                             format_value(row.semantic_errors),
+                            format_optional(row.cpu_cycles),
+                            format_optional(row.cpu_instructions),
+                            format_optional(row.l1d_read_misses),
+                            format_optional(row.llc_misses),
+                            format_optional(row.branch_misses),
+                            format_optional(row.tree_depth),
+                            format_optional(row.tree_fanout),
+                            format_optional(row.instance_count),
+                            format_optional(row.ns_per_node_tick),
+                            format_optional(row.instance_bytes),
+                            format_optional(row.instance_create_ns),
+                            format_optional(row.gc_objects_per_op),
+                            format_optional(row.alloc_bytes_per_op),
                             row.notes});
         }
     }
@@ -338,6 +364,7 @@ void csv_writer::write_summaries(const std::filesystem::path& output_dir,
                         "harness_commit",
                         "clock_source",
                         "allocator_mode",
+                        "perf_counters",
                         "notes"});
         write_csv_line(out,
                        {environment_row.schema_version,
@@ -365,6 +392,7 @@ void csv_writer::write_summaries(const std::filesystem::path& output_dir,
                         environment_row.harness_commit,
                         environment_row.clock_source,
                         environment_row.allocator_mode,
+                        environment_row.perf_counters,
                         environment_row.notes});
     }
 }
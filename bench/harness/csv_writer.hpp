@@ -79,6 +79,26 @@ struct run_summary_row {
     std::uint64_t dropped_completion_count = 0;
     double dropped_completion_rate = 0.0;
     std::uint64_t semantic_errors = 0;
+    // Hardware counters over the timed tick loop; empty unless the run asked for them and the host
+    // provides them (see perf_counter_group).
+    std::optional<std::uint64_t> cpu_cycles;
+    std::optional<std::uint64_t> cpu_instructions;
+    std::optional<std::uint64_t> l1d_read_misses;
+    std::optional<std::uint64_t> llc_misses;
+    std::optional<std::uint64_t> branch_misses;
+    // B10 scaling rows only, except that B14 footprint rows also fill instance_count and instance_bytes.
+    // ns_per_node_tick is the median round latency over instances times nodes; instance_bytes and
+    // instance_create_ns are per-instance means.
+    std::optional<std::size_t> tree_depth;
+    std::optional<std::size_t> tree_fanout;
+    std::optional<std::size_t> instance_count;
+    std::optional<double> ns_per_node_tick;
+    std::optional<std::uint64_t> instance_bytes;
+    std::optional<std::uint64_t> instance_create_ns;
+    // B13 Lisp rows only: Lisp heap objects allocated per operation (from the GC stats) and C++
+    // heap bytes allocated per operation (from the allocation tracker).
+    std::optional<double> gc_objects_per_op;
+    std::optional<double> alloc_bytes_per_op;
     std::string notes;
 };
 
@@ -151,6 +171,7 @@ struct environment_metadata_row {
     std::string harness_commit;
     std::string clock_source;
     std::string allocator_mode;
+    std::string perf_counters;
     std::string notes;
 };
 
@@ -212,6 +212,7 @@ environment_info collect_environment() {
     info.harness_commit = MUESLI_BT_BENCH_GIT_COMMIT;
     info.clock_source = "std::chrono::steady_clock";
     info.allocator_mode = "global_new_counter";
+    info.perf_counters = "off";
     info.notes = environment_notes(info.cpu_governor);
     info.machine_id = hash64_hex(info.hostname + "|" + info.cpu_model + "|" + info.os_name + "|" + info.kernel_version);
     return info;
@@ -30,6 +30,8 @@ struct environment_info {
     std::string harness_commit;
     std::string clock_source = "std::chrono::steady_clock";
     std::string allocator_mode = "global_new_counter";
+    // "off", the hardware counters captured per run, or "unavailable: <reason>".
+    std::string perf_counters = "off";
     std::string notes;
 };
 
@@ -0,0 +1,183 @@
+#include "harness/perf_counters.hpp"
+
+#include <cerrno>
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace muesli_bt::bench {
+namespace {
+
+constexpr std::array<const char*, 5> k_counter_names{
+    "cycles",
+    "instructions",
+    "l1d_read_misses",
+    "llc_misses",
+    "branch_misses",
+};
+
+#if defined(__linux__)
+
+struct counter_config {
+    std::uint32_t type = 0;
+    std::uint64_t config = 0;
+};
+
+constexpr std::array<counter_config, 5> k_counter_configs{{
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HW_CACHE,
+     PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8u) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16u)},
+    // The generic cache-miss event, which the kernel maps to last-level cache misses.
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+}};
+
+int open_counter(const counter_config& counter) noexcept {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = counter.type;
+    attr.config = counter.config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+std::optional<std::uint64_t> read_counter(int fd) noexcept {
+    std::uint64_t values[3] = {0, 0, 0};
+    if (::read(fd, values, sizeof(values)) != static_cast<ssize_t>(sizeof(values))) {
+        return std::nullopt;
+    }
+    const std::uint64_t count = values[0];
+    const std::uint64_t enabled = values[1];
+    const std::uint64_t running = values[2];
+    if (running == 0u) {
+        return std::nullopt;
+    }
+    if (running >= enabled) {
+        return count;
+    }
+    return static_cast<std::uint64_t>(static_cast<double>(count) * static_cast<double>(enabled) /
+                                      static_cast<double>(running));
+}
+
+std::string open_failure_reason(int error) {
+    if (error == ENOENT || error == EOPNOTSUPP) {
+        return "no hardware PMU events on this host";
+    }
+    std::string reason = std::strerror(error);
+    if (error == EACCES || error == EPERM) {
+        reason += " (check /proc/sys/kernel/perf_event_paranoid)";
+    }
+    return reason;
+}
+
+std::optional<std::uint64_t>& sample_field(perf_counter_sample& sample, std::size_t index) noexcept {
+    switch (index) {
+        case 0:
+            return sample.cpu_cycles;
+        case 1:
+            return sample.cpu_instructions;
+        case 2:
+            return sample.l1d_read_misses;
+        case 3:
+            return sample.llc_misses;
+        default:
+            return sample.branch_misses;
+    }
+}
+
+#endif
+
+}  // namespace
+
+perf_counter_group::perf_counter_group() {
+    fds_.fill(-1);
+#if defined(__linux__)
+    int first_error = 0;
+    for (std::size_t index = 0; index < k_counter_count; ++index) {
+        fds_[index] = open_counter(k_counter_configs[index]);
+        if (fds_[index] < 0 && first_error == 0) {
+            first_error = errno;
+        }
+    }
+    if (!available()) {
+        unavailable_reason_ = open_failure_reason(first_error);
+    }
+#else
+    unavailable_reason_ = "perf_event_open is Linux only";
+#endif
+}
+
+perf_counter_group::~perf_counter_group() {
+#if defined(__linux__)
+    for (const int fd : fds_) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+#endif
+}
+
+bool perf_counter_group::available() const noexcept {
+    for (const int fd : fds_) {
+        if (fd >= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string perf_counter_group::description() const {
+    if (!available()) {
+        return "unavailable: " + unavailable_reason_;
+    }
+    std::string names;
+    for (std::size_t index = 0; index < k_counter_count; ++index) {
+        if (fds_[index] < 0) {
+            continue;
+        }
+        if (!names.empty()) {
+            names += ",";
+        }
+        names += k_counter_names[index];
+    }
+    return names;
+}
+
+void perf_counter_group::start() noexcept {
+#if defined(__linux__)
+    for (const int fd : fds_) {
+        if (fd >= 0) {
+            ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+}
+
+perf_counter_sample perf_counter_group::stop() noexcept {
+    perf_counter_sample sample;
+#if defined(__linux__)
+    for (const int fd : fds_) {
+        if (fd >= 0) {
+            ::ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+    for (std::size_t index = 0; index < k_counter_count; ++index) {
+        if (fds_[index] >= 0) {
+            sample_field(sample, index) = read_counter(fds_[index]);
+        }
+    }
+#endif
+    return sample;
+}
+
+}  // namespace muesli_bt::bench
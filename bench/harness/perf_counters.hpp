@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace muesli_bt::bench {
+
+// Hardware counter totals over one timed run. A counter that could not be opened, or that the PMU
+// never scheduled, is nullopt and written as an empty CSV cell.
+struct perf_counter_sample {
+    std::optional<std::uint64_t> cpu_cycles;
+    std::optional<std::uint64_t> cpu_instructions;
+    std::optional<std::uint64_t> l1d_read_misses;
+    std::optional<std::uint64_t> llc_misses;
+    std::optional<std::uint64_t> branch_misses;
+};
+
+// User-space hardware counters of the calling thread, read through perf_event_open(2). Each counter
+// is opened on its own, so a PMU without one event still reports the others. When none opens (no
+// PMU in a VM, perf_event_paranoid too strict, a non-Linux host) the group is unavailable and every
+// sample is empty. Counts are scaled by enabled/running time when the kernel multiplexes the PMU.
+//
+// start() and stop() only issue ioctl and read calls, so they do not allocate and may bracket an
+// allocation-tracked loop.
+class perf_counter_group {
+public:
+    perf_counter_group();
+    ~perf_counter_group();
+
+    perf_counter_group(const perf_counter_group&) = delete;
+    perf_counter_group& operator=(const perf_counter_group&) = delete;
+
+    [[nodiscard]] bool available() const noexcept;
+    // Comma-separated names of the counters that opened, or "unavailable: <reason>".
+    [[nodiscard]] std::string description() const;
+
+    // Zeroes and enables every open counter.
+    void start() noexcept;
+    // Disables every open counter and returns the totals since start().
+    perf_counter_sample stop() noexcept;
+
+private:
+    static constexpr std::size_t k_counter_count = 5;
+
+    std::array<int, k_counter_count> fds_;
+    std::string unavailable_reason_;
+};
+
+}  // namespace muesli_bt::bench
@@ -0,0 +1,283 @@
+#include "harness/regression_gate.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+
+#include "harness/stats.hpp"
+
+namespace muesli_bt::bench {
+namespace {
+
+constexpr const char* k_report_schema_version = "1";
+
+// Splits one RFC 4180 record. Quoted fields may hold commas and doubled quotes; the writer never
+// emits embedded newlines in the columns the gate reads.
+std::vector<std::string> split_csv_record(std::string_view line) {
+    std::vector<std::string> fields;
+    std::string field;
+    bool quoted = false;
+    for (std::size_t index = 0; index < line.size(); ++index) {
+        const char ch = line[index];
+        if (quoted) {
+            if (ch == '"' && index + 1u < line.size() && line[index + 1u] == '"') {
+                field.push_back('"');
+                ++index;
+            } else if (ch == '"') {
+                quoted = false;
+            } else {
+                field.push_back(ch);
+            }
+        } else if (ch == '"') {
+            quoted = true;
+        } else if (ch == ',') {
+            fields.push_back(std::move(field));
+            field.clear();
+        } else if (ch != '\r') {
+            field.push_back(ch);
+        }
+    }
+    fields.push_back(std::move(field));
+    return fields;
+}
+
+std::size_t require_column(const std::vector<std::string>& header,
+                           std::string_view name,
+                           const std::filesystem::path& path) {
+    const auto found = std::find(header.begin(), header.end(), name);
+    if (found == header.end()) {
+        throw std::runtime_error("regression gate: " + path.string() + " has no " + std::string(name) + " column");
+    }
+    return static_cast<std::size_t>(found - header.begin());
+}
+
+std::optional<double> parse_cell(const std::vector<std::string>& fields, std::size_t column) {
+    if (column >= fields.size() || fields[column].empty()) {
+        return std::nullopt;
+    }
+    try {
+        return std::stod(fields[column]);
+    } catch (const std::exception&) {
+        return std::nullopt;
+    }
+}
+
+double median_of(std::vector<double> values) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    const std::size_t mid = values.size() / 2u;
+    if (values.size() % 2u == 1u) {
+        return values[mid];
+    }
+    return (values[mid - 1u] + values[mid]) / 2.0;
+}
+
+std::string json_escape(std::string_view value) {
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (const char ch : value) {
+        switch (ch) {
+            case '\\':
+                escaped += "\\\\";
+                break;
+            case '"':
+                escaped += "\\\"";
+                break;
+            case '\n':
+                escaped += "\\n";
+                break;
+            default:
+                escaped.push_back(ch);
+                break;
+        }
+    }
+    return escaped;
+}
+
+std::string json_string(std::string_view value) {
+    const std::string escaped = json_escape(value);
+    std::string out;
+    out.reserve(escaped.size() + 2);
+    out.append(1, '"').append(escaped).append(1, '"');
+    return out;
+}
+
+std::string json_double(double value) {
+    std::ostringstream out;
+    out << std::setprecision(9) << value;
+    return out.str();
+}
+
+}  // namespace
+
+std::size_t gate_report::regression_count() const noexcept {
+    return static_cast<std::size_t>(std::count_if(comparisons.begin(), comparisons.end(), [](const gate_comparison& c) {
+        return c.verdict == gate_verdict::regression;
+    }));
+}
+
+const char* gate_verdict_name(gate_verdict verdict) noexcept {
+    switch (verdict) {
+        case gate_verdict::unchanged:
+            return "unchanged";
+        case gate_verdict::regression:
+            return "regression";
+        case gate_verdict::improvement:
+            return "improvement";
+        case gate_verdict::no_baseline:
+            return "no_baseline";
+    }
+    return "unchanged";
+}
+
+gate_samples load_gate_samples(const std::filesystem::path& path) {
+    const std::filesystem::path file =
+        std::filesystem::is_directory(path) ? path / "run_summary.csv" : path;
+    std::ifstream in(file);
+    if (!in) {
+        throw std::runtime_error("regression gate: cannot read " + file.string());
+    }
+
+    std::string line;
+    if (!std::getline(in, line)) {
+        throw std::runtime_error("regression gate: " + file.string() + " is empty");
+    }
+    const std::vector<std::string> header = split_csv_record(line);
+    const std::size_t runtime_column = require_column(header, "runtime_name", file);
+    const std::size_t scenario_column = require_column(header, "scenario_id", file);
+    const std::size_t ticks_column = require_column(header, "ticks_total", file);
+    const std::size_t median_column = require_column(header, "latency_ns_median", file);
+    const std::size_t p99_column = require_column(header, "latency_ns_p99", file);
+    const std::size_t alloc_column = require_column(header, "alloc_count_total", file);
+
+    gate_samples samples;
+    while (std::getline(in, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        const std::vector<std::string> fields = split_csv_record(line);
+        if (scenario_column >= fields.size() || runtime_column >= fields.size()) {
+            continue;
+        }
+        std::map<std::string, std::vector<double>>& metrics =
+            samples[{fields[runtime_column], fields[scenario_column]}];
+        if (const std::optional<double> median = parse_cell(fields, median_column)) {
+            metrics["latency_ns_median"].push_back(*median);
+        }
+        if (const std::optional<double> p99 = parse_cell(fields, p99_column)) {
+            metrics["latency_ns_p99"].push_back(*p99);
+        }
+        const std::optional<double> ticks = parse_cell(fields, ticks_column);
+        const std::optional<double> allocs = parse_cell(fields, alloc_column);
+        if (ticks.has_value() && allocs.has_value() && *ticks > 0.0) {
+            metrics["allocs_per_tick"].push_back(*allocs / *ticks);
+        }
+    }
+    return samples;
+}
+
+std::vector<gate_comparison> compare_gate_samples(const gate_samples& baseline,
+                                                  const gate_samples& current,
+                                                  const gate_options& options) {
+    std::vector<gate_comparison> comparisons;
+    for (const auto& [key, metrics] : current) {
+        const auto baseline_entry = baseline.find(key);
+        for (const auto& [metric, values] : metrics) {
+            gate_comparison comparison;
+            comparison.runtime_name = key.first;
+            comparison.scenario_id = key.second;
+            comparison.metric = metric;
+            comparison.current_samples = values.size();
+            comparison.current_median = median_of(values);
+
+            const std::vector<double>* reference = nullptr;
+            if (baseline_entry != baseline.end()) {
+                const auto found = baseline_entry->second.find(metric);
+                if (found != baseline_entry->second.end() && !found->second.empty()) {
+                    reference = &found->second;
+                }
+            }
+            if (reference == nullptr || values.empty()) {
+                comparison.verdict = gate_verdict::no_baseline;
+                comparisons.push_back(std::move(comparison));
+                continue;
+            }
+
+            comparison.baseline_samples = reference->size();
+            comparison.baseline_median = median_of(*reference);
+            const double delta = comparison.current_median - comparison.baseline_median;
+            if (comparison.baseline_median != 0.0) {
+                comparison.relative_change = delta / comparison.baseline_median;
+            } else if (delta == 0.0) {
+                comparison.relative_change = 0.0;
+            }
+
+            // A zero baseline (an allocation-free scenario) regresses on any growth.
+            const bool beyond_threshold =
+                !comparison.relative_change.has_value() || std::abs(*comparison.relative_change) > options.threshold;
+            if (delta > 0.0) {
+                comparison.p_value = mann_whitney_greater_p(*reference, values);
+                if (beyond_threshold && comparison.p_value <= options.alpha) {
+                    comparison.verdict = gate_verdict::regression;
+                }
+            } else if (delta < 0.0) {
+                comparison.p_value = mann_whitney_greater_p(values, *reference);
+                if (beyond_threshold && comparison.p_value <= options.alpha) {
+                    comparison.verdict = gate_verdict::improvement;
+                }
+            }
+            comparisons.push_back(std::move(comparison));
+        }
+    }
+    return comparisons;
+}
+
+gate_report run_regression_gate(const std::filesystem::path& baseline_path,
+                                const std::filesystem::path& current_path,
+                                const gate_options& options) {
+    gate_report report;
+    report.baseline_path = baseline_path;
+    report.current_path = current_path;
+    report.options = options;
+    report.comparisons = compare_gate_samples(load_gate_samples(baseline_path), load_gate_samples(current_path), options);
+    return report;
+}
+
+void write_regression_report(const std::filesystem::path& output_dir, const gate_report& report) {
+    std::filesystem::create_directories(output_dir);
+    std::ofstream out(output_dir / "regression_report.json", std::ios::trunc);
+    out << "{\n"
+        << "  \"schema_version\": " << json_string(k_report_schema_version) << ",\n"
+        << "  \"baseline\": " << json_string(report.baseline_path.string()) << ",\n"
+        << "  \"current\": " << json_string(report.current_path.string()) << ",\n"
+        << "  \"test\": \"mann-whitney-u-one-sided\",\n"
+        << "  \"threshold\": " << json_double(report.options.threshold) << ",\n"
+        << "  \"alpha\": " << json_double(report.options.alpha) << ",\n"
+        << "  \"passed\": " << (report.passed() ? "true" : "false") << ",\n"
+        << "  \"regressions\": " << report.regression_count() << ",\n"
+        << "  \"comparisons\": [";
+    for (std::size_t index = 0; index < report.comparisons.size(); ++index) {
+        const gate_comparison& c = report.comparisons[index];
+        out << (index == 0u ? "\n" : ",\n")
+            << "    {\"runtime_name\": " << json_string(c.runtime_name)
+            << ", \"scenario_id\": " << json_string(c.scenario_id)
+            << ", \"metric\": " << json_string(c.metric)
+            << ", \"verdict\": " << json_string(gate_verdict_name(c.verdict))
+            << ", \"baseline_samples\": " << c.baseline_samples
+            << ", \"current_samples\": " << c.current_samples
+            << ", \"baseline_median\": " << json_double(c.baseline_median)
+            << ", \"current_median\": " << json_double(c.current_median)
+            << ", \"relative_change\": "
+            << (c.relative_change.has_value() ? json_double(*c.relative_change) : std::string("null"))
+            << ", \"p_value\": " << json_double(c.p_value) << '}';
+    }
+    out << (report.comparisons.empty() ? "]\n" : "\n  ]\n") << "}\n";
+}
+
+}  // namespace muesli_bt::bench
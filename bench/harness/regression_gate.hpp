@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace muesli_bt::bench {
+
+// Per-repetition values of the gated metrics, keyed by (runtime_name, scenario_id) and then by metric
+// name. Every gated metric is lower-is-better.
+using gate_samples = std::map<std::pair<std::string, std::string>, std::map<std::string, std::vector<double>>>;
+
+struct gate_options {
+    // Smallest relative change of the median that counts, as a fraction (0.05 is 5%).
+    double threshold = 0.05;
+    // A change is significant when the one-sided Mann-Whitney p-value is at most alpha.
+    double alpha = 0.05;
+};
+
+enum class gate_verdict {
+    unchanged,
+    regression,
+    improvement,
+    no_baseline,
+};
+
+struct gate_comparison {
+    std::string runtime_name;
+    std::string scenario_id;
+    std::string metric;
+    std::size_t baseline_samples = 0;
+    std::size_t current_samples = 0;
+    double baseline_median = 0.0;
+    double current_median = 0.0;
+    // (current - baseline) / baseline; nullopt when the baseline median is zero and the current is not.
+    std::optional<double> relative_change;
+    // p-value of the test in the direction of the observed change.
+    double p_value = 1.0;
+    gate_verdict verdict = gate_verdict::unchanged;
+};
+
+struct gate_report {
+    std::filesystem::path baseline_path;
+    std::filesystem::path current_path;
+    gate_options options{};
+    std::vector<gate_comparison> comparisons;
+
+    [[nodiscard]] std::size_t regression_count() const noexcept;
+    [[nodiscard]] bool passed() const noexcept { return regression_count() == 0u; }
+};
+
+[[nodiscard]] const char* gate_verdict_name(gate_verdict verdict) noexcept;
+
+// Reads the gated metrics from a run_summary.csv, or from the run_summary.csv inside a result
+// directory. Throws std::runtime_error when the file cannot be read or lacks a required column.
+[[nodiscard]] gate_samples load_gate_samples(const std::filesystem::path& path);
+
+// Compares every current (runtime, scenario, metric) against the baseline. Baseline entries without a
+// current counterpart are ignored, so a baseline of run-all can gate a single group.
+[[nodiscard]] std::vector<gate_comparison> compare_gate_samples(const gate_samples& baseline,
+                                                                const gate_samples& current,
+                                                                const gate_options& options);
+
+[[nodiscard]] gate_report run_regression_gate(const std::filesystem::path& baseline_path,
+                                              const std::filesystem::path& current_path,
+                                              const gate_options& options);
+
+// Writes regression_report.json into `output_dir`.
+void write_regression_report(const std::filesystem::path& output_dir, const gate_report& report);
+
+}  // namespace muesli_bt::bench
@@ -2,11 +2,13 @@
 
 #include <algorithm>
 #include <atomic>
+#include <cmath>
 #include <condition_variable>
 #include <ctime>
 #include <filesystem>
 #include <fstream>
 #include <iomanip>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <sstream>
@@ -16,22 +18,31 @@
 #include <vector>
 
 #include "bt/event_log.hpp"
+#include "bt/compiler.hpp"
+#include "bt/planner.hpp"
+#include "bt/runtime_host.hpp"
 #include "bt/scheduler.hpp"
 #include "bt/vla.hpp"
 #include "harness/allocation_tracker.hpp"
 #include "harness/metadata.hpp"
+#include "harness/perf_counters.hpp"
 #include "harness/stats.hpp"
 #include "bench_config.hpp"
+#include "fixtures/source_factory.hpp"
 #include "fixtures/tree_factory.hpp"
 #include "muesli_bt/contract/events.hpp"
 #include "muesli_bt/contract/version.hpp"
+#include "muslisp/eval.hpp"
 #include "muslisp/gc.hpp"
+#include "muslisp/reader.hpp"
 #include "muslisp/value.hpp"
 #include "runtimes/muesli_adapter.hpp"
 #if MUESLI_BT_BENCH_WITH_BTCPP
 #include "runtimes/btcpp_adapter.hpp"
 #endif
 
+#include "../../src/compiled_eval.hpp"
+
 namespace muesli_bt::bench {
 namespace {
 
@@ -253,6 +264,32 @@ std::string scenario_description(const scenario_definition& scenario) {
             if (scenario.group_id == "B8") {
                 return "async contract edge (" + scenario.variant + ")";
             }
+            if (scenario.group_id == "B10") {
+                return "scaling " + scenario.variant + " (" + std::to_string(scenario.tree_size_nodes) + " nodes, fan-out " +
+                       std::to_string(scenario.fanout) + ", " + std::to_string(scenario.instance_count) + " instances)";
+            }
+            if (scenario.group_id == "B11") {
+                return "open-loop tail latency (" + std::to_string(scenario.target_hz) + " Hz, " +
+                       (scenario.background_load ? "loaded" : "idle") + ")";
+            }
+            if (scenario.group_id == "B13") {
+                return "lisp " + std::string(lisp_benchmark_op_name(scenario.lisp.op)) + " (" +
+                       (scenario.lisp.interpreted ? "eval" : "compiled_eval") + ")";
+            }
+            if (scenario.group_id == "B14") {
+                return "memory footprint (" + std::to_string(scenario.tree_size_nodes) + " nodes, " +
+                       std::to_string(scenario.instance_count) + " instances)";
+            }
+            if (scenario.group_id == "B12") {
+                return "observability layer " + std::string(logging_mode_name(scenario.logging)) + " (" +
+                       std::to_string(scenario.tree_size_nodes) + " nodes" +
+                       (scenario.blackboard_reads ? ", blackboard reads)" : ")");
+            }
+            if (scenario.group_id == "B9") {
+                return "planner " + std::string(planner_benchmark_backend_name(scenario.planner.backend)) + " (" +
+                       scenario.planner.model + ", horizon " + std::to_string(scenario.planner.horizon) + ", " +
+                       std::to_string(scenario.planner.samples) + " samples)";
+            }
             break;
     }
     return scenario.scenario_id;
@@ -791,6 +828,439 @@ run_summary_row run_async_contract_once(const environment_info& environment,
     return row;
 }
 
+bt::planner_request make_planner_benchmark_request(const planner_benchmark_case& planner_case,
+                                                   std::size_t samples,
+                                                   std::uint64_t seed) {
+    bt::planner_request request;
+    request.model_service = planner_case.model;
+    request.state = planner_case.model == "toy-unicycle" ? bt::planner_vector{0.0, 0.0, 0.0, 1.0, 0.0}
+                                                         : bt::planner_vector{0.0};
+    // The work cap, not the clock, ends every plan, so each one does the same amount of work.
+    request.budget_ms = 60000;
+    request.horizon = static_cast<std::int64_t>(planner_case.horizon);
+    request.seed = seed;
+    request.top_k = 1;
+    request.node_name = "bench-planner";
+    const auto work = static_cast<std::int64_t>(samples);
+    switch (planner_case.backend) {
+        case planner_benchmark_backend::none:
+        case planner_benchmark_backend::mcts:
+            request.planner = bt::planner_backend::mcts;
+            request.work_max = work;
+            request.mcts.max_depth = request.horizon;
+            break;
+        case planner_benchmark_backend::mppi:
+            request.planner = bt::planner_backend::mppi;
+            request.work_max = work;
+            request.mppi.n_samples = work;
+            break;
+        case planner_benchmark_backend::ilqr:
+            request.planner = bt::planner_backend::ilqr;
+            request.work_max = work;
+            request.ilqr.max_iters = work;
+            if (planner_case.model != "toy-1d") {
+                request.ilqr.derivatives = bt::planner_ilqr_derivatives_mode::finite_diff;
+            }
+            break;
+    }
+    return request;
+}
+
+double planner_action_distance(const bt::planner_vector& a, const bt::planner_vector& b) {
+    if (a.size() != b.size()) {
+        return std::numeric_limits<double>::infinity();
+    }
+    double sum = 0.0;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        sum += (a[i] - b[i]) * (a[i] - b[i]);
+    }
+    return std::sqrt(sum);
+}
+
+std::string format_planner_metric(double value) {
+    std::ostringstream out;
+    out << std::setprecision(6) << value;
+    return out.str();
+}
+
+run_summary_row run_planner_once(const environment_info& environment,
+                                 const runtime_adapter& adapter,
+                                 const scenario_definition& scenario,
+                                 const tree_fixture& fixture,
+                                 std::size_t repetition) {
+    constexpr std::size_t kReferenceWorkFactor = 8u;
+
+    bt::planner_service planner;
+    planner.set_cache_enabled(false);
+
+    // Quality is the distance from each plan's action to the action of one plan given eight times
+    // the work from the same state, so it shows what a smaller sample count gives up.
+    const bt::planner_result reference = planner.plan(make_planner_benchmark_request(
+        scenario.planner, scenario.planner.samples * kReferenceWorkFactor, scenario.seed ^ 0x5265666572656e63ull));
+
+    std::uint64_t plan_index = 0u;
+    const auto next_request = [&] {
+        ++plan_index;
+        return make_planner_benchmark_request(scenario.planner, scenario.planner.samples, scenario.seed + plan_index);
+    };
+
+    const auto warmup_started = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - warmup_started < scenario.timing.warmup) {
+        (void)planner.plan(next_request());
+    }
+    const auto warmup_finished = std::chrono::steady_clock::now();
+
+    std::vector<std::uint64_t> latencies_ns;
+    std::vector<double> action_errors;
+    std::uint64_t plans_total = 0u;
+    std::uint64_t work_done_total = 0u;
+    std::uint64_t timeout_count = 0u;
+    std::uint64_t semantic_errors = reference.status == bt::planner_status::ok ? 0u : 1u;
+
+    allocation_tracker::reset();
+    allocation_tracker::set_enabled(true);
+    const auto run_started = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - run_started < scenario.timing.run || plans_total == 0u) {
+        const bt::planner_request request = next_request();
+        const auto plan_started = std::chrono::steady_clock::now();
+        const bt::planner_result result = planner.plan(request);
+        const auto plan_finished = std::chrono::steady_clock::now();
+        latencies_ns.push_back(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(plan_finished - plan_started).count()));
+        work_done_total += static_cast<std::uint64_t>(std::max<std::int64_t>(result.stats.work_done, 0));
+        if (result.status == bt::planner_status::timeout) {
+            ++timeout_count;
+        } else if (result.status != bt::planner_status::ok) {
+            ++semantic_errors;
+        }
+        action_errors.push_back(planner_action_distance(result.action.u, reference.action.u));
+        ++plans_total;
+    }
+    const auto run_finished = std::chrono::steady_clock::now();
+    allocation_tracker::set_enabled(false);
+
+    const auto allocations = allocation_tracker::read();
+    const latency_summary latency = summarise_latencies(latencies_ns);
+    std::uint64_t plan_ns_total = 0u;
+    for (const std::uint64_t ns : latencies_ns) {
+        plan_ns_total += ns;
+    }
+    std::sort(action_errors.begin(), action_errors.end());
+    const double work_per_ms =
+        plan_ns_total == 0u ? 0.0 : static_cast<double>(work_done_total) * 1.0e6 / static_cast<double>(plan_ns_total);
+
+    run_summary_row row = make_base_run_row(environment, adapter, scenario, fixture, repetition);
+    row.warmup_seconds = std::chrono::duration<double>(warmup_finished - warmup_started).count();
+    row.run_seconds = std::chrono::duration<double>(run_finished - run_started).count();
+    row.ticks_total = plans_total;
+    row.ticks_per_second = row.run_seconds > 0.0 ? static_cast<double>(plans_total) / row.run_seconds : 0.0;
+    row.latency_ns_median = latency.median;
+    row.latency_ns_p95 = latency.p95;
+    row.latency_ns_p99 = latency.p99;
+    row.latency_ns_p999 = latency.p999;
+    row.latency_ns_max = latency.max;
+    row.jitter_ratio_p99_over_median = latency.jitter_ratio_p99_over_median;
+    row.alloc_count_total = allocations.allocation_count;
+    row.alloc_bytes_total = allocations.allocation_bytes;
+    row.rss_bytes_peak = peak_rss_bytes();
+    row.deadline_miss_count = timeout_count;
+    row.deadline_miss_rate =
+        plans_total == 0u ? 0.0 : static_cast<double>(timeout_count) / static_cast<double>(plans_total);
+    row.semantic_errors = semantic_errors;
+    row.notes = "work_done_total=" + std::to_string(work_done_total) +
+                "; work_per_ms=" + format_planner_metric(work_per_ms) +
+                "; action_error_median=" + format_planner_metric(action_errors[action_errors.size() / 2u]) +
+                "; action_error_max=" + format_planner_metric(action_errors.back()) +
+                "; reference_work=" + std::to_string(reference.stats.work_done);
+    return row;
+}
+
+// A B13 operation: `program` is loaded once into a fresh global environment, and one operation is one
+// call of the closure bound to `entry` with `args`. `iterations` is how much work a call does
+// (loop trips, elements or calls) and is reported in the notes.
+struct lisp_benchmark_program {
+    std::string program;
+    std::string entry;
+    std::vector<std::int64_t> args;
+    std::uint64_t iterations = 1u;
+};
+
+constexpr std::size_t kLispGlobalCount = 64u;
+constexpr std::string_view kLispJsonDocument =
+    R"({"schema_version":"bench.lisp.v1","robot":"arm-7","tick":4096,"ok":true,)"
+    R"("pose":{"x":0.25,"y":-1.5,"z":0.75,"yaw":3.125},)"
+    R"("joints":[0.1,0.2,0.3,0.4,0.5,0.6,0.7],)"
+    R"("targets":[{"id":1,"label":"cup","score":0.875},{"id":2,"label":"plate","score":0.5}],)"
+    R"("status":{"battery":0.625,"mode":"grasp","faults":[]}})";
+
+std::string lisp_string_literal(std::string_view text) {
+    std::string out = "\"";
+    for (const char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    out += '"';
+    return out;
+}
+
+lisp_benchmark_program make_lisp_benchmark_program(lisp_benchmark_op op) {
+    switch (op) {
+        case lisp_benchmark_op::symbol_lookup: {
+            // Eight global reads per trip through a loop over a 64-binding global environment.
+            std::string program;
+            for (std::size_t i = 0; i < kLispGlobalCount; ++i) {
+                program += "(define g" + std::to_string(i) + " " + std::to_string(i) + ")\n";
+            }
+            program +=
+                "(define (lookup-loop i acc)\n"
+                "  (if (= i 0) acc (lookup-loop (- i 1) (+ acc g3 g17 g29 g41 g53 g63 g5 g11))))\n";
+            return {.program = std::move(program), .entry = "lookup-loop", .args = {100, 0}, .iterations = 100u};
+        }
+        case lisp_benchmark_op::closure_call:
+            // fib 15 makes 1973 closure calls.
+            return {.program = "(define (fib n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))\n",
+                    .entry = "fib",
+                    .args = {15},
+                    .iterations = 1973u};
+        case lisp_benchmark_op::arith_loop:
+            return {.program = "(define (arith-loop i acc)\n"
+                               "  (if (= i 0) acc (arith-loop (- i 1) (+ acc (* i i) (- (* 3 i) 7) (/ i 4.0)))))\n",
+                    .entry = "arith-loop",
+                    .args = {1000, 0},
+                    .iterations = 1000u};
+        case lisp_benchmark_op::map_ops:
+            return {.program = "(define (map-fill m i) (if (= i 0) m (begin (map.set! m i (* i 2)) (map-fill m (- i 1)))))\n"
+                               "(define (map-sum m i acc) (if (= i 0) acc (map-sum m (- i 1) (+ acc (map.get m i 0)))))\n"
+                               "(define (map-ops n) (let ((m (map.make))) (map-fill m n) (map-sum m n 0)))\n",
+                    .entry = "map-ops",
+                    .args = {64},
+                    .iterations = 64u};
+        case lisp_benchmark_op::vec_ops:
+            return {.program = "(define (vec-fill v i) (if (= i 0) v (begin (vec.push! v i) (vec-fill v (- i 1)))))\n"
+                               "(define (vec-sum v i acc) (if (= i 0) acc (vec-sum v (- i 1) (+ acc (vec.get v (- i 1))))))\n"
+                               "(define (vec-ops n) (let ((v (vec.make n))) (vec-fill v n) (vec-sum v n 0)))\n",
+                    .entry = "vec-ops",
+                    .args = {64},
+                    .iterations = 64u};
+        case lisp_benchmark_op::json_encode:
+            return {.program = "(define bench-doc (json.decode " + lisp_string_literal(kLispJsonDocument) + "))\n"
+                               "(define (json-encode-op) (json.encode bench-doc))\n",
+                    .entry = "json-encode-op",
+                    .args = {},
+                    .iterations = 1u};
+        case lisp_benchmark_op::json_decode:
+            return {.program = "(define bench-text " + lisp_string_literal(kLispJsonDocument) + ")\n"
+                               "(define (json-decode-op) (json.decode bench-text))\n",
+                    .entry = "json-decode-op",
+                    .args = {},
+                    .iterations = 1u};
+        case lisp_benchmark_op::none:
+            break;
+    }
+    throw std::invalid_argument("lisp benchmark: unsupported operation");
+}
+
+// Whether one operation's result is what its program computes.
+bool lisp_benchmark_result_ok(lisp_benchmark_op op, muslisp::value result) {
+    switch (op) {
+        case lisp_benchmark_op::symbol_lookup:
+            return muslisp::is_integer(result) && muslisp::integer_value(result) == 22200;
+        case lisp_benchmark_op::closure_call:
+            return muslisp::is_integer(result) && muslisp::integer_value(result) == 610;
+        case lisp_benchmark_op::arith_loop: {
+            double expected = 0.0;
+            for (std::int64_t i = 1000; i > 0; --i) {
+                expected += static_cast<double>(i * i + 3 * i - 7) + static_cast<double>(i) / 4.0;
+            }
+            return muslisp::is_float(result) && std::abs(muslisp::float_value(result) - expected) <= 1e-9 * expected;
+        }
+        case lisp_benchmark_op::map_ops:
+            return muslisp::is_integer(result) && muslisp::integer_value(result) == 4160;
+        case lisp_benchmark_op::vec_ops:
+            return muslisp::is_integer(result) && muslisp::integer_value(result) == 2080;
+        case lisp_benchmark_op::json_encode:
+            return muslisp::is_string(result) && !muslisp::string_value(result).empty();
+        case lisp_benchmark_op::json_decode:
+            return muslisp::is_map(result);
+        case lisp_benchmark_op::none:
+            break;
+    }
+    return false;
+}
+
+run_summary_row run_lisp_eval_once(const environment_info& environment,
+                                   const runtime_adapter& adapter,
+                                   const scenario_definition& scenario,
+                                   const tree_fixture& fixture,
+                                   std::size_t repetition) {
+    const lisp_benchmark_program program = make_lisp_benchmark_program(scenario.lisp.op);
+
+    muslisp::gc& heap = muslisp::default_gc();
+    const muslisp::env_ptr global = muslisp::create_global_env();
+    (void)muslisp::eval_source(program.program, global);
+
+    muslisp::value fn = muslisp::eval_source(program.entry, global);
+    std::vector<muslisp::value> args;
+    args.reserve(program.args.size());
+    for (const std::int64_t arg : program.args) {
+        args.push_back(muslisp::make_integer(arg));
+    }
+    muslisp::value result = muslisp::make_nil();
+    muslisp::gc_root_scope roots(heap);
+    roots.add(&fn);
+    roots.add(&result);
+    for (muslisp::value& arg : args) {
+        roots.add(&arg);
+    }
+
+    // Every benchmark closure compiles; dropping the compiled body sends calls through eval instead.
+    std::uint64_t semantic_errors = muslisp::closure_compiled(fn) ? 0u : 1u;
+    if (scenario.lisp.interpreted) {
+        muslisp::set_closure_compiled(fn, nullptr);
+    }
+
+    std::vector<std::uint64_t> gc_pause_ns;
+    heap.clear_lifecycle_listener();
+    heap.set_lifecycle_listener([&](const muslisp::gc_lifecycle_event& event) {
+        if (!event.begin) {
+            gc_pause_ns.push_back(event.pause_time_ns);
+        }
+    });
+
+    const auto warmup_started = std::chrono::steady_clock::now();
+    do {
+        result = muslisp::invoke_callable(fn, args);
+    } while (std::chrono::steady_clock::now() - warmup_started < scenario.timing.warmup);
+    const auto warmup_finished = std::chrono::steady_clock::now();
+    if (!lisp_benchmark_result_ok(scenario.lisp.op, result)) {
+        ++semantic_errors;
+    }
+    gc_pause_ns.clear();
+    gc_pause_ns.reserve(1024u);
+
+    std::vector<std::uint64_t> latencies_ns;
+    const muslisp::gc_stats_snapshot stats_start = heap.stats();
+    std::uint64_t ops_total = 0u;
+
+    allocation_tracker::reset();
+    allocation_tracker::set_enabled(true);
+    const auto run_started = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - run_started < scenario.timing.run || ops_total == 0u) {
+        const auto op_started = std::chrono::steady_clock::now();
+        result = muslisp::invoke_callable(fn, args);
+        const auto op_finished = std::chrono::steady_clock::now();
+        latencies_ns.push_back(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(op_finished - op_started).count()));
+        ++ops_total;
+    }
+    const auto run_finished = std::chrono::steady_clock::now();
+    allocation_tracker::set_enabled(false);
+
+    const auto allocations = allocation_tracker::read();
+    const muslisp::gc_stats_snapshot stats_end = heap.stats();
+    heap.clear_lifecycle_listener();
+    if (!lisp_benchmark_result_ok(scenario.lisp.op, result)) {
+        ++semantic_errors;
+    }
+    heap.unregister_root_env(global);
+
+    const latency_summary latency = summarise_latencies(latencies_ns);
+    const double ops = static_cast<double>(ops_total);
+    run_summary_row row = make_base_run_row(environment, adapter, scenario, fixture, repetition);
+    row.warmup_seconds = std::chrono::duration<double>(warmup_finished - warmup_started).count();
+    row.run_seconds = std::chrono::duration<double>(run_finished - run_started).count();
+    row.ticks_total = ops_total;
+    row.ticks_per_second = row.run_seconds > 0.0 ? ops / row.run_seconds : 0.0;
+    row.latency_ns_median = latency.median;
+    row.latency_ns_p95 = latency.p95;
+    row.latency_ns_p99 = latency.p99;
+    row.latency_ns_p999 = latency.p999;
+    row.latency_ns_max = latency.max;
+    row.jitter_ratio_p99_over_median = latency.jitter_ratio_p99_over_median;
+    row.alloc_count_total = allocations.allocation_count;
+    row.alloc_bytes_total = allocations.allocation_bytes;
+    row.rss_bytes_peak = peak_rss_bytes();
+    row.gc_collections_total = stats_end.collection_count - stats_start.collection_count;
+    row.gc_pause_ns_p50 = percentile_u64(gc_pause_ns, 0.50);
+    row.gc_pause_ns_p95 = percentile_u64(gc_pause_ns, 0.95);
+    row.gc_pause_ns_p99 = percentile_u64(gc_pause_ns, 0.99);
+    row.gc_pause_ns_p999 = percentile_u64(gc_pause_ns, 0.999);
+    row.heap_live_bytes_start = stats_start.bytes_allocated;
+    row.heap_live_bytes_end = stats_end.bytes_allocated;
+    row.semantic_errors = semantic_errors;
+    row.gc_objects_per_op =
+        static_cast<double>(stats_end.total_allocated_objects - stats_start.total_allocated_objects) / ops;
+    row.alloc_bytes_per_op = static_cast<double>(allocations.allocation_bytes) / ops;
+    row.notes = "op_iterations=" + std::to_string(program.iterations) + "; evaluator=" +
+                (scenario.lisp.interpreted ? "eval" : "compiled_eval");
+    return row;
+}
+
+// A B14 repetition: a fresh runtime_host compiles the fixture, creates `instance_count` instances and
+// ticks each once, and its memory_report() after a collection is the row. Nothing is timed.
+run_summary_row run_memory_footprint_once(const environment_info& environment,
+                                          const runtime_adapter& adapter,
+                                          const scenario_definition& scenario,
+                                          const tree_fixture& fixture,
+                                          std::size_t repetition) {
+    muslisp::gc& heap = muslisp::default_gc();
+    bt::runtime_host host;
+    host.callbacks().register_condition("cond_ok",
+                                        [](bt::tick_context&, std::span<const muslisp::value>) { return true; });
+    host.callbacks().register_condition("cond_fail",
+                                        [](bt::tick_context&, std::span<const muslisp::value>) { return false; });
+    for (const char* name : {"act_ok", "act_stop"}) {
+        host.callbacks().register_action(
+            name, [](bt::tick_context&, bt::node_id, bt::node_memory&, std::span<const muslisp::value>) {
+                return bt::status::success;
+            });
+    }
+    host.callbacks().register_action(
+        "act_fail", [](bt::tick_context&, bt::node_id, bt::node_memory&, std::span<const muslisp::value>) {
+            return bt::status::failure;
+        });
+
+    heap.collect();
+    const bt::memory_report baseline = host.memory_report();
+
+    const std::int64_t definition =
+        host.store_definition(bt::compile_definition(muslisp::read_one(make_fixture_dsl(fixture))));
+    const std::size_t instance_count = std::max<std::size_t>(scenario.instance_count, 1u);
+    std::vector<std::int64_t> handles;
+    handles.reserve(instance_count);
+    std::uint64_t semantic_errors = 0u;
+    for (std::size_t i = 0; i < instance_count; ++i) {
+        handles.push_back(host.create_instance(definition));
+    }
+    for (const std::int64_t handle : handles) {
+        if (host.tick_instance(handle) == bt::status::running) {
+            ++semantic_errors;
+        }
+    }
+    heap.collect();
+    const bt::memory_report report = host.memory_report();
+
+    run_summary_row row = make_base_run_row(environment, adapter, scenario, fixture, repetition);
+    row.ticks_total = instance_count;
+    row.rss_bytes_peak = peak_rss_bytes();
+    row.heap_live_bytes_start = baseline.lisp_heap_bytes;
+    row.heap_live_bytes_end = report.lisp_heap_bytes;
+    row.semantic_errors = semantic_errors;
+    row.instance_count = instance_count;
+    row.instance_bytes = (report.instance_state_bytes + report.blackboard_bytes + report.trace_bytes) / instance_count;
+    row.notes = "definition_bytes=" + std::to_string(report.definition_bytes) +
+                "; instance_state_bytes=" + std::to_string(report.instance_state_bytes) +
+                "; blackboard_bytes=" + std::to_string(report.blackboard_bytes) +
+                "; trace_bytes=" + std::to_string(report.trace_bytes) +
+                "; event_ring_bytes=" + std::to_string(report.event_ring_bytes) +
+                "; log_ring_bytes=" + std::to_string(report.log_ring_bytes) +
+                "; lisp_heap_bytes=" + std::to_string(report.lisp_heap_bytes) +
+                "; total_bytes=" + std::to_string(report.total_bytes());
+    return row;
+}
+
 std::unique_ptr<runtime_adapter> make_runtime_adapter(const std::string& runtime_name) {
     if (runtime_name == "muesli") {
         return std::make_unique<muesli_adapter>();
@@ -857,6 +1327,308 @@ run_summary_row make_base_run_row(const environment_info& environment,
     return row;
 }
 
+// One B10 repetition: creates `instance_count` instances, then times rounds that tick each of them
+// once. Instance footprint includes the priming tick, which is when an instance sizes its per-node
+// state; creation time covers construction only.
+run_summary_row run_scaling_once(const environment_info& environment,
+                                 runtime_adapter& adapter,
+                                 const runtime_adapter::compiled_tree& compiled,
+                                 const scenario_definition& scenario,
+                                 const tree_fixture& fixture,
+                                 std::size_t repetition,
+                                 perf_counter_group* perf_counters) {
+    const std::size_t instance_count = std::max<std::size_t>(scenario.instance_count, 1u);
+    std::vector<std::unique_ptr<runtime_adapter::instance_handle>> instances;
+    instances.reserve(instance_count);
+
+    allocation_tracker::reset();
+    allocation_tracker::set_enabled(true);
+    const auto create_started = std::chrono::steady_clock::now();
+    for (std::size_t index = 0; index < instance_count; ++index) {
+        instances.push_back(adapter.new_instance(compiled, scenario));
+    }
+    const auto create_finished = std::chrono::steady_clock::now();
+    for (const auto& instance : instances) {
+        adapter.prepare_for_timed_run(*instance, 0u, repetition);
+    }
+    allocation_tracker::set_enabled(false);
+    const auto footprint = allocation_tracker::read();
+
+    const auto tick_round = [&] {
+        for (const auto& instance : instances) {
+            (void)adapter.tick(*instance);
+        }
+    };
+
+    std::size_t warmup_rounds = 0u;
+    const auto warmup_started = std::chrono::steady_clock::now();
+    if (scenario.timing.warmup > std::chrono::milliseconds::zero()) {
+        do {
+            tick_round();
+            ++warmup_rounds;
+        } while (std::chrono::steady_clock::now() - warmup_started < scenario.timing.warmup);
+    }
+    const auto warmup_elapsed = std::chrono::steady_clock::now() - warmup_started;
+
+    std::vector<std::uint64_t> latencies_ns;
+    latencies_ns.reserve(estimate_timed_ticks(warmup_rounds, warmup_elapsed, scenario.timing.run));
+
+    allocation_tracker::reset();
+    allocation_tracker::set_enabled(true);
+    if (perf_counters) {
+        perf_counters->start();
+    }
+
+    std::uint64_t rounds_total = 0u;
+    const auto run_started = std::chrono::steady_clock::now();
+    if (scenario.timing.run > std::chrono::milliseconds::zero()) {
+        do {
+            const auto round_started = std::chrono::steady_clock::now();
+            tick_round();
+            const auto round_finished = std::chrono::steady_clock::now();
+            latencies_ns.push_back(static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(round_finished - round_started).count()));
+            ++rounds_total;
+        } while (std::chrono::steady_clock::now() - run_started < scenario.timing.run);
+    }
+    const auto run_finished = std::chrono::steady_clock::now();
+    const perf_counter_sample perf_sample = perf_counters ? perf_counters->stop() : perf_counter_sample{};
+
+    allocation_tracker::set_enabled(false);
+    std::uint64_t semantic_errors = 0u;
+    for (const auto& instance : instances) {
+        adapter.teardown(*instance);
+        semantic_errors += adapter.read_counters(*instance).semantic_errors;
+    }
+
+    const auto allocations = allocation_tracker::read();
+    const latency_summary latency = summarise_latencies(latencies_ns);
+    const double run_seconds = std::chrono::duration<double>(run_finished - run_started).count();
+    const std::uint64_t ticks_total = rounds_total * instance_count;
+    const auto create_ns = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(create_finished - create_started).count());
+
+    run_summary_row row = make_base_run_row(environment, adapter, scenario, fixture, repetition);
+    row.warmup_seconds = std::chrono::duration<double>(warmup_elapsed).count();
+    row.run_seconds = run_seconds;
+    row.ticks_total = ticks_total;
+    row.ticks_per_second = run_seconds > 0.0 ? static_cast<double>(ticks_total) / run_seconds : 0.0;
+    row.latency_ns_median = latency.median;
+    row.latency_ns_p95 = latency.p95;
+    row.latency_ns_p99 = latency.p99;
+    row.latency_ns_p999 = latency.p999;
+    row.latency_ns_max = latency.max;
+    row.jitter_ratio_p99_over_median = latency.jitter_ratio_p99_over_median;
+    row.alloc_count_total = allocations.allocation_count;
+    row.alloc_bytes_total = allocations.allocation_bytes;
+    row.rss_bytes_peak = peak_rss_bytes();
+    row.semantic_errors = semantic_errors;
+    row.cpu_cycles = perf_sample.cpu_cycles;
+    row.cpu_instructions = perf_sample.cpu_instructions;
+    row.l1d_read_misses = perf_sample.l1d_read_misses;
+    row.llc_misses = perf_sample.llc_misses;
+    row.branch_misses = perf_sample.branch_misses;
+    row.tree_depth = fixture.depth;
+    row.tree_fanout = scenario.fanout;
+    row.instance_count = instance_count;
+    row.ns_per_node_tick =
+        static_cast<double>(latency.median) / static_cast<double>(instance_count * fixture.node_count);
+    row.instance_bytes = footprint.allocation_bytes / instance_count;
+    row.instance_create_ns = create_ns / instance_count;
+    return row;
+}
+
+// Sleeps until shortly before `deadline`, then spins, so an open-loop tick starts close to its slot.
+void wait_until(std::chrono::steady_clock::time_point deadline) {
+    constexpr auto kSpin = std::chrono::microseconds(200);
+    if (deadline - std::chrono::steady_clock::now() > kSpin) {
+        std::this_thread::sleep_until(deadline - kSpin);
+    }
+    while (std::chrono::steady_clock::now() < deadline) {
+    }
+}
+
+// Background work for loaded B11 runs: a short burst of CPU and a short-lived allocation, standing in
+// for perception or planning jobs that share the host with the tick loop.
+bt::job_result background_load_job() {
+    const auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(200);
+    std::vector<std::uint64_t> scratch(256u, 1u);
+    std::uint64_t checksum = 0u;
+    while (std::chrono::steady_clock::now() < until) {
+        for (std::uint64_t& value : scratch) {
+            value = value * 6364136223846793005ull + 1442695040888963407ull;
+            checksum ^= value;
+        }
+    }
+    return bt::job_result{.payload = checksum};
+}
+
+// One B11 repetition. Ticks are scheduled open-loop at start + n * period and each tick's response
+// time is measured from its scheduled start, so a slow tick also charges the ticks queued behind it
+// (the coordinated-omission correction). A tick misses its deadline when it finishes more than one
+// period after its scheduled start. Slots the loop has not reached when the run window closes are
+// recorded with the time they had waited so far, a lower bound.
+run_summary_row run_open_loop_once(const environment_info& environment,
+                                   runtime_adapter& adapter,
+                                   const runtime_adapter::compiled_tree& compiled,
+                                   const scenario_definition& scenario,
+                                   const tree_fixture& fixture,
+                                   std::size_t repetition,
+                                   perf_counter_group* perf_counters) {
+    using clock = std::chrono::steady_clock;
+    if (scenario.target_hz == 0u) {
+        throw std::invalid_argument("open-loop benchmark: target rate must be positive");
+    }
+    const auto period = std::chrono::duration_cast<clock::duration>(
+        std::chrono::nanoseconds(1'000'000'000ll / static_cast<std::int64_t>(scenario.target_hz)));
+    const auto to_ns = [](clock::duration duration) {
+        return static_cast<std::uint64_t>(std::max<std::int64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count(), 0));
+    };
+
+    std::unique_ptr<runtime_adapter::instance_handle> instance = adapter.new_instance(compiled, scenario);
+
+    muslisp::gc& heap = muslisp::default_gc();
+    muslisp::value retained = muslisp::make_nil();
+    muslisp::gc_root_scope roots(heap);
+    roots.add(&retained);
+    std::vector<std::uint64_t> gc_pause_ns;
+    std::optional<bt::thread_pool_scheduler> background;
+    std::uint64_t background_jobs = 0u;
+    if (scenario.background_load) {
+        background.emplace(2u);
+        heap.clear_lifecycle_listener();
+        heap.set_lifecycle_listener([&](const muslisp::gc_lifecycle_event& event) {
+            if (!event.begin) {
+                gc_pause_ns.push_back(event.pause_time_ns);
+            }
+        });
+    }
+    const auto load_between_ticks = [&](std::uint64_t slot) {
+        if (!background) {
+            return;
+        }
+        bt::job_request request;
+        request.task_name = "bench-background-load";
+        request.fn = background_load_job;
+        (void)background->submit(std::move(request));
+        ++background_jobs;
+        if ((slot % 1024u) == 0u) {
+            retained = muslisp::make_nil();
+        }
+        allocate_gc_pressure_batch(slot, retained);
+        heap.maybe_collect();
+    };
+
+    std::uint64_t warmup_slot = 0u;
+    const auto warmup_started = clock::now();
+    while (clock::now() - warmup_started < scenario.timing.warmup) {
+        (void)adapter.tick(*instance);
+        load_between_ticks(warmup_slot++);
+        wait_until(clock::now() + period);
+    }
+    const auto warmup_elapsed = clock::now() - warmup_started;
+
+    const std::size_t slots_planned = std::max<std::size_t>(
+        static_cast<std::size_t>(std::chrono::duration_cast<clock::duration>(scenario.timing.run) / period), 1u);
+    adapter.prepare_for_timed_run(*instance, slots_planned, repetition);
+
+    std::vector<std::uint64_t> latencies_ns;
+    std::vector<std::uint64_t> service_ns;
+    latencies_ns.reserve(slots_planned);
+    service_ns.reserve(slots_planned);
+    gc_pause_ns.reserve(1024u);
+    const auto gc_stats_start = heap.stats();
+
+    allocation_tracker::reset();
+    allocation_tracker::set_enabled(true);
+    if (perf_counters) {
+        perf_counters->start();
+    }
+
+    std::uint64_t deadline_misses = 0u;
+    const auto run_started = clock::now();
+    const auto first_slot = run_started + period;
+    const auto run_end = first_slot + period * static_cast<std::int64_t>(slots_planned);
+    std::size_t slot = 0u;
+    for (; slot < slots_planned; ++slot) {
+        if (clock::now() >= run_end) {
+            break;
+        }
+        const auto intended = first_slot + period * static_cast<std::int64_t>(slot);
+        wait_until(intended);
+        const auto tick_started = clock::now();
+        (void)adapter.tick(*instance);
+        const auto tick_finished = clock::now();
+        latencies_ns.push_back(to_ns(tick_finished - intended));
+        service_ns.push_back(to_ns(tick_finished - tick_started));
+        if (tick_finished - intended > period) {
+            ++deadline_misses;
+        }
+        load_between_ticks(warmup_slot + slot);
+    }
+    const auto run_finished = clock::now();
+    const perf_counter_sample perf_sample = perf_counters ? perf_counters->stop() : perf_counter_sample{};
+    allocation_tracker::set_enabled(false);
+
+    const std::uint64_t ticks_total = slot;
+    const std::size_t slots_dropped = slots_planned - slot;
+    for (; slot < slots_planned; ++slot) {
+        const auto waited = run_finished - (first_slot + period * static_cast<std::int64_t>(slot));
+        latencies_ns.push_back(to_ns(waited));
+        if (waited > period) {
+            ++deadline_misses;
+        }
+    }
+
+    if (background) {
+        heap.clear_lifecycle_listener();
+    }
+    const auto gc_stats_end = heap.stats();
+    adapter.teardown(*instance);
+    const run_counters counters = adapter.read_counters(*instance);
+    const auto allocations = allocation_tracker::read();
+    const latency_summary latency = summarise_latencies(latencies_ns);
+    const latency_summary service = summarise_latencies(service_ns);
+    const double run_seconds = std::chrono::duration<double>(run_finished - run_started).count();
+
+    run_summary_row row = make_base_run_row(environment, adapter, scenario, fixture, repetition);
+    row.warmup_seconds = std::chrono::duration<double>(warmup_elapsed).count();
+    row.run_seconds = run_seconds;
+    row.ticks_total = ticks_total;
+    row.ticks_per_second = run_seconds > 0.0 ? static_cast<double>(ticks_total) / run_seconds : 0.0;
+    row.latency_ns_median = latency.median;
+    row.latency_ns_p95 = latency.p95;
+    row.latency_ns_p99 = latency.p99;
+    row.latency_ns_p999 = latency.p999;
+    row.latency_ns_max = latency.max;
+    row.jitter_ratio_p99_over_median = latency.jitter_ratio_p99_over_median;
+    row.alloc_count_total = allocations.allocation_count;
+    row.alloc_bytes_total = allocations.allocation_bytes;
+    row.rss_bytes_peak = peak_rss_bytes();
+    row.gc_collections_total = gc_stats_end.collection_count - gc_stats_start.collection_count;
+    row.gc_pause_ns_p50 = percentile_u64(gc_pause_ns, 0.50);
+    row.gc_pause_ns_p95 = percentile_u64(gc_pause_ns, 0.95);
+    row.gc_pause_ns_p99 = percentile_u64(gc_pause_ns, 0.99);
+    row.gc_pause_ns_p999 = percentile_u64(gc_pause_ns, 0.999);
+    row.deadline_miss_count = deadline_misses;
+    row.deadline_miss_rate = static_cast<double>(deadline_misses) / static_cast<double>(slots_planned);
+    row.semantic_errors = counters.semantic_errors;
+    row.cpu_cycles = perf_sample.cpu_cycles;
+    row.cpu_instructions = perf_sample.cpu_instructions;
+    row.l1d_read_misses = perf_sample.l1d_read_misses;
+    row.llc_misses = perf_sample.llc_misses;
+    row.branch_misses = perf_sample.branch_misses;
+    row.notes = "target_hz=" + std::to_string(scenario.target_hz) +
+                "; service_ns_median=" + std::to_string(service.median) +
+                "; service_ns_p99=" + std::to_string(service.p99) +
+                "; service_ns_p999=" + std::to_string(service.p999) +
+                "; service_ns_max=" + std::to_string(service.max) +
+                "; slots_dropped=" + std::to_string(slots_dropped) +
+                "; background_jobs=" + std::to_string(background_jobs);
+    return row;
+}
+
 aggregate_summary_row build_aggregate_row(const environment_info& environment,
                                           const scenario_definition& scenario,
                                           const std::vector<run_summary_row>& rows) {
@@ -998,6 +1770,7 @@ environment_metadata_row build_environment_row(const environment_info& environme
     row.harness_commit = environment.harness_commit;
     row.clock_source = environment.clock_source;
     row.allocator_mode = environment.allocator_mode;
+    row.perf_counters = environment.perf_counters;
     row.notes = environment.notes;
     return row;
 }
@@ -1055,7 +1828,8 @@ void write_experiment_manifest(const std::filesystem::path& output_dir,
         << "    \"repetitions_override\": " << optional_size_json(request.repetitions_override) << ",\n"
         << "    \"seed_override\": " << optional_u64_json(request.seed_override) << ",\n"
         << "    \"clock_source\": " << json_string(environment.clock_source) << ",\n"
-        << "    \"allocator_mode\": " << json_string(environment.allocator_mode) << "\n"
+        << "    \"allocator_mode\": " << json_string(environment.allocator_mode) << ",\n"
+        << "    \"perf_counters\": " << json_string(environment.perf_counters) << "\n"
         << "  },\n"
         << "  \"scenarios\": [\n";
 
@@ -1076,6 +1850,17 @@ void write_experiment_manifest(const std::filesystem::path& output_dir,
             << "      \"lifecycle_phase\": " << json_string(lifecycle_phase_name(scenario.lifecycle)) << ",\n"
             << "      \"gc_mode\": " << json_string(gc_mode_name(scenario.gc_mode)) << ",\n"
             << "      \"async_case\": " << json_string(async_case_name(scenario.async_case)) << ",\n"
+            << "      \"planner_backend\": " << json_string(planner_benchmark_backend_name(scenario.planner.backend)) << ",\n"
+            << "      \"planner_model\": " << json_string(scenario.planner.model) << ",\n"
+            << "      \"planner_horizon\": " << scenario.planner.horizon << ",\n"
+            << "      \"planner_samples\": " << scenario.planner.samples << ",\n"
+            << "      \"tree_fanout\": " << scenario.fanout << ",\n"
+            << "      \"instance_count\": " << scenario.instance_count << ",\n"
+            << "      \"target_hz\": " << scenario.target_hz << ",\n"
+            << "      \"background_load\": " << (scenario.background_load ? "true" : "false") << ",\n"
+            << "      \"blackboard_reads\": " << (scenario.blackboard_reads ? "true" : "false") << ",\n"
+            << "      \"lisp_op\": " << json_string(lisp_benchmark_op_name(scenario.lisp.op)) << ",\n"
+            << "      \"lisp_interpreted\": " << (scenario.lisp.interpreted ? "true" : "false") << ",\n"
             << "      \"variant\": " << json_string(scenario.variant) << ",\n"
             << "      \"seed\": " << scenario.seed << ",\n"
             << "      \"warmup_ms\": " << scenario.timing.warmup.count() << ",\n"
@@ -1116,6 +1901,11 @@ run_result benchmark_runner::run(const run_request& request) const {
     environment.runtime_name = adapter->name();
     environment.runtime_version = adapter->version();
     environment.runtime_commit = adapter->commit();
+    std::optional<perf_counter_group> perf_counters;
+    if (request.perf_counters) {
+        perf_counters.emplace();
+        environment.perf_counters = perf_counters->description();
+    }
     csv_writer writer;
 
     run_result result;
@@ -1181,6 +1971,40 @@ run_result benchmark_runner::run(const run_request& request) const {
             continue;
         }
 
+        if (scenario.kind == benchmark_kind::lisp_eval) {
+            for (std::size_t repetition = 0; repetition < scenario.timing.repetitions; ++repetition) {
+                run_summary_row row = run_lisp_eval_once(environment, *adapter, scenario, fixture, repetition);
+                scenario_rows.push_back(row);
+                result.run_rows.push_back(row);
+            }
+            result.aggregate_rows.push_back(build_aggregate_row(environment, scenario, scenario_rows));
+            continue;
+        }
+        if (scenario.kind == benchmark_kind::memory_footprint) {
+            if (adapter->name() != "muesli-bt") {
+                throw std::invalid_argument("B14 memory footprint benchmarks are muesli-bt only");
+            }
+            for (std::size_t repetition = 0; repetition < scenario.timing.repetitions; ++repetition) {
+                run_summary_row row = run_memory_footprint_once(environment, *adapter, scenario, fixture, repetition);
+                scenario_rows.push_back(row);
+                result.run_rows.push_back(row);
+            }
+            result.aggregate_rows.push_back(build_aggregate_row(environment, scenario, scenario_rows));
+            continue;
+        }
+        if (scenario.kind == benchmark_kind::planner) {
+            if (adapter->name() != "muesli-bt") {
+                throw std::invalid_argument("B9 planner benchmarks are muesli-bt only");
+            }
+            for (std::size_t repetition = 0; repetition < scenario.timing.repetitions; ++repetition) {
+                run_summary_row row = run_planner_once(environment, *adapter, scenario, fixture, repetition);
+                scenario_rows.push_back(row);
+                result.run_rows.push_back(row);
+            }
+            result.aggregate_rows.push_back(build_aggregate_row(environment, scenario, scenario_rows));
+            continue;
+        }
+
         if (scenario.kind == benchmark_kind::compile_lifecycle) {
             const std::filesystem::path scratch_dir = result.output_dir / ".scratch" / scenario.scenario_id;
             std::unique_ptr<runtime_adapter::lifecycle_case> lifecycle =
@@ -1223,6 +2047,38 @@ run_result benchmark_runner::run(const run_request& request) const {
 
         std::unique_ptr<runtime_adapter::compiled_tree> compiled = adapter->compile_tree(fixture);
 
+        if (scenario.kind == benchmark_kind::open_loop) {
+            for (std::size_t repetition = 0; repetition < scenario.timing.repetitions; ++repetition) {
+                run_summary_row row = run_open_loop_once(environment,
+                                                         *adapter,
+                                                         *compiled,
+                                                         scenario,
+                                                         fixture,
+                                                         repetition,
+                                                         perf_counters ? &*perf_counters : nullptr);
+                scenario_rows.push_back(row);
+                result.run_rows.push_back(row);
+            }
+            result.aggregate_rows.push_back(build_aggregate_row(environment, scenario, scenario_rows));
+            continue;
+        }
+
+        if (scenario.kind == benchmark_kind::scaling) {
+            for (std::size_t repetition = 0; repetition < scenario.timing.repetitions; ++repetition) {
+                run_summary_row row = run_scaling_once(environment,
+                                                       *adapter,
+                                                       *compiled,
+                                                       scenario,
+                                                       fixture,
+                                                       repetition,
+                                                       perf_counters ? &*perf_counters : nullptr);
+                scenario_rows.push_back(row);
+                result.run_rows.push_back(row);
+            }
+            result.aggregate_rows.push_back(build_aggregate_row(environment, scenario, scenario_rows));
+            continue;
+        }
+
         for (std::size_t repetition = 0; repetition < scenario.timing.repetitions; ++repetition) {
             std::unique_ptr<runtime_adapter::instance_handle> instance = adapter->new_instance(*compiled, scenario);
 
@@ -1245,6 +2101,9 @@ run_result benchmark_runner::run(const run_request& request) const {
 
             allocation_tracker::reset();
             allocation_tracker::set_enabled(true);
+            if (perf_counters) {
+                perf_counters->start();
+            }
 
             std::uint64_t ticks_total = 0u;
             const auto run_started = std::chrono::steady_clock::now();
@@ -1259,6 +2118,7 @@ run_result benchmark_runner::run(const run_request& request) const {
                 } while (std::chrono::steady_clock::now() - run_started < scenario.timing.run);
             }
             const auto run_finished = std::chrono::steady_clock::now();
+            const perf_counter_sample perf_sample = perf_counters ? perf_counters->stop() : perf_counter_sample{};
 
             allocation_tracker::set_enabled(false);
             adapter->teardown(*instance);
@@ -1297,7 +2157,14 @@ run_result benchmark_runner::run(const run_request& request) const {
             row.rss_bytes_peak = peak_rss_bytes();
             row.log_events_total = counters.log_events_total;
             row.log_bytes_total = counters.log_bytes_total;
+            row.event_log_bytes_per_tick =
+                ticks_total == 0u ? 0.0 : static_cast<double>(counters.log_bytes_total) / static_cast<double>(ticks_total);
             row.semantic_errors = counters.semantic_errors;
+            row.cpu_cycles = perf_sample.cpu_cycles;
+            row.cpu_instructions = perf_sample.cpu_instructions;
+            row.l1d_read_misses = perf_sample.l1d_read_misses;
+            row.llc_misses = perf_sample.llc_misses;
+            row.branch_misses = perf_sample.branch_misses;
             if (scenario.group_id == "A2" && latency.median != 0u && latency.p99 >= latency.median * 5u) {
                 row.notes = "p99 exceeded 5x median";
             }
@@ -34,6 +34,8 @@ struct run_request {
     std::optional<std::chrono::milliseconds> run_override;
     std::optional<std::size_t> repetitions_override;
     std::optional<std::uint64_t> seed_override;
+    // Capture hardware performance counters around each timed tick loop.
+    bool perf_counters = false;
     std::function<void(const progress_event&)> progress_callback;
 };
 
@@ -115,10 +115,144 @@ scenario_definition make_async_contract_scenario(std::string scenario_id,
     };
 }
 
+scenario_definition make_planner_scenario(planner_benchmark_backend backend,
+                                          std::string model,
+                                          std::size_t horizon,
+                                          std::size_t samples,
+                                          timing_config timing) {
+    std::string variant = std::string(planner_benchmark_backend_name(backend)) + "-" + model + "-h" +
+                          std::to_string(horizon) + "-s" + std::to_string(samples);
+    return scenario_definition{
+        .scenario_id = "B9-planner-" + variant,
+        .group_id = "B9",
+        .kind = benchmark_kind::planner,
+        .family = tree_family::single_leaf,
+        .tree_size_nodes = 1,
+        .logging = logging_mode::off,
+        .schedule = schedule_kind::none,
+        .lifecycle = lifecycle_phase::none,
+        .gc_mode = gc_benchmark_mode::none,
+        .async_case = async_contract_case::none,
+        .planner =
+            planner_benchmark_case{
+                .backend = backend,
+                .model = std::move(model),
+                .horizon = horizon,
+                .samples = samples,
+            },
+        .variant = std::move(variant),
+        .timing = timing,
+        .seed = 20260315ull,
+        .capture_tick_trace = false,
+    };
+}
+
+scenario_definition make_lisp_scenario(lisp_benchmark_op op, bool interpreted, timing_config timing) {
+    std::string variant = std::string(lisp_benchmark_op_name(op)) + (interpreted ? "-interpreted" : "-compiled");
+    return scenario_definition{
+        .scenario_id = "B13-lisp-" + variant,
+        .group_id = "B13",
+        .kind = benchmark_kind::lisp_eval,
+        .family = tree_family::single_leaf,
+        .tree_size_nodes = 1,
+        .logging = logging_mode::off,
+        .schedule = schedule_kind::none,
+        .lifecycle = lifecycle_phase::none,
+        .gc_mode = gc_benchmark_mode::none,
+        .async_case = async_contract_case::none,
+        .planner = {},
+        .lisp =
+            lisp_benchmark_case{
+                .op = op,
+                .interpreted = interpreted,
+            },
+        .variant = std::move(variant),
+        .timing = timing,
+        .seed = 20260315ull,
+        .capture_tick_trace = false,
+    };
+}
+
+scenario_definition make_scaling_scenario(std::string sweep,
+                                          std::size_t tree_size_nodes,
+                                          std::size_t fanout,
+                                          std::size_t instance_count,
+                                          timing_config timing) {
+    return scenario_definition{
+        .scenario_id = "B10-" + sweep + "-n" + std::to_string(tree_size_nodes) + "-f" + std::to_string(fanout) + "-i" +
+                       std::to_string(instance_count),
+        .group_id = "B10",
+        .kind = benchmark_kind::scaling,
+        .family = tree_family::alt,
+        .tree_size_nodes = tree_size_nodes,
+        .logging = logging_mode::off,
+        .schedule = schedule_kind::none,
+        .lifecycle = lifecycle_phase::none,
+        .gc_mode = gc_benchmark_mode::none,
+        .async_case = async_contract_case::none,
+        .planner = {},
+        .fanout = fanout,
+        .instance_count = instance_count,
+        .variant = std::move(sweep),
+        .timing = timing,
+        .seed = 20260315ull,
+        .capture_tick_trace = false,
+    };
+}
+
+// B14: `instance_count` instances of one alt tree, each ticked once, measured by memory_report.
+scenario_definition make_memory_footprint_scenario(std::size_t tree_size_nodes,
+                                                   std::size_t instance_count,
+                                                   timing_config timing) {
+    return scenario_definition{
+        .scenario_id = "B14-footprint-alt-" + std::to_string(tree_size_nodes) + "-i" + std::to_string(instance_count),
+        .group_id = "B14",
+        .kind = benchmark_kind::memory_footprint,
+        .family = tree_family::alt,
+        .tree_size_nodes = tree_size_nodes,
+        .logging = logging_mode::off,
+        .schedule = schedule_kind::none,
+        .lifecycle = lifecycle_phase::none,
+        .gc_mode = gc_benchmark_mode::none,
+        .async_case = async_contract_case::none,
+        .planner = {},
+        .instance_count = instance_count,
+        .variant = "footprint",
+        .timing = timing,
+        .seed = 20260315ull,
+        .capture_tick_trace = false,
+    };
+}
+
+scenario_definition make_open_loop_scenario(std::uint32_t target_hz, bool background_load, timing_config timing) {
+    std::string variant = std::to_string(target_hz) + "hz-" + (background_load ? "loaded" : "idle");
+    return scenario_definition{
+        .scenario_id = "B11-alt-255-" + variant,
+        .group_id = "B11",
+        .kind = benchmark_kind::open_loop,
+        .family = tree_family::alt,
+        .tree_size_nodes = 255,
+        .logging = logging_mode::off,
+        .schedule = schedule_kind::none,
+        .lifecycle = lifecycle_phase::none,
+        .gc_mode = gc_benchmark_mode::none,
+        .async_case = async_contract_case::none,
+        .planner = {},
+        .fanout = 2,
+        .instance_count = 1,
+        .target_hz = target_hz,
+        .background_load = background_load,
+        .variant = std::move(variant),
+        .timing = timing,
+        .seed = 20260315ull,
+        .capture_tick_trace = false,
+    };
+}
+
 const std::vector<scenario_definition>& scenario_catalogue() {
     static const std::vector<scenario_definition> catalogue = [] {
         std::vector<scenario_definition> scenarios;
-        scenarios.reserve(49);
+        scenarios.reserve(110);
 
         scenarios.push_back(
             make_static_scenario("A1-single-leaf-off", "A1", tree_family::single_leaf, 1, logging_mode::off, "base"));
@@ -253,6 +387,115 @@ const std::vector<scenario_definition>& scenario_catalogue() {
                                                          "late-completion-after-cancel",
                                                          b8_timing));
 
+        const timing_config b9_timing{
+            .warmup = std::chrono::milliseconds(50),
+            .run = std::chrono::milliseconds(500),
+            .repetitions = 3,
+        };
+        struct planner_sample_counts {
+            planner_benchmark_backend backend;
+            std::size_t small;
+            std::size_t large;
+        };
+        for (const planner_sample_counts& counts : {
+                 planner_sample_counts{planner_benchmark_backend::mcts, 256u, 1024u},
+                 planner_sample_counts{planner_benchmark_backend::mppi, 64u, 256u},
+                 planner_sample_counts{planner_benchmark_backend::ilqr, 10u, 30u},
+             }) {
+            for (const char* model : {"toy-1d", "toy-unicycle"}) {
+                for (const std::size_t horizon : {10u, 30u}) {
+                    for (const std::size_t samples : {counts.small, counts.large}) {
+                        scenarios.push_back(make_planner_scenario(counts.backend, model, horizon, samples, b9_timing));
+                    }
+                }
+            }
+        }
+
+        const timing_config b10_timing{
+            .warmup = std::chrono::milliseconds(50),
+            .run = std::chrono::milliseconds(500),
+            .repetitions = 3,
+        };
+        for (const std::size_t size : {1000u, 10000u, 100000u}) {
+            scenarios.push_back(make_scaling_scenario("size", size, 4u, 1u, b10_timing));
+        }
+        for (const std::size_t fanout : {2u, 4u, 8u, 16u, 64u}) {
+            scenarios.push_back(make_scaling_scenario("shape", 10000u, fanout, 1u, b10_timing));
+        }
+        for (const std::size_t instances : {1u, 4u, 16u, 64u, 256u, 1024u}) {
+            scenarios.push_back(make_scaling_scenario("instances", 255u, 2u, instances, b10_timing));
+        }
+
+        const timing_config b11_timing{
+            .warmup = std::chrono::milliseconds(500),
+            .run = std::chrono::milliseconds(10000),
+            .repetitions = 3,
+        };
+        scenarios.push_back(make_open_loop_scenario(100u, false, b11_timing));
+        scenarios.push_back(make_open_loop_scenario(100u, true, b11_timing));
+        scenarios.push_back(make_open_loop_scenario(1000u, true, b11_timing));
+
+        const timing_config b12_timing{
+            .warmup = std::chrono::milliseconds(50),
+            .run = std::chrono::milliseconds(250),
+            .repetitions = 3,
+        };
+        for (const logging_mode logging : {logging_mode::off,
+                                           logging_mode::fulltrace,
+                                           logging_mode::ring,
+                                           logging_mode::file_tick_flush,
+                                           logging_mode::file_each_flush,
+                                           logging_mode::line_listener,
+                                           logging_mode::tick_audit,
+                                           logging_mode::trace}) {
+            scenarios.push_back(make_static_scenario("B12-alt-31-layer-" + std::string(logging_mode_name(logging)),
+                                                     "B12",
+                                                     tree_family::alt,
+                                                     31,
+                                                     logging,
+                                                     "layer",
+                                                     b12_timing));
+        }
+        for (const logging_mode logging : {logging_mode::off, logging_mode::read_trace}) {
+            scenario_definition scenario = make_static_scenario("B12-alt-31-bbread-" + std::string(logging_mode_name(logging)),
+                                                                "B12",
+                                                                tree_family::alt,
+                                                                31,
+                                                                logging,
+                                                                "bbread",
+                                                                b12_timing);
+            scenario.blackboard_reads = true;
+            scenarios.push_back(std::move(scenario));
+        }
+
+        const timing_config b13_timing{
+            .warmup = std::chrono::milliseconds(50),
+            .run = std::chrono::milliseconds(500),
+            .repetitions = 3,
+        };
+        for (const lisp_benchmark_op op :
+             {lisp_benchmark_op::symbol_lookup, lisp_benchmark_op::closure_call, lisp_benchmark_op::arith_loop}) {
+            scenarios.push_back(make_lisp_scenario(op, false, b13_timing));
+            scenarios.push_back(make_lisp_scenario(op, true, b13_timing));
+        }
+        for (const lisp_benchmark_op op : {lisp_benchmark_op::map_ops,
+                                           lisp_benchmark_op::vec_ops,
+                                           lisp_benchmark_op::json_encode,
+                                           lisp_benchmark_op::json_decode}) {
+            scenarios.push_back(make_lisp_scenario(op, false, b13_timing));
+        }
+
+        const timing_config b14_timing{
+            .warmup = std::chrono::milliseconds(0),
+            .run = std::chrono::milliseconds(0),
+            .repetitions = 3,
+        };
+        for (const std::size_t size : {31u, 255u}) {
+            for (const std::size_t instances : {1u, 100u}) {
+                scenarios.push_back(make_memory_footprint_scenario(size, instances, b14_timing));
+            }
+        }
+
         timing_config jitter_timing;
         jitter_timing.warmup = std::chrono::milliseconds(2000);
         jitter_timing.run = std::chrono::milliseconds(60000);
@@ -281,6 +524,16 @@ std::string_view benchmark_kind_name(benchmark_kind kind) noexcept {
             return "memory_gc";
         case benchmark_kind::async_contract:
             return "async_contract";
+        case benchmark_kind::planner:
+            return "planner";
+        case benchmark_kind::scaling:
+            return "scaling";
+        case benchmark_kind::open_loop:
+            return "open_loop";
+        case benchmark_kind::lisp_eval:
+            return "lisp_eval";
+        case benchmark_kind::memory_footprint:
+            return "memory_footprint";
     }
     return "unknown";
 }
@@ -327,6 +580,20 @@ std::string_view logging_mode_name(logging_mode mode) noexcept {
             return "off";
         case logging_mode::fulltrace:
             return "fulltrace";
+        case logging_mode::ring:
+            return "ring";
+        case logging_mode::file_tick_flush:
+            return "file-tickflush";
+        case logging_mode::file_each_flush:
+            return "file-eachflush";
+        case logging_mode::line_listener:
+            return "listener";
+        case logging_mode::tick_audit:
+            return "audit";
+        case logging_mode::trace:
+            return "trace";
+        case logging_mode::read_trace:
+            return "readtrace";
     }
     return "unknown";
 }
@@ -347,6 +614,42 @@ std::string_view schedule_kind_name(schedule_kind kind) noexcept {
     return "unknown";
 }
 
+std::string_view planner_benchmark_backend_name(planner_benchmark_backend backend) noexcept {
+    switch (backend) {
+        case planner_benchmark_backend::none:
+            return "";
+        case planner_benchmark_backend::mcts:
+            return "mcts";
+        case planner_benchmark_backend::mppi:
+            return "mppi";
+        case planner_benchmark_backend::ilqr:
+            return "ilqr";
+    }
+    return "unknown";
+}
+
+std::string_view lisp_benchmark_op_name(lisp_benchmark_op op) noexcept {
+    switch (op) {
+        case lisp_benchmark_op::none:
+            return "";
+        case lisp_benchmark_op::symbol_lookup:
+            return "symbol-lookup";
+        case lisp_benchmark_op::closure_call:
+            return "closure-call";
+        case lisp_benchmark_op::arith_loop:
+            return "arith-loop";
+        case lisp_benchmark_op::map_ops:
+            return "map-ops";
+        case lisp_benchmark_op::vec_ops:
+            return "vec-ops";
+        case lisp_benchmark_op::json_encode:
+            return "json-encode";
+        case lisp_benchmark_op::json_decode:
+            return "json-decode";
+    }
+    return "unknown";
+}
+
 std::vector<scenario_definition> default_scenarios() {
     return scenario_catalogue();
 }
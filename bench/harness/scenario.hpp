@@ -9,7 +9,7 @@
 
 namespace muesli_bt::bench {
 
-inline constexpr std::string_view kSchemaVersion = "5";
+inline constexpr std::string_view kSchemaVersion = "8";
 inline constexpr std::string_view kBenchmarkSuiteVersion = "0.1.0-m1";
 
 enum class benchmark_kind {
@@ -18,7 +18,12 @@ enum class benchmark_kind {
     reactive_interrupt,
     compile_lifecycle,
     memory_gc,
-    async_contract
+    async_contract,
+    planner,
+    scaling,
+    open_loop,
+    lisp_eval,
+    memory_footprint
 };
 
 enum class lifecycle_phase {
@@ -39,9 +44,19 @@ enum class tree_family {
     reactive
 };
 
+// Observability configurations. `fulltrace` serialises every event but keeps no sink; the B12
+// layers each add one sink or tracing feature on top of that (or, for the trace layers, use the
+// in-memory trace buffer instead of the event log).
 enum class logging_mode {
     off,
-    fulltrace
+    fulltrace,
+    ring,
+    file_tick_flush,
+    file_each_flush,
+    line_listener,
+    tick_audit,
+    trace,
+    read_trace
 };
 
 enum class schedule_kind {
@@ -68,6 +83,41 @@ enum class async_contract_case {
     late_completion_after_cancel
 };
 
+enum class planner_benchmark_backend {
+    none,
+    mcts,
+    mppi,
+    ilqr
+};
+
+// One planner_service::plan configuration. `samples` is the backend's unit of work: MCTS
+// iterations, MPPI rollouts, or iLQR iterations.
+struct planner_benchmark_case {
+    planner_benchmark_backend backend = planner_benchmark_backend::none;
+    std::string model;
+    std::size_t horizon = 0;
+    std::size_t samples = 0;
+};
+
+enum class lisp_benchmark_op {
+    none,
+    symbol_lookup,
+    closure_call,
+    arith_loop,
+    map_ops,
+    vec_ops,
+    json_encode,
+    json_decode
+};
+
+// One Lisp-core operation (B13): a call of a closure defined by the scenario's program. With
+// `interpreted` set the closure is run by the tree-walking evaluator even when compiled_eval could
+// compile it.
+struct lisp_benchmark_case {
+    lisp_benchmark_op op = lisp_benchmark_op::none;
+    bool interpreted = false;
+};
+
 struct timing_config {
     std::chrono::milliseconds warmup{2000};
     std::chrono::milliseconds run{10000};
@@ -85,6 +135,18 @@ struct scenario_definition {
     lifecycle_phase lifecycle = lifecycle_phase::none;
     gc_benchmark_mode gc_mode = gc_benchmark_mode::none;
     async_contract_case async_case = async_contract_case::none;
+    planner_benchmark_case planner{};
+    lisp_benchmark_case lisp{};
+    // Scaling sweeps (B10): children per composite node, and how many instances one timed round
+    // ticks.
+    std::size_t fanout = 2;
+    std::size_t instance_count = 1;
+    // Open-loop runs (B11): the fixed rate ticks are scheduled at, and whether async jobs and GC
+    // pressure run alongside the ticks.
+    std::uint32_t target_hz = 0;
+    bool background_load = false;
+    // Condition leaves read a blackboard key each tick (B12 read-trace layer).
+    bool blackboard_reads = false;
     std::string variant;
     timing_config timing{};
     std::uint64_t seed = 20260315ull;
@@ -96,6 +158,8 @@ std::string_view lifecycle_phase_name(lifecycle_phase phase) noexcept;
 std::string_view tree_family_name(tree_family family) noexcept;
 std::string_view logging_mode_name(logging_mode mode) noexcept;
 std::string_view schedule_kind_name(schedule_kind kind) noexcept;
+std::string_view planner_benchmark_backend_name(planner_benchmark_backend backend) noexcept;
+std::string_view lisp_benchmark_op_name(lisp_benchmark_op op) noexcept;
 
 std::vector<scenario_definition> default_scenarios();
 std::vector<scenario_definition> scenarios_for_group(std::string_view group_id);
@@ -30,6 +30,31 @@ T percentile_sorted(const std::vector<T>& sorted, double fraction) {
     return sorted[index - 1u];
 }
 
+// Number of orderings of `m` candidate and `n` baseline samples, indexed by U (pairs in which the
+// candidate sample is larger). Built up by placing the largest sample last.
+std::vector<double> mann_whitney_u_counts(std::size_t m, std::size_t n) {
+    std::vector<std::vector<std::vector<double>>> counts(m + 1u, std::vector<std::vector<double>>(n + 1u));
+    for (std::size_t i = 0; i <= m; ++i) {
+        for (std::size_t j = 0; j <= n; ++j) {
+            std::vector<double>& cell = counts[i][j];
+            cell.assign(i * j + 1u, 0.0);
+            if (i == 0u || j == 0u) {
+                cell[0] = 1.0;
+                continue;
+            }
+            const std::vector<double>& candidate_last = counts[i - 1u][j];
+            for (std::size_t u = 0; u < candidate_last.size(); ++u) {
+                cell[u + j] += candidate_last[u];
+            }
+            const std::vector<double>& baseline_last = counts[i][j - 1u];
+            for (std::size_t u = 0; u < baseline_last.size(); ++u) {
+                cell[u] += baseline_last[u];
+            }
+        }
+    }
+    return counts[m][n];
+}
+
 }  // namespace
 
 latency_summary summarise_latencies(const std::vector<std::uint64_t>& samples) {
@@ -93,4 +118,65 @@ double stddev_double(const std::vector<double>& samples) {
     return std::sqrt(accum / static_cast<double>(samples.size()));
 }
 
+double mann_whitney_greater_p(const std::vector<double>& baseline, const std::vector<double>& candidate) {
+    // Exact counts stay cheap up to 20 samples a side.
+    constexpr std::size_t kExactPairLimit = 400u;
+
+    if (baseline.empty() || candidate.empty()) {
+        return 1.0;
+    }
+
+    double u = 0.0;
+    bool tied = false;
+    for (const double c : candidate) {
+        for (const double b : baseline) {
+            if (c > b) {
+                u += 1.0;
+            } else if (c == b) {
+                u += 0.5;
+                tied = true;
+            }
+        }
+    }
+
+    const std::size_t m = candidate.size();
+    const std::size_t n = baseline.size();
+    if (!tied && m * n <= kExactPairLimit) {
+        const std::vector<double> counts = mann_whitney_u_counts(m, n);
+        double total = 0.0;
+        double at_least = 0.0;
+        for (std::size_t value = 0; value < counts.size(); ++value) {
+            total += counts[value];
+            if (static_cast<double>(value) >= u) {
+                at_least += counts[value];
+            }
+        }
+        return at_least / total;
+    }
+
+    std::vector<double> pooled = baseline;
+    pooled.insert(pooled.end(), candidate.begin(), candidate.end());
+    std::sort(pooled.begin(), pooled.end());
+    double tie_term = 0.0;
+    for (std::size_t start = 0; start < pooled.size();) {
+        std::size_t end = start;
+        while (end < pooled.size() && pooled[end] == pooled[start]) {
+            ++end;
+        }
+        const double run = static_cast<double>(end - start);
+        tie_term += run * run * run - run;
+        start = end;
+    }
+
+    const double md = static_cast<double>(m);
+    const double nd = static_cast<double>(n);
+    const double total = md + nd;
+    const double variance = md * nd / 12.0 * ((total + 1.0) - tie_term / (total * (total - 1.0)));
+    if (variance <= 0.0) {
+        return 1.0;
+    }
+    const double z = (u - md * nd / 2.0 - 0.5) / std::sqrt(variance);
+    return 0.5 * std::erfc(z / std::sqrt(2.0));
+}
+
 }  // namespace muesli_bt::bench
@@ -14,10 +14,17 @@ struct latency_summary {
     double jitter_ratio_p99_over_median = 0.0;
 };
 
+// Percentiles of the samples as given. Back-to-back (closed-loop) tick times leave out time a tick
+// spent waiting behind a slow one; B11 passes open-loop response times, measured from each tick's
+// scheduled start, so the waiting is counted.
 latency_summary summarise_latencies(const std::vector<std::uint64_t>& samples);
 std::uint64_t percentile_u64(std::vector<std::uint64_t> samples, double fraction);
 double percentile_double(std::vector<double> samples, double fraction);
 double mean_double(const std::vector<double>& samples);
 double stddev_double(const std::vector<double>& samples);
+// One-sided Mann-Whitney U test: the p-value for `candidate` tending to be larger than `baseline`.
+// Exact when the samples are small and untied, otherwise the tie-corrected normal approximation
+// with continuity correction. Returns 1 when either side is empty.
+double mann_whitney_greater_p(const std::vector<double>& baseline, const std::vector<double>& candidate);
 
 }  // namespace muesli_bt::bench
@@ -1,8 +1,11 @@
+#include <filesystem>
 #include <iostream>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <vector>
 
+#include "harness/regression_gate.hpp"
 #include "harness/runner.hpp"
 
 namespace {
@@ -10,9 +13,15 @@ namespace {
 void print_usage() {
     std::cout << "usage:\n"
               << "  bench list\n"
-              << "  bench run <scenario-id> [--runtime NAME] [--output-dir DIR] [--warmup-ms N] [--run-ms N] [--repetitions N] [--seed N]\n"
-              << "  bench run-group <group-id> [--runtime NAME] [--output-dir DIR] [--warmup-ms N] [--run-ms N] [--repetitions N] [--seed N]\n"
-              << "  bench run-all [--runtime NAME] [--output-dir DIR] [--warmup-ms N] [--run-ms N] [--repetitions N] [--seed N]\n";
+              << "  bench run <scenario-id> [--runtime NAME] [--output-dir DIR] [--warmup-ms N] [--run-ms N] [--repetitions N] [--seed N] [--perf-counters]\n"
+              << "  bench run-group <group-id> [--runtime NAME] [--output-dir DIR] [--warmup-ms N] [--run-ms N] [--repetitions N] [--seed N] [--perf-counters]\n"
+              << "  bench run-all [--runtime NAME] [--output-dir DIR] [--warmup-ms N] [--run-ms N] [--repetitions N] [--seed N] [--perf-counters]\n"
+              << "\n"
+              << "regression gate (run, run-group, run-all):\n"
+              << "  --baseline PATH        compare against a stored run_summary.csv or result directory\n"
+              << "  --gate                 exit with status 2 when a metric regresses significantly\n"
+              << "  --gate-threshold PCT   smallest median change that counts, in percent (default 5)\n"
+              << "  --gate-alpha A         one-sided Mann-Whitney significance level (default 0.05)\n";
 }
 
 std::string require_value(const std::vector<std::string>& args, std::size_t& index, const std::string& option) {
@@ -36,6 +45,9 @@ int main(int argc, char** argv) {
         }
 
         run_request request;
+        std::optional<std::filesystem::path> baseline_path;
+        bool gate = false;
+        gate_options gate_settings;
         std::string command = args[0];
 
         if (command == "list") {
@@ -85,11 +97,25 @@ int main(int argc, char** argv) {
                 request.seed_override = std::stoull(require_value(args, cursor, arg));
             } else if (arg == "--runtime") {
                 request.runtime_name = require_value(args, cursor, arg);
+            } else if (arg == "--perf-counters") {
+                request.perf_counters = true;
+            } else if (arg == "--baseline") {
+                baseline_path = require_value(args, cursor, arg);
+            } else if (arg == "--gate") {
+                gate = true;
+            } else if (arg == "--gate-threshold") {
+                gate_settings.threshold = std::stod(require_value(args, cursor, arg)) / 100.0;
+            } else if (arg == "--gate-alpha") {
+                gate_settings.alpha = std::stod(require_value(args, cursor, arg));
             } else {
                 throw std::invalid_argument("unknown option: " + arg);
             }
         }
 
+        if (gate && !baseline_path.has_value()) {
+            throw std::invalid_argument("--gate requires --baseline");
+        }
+
         request.progress_callback = [](const progress_event& event) {
             if (event.kind == progress_event_kind::suite_started) {
                 std::cout << event.total_scenarios << " benchmarks queued"
@@ -106,6 +132,25 @@ int main(int argc, char** argv) {
         benchmark_runner runner;
         const run_result result = runner.run(request);
         std::cout << "wrote benchmark results to " << result.output_dir << '\n';
+
+        if (baseline_path.has_value()) {
+            const gate_report report = run_regression_gate(*baseline_path, result.output_dir, gate_settings);
+            write_regression_report(result.output_dir, report);
+            for (const gate_comparison& comparison : report.comparisons) {
+                if (comparison.verdict == gate_verdict::regression || comparison.verdict == gate_verdict::improvement) {
+                    std::cout << gate_verdict_name(comparison.verdict) << ": " << comparison.runtime_name << ' '
+                              << comparison.scenario_id << ' ' << comparison.metric << ' '
+                              << comparison.baseline_median << " -> " << comparison.current_median
+                              << " (p=" << comparison.p_value << ")\n";
+                }
+            }
+            std::cout << "regression gate: " << report.regression_count() << " regression(s) in "
+                      << report.comparisons.size() << " comparisons; wrote "
+                      << (result.output_dir / "regression_report.json") << '\n';
+            if (gate && !report.passed()) {
+                return 2;
+            }
+        }
         return 0;
     } catch (const std::exception& e) {
         std::cerr << "bench: " << e.what() << '\n';
@@ -8,10 +8,13 @@
 #include <optional>
 #include <stdexcept>
 #include <string>
+#include <system_error>
 #include <utility>
+#include <vector>
 
 #include <behaviortree_cpp/action_node.h>
 #include <behaviortree_cpp/bt_factory.h>
+#include <behaviortree_cpp/loggers/abstract_logger.h>
 
 #include "bench_config.hpp"
 #include "fixtures/schedules.hpp"
@@ -144,6 +147,89 @@ private:
     std::shared_ptr<benchmark_state> state_;
 };
 
+std::filesystem::path bench_event_file_path(const scenario_definition& scenario) {
+    return std::filesystem::temp_directory_path() / ("btcpp-bench-" + scenario.scenario_id + ".jsonl");
+}
+
+// The B12 layers over BehaviorTree.CPP's status-change hook. Each transition is serialised to one
+// JSON line, as muesli-bt's event log does for node events, and then handed to the layer's sink:
+// none (fulltrace), a bounded in-memory ring, a file flushed per tick or per line, or a listener.
+// BehaviorTree.CPP has no counterpart to tick audits or the trace buffer.
+class bench_status_logger final : public BT::StatusChangeLogger {
+public:
+    bench_status_logger(BT::TreeNode* root, std::shared_ptr<benchmark_state> state)
+        : BT::StatusChangeLogger(root), state_(std::move(state)) {
+        const logging_mode logging = state_->scenario.logging;
+        if (logging == logging_mode::ring) {
+            ring_.resize(kRingCapacity);
+        }
+        if (logging == logging_mode::file_tick_flush || logging == logging_mode::file_each_flush) {
+            file_.open(bench_event_file_path(state_->scenario), std::ios::trunc);
+            if (!file_) {
+                throw std::runtime_error("btcpp adapter: failed to open event file");
+            }
+        }
+    }
+
+    void callback(BT::Duration timestamp,
+                  const BT::TreeNode& node,
+                  BT::NodeStatus prev_status,
+                  BT::NodeStatus status) override {
+        line_.clear();
+        line_ += "{\"t_ns\":";
+        line_ += std::to_string(std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp).count());
+        line_ += ",\"node\":";
+        line_ += std::to_string(node.UID());
+        line_ += ",\"name\":\"";
+        line_ += node.name();
+        line_ += "\",\"from\":\"";
+        line_ += BT::toStr(prev_status);
+        line_ += "\",\"to\":\"";
+        line_ += BT::toStr(status);
+        line_ += "\"}";
+        ++state_->counters.log_events_total;
+        state_->counters.log_bytes_total += line_.size();
+
+        switch (state_->scenario.logging) {
+            case logging_mode::ring:
+                ring_[ring_next_++ % ring_.size()].assign(line_);
+                break;
+            case logging_mode::file_tick_flush:
+                file_ << line_ << '\n';
+                break;
+            case logging_mode::file_each_flush:
+                file_ << line_ << '\n';
+                file_.flush();
+                break;
+            case logging_mode::line_listener:
+                listener_bytes_ += line_.size();
+                break;
+            case logging_mode::off:
+            case logging_mode::fulltrace:
+            case logging_mode::tick_audit:
+            case logging_mode::trace:
+            case logging_mode::read_trace:
+                break;
+        }
+    }
+
+    void flush() override {
+        if (file_.is_open()) {
+            file_.flush();
+        }
+    }
+
+private:
+    static constexpr std::size_t kRingCapacity = 4096u;
+
+    std::shared_ptr<benchmark_state> state_;
+    std::string line_;
+    std::vector<std::string> ring_;
+    std::size_t ring_next_ = 0u;
+    std::ofstream file_;
+    std::uint64_t listener_bytes_ = 0u;
+};
+
 void register_common_nodes(BT::BehaviorTreeFactory& factory, const std::shared_ptr<benchmark_state>& state) {
     factory.registerSimpleCondition("cond_ok", [](BT::TreeNode&) { return BT::NodeStatus::SUCCESS; });
     factory.registerSimpleCondition("cond_fail", [](BT::TreeNode&) { return BT::NodeStatus::FAILURE; });
@@ -170,10 +256,32 @@ void register_common_nodes(BT::BehaviorTreeFactory& factory, const std::shared_p
 }
 
 bool supports_btcpp_scenario(const scenario_definition& scenario) {
-    if (scenario.kind == benchmark_kind::memory_gc || scenario.kind == benchmark_kind::async_contract) {
+    if (scenario.kind == benchmark_kind::memory_gc || scenario.kind == benchmark_kind::async_contract ||
+        scenario.kind == benchmark_kind::planner || scenario.kind == benchmark_kind::lisp_eval ||
+        scenario.kind == benchmark_kind::memory_footprint) {
         return false;
     }
-    if (scenario.logging != logging_mode::off) {
+    switch (scenario.logging) {
+        case logging_mode::off:
+            break;
+        case logging_mode::fulltrace:
+        case logging_mode::ring:
+        case logging_mode::file_tick_flush:
+        case logging_mode::file_each_flush:
+        case logging_mode::line_listener:
+            if (scenario.group_id != "B12") {
+                return false;
+            }
+            break;
+        case logging_mode::tick_audit:
+        case logging_mode::trace:
+        case logging_mode::read_trace:
+            return false;
+    }
+    if (scenario.blackboard_reads) {
+        return false;
+    }
+    if (scenario.background_load) {
         return false;
     }
     if (scenario.group_id == "B6") {
@@ -212,14 +320,27 @@ public:
         rebuild_tree();
     }
 
+    ~instance_impl() override {
+        const bool file_layer = logger && (state->scenario.logging == logging_mode::file_tick_flush ||
+                                           state->scenario.logging == logging_mode::file_each_flush);
+        logger.reset();
+        if (file_layer) {
+            std::error_code ignored;
+            std::filesystem::remove(bench_event_file_path(state->scenario), ignored);
+        }
+    }
+
     void rebuild_tree() {
+        logger.reset();
         state->clear_counters();
-        state->scenario.logging = logging_mode::off;
 
         BT::BehaviorTreeFactory factory;
         register_common_nodes(factory, state);
         factory.registerBehaviorTreeFromText(compiled->xml);
         tree = factory.createTree(kTreeId);
+        if (state->scenario.logging != logging_mode::off) {
+            logger = std::make_unique<bench_status_logger>(tree.rootNode(), state);
+        }
     }
 
     void prime_hot_path() {
@@ -235,6 +356,8 @@ public:
     const compiled_tree_impl* compiled = nullptr;
     std::shared_ptr<benchmark_state> state;
     BT::Tree tree;
+    // Declared after `tree` so that it unsubscribes before the nodes go away.
+    std::unique_ptr<bench_status_logger> logger;
 };
 
 class btcpp_adapter::lifecycle_case_impl final : public runtime_adapter::lifecycle_case {
@@ -400,6 +523,9 @@ run_status btcpp_adapter::tick(runtime_adapter::instance_handle& instance) {
     ++state.current_tick_index;
 
     const BT::NodeStatus status = typed.tree.tickExactlyOnce();
+    if (typed.logger && state.scenario.logging == logging_mode::file_tick_flush) {
+        typed.logger->flush();
+    }
     const run_status run_state = from_btcpp_status(status);
 
     if (state.scenario.kind == benchmark_kind::reactive_interrupt) {
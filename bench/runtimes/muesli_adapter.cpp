@@ -9,6 +9,8 @@
 #include <optional>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <system_error>
 #include <utility>
 
 #include "bench_config.hpp"
@@ -16,6 +18,7 @@
 #include "bt/compiler.hpp"
 #include "bt/event_log.hpp"
 #include "bt/instance.hpp"
+#include "bt/instance_pool.hpp"
 #include "bt/registry.hpp"
 #include "bt/runtime.hpp"
 #include "bt/serialisation.hpp"
@@ -73,6 +76,41 @@ std::size_t estimate_interrupt_capacity(const scenario_definition& scenario, std
     return 0u;
 }
 
+// B12 layer sizes: events kept by the ring layer, trace records kept by the trace layers.
+constexpr std::size_t k_bench_ring_capacity = 4096u;
+constexpr std::size_t k_bench_trace_capacity = 4096u;
+// Blackboard key read by `cond_bb_ok` leaves.
+constexpr std::string_view k_bench_ready_key = "bench_ready";
+
+bool uses_event_log(logging_mode mode) noexcept {
+    switch (mode) {
+        case logging_mode::fulltrace:
+        case logging_mode::ring:
+        case logging_mode::file_tick_flush:
+        case logging_mode::file_each_flush:
+        case logging_mode::line_listener:
+        case logging_mode::tick_audit:
+            return true;
+        case logging_mode::off:
+        case logging_mode::trace:
+        case logging_mode::read_trace:
+            return false;
+    }
+    return false;
+}
+
+bool uses_trace_buffer(logging_mode mode) noexcept {
+    return mode == logging_mode::trace || mode == logging_mode::read_trace;
+}
+
+bool uses_event_file(logging_mode mode) noexcept {
+    return mode == logging_mode::file_tick_flush || mode == logging_mode::file_each_flush;
+}
+
+std::filesystem::path bench_event_file_path(const scenario_definition& scenario) {
+    return std::filesystem::temp_directory_path() / ("muesli-bt-bench-" + scenario.scenario_id + ".jsonl");
+}
+
 class allocation_measure_scope {
 public:
     allocation_measure_scope() {
@@ -122,25 +160,18 @@ public:
         : owner(owner_value),
           compiled_tree(&compiled),
           scenario(std::move(scenario_value)),
-          runtime_instance(&compiled.definition, 0u),
+          runtime_instance(&compiled.definition, uses_trace_buffer(scenario.logging) ? k_bench_trace_capacity : 0u),
           event_log(0u) {
-        runtime_instance.trace_enabled = false;
-        runtime_instance.read_trace_enabled = false;
-
         services.sched = nullptr;
         services.obs.trace = nullptr;
         services.obs.logger = nullptr;
-        services.obs.events = scenario.logging == logging_mode::fulltrace ? &event_log : nullptr;
         services.clock = nullptr;
         services.robot = nullptr;
         services.planner = nullptr;
         services.vla = nullptr;
 
-        event_log.set_ring_capacity(0u);
-        event_log.set_enabled(scenario.logging == logging_mode::fulltrace);
-        event_log.set_capture_stats_enabled(scenario.logging == logging_mode::fulltrace);
-        event_log.set_file_enabled(false);
-        event_log.set_flush_on_tick_end(false);
+        configure_observability();
+        seed_blackboard();
         event_log.set_git_sha(MUESLI_BT_BENCH_GIT_COMMIT);
         event_log.set_host_info("muesli-bt-bench", MUESLI_BT_BENCH_PROJECT_VERSION, "bench");
         event_log.set_run_id(scenario.scenario_id + "-warmup");
@@ -153,6 +184,54 @@ public:
 
     ~instance_impl() override {
         owner.instance_index_.erase(&runtime_instance);
+        if (uses_event_file(scenario.logging)) {
+            event_log.set_file_enabled(false);
+            std::error_code ignored;
+            std::filesystem::remove(bench_event_file_path(scenario), ignored);
+        }
+    }
+
+    // Applies the scenario's logging layer. A file layer starts a fresh file, so the sink holds
+    // at most one repetition.
+    void configure_observability() {
+        const logging_mode logging = scenario.logging;
+        const bool events = uses_event_log(logging);
+        runtime_instance.trace_enabled = uses_trace_buffer(logging);
+        runtime_instance.read_trace_enabled = logging == logging_mode::read_trace;
+        services.obs.events = events ? &event_log : nullptr;
+
+        bt::emission_policy policy;
+        if (logging == logging_mode::tick_audit) {
+            policy.family_mask = bt::emission_policy::bit(bt::event_family::alert);
+            policy.always_emit_failures = false;
+        }
+        event_log.set_emission_policy(policy);
+        event_log.set_enabled(events);
+        event_log.set_capture_stats_enabled(events);
+        event_log.set_tick_audit_enabled(logging == logging_mode::tick_audit);
+        event_log.set_ring_capacity(logging == logging_mode::ring ? k_bench_ring_capacity : 0u);
+        event_log.set_flush_on_tick_end(logging == logging_mode::file_tick_flush);
+        event_log.set_flush_each_message(logging == logging_mode::file_each_flush);
+        event_log.clear_line_listener();
+        if (logging == logging_mode::line_listener) {
+            event_log.set_line_listener([this](const std::string& line) { listener_bytes += line.size(); });
+        }
+
+        event_log.set_file_enabled(false);
+        if (uses_event_file(logging)) {
+            const std::filesystem::path path = bench_event_file_path(scenario);
+            std::error_code ignored;
+            std::filesystem::remove(path, ignored);
+            event_log.set_path(path.string());
+            event_log.set_file_enabled(true);
+        }
+    }
+
+    void seed_blackboard() {
+        if (scenario.blackboard_reads) {
+            runtime_instance.bb.put(
+                k_bench_ready_key, true, 0u, std::chrono::steady_clock::now(), 0u, "muesli-bt-bench");
+        }
     }
 
     void clear_runtime_state() {
@@ -162,7 +241,7 @@ public:
         bt::reset(runtime_instance);
         runtime_instance.tick_index = 0u;
         runtime_instance.tree_stats = {};
-        runtime_instance.node_stats.clear();
+        runtime_instance.clear_node_stats();
         runtime_instance.trace.clear();
     }
 
@@ -216,6 +295,8 @@ public:
     std::uint64_t activation_tick = 0u;
     std::chrono::steady_clock::time_point activation_started_at{};
     std::size_t repetition_index = 0u;
+    // What the line-listener layer's listener does with each line.
+    std::uint64_t listener_bytes = 0u;
 };
 
 class muesli_adapter::lifecycle_case_impl final : public runtime_adapter::lifecycle_case {
@@ -304,8 +385,11 @@ private:
                 ensure_parsed_form();
                 return;
             case lifecycle_phase::instantiate_one:
+                ensure_compiled_definition();
+                return;
             case lifecycle_phase::instantiate_hundred:
                 ensure_compiled_definition();
+                instance_pool_ = std::make_unique<bt::instance_pool>(compiled_definition_.get(), nullptr, 0u, 100u);
                 return;
             case lifecycle_phase::load_binary:
                 ensure_compiled_definition();
@@ -347,13 +431,18 @@ private:
         });
     }
 
+    // Episode-style churn: a hundred instances taken from the definition's pool and handed back, so
+    // after warmup each one is a recycled instance rather than a fresh allocation.
     lifecycle_sample instantiate_hundred_once() {
         return measure_phase(100u, [this] {
-            std::array<std::optional<bt::instance>, 100u> instances;
+            std::array<std::unique_ptr<bt::instance>, 100u> instances;
             for (auto& instance : instances) {
-                instance.emplace(compiled_definition_.get(), 0u);
+                instance = instance_pool_->acquire();
             }
             sink_ = instances.back()->halt_stack.capacity();
+            for (auto& instance : instances) {
+                instance_pool_->release(std::move(instance));
+            }
         });
     }
 
@@ -380,6 +469,7 @@ private:
     std::filesystem::path scratch_dir_;
     std::string source_;
     std::unique_ptr<bt::definition> compiled_definition_;
+    std::unique_ptr<bt::instance_pool> instance_pool_;
     muslisp::value parsed_form_ = nullptr;
     bool parsed_form_rooted_ = false;
     std::filesystem::path binary_path_;
@@ -460,10 +550,9 @@ void muesli_adapter::prepare_for_timed_run(runtime_adapter::instance_handle& ins
     typed.counters.cancel_latency_ns.reserve(interrupt_capacity);
 
     typed.event_log.clear_ring();
-    typed.event_log.set_enabled(typed.scenario.logging == logging_mode::fulltrace);
-    typed.event_log.set_capture_stats_enabled(typed.scenario.logging == logging_mode::fulltrace);
+    typed.configure_observability();
     typed.event_log.clear_capture_stats();
-    typed.event_log.clear_line_listener();
+    typed.seed_blackboard();
 
     (void)bt::tick(typed.runtime_instance, *registry(), typed.services);
     if (typed.scenario.kind == benchmark_kind::reactive_interrupt) {
@@ -516,7 +605,7 @@ run_counters muesli_adapter::read_counters(const runtime_adapter::instance_handl
     const auto& typed = dynamic_cast<const instance_impl&>(instance);
     run_counters out = typed.counters;
     out.live_async_action = typed.async_running;
-    if (typed.scenario.logging == logging_mode::fulltrace) {
+    if (uses_event_log(typed.scenario.logging)) {
         const bt::event_log_stats stats = typed.event_log.capture_stats();
         out.log_events_total = stats.event_count;
         out.log_bytes_total = stats.byte_count;
@@ -569,6 +658,9 @@ void muesli_adapter::register_callbacks() {
     registry()->register_condition("cond_ok", [](bt::tick_context&, std::span<const muslisp::value>) { return true; });
     registry()->register_condition("cond_fail", [](bt::tick_context&, std::span<const muslisp::value>) { return false; });
     registry()->register_condition("cond_path_valid", [](bt::tick_context&, std::span<const muslisp::value>) { return true; });
+    registry()->register_condition("cond_bb_ok", [](bt::tick_context& ctx, std::span<const muslisp::value>) {
+        return ctx.bb_get(k_bench_ready_key) != nullptr;
+    });
 
     registry()->register_condition(
         "cond_emergency_stop",
@@ -1,3 +1,4 @@
+#include <cmath>
 #include <filesystem>
 #include <fstream>
 #include <memory>
@@ -8,6 +9,8 @@
 #include "bench_config.hpp"
 #include "fixtures/tree_factory.hpp"
 #include "harness/allocation_tracker.hpp"
+#include "harness/regression_gate.hpp"
+#include "harness/stats.hpp"
 #include "harness/runner.hpp"
 #include "runtimes/muesli_adapter.hpp"
 
@@ -44,6 +47,10 @@ void test_catalogue_contains_new_benchmarks() {
     check(find_scenario("B8-async-cancel-before-start") != nullptr, "missing B8 cancel-before-start scenario");
     check(find_scenario("B8-async-late-completion-after-cancel") != nullptr,
           "missing B8 late-completion-after-cancel scenario");
+    check(find_scenario("B9-planner-mcts-toy-1d-h10-s256") != nullptr, "missing B9 MCTS planner scenario");
+    check(find_scenario("B9-planner-mppi-toy-unicycle-h30-s256") != nullptr, "missing B9 MPPI planner scenario");
+    check(find_scenario("B9-planner-ilqr-toy-unicycle-h30-s30") != nullptr, "missing B9 iLQR planner scenario");
+    check(find_scenario("B10-shape-n10000-f2-i1") != nullptr, "missing B10 scaling scenario");
 }
 
 void test_runner_writes_expected_csv_files() {
@@ -76,6 +83,7 @@ void test_runner_writes_expected_csv_files() {
     const std::string environment_metadata = read_text(result.output_dir / "environment_metadata.csv");
     check(environment_metadata.find("clock_source") != std::string::npos, "environment metadata header missing");
     check(environment_metadata.find("muesli-bt") != std::string::npos, "environment metadata missing runtime name");
+    check(result.environment_row.perf_counters == "off", "perf counters should be off unless requested");
 
     const std::string manifest = read_text(result.output_dir / "experiment_manifest.json");
     for (const std::string& required : {
@@ -93,6 +101,44 @@ void test_runner_writes_expected_csv_files() {
     }
 }
 
+void test_runner_records_perf_counters_or_why_not() {
+    using namespace muesli_bt::bench;
+
+    const std::filesystem::path output_dir =
+        std::filesystem::temp_directory_path() / "muesli_bt_bench_perf_counters";
+    std::filesystem::remove_all(output_dir);
+
+    run_request request;
+    request.output_dir = output_dir;
+    request.scenarios.push_back(*find_scenario("A1-single-leaf-off"));
+    request.warmup_override = std::chrono::milliseconds(5);
+    request.run_override = std::chrono::milliseconds(10);
+    request.repetitions_override = 1u;
+    request.perf_counters = true;
+
+    benchmark_runner runner;
+    const run_result result = runner.run(request);
+    check(result.run_rows.size() == 1u, "perf counter run should write one row");
+
+    const std::string& mode = result.environment_row.perf_counters;
+    const run_summary_row& row = result.run_rows.front();
+    const bool any_counter = row.cpu_cycles || row.cpu_instructions || row.l1d_read_misses || row.llc_misses ||
+                             row.branch_misses;
+    if (mode.rfind("unavailable: ", 0) == 0) {
+        check(!any_counter, "unavailable perf counters should leave the counter columns empty");
+    } else {
+        check(mode != "off" && !mode.empty(), "requested perf counters should be recorded in the environment");
+        check(any_counter, "available perf counters should fill at least one counter column");
+    }
+
+    const std::string run_summary = read_text(result.output_dir / "run_summary.csv");
+    check(first_line(run_summary).find("cpu_cycles,cpu_instructions,l1d_read_misses,llc_misses,branch_misses") !=
+              std::string::npos,
+          "run summary header missing perf counter columns");
+    const std::string manifest = read_text(result.output_dir / "experiment_manifest.json");
+    check(manifest.find("\"perf_counters\": ") != std::string::npos, "experiment manifest missing perf_counters");
+}
+
 void test_fulltrace_mode_emits_log_bytes() {
     using namespace muesli_bt::bench;
 
@@ -309,6 +355,308 @@ void test_b8_async_contract_benchmarks_run() {
     }
 }
 
+void test_b9_planner_benchmarks_run() {
+    using namespace muesli_bt::bench;
+
+    const std::filesystem::path output_dir =
+        std::filesystem::temp_directory_path() / "muesli_bt_bench_b9_smoke";
+    std::filesystem::remove_all(output_dir);
+
+    run_request request;
+    request.output_dir = output_dir;
+    request.scenarios.push_back(*find_scenario("B9-planner-mcts-toy-1d-h10-s256"));
+    request.scenarios.push_back(*find_scenario("B9-planner-mppi-toy-unicycle-h10-s64"));
+    request.scenarios.push_back(*find_scenario("B9-planner-ilqr-toy-1d-h10-s10"));
+    request.warmup_override = std::chrono::milliseconds(0);
+    request.run_override = std::chrono::milliseconds(5);
+    request.repetitions_override = 1u;
+
+    benchmark_runner runner;
+    const run_result result = runner.run(request);
+
+    check(result.run_rows.size() == 3u, "expected three B9 run rows");
+    check(result.aggregate_rows.size() == 3u, "expected three B9 aggregate rows");
+    for (const run_summary_row& row : result.run_rows) {
+        check(row.group_id == "B9", "B9 row should use B9 group id");
+        check(row.ticks_total > 0u, "B9 should record plan count");
+        check(row.latency_ns_median > 0u, "B9 should record plan latency");
+        check(row.alloc_count_total > 0u, "B9 should record planner allocations");
+        check(row.semantic_errors == 0u, "B9 plans should succeed");
+        check(row.deadline_miss_count == 0u, "B9 plans should end on the work cap, not the budget");
+        check(row.notes.find("work_per_ms=") != std::string::npos, "B9 should record work per millisecond");
+        check(row.notes.find("action_error_median=") != std::string::npos, "B9 should record reference action error");
+    }
+    const std::string manifest = read_text(result.output_dir / "experiment_manifest.json");
+    check(manifest.find("\"planner_backend\": \"mppi\"") != std::string::npos,
+          "experiment manifest should describe the planner case");
+}
+
+std::size_t count_fixture_nodes(const muesli_bt::bench::fixture_node& node) {
+    std::size_t total = 1u;
+    for (const muesli_bt::bench::fixture_node& child : node.children) {
+        total += count_fixture_nodes(child);
+    }
+    return total;
+}
+
+void test_b10_scaling_benchmarks_run() {
+    using namespace muesli_bt::bench;
+
+    const scenario_definition* shape = find_scenario("B10-shape-n10000-f16-i1");
+    check(shape != nullptr, "missing B10 shape scenario");
+    const tree_fixture wide = make_fixture(*shape);
+    check(count_fixture_nodes(wide.root) == 10000u, "B10 fan-out fixture should have exactly the requested nodes");
+    check(wide.depth == 5u, "B10 fan-out 16 fixture over 10000 nodes should be five levels deep");
+    check(wide.root.children.size() == 16u, "B10 fan-out fixture root should have fan-out children");
+    check(find_scenario("B10-size-n100000-f4-i1") != nullptr, "missing B10 100k-node scenario");
+    check(find_scenario("B10-instances-n255-f2-i1024") != nullptr, "missing B10 1024-instance scenario");
+
+    const std::filesystem::path output_dir =
+        std::filesystem::temp_directory_path() / "muesli_bt_bench_b10_smoke";
+    std::filesystem::remove_all(output_dir);
+
+    run_request request;
+    request.output_dir = output_dir;
+    request.scenarios.push_back(*find_scenario("B10-instances-n255-f2-i16"));
+    request.scenarios.push_back(*find_scenario("B10-shape-n10000-f64-i1"));
+    request.warmup_override = std::chrono::milliseconds(0);
+    request.run_override = std::chrono::milliseconds(5);
+    request.repetitions_override = 1u;
+
+    benchmark_runner runner;
+    const run_result result = runner.run(request);
+
+    check(result.run_rows.size() == 2u, "expected two B10 run rows");
+    const run_summary_row& instances = result.run_rows.front();
+    check(instances.instance_count == 16u, "B10 should record the instance count");
+    check(instances.ticks_total > 0u && instances.ticks_total % 16u == 0u,
+          "B10 should count every instance tick of every round");
+    check(instances.tree_depth == 8u, "B10 should record tree depth");
+    for (const run_summary_row& row : result.run_rows) {
+        check(row.group_id == "B10", "B10 row should use B10 group id");
+        check(row.semantic_errors == 0u, "B10 trees should succeed every tick");
+        check(row.ns_per_node_tick.value_or(0.0) > 0.0, "B10 should record ns per node per tick");
+        check(row.instance_bytes.value_or(0u) > 0u, "B10 should record memory per instance");
+        check(row.instance_create_ns.value_or(0u) > 0u, "B10 should record instance creation time");
+    }
+    check(result.run_rows.back().tree_fanout == 64u, "B10 should record fan-out");
+
+    const std::string run_summary = read_text(result.output_dir / "run_summary.csv");
+    check(first_line(run_summary).find("ns_per_node_tick,instance_bytes,instance_create_ns") != std::string::npos,
+          "run summary missing B10 scaling columns");
+}
+
+void test_b11_open_loop_benchmarks_run() {
+    using namespace muesli_bt::bench;
+
+    const std::filesystem::path output_dir =
+        std::filesystem::temp_directory_path() / "muesli_bt_bench_b11_smoke";
+    std::filesystem::remove_all(output_dir);
+
+    run_request request;
+    request.output_dir = output_dir;
+    request.scenarios.push_back(*find_scenario("B11-alt-255-100hz-idle"));
+    request.scenarios.push_back(*find_scenario("B11-alt-255-1000hz-loaded"));
+    request.warmup_override = std::chrono::milliseconds(10);
+    request.run_override = std::chrono::milliseconds(100);
+    request.repetitions_override = 1u;
+
+    benchmark_runner runner;
+    const run_result result = runner.run(request);
+
+    check(result.run_rows.size() == 2u, "expected two B11 run rows");
+    for (const run_summary_row& row : result.run_rows) {
+        check(row.group_id == "B11", "B11 row should use B11 group id");
+        check(row.ticks_total > 0u, "B11 should tick on schedule");
+        check(row.semantic_errors == 0u, "B11 ticks should succeed");
+        check(row.latency_ns_median > 0u && row.latency_ns_max >= row.latency_ns_p99,
+              "B11 should record response-time percentiles");
+        check(row.deadline_miss_rate >= 0.0 && row.deadline_miss_rate <= 1.0, "B11 miss rate should be a ratio");
+        check(row.notes.find("service_ns_p99=") != std::string::npos,
+              "B11 should record service time next to response time");
+    }
+    const run_summary_row& idle = result.run_rows.front();
+    check(idle.ticks_total <= 10u, "B11 100 Hz run over 100 ms should schedule at most ten ticks");
+    check(idle.notes.find("background_jobs=0") != std::string::npos, "idle B11 run should submit no jobs");
+    const run_summary_row& loaded = result.run_rows.back();
+    check(loaded.notes.find("background_jobs=0") == std::string::npos, "loaded B11 run should submit background jobs");
+}
+
+void test_b12_observability_layers_run() {
+    using namespace muesli_bt::bench;
+
+    const std::filesystem::path output_dir =
+        std::filesystem::temp_directory_path() / "muesli_bt_bench_b12_smoke";
+    std::filesystem::remove_all(output_dir);
+
+    run_request request;
+    request.output_dir = output_dir;
+    for (const scenario_definition& scenario : scenarios_for_group("B12")) {
+        request.scenarios.push_back(scenario);
+    }
+    request.warmup_override = std::chrono::milliseconds(5);
+    request.run_override = std::chrono::milliseconds(20);
+    request.repetitions_override = 1u;
+
+    benchmark_runner runner;
+    const run_result result = runner.run(request);
+
+    check(result.run_rows.size() == 10u, "expected one row per B12 layer");
+    for (const run_summary_row& row : result.run_rows) {
+        check(row.group_id == "B12", "B12 row should use B12 group id");
+        check(row.ticks_total > 0u, "B12 layer should tick");
+        check(row.semantic_errors == 0u, "B12 ticks should succeed under every layer");
+        const bool event_log_layer = row.logging_mode != "off" && row.logging_mode != "trace" &&
+                                     row.logging_mode != "readtrace";
+        check(event_log_layer == (row.log_bytes_total > 0u), "only event-log layers should count log bytes");
+        check(event_log_layer == (row.event_log_bytes_per_tick > 0.0), "event-log layers should report bytes per tick");
+    }
+
+    const auto bytes_per_tick = [&](std::string_view mode) {
+        for (const run_summary_row& row : result.run_rows) {
+            if (row.logging_mode == mode) {
+                return row.event_log_bytes_per_tick;
+            }
+        }
+        return 0.0;
+    };
+    check(bytes_per_tick("audit") < bytes_per_tick("fulltrace"), "tick audit alone should log less than every event");
+    check(!std::filesystem::exists(std::filesystem::temp_directory_path() / "muesli-bt-bench-B12-alt-31-layer-file-eachflush.jsonl"),
+          "B12 file layer should remove its event file");
+}
+
+void test_b13_lisp_benchmarks_run() {
+    using namespace muesli_bt::bench;
+
+    const std::filesystem::path output_dir =
+        std::filesystem::temp_directory_path() / "muesli_bt_bench_b13_smoke";
+    std::filesystem::remove_all(output_dir);
+
+    run_request request;
+    request.output_dir = output_dir;
+    for (const scenario_definition& scenario : scenarios_for_group("B13")) {
+        request.scenarios.push_back(scenario);
+    }
+    request.warmup_override = std::chrono::milliseconds(1);
+    request.run_override = std::chrono::milliseconds(10);
+    request.repetitions_override = 1u;
+
+    benchmark_runner runner;
+    const run_result result = runner.run(request);
+
+    check(result.run_rows.size() == 10u, "expected one row per B13 operation and evaluator");
+    for (const run_summary_row& row : result.run_rows) {
+        check(row.group_id == "B13", "B13 row should use B13 group id");
+        check(row.ticks_total > 0u, "B13 should run at least one operation");
+        check(row.semantic_errors == 0u, "B13 operations should compile and return the expected result");
+        check(row.gc_objects_per_op.has_value() && row.alloc_bytes_per_op.has_value(),
+              "B13 should report allocation per operation");
+    }
+
+    const auto objects_per_op = [&](std::string_view scenario_id) {
+        for (const run_summary_row& row : result.run_rows) {
+            if (row.scenario_id == scenario_id) {
+                return row.gc_objects_per_op.value_or(0.0);
+            }
+        }
+        return 0.0;
+    };
+    check(objects_per_op("B13-lisp-closure-call-interpreted") > objects_per_op("B13-lisp-closure-call-compiled"),
+          "interpreted closure calls should allocate environments that compiled calls avoid");
+
+    const std::string header = first_line(read_text(output_dir / "run_summary.csv"));
+    check(header.find("gc_objects_per_op,alloc_bytes_per_op") != std::string::npos,
+          "run summary should carry the B13 per-operation allocation columns");
+}
+
+void test_b14_memory_footprint_runs() {
+    using namespace muesli_bt::bench;
+
+    const std::filesystem::path output_dir =
+        std::filesystem::temp_directory_path() / "muesli_bt_bench_b14_smoke";
+    std::filesystem::remove_all(output_dir);
+
+    run_request request;
+    request.output_dir = output_dir;
+    for (const scenario_definition& scenario : scenarios_for_group("B14")) {
+        request.scenarios.push_back(scenario);
+    }
+    request.repetitions_override = 1u;
+
+    benchmark_runner runner;
+    const run_result result = runner.run(request);
+
+    check(result.run_rows.size() == 4u, "expected one row per B14 tree size and instance count");
+    const auto bytes_for = [&](std::string_view scenario_id) {
+        for (const run_summary_row& row : result.run_rows) {
+            if (row.scenario_id == scenario_id) {
+                return row.instance_bytes.value_or(0u);
+            }
+        }
+        return std::uint64_t{0};
+    };
+    for (const run_summary_row& row : result.run_rows) {
+        check(row.group_id == "B14", "B14 row should use B14 group id");
+        check(row.instance_bytes.value_or(0u) > 0u, "B14 should report bytes per instance");
+        check(row.ticks_total == row.instance_count.value_or(0u), "B14 should tick every instance once");
+        check(row.notes.find("blackboard_bytes=") != std::string::npos &&
+                  row.notes.find("total_bytes=") != std::string::npos,
+              "B14 notes should carry the per-component breakdown");
+    }
+    check(bytes_for("B14-footprint-alt-255-i1") > bytes_for("B14-footprint-alt-31-i1"),
+          "a larger tree should need more bytes per instance");
+}
+
+void test_regression_gate_flags_significant_slowdowns() {
+    using namespace muesli_bt::bench;
+
+    check(std::abs(mann_whitney_greater_p({1.0, 2.0, 3.0}, {4.0, 5.0, 6.0}) - 0.05) < 1e-12,
+          "three fully separated samples a side should give the exact one-sided p of 1/20");
+    check(mann_whitney_greater_p({4.0, 5.0, 6.0}, {1.0, 2.0, 3.0}) == 1.0,
+          "a faster candidate should never look slower");
+
+    const std::filesystem::path output_dir =
+        std::filesystem::temp_directory_path() / "muesli_bt_bench_regression_gate";
+    std::filesystem::remove_all(output_dir);
+    std::filesystem::create_directories(output_dir);
+
+    const auto write_summary = [&](const std::string& name, double slow_scale) {
+        const std::filesystem::path path = output_dir / name;
+        std::ofstream out(path);
+        out << "runtime_name,scenario_id,ticks_total,latency_ns_median,latency_ns_p99,alloc_count_total\n";
+        for (int rep = 0; rep < 5; ++rep) {
+            const double jitter = static_cast<double>(rep);
+            out << "muesli-bt,B1-seq-31," << 1000 << ',' << (100.0 + jitter) * slow_scale << ','
+                << (150.0 + jitter) * slow_scale << ",0\n";
+            out << "muesli-bt,B1-sel-31," << 1000 << ',' << 100.0 + jitter << ',' << 150.0 + jitter << ",0\n";
+        }
+        return path;
+    };
+    const std::filesystem::path baseline = write_summary("baseline.csv", 1.0);
+    const std::filesystem::path same = write_summary("same.csv", 1.0);
+    const std::filesystem::path slower = write_summary("slower.csv", 1.5);
+
+    const gate_report pass = run_regression_gate(baseline, same, gate_options{});
+    check(pass.passed(), "an identical run should pass the gate");
+    check(pass.comparisons.size() == 6u, "expected three gated metrics per scenario");
+
+    const gate_report fail = run_regression_gate(baseline, slower, gate_options{});
+    check(fail.regression_count() == 2u, "a 50% slower scenario should regress both latency metrics");
+    for (const gate_comparison& comparison : fail.comparisons) {
+        const bool slowed = comparison.scenario_id == "B1-seq-31" && comparison.metric != "allocs_per_tick";
+        check((comparison.verdict == gate_verdict::regression) == slowed,
+              "only the slowed scenario's latency should regress: " + comparison.scenario_id + " " + comparison.metric);
+    }
+
+    const gate_report lenient = run_regression_gate(baseline, slower, gate_options{.threshold = 0.75});
+    check(lenient.passed(), "a change below the threshold should not fail the gate");
+
+    write_regression_report(output_dir, fail);
+    const std::string report = read_text(output_dir / "regression_report.json");
+    check(report.find("\"passed\": false") != std::string::npos, "report should record the failed gate");
+    check(report.find("\"verdict\": \"regression\"") != std::string::npos, "report should list the regressions");
+}
+
 class fail_on_unwhitelisted_allocation_scope final {
 public:
     fail_on_unwhitelisted_allocation_scope() {
@@ -566,12 +914,20 @@ int main(int argc, char** argv) {
 
     test_catalogue_contains_new_benchmarks();
     test_runner_writes_expected_csv_files();
+    test_runner_records_perf_counters_or_why_not();
     test_fulltrace_mode_emits_log_bytes();
     test_jitter_trace_is_written_for_a2();
     test_runner_emits_progress_events();
     test_b5_lifecycle_benchmarks_run();
     test_b7_gc_memory_benchmark_runs();
     test_b8_async_contract_benchmarks_run();
+    test_b9_planner_benchmarks_run();
+    test_b10_scaling_benchmarks_run();
+    test_b11_open_loop_benchmarks_run();
+    test_b12_observability_layers_run();
+    test_b13_lisp_benchmarks_run();
+    test_b14_memory_footprint_runs();
+    test_regression_gate_flags_significant_slowdowns();
     test_allocation_whitelist_allows_explicit_logging_paths_only();
     test_precompiled_ticks_fail_on_unwhitelisted_allocations();
     test_precompiled_strict_allocation_covers_static_shapes();
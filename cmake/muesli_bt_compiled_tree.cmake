@@ -0,0 +1,31 @@
+# muesli_bt_add_compiled_tree(<target> NAME <identifier> DSL <file> [MUSLISP <executable>])
+#
+# Runs `muslisp --emit-cpp` on the BT DSL file at build time and adds the generated
+# <identifier>.cpp to <target>. The generated tree registers itself when the program starts, so
+# every definition with the same tick program runs it instead of the interpreter loop. MUSLISP
+# defaults to this project's muslisp target.
+function (muesli_bt_add_compiled_tree target)
+  cmake_parse_arguments(PARSE_ARGV 1 arg "" "NAME;DSL;MUSLISP" "")
+  if (NOT arg_NAME OR NOT arg_DSL)
+    message(FATAL_ERROR "muesli_bt_add_compiled_tree: NAME and DSL are required")
+  endif ()
+  set(muslisp_command "${arg_MUSLISP}")
+  set(muslisp_depends "")
+  if (NOT muslisp_command)
+    set(muslisp_command $<TARGET_FILE:muslisp>)
+    set(muslisp_depends muslisp)
+  endif ()
+
+  get_filename_component(dsl_path "${arg_DSL}" ABSOLUTE)
+  set(out_dir "${CMAKE_CURRENT_BINARY_DIR}/compiled_trees")
+  set(out_path "${out_dir}/${arg_NAME}.cpp")
+  add_custom_command(
+    OUTPUT "${out_path}"
+    COMMAND "${CMAKE_COMMAND}" -E make_directory "${out_dir}"
+    COMMAND ${muslisp_command} --emit-cpp "${arg_NAME}" "${dsl_path}" "${out_path}"
+    DEPENDS "${dsl_path}" ${muslisp_depends}
+    COMMENT "Compiling BT ${arg_DSL} to C++"
+    VERBATIM
+  )
+  target_sources(${target} PRIVATE "${out_path}")
+endfunction ()
@@ -2,6 +2,8 @@
 #include <array>
 #include <chrono>
 #include <cstdint>
+#include <memory>
+#include <span>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -9,6 +11,7 @@
 #include <utility>
 #include <vector>
 
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
@@ -149,7 +152,7 @@ py::object lisp_to_py(const muslisp::value& value) {
     }
     if (is_map(value)) {
         py::dict out;
-        for (const auto& [key, item] : value->map_data) {
+        for (const auto& [key, item] : value->map_data()) {
             switch (key.type) {
                 case map_key_type::symbol:
                 case map_key_type::string:
@@ -191,7 +194,7 @@ py::object bb_value_to_py(const bt::bb_value& value) {
                 return py::float_(item);
             } else if constexpr (std::is_same_v<T, std::string>) {
                 return py::str(item);
-            } else if constexpr (std::is_same_v<T, std::vector<double>>) {
+            } else if constexpr (std::is_same_v<T, bt::bb_vector>) {
                 py::list out;
                 for (double v : item) {
                     out.append(py::float_(v));
@@ -208,6 +211,58 @@ py::object bb_value_to_py(const bt::bb_value& value) {
         value);
 }
 
+// Wraps memory owned by `owner` in a read-only NumPy array without copying. The owner moves into the
+// array's base capsule first, so `data_of` must return a pointer into the moved copy.
+template <typename Owner, typename DataOf>
+py::array read_only_view(Owner owner, DataOf data_of, const py::dtype& dtype, std::vector<py::ssize_t> shape) {
+    auto held = std::make_unique<Owner>(std::move(owner));
+    const void* data = data_of(*held);
+    py::capsule base(held.get(), [](void* p) { delete static_cast<Owner*>(p); });
+    held.release();
+    py::array out(dtype, std::move(shape), std::vector<py::ssize_t>{}, data, base);
+    out.attr("setflags")(py::arg("write") = false);
+    return out;
+}
+
+// Large bb_vectors share their buffer, so holding a copy keeps the doubles alive without copying
+// them; small ones are stored inline in the copy itself.
+py::array bb_vector_view(const bt::bb_vector& vec) {
+    const auto size = static_cast<py::ssize_t>(vec.size());
+    return read_only_view(
+        vec, [](const bt::bb_vector& held) { return held.data(); }, py::dtype::of<double>(), {size});
+}
+
+py::array payload_view(bt::retained_payload payload, std::vector<py::ssize_t> shape) {
+    return read_only_view(
+        std::move(payload),
+        [](const bt::retained_payload& held) { return held.bytes.data(); },
+        py::dtype::of<std::uint8_t>(),
+        std::move(shape));
+}
+
+// Keeps a NumPy array alive for as long as the runtime holds its bytes. The last reference may be
+// dropped on a thread without the GIL, so the deleter takes it.
+std::shared_ptr<const void> python_buffer_owner(py::array array) {
+    return std::shared_ptr<const void>(new py::array(std::move(array)), [](py::array* held) {
+        if (Py_IsInitialized() == 0) {
+            return;
+        }
+        py::gil_scoped_acquire gil;
+        delete held;
+    });
+}
+
+bt::retained_payload require_byte_buffer(const py::array& array, const std::string& where) {
+    if (!py::isinstance<py::array_t<std::uint8_t>>(array) || (array.flags() & py::array::c_style) == 0) {
+        throw std::runtime_error(where + ": expected a C-contiguous uint8 array");
+    }
+    if (array.size() == 0) {
+        throw std::runtime_error(where + ": array is empty");
+    }
+    const auto* data = static_cast<const std::byte*>(array.data());
+    return bt::retained_payload{python_buffer_owner(array), {data, static_cast<std::size_t>(array.nbytes())}};
+}
+
 bt::bb_value py_to_bb_value(const py::handle& value, const std::string& where) {
     if (value.is_none()) {
         return bt::bb_value{std::monostate{}};
@@ -224,6 +279,14 @@ bt::bb_value py_to_bb_value(const py::handle& value, const std::string& where) {
     if (py::isinstance<py::str>(value)) {
         return bt::bb_value{py::cast<std::string>(value)};
     }
+    if (py::isinstance<py::array>(value)) {
+        // One memcpy (after any dtype conversion) instead of a Python float per element.
+        auto arr = py::array_t<double, py::array::c_style | py::array::forcecast>::ensure(value);
+        if (!arr) {
+            throw std::runtime_error(where + ": expected a numeric array");
+        }
+        return bt::bb_value{bt::bb_vector(std::span<const double>(arr.data(), static_cast<std::size_t>(arr.size())))};
+    }
     if (py::isinstance<py::sequence>(value) && !py::isinstance<py::str>(value)) {
         py::sequence seq = py::reinterpret_borrow<py::sequence>(value);
         std::vector<double> out;
@@ -236,6 +299,26 @@ bt::bb_value py_to_bb_value(const py::handle& value, const std::string& where) {
     throw std::runtime_error(where + ": unsupported value type for blackboard input");
 }
 
+bt::racecar_state state_from_py(const py::handle& value, const std::string& where) {
+    if (!py::isinstance<py::dict>(value)) {
+        throw std::runtime_error(where + "() must return dict");
+    }
+    py::dict obj = py::reinterpret_borrow<py::dict>(value);
+    bt::racecar_state state;
+    state.state_schema = require_py_str_key(obj, "state_schema", where);
+    state.state_vec = require_py_vec_key(obj, "state_vec", where);
+    state.x = require_py_float_key(obj, "x", where);
+    state.y = require_py_float_key(obj, "y", where);
+    state.yaw = require_py_float_key(obj, "yaw", where);
+    state.speed = require_py_float_key(obj, "speed", where);
+    state.rays = require_py_vec_key(obj, "rays", where);
+    state.goal = require_py_vec_key(obj, "goal", where);
+    state.collision_imminent = require_py_bool_key(obj, "collision_imminent", where);
+    state.collision_count = require_py_int_key(obj, "collision_count", where);
+    state.t_ms = require_py_int_key(obj, "t_ms", where);
+    return state;
+}
+
 class python_racecar_sim_adapter final : public bt::racecar_sim_adapter {
 public:
     explicit python_racecar_sim_adapter(py::object sim_obj) : sim_obj_(std::move(sim_obj)) {}
@@ -250,29 +333,71 @@ public:
     [[nodiscard]] bt::racecar_state get_state() override {
         py::gil_scoped_acquire gil;
         try {
-            py::object out = sim_obj_.attr("get_state")();
-            if (!py::isinstance<py::dict>(out)) {
-                throw std::runtime_error("sim_adapter.get_state() must return dict");
-            }
-            py::dict obj = py::reinterpret_borrow<py::dict>(out);
-            bt::racecar_state state;
-            state.state_schema = require_py_str_key(obj, "state_schema", "sim_adapter.get_state");
-            state.state_vec = require_py_vec_key(obj, "state_vec", "sim_adapter.get_state");
-            state.x = require_py_float_key(obj, "x", "sim_adapter.get_state");
-            state.y = require_py_float_key(obj, "y", "sim_adapter.get_state");
-            state.yaw = require_py_float_key(obj, "yaw", "sim_adapter.get_state");
-            state.speed = require_py_float_key(obj, "speed", "sim_adapter.get_state");
-            state.rays = require_py_vec_key(obj, "rays", "sim_adapter.get_state");
-            state.goal = require_py_vec_key(obj, "goal", "sim_adapter.get_state");
-            state.collision_imminent = require_py_bool_key(obj, "collision_imminent", "sim_adapter.get_state");
-            state.collision_count = require_py_int_key(obj, "collision_count", "sim_adapter.get_state");
-            state.t_ms = require_py_int_key(obj, "t_ms", "sim_adapter.get_state");
-            return state;
+            return state_from_py(sim_obj_.attr("get_state")(), "sim_adapter.get_state");
         } catch (const py::error_already_set& e) {
             throw std::runtime_error(std::string("sim_adapter.get_state failed: ") + e.what());
         }
     }
 
+    // Multi-car simulations implement env_count(), get_states() returning one state dict per car, and
+    // apply_actions() taking one (steering, throttle) tuple per car; step() then advances every car.
+    [[nodiscard]] std::size_t env_count() const override {
+        py::gil_scoped_acquire gil;
+        try {
+            if (!py::hasattr(sim_obj_, "env_count")) {
+                return 1;
+            }
+            return py::cast<std::size_t>(sim_obj_.attr("env_count")());
+        } catch (const py::error_already_set& e) {
+            throw std::runtime_error(std::string("sim_adapter.env_count failed: ") + e.what());
+        }
+    }
+
+    void get_states(std::span<bt::racecar_state> out) override {
+        py::gil_scoped_acquire gil;
+        try {
+            if (!py::hasattr(sim_obj_, "get_states")) {
+                if (!out.empty()) {
+                    out.front() = state_from_py(sim_obj_.attr("get_state")(), "sim_adapter.get_state");
+                }
+                return;
+            }
+            py::object states = sim_obj_.attr("get_states")();
+            if (!py::isinstance<py::sequence>(states)) {
+                throw std::runtime_error("sim_adapter.get_states() must return a sequence of dicts");
+            }
+            py::sequence seq = py::reinterpret_borrow<py::sequence>(states);
+            if (static_cast<std::size_t>(seq.size()) != out.size()) {
+                throw std::runtime_error("sim_adapter.get_states() returned " + std::to_string(seq.size()) +
+                                         " states for " + std::to_string(out.size()) + " cars");
+            }
+            for (std::size_t i = 0; i < out.size(); ++i) {
+                out[i] = state_from_py(seq[i], "sim_adapter.get_states");
+            }
+        } catch (const py::error_already_set& e) {
+            throw std::runtime_error(std::string("sim_adapter.get_states failed: ") + e.what());
+        }
+    }
+
+    void apply_actions(std::span<const std::array<double, 2>> actions) override {
+        py::gil_scoped_acquire gil;
+        try {
+            if (!py::hasattr(sim_obj_, "apply_actions")) {
+                if (!actions.empty()) {
+                    sim_obj_.attr("apply_action")(py::make_tuple(actions[0][0], actions[0][1]));
+                }
+                return;
+            }
+            py::list batch;
+            for (const auto& action : actions) {
+                batch.append(py::make_tuple(action[0], action[1]));
+            }
+            sim_obj_.attr("apply_actions")(batch);
+        } catch (const py::error_already_set& e) {
+            throw std::runtime_error(std::string("sim_adapter.apply_actions failed: ") + e.what());
+        }
+    }
+
     void apply_action(double steering, double throttle) override {
         py::gil_scoped_acquire gil;
         try {
@@ -383,7 +508,71 @@ public:
         }
     }
 
+    // Sims that define on_tick_records(columns) receive each batch as one dict: a NumPy array per
+    // numeric or flag column, a list of str per text column, and the run-wide schema_version, run_id and
+    // mode as str. Other sims get one on_tick_record call per tick.
+    void on_tick_records(const bt::racecar_tick_columns& batch) override {
+        py::gil_scoped_acquire gil;
+        if (!py::hasattr(sim_obj_, "on_tick_records")) {
+            bt::racecar_sim_adapter::on_tick_records(batch);
+            return;
+        }
+        try {
+            py::dict columns;
+            columns[py::str("schema_version")] = py::str(batch.schema_version);
+            columns[py::str("run_id")] = py::str(batch.run_id);
+            columns[py::str("mode")] = py::str(batch.mode);
+            columns[py::str("tick_index")] = numeric_column(batch.tick_index);
+            columns[py::str("sim_time_s")] = numeric_column(batch.sim_time_s);
+            columns[py::str("wall_time_s")] = numeric_column(batch.wall_time_s);
+            columns[py::str("x")] = numeric_column(batch.x);
+            columns[py::str("y")] = numeric_column(batch.y);
+            columns[py::str("yaw")] = numeric_column(batch.yaw);
+            columns[py::str("speed")] = numeric_column(batch.speed);
+            columns[py::str("goal_x")] = numeric_column(batch.goal_x);
+            columns[py::str("goal_y")] = numeric_column(batch.goal_y);
+            columns[py::str("collision_imminent")] = flag_column(batch.collision_imminent);
+            columns[py::str("distance_to_goal")] = numeric_column(batch.distance_to_goal);
+            columns[py::str("steering")] = numeric_column(batch.steering);
+            columns[py::str("throttle")] = numeric_column(batch.throttle);
+            columns[py::str("has_shared_action")] = flag_column(batch.has_shared_action);
+            columns[py::str("shared_linear_x")] = numeric_column(batch.shared_linear_x);
+            columns[py::str("shared_angular_z")] = numeric_column(batch.shared_angular_z);
+            columns[py::str("collisions_total")] = numeric_column(batch.collisions_total);
+            columns[py::str("goal_reached")] = flag_column(batch.goal_reached);
+            columns[py::str("bt_status")] = text_column(batch.bt_status);
+            columns[py::str("active_branch")] = numeric_column(batch.active_branch);
+            columns[py::str("planner_meta_json")] = text_column(batch.planner_meta_json);
+            columns[py::str("used_fallback")] = flag_column(batch.used_fallback);
+            columns[py::str("is_error_record")] = flag_column(batch.is_error_record);
+            columns[py::str("error_reason")] = text_column(batch.error_reason);
+            sim_obj_.attr("on_tick_records")(columns);
+        } catch (const py::error_already_set& e) {
+            throw std::runtime_error(std::string("sim_adapter.on_tick_records failed: ") + e.what());
+        }
+    }
+
 private:
+    template <typename T>
+    static py::array numeric_column(const std::vector<T>& column) {
+        return py::array_t<T>(static_cast<py::ssize_t>(column.size()), column.data());
+    }
+
+    static py::array flag_column(const std::vector<std::uint8_t>& column) {
+        return py::array(py::dtype("bool"),
+                         std::vector<py::ssize_t>{static_cast<py::ssize_t>(column.size())},
+                         std::vector<py::ssize_t>{},
+                         column.data());
+    }
+
+    static py::list text_column(const std::vector<std::string>& column) {
+        py::list out;
+        for (const std::string& text : column) {
+            out.append(py::str(text));
+        }
+        return out;
+    }
+
     py::object sim_obj_;
 };
 
@@ -451,28 +640,71 @@ public:
         }
 
         if (!bb_inputs.is_none()) {
-            if (!py::isinstance<py::dict>(bb_inputs)) {
-                throw std::runtime_error("Runtime.tick: bb_inputs must be dict[str, value]");
+            apply_bb_inputs(*inst, bb_inputs, "Runtime.tick");
+        }
+
+        try {
+            bt::status st = bt::status::failure;
+            {
+                py::gil_scoped_release release;
+                st = host.tick_instance(instance_handle);
             }
-            py::dict inputs = py::reinterpret_borrow<py::dict>(bb_inputs);
-            const auto now = std::chrono::steady_clock::now();
-            const std::uint64_t write_tick = inst->tick_index + 1;
-            for (const auto& kv : inputs) {
-                if (!py::isinstance<py::str>(kv.first)) {
-                    throw std::runtime_error("Runtime.tick: bb_inputs keys must be str");
+            return std::string(bt::status_name(st));
+        } catch (const std::exception& e) {
+            throw std::runtime_error(std::string("Runtime.tick failed: ") + e.what());
+        }
+    }
+
+    // Ticks every instance in `instance_handles` once per step, as one wave, for `ticks` steps with
+    // the GIL released; Python sim adapters take it back only while their callbacks run. `bb_inputs`,
+    // one dict per instance, is written before the first step. Returns a (ticks, instances) int8 array
+    // of status codes; `status_names` maps a code to its name.
+    py::array_t<std::int8_t> step_many(const std::vector<std::int64_t>& instance_handles,
+                                       std::int64_t ticks,
+                                       py::object bb_inputs) {
+        if (ticks < 0) {
+            throw std::runtime_error("Runtime.step_many: ticks must be non-negative");
+        }
+        bt::runtime_host& host = bt::default_runtime_host();
+        std::vector<bt::instance*> instances;
+        instances.reserve(instance_handles.size());
+        for (const std::int64_t handle : instance_handles) {
+            bt::instance* inst = host.find_instance(handle);
+            if (!inst) {
+                throw std::runtime_error("Runtime.step_many: unknown instance handle");
+            }
+            instances.push_back(inst);
+        }
+        if (!bb_inputs.is_none()) {
+            if (!py::isinstance<py::sequence>(bb_inputs) ||
+                py::len(bb_inputs) != instance_handles.size()) {
+                throw std::runtime_error("Runtime.step_many: bb_inputs must hold one dict per instance");
+            }
+            py::sequence inputs = py::reinterpret_borrow<py::sequence>(bb_inputs);
+            for (std::size_t i = 0; i < instances.size(); ++i) {
+                const py::object item = inputs[i];
+                if (!item.is_none()) {
+                    apply_bb_inputs(*instances[i], item, "Runtime.step_many");
                 }
-                const std::string key = py::cast<std::string>(kv.first);
-                bt::bb_value bb_val = py_to_bb_value(kv.second, "Runtime.tick bb_inputs." + key);
-                inst->bb.put(key, std::move(bb_val), write_tick, now, 0, "Runtime.tick");
             }
         }
 
+        const auto width = static_cast<py::ssize_t>(instance_handles.size());
+        py::array_t<std::int8_t> out({static_cast<py::ssize_t>(ticks), width});
+        std::int8_t* codes = out.mutable_data();
+        std::vector<bt::status> statuses(instance_handles.size());
         try {
-            const bt::status st = host.tick_instance(instance_handle);
-            return std::string(bt::status_name(st));
+            py::gil_scoped_release release;
+            for (std::int64_t t = 0; t < ticks; ++t) {
+                host.tick_instances(instance_handles, statuses);
+                for (const bt::status st : statuses) {
+                    *codes++ = static_cast<std::int8_t>(st);
+                }
+            }
         } catch (const std::exception& e) {
-            throw std::runtime_error(std::string("Runtime.tick failed: ") + e.what());
+            throw std::runtime_error(std::string("Runtime.step_many failed: ") + e.what());
         }
+        return out;
     }
 
     py::dict run_loop(std::int64_t instance_handle, py::dict options_dict) {
@@ -542,6 +774,11 @@ public:
                 options.run_id = py::cast<std::string>(val);
             } else if (key == "goal_tolerance") {
                 options.goal_tolerance = require_py_number(val, "Runtime.run_loop.goal_tolerance");
+            } else if (key == "tick_record_batch") {
+                if (!py::isinstance<py::int_>(val)) {
+                    throw std::runtime_error("Runtime.run_loop.tick_record_batch: expected int");
+                }
+                options.tick_record_batch = py::cast<std::int64_t>(val);
             } else if (key == "action_semantics") {
                 if (!py::isinstance<py::str>(val)) {
                     throw std::runtime_error("Runtime.run_loop.action_semantics: expected str");
@@ -601,11 +838,103 @@ public:
         return bb_value_to_py(entry->value);
     }
 
+    // Read-only NumPy view of a blackboard entry, without copying: a numeric vector (such as a planner
+    // action) as float64, an image as uint8 of shape (height, width, channels), a blob as 1-D uint8.
+    // None when the key is unset. The view keeps its data alive after the entry is overwritten.
+    py::object blackboard_array(std::int64_t instance_handle, const std::string& key) {
+        bt::instance* inst = bt::default_runtime_host().find_instance(instance_handle);
+        if (!inst) {
+            throw std::runtime_error("Runtime.blackboard_array: unknown instance handle");
+        }
+        const bt::bb_entry* entry = inst->bb.get(key);
+        if (!entry) {
+            return py::none();
+        }
+        if (const auto* vec = std::get_if<bt::bb_vector>(&entry->value)) {
+            return bb_vector_view(*vec);
+        }
+        if (const auto* image = std::get_if<bt::image_handle_ref>(&entry->value)) {
+            return image_array(image->id);
+        }
+        if (const auto* blob = std::get_if<bt::blob_handle_ref>(&entry->value)) {
+            return blob_array(blob->id);
+        }
+        throw std::runtime_error("Runtime.blackboard_array: '" + key + "' does not hold a vector, image or blob");
+    }
+
+    py::array image_array(std::int64_t image_id) {
+        const bt::vla_service& vla = bt::default_runtime_host().vla_ref();
+        const std::optional<bt::image_info> info = vla.get_image_info(bt::image_handle_ref{image_id});
+        std::optional<bt::retained_payload> payload = vla.image_payload(bt::image_handle_ref{image_id});
+        if (!info || !payload) {
+            throw std::runtime_error("Runtime.image_array: unknown image or no in-process pixels");
+        }
+        std::vector<py::ssize_t> shape{static_cast<py::ssize_t>(payload->bytes.size())};
+        if (info->width > 0 && info->height > 0 && info->channels > 0 &&
+            static_cast<std::size_t>(info->width * info->height * info->channels) == payload->bytes.size()) {
+            shape = {info->height, info->width, info->channels};
+        }
+        return payload_view(std::move(*payload), std::move(shape));
+    }
+
+    py::array blob_array(std::int64_t blob_id) {
+        std::optional<bt::retained_payload> payload =
+            bt::default_runtime_host().vla_ref().blob_payload(bt::blob_handle_ref{blob_id});
+        if (!payload) {
+            throw std::runtime_error("Runtime.blob_array: unknown blob or no in-process bytes");
+        }
+        const auto size = static_cast<py::ssize_t>(payload->bytes.size());
+        return payload_view(std::move(*payload), {size});
+    }
+
+    // Adopts a C-contiguous uint8 array of shape (height, width[, channels]) as an image handle
+    // without copying its pixels. The array must not be written while the handle is alive.
+    std::int64_t image_from_array(const py::array& pixels,
+                                  const std::string& encoding,
+                                  const std::string& frame_id,
+                                  std::int64_t timestamp_ms) {
+        if (pixels.ndim() != 2 && pixels.ndim() != 3) {
+            throw std::runtime_error("Runtime.image_from_array: expected shape (height, width[, channels])");
+        }
+        bt::retained_payload payload = require_byte_buffer(pixels, "Runtime.image_from_array");
+        const std::int64_t channels = pixels.ndim() == 3 ? pixels.shape(2) : 1;
+        return bt::default_runtime_host()
+            .vla_ref()
+            .adopt_image(pixels.shape(1), pixels.shape(0), channels, encoding, timestamp_ms, frame_id, std::move(payload))
+            .id;
+    }
+
+    // Adopts a C-contiguous uint8 array as a blob handle without copying it.
+    std::int64_t blob_from_array(const py::array& bytes,
+                                 const std::string& mime_type,
+                                 const std::string& tag,
+                                 std::int64_t timestamp_ms) {
+        bt::retained_payload payload = require_byte_buffer(bytes, "Runtime.blob_from_array");
+        return bt::default_runtime_host().vla_ref().adopt_blob(mime_type, timestamp_ms, tag, std::move(payload)).id;
+    }
+
     std::uint64_t session_generation() const noexcept {
         return session_generation_;
     }
 
 private:
+    static void apply_bb_inputs(bt::instance& inst, const py::handle& bb_inputs, const std::string& where) {
+        if (!py::isinstance<py::dict>(bb_inputs)) {
+            throw std::runtime_error(where + ": bb_inputs must be dict[str, value]");
+        }
+        py::dict inputs = py::reinterpret_borrow<py::dict>(bb_inputs);
+        const auto now = std::chrono::steady_clock::now();
+        const std::uint64_t write_tick = inst.tick_index + 1;
+        for (const auto& kv : inputs) {
+            if (!py::isinstance<py::str>(kv.first)) {
+                throw std::runtime_error(where + ": bb_inputs keys must be str");
+            }
+            const std::string key = py::cast<std::string>(kv.first);
+            bt::bb_value bb_val = py_to_bb_value(kv.second, where + " bb_inputs." + key);
+            inst.bb.put(key, std::move(bb_val), write_tick, now, 0, where);
+        }
+    }
+
     muslisp::env_ptr env_;
     std::shared_ptr<python_racecar_sim_adapter> sim_adapter_;
     std::uint64_t session_generation_ = 1;
@@ -615,6 +944,9 @@ private:
 
 PYBIND11_MODULE(muesli_bt_bridge, m) {
     m.doc() = "muesli-bt python bridge";
+    m.attr("status_names") = py::make_tuple(bt::status_name(bt::status::success),
+                                            bt::status_name(bt::status::failure),
+                                            bt::status_name(bt::status::running));
 
     py::class_<runtime_bridge>(m, "Runtime")
         .def(py::init<>())
@@ -627,5 +959,25 @@ PYBIND11_MODULE(muesli_bt_bridge, m) {
         .def("run_loop", &runtime_bridge::run_loop, py::arg("instance_handle"), py::arg("options"))
         .def("eval", &runtime_bridge::eval, py::arg("source"))
         .def("blackboard_get", &runtime_bridge::blackboard_get, py::arg("instance_handle"), py::arg("key"))
+        .def("step_many",
+             &runtime_bridge::step_many,
+             py::arg("instance_handles"),
+             py::arg("ticks") = 1,
+             py::arg("bb_inputs") = py::none())
+        .def("blackboard_array", &runtime_bridge::blackboard_array, py::arg("instance_handle"), py::arg("key"))
+        .def("image_array", &runtime_bridge::image_array, py::arg("image_id"))
+        .def("blob_array", &runtime_bridge::blob_array, py::arg("blob_id"))
+        .def("image_from_array",
+             &runtime_bridge::image_from_array,
+             py::arg("pixels"),
+             py::arg("encoding") = "rgb8",
+             py::arg("frame_id") = "camera",
+             py::arg("timestamp_ms") = 0)
+        .def("blob_from_array",
+             &runtime_bridge::blob_from_array,
+             py::arg("bytes"),
+             py::arg("mime_type") = "application/octet-stream",
+             py::arg("tag") = "",
+             py::arg("timestamp_ms") = 0)
         .def_property_readonly("session_generation", &runtime_bridge::session_generation);
 }
@@ -10,6 +10,7 @@
 #include <memory>
 #include <optional>
 #include <random>
+#include <span>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -60,7 +61,7 @@ std::optional<muslisp::value> map_lookup_option(muslisp::value map_obj, const st
     if (!muslisp::is_map(map_obj)) {
         return std::nullopt;
     }
-    for (const auto& [key, val] : map_obj->map_data) {
+    for (const auto& [key, val] : map_obj->map_data()) {
         if (key.type != muslisp::map_key_type::symbol && key.type != muslisp::map_key_type::string) {
             continue;
         }
@@ -79,7 +80,8 @@ muslisp::map_key symbol_key(const std::string& name) {
 }
 
 void map_set_symbol(muslisp::value map_obj, const std::string& key_name, muslisp::value v) {
-    map_obj->map_data[symbol_key(key_name)] = v;
+    map_obj->map_data()[symbol_key(key_name)] = v;
+    muslisp::default_gc().write_barrier(map_obj, v);
 }
 
 std::string require_text_value(muslisp::value v, const std::string& where) {
@@ -116,7 +118,7 @@ bool require_bool_value(muslisp::value v, const std::string& where) {
     return muslisp::boolean_value(v);
 }
 
-muslisp::value numeric_vector_to_lisp_list(const std::vector<double>& values) {
+muslisp::value numeric_vector_to_lisp_list(std::span<const double> values) {
     std::vector<muslisp::value> out;
     out.reserve(values.size());
     muslisp::gc_root_scope roots(muslisp::default_gc());
@@ -219,8 +221,8 @@ std::int64_t require_bb_int(std::span<const muslisp::value> args, std::size_t in
 }
 
 std::vector<double> bb_to_vector(const bt::bb_value& value) {
-    if (const auto* vec = std::get_if<std::vector<double>>(&value)) {
-        return *vec;
+    if (const auto* vec = std::get_if<bt::bb_vector>(&value)) {
+        return vec->to_vector();
     }
     if (const auto* f = std::get_if<double>(&value)) {
         return {*f, *f};
@@ -252,7 +254,7 @@ bool bb_truthy(const bt::bb_entry* entry) {
     if (const auto* s = std::get_if<std::string>(&value)) {
         return !s->empty() && *s != "0" && *s != "false";
     }
-    if (const auto* vec = std::get_if<std::vector<double>>(&value)) {
+    if (const auto* vec = std::get_if<bt::bb_vector>(&value)) {
         return !vec->empty();
     }
     return true;
@@ -317,7 +319,7 @@ double relative_bearing(const std::array<double, 2>& origin,
     return wrap_angle(heading - origin_yaw);
 }
 
-std::vector<double> lidar_lite_from_proximity(const std::array<double, 8>& p) {
+std::array<double, 5> lidar_lite_from_proximity(const std::array<double, 8>& p) {
     const double left = std::max(p[5], p[6]);
     const double front_left = std::max(p[6], p[7]);
     const double front = std::max(std::max(p[7], p[0]), std::max(p[6], p[1]));
@@ -326,6 +328,65 @@ std::vector<double> lidar_lite_from_proximity(const std::array<double, 8>& p) {
     return {left, front_left, front, front_right, right};
 }
 
+// Where the line lies across the three ground sensors, from -1 (left) to 1 (right); 0 without a line.
+double ground_line_error(const std::array<double, 3>& ground) {
+    const double dark_left = clampd(1.0 - ground[0], 0.0, 1.0);
+    const double dark_centre = clampd(1.0 - ground[1], 0.0, 1.0);
+    const double dark_right = clampd(1.0 - ground[2], 0.0, 1.0);
+    const double dark_sum = dark_left + dark_centre + dark_right;
+    return dark_sum > 1e-6 ? clampd((dark_right - dark_left) / dark_sum, -1.0, 1.0) : 0.0;
+}
+
+enum class epuck_obs_kind {
+    obstacle,
+    line,
+    goal,
+    foraging,
+    tag
+};
+
+// Schemas other than the five demo schemas get the obstacle fields only.
+epuck_obs_kind obs_kind_for_schema(std::string_view schema) {
+    if (schema == "epuck.line.obs.v1") {
+        return epuck_obs_kind::line;
+    }
+    if (schema == "epuck.goal.obs.v1") {
+        return epuck_obs_kind::goal;
+    }
+    if (schema == "epuck.foraging.obs.v1") {
+        return epuck_obs_kind::foraging;
+    }
+    if (schema == "epuck.tag.obs.v1") {
+        return epuck_obs_kind::tag;
+    }
+    return epuck_obs_kind::obstacle;
+}
+
+// Builds the map observe() returns from the same writes observe_into() sends to a blackboard.
+class map_observation_sink final : public muslisp::env_observation_sink {
+public:
+    map_observation_sink() : map_(muslisp::make_map()), roots_(muslisp::default_gc()) {
+        roots_.add(&map_);
+    }
+
+    void put_bool(std::string_view key, bool v) override { set(key, muslisp::make_boolean(v)); }
+    void put_integer(std::string_view key, std::int64_t v) override { set(key, muslisp::make_integer(v)); }
+    void put_number(std::string_view key, double v) override { set(key, muslisp::make_float(v)); }
+    void put_vector(std::string_view key, std::span<const double> v) override {
+        set(key, numeric_vector_to_lisp_list(v));
+    }
+    void put_string(std::string_view key, std::string_view v) override { set(key, muslisp::make_string(v)); }
+    void put_image(std::string_view key, std::int64_t image_id) override { put_integer(key, image_id); }
+    void put_blob(std::string_view key, std::int64_t blob_id) override { put_integer(key, blob_id); }
+
+    void set(std::string_view key, muslisp::value v) { map_set_symbol(map_, std::string(key), v); }
+    [[nodiscard]] muslisp::value map() const { return map_; }
+
+private:
+    muslisp::value map_;
+    muslisp::gc_root_scope roots_;
+};
+
 class epuck_line_planner_model final : public bt::planner_model {
 public:
     [[nodiscard]] bt::planner_step_result step(const bt::planner_vector& state,
@@ -573,6 +634,47 @@ void install_epuck_callbacks(bt::runtime_host& host) {
     });
 }
 
+// One control step's sensor readings and the values derived from them. webots_env_backend keeps
+// one and refills it in place once per step, so observe() and observe_into() publish the same
+// readings without querying a device or scene node twice.
+struct epuck_sensor_frame {
+    std::int64_t t_ms = 0;
+    std::array<double, 8> proximity{};
+    std::array<double, 3> ground{};
+    double min_obstacle = 1.0;
+    const char* wall_side = "left";
+    double line_error = 0.0;
+    std::array<double, 5> lidar_lite{};
+
+    bool has_pose = false;
+    std::array<double, 2> robot_xy{};
+    double robot_yaw = 0.0;
+
+    // epuck.goal.obs.v1
+    bool has_goal = false;
+    std::array<double, 2> goal_xy{};
+    double goal_dist = 1.0;
+    double goal_bearing = 0.0;
+
+    // epuck.foraging.obs.v1
+    bool has_base = false;
+    std::array<double, 2> base_xy{};
+    double base_dist = 0.0;
+    double base_bearing = 0.0;
+    bool has_target = false;
+    const char* target_kind = "none";
+    std::array<double, 2> target_xy{};
+    std::int64_t target_index = -1;
+    double target_dist = 1.5;
+    double target_bearing = 0.0;
+
+    // epuck.tag.obs.v1
+    bool evader_seen = false;
+    std::array<double, 2> evader_xy{};
+    double evader_dist = 2.0;
+    double evader_bearing = 0.0;
+};
+
 struct epuck_devices {
     explicit epuck_devices(webots::Robot* robot) : robot(robot) {
         if (!robot) {
@@ -613,28 +715,24 @@ struct epuck_devices {
         robot->step(time_step_ms);
     }
 
-    [[nodiscard]] std::array<double, 8> read_proximity_normalised() const {
-        std::array<double, 8> values{};
-        for (int i = 0; i < 8; ++i) {
+    // Reads every proximity and ground sensor into `frame`, normalised to [0, 1]. A missing ground
+    // sensor reads 1 (bright floor).
+    void read_sensors(epuck_sensor_frame& frame) const {
+        frame.t_ms = static_cast<std::int64_t>(std::llround(robot->getTime() * 1000.0));
+        for (std::size_t i = 0; i < frame.proximity.size(); ++i) {
             const double raw = proximity[i]->getValue();
             const double finite = std::isfinite(raw) ? raw : 0.0;
-            values[static_cast<std::size_t>(i)] = clampd(finite / 4096.0, 0.0, 1.0);
+            frame.proximity[i] = clampd(finite / 4096.0, 0.0, 1.0);
         }
-        return values;
-    }
-
-    [[nodiscard]] std::array<double, 3> read_ground_normalised() const {
-        std::array<double, 3> values{};
-        for (int i = 0; i < 3; ++i) {
+        for (std::size_t i = 0; i < frame.ground.size(); ++i) {
             if (!ground[i]) {
-                values[static_cast<std::size_t>(i)] = 1.0;
+                frame.ground[i] = 1.0;
                 continue;
             }
             const double raw = ground[i]->getValue();
             const double finite = std::isfinite(raw) ? raw : 1000.0;
-            values[static_cast<std::size_t>(i)] = clampd(finite / 1000.0, 0.0, 1.0);
+            frame.ground[i] = clampd(finite / 1000.0, 0.0, 1.0);
         }
-        return values;
     }
 
     void set_wheel_velocity(double left, double right) {
@@ -671,6 +769,7 @@ public:
         out.headless = true;
         out.realtime_pacing = true;
         out.deterministic_seed = true;
+        out.typed_observe = true;
         return out;
     }
 
@@ -733,8 +832,10 @@ public:
         if (const auto v = map_lookup_option(opts, "obs_schema")) {
             obs_schema_ = require_text_value(*v, "env.configure :obs_schema");
         }
+        obs_kind_ = obs_kind_for_schema(obs_schema_);
 
         refresh_scene_handles();
+        frame_stale_ = true;
     }
 
     [[nodiscard]] muslisp::value reset(std::optional<std::int64_t> seed) override {
@@ -743,51 +844,27 @@ public:
     }
 
     [[nodiscard]] muslisp::value observe() override {
-        muslisp::value obs = muslisp::make_map();
-        muslisp::gc_root_scope roots(muslisp::default_gc());
-        roots.add(&obs);
-
-        const std::array<double, 8> proximity = devices_->read_proximity_normalised();
-        std::vector<double> proximity_vec(proximity.begin(), proximity.end());
-        muslisp::value proximity_list = numeric_vector_to_lisp_list(proximity_vec);
-        roots.add(&proximity_list);
-
-        const double max_proximity = *std::max_element(proximity.begin(), proximity.end());
-        const double min_obstacle = clampd(1.0 - max_proximity, 0.0, 1.0);
-
-        const double left_activity = proximity[5] + proximity[6] + proximity[7];
-        const double right_activity = proximity[0] + proximity[1] + proximity[2];
-        const std::string wall_side = left_activity >= right_activity ? "left" : "right";
-
-        map_set_symbol(obs, "obs_schema", muslisp::make_string(obs_schema_));
-        map_set_symbol(obs, "t_ms", muslisp::make_integer(static_cast<std::int64_t>(std::llround(devices_->robot->getTime() * 1000.0))));
-        map_set_symbol(obs, "proximity", proximity_list);
-        map_set_symbol(obs, "min_obstacle", muslisp::make_float(min_obstacle));
-        map_set_symbol(obs, "wall_side", muslisp::make_string(wall_side));
-
-        if (has_seed_) {
-            map_set_symbol(obs, "seed", muslisp::make_integer(configured_seed_));
-        }
-
-        const auto robot_xy = node_xy(robot_node_);
-        if (robot_xy.has_value()) {
-            muslisp::value robot_xy_list = numeric_vector_to_lisp_list({(*robot_xy)[0], (*robot_xy)[1]});
-            roots.add(&robot_xy_list);
-            map_set_symbol(obs, "robot_xy", robot_xy_list);
-            map_set_symbol(obs, "robot_yaw", muslisp::make_float(node_yaw(robot_node_)));
+        map_observation_sink sink;
+        write_observation(current_frame(), sink);
+        if (const char* model = planner_hint_model()) {
+            muslisp::value planner_hint = muslisp::make_map();
+            muslisp::gc_root_scope roots(muslisp::default_gc());
+            roots.add(&planner_hint);
+            map_set_symbol(planner_hint, "model_service", muslisp::make_string(model));
+            map_set_symbol(planner_hint, "state_key", muslisp::make_string("planner_state"));
+            sink.set("planner_hint", planner_hint);
         }
+        return sink.map();
+    }
 
-        if (obs_schema_ == "epuck.line.obs.v1") {
-            add_line_observation(obs, roots);
-        } else if (obs_schema_ == "epuck.goal.obs.v1") {
-            add_goal_observation(obs, proximity, min_obstacle, roots);
-        } else if (obs_schema_ == "epuck.foraging.obs.v1") {
-            add_foraging_observation(obs, min_obstacle, roots);
-        } else if (obs_schema_ == "epuck.tag.obs.v1") {
-            add_tag_observation(obs, min_obstacle, roots);
+    // The fields of observe(), written from the step's sensor frame without building Lisp values;
+    // planner_hint is flattened to model_service and state_key.
+    void observe_into(muslisp::env_observation_sink& sink) override {
+        write_observation(current_frame(), sink);
+        if (const char* model = planner_hint_model()) {
+            sink.put_string("model_service", model);
+            sink.put_string("state_key", "planner_state");
         }
-
-        return obs;
     }
 
     void act(muslisp::value action) override {
@@ -819,6 +896,7 @@ public:
     }
 
     [[nodiscard]] bool step() override {
+        frame_stale_ = true;
         if (has_pending_) {
             devices_->set_wheel_velocity(pending_left_, pending_right_);
             has_pending_ = false;
@@ -1004,149 +1082,190 @@ private:
         }
     }
 
-    void add_line_observation(muslisp::value obs, muslisp::gc_root_scope& roots) {
-        const std::array<double, 3> ground = devices_->read_ground_normalised();
-        std::vector<double> ground_vec(ground.begin(), ground.end());
-        muslisp::value ground_list = numeric_vector_to_lisp_list(ground_vec);
-        roots.add(&ground_list);
+    // The frame for the current step, read from the devices and scene on first use after a step.
+    const epuck_sensor_frame& current_frame() {
+        if (frame_stale_) {
+            capture_frame();
+            frame_stale_ = false;
+        }
+        return frame_;
+    }
 
-        const double dark_left = clampd(1.0 - ground[0], 0.0, 1.0);
-        const double dark_centre = clampd(1.0 - ground[1], 0.0, 1.0);
-        const double dark_right = clampd(1.0 - ground[2], 0.0, 1.0);
-        const double dark_sum = dark_left + dark_centre + dark_right;
-        const double line_error = dark_sum > 1e-6 ? clampd((dark_right - dark_left) / dark_sum, -1.0, 1.0) : 0.0;
+    void capture_frame() {
+        epuck_sensor_frame& f = frame_;
+        devices_->read_sensors(f);
 
-        map_set_symbol(obs, "ground", ground_list);
-        map_set_symbol(obs, "line_error", muslisp::make_float(line_error));
+        const std::array<double, 8>& p = f.proximity;
+        f.min_obstacle = clampd(1.0 - *std::max_element(p.begin(), p.end()), 0.0, 1.0);
+        f.wall_side = p[5] + p[6] + p[7] >= p[0] + p[1] + p[2] ? "left" : "right";
+        f.line_error = ground_line_error(f.ground);
+        f.lidar_lite = lidar_lite_from_proximity(p);
 
-        muslisp::value planner_hint = muslisp::make_map();
-        roots.add(&planner_hint);
-        map_set_symbol(planner_hint, "model_service", muslisp::make_string("epuck-line-v1"));
-        map_set_symbol(planner_hint, "state_key", muslisp::make_string("planner_state"));
-        map_set_symbol(obs, "planner_hint", planner_hint);
-    }
+        const auto rxy = node_xy(robot_node_);
+        f.has_pose = rxy.has_value();
+        if (f.has_pose) {
+            f.robot_xy = *rxy;
+            f.robot_yaw = node_yaw(robot_node_);
+        }
 
-    void add_goal_observation(muslisp::value obs,
-                              const std::array<double, 8>& proximity,
-                              double min_obstacle,
-                              muslisp::gc_root_scope& roots) {
-        map_set_symbol(obs, "obs_schema", muslisp::make_string("epuck.goal.obs.v1"));
+        switch (obs_kind_) {
+            case epuck_obs_kind::goal:
+                capture_goal(f);
+                break;
+            case epuck_obs_kind::foraging:
+                capture_foraging(f);
+                break;
+            case epuck_obs_kind::tag:
+                capture_tag(f);
+                break;
+            case epuck_obs_kind::obstacle:
+            case epuck_obs_kind::line:
+                break;
+        }
+    }
 
-        const auto rxy = node_xy(robot_node_);
+    void capture_goal(epuck_sensor_frame& f) const {
         const auto gxy = node_xy(goal_node_);
-        double goal_dist = 1.0;
-        double goal_bearing = 0.0;
-        if (rxy.has_value() && gxy.has_value()) {
-            goal_dist = planar_distance(*rxy, *gxy);
-            goal_bearing = relative_bearing(*rxy, node_yaw(robot_node_), *gxy);
-            muslisp::value goal_xy_list = numeric_vector_to_lisp_list({(*gxy)[0], (*gxy)[1]});
-            roots.add(&goal_xy_list);
-            map_set_symbol(obs, "goal_xy", goal_xy_list);
-        }
-
-        const std::vector<double> lidar = lidar_lite_from_proximity(proximity);
-        muslisp::value lidar_list = numeric_vector_to_lisp_list(lidar);
-        roots.add(&lidar_list);
-
-        map_set_symbol(obs, "goal_dist", muslisp::make_float(goal_dist));
-        map_set_symbol(obs, "goal_bearing", muslisp::make_float(goal_bearing));
-        map_set_symbol(obs, "obstacle_front", muslisp::make_float(1.0 - min_obstacle));
-        map_set_symbol(obs, "lidar_lite", lidar_list);
-
-        muslisp::value planner_hint = muslisp::make_map();
-        roots.add(&planner_hint);
-        map_set_symbol(planner_hint, "model_service", muslisp::make_string("epuck-goal-v1"));
-        map_set_symbol(planner_hint, "state_key", muslisp::make_string("planner_state"));
-        map_set_symbol(obs, "planner_hint", planner_hint);
-    }
-
-    void add_foraging_observation(muslisp::value obs, double min_obstacle, muslisp::gc_root_scope& roots) {
-        map_set_symbol(obs, "obs_schema", muslisp::make_string("epuck.foraging.obs.v1"));
-        map_set_symbol(obs, "carrying", muslisp::make_boolean(carrying_));
-        map_set_symbol(obs, "collected", muslisp::make_integer(collected_count_));
-        map_set_symbol(obs, "puck_total", muslisp::make_integer(static_cast<std::int64_t>(puck_nodes_.size())));
-        map_set_symbol(obs, "obstacle_front", muslisp::make_float(1.0 - min_obstacle));
+        f.has_goal = f.has_pose && gxy.has_value();
+        f.goal_dist = 1.0;
+        f.goal_bearing = 0.0;
+        if (f.has_goal) {
+            f.goal_xy = *gxy;
+            f.goal_dist = planar_distance(f.robot_xy, *gxy);
+            f.goal_bearing = relative_bearing(f.robot_xy, f.robot_yaw, *gxy);
+        }
+    }
 
-        const auto rxy = node_xy(robot_node_);
+    void capture_foraging(epuck_sensor_frame& f) const {
         const auto bxy = node_xy(base_node_);
-
-        double target_dist = 1.5;
-        double target_bearing = 0.0;
-        std::string target_kind = "none";
-
-        if (rxy.has_value() && bxy.has_value()) {
-            const double yaw = node_yaw(robot_node_);
-            const double base_dist = planar_distance(*rxy, *bxy);
-            const double base_bearing = relative_bearing(*rxy, yaw, *bxy);
-            map_set_symbol(obs, "base_dist", muslisp::make_float(base_dist));
-            map_set_symbol(obs, "base_bearing", muslisp::make_float(base_bearing));
-
-            muslisp::value base_xy_list = numeric_vector_to_lisp_list({(*bxy)[0], (*bxy)[1]});
-            roots.add(&base_xy_list);
-            map_set_symbol(obs, "base_xy", base_xy_list);
-
-            if (carrying_) {
-                target_dist = base_dist;
-                target_bearing = base_bearing;
-                target_kind = "base";
-                map_set_symbol(obs, "target_xy", base_xy_list);
-            } else {
-                const auto nearest = nearest_puck_to_robot();
-                if (nearest.has_value() && static_cast<std::size_t>(nearest->first) < puck_nodes_.size()) {
-                    const auto pxy = node_xy(puck_nodes_[static_cast<std::size_t>(nearest->first)]);
-                    if (pxy.has_value()) {
-                        target_dist = nearest->second;
-                        target_bearing = relative_bearing(*rxy, yaw, *pxy);
-                        target_kind = "puck";
-                        muslisp::value target_xy_list = numeric_vector_to_lisp_list({(*pxy)[0], (*pxy)[1]});
-                        roots.add(&target_xy_list);
-                        map_set_symbol(obs, "target_xy", target_xy_list);
-                        map_set_symbol(obs, "target_index", muslisp::make_integer(nearest->first));
-                    }
-                }
-            }
+        f.has_base = f.has_pose && bxy.has_value();
+        f.has_target = false;
+        f.target_kind = "none";
+        f.target_index = -1;
+        f.target_dist = 1.5;
+        f.target_bearing = 0.0;
+        if (!f.has_base) {
+            return;
         }
+        f.base_xy = *bxy;
+        f.base_dist = planar_distance(f.robot_xy, *bxy);
+        f.base_bearing = relative_bearing(f.robot_xy, f.robot_yaw, *bxy);
 
-        map_set_symbol(obs, "target_kind", muslisp::make_string(target_kind));
-        map_set_symbol(obs, "target_dist", muslisp::make_float(target_dist));
-        map_set_symbol(obs, "target_bearing", muslisp::make_float(target_bearing));
-
-        muslisp::value planner_hint = muslisp::make_map();
-        roots.add(&planner_hint);
-        map_set_symbol(planner_hint, "model_service", muslisp::make_string("epuck-target-v1"));
-        map_set_symbol(planner_hint, "state_key", muslisp::make_string("planner_state"));
-        map_set_symbol(obs, "planner_hint", planner_hint);
+        if (carrying_) {
+            f.has_target = true;
+            f.target_kind = "base";
+            f.target_xy = f.base_xy;
+            f.target_dist = f.base_dist;
+            f.target_bearing = f.base_bearing;
+            return;
+        }
+        const auto nearest = nearest_puck_to_robot();
+        if (!nearest.has_value() || static_cast<std::size_t>(nearest->first) >= puck_nodes_.size()) {
+            return;
+        }
+        const auto pxy = node_xy(puck_nodes_[static_cast<std::size_t>(nearest->first)]);
+        if (!pxy.has_value()) {
+            return;
+        }
+        f.has_target = true;
+        f.target_kind = "puck";
+        f.target_xy = *pxy;
+        f.target_index = nearest->first;
+        f.target_dist = nearest->second;
+        f.target_bearing = relative_bearing(f.robot_xy, f.robot_yaw, *pxy);
     }
 
-    void add_tag_observation(muslisp::value obs, double min_obstacle, muslisp::gc_root_scope& roots) {
-        map_set_symbol(obs, "obs_schema", muslisp::make_string("epuck.tag.obs.v1"));
-        map_set_symbol(obs, "intercepts", muslisp::make_integer(intercept_count_));
-        map_set_symbol(obs, "obstacle_front", muslisp::make_float(1.0 - min_obstacle));
-
-        const auto rxy = node_xy(robot_node_);
+    void capture_tag(epuck_sensor_frame& f) const {
         const auto exy = node_xy(evader_node_);
-
-        double evader_dist = 2.0;
-        double evader_bearing = 0.0;
-        bool evader_seen = false;
-        if (rxy.has_value() && exy.has_value()) {
-            evader_dist = planar_distance(*rxy, *exy);
-            evader_bearing = relative_bearing(*rxy, node_yaw(robot_node_), *exy);
-            evader_seen = true;
-            muslisp::value evader_xy_list = numeric_vector_to_lisp_list({(*exy)[0], (*exy)[1]});
-            roots.add(&evader_xy_list);
-            map_set_symbol(obs, "evader_xy", evader_xy_list);
+        f.evader_seen = f.has_pose && exy.has_value();
+        f.evader_dist = 2.0;
+        f.evader_bearing = 0.0;
+        if (f.evader_seen) {
+            f.evader_xy = *exy;
+            f.evader_dist = planar_distance(f.robot_xy, *exy);
+            f.evader_bearing = relative_bearing(f.robot_xy, f.robot_yaw, *exy);
+        }
+    }
+
+    // The flat fields of one observation; observe() nests planner_hint on top.
+    void write_observation(const epuck_sensor_frame& f, muslisp::env_observation_sink& sink) const {
+        sink.put_string("obs_schema", obs_schema_);
+        sink.put_integer("t_ms", f.t_ms);
+        sink.put_vector("proximity", f.proximity);
+        sink.put_number("min_obstacle", f.min_obstacle);
+        sink.put_string("wall_side", f.wall_side);
+        sink.put_bool("done", false);
+        if (has_seed_) {
+            sink.put_integer("seed", configured_seed_);
+        }
+        if (f.has_pose) {
+            sink.put_vector("robot_xy", f.robot_xy);
+            sink.put_number("robot_yaw", f.robot_yaw);
+        }
+
+        switch (obs_kind_) {
+            case epuck_obs_kind::obstacle:
+                break;
+            case epuck_obs_kind::line:
+                sink.put_vector("ground", f.ground);
+                sink.put_number("line_error", f.line_error);
+                break;
+            case epuck_obs_kind::goal:
+                if (f.has_goal) {
+                    sink.put_vector("goal_xy", f.goal_xy);
+                }
+                sink.put_number("goal_dist", f.goal_dist);
+                sink.put_number("goal_bearing", f.goal_bearing);
+                sink.put_number("obstacle_front", 1.0 - f.min_obstacle);
+                sink.put_vector("lidar_lite", f.lidar_lite);
+                break;
+            case epuck_obs_kind::foraging:
+                sink.put_bool("carrying", carrying_);
+                sink.put_integer("collected", collected_count_);
+                sink.put_integer("puck_total", static_cast<std::int64_t>(puck_nodes_.size()));
+                sink.put_number("obstacle_front", 1.0 - f.min_obstacle);
+                if (f.has_base) {
+                    sink.put_number("base_dist", f.base_dist);
+                    sink.put_number("base_bearing", f.base_bearing);
+                    sink.put_vector("base_xy", f.base_xy);
+                }
+                if (f.has_target) {
+                    sink.put_vector("target_xy", f.target_xy);
+                }
+                if (f.target_index >= 0) {
+                    sink.put_integer("target_index", f.target_index);
+                }
+                sink.put_string("target_kind", f.target_kind);
+                sink.put_number("target_dist", f.target_dist);
+                sink.put_number("target_bearing", f.target_bearing);
+                break;
+            case epuck_obs_kind::tag:
+                sink.put_integer("intercepts", intercept_count_);
+                sink.put_number("obstacle_front", 1.0 - f.min_obstacle);
+                if (f.evader_seen) {
+                    sink.put_vector("evader_xy", f.evader_xy);
+                }
+                sink.put_bool("evader_seen", f.evader_seen);
+                sink.put_number("evader_dist", f.evader_dist);
+                sink.put_number("evader_bearing", f.evader_bearing);
+                break;
         }
+    }
 
-        map_set_symbol(obs, "evader_seen", muslisp::make_boolean(evader_seen));
-        map_set_symbol(obs, "evader_dist", muslisp::make_float(evader_dist));
-        map_set_symbol(obs, "evader_bearing", muslisp::make_float(evader_bearing));
-
-        muslisp::value planner_hint = muslisp::make_map();
-        roots.add(&planner_hint);
-        map_set_symbol(planner_hint, "model_service", muslisp::make_string("epuck-intercept-v1"));
-        map_set_symbol(planner_hint, "state_key", muslisp::make_string("planner_state"));
-        map_set_symbol(obs, "planner_hint", planner_hint);
+    [[nodiscard]] const char* planner_hint_model() const {
+        switch (obs_kind_) {
+            case epuck_obs_kind::line:
+                return "epuck-line-v1";
+            case epuck_obs_kind::goal:
+                return "epuck-goal-v1";
+            case epuck_obs_kind::foraging:
+                return "epuck-target-v1";
+            case epuck_obs_kind::tag:
+                return "epuck-intercept-v1";
+            case epuck_obs_kind::obstacle:
+                break;
+        }
+        return nullptr;
     }
 
     epuck_devices* devices_ = nullptr;
@@ -1162,6 +1281,10 @@ private:
     std::int64_t steps_per_tick_ = 1;
     std::string demo_ = "obstacle";
     std::string obs_schema_ = "epuck.obstacle.obs.v1";
+    epuck_obs_kind obs_kind_ = epuck_obs_kind::obstacle;
+
+    epuck_sensor_frame frame_;
+    bool frame_stale_ = true;
 
     bool has_pending_ = false;
     double pending_left_ = 0.0;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -7,6 +8,9 @@
 namespace bt {
 
 using node_id = std::uint32_t;
+using bb_slot = std::uint32_t;
+
+inline constexpr bb_slot kNoBbSlot = ~bb_slot{0};
 
 enum class node_kind {
     seq,
@@ -27,9 +31,18 @@ enum class node_kind {
     mem_sel,
     async_seq,
     reactive_seq,
-    reactive_sel
+    reactive_sel,
+    par,
+    vla_chunk
 };
 
+// `par` nodes keep per-child completion in two 64-bit masks, which bounds their child count. Their
+// args are the success and failure thresholds, in that order.
+inline constexpr std::size_t kMaxParChildren = 64;
+
+// DSL spelling of `kind`, e.g. "plan-action".
+const char* node_kind_name(node_kind kind) noexcept;
+
 enum class arg_kind {
     nil,
     boolean,
@@ -56,14 +69,23 @@ struct node {
     std::vector<arg_value> args;
 
     std::int64_t int_param = 0;
+
+    // plan-action only: index into `definition::bb_keys` of the state key read every tick.
+    bb_slot state_key = kNoBbSlot;
 };
 
 struct definition {
     std::vector<node> nodes;
     node_id root = 0;
+    // Set for definitions compiled from DSL source. Their canonical DSL and its hash are filled in on
+    // first use by ensure_canonical_dsl (bt/compiler.hpp); read them after calling it.
     std::string source_hash;
-    std::string canonical_dsl_hash;
-    std::string canonical_dsl;
+    mutable std::string canonical_dsl_hash;
+    mutable std::string canonical_dsl;
+
+    // Blackboard keys named statically by the tree (leaf symbol args and planner/VLA `*_key` options).
+    // Instances intern these up front, so index i maps to a dense blackboard slot with no hashing per tick.
+    std::vector<std::string> bb_keys;
 };
 
 }  // namespace bt
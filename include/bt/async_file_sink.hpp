@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace bt {
+
+// Appends lines to a file from a dedicated writer thread. Producers copy each line into a slot of a
+// fixed ring (slots keep their string capacity, so steady-state pushes do not allocate) and never
+// block or touch the file; the writer thread hands whole batches to the OS with writev. A push that
+// finds the ring full is dropped and counted rather than waiting for the disk.
+//
+// The ring is single-producer/single-consumer: callers must serialise push() (event_log pushes while
+// holding its own lock).
+class async_file_sink {
+public:
+    static constexpr std::size_t k_default_queue_lines = 4096;
+
+    // `queue_lines` is rounded up to a power of two. Lines that cannot be written (including every
+    // line, when `path` cannot be opened) are added to `dropped`.
+    async_file_sink(const std::string& path, std::size_t queue_lines, std::atomic<std::uint64_t>& dropped);
+    // Writes everything already queued, then stops the writer thread.
+    ~async_file_sink();
+
+    async_file_sink(const async_file_sink&) = delete;
+    async_file_sink& operator=(const async_file_sink&) = delete;
+
+    [[nodiscard]] static bool supported() noexcept;
+
+    // Queues `line` (a newline is appended when written). Returns false if the line was dropped.
+    bool push(std::string_view line);
+    // Blocks until every line pushed before the call has been written.
+    void drain();
+
+    [[nodiscard]] std::size_t queue_lines() const noexcept;
+
+private:
+    void run();
+    void write_batch(std::uint64_t from, std::uint64_t to);
+
+    std::vector<std::string> slots_;
+    std::size_t mask_ = 0;
+    int fd_ = -1;
+    std::atomic<std::uint64_t>& dropped_;
+
+    alignas(64) std::atomic<std::uint64_t> head_{0};
+    alignas(64) std::atomic<std::uint64_t> tail_{0};
+    alignas(64) std::atomic<std::uint32_t> wake_{0};
+    std::atomic<bool> idle_{false};
+    std::atomic<bool> stopping_{false};
+    std::thread thread_;
+};
+
+}  // namespace bt
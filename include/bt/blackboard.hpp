@@ -1,8 +1,14 @@
 #pragma once
 
+#include <array>
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <deque>
+#include <initializer_list>
+#include <memory>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
 #include <unordered_map>
@@ -10,12 +16,67 @@
 #include <vector>
 
 #include "bt/ast.hpp"
+#include "bt/tick_wake.hpp"
 #include "bt/vla.hpp"
 
 namespace bt {
 
+// Immutable numeric vector payload. Up to `inline_capacity` values are stored in place; larger payloads
+// live in a shared buffer, so copying a blackboard value (snapshots, planner reads) never copies doubles.
+class bb_vector {
+public:
+    static constexpr std::size_t inline_capacity = 8;
+
+    bb_vector() noexcept = default;
+    bb_vector(std::initializer_list<double> values);
+    bb_vector(std::span<const double> values);
+    bb_vector(const std::vector<double>& values);
+    bb_vector(std::vector<double>&& values);
+
+    [[nodiscard]] const double* data() const noexcept {
+        return shared_ ? shared_->data() : inline_.data();
+    }
+    [[nodiscard]] std::size_t size() const noexcept {
+        return size_;
+    }
+    [[nodiscard]] bool empty() const noexcept {
+        return size_ == 0;
+    }
+    [[nodiscard]] bool is_inline() const noexcept {
+        return !shared_;
+    }
+    [[nodiscard]] const double* begin() const noexcept {
+        return data();
+    }
+    [[nodiscard]] const double* end() const noexcept {
+        return data() + size_;
+    }
+    [[nodiscard]] double operator[](std::size_t i) const noexcept {
+        return data()[i];
+    }
+    [[nodiscard]] double front() const noexcept {
+        return data()[0];
+    }
+    [[nodiscard]] double back() const noexcept {
+        return data()[size_ - 1];
+    }
+    [[nodiscard]] std::span<const double> view() const noexcept {
+        return {data(), size_};
+    }
+    [[nodiscard]] std::vector<double> to_vector() const {
+        return std::vector<double>(begin(), end());
+    }
+
+    friend bool operator==(const bb_vector& a, const bb_vector& b) noexcept;
+
+private:
+    std::size_t size_ = 0;
+    std::array<double, inline_capacity> inline_{};
+    std::shared_ptr<const std::vector<double>> shared_;
+};
+
 using bb_value =
-    std::variant<std::monostate, bool, std::int64_t, double, std::string, std::vector<double>, image_handle_ref, blob_handle_ref>;
+    std::variant<std::monostate, bool, std::int64_t, double, std::string, bb_vector, image_handle_ref, blob_handle_ref>;
 
 struct bb_entry {
     bb_value value;
@@ -25,24 +86,259 @@ struct bb_entry {
     std::string last_writer_name;
 };
 
+struct bb_history_sample {
+    std::uint64_t tick = 0;
+    std::chrono::steady_clock::time_point ts{};
+    bb_value value;
+};
+
+// Aggregates over the numeric (int64 and float64) samples of a history window; other samples are
+// skipped. min, max and mean() are only meaningful when count > 0.
+struct bb_window_stats {
+    std::size_t count = 0;
+    double sum = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+
+    [[nodiscard]] double mean() const noexcept { return count == 0 ? 0.0 : sum / static_cast<double>(count); }
+};
+
+// Fixed-capacity ring of the last writes to one blackboard slot. The sum, count, min and max of the
+// whole ring are kept up to date on every push (min and max through monotonic queues), so whole-ring
+// aggregates cost O(1); windows shorter than the ring scan their samples. The running sum is
+// recomputed once per lap of the ring so rounding does not accumulate.
+class bb_history {
+public:
+    explicit bb_history(std::size_t capacity);
+
+    void push(std::uint64_t tick, std::chrono::steady_clock::time_point ts, const bb_value& value);
+    void clear() noexcept;
+
+    [[nodiscard]] std::size_t size() const noexcept { return size_; }
+    [[nodiscard]] std::size_t capacity() const noexcept { return samples_.size(); }
+    // `age` 0 is the newest sample; requires age < size().
+    [[nodiscard]] const bb_history_sample& recent(std::size_t age) const noexcept;
+    // The newest sample written at or before `tick`, or nullptr when every retained sample is newer.
+    // Binary search, so it assumes ticks do not decrease from one write to the next.
+    [[nodiscard]] const bb_history_sample* at_tick(std::uint64_t tick) const noexcept;
+    // Aggregates over the newest `k` samples; 0 or k >= size() means the whole ring.
+    [[nodiscard]] bb_window_stats window(std::size_t k = 0) const noexcept;
+
+private:
+    // Sequence numbers of pushes, front to back, in a ring as large as the history.
+    struct seq_queue {
+        std::vector<std::uint64_t> items;
+        std::size_t head = 0;
+        std::size_t length = 0;
+
+        [[nodiscard]] bool empty() const noexcept { return length == 0; }
+        [[nodiscard]] std::uint64_t front() const noexcept { return items[head]; }
+        [[nodiscard]] std::uint64_t back() const noexcept { return items[(head + length - 1) % items.size()]; }
+        void push_back(std::uint64_t seq) noexcept;
+        void pop_back() noexcept { --length; }
+        void pop_front() noexcept;
+        void clear() noexcept { head = length = 0; }
+    };
+
+    [[nodiscard]] std::size_t index_of(std::uint64_t seq) const noexcept { return seq % samples_.size(); }
+
+    std::vector<bb_history_sample> samples_;
+    // Per sample: its numeric value and whether it has one.
+    std::vector<double> numbers_;
+    std::vector<std::uint8_t> numeric_;
+    std::size_t size_ = 0;
+    std::uint64_t pushes_ = 0;
+    std::size_t numeric_count_ = 0;
+    double sum_ = 0.0;
+    seq_queue min_queue_;
+    seq_queue max_queue_;
+};
+
+// Keys are interned into dense slot ids on first use and never removed, so a slot resolved once (for
+// example from `definition::bb_keys`) stays valid for the lifetime of the blackboard, across `clear()`.
+// The string-keyed API is the slow path over the same storage.
+//
+// Every write (put, get_mut, clear) stamps the touched slots with the next value of a per-blackboard
+// write counter. Unlike `bb_entry::last_write_tick`, which is whatever tick the caller passed, the
+// stamp orders writes within a tick and between ticks, so incremental ticking can ask "has this
+// slot changed since I last looked".
+//
+// Slots are stored in fixed-size pages shared copy-on-write between a blackboard and its forks (see
+// fork()); a write copies only the page it lands in when another blackboard still shares it.
+//
+// A blackboard can watch a set of slots for a tick_waker (see watch()): a put() that changes a watched
+// slot's value, a get_mut() of one, or a clear() that drops one notifies wake_reason::bb_write.
+//
+// Given vla_handle_refs, the blackboard holds one reference per entry whose value is an image or blob
+// handle: put() takes it and drops the one of the value it replaces, and clear(), destruction and
+// move assignment drop them all. History samples and read views hold no references.
+class bb_read_view;
+
 class blackboard {
 public:
+    blackboard() = default;
+    ~blackboard();
+    blackboard(const blackboard&) = delete;
+    blackboard& operator=(const blackboard&) = delete;
+    blackboard(blackboard&&) = default;
+    blackboard& operator=(blackboard&& other) noexcept;
+
+    // Takes a reference to every handle now on the blackboard from `refs` and drops those held from
+    // the previous refs. nullptr stops holding references.
+    void set_handle_refs(std::shared_ptr<vla_handle_refs> refs);
+    [[nodiscard]] const std::shared_ptr<vla_handle_refs>& handle_refs() const noexcept { return handle_refs_; }
+
+    // A blackboard with the same keys, slots, entries and write counter that shares this one's
+    // storage until either side writes. The fork starts with an empty journal. Costs one pointer
+    // copy per page, not per entry, plus a reference per handle entry when handle refs are set.
+    [[nodiscard]] blackboard fork() const;
+    // Read-only view of `slots` (or `keys`) as they are now, for job functions on other threads. Keys
+    // that were never interned are left out.
+    [[nodiscard]] bb_read_view read_view(std::span<const bb_slot> slots) const;
+    [[nodiscard]] bb_read_view read_view(std::span<const std::string_view> keys) const;
+
     bool has(std::string_view key) const;
     const bb_entry* get(std::string_view key) const;
     bb_entry* get_mut(std::string_view key);
 
-    void put(std::string key,
+    void put(std::string_view key,
              bb_value value,
              std::uint64_t tick,
              std::chrono::steady_clock::time_point ts,
              node_id writer_node,
-             std::string writer_name);
+             std::string_view writer_name);
+
+    bb_slot intern(std::string_view key);
+    bb_slot find_slot(std::string_view key) const;
+    const std::string& key_name(bb_slot slot) const;
+    bool has(bb_slot slot) const;
+    const bb_entry* get(bb_slot slot) const;
+    bb_entry* get_mut(bb_slot slot);
+    bb_entry& put(bb_slot slot,
+                  bb_value value,
+                  std::uint64_t tick,
+                  std::chrono::steady_clock::time_point ts,
+                  node_id writer_node,
+                  std::string_view writer_name);
+
+    // Keeps the last `capacity` writes through put() to `slot` in a bb_history, starting empty; 0 stops
+    // keeping them. Histories survive clear(), which only empties them, and are shared copy-on-write
+    // with forks like pages. Writes through get_mut() are not recorded, nor do they change the handle
+    // references held for the slot.
+    void set_history(bb_slot slot, std::size_t capacity);
+    [[nodiscard]] const bb_history* history(bb_slot slot) const noexcept {
+        return slot < histories_.size() ? histories_[slot].get() : nullptr;
+    }
+    // Stops keeping history for every slot.
+    void clear_histories() noexcept { histories_.clear(); }
 
     std::vector<std::pair<std::string, bb_entry>> snapshot() const;
     void clear();
 
+    [[nodiscard]] std::uint64_t write_count() const noexcept { return write_count_; }
+    // Heap bytes held: pages, entry payloads, key table, journal and histories. Pages and histories
+    // shared with forks are counted by every blackboard that holds them.
+    [[nodiscard]] std::size_t memory_bytes() const noexcept;
+    // Write stamp of `slot` (0 if it was never written).
+    [[nodiscard]] std::uint64_t write_version(bb_slot slot) const noexcept {
+        return slot < slot_count_ ? slot_ref(slot).version : 0;
+    }
+
+    // Notifies `waker` of later writes to `slots`, or to every slot (including ones interned later)
+    // when `all_slots` is set, replacing any previous watch. Forks and move-assigned-over blackboards
+    // do not keep a watch. nullptr stops watching.
+    void watch(std::shared_ptr<tick_waker> waker, std::span<const bb_slot> slots, bool all_slots = false);
+    [[nodiscard]] bool watched(bb_slot slot) const noexcept {
+        return waker_ && (watch_all_ || (slot < watched_.size() && watched_[slot] != 0u));
+    }
+
+    // Slots written since the last reset_journal(), including slots that were cleared or deleted.
+    [[nodiscard]] std::span<const bb_slot> journal() const noexcept { return journal_; }
+    void reset_journal() noexcept;
+
 private:
-    std::unordered_map<std::string, bb_entry> map_;
+    friend class bb_read_view;
+
+    static constexpr std::size_t k_page_slots = 16;
+
+    struct slot_data {
+        bb_entry entry;
+        bool present = false;
+        std::uint64_t version = 0;
+    };
+    struct page {
+        std::array<slot_data, k_page_slots> slots;
+    };
+    // deque keeps the names' addresses stable, so the index can key on views into it.
+    struct key_table {
+        std::deque<std::string> names;
+        std::unordered_map<std::string_view, bb_slot> index;
+    };
+
+    [[nodiscard]] const slot_data& slot_ref(bb_slot slot) const noexcept {
+        return pages_[slot / k_page_slots]->slots[slot % k_page_slots];
+    }
+    // The slot in a page owned by this blackboard alone, copying the page first if it is shared.
+    slot_data& writable_slot(bb_slot slot);
+    void stamp(slot_data& data, bb_slot slot, std::uint64_t version);
+    // Take or drop a reference when `value` is an image or blob handle.
+    void retain_handle(const bb_value& value) const;
+    void release_handle(const bb_value& value) const;
+    void release_handles() const noexcept;
+
+    std::shared_ptr<key_table> keys_;
+    std::vector<std::shared_ptr<page>> pages_;
+    std::size_t slot_count_ = 0;
+    std::uint64_t write_count_ = 0;
+    std::vector<bb_slot> journal_;
+    std::vector<std::uint8_t> journaled_;
+    // Indexed by slot; empty until the first set_history().
+    std::vector<std::shared_ptr<bb_history>> histories_;
+    std::shared_ptr<vla_handle_refs> handle_refs_;
+    std::shared_ptr<tick_waker> waker_;
+    // Indexed by slot; only read while waker_ is set.
+    std::vector<std::uint8_t> watched_;
+    bool watch_all_ = false;
+};
+
+// Selected blackboard slots frozen at the moment blackboard::read_view was called, RCU style: the view
+// holds references to the pages those slots live in, and a later write to such a page copies it first
+// (see blackboard::fork), so the tick thread never changes what a view sees. Views are immutable and
+// safe to read from any thread while the blackboard keeps being written; move one into a job_request
+// closure instead of copying values out at submit time. Large float64[] values are shared, not copied,
+// either way.
+//
+// Each entry keeps its last_write_tick and last_write_ts, and write_count() is the blackboard's write
+// counter when the view was taken, so a job can tell how stale its inputs are. Holding a view makes
+// the next write to each of its pages copy that page (16 slots), so drop views when the job ends.
+class bb_read_view {
+public:
+    bb_read_view() = default;
+
+    [[nodiscard]] const bb_entry* get(std::string_view key) const;
+    // `slot` as interned by the blackboard the view was taken from.
+    [[nodiscard]] const bb_entry* get(bb_slot slot) const;
+    [[nodiscard]] bool has(std::string_view key) const { return get(key) != nullptr; }
+    // Write stamp of `slot` when the view was taken (0 if it was never written or is not in the view).
+    [[nodiscard]] std::uint64_t write_version(bb_slot slot) const noexcept;
+    [[nodiscard]] std::uint64_t write_count() const noexcept { return write_count_; }
+    // Number of slots in the view, present or not.
+    [[nodiscard]] std::size_t size() const noexcept { return slots_.size(); }
+
+private:
+    friend class blackboard;
+
+    struct slot_ref {
+        bb_slot slot = kNoBbSlot;
+        std::shared_ptr<const blackboard::page> page;
+    };
+
+    [[nodiscard]] const blackboard::slot_data* find(bb_slot slot) const noexcept;
+
+    std::shared_ptr<const blackboard::key_table> keys_;
+    // Sorted by slot.
+    std::vector<slot_ref> slots_;
+    std::uint64_t write_count_ = 0;
 };
 
 std::string bb_value_repr(const bb_value& value);
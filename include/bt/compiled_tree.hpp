@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bt/compiler.hpp"
+#include "bt/runtime.hpp"
+
+namespace bt {
+
+// The effects of each tick_op, one call per instruction, for executors that have the program's
+// control flow built in: the interpreter loop in runtime.cpp and trees generated by
+// emit_compiled_tree_cpp. Every call produces the same events, stats and node path updates as the
+// instruction it stands for, so a generated tree and the interpreter write identical event logs.
+// `st` is the program's status register.
+class tick_program_kernel {
+public:
+    tick_program_kernel(const tick_program& program, tick_context& ctx);
+    ~tick_program_kernel();
+
+    tick_program_kernel(const tick_program_kernel&) = delete;
+    tick_program_kernel& operator=(const tick_program_kernel&) = delete;
+
+    void enter(node_id id);
+    void exit(node_id id);
+    // `leaf` dispatches on the node kind; generated code calls the specialised forms.
+    void leaf(node_id id);
+    void condition(node_id id);
+    void action(node_id id);
+    void constant(node_id id, status result);
+    void subtree(node_id id);
+    void invert() noexcept;
+    void touch_memory(node_id id);
+    // True when the repeat is already done; `st` is then success.
+    bool repeat_check(node_id id);
+    void repeat_step(node_id id);
+    void retry_step(node_id id);
+    // The child a mem-seq or mem-sel resumes at, or its child count when it has none left.
+    std::uint32_t mem_child(node_id id);
+    // True when the node exits after child `child`.
+    bool mem_seq_step(node_id id, std::uint32_t child);
+    bool mem_sel_step(node_id id, std::uint32_t child);
+    void mem_seq_done(node_id id);
+    void mem_sel_done(node_id id);
+    // Index of the first guard of `guard_tables[table]` that has to be evaluated; the guards before
+    // it have been replayed as failed visits. 0 when every guard runs.
+    std::uint32_t guard_dispatch(std::uint32_t table);
+    // Closes the open frames as failures, for a callback that escaped with an exception.
+    void unwind();
+
+    status st = status::failure;
+
+private:
+    const tick_program& program_;
+    const definition& def_;
+    tick_context& ctx_;
+    std::vector<tick_frame> frames_;
+};
+
+// A tree whose tick program was turned into C++ ahead of time (see emit_compiled_tree_cpp). `run`
+// executes the program from the root through the kernel and returns the status register.
+class compiled_tree {
+public:
+    virtual ~compiled_tree() = default;
+
+    // tick_program_fingerprint of the program the tree was generated from.
+    [[nodiscard]] virtual std::uint64_t fingerprint() const noexcept = 0;
+    [[nodiscard]] virtual std::string_view name() const noexcept = 0;
+    virtual status run(tick_program_kernel& k) const = 0;
+};
+
+// FNV-1a over the instructions, jump tables, guard table addresses and the kinds of leaf nodes: the
+// parts of a program a generated tree has built in. Leaf names, arguments and repeat counts are
+// read from the definition at tick time and are not part of it.
+[[nodiscard]] std::uint64_t tick_program_fingerprint(const tick_program& program);
+
+// Process-wide table consulted by compile_tick_program, which attaches the tree registered for the
+// program's fingerprint. A later registration with the same fingerprint replaces the earlier one;
+// programs compiled before a registration keep what they had. Thread-safe.
+void register_compiled_tree(std::shared_ptr<const compiled_tree> tree);
+[[nodiscard]] std::shared_ptr<const compiled_tree> find_compiled_tree(std::uint64_t fingerprint);
+
+// C++ translation unit for `def`'s tick program: a compiled_tree subclass with the program unrolled
+// into straight-line code, a factory `std::shared_ptr<const bt::compiled_tree> make_<name>_compiled_tree()`,
+// and a static registration. `name` must be a C identifier. Throws bt_compile_error otherwise.
+[[nodiscard]] std::string emit_compiled_tree_cpp(const definition& def, std::string_view name);
+void emit_compiled_tree_file(const definition& def, std::string_view name, const std::string& path);
+
+}  // namespace bt
@@ -1,12 +1,21 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <memory>
 #include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "bt/ast.hpp"
+#include "bt/status.hpp"
 #include "muslisp/value.hpp"
 
 namespace bt {
 
+class compiled_tree;
+
 class bt_compile_error : public std::runtime_error {
 public:
     explicit bt_compile_error(const std::string& message) : std::runtime_error(message) {}
@@ -14,4 +23,92 @@ public:
 
 definition compile_definition(muslisp::value form);
 
+// Rebuilds `def.bb_keys` and the per-node key references from the node args.
+void index_blackboard_keys(definition& def);
+
+// Canonical DSL text of `def`, byte-for-byte what `(write (bt.to-dsl def))` prints.
+std::string write_canonical_dsl(const definition& def);
+// Fills `def.canonical_dsl` and `def.canonical_dsl_hash` the first time it is called for a definition
+// with a `source_hash`; does nothing otherwise. Not thread-safe: call it from the host thread.
+void ensure_canonical_dsl(const definition& def);
+
+// FNV-1a over the tree reachable from `def.root` (kinds, leaf names, args, parameters and shape),
+// fed node by node without building the DSL text. Equal trees hash equal regardless of node ids.
+std::uint64_t structural_hash(const definition& def);
+bool structurally_equal(const definition& a, const definition& b);
+// True when the two nodes agree on everything but their id and children: kind, leaf name, arguments
+// and integer parameter.
+bool same_node_label(const node& a, const node& b);
+
+// Linear tick program for a definition. Each supported node becomes an `enter`/`exit` pair around its
+// children's code, with jumps replacing the recursive interpreter's early returns; `status` is the
+// single result register. Memory nodes resume through `mem_dispatch`, which jumps to the child stored
+// in the node's memory. Kinds the program does not cover are ticked as a `subtree` by the recursive
+// interpreter, so a definition always compiles.
+enum class tick_op : std::uint8_t {
+    enter,         // open a visit frame for `node`
+    exit,          // close the innermost frame with the status register
+    leaf,          // enter, run a cond/act/succeed/fail/running leaf, exit
+    subtree,       // tick `node` with the recursive interpreter
+    set_status,    // status = `value`
+    jump_unless,   // if status != `value`, jump to `target`
+    invert,        // swap success and failure
+    touch_memory,  // mark `node`'s memory as used (retry)
+    repeat_check,  // if `node` already repeated `int_param` times, status = success and jump to `target`
+    repeat_step,   // account a finished repeat child
+    retry_step,    // account a finished retry child
+    mem_dispatch,  // jump to the stored child of `node` via `jump_tables[aux..]`, or to `target` (done)
+    mem_seq_step,  // after child `aux` of a mem-seq; jumps to `target` (exit) unless it succeeded
+    mem_sel_step,  // after child `aux` of a mem-sel; jumps to `target` (exit) unless it failed
+    mem_seq_done,
+    mem_sel_done,
+    guard_dispatch,  // skip the guards of `node` that cannot hold, via `guard_tables[aux]`
+};
+
+struct tick_instr {
+    tick_op op = tick_op::exit;
+    status value = status::failure;
+    node_id node = 0;
+    std::uint32_t target = 0;
+    std::uint32_t aux = 0;
+};
+
+// A `sel` whose first children are guards `(seq (cond NAME key operand) ...)` over one blackboard key,
+// with the same NAME throughout. When NAME is bound to a blackboard comparison (condition_test in
+// bt/registry.hpp), `guard_dispatch` finds the first guard that can hold with one lookup, replays the
+// guards before it as failed visits, and jumps to it; that guard is still evaluated for real. Either
+// lookup is left empty when the operands do not allow it.
+struct tick_guard_table {
+    std::string condition;
+    std::uint32_t key_index = 0;  // into definition::bb_keys
+    std::vector<node_id> guard_seqs;
+    std::vector<node_id> guard_conds;
+    // Code address of each guard, then of the first child after the guards, or of the `sel` exit when
+    // the guards are all of its children.
+    std::vector<std::uint32_t> child_pcs;
+    bool guards_are_all_children = false;
+    // bb_equals: index of the first guard per operand, for int, bool and text (string or symbol) operands.
+    bool has_equality_cases = false;
+    std::unordered_map<std::int64_t, std::uint32_t> int_cases;
+    std::array<std::uint32_t, 2> bool_cases{};
+    std::unordered_map<std::string, std::uint32_t> text_cases;
+    // bb_less: the numeric operands, when they never decrease.
+    std::vector<double> thresholds;
+};
+
+struct tick_program {
+    const definition* def = nullptr;
+    std::vector<tick_instr> code;
+    std::vector<std::uint32_t> jump_tables;
+    std::vector<tick_guard_table> guard_tables;
+    // Deepest nesting of open frames, so executors can size their frame stack once.
+    std::size_t max_depth = 0;
+    // The ahead-of-time translation registered for this program (bt/compiled_tree.hpp), if any; the
+    // runtime runs it instead of interpreting `code`.
+    std::shared_ptr<const compiled_tree> native;
+};
+
+// Also attaches the compiled_tree registered for the program's fingerprint.
+tick_program compile_tick_program(const definition& def);
+
 }  // namespace bt
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "bt/ast.hpp"
+#include "bt/scheduler.hpp"
+#include "bt/status.hpp"
+#include "muslisp/value.hpp"
+
+namespace bt {
+
+struct tick_context;
+
+// What a coroutine action sees of its node. Coroutine actions take it by value, so it lives in the
+// coroutine frame. tick() is the tick that is currently resuming the action; do not hold on to it
+// across a co_await.
+class action_context {
+public:
+    action_context(node_id node, std::span<const muslisp::value> args) noexcept : node_(node), args_(args) {}
+
+    [[nodiscard]] tick_context& tick() const noexcept { return *tick_; }
+    [[nodiscard]] node_id node() const noexcept { return node_; }
+    // The leaf's arguments; they stay valid for the life of the instance.
+    [[nodiscard]] std::span<const muslisp::value> args() const noexcept { return args_; }
+
+private:
+    friend class action_task;
+
+    tick_context* tick_ = nullptr;
+    node_id node_ = 0;
+    std::span<const muslisp::value> args_;
+};
+
+// Return type of a coroutine action, `action_task fn(action_context co)`, which finishes with
+// `co_return status::success` or `co_return status::failure`.
+//
+// The runtime keeps the task in the node's memory slot. It starts the coroutine on the node's first
+// tick, and on later ticks resumes it only once the awaitable it is suspended on reports ready; until
+// then the node returns running without entering the coroutine. The frame is destroyed when the
+// coroutine returns, or when the node is halted or its instance reset. Frames are recycled through a
+// per-thread pool, so restarting an action does not reach the heap in steady state.
+class action_task {
+public:
+    // Readiness check for the awaitable a suspended coroutine waits on.
+    using ready_fn = bool (*)(void* awaiter, tick_context& ctx);
+
+    class promise_type {
+    public:
+        // Finds the coroutine's action_context parameter (the frame's copy of it).
+        template <typename... Args>
+        explicit promise_type(Args&... args) noexcept {
+            (bind(args), ...);
+        }
+
+        static void* operator new(std::size_t size);
+        static void operator delete(void* frame, std::size_t size) noexcept;
+
+        action_task get_return_object() noexcept {
+            return action_task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        std::suspend_always final_suspend() const noexcept { return {}; }
+        void return_value(status st) noexcept { result_ = st; }
+        void unhandled_exception() noexcept { error_ = std::current_exception(); }
+
+        [[nodiscard]] action_context& context() const noexcept { return *context_; }
+        // Called by an awaitable's await_suspend; `awaiter` lives in the frame until it resumes.
+        void wait_on(void* awaiter, ready_fn ready) noexcept {
+            awaiter_ = awaiter;
+            ready_ = ready;
+        }
+
+    private:
+        friend class action_task;
+
+        template <typename T>
+        void bind(T& arg) noexcept {
+            if constexpr (std::is_same_v<std::remove_cv_t<T>, action_context>) {
+                context_ = const_cast<action_context*>(&arg);
+            }
+        }
+
+        action_context* context_ = nullptr;
+        void* awaiter_ = nullptr;
+        ready_fn ready_ = nullptr;
+        status result_ = status::failure;
+        std::exception_ptr error_;
+    };
+
+    action_task() noexcept = default;
+    action_task(action_task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    action_task& operator=(action_task&& other) noexcept;
+    ~action_task() { reset(); }
+
+    action_task(const action_task&) = delete;
+    action_task& operator=(const action_task&) = delete;
+
+    [[nodiscard]] explicit operator bool() const noexcept { return static_cast<bool>(handle_); }
+
+    // Resumes the coroutine if what it waits on is ready. Returns running while it stays suspended;
+    // otherwise destroys the frame and returns the co_return value, or rethrows what the body threw.
+    status tick(tick_context& ctx);
+    // Destroys the frame, if any.
+    void reset() noexcept;
+
+private:
+    explicit action_task(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+using coroutine_action_fn = std::function<action_task(action_context)>;
+using action_handle = std::coroutine_handle<action_task::promise_type>;
+
+// `co_await next_tick{}` suspends until the node's next tick.
+struct next_tick {
+    [[nodiscard]] bool await_ready() const noexcept { return false; }
+    void await_suspend(action_handle h) noexcept;
+    void await_resume() const noexcept {}
+};
+
+// `co_await sleep_for{d}` suspends until the tick clock (tick_context::now) has advanced by `d`.
+//
+// The awaitables below have constructors rather than being aggregates: GCC 12 destroys members of
+// an aggregate temporary in a co_await expression twice.
+struct sleep_for {
+    explicit sleep_for(std::chrono::steady_clock::duration d) noexcept : delay(d) {}
+
+    std::chrono::steady_clock::duration delay{};
+    std::chrono::steady_clock::time_point wake_at{};
+
+    [[nodiscard]] bool await_ready() const noexcept { return delay <= std::chrono::steady_clock::duration::zero(); }
+    void await_suspend(action_handle h) noexcept;
+    void await_resume() const noexcept {}
+};
+
+// `co_await wait_until{pred}` continues once `pred(tick_context&)` holds, checking it straight away
+// and then once per tick (typically a blackboard test).
+template <typename Pred>
+struct wait_until {
+    explicit wait_until(Pred p) : pred(std::move(p)) {}
+
+    Pred pred;
+
+    [[nodiscard]] bool await_ready() const noexcept { return false; }
+    bool await_suspend(action_handle h) {
+        if (pred(h.promise().context().tick())) {
+            return false;
+        }
+        h.promise().wait_on(this, [](void* self, tick_context& ctx) { return static_cast<wait_until*>(self)->pred(ctx); });
+        return true;
+    }
+    void await_resume() const noexcept {}
+};
+
+// What `co_await run_job{req}` returns.
+struct job_outcome {
+    job_status status = job_status::unknown;
+    job_result result;
+    std::string error_text;
+};
+
+// `co_await run_job{std::move(req)}` submits `req` to the tick's scheduler and suspends until the job
+// finishes. The job is tracked in the node's memory like any scheduler-backed leaf: halting the node
+// cancels it, and the node is woken through the instance's completion queue rather than by polling.
+// Build `req` as a named local; for the same GCC 12 reason, a job_request temporary nested in the
+// co_await expression can be destroyed twice.
+struct run_job {
+    explicit run_job(job_request req) noexcept : request(std::move(req)) {}
+
+    job_request request;
+    job_id id = 0;
+    node_id node = 0;
+    job_outcome outcome;
+
+    [[nodiscard]] bool await_ready() const noexcept { return false; }
+    bool await_suspend(action_handle h);
+    job_outcome await_resume() noexcept { return std::move(outcome); }
+    // Readiness check: true once the job has reached a terminal state (or was taken off the node).
+    bool poll(tick_context& ctx);
+};
+
+}  // namespace bt
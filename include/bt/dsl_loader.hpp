@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "bt/ast.hpp"
+
+namespace bt {
+
+// One file of compile_dsl_files: its compiled definition, or the reason it failed.
+struct dsl_file_result {
+    std::string path;
+    // event_log::hash64_hex of the file text and its size, for runtime_host::find_dsl_definition.
+    std::string source_hash;
+    std::size_t source_size = 0;
+    std::optional<definition> def;
+    std::string error;
+};
+
+// Reads, parses and compiles independent DSL files, each on up to `workers` threads (0 picks the
+// hardware concurrency). Every worker parses into a heap of its own, so the calling thread's heap is
+// never touched and the definitions hold no Lisp values. Results are in `paths` order; a file that
+// cannot be read, parsed or compiled leaves `def` empty and says why in `error`.
+[[nodiscard]] std::vector<dsl_file_result> compile_dsl_files(std::span<const std::string> paths, std::size_t workers = 0);
+
+}  // namespace bt
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace bt {
+
+// mbt.evt.v1-bin: a compact, lossless encoding of canonical mbt.evt.v1 JSONL.
+//
+// A stream is the header "MBTB" + format version byte, followed by records:
+//   0x01 string   varint length, bytes. Appends to the stream's string table (ids count from 0).
+//   0x02 raw line varint length, bytes. A line kept verbatim (for input that is not canonical).
+//   0x1X event    X bit 0: has tick, bit 1: templated payload. Then varint ids of the contract
+//                 version, type and run id strings; zigzag varint deltas of unix_ms, seq and (if
+//                 present) tick against the previous event; then the payload. A templated payload
+//                 is the string id of the payload text with every number outside a string replaced
+//                 by 0x01, followed by one token per number: varint (zigzag << 1) for integers,
+//                 varint (length << 1 | 1) plus the literal text otherwise. Other payloads are a
+//                 varint length and the JSON bytes.
+// Decoding rebuilds each line with event_log::append_event_line, so the JSONL is byte-identical.
+// tools/event_log_binary.py reads and writes the same format.
+class event_binary_encoder {
+public:
+    static constexpr std::string_view k_magic = "MBTB";
+    static constexpr std::uint8_t k_format_version = 1;
+    // Payload templates stop being added once the string table holds this many entries.
+    static constexpr std::size_t k_max_strings = 8192;
+
+    // Appends the stream header and forgets all state from a previous stream.
+    void begin_stream(std::string& out);
+
+    void encode(std::string& out,
+                std::string_view contract_version,
+                std::string_view type,
+                std::string_view run_id,
+                std::int64_t unix_ms,
+                std::uint64_t seq,
+                std::optional<std::uint64_t> tick,
+                std::string_view data_json);
+
+private:
+    struct text_hash {
+        using is_transparent = void;
+        [[nodiscard]] std::size_t operator()(std::string_view text) const noexcept {
+            return std::hash<std::string_view>{}(text);
+        }
+    };
+
+    std::uint64_t intern(std::string& out, std::string_view text);
+    // Splits `data_json` into template_ and number_tokens_; false if it cannot be templated.
+    [[nodiscard]] bool split_payload(std::string_view data_json);
+
+    std::unordered_map<std::string, std::uint64_t, text_hash, std::equal_to<>> strings_;
+    std::string template_;
+    std::string number_tokens_;
+    std::int64_t prev_unix_ms_ = 0;
+    std::uint64_t prev_seq_ = 0;
+    std::uint64_t prev_tick_ = 0;
+};
+
+// Transcodes a whole mbt.evt.v1-bin stream to JSONL (each line '\n'-terminated). Throws
+// std::runtime_error if the stream is malformed or truncated.
+[[nodiscard]] std::string transcode_event_binary_to_jsonl(std::string_view bytes);
+
+}  // namespace bt
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace bt {
+
+// The compact-ids profile of mbt.evt.v1 (event_log::set_compact_ids). Lines keep the canonical
+// envelope and stay valid against the schema; only payload strings repeated on every tick become small
+// integers. node_exit and node_status carry `status_id`, an index into k_compact_status_names, and
+// bb_write and bb_delete carry `key_id` for keys a `bt_def` declared earlier in the run, in its
+// `string_table`: key i of `keys` has id `key_base + i`.
+inline constexpr std::string_view k_compact_ids_profile = "compact-ids.v1";
+inline constexpr std::string_view k_compact_status_names[] = {"success", "failure", "running"};
+
+// The status name `status_id` stands for, or nullopt when it is out of range.
+[[nodiscard]] std::optional<std::string_view> compact_status_name(std::int64_t status_id) noexcept;
+
+// Turns compact-ids lines back into canonical ones. Feed it a log's lines in order: it learns key ids
+// from each bt_def's string_table and forgets them at run_start. Canonical lines, and ids it does not
+// know, pass through unchanged.
+class compact_event_expander {
+public:
+    // Rewrites `line` in place; returns whether it changed.
+    bool expand(std::string& line);
+    void reset() noexcept { keys_.clear(); }
+
+private:
+    std::unordered_map<std::uint64_t, std::string> keys_;
+};
+
+}  // namespace bt
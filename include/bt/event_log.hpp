@@ -1,22 +1,82 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <fstream>
 #include <functional>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include "bt/ast.hpp"
+#include "bt/async_file_sink.hpp"
+#include "bt/event_binary.hpp"
+#include "bt/json_writer.hpp"
+#include "bt/net_event_sink.hpp"
 
 namespace bt {
 
+class loop_pacer;
+
+// Coarse groups of event types that an emission policy switches on and off together.
+enum class event_family : std::uint8_t {
+    lifecycle,   // run_start/run_end, episode_*, bt_def, tick_begin/tick_end, gc_begin/gc_end
+    node,        // node_enter, node_exit, node_status
+    blackboard,  // bb_write, bb_delete, bb_snapshot, bb_delta
+    async,       // planner, capability, VLA, scheduler and async job events
+    outcome,     // runtime_outcome.v1 summaries that are not alerts
+    alert,       // error, budget_warning, deadline_exceeded, tick_audit, timeouts, misses and fallbacks
+    other,
+};
+inline constexpr std::size_t k_event_family_count = 7;
+
+// Decides which events are worth building. Callers ask event_log::wants() before serialising a
+// payload, so a suppressed event costs one atomic load and a few branches.
+struct emission_policy {
+    static constexpr std::uint32_t k_all_families = (1u << k_event_family_count) - 1u;
+
+    [[nodiscard]] static constexpr std::uint32_t bit(event_family family) noexcept {
+        return 1u << static_cast<unsigned>(family);
+    }
+
+    std::uint32_t family_mask = k_all_families;
+    // Node events are kept for ticks whose index is a multiple of this (1 keeps every tick). Whole
+    // ticks are sampled so that node_enter/node_exit pairs stay balanced.
+    std::uint32_t node_sample_every = 1;
+    // Alerts, and node_exit/node_status events for failing nodes, bypass the mask and sampling.
+    bool always_emit_failures = true;
+};
+
 struct event_log_stats {
     std::uint64_t event_count = 0;
     std::uint64_t byte_count = 0;
+    // Lines the asynchronous file sink could not queue or write. Counted whether or not capture
+    // stats are enabled.
+    std::uint64_t dropped_line_count = 0;
+};
+
+// Sidecar index and segment rotation for the synchronous JSONL file sink.
+struct event_file_layout {
+    // Every `index_every` events of a segment, a {seq, offset, tick} entry goes to its `<segment>.idx`
+    // sidecar; `tick` is the newest tick written so far. Closing a segment appends a record with its
+    // per-type event counts. 0 writes no sidecar.
+    std::uint64_t index_every = 0;
+    // A new segment starts before a line that would take the current one past `rotate_bytes`, or once
+    // it has been open for `rotate_after`; 0 disables each limit. Segment k > 0 of `run.jsonl` is
+    // `run.k.jsonl` and begins with a copy of the run's `run_start` line.
+    std::uint64_t rotate_bytes = 0;
+    std::chrono::milliseconds rotate_after{0};
+
+    [[nodiscard]] bool active() const noexcept {
+        return index_every != 0 || rotate_bytes != 0 || rotate_after.count() != 0;
+    }
 };
 
 class event_log {
@@ -25,29 +85,99 @@ public:
     using allocation_whitelist_hook = void (*)() noexcept;
 
     explicit event_log(std::size_t ring_capacity = 4096);
+    ~event_log();
 
     void set_enabled(bool enabled) noexcept;
     [[nodiscard]] bool enabled() const noexcept;
 
+    // Throws std::invalid_argument if node_sample_every is 0.
+    void set_emission_policy(const emission_policy& policy);
+    [[nodiscard]] emission_policy get_emission_policy() const noexcept;
+    // Whether an event of `family` on `tick` passes the log's enabled flag and emission policy.
+    // emit() itself does not filter; event producers check this before building the payload.
+    [[nodiscard]] bool wants(event_family family,
+                             std::optional<std::uint64_t> tick = std::nullopt,
+                             bool failure = false) const noexcept {
+        const std::uint64_t bits = policy_bits_.load(std::memory_order_relaxed);
+        if ((bits & k_policy_enabled) == 0) {
+            return false;
+        }
+        if ((bits & k_policy_always_failures) != 0 && (family == event_family::alert || (failure && family == event_family::node))) {
+            return true;
+        }
+        if ((bits & emission_policy::bit(family)) == 0) {
+            return false;
+        }
+        if (family == event_family::node) {
+            const auto every = static_cast<std::uint32_t>(bits >> 32);
+            return every <= 1 || (tick.has_value() && *tick % every == 0);
+        }
+        return true;
+    }
+    [[nodiscard]] static event_family family_of(std::string_view type) noexcept;
+    // Accepts family names with or without a leading ':' (for Lisp keywords).
+    [[nodiscard]] static bool parse_family(std::string_view text, event_family& out) noexcept;
+
     void set_ring_capacity(std::size_t capacity);
     [[nodiscard]] std::size_t ring_capacity() const noexcept;
+    // Bytes of the retained event lines and the ring that holds them.
+    [[nodiscard]] std::size_t ring_memory_bytes() const;
 
     void set_path(std::string path);
     [[nodiscard]] const std::string& path() const noexcept;
 
-    void set_file_enabled(bool enabled) noexcept;
+    void set_file_enabled(bool enabled);
     [[nodiscard]] bool file_enabled() const noexcept;
+    // Moves file output onto an async_file_sink: emit() only queues the line, and a writer thread
+    // appends queued lines to the file. Lines that do not fit in the queue are dropped and reported
+    // through capture_stats(). Flush settings do not apply while this is on; every batch the writer
+    // takes is handed to the OS immediately.
+    void set_file_async(bool enabled, std::size_t queue_lines = async_file_sink::k_default_queue_lines);
+    [[nodiscard]] bool file_async() const noexcept;
+    // Applies from the next event; the current segment is closed and reopened for appending. Throws
+    // std::invalid_argument if the layout is active while the asynchronous sink is on, and
+    // set_file_async throws the same for an active layout.
+    void set_file_layout(const event_file_layout& layout);
+    [[nodiscard]] event_file_layout file_layout() const;
+    // The segment the synchronous sink is writing, or empty while no file is open.
+    [[nodiscard]] std::string file_segment_path() const;
+    // Blocks until the asynchronous sink has written every line emitted so far; no-op otherwise.
+    void drain_file_async();
+    // Also writes every event to `path` in the compact mbt.evt.v1-bin encoding (bt/event_binary.hpp),
+    // independently of the JSONL sinks and flushed on the same schedule as the synchronous file sink.
+    // The file is truncated and starts a new stream; an empty path closes the binary sink.
+    void set_binary_path(std::string path);
+    [[nodiscard]] std::string binary_path() const;
+    // Also streams every event line to a remote collector through a net_event_sink, independently of
+    // the file sinks; alerts are exempt from its sampling. emit() only queues the line. Replaces any
+    // previous network sink, which is given its reconnect interval to deliver what it holds. Throws
+    // std::invalid_argument for a malformed endpoint or option.
+    void set_net_sink(const net_sink_options& options);
+    void close_net_sink();
+    // Counters of the current network sink; nullopt while there is none.
+    [[nodiscard]] std::optional<net_sink_stats> net_stats() const;
+    // Waits up to `timeout` for the network sink to send or drop every line emitted so far. Returns
+    // false on timeout, true when done or when there is no network sink.
+    bool flush_net_sink(std::chrono::milliseconds timeout);
 
     void set_flush_on_tick_end(bool enabled) noexcept;
     [[nodiscard]] bool flush_on_tick_end() const noexcept;
     void set_flush_each_message(bool enabled) noexcept;
     [[nodiscard]] bool flush_each_message() const noexcept;
+    // While a batch is open, `tick_end` events no longer flush the file stream; closing the outermost
+    // batch flushes once. Flushing on every message is unaffected.
+    void begin_batch() noexcept;
+    void end_batch();
     void set_tick_audit_enabled(bool enabled) noexcept;
     [[nodiscard]] bool tick_audit_enabled() const noexcept;
     void set_tick_audit_warmup_complete(bool complete) noexcept;
     [[nodiscard]] bool tick_audit_warmup_complete() const noexcept;
     void set_tick_audit_strict_allocations(bool strict) noexcept;
     [[nodiscard]] bool tick_audit_strict_allocations() const noexcept;
+    // While set, tick_audit records carry the pacer's counters as `loop_pacing`. The pacer must
+    // outlive the registration; a host loop sets it for the duration of a run.
+    void set_audit_loop_pacer(const loop_pacer* pacer) noexcept;
+    [[nodiscard]] const loop_pacer* audit_loop_pacer() const noexcept;
 
     void set_run_id(std::string run_id);
     [[nodiscard]] std::string run_id() const;
@@ -59,9 +189,36 @@ public:
     void set_host_info(std::string name, std::string version, std::string platform);
 
     void ensure_run_started(std::string_view tree_hash = "", std::string_view capabilities_json = "{\"reset\":true}");
+    // A `bt_def` payload depends only on the (immutable) definition, so hosts that instantiate one
+    // definition many times can build it once with describe_bt_def and emit the prepared copy.
+    struct bt_def_event {
+        std::string tree_hash;
+        std::string data_json;
+        // Declared in the payload's `string_table` when compact ids are on.
+        std::vector<std::string> bb_keys;
+    };
+    [[nodiscard]] static bt_def_event describe_bt_def(const definition& def);
     void emit_bt_def(const definition& def);
+    void emit_bt_def(const bt_def_event& event);
 
     std::uint64_t emit(std::string_view type, std::optional<std::uint64_t> tick, std::string_view data_json);
+    // Structured emit: fill the calling thread's reusable writer from payload_writer() and pass it
+    // here. The writer is cleared by the next payload_writer() call on the thread, so emit before
+    // building another payload. The event line goes straight into a ring slot or the thread's line
+    // buffer; in steady state neither path allocates.
+    [[nodiscard]] static json_writer& payload_writer();
+    std::uint64_t emit(std::string_view type, std::optional<std::uint64_t> tick, const json_writer& data);
+
+    // A shard stands in for `canonical` on a worker thread: it reports the canonical log's settings,
+    // treats the run as started, and emit() only queues the event (returning 0) for the owner to
+    // replay into the canonical log, in order, with replay_into().
+    struct deferred_event {
+        std::string type;
+        std::optional<std::uint64_t> tick;
+        std::string data_json;
+    };
+    void configure_shard(const event_log& canonical);
+    void replay_into(event_log& canonical);
 
     void set_line_listener(line_listener listener);
     void clear_line_listener() noexcept;
@@ -93,34 +250,99 @@ public:
                                                           std::optional<std::uint64_t> tick,
                                                           std::string_view data_json);
 
+    // Appends a canonical line that carries `contract_version` instead of this build's version; used to
+    // reproduce lines recorded by other builds.
+    static void append_event_line(std::string& out,
+                                  std::string_view contract_version,
+                                  std::string_view type,
+                                  std::string_view run_id,
+                                  std::int64_t unix_ms,
+                                  std::uint64_t seq,
+                                  std::optional<std::uint64_t> tick,
+                                  std::string_view data_json);
+
     [[nodiscard]] std::vector<std::string> snapshot(std::size_t max_count = 0) const;
     void clear_ring();
 
     void request_snapshot_bb(bool full = false) noexcept;
     [[nodiscard]] bool consume_snapshot_bb_request(bool* full = nullptr) noexcept;
 
+    // When `keyframe_every` is positive, each tick begins with a `bb_delta` event listing the keys
+    // written since the previous one, and every `keyframe_every` ticks with a full `bb_snapshot`
+    // keyframe instead. 0 turns deltas off.
+    void set_bb_delta_keyframe_interval(std::uint64_t keyframe_every) noexcept;
+    [[nodiscard]] std::uint64_t bb_delta_keyframe_interval() const noexcept {
+        return bb_keyframe_every_.load(std::memory_order_relaxed);
+    }
+    // Changes whenever replay would need a fresh keyframe: a new run or a new interval.
+    [[nodiscard]] std::uint64_t bb_keyframe_epoch() const noexcept {
+        return bb_keyframe_epoch_.load(std::memory_order_relaxed);
+    }
+
+    // Compact ids (profile compact-ids.v1, bt/event_compact.hpp): node_exit and node_status carry
+    // `status_id` instead of `status`, and bb_write and bb_delete of a key some `bt_def` of this run
+    // declared carry `key_id` instead of `key`. Each bt_def declares the keys it names that have no id
+    // yet in a `string_table`. Off by default; compact_event_expander turns lines back into canonical ones.
+    void set_compact_ids(bool enabled) noexcept;
+    [[nodiscard]] bool compact_ids() const noexcept { return compact_ids_.load(std::memory_order_relaxed); }
+    // The id a bt_def of this run declared for `key`, or nullopt.
+    [[nodiscard]] std::optional<std::uint32_t> compact_key_id(std::string_view key) const;
+
     [[nodiscard]] static std::string json_escape(std::string_view text);
     [[nodiscard]] static std::string hash64_hex(std::string_view text);
 
 private:
-    void append_ring_line(const std::string& line);
-    void append_file_line(const std::string& line, bool flush_now);
+    // Caller holds mutex_.
+    [[nodiscard]] std::string& claim_ring_slot();
+    // Caller holds mutex_. Replaces the asynchronous sink to match file_async_, file_enabled_ and path_.
+    void restart_async_sink_locked();
+    void append_file_line(std::string_view type,
+                          std::uint64_t seq,
+                          std::optional<std::uint64_t> tick,
+                          std::string_view line,
+                          bool flush_now);
+    // Caller holds file_mutex_. Opens segment `index` of `base`, appending unless `truncate`; returns
+    // false (with no file open) if it cannot be opened.
+    bool open_segment_locked(const std::string& base, std::uint64_t index, bool truncate);
+    [[nodiscard]] bool should_rotate_locked(std::size_t line_size) const noexcept;
+    bool write_file_line_locked(std::string_view type,
+                                std::uint64_t seq,
+                                std::optional<std::uint64_t> tick,
+                                std::string_view line);
+    // Caller holds file_mutex_. Flushes and closes the segment and its sidecar, which gets a counts record.
+    void close_file_locked();
     [[nodiscard]] static std::string node_kind_name(node_kind kind);
 
+    // Caller holds mutex_.
+    void publish_policy_locked() noexcept;
+
+    static constexpr std::uint64_t k_policy_enabled = 1ull << 16;
+    static constexpr std::uint64_t k_policy_always_failures = 1ull << 17;
+
     mutable std::mutex mutex_;
     mutable std::mutex file_mutex_;
 
     bool enabled_ = true;
+    emission_policy policy_{};
+    // enabled_ and policy_ packed for wants(): family bits, k_policy_* flags, node_sample_every << 32.
+    std::atomic<std::uint64_t> policy_bits_{0};
     bool file_enabled_ = false;
     bool flush_on_tick_end_ = true;
     bool flush_each_message_ = false;
     bool tick_audit_enabled_ = false;
     bool tick_audit_warmup_complete_ = true;
     bool tick_audit_strict_allocations_ = false;
+    const loop_pacer* audit_loop_pacer_ = nullptr;
     bool run_started_ = false;
+    std::size_t batch_depth_ = 0;
+    bool shard_ = false;
+    std::vector<deferred_event> deferred_;
+    std::size_t deferred_size_ = 0;
 
     std::size_t ring_capacity_ = 4096;
+    // Circular once full: ring_start_ indexes the oldest line.
     std::vector<std::string> ring_;
+    std::size_t ring_start_ = 0;
 
     std::string path_ = "logs/run.jsonl";
     std::string open_path_{};
@@ -133,7 +355,8 @@ private:
     std::string host_version_ = "dev";
     std::string host_platform_ = "unknown";
 
-    line_listener line_listener_{};
+    // Shared so emit() can hold the listener past the lock without copying the std::function.
+    std::shared_ptr<const line_listener> line_listener_;
 
     bool deterministic_time_enabled_ = false;
     std::int64_t deterministic_unix_ms_ = 0;
@@ -142,11 +365,68 @@ private:
     std::uint64_t captured_event_count_ = 0;
     std::uint64_t captured_byte_count_ = 0;
     std::ofstream file_stream_{};
+    // Segment state is guarded by file_mutex_. The counters survive reopening the same segment and
+    // restart with each new one; the last tick and the run_start line carry across rotations.
+    event_file_layout file_layout_{};
+    std::ofstream index_stream_{};
+    std::string segment_base_{};
+    std::string segment_path_{};
+    std::uint64_t segment_index_ = 0;
+    std::uint64_t segment_bytes_ = 0;
+    std::uint64_t segment_events_ = 0;
+    std::chrono::steady_clock::time_point segment_opened_{};
+    std::map<std::string, std::uint64_t, std::less<>> segment_counts_;
+    std::optional<std::uint64_t> last_file_tick_;
+    std::string run_start_line_{};
+    std::uint64_t run_start_seq_ = 0;
+    bool file_async_ = false;
+    std::size_t async_queue_lines_ = async_file_sink::k_default_queue_lines;
+    std::atomic<std::uint64_t> async_dropped_lines_{0};
+    std::unique_ptr<async_file_sink> async_sink_;
+    // Shared so flush_net_sink() can wait on the sink without holding mutex_.
+    std::shared_ptr<net_event_sink> net_sink_;
+    // Binary sink state is guarded by mutex_, so events are encoded in seq order.
+    std::string binary_path_{};
+    std::ofstream binary_stream_{};
+    event_binary_encoder binary_encoder_{};
+    std::string binary_buffer_{};
     allocation_whitelist_hook allocation_whitelist_enter_ = nullptr;
     allocation_whitelist_hook allocation_whitelist_leave_ = nullptr;
 
     bool snapshot_bb_requested_ = false;
     bool snapshot_bb_full_ = false;
+    std::atomic<std::uint64_t> bb_keyframe_every_{0};
+    std::atomic<std::uint64_t> bb_keyframe_epoch_{1};
+
+    struct compact_key {
+        std::uint32_t id = 0;
+        // Set once the bt_def declaring the key is in the log, so no line uses the id before that.
+        bool declared = false;
+    };
+    struct compact_key_hash {
+        using is_transparent = void;
+        [[nodiscard]] std::size_t operator()(std::string_view text) const noexcept {
+            return std::hash<std::string_view>{}(text);
+        }
+    };
+    // Run-wide key ids, shared with shards so their lines use the canonical log's ids.
+    struct compact_key_table {
+        std::mutex mutex;
+        std::unordered_map<std::string, compact_key, compact_key_hash, std::equal_to<>> keys;
+    };
+    std::atomic<bool> compact_ids_{false};
+    std::shared_ptr<compact_key_table> compact_keys_ = std::make_shared<compact_key_table>();
+};
+
+class event_log_batch_scope final {
+public:
+    explicit event_log_batch_scope(event_log* events) noexcept;
+    event_log_batch_scope(const event_log_batch_scope&) = delete;
+    event_log_batch_scope& operator=(const event_log_batch_scope&) = delete;
+    ~event_log_batch_scope();
+
+private:
+    event_log* events_ = nullptr;
 };
 
 class event_log_allocation_scope final {
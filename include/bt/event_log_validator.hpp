@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace bt {
+
+// The subset of JSON Schema (draft 2020-12) that schemas/event_log uses: type, const, enum, minLength,
+// minimum, exclusiveMinimum, maximum, exclusiveMaximum, required, properties, additionalProperties,
+// items, allOf and if/then/else. Loading a schema with any other validation keyword throws, so the
+// native checker never silently accepts what tools/validate_log.py would reject.
+class event_schema {
+public:
+    // Throws std::runtime_error for unreadable files, invalid JSON and unsupported keywords.
+    [[nodiscard]] static event_schema load(const std::string& path);
+    [[nodiscard]] static event_schema parse(std::string_view json_text);
+
+    struct node;
+    struct literal;
+
+    event_schema();
+    event_schema(event_schema&&) noexcept;
+    event_schema& operator=(event_schema&&) noexcept;
+    ~event_schema();
+
+    [[nodiscard]] const std::vector<node>& nodes() const noexcept { return nodes_; }
+
+private:
+    // nodes_[0] is the root schema.
+    std::vector<node> nodes_;
+};
+
+struct event_log_violation {
+    std::string code;
+    // "error" fails the log; "info" is reported only.
+    std::string severity;
+    std::string message;
+    std::size_t line_no = 0;
+    std::optional<std::int64_t> seq;
+    std::optional<std::int64_t> tick;
+};
+
+struct event_log_check_options {
+    // Per-line schema validation; null skips it.
+    const event_schema* schema = nullptr;
+    // The cross-event checks of tools/trace_validator.py (`check` mode).
+    bool check_trace = true;
+    bool tolerate_incomplete_tail = false;
+    // Lines are parsed and schema-checked in parallel over chunks of about `chunk_bytes`; the
+    // cross-event checks then run over each chunk in order. 0 threads uses every hardware thread.
+    std::size_t threads = 0;
+    std::size_t chunk_bytes = std::size_t{16} << 20;
+};
+
+struct event_log_check_report {
+    bool passed = true;
+    bool trace_truncated = false;
+    std::uint64_t total_events = 0;
+    std::uint64_t completed_ticks = 0;
+    std::uint64_t distinct_nodes = 0;
+    std::uint64_t async_jobs = 0;
+    std::optional<std::int64_t> first_seq;
+    std::optional<std::int64_t> last_seq;
+    // Schema and JSON errors first, in line order, then cross-event violations in the order
+    // tools/trace_validator.py reports them.
+    std::vector<event_log_violation> violations;
+
+    [[nodiscard]] std::size_t error_count() const noexcept;
+};
+
+// Streams an mbt.evt.v1 JSONL log. Blank lines are skipped but counted for line numbers. Lines that
+// are not JSON become `invalid_json` errors (the Python trace checker stops at the first one instead).
+[[nodiscard]] event_log_check_report check_event_log(std::istream& in, const event_log_check_options& options);
+// Throws std::runtime_error if the file cannot be opened.
+[[nodiscard]] event_log_check_report check_event_log_file(const std::string& path, const event_log_check_options& options);
+
+}  // namespace bt
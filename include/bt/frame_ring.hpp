@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bt {
+
+// Describes one frame stored in a frame_ring slot.
+struct frame_ring_meta {
+    std::int64_t width = 0;
+    std::int64_t height = 0;
+    std::int64_t channels = 0;
+    // At most 15 bytes are stored, for example "rgb8" or "image/jpeg".
+    std::string encoding;
+    std::int64_t timestamp_ms = 0;
+};
+
+// Shared-memory ring of camera frames or other observation payloads. A co-located model service can
+// map it by name and read frames in place, instead of receiving them over HTTP.
+//
+// The ring is one POSIX shared-memory object, "/<name>", laid out as a 64-byte header followed by
+// slot_count slots of (128-byte slot header + slot_bytes payload rounded up to 64 bytes). Integers
+// are in host byte order:
+//   header: char magic[8] = "MBTFRAME", u32 version = 1, u32 slot_count, u64 slot_bytes,
+//           u64 next_sequence (atomic; the sequence the next publish will use)
+//   slot:   u64 lock (seqlock: odd while the slot is being written), u64 sequence, u64 size,
+//           i64 width, i64 height, i64 channels, i64 timestamp_ms, char encoding[16]
+// Frame n lives in slot n % slot_count. A reader copies the slot, then checks that lock was even
+// and unchanged and that sequence is still n; otherwise the frame was overwritten.
+//
+// One process publishes; any number may read. Frame refs have the form "shm://<name>/<sequence>".
+class frame_ring {
+public:
+    // Creates (or replaces) the shared-memory object and unlinks it again on destruction. Throws
+    // std::runtime_error when shared memory is unavailable or the sizes are zero.
+    [[nodiscard]] static std::shared_ptr<frame_ring> create(std::string name,
+                                                            std::size_t slot_count,
+                                                            std::size_t slot_bytes);
+    // Maps an existing ring for reading, as a model service would. Throws std::runtime_error when the
+    // object does not exist or is not a frame ring.
+    [[nodiscard]] static std::shared_ptr<frame_ring> open(std::string name);
+
+    ~frame_ring();
+    frame_ring(const frame_ring&) = delete;
+    frame_ring& operator=(const frame_ring&) = delete;
+
+    // Copies `bytes` into the next slot and returns its sequence number. Throws std::length_error
+    // when the payload is larger than slot_bytes, or std::logic_error on a ring opened with open().
+    std::uint64_t publish(std::span<const std::byte> bytes, const frame_ring_meta& meta);
+    // Copies frame `sequence` into `out`. Returns false when it has not been published yet or has
+    // already been overwritten.
+    bool read(std::uint64_t sequence, std::vector<std::byte>& out, frame_ring_meta* meta = nullptr) const;
+
+    [[nodiscard]] std::string ref(std::uint64_t sequence) const;
+    [[nodiscard]] const std::string& name() const noexcept { return name_; }
+    [[nodiscard]] std::size_t slot_count() const noexcept { return slot_count_; }
+    [[nodiscard]] std::size_t slot_bytes() const noexcept { return slot_bytes_; }
+    [[nodiscard]] std::uint64_t next_sequence() const noexcept;
+
+private:
+    frame_ring(std::string name, void* base, std::size_t mapped_bytes, bool owner);
+
+    [[nodiscard]] std::byte* slot(std::uint64_t sequence) const noexcept;
+
+    std::string name_;
+    void* base_ = nullptr;
+    std::size_t mapped_bytes_ = 0;
+    std::size_t slot_count_ = 0;
+    std::size_t slot_bytes_ = 0;
+    std::size_t slot_stride_ = 0;
+    bool owner_ = false;
+};
+
+// Splits "shm://<name>/<sequence>"; nullopt for any other ref.
+[[nodiscard]] std::optional<std::pair<std::string, std::uint64_t>> parse_frame_ring_ref(const std::string& ref);
+
+}  // namespace bt
@@ -1,8 +1,12 @@
 #pragma once
 
-#include <any>
+#include <array>
 #include <chrono>
 #include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -10,24 +14,38 @@
 
 #include "bt/ast.hpp"
 #include "bt/blackboard.hpp"
+#include "bt/compiler.hpp"
 #include "bt/event_log.hpp"
 #include "bt/logging.hpp"
+#include "bt/node_payload.hpp"
 #include "bt/profile.hpp"
+#include "bt/registry.hpp"
 #include "bt/scheduler.hpp"
 #include "bt/status.hpp"
+#include "bt/tick_arena.hpp"
+#include "bt/tick_wake.hpp"
 #include "bt/trace.hpp"
+#include "bt/vla.hpp"
+#include "muslisp/value.hpp"
 
 namespace bt {
 
 struct tick_context;
 class planner_service;
 class vla_service;
+class log_replay;
 
 struct node_memory {
     std::int64_t i0 = 0;
     std::int64_t i1 = 0;
     bool b0 = false;
-    std::any payload;
+    // Set at tick start when the scheduler job this leaf watches (see tick_context::watch_job)
+    // started or finished since the leaf last looked; the leaf clears it once it has polled.
+    bool job_notified = false;
+    // Leaf-defined state that does not fit the scalar fields; see node_payload.
+    node_payload payload;
+    // Suspended coroutine of a coroutine action (see registry::register_coroutine_action).
+    action_task task;
 };
 
 struct observability {
@@ -40,6 +58,9 @@ class clock_interface {
 public:
     virtual ~clock_interface() = default;
     virtual std::chrono::steady_clock::time_point now() const = 0;
+    // True for clocks that follow a simulation rather than wall time (see bt::sim_clock). Leaves
+    // that would wait in wall time wait on now() instead.
+    [[nodiscard]] virtual bool simulated() const noexcept { return false; }
 };
 
 class robot_interface {
@@ -61,15 +82,182 @@ struct services {
     robot_interface* robot = nullptr;
     planner_service* planner = nullptr;
     vla_service* vla = nullptr;
+    // Set while bt::log_replay re-drives a recording: VLA and planner leaves take their results from
+    // it instead of the services above.
+    log_replay* replay = nullptr;
+};
+
+// Leaf arguments of one definition as Lisp values, rooted as a single GC root range for the table's
+// lifetime. Definitions are immutable once stored, so every instance of one definition can share one
+// table instead of allocating its own copy of every argument.
+struct leaf_arg_table {
+    explicit leaf_arg_table(const definition& def);
+    ~leaf_arg_table();
+
+    leaf_arg_table(const leaf_arg_table&) = delete;
+    leaf_arg_table& operator=(const leaf_arg_table&) = delete;
+
+    [[nodiscard]] std::span<const muslisp::value> args(node_id id) const noexcept;
+
+    const definition* def = nullptr;
+    std::vector<muslisp::value> values;
+    std::vector<std::uint32_t> offsets;
+};
+
+// Where a native-bound leaf's decoded arguments sit in `leaf_link_table::native_args`. `valid` is false
+// when the leaf's arguments do not match the callback's signature.
+struct native_arg_range {
+    std::uint32_t offset = 0;
+    std::uint32_t count = 0;
+    bool valid = false;
+};
+
+// Callback indices of a definition's cond/act leaves in one registry generation, plus the decoded
+// arguments of native-bound leaves. Nothing in it is per-instance, so instances of one definition
+// linked against the same generation share a table.
+struct leaf_link_table {
+    const definition* def = nullptr;
+    std::uint64_t generation = 0;
+    std::vector<std::uint32_t> bindings;
+    std::vector<native_arg> native_args;
+    std::vector<native_arg_range> native_arg_ranges;
+    // Every cond/act leaf is a native callback whose arguments decoded, and no node kind runs Lisp code
+    // (plan-action and the vla-* nodes do). Only such definitions tick on tick_worker_pool workers.
+    bool native_only = true;
+};
+
+// Incremental-tick memo for a node whose whole subtree is pure: declared-read conditions, constant
+// leaves, and memoryless composites over them. `reads` is the subtree's blackboard read set.
+struct node_memo {
+    std::uint32_t reads_offset = 0;
+    std::uint32_t reads_count = 0;
+    std::uint64_t evaluated_at = 0;
+    status result = status::failure;
+    bool pure = false;
+    bool valid = false;
+};
+
+// One open node visit: what the runtime restores and measures when the node returns.
+struct tick_frame {
+    node_id node = 0;
+    node_id prev_node = 0;
+    // Only set when `timed`.
+    std::chrono::steady_clock::time_point started_at{};
+    // Heap allocation totals and the tick's attributed allocations when the visit began.
+    std::size_t heap_objects_at = 0;
+    std::size_t heap_bytes_at = 0;
+    std::uint64_t attributed_objects_at = 0;
+    std::uint64_t attributed_bytes_at = 0;
+    bool track_node_path = false;
+    bool timed = false;
+};
+
+// One visited node in the tick's node path arena, linked to the record of the node that visited it.
+struct node_path_record {
+    static constexpr std::uint32_t k_none = 0xffffffffu;
+
+    node_id node = 0;
+    std::uint32_t parent = k_none;
+};
+
+// A node that allocated on the GC heap during the current tick, for the tick audit record.
+struct node_alloc_record {
+    node_id node = 0;
+    std::uint64_t objects = 0;
+    std::uint64_t bytes = 0;
 };
 
 struct instance {
-    explicit instance(const definition* definition_ptr = nullptr, std::size_t trace_capacity = 4096);
+    static constexpr std::size_t k_default_trace_capacity = 4096;
+
+    explicit instance(const definition* definition_ptr = nullptr,
+                      std::size_t trace_capacity = k_default_trace_capacity);
+    // Reuses `shared_leaf_args` when it was built for `definition_ptr`.
+    instance(const definition* definition_ptr,
+             std::shared_ptr<const leaf_arg_table> shared_leaf_args,
+             std::size_t trace_capacity = k_default_trace_capacity);
+    ~instance();
+
+    instance(const instance&) = delete;
+    instance& operator=(const instance&) = delete;
+
+    // Per-node tick state is indexed directly by node_id; the slabs are sized to the definition and
+    // leaf arguments are materialised (and GC-rooted) once per definition rather than per tick.
+    void prepare_node_slots();
+    // Zeroes node_stats, skipping nodes that have recorded nothing.
+    void clear_node_stats() noexcept;
+    [[nodiscard]] std::span<const muslisp::value> leaf_args(node_id id) const noexcept;
+    // Maps an index into `definition::bb_keys` to this instance's blackboard slot.
+    [[nodiscard]] bb_slot bb_key_slot(bb_slot def_key) const noexcept;
+    // Resolves every cond/act leaf name to its callback index in `reg` and records the registry
+    // generation; the runtime relinks when the generation it ticks against differs. `shared` is
+    // adopted instead of rebuilding when it was linked for this definition and generation.
+    void link_leaves(const registry& reg, std::shared_ptr<const leaf_link_table> shared = nullptr);
+    // Callback index of a cond/act leaf as of the last link, or registry::k_unbound.
+    [[nodiscard]] std::uint32_t leaf_binding(node_id id) const noexcept;
+    // Forgets every memoised result; the next incremental tick re-evaluates all pure subtrees.
+    void invalidate_memos() noexcept;
+    // Decoded arguments of a leaf bound to a native callback; nullopt when they did not match.
+    [[nodiscard]] std::optional<std::span<const native_arg>> native_leaf_args(node_id id) const noexcept;
+    // Sets memory_touched[id] and counts `id` in the live_memory_nodes of it and every ancestor.
+    void touch_memory(node_id id) noexcept;
+    // Undoes touch_memory for a node whose memory is back to its initial state, so finished nodes stop
+    // counting as live. Nodes that keep state after finishing (mem-seq, repeat, ...) stay counted.
+    void release_idle_memory(node_id id) noexcept;
+    // Why this instance's tick state cannot be checkpointed or forked, or an empty string. Leaf
+    // payloads, suspended coroutine actions and VLA jobs in flight cannot be copied.
+    [[nodiscard]] std::string uncopyable_state() const;
 
     const definition* def = nullptr;
     std::int64_t instance_handle = 0;
-    std::unordered_map<node_id, node_memory> memory;
+    std::vector<node_memory> memory;
+    std::vector<std::uint8_t> memory_touched;
+    // Per node, how many nodes of its subtree (itself included) have touched memory that is not back
+    // to its initial state. Halts only descend into subtrees with live memory, so halting an idle or
+    // finished branch costs nothing per node.
+    std::vector<std::uint32_t> live_memory_nodes;
+    static constexpr node_id k_no_parent = std::numeric_limits<node_id>::max();
+    std::vector<node_id> node_parents;
+    // Per node, set once the leaf watched a job through tick_context::watch_job. While such a leaf runs
+    // holding its job (b0 set, the job id in i0), the job's completion wakes an on-demand instance.
+    std::vector<std::uint8_t> job_watchers;
     std::unordered_map<node_id, std::uint64_t> active_vla_jobs;
+    // Speculative vla-request submits (see :prefetch_key), keyed by node, awaiting the node's next tick.
+    struct vla_prefetch {
+        std::uint64_t job = 0;
+        std::uint64_t match_hash = 0;
+    };
+    std::unordered_map<node_id, vla_prefetch> vla_prefetches;
+    // Action chunk a vla-chunk node is executing, and the job fetching its next one.
+    struct vla_chunk_buffer {
+        std::vector<vla_chunk_step> steps;
+        // Tick time the first step applies from.
+        std::chrono::steady_clock::time_point started_at{};
+        std::uint64_t job = 0;
+    };
+    std::unordered_map<node_id, vla_chunk_buffer> vla_chunks;
+    // vla-request nodes declaring :prefetch_key, computed for `vla_prefetch_def`.
+    std::vector<node_id> vla_prefetch_nodes;
+    const definition* vla_prefetch_def = nullptr;
+    // Created by the first tick_context::watch_job; drained at the start of every tick.
+    std::shared_ptr<completion_queue> job_completions;
+    std::vector<completion_queue::notification> job_notifications;
+    // Watched jobs of nodes that swap_definition moved to a new id: their completion tags still name
+    // the old node. An entry is dropped once its node no longer holds the job.
+    std::unordered_map<job_id, node_id> moved_job_watchers;
+    // What plan-action :budget_mode "adaptive" has learned, keyed by node: a smoothed mean and mean
+    // deviation of the tick time spent after the planner returned. A plan sets `pending_tick`, and the
+    // end of that tick folds in its sample. Kept across reset; cleared by recycle.
+    struct plan_budget {
+        double post_work_ms = 0.0;
+        double post_work_dev_ms = 0.0;
+        double alpha = 0.2;
+        double planner_done_ms = 0.0;
+        std::uint64_t pending_tick = 0;
+        std::uint64_t samples = 0;
+        bool pending = false;
+    };
+    std::unordered_map<node_id, plan_budget> plan_budgets;
     std::unordered_set<node_id> halt_warning_emitted;
     blackboard bb;
     std::uint64_t tick_index = 0;
@@ -77,10 +265,63 @@ struct instance {
     bool trace_enabled = true;
     bool read_trace_enabled = false;
 
+    // bb_delta bookkeeping: the event log keyframe epoch and tick of this instance's last keyframe,
+    // and the tick its last keyframe or delta was taken at.
+    std::uint64_t bb_keyframe_epoch = 0;
+    std::uint64_t bb_keyframe_tick = 0;
+    std::uint64_t bb_journal_tick = 0;
+
     tree_profile_stats tree_stats{};
-    std::unordered_map<node_id, node_profile_stats> node_stats;
+    std::vector<node_profile_stats> node_stats;
+    // Which node visits are timed into node_stats; see set_node_profiling.
+    node_profiling_options node_profiling{};
     std::vector<node_id> halt_stack;
 
+    const definition* slots_def = nullptr;
+    std::shared_ptr<const leaf_arg_table> leaf_arg_values;
+    std::vector<bb_slot> bb_key_slots;
+    std::shared_ptr<const leaf_link_table> leaf_links;
+    std::uint64_t leaf_bindings_generation = 0;
+
+    // When set, ticks reuse the memoised status of pure subtrees whose blackboard reads have no write
+    // stamp newer than the memo. Memos are built by link_leaves only while this is enabled.
+    bool incremental_tick = false;
+    std::vector<node_memo> node_memos;
+    std::vector<bb_slot> memo_reads;
+
+    // On-demand ticking (see set_tick_on_demand): `waker` collects wake reasons from writes to the
+    // blackboard slots in `wake_reads` (every slot when `wake_on_any_write`) and from job_completions.
+    // The wake set is the union of the declared read sets of the definition's condition leaves,
+    // rebuilt by link_leaves while this is enabled; a condition without declared reads makes it
+    // every slot.
+    bool tick_on_demand = false;
+    std::chrono::nanoseconds tick_max_interval{0};
+    std::shared_ptr<tick_waker> waker;
+    std::vector<bb_slot> wake_reads;
+    bool wake_on_any_write = false;
+    // Steady time of the last tick while tick_on_demand; time_point{} before the first.
+    std::chrono::steady_clock::time_point last_tick_at{};
+    // The last tick returned running with a running leaf no watched job will wake (a Lisp action, a
+    // coroutine sleep, a vla-request); tick_due keeps the instance due until it stops running.
+    bool running_unwatched = false;
+    // Ticks started per wake reason (by bit position), and tick_if_due calls that did not tick.
+    std::array<std::uint64_t, 5> wake_counts{};
+    std::uint64_t wake_skip_count = 0;
+
+    // Ticks run the definition's linear tick program (compiled on first use) unless this is cleared;
+    // incremental ticks always use the recursive interpreter.
+    bool tick_program_enabled = true;
+    std::shared_ptr<const tick_program> program;
+    // Programs with a registered compiled_tree run its generated code unless this is cleared.
+    bool compiled_tree_enabled = true;
+    std::vector<tick_frame> tick_frames;
+    // Cleared at the start of every tick; capacity is kept so audited ticks stop allocating.
+    std::vector<node_path_record> node_path_records;
+    // Nodes that allocated this tick while tick audits are enabled; cleared and reused like the above.
+    std::vector<node_alloc_record> node_alloc_records;
+    // Scratch for event payloads and serialised event lines built during a tick; reset at tick end.
+    tick_arena arena;
+
     trace_buffer trace;
 };
 
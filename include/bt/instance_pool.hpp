@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "bt/instance.hpp"
+
+namespace bt {
+
+// Idle instances of one definition, kept so that high-churn callers (one instance per episode,
+// rollout or request) reuse slabs, interned blackboard keys, leaf links, tick programs and trace
+// rings instead of building them again. Released instances are recycled (see bt::recycle) on the way
+// in, so acquire() hands out an instance indistinguishable from a new one. Not thread-safe.
+class instance_pool {
+public:
+    static constexpr std::size_t k_default_max_idle = 256;
+
+    // New instances share `shared_leaf_args` when it was built for `def`.
+    explicit instance_pool(const definition* def,
+                           std::shared_ptr<const leaf_arg_table> shared_leaf_args = nullptr,
+                           std::size_t trace_capacity = instance::k_default_trace_capacity,
+                           std::size_t max_idle = k_default_max_idle);
+
+    instance_pool(const instance_pool&) = delete;
+    instance_pool& operator=(const instance_pool&) = delete;
+
+    // The most recently released idle instance, or a new one when none is idle.
+    [[nodiscard]] std::unique_ptr<instance> acquire();
+    // Recycles `inst` and keeps it for a later acquire(). Instances of another definition, with
+    // another trace capacity, or beyond max_idle() are freed instead. Running leaves must already
+    // have been halted; their scheduler jobs are not cancelled here.
+    void release(std::unique_ptr<instance> inst);
+
+    // Frees the idle instances and applies `capacity` to instances created from now on.
+    void set_trace_capacity(std::size_t capacity);
+    [[nodiscard]] std::size_t trace_capacity() const noexcept { return trace_capacity_; }
+    [[nodiscard]] std::size_t max_idle() const noexcept { return max_idle_; }
+    [[nodiscard]] std::size_t idle_count() const noexcept { return idle_.size(); }
+    [[nodiscard]] std::span<const std::unique_ptr<instance>> idle() const noexcept { return idle_; }
+    [[nodiscard]] const definition* def() const noexcept { return def_; }
+
+private:
+    const definition* def_ = nullptr;
+    std::shared_ptr<const leaf_arg_table> leaf_args_;
+    std::size_t trace_capacity_ = instance::k_default_trace_capacity;
+    std::size_t max_idle_ = k_default_max_idle;
+    std::vector<std::unique_ptr<instance>> idle_;
+};
+
+}  // namespace bt
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace bt {
+
+// Appends compact JSON to a reusable buffer; commas between members and elements are inserted
+// automatically. Numbers are formatted with std::to_chars (non-finite doubles become null) and
+// strings use the same escaping as event_log::json_escape. clear() keeps the buffer's capacity.
+class json_writer {
+public:
+    static constexpr unsigned k_max_depth = 64;
+
+    void clear() noexcept;
+
+    json_writer& begin_object();
+    json_writer& end_object();
+    json_writer& begin_array();
+    json_writer& end_array();
+
+    // Writes `"name":`; the next value call supplies the member's value.
+    json_writer& key(std::string_view name);
+
+    json_writer& value(std::string_view text);
+    json_writer& value(const char* text) { return value(std::string_view(text)); }
+    json_writer& value(bool flag);
+    json_writer& value(double number);
+    json_writer& value(std::int64_t number);
+    json_writer& value(std::uint64_t number);
+    template <std::integral T>
+        requires(!std::same_as<T, bool>)
+    json_writer& value(T number) {
+        if constexpr (std::is_signed_v<T>) {
+            return value(static_cast<std::int64_t>(number));
+        } else {
+            return value(static_cast<std::uint64_t>(number));
+        }
+    }
+    json_writer& null();
+    // Appends already-serialised JSON as one value.
+    json_writer& raw(std::string_view json);
+
+    template <typename T>
+    json_writer& field(std::string_view name, const T& v) {
+        key(name);
+        return value(v);
+    }
+
+    [[nodiscard]] std::string_view view() const noexcept { return buffer_; }
+
+    static void append_escaped(std::string& out, std::string_view text);
+
+private:
+    void separate();
+
+    std::string buffer_;
+    // Bit d is set while the container at depth d has no members yet.
+    std::uint64_t empty_bits_ = 0;
+    unsigned depth_ = 0;
+    bool after_key_ = false;
+};
+
+}  // namespace bt
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace bt {
+
+// Single-producer, single-consumer mailbox that holds only the latest value: a triple buffer. The
+// producer fills back() and calls publish(); the consumer calls read() and gets the newest published
+// value. Neither side ever waits for the other, and a slow consumer just skips values. Producer
+// calls may come from different threads, and so may consumer calls, as long as calls on one side
+// do not overlap.
+//
+// Slots are reused, so a T that owns buffers (strings, vectors) keeps their capacity from one
+// publish to the next.
+template <typename T>
+class latest_mailbox {
+public:
+    // The slot the producer writes next. It holds a value published three publishes ago.
+    [[nodiscard]] T& back() noexcept { return slots_[back_]; }
+
+    void publish() noexcept {
+        const std::uint8_t previous = middle_.exchange(static_cast<std::uint8_t>(back_ | k_fresh), std::memory_order_acq_rel);
+        back_ = static_cast<std::uint8_t>(previous & k_index);
+    }
+
+    // The newest published value, or nullptr before the first publish. The pointer stays valid, and
+    // the value unchanged, until the next read().
+    [[nodiscard]] const T* read() noexcept {
+        if ((middle_.load(std::memory_order_relaxed) & k_fresh) != 0) {
+            const std::uint8_t previous = middle_.exchange(front_, std::memory_order_acq_rel);
+            front_ = static_cast<std::uint8_t>(previous & k_index);
+            has_front_ = true;
+        }
+        return has_front_ ? &slots_[front_] : nullptr;
+    }
+
+    // True when a value was published since the last read().
+    [[nodiscard]] bool fresh() const noexcept { return (middle_.load(std::memory_order_acquire) & k_fresh) != 0; }
+
+private:
+    static constexpr std::uint8_t k_index = 0x3;
+    static constexpr std::uint8_t k_fresh = 0x4;
+
+    std::array<T, 3> slots_{};
+    // Index of the slot between the two sides, with k_fresh set when the producer swapped it in.
+    alignas(64) std::atomic<std::uint8_t> middle_{1};
+    alignas(64) std::uint8_t back_ = 0;
+    alignas(64) std::uint8_t front_ = 2;
+    bool has_front_ = false;
+};
+
+}  // namespace bt
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "bt/ast.hpp"
+#include "bt/planner.hpp"
+#include "bt/vla.hpp"
+
+namespace bt {
+
+struct instance;
+class registry;
+struct services;
+
+struct log_replay_options {
+    // Stop after this many recorded ticks; 0 replays them all.
+    std::uint64_t max_ticks = 0;
+};
+
+// Where a replay first stopped matching its recording, comparing the tick's node_exit events in
+// order and then its root status. `kind` is "node_status" (the same node returned another status),
+// "node_order" (another node ran at that point; expected and actual are node ids), "extra_node" or
+// "missing_node" (the replay ran more or fewer nodes; the absent side is "-") or "root_status".
+struct log_replay_divergence {
+    std::uint64_t tick = 0;
+    std::string kind;
+    node_id node = 0;
+    std::string expected;
+    std::string actual;
+};
+
+struct log_replay_report {
+    std::uint64_t recorded_ticks = 0;
+    std::uint64_t replayed_ticks = 0;
+    // Blackboard writes and deletes restored from bb_snapshot/bb_delta events.
+    std::uint64_t injected_bb_writes = 0;
+    std::uint64_t injected_vla_results = 0;
+    std::uint64_t injected_planner_results = 0;
+    double elapsed_ms = 0.0;
+    std::optional<log_replay_divergence> divergence;
+};
+
+// Re-drives a tree from an mbt.evt.v1 log as fast as it will tick. Before each recorded tick the
+// replay restores the blackboard inputs the recording saw, that is every key in that tick's
+// bb_snapshot or bb_delta whose value is not the one the tree itself last wrote, so the log must be
+// recorded with `events.set-bb-deltas`. Time is a bt::sim_clock moved to each tick's recorded
+// unix_ms, so waits and deadlines cost nothing. VLA jobs and plan-action calls are answered from the
+// recording (see the hooks below) instead of the services: a vla-wait sees the poll status recorded
+// for its tick, with the recorded action once the job is done, and a plan-action :async job completes
+// on the tick its planner_call_end was logged. Replay stops at the first tick whose node statuses or
+// root status differ from the recording.
+class log_replay {
+public:
+    // Throws std::runtime_error for an unreadable file, a line that is not JSON, or a log with no
+    // ticks or whose ticks do not increase (a log of several instances).
+    [[nodiscard]] static log_replay load(const std::string& path);
+    [[nodiscard]] static log_replay parse(std::istream& in);
+
+    log_replay(log_replay&&) noexcept;
+    log_replay& operator=(log_replay&&) noexcept;
+    ~log_replay();
+
+    // The tree as recorded in the log's bt_def event; empty if the log has none.
+    [[nodiscard]] const std::string& tree_dsl() const noexcept;
+    [[nodiscard]] const std::string& tree_hash() const noexcept;
+    [[nodiscard]] std::uint64_t recorded_ticks() const noexcept;
+
+    // Ticks `inst` through the recording. `base` supplies the scheduler, planner, VLA service and
+    // robot; the replay substitutes its own clock, event log and hooks, and drops the log sink. The
+    // instance should be fresh: it is moved to the tick before the first recorded one.
+    log_replay_report run(instance& inst, registry& reg, const services& base, const log_replay_options& options = {});
+
+    // Hooks the runtime calls while services::replay points at this replay.
+    // The job id the recording's vla-request `node` submitted on `tick`.
+    [[nodiscard]] std::optional<vla_service::vla_job_id> vla_job(std::uint64_t tick, node_id node) const;
+    // What the recording's vla-wait `node` polled on `tick`; `running` when it did not poll.
+    [[nodiscard]] vla_poll vla_poll_at(std::uint64_t tick, node_id node);
+    // The result plan-action `node` concluded on `tick`, when the log records planner actions.
+    [[nodiscard]] std::optional<planner_result> planner_result_at(std::uint64_t tick, node_id node);
+    // Whether any planner_call_end carries its action; older logs replay plan-action live.
+    [[nodiscard]] bool records_planner_results() const noexcept;
+
+private:
+    struct recording;
+
+    explicit log_replay(std::unique_ptr<recording> rec);
+
+    std::unique_ptr<recording> rec_;
+    log_replay_report* report_ = nullptr;
+};
+
+}  // namespace bt
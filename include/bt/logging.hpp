@@ -1,10 +1,16 @@
 #pragma once
 
+#include <atomic>
+#include <bit>
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
+#include <memory>
 #include <mutex>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "bt/ast.hpp"
@@ -28,27 +34,165 @@ struct log_record {
     std::string message;
 };
 
+// Where and when a message was raised, for the deferred write path.
+struct log_origin {
+    std::chrono::steady_clock::time_point ts{};
+    log_level level = log_level::info;
+    std::uint64_t tick_index = 0;
+    node_id node = 0;
+};
+
+enum class log_arg_kind : std::uint8_t {
+    int64,
+    uint64,
+    float64,
+    text,
+    float64_list
+};
+
+// One argument of a deferred message, filled into the next "{}" of its format when the log is read.
+// Text and lists are borrowed: the sink copies them before write_deferred returns.
+struct log_arg {
+    log_arg_kind kind = log_arg_kind::int64;
+    std::uint64_t bits = 0;
+    std::string_view text{};
+    std::span<const double> list{};
+
+    log_arg(std::int64_t v) noexcept : kind(log_arg_kind::int64), bits(static_cast<std::uint64_t>(v)) {}
+    log_arg(int v) noexcept : log_arg(static_cast<std::int64_t>(v)) {}
+    log_arg(std::uint64_t v) noexcept : kind(log_arg_kind::uint64), bits(v) {}
+    log_arg(double v) noexcept : kind(log_arg_kind::float64), bits(std::bit_cast<std::uint64_t>(v)) {}
+    log_arg(std::string_view v) noexcept : kind(log_arg_kind::text), text(v) {}
+    log_arg(const char* v) noexcept : log_arg(std::string_view(v)) {}
+    log_arg(const std::string& v) noexcept : log_arg(std::string_view(v)) {}
+    log_arg(std::span<const double> v) noexcept : kind(log_arg_kind::float64_list), list(v) {}
+    log_arg(const std::vector<double>& v) noexcept : log_arg(std::span<const double>(v)) {}
+};
+
+// Fills the "{}" placeholders of `format` from `args`, in order. Placeholders without an argument are
+// kept as written; unused arguments are dropped.
+[[nodiscard]] std::string format_log_message(std::string_view format, std::span<const log_arg> args);
+
 class log_sink {
 public:
     virtual ~log_sink() = default;
     virtual void write(const log_record& rec) = 0;
+    // Whether a message in `category` from `origin` should be written at all. Callers ask before
+    // formatting anything; sinks without rate limiting admit everything.
+    virtual bool admit(const log_origin& origin, std::string_view category) {
+        (void)origin;
+        (void)category;
+        return true;
+    }
+    // Writes a message whose `format` is only filled from `args` when the log is read. `format` must
+    // have static storage duration (a string literal). The default formats at once and calls write().
+    virtual void write_deferred(const log_origin& origin,
+                                std::string_view category,
+                                const char* format,
+                                std::span<const log_arg> args);
 };
 
+// Fixed-capacity ring of log records, safe to write from any number of threads without a lock. Each
+// record is stored in a fixed-size slot: its category, its message text and the text or list
+// arguments share k_text_bytes_per_record bytes, and longer text is cut and marked with "...".
+// Deferred messages keep their format and raw arguments and are only formatted by snapshot(). The
+// slots are allocated by the first write.
+//
+// Writers claim a sequence number with one atomic increment and fill its slot under the slot's
+// sequence lock. snapshot() may run concurrently with writers; records still being written, or
+// overwritten mid-copy, are skipped.
+//
+// admit() rate-limits each (category, node): at most `burst` messages per `window` of the messages'
+// own timestamps. The rest are counted, and the first message admitted in a later window is preceded
+// by a warn record "suppressed N repeated log messages". Keys hash into k_rate_limit_slots limiters,
+// so rarely two keys share one.
 class memory_log_sink final : public log_sink {
 public:
+    static constexpr std::size_t k_text_bytes_per_record = 224;
+    static constexpr std::size_t k_max_args = 6;
+    static constexpr std::size_t k_rate_limit_slots = 256;
+    static constexpr std::size_t k_default_burst = 32;
+    static constexpr std::chrono::milliseconds k_default_window{1000};
+
     explicit memory_log_sink(std::size_t capacity_records);
 
+    memory_log_sink(const memory_log_sink&) = delete;
+    memory_log_sink& operator=(const memory_log_sink&) = delete;
+
     void write(const log_record& rec) override;
+    bool admit(const log_origin& origin, std::string_view category) override;
+    void write_deferred(const log_origin& origin,
+                        std::string_view category,
+                        const char* format,
+                        std::span<const log_arg> args) override;
+    // Decodes and formats the retained records, oldest first.
     std::vector<log_record> snapshot() const;
     std::size_t size() const;
     std::size_t capacity() const;
+    // Forgets retained records; sequence numbers and the rate limiters keep counting.
     void clear();
 
+    // Bytes of the record slots (once the first write allocated them) and the rate limiters.
+    [[nodiscard]] std::size_t memory_bytes() const noexcept;
+
+    // `burst` 0 turns rate limiting off.
+    void set_rate_limit(std::size_t burst, std::chrono::nanoseconds window) noexcept;
+    // Messages admit() has turned away since the sink was made.
+    [[nodiscard]] std::uint64_t suppressed() const noexcept;
+
 private:
+    struct stored_record {
+        std::uint64_t sequence = 0;
+        std::chrono::steady_clock::time_point ts{};
+        log_level level = log_level::info;
+        std::uint64_t tick_index = 0;
+        node_id node = 0;
+        // nullptr when the text after the category is the message itself.
+        const char* format = nullptr;
+        std::uint8_t arg_count = 0;
+        bool truncated = false;
+        std::uint16_t category_size = 0;
+        std::uint16_t text_size = 0;
+        log_arg_kind arg_kinds[k_max_args]{};
+        // Scalar bits, or the byte size of a text or list argument in `text`.
+        std::uint64_t arg_bits[k_max_args]{};
+        char text[k_text_bytes_per_record]{};
+    };
+
+    // `version` is 2 * sequence once that record is stored and odd while a writer fills the slot.
+    struct slot {
+        std::atomic<std::uint64_t> version{0};
+        stored_record rec{};
+    };
+
+    static constexpr std::int64_t k_unset_window = std::numeric_limits<std::int64_t>::min();
+
+    struct limiter {
+        // k_unset_window until the first message.
+        std::atomic<std::int64_t> window_start{k_unset_window};
+        std::atomic<std::uint64_t> count{0};
+        std::atomic<std::uint64_t> suppressed{0};
+    };
+
+    slot* slots();
+    void store(const log_origin& origin,
+               std::string_view category,
+               const char* format,
+               std::string_view message,
+               std::span<const log_arg> args) noexcept;
+
     std::size_t capacity_;
-    std::vector<log_record> records_;
-    std::uint64_t sequence_ = 0;
-    mutable std::mutex mutex_;
+    std::unique_ptr<slot[]> slots_;
+    std::once_flag allocate_once_;
+    std::atomic<slot*> ready_{nullptr};
+    // Sequence numbers claimed so far (== the newest one) and the count before the last clear().
+    std::atomic<std::uint64_t> head_{0};
+    std::atomic<std::uint64_t> cleared_at_{0};
+
+    std::unique_ptr<limiter[]> limiters_;
+    std::atomic<std::uint64_t> burst_{k_default_burst};
+    std::atomic<std::int64_t> window_ns_{std::chrono::nanoseconds(k_default_window).count()};
+    std::atomic<std::uint64_t> suppressed_{0};
 };
 
 const char* log_level_name(log_level level) noexcept;
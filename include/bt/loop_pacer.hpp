@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace bt {
+
+class json_writer;
+
+// What loop_pacer does when the work between two waits ran past the next deadline.
+enum class overrun_policy {
+    // Drop the missed ticks and wait for the next deadline on the original grid.
+    skip,
+    // Run the missed ticks back to back, without sleeping, until the loop is on schedule again. A
+    // backlog longer than max_catch_up periods is dropped as under skip.
+    catch_up,
+    // Double the period (up to degrade_max_factor times the configured one) and restart the grid from
+    // now. The period halves again after degrade_recover_ticks ticks in a row finish on time.
+    degrade,
+};
+
+[[nodiscard]] std::optional<overrun_policy> parse_overrun_policy(std::string_view name) noexcept;
+[[nodiscard]] const char* overrun_policy_name(overrun_policy policy) noexcept;
+
+struct loop_pacer_options {
+    std::chrono::nanoseconds period{};
+    overrun_policy policy = overrun_policy::skip;
+    // Sleep until this long before a deadline, then busy-wait. OS wake-up latency is usually tens of
+    // microseconds, so a short spin keeps wake-up lateness near zero. Zero disables spinning.
+    std::chrono::nanoseconds spin{std::chrono::microseconds(100)};
+    std::uint32_t max_catch_up = 4;
+    std::uint32_t degrade_max_factor = 8;
+    std::uint32_t degrade_recover_ticks = 32;
+};
+
+// Counters since the last reset(). Jitter is wake-up lateness: how long after its deadline a tick
+// was released.
+struct loop_pacer_stats {
+    // Upper bounds, in microseconds, of every histogram bucket but the last, which is unbounded.
+    static constexpr std::array<std::int64_t, 9> k_jitter_bounds_us{10, 25, 50, 100, 250, 500, 1000, 2500, 5000};
+
+    std::uint64_t ticks = 0;
+    std::uint64_t overruns = 0;
+    std::uint64_t skipped_ticks = 0;
+    std::uint64_t caught_up_ticks = 0;
+    std::uint32_t degrade_factor = 1;
+    std::int64_t jitter_last_ns = 0;
+    std::int64_t jitter_max_ns = 0;
+    std::int64_t jitter_total_ns = 0;
+    std::array<std::uint64_t, k_jitter_bounds_us.size() + 1> jitter_histogram{};
+};
+
+// Paces a fixed-rate loop against absolute deadlines on a fixed grid (start + n * period), so sleep
+// error does not accumulate into drift. A wait sleeps with clock_nanosleep(TIMER_ABSTIME) where
+// available and spins through the last `spin` of the period.
+class loop_pacer {
+public:
+    using clock = std::chrono::steady_clock;
+
+    explicit loop_pacer(loop_pacer_options options = {});
+
+    // Blocks until the next tick is due and returns its wake-up lateness. The first call after
+    // construction, restart() or reset() starts the grid one period from now.
+    std::chrono::nanoseconds wait_next();
+    // Forgets the grid, so the next wait starts a new one; the counters are kept.
+    void restart() noexcept;
+    // Forgets the grid and the counters.
+    void reset() noexcept;
+
+    [[nodiscard]] const loop_pacer_options& options() const noexcept { return options_; }
+    // The period in force, which differs from options().period while degraded.
+    [[nodiscard]] std::chrono::nanoseconds period() const noexcept { return period_; }
+    [[nodiscard]] const loop_pacer_stats& stats() const noexcept { return stats_; }
+
+    // Writes the counters as a JSON object, as carried by tick_audit `loop_pacing`.
+    void write_json(json_writer& out) const;
+
+private:
+    void sleep_until(clock::time_point deadline) const;
+    void record_jitter(std::chrono::nanoseconds lateness) noexcept;
+    void set_degrade_factor(std::uint32_t factor) noexcept;
+
+    loop_pacer_options options_;
+    std::chrono::nanoseconds period_;
+    clock::time_point deadline_{};
+    bool anchored_ = false;
+    std::uint32_t on_time_streak_ = 0;
+    loop_pacer_stats stats_;
+};
+
+}  // namespace bt
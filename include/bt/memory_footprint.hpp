@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "bt/ast.hpp"
+
+namespace bt {
+
+struct instance;
+
+// Steady-state memory accounting. Sizes are container capacities times element sizes plus the heap
+// buffers of strings, without allocator overhead, so they slightly under-count what the allocator
+// handed out and never include memory already freed.
+
+// Heap bytes a string owns beyond the object itself; 0 while it fits the small-string buffer.
+[[nodiscard]] inline std::size_t string_heap_bytes(const std::string& s) noexcept {
+    return s.capacity() > std::string().capacity() ? s.capacity() + 1 : 0;
+}
+
+template <typename T>
+[[nodiscard]] std::size_t vector_heap_bytes(const std::vector<T>& v) noexcept {
+    return v.capacity() * sizeof(T);
+}
+
+// Bucket array plus one node (value and next pointer, cached hash) per element of an unordered
+// container.
+template <typename Map>
+[[nodiscard]] std::size_t hash_heap_bytes(const Map& m) noexcept {
+    return m.bucket_count() * sizeof(void*) + m.size() * (sizeof(typename Map::value_type) + 2 * sizeof(void*));
+}
+
+struct instance_footprint {
+    // The instance object, node memory and slot tables, memos, profile stats and tick scratch.
+    std::size_t state_bytes = 0;
+    std::size_t blackboard_bytes = 0;
+    std::size_t trace_bytes = 0;
+
+    [[nodiscard]] std::size_t total_bytes() const noexcept { return state_bytes + blackboard_bytes + trace_bytes; }
+};
+
+// The definition's nodes, leaf arguments, key names and canonical DSL.
+[[nodiscard]] std::size_t definition_footprint(const definition& def) noexcept;
+// Leaves out the leaf and tick program tables `inst` shares with other instances or caches; see
+// shared_tables_footprint.
+[[nodiscard]] instance_footprint measure_instance(const instance& inst) noexcept;
+// Leaf argument, leaf link and tick program tables `inst` shares with other holders and that are not
+// yet in `counted`, which gains them, so a table shared by many instances is counted once.
+[[nodiscard]] std::size_t shared_tables_footprint(const instance& inst, std::unordered_set<const void*>& counted);
+
+// Per-component bytes held by a runtime_host; see runtime_host::memory_report.
+struct memory_report {
+    std::size_t definition_count = 0;
+    // Definitions plus the leaf and tick program tables their instances share, each counted once.
+    std::size_t definition_bytes = 0;
+    std::size_t instance_count = 0;
+    // Recycled instances kept by the host's instance pools.
+    std::size_t idle_instance_count = 0;
+    // Sums over live and idle instances.
+    std::size_t instance_state_bytes = 0;
+    std::size_t blackboard_bytes = 0;
+    std::size_t trace_bytes = 0;
+    std::size_t event_ring_bytes = 0;
+    std::size_t log_ring_bytes = 0;
+    // Live bytes of the default Lisp heap (the sum of gc_size_bytes over live objects), and the bytes
+    // its cell pools reserve, which total_bytes() leaves out since they overlap the live bytes.
+    std::size_t lisp_heap_bytes = 0;
+    std::size_t lisp_heap_reserved_bytes = 0;
+
+    [[nodiscard]] std::size_t total_bytes() const noexcept;
+};
+
+// One `component=bytes` line per field, then `total_bytes`.
+[[nodiscard]] std::string format_memory_report(const memory_report& report);
+
+}  // namespace bt
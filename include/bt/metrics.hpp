@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "bt/profile.hpp"
+
+namespace bt {
+
+// Runtime counters and histograms meant to be scraped from another thread. Writers only touch
+// relaxed atomics, so a scrape never blocks a tick and a tick never waits for a scrape. Each
+// histogram has a single writer at a time (see latency_histogram): ticks and GC pauses are recorded
+// on the ticking thread, model-service calls under the host's model-service latency lock.
+class runtime_metrics {
+public:
+    void set_enabled(bool enabled) noexcept { enabled_.store(enabled, std::memory_order_relaxed); }
+    [[nodiscard]] bool enabled() const noexcept { return enabled_.load(std::memory_order_relaxed); }
+
+    void record_tick(std::chrono::nanoseconds duration, bool overrun) noexcept;
+    void record_gc_pause(std::chrono::nanoseconds pause, bool minor) noexcept;
+    void record_model_service_call(std::chrono::nanoseconds latency) noexcept;
+    // Not safe against concurrent writers; call while nothing ticks.
+    void reset() noexcept;
+
+    // Appends the families above in OpenMetrics text format, without the closing `# EOF`.
+    void append_openmetrics(std::string& out) const;
+
+private:
+    std::atomic<bool> enabled_{false};
+
+    latency_histogram tick_duration_;
+    std::atomic<std::uint64_t> tick_ns_total_{0};
+    std::atomic<std::uint64_t> tick_overruns_{0};
+
+    latency_histogram gc_pause_;
+    std::atomic<std::uint64_t> gc_pause_ns_total_{0};
+    std::atomic<std::uint64_t> gc_minor_collections_{0};
+
+    latency_histogram model_service_call_;
+    std::atomic<std::uint64_t> model_service_call_ns_total_{0};
+};
+
+// OpenMetrics text helpers shared by the host's renderer.
+void append_openmetrics_counter(std::string& out, std::string_view name, std::string_view help, std::uint64_t value);
+void append_openmetrics_gauge(std::string& out, std::string_view name, std::string_view help, double value);
+// Emits the histogram as seconds over fixed `le` bounds from 1 us to 10 s. Each bound counts the
+// latency_histogram buckets that lie wholly below it, so a bound can undercount by the samples in
+// the one bucket it splits (at most 12.5% of the bound's width).
+void append_openmetrics_histogram(std::string& out,
+                                  std::string_view name,
+                                  std::string_view help,
+                                  const latency_histogram& histogram,
+                                  std::chrono::nanoseconds sum);
+
+inline constexpr std::string_view k_openmetrics_content_type =
+    "application/openmetrics-text; version=1.0.0; charset=utf-8";
+
+// A minimal HTTP/1.0 server on its own thread that answers `GET /metrics` with `render()` and
+// anything else with 404. It serves one connection at a time and closes it after the response,
+// which is all a Prometheus scrape needs. Only IPv4 addresses are accepted. POSIX only; elsewhere
+// the constructor throws.
+class metrics_endpoint {
+public:
+    using render_fn = std::function<std::string()>;
+
+    // Binds and starts listening before returning; port 0 picks a free port (see port()). Throws
+    // std::runtime_error when the address cannot be bound.
+    metrics_endpoint(const std::string& bind_address, std::uint16_t port, render_fn render);
+    ~metrics_endpoint();
+
+    metrics_endpoint(const metrics_endpoint&) = delete;
+    metrics_endpoint& operator=(const metrics_endpoint&) = delete;
+
+    [[nodiscard]] std::uint16_t port() const noexcept { return port_; }
+    [[nodiscard]] const std::string& bind_address() const noexcept { return bind_address_; }
+
+private:
+    void serve();
+
+    std::string bind_address_;
+    std::uint16_t port_ = 0;
+    int listen_fd_ = -1;
+    render_fn render_;
+    std::atomic<bool> stop_{false};
+    std::thread thread_;
+};
+
+}  // namespace bt
@@ -1,9 +1,11 @@
 #pragma once
 
 #include <cstdint>
+#include <future>
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace bt {
@@ -47,10 +49,37 @@ struct model_service_config {
     std::string endpoint = "ws://127.0.0.1:8765/v1/ws";
     std::int64_t connect_timeout_ms = 200;
     std::int64_t request_timeout_ms = 500;
+    // Websocket connections the bridge client keeps open; requests are pipelined over them.
+    std::size_t connection_pool_size = 2;
     bool required = false;
     std::string replay_mode = "live";
     std::string replay_cache_path;
+    // "files" keeps one <request_hash>.json per response under replay_cache_path; "indexed" keeps a
+    // replay_store there, which replays without reading the whole cache.
+    std::string replay_cache_format = "files";
     std::vector<std::string> fault_schedule;
+    // VLA requests that arrive within this many milliseconds of each other are sent as one batched
+    // invoke when describe advertises batching for cap.vla.action_chunk.v1; 0 disables batching.
+    std::int64_t batch_window_ms = 0;
+    // When non-empty, a shared-memory frame ring of this name is created so that image.make and
+    // blob.make payloads reach a co-located service as shm:// refs instead of HTTP frame uploads.
+    std::string frame_ring_name;
+    std::size_t frame_ring_slots = 8;
+    std::size_t frame_ring_slot_bytes = std::size_t{4} << 20;
+    // Hedging of invoke calls; 0 disables it. When an invoke call is still unanswered after this
+    // percentile (0, 100) of recent successful invoke latencies, a duplicate goes to hedge_endpoint.
+    // When hedge_endpoint is empty the duplicate goes to the same client, on whichever pooled
+    // connection is free. The first valid response wins, and the other is discarded when it arrives.
+    double hedge_percentile = 0.0;
+    // The hedge delay never drops below this, so a fast service is not hedged on jitter.
+    std::int64_t hedge_min_delay_ms = 1;
+    std::string hedge_endpoint;
+};
+
+// Hedging counters of a runtime_host since its model-service client was last set.
+struct model_service_hedge_stats {
+    std::uint64_t hedged = 0;
+    std::uint64_t hedge_wins = 0;
 };
 
 struct model_service_request {
@@ -103,6 +132,10 @@ public:
     virtual ~model_service_client() = default;
 
     [[nodiscard]] virtual model_service_response call(const model_service_request& request) = 0;
+    // Starts the call and returns a future for its response. The default runs call() before
+    // returning; clients with their own transport complete the future from it instead, so the
+    // caller's thread is free until it waits.
+    [[nodiscard]] virtual std::future<model_service_response> call_async(const model_service_request& request);
 };
 
 class unavailable_model_service_client final : public model_service_client {
@@ -112,9 +145,27 @@ public:
 
 [[nodiscard]] std::string model_service_request_to_json(const model_service_request& request);
 [[nodiscard]] std::string model_service_response_to_json(const model_service_response& response);
-[[nodiscard]] model_service_response model_service_response_from_json(const std::string& text);
+// Parses a response envelope in place with a per-thread json_scan document, copying out only the
+// fields the response keeps; an envelope that is not strict JSON falls back to a lenient field scan.
+[[nodiscard]] model_service_response model_service_response_from_json(std::string_view text);
+// Parses a request envelope as written by model_service_request_to_json. Throws std::invalid_argument
+// when the op is missing or unknown or deadline_ms is not a non-negative number.
+[[nodiscard]] model_service_request model_service_request_from_json(const std::string& text);
 void validate_model_service_response(const model_service_request& request, model_service_response& response);
 [[nodiscard]] std::vector<std::string> model_service_required_capabilities();
+
+// Largest batch the service accepts for `capability`, read from the optional "batch":{"max_size":N}
+// field of its descriptor in a describe output. Returns 1 when batching is not advertised.
+[[nodiscard]] std::size_t model_service_batch_limit(std::string_view describe_output_json, std::string_view capability);
+// Folds invoke requests for one capability into a single invoke whose input is
+// {"batch":[{"id":...,"input":...,"refs":[...]},...]}. The batch deadline is the earliest item deadline.
+[[nodiscard]] model_service_request make_model_service_batch_request(const std::vector<model_service_request>& items,
+                                                                     std::string id);
+// Splits the response to a batch request into one response per item, in item order, each validated
+// against its own request. A failed batch fails every item; missing entries become invalid_output.
+[[nodiscard]] std::vector<model_service_response>
+split_model_service_batch_response(const std::vector<model_service_request>& items,
+                                   const model_service_response& response);
 [[nodiscard]] model_service_compatibility_result
 check_model_service_compatibility(model_service_client& client,
                                   std::vector<std::string> required_capabilities = model_service_required_capabilities(),
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "bt/model_service.hpp"
+
+namespace bt {
+
+struct model_service_mux_options {
+    // Filesystem path of the Unix-domain socket clients connect to. A stale socket file at the path
+    // is replaced.
+    std::string socket_path;
+    // Upstream calls in flight at once; each holds one mux thread until its response arrives.
+    std::size_t upstream_workers = 8;
+    // How long successful invoke responses are served from the shared cache; 0 keeps only the
+    // deduplication of identical in-flight requests. Successful describe responses are always cached.
+    std::int64_t cache_ttl_ms = 0;
+    std::size_t cache_entries = 1024;
+};
+
+struct model_service_mux_stats {
+    std::uint64_t clients = 0;
+    std::uint64_t clients_accepted = 0;
+    std::uint64_t requests = 0;
+    std::uint64_t upstream_calls = 0;
+    // Requests answered by a call another client already had in flight.
+    std::uint64_t deduplicated = 0;
+    std::uint64_t cache_hits = 0;
+};
+
+// Hash of `request` with its id, trace and deadline left out, so identical describe and invoke calls
+// from different clients share a key. Empty for the session ops, which are never shared.
+[[nodiscard]] std::string model_service_dedup_key(const model_service_request& request);
+
+// Owns one upstream model_service_client on behalf of several muslisp processes on the same machine, so
+// they share its connections, its describe gate and a response cache instead of each opening their
+// own. Clients connect to `socket_path` with make_unix_model_service_client (endpoint
+// "unix://<socket_path>").
+//
+// Wire format, both directions: a stream of frames, each a u32 little-endian payload length followed by
+// one MMSP envelope as JSON (model_service_request_to_json / model_service_response_to_json).
+//
+// A describe or invoke request whose model_service_dedup_key matches a call already in flight waits
+// for that call instead of making its own; each waiter gets the response under its own request id.
+// Such duplicates share the first request's deadline.
+class model_service_mux {
+public:
+    // Binds and starts listening before returning. Throws std::runtime_error when the socket cannot be
+    // bound or Unix-domain sockets are unavailable, and std::invalid_argument for an empty path, a
+    // null upstream or zero workers.
+    model_service_mux(model_service_mux_options options, std::unique_ptr<model_service_client> upstream);
+    // Stops accepting, disconnects clients, waits for upstream calls in flight and removes the socket.
+    ~model_service_mux();
+
+    model_service_mux(const model_service_mux&) = delete;
+    model_service_mux& operator=(const model_service_mux&) = delete;
+
+    [[nodiscard]] const model_service_mux_options& options() const noexcept { return options_; }
+    [[nodiscard]] model_service_mux_stats stats() const;
+
+private:
+    struct connection;
+    struct flight;
+    struct cache_entry {
+        model_service_response response;
+        // time_point::max() for describe.
+        std::chrono::steady_clock::time_point expires;
+        std::uint64_t order = 0;
+    };
+
+    void accept_loop();
+    void read_loop(const std::shared_ptr<connection>& conn);
+    void dispatch(const std::shared_ptr<connection>& conn, model_service_request request);
+    void upstream_loop();
+    void finish(const std::shared_ptr<flight>& call, model_service_response response);
+    static void reply(const std::shared_ptr<connection>& conn, const std::string& id, model_service_response response);
+    void reap_connections(bool all);
+
+    model_service_mux_options options_;
+    std::unique_ptr<model_service_client> upstream_;
+    int listen_fd_ = -1;
+    std::atomic<bool> stop_{false};
+
+    mutable std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::deque<std::shared_ptr<flight>> queue_;
+    std::unordered_map<std::string, std::shared_ptr<flight>> in_flight_;
+    std::unordered_map<std::string, cache_entry> cache_;
+    // (order, key) of cache insertions, oldest first, bounded by cache_entries. An entry is evicted when
+    // its record leaves the front; records of entries that already expired are skipped.
+    std::deque<std::pair<std::uint64_t, std::string>> cache_order_;
+    std::uint64_t next_cache_order_ = 0;
+    std::vector<std::shared_ptr<connection>> connections_;
+    model_service_mux_stats stats_{};
+
+    std::vector<std::thread> workers_;
+    std::thread accept_thread_;
+};
+
+// Whether `endpoint` names a model_service_mux socket ("unix://<path>").
+[[nodiscard]] bool is_unix_model_service_endpoint(std::string_view endpoint) noexcept;
+
+// MMSP client for a model_service_mux at config.endpoint ("unix://<path>"). It connects on first use
+// and again after the mux goes away, pipelines requests over one connection, and answers a request
+// as unavailable when no response arrives within config.request_timeout_ms.
+[[nodiscard]] std::unique_ptr<model_service_client> make_unix_model_service_client(model_service_config config);
+
+}  // namespace bt
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace bt {
+
+// What the sender does when sealed frames wait for the link past `max_buffered_bytes`.
+enum class net_overflow_policy : std::uint8_t {
+    // Discard the oldest unsent frames.
+    drop_oldest,
+    // Past three quarters of the bound, keep only every `sample_every`-th line (alerts are always
+    // kept) until the backlog falls to half of it; frames are still dropped oldest-first if that is
+    // not enough.
+    sample,
+};
+
+struct net_sink_options {
+    static constexpr std::size_t k_default_queue_lines = 4096;
+
+    // "tcp://host:port". The host is a numeric IPv4 address or a name resolved once per connect.
+    std::string endpoint;
+    // Lines between event_log::emit and the sender thread; rounded up to a power of two.
+    std::size_t queue_lines = k_default_queue_lines;
+    // A frame is sealed once its lines reach `batch_bytes` or its first line is `batch_interval` old.
+    std::size_t batch_bytes = 64u * 1024u;
+    std::chrono::milliseconds batch_interval{50};
+    // Bound on sealed frames waiting for the link, counted in wire bytes.
+    std::size_t max_buffered_bytes = 4u * 1024u * 1024u;
+    net_overflow_policy overflow = net_overflow_policy::drop_oldest;
+    std::uint32_t sample_every = 10;
+    // Deflates frame payloads when built with zlib (see net_event_sink::compression_supported).
+    bool compress = true;
+    std::chrono::milliseconds reconnect_interval{500};
+};
+
+struct net_sink_stats {
+    bool connected = false;
+    bool sampling = false;
+    std::uint64_t frames_sent = 0;
+    std::uint64_t lines_sent = 0;
+    // Payload bytes before compression and wire bytes including frame headers.
+    std::uint64_t raw_bytes_sent = 0;
+    std::uint64_t wire_bytes_sent = 0;
+    std::uint64_t buffered_bytes = 0;
+    std::uint64_t connects = 0;
+    std::uint64_t disconnects = 0;
+    // Every line that did not reach the socket, by cause: the queue was full at emit, the frame
+    // holding it was discarded under overflow, it was sampled out, or it was lost with a broken link.
+    std::uint64_t dropped_queue_full = 0;
+    std::uint64_t dropped_overflow = 0;
+    std::uint64_t dropped_sampled = 0;
+    std::uint64_t dropped_link = 0;
+
+    [[nodiscard]] std::uint64_t dropped_lines() const noexcept {
+        return dropped_queue_full + dropped_overflow + dropped_sampled + dropped_link;
+    }
+};
+
+// Streams event lines to a remote collector over TCP without ever blocking the producer on the
+// network. Producers copy each line into a slot of a fixed ring, as async_file_sink does; a sender
+// thread drains the ring into frames sealed by size and age, keeps sealed frames in a queue bounded by
+// `max_buffered_bytes`, and writes them with non-blocking sends, reconnecting while the collector is
+// away. Every line that is not delivered is counted in stats() and in the next frame's header.
+//
+// Wire format: a stream of frames, each a 40-byte little-endian header followed by its payload:
+//   char[4] magic "MBTN", u8 version (1), u8 codec (0 raw, 1 zlib deflate), u16 reserved,
+//   u64 frame seq, u32 lines, u32 raw bytes, u32 payload bytes, u32 reserved, u64 dropped lines.
+// The raw payload is the frame's lines, each terminated by '\n'. Seq counts sealed frames from 0 for
+// the sink's lifetime, so a gap marks discarded frames. `dropped lines` is the running total of lines
+// dropped when the frame started sending, so a collector can tell exactly how many it missed between
+// two frames.
+//
+// The ring is single-producer/single-consumer: callers must serialise push() (event_log pushes while
+// holding its own lock).
+class net_event_sink {
+public:
+    static constexpr std::size_t k_frame_header_bytes = 40;
+    static constexpr std::uint8_t k_wire_version = 1;
+    static constexpr std::uint8_t k_codec_raw = 0;
+    static constexpr std::uint8_t k_codec_deflate = 1;
+
+    // Throws std::invalid_argument for a malformed endpoint or option. Does not wait for the
+    // connection; lines emitted before it is up are buffered like any other backlog.
+    explicit net_event_sink(net_sink_options options);
+    // Seals the open frame and gives the sender up to `reconnect_interval` to deliver what is
+    // buffered, then closes the connection.
+    ~net_event_sink();
+
+    net_event_sink(const net_event_sink&) = delete;
+    net_event_sink& operator=(const net_event_sink&) = delete;
+
+    [[nodiscard]] static bool supported() noexcept;
+    [[nodiscard]] static bool compression_supported() noexcept;
+
+    // Queues `line`. `essential` lines (alerts) are exempt from sampling. Returns false if the ring
+    // was full and the line was dropped.
+    bool push(std::string_view line, bool essential = false);
+    // Blocks until every line pushed before the call has been sealed into a frame and that frame has
+    // been sent or dropped, or until `timeout` passes. Returns false on timeout.
+    bool flush(std::chrono::milliseconds timeout);
+
+    [[nodiscard]] const net_sink_options& options() const noexcept;
+    [[nodiscard]] net_sink_stats stats() const;
+
+private:
+    struct slot {
+        std::string line;
+        bool essential = false;
+    };
+    struct frame {
+        std::string bytes;
+        std::uint64_t lines = 0;
+        std::uint64_t raw_bytes = 0;
+    };
+
+    void run();
+    void take_lines(std::chrono::steady_clock::time_point now);
+    void seal_frame();
+    void enforce_bound();
+    // Caller holds stats_mutex_. Starts sampling above three quarters of the buffer bound and stops at
+    // half of it.
+    void update_sampling_locked();
+    void try_connect(std::chrono::steady_clock::time_point now);
+    void close_link(bool lost);
+    void send_pending();
+    void wake();
+
+    net_sink_options options_;
+    std::string host_;
+    std::uint16_t port_ = 0;
+
+    std::vector<slot> slots_;
+    std::size_t mask_ = 0;
+    alignas(64) std::atomic<std::uint64_t> head_{0};
+    alignas(64) std::atomic<std::uint64_t> tail_{0};
+    std::atomic<bool> idle_{false};
+    std::atomic<bool> stopping_{false};
+    std::atomic<std::uint64_t> flush_requested_{0};
+    std::atomic<std::uint64_t> flushed_{0};
+    std::atomic<std::uint64_t> dropped_queue_full_{0};
+
+    // Sender thread state.
+    std::string batch_;
+    std::uint64_t batch_lines_ = 0;
+    std::chrono::steady_clock::time_point batch_started_{};
+    std::deque<frame> frames_;
+    std::size_t front_sent_ = 0;
+    std::uint64_t sample_counter_ = 0;
+    bool sampling_ = false;
+    std::uint64_t next_seq_ = 0;
+    std::chrono::steady_clock::time_point next_connect_{};
+    std::string compress_buffer_;
+    int socket_fd_ = -1;
+    bool connecting_ = false;
+    int wake_read_fd_ = -1;
+    int wake_write_fd_ = -1;
+
+    // Published by the sender for stats().
+    mutable std::mutex stats_mutex_;
+    net_sink_stats stats_{};
+
+    std::thread thread_;
+};
+
+}  // namespace bt
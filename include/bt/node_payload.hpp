@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace bt {
+
+// Typed per-node state slot for stateful leaves (node_memory::payload).
+//
+// A value of up to k_inline_bytes, aligned to at most k_inline_align and nothrow-movable, is stored
+// in the slot itself, so a leaf's state stays in the instance's flat memory array and activating the
+// node does not allocate. Anything else is boxed on the heap. The held type is identified by the
+// address of a per-type operations table, so get<T>() is one pointer compare instead of an RTTI check.
+class node_payload {
+public:
+    static constexpr std::size_t k_inline_bytes = 64;
+    static constexpr std::size_t k_inline_align = alignof(std::max_align_t);
+
+    template <typename T>
+    static constexpr bool stored_inline =
+        sizeof(T) <= k_inline_bytes && alignof(T) <= k_inline_align && std::is_nothrow_move_constructible_v<T>;
+
+    node_payload() noexcept = default;
+    node_payload(node_payload&& other) noexcept { take(other); }
+    node_payload& operator=(node_payload&& other) noexcept {
+        if (this != &other) {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+    ~node_payload() { reset(); }
+
+    node_payload(const node_payload&) = delete;
+    node_payload& operator=(const node_payload&) = delete;
+
+    // Replaces the held value with a T built from `args`.
+    template <typename T, typename... Args>
+    T& emplace(Args&&... args) {
+        static_assert(std::is_same_v<T, std::remove_cvref_t<T>>, "node_payload holds plain object types");
+        reset();
+        T* value = nullptr;
+        if constexpr (stored_inline<T>) {
+            value = ::new (static_cast<void*>(storage_)) T(std::forward<Args>(args)...);
+        } else {
+            value = new T(std::forward<Args>(args)...);
+            ::new (static_cast<void*>(storage_)) T*(value);
+        }
+        ops_ = &ops_for<T>;
+        return *value;
+    }
+
+    // The held value if it is a T, otherwise nullptr.
+    template <typename T>
+    [[nodiscard]] T* get() noexcept {
+        return holds<T>() ? address<T>() : nullptr;
+    }
+    template <typename T>
+    [[nodiscard]] const T* get() const noexcept {
+        return holds<T>() ? const_cast<node_payload*>(this)->address<T>() : nullptr;
+    }
+
+    template <typename T>
+    [[nodiscard]] bool holds() const noexcept {
+        return ops_ == &ops_for<T>;
+    }
+    [[nodiscard]] bool has_value() const noexcept { return ops_ != nullptr; }
+    // True when the held value lives in the slot rather than on the heap.
+    [[nodiscard]] bool is_inline() const noexcept { return ops_ && ops_->inline_storage; }
+
+    void reset() noexcept {
+        if (ops_) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+private:
+    struct operations {
+        bool inline_storage;
+        void (*destroy)(std::byte* storage) noexcept;
+        // Moves the value out of `from` into uninitialised `to` and ends its lifetime in `from`.
+        void (*relocate)(std::byte* from, std::byte* to) noexcept;
+    };
+
+    template <typename T>
+    static void destroy_value(std::byte* storage) noexcept {
+        if constexpr (stored_inline<T>) {
+            std::launder(reinterpret_cast<T*>(storage))->~T();
+        } else {
+            delete *std::launder(reinterpret_cast<T**>(storage));
+        }
+    }
+
+    template <typename T>
+    static void relocate_value(std::byte* from, std::byte* to) noexcept {
+        if constexpr (stored_inline<T>) {
+            T* source = std::launder(reinterpret_cast<T*>(from));
+            ::new (static_cast<void*>(to)) T(std::move(*source));
+            source->~T();
+        } else {
+            ::new (static_cast<void*>(to)) T*(*std::launder(reinterpret_cast<T**>(from)));
+        }
+    }
+
+    template <typename T>
+    static constexpr operations ops_for{stored_inline<T>, &destroy_value<T>, &relocate_value<T>};
+
+    template <typename T>
+    T* address() noexcept {
+        if constexpr (stored_inline<T>) {
+            return std::launder(reinterpret_cast<T*>(storage_));
+        } else {
+            return *std::launder(reinterpret_cast<T**>(storage_));
+        }
+    }
+
+    void take(node_payload& other) noexcept {
+        if (other.ops_) {
+            other.ops_->relocate(other.storage_, storage_);
+            ops_ = std::exchange(other.ops_, nullptr);
+        }
+    }
+
+    alignas(k_inline_align) std::byte storage_[k_inline_bytes];
+    const operations* ops_ = nullptr;
+};
+
+}  // namespace bt
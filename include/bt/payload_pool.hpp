@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace bt {
+
+struct payload_pool_class_stats {
+    std::size_t slab_bytes = 0;
+    std::size_t slabs = 0;
+    std::size_t in_use = 0;
+};
+
+struct payload_pool_stats {
+    std::size_t capacity_bytes = 0;
+    // Bytes of every slab the pool holds, in use or free.
+    std::size_t reserved_bytes = 0;
+    std::size_t in_use_bytes = 0;
+    std::size_t slabs_in_use = 0;
+    std::size_t slabs_free = 0;
+    std::uint64_t acquired = 0;
+    // Acquisitions served from a free slab instead of a new allocation.
+    std::uint64_t reused = 0;
+    // Free slabs dropped to make room for a slab of another size.
+    std::uint64_t trimmed = 0;
+    // Acquisitions refused because slabs in use fill the capacity.
+    std::uint64_t exhausted = 0;
+    // One entry per slab size, smallest first.
+    std::vector<payload_pool_class_stats> classes;
+};
+
+// Bounded pool of payload buffers for frames held in process. Each slab size (one per camera
+// resolution and encoding, in practice) keeps its own free list, so a camera producing one frame per
+// tick reuses the same few slabs instead of allocating. A slab returns to its free list when the last
+// copy of the pointer acquire() handed out is dropped, which may happen on any thread and after the
+// pool itself is gone.
+//
+// The capacity bounds the bytes of all slabs together. When a new slab would not fit, free slabs of
+// other sizes are dropped first; if slabs in use still fill the capacity the acquisition fails.
+class payload_pool {
+public:
+    static constexpr std::size_t k_default_capacity_bytes = std::size_t{256} << 20;
+
+    explicit payload_pool(std::size_t capacity_bytes = k_default_capacity_bytes);
+    ~payload_pool();
+    payload_pool(const payload_pool&) = delete;
+    payload_pool& operator=(const payload_pool&) = delete;
+
+    // A slab of exactly `bytes` bytes, with unspecified contents. Throws std::invalid_argument for 0
+    // bytes and std::length_error when the pool is exhausted.
+    [[nodiscard]] std::shared_ptr<std::byte[]> acquire(std::size_t bytes);
+
+    // A smaller capacity drops free slabs until the pool fits; slabs in use are freed instead of
+    // pooled when they come back while the pool is over capacity.
+    void set_capacity(std::size_t bytes);
+    [[nodiscard]] std::size_t capacity() const;
+    // Drops every free slab.
+    void trim();
+    [[nodiscard]] payload_pool_stats stats() const;
+
+private:
+    struct state;
+
+    std::shared_ptr<state> state_;
+};
+
+}  // namespace bt
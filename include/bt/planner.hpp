@@ -1,20 +1,25 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
-namespace bt {
+#include "bt/planner_vector.hpp"
+#include "bt/scheduler.hpp"
 
-using planner_vector = std::vector<double>;
+namespace bt {
 
 class planner_rng {
 public:
@@ -23,6 +28,10 @@ public:
     [[nodiscard]] double uniform(double lo, double hi);
     [[nodiscard]] std::int64_t uniform_int(std::int64_t n);
     [[nodiscard]] double normal(double mu, double sigma);
+    // Fills `out` with standard normals: the same values, and the same stream position afterwards,
+    // as out.size() calls to normal(0.0, 1.0), but drawn a block at a time in loops without a
+    // dependency between lanes.
+    void fill_normal(std::span<double> out);
 
 private:
     [[nodiscard]] std::uint64_t next_u64();
@@ -70,6 +79,9 @@ enum class planner_ilqr_derivatives_mode {
     finite_diff
 };
 
+// Upper bound on planner_mcts_config::threads and planner_mppi_config::threads.
+inline constexpr std::int64_t k_planner_max_threads = 64;
+
 struct planner_mcts_config {
     double c_ucb = 1.2;
     double pw_k = 2.0;
@@ -80,6 +92,22 @@ struct planner_mcts_config {
     std::string action_sampler = "model_default";
     std::int64_t default_iters = 2000;
     std::int64_t time_check_interval = 8;
+    // Warm start (only with planner_request::mcts_tree): the retained subtree is used when every
+    // state component is within reuse_state_tolerance of the state it predicted, and is cut to at
+    // most reuse_max_nodes nodes (breadth-first) when it is kept.
+    double reuse_state_tolerance = 1.0e-3;
+    std::int64_t reuse_max_nodes = 20000;
+    // Parallel search over `threads` concurrent searches (see planner_service::set_scheduler):
+    //   "none" - one sequential search (the default; `threads` is ignored);
+    //   "root" - `threads` independent trees, tree k seeded from the request seed and k, each with
+    //            the full iteration cap; root visits of children with identical actions are summed;
+    //   "tree" - one shared tree grown in waves of `threads` paths with a virtual loss on the
+    //            children a wave passes; work_max still caps the total iterations.
+    // Results depend on the seed and these settings only, not on how many workers were free.
+    // Both parallel modes call the model from several threads at once.
+    std::string parallelism = "none";
+    std::int64_t threads = 1;
+    double virtual_loss = 1.0;
 };
 
 struct planner_mppi_config {
@@ -89,6 +117,10 @@ struct planner_mppi_config {
     std::int64_t n_elite = 0;
     planner_vector u_init{};
     planner_vector u_nominal{};
+    // Sample blocks are spread over this many threads (see planner_service::set_scheduler). Each
+    // block of 16 samples draws from its own stream split from the request seed and the reduction is
+    // in sample order, so the result is the same for any value; the model is called concurrently.
+    std::int64_t threads = 1;
 };
 
 struct planner_ilqr_config {
@@ -100,6 +132,9 @@ struct planner_ilqr_config {
     planner_vector u_init{};
     planner_ilqr_derivatives_mode derivatives = planner_ilqr_derivatives_mode::analytic;
     double fd_eps = 1.0e-4;
+    // Horizon steps are linearised on this many threads (see planner_service::set_scheduler); the
+    // result does not depend on it. The model is called concurrently.
+    std::int64_t threads = 1;
 };
 
 struct planner_linearisation {
@@ -124,6 +159,20 @@ struct planner_terminal_quadratic_cost {
     std::vector<double> l_xx;
 };
 
+// A block of action sequences laid out structure-of-arrays for batched rollouts: the value of action
+// dimension d at step t of sample s is u[(t * action_dim + d) * samples + s], so one step of every
+// sample is a contiguous run per dimension.
+struct planner_action_batch {
+    std::size_t samples = 0;
+    std::size_t horizon = 0;
+    std::size_t action_dim = 0;
+    const double* u = nullptr;
+
+    [[nodiscard]] const double* row(std::size_t t, std::size_t d) const noexcept {
+        return u + (t * action_dim + d) * samples;
+    }
+};
+
 class planner_model {
 public:
     virtual ~planner_model() = default;
@@ -146,9 +195,24 @@ public:
                                             const std::vector<planner_vector>& action_sequence,
                                             double& cost) const;
 
+    // Batched form of rollout_cost used by MPPI: writes one cost per sample to `costs` (a non-finite
+    // cost rejects the sample). MPPI first calls it with an empty batch; returning true there means
+    // every block of the search goes through it, while returning false, as the default does, has each
+    // sample rolled out through rollout_cost or step instead.
+    [[nodiscard]] virtual bool rollout_cost_batch(const planner_vector& state,
+                                                  const planner_action_batch& batch,
+                                                  std::span<double> costs,
+                                                  planner_rng& rng) const;
+
     [[nodiscard]] virtual bool deterministic_step(const planner_vector& state,
                                                   const planner_vector& action,
                                                   planner_step_result& out) const;
+    // Batched form of deterministic_step used by iLQR finite differences: writes out[i] for
+    // (states[i], actions[i]), all spans having the same length. Returning false, as the default
+    // does, has each pair evaluated through deterministic_step or step instead.
+    [[nodiscard]] virtual bool deterministic_step_batch(std::span<const planner_vector> states,
+                                                        std::span<const planner_vector> actions,
+                                                        std::span<planner_step_result> out) const;
 
     [[nodiscard]] virtual bool linearise_dynamics(const planner_vector& state,
                                                   const planner_vector& action,
@@ -186,6 +250,8 @@ struct planner_trace_mcts {
     std::int64_t root_visits = 0;
     std::int64_t root_children = 0;
     std::int64_t widen_added = 0;
+    // Root visits carried over from the previous search by a warm start (0 for a fresh tree).
+    std::int64_t reused_visits = 0;
     std::vector<planner_top_choice_mcts> top_k{};
 };
 
@@ -202,6 +268,10 @@ struct planner_trace_ilqr {
     double cost_init = 0.0;
     double cost_final = 0.0;
     double reg_final = 0.0;
+    // Set when the solve started from a planner_ilqr_warm_start; iters_saved is how many fewer
+    // iterations it took than the last solve that started cold.
+    bool warm_started = false;
+    std::int64_t iters_saved = 0;
     std::vector<planner_top_choice_mppi> top_k{};
 };
 
@@ -211,8 +281,18 @@ struct planner_trace {
     planner_trace_ilqr ilqr;
 };
 
+// How plan-action chose budget_ms. In adaptive mode the budget is the tick time left when the planner
+// started (`slack_ms`) less a margin learned from the work that followed earlier plans (`margin_ms`),
+// clamped to the node's min and max.
+struct planner_budget_choice {
+    bool adaptive = false;
+    double slack_ms = 0.0;
+    double margin_ms = 0.0;
+};
+
 struct planner_stats {
     std::int64_t budget_ms = 0;
+    planner_budget_choice budget_choice{};
     std::int64_t time_used_ms = 0;
     std::int64_t work_done = 0;
     std::uint64_t seed = 0;
@@ -220,6 +300,67 @@ struct planner_stats {
     std::string note;
 };
 
+struct planner_mcts_tree_state;
+
+// MCTS search tree kept by a caller between plan() calls, so that consecutive plans from nearly
+// the same state share their statistics. After a search the backend keeps the subtree under the
+// action it returned, together with the state that action is predicted to lead to. The next search
+// given the same tree starts from that subtree if the request state matches the prediction within
+// planner_mcts_config::reuse_state_tolerance, and from an empty tree otherwise.
+//
+// A tree must not be used by two plan() calls at once.
+class planner_mcts_tree {
+public:
+    planner_mcts_tree();
+    ~planner_mcts_tree();
+    planner_mcts_tree(planner_mcts_tree&&) noexcept;
+    planner_mcts_tree& operator=(planner_mcts_tree&&) noexcept;
+
+    planner_mcts_tree(const planner_mcts_tree&) = delete;
+    planner_mcts_tree& operator=(const planner_mcts_tree&) = delete;
+
+    // Nodes retained for the next search.
+    [[nodiscard]] std::size_t retained_nodes() const noexcept;
+    void clear() noexcept;
+
+    [[nodiscard]] planner_mcts_tree_state& state() noexcept { return *state_; }
+
+private:
+    std::unique_ptr<planner_mcts_tree_state> state_;
+};
+
+struct planner_ilqr_warm_start_state;
+
+// iLQR solution kept by a caller between plan() calls for receding-horizon use. After a solve the
+// backend keeps its control sequence shifted one step ahead (the last control repeated) and its
+// final regularisation. The next solve given the same warm start begins from that sequence, and
+// from that regularisation capped at ilqr.reg_init, instead of ilqr.u_init and ilqr.reg_init,
+// provided the model service, action dimensions and horizon are unchanged. The forward pass runs
+// from the request state, so a state that drifted from the prediction only costs iterations.
+//
+// A warm start must not be used by two plan() calls at once.
+class planner_ilqr_warm_start {
+public:
+    planner_ilqr_warm_start();
+    ~planner_ilqr_warm_start();
+    planner_ilqr_warm_start(planner_ilqr_warm_start&&) noexcept;
+    planner_ilqr_warm_start& operator=(planner_ilqr_warm_start&&) noexcept;
+
+    planner_ilqr_warm_start(const planner_ilqr_warm_start&) = delete;
+    planner_ilqr_warm_start& operator=(const planner_ilqr_warm_start&) = delete;
+
+    // Horizon steps of the retained control sequence (0 when nothing is retained).
+    [[nodiscard]] std::size_t retained_steps() const noexcept;
+    void clear() noexcept;
+
+    [[nodiscard]] planner_ilqr_warm_start_state& state() noexcept { return *state_; }
+
+private:
+    std::unique_ptr<planner_ilqr_warm_start_state> state_;
+};
+
+class planner_progress;
+
 struct planner_request {
     std::string schema_version = "planner.request.v1";
     planner_backend planner = planner_backend::mcts;
@@ -227,6 +368,8 @@ struct planner_request {
     planner_vector state;
 
     std::int64_t budget_ms = 20;
+    // Filled by plan-action when it picked budget_ms itself; copied into the stats and record.
+    planner_budget_choice budget_choice{};
     std::int64_t work_max = 0;
     std::int64_t horizon = 0;
     std::int64_t dt_ms = 0;
@@ -242,6 +385,18 @@ struct planner_request {
     planner_mcts_config mcts{};
     planner_mppi_config mppi{};
     planner_ilqr_config ilqr{};
+    // Optional warm-start tree for the MCTS backend; other backends ignore it.
+    planner_mcts_tree* mcts_tree = nullptr;
+    // Optional receding-horizon warm start for the iLQR backend; other backends ignore it.
+    planner_ilqr_warm_start* ilqr_warm_start = nullptr;
+    // Optional slot that receives best-so-far results while the plan runs, then the final result.
+    planner_progress* progress = nullptr;
+    // Minimum time between two best-so-far results published to `progress`.
+    std::int64_t progress_interval_ms = 1;
+    // Opt-in result cache (see planner_service::set_cache_enabled): when positive, a request whose
+    // model, backend, configuration and state rounded to multiples of cache_quantum match an earlier
+    // :ok result gets that result back without searching. Requests with a warm start never use it.
+    double cache_quantum = 0.0;
 
     std::string run_id = "default";
     std::uint64_t tick_index = 0;
@@ -260,6 +415,47 @@ struct planner_result {
     std::string error;
 };
 
+// Results of one running plan() call, handed from the planning threads to one reader without
+// locks. The backends publish a best-so-far result (status ok, note "partial") at most every
+// planner_request::progress_interval_ms while they search: the most visited root action for MCTS,
+// the first action of the cheapest sample so far for MPPI (confidence 0), and the first control of
+// the latest accepted iLQR iteration. plan() publishes its final result last and then marks the slot
+// finished.
+//
+// The slot is a triple buffer, so neither side waits for the other and the reader always sees the
+// newest whole result. Publishers must not publish concurrently; a slot serves one plan() call.
+class planner_progress {
+public:
+    planner_progress() = default;
+
+    planner_progress(const planner_progress&) = delete;
+    planner_progress& operator=(const planner_progress&) = delete;
+
+    // Reader side. Moves the newest result published since the last take() into `out`, returning
+    // false and leaving `out` alone when nothing new was published. After finished() has returned
+    // true, the next take() yields the final result unless an earlier take() already did.
+    bool take(planner_result& out);
+    [[nodiscard]] bool finished() const noexcept { return finished_.load(std::memory_order_acquire); }
+    // Results published so far, the final one included.
+    [[nodiscard]] std::uint64_t published() const noexcept { return published_.load(std::memory_order_acquire); }
+
+    // Writer side.
+    void publish(const planner_result& result);
+    void finish(const planner_result& result);
+
+private:
+    static constexpr std::uint32_t k_fresh = 4;
+
+    planner_result slots_[3];
+    // Index of the slot between writer and reader, or'ed with k_fresh when the writer filled it
+    // after the reader last swapped it out.
+    std::atomic<std::uint32_t> middle_{1};
+    std::uint32_t back_ = 0;
+    std::uint32_t front_ = 2;
+    std::atomic<std::uint64_t> published_{0};
+    std::atomic<bool> finished_{false};
+};
+
 struct planner_record {
     std::string schema_version = "planner.v1";
     std::int64_t ts_ms = 0;
@@ -269,6 +465,7 @@ struct planner_record {
     planner_backend planner = planner_backend::mcts;
     planner_status status = planner_status::error;
     std::int64_t budget_ms = 0;
+    planner_budget_choice budget_choice{};
     std::int64_t time_used_ms = 0;
     std::int64_t work_done = 0;
     planner_action action;
@@ -282,49 +479,114 @@ struct planner_record {
 
 class planner_service {
 public:
-    using record_listener = std::function<void(const planner_record&, const std::string&)>;
+    // Called on the planning thread for every record, in plan() order. Listeners that need the
+    // JSON form build it with record_to_json() only when they will use it.
+    using record_listener = std::function<void(const planner_record&)>;
 
     planner_service();
+    // Writes any JSONL records still queued, then stops the writer thread.
+    ~planner_service();
+
+    planner_service(const planner_service&) = delete;
+    planner_service& operator=(const planner_service&) = delete;
 
     void register_model(std::string name, std::shared_ptr<planner_model> model);
     [[nodiscard]] bool has_model(std::string_view name) const;
 
-    [[nodiscard]] planner_result plan(const planner_request& request);
+    // Backends check `cancel` wherever they check the budget deadline; a cancelled plan stops there
+    // like a timed-out one, returns its best action so far and notes "cancelled" in its stats.
+    [[nodiscard]] planner_result plan(const planner_request& request, const cancel_token& cancel = {});
+
+    // Workers for parallel MCTS (planner_mcts_config::parallelism). Without one, parallel searches
+    // run their shares one after the other on the calling thread, with the same results.
+    void set_scheduler(scheduler* sched) noexcept;
+    [[nodiscard]] scheduler* scheduler_ptr() const noexcept;
 
     [[nodiscard]] std::uint64_t base_seed() const noexcept;
     void set_base_seed(std::uint64_t seed) noexcept;
 
     [[nodiscard]] std::uint64_t derive_seed(std::string_view node_name, std::uint64_t tick_index) const;
 
+    // Results cached for requests with a positive cache_quantum live for the TTL and at most
+    // `capacity` are kept. A hit is returned with work_done 0 and note "cache_hit", and its action
+    // came from an earlier seed, so runs that must replay bit for bit disable the cache (the runtime
+    // host does in deterministic test mode). Registering a model clears the cache.
+    void set_cache_enabled(bool enabled);
+    [[nodiscard]] bool cache_enabled() const noexcept;
+    void set_cache_ttl_ms(std::int64_t ttl_ms);
+    [[nodiscard]] std::int64_t cache_ttl_ms() const noexcept;
+    void set_cache_capacity(std::size_t capacity);
+    [[nodiscard]] std::size_t cache_capacity() const noexcept;
+    void clear_cache();
+
     [[nodiscard]] static std::uint64_t hash64(std::string_view text) noexcept;
 
+    // Records are kept in a fixed ring of record_capacity slots that keep their allocations, so
+    // logging a plan costs the planning thread one record copy. With JSONL output on, a writer
+    // thread started on first use serialises the new records and appends them to the file in
+    // batches. Records the writer has not reached before the ring wraps over them are not written
+    // and are counted in jsonl_dropped().
     void set_jsonl_path(std::string path);
     [[nodiscard]] const std::string& jsonl_path() const noexcept;
     void set_jsonl_enabled(bool enabled) noexcept;
     [[nodiscard]] bool jsonl_enabled() const noexcept;
+    // Blocks until every record logged so far with JSONL output on has been written.
+    void flush_jsonl();
+    [[nodiscard]] std::uint64_t jsonl_dropped() const noexcept;
 
     [[nodiscard]] std::vector<planner_record> recent_records(std::size_t max_count) const;
     [[nodiscard]] std::string dump_recent_records(std::size_t max_count) const;
     void clear_records();
     void set_record_listener(record_listener listener);
+    [[nodiscard]] std::string record_to_json(const planner_record& record) const;
 
 private:
-    void append_record(planner_record record);
-    [[nodiscard]] std::string record_to_json(const planner_record& record) const;
-    void append_jsonl_line(const std::string& line);
+    struct cache_entry {
+        planner_result result;
+        std::chrono::steady_clock::time_point expires_at{};
+    };
+
+    [[nodiscard]] bool cache_lookup(const std::string& key, planner_result& out);
+    void cache_store(const std::string& key, const planner_result& result);
+    // Drops expired entries, then arbitrary ones, until at most `max_entries` remain.
+    void evict_cache_to(std::size_t max_entries);
+
+    struct record_slot {
+        planner_record record;
+        bool to_jsonl = false;
+    };
+
+    void append_record(const planner_record& record);
+    void run_jsonl_writer();
 
     std::unordered_map<std::string, std::shared_ptr<planner_model>> models_;
 
     std::uint64_t base_seed_ = 0x4d6f6f736c694254ull;
+    std::atomic<scheduler*> scheduler_{nullptr};
+
+    std::unordered_map<std::string, cache_entry> cache_;
+    bool cache_enabled_ = true;
+    std::size_t cache_capacity_ = 256;
+    std::int64_t cache_ttl_ms_ = 750;
 
-    std::vector<planner_record> records_;
+    // Record n (counting from 0) lives in records_[n % record_capacity_].
+    std::vector<record_slot> records_;
     std::size_t record_capacity_ = 4096;
+    std::uint64_t record_next_ = 0;
+    // First record recent_records() reports (raised by clear_records()).
+    std::uint64_t record_history_begin_ = 0;
 
-    bool jsonl_enabled_ = false;
+    std::atomic<bool> jsonl_enabled_{false};
     std::string jsonl_path_ = "logs/run.jsonl";
+    // Records before jsonl_written_ have been written or skipped.
+    std::uint64_t jsonl_written_ = 0;
+    std::atomic<std::uint64_t> jsonl_dropped_{0};
+    bool jsonl_stop_ = false;
+    std::condition_variable jsonl_wake_;
+    std::condition_variable jsonl_done_;
+    std::thread jsonl_writer_;
 
     mutable std::mutex mutex_;
-    mutable std::mutex file_mutex_;
     record_listener record_listener_;
 };
 
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bt/planner.hpp"
+#include "muslisp/value.hpp"
+
+namespace bt {
+
+// A planner model written as numeric Lisp expressions (see planner.define-model).
+//
+// Each expression is compiled once into bytecode that runs on a small stack of doubles, so model
+// calls never enter the evaluator or touch the Lisp heap, and batched MPPI rollouts work on flat
+// buffers without allocating per step. The expressions are a numeric subset of the language:
+//   - number literals; (vec.get x i), (vec.get u i) and, in cost and done, (vec.get next i) with a
+//     literal index, where x is the state, u the clamped action and next the new state;
+//   - + - * / min max abs sqrt exp log sin cos tan tanh atan2 pow floor clamp;
+//   - < <= > >= = (1.0 or 0.0), and or not, and if, all treating any non-zero value as true;
+//   - (let ((name expr) ...) body), binding names visible in body.
+// Anything else is rejected when the model is compiled.
+struct planner_model_definition {
+    std::size_t state_dim = 0;
+    // One entry per action dimension; actions are clamped to these bounds and sampled uniformly in them.
+    std::vector<planner_bound> action_bounds;
+    // One expression per state dimension, giving the next state.
+    std::vector<muslisp::value> next_state;
+    // Stage cost of the step (reward is its negation).
+    muslisp::value cost = nullptr;
+    // Optional; the episode ends after a step where it is true.
+    muslisp::value done = nullptr;
+    std::int64_t default_horizon = 0;
+    std::int64_t default_dt_ms = 0;
+};
+
+// Compiles `def` into a model. Throws std::invalid_argument, naming `name` and the offending form,
+// when an expression falls outside the subset above or the dimensions do not match.
+[[nodiscard]] std::shared_ptr<planner_model> compile_planner_model(const std::string& name,
+                                                                   const planner_model_definition& def);
+
+}  // namespace bt
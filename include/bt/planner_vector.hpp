@@ -0,0 +1,240 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace bt {
+
+// Dense vector of doubles used for planner states, actions, bounds and samples.
+//
+// Up to k_inline_capacity values live in the object itself, so the vectors the backends copy, clamp
+// and step through for typical state and action sizes never allocate. Longer vectors spill to one
+// heap block. Both the inline buffer and the heap block are aligned to k_alignment bytes, which lets
+// the compiler use aligned vector loads on data(). The interface is the subset of std::vector<double>
+// the planner uses; iterators are plain pointers and are invalidated by anything that changes the
+// size or capacity.
+class planner_vector {
+public:
+    using value_type = double;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = double&;
+    using const_reference = const double&;
+    using pointer = double*;
+    using const_pointer = const double*;
+    using iterator = double*;
+    using const_iterator = const double*;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    static constexpr std::size_t k_inline_capacity = 16;
+    static constexpr std::size_t k_alignment = 32;
+
+    planner_vector() noexcept = default;
+    explicit planner_vector(std::size_t count, double value = 0.0) { assign(count, value); }
+    planner_vector(std::initializer_list<double> values) { assign(values.begin(), values.end()); }
+    template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+    planner_vector(InputIt first, InputIt last) {
+        assign(first, last);
+    }
+    explicit planner_vector(std::span<const double> values) { assign(values.begin(), values.end()); }
+
+    planner_vector(const planner_vector& other) { assign(other.begin(), other.end()); }
+    planner_vector(planner_vector&& other) noexcept { take(other); }
+    planner_vector& operator=(const planner_vector& other) {
+        if (this != &other) {
+            assign(other.begin(), other.end());
+        }
+        return *this;
+    }
+    planner_vector& operator=(planner_vector&& other) noexcept {
+        if (this != &other) {
+            if (other.on_heap()) {
+                release();
+                take(other);
+            } else {
+                // Keep our own heap block, if any, rather than trading it for an inline copy.
+                std::copy(other.data_, other.data_ + other.size_, data_);
+                size_ = other.size_;
+                other.size_ = 0;
+            }
+        }
+        return *this;
+    }
+    planner_vector& operator=(std::initializer_list<double> values) {
+        assign(values.begin(), values.end());
+        return *this;
+    }
+    ~planner_vector() { release(); }
+
+    void assign(std::size_t count, double value) {
+        clear();
+        reserve(count);
+        std::fill_n(data_, count, value);
+        size_ = count;
+    }
+    template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+    void assign(InputIt first, InputIt last) {
+        clear();
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag,
+                                        typename std::iterator_traits<InputIt>::iterator_category>) {
+            const auto count = static_cast<std::size_t>(std::distance(first, last));
+            reserve(count);
+            std::copy(first, last, data_);
+            size_ = count;
+        } else {
+            for (; first != last; ++first) {
+                push_back(*first);
+            }
+        }
+    }
+    void assign(std::initializer_list<double> values) { assign(values.begin(), values.end()); }
+
+    [[nodiscard]] double& operator[](std::size_t i) noexcept { return data_[i]; }
+    [[nodiscard]] const double& operator[](std::size_t i) const noexcept { return data_[i]; }
+    [[nodiscard]] double& at(std::size_t i) {
+        if (i >= size_) {
+            throw std::out_of_range("planner_vector::at: index out of range");
+        }
+        return data_[i];
+    }
+    [[nodiscard]] const double& at(std::size_t i) const {
+        if (i >= size_) {
+            throw std::out_of_range("planner_vector::at: index out of range");
+        }
+        return data_[i];
+    }
+    [[nodiscard]] double& front() noexcept { return data_[0]; }
+    [[nodiscard]] const double& front() const noexcept { return data_[0]; }
+    [[nodiscard]] double& back() noexcept { return data_[size_ - 1]; }
+    [[nodiscard]] const double& back() const noexcept { return data_[size_ - 1]; }
+    [[nodiscard]] double* data() noexcept { return data_; }
+    [[nodiscard]] const double* data() const noexcept { return data_; }
+
+    [[nodiscard]] iterator begin() noexcept { return data_; }
+    [[nodiscard]] const_iterator begin() const noexcept { return data_; }
+    [[nodiscard]] const_iterator cbegin() const noexcept { return data_; }
+    [[nodiscard]] iterator end() noexcept { return data_ + size_; }
+    [[nodiscard]] const_iterator end() const noexcept { return data_ + size_; }
+    [[nodiscard]] const_iterator cend() const noexcept { return data_ + size_; }
+    [[nodiscard]] reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+    [[nodiscard]] const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+    [[nodiscard]] reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+    [[nodiscard]] const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+
+    [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+    [[nodiscard]] std::size_t size() const noexcept { return size_; }
+    [[nodiscard]] std::size_t capacity() const noexcept { return capacity_; }
+    // True while the values are held in the object rather than in a heap block.
+    [[nodiscard]] bool is_inline() const noexcept { return !on_heap(); }
+
+    void reserve(std::size_t capacity) {
+        if (capacity > capacity_) {
+            grow_to(capacity);
+        }
+    }
+    void clear() noexcept { size_ = 0; }
+    void resize(std::size_t count, double value = 0.0) {
+        if (count > size_) {
+            reserve(count);
+            std::fill(data_ + size_, data_ + count, value);
+        }
+        size_ = count;
+    }
+    void push_back(double value) {
+        if (size_ == capacity_) {
+            grow_to(capacity_ * 2);
+        }
+        data_[size_++] = value;
+    }
+    double& emplace_back(double value) {
+        push_back(value);
+        return back();
+    }
+    void pop_back() noexcept { --size_; }
+    template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+    iterator insert(const_iterator pos, InputIt first, InputIt last) {
+        const auto offset = static_cast<std::size_t>(pos - data_);
+        planner_vector tail(data_ + offset, data_ + size_);
+        size_ = offset;
+        for (; first != last; ++first) {
+            push_back(*first);
+        }
+        for (const double value : tail) {
+            push_back(value);
+        }
+        return data_ + offset;
+    }
+    iterator insert(const_iterator pos, double value) {
+        const double* one = &value;
+        return insert(pos, one, one + 1);
+    }
+    iterator erase(const_iterator first, const_iterator last) noexcept {
+        double* out = data_ + (first - data_);
+        const double* rest = last;
+        std::copy(rest, static_cast<const double*>(data_ + size_), out);
+        size_ -= static_cast<std::size_t>(last - first);
+        return out;
+    }
+    iterator erase(const_iterator pos) noexcept { return erase(pos, pos + 1); }
+
+    void swap(planner_vector& other) noexcept {
+        planner_vector tmp(std::move(other));
+        other = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+    friend bool operator==(const planner_vector& a, const planner_vector& b) noexcept {
+        return a.size_ == b.size_ && std::equal(a.begin(), a.end(), b.begin());
+    }
+
+private:
+    [[nodiscard]] bool on_heap() const noexcept { return data_ != inline_; }
+
+    void grow_to(std::size_t capacity) {
+        capacity = std::max(capacity, k_inline_capacity * 2);
+        auto* block = static_cast<double*>(::operator new(capacity * sizeof(double), std::align_val_t{k_alignment}));
+        std::copy(data_, data_ + size_, block);
+        release();
+        data_ = block;
+        capacity_ = capacity;
+    }
+
+    void release() noexcept {
+        if (on_heap()) {
+            ::operator delete(data_, std::align_val_t{k_alignment});
+            data_ = inline_;
+            capacity_ = k_inline_capacity;
+        }
+    }
+
+    // Leaves `other` empty and inline.
+    void take(planner_vector& other) noexcept {
+        if (other.on_heap()) {
+            data_ = std::exchange(other.data_, other.inline_);
+            capacity_ = std::exchange(other.capacity_, k_inline_capacity);
+        } else {
+            std::copy(other.data_, other.data_ + other.size_, inline_);
+        }
+        size_ = std::exchange(other.size_, 0);
+    }
+
+    alignas(k_alignment) double inline_[k_inline_capacity];
+    double* data_ = inline_;
+    std::size_t size_ = 0;
+    std::size_t capacity_ = k_inline_capacity;
+};
+
+inline void swap(planner_vector& a, planner_vector& b) noexcept {
+    a.swap(b);
+}
+
+}  // namespace bt
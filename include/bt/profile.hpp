@@ -1,22 +1,95 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <string>
 
 #include "bt/ast.hpp"
 
+namespace muslisp {
+class gc;
+}
+
 namespace bt {
 
+class clock_interface;
+
+// Log-linear (HDR-style) histogram of nanosecond durations. Values below k_sub_buckets land in
+// exact buckets; above that, each power of two is split into k_sub_buckets equal buckets, so a
+// bucket's width is at most 1/k_sub_buckets of its lower bound. Durations past
+// 2^(k_max_exponent + 1) ns (about 37 minutes) are counted in the last bucket.
+//
+// record() and merge() assume a single writer (each histogram in this runtime is updated under its
+// owner's lock or from the ticking thread only); buckets are relaxed atomics so readers may copy or
+// query a histogram while it is written. Copies load each bucket separately.
+class latency_histogram {
+public:
+    static constexpr std::size_t k_sub_bucket_bits = 3;
+    static constexpr std::size_t k_sub_buckets = std::size_t{1} << k_sub_bucket_bits;
+    static constexpr std::size_t k_max_exponent = 40;
+    static constexpr std::size_t k_bucket_count = k_sub_buckets * (k_max_exponent - k_sub_bucket_bits + 2);
+
+    latency_histogram() noexcept = default;
+    latency_histogram(const latency_histogram& other) noexcept;
+    latency_histogram& operator=(const latency_histogram& other) noexcept;
+
+    void record(std::chrono::nanoseconds sample) noexcept;
+    void merge(const latency_histogram& other) noexcept;
+    void reset() noexcept;
+
+    [[nodiscard]] std::uint64_t count() const noexcept;
+    [[nodiscard]] std::uint64_t bucket_count_at(std::size_t bucket) const noexcept;
+    // Largest value that falls in `bucket` (inclusive).
+    [[nodiscard]] static std::chrono::nanoseconds bucket_upper_bound(std::size_t bucket) noexcept;
+    [[nodiscard]] static std::size_t bucket_index(std::chrono::nanoseconds sample) noexcept;
+    // Upper bound of the bucket holding the sample at quantile `q` (0..1); zero when empty.
+    [[nodiscard]] std::chrono::nanoseconds quantile(double q) const noexcept;
+
+private:
+    std::array<std::atomic<std::uint64_t>, k_bucket_count> buckets_{};
+    std::atomic<std::uint64_t> count_{0};
+};
+
 struct duration_stats {
     std::uint64_t count = 0;
     std::chrono::nanoseconds last{0};
     std::chrono::nanoseconds max{0};
     std::chrono::nanoseconds total{0};
     std::uint64_t over_budget_count = 0;
+    latency_histogram histogram;
 
     void observe(std::chrono::nanoseconds sample, std::chrono::nanoseconds budget = std::chrono::nanoseconds{0});
+    // Histogram quantile, capped at max (a bucket's upper bound can exceed every sample in it).
+    [[nodiscard]] std::chrono::nanoseconds percentile(double q) const noexcept;
+};
+
+// Quantiles reported by the stats dumps, as (label, q) pairs: p50, p90, p99, p999.
+struct reported_quantile {
+    const char* label;
+    double q;
 };
+inline constexpr std::array<reported_quantile, 4> k_reported_quantiles{
+    {{"p50", 0.50}, {"p90", 0.90}, {"p99", 0.99}, {"p999", 0.999}}};
+
+// How end_node_visit times nodes. `off` still counts each node's returns but reads no clock for
+// them; `sampled` times a subset of visits; `full` times every visit. Untimed visits leave dur_ms
+// out of their node_exit/node_status events and record no duration in the trace.
+enum class node_profiling_mode : std::uint8_t { off, sampled, full };
+
+struct node_profiling_options {
+    node_profiling_mode mode = node_profiling_mode::full;
+    // sampled: time nodes on every Nth tick (by tick index)...
+    std::uint32_t every_n_ticks = 1;
+    // ...and on those ticks, roughly this percentage of nodes, picked afresh each tick.
+    std::uint32_t node_percent = 100;
+    // Clock node durations are read from; nullptr means profile_clock::shared().
+    const clock_interface* timer = nullptr;
+};
+
+const char* node_profiling_mode_name(node_profiling_mode mode) noexcept;
 
 struct node_profile_stats {
     node_id id = 0;
@@ -25,25 +98,139 @@ struct node_profile_stats {
     std::uint64_t running_returns = 0;
     std::uint64_t success_returns = 0;
     std::uint64_t failure_returns = 0;
+    // GC heap objects and bytes allocated by the node itself, excluding its children's visits, on
+    // every visit whatever the profiling mode.
+    std::uint64_t alloc_objects = 0;
+    std::uint64_t alloc_bytes = 0;
+};
+
+// Subsystems a tick's time is charged to by tick_ledger. `other` is whatever no category claimed:
+// tree traversal, tracing and the runtime's own bookkeeping.
+enum class ledger_category : std::uint8_t {
+    lisp_leaves,
+    native_leaves,
+    planner,
+    vla_submit,
+    vla_poll,
+    scheduler,
+    bb_write,
+    events,
+    gc,
+    other,
+};
+inline constexpr std::size_t k_ledger_category_count = 10;
+
+const char* ledger_category_name(ledger_category category) noexcept;
+
+struct tick_ledger_sample {
+    // Indexed by ledger_category.
+    std::array<std::uint64_t, k_ledger_category_count> ns{};
+    std::uint64_t wall_ns = 0;
+};
+
+// Per-tick time accounting by subsystem. Categories are exclusive: entering one pauses the one that
+// was open, so a blackboard write made inside an action callback counts as bb_write and not as the
+// callback. GC pauses count as gc wherever they fall. While a tick runs, its ledger is the thread's
+// current() one, so the scheduler and the event log charge themselves without seeing the tick.
+class tick_ledger {
+public:
+    tick_ledger() = default;
+    // Stops being the thread's current ledger if finish() was never reached.
+    ~tick_ledger();
+    tick_ledger(const tick_ledger&) = delete;
+    tick_ledger& operator=(const tick_ledger&) = delete;
+
+    // Starts the ledger and makes it the thread's current one. `heap` may be nullptr, which leaves
+    // GC pauses in the category they interrupt.
+    void start(const clock_interface& clock, const muslisp::gc* heap) noexcept;
+    // Closes the open category, charges the unclaimed rest to `other` and puts back the ledger that
+    // was current before start().
+    tick_ledger_sample finish() noexcept;
+
+    // Charges the time since the last switch and opens `category`; returns what to pass to leave().
+    [[nodiscard]] std::uint8_t enter(ledger_category category) noexcept;
+    void leave(std::uint8_t previous) noexcept;
+
+    [[nodiscard]] static tick_ledger* current() noexcept;
+
+private:
+    static constexpr std::uint8_t k_none = 0xff;
+
+    void charge() noexcept;
+
+    const clock_interface* clock_ = nullptr;
+    const muslisp::gc* heap_ = nullptr;
+    tick_ledger* outer_ = nullptr;
+    std::chrono::steady_clock::time_point started_at_{};
+    std::chrono::steady_clock::time_point since_{};
+    std::uint64_t pause_ns_ = 0;
+    std::uint8_t open_ = k_none;
+    tick_ledger_sample sample_{};
+};
+
+// Charges its lifetime to `category` on a ledger, by default the thread's current one, if any.
+class ledger_scope {
+public:
+    explicit ledger_scope(ledger_category category) noexcept : ledger_scope(tick_ledger::current(), category) {}
+    // Charges to `ledger`, which may be nullptr.
+    ledger_scope(tick_ledger* ledger, ledger_category category) noexcept : ledger_(ledger) {
+        if (ledger_) {
+            previous_ = ledger_->enter(category);
+        }
+    }
+    ~ledger_scope() {
+        if (ledger_) {
+            ledger_->leave(previous_);
+        }
+    }
+    ledger_scope(const ledger_scope&) = delete;
+    ledger_scope& operator=(const ledger_scope&) = delete;
+
+private:
+    tick_ledger* ledger_ = nullptr;
+    std::uint8_t previous_ = 0;
+};
+
+// Rolling view of an instance's ledgered ticks, per category: the total, the largest single tick,
+// and an exponentially weighted mean over roughly the last 16 ticks.
+struct tick_ledger_stats {
+    static constexpr double k_recent_alpha = 1.0 / 16.0;
+
+    std::uint64_t ticks = 0;
+    std::array<std::uint64_t, k_ledger_category_count> total_ns{};
+    std::array<std::uint64_t, k_ledger_category_count> max_ns{};
+    std::array<double, k_ledger_category_count> recent_ns{};
+
+    void observe(const tick_ledger_sample& sample) noexcept;
 };
 
 struct tree_profile_stats {
     duration_stats tick_duration;
     std::uint64_t tick_count = 0;
     std::uint64_t tick_overrun_count = 0;
+    std::uint64_t memo_hit_count = 0;
     std::chrono::nanoseconds configured_tick_budget{0};
+    tick_ledger_stats ledger;
 };
 
+// Number of bt::job_priority classes.
+inline constexpr std::size_t k_job_priority_count = 3;
+
 struct scheduler_profile_stats {
     std::uint64_t submitted = 0;
     std::uint64_t started = 0;
     std::uint64_t completed = 0;
     std::uint64_t failed = 0;
+    // Includes expired jobs.
     std::uint64_t cancelled = 0;
     std::uint64_t queue_overflow = 0;
+    // Jobs cancelled because their deadline passed before a worker started them.
+    std::uint64_t expired = 0;
 
     duration_stats queue_delay;
     duration_stats run_time;
+    // queue_delay split by job_priority.
+    std::array<duration_stats, k_job_priority_count> queue_delay_by_priority{};
 };
 
 }  // namespace bt
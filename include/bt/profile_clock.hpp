@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "bt/instance.hpp"
+
+namespace bt {
+
+// A clock_interface for timing nodes cheaply. It reads the CPU timestamp counter when the CPU
+// reports an invariant TSC (x86-64), otherwise clock_gettime(CLOCK_MONOTONIC_RAW), otherwise
+// steady_clock. Readings are mapped onto steady_clock's timeline at construction, so they can be
+// compared with steady_clock times, but they are not slewed with it: over hours the two drift apart
+// by up to the NTP slew rate. Use it to measure durations, not to schedule against.
+class profile_clock final : public clock_interface {
+public:
+    enum class source : std::uint8_t { tsc, monotonic_raw, steady };
+
+    // Falls back down the list above when `preferred` is not available. Calibrating the TSC spins
+    // for about two milliseconds.
+    explicit profile_clock(source preferred = source::tsc);
+
+    std::chrono::steady_clock::time_point now() const override;
+
+    [[nodiscard]] source active_source() const noexcept { return source_; }
+    // Counter ticks per nanosecond; 1 for the non-TSC sources.
+    [[nodiscard]] double ticks_per_ns() const noexcept { return ticks_per_ns_; }
+
+    // Process-wide instance, calibrated on first use.
+    static const profile_clock& shared();
+
+private:
+    std::uint64_t read_counter() const noexcept;
+
+    source source_ = source::steady;
+    double ticks_per_ns_ = 1.0;
+    double ns_per_tick_ = 1.0;
+    std::uint64_t counter_base_ = 0;
+    std::chrono::steady_clock::time_point steady_base_{};
+};
+
+const char* profile_clock_source_name(profile_clock::source src) noexcept;
+
+}  // namespace bt
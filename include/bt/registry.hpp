@@ -1,12 +1,20 @@
 #pragma once
 
+#include <cstdint>
+#include <deque>
 #include <functional>
+#include <memory>
+#include <optional>
 #include <span>
 #include <string>
 #include <string_view>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "bt/ast.hpp"
+#include "bt/coroutine_action.hpp"
 #include "bt/status.hpp"
 #include "muslisp/value.hpp"
 
@@ -19,21 +27,254 @@ using condition_fn = std::function<bool(tick_context&, std::span<const muslisp::
 using action_fn = std::function<status(tick_context&, node_id, node_memory&, std::span<const muslisp::value> args)>;
 using action_halt_fn = std::function<void(tick_context&, node_id, node_memory&)>;
 
+// Argument types a native leaf callback may declare after its fixed parameters.
+enum class native_arg_type : std::uint8_t { integer, floating, boolean, text };
+
+// One leaf argument decoded at link time for a native callback. `text` views the definition's string.
+struct native_arg {
+    std::int64_t int_v = 0;
+    double float_v = 0.0;
+    bool bool_v = false;
+    std::string_view text;
+};
+
+template <typename T>
+struct native_arg_traits;
+
+template <>
+struct native_arg_traits<std::int64_t> {
+    static constexpr native_arg_type type = native_arg_type::integer;
+    static std::int64_t get(const native_arg& arg) noexcept { return arg.int_v; }
+};
+
+template <>
+struct native_arg_traits<double> {
+    static constexpr native_arg_type type = native_arg_type::floating;
+    static double get(const native_arg& arg) noexcept { return arg.float_v; }
+};
+
+template <>
+struct native_arg_traits<bool> {
+    static constexpr native_arg_type type = native_arg_type::boolean;
+    static bool get(const native_arg& arg) noexcept { return arg.bool_v; }
+};
+
+template <>
+struct native_arg_traits<std::string_view> {
+    static constexpr native_arg_type type = native_arg_type::text;
+    static std::string_view get(const native_arg& arg) noexcept { return arg.text; }
+};
+
+// Blackboard keys a condition reads: leaf argument positions that name keys, plus fixed keys. A
+// condition that declares its reads promises its result depends only on those entries and its leaf
+// arguments, which lets incremental ticks reuse the previous result while none of them changed.
+//
+// `thread_safe` further promises the condition may run on a scheduler worker while other conditions
+// of the same instance run: it only reads through the tick_context, and never allocates on the Lisp
+// heap. A `par` node evaluates its thread-safe native condition children concurrently.
+//
+// `test` names what the condition computes when it is a plain comparison of one blackboard key
+// (args `key operand`), which lets tick programs dispatch guard-heavy selectors with one lookup
+// (see tick_guard_table in bt/compiler.hpp). A condition declaring one must return exactly:
+//   bb_equals: the entry holds the operand's type and value (int, bool, or a string equal to a string or
+//              symbol operand); false when the key is missing;
+//   bb_less:   the entry is an int or float below the numeric operand, compared as doubles.
+enum class condition_test : std::uint8_t {
+    opaque,
+    bb_equals,
+    bb_less
+};
+
+struct condition_reads {
+    std::vector<std::size_t> key_args;
+    std::vector<std::string> keys;
+    bool thread_safe = false;
+    condition_test test = condition_test::opaque;
+};
+
+// A native callback stored as a plain function pointer plus the callable it forwards to.
+template <typename Thunk>
+struct native_callback {
+    Thunk invoke = nullptr;
+    std::shared_ptr<void> callable;
+    std::vector<native_arg_type> signature;
+};
+
+using native_condition_thunk = bool (*)(void* callable, tick_context&, std::span<const native_arg> args);
+using native_action_thunk = status (*)(void* callable,
+                                       tick_context&,
+                                       node_id,
+                                       node_memory&,
+                                       std::span<const native_arg> args);
+
+namespace detail {
+
+template <typename... Args>
+struct type_list {};
+
+template <typename F>
+struct callable_signature : callable_signature<decltype(&F::operator())> {};
+
+template <typename R, typename... Args>
+struct callable_signature<R (*)(Args...)> {
+    using result = R;
+    using args = type_list<Args...>;
+};
+
+template <typename R, typename C, typename... Args>
+struct callable_signature<R (C::*)(Args...) const> : callable_signature<R (*)(Args...)> {};
+
+template <typename R, typename C, typename... Args>
+struct callable_signature<R (C::*)(Args...)> : callable_signature<R (*)(Args...)> {};
+
+template <typename T>
+using native_arg_of = native_arg_traits<std::remove_cvref_t<T>>;
+
+}  // namespace detail
+
+// Callbacks live in per-kind tables so instances can bind each leaf to a table index once (see
+// instance::link_leaves) and call through it directly. Every registration or clear() issues a new
+// process-wide generation; a binding is valid only while its recorded generation matches.
+//
+// Native callbacks declare typed trailing parameters (std::int64_t, double, bool, std::string_view)
+// instead of a span of Lisp values; leaf arguments are decoded against that signature at link time,
+// so ticks pass plain C++ values and never touch the Lisp value layer.
 class registry {
 public:
-    void register_condition(std::string name, condition_fn fn);
+    static constexpr std::uint32_t k_unbound = 0xFFFFFFFFu;
+
+    struct condition_entry {
+        condition_fn fn;
+        native_callback<native_condition_thunk> native;
+        std::optional<condition_reads> reads;
+    };
+
+    struct action_entry {
+        action_fn fn;
+        native_callback<native_action_thunk> native;
+        action_halt_fn halt;
+        coroutine_action_fn coroutine;
+    };
+
+    registry();
+
+    void register_condition(std::string name, condition_fn fn, std::optional<condition_reads> reads = std::nullopt);
     void register_action(std::string name, action_fn fn, action_halt_fn halt_fn = {});
+    // `fn` starts a coroutine (see action_task); halting the node destroys its frame.
+    void register_coroutine_action(std::string name, coroutine_action_fn fn);
 
+    // `fn` is `bool(tick_context&, Args...)`.
+    template <typename F>
+    void register_native_condition(std::string name, F fn, std::optional<condition_reads> reads = std::nullopt);
+    // `fn` is `status(tick_context&, node_id, node_memory&, Args...)`.
+    template <typename F>
+    void register_native_action(std::string name, F fn, action_halt_fn halt_fn = {});
+
+    // Span-based callbacks only; native registrations are reached through the table accessors.
     const condition_fn* find_condition(std::string_view name) const;
     const action_fn* find_action(std::string_view name) const;
     const action_halt_fn* find_action_halt(std::string_view name) const;
 
+    // Table indices for linking; k_unbound when the name is not registered.
+    [[nodiscard]] std::uint32_t condition_index(std::string_view name) const;
+    [[nodiscard]] std::uint32_t action_index(std::string_view name) const;
+    [[nodiscard]] const condition_entry& condition_at(std::uint32_t index) const { return conditions_[index]; }
+    [[nodiscard]] const action_entry& action_at(std::uint32_t index) const { return actions_[index]; }
+    [[nodiscard]] const action_halt_fn* action_halt_at(std::uint32_t index) const {
+        const action_halt_fn& halt = actions_[index].halt;
+        return halt ? &halt : nullptr;
+    }
+    [[nodiscard]] std::uint64_t generation() const noexcept { return generation_; }
+
+    // Decodes `args` against a native signature; false when the count or any kind does not match.
+    static bool decode_native_args(std::span<const native_arg_type> signature,
+                                   const std::vector<arg_value>& args,
+                                   std::vector<native_arg>& out);
+
     void clear();
 
 private:
-    std::unordered_map<std::string, condition_fn> conditions_;
-    std::unordered_map<std::string, action_fn> actions_;
-    std::unordered_map<std::string, action_halt_fn> action_halts_;
+    struct name_hash {
+        using is_transparent = void;
+        [[nodiscard]] std::size_t operator()(std::string_view name) const noexcept {
+            return std::hash<std::string_view>{}(name);
+        }
+    };
+    using index_map = std::unordered_map<std::string, std::uint32_t, name_hash, std::equal_to<>>;
+
+    template <typename Callable, typename... Args>
+    void add_native_condition(std::string name,
+                              Callable fn,
+                              std::optional<condition_reads> reads,
+                              detail::type_list<tick_context&, Args...>);
+    template <typename Callable, typename... Args>
+    void add_native_action(std::string name,
+                           Callable fn,
+                           action_halt_fn halt_fn,
+                           detail::type_list<tick_context&, node_id, node_memory&, Args...>);
+
+    void set_condition(std::string name, condition_entry entry);
+    void set_action(std::string name, action_entry entry);
+
+    // Deques keep callbacks in place while a registration from inside a running callback appends.
+    std::deque<condition_entry> conditions_;
+    std::deque<action_entry> actions_;
+    index_map condition_indices_;
+    index_map action_indices_;
+    std::uint64_t generation_ = 0;
 };
 
+template <typename F>
+void registry::register_native_condition(std::string name, F fn, std::optional<condition_reads> reads) {
+    using callable = std::decay_t<F>;
+    using signature = detail::callable_signature<callable>;
+    static_assert(std::is_same_v<typename signature::result, bool>, "native conditions must return bool");
+    add_native_condition(std::move(name), callable(std::move(fn)), std::move(reads), typename signature::args{});
+}
+
+template <typename F>
+void registry::register_native_action(std::string name, F fn, action_halt_fn halt_fn) {
+    using callable = std::decay_t<F>;
+    using signature = detail::callable_signature<callable>;
+    static_assert(std::is_same_v<typename signature::result, status>, "native actions must return bt::status");
+    add_native_action(std::move(name), callable(std::move(fn)), std::move(halt_fn), typename signature::args{});
+}
+
+template <typename Callable, typename... Args>
+void registry::add_native_condition(std::string name,
+                                    Callable fn,
+                                    std::optional<condition_reads> reads,
+                                    detail::type_list<tick_context&, Args...>) {
+    condition_entry entry;
+    entry.reads = std::move(reads);
+    entry.native.callable = std::make_shared<Callable>(std::move(fn));
+    entry.native.signature = {detail::native_arg_of<Args>::type...};
+    entry.native.invoke = [](void* callable, tick_context& ctx, std::span<const native_arg> args) -> bool {
+        Callable& f = *static_cast<Callable*>(callable);
+        return [&]<std::size_t... I>(std::index_sequence<I...>) {
+            return f(ctx, detail::native_arg_of<Args>::get(args[I])...);
+        }(std::index_sequence_for<Args...>{});
+    };
+    set_condition(std::move(name), std::move(entry));
+}
+
+template <typename Callable, typename... Args>
+void registry::add_native_action(std::string name,
+                                 Callable fn,
+                                 action_halt_fn halt_fn,
+                                 detail::type_list<tick_context&, node_id, node_memory&, Args...>) {
+    action_entry entry;
+    entry.native.callable = std::make_shared<Callable>(std::move(fn));
+    entry.native.signature = {detail::native_arg_of<Args>::type...};
+    entry.native.invoke =
+        [](void* callable, tick_context& ctx, node_id id, node_memory& mem, std::span<const native_arg> args) -> status {
+        Callable& f = *static_cast<Callable*>(callable);
+        return [&]<std::size_t... I>(std::index_sequence<I...>) {
+            return f(ctx, id, mem, detail::native_arg_of<Args>::get(args[I])...);
+        }(std::index_sequence_for<Args...>{});
+    };
+    entry.halt = std::move(halt_fn);
+    set_action(std::move(name), std::move(entry));
+}
+
 }  // namespace bt
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace bt {
+
+// Hash-indexed, append-only store of recorded responses. Replaying a long evidence bundle from it
+// maps the files instead of loading them. A store is a directory of three files, with integers in
+// host byte order:
+//   replay.payload  response bytes, appended back to back
+//   replay.index    char magic[8] = "MBTRPIDX", u32 version = 1, u32 reserved, u64 count, followed by
+//                   `count` entries (u64 key, u64 offset, u64 size) sorted by key
+//   replay.journal  entries (u64 key, u64 offset, u64 size) appended since the index was last built
+// The index and payload are memory-mapped on open. A lookup is a binary search of the index plus one
+// copy out of the payload. The journal is read into memory on open, and compact() folds it into a
+// new index. A put writes its payload before its journal entry, so a torn write never leaves an
+// entry that points past the payload. When a key is stored twice, the later entry wins.
+class replay_store {
+public:
+    // Opens the store in `directory`, creating the directory and files when missing. Throws
+    // std::runtime_error when a file cannot be opened or replay.index is not a version 1 index.
+    [[nodiscard]] static std::shared_ptr<replay_store> open(std::filesystem::path directory);
+
+    ~replay_store();
+    replay_store(const replay_store&) = delete;
+    replay_store& operator=(const replay_store&) = delete;
+
+    [[nodiscard]] std::optional<std::string> find(std::uint64_t key) const;
+    // Appends `payload` under `key`. Folds the journal into the index once it holds
+    // k_compact_threshold entries. Throws std::runtime_error when a write fails.
+    void put(std::uint64_t key, std::string_view payload);
+    // Rewrites replay.index to include every journal entry, then empties the journal.
+    void compact();
+
+    // Number of distinct keys.
+    [[nodiscard]] std::size_t size() const;
+    [[nodiscard]] const std::filesystem::path& directory() const noexcept { return directory_; }
+
+    static constexpr std::size_t k_compact_threshold = 4096;
+
+private:
+    struct entry {
+        std::uint64_t key;
+        std::uint64_t offset;
+        std::uint64_t size;
+    };
+
+    explicit replay_store(std::filesystem::path directory);
+
+    [[nodiscard]] const entry* index_find(std::uint64_t key) const noexcept;
+    [[nodiscard]] std::string read_payload(const entry& e) const;
+    void map_index();
+    void map_payload();
+    void unmap() noexcept;
+    void compact_locked();
+
+    std::filesystem::path directory_;
+    mutable std::mutex mutex_;
+    int payload_fd_ = -1;
+    int journal_fd_ = -1;
+    std::uint64_t payload_end_ = 0;
+    void* index_base_ = nullptr;
+    std::size_t index_bytes_ = 0;
+    const entry* index_entries_ = nullptr;
+    std::size_t index_count_ = 0;
+    void* payload_base_ = nullptr;
+    std::size_t payload_mapped_ = 0;
+    std::unordered_map<std::uint64_t, entry> journal_;
+};
+
+}  // namespace bt
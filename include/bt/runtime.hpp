@@ -1,7 +1,9 @@
 #pragma once
 
 #include <chrono>
+#include <memory>
 #include <optional>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <string_view>
@@ -11,6 +13,10 @@
 #include "bt/registry.hpp"
 #include "bt/status.hpp"
 
+namespace muslisp {
+class gc;
+}
+
 namespace bt {
 
 class bt_runtime_error : public std::runtime_error {
@@ -18,6 +24,14 @@ public:
     explicit bt_runtime_error(const std::string& message) : std::runtime_error(message) {}
 };
 
+// A condition result a `par` node computed off the ticking thread before visiting the condition.
+struct precomputed_condition {
+    node_id node = 0;
+    bool value = false;
+    bool threw = false;
+    std::string error;
+};
+
 struct tick_context {
     instance& inst;
     registry& reg;
@@ -27,26 +41,102 @@ struct tick_context {
     std::chrono::steady_clock::time_point tick_started_at{};
     std::chrono::steady_clock::time_point tick_deadline{};
     node_id current_node = 0;
-    std::vector<node_id> node_path{};
-    std::vector<node_id> last_node_path{};
+    // While tick audits are enabled, each visit appends to `inst.node_path_records`; the path is
+    // only materialised from the terminal record when the audit event is written.
+    std::uint32_t node_path_top = node_path_record::k_none;
+    std::uint32_t node_path_depth = 0;
+    std::uint32_t terminal_depth = 0;
+    std::uint32_t terminal_record = node_path_record::k_none;
     std::optional<node_id> terminal_node_id{};
+    // Heap whose allocation counters are attributed to node visits; nullptr turns attribution off.
+    // The attributed_* totals are what node visits have claimed as their own so far this tick.
+    muslisp::gc* heap = nullptr;
+    std::uint64_t attributed_alloc_objects = 0;
+    std::uint64_t attributed_alloc_bytes = 0;
+    // Set while the tick is ledgered (node profiling on, or tick audits enabled); the same ledger is
+    // tick_ledger::current() on the ticking thread.
+    tick_ledger* ledger = nullptr;
     std::uint64_t planner_calls = 0;
     std::uint64_t vla_submits = 0;
     std::uint64_t vla_polls = 0;
+    // Condition callbacks that threw this tick; a memo is only stored when none did during its subtree.
+    std::uint64_t condition_errors = 0;
+    // Set by a `par` node while it visits children whose thread-safe conditions it already evaluated
+    // concurrently; tick_condition takes those results from here instead of calling the condition.
+    std::span<const precomputed_condition> precomputed_conditions{};
 
-    void bb_put(std::string key, bb_value value, std::string writer_name = "");
+    void bb_put(std::string_view key, bb_value value, std::string_view writer_name = "");
+    void bb_put(bb_slot slot, bb_value value, std::string_view writer_name = "");
     const bb_entry* bb_get(std::string_view key);
+    const bb_entry* bb_get(bb_slot slot);
     void scheduler_event(trace_event_kind kind, job_id job, job_status st, std::string message = "");
+    // Routes `req`'s start and finish notifications to leaf `id`: once submitted with mem.i0 holding
+    // the job id and mem.b0 set, the leaf's job_notified flag is raised at the start of the next
+    // tick after the job moves, so the leaf only has to poll the scheduler when it is set.
+    void watch_job(job_request& req, node_id id);
 };
 
 status tick(instance& inst, registry& reg, services& svc);
+// Ticks every instance once, in order, as one wave: a single GC tick scope and event-log batch cover
+// the wave, `svc.obs.trace` is pointed at each instance's own trace buffer, and instances of one
+// definition share its leaf link table and tick program. `out[i]` receives the status of `insts[i]`.
+void tick_wave(std::span<instance* const> insts, registry& reg, services& svc, std::span<status> out);
+// Links every instance against `reg` and compiles missing tick programs, sharing both between
+// instances of one definition; tick_wave does this first, and callers that split a wave across
+// threads do it once up front.
+void prepare_wave(std::span<instance* const> insts, registry& reg);
+// Clears node memory, async job bookkeeping and the blackboard. Costs O(nodes with memory), not
+// O(nodes): only subtrees that live_memory_nodes marks as holding state are visited. Does not halt
+// running leaves; see halt_subtree.
 void reset(instance& inst);
+// Returns `inst` to the state of a newly constructed instance of its definition while keeping its
+// storage: slabs, interned blackboard keys, leaf links, tick program and trace rings. Profile stats,
+// tick settings and the tick index are reset too. Used by instance_pool; running leaves must be halted
+// first.
+void recycle(instance& inst);
+// Makes `dst`, an instance of the same definition, continue from `src`'s state: node memory, tick
+// index, tick settings and a copy-on-write fork of the blackboard (see blackboard::fork), so the two
+// can be ticked independently from here. Profile stats and traces start empty. Throws
+// bt_runtime_error when the definitions differ or `src` holds state that cannot be copied (see
+// instance::uncopyable_state). Scheduler jobs a leaf tracks through its memory are not duplicated.
+void fork_state(const instance& src, instance& dst);
 void halt_subtree(instance& inst, registry& reg, services& svc, node_id root, std::string_view reason = "halt");
+// Moves `inst` onto `new_def` between ticks, keeping its blackboard. Nodes are matched by structural
+// path: an old node carries its memory, watched scheduler job, async VLA job and profile stats over to
+// the node at the same child-index path in `new_def` when both have the same label (see
+// same_node_label). Every old subtree without a match is halted with reason "swap", and its VLA jobs
+// are cancelled, before the switch. `shared_leaf_args` is adopted when it was built for `new_def`.
+// Returns the number of old nodes halted.
+std::size_t swap_definition(instance& inst,
+                            const definition* new_def,
+                            registry& reg,
+                            services& svc,
+                            std::shared_ptr<const leaf_arg_table> shared_leaf_args = nullptr);
 
 std::string dump_stats(const instance& inst);
 std::string dump_trace(const instance& inst);
 std::string dump_blackboard(const instance& inst);
+// Timed node durations in collapsed-stack format, one `frame;frame;... self_ns` line per node with
+// self time, for flamegraph.pl, inferno or speedscope. Frames are `kind:leaf_name` for named nodes
+// and `kind#id` otherwise, from the root down; `root_frame`, when given, is prepended to every
+// stack. Self time is a node's timed total minus its children's, so it is exact under full node
+// profiling and approximate under sampled profiling, where a child can be timed without its parent.
+std::string dump_flamegraph(const instance& inst, std::string_view root_frame = {});
 
 void set_tick_budget_ms(instance& inst, std::int64_t budget_ms);
+void set_incremental_tick(instance& inst, bool enabled);
+// On-demand ticking: instead of ticking at a fixed rate, the host asks tick_due and ticks only when a
+// blackboard key some condition reads changed, a watched scheduler job moved, or `max_interval` (0 =
+// no timer) passed since the last tick. The first tick after enabling is always due, and so is every
+// tick while a leaf runs without a watched job to wake it (wake_reason::running), such as a Lisp action
+// or a vla-request polled through vla_service.
+void set_tick_on_demand(instance& inst, bool enabled, std::chrono::nanoseconds max_interval = {});
+// The wake_reason bits for which `inst` should tick at `now`, or 0 when it can sleep. Always
+// wake_reason::timer when on-demand ticking is off. Does not clear anything; tick() does.
+[[nodiscard]] std::uint32_t tick_due(const instance& inst, std::chrono::steady_clock::time_point now);
+// Blocks until tick_due would return non-zero or `deadline` passes, and returns tick_due then.
+std::uint32_t wait_for_wake(instance& inst, std::chrono::steady_clock::time_point deadline);
+// Throws std::invalid_argument unless every_n_ticks >= 1 and node_percent is 1..100.
+void set_node_profiling(instance& inst, node_profiling_options options);
 
 }  // namespace bt
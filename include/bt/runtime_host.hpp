@@ -1,34 +1,104 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "bt/compiler.hpp"
 #include "bt/event_log.hpp"
+#include "bt/memory_footprint.hpp"
+#include "bt/instance_pool.hpp"
+#include "bt/log_replay.hpp"
+#include "bt/metrics.hpp"
 #include "bt/model_service.hpp"
 #include "bt/planner.hpp"
+#include "bt/replay_store.hpp"
 #include "bt/runtime.hpp"
+#include "bt/sim_clock.hpp"
+#include "bt/tick_pool.hpp"
 #include "bt/vla.hpp"
 
 namespace bt {
 
+// Construction-time settings for a runtime_host's job scheduler.
+struct runtime_host_options {
+    // 0 keeps the scheduler's default pool size.
+    std::size_t scheduler_workers = 0;
+    scheduler_thread_options scheduler_threads{};
+};
+
 class runtime_host {
 public:
     runtime_host();
+    explicit runtime_host(runtime_host_options options);
 
     std::int64_t store_definition(definition def);
+    // Like store_definition, but returns the handle of an already stored definition with the same
+    // canonical DSL (compared structurally, see bt::structural_hash) instead of storing a duplicate.
+    // Definitions are immutable once stored, so every instance of a shared handle reads the same node
+    // storage and per-definition leaf caches. Definitions without a `source_hash` are always stored.
+    std::int64_t intern_definition(definition def);
+    // Takes an idle instance from the definition's instance_pool when one was released, otherwise
+    // builds a new one.
     std::int64_t create_instance(std::int64_t definition_handle);
+    // Halts the instance's running nodes with reason "release", drops its handle and returns it to its
+    // definition's instance_pool for a later create_instance.
+    void release_instance(std::int64_t handle);
+    // Trace ring capacity, in events, of instances created from now on. Rings are allocated by the
+    // first traced event. Idle pooled instances with another capacity are freed.
+    void set_instance_trace_capacity(std::size_t capacity);
+    [[nodiscard]] std::size_t instance_trace_capacity() const noexcept { return instance_trace_capacity_; }
+    // Number of released instances of `definition_handle` waiting for reuse.
+    [[nodiscard]] std::size_t idle_instance_count(std::int64_t definition_handle) const;
 
     definition* find_definition(std::int64_t handle);
     const definition* find_definition(std::int64_t handle) const;
+
+    // Parse cache for `bt.load-dsl`: definitions keyed by the `source_hash` of the DSL text they were
+    // compiled from, so reloading unchanged text returns the stored definition without reading or
+    // compiling it again. `source_size` guards against hash collisions.
+    [[nodiscard]] std::optional<std::int64_t> find_dsl_definition(const std::string& source_hash,
+                                                                  std::size_t source_size) const;
+    void remember_dsl_definition(const std::string& source_hash, std::size_t source_size, std::int64_t handle);
+    // Parses and compiles the DSL files on `workers` threads (see compile_dsl_files), then stores them
+    // as bt.load-dsl does, reusing definitions already loaded from the same text. Throws
+    // std::runtime_error naming the first file that failed, before anything is stored.
+    std::vector<std::int64_t> load_dsl_files(std::span<const std::string> paths, std::size_t workers = 0);
     instance* find_instance(std::int64_t handle);
     const instance* find_instance(std::int64_t handle) const;
 
     status tick_instance(std::int64_t handle);
+    // Ticks `handles` once each, in order, as one wave (see bt::tick_wave); `out[i]` receives the
+    // status of `handles[i]`. Every handle is resolved before any instance is ticked.
+    void tick_instances(std::span<const std::int64_t> handles, std::span<status> out);
+    // With more than one worker, tick_instances splits each wave across a tick_worker_pool of that
+    // many threads; 0 or 1 ticks waves on the calling thread. Waves with a tree that is not native-only
+    // still tick on the calling thread; the first such wave under a pool logs a warning, and
+    // dump_scheduler_stats counts them.
+    void set_tick_workers(std::size_t count);
+    [[nodiscard]] std::size_t tick_workers() const noexcept;
+    // When tick_instance or tick_instances first started a tick on this host; nullopt before that.
+    [[nodiscard]] std::optional<std::chrono::steady_clock::time_point> first_tick_time() const noexcept;
+    // Called once, on the ticking thread, just before the first tick; used for start-up timing.
+    void set_first_tick_listener(std::function<void()> listener);
     void reset_instance(std::int64_t handle);
+    // Re-drives the instance through a recorded event log with this host's services (see
+    // bt::log_replay::run).
+    log_replay_report replay_instance(std::int64_t handle, log_replay& replay, const log_replay_options& options = {});
+    // New instance of `handle`'s definition continuing from its current state (see bt::fork_state).
+    std::int64_t fork_instance(std::int64_t handle);
+    // Hot-swaps an instance onto another stored definition between ticks (see bt::swap_definition) and
+    // emits the new definition's bt_def event. Returns the number of old nodes halted.
+    std::size_t swap_instance_definition(std::int64_t instance_handle, std::int64_t definition_handle);
 
     registry& callbacks() noexcept;
     const registry& callbacks() const noexcept;
@@ -40,12 +110,24 @@ public:
     const planner_service& planner_ref() const;
     vla_service& vla_ref();
     const vla_service& vla_ref() const;
-    void set_model_service_client(model_service_config config, std::unique_ptr<model_service_client> client);
+    // `hedge_client`, when given, receives the duplicates of hedged calls (see
+    // model_service_config::hedge_percentile); otherwise they go to `client`.
+    void set_model_service_client(model_service_config config,
+                                  std::unique_ptr<model_service_client> client,
+                                  std::unique_ptr<model_service_client> hedge_client = nullptr);
     void clear_model_service_client() noexcept;
     [[nodiscard]] bool model_service_configured() const noexcept;
     [[nodiscard]] const model_service_config& model_service_config_ref() const noexcept;
     [[nodiscard]] model_service_response call_model_service(const model_service_request& request);
     [[nodiscard]] model_service_compatibility_result check_model_service_compatibility();
+    // Runs check_model_service_compatibility before the first call that is not a describe, instead of
+    // when the client is configured, so start-up does not wait for the service. Until a new client is
+    // set, calls after an incompatible answer fail with model_service_incompatible without reaching it.
+    void check_model_service_on_first_use();
+    [[nodiscard]] model_service_hedge_stats model_service_hedge_stats_snapshot() const;
+    // Batch size the configured service advertises for `capability` (1 when it does not batch). The
+    // first call sends describe directly to the client; the answer is kept until the client changes.
+    [[nodiscard]] std::size_t model_service_batch_limit(const std::string& capability);
 
     memory_log_sink& logs() noexcept;
     const memory_log_sink& logs() const noexcept;
@@ -56,6 +138,17 @@ public:
     clock_interface* clock_interface_ptr() noexcept;
     const clock_interface* clock_interface_ptr() const noexcept;
 
+    // Simulated time: ticks read a host-owned bt::sim_clock, which moves only when advanced, so
+    // tick budgets, tick timestamps and async-sleep-ms deadlines follow the simulation however fast
+    // it runs. The clock keeps its time across enable/disable, so simulated time never runs back.
+    sim_clock& enable_simulated_time();
+    // Puts back the clock that was in use before enable_simulated_time().
+    void disable_simulated_time() noexcept;
+    // The simulated clock while simulated time is on, otherwise nullptr.
+    [[nodiscard]] sim_clock* simulated_clock() noexcept;
+    // Waits until every scheduler job has finished; see thread_pool_scheduler::wait_idle.
+    bool settle_jobs(std::chrono::steady_clock::duration timeout);
+
     void set_robot_interface(robot_interface* robot) noexcept;
     robot_interface* robot_interface_ptr() noexcept;
     const robot_interface* robot_interface_ptr() const noexcept;
@@ -67,24 +160,87 @@ public:
     void disable_deterministic_test_mode() noexcept;
     [[nodiscard]] bool deterministic_test_mode_enabled() const noexcept;
 
+    // Metrics for fleet dashboards. While enabled, every tick, default-heap collection and model-service
+    // call is recorded into lock-free counters; render_metrics() reads those, plus the scheduler,
+    // event-log and VLA cache counters, without touching the ticking thread.
+    void set_metrics_enabled(bool enabled) noexcept;
+    [[nodiscard]] bool metrics_enabled() const noexcept;
+    [[nodiscard]] runtime_metrics& metrics() noexcept;
+    // Every metric in OpenMetrics text format, ending with `# EOF`. Safe to call from any thread.
+    [[nodiscard]] std::string render_metrics() const;
+    // Serves render_metrics() at http://<bind_address>:<port>/metrics from a background thread and
+    // enables metrics; replaces any endpoint already running. Port 0 picks a free port. Returns the
+    // bound port.
+    std::uint16_t start_metrics_endpoint(std::uint16_t port, const std::string& bind_address = "127.0.0.1");
+    void stop_metrics_endpoint() noexcept;
+    // The bound port, or 0 when no endpoint is running.
+    [[nodiscard]] std::uint16_t metrics_endpoint_port() const noexcept;
+
     void clear_logs();
+    // Also stops the metrics endpoint and disables and resets the metrics.
     void clear_all();
 
     std::string dump_instance_stats(std::int64_t handle) const;
     std::string dump_instance_trace(std::int64_t handle) const;
     std::string dump_instance_blackboard(std::int64_t handle) const;
+    std::string dump_instance_flamegraph(std::int64_t handle) const;
+    // Collapsed stacks of every live instance, in handle order, each rooted at an `inst-<handle>` frame.
+    std::string dump_flamegraph() const;
+    // Includes the worker thread settings and any setup failures.
     std::string dump_scheduler_stats() const;
+    // Steady-state bytes by component: stored definitions and the tables their instances share, live
+    // and pooled instances (tick state, blackboards, trace rings), the event and log rings, and the
+    // default Lisp heap. Walks every instance, so call it between ticks.
+    [[nodiscard]] bt::memory_report memory_report() const;
     std::string dump_logs() const;
     std::string dump_planner_records(std::size_t max_count = 200) const;
     std::string dump_vla_records(std::size_t max_count = 200) const;
 
 private:
+    // Sends `request` to the client, hedging invoke calls when configured.
+    [[nodiscard]] model_service_response call_model_service_client(const model_service_request& request);
+    // Delay after which an invoke call is hedged; nullopt while hedging is off or too few latencies
+    // have been recorded.
+    [[nodiscard]] std::optional<std::chrono::nanoseconds> model_service_hedge_delay() const;
+    void record_model_service_latency(std::chrono::steady_clock::duration latency);
+    void note_first_tick();
+    void tick_pooled_wave(services& svc, std::span<status> out);
+    // The refusal for `request` while a deferred compatibility check failed; runs the check first if
+    // it is still pending.
+    [[nodiscard]] std::optional<model_service_response> model_service_first_use_refusal(
+        const model_service_request& request);
+
     std::int64_t next_definition_handle_ = 1;
     std::int64_t next_instance_handle_ = 1;
 
     std::unordered_map<std::int64_t, definition> definitions_;
+    // Stored definitions by address, for instances that only know their definition pointer.
+    std::unordered_map<const definition*, std::int64_t> definition_handles_;
     std::unordered_map<std::int64_t, std::unique_ptr<instance>> instances_;
 
+    struct dsl_cache_entry {
+        std::int64_t handle = 0;
+        std::size_t source_size = 0;
+    };
+    std::unordered_map<std::string, dsl_cache_entry> dsl_cache_;
+    // intern_definition index: structural_hash -> handle.
+    std::unordered_map<std::uint64_t, std::int64_t> canonical_definitions_;
+    // Per-definition state reused by every create_instance call for that handle.
+    struct definition_cache {
+        std::weak_ptr<const leaf_arg_table> leaf_args;
+        std::weak_ptr<const leaf_link_table> leaf_links;
+        std::optional<event_log::bt_def_event> bt_def;
+        std::unique_ptr<instance_pool> pool;
+    };
+    std::size_t instance_trace_capacity_ = instance::k_default_trace_capacity;
+    std::unordered_map<std::int64_t, definition_cache> definition_caches_;
+    std::vector<instance*> wave_instances_;
+    // Overrun counts of wave_instances_ before the wave, while metrics are enabled.
+    std::vector<std::uint64_t> wave_overruns_;
+    // steady_clock ticks of the first tick, 0 until then.
+    std::atomic<std::int64_t> first_tick_at_{0};
+    std::function<void()> first_tick_listener_;
+
     registry registry_;
     thread_pool_scheduler scheduler_;
     memory_log_sink logs_;
@@ -93,17 +249,48 @@ private:
     vla_service vla_;
     model_service_config model_service_config_{};
     std::unique_ptr<model_service_client> model_service_client_;
+    std::unique_ptr<model_service_client> model_service_hedge_client_;
+    // Latencies of recent successful invoke calls, in ms, for the hedge delay; a ring of
+    // k_model_service_latency_window samples.
+    static constexpr std::size_t k_model_service_latency_window = 256;
+    mutable std::mutex model_service_latency_mutex_;
+    std::vector<double> model_service_latency_ms_;
+    std::size_t model_service_latency_next_ = 0;
+    model_service_hedge_stats model_service_hedge_stats_{};
+    // Open when replay_cache_format is "indexed".
+    std::shared_ptr<replay_store> model_service_replay_store_;
     std::size_t model_service_fault_index_ = 0;
+    std::mutex model_service_describe_mutex_;
+    std::optional<std::string> model_service_describe_output_;
+    // Set by check_model_service_on_first_use until the check has run and passed; the failed result
+    // is kept under model_service_describe_mutex_.
+    std::atomic<bool> model_service_check_pending_{false};
+    std::optional<model_service_compatibility_result> model_service_failed_check_;
 
     std::unique_ptr<clock_interface> owned_clock_;
     std::unique_ptr<robot_interface> owned_robot_;
     clock_interface* clock_ = nullptr;
+    std::unique_ptr<sim_clock> sim_clock_;
+    // The clock enable_simulated_time() replaced; nullptr while simulated time is off.
+    clock_interface* clock_before_sim_ = nullptr;
     robot_interface* robot_ = nullptr;
 
     bool deterministic_test_mode_enabled_ = false;
+
+    runtime_metrics metrics_;
+    // Declared late, so its thread stops before the state it renders is destroyed.
+    std::unique_ptr<metrics_endpoint> metrics_endpoint_;
+
+    // Last member, so its threads stop before the state they tick against is destroyed.
+    std::unique_ptr<tick_worker_pool> tick_pool_;
 };
 
+// The host of the runtime_context bound to the calling thread, or the process-wide host.
 runtime_host& default_runtime_host();
+// Options for the host default_runtime_host() creates. Throws std::logic_error once that host exists.
+void set_default_runtime_host_options(runtime_host_options options);
 void install_demo_callbacks(runtime_host& host);
+// Reports `heap`'s collections and limit incidents to `host`'s metrics and event log.
+void report_heap_events(runtime_host& host, muslisp::gc& heap);
 
 }  // namespace bt
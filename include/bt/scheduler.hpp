@@ -1,8 +1,11 @@
 #pragma once
 
 #include <any>
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <memory>
@@ -10,11 +13,13 @@
 #include <optional>
 #include <queue>
 #include <string>
+#include <string_view>
 #include <thread>
-#include <unordered_map>
+#include <type_traits>
 #include <vector>
 
 #include "bt/profile.hpp"
+#include "bt/tick_wake.hpp"
 
 namespace bt {
 
@@ -46,10 +51,112 @@ struct job_result {
     std::any payload;
 };
 
+// Lock-free multi-producer, single-consumer list of job status notifications. A job_request that
+// names one is pushed its completion_tag when the job starts running and again when it reaches a
+// terminal state, so the submitter can find the jobs that moved by draining the queue instead of
+// polling every outstanding job through the scheduler.
+class completion_queue {
+public:
+    struct notification {
+        job_id job = 0;
+        std::uint64_t tag = 0;
+    };
+
+    completion_queue() = default;
+    ~completion_queue();
+
+    completion_queue(const completion_queue&) = delete;
+    completion_queue& operator=(const completion_queue&) = delete;
+
+    // Safe from any thread. Notifies the waker, if one is set, with wake_reason::job_complete.
+    void push(job_id job, std::uint64_t tag);
+    // Appends every notification pushed so far to `out`, oldest first. One consumer at a time.
+    void drain(std::vector<notification>& out);
+    [[nodiscard]] bool empty() const noexcept { return head_.load(std::memory_order_acquire) == nullptr; }
+    // Safe while jobs push; nullptr stops notifying.
+    void set_waker(std::shared_ptr<tick_waker> waker) { waker_.store(std::move(waker)); }
+
+private:
+    struct entry {
+        notification value;
+        entry* next = nullptr;
+    };
+
+    std::atomic<entry*> head_{nullptr};
+    std::atomic<std::shared_ptr<tick_waker>> waker_;
+};
+
+// Dispatch classes: a queued job of a higher class always starts before one of a lower class.
+enum class job_priority : std::uint8_t {
+    high,
+    normal,
+    low
+};
+
+// Read side of a job's cancellation flag, handed to the job function. A running job is never
+// stopped by force; long-running work should check cancelled() at its natural yield points and
+// return early. A default-constructed token is never cancelled.
+class cancel_token {
+public:
+    cancel_token() = default;
+    explicit cancel_token(const std::atomic<bool>* flag) noexcept : flag_(flag) {}
+
+    [[nodiscard]] bool cancelled() const noexcept {
+        return flag_ != nullptr && flag_->load(std::memory_order_acquire);
+    }
+
+private:
+    const std::atomic<bool>* flag_ = nullptr;
+};
+
+// A job body. Takes callables of the form `job_result(const cancel_token&)`, or `job_result()` for
+// jobs that never look at their token.
+class job_function {
+public:
+    job_function() = default;
+    job_function(std::nullptr_t) noexcept {}
+
+    template <typename F>
+        requires(!std::is_same_v<std::remove_cvref_t<F>, job_function> &&
+                 std::is_invocable_r_v<job_result, std::remove_cvref_t<F>&, const cancel_token&>)
+    job_function(F&& fn) : fn_(std::forward<F>(fn)) {}
+
+    template <typename F>
+        requires(!std::is_same_v<std::remove_cvref_t<F>, job_function> &&
+                 !std::is_invocable_v<std::remove_cvref_t<F>&, const cancel_token&> &&
+                 std::is_invocable_r_v<job_result, std::remove_cvref_t<F>&>)
+    job_function(F&& fn)
+        : fn_([inner = std::forward<F>(fn)](const cancel_token&) mutable -> job_result { return inner(); }) {}
+
+    explicit operator bool() const noexcept { return static_cast<bool>(fn_); }
+    job_result operator()(const cancel_token& cancel) { return fn_(cancel); }
+
+private:
+    std::function<job_result(const cancel_token&)> fn_;
+};
+
+// Id of a job whose body produces a `T`; see scheduler::submit_typed.
+template <typename T>
+struct typed_job {
+    job_id id = 0;
+};
+
 struct job_request {
     std::string task_name;
-    std::function<job_result()> fn;
-    std::optional<std::chrono::milliseconds> timeout;
+    job_function fn{};
+    std::optional<std::chrono::milliseconds> timeout{};
+    job_priority priority = job_priority::normal;
+    // Within a class, jobs with earlier deadlines start first and jobs without one start last, in
+    // submission order. A job still queued at its deadline is cancelled instead of started.
+    std::optional<std::chrono::steady_clock::time_point> deadline{};
+    // When set, the scheduler pushes (job id, completion_tag) here as the job starts and finishes,
+    // including when it is cancelled or expires while queued. Every bt::scheduler honours this.
+    std::shared_ptr<completion_queue> completions{};
+    std::uint64_t completion_tag = 0;
+    // The flag behind the job's cancel_token. Left empty, the scheduler uses a flag of its own; a
+    // caller that already keeps a cancellation flag (vla_service) passes it here so that cancel()
+    // and the caller's own cancellation both reach the job through one flag.
+    std::shared_ptr<std::atomic<bool>> cancel_flag{};
 };
 
 class scheduler {
@@ -58,15 +165,104 @@ public:
 
     virtual job_id submit(job_request req) = 0;
     virtual job_info get_info(job_id id) const = 0;
+    // Copies a finished job's result into `out`.
     virtual bool try_get_result(job_id id, job_result& out) = 0;
+    // Moves a finished job's result into `out`. A result is taken once; afterwards take_result and
+    // try_get_result both return false for the job. Must not race another read of the same job's
+    // result. The default copies through try_get_result.
+    virtual bool take_result(job_id id, job_result& out) { return try_get_result(id, out); }
     virtual bool cancel(job_id id) = 0;
 
     virtual scheduler_profile_stats stats_snapshot() const = 0;
+
+    // Submits `req` with `fn` as its body. `fn` returns a `T` and takes a const cancel_token& or
+    // nothing; the value is moved into the job's slot, and take() moves it out again, so a large
+    // result is never copied on its way to the caller.
+    template <typename T, typename F>
+    typed_job<T> submit_typed(job_request req, F fn);
+    // The `T` of a finished job, moved out; nullopt while the job is unfinished, when it failed or
+    // was cancelled, and once the result has been taken.
+    template <typename T>
+    std::optional<T> take(typed_job<T> job);
+};
+
+template <typename T, typename F>
+typed_job<T> scheduler::submit_typed(job_request req, F fn) {
+    static_assert(std::is_copy_constructible_v<T>, "job results are held in std::any, which needs a copyable type");
+    if constexpr (std::is_invocable_r_v<T, F&, const cancel_token&>) {
+        req.fn = [inner = std::move(fn)](const cancel_token& cancel) mutable {
+            return job_result{.payload = std::any(std::in_place_type<T>, inner(cancel))};
+        };
+    } else {
+        static_assert(std::is_invocable_r_v<T, F&>, "submit_typed: fn must return T");
+        req.fn = [inner = std::move(fn)]() mutable {
+            return job_result{.payload = std::any(std::in_place_type<T>, inner())};
+        };
+    }
+    return typed_job<T>{.id = submit(std::move(req))};
+}
+
+template <typename T>
+std::optional<T> scheduler::take(typed_job<T> job) {
+    job_result out;
+    if (!take_result(job.id, out)) {
+        return std::nullopt;
+    }
+    T* value = std::any_cast<T>(&out.payload);
+    if (!value) {
+        return std::nullopt;
+    }
+    return std::optional<T>(std::move(*value));
+}
+
+// What thread_pool_scheduler::submit does when every job slot holds a queued or running job.
+enum class queue_overflow_policy {
+    reject,  // submit throws std::runtime_error
+    grow     // allocate another slot past max_jobs
 };
 
+// Both outcomes are counted in scheduler_profile_stats::queue_overflow.
+struct scheduler_limits {
+    // Job slots, live and retained, before the overflow policy applies.
+    std::size_t max_jobs = 65536;
+    // Finished jobs kept for get_info/try_get_result; the oldest is recycled first. At least 1.
+    std::size_t max_retained_finished = 4096;
+    queue_overflow_policy overflow = queue_overflow_policy::reject;
+};
+
+// Per-thread setup a scheduler applies on each worker before it takes its first job. Each setting
+// is best effort: a worker whose setup fails (no permission for SCHED_FIFO, a CPU outside the
+// process's allowed set, a non-Linux host) keeps running and the failure is reported through
+// thread_setup_errors().
+struct scheduler_thread_options {
+    // Worker i is named "<name_prefix>-<i>", with the prefix shortened to fit the 15 characters
+    // Linux keeps. Empty leaves the inherited name.
+    std::string name_prefix = "mbt-sched";
+    // Worker i is pinned to cpus[i % cpus.size()], so listing isolated cores (isolcpus=) dedicates
+    // them to the workers. Empty keeps the inherited affinity.
+    std::vector<int> cpus;
+    // Real-time SCHED_FIFO priority (1-99); usually needs CAP_SYS_NICE.
+    std::optional<int> fifo_priority{};
+    // Nice level (-20..19) for SCHED_OTHER workers; ignored by the kernel while fifo_priority holds.
+    std::optional<int> nice{};
+};
+
+// Applies `options` to the calling thread as worker `worker_index`. Returns an empty string on
+// success, otherwise the settings that could not be applied, separated by "; ".
+[[nodiscard]] std::string apply_scheduler_thread_options(const scheduler_thread_options& options,
+                                                         std::size_t worker_index);
+
+// Worker count a scheduler starts when asked for 0 workers: the hardware thread count capped at 4 (2 when
+// it is unknown). Jobs block and cancellation is cooperative, so more workers rarely help.
+[[nodiscard]] std::size_t default_scheduler_worker_count() noexcept;
+
+// Job ids carry a slot index in the low 32 bits and the slot's generation in the high 32 bits, so an
+// id whose slot has been recycled reports job_status::unknown rather than another job's state.
 class thread_pool_scheduler final : public scheduler {
 public:
-    explicit thread_pool_scheduler(std::size_t worker_count = 0);
+    explicit thread_pool_scheduler(std::size_t worker_count = 0,
+                                   scheduler_limits limits = {},
+                                   scheduler_thread_options threads = {});
     ~thread_pool_scheduler() override;
 
     thread_pool_scheduler(const thread_pool_scheduler&) = delete;
@@ -75,12 +271,27 @@ public:
     job_id submit(job_request req) override;
     job_info get_info(job_id id) const override;
     bool try_get_result(job_id id, job_result& out) override;
+    bool take_result(job_id id, job_result& out) override;
     bool cancel(job_id id) override;
     scheduler_profile_stats stats_snapshot() const override;
 
+    [[nodiscard]] const scheduler_limits& limits() const noexcept { return limits_; }
+    // Slots currently allocated (in use or free).
+    [[nodiscard]] std::size_t slot_count() const;
+    [[nodiscard]] std::size_t worker_count() const noexcept { return worker_count_; }
+    [[nodiscard]] const scheduler_thread_options& thread_options() const noexcept { return threads_; }
+    // Setup failures reported by workers so far, prefixed with the worker index.
+    [[nodiscard]] std::vector<std::string> thread_setup_errors() const;
+    // Blocks until no job is queued or running, or until `timeout` passes; returns false on timeout.
+    // A simulated-time loop calls this between ticks so that every job submitted in one tick has
+    // finished, whatever the wall time it took, before the next tick looks for it.
+    bool wait_idle(std::chrono::steady_clock::duration timeout);
+
 private:
     struct job_state {
         job_id id = 0;
+        std::uint32_t generation = 1;
+        bool in_use = false;
         job_status status = job_status::queued;
         job_timing timing{};
         std::string task_name;
@@ -88,22 +299,59 @@ private:
         job_request request;
         std::optional<job_result> result;
         bool cancel_requested = false;
+        // Read by the job's cancel_token unless request.cancel_flag is set.
+        std::atomic<bool> cancel_signal{false};
     };
 
-    void worker_loop();
+    // Caller holds mutex_.
+    [[nodiscard]] job_state* find_locked(job_id id) const noexcept;
+    [[nodiscard]] job_state& acquire_slot_locked();
+    void retire_locked(job_state& state);
+    void recycle_locked(std::uint32_t index);
+    static void notify(job_state& state);
+    [[nodiscard]] static std::atomic<bool>& cancel_flag_of(job_state& state) noexcept;
+
+    // Caller holds mutex_ and ready_count_ > 0.
+    [[nodiscard]] job_id pop_ready_locked();
+
+    void worker_loop(std::size_t index);
 
     std::size_t worker_count_;
+    scheduler_limits limits_;
+    scheduler_thread_options threads_;
     mutable std::mutex mutex_;
     std::condition_variable cv_;
+    // Signalled when live_jobs_ drops to zero.
+    std::condition_variable idle_cv_;
+    // Jobs submitted and not yet retired.
+    std::size_t live_jobs_ = 0;
     bool stopping_ = false;
-    job_id next_job_id_ = 1;
 
-    std::queue<job_id> queue_;
-    std::unordered_map<job_id, std::shared_ptr<job_state>> jobs_;
+    struct ready_job {
+        // time_point::max() for jobs without a deadline.
+        std::chrono::steady_clock::time_point deadline{};
+        std::uint64_t order = 0;
+        job_id id = 0;
+    };
+
+    // One min-heap per priority class, ordered by deadline then submission. Jobs cancelled while
+    // queued stay in their heap until a worker pops and skips them.
+    std::array<std::vector<ready_job>, k_job_priority_count> ready_{};
+    std::size_t ready_count_ = 0;
+    std::uint64_t next_order_ = 0;
+    // Pooled job states; unique_ptr keeps their addresses stable while workers run them unlocked.
+    std::vector<std::unique_ptr<job_state>> slots_;
+    std::vector<std::uint32_t> free_slots_;
+    // Finished slots, oldest first.
+    std::queue<std::uint32_t> finished_;
     scheduler_profile_stats stats_{};
+    std::vector<std::string> thread_setup_errors_;
     std::vector<std::thread> workers_;
 };
 
 const char* job_status_name(job_status st) noexcept;
+const char* job_priority_name(job_priority priority) noexcept;
+// Accepts "high", "normal" and "low".
+[[nodiscard]] bool parse_job_priority(std::string_view text, job_priority& out) noexcept;
 
 }  // namespace bt
@@ -1,13 +1,104 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <span>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "bt/ast.hpp"
+#include "bt/instance.hpp"
 
 namespace bt {
 
 void save_definition_binary(const definition& def, const std::string& path);
+// The flat image save_definition_binary writes, for embedding in other files; definition_view reads it.
+[[nodiscard]] std::vector<std::byte> encode_definition_binary(const definition& def);
 definition load_definition_binary(const std::string& path);
 void export_definition_dot(const definition& def, const std::string& path);
 
+// Instance checkpoints hold what an instance carries from one tick to the next: the memory of nodes
+// that used it, the tick index and the blackboard, as a compact little-endian image. The image
+// records the node layout of its tree and restores only into an instance with the same layout.
+// Blackboard timestamps are stored as ages, so a restored entry is as old as it was when saved.
+// Throws std::runtime_error for state that cannot leave the process (see
+// instance::uncopyable_state, and image or blob handles on the blackboard). Scheduler jobs that a
+// leaf tracks through its memory are not saved; their leaves see an unknown job after a restore.
+[[nodiscard]] std::vector<std::byte> encode_instance_checkpoint(const instance& inst);
+// Validates the whole image, then resets `inst` (see bt::reset) and loads the image into it. A bad
+// image leaves the instance unchanged.
+void restore_instance_checkpoint(instance& inst, std::span<const std::byte> image);
+void save_instance_checkpoint(const instance& inst, const std::string& path);
+void load_instance_checkpoint(instance& inst, const std::string& path);
+
+// Read-only view over a flat (format version 2) binary definition. The image is a header followed by
+// fixed-size node and arg records, a child id pool, a blackboard key table, and a string pool. Every
+// reference is an offset from the start of the image, so it can be used in place from any address,
+// such as an mmapped file. `open` checks every offset and count up front, so the accessors do not
+// re-check them. The view does not own the bytes.
+class definition_view {
+public:
+    static definition_view open(std::span<const std::byte> image);
+
+    [[nodiscard]] std::size_t node_count() const noexcept { return node_count_; }
+    [[nodiscard]] node_id root() const noexcept { return root_; }
+    [[nodiscard]] node_kind kind(node_id id) const;
+    [[nodiscard]] std::int64_t int_param(node_id id) const;
+    [[nodiscard]] bb_slot state_key(node_id id) const;
+    [[nodiscard]] std::size_t child_count(node_id id) const;
+    [[nodiscard]] node_id child(node_id id, std::size_t index) const;
+    [[nodiscard]] std::string_view leaf_name(node_id id) const;
+    [[nodiscard]] std::size_t arg_count(node_id id) const;
+    [[nodiscard]] arg_value arg(node_id id, std::size_t index) const;
+    [[nodiscard]] std::size_t bb_key_count() const noexcept { return bb_key_count_; }
+    [[nodiscard]] std::string_view bb_key(std::size_t index) const;
+
+    // Copies the image into an owning `definition` for the runtime.
+    [[nodiscard]] definition materialise() const;
+
+private:
+    struct node_record;
+
+    definition_view() = default;
+
+    template <typename T>
+    [[nodiscard]] T load(std::uint64_t offset) const;
+    [[nodiscard]] node_record node_at(node_id id) const;
+    [[nodiscard]] std::string_view string_at(std::uint32_t offset, std::uint32_t size) const;
+
+    std::span<const std::byte> image_;
+    std::size_t node_count_ = 0;
+    node_id root_ = 0;
+    std::size_t child_total_ = 0;
+    std::size_t arg_total_ = 0;
+    std::size_t bb_key_count_ = 0;
+    std::uint64_t nodes_offset_ = 0;
+    std::uint64_t children_offset_ = 0;
+    std::uint64_t args_offset_ = 0;
+    std::uint64_t bb_keys_offset_ = 0;
+    std::uint64_t strings_offset_ = 0;
+    std::uint64_t strings_size_ = 0;
+};
+
+// Maps a binary definition file read-only (mmap on POSIX, a heap copy elsewhere) and exposes its view.
+class mapped_definition_file {
+public:
+    explicit mapped_definition_file(const std::string& path);
+    ~mapped_definition_file();
+
+    mapped_definition_file(const mapped_definition_file&) = delete;
+    mapped_definition_file& operator=(const mapped_definition_file&) = delete;
+
+    [[nodiscard]] std::span<const std::byte> bytes() const noexcept { return {data_, size_}; }
+    // Throws for legacy (version 1) streams, which can only be decoded by load_definition_binary.
+    [[nodiscard]] definition_view view() const { return definition_view::open(bytes()); }
+
+private:
+    const std::byte* data_ = nullptr;
+    std::size_t size_ = 0;
+    bool mapped_ = false;
+    std::vector<std::byte> owned_;
+};
+
 }  // namespace bt
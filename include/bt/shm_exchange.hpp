@@ -0,0 +1,116 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace bt {
+
+// The two directions of a shm_exchange: observations flow from the host to the BT process, actions
+// from the BT process to the host.
+enum class shm_channel : std::uint8_t {
+    observation,
+    action,
+};
+
+// One message as copied out of a shm_exchange channel.
+struct shm_message {
+    // Observation flag: the episode is over.
+    static constexpr std::uint32_t k_flag_done = 1u;
+    // Action flag: reset the episode instead of applying `values`. `aux` holds the seed when
+    // k_flag_seed is also set.
+    static constexpr std::uint32_t k_flag_reset = 2u;
+    static constexpr std::uint32_t k_flag_seed = 4u;
+
+    // 0 until the first publish; then the channel's running message count.
+    std::uint64_t seq = 0;
+    std::int64_t t_ms = 0;
+    std::int64_t aux = 0;
+    std::uint32_t flags = 0;
+    std::vector<double> values;
+};
+
+// Lock-free observation/action exchange between a BT process and an out-of-process simulator (an
+// Isaac Sim or Python host), so neither side goes through a middleware or an interpreter per tick.
+//
+// The exchange is one POSIX shared-memory object, "/<name>", laid out as a 64-byte header followed by
+// the observation channel and then the action channel. Each channel is two buffers of (64-byte buffer
+// header + capacity doubles rounded up to 64 bytes). Integers are in host byte order:
+//   header: char magic[8] = "MBTSHMEX", u32 version = 1, u32 obs_capacity, u32 act_capacity,
+//           u32 closed (atomic), u32 obs_doorbell, u32 act_doorbell, u32 obs_waiters,
+//           u32 act_waiters (atomics), u64 obs_seq, u64 act_seq (atomics; last published seq)
+//   buffer: u64 lock (seqlock: odd while the buffer is being written), u64 seq, i64 t_ms, i64 aux,
+//           u32 flags, u32 count, then count doubles
+// Message n of a channel lives in buffer n % 2, so the writer fills the buffer a reader of the latest
+// message is not looking at. A reader copies the buffer, then checks that lock was even and unchanged
+// and that seq is still n; otherwise it retries with the newer message.
+//
+// After each publish the writer bumps the channel's doorbell word and, when a peer is parked on it
+// (its waiters word is non-zero), wakes it with a shared futex on Linux. A waiter spins on the
+// channel's seq for a short while first, which is what keeps a round trip in the microseconds.
+// Elsewhere, and for hosts that cannot reach futexes (such as Python over mmap), polling seq is enough.
+//
+// Each channel has one writer: the host publishes observations and the BT process publishes actions.
+class shm_exchange {
+public:
+    static constexpr std::chrono::microseconds k_default_spin{50};
+
+    // Creates (or replaces) the shared-memory object and unlinks it again on destruction. Throws
+    // std::runtime_error when shared memory is unavailable or a capacity is zero.
+    [[nodiscard]] static std::shared_ptr<shm_exchange> create(std::string name,
+                                                              std::size_t obs_capacity,
+                                                              std::size_t act_capacity);
+    // Maps an exchange created by the peer. Throws std::runtime_error when the object does not exist
+    // or is not an exchange.
+    [[nodiscard]] static std::shared_ptr<shm_exchange> open(std::string name);
+
+    ~shm_exchange();
+    shm_exchange(const shm_exchange&) = delete;
+    shm_exchange& operator=(const shm_exchange&) = delete;
+
+    // Copies `values` into the channel's next buffer, rings its doorbell and returns the new seq.
+    // Throws std::length_error when `values` is larger than the channel's capacity.
+    std::uint64_t publish(shm_channel channel,
+                          std::span<const double> values,
+                          std::int64_t t_ms,
+                          std::uint32_t flags = 0,
+                          std::int64_t aux = 0);
+    // Copies the latest message of `channel` into `out`, reusing its storage. Returns false when
+    // nothing has been published yet.
+    bool read(shm_channel channel, shm_message& out) const;
+    // Seq of the latest message of `channel`; 0 before the first publish.
+    [[nodiscard]] std::uint64_t latest(shm_channel channel) const noexcept;
+    // Blocks until `channel` has a message newer than `after_seq`, spinning for up to `spin` before
+    // parking. Returns false on timeout or once the exchange is closed.
+    bool wait(shm_channel channel,
+              std::uint64_t after_seq,
+              std::chrono::microseconds timeout,
+              std::chrono::microseconds spin = k_default_spin) const;
+
+    // Marks the exchange closed and wakes both sides; either peer may call it when it goes away.
+    void close() noexcept;
+    [[nodiscard]] bool closed() const noexcept;
+
+    [[nodiscard]] const std::string& name() const noexcept { return name_; }
+    [[nodiscard]] std::size_t capacity(shm_channel channel) const noexcept;
+
+private:
+    shm_exchange(std::string name, void* base, std::size_t mapped_bytes, bool owner);
+
+    [[nodiscard]] std::byte* buffer(shm_channel channel, std::uint64_t seq) const noexcept;
+
+    std::string name_;
+    void* base_ = nullptr;
+    std::size_t mapped_bytes_ = 0;
+    std::size_t obs_capacity_ = 0;
+    std::size_t act_capacity_ = 0;
+    std::size_t obs_stride_ = 0;
+    std::size_t act_stride_ = 0;
+    bool owner_ = false;
+};
+
+}  // namespace bt
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "bt/instance.hpp"
+
+namespace bt {
+
+// A clock_interface that only moves when told to, for running a simulation faster (or slower) than
+// wall time. The time is kept in one atomic, so now() is safe from any thread while one thread
+// advances it. The clock never moves backwards: set() to an earlier time is ignored.
+class sim_clock final : public clock_interface {
+public:
+    using time_point = std::chrono::steady_clock::time_point;
+
+    // Non-zero, so that no simulated timestamp reads as an unset time_point.
+    static constexpr time_point k_default_start{std::chrono::seconds(1)};
+
+    explicit sim_clock(time_point start = k_default_start) noexcept
+        : ns_(std::chrono::duration_cast<std::chrono::nanoseconds>(start.time_since_epoch()).count()) {}
+
+    time_point now() const override {
+        return time_point(std::chrono::duration_cast<time_point::duration>(
+            std::chrono::nanoseconds(ns_.load(std::memory_order_acquire))));
+    }
+
+    [[nodiscard]] bool simulated() const noexcept override { return true; }
+
+    void advance(std::chrono::nanoseconds by) noexcept {
+        if (by.count() > 0) {
+            ns_.fetch_add(by.count(), std::memory_order_acq_rel);
+        }
+    }
+
+    void set(time_point at) noexcept {
+        const std::int64_t target = std::chrono::duration_cast<std::chrono::nanoseconds>(at.time_since_epoch()).count();
+        std::int64_t current = ns_.load(std::memory_order_relaxed);
+        while (current < target && !ns_.compare_exchange_weak(current, target, std::memory_order_acq_rel)) {
+        }
+    }
+
+private:
+    std::atomic<std::int64_t> ns_;
+};
+
+}  // namespace bt
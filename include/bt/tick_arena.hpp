@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+
+namespace bt {
+
+// Monotonic scratch memory for allocations that do not outlive one tick: event payloads and the
+// serialised event lines built from them. Allocation bumps a pointer through a buffer owned by the
+// arena and deallocation is a no-op; reset() rewinds the buffer at tick end. A tick that overruns the
+// buffer spills to the heap, and the next reset() regrows the buffer to cover it, so once ticks reach
+// a steady size they stop touching the heap. The buffer is allocated by the first allocation, so an
+// instance that never ticks with events on costs no scratch memory.
+class tick_arena final : public std::pmr::memory_resource {
+public:
+    static constexpr std::size_t k_default_bytes = 16 * 1024;
+
+    explicit tick_arena(std::size_t initial_bytes = k_default_bytes);
+    ~tick_arena() override;
+
+    tick_arena(const tick_arena&) = delete;
+    tick_arena& operator=(const tick_arena&) = delete;
+
+    // Frees spilled blocks and rewinds the buffer. Growth happens here, outside any tick.
+    void reset();
+
+    [[nodiscard]] std::size_t capacity_bytes() const noexcept;
+    [[nodiscard]] std::size_t used_bytes() const noexcept;
+    // Largest number of bytes a single tick asked for, including spilled blocks.
+    [[nodiscard]] std::size_t high_water_bytes() const noexcept;
+    // Number of resets that found the buffer had overrun (and so regrew it).
+    [[nodiscard]] std::uint64_t overflow_count() const noexcept;
+
+private:
+    struct spill_block;
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) noexcept override;
+    [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    std::unique_ptr<std::byte[]> buffer_;
+    std::size_t capacity_ = 0;
+    std::size_t used_ = 0;
+    std::size_t spilled_bytes_ = 0;
+    std::size_t high_water_ = 0;
+    std::uint64_t overflow_count_ = 0;
+    spill_block* spills_ = nullptr;
+};
+
+}  // namespace bt
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "bt/event_log.hpp"
+#include "bt/runtime.hpp"
+#include "muslisp/gc.hpp"
+
+namespace bt {
+
+// Ticks a wave of independent instances on worker threads. The wave is split into contiguous slices,
+// one per worker. Each worker ticks its slice with its own Lisp heap bound as muslisp::default_gc()
+// and its own event-log shard. Once every slice is done, the shards are replayed into the canonical
+// log in wave order, so event sequence numbers do not depend on thread timing.
+//
+// Only waves whose definitions are native-only (leaf_link_table::native_only) go parallel; a wave with
+// a Lisp leaf, which could write the shared global env or process-heap objects, is ticked on the
+// calling thread. Leaves ticked in parallel share the registry, scheduler, services and interfaces in
+// `svc`. They must be safe to call concurrently, and must not store Lisp values into objects they did
+// not allocate.
+class tick_worker_pool {
+public:
+    // Receives a worker heap's collection events on that worker's thread, with the worker's shard.
+    using heap_event_sink = std::function<void(event_log& shard, const muslisp::gc_lifecycle_event& event)>;
+
+    explicit tick_worker_pool(std::size_t worker_count, heap_event_sink on_heap_event = nullptr);
+    ~tick_worker_pool();
+
+    tick_worker_pool(const tick_worker_pool&) = delete;
+    tick_worker_pool& operator=(const tick_worker_pool&) = delete;
+
+    [[nodiscard]] std::size_t worker_count() const noexcept;
+    // Waves of two or more instances split across the workers, and those ticked on the calling thread
+    // instead because a definition was not native-only.
+    [[nodiscard]] std::uint64_t parallel_waves() const noexcept { return parallel_waves_; }
+    [[nodiscard]] std::uint64_t sequential_waves() const noexcept { return sequential_waves_; }
+
+    // Same contract as bt::tick_wave, except that each instance may appear only once. If a slice
+    // throws, the first error in wave order is rethrown after every worker has finished.
+    void tick_wave(std::span<instance* const> insts, registry& reg, services& svc, std::span<status> out);
+
+private:
+    struct worker {
+        std::unique_ptr<muslisp::gc> heap;
+        event_log shard{0};
+        std::span<instance* const> insts;
+        std::span<status> out;
+        std::exception_ptr error;
+        std::thread thread;
+    };
+
+    void worker_loop(worker& w);
+    void run_slice(worker& w);
+
+    heap_event_sink on_heap_event_;
+    std::vector<std::unique_ptr<worker>> workers_;
+    std::vector<instance*> sorted_;
+    std::uint64_t parallel_waves_ = 0;
+    std::uint64_t sequential_waves_ = 0;
+
+    std::mutex mutex_;
+    std::condition_variable wave_cv_;
+    std::condition_variable done_cv_;
+    std::uint64_t wave_ = 0;
+    std::size_t pending_ = 0;
+    bool stopping_ = false;
+    registry* reg_ = nullptr;
+    services svc_{};
+};
+
+}  // namespace bt
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace bt {
+
+// Why an on-demand instance should tick; see set_tick_on_demand. Reasons are bits and combine.
+enum class wake_reason : std::uint32_t {
+    none = 0,
+    // The instance has not ticked since on-demand ticking was turned on.
+    initial = 1u << 0,
+    // A blackboard key in the instance's wake set changed.
+    bb_write = 1u << 1,
+    // A scheduler job a leaf watches (tick_context::watch_job) finished or moved.
+    job_complete = 1u << 2,
+    // max_interval passed since the last tick.
+    timer = 1u << 3,
+    // The last tick left a leaf running that no watched job will wake, so the instance polls it.
+    running = 1u << 4
+};
+
+[[nodiscard]] constexpr std::uint32_t wake_bits(wake_reason reason) noexcept {
+    return static_cast<std::uint32_t>(reason);
+}
+
+// Symbolic name of one reason ("initial", "bb_write", ...).
+const char* wake_reason_name(wake_reason reason) noexcept;
+
+// Wake reasons pending for one instance. notify() is safe from any thread and costs one atomic or
+// when nobody waits; the tick thread takes the bits when it ticks, or blocks in wait_until() until
+// some arrive.
+class tick_waker {
+public:
+    void notify(wake_reason reason) noexcept;
+    // The pending reasons, clearing them.
+    [[nodiscard]] std::uint32_t take() noexcept { return pending_.exchange(0); }
+    [[nodiscard]] std::uint32_t pending() const noexcept { return pending_.load(); }
+    // Blocks until a reason is pending or `deadline` passes; returns the pending reasons without
+    // clearing them (0 on timeout).
+    std::uint32_t wait_until(std::chrono::steady_clock::time_point deadline);
+
+private:
+    std::atomic<std::uint32_t> pending_{0};
+    // Threads blocked in wait_until; notify() only takes the mutex when this is non-zero.
+    std::atomic<std::uint32_t> waiters_{0};
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
+
+}  // namespace bt
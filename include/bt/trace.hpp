@@ -1,19 +1,22 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
-#include <mutex>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "bt/ast.hpp"
+#include "bt/blackboard.hpp"
 #include "bt/scheduler.hpp"
 #include "bt/status.hpp"
 
 namespace bt {
 
-enum class trace_event_kind {
+enum class trace_event_kind : std::uint8_t {
     tick_begin,
     tick_end,
     node_enter,
@@ -30,6 +33,46 @@ enum class trace_event_kind {
     error
 };
 
+// How a record's value was captured: as preformatted text, or as a blackboard value snapshot that
+// is only formatted (with bb_value_repr) when the trace is read.
+enum class trace_value_kind : std::uint8_t {
+    text,
+    nil,
+    boolean,
+    int64,
+    float64,
+    float64_vector,
+    string,
+    image_handle,
+    blob_handle
+};
+
+// The fixed-size part of a trace event, as stored in the ring. Producers fill in what they know;
+// trace_buffer::push assigns sequence and the text location.
+struct trace_record {
+    trace_event_kind kind = trace_event_kind::tick_begin;
+    status node_status = status::failure;
+    job_status job_st = job_status::unknown;
+    trace_value_kind value_kind = trace_value_kind::text;
+    node_id node = 0;
+    std::uint64_t sequence = 0;
+    std::uint64_t tick_index = 0;
+    std::chrono::steady_clock::time_point ts{};
+    std::chrono::nanoseconds duration{0};
+    job_id job = 0;
+
+    // key, value and message bytes are stored back to back in the buffer's text ring. A string or
+    // vector value keeps its first elements there (raw doubles for vectors); value_count is its full
+    // length. Scalars and handles live in value_bits.
+    std::uint64_t text_offset = 0;
+    std::uint32_t key_size = 0;
+    std::uint32_t value_size = 0;
+    std::uint32_t message_size = 0;
+    std::uint32_t value_count = 0;
+    std::uint64_t value_bits = 0;
+};
+
+// A decoded trace event, as returned by trace_buffer::snapshot().
 struct trace_event {
     trace_event_kind kind = trace_event_kind::tick_begin;
     std::uint64_t sequence = 0;
@@ -48,21 +91,72 @@ struct trace_event {
     std::string message;
 };
 
+// Fixed-capacity ring of trace records. Event text lives in a separate byte ring sized at
+// k_text_bytes_per_event per slot; text that has been overwritten by the time of a snapshot decodes
+// as "<evicted>". Both rings are allocated by the first push, so instances that never trace cost
+// nothing; after that pushing never allocates. If that allocation fails the buffer keeps counting
+// sequence numbers but retains nothing.
+//
+// push() and clear() are single-writer and lock-free: only the thread ticking the owning instance
+// may call them. snapshot() and size() may run concurrently with the writer; each slot is guarded
+// by a sequence lock, and records overwritten mid-copy are skipped.
 class trace_buffer {
 public:
+    static constexpr std::size_t k_text_bytes_per_event = 64;
+    static constexpr std::size_t k_default_value_preview = 16;
+
     explicit trace_buffer(std::size_t capacity_events);
 
-    void push(trace_event ev);
+    trace_buffer(const trace_buffer&) = delete;
+    trace_buffer& operator=(const trace_buffer&) = delete;
+
+    void push(const trace_record& rec,
+              std::string_view key = {},
+              std::string_view value_repr = {},
+              std::string_view message = {}) noexcept;
+    void push(const trace_event& ev) noexcept;
+    // Records a blackboard value without formatting it. Strings and vectors keep at most
+    // value_preview() characters or elements; the decoded text marks the cut with "...".
+    void push_value(const trace_record& rec, std::string_view key, const bb_value& value) noexcept;
+    void set_value_preview(std::size_t elements) noexcept;
+    [[nodiscard]] std::size_t value_preview() const noexcept;
+    // Decodes the retained events, oldest first.
     std::vector<trace_event> snapshot() const;
-    std::size_t size() const;
-    std::size_t capacity() const;
-    void clear();
+    std::size_t size() const noexcept;
+    std::size_t capacity() const noexcept;
+    // Whether the rings have been allocated. Writer thread only.
+    [[nodiscard]] bool allocated() const noexcept;
+    // Bytes of the event and text rings; 0 until the first push allocates them. Writer thread only.
+    [[nodiscard]] std::size_t memory_bytes() const noexcept;
+    // Forgets retained events; sequence numbers keep counting.
+    void clear() noexcept;
 
 private:
+    struct slot {
+        std::atomic<std::uint64_t> version{0};
+        trace_record rec{};
+    };
+
+    void append(trace_record rec, std::string_view key, std::string_view value, std::string_view message) noexcept;
+    // Allocates the rings on the first push only, so readers that saw a pushed event see them too.
+    bool allocate() noexcept;
+    void write_text(std::uint64_t offset, std::string_view text) noexcept;
+    void read_text(std::uint64_t offset, std::size_t size, std::string& out) const;
+
     std::size_t capacity_;
-    std::vector<trace_event> events_;
-    std::uint64_t sequence_ = 0;
-    mutable std::mutex mutex_;
+    std::unique_ptr<slot[]> slots_;
+    std::size_t text_capacity_ = 0;
+    std::unique_ptr<char[]> text_;
+    std::size_t value_preview_ = k_default_value_preview;
+    bool allocation_tried_ = false;
+
+    // Writer-side position of the next slot, so push() does not divide.
+    std::size_t next_slot_ = 0;
+    // Events pushed so far (== the newest sequence number) and the count before the last clear().
+    std::atomic<std::uint64_t> head_{0};
+    std::atomic<std::uint64_t> cleared_at_{0};
+    // End of the text reserved so far; bytes before text_end_ - text_capacity_ have been overwritten.
+    std::atomic<std::uint64_t> text_end_{0};
 };
 
 const char* trace_event_kind_name(trace_event_kind kind) noexcept;
@@ -1,18 +1,24 @@
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <list>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <queue>
+#include <span>
 #include <string>
 #include <string_view>
 #include <unordered_map>
 #include <vector>
 
+#include "bt/payload_pool.hpp"
+#include "bt/frame_ring.hpp"
 #include "bt/scheduler.hpp"
 
 namespace bt {
@@ -33,6 +39,10 @@ struct image_info {
     std::string encoding = "rgb8";
     std::int64_t timestamp_ms = 0;
     std::string frame_id = "camera";
+    // "shm://<ring>/<sequence>" when the pixels were written to the attached frame ring.
+    std::string frame_ref;
+    // True when the pixels are held in process by adopt_image.
+    bool in_process = false;
 };
 
 struct blob_info {
@@ -41,6 +51,17 @@ struct blob_info {
     std::string mime_type = "application/octet-stream";
     std::int64_t timestamp_ms = 0;
     std::string tag;
+    // "shm://<ring>/<sequence>" when the bytes were written to the attached frame ring.
+    std::string frame_ref;
+    // True when the bytes are held in process by adopt_blob.
+    bool in_process = false;
+};
+
+// Bytes that live in a buffer owned by someone else, such as a received ROS message, kept alive by
+// `owner` rather than copied.
+struct retained_payload {
+    std::shared_ptr<const void> owner;
+    std::span<const std::byte> bytes;
 };
 
 struct capability_field {
@@ -134,6 +155,8 @@ struct vla_request {
     vla_action_space action_space{};
     vla_constraints constraints{};
     std::int64_t deadline_ms = 200;
+    // Scheduler class of the job; the job's scheduler deadline is submission + deadline_ms.
+    job_priority priority = job_priority::normal;
     std::optional<std::uint64_t> seed{};
     vla_model_info model{};
 
@@ -142,9 +165,19 @@ struct vla_request {
     std::string node_name = "vla-node";
 };
 
+// One action of a multi-action result, such as an MMSP action chunk, held for `dt_ms` before the
+// next one applies.
+struct vla_chunk_step {
+    std::vector<double> u{};
+    double dt_ms = 0.0;
+};
+
 struct vla_response {
     vla_status status = vla_status::error;
     vla_action action{};
+    // Every action of an action chunk, the first being `action`; empty for single-action results.
+    // The service gates each step as it gates `action`.
+    std::vector<vla_chunk_step> chunk{};
     double confidence = 0.0;
     std::string explanation{};
     vla_model_info model{};
@@ -169,6 +202,93 @@ struct vla_poll {
     std::unordered_map<std::string, double> stats{};
 };
 
+// Incremental FNV-1a: the value vla_service::hash64 gives for a text, taken from its pieces without
+// building the text. Numbers are fed as the bytes `std::ostream <<` would write for them in the
+// classic locale, so streaming a sequence of writes hashes the same as writing it to a
+// std::ostringstream and hashing the result.
+class hash64_stream {
+public:
+    hash64_stream& operator<<(std::string_view text) noexcept;
+    hash64_stream& operator<<(char c) noexcept;
+    hash64_stream& operator<<(std::int64_t value) noexcept;
+    hash64_stream& operator<<(double value) noexcept;
+
+    [[nodiscard]] std::uint64_t value() const noexcept { return hash_; }
+
+private:
+    std::uint64_t hash_ = 1469598103934665603ull;
+};
+
+// Counters of the vla_service response cache. Evictions are entries dropped to stay within capacity;
+// expirations are entries dropped because their TTL ran out.
+struct vla_cache_stats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+    std::uint64_t expirations = 0;
+    std::size_t size = 0;
+    std::size_t capacity = 0;
+};
+
+// Response cache keyed by request hash. Keys are spread over k_shard_count shards, each with its
+// own lock, an LRU list and a min-heap of expiry times, so a lookup or insert touches one shard and
+// costs O(1) plus O(log n) for the heap; nothing scans the whole cache. The capacity bounds the
+// total across shards. When it is exceeded, eviction compares the least recently used entry of each
+// shard (a fixed k_shard_count peeks) and drops the oldest, so the cache as a whole stays LRU.
+class vla_response_cache {
+public:
+    using clock = std::chrono::steady_clock;
+    static constexpr std::size_t k_shard_count = 16;
+
+    explicit vla_response_cache(std::size_t capacity);
+
+    // Returns the live entry for `key` and marks it most recently used; counts a hit or a miss.
+    [[nodiscard]] std::optional<vla_response> find(std::uint64_t key, clock::time_point now);
+    void insert(std::uint64_t key, vla_response response, clock::time_point expires_at);
+    void set_capacity(std::size_t capacity);
+    [[nodiscard]] std::size_t capacity() const noexcept;
+    void clear();
+    [[nodiscard]] vla_cache_stats stats() const noexcept;
+
+private:
+    struct entry {
+        std::uint64_t key = 0;
+        vla_response response;
+        clock::time_point expires_at{};
+        // Value of use_counter_ at the last find or insert.
+        std::uint64_t last_use = 0;
+    };
+    struct expiry {
+        clock::time_point at{};
+        std::uint64_t key = 0;
+        friend bool operator>(const expiry& a, const expiry& b) noexcept { return a.at > b.at; }
+    };
+    struct shard {
+        mutable std::mutex mutex;
+        // Most recently used at the front.
+        std::list<entry> lru;
+        std::unordered_map<std::uint64_t, std::list<entry>::iterator> index;
+        // May hold stale items for keys since refreshed or evicted; they are skipped when popped.
+        std::priority_queue<expiry, std::vector<expiry>, std::greater<>> expiries;
+    };
+
+    [[nodiscard]] shard& shard_for(std::uint64_t key) noexcept;
+    // Drops expired entries from the front of the shard's heap. Caller holds the shard lock.
+    void expire_locked(shard& s, clock::time_point now);
+    void erase_locked(shard& s, std::list<entry>::iterator it);
+    // Evicts the globally least recently used entries until size <= capacity.
+    void evict_to_capacity();
+
+    std::array<shard, k_shard_count> shards_;
+    std::atomic<std::size_t> capacity_;
+    std::atomic<std::size_t> size_{0};
+    std::atomic<std::uint64_t> use_counter_{0};
+    std::atomic<std::uint64_t> hits_{0};
+    std::atomic<std::uint64_t> misses_{0};
+    std::atomic<std::uint64_t> evictions_{0};
+    std::atomic<std::uint64_t> expirations_{0};
+};
+
 struct vla_record {
     std::int64_t ts_ms = 0;
     std::string run_id;
@@ -193,6 +313,8 @@ struct vla_record {
     bool replay_hit = false;
     bool superseded = false;
     bool completion_dropped = false;
+    // Response cache counters when the record was written.
+    vla_cache_stats cache_stats{};
 };
 
 class vla_backend {
@@ -204,6 +326,25 @@ public:
                                std::atomic<bool>& cancel_flag) = 0;
 };
 
+class vla_service;
+
+// References to image and blob handles taken on behalf of whatever holds their ids, such as a
+// blackboard entry. Shared, so a holder may outlive its vla_service: once the service is destroyed
+// every call does nothing and returns false.
+class vla_handle_refs {
+public:
+    bool retain_image(image_handle_ref handle);
+    bool release_image(image_handle_ref handle);
+    bool retain_blob(blob_handle_ref handle);
+    bool release_blob(blob_handle_ref handle);
+
+private:
+    friend class vla_service;
+
+    std::mutex mutex_;
+    vla_service* service_ = nullptr;
+};
+
 class vla_service {
 public:
     using record_listener = std::function<void(const vla_record&, const std::string&)>;
@@ -229,13 +370,55 @@ public:
                                                 std::int64_t channels,
                                                 std::string encoding,
                                                 std::int64_t timestamp_ms,
-                                                std::string frame_id);
+                                                std::string frame_id,
+                                                std::span<const std::byte> payload = {});
     [[nodiscard]] blob_handle_ref create_blob(std::int64_t size_bytes,
                                               std::string mime_type,
                                               std::int64_t timestamp_ms,
-                                              std::string tag);
+                                              std::string tag,
+                                              std::span<const std::byte> payload = {});
+    // Like create_image/create_blob, but the handle keeps `payload` alive instead of copying it.
+    // Throws std::invalid_argument on an empty payload.
+    [[nodiscard]] image_handle_ref adopt_image(std::int64_t width,
+                                               std::int64_t height,
+                                               std::int64_t channels,
+                                               std::string encoding,
+                                               std::int64_t timestamp_ms,
+                                               std::string frame_id,
+                                               retained_payload payload);
+    [[nodiscard]] blob_handle_ref adopt_blob(std::string mime_type,
+                                             std::int64_t timestamp_ms,
+                                             std::string tag,
+                                             retained_payload payload);
     [[nodiscard]] std::optional<image_info> get_image_info(image_handle_ref handle) const;
     [[nodiscard]] std::optional<blob_info> get_blob_info(blob_handle_ref handle) const;
+    // The adopted bytes of a handle; nullopt for unknown handles and handles without them. The copy
+    // shares ownership, so the bytes outlive a release that happens while they are read.
+    [[nodiscard]] std::optional<retained_payload> image_payload(image_handle_ref handle) const;
+    [[nodiscard]] std::optional<retained_payload> blob_payload(blob_handle_ref handle) const;
+    // Handles start with one reference. The last release forgets the handle and drops its payload
+    // owner. Both return false for unknown handles.
+    bool retain_image(image_handle_ref handle);
+    bool release_image(image_handle_ref handle);
+    bool retain_blob(blob_handle_ref handle);
+    bool release_blob(blob_handle_ref handle);
+    // A non-empty payload passed to create_image/create_blob is published to this ring and the handle
+    // records its shm:// ref; without a ring it is copied into a payload_pool slab held in process.
+    // nullptr detaches.
+    void attach_frame_ring(std::shared_ptr<frame_ring> ring);
+    [[nodiscard]] std::shared_ptr<frame_ring> attached_frame_ring() const;
+    // Slabs for payloads held in process. A slab is recycled once the handle is forgotten and every
+    // image_payload/blob_payload copy of it is gone.
+    [[nodiscard]] payload_pool& payload_pool_ref() noexcept;
+    [[nodiscard]] const payload_pool& payload_pool_ref() const noexcept;
+    // Handles not yet released.
+    [[nodiscard]] std::size_t live_images() const;
+    [[nodiscard]] std::size_t live_blobs() const;
+    // Forgets every image and blob handle whatever its count, as if each had been released.
+    void clear_handles();
+    // For holders of handle ids. Blackboards given these by the runtime host take a reference per
+    // entry, and a submitted request holds its observation handles until the backend has run.
+    [[nodiscard]] std::shared_ptr<vla_handle_refs> handle_refs() const noexcept;
 
     [[nodiscard]] std::string dump_recent_records(std::size_t max_count = 200) const;
     [[nodiscard]] std::vector<vla_record> recent_records(std::size_t max_count = 200) const;
@@ -251,16 +434,15 @@ public:
     [[nodiscard]] std::int64_t cache_ttl_ms() const noexcept;
     void set_cache_capacity(std::size_t capacity);
     [[nodiscard]] std::size_t cache_capacity() const noexcept;
+    [[nodiscard]] vla_cache_stats cache_stats() const noexcept;
 
     [[nodiscard]] static std::uint64_t hash64(std::string_view text) noexcept;
+    // Hashes the fields of canonical_request without building it.
     [[nodiscard]] static std::uint64_t hash_request(const vla_request& request);
+    // The text hash_request identifies a request by. Only needed when it is stored or inspected.
+    [[nodiscard]] static std::string canonical_request(const vla_request& request);
 
 private:
-    struct cache_entry {
-        vla_response response;
-        std::chrono::steady_clock::time_point expires_at{};
-    };
-
     struct job_state {
         vla_job_id id = 0;
         vla_request request;
@@ -281,14 +463,19 @@ private:
         std::string error{};
     };
 
-    void append_record(const vla_record& record);
+    void append_record(vla_record record);
     [[nodiscard]] std::string record_to_json(const vla_record& record) const;
     void append_jsonl_line(const std::string& line);
     [[nodiscard]] std::string response_to_json(const vla_response& response) const;
 
     [[nodiscard]] std::shared_ptr<vla_backend> resolve_backend(const vla_request& request) const;
     [[nodiscard]] std::string make_owner_key(const vla_request& request) const;
-    void evict_cache_if_needed();
+    // Publishes to the attached ring and returns the frame's ref, or copies the payload into a pooled
+    // slab when no ring is attached; `where` prefixes errors.
+    [[nodiscard]] std::string store_frame(std::span<const std::byte> payload,
+                                          const frame_ring_meta& meta,
+                                          retained_payload& pooled,
+                                          const char* where);
 
     scheduler* sched_ = nullptr;
     capability_registry capabilities_;
@@ -301,16 +488,29 @@ private:
     std::unordered_map<std::string, std::shared_ptr<vla_backend>> backends_;
     std::string default_backend_ = "rt2-stub";
 
-    std::unordered_map<std::uint64_t, cache_entry> cache_;
-    std::size_t cache_capacity_ = 256;
+    vla_response_cache cache_{256};
     std::int64_t cache_ttl_ms_ = 750;
 
     std::unordered_map<std::uint64_t, vla_response> replay_store_;
 
     std::int64_t next_image_id_ = 1;
     std::int64_t next_blob_id_ = 1;
-    std::unordered_map<std::int64_t, image_info> images_;
-    std::unordered_map<std::int64_t, blob_info> blobs_;
+    struct image_record {
+        image_info info;
+        retained_payload payload;
+        std::uint32_t refs = 1;
+    };
+    struct blob_record {
+        blob_info info;
+        retained_payload payload;
+        std::uint32_t refs = 1;
+    };
+    std::unordered_map<std::int64_t, image_record> images_;
+    std::unordered_map<std::int64_t, blob_record> blobs_;
+    mutable std::mutex frame_ring_mutex_;
+    std::shared_ptr<frame_ring> frame_ring_;
+    payload_pool payload_pool_;
+    std::shared_ptr<vla_handle_refs> handle_refs_;
 
     std::vector<vla_record> records_;
     std::size_t record_capacity_ = 4096;
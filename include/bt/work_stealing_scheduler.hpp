@@ -0,0 +1,198 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bt/scheduler.hpp"
+
+namespace bt {
+
+// A scheduler whose submit, poll and dispatch paths share no lock.
+//
+// Jobs live in a segmented slot table. As in thread_pool_scheduler, a job id carries its slot index in
+// the low 32 bits and the slot's generation in the high 32 bits, so get_info, try_get_result and
+// cancel are a few loads and CASes on that slot. Jobs submitted from outside the pool go onto a
+// bounded multi-producer queue that workers claim in submission order. Jobs submitted by a job
+// running on a worker go onto that worker's bounded Chase-Lev deque, where idle workers steal them.
+// Workers sleep on a futex-style atomic and are only woken when a job is published while some worker
+// is asleep.
+//
+// Dispatch ignores job_request::priority (stats still split queue delay by class), but a job whose
+// deadline has passed when a worker picks it up is cancelled instead of started.
+//
+// A finished job's slot is recycled once take_result has collected its result, or once
+// k_retained_finished later jobs have finished; its id then reports job_status::unknown. submit
+// throws when k_inject_capacity host-submitted jobs are already waiting, or when every one of the
+// k_max_segments * k_jobs_per_segment slots holds a live or retained job.
+class work_stealing_scheduler final : public scheduler {
+public:
+    static constexpr std::size_t k_deque_capacity = 1024;
+    static constexpr std::size_t k_jobs_per_segment = 1024;
+    static constexpr std::size_t k_max_segments = std::size_t{1} << 16;
+    static constexpr std::size_t k_inject_capacity = 65536;
+    static constexpr std::size_t k_retained_finished = 4096;
+
+    explicit work_stealing_scheduler(std::size_t worker_count = 0, scheduler_thread_options threads = {});
+    // Runs every job already queued, then joins the workers.
+    ~work_stealing_scheduler() override;
+
+    work_stealing_scheduler(const work_stealing_scheduler&) = delete;
+    work_stealing_scheduler& operator=(const work_stealing_scheduler&) = delete;
+
+    job_id submit(job_request req) override;
+    job_info get_info(job_id id) const override;
+    bool try_get_result(job_id id, job_result& out) override;
+    bool take_result(job_id id, job_result& out) override;
+    bool cancel(job_id id) override;
+    scheduler_profile_stats stats_snapshot() const override;
+
+    [[nodiscard]] std::size_t worker_count() const noexcept { return workers_.size(); }
+    [[nodiscard]] const scheduler_thread_options& thread_options() const noexcept { return threads_; }
+    // Slots created so far; bounded by the live jobs plus k_retained_finished.
+    [[nodiscard]] std::size_t slot_count() const noexcept { return next_slot_.load(std::memory_order_relaxed); }
+    // Setup failures reported by workers so far, prefixed with the worker index.
+    [[nodiscard]] std::vector<std::string> thread_setup_errors() const;
+
+private:
+    // job_state::state values. running_cancel_requested reports as running.
+    enum class slot_state : std::uint8_t { empty, queued, running, running_cancel_requested, done, failed, cancelled };
+
+    static constexpr std::uint64_t k_lease_recycling = std::uint64_t{1} << 31;
+    static constexpr std::uint64_t k_lease_pins = k_lease_recycling - 1;
+    // job_state::retire_marks bits. Whichever of settle and take_result sets the second one
+    // recycles the slot.
+    static constexpr std::uint8_t k_mark_settled = 1;
+    static constexpr std::uint8_t k_mark_taken = 2;
+
+    struct job_state {
+        std::atomic<slot_state> state{slot_state::empty};
+        // The slot's generation in the high 32 bits, k_lease_recycling while the slot is being reset,
+        // and in the low bits the readers that pinned it to copy its fields. A slot is only reset
+        // unpinned, so a reader never sees a slot that is being recycled.
+        std::atomic<std::uint64_t> lease{std::uint64_t{1} << 32};
+        // k_mark_settled once the thread that ended the job no longer touches the slot, and
+        // k_mark_taken once take_result has moved the result out.
+        std::atomic<std::uint8_t> retire_marks{0};
+        // Next entry of the free-slot stack, as slot index + 1 (0 ends it).
+        std::atomic<std::uint32_t> next_free{0};
+        // Written before the job is published, read-only afterwards, except that the thread moving
+        // the job to a terminal state clears request.fn and request.completions.
+        std::chrono::steady_clock::time_point submitted_at{};
+        std::string task_name;
+        job_request request;
+        // Written by the worker before it publishes done, failed or (for expired jobs) cancelled.
+        std::optional<job_result> result;
+        std::string error_text;
+        // Read by the job's cancel_token unless request.cancel_flag is set.
+        std::atomic<bool> cancel_signal{false};
+        std::atomic<std::int64_t> started_ns{0};
+        std::atomic<std::int64_t> finished_ns{0};
+    };
+
+    struct segment {
+        job_state jobs[k_jobs_per_segment];
+    };
+
+    // Bounded multi-producer, multi-consumer FIFO of host-submitted job ids; each cell's sequence
+    // says whether it is free for the push at that position or holds the id for the pop there.
+    class inject_queue {
+    public:
+        inject_queue();
+        [[nodiscard]] bool push(job_id id) noexcept;
+        [[nodiscard]] bool pop(job_id& out) noexcept;
+
+    private:
+        struct cell {
+            std::atomic<std::uint64_t> sequence{0};
+            job_id id = 0;
+        };
+
+        std::unique_ptr<cell[]> cells_;
+        alignas(64) std::atomic<std::uint64_t> head_{0};
+        alignas(64) std::atomic<std::uint64_t> tail_{0};
+    };
+
+    // Bounded Chase-Lev deque of job ids: the owning worker pushes and pops at the bottom, other
+    // workers steal from the top.
+    class job_deque {
+    public:
+        job_deque();
+        [[nodiscard]] bool full() const noexcept;
+        void push(job_id id) noexcept;
+        [[nodiscard]] bool pop(job_id& out) noexcept;
+        [[nodiscard]] bool steal(job_id& out) noexcept;
+
+    private:
+        alignas(64) std::atomic<std::int64_t> top_{0};
+        alignas(64) std::atomic<std::int64_t> bottom_{0};
+        std::unique_ptr<std::atomic<job_id>[]> slots_;
+    };
+
+    struct alignas(64) worker {
+        work_stealing_scheduler* owner = nullptr;
+        std::size_t index = 0;
+        job_deque deque;
+        // Uncontended except by stats_snapshot().
+        mutable std::mutex stats_mutex;
+        scheduler_profile_stats stats{};
+        std::string setup_error;
+        std::thread thread;
+    };
+
+    static worker*& current_worker() noexcept;
+
+    [[nodiscard]] job_state* slot(job_id id) const noexcept;
+    [[nodiscard]] job_state& slot_at(std::uint32_t index) const noexcept;
+    // Takes a free slot, or a fresh one; throws when the table is full.
+    [[nodiscard]] std::uint32_t acquire_slot();
+    void release_slot(std::uint32_t index) noexcept;
+    // Pins the slot of `id` against recycling; false when the id's slot was already recycled.
+    [[nodiscard]] static bool pin(job_state& job, job_id id) noexcept;
+    static void unpin(job_state& job) noexcept;
+    // Claims the slot of `id` for the caller alone, once no reader holds it pinned.
+    [[nodiscard]] static bool claim_exclusive(job_state& job, job_id id) noexcept;
+    // Resets a slot claimed with claim_exclusive (or never published), bumps its generation and
+    // frees it.
+    void recycle_claimed(job_state& job, job_id id) noexcept;
+    // Recycles the slot of `id` unless it already was.
+    void try_recycle(job_id id) noexcept;
+    // Called by the thread that ended the job, once it is done with the slot: recycles it if its
+    // result was already taken, else retains it and recycles the oldest job past k_retained_finished.
+    void settle(job_state& job, job_id id) noexcept;
+    [[nodiscard]] bool find_work(worker& self, job_id& out) noexcept;
+    void wake_one() noexcept;
+    void run_job(worker& self, job_id id);
+    // Called once, by whichever thread moved the job to its terminal state.
+    static void notify_finished(job_state& job, job_id id);
+    [[nodiscard]] static std::atomic<bool>& cancel_flag_of(job_state& job) noexcept;
+    void worker_loop(worker& self);
+
+    scheduler_thread_options threads_;
+    std::unique_ptr<std::atomic<segment*>[]> directory_;
+    std::vector<std::unique_ptr<worker>> workers_;
+
+    inject_queue injected_;
+    // Free slots as a Treiber stack: an ABA tag in the high 32 bits, the top slot index + 1 below.
+    alignas(64) std::atomic<std::uint64_t> free_head_{0};
+    alignas(64) std::atomic<std::uint32_t> next_slot_{0};
+    // Ids of finished jobs, in finishing order, kept until k_retained_finished later ones finish.
+    std::unique_ptr<std::atomic<job_id>[]> retained_;
+    alignas(64) std::atomic<std::uint64_t> retained_cursor_{0};
+    alignas(64) std::atomic<std::uint32_t> wake_epoch_{0};
+    std::atomic<std::uint32_t> sleepers_{0};
+    std::atomic<bool> stopping_{false};
+
+    std::atomic<std::uint64_t> submitted_{0};
+    std::atomic<std::uint64_t> cancelled_while_queued_{0};
+    std::atomic<std::int64_t> last_queue_delay_ns_{0};
+    std::atomic<std::int64_t> last_run_time_ns_{0};
+};
+
+}  // namespace bt
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <string>
 #include <unordered_map>
 
@@ -7,18 +10,35 @@
 
 namespace muslisp {
 
+// Bindings are keyed by interned symbol, so lookups hash and compare pointers rather than names.
+struct symbol_key_hash {
+    [[nodiscard]] std::size_t operator()(value symbol) const noexcept {
+        return std::hash<std::uintptr_t>{}(reinterpret_cast<std::uintptr_t>(symbol) >> 4);
+    }
+};
+
+using binding_map = std::unordered_map<value, value, symbol_key_hash>;
+
 struct env final : gc_node {
     explicit env(env_ptr parent_env = nullptr);
 
     env_ptr parent = nullptr;
-    std::unordered_map<std::string, value> bindings;
+    binding_map bindings;
+    // Bumped whenever a new name is bound here (not on rebinding), so cached binding cells can detect shadowing.
+    std::uint64_t shape_version = 0;
 
     void gc_mark_children(gc& heap) override;
     [[nodiscard]] std::size_t gc_size_bytes() const override;
 };
 
 env_ptr make_env(env_ptr parent = nullptr);
+// `symbol` overloads take an interned symbol value; the string forms intern (define) or look up the name first.
+void define(env_ptr scope, value symbol, value bound_value);
 void define(env_ptr scope, const std::string& name, value bound_value);
+value lookup(env_ptr scope, value symbol);
 value lookup(env_ptr scope, const std::string& name);
+// Returns the binding cell for `symbol`, or nullptr if unbound. Cells stay valid while their env is alive.
+value* lookup_cell(env_ptr scope, value symbol, std::size_t* depth = nullptr);
+value* lookup_cell(env_ptr scope, const std::string& name, std::size_t* depth = nullptr);
 
 }  // namespace muslisp
@@ -1,9 +1,13 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <optional>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "muslisp/value.hpp"
@@ -16,6 +20,43 @@ struct env_backend_supports {
     bool headless = false;
     bool realtime_pacing = false;
     bool deterministic_seed = false;
+    // acquire_observation() may run on another thread while act() and step() run; see env.run-loop
+    // :pipeline_observe.
+    bool pipelined_observe = false;
+    // observe_into() writes the observation as typed fields; see env.run-loop :observe_into.
+    bool typed_observe = false;
+    // env_count() copies of the environment are observed, acted on and stepped as one batch; see
+    // env.run-batch.
+    bool batched_step = false;
+    // The t_ms of each observation is the simulation's own time, so env.run-loop :simulated_time
+    // can drive the runtime's clock from it.
+    bool simulated_time = false;
+};
+
+// Receives one observation as typed fields. env.run-loop :observe_into binds a sink to a BT
+// instance's blackboard, where each key is an interned slot, so no field becomes a Lisp value.
+class env_observation_sink {
+public:
+    virtual ~env_observation_sink() = default;
+
+    virtual void put_bool(std::string_view key, bool v) = 0;
+    virtual void put_integer(std::string_view key, std::int64_t v) = 0;
+    virtual void put_number(std::string_view key, double v) = 0;
+    virtual void put_vector(std::string_view key, std::span<const double> v) = 0;
+    virtual void put_string(std::string_view key, std::string_view v) = 0;
+    // Handles from bt::vla_service, such as adopted sensor messages.
+    virtual void put_image(std::string_view key, std::int64_t image_id) = 0;
+    virtual void put_blob(std::string_view key, std::int64_t blob_id) = 0;
+};
+
+// An observation captured without touching the Lisp heap, so it can be taken off the interpreter
+// thread and turned into a map later.
+class env_observation {
+public:
+    virtual ~env_observation() = default;
+
+    // Builds the observation map. Runs on the interpreter thread.
+    [[nodiscard]] virtual value to_value() const = 0;
 };
 
 class env_backend {
@@ -32,6 +73,34 @@ public:
     [[nodiscard]] virtual value observe() = 0;
     virtual void act(value action) = 0;
     [[nodiscard]] virtual bool step() = 0;
+    // Backends that report supports().pipelined_observe capture the next observation here. It is
+    // called from a pipeline thread, concurrently with act() and step() but never with another
+    // acquire_observation(), observe() or reset(), and must not create Lisp values.
+    [[nodiscard]] virtual std::unique_ptr<env_observation> acquire_observation() {
+        return nullptr;
+    }
+    // Backends that report supports().typed_observe write the observation here instead of building
+    // a map. Keys name the fields observe() returns, with nested maps flattened; `obs_schema`, `t_ms`
+    // and `done` also make up the map env.run-loop passes to on_tick.
+    virtual void observe_into(env_observation_sink& sink) {
+        (void)sink;
+    }
+    // Backends that report supports().batched_step run env_count() copies of one environment, for
+    // example several robots in one physics client. env.run-batch writes copy i's observation into
+    // sinks[i], hands copy i the action vector actions[i] (the `u` of its action map; empty holds
+    // its previous command), then advances every copy with one step_batch().
+    [[nodiscard]] virtual std::size_t env_count() const {
+        return 1;
+    }
+    virtual void observe_batch_into(std::span<env_observation_sink* const> sinks) {
+        (void)sinks;
+    }
+    virtual void act_batch(std::span<const std::span<const double>> actions) {
+        (void)actions;
+    }
+    [[nodiscard]] virtual bool step_batch() {
+        return step();
+    }
     virtual void debug_draw(value payload) {
         (void)payload;
     }
@@ -39,6 +108,11 @@ public:
 
 void env_api_reset();
 void env_api_register_backend(const std::string& name, std::shared_ptr<env_backend> backend);
+// Registers `name` without building it: `factory` runs on the first env.attach of `name`, outside the
+// registry lock, and the backend it returns is kept for later attaches. Lets an extension defer device
+// or middleware start-up until a script actually uses the backend.
+using env_backend_factory = std::function<std::shared_ptr<env_backend>()>;
+void env_api_register_backend_factory(const std::string& name, env_backend_factory factory);
 std::vector<std::string> env_api_registered_backends();
 [[nodiscard]] bool env_api_is_attached();
 [[nodiscard]] std::string env_api_attached_backend_name();
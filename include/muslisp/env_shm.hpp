@@ -0,0 +1,13 @@
+#pragma once
+
+#include <memory>
+
+#include "muslisp/env_api.hpp"
+
+namespace muslisp {
+
+// The "shm" env backend: exchanges observations and actions with an out-of-process simulator through
+// a bt::shm_exchange. create_global_env registers it under that name.
+[[nodiscard]] std::shared_ptr<env_backend> make_shm_env_backend();
+
+}  // namespace muslisp
@@ -36,4 +36,10 @@ public:
     explicit name_error(const std::string& message) : eval_error(message) {}
 };
 
+// Thrown by an allocation that would take the heap past gc_limits::hard_limit_bytes.
+class heap_limit_error : public lisp_error {
+public:
+    explicit heap_limit_error(const std::string& message) : lisp_error(message) {}
+};
+
 }  // namespace muslisp
@@ -1,10 +1,12 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
 #include "muslisp/env.hpp"
+#include "muslisp/gc.hpp"
 #include "muslisp/value.hpp"
 
 namespace bt {
@@ -44,9 +46,13 @@ class runtime_config {
 public:
     void register_extension(std::unique_ptr<extension> ext);
     [[nodiscard]] const std::vector<std::unique_ptr<extension>>& extensions() const noexcept;
+    // Applied to default_gc() by create_global_env; without it the heap keeps its current limits.
+    void set_heap_limits(const gc_limits& limits);
+    [[nodiscard]] const std::optional<gc_limits>& heap_limits() const noexcept;
 
 private:
     std::vector<std::unique_ptr<extension>> extensions_;
+    std::optional<gc_limits> heap_limits_;
 };
 
 }  // namespace muslisp
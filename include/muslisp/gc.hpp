@@ -1,8 +1,13 @@
 #pragma once
 
+#include <array>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <memory>
+#include <new>
+#include <optional>
 #include <string_view>
 #include <type_traits>
 #include <utility>
@@ -16,10 +21,25 @@ struct env;
 using value = object*;
 using env_ptr = env*;
 
+// Small integers and most doubles are encoded in the low bits of a `value` and never point at a heap node
+// (see value.hpp). Heap nodes are at least 16-byte aligned, so their low two bits are zero.
+[[nodiscard]] inline bool is_immediate(value v) noexcept {
+    return (reinterpret_cast<std::uintptr_t>(v) & 0x3u) != 0;
+}
+
 class gc;
 
 struct gc_node {
     bool marked = false;
+    // Survived a collection and lives in the old generation; `remembered` means it is queued in the
+    // remembered set because it was written to point at a young node.
+    bool old = false;
+    bool remembered = false;
+    // Pool size class the node's cell came from (set by gc::allocate).
+    std::uint8_t size_class = 0;
+    // Id of the heap that allocated the node. A heap only marks and remembers its own nodes; nodes of
+    // other heaps are kept alive by their owner.
+    std::uint16_t heap_id = 0;
     gc_node* next = nullptr;
 
     virtual ~gc_node() = default;
@@ -29,6 +49,8 @@ struct gc_node {
 
 struct gc_stats_snapshot {
     std::size_t total_allocated_objects = 0;
+    // Monotonic, unlike bytes_allocated, which is the live byte count and drops on collection.
+    std::size_t total_allocated_bytes = 0;
     std::size_t live_objects_after_last_gc = 0;
     std::size_t bytes_allocated = 0;
     std::size_t next_gc_threshold = 0;
@@ -36,6 +58,52 @@ struct gc_stats_snapshot {
     std::uint64_t total_pause_ns = 0;
     std::size_t freed_objects_total = 0;
     std::uint64_t forced_collection_count = 0;
+    std::uint64_t minor_collection_count = 0;
+    std::size_t young_objects = 0;
+    std::size_t promoted_objects_total = 0;
+    std::size_t remembered_set_size = 0;
+    std::size_t pool_reserved_bytes = 0;
+    std::size_t pool_free_cells = 0;
+    bool incremental_cycle_active = false;
+    std::uint64_t incremental_slice_count = 0;
+    // See gc_limits: whether the heap is past its soft limit, and how many allocations the hard limit
+    // refused.
+    bool memory_pressure = false;
+    std::uint64_t soft_limit_crossings = 0;
+    std::uint64_t hard_limit_failures = 0;
+};
+
+// Heap bounds and collection pacing (see gc::set_limits). Byte counts are the heap's own accounting
+// (gc_size_bytes of live nodes, refreshed by each collection), not process RSS.
+struct gc_limits {
+    // Once live bytes reach this, every requested collection is a full one, and while a full collection
+    // leaves the heap above it the next is due after another eighth of growth. 0 disables.
+    std::size_t soft_limit_bytes = 0;
+    // Once allocations take the heap past this, the next safe point runs a full collection. An
+    // allocation throws heap_limit_error when the live bytes the last full collection measured leave no
+    // room for it, or when garbage since then has grown the heap to twice this. 0 disables.
+    std::size_t hard_limit_bytes = 0;
+    // After a full collection the next is due when the old generation reaches this multiple of its
+    // survivors (Lua's "pause" as a ratio). At least 1.
+    double growth_factor = 2.0;
+    // Young objects allocated between minor collections, which sets how often they run. At least 1.
+    std::size_t nursery_objects = 1024;
+};
+
+enum class gc_limit_kind {
+    soft_limit_reached,
+    hard_limit_exceeded,
+};
+
+// Reported to the limit listener when the heap crosses its soft limit, and on the first allocation the
+// hard limit refuses, once per crossing of each.
+struct gc_limit_event {
+    gc_limit_kind kind = gc_limit_kind::soft_limit_reached;
+    std::size_t heap_live_bytes = 0;
+    std::size_t limit_bytes = 0;
+    // Size of the refused allocation; 0 for soft limit events.
+    std::size_t request_bytes = 0;
+    bool in_tick = false;
 };
 
 enum class gc_policy {
@@ -43,6 +111,7 @@ enum class gc_policy {
     between_ticks,
     manual,
     fail_on_tick_gc,
+    incremental,
 };
 
 enum class gc_collection_reason {
@@ -59,6 +128,11 @@ struct gc_lifecycle_event {
     gc_policy policy = gc_policy::default_policy;
     bool forced = false;
     bool in_tick = false;
+    bool minor = false;
+    // Set for full collections run in slices under the incremental policy; `slice_count` is only
+    // meaningful on the end event, whose pause time is the sum of the slices.
+    bool incremental = false;
+    std::uint64_t slice_count = 0;
     std::size_t heap_live_bytes_before = 0;
     std::size_t heap_live_bytes_after = 0;
     std::size_t live_objects_before = 0;
@@ -72,6 +146,7 @@ struct gc_lifecycle_event {
 class gc {
 public:
     using lifecycle_listener = std::function<void(const gc_lifecycle_event&)>;
+    using limit_listener = std::function<void(const gc_limit_event&)>;
 
     gc();
     ~gc();
@@ -82,7 +157,18 @@ public:
     template <typename T, typename... Args>
     T* allocate(Args&&... args) {
         static_assert(std::is_base_of_v<gc_node, T>, "GC can allocate only gc_node-derived types");
-        T* node = new T(std::forward<Args>(args)...);
+        static_assert(alignof(T) <= kCellGranule, "GC cells are aligned to kCellGranule");
+        constexpr std::uint8_t size_class = size_class_for(sizeof(T));
+        void* memory = allocate_cell(size_class, sizeof(T));
+        T* node = nullptr;
+        try {
+            node = new (memory) T(std::forward<Args>(args)...);
+        } catch (...) {
+            release_cell(memory, size_class);
+            throw;
+        }
+        node->size_class = size_class;
+        node->heap_id = heap_id_;
         link_node(node, node->gc_size_bytes());
         return node;
     }
@@ -93,41 +179,163 @@ public:
 
     void mark_value(value v);
     void mark_env(env_ptr env);
+    // For gc_node-derived payload structures (for example persistent map/vector trie nodes).
+    void mark_node(gc_node* node);
+
+    // Whether `v` is a heap value allocated by this heap.
+    [[nodiscard]] bool owns(value v) const noexcept {
+        return v && !is_immediate(v) && as_gc_node(v)->heap_id == heap_id_;
+    }
+
+    // Call after storing a reference into an existing node's payload (vec/map/pq slots, env bindings).
+    // Old nodes that gain a young referent are remembered so minor collections can skip the old heap, and
+    // while an incremental cycle is marking, a store into an already-marked node shades the stored node.
+    void write_barrier(gc_node* owner, value stored_value) {
+        if (!stored_value || is_immediate(stored_value)) {
+            return;
+        }
+        write_barrier(owner, as_gc_node(stored_value));
+    }
+
+    void write_barrier(gc_node* owner, gc_node* stored) {
+        if (!owner || !stored || owner->heap_id != heap_id_ || stored->heap_id != heap_id_) {
+            return;
+        }
+        if (owner->old && !owner->remembered && !stored->old) {
+            remember(owner);
+        }
+        if (incremental_phase_ == incremental_phase::marking && owner->marked && !stored->marked) {
+            mark_node(stored);
+        }
+    }
 
     void add_root_slot(value* slot);
     void remove_root_slot(value* slot);
+    // Long-lived contiguous root ranges (for example pre-materialised BT leaf arguments). Unlike
+    // root slots they are not truncated by gc_root_scope, and must be removed explicitly.
+    void add_root_range(const value* begin, std::size_t count);
+    // Like a root range, but the live extent is [begin, *top) at collection time (for example a VM operand
+    // stack). Removed with remove_root_range(begin).
+    void add_root_stack(const value* begin, value* const* top);
+    void remove_root_range(const value* begin);
     void register_root_env(env_ptr env);
     void unregister_root_env(env_ptr env);
 
     [[nodiscard]] gc_stats_snapshot stats() const noexcept;
+    // The monotonic allocation counters on their own, cheap enough to read around every BT node visit.
+    [[nodiscard]] std::size_t total_allocated_objects() const noexcept { return total_allocated_objects_; }
+    [[nodiscard]] std::size_t total_allocated_bytes() const noexcept { return total_allocated_bytes_; }
+    // Nanoseconds spent in collections and incremental slices so far; read by bt::tick_ledger.
+    [[nodiscard]] std::uint64_t total_pause_ns() const noexcept { return total_pause_ns_; }
     void set_policy(gc_policy policy) noexcept;
     [[nodiscard]] gc_policy policy() const noexcept;
     void enter_tick() noexcept;
-    void exit_tick();
+    // `slack` is the time left in the tick budget, if one is configured. Under the incremental policy the
+    // outermost exit runs at most min(slack, slice budget) of collection work.
+    void exit_tick(std::optional<std::chrono::nanoseconds> slack = std::nullopt);
+    // Advances the incremental collector (starting a cycle if one is due) for up to `budget`. Returns true
+    // while a cycle is still in progress.
+    bool step(std::chrono::nanoseconds budget);
+    void set_incremental_slice_budget(std::chrono::nanoseconds budget) noexcept;
+    [[nodiscard]] std::chrono::nanoseconds incremental_slice_budget() const noexcept;
+    [[nodiscard]] bool incremental_cycle_active() const noexcept;
     [[nodiscard]] bool in_tick() const noexcept;
     void set_lifecycle_listener(lifecycle_listener listener);
     void clear_lifecycle_listener();
+    // Throws std::invalid_argument for a growth factor or nursery below 1, or a soft limit above the hard
+    // one. Takes effect from the next allocation.
+    void set_limits(const gc_limits& limits);
+    [[nodiscard]] const gc_limits& limits() const noexcept { return limits_; }
+    void set_limit_listener(limit_listener listener);
+    void clear_limit_listener();
 
     [[nodiscard]] static std::string_view policy_name(gc_policy policy) noexcept;
     [[nodiscard]] static std::string_view collection_reason_name(gc_collection_reason reason) noexcept;
     [[nodiscard]] static bool parse_policy(std::string_view text, gc_policy& out) noexcept;
 
 private:
+    // Cells up to kPooledCellMax bytes come from per-size-class free lists carved out of kSlabBytes slabs;
+    // sweeps push freed cells back onto their list. Larger nodes use the global allocator.
+    static constexpr std::size_t kCellGranule = 16;
+    static constexpr std::size_t kPooledCellMax = 256;
+    static constexpr std::size_t kSizeClassCount = kPooledCellMax / kCellGranule;
+    static constexpr std::size_t kSlabBytes = 64 * 1024;
+    static constexpr std::uint8_t kUnpooledSizeClass = 0xff;
+
+    [[nodiscard]] static constexpr std::uint8_t size_class_for(std::size_t bytes) noexcept {
+        return bytes <= kPooledCellMax ? static_cast<std::uint8_t>((bytes + kCellGranule - 1) / kCellGranule - 1)
+                                       : kUnpooledSizeClass;
+    }
+
+    struct free_cell {
+        free_cell* next = nullptr;
+    };
+
     struct sweep_result {
         std::size_t live_count = 0;
         std::size_t live_bytes = 0;
         std::size_t freed_count = 0;
     };
 
+    enum class incremental_phase : std::uint8_t {
+        idle,
+        marking,
+        sweeping,
+    };
+
+    struct incremental_cycle {
+        std::uint64_t collection_id = 0;
+        gc_collection_reason reason = gc_collection_reason::threshold;
+        std::size_t live_objects_before = 0;
+        std::size_t heap_live_bytes_before = 0;
+        std::uint64_t mark_time_ns = 0;
+        std::uint64_t sweep_time_ns = 0;
+        std::uint64_t slice_count = 0;
+        gc_node** sweep_link = nullptr;
+        sweep_result swept{};
+    };
+
+    [[nodiscard]] void* allocate_cell(std::uint8_t size_class, std::size_t bytes);
+    void release_cell(void* memory, std::uint8_t size_class) noexcept;
+    void refill_size_class(std::uint8_t size_class);
+    void destroy_node(gc_node* node) noexcept;
     void link_node(gc_node* node, std::size_t bytes);
-    void mark_node(gc_node* node);
+    [[nodiscard]] std::size_t threshold_after(std::size_t live_count) const noexcept;
+    // After each full collection: refreshes memory pressure and the hard limit's view of the live set.
+    void update_memory_pressure() noexcept;
+    // Throws heap_limit_error (freeing `node`) when the hard limit refuses an allocation of `bytes`.
+    void check_hard_limit(gc_node* node, std::size_t bytes);
+    void emit_limit(gc_limit_kind kind, std::size_t limit_bytes, std::size_t request_bytes);
+    void remember(gc_node* node);
+    [[nodiscard]] static gc_node* as_gc_node(value v) noexcept;
+    void mark_roots();
     void collect_impl(gc_collection_reason reason, bool forced);
-    [[nodiscard]] sweep_result sweep();
+    [[nodiscard]] sweep_result sweep_minor();
+    [[nodiscard]] sweep_result sweep_full();
+    void finish_sweep(const sweep_result& result);
+    void start_incremental_cycle(gc_collection_reason reason);
+    void run_incremental_slice(std::chrono::steady_clock::time_point deadline);
+    [[nodiscard]] bool drain_gray(std::chrono::steady_clock::time_point deadline);
+    void finish_incremental_mark();
+    [[nodiscard]] bool sweep_incremental(std::chrono::steady_clock::time_point deadline);
+    void finish_incremental_cycle();
+    void complete_incremental_cycle();
     void emit_lifecycle(const gc_lifecycle_event& event);
 
+    // New nodes go on the young list; minor collections sweep only it and promote survivors onto the old
+    // list. Nodes never move, so promotion is a relink plus the `old` flag.
+    std::uint16_t heap_id_ = 0;
     gc_node* head_ = nullptr;
+    gc_node* young_head_ = nullptr;
+    std::size_t young_objects_ = 0;
+    std::size_t young_bytes_ = 0;
+    bool marking_minor_ = false;
+    std::vector<gc_node*> remembered_;
+    std::uint64_t minor_collection_count_ = 0;
+    std::size_t promoted_objects_total_ = 0;
     std::size_t allocated_objects_current_ = 0;
     std::size_t total_allocated_objects_ = 0;
+    std::size_t total_allocated_bytes_ = 0;
     std::size_t live_objects_after_last_gc_ = 0;
     std::size_t bytes_allocated_ = 0;
     std::size_t next_gc_threshold_ = 256;
@@ -140,15 +348,63 @@ private:
     std::size_t freed_objects_total_ = 0;
     std::uint64_t forced_collection_count_ = 0;
     lifecycle_listener lifecycle_listener_{};
+    gc_limits limits_{};
+    limit_listener limit_listener_{};
+    bool memory_pressure_ = false;
+    std::size_t pressure_trigger_bytes_ = 0;
+    std::uint64_t soft_limit_crossings_ = 0;
+    std::uint64_t hard_limit_failures_ = 0;
+    // Live bytes the last full collection measured, and whether the next requested collection must be
+    // a full one because the heap counter crossed the hard limit.
+    std::size_t live_bytes_after_full_ = 0;
+    bool full_collection_requested_ = false;
+    // Set once the current crossing of the hard limit has been reported; cleared when a full collection
+    // brings the heap back under it.
+    bool hard_limit_reported_ = false;
+
+    // Incremental full collections mark through an explicit gray stack so they can stop between nodes.
+    // Minor collections wait while a cycle is active.
+    incremental_phase incremental_phase_ = incremental_phase::idle;
+    std::vector<gc_node*> gray_;
+    incremental_cycle cycle_{};
+    std::chrono::nanoseconds incremental_slice_budget_ = std::chrono::milliseconds(1);
+    std::uint64_t incremental_slice_count_ = 0;
+
+    std::array<free_cell*, kSizeClassCount> free_lists_{};
+    std::vector<std::unique_ptr<std::byte[]>> slabs_;
+    std::size_t pool_free_cells_ = 0;
+
+    struct root_range {
+        const value* begin = nullptr;
+        std::size_t count = 0;
+        value* const* top = nullptr;
+    };
 
     std::vector<value*> root_slots_;
+    std::vector<root_range> root_ranges_;
     std::vector<env_ptr> root_envs_;
 
     friend class gc_root_scope;
 };
 
+// The heap bound to the calling thread by gc_thread_heap_scope, or the process heap.
 gc& default_gc();
 
+// Binds `heap` as default_gc() for the calling thread until the scope closes, so a worker thread can
+// allocate and collect on its own heap while the process heap belongs to another thread. Values from
+// the two heaps may be read across, but a value must not be stored into another heap's objects.
+class gc_thread_heap_scope {
+public:
+    explicit gc_thread_heap_scope(gc& heap) noexcept;
+    ~gc_thread_heap_scope();
+
+    gc_thread_heap_scope(const gc_thread_heap_scope&) = delete;
+    gc_thread_heap_scope& operator=(const gc_thread_heap_scope&) = delete;
+
+private:
+    gc* previous_ = nullptr;
+};
+
 class gc_root_scope {
 public:
     explicit gc_root_scope(gc& heap);
@@ -172,8 +428,12 @@ public:
     gc_tick_scope(const gc_tick_scope&) = delete;
     gc_tick_scope& operator=(const gc_tick_scope&) = delete;
 
+    // Time left in the tick budget, handed to gc::exit_tick when the scope closes.
+    void set_slack(std::chrono::nanoseconds slack) noexcept;
+
 private:
     gc& heap_;
+    std::optional<std::chrono::nanoseconds> slack_{};
 };
 
 }  // namespace muslisp
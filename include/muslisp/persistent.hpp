@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "muslisp/gc.hpp"
+#include "muslisp/value.hpp"
+
+namespace muslisp {
+
+// Hash array mapped trie node for `pmap`. Branch nodes use 5 hash bits per level: `bitmap` says which of
+// the 32 positions are occupied and `slots` holds them densely, each either a key/value pair or a child.
+// Once the hash bits run out, a collision node holds pairs whose hashes are equal. Nodes are GC-managed
+// so versions that share structure also share marking work. They are immutable once published; only the
+// transient whose edit id matches `edit` may update a node in place.
+struct hamt_node final : gc_node {
+    struct slot {
+        map_key key;
+        value mapped = nullptr;
+        hamt_node* child = nullptr;
+    };
+
+    std::uint32_t bitmap = 0;
+    bool collision = false;
+    std::uint64_t edit = 0;
+    std::vector<slot> slots;
+
+    void gc_mark_children(gc& heap) override;
+    [[nodiscard]] std::size_t gc_size_bytes() const override;
+};
+
+// 32-way trie node for `pvec`. Leaf nodes fill `items`, interior nodes fill `children`; the last partial
+// leaf lives in the owning pvec's tail.
+struct pvec_node final : gc_node {
+    std::uint64_t edit = 0;
+    std::vector<value> items;
+    std::vector<pvec_node*> children;
+
+    void gc_mark_children(gc& heap) override;
+    [[nodiscard]] std::size_t gc_size_bytes() const override;
+};
+
+// Persistent maps. Updates return a new pmap sharing untouched nodes with the old one. A transient is a
+// pmap that may be updated in place (the `!` functions) until pmap_persistent seals it.
+value make_pmap();
+[[nodiscard]] std::size_t pmap_count(value pmap);
+[[nodiscard]] const value* pmap_find(value pmap, const map_key& key);
+[[nodiscard]] value pmap_assoc(value pmap, const map_key& key, value mapped);
+[[nodiscard]] value pmap_dissoc(value pmap, const map_key& key);
+void pmap_for_each(value pmap, const std::function<void(const map_key&, value)>& fn);
+[[nodiscard]] value pmap_transient(value pmap);
+void pmap_assoc_in_place(value transient, const map_key& key, value mapped);
+bool pmap_dissoc_in_place(value transient, const map_key& key);
+[[nodiscard]] value pmap_persistent(value transient);
+
+// Persistent vectors with the same transient protocol.
+value make_pvec();
+[[nodiscard]] std::size_t pvec_count(value pvec);
+[[nodiscard]] value pvec_get(value pvec, std::size_t index);
+[[nodiscard]] value pvec_assoc(value pvec, std::size_t index, value item);
+[[nodiscard]] value pvec_conj(value pvec, value item);
+[[nodiscard]] value pvec_pop(value pvec);
+[[nodiscard]] value pvec_transient(value pvec);
+void pvec_assoc_in_place(value transient, std::size_t index, value item);
+void pvec_conj_in_place(value transient, value item);
+void pvec_pop_in_place(value transient);
+[[nodiscard]] value pvec_persistent(value transient);
+
+// True for transients that have not been sealed yet.
+[[nodiscard]] bool is_live_transient(value v);
+
+}  // namespace muslisp
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <iosfwd>
 #include <string>
 
 #include "muslisp/value.hpp"
@@ -9,4 +10,10 @@ namespace muslisp {
 std::string print_value(value v);
 std::string write_value(value v);
 
+// Streaming variants: output goes to `out` through a bounded buffer instead of one string. If
+// write_value throws part-way (a value with no readable form), part of the text may already be
+// written.
+void print_value(std::ostream& out, value v);
+void write_value(std::ostream& out, value v);
+
 }  // namespace muslisp
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <memory>
+#include <string_view>
+#include <typeindex>
+#include <unordered_map>
+
+#include "bt/runtime_host.hpp"
+#include "muslisp/env.hpp"
+#include "muslisp/extensions.hpp"
+#include "muslisp/gc.hpp"
+#include "muslisp/value.hpp"
+
+namespace muslisp {
+
+// One isolated runtime: a Lisp heap, a global environment built by create_global_env, the env API
+// state behind the env.* builtins, and a bt::runtime_host with its own scheduler, instances and event
+// log. Several contexts can live in one process, each driven by one thread at a time; nothing but
+// interned symbols, nil and the booleans is shared between them. BT definitions are plain data, so a
+// definition parsed once can be interned into every context's host.
+//
+// A context only takes effect on a thread through runtime_context_scope, which rebinds
+// default_gc(), bt::default_runtime_host() and the env API state. Code outside any scope keeps using
+// the process-wide instances.
+class runtime_context {
+public:
+    runtime_context();
+    explicit runtime_context(runtime_config config, bt::runtime_host_options host_options = {});
+    // Tears the host and global environment down with the context bound, so instances unroot their
+    // arguments from this context's heap.
+    ~runtime_context();
+
+    runtime_context(const runtime_context&) = delete;
+    runtime_context& operator=(const runtime_context&) = delete;
+
+    [[nodiscard]] gc& heap() noexcept { return heap_; }
+    [[nodiscard]] bt::runtime_host& host() noexcept { return *host_; }
+    [[nodiscard]] bt::event_log& events() noexcept { return host_->events(); }
+    [[nodiscard]] env_ptr global_env() const noexcept { return global_; }
+
+    // muslisp::eval_source on the global environment, with the context bound to the calling thread.
+    value eval_source(std::string_view source);
+
+    // Per-context instance of `T`, default-constructed on first use, for state that would otherwise be
+    // a function-local static. Call only from the thread the context is bound to.
+    template <typename T>
+    T& local() {
+        auto found = locals_.find(std::type_index(typeid(T)));
+        if (found == locals_.end()) {
+            found = locals_.emplace(std::type_index(typeid(T)), std::make_shared<T>()).first;
+        }
+        return *static_cast<T*>(found->second.get());
+    }
+
+private:
+    gc heap_;
+    std::unique_ptr<bt::runtime_host> host_;
+    std::unordered_map<std::type_index, std::shared_ptr<void>> locals_;
+    env_ptr global_ = nullptr;
+};
+
+// The context bound to the calling thread, or nullptr.
+[[nodiscard]] runtime_context* current_runtime_context() noexcept;
+
+// Binds `context` to the calling thread until the scope closes. Scopes nest; a thread must not
+// allocate values of one context while another is bound.
+class runtime_context_scope {
+public:
+    explicit runtime_context_scope(runtime_context& context) noexcept;
+    ~runtime_context_scope();
+
+    runtime_context_scope(const runtime_context_scope&) = delete;
+    runtime_context_scope& operator=(const runtime_context_scope&) = delete;
+
+private:
+    runtime_context* previous_ = nullptr;
+    gc_thread_heap_scope heap_scope_;
+};
+
+}  // namespace muslisp
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "muslisp/env.hpp"
+
+namespace muslisp {
+
+struct snapshot_stats {
+    std::size_t bindings = 0;
+    std::size_t objects = 0;
+    std::size_t envs = 0;
+    std::size_t bt_definitions = 0;
+};
+
+// Writes the bindings of `global` and everything reachable from them (closures with their captured
+// envs, lists, vecs, f64vecs, maps, pmaps, pvecs, priority queues, rngs and BT definitions) to a
+// snapshot file. Primitives are written by name; bindings of a primitive to its own name are left
+// out, since create_global_env recreates them. Throws lisp_error for values that only make sense in
+// the running process (bt instances, image and blob handles, live transients).
+snapshot_stats save_snapshot(env_ptr global, const std::string& path);
+
+// Maps a snapshot file and rebuilds it into `global`, which should come from create_global_env:
+// objects are allocated in one pass, references are fixed up in a second, and then every saved binding
+// is defined in `global`, replacing any existing binding of that name. Closures are recompiled and BT
+// definitions are stored in the default runtime host under new handles. Throws lisp_error for a
+// malformed file or a primitive that `global` does not bind.
+snapshot_stats load_snapshot(env_ptr global, const std::string& path);
+
+}  // namespace muslisp
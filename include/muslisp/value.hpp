@@ -1,8 +1,11 @@
 #pragma once
 
+#include <bit>
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <new>
+#include <span>
 #include <string>
 #include <string_view>
 #include <unordered_map>
@@ -13,7 +16,12 @@
 namespace muslisp {
 
 using primitive_fn = std::function<value(const std::vector<value>&)>;
+// Calling convention for hot builtins: arguments are a view of the caller's (rooted) operands, so
+// compiled call sites pass their operand stack without building a vector.
+using primitive_span_fn = value (*)(std::span<const value>);
 struct compiled_closure;
+struct hamt_node;
+struct pvec_node;
 
 enum class value_type {
     nil,
@@ -32,7 +40,10 @@ enum class value_type {
     bt_def,
     bt_instance,
     image_handle,
-    blob_handle
+    blob_handle,
+    pmap,
+    pvec,
+    f64vec
 };
 
 enum class map_key_type {
@@ -63,10 +74,141 @@ struct rng_state {
     double spare_normal = 0.0;
 };
 
-struct pq_entry {
+// Heap-ordered key of a pq entry. Keys are kept apart from the payloads so sifting moves only these
+// small records; `slot` indexes the payload and doubles as the entry's handle.
+struct pq_key {
     double priority = 0.0;
     std::uint64_t sequence = 0;
-    value payload = nullptr;
+    std::uint32_t slot = 0;
+};
+
+// Hands out `Align`-byte aligned blocks so loops over the elements can use aligned vector loads.
+template <typename T, std::size_t Align>
+struct aligned_allocator {
+    using value_type = T;
+    template <typename U>
+    struct rebind {
+        using other = aligned_allocator<U, Align>;
+    };
+
+    aligned_allocator() noexcept = default;
+    template <typename U>
+    aligned_allocator(const aligned_allocator<U, Align>&) noexcept {}
+
+    [[nodiscard]] T* allocate(std::size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{Align}));
+    }
+    void deallocate(T* p, std::size_t) noexcept { ::operator delete(p, std::align_val_t{Align}); }
+
+    template <typename U>
+    [[nodiscard]] bool operator==(const aligned_allocator<U, Align>&) const noexcept {
+        return true;
+    }
+};
+
+using f64_storage = std::vector<double, aligned_allocator<double, 64>>;
+
+// Heavy per-type state lives out of line so that scalar, symbol, and cons cells stay small. The payload
+// is created by the object constructor for the types that need one and never changes afterwards.
+struct object_payload {
+    virtual ~object_payload() = default;
+    [[nodiscard]] virtual std::size_t size_bytes() const noexcept = 0;
+};
+
+struct primitive_payload final : object_payload {
+    primitive_fn fn;
+    // Set for primitives made from a primitive_span_fn; `fn` then forwards to it.
+    primitive_span_fn span_fn = nullptr;
+    [[nodiscard]] std::size_t size_bytes() const noexcept override { return sizeof(*this); }
+};
+
+struct closure_payload final : object_payload {
+    std::vector<std::string> params;
+    std::vector<value> param_symbols;
+    std::vector<value> body;
+    env_ptr captured_env = nullptr;
+    std::shared_ptr<compiled_closure> compiled;
+    [[nodiscard]] std::size_t size_bytes() const noexcept override { return sizeof(*this); }
+};
+
+struct vec_payload final : object_payload {
+    std::vector<value> items;
+    [[nodiscard]] std::size_t size_bytes() const noexcept override { return sizeof(*this); }
+};
+
+struct map_payload final : object_payload {
+    map_storage entries;
+    [[nodiscard]] std::size_t size_bytes() const noexcept override { return sizeof(*this); }
+};
+
+// Indexed 4-ary min-heap ordered by (priority, sequence), so equal priorities pop in insertion order.
+// A slot stays with its entry while the key moves, which is what lets update and remove find an entry
+// by handle; slots are reused once their entry leaves the queue.
+struct pq_payload final : object_payload {
+    static constexpr std::uint32_t k_free_slot = 0xffffffffu;
+
+    std::vector<pq_key> heap;
+    std::vector<value> slot_payloads;
+    // Heap index of each slot's key, or k_free_slot.
+    std::vector<std::uint32_t> slot_positions;
+    std::vector<std::uint32_t> free_slots;
+    std::uint64_t next_sequence = 0;
+
+    [[nodiscard]] std::size_t size() const noexcept { return heap.size(); }
+    [[nodiscard]] bool holds(std::uint64_t slot) const noexcept {
+        return slot < slot_positions.size() && slot_positions[slot] != k_free_slot;
+    }
+    // Adds an entry with the next sequence number and returns its slot.
+    std::uint32_t insert(double priority, value payload);
+    // Appends an entry without restoring heap order; call heapify() after the last one.
+    std::uint32_t append_unordered(double priority, std::uint64_t sequence, value payload);
+    // Floyd's bottom-up build: restores heap order over all keys in O(n).
+    void heapify();
+    // Moves a held slot's entry to `priority`, keeping its sequence number.
+    void update(std::uint32_t slot, double priority);
+    // Removes a held slot's entry and frees the slot; read slot_payloads[slot] first.
+    pq_key remove(std::uint32_t slot);
+
+    [[nodiscard]] std::size_t size_bytes() const noexcept override { return sizeof(*this); }
+
+private:
+    std::uint32_t claim_slot(value payload);
+    void place(std::size_t index, const pq_key& key);
+    void sift_up(std::size_t index);
+    void sift_down(std::size_t index);
+};
+
+struct rng_payload final : object_payload {
+    std::shared_ptr<rng_state> state;
+    [[nodiscard]] std::size_t size_bytes() const noexcept override { return sizeof(*this); }
+};
+
+// `edit` is nonzero while the pmap/pvec is a live transient; `transient` stays set after sealing so stale
+// transients can be rejected.
+struct pmap_payload final : object_payload {
+    hamt_node* root = nullptr;
+    std::size_t count = 0;
+    std::uint64_t edit = 0;
+    bool transient = false;
+    [[nodiscard]] std::size_t size_bytes() const noexcept override { return sizeof(*this); }
+};
+
+struct pvec_payload final : object_payload {
+    pvec_node* root = nullptr;
+    std::vector<value> tail;
+    std::size_t count = 0;
+    unsigned shift = 5;
+    std::uint64_t edit = 0;
+    bool transient = false;
+    [[nodiscard]] std::size_t size_bytes() const noexcept override { return sizeof(*this); }
+};
+
+// Unboxed doubles with a length fixed when the f64vec is made.
+struct f64vec_payload final : object_payload {
+    f64_storage items;
+    [[nodiscard]] std::size_t size_bytes() const noexcept override {
+        return sizeof(*this) + items.capacity() * sizeof(double);
+    }
 };
 
 struct object final : gc_node {
@@ -74,38 +216,61 @@ struct object final : gc_node {
 
     value_type type = value_type::nil;
     bool boolean_data = false;
+    // Integers and the bt_def/bt_instance/image/blob handle types all keep their value here.
     std::int64_t integer_data = 0;
     double float_data = 0.0;
     std::string text_data;
     value car_data = nullptr;
     value cdr_data = nullptr;
-    primitive_fn primitive_data;
-    std::vector<std::string> closure_params_data;
-    std::vector<value> closure_body_data;
-    env_ptr closure_env_data = nullptr;
-    std::shared_ptr<compiled_closure> closure_compiled_data;
-    std::vector<value> vec_data;
-    map_storage map_data;
-    std::vector<pq_entry> pq_data;
-    std::uint64_t pq_next_sequence = 0;
-    std::shared_ptr<rng_state> rng_data;
-    std::int64_t bt_handle_data = 0;
-    std::int64_t image_handle_data = 0;
-    std::int64_t blob_handle_data = 0;
+    std::unique_ptr<object_payload> payload;
+
+    // Payload accessors; callers must have checked `type` first.
+    [[nodiscard]] primitive_fn& primitive_data() { return payload_as<primitive_payload>().fn; }
+    [[nodiscard]] primitive_span_fn& primitive_span_data() { return payload_as<primitive_payload>().span_fn; }
+    [[nodiscard]] std::vector<std::string>& closure_params_data() { return payload_as<closure_payload>().params; }
+    [[nodiscard]] std::vector<value>& closure_param_symbols_data() {
+        return payload_as<closure_payload>().param_symbols;
+    }
+    [[nodiscard]] std::vector<value>& closure_body_data() { return payload_as<closure_payload>().body; }
+    [[nodiscard]] env_ptr& closure_env_data() { return payload_as<closure_payload>().captured_env; }
+    [[nodiscard]] std::shared_ptr<compiled_closure>& closure_compiled_data() {
+        return payload_as<closure_payload>().compiled;
+    }
+    [[nodiscard]] std::vector<value>& vec_data() { return payload_as<vec_payload>().items; }
+    [[nodiscard]] map_storage& map_data() { return payload_as<map_payload>().entries; }
+    [[nodiscard]] pq_payload& pq_data() { return payload_as<pq_payload>(); }
+    [[nodiscard]] std::shared_ptr<rng_state>& rng_data() { return payload_as<rng_payload>().state; }
+    [[nodiscard]] pmap_payload& pmap_data() { return payload_as<pmap_payload>(); }
+    [[nodiscard]] pvec_payload& pvec_data() { return payload_as<pvec_payload>(); }
+    [[nodiscard]] f64_storage& f64vec_data() { return payload_as<f64vec_payload>().items; }
 
     void gc_mark_children(gc& heap) override;
     [[nodiscard]] std::size_t gc_size_bytes() const override;
+
+private:
+    template <typename T>
+    [[nodiscard]] T& payload_as() {
+        return static_cast<T&>(*payload);
+    }
 };
 
 value make_nil();
 value make_boolean(bool v);
 value make_integer(std::int64_t v);
 value make_float(double v);
-value make_symbol(const std::string& name);
-value make_string(const std::string& text);
+value make_symbol(std::string_view name);
+// Returns the interned symbol for `name`, or nullptr if it was never interned (unlike make_symbol).
+[[nodiscard]] value find_symbol(std::string_view name);
+value make_string(std::string_view text);
 value make_cons(value car_value, value cdr_value);
 value make_primitive(const std::string& name, primitive_fn fn);
+value make_primitive(const std::string& name, primitive_span_fn fn);
 value make_closure(const std::vector<std::string>& params, const std::vector<value>& body, env_ptr captured_env);
+// Uses `compiled` (which may be shared with other closures) instead of compiling the body again.
+value make_closure(const std::vector<std::string>& params,
+                   const std::vector<value>& body,
+                   env_ptr captured_env,
+                   std::shared_ptr<compiled_closure> compiled);
 value make_vec(std::size_t capacity = 0);
 value make_map();
 value make_pq(std::size_t capacity = 0);
@@ -114,15 +279,78 @@ value make_bt_def(std::int64_t handle);
 value make_bt_instance(std::int64_t handle);
 value make_image_handle(std::int64_t handle);
 value make_blob_handle(std::int64_t handle);
+value make_f64vec(std::size_t length, double fill = 0.0);
+value make_f64vec(std::span<const double> values);
+
+// Immediate encodings (tag in the low bits, see is_immediate):
+// - xx1: fixnum, a signed integer in [kFixnumMin, kFixnumMax] shifted left by one
+// - x10: flonum, a double whose exponent is within roughly 2^-255..2^256 (or +0.0), stored rotated left by
+//   three bits with the two exponent bits it can recover replaced by the tag
+// Other integers and doubles are boxed heap objects; callers should not care which form they got.
+static_assert(sizeof(std::uintptr_t) == sizeof(std::uint64_t), "immediate values assume 64-bit pointers");
+
+inline constexpr std::int64_t kFixnumMin = -(std::int64_t{1} << 62);
+inline constexpr std::int64_t kFixnumMax = (std::int64_t{1} << 62) - 1;
+
+[[nodiscard]] inline std::uint64_t value_bits(value v) noexcept {
+    return static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(v));
+}
+
+[[nodiscard]] inline value value_from_bits(std::uint64_t bits) noexcept {
+    return reinterpret_cast<value>(static_cast<std::uintptr_t>(bits));
+}
+
+[[nodiscard]] inline bool is_fixnum(value v) noexcept {
+    return (value_bits(v) & 0x1u) != 0;
+}
+
+[[nodiscard]] inline bool is_flonum(value v) noexcept {
+    return (value_bits(v) & 0x3u) == 0x2u;
+}
+
+[[nodiscard]] inline bool is_heap_value(value v) noexcept {
+    return v && !is_immediate(v);
+}
+
+inline constexpr std::uint64_t kFlonumZeroBits = 0x8000000000000002ull;
+
+[[nodiscard]] inline bool try_make_flonum(double d, value& out) noexcept {
+    const std::uint64_t bits = std::bit_cast<std::uint64_t>(d);
+    const std::uint64_t high = (bits >> 60) & 0x7u;
+    if (bits != 0x3000000000000000ull && (high == 3 || high == 4)) {
+        out = value_from_bits((std::rotl(bits, 3) & ~std::uint64_t{1}) | 0x2u);
+        return true;
+    }
+    if (bits == 0) {
+        out = value_from_bits(kFlonumZeroBits);
+        return true;
+    }
+    return false;
+}
+
+[[nodiscard]] inline double flonum_value(value v) noexcept {
+    const std::uint64_t bits = value_bits(v);
+    if (bits == kFlonumZeroBits) {
+        return 0.0;
+    }
+    const std::uint64_t restored = (2 - (bits >> 63)) | (bits & ~std::uint64_t{3});
+    return std::bit_cast<double>(std::rotr(restored, 3));
+}
 
 [[nodiscard]] value_type type_of(value v);
 [[nodiscard]] std::string_view type_name(value_type t);
 
 [[nodiscard]] bool is_nil(value v);
 [[nodiscard]] bool is_boolean(value v);
-[[nodiscard]] bool is_integer(value v);
-[[nodiscard]] bool is_float(value v);
-[[nodiscard]] bool is_number(value v);
+[[nodiscard]] inline bool is_integer(value v) {
+    return is_fixnum(v) || (is_heap_value(v) && v->type == value_type::integer);
+}
+[[nodiscard]] inline bool is_float(value v) {
+    return is_flonum(v) || (is_heap_value(v) && v->type == value_type::floating);
+}
+[[nodiscard]] inline bool is_number(value v) {
+    return is_integer(v) || is_float(v);
+}
 [[nodiscard]] bool is_symbol(value v);
 [[nodiscard]] bool is_string(value v);
 [[nodiscard]] bool is_cons(value v);
@@ -136,18 +364,31 @@ value make_blob_handle(std::int64_t handle);
 [[nodiscard]] bool is_bt_instance(value v);
 [[nodiscard]] bool is_image_handle(value v);
 [[nodiscard]] bool is_blob_handle(value v);
+[[nodiscard]] bool is_pmap(value v);
+[[nodiscard]] bool is_pvec(value v);
+[[nodiscard]] bool is_f64vec(value v);
 [[nodiscard]] bool is_truthy(value v);
 
 [[nodiscard]] bool boolean_value(value v);
-[[nodiscard]] std::int64_t integer_value(value v);
-[[nodiscard]] double float_value(value v);
+[[nodiscard]] std::int64_t boxed_integer_value(value v);
+[[nodiscard]] double boxed_float_value(value v);
+[[nodiscard]] inline std::int64_t integer_value(value v) {
+    return is_fixnum(v) ? static_cast<std::int64_t>(value_bits(v)) >> 1 : boxed_integer_value(v);
+}
+[[nodiscard]] inline double float_value(value v) {
+    return is_flonum(v) ? flonum_value(v) : boxed_float_value(v);
+}
 [[nodiscard]] const std::string& symbol_name(value v);
 [[nodiscard]] const std::string& string_value(value v);
 [[nodiscard]] value car(value v);
 [[nodiscard]] value cdr(value v);
 [[nodiscard]] const primitive_fn& primitive_function(value v);
+// nullptr unless `v` was made from a primitive_span_fn.
+[[nodiscard]] primitive_span_fn primitive_span_function(value v);
 [[nodiscard]] const std::string& primitive_name(value v);
 [[nodiscard]] const std::vector<std::string>& closure_params(value v);
+// Interned symbols for closure_params(v), in the same order.
+[[nodiscard]] const std::vector<value>& closure_param_symbols(value v);
 [[nodiscard]] const std::vector<value>& closure_body(value v);
 [[nodiscard]] env_ptr closure_env(value v);
 [[nodiscard]] std::int64_t bt_handle(value v);
@@ -155,10 +396,9 @@ value make_blob_handle(std::int64_t handle);
 [[nodiscard]] std::int64_t blob_handle_id(value v);
 
 [[nodiscard]] value list_from_vector(const std::vector<value>& items);
+[[nodiscard]] value list_from_vector(std::span<const value> items);
 [[nodiscard]] std::vector<value> vector_from_list(value list_value);
 [[nodiscard]] bool is_proper_list(value list_value);
 [[nodiscard]] bool eq_values(value lhs, value rhs);
 
-void mark_interned_symbols(gc& heap);
-
 }  // namespace muslisp
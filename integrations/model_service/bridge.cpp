@@ -6,11 +6,18 @@
 #include <chrono>
 #include <cstdint>
 #include <cstring>
+#include <optional>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <random>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -33,9 +40,10 @@ bool model_service_bridge_target_available() noexcept {
 
 #include <fcntl.h>
 #include <netdb.h>
-#include <sys/select.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
 #include <sys/socket.h>
-#include <sys/time.h>
 #include <unistd.h>
 
 namespace bt {
@@ -104,106 +112,31 @@ parsed_ws_endpoint parse_endpoint(const std::string& endpoint) {
     return out;
 }
 
-void set_socket_timeouts(int fd, std::int64_t timeout_ms) {
-    const auto clamped_ms = std::max<std::int64_t>(timeout_ms, 1);
-    timeval tv{};
-    tv.tv_sec = static_cast<long>(clamped_ms / 1000);
-    tv.tv_usec = static_cast<int>((clamped_ms % 1000) * 1000);
-    (void)::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
-    (void)::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
-}
-
-socket_handle connect_tcp(const parsed_ws_endpoint& endpoint, std::int64_t connect_timeout_ms) {
-    addrinfo hints{};
-    hints.ai_family = AF_UNSPEC;
-    hints.ai_socktype = SOCK_STREAM;
-
-    addrinfo* raw_results = nullptr;
-    const int gai = ::getaddrinfo(endpoint.host.c_str(), endpoint.port.c_str(), &hints, &raw_results);
-    if (gai != 0) {
-        throw std::runtime_error(std::string("model-service DNS resolution failed: ") + ::gai_strerror(gai));
-    }
-    std::unique_ptr<addrinfo, decltype(&::freeaddrinfo)> results(raw_results, ::freeaddrinfo);
-
-    for (addrinfo* ai = results.get(); ai != nullptr; ai = ai->ai_next) {
-        socket_handle sock(::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol));
-        if (!sock) {
-            continue;
-        }
-
-        const int flags = ::fcntl(sock.get(), F_GETFL, 0);
-        if (flags >= 0) {
-            (void)::fcntl(sock.get(), F_SETFL, flags | O_NONBLOCK);
-        }
-
-        const int rc = ::connect(sock.get(), ai->ai_addr, ai->ai_addrlen);
-        if (rc != 0 && errno != EINPROGRESS) {
-            continue;
-        }
-
-        fd_set write_set;
-        FD_ZERO(&write_set);
-        FD_SET(sock.get(), &write_set);
-        timeval tv{};
-        const auto clamped_ms = std::max<std::int64_t>(connect_timeout_ms, 1);
-        tv.tv_sec = static_cast<long>(clamped_ms / 1000);
-        tv.tv_usec = static_cast<int>((clamped_ms % 1000) * 1000);
-        const int ready = ::select(sock.get() + 1, nullptr, &write_set, nullptr, &tv);
-        if (ready <= 0) {
-            continue;
-        }
-        int error = 0;
-        socklen_t error_len = sizeof(error);
-        if (::getsockopt(sock.get(), SOL_SOCKET, SO_ERROR, &error, &error_len) != 0 || error != 0) {
-            continue;
-        }
-        if (flags >= 0) {
-            (void)::fcntl(sock.get(), F_SETFL, flags);
-        }
-        return sock;
-    }
+#if defined(MSG_NOSIGNAL)
+constexpr int k_send_flags = MSG_NOSIGNAL;
+#else
+constexpr int k_send_flags = 0;
+#endif
 
-    throw std::runtime_error("model-service TCP connection failed");
-}
+constexpr std::int64_t k_reconnect_backoff_initial_ms = 10;
+constexpr std::int64_t k_reconnect_backoff_max_ms = 1000;
+constexpr std::size_t k_max_frame_bytes = 16 * 1024 * 1024;
 
-void write_all(int fd, const std::string& data) {
-    std::size_t sent = 0;
-    while (sent < data.size()) {
-        const ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, 0);
-        if (n <= 0) {
-            throw std::runtime_error("model-service socket write failed");
-        }
-        sent += static_cast<std::size_t>(n);
+void set_non_blocking(int fd) {
+    const int flags = ::fcntl(fd, F_GETFL, 0);
+    if (flags >= 0) {
+        (void)::fcntl(fd, F_SETFL, flags | O_NONBLOCK);
     }
 }
 
-std::vector<std::uint8_t> read_exact(int fd, std::size_t count) {
-    std::vector<std::uint8_t> out(count);
-    std::size_t read = 0;
-    while (read < count) {
-        const ssize_t n = ::recv(fd, out.data() + read, count - read, 0);
-        if (n <= 0) {
-            throw std::runtime_error("model-service socket read failed");
-        }
-        read += static_cast<std::size_t>(n);
-    }
-    return out;
-}
-
-std::string read_http_headers(int fd) {
-    std::string out;
-    std::array<char, 1> ch{};
-    while (out.find("\r\n\r\n") == std::string::npos) {
-        const ssize_t n = ::recv(fd, ch.data(), ch.size(), 0);
-        if (n <= 0) {
-            throw std::runtime_error("model-service websocket handshake read failed");
-        }
-        out.push_back(ch[0]);
-        if (out.size() > 16384) {
-            throw std::runtime_error("model-service websocket handshake too large");
-        }
-    }
-    return out;
+// Small request frames are not delayed by Nagle, and the kernel probes idle peers.
+void set_stream_options(int fd) {
+    const int on = 1;
+    (void)::setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on));
+    (void)::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+#if defined(SO_NOSIGPIPE)
+    (void)::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
 }
 
 std::uint32_t random_u32() {
@@ -217,9 +150,10 @@ std::array<std::uint8_t, 4> make_mask() {
             static_cast<std::uint8_t>((value >> 8) & 0xff), static_cast<std::uint8_t>(value & 0xff)};
 }
 
-void send_text_frame(int fd, const std::string& text) {
+std::string encode_frame(std::uint8_t opcode, std::string_view text) {
     std::string frame;
-    frame.push_back(static_cast<char>(0x81));
+    frame.reserve(text.size() + 14);
+    frame.push_back(static_cast<char>(0x80 | opcode));
     const auto mask = make_mask();
     const std::size_t size = text.size();
     if (size <= 125) {
@@ -240,58 +174,93 @@ void send_text_frame(int fd, const std::string& text) {
     for (std::size_t i = 0; i < text.size(); ++i) {
         frame.push_back(static_cast<char>(static_cast<std::uint8_t>(text[i]) ^ mask[i % mask.size()]));
     }
-    write_all(fd, frame);
+    return frame;
 }
 
-std::uint64_t read_payload_length(int fd, std::uint8_t first_len) {
-    std::uint64_t length = first_len & 0x7f;
-    if (length == 126) {
-        const auto bytes = read_exact(fd, 2);
-        length = (static_cast<std::uint64_t>(bytes[0]) << 8) | bytes[1];
-    } else if (length == 127) {
-        const auto bytes = read_exact(fd, 8);
-        length = 0;
-        for (std::uint8_t byte : bytes) {
-            length = (length << 8) | byte;
-        }
+// Bytes received on one connection. Frames are consumed by advancing `read` rather than erasing,
+// and the consumed prefix is dropped only when more bytes are appended, so the buffer keeps its
+// capacity and a frame's payload stays in place until then.
+struct frame_buffer {
+    std::string bytes;
+    std::size_t read = 0;
+
+    [[nodiscard]] std::string_view pending() const noexcept {
+        return std::string_view(bytes).substr(read);
     }
-    return length;
-}
 
-std::string read_text_frame(int fd) {
-    while (true) {
-        const auto header = read_exact(fd, 2);
-        const std::uint8_t opcode = header[0] & 0x0f;
-        const bool masked = (header[1] & 0x80) != 0;
-        const std::uint64_t length = read_payload_length(fd, header[1]);
-        if (length > 16 * 1024 * 1024) {
-            throw std::runtime_error("model-service websocket frame too large");
-        }
-        std::array<std::uint8_t, 4> mask{};
-        if (masked) {
-            const auto mask_bytes = read_exact(fd, 4);
-            std::copy(mask_bytes.begin(), mask_bytes.end(), mask.begin());
+    void append(const char* data, std::size_t size) {
+        if (read > 0) {
+            bytes.erase(0, read);
+            read = 0;
         }
-        auto payload = read_exact(fd, static_cast<std::size_t>(length));
-        if (masked) {
-            for (std::size_t i = 0; i < payload.size(); ++i) {
-                payload[i] ^= mask[i % mask.size()];
-            }
+        bytes.append(data, size);
+    }
+
+    void consume(std::size_t size) noexcept { read += size; }
+
+    void clear() noexcept {
+        bytes.clear();
+        read = 0;
+    }
+};
+
+struct websocket_frame {
+    std::uint8_t opcode = 0;
+    // Unmasked payload inside the frame_buffer; valid until the next append.
+    std::string_view payload;
+};
+
+// Takes one complete frame from the front of `buffer`, unmasking it in place; nullopt while the
+// frame is still arriving. Throws when the frame is larger than k_max_frame_bytes.
+std::optional<websocket_frame> take_frame(frame_buffer& buffer) {
+    const std::size_t available = buffer.bytes.size() - buffer.read;
+    if (available < 2) {
+        return std::nullopt;
+    }
+    char* const base = buffer.bytes.data() + buffer.read;
+    const auto byte = [&](std::size_t i) { return static_cast<std::uint8_t>(base[i]); };
+    const bool masked = (byte(1) & 0x80) != 0;
+    std::uint64_t length = byte(1) & 0x7f;
+    std::size_t header = 2;
+    if (length == 126) {
+        if (available < 4) {
+            return std::nullopt;
         }
-        if (opcode == 0x1) {
-            return std::string(payload.begin(), payload.end());
+        length = (static_cast<std::uint64_t>(byte(2)) << 8) | byte(3);
+        header = 4;
+    } else if (length == 127) {
+        if (available < 10) {
+            return std::nullopt;
         }
-        if (opcode == 0x8) {
-            throw std::runtime_error("model-service websocket closed");
+        length = 0;
+        for (std::size_t i = 2; i < 10; ++i) {
+            length = (length << 8) | byte(i);
         }
-        if (opcode == 0x9) {
-            // Ignore pings for this one-request client; the next recv will read the response.
-            continue;
+        header = 10;
+    }
+    if (length > k_max_frame_bytes) {
+        throw std::runtime_error("model-service websocket frame too large");
+    }
+    const std::size_t mask_at = header;
+    if (masked) {
+        header += 4;
+    }
+    if (available < header + length) {
+        return std::nullopt;
+    }
+    const auto size = static_cast<std::size_t>(length);
+    char* const payload = base + header;
+    if (masked) {
+        for (std::size_t i = 0; i < size; ++i) {
+            payload[i] = static_cast<char>(payload[i] ^ base[mask_at + i % 4]);
         }
     }
+    buffer.consume(header + size);
+    return websocket_frame{.opcode = static_cast<std::uint8_t>(byte(0) & 0x0f),
+                           .payload = std::string_view(payload, size)};
 }
 
-void websocket_handshake(int fd, const parsed_ws_endpoint& endpoint) {
+std::string make_handshake_request(const parsed_ws_endpoint& endpoint) {
     constexpr std::string_view key = "bXVlc2xpLWJ0LWJyaWRnZQ==";
     std::ostringstream request;
     request << "GET " << endpoint.path << " HTTP/1.1\r\n"
@@ -300,48 +269,556 @@ void websocket_handshake(int fd, const parsed_ws_endpoint& endpoint) {
             << "Connection: Upgrade\r\n"
             << "Sec-WebSocket-Key: " << key << "\r\n"
             << "Sec-WebSocket-Version: 13\r\n\r\n";
-    write_all(fd, request.str());
-    const std::string response = read_http_headers(fd);
-    if (response.rfind("HTTP/1.1 101", 0) != 0 && response.rfind("HTTP/1.0 101", 0) != 0) {
-        throw std::runtime_error("model-service websocket handshake was not accepted");
-    }
+    return request.str();
 }
 
-model_service_response unavailable_from_exception(const model_service_request& request, const std::exception& error) {
+model_service_response unavailable_response(const std::string& request_id, std::string message) {
     model_service_response out;
-    out.id = request.id;
+    out.id = request_id;
     out.status = model_service_status::unavailable;
     out.error_code = "model_service_unavailable";
-    out.error_message = error.what();
+    out.error_message = std::move(message);
     out.error_retryable = true;
     out.host_reached = false;
     return out;
 }
 
+using clock_type = std::chrono::steady_clock;
+
+// A request from the moment call_async accepts it until its future is completed.
+struct pending_call {
+    std::string id;
+    clock_type::time_point deadline;
+    std::promise<model_service_response> promise;
+    bool done = false;
+};
+using pending_ptr = std::shared_ptr<pending_call>;
+
+struct outgoing_frame {
+    std::string bytes;
+    std::size_t sent = 0;
+    // Empty for handshake and pong frames.
+    pending_ptr call = nullptr;
+};
+
+// A request waiting for an open connection.
+struct waiting_call {
+    pending_ptr call;
+    std::string frame;
+    clock_type::time_point open_deadline;
+};
+
+enum class connection_state {
+    idle,
+    connecting,
+    handshaking,
+    open
+};
+
+struct pooled_connection {
+    socket_handle sock;
+    connection_state state = connection_state::idle;
+    frame_buffer in;
+    std::deque<outgoing_frame> out;
+    // Requests sent, or queued to send, on this connection, by request id.
+    std::unordered_map<std::string, std::deque<pending_ptr>> in_flight;
+    std::size_t in_flight_count = 0;
+    clock_type::time_point next_attempt{};
+    clock_type::time_point phase_deadline{};
+    std::int64_t backoff_ms = k_reconnect_backoff_initial_ms;
+};
+
+// MMSP client over a pool of websocket connections, all driven by one event-loop thread.
+//
+// Sockets are non-blocking. The loop connects and handshakes each connection, reconnects dropped
+// ones with exponential backoff, writes queued request frames, reads responses, answers pings and
+// completes each request's future when its response (matched by request id) arrives or its
+// deadline passes. call_async never blocks on the network, so callers only hold a thread while they
+// choose to wait on the future; any number of requests can be in flight on one connection.
 class websocket_model_service_client final : public model_service_client {
 public:
-    explicit websocket_model_service_client(model_service_config config) : config_(std::move(config)) {}
-
-    [[nodiscard]] model_service_response call(const model_service_request& request) override {
+    explicit websocket_model_service_client(model_service_config config) : config_(std::move(config)) {
         try {
-            const parsed_ws_endpoint endpoint = parse_endpoint(config_.endpoint);
-            socket_handle sock = connect_tcp(endpoint, config_.connect_timeout_ms);
-            set_socket_timeouts(sock.get(), config_.request_timeout_ms);
-            websocket_handshake(sock.get(), endpoint);
-            send_text_frame(sock.get(), model_service_request_to_json(request));
-            model_service_response response = model_service_response_from_json(read_text_frame(sock.get()));
-            if (response.id.empty()) {
-                response.id = request.id;
-            }
-            response.host_reached = false;
-            return response;
+            endpoint_ = parse_endpoint(config_.endpoint);
         } catch (const std::exception& error) {
-            return unavailable_from_exception(request, error);
+            endpoint_error_ = error.what();
+            return;
+        }
+        int fds[2] = {-1, -1};
+        if (::pipe(fds) != 0) {
+            endpoint_error_ = "model-service event loop could not create its wake pipe";
+            return;
+        }
+        wake_read_ = socket_handle(fds[0]);
+        wake_write_ = socket_handle(fds[1]);
+        set_non_blocking(wake_read_.get());
+        set_non_blocking(wake_write_.get());
+        connections_.resize(std::max<std::size_t>(config_.connection_pool_size, 1));
+        loop_ = std::thread([this] { run(); });
+    }
+
+    websocket_model_service_client(const websocket_model_service_client&) = delete;
+    websocket_model_service_client& operator=(const websocket_model_service_client&) = delete;
+
+    ~websocket_model_service_client() override {
+        if (!loop_.joinable()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
         }
+        wake();
+        loop_.join();
+    }
+
+    [[nodiscard]] model_service_response call(const model_service_request& request) override {
+        return call_async(request).get();
+    }
+
+    [[nodiscard]] std::future<model_service_response> call_async(const model_service_request& request) override {
+        const auto now = clock_type::now();
+        auto call = std::make_shared<pending_call>();
+        call->id = request.id;
+        call->deadline = now + std::chrono::milliseconds(std::max<std::int64_t>(config_.request_timeout_ms, 1));
+        std::future<model_service_response> future = call->promise.get_future();
+        if (!endpoint_error_.empty()) {
+            call->promise.set_value(unavailable_response(request.id, endpoint_error_));
+            return future;
+        }
+        std::string frame = encode_frame(0x1, model_service_request_to_json(request));
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            waiting_.push_back(waiting_call{
+                .call = std::move(call),
+                .frame = std::move(frame),
+                .open_deadline =
+                    now + std::chrono::milliseconds(std::max<std::int64_t>(config_.connect_timeout_ms, 1)),
+            });
+        }
+        wake();
+        return future;
     }
 
 private:
+    using completion = std::pair<pending_ptr, model_service_response>;
+
+    void wake() {
+        const char byte = 1;
+        (void)!::write(wake_write_.get(), &byte, 1);
+    }
+
+    // Marks `call` done and queues its response; the promise is fulfilled after the lock is released.
+    static void complete(const pending_ptr& call, model_service_response response, std::vector<completion>& done) {
+        if (call->done) {
+            return;
+        }
+        call->done = true;
+        done.emplace_back(call, std::move(response));
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        std::vector<pollfd> fds;
+        std::vector<completion> done;
+        while (!stopping_) {
+            const auto now = clock_type::now();
+            for (pooled_connection& conn : connections_) {
+                if (conn.state == connection_state::idle && now >= conn.next_attempt) {
+                    start_connect(conn, now, done);
+                } else if ((conn.state == connection_state::connecting ||
+                            conn.state == connection_state::handshaking) &&
+                           now >= conn.phase_deadline) {
+                    fail_connection(conn,
+                                    conn.state == connection_state::connecting
+                                        ? "model-service TCP connection failed"
+                                        : "model-service websocket handshake timed out",
+                                    now,
+                                    done);
+                }
+            }
+            expire_in_flight(now, done);
+            dispatch_waiting(now, done);
+            for (pooled_connection& conn : connections_) {
+                flush(conn, now, done);
+            }
+
+            fds.clear();
+            fds.push_back(pollfd{wake_read_.get(), POLLIN, 0});
+            for (const pooled_connection& conn : connections_) {
+                short events = 0;
+                if (conn.state != connection_state::idle) {
+                    events = POLLIN;
+                    if (conn.state == connection_state::connecting || !conn.out.empty()) {
+                        events |= POLLOUT;
+                    }
+                }
+                fds.push_back(pollfd{events != 0 ? conn.sock.get() : -1, events, 0});
+            }
+            const int timeout_ms = next_timeout_ms(now);
+
+            lock.unlock();
+            fulfil(done);
+            (void)::poll(fds.data(), static_cast<nfds_t>(fds.size()), timeout_ms);
+            lock.lock();
+
+            if ((fds[0].revents & POLLIN) != 0) {
+                char drain[64];
+                while (::read(wake_read_.get(), drain, sizeof(drain)) > 0) {
+                }
+            }
+            const auto after_poll = clock_type::now();
+            for (std::size_t i = 0; i < connections_.size(); ++i) {
+                if (fds[i + 1].fd >= 0 && fds[i + 1].revents != 0) {
+                    handle_events(connections_[i], fds[i + 1].revents, after_poll, done);
+                }
+            }
+        }
+
+        for (pooled_connection& conn : connections_) {
+            for (auto& [id, calls] : conn.in_flight) {
+                for (const pending_ptr& call : calls) {
+                    complete(call, unavailable_response(call->id, "model-service client closed"), done);
+                }
+            }
+            conn.in_flight.clear();
+            conn.sock.reset();
+        }
+        for (const waiting_call& waiting : waiting_) {
+            complete(waiting.call, unavailable_response(waiting.call->id, "model-service client closed"), done);
+        }
+        waiting_.clear();
+        lock.unlock();
+        fulfil(done);
+    }
+
+    static void fulfil(std::vector<completion>& done) {
+        for (auto& [call, response] : done) {
+            call->promise.set_value(std::move(response));
+        }
+        done.clear();
+    }
+
+    int next_timeout_ms(clock_type::time_point now) const {
+        auto next = now + std::chrono::milliseconds(100);
+        for (const pooled_connection& conn : connections_) {
+            if (conn.state == connection_state::idle) {
+                next = std::min(next, conn.next_attempt);
+            } else if (conn.state != connection_state::open) {
+                next = std::min(next, conn.phase_deadline);
+            }
+            for (const auto& [id, calls] : conn.in_flight) {
+                for (const pending_ptr& call : calls) {
+                    next = std::min(next, call->deadline);
+                }
+            }
+        }
+        for (const waiting_call& waiting : waiting_) {
+            next = std::min(next, waiting.open_deadline);
+        }
+        const auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(next - now).count();
+        return static_cast<int>(std::clamp<std::int64_t>(wait + 1, 0, 100));
+    }
+
+    void start_connect(pooled_connection& conn, clock_type::time_point now, std::vector<completion>& done) {
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* raw_results = nullptr;
+        const int gai = ::getaddrinfo(endpoint_.host.c_str(), endpoint_.port.c_str(), &hints, &raw_results);
+        if (gai != 0) {
+            fail_connection(conn, std::string("model-service DNS resolution failed: ") + ::gai_strerror(gai), now, done);
+            return;
+        }
+        std::unique_ptr<addrinfo, decltype(&::freeaddrinfo)> results(raw_results, ::freeaddrinfo);
+        for (addrinfo* ai = results.get(); ai != nullptr; ai = ai->ai_next) {
+            socket_handle sock(::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol));
+            if (!sock) {
+                continue;
+            }
+            set_non_blocking(sock.get());
+            const int rc = ::connect(sock.get(), ai->ai_addr, ai->ai_addrlen);
+            if (rc != 0 && errno != EINPROGRESS) {
+                continue;
+            }
+            conn.sock = std::move(sock);
+            conn.in.clear();
+            if (rc == 0) {
+                begin_handshake(conn, now);
+            } else {
+                conn.state = connection_state::connecting;
+                conn.phase_deadline =
+                    now + std::chrono::milliseconds(std::max<std::int64_t>(config_.connect_timeout_ms, 1));
+            }
+            return;
+        }
+        fail_connection(conn, "model-service TCP connection failed", now, done);
+    }
+
+    void begin_handshake(pooled_connection& conn, clock_type::time_point now) {
+        set_stream_options(conn.sock.get());
+        conn.state = connection_state::handshaking;
+        conn.phase_deadline = now + std::chrono::milliseconds(std::max<std::int64_t>(config_.request_timeout_ms, 1));
+        conn.out.push_front(outgoing_frame{.bytes = make_handshake_request(endpoint_)});
+    }
+
+    // Closes the connection and schedules the next attempt: at once after a drop, with backoff after
+    // a failed connect. Requests whose frames were not started go back to the waiting queue; the
+    // rest fail with `reason`.
+    void fail_connection(pooled_connection& conn,
+                         const std::string& reason,
+                         clock_type::time_point now,
+                         std::vector<completion>& done) {
+        const bool was_open = conn.state == connection_state::open;
+        conn.sock.reset();
+        conn.state = connection_state::idle;
+        conn.in.clear();
+        last_error_ = reason;
+        if (was_open) {
+            conn.backoff_ms = k_reconnect_backoff_initial_ms;
+            conn.next_attempt = now;
+        } else {
+            conn.next_attempt = now + std::chrono::milliseconds(conn.backoff_ms);
+            conn.backoff_ms = std::min(conn.backoff_ms * 2, k_reconnect_backoff_max_ms);
+        }
+
+        std::vector<waiting_call> unsent;
+        for (outgoing_frame& frame : conn.out) {
+            if (frame.call && frame.sent == 0 && !frame.call->done) {
+                unsent.push_back(waiting_call{.call = frame.call, .frame = std::move(frame.bytes), .open_deadline = now});
+            }
+        }
+        conn.out.clear();
+        for (auto& [id, calls] : conn.in_flight) {
+            for (const pending_ptr& call : calls) {
+                const bool requeued = std::any_of(unsent.begin(), unsent.end(), [&](const waiting_call& waiting) {
+                    return waiting.call == call;
+                });
+                if (!requeued) {
+                    complete(call, unavailable_response(call->id, reason), done);
+                }
+            }
+        }
+        conn.in_flight.clear();
+        conn.in_flight_count = 0;
+        // Requeued requests keep their order ahead of anything that arrived later. Their open deadline
+        // is now, so they fail at once if no other connection is open.
+        waiting_.insert(waiting_.begin(), std::make_move_iterator(unsent.begin()), std::make_move_iterator(unsent.end()));
+    }
+
+    void expire_in_flight(clock_type::time_point now, std::vector<completion>& done) {
+        for (pooled_connection& conn : connections_) {
+            for (auto it = conn.in_flight.begin(); it != conn.in_flight.end();) {
+                auto& calls = it->second;
+                for (auto call_it = calls.begin(); call_it != calls.end();) {
+                    if ((*call_it)->done || now >= (*call_it)->deadline) {
+                        complete(*call_it, unavailable_response((*call_it)->id, "model-service response timed out"), done);
+                        call_it = calls.erase(call_it);
+                        --conn.in_flight_count;
+                    } else {
+                        ++call_it;
+                    }
+                }
+                it = calls.empty() ? conn.in_flight.erase(it) : std::next(it);
+            }
+        }
+    }
+
+    void dispatch_waiting(clock_type::time_point now, std::vector<completion>& done) {
+        while (!waiting_.empty()) {
+            waiting_call& waiting = waiting_.front();
+            if (waiting.call->done) {
+                waiting_.pop_front();
+                continue;
+            }
+            if (now >= waiting.call->deadline) {
+                complete(waiting.call, unavailable_response(waiting.call->id, "model-service response timed out"), done);
+                waiting_.pop_front();
+                continue;
+            }
+            pooled_connection* chosen = nullptr;
+            for (pooled_connection& conn : connections_) {
+                if (conn.state == connection_state::open &&
+                    (chosen == nullptr || conn.in_flight_count < chosen->in_flight_count)) {
+                    chosen = &conn;
+                }
+            }
+            if (chosen == nullptr) {
+                // Without an open connection, fail requests whose connect window has passed and keep
+                // the rest queued in order.
+                for (auto it = waiting_.begin(); it != waiting_.end();) {
+                    if (now >= it->open_deadline) {
+                        complete(it->call,
+                                 unavailable_response(it->call->id,
+                                                      last_error_.empty() ? "model-service connection is not open"
+                                                                          : last_error_),
+                                 done);
+                        it = waiting_.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+                return;
+            }
+            chosen->in_flight[waiting.call->id].push_back(waiting.call);
+            ++chosen->in_flight_count;
+            chosen->out.push_back(outgoing_frame{.bytes = std::move(waiting.frame), .call = waiting.call});
+            waiting_.pop_front();
+        }
+    }
+
+    void flush(pooled_connection& conn, clock_type::time_point now, std::vector<completion>& done) {
+        if (conn.state != connection_state::open && conn.state != connection_state::handshaking) {
+            return;
+        }
+        while (!conn.out.empty()) {
+            outgoing_frame& frame = conn.out.front();
+            const ssize_t n =
+                ::send(conn.sock.get(), frame.bytes.data() + frame.sent, frame.bytes.size() - frame.sent, k_send_flags);
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+                return;
+            }
+            if (n <= 0) {
+                fail_connection(conn, "model-service socket write failed", now, done);
+                return;
+            }
+            frame.sent += static_cast<std::size_t>(n);
+            if (frame.sent == frame.bytes.size()) {
+                conn.out.pop_front();
+            }
+            if (conn.state == connection_state::handshaking) {
+                // Requests wait for the upgrade response before they are written.
+                return;
+            }
+        }
+    }
+
+    void handle_events(pooled_connection& conn, short revents, clock_type::time_point now, std::vector<completion>& done) {
+        if (conn.state == connection_state::connecting) {
+            int error = 0;
+            socklen_t error_len = sizeof(error);
+            if (::getsockopt(conn.sock.get(), SOL_SOCKET, SO_ERROR, &error, &error_len) != 0 || error != 0) {
+                fail_connection(conn, "model-service TCP connection failed", now, done);
+                return;
+            }
+            if ((revents & POLLOUT) != 0) {
+                begin_handshake(conn, now);
+                flush(conn, now, done);
+            }
+            return;
+        }
+        if ((revents & POLLIN) != 0 || (revents & (POLLHUP | POLLERR)) != 0) {
+            char buffer[16384];
+            while (true) {
+                const ssize_t n = ::recv(conn.sock.get(), buffer, sizeof(buffer), 0);
+                if (n > 0) {
+                    conn.in.append(buffer, static_cast<std::size_t>(n));
+                    continue;
+                }
+                if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+                    break;
+                }
+                read_input(conn, now, done);
+                if (conn.state != connection_state::idle) {
+                    fail_connection(conn,
+                                    n == 0 ? "model-service websocket closed" : "model-service socket read failed",
+                                    now,
+                                    done);
+                }
+                return;
+            }
+            read_input(conn, now, done);
+            if (conn.state == connection_state::idle) {
+                return;
+            }
+        }
+        if ((revents & POLLOUT) != 0) {
+            flush(conn, now, done);
+        }
+    }
+
+    void read_input(pooled_connection& conn, clock_type::time_point now, std::vector<completion>& done) {
+        if (conn.state == connection_state::handshaking) {
+            const std::string_view head = conn.in.pending();
+            const std::size_t end = head.find("\r\n\r\n");
+            if (end == std::string_view::npos) {
+                if (head.size() > 16384) {
+                    fail_connection(conn, "model-service websocket handshake too large", now, done);
+                }
+                return;
+            }
+            if (!head.starts_with("HTTP/1.1 101") && !head.starts_with("HTTP/1.0 101")) {
+                fail_connection(conn, "model-service websocket handshake was not accepted", now, done);
+                return;
+            }
+            conn.in.consume(end + 4);
+            conn.state = connection_state::open;
+            conn.backoff_ms = k_reconnect_backoff_initial_ms;
+            last_error_.clear();
+        }
+        if (conn.state != connection_state::open) {
+            return;
+        }
+        while (true) {
+            std::optional<websocket_frame> frame;
+            try {
+                frame = take_frame(conn.in);
+            } catch (const std::exception& error) {
+                fail_connection(conn, error.what(), now, done);
+                return;
+            }
+            if (!frame.has_value()) {
+                return;
+            }
+            if (frame->opcode == 0x8) {
+                fail_connection(conn, "model-service websocket closed", now, done);
+                return;
+            }
+            if (frame->opcode == 0x9) {
+                conn.out.push_back(outgoing_frame{.bytes = encode_frame(0xA, frame->payload)});
+                continue;
+            }
+            if (frame->opcode == 0x1) {
+                deliver(conn, model_service_response_from_json(frame->payload), done);
+            }
+        }
+    }
+
+    static void deliver(pooled_connection& conn, model_service_response response, std::vector<completion>& done) {
+        auto it = conn.in_flight.find(response.id);
+        // A service that omits ids can only be matched when exactly one request is waiting.
+        if (it == conn.in_flight.end() && response.id.empty() && conn.in_flight_count == 1) {
+            it = conn.in_flight.begin();
+        }
+        if (it == conn.in_flight.end()) {
+            return;
+        }
+        const pending_ptr call = it->second.front();
+        it->second.pop_front();
+        --conn.in_flight_count;
+        if (it->second.empty()) {
+            conn.in_flight.erase(it);
+        }
+        if (response.id.empty()) {
+            response.id = call->id;
+        }
+        response.host_reached = false;
+        complete(call, std::move(response), done);
+    }
+
     model_service_config config_;
+    parsed_ws_endpoint endpoint_;
+    std::string endpoint_error_;
+    socket_handle wake_read_;
+    socket_handle wake_write_;
+
+    // Guards everything below; the loop releases it only while polling and fulfilling futures.
+    std::mutex mutex_;
+    std::vector<pooled_connection> connections_;
+    std::deque<waiting_call> waiting_;
+    std::string last_error_;
+    bool stopping_ = false;
+    std::thread loop_;
 };
 
 }  // namespace
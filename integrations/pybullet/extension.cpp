@@ -5,6 +5,7 @@
 #include <cmath>
 #include <memory>
 #include <optional>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -30,7 +31,7 @@ std::string normalize_option_key(std::string key) {
 }
 
 std::optional<value> map_lookup_option(value map_obj, const std::string& normalized_key) {
-    for (const auto& [key, val] : map_obj->map_data) {
+    for (const auto& [key, val] : map_obj->map_data()) {
         if (key.type != map_key_type::symbol && key.type != map_key_type::string) {
             continue;
         }
@@ -60,7 +61,8 @@ map_key symbol_key(const std::string& name) {
 }
 
 void map_set_symbol(value map_obj, const std::string& key_name, value v) {
-    map_obj->map_data[symbol_key(key_name)] = v;
+    map_obj->map_data()[symbol_key(key_name)] = v;
+    muslisp::default_gc().write_barrier(map_obj, v);
 }
 
 double require_number_value(value v, const std::string& where) {
@@ -125,6 +127,9 @@ public:
         out.headless = true;
         out.realtime_pacing = true;
         out.deterministic_seed = false;
+        out.typed_observe = true;
+        out.batched_step = true;
+        out.simulated_time = true;
         return out;
     }
 
@@ -196,15 +201,10 @@ public:
         value goal = numeric_vector_to_lisp_list(state.goal);
         roots.add(&goal);
 
-        const double dx = state.goal.size() > 0 ? (state.goal[0] - state.x) : 0.0;
-        const double dy = state.goal.size() > 1 ? (state.goal[1] - state.y) : 0.0;
-        const double dist_goal = std::hypot(dx, dy);
-        const bool done = state.collision_imminent || (std::isfinite(dist_goal) && dist_goal <= 0.6);
-
         map_set_symbol(obs, "obs_schema", make_string("racecar.obs.v1"));
         map_set_symbol(obs, "t_ms", make_integer(state.t_ms));
         map_set_symbol(obs, "state_vec", state_vec);
-        map_set_symbol(obs, "done", make_boolean(done));
+        map_set_symbol(obs, "done", make_boolean(episode_done(state)));
 
         map_set_symbol(info, "state_schema", make_string(state.state_schema));
         map_set_symbol(info, "x", make_float(state.x));
@@ -220,6 +220,39 @@ public:
         return obs;
     }
 
+    // The fields of observe(), with `info` flattened, written without building Lisp values.
+    void observe_into(env_observation_sink& sink) override {
+        write_typed_state(sink, bt::racecar_get_state());
+    }
+
+    // One car per copy; an adapter that simulates several cars sets the count.
+    [[nodiscard]] std::size_t env_count() const override {
+        return bt::racecar_sim_adapter_ptr() ? bt::racecar_env_count() : 1;
+    }
+
+    void observe_batch_into(std::span<env_observation_sink* const> sinks) override {
+        states_.resize(bt::racecar_env_count());
+        bt::racecar_get_states(states_);
+        for (std::size_t i = 0; i < std::min(states_.size(), sinks.size()); ++i) {
+            write_typed_state(*sinks[i], states_[i]);
+        }
+    }
+
+    // Actions are [steering throttle], as `u` in racecar action maps.
+    void act_batch(std::span<const std::span<const double>> actions) override {
+        last_actions_.resize(actions.size());
+        for (std::size_t i = 0; i < actions.size(); ++i) {
+            if (actions[i].size() >= 2) {
+                last_actions_[i] = {actions[i][0], actions[i][1]};
+            }
+        }
+        bt::racecar_apply_actions(last_actions_);
+    }
+
+    [[nodiscard]] bool step_batch() override {
+        return step();
+    }
+
     void act(value action) override {
         const auto parsed = parse_canonical_action_map(action, "env.act");
         bt::racecar_apply_action(parsed[0], parsed[1]);
@@ -243,7 +276,34 @@ public:
     }
 
 private:
+    static void write_typed_state(env_observation_sink& sink, const bt::racecar_state& state) {
+        sink.put_string("obs_schema", "racecar.obs.v1");
+        sink.put_integer("t_ms", state.t_ms);
+        sink.put_vector("state_vec", state.state_vec);
+        sink.put_bool("done", episode_done(state));
+        sink.put_string("state_schema", state.state_schema);
+        sink.put_number("x", state.x);
+        sink.put_number("y", state.y);
+        sink.put_number("yaw", state.yaw);
+        sink.put_number("speed", state.speed);
+        sink.put_vector("rays", state.rays);
+        sink.put_vector("goal", state.goal);
+        sink.put_bool("collision_imminent", state.collision_imminent);
+        sink.put_integer("collision_count", state.collision_count);
+    }
+
+    static bool episode_done(const bt::racecar_state& state) {
+        const double dx = state.goal.size() > 0 ? (state.goal[0] - state.x) : 0.0;
+        const double dy = state.goal.size() > 1 ? (state.goal[1] - state.y) : 0.0;
+        const double dist_goal = std::hypot(dx, dy);
+        return state.collision_imminent || (std::isfinite(dist_goal) && dist_goal <= 0.6);
+    }
+
     std::int64_t steps_per_tick_ = 1;
+    // The last command of each copy, held while its BT has no action.
+    std::vector<std::array<double, 2>> last_actions_;
+    // Each copy's last state; kept so their vectors reuse their buffers every tick.
+    std::vector<bt::racecar_state> states_;
 };
 
 class pybullet_extension final : public extension {
@@ -254,7 +314,7 @@ public:
 
     void register_lisp(registrar& reg) const override {
         (void)reg;
-        env_api_register_backend("pybullet", std::make_shared<pybullet_env_backend>());
+        env_api_register_backend_factory("pybullet", [] { return std::make_shared<pybullet_env_backend>(); });
     }
 
     void register_bt(bt::runtime_host& host) const override {
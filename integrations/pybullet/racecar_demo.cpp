@@ -4,6 +4,9 @@
 #include <array>
 #include <chrono>
 #include <cmath>
+#include <condition_variable>
+#include <exception>
+#include <functional>
 #include <limits>
 #include <mutex>
 #include <stdexcept>
@@ -56,8 +59,8 @@ double finite_or_throw(double value, const std::string& where) {
     return value;
 }
 
-const std::vector<double>* as_vector(const bb_value& value) {
-    return std::get_if<std::vector<double>>(&value);
+const bb_vector* as_vector(const bb_value& value) {
+    return std::get_if<bb_vector>(&value);
 }
 
 std::string require_key_like(const muslisp::value& arg, const std::string& where) {
@@ -459,6 +462,125 @@ void write_state_to_blackboard(instance& inst,
 
 }  // namespace
 
+void racecar_tick_columns::reserve(std::size_t ticks) {
+    tick_index.reserve(ticks);
+    sim_time_s.reserve(ticks);
+    wall_time_s.reserve(ticks);
+    x.reserve(ticks);
+    y.reserve(ticks);
+    yaw.reserve(ticks);
+    speed.reserve(ticks);
+    goal_x.reserve(ticks);
+    goal_y.reserve(ticks);
+    collision_imminent.reserve(ticks);
+    distance_to_goal.reserve(ticks);
+    steering.reserve(ticks);
+    throttle.reserve(ticks);
+    has_shared_action.reserve(ticks);
+    shared_linear_x.reserve(ticks);
+    shared_angular_z.reserve(ticks);
+    collisions_total.reserve(ticks);
+    goal_reached.reserve(ticks);
+    bt_status.reserve(ticks);
+    active_branch.reserve(ticks);
+    planner_meta_json.reserve(ticks);
+    used_fallback.reserve(ticks);
+    is_error_record.reserve(ticks);
+    error_reason.reserve(ticks);
+}
+
+void racecar_tick_columns::clear() noexcept {
+    tick_index.clear();
+    sim_time_s.clear();
+    wall_time_s.clear();
+    x.clear();
+    y.clear();
+    yaw.clear();
+    speed.clear();
+    goal_x.clear();
+    goal_y.clear();
+    collision_imminent.clear();
+    distance_to_goal.clear();
+    steering.clear();
+    throttle.clear();
+    has_shared_action.clear();
+    shared_linear_x.clear();
+    shared_angular_z.clear();
+    collisions_total.clear();
+    goal_reached.clear();
+    bt_status.clear();
+    active_branch.clear();
+    planner_meta_json.clear();
+    used_fallback.clear();
+    is_error_record.clear();
+    error_reason.clear();
+}
+
+void racecar_tick_columns::append(const racecar_tick_record& record) {
+    tick_index.push_back(record.tick_index);
+    sim_time_s.push_back(record.sim_time_s);
+    wall_time_s.push_back(record.wall_time_s);
+    x.push_back(record.state.x);
+    y.push_back(record.state.y);
+    yaw.push_back(record.state.yaw);
+    speed.push_back(record.state.speed);
+    goal_x.push_back(record.state.goal.size() > 0 ? record.state.goal[0] : 0.0);
+    goal_y.push_back(record.state.goal.size() > 1 ? record.state.goal[1] : 0.0);
+    collision_imminent.push_back(record.state.collision_imminent ? 1 : 0);
+    distance_to_goal.push_back(record.distance_to_goal);
+    steering.push_back(record.steering);
+    throttle.push_back(record.throttle);
+    has_shared_action.push_back(record.has_shared_action ? 1 : 0);
+    shared_linear_x.push_back(record.shared_linear_x);
+    shared_angular_z.push_back(record.shared_angular_z);
+    collisions_total.push_back(record.collisions_total);
+    goal_reached.push_back(record.goal_reached ? 1 : 0);
+    bt_status.push_back(record.bt_status);
+    active_branch.push_back(record.active_branch);
+    planner_meta_json.push_back(record.planner_meta_json);
+    used_fallback.push_back(record.used_fallback ? 1 : 0);
+    is_error_record.push_back(record.is_error_record ? 1 : 0);
+    error_reason.push_back(record.error_reason);
+}
+
+racecar_tick_record racecar_tick_columns::record(std::size_t i) const {
+    racecar_tick_record out;
+    out.schema_version = schema_version;
+    out.run_id = run_id;
+    out.mode = mode;
+    out.tick_index = tick_index[i];
+    out.sim_time_s = sim_time_s[i];
+    out.wall_time_s = wall_time_s[i];
+    out.state.x = x[i];
+    out.state.y = y[i];
+    out.state.yaw = yaw[i];
+    out.state.speed = speed[i];
+    out.state.goal = {goal_x[i], goal_y[i]};
+    out.state.collision_imminent = collision_imminent[i] != 0;
+    out.state.t_ms = static_cast<std::int64_t>(std::llround(sim_time_s[i] * 1000.0));
+    out.distance_to_goal = distance_to_goal[i];
+    out.steering = steering[i];
+    out.throttle = throttle[i];
+    out.has_shared_action = has_shared_action[i] != 0;
+    out.shared_linear_x = shared_linear_x[i];
+    out.shared_angular_z = shared_angular_z[i];
+    out.collisions_total = collisions_total[i];
+    out.goal_reached = goal_reached[i] != 0;
+    out.bt_status = bt_status[i];
+    out.active_branch = active_branch[i];
+    out.planner_meta_json = planner_meta_json[i];
+    out.used_fallback = used_fallback[i] != 0;
+    out.is_error_record = is_error_record[i] != 0;
+    out.error_reason = error_reason[i];
+    return out;
+}
+
+void racecar_sim_adapter::on_tick_records(const racecar_tick_columns& batch) {
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+        on_tick_record(batch.record(i));
+    }
+}
+
 void set_racecar_sim_adapter(std::shared_ptr<racecar_sim_adapter> adapter) {
     racecar_demo_state& state = global_demo_state();
     std::lock_guard<std::mutex> lock(state.mutex);
@@ -495,6 +617,41 @@ void racecar_apply_action(double steering, double throttle) {
     adapter->apply_action(clamp_double(steering, -1.0, 1.0), clamp_double(throttle, -1.0, 1.0));
 }
 
+std::size_t racecar_env_count() {
+    const std::shared_ptr<racecar_sim_adapter> adapter = racecar_sim_adapter_ptr();
+    if (!adapter) {
+        throw std::runtime_error("pybullet.observe: racecar sim adapter is not installed");
+    }
+    return adapter->env_count();
+}
+
+void racecar_get_states(std::span<racecar_state> out) {
+    const std::shared_ptr<racecar_sim_adapter> adapter = racecar_sim_adapter_ptr();
+    if (!adapter) {
+        throw std::runtime_error("pybullet.observe: racecar sim adapter is not installed");
+    }
+    if (out.size() != adapter->env_count()) {
+        throw std::runtime_error("pybullet.observe: expected room for " + std::to_string(adapter->env_count()) +
+                                 " states, got " + std::to_string(out.size()));
+    }
+    adapter->get_states(out);
+    for (const racecar_state& state : out) {
+        validate_state_schema(state);
+    }
+}
+
+void racecar_apply_actions(std::span<const std::array<double, 2>> actions) {
+    const std::shared_ptr<racecar_sim_adapter> adapter = racecar_sim_adapter_ptr();
+    if (!adapter) {
+        throw std::runtime_error("pybullet.act: racecar sim adapter is not installed");
+    }
+    std::vector<std::array<double, 2>> clamped(actions.begin(), actions.end());
+    for (auto& action : clamped) {
+        action = {clamp_double(action[0], -1.0, 1.0), clamp_double(action[1], -1.0, 1.0)};
+    }
+    adapter->apply_actions(clamped);
+}
+
 void racecar_step(std::int64_t steps) {
     const std::shared_ptr<racecar_sim_adapter> adapter = racecar_sim_adapter_ptr();
     if (!adapter) {
@@ -522,6 +679,173 @@ void racecar_debug_draw() {
     adapter->debug_draw();
 }
 
+namespace {
+
+class racecar_parallel_adapter final : public racecar_sim_adapter {
+public:
+    explicit racecar_parallel_adapter(std::vector<std::shared_ptr<racecar_sim_adapter>> copies)
+        : copies_(std::move(copies)) {
+        workers_.reserve(copies_.size() - 1);
+        for (std::size_t i = 1; i < copies_.size(); ++i) {
+            workers_.emplace_back([this, i] { worker_loop(i); });
+        }
+    }
+
+    ~racecar_parallel_adapter() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        start_cv_.notify_all();
+        for (std::thread& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    [[nodiscard]] racecar_state get_state() override { return copies_.front()->get_state(); }
+    void apply_action(double steering, double throttle) override { copies_.front()->apply_action(steering, throttle); }
+    void step(std::int64_t steps) override {
+        run_parallel([this, steps](std::size_t i) { copies_[i]->step(steps); });
+    }
+    void reset() override {
+        run_parallel([this](std::size_t i) { copies_[i]->reset(); });
+    }
+    void debug_draw() override { copies_.front()->debug_draw(); }
+    [[nodiscard]] bool stop_requested() const override {
+        return std::any_of(copies_.begin(), copies_.end(), [](const auto& copy) { return copy->stop_requested(); });
+    }
+    void on_tick_record(const racecar_tick_record& record) override { copies_.front()->on_tick_record(record); }
+    void on_tick_records(const racecar_tick_columns& batch) override { copies_.front()->on_tick_records(batch); }
+
+    [[nodiscard]] std::size_t env_count() const override { return copies_.size(); }
+    void get_states(std::span<racecar_state> out) override {
+        const std::size_t n = std::min(out.size(), copies_.size());
+        run_parallel([this, out, n](std::size_t i) {
+            if (i < n) {
+                out[i] = copies_[i]->get_state();
+            }
+        });
+    }
+    void apply_actions(std::span<const std::array<double, 2>> actions) override {
+        for (std::size_t i = 0; i < std::min(actions.size(), copies_.size()); ++i) {
+            copies_[i]->apply_action(actions[i][0], actions[i][1]);
+        }
+    }
+
+private:
+    // Runs `job` with every copy's index, copy 0 on this thread, and rethrows the first failure once all
+    // are done.
+    void run_parallel(std::function<void(std::size_t)> job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_ = std::move(job);
+            pending_ = workers_.size();
+            ++generation_;
+        }
+        start_cv_.notify_all();
+        std::exception_ptr error;
+        try {
+            job_(0);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_cv_.wait(lock, [this] { return pending_ == 0; });
+        if (!error) {
+            error = worker_error_;
+        }
+        worker_error_ = nullptr;
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    void worker_loop(std::size_t index) {
+        std::uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            start_cv_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+            if (stopping_) {
+                return;
+            }
+            seen = generation_;
+            lock.unlock();
+            std::exception_ptr error;
+            try {
+                job_(index);
+            } catch (...) {
+                error = std::current_exception();
+            }
+            lock.lock();
+            if (error && !worker_error_) {
+                worker_error_ = error;
+            }
+            if (--pending_ == 0) {
+                done_cv_.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::shared_ptr<racecar_sim_adapter>> copies_;
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+    std::function<void(std::size_t)> job_;
+    std::uint64_t generation_ = 0;
+    std::size_t pending_ = 0;
+    std::exception_ptr worker_error_;
+    bool stopping_ = false;
+};
+
+// Hands run_racecar_loop's tick records to the adapter: one per tick, or buffered as columns when
+// racecar_loop_options::tick_record_batch is above 1.
+class tick_record_writer {
+public:
+    tick_record_writer(racecar_sim_adapter& adapter, const racecar_loop_options& options)
+        : adapter_(adapter), batch_(static_cast<std::size_t>(options.tick_record_batch)) {
+        if (batch_ > 1) {
+            columns_.run_id = options.run_id;
+            columns_.mode = options.mode;
+            columns_.reserve(batch_);
+        }
+    }
+
+    void write(const racecar_tick_record& record) {
+        if (batch_ <= 1) {
+            adapter_.on_tick_record(record);
+            return;
+        }
+        columns_.append(record);
+        if (columns_.size() >= batch_) {
+            flush();
+        }
+    }
+
+    void flush() {
+        if (columns_.empty()) {
+            return;
+        }
+        adapter_.on_tick_records(columns_);
+        columns_.clear();
+    }
+
+private:
+    racecar_sim_adapter& adapter_;
+    std::size_t batch_ = 1;
+    racecar_tick_columns columns_;
+};
+
+}  // namespace
+
+std::shared_ptr<racecar_sim_adapter> make_racecar_parallel_adapter(std::vector<std::shared_ptr<racecar_sim_adapter>> copies) {
+    if (copies.empty() ||
+        std::any_of(copies.begin(), copies.end(), [](const auto& copy) { return copy == nullptr; })) {
+        throw std::invalid_argument("make_racecar_parallel_adapter: expected one or more adapters");
+    }
+    return std::make_shared<racecar_parallel_adapter>(std::move(copies));
+}
+
 const char* racecar_loop_status_name(racecar_loop_status status) noexcept {
     switch (status) {
         case racecar_loop_status::ok:
@@ -547,6 +871,9 @@ racecar_loop_result run_racecar_loop(runtime_host& host, std::int64_t instance_h
     if (options.state_key.empty() || options.action_key.empty()) {
         throw std::runtime_error("env.run-loop: :state_key and :action_key must be non-empty");
     }
+    if (options.tick_record_batch <= 0) {
+        throw std::runtime_error("env.run-loop: :tick_record_batch must be > 0");
+    }
 
     const std::shared_ptr<racecar_sim_adapter> adapter = racecar_sim_adapter_ptr();
     if (!adapter) {
@@ -575,9 +902,11 @@ racecar_loop_result run_racecar_loop(runtime_host& host, std::int64_t instance_h
     const double safe_steer = clamp_double(options.safe_action[0], -1.0, 1.0);
     const double safe_throttle = clamp_double(options.safe_action[1], -1.0, 1.0);
     const bool action_is_shared = options.action_semantics == kFlagshipActionSemantics;
+    tick_record_writer records(*adapter, options);
 
     for (std::int64_t i = 0; i < options.max_ticks; ++i) {
         if (adapter->stop_requested()) {
+            records.flush();
             result.status = racecar_loop_status::stopped;
             result.reason = "stop requested";
             result.ticks = ticks;
@@ -660,9 +989,10 @@ racecar_loop_result run_racecar_loop(runtime_host& host, std::int64_t instance_h
                 }
             }
 
-            adapter->on_tick_record(tick_record);
+            records.write(tick_record);
 
             if (goal_reached || bt_status == status::success) {
+                records.flush();
                 result.status = racecar_loop_status::ok;
                 result.reason = goal_reached ? "goal reached" : "bt returned success";
                 result.ticks = ticks;
@@ -707,7 +1037,8 @@ racecar_loop_result run_racecar_loop(runtime_host& host, std::int64_t instance_h
             tick_record.used_fallback = true;
             tick_record.is_error_record = true;
             tick_record.error_reason = e.what();
-            adapter->on_tick_record(tick_record);
+            records.write(tick_record);
+            records.flush();
 
             result.status = racecar_loop_status::error;
             result.reason = e.what();
@@ -728,6 +1059,7 @@ racecar_loop_result run_racecar_loop(runtime_host& host, std::int64_t instance_h
         }
     }
 
+    records.flush();
     result.status = racecar_loop_status::stopped;
     result.reason = "max ticks reached";
     result.ticks = ticks;
@@ -805,7 +1137,7 @@ void install_racecar_demo_callbacks(runtime_host& host) {
         }
 
         const bb_entry* rays_entry = ctx.bb_get(rays_key);
-        const auto* rays = rays_entry ? std::get_if<std::vector<double>>(&rays_entry->value) : nullptr;
+        const auto* rays = rays_entry ? std::get_if<bb_vector>(&rays_entry->value) : nullptr;
         if (!rays || rays->empty()) {
             ctx.bb_put(action_key, bb_value{std::vector<double>{0.0, 0.0}}, "avoid-obstacle");
             return status::failure;
@@ -875,7 +1207,7 @@ void install_racecar_demo_callbacks(runtime_host& host) {
         }
 
         const bb_entry* goal_entry = ctx.bb_get(goal_key);
-        const auto* goal = goal_entry ? std::get_if<std::vector<double>>(&goal_entry->value) : nullptr;
+        const auto* goal = goal_entry ? std::get_if<bb_vector>(&goal_entry->value) : nullptr;
         if (!goal || goal->size() < 2) {
             ctx.bb_put(action_key, bb_value{std::vector<double>{0.0, 0.0}}, "drive-to-goal");
             return status::failure;
@@ -901,7 +1233,7 @@ void install_racecar_demo_callbacks(runtime_host& host) {
         if (!entry) {
             return status::failure;
         }
-        const auto* vec = std::get_if<std::vector<double>>(&entry->value);
+        const auto* vec = std::get_if<bb_vector>(&entry->value);
         if (!vec || vec->size() < 2) {
             return status::failure;
         }
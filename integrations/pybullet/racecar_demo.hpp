@@ -3,6 +3,7 @@
 #include <array>
 #include <cstdint>
 #include <memory>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -48,6 +49,47 @@ struct racecar_tick_record {
     std::string error_reason{};
 };
 
+// Tick records as columns, one entry per tick, oldest first; see racecar_loop_options::tick_record_batch.
+// The columns keep the state fields tick logs use: pose, speed, goal and collision_imminent.
+struct racecar_tick_columns {
+    std::string schema_version = "racecar_demo.v1";
+    std::string run_id = "run";
+    std::string mode = "bt";
+    std::vector<std::int64_t> tick_index;
+    std::vector<double> sim_time_s;
+    std::vector<double> wall_time_s;
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> yaw;
+    std::vector<double> speed;
+    std::vector<double> goal_x;
+    std::vector<double> goal_y;
+    std::vector<std::uint8_t> collision_imminent;
+    std::vector<double> distance_to_goal;
+    std::vector<double> steering;
+    std::vector<double> throttle;
+    std::vector<std::uint8_t> has_shared_action;
+    std::vector<double> shared_linear_x;
+    std::vector<double> shared_angular_z;
+    std::vector<std::int64_t> collisions_total;
+    std::vector<std::uint8_t> goal_reached;
+    std::vector<std::string> bt_status;
+    std::vector<std::int64_t> active_branch;
+    std::vector<std::string> planner_meta_json;
+    std::vector<std::uint8_t> used_fallback;
+    std::vector<std::uint8_t> is_error_record;
+    std::vector<std::string> error_reason;
+
+    [[nodiscard]] std::size_t size() const noexcept { return tick_index.size(); }
+    [[nodiscard]] bool empty() const noexcept { return tick_index.empty(); }
+    void reserve(std::size_t ticks);
+    // Empties the columns, keeping their capacity.
+    void clear() noexcept;
+    void append(const racecar_tick_record& record);
+    // Tick `i` as a record, with the state fields the columns keep.
+    [[nodiscard]] racecar_tick_record record(std::size_t i) const;
+};
+
 class racecar_sim_adapter {
 public:
     virtual ~racecar_sim_adapter() = default;
@@ -59,14 +101,46 @@ public:
     virtual void debug_draw() {}
     [[nodiscard]] virtual bool stop_requested() const { return false; }
     virtual void on_tick_record(const racecar_tick_record&) {}
+    // Called instead of on_tick_record when racecar_loop_options::tick_record_batch is above 1: with
+    // that many ticks at a time, and with the rest when the loop returns. The default replays each
+    // tick through on_tick_record.
+    virtual void on_tick_records(const racecar_tick_columns& batch);
+
+    // Adapters that simulate several cars at once, for example many bodies in one physics client,
+    // override these; step() then advances every car. The defaults describe a single car.
+    [[nodiscard]] virtual std::size_t env_count() const { return 1; }
+    // Fills `out`, which holds env_count() states; assigning into them lets their vectors keep their
+    // buffers from one tick to the next.
+    virtual void get_states(std::span<racecar_state> out) {
+        if (!out.empty()) {
+            out.front() = get_state();
+        }
+    }
+    // One {steering, throttle} pair per car.
+    virtual void apply_actions(std::span<const std::array<double, 2>> actions) {
+        if (!actions.empty()) {
+            apply_action(actions[0][0], actions[0][1]);
+        }
+    }
 };
 
+// Runs one single-car adapter per copy, each typically with its own physics client, and steps them
+// in parallel: copy 0 on the calling thread, the others on worker threads kept for the adapter's
+// lifetime; get_states() reads the copies in parallel the same way. Every copy must tolerate calls
+// from its worker thread.
+[[nodiscard]] std::shared_ptr<racecar_sim_adapter> make_racecar_parallel_adapter(
+    std::vector<std::shared_ptr<racecar_sim_adapter>> copies);
+
 void set_racecar_sim_adapter(std::shared_ptr<racecar_sim_adapter> adapter);
 [[nodiscard]] std::shared_ptr<racecar_sim_adapter> racecar_sim_adapter_ptr();
 void clear_racecar_demo_state();
 
 [[nodiscard]] racecar_state racecar_get_state();
 void racecar_apply_action(double steering, double throttle);
+[[nodiscard]] std::size_t racecar_env_count();
+// Fills `out`, which must hold racecar_env_count() states.
+void racecar_get_states(std::span<racecar_state> out);
+void racecar_apply_actions(std::span<const std::array<double, 2>> actions);
 void racecar_step(std::int64_t steps);
 void racecar_reset();
 void racecar_debug_draw();
@@ -84,6 +158,9 @@ struct racecar_loop_options {
     std::string run_id = "run";
     double goal_tolerance = 0.6;
     std::string action_semantics = "racecar.native.v1";
+    // Ticks of records buffered as columns before the adapter's on_tick_records runs; 1 calls
+    // on_tick_record every tick.
+    std::int64_t tick_record_batch = 1;
 };
 
 enum class racecar_loop_status {
@@ -10,18 +10,26 @@
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <thread>
+#include <type_traits>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include <geometry_msgs/msg/twist.hpp>
 #include <nav_msgs/msg/odometry.hpp>
+#include <rclcpp/executors/multi_threaded_executor.hpp>
 #include <rclcpp/executors/single_threaded_executor.hpp>
 #include <rclcpp/rclcpp.hpp>
+#include <sensor_msgs/image_encodings.hpp>
+#include <sensor_msgs/msg/image.hpp>
+#include <sensor_msgs/msg/point_cloud2.hpp>
 
+#include "bt/latest_mailbox.hpp"
+#include "bt/runtime_host.hpp"
 #include "muslisp/gc.hpp"
 
 namespace muslisp::integrations::ros2 {
@@ -43,7 +51,7 @@ std::optional<value> map_lookup_option(value map_obj, const std::string& normali
     if (!is_map(map_obj)) {
         return std::nullopt;
     }
-    for (const auto& [key, val] : map_obj->map_data) {
+    for (const auto& [key, val] : map_obj->map_data()) {
         if (key.type != map_key_type::symbol && key.type != map_key_type::string) {
             continue;
         }
@@ -62,7 +70,8 @@ map_key symbol_key(const std::string& name) {
 }
 
 void map_set_symbol(value map_obj, const std::string& key_name, value v) {
-    map_obj->map_data[symbol_key(key_name)] = v;
+    map_obj->map_data()[symbol_key(key_name)] = v;
+    muslisp::default_gc().write_barrier(map_obj, v);
 }
 
 double require_number_value(value v, const std::string& where) {
@@ -206,6 +215,18 @@ void validate_ros2_schema_id_family(const std::string& schema_id,
     }
 }
 
+// Topics keep the last few messages; intra-process delivery needs a keep-last history.
+constexpr std::size_t kTopicQueueDepth = 10;
+
+// With `threads` > 0 the executor spins on its own threads; otherwise the tick thread pumps it.
+std::unique_ptr<rclcpp::Executor> make_executor(std::int64_t threads) {
+    if (threads > 0) {
+        return std::make_unique<rclcpp::executors::MultiThreadedExecutor>(rclcpp::ExecutorOptions(),
+                                                                         static_cast<std::size_t>(threads));
+    }
+    return std::make_unique<rclcpp::executors::SingleThreadedExecutor>();
+}
+
 std::int64_t stamp_to_ms(const builtin_interfaces::msg::Time& stamp) {
     return static_cast<std::int64_t>(stamp.sec) * 1000LL + static_cast<std::int64_t>(stamp.nanosec / 1000000U);
 }
@@ -296,21 +317,64 @@ struct observation_snapshot {
     double wy = 0.0;
     double wz = 0.0;
     std::string source = "odom";
+    // vla_service handles of the latest retained sensor messages; 0 when there is none.
+    std::int64_t image_id = 0;
+    std::int64_t cloud_id = 0;
+};
+
+// A sensor topic whose messages are kept rather than copied. The callback publishes the received
+// shared message; the observing thread adopts it as a vla_service handle backed by the message
+// buffer. The two newest adopted handles are held, so a handle in an observation stays valid while
+// the next observation is captured, as a pipelined run loop does.
+template <typename Msg>
+struct retained_sensor {
+    typename rclcpp::Subscription<Msg>::SharedPtr subscription{};
+    rclcpp::CallbackGroup::SharedPtr callback_group{};
+    bt::latest_mailbox<std::shared_ptr<const Msg>> mailbox{};
+    std::string topic{};
+    const Msg* adopted_msg = nullptr;
+    std::int64_t current_id = 0;
+    std::int64_t previous_id = 0;
+};
+
+class ros2_env_backend;
+
+// A captured odometry snapshot; the map is built on the interpreter thread.
+class ros2_observation final : public env_observation {
+public:
+    ros2_observation(const ros2_env_backend& backend, observation_snapshot snapshot, bool fresh)
+        : backend_(backend), snapshot_(std::move(snapshot)), fresh_(fresh) {}
+
+    [[nodiscard]] value to_value() const override;
+
+private:
+    const ros2_env_backend& backend_;
+    observation_snapshot snapshot_;
+    bool fresh_ = false;
 };
 
 class ros2_env_backend final : public env_backend {
+    friend class ros2_observation;
+
 public:
     ros2_env_backend() = default;
 
     ~ros2_env_backend() override {
+        stop_spinning();
         if (executor_ && node_) {
             executor_->cancel();
             executor_->remove_node(node_);
         }
         subscription_.reset();
+        image_.subscription.reset();
+        cloud_.subscription.reset();
         publisher_.reset();
         node_.reset();
         executor_.reset();
+        release_handle<sensor_msgs::msg::Image>(image_.current_id);
+        release_handle<sensor_msgs::msg::Image>(image_.previous_id);
+        release_handle<sensor_msgs::msg::PointCloud2>(cloud_.current_id);
+        release_handle<sensor_msgs::msg::PointCloud2>(cloud_.previous_id);
     }
 
     [[nodiscard]] std::string backend_version() const override {
@@ -324,6 +388,8 @@ public:
         out.headless = true;
         out.realtime_pacing = true;
         out.deterministic_seed = false;
+        out.pipelined_observe = true;
+        out.typed_observe = true;
         return out;
     }
 
@@ -349,11 +415,13 @@ public:
         map_set_symbol(out, "capabilities", string_vector_to_lisp_list(capability_tags()));
         map_set_symbol(out, "obs_topic", make_string(obs_topic_));
         map_set_symbol(out, "action_topic", make_string(action_topic_));
+        map_set_symbol(out, "image_topic", make_string(image_.topic));
+        map_set_symbol(out, "cloud_topic", make_string(cloud_.topic));
         map_set_symbol(out, "node_name", make_string(node_name_));
         map_set_symbol(out, "ros_distro", make_string(ros_distro_));
         map_set_symbol(out, "time_source", make_string(ros_time_source_name(use_sim_time_)));
         map_set_symbol(out, "obs_timestamp_source", make_string(std::string(ros_obs_timestamp_source_name())));
-        map_set_symbol(out, "received_samples", make_integer(static_cast<std::int64_t>(observation_generation_)));
+        map_set_symbol(out, "received_samples", make_integer(static_cast<std::int64_t>(observation_generation_.load())));
         map_set_symbol(out, "published_actions", make_integer(published_action_count_));
 
         map_set_symbol(config, "control_hz", make_integer(control_hz_));
@@ -368,6 +436,9 @@ public:
         map_set_symbol(config, "obs_source", make_string(obs_source_));
         map_set_symbol(config, "action_sink", make_string(action_sink_));
         map_set_symbol(config, "reset_mode", make_string(reset_mode_));
+        map_set_symbol(config, "executor_threads", make_integer(executor_threads_));
+        map_set_symbol(config, "image_source", make_string(image_source_));
+        map_set_symbol(config, "cloud_source", make_string(cloud_source_));
         map_set_symbol(out, "config", config);
 
         return out;
@@ -410,9 +481,12 @@ public:
             "obs_source",
             "action_sink",
             "reset_mode",
+            "executor_threads",
+            "image_source",
+            "cloud_source",
         };
 
-        for (const auto& [key, _] : opts->map_data) {
+        for (const auto& [key, _] : opts->map_data()) {
             if (key.type != map_key_type::symbol && key.type != map_key_type::string) {
                 throw std::runtime_error("configure: option keys must be strings or symbols");
             }
@@ -435,6 +509,9 @@ public:
         std::string obs_source = obs_source_;
         std::string action_sink = action_sink_;
         std::string reset_mode = reset_mode_;
+        std::int64_t executor_threads = executor_threads_;
+        std::string image_source = image_source_;
+        std::string cloud_source = cloud_source_;
 
         if (const auto candidate = map_lookup_option(opts, "obs_schema")) {
             obs_schema = require_text_value(*candidate, "configure.obs_schema");
@@ -506,6 +583,24 @@ public:
                 throw std::runtime_error("configure: reset_mode must be 'stub' or 'unsupported'");
             }
         }
+        if (const auto candidate = map_lookup_option(opts, "executor_threads")) {
+            if (!is_integer(*candidate)) {
+                throw std::runtime_error("configure: executor_threads must be integer");
+            }
+            executor_threads = integer_value(*candidate);
+            if (executor_threads < 0) {
+                throw std::runtime_error("configure: executor_threads must be >= 0");
+            }
+        }
+        if (const auto candidate = map_lookup_option(opts, "image_source")) {
+            image_source = require_text_value(*candidate, "configure.image_source");
+        }
+        if (const auto candidate = map_lookup_option(opts, "cloud_source")) {
+            cloud_source = require_text_value(*candidate, "configure.cloud_source");
+        }
+
+        // Callbacks read the transport settings, so a spinning executor stops while they change.
+        stop_spinning();
 
         obs_schema_ = std::move(obs_schema);
         state_schema_ = std::move(state_schema);
@@ -520,9 +615,19 @@ public:
         obs_source_ = std::move(obs_source);
         action_sink_ = std::move(action_sink);
         reset_mode_ = std::move(reset_mode);
+        image_source_ = std::move(image_source);
+        cloud_source_ = std::move(cloud_source);
+        const bool executor_changed = executor_threads != executor_threads_;
+        executor_threads_ = executor_threads;
 
         ensure_runtime();
+        if (executor_changed) {
+            executor_->remove_node(node_);
+            executor_ = make_executor(executor_threads_);
+            executor_->add_node(node_);
+        }
         rebuild_transport();
+        start_spinning();
     }
 
     [[nodiscard]] value reset(std::optional<std::int64_t> seed) override {
@@ -537,18 +642,18 @@ public:
         publish_zero_twist();
 
         observation_snapshot snapshot;
+        snapshot.frame_id = frame_id_;
+        snapshot.child_frame_id = child_frame_id_;
+        snapshot.source = "reset_stub";
+        snapshot.generation = observation_generation_.fetch_add(1) + 1;
+        snapshot.t_ms = node_now_ms();
+        reset_observation_ = snapshot;
+        last_observed_generation_ = snapshot.generation;
+        raise_published_generation(snapshot.generation);
         {
             const std::lock_guard<std::mutex> lock(mutex_);
-            latest_observation_ = observation_snapshot{};
-            latest_observation_->frame_id = frame_id_;
-            latest_observation_->child_frame_id = child_frame_id_;
-            latest_observation_->source = "reset_stub";
-            latest_observation_->generation = ++observation_generation_;
-            latest_observation_->t_ms = node_now_ms();
-            last_observed_generation_ = latest_observation_->generation;
             last_action_ = action_command{};
             published_action_count_ = 0;
-            snapshot = *latest_observation_;
         }
 
         return observation_to_value(snapshot, false);
@@ -556,43 +661,55 @@ public:
 
     [[nodiscard]] value observe() override {
         ensure_runtime();
+        bool fresh = false;
+        const observation_snapshot snapshot = capture_observation(fresh);
+        return observation_to_value(snapshot, fresh);
+    }
 
+    // Waits for and copies the latest odometry without building Lisp values, so a run-loop pipeline
+    // thread can call it while act() and step() run; executor access is serialised.
+    [[nodiscard]] std::unique_ptr<env_observation> acquire_observation() override {
+        ensure_runtime();
         bool fresh = false;
-        const auto baseline_generation = current_generation();
-        if ((require_fresh_obs_ || !has_cached_observation()) &&
-            wait_for_generation_change(baseline_generation, std::chrono::milliseconds(observe_timeout_ms_))) {
-            fresh = true;
-        } else {
-            pump_executor_for(std::chrono::milliseconds(0));
-        }
+        observation_snapshot snapshot = capture_observation(fresh);
+        return std::make_unique<ros2_observation>(*this, std::move(snapshot), fresh);
+    }
 
-        observation_snapshot snapshot;
-        {
-            const std::lock_guard<std::mutex> lock(mutex_);
-            if (latest_observation_.has_value()) {
-                snapshot = *latest_observation_;
-                fresh = snapshot.generation > last_observed_generation_;
-                last_observed_generation_ = snapshot.generation;
-            } else {
-                if (require_fresh_obs_) {
-                    throw std::runtime_error("no observation available within observe_timeout_ms");
-                }
-                snapshot = placeholder_observation();
-            }
+    // The odometry fields of observe() as typed fields: pose is [x y z qx qy qz qw] and twist is
+    // [vx vy vz wx wy wz]. Static configuration (topics, node name) stays in env.info.
+    void observe_into(env_observation_sink& sink) override {
+        ensure_runtime();
+        bool fresh = false;
+        const observation_snapshot snapshot = capture_observation(fresh);
+        const double yaw = yaw_from_quaternion(snapshot.qx, snapshot.qy, snapshot.qz, snapshot.qw);
+        const double state_vec[] = {snapshot.x, snapshot.y, yaw, snapshot.vx, snapshot.vy, snapshot.wz};
+        const double pose[] = {snapshot.x, snapshot.y, snapshot.z, snapshot.qx, snapshot.qy, snapshot.qz, snapshot.qw};
+        const double twist[] = {snapshot.vx, snapshot.vy, snapshot.vz, snapshot.wx, snapshot.wy, snapshot.wz};
+
+        sink.put_string("obs_schema", obs_schema_);
+        sink.put_string("state_schema", state_schema_);
+        sink.put_integer("t_ms", snapshot.t_ms);
+        sink.put_bool("done", false);
+        sink.put_vector("state_vec", state_vec);
+        sink.put_string("frame_id", snapshot.frame_id);
+        sink.put_string("child_frame_id", snapshot.child_frame_id);
+        sink.put_vector("pose", pose);
+        sink.put_vector("twist", twist);
+        sink.put_string("source", snapshot.source);
+        sink.put_bool("fresh_obs", fresh);
+        sink.put_bool("has_sample", snapshot.available);
+        if (snapshot.image_id != 0) {
+            sink.put_image("image", snapshot.image_id);
+        }
+        if (snapshot.cloud_id != 0) {
+            sink.put_blob("cloud", snapshot.cloud_id);
         }
-
-        return observation_to_value(snapshot, fresh);
     }
 
     void act(value action) override {
         ensure_runtime();
         const action_command command = parse_action(action);
-
-        geometry_msgs::msg::Twist twist;
-        twist.linear.x = command.linear_x;
-        twist.linear.y = command.linear_y;
-        twist.angular.z = command.angular_z;
-        publisher_->publish(twist);
+        publish_twist(command);
 
         const std::lock_guard<std::mutex> lock(mutex_);
         last_action_ = command;
@@ -606,6 +723,98 @@ public:
     }
 
 private:
+    [[nodiscard]] observation_snapshot capture_observation(bool& fresh) {
+        const auto baseline_generation = current_generation();
+        if ((require_fresh_obs_ || !has_cached_observation()) &&
+            wait_for_generation_change(baseline_generation, std::chrono::milliseconds(observe_timeout_ms_))) {
+            fresh = true;
+        } else {
+            pump_executor_for(std::chrono::milliseconds(0));
+        }
+
+        observation_snapshot snapshot;
+        if (const observation_snapshot* latest = latest_observation()) {
+            snapshot = *latest;
+            fresh = snapshot.generation > last_observed_generation_;
+            last_observed_generation_ = snapshot.generation;
+        } else {
+            if (require_fresh_obs_) {
+                throw std::runtime_error("no observation available within observe_timeout_ms");
+            }
+            snapshot = placeholder_observation();
+        }
+        snapshot.image_id = adopt_latest(image_, [](const sensor_msgs::msg::Image& msg,
+                                                    const std::shared_ptr<const sensor_msgs::msg::Image>& owner) {
+            std::int64_t channels = 0;
+            try {
+                channels = sensor_msgs::image_encodings::numChannels(msg.encoding);
+            } catch (const std::exception&) {
+                channels = msg.width > 0 ? static_cast<std::int64_t>(msg.step / msg.width) : 0;
+            }
+            return bt::default_runtime_host()
+                .vla_ref()
+                .adopt_image(msg.width,
+                             msg.height,
+                             channels,
+                             msg.encoding,
+                             stamp_to_ms(msg.header.stamp),
+                             msg.header.frame_id.empty() ? "camera" : msg.header.frame_id,
+                             bt::retained_payload{.owner = owner, .bytes = std::as_bytes(std::span(msg.data))})
+                .id;
+        });
+        snapshot.cloud_id = adopt_latest(cloud_, [](const sensor_msgs::msg::PointCloud2& msg,
+                                                    const std::shared_ptr<const sensor_msgs::msg::PointCloud2>& owner) {
+            return bt::default_runtime_host()
+                .vla_ref()
+                .adopt_blob("application/x-ros2-pointcloud2",
+                            stamp_to_ms(msg.header.stamp),
+                            msg.header.frame_id,
+                            bt::retained_payload{.owner = owner, .bytes = std::as_bytes(std::span(msg.data))})
+                .id;
+        });
+        return snapshot;
+    }
+
+    // Adopts the sensor's newest message if it was not adopted yet and returns the current handle.
+    // Runs on the observing thread only, like latest_observation().
+    template <typename Msg, typename Adopt>
+    std::int64_t adopt_latest(retained_sensor<Msg>& sensor, Adopt adopt) {
+        const std::shared_ptr<const Msg>* latest = sensor.mailbox.read();
+        if (latest == nullptr || !*latest || latest->get() == sensor.adopted_msg || (*latest)->data.empty()) {
+            return sensor.current_id;
+        }
+        const std::int64_t id = adopt(**latest, *latest);
+        release_handle<Msg>(sensor.previous_id);
+        sensor.previous_id = sensor.current_id;
+        sensor.current_id = id;
+        sensor.adopted_msg = latest->get();
+        return id;
+    }
+
+    template <typename Msg>
+    static void release_handle(std::int64_t id) {
+        if (id == 0) {
+            return;
+        }
+        bt::vla_service& vla = bt::default_runtime_host().vla_ref();
+        if constexpr (std::is_same_v<Msg, sensor_msgs::msg::Image>) {
+            (void)vla.release_image(bt::image_handle_ref{.id = id});
+        } else {
+            (void)vla.release_blob(bt::blob_handle_ref{.id = id});
+        }
+    }
+
+    // Reader side of the odometry mailbox. A reset stub newer than the last message wins. Called from
+    // one thread at a time: the tick thread, or the run-loop pipeline thread while the tick thread
+    // does not observe.
+    [[nodiscard]] const observation_snapshot* latest_observation() {
+        const observation_snapshot* latest = odom_mailbox_.read();
+        if (reset_observation_.has_value() && (latest == nullptr || latest->generation < reset_observation_->generation)) {
+            return &*reset_observation_;
+        }
+        return latest;
+    }
+
     [[nodiscard]] std::vector<std::string> capability_tags() const {
         std::vector<std::string> tags = {"observe", "act", "step", "run_loop", "event_log"};
         if (supports().reset) {
@@ -636,11 +845,36 @@ private:
         options.start_parameter_services(false);
         options.start_parameter_event_publisher(false);
         options.append_parameter_override("use_sim_time", use_sim_time_);
+        options.use_intra_process_comms(true);
         node_ = std::make_shared<rclcpp::Node>(node_name_, options);
-        executor_ = std::make_unique<rclcpp::executors::SingleThreadedExecutor>();
+        executor_ = make_executor(executor_threads_);
         executor_->add_node(node_);
     }
 
+    // With executor_threads > 0, runs the executor on its own threads until stop_spinning().
+    void start_spinning() {
+        if (executor_threads_ <= 0 || spin_thread_.joinable()) {
+            return;
+        }
+        spin_done_.store(false);
+        spin_thread_ = std::thread([this] {
+            executor_->spin();
+            spin_done_.store(true);
+        });
+    }
+
+    void stop_spinning() {
+        if (!spin_thread_.joinable()) {
+            return;
+        }
+        // cancel() is lost if it lands before spin() starts, so repeat it until the thread is done.
+        while (!spin_done_.load()) {
+            executor_->cancel();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        spin_thread_.join();
+    }
+
     void rebuild_transport() {
         obs_topic_ = resolve_topic_name(topic_ns_, obs_source_);
         action_topic_ = resolve_topic_name(topic_ns_, action_sink_);
@@ -648,24 +882,64 @@ private:
         subscription_.reset();
         publisher_.reset();
 
-        publisher_ = node_->create_publisher<geometry_msgs::msg::Twist>(action_topic_, rclcpp::SystemDefaultsQoS());
+        // Each subscription has its own mutually exclusive group: its callbacks never overlap, so it
+        // is the single writer of its mailbox, while a multi-threaded executor runs topics in parallel.
+        if (!odom_callback_group_) {
+            odom_callback_group_ = node_->create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
+        }
+        rclcpp::SubscriptionOptions subscription_options;
+        subscription_options.callback_group = odom_callback_group_;
+
+        const rclcpp::QoS qos{rclcpp::KeepLast(kTopicQueueDepth)};
+        publisher_ = node_->create_publisher<geometry_msgs::msg::Twist>(action_topic_, qos);
         subscription_ = node_->create_subscription<nav_msgs::msg::Odometry>(
             obs_topic_,
-            rclcpp::SystemDefaultsQoS(),
-            [this](const nav_msgs::msg::Odometry::SharedPtr msg) { handle_odometry(*msg); });
+            qos,
+            [this, source = obs_source_](const nav_msgs::msg::Odometry::SharedPtr msg) { handle_odometry(*msg, source); },
+            subscription_options);
+        subscribe_retained(image_, image_source_, qos);
+        subscribe_retained(cloud_, cloud_source_, qos);
     }
 
-    void handle_odometry(const nav_msgs::msg::Odometry& msg) {
-        observation_snapshot snapshot;
+    // An empty source leaves the sensor unsubscribed. Held handles stay valid until replaced.
+    template <typename Msg>
+    void subscribe_retained(retained_sensor<Msg>& sensor, const std::string& source, const rclcpp::QoS& qos) {
+        sensor.subscription.reset();
+        sensor.topic = source.empty() ? std::string{} : resolve_topic_name(topic_ns_, source);
+        if (source.empty()) {
+            return;
+        }
+        if (!sensor.callback_group) {
+            sensor.callback_group = node_->create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
+        }
+        rclcpp::SubscriptionOptions options;
+        options.callback_group = sensor.callback_group;
+        sensor.subscription = node_->create_subscription<Msg>(
+            sensor.topic,
+            qos,
+            [this, &sensor](std::shared_ptr<const Msg> msg) {
+                // A loaned message returns to the middleware when the callback ends, so it is copied
+                // once; otherwise the received message itself is kept.
+                if (sensor.subscription && sensor.subscription->can_loan_messages()) {
+                    msg = std::make_shared<const Msg>(*msg);
+                }
+                sensor.mailbox.back() = std::move(msg);
+                sensor.mailbox.publish();
+            },
+            options);
+    }
+
+    // Writes the message into the mailbox's free slot, reusing its string buffers.
+    void handle_odometry(const nav_msgs::msg::Odometry& msg, const std::string& source) {
+        observation_snapshot& snapshot = odom_mailbox_.back();
         snapshot.available = true;
-        snapshot.generation = 0;
         if (msg.header.stamp.sec != 0 || msg.header.stamp.nanosec != 0) {
             snapshot.t_ms = stamp_to_ms(msg.header.stamp);
         } else {
             snapshot.t_ms = node_now_ms();
         }
-        snapshot.frame_id = msg.header.frame_id.empty() ? frame_id_ : msg.header.frame_id;
-        snapshot.child_frame_id = msg.child_frame_id.empty() ? child_frame_id_ : msg.child_frame_id;
+        snapshot.frame_id.assign(msg.header.frame_id.empty() ? frame_id_ : msg.header.frame_id);
+        snapshot.child_frame_id.assign(msg.child_frame_id.empty() ? child_frame_id_ : msg.child_frame_id);
         snapshot.x = msg.pose.pose.position.x;
         snapshot.y = msg.pose.pose.position.y;
         snapshot.z = msg.pose.pose.position.z;
@@ -679,20 +953,30 @@ private:
         snapshot.wx = msg.twist.twist.angular.x;
         snapshot.wy = msg.twist.twist.angular.y;
         snapshot.wz = msg.twist.twist.angular.z;
-        snapshot.source = obs_source_;
+        snapshot.source.assign(source);
+        const std::uint64_t generation = observation_generation_.fetch_add(1) + 1;
+        snapshot.generation = generation;
+        odom_mailbox_.publish();
+        raise_published_generation(generation);
+    }
 
-        const std::lock_guard<std::mutex> lock(mutex_);
-        snapshot.generation = ++observation_generation_;
-        latest_observation_ = snapshot;
+    void raise_published_generation(std::uint64_t generation) {
+        std::uint64_t current = published_generation_.load();
+        while (current < generation && !published_generation_.compare_exchange_weak(current, generation)) {
+        }
     }
 
+    // Spins the tick-thread executor. A background executor needs no pumping.
     void pump_executor_for(std::chrono::milliseconds budget) {
-        if (!executor_) {
+        if (!executor_ || spin_thread_.joinable()) {
             return;
         }
         const auto deadline = std::chrono::steady_clock::now() + budget;
         do {
-            executor_->spin_some(std::chrono::milliseconds(0));
+            {
+                const std::lock_guard<std::mutex> lock(executor_mutex_);
+                executor_->spin_some(std::chrono::milliseconds(0));
+            }
             if (budget.count() <= 0) {
                 break;
             }
@@ -713,14 +997,13 @@ private:
         return current_generation() > baseline;
     }
 
-    [[nodiscard]] bool has_cached_observation() const {
-        const std::lock_guard<std::mutex> lock(mutex_);
-        return latest_observation_.has_value();
+    [[nodiscard]] bool has_cached_observation() {
+        return latest_observation() != nullptr;
     }
 
+    // Generation of the newest observation a reader can see.
     [[nodiscard]] std::uint64_t current_generation() const {
-        const std::lock_guard<std::mutex> lock(mutex_);
-        return observation_generation_;
+        return published_generation_.load();
     }
 
     [[nodiscard]] action_command parse_action(value action) const {
@@ -812,12 +1095,11 @@ private:
 
         action_command last_action;
         std::int64_t published_actions = 0;
-        std::uint64_t generations = 0;
+        const std::uint64_t generations = observation_generation_.load();
         {
             const std::lock_guard<std::mutex> lock(mutex_);
             last_action = last_action_;
             published_actions = published_action_count_;
-            generations = observation_generation_;
         }
 
         map_set_symbol(obs, "obs_schema", make_string(obs_schema_));
@@ -828,6 +1110,12 @@ private:
         map_set_symbol(obs, "flags", flags);
         map_set_symbol(obs, "info", info);
         map_set_symbol(obs, "done", make_boolean(false));
+        if (snapshot.image_id != 0) {
+            map_set_symbol(obs, "image", make_image_handle(snapshot.image_id));
+        }
+        if (snapshot.cloud_id != 0) {
+            map_set_symbol(obs, "cloud", make_blob_handle(snapshot.cloud_id));
+        }
 
         map_set_symbol(state, "state_schema", make_string(state_schema_));
         map_set_symbol(state, "frame_id", make_string(snapshot.frame_id));
@@ -866,8 +1154,27 @@ private:
         if (!publisher_) {
             return;
         }
-        geometry_msgs::msg::Twist twist;
-        publisher_->publish(twist);
+        publish_twist(action_command{});
+    }
+
+    // Writes into a middleware loan when the RMW offers one, so shared-memory transports publish
+    // without a serialisation copy. Otherwise published as a unique_ptr, so intra-process subscribers
+    // take ownership without a copy.
+    void publish_twist(const action_command& command) {
+        const auto fill = [&command](geometry_msgs::msg::Twist& twist) {
+            twist.linear.x = command.linear_x;
+            twist.linear.y = command.linear_y;
+            twist.angular.z = command.angular_z;
+        };
+        if (publisher_->can_loan_messages()) {
+            auto loaned = publisher_->borrow_loaned_message();
+            fill(loaned.get());
+            publisher_->publish(std::move(loaned));
+            return;
+        }
+        auto twist = std::make_unique<geometry_msgs::msg::Twist>();
+        fill(*twist);
+        publisher_->publish(std::move(twist));
     }
 
     [[nodiscard]] std::int64_t node_now_ms() const {
@@ -878,6 +1185,9 @@ private:
     }
 
     mutable std::mutex mutex_{};
+    // A pipelined acquire_observation() pumps the executor while step() does.
+    std::mutex executor_mutex_{};
+    std::int64_t executor_threads_ = 0;
     std::string obs_schema_ = "ros2.obs.v1";
     std::string state_schema_ = "ros2.state.v1";
     std::string action_schema_ = "ros2.action.v1";
@@ -892,6 +1202,8 @@ private:
     std::string obs_source_ = "odom";
     std::string action_sink_ = "cmd_vel";
     std::string reset_mode_ = "unsupported";
+    std::string image_source_{};
+    std::string cloud_source_{};
     std::string frame_id_ = "map";
     std::string child_frame_id_ = "base_link";
     std::string node_name_{};
@@ -899,16 +1211,29 @@ private:
     std::string action_topic_ = "/cmd_vel";
     std::string ros_distro_ = "humble";
     std::shared_ptr<rclcpp::Node> node_{};
-    std::unique_ptr<rclcpp::executors::SingleThreadedExecutor> executor_{};
+    std::unique_ptr<rclcpp::Executor> executor_{};
+    std::thread spin_thread_{};
+    std::atomic<bool> spin_done_{false};
+    rclcpp::CallbackGroup::SharedPtr odom_callback_group_{};
     rclcpp::Subscription<nav_msgs::msg::Odometry>::SharedPtr subscription_{};
     rclcpp::Publisher<geometry_msgs::msg::Twist>::SharedPtr publisher_{};
-    std::optional<observation_snapshot> latest_observation_{};
-    std::uint64_t observation_generation_ = 0;
+    // Latest odometry, written by the subscription callback on an executor thread.
+    bt::latest_mailbox<observation_snapshot> odom_mailbox_{};
+    // Set by a stub reset; wins over mailbox samples older than it.
+    std::optional<observation_snapshot> reset_observation_{};
+    retained_sensor<sensor_msgs::msg::Image> image_{};
+    retained_sensor<sensor_msgs::msg::PointCloud2> cloud_{};
+    std::atomic<std::uint64_t> observation_generation_{0};
+    std::atomic<std::uint64_t> published_generation_{0};
     std::uint64_t last_observed_generation_ = 0;
     action_command last_action_{};
     std::int64_t published_action_count_ = 0;
 };
 
+value ros2_observation::to_value() const {
+    return backend_.observation_to_value(snapshot_, fresh_);
+}
+
 }  // namespace
 
 std::shared_ptr<env_backend> make_backend() {
@@ -16,7 +16,7 @@ public:
 
     void register_lisp(registrar& reg) const override {
         (void)reg;
-        env_api_register_backend("ros2", make_backend());
+        env_api_register_backend_factory("ros2", make_backend);
     }
 };
 
@@ -6,6 +6,7 @@
 #include <cstdint>
 #include <memory>
 #include <optional>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <utility>
@@ -41,7 +42,7 @@ std::optional<muslisp::value> map_lookup_option(muslisp::value map_obj, const st
     if (!muslisp::is_map(map_obj)) {
         return std::nullopt;
     }
-    for (const auto& [key, val] : map_obj->map_data) {
+    for (const auto& [key, val] : map_obj->map_data()) {
         if (key.type != muslisp::map_key_type::symbol && key.type != muslisp::map_key_type::string) {
             continue;
         }
@@ -60,7 +61,8 @@ muslisp::map_key symbol_key(const std::string& name) {
 }
 
 void map_set_symbol(muslisp::value map_obj, const std::string& key_name, muslisp::value v) {
-    map_obj->map_data[symbol_key(key_name)] = v;
+    map_obj->map_data()[symbol_key(key_name)] = v;
+    muslisp::default_gc().write_barrier(map_obj, v);
 }
 
 double clamp_double(double value, double lo, double hi) {
@@ -154,6 +156,9 @@ public:
         out.headless = true;
         out.realtime_pacing = true;
         out.deterministic_seed = true;
+        out.typed_observe = true;
+        out.batched_step = true;
+        out.simulated_time = true;
         return out;
     }
 
@@ -224,17 +229,51 @@ public:
             roots.add(&ground_list);
             map_set_symbol(obs, "ground", ground_list);
 
-            const double dark_left = clamp_double(1.0 - ground[0], 0.0, 1.0);
-            const double dark_centre = clamp_double(1.0 - ground[1], 0.0, 1.0);
-            const double dark_right = clamp_double(1.0 - ground[2], 0.0, 1.0);
-            const double dark_sum = dark_left + dark_centre + dark_right;
-            const double line_error = dark_sum > 1e-6 ? clamp_double((dark_right - dark_left) / dark_sum, -1.0, 1.0) : 0.0;
-            map_set_symbol(obs, "line_error", muslisp::make_float(line_error));
+            map_set_symbol(obs, "line_error", muslisp::make_float(line_error(ground)));
         }
 
         return obs;
     }
 
+    // The fields of observe(), written without building Lisp values.
+    void observe_into(muslisp::env_observation_sink& sink) override {
+        const std::array<double, 8> proximity = read_proximity_normalised();
+        const double max_proximity = *std::max_element(proximity.begin(), proximity.end());
+        const double left_activity = proximity[5] + proximity[6] + proximity[7];
+        const double right_activity = proximity[0] + proximity[1] + proximity[2];
+
+        sink.put_string("obs_schema", obs_schema_);
+        sink.put_integer("t_ms", static_cast<std::int64_t>(std::llround(robot_->getTime() * 1000.0)));
+        sink.put_vector("proximity", proximity);
+        sink.put_number("min_obstacle", clamp_double(1.0 - max_proximity, 0.0, 1.0));
+        sink.put_string("wall_side", left_activity >= right_activity ? "left" : "right");
+        sink.put_string("demo", demo_);
+        sink.put_bool("done", false);
+        if (has_seed_) {
+            sink.put_integer("seed", seed_);
+        }
+        if (demo_ == "line") {
+            const std::array<double, 3> ground = read_ground_normalised();
+            sink.put_vector("ground", ground);
+            sink.put_number("line_error", line_error(ground));
+        }
+    }
+
+    // A Webots controller drives one robot, so the batch has one copy. Evaluation sweeps run several
+    // Webots instances, each with its own controller process.
+    void observe_batch_into(std::span<muslisp::env_observation_sink* const> sinks) override {
+        observe_into(*sinks.front());
+    }
+
+    void act_batch(std::span<const std::span<const double>> actions) override {
+        const std::span<const double> u = actions.front();
+        if (u.size() >= 2) {
+            pending_left_ = clamp_double(u[0], -kMaxWheelSpeed, kMaxWheelSpeed);
+            pending_right_ = clamp_double(u[1], -kMaxWheelSpeed, kMaxWheelSpeed);
+            has_pending_ = true;
+        }
+    }
+
     void act(muslisp::value action) override {
         if (!muslisp::is_map(action)) {
             throw std::runtime_error("env.act: expected action map");
@@ -325,6 +364,14 @@ private:
         return values;
     }
 
+    [[nodiscard]] static double line_error(const std::array<double, 3>& ground) {
+        const double dark_left = clamp_double(1.0 - ground[0], 0.0, 1.0);
+        const double dark_centre = clamp_double(1.0 - ground[1], 0.0, 1.0);
+        const double dark_right = clamp_double(1.0 - ground[2], 0.0, 1.0);
+        const double dark_sum = dark_left + dark_centre + dark_right;
+        return dark_sum > 1e-6 ? clamp_double((dark_right - dark_left) / dark_sum, -1.0, 1.0) : 0.0;
+    }
+
     [[nodiscard]] std::array<double, 3> read_ground_normalised() const {
         std::array<double, 3> values{};
         for (int i = 0; i < 3; ++i) {
@@ -362,7 +409,11 @@ private:
 class webots_extension final : public muslisp::extension {
 public:
     webots_extension(::webots::Robot* robot, muslisp::integrations::webots::attach_options options)
-        : backend_(std::make_shared<webots_env_backend>(robot, std::move(options))) {}
+        : robot_(robot), options_(std::move(options)) {
+        if (!robot_) {
+            throw muslisp::lisp_error("webots integration requires non-null webots::Robot");
+        }
+    }
 
     [[nodiscard]] std::string name() const override {
         return "integration.webots";
@@ -370,13 +421,17 @@ public:
 
     void register_lisp(muslisp::registrar& reg) const override {
         (void)reg;
-        muslisp::env_api_register_backend("webots", backend_);
+        // Devices are looked up and enabled on the first env.attach, not at start-up.
+        muslisp::env_api_register_backend_factory("webots", [robot = robot_, options = options_] {
+            return std::make_shared<webots_env_backend>(robot, options);
+        });
     }
 
     void register_bt(bt::runtime_host& host) const override;
 
 private:
-    std::shared_ptr<webots_env_backend> backend_;
+    ::webots::Robot* robot_;
+    muslisp::integrations::webots::attach_options options_;
 };
 
 }  // namespace
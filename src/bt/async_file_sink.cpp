@@ -0,0 +1,168 @@
+#include "bt/async_file_sink.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <filesystem>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MUESLI_BT_HAVE_WRITEV 1
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#else
+#define MUESLI_BT_HAVE_WRITEV 0
+#endif
+
+namespace bt {
+namespace {
+
+constexpr std::size_t k_batch_lines = 256;
+
+}  // namespace
+
+async_file_sink::async_file_sink(const std::string& path,
+                                 std::size_t queue_lines,
+                                 std::atomic<std::uint64_t>& dropped)
+    : dropped_(dropped) {
+    if (!supported()) {
+        throw std::runtime_error("async_file_sink: asynchronous file output is not supported on this platform");
+    }
+    if (queue_lines == 0) {
+        throw std::invalid_argument("async_file_sink: queue size must be positive");
+    }
+    slots_.resize(std::bit_ceil(queue_lines));
+    mask_ = slots_.size() - 1;
+
+#if MUESLI_BT_HAVE_WRITEV
+    const std::filesystem::path fs_path(path);
+    if (fs_path.has_parent_path()) {
+        std::error_code ec;
+        std::filesystem::create_directories(fs_path.parent_path(), ec);
+    }
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+#endif
+    thread_ = std::thread([this] { run(); });
+}
+
+async_file_sink::~async_file_sink() {
+    stopping_.store(true);
+    wake_.fetch_add(1);
+    wake_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+#if MUESLI_BT_HAVE_WRITEV
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+#endif
+}
+
+bool async_file_sink::supported() noexcept {
+    return MUESLI_BT_HAVE_WRITEV != 0;
+}
+
+bool async_file_sink::push(std::string_view line) {
+    const std::uint64_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) >= slots_.size()) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    slots_[head & mask_].assign(line);
+    head_.store(head + 1);
+    // Pairs with the idle check in run(): either the writer sees the new head before it sleeps, or
+    // this sees it idle and wakes it.
+    if (idle_.load()) {
+        wake_.fetch_add(1);
+        wake_.notify_one();
+    }
+    return true;
+}
+
+void async_file_sink::drain() {
+    const std::uint64_t target = head_.load();
+    for (std::uint64_t tail = tail_.load(); tail < target; tail = tail_.load()) {
+        tail_.wait(tail);
+    }
+}
+
+std::size_t async_file_sink::queue_lines() const noexcept {
+    return slots_.size();
+}
+
+void async_file_sink::run() {
+    std::uint64_t tail = tail_.load(std::memory_order_relaxed);
+    while (true) {
+        const std::uint64_t head = head_.load(std::memory_order_acquire);
+        if (head == tail) {
+            if (stopping_.load()) {
+                return;
+            }
+            idle_.store(true);
+            const std::uint32_t wake = wake_.load();
+            if (head_.load() == tail && !stopping_.load()) {
+                wake_.wait(wake);
+            }
+            idle_.store(false);
+            continue;
+        }
+        const std::uint64_t end = std::min(head, tail + k_batch_lines);
+        write_batch(tail, end);
+        tail = end;
+        tail_.store(tail, std::memory_order_release);
+        tail_.notify_all();
+    }
+}
+
+void async_file_sink::write_batch(std::uint64_t from, std::uint64_t to) {
+#if MUESLI_BT_HAVE_WRITEV
+    if (fd_ < 0) {
+        dropped_.fetch_add(to - from, std::memory_order_relaxed);
+        return;
+    }
+    static constexpr char newline = '\n';
+    iovec iov[2 * k_batch_lines];
+    int count = 0;
+    for (std::uint64_t i = from; i < to; ++i) {
+        const std::string& line = slots_[i & mask_];
+        iov[count++] = iovec{const_cast<char*>(line.data()), line.size()};
+        iov[count++] = iovec{const_cast<char*>(&newline), 1};
+    }
+
+    // writev may stop part-way through an entry; resume from the first unfinished one.
+    iovec* next = iov;
+    while (count > 0) {
+        const ssize_t written = ::writev(fd_, next, count);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // Count the lines whose newline has not been written yet.
+            std::uint64_t lost = 0;
+            for (int i = 0; i < count; ++i) {
+                if (next[i].iov_base == &newline) {
+                    ++lost;
+                }
+            }
+            dropped_.fetch_add(lost, std::memory_order_relaxed);
+            return;
+        }
+        std::size_t remaining = static_cast<std::size_t>(written);
+        while (count > 0 && remaining >= next->iov_len) {
+            remaining -= next->iov_len;
+            ++next;
+            --count;
+        }
+        if (count > 0) {
+            next->iov_base = static_cast<char*>(next->iov_base) + remaining;
+            next->iov_len -= remaining;
+        }
+    }
+#else
+    dropped_.fetch_add(to - from, std::memory_order_relaxed);
+#endif
+}
+
+}  // namespace bt
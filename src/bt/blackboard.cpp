@@ -1,48 +1,579 @@
 #include "bt/blackboard.hpp"
 
+#include "bt/memory_footprint.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <optional>
 #include <sstream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
 
 namespace bt {
 
+bb_vector::bb_vector(std::initializer_list<double> values) : bb_vector(std::span<const double>(values.begin(), values.size())) {}
+
+bb_vector::bb_vector(std::span<const double> values) : size_(values.size()) {
+    if (values.size() <= inline_capacity) {
+        std::copy(values.begin(), values.end(), inline_.begin());
+    } else {
+        shared_ = std::make_shared<const std::vector<double>>(values.begin(), values.end());
+    }
+}
+
+bb_vector::bb_vector(const std::vector<double>& values) : bb_vector(std::span<const double>(values)) {}
+
+bb_vector::bb_vector(std::vector<double>&& values) : size_(values.size()) {
+    if (values.size() <= inline_capacity) {
+        std::copy(values.begin(), values.end(), inline_.begin());
+    } else {
+        shared_ = std::make_shared<const std::vector<double>>(std::move(values));
+    }
+}
+
+bool operator==(const bb_vector& a, const bb_vector& b) noexcept {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end());
+}
+
+namespace {
+
+std::optional<double> numeric_value(const bb_value& value) noexcept {
+    if (const auto* i = std::get_if<std::int64_t>(&value)) {
+        return static_cast<double>(*i);
+    }
+    if (const auto* d = std::get_if<double>(&value)) {
+        return *d;
+    }
+    return std::nullopt;
+}
+
+// Value equality for change detection; handles compare by id and NaN never equals itself.
+bool same_value(const bb_value& a, const bb_value& b) noexcept {
+    if (a.index() != b.index()) {
+        return false;
+    }
+    return std::visit(
+        [&b](const auto& x) {
+            using T = std::decay_t<decltype(x)>;
+            const T& y = std::get<T>(b);
+            if constexpr (std::is_same_v<T, std::monostate>) {
+                return true;
+            } else if constexpr (std::is_same_v<T, image_handle_ref> || std::is_same_v<T, blob_handle_ref>) {
+                return x.id == y.id;
+            } else {
+                return x == y;
+            }
+        },
+        a);
+}
+
+// True when `owner` is the only reference, with the acquire a release by the last other owner
+// needs before this one writes in place.
+template <typename T>
+bool sole_owner(const std::shared_ptr<T>& owner) noexcept {
+    if (owner.use_count() != 1) {
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return true;
+}
+
+}  // namespace
+
+void bb_history::seq_queue::push_back(std::uint64_t seq) noexcept {
+    items[(head + length) % items.size()] = seq;
+    ++length;
+}
+
+void bb_history::seq_queue::pop_front() noexcept {
+    head = head + 1 == items.size() ? 0 : head + 1;
+    --length;
+}
+
+bb_history::bb_history(std::size_t capacity) {
+    if (capacity == 0) {
+        throw std::invalid_argument("bb_history: capacity must be positive");
+    }
+    samples_.resize(capacity);
+    numbers_.assign(capacity, 0.0);
+    numeric_.assign(capacity, 0u);
+    min_queue_.items.assign(capacity, 0u);
+    max_queue_.items.assign(capacity, 0u);
+}
+
+void bb_history::push(std::uint64_t tick, std::chrono::steady_clock::time_point ts, const bb_value& value) {
+    const std::size_t cap = samples_.size();
+    if (size_ == cap) {
+        const std::uint64_t evicted = pushes_ - cap;
+        if (numeric_[index_of(evicted)] != 0u) {
+            sum_ -= numbers_[index_of(evicted)];
+            --numeric_count_;
+        }
+        if (!min_queue_.empty() && min_queue_.front() == evicted) {
+            min_queue_.pop_front();
+        }
+        if (!max_queue_.empty() && max_queue_.front() == evicted) {
+            max_queue_.pop_front();
+        }
+    } else {
+        ++size_;
+    }
+
+    const std::uint64_t seq = pushes_++;
+    const std::size_t at = index_of(seq);
+    bb_history_sample& sample = samples_[at];
+    sample.tick = tick;
+    sample.ts = ts;
+    sample.value = value;
+    const std::optional<double> number = numeric_value(value);
+    numeric_[at] = number.has_value() ? 1u : 0u;
+    numbers_[at] = number.value_or(0.0);
+    if (number) {
+        sum_ += *number;
+        ++numeric_count_;
+        while (!min_queue_.empty() && numbers_[index_of(min_queue_.back())] >= *number) {
+            min_queue_.pop_back();
+        }
+        min_queue_.push_back(seq);
+        while (!max_queue_.empty() && numbers_[index_of(max_queue_.back())] <= *number) {
+            max_queue_.pop_back();
+        }
+        max_queue_.push_back(seq);
+    }
+
+    if (pushes_ % cap == 0) {
+        sum_ = 0.0;
+        for (std::size_t i = 0; i < size_; ++i) {
+            sum_ += numeric_[i] != 0u ? numbers_[i] : 0.0;
+        }
+    }
+}
+
+void bb_history::clear() noexcept {
+    size_ = 0;
+    pushes_ = 0;
+    numeric_count_ = 0;
+    sum_ = 0.0;
+    min_queue_.clear();
+    max_queue_.clear();
+}
+
+const bb_history_sample& bb_history::recent(std::size_t age) const noexcept {
+    return samples_[index_of(pushes_ - 1 - age)];
+}
+
+const bb_history_sample* bb_history::at_tick(std::uint64_t tick) const noexcept {
+    // Smallest age whose tick is at or before `tick`.
+    std::size_t lo = 0;
+    std::size_t hi = size_;
+    while (lo < hi) {
+        const std::size_t mid = lo + (hi - lo) / 2;
+        if (recent(mid).tick <= tick) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo < size_ ? &recent(lo) : nullptr;
+}
+
+bb_window_stats bb_history::window(std::size_t k) const noexcept {
+    bb_window_stats out;
+    if (k == 0 || k >= size_) {
+        out.count = numeric_count_;
+        out.sum = sum_;
+        if (numeric_count_ > 0) {
+            out.min = numbers_[index_of(min_queue_.front())];
+            out.max = numbers_[index_of(max_queue_.front())];
+        }
+        return out;
+    }
+    for (std::size_t age = 0; age < k; ++age) {
+        const std::size_t at = index_of(pushes_ - 1 - age);
+        if (numeric_[at] == 0u) {
+            continue;
+        }
+        const double x = numbers_[at];
+        out.min = out.count == 0 ? x : std::min(out.min, x);
+        out.max = out.count == 0 ? x : std::max(out.max, x);
+        out.sum += x;
+        ++out.count;
+    }
+    return out;
+}
+
+blackboard::~blackboard() {
+    release_handles();
+}
+
+blackboard& blackboard::operator=(blackboard&& other) noexcept {
+    if (this != &other) {
+        release_handles();
+        keys_ = std::move(other.keys_);
+        pages_ = std::move(other.pages_);
+        slot_count_ = std::exchange(other.slot_count_, 0);
+        write_count_ = std::exchange(other.write_count_, 0);
+        journal_ = std::move(other.journal_);
+        journaled_ = std::move(other.journaled_);
+        histories_ = std::move(other.histories_);
+        handle_refs_ = std::move(other.handle_refs_);
+        waker_ = std::move(other.waker_);
+        watched_ = std::move(other.watched_);
+        watch_all_ = std::exchange(other.watch_all_, false);
+    }
+    return *this;
+}
+
+void blackboard::set_handle_refs(std::shared_ptr<vla_handle_refs> refs) {
+    if (refs == handle_refs_) {
+        return;
+    }
+    release_handles();
+    handle_refs_ = std::move(refs);
+    if (!handle_refs_) {
+        return;
+    }
+    for (bb_slot slot = 0; slot < slot_count_; ++slot) {
+        if (const slot_data& data = slot_ref(slot); data.present) {
+            retain_handle(data.entry.value);
+        }
+    }
+}
+
+blackboard blackboard::fork() const {
+    blackboard out;
+    out.keys_ = keys_;
+    out.pages_ = pages_;
+    out.slot_count_ = slot_count_;
+    out.write_count_ = write_count_;
+    out.journaled_.assign(slot_count_, 0u);
+    out.histories_ = histories_;
+    out.set_handle_refs(handle_refs_);
+    return out;
+}
+
+bb_read_view blackboard::read_view(std::span<const bb_slot> slots) const {
+    bb_read_view out;
+    out.keys_ = keys_;
+    out.write_count_ = write_count_;
+    out.slots_.reserve(slots.size());
+    for (const bb_slot slot : slots) {
+        if (slot < slot_count_) {
+            out.slots_.push_back({slot, pages_[slot / k_page_slots]});
+        }
+    }
+    std::sort(out.slots_.begin(), out.slots_.end(), [](const auto& a, const auto& b) { return a.slot < b.slot; });
+    out.slots_.erase(std::unique(out.slots_.begin(),
+                                 out.slots_.end(),
+                                 [](const auto& a, const auto& b) { return a.slot == b.slot; }),
+                     out.slots_.end());
+    return out;
+}
+
+bb_read_view blackboard::read_view(std::span<const std::string_view> keys) const {
+    std::vector<bb_slot> slots;
+    slots.reserve(keys.size());
+    for (const std::string_view key : keys) {
+        if (const bb_slot slot = find_slot(key); slot != kNoBbSlot) {
+            slots.push_back(slot);
+        }
+    }
+    return read_view(slots);
+}
+
 bool blackboard::has(std::string_view key) const {
-    return map_.find(std::string(key)) != map_.end();
+    return has(find_slot(key));
 }
 
 const bb_entry* blackboard::get(std::string_view key) const {
-    const auto it = map_.find(std::string(key));
-    return it == map_.end() ? nullptr : &it->second;
+    return get(find_slot(key));
 }
 
 bb_entry* blackboard::get_mut(std::string_view key) {
-    const auto it = map_.find(std::string(key));
-    return it == map_.end() ? nullptr : &it->second;
+    return get_mut(find_slot(key));
 }
 
-void blackboard::put(std::string key,
+void blackboard::put(std::string_view key,
                      bb_value value,
                      std::uint64_t tick,
                      std::chrono::steady_clock::time_point ts,
                      node_id writer_node,
-                     std::string writer_name) {
-    bb_entry& entry = map_[std::move(key)];
+                     std::string_view writer_name) {
+    (void)put(intern(key), std::move(value), tick, ts, writer_node, writer_name);
+}
+
+bb_slot blackboard::intern(std::string_view key) {
+    if (const bb_slot found = find_slot(key); found != kNoBbSlot) {
+        return found;
+    }
+    if (!keys_) {
+        keys_ = std::make_shared<key_table>();
+    } else if (!sole_owner(keys_)) {
+        auto copy = std::make_shared<key_table>();
+        copy->names = keys_->names;
+        for (bb_slot slot = 0; slot < copy->names.size(); ++slot) {
+            copy->index.emplace(std::string_view(copy->names[slot]), slot);
+        }
+        keys_ = std::move(copy);
+    }
+    const auto slot = static_cast<bb_slot>(slot_count_++);
+    const std::string& name = keys_->names.emplace_back(key);
+    keys_->index.emplace(std::string_view(name), slot);
+    if (slot % k_page_slots == 0) {
+        pages_.push_back(std::make_shared<page>());
+    }
+    journaled_.push_back(0u);
+    return slot;
+}
+
+bb_slot blackboard::find_slot(std::string_view key) const {
+    if (!keys_) {
+        return kNoBbSlot;
+    }
+    const auto it = keys_->index.find(key);
+    return it == keys_->index.end() ? kNoBbSlot : it->second;
+}
+
+const std::string& blackboard::key_name(bb_slot slot) const {
+    if (slot >= slot_count_) {
+        throw std::out_of_range("blackboard::key_name: slot out of range");
+    }
+    return keys_->names[slot];
+}
+
+bool blackboard::has(bb_slot slot) const {
+    return slot < slot_count_ && slot_ref(slot).present;
+}
+
+const bb_entry* blackboard::get(bb_slot slot) const {
+    return has(slot) ? &slot_ref(slot).entry : nullptr;
+}
+
+bb_entry* blackboard::get_mut(bb_slot slot) {
+    if (!has(slot)) {
+        return nullptr;
+    }
+    slot_data& data = writable_slot(slot);
+    stamp(data, slot, ++write_count_);
+    // The caller may change the entry in place, so this counts as a change without comparing.
+    if (watched(slot)) {
+        waker_->notify(wake_reason::bb_write);
+    }
+    return &data.entry;
+}
+
+bb_entry& blackboard::put(bb_slot slot,
+                          bb_value value,
+                          std::uint64_t tick,
+                          std::chrono::steady_clock::time_point ts,
+                          node_id writer_node,
+                          std::string_view writer_name) {
+    if (slot >= slot_count_) {
+        throw std::out_of_range("blackboard::put: slot out of range");
+    }
+    slot_data& data = writable_slot(slot);
+    if (watched(slot) && (!data.present || !same_value(data.entry.value, value))) {
+        waker_->notify(wake_reason::bb_write);
+    }
+    if (handle_refs_) {
+        // Retained first, so rewriting the same handle never drops its last reference.
+        retain_handle(value);
+        if (data.present) {
+            release_handle(data.entry.value);
+        }
+    }
+    data.present = true;
+    stamp(data, slot, ++write_count_);
+    bb_entry& entry = data.entry;
     entry.value = std::move(value);
     entry.last_write_tick = tick;
     entry.last_write_ts = ts;
     entry.last_writer_node_id = writer_node;
-    entry.last_writer_name = std::move(writer_name);
+    entry.last_writer_name.assign(writer_name);
+    if (slot < histories_.size() && histories_[slot]) {
+        std::shared_ptr<bb_history>& history = histories_[slot];
+        if (!sole_owner(history)) {
+            history = std::make_shared<bb_history>(*history);
+        }
+        history->push(tick, ts, entry.value);
+    }
+    return entry;
+}
+
+void blackboard::set_history(bb_slot slot, std::size_t capacity) {
+    if (slot >= slot_count_) {
+        throw std::out_of_range("blackboard::set_history: slot out of range");
+    }
+    if (capacity == 0) {
+        if (slot < histories_.size()) {
+            histories_[slot].reset();
+        }
+        return;
+    }
+    if (histories_.size() < slot_count_) {
+        histories_.resize(slot_count_);
+    }
+    histories_[slot] = std::make_shared<bb_history>(capacity);
 }
 
 std::vector<std::pair<std::string, bb_entry>> blackboard::snapshot() const {
     std::vector<std::pair<std::string, bb_entry>> out;
-    out.reserve(map_.size());
-    for (const auto& [key, entry] : map_) {
-        out.emplace_back(key, entry);
+    for (bb_slot slot = 0; slot < slot_count_; ++slot) {
+        const slot_data& data = slot_ref(slot);
+        if (data.present) {
+            out.emplace_back(keys_->names[slot], data.entry);
+        }
     }
     return out;
 }
 
 void blackboard::clear() {
-    map_.clear();
+    release_handles();
+    const std::uint64_t version = ++write_count_;
+    for (std::shared_ptr<page>& p : pages_) {
+        // A shared page is replaced rather than copied, since every entry in it is dropped.
+        if (!sole_owner(p)) {
+            p = std::make_shared<page>();
+        }
+    }
+    for (bb_slot slot = 0; slot < slot_count_; ++slot) {
+        slot_data& data = pages_[slot / k_page_slots]->slots[slot % k_page_slots];
+        if (data.present && watched(slot)) {
+            waker_->notify(wake_reason::bb_write);
+        }
+        data.present = false;
+        data.entry = bb_entry{};
+        stamp(data, slot, version);
+    }
+    for (std::shared_ptr<bb_history>& history : histories_) {
+        if (!history) {
+            continue;
+        }
+        if (sole_owner(history)) {
+            history->clear();
+        } else {
+            history = std::make_shared<bb_history>(history->capacity());
+        }
+    }
+}
+
+std::size_t blackboard::memory_bytes() const noexcept {
+    std::size_t bytes = vector_heap_bytes(pages_) + pages_.size() * sizeof(page) + vector_heap_bytes(journal_) +
+                        vector_heap_bytes(journaled_) + vector_heap_bytes(histories_) + vector_heap_bytes(watched_);
+    for (bb_slot slot = 0; slot < slot_count_; ++slot) {
+        const slot_data& data = slot_ref(slot);
+        if (!data.present) {
+            continue;
+        }
+        bytes += string_heap_bytes(data.entry.last_writer_name);
+        if (const auto* text = std::get_if<std::string>(&data.entry.value)) {
+            bytes += string_heap_bytes(*text);
+        } else if (const auto* vec = std::get_if<bb_vector>(&data.entry.value); vec && !vec->is_inline()) {
+            bytes += sizeof(std::vector<double>) + vec->size() * sizeof(double);
+        }
+    }
+    if (keys_) {
+        bytes += sizeof(key_table) + hash_heap_bytes(keys_->index) + keys_->names.size() * sizeof(std::string);
+        for (const std::string& name : keys_->names) {
+            bytes += string_heap_bytes(name);
+        }
+    }
+    for (const std::shared_ptr<bb_history>& history : histories_) {
+        if (history) {
+            bytes += sizeof(bb_history) + history->capacity() * (sizeof(bb_history_sample) + sizeof(double) + 1 +
+                                                                 2 * sizeof(std::uint64_t));
+        }
+    }
+    return bytes;
+}
+
+void blackboard::watch(std::shared_ptr<tick_waker> waker, std::span<const bb_slot> slots, bool all_slots) {
+    waker_ = std::move(waker);
+    watch_all_ = all_slots;
+    watched_.assign(slot_count_, 0u);
+    for (const bb_slot slot : slots) {
+        if (slot < slot_count_) {
+            watched_[slot] = 1u;
+        }
+    }
+}
+
+void blackboard::reset_journal() noexcept {
+    for (const bb_slot slot : journal_) {
+        journaled_[slot] = 0u;
+    }
+    journal_.clear();
+}
+
+blackboard::slot_data& blackboard::writable_slot(bb_slot slot) {
+    std::shared_ptr<page>& p = pages_[slot / k_page_slots];
+    if (!sole_owner(p)) {
+        p = std::make_shared<page>(*p);
+    }
+    return p->slots[slot % k_page_slots];
+}
+
+void blackboard::retain_handle(const bb_value& value) const {
+    if (const auto* image = std::get_if<image_handle_ref>(&value)) {
+        (void)handle_refs_->retain_image(*image);
+    } else if (const auto* blob = std::get_if<blob_handle_ref>(&value)) {
+        (void)handle_refs_->retain_blob(*blob);
+    }
+}
+
+void blackboard::release_handle(const bb_value& value) const {
+    if (const auto* image = std::get_if<image_handle_ref>(&value)) {
+        (void)handle_refs_->release_image(*image);
+    } else if (const auto* blob = std::get_if<blob_handle_ref>(&value)) {
+        (void)handle_refs_->release_blob(*blob);
+    }
+}
+
+void blackboard::release_handles() const noexcept {
+    if (!handle_refs_) {
+        return;
+    }
+    for (bb_slot slot = 0; slot < slot_count_; ++slot) {
+        if (const slot_data& data = slot_ref(slot); data.present) {
+            release_handle(data.entry.value);
+        }
+    }
+}
+
+void blackboard::stamp(slot_data& data, bb_slot slot, std::uint64_t version) {
+    data.version = version;
+    if (journaled_[slot] == 0u) {
+        journaled_[slot] = 1u;
+        journal_.push_back(slot);
+    }
+}
+
+const bb_entry* bb_read_view::get(std::string_view key) const {
+    if (!keys_) {
+        return nullptr;
+    }
+    const auto it = keys_->index.find(key);
+    return it == keys_->index.end() ? nullptr : get(it->second);
+}
+
+const bb_entry* bb_read_view::get(bb_slot slot) const {
+    const blackboard::slot_data* data = find(slot);
+    return data && data->present ? &data->entry : nullptr;
+}
+
+std::uint64_t bb_read_view::write_version(bb_slot slot) const noexcept {
+    const blackboard::slot_data* data = find(slot);
+    return data ? data->version : 0;
+}
+
+const blackboard::slot_data* bb_read_view::find(bb_slot slot) const noexcept {
+    const auto it =
+        std::lower_bound(slots_.begin(), slots_.end(), slot, [](const slot_ref& ref, bb_slot s) { return ref.slot < s; });
+    if (it == slots_.end() || it->slot != slot) {
+        return nullptr;
+    }
+    return &it->page->slots[slot % blackboard::k_page_slots];
 }
 
 std::string bb_value_repr(const bb_value& value) {
@@ -59,7 +590,7 @@ std::string bb_value_repr(const bb_value& value) {
                 std::ostringstream out;
                 out << v;
                 return out.str();
-            } else if constexpr (std::is_same_v<T, std::vector<double>>) {
+            } else if constexpr (std::is_same_v<T, bb_vector>) {
                 std::ostringstream out;
                 out << '[';
                 for (std::size_t i = 0; i < v.size(); ++i) {
@@ -0,0 +1,273 @@
+#include "bt/compiled_tree.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace bt {
+namespace {
+
+struct compiled_tree_table {
+    std::mutex mutex;
+    std::unordered_map<std::uint64_t, std::shared_ptr<const compiled_tree>> trees;
+};
+
+compiled_tree_table& compiled_trees() {
+    static compiled_tree_table table;
+    return table;
+}
+
+bool is_identifier(std::string_view name) noexcept {
+    const auto alpha = [](char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_'; };
+    const auto digit = [](char c) { return c >= '0' && c <= '9'; };
+    return !name.empty() && alpha(name.front()) &&
+           std::all_of(name.begin(), name.end(), [&](char c) { return alpha(c) || digit(c); });
+}
+
+const char* status_literal(status st) noexcept {
+    switch (st) {
+        case status::success:
+            return "bt::status::success";
+        case status::failure:
+            return "bt::status::failure";
+        case status::running:
+            return "bt::status::running";
+    }
+    return "bt::status::failure";
+}
+
+// Node kind and leaf name for the line comment after a visit, with anything unprintable replaced.
+std::string node_comment(const node& n) {
+    std::string text = node_kind_name(n.kind);
+    if (!n.leaf_name.empty()) {
+        text.push_back(' ');
+        for (const char c : n.leaf_name) {
+            text.push_back(c >= ' ' && c <= '~' ? c : '?');
+        }
+    }
+    return text;
+}
+
+std::string label(std::uint32_t pc, std::uint32_t code_size) {
+    return pc == code_size ? std::string("done") : "pc_" + std::to_string(pc);
+}
+
+class cpp_emitter {
+public:
+    cpp_emitter(const definition& def, std::string_view name) : def_(def), name_(name), program_(compile_tick_program(def)) {
+        code_size_ = static_cast<std::uint32_t>(program_.code.size());
+        targeted_.assign(code_size_ + 1u, false);
+        for (const tick_instr& in : program_.code) {
+            switch (in.op) {
+                case tick_op::jump_unless:
+                case tick_op::repeat_check:
+                case tick_op::mem_seq_step:
+                case tick_op::mem_sel_step:
+                    targeted_[in.target] = true;
+                    break;
+                case tick_op::mem_dispatch:
+                    targeted_[in.target] = true;
+                    for (std::size_t i = 0; i < def_.nodes[in.node].children.size(); ++i) {
+                        targeted_[program_.jump_tables[in.aux + i]] = true;
+                    }
+                    break;
+                case tick_op::guard_dispatch: {
+                    const std::vector<std::uint32_t>& pcs = program_.guard_tables[in.aux].child_pcs;
+                    for (std::size_t i = 1; i < pcs.size(); ++i) {
+                        targeted_[pcs[i]] = true;
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+    }
+
+    std::string emit() {
+        char fingerprint[24];
+        std::snprintf(fingerprint,
+                      sizeof(fingerprint),
+                      "0x%016llxull",
+                      static_cast<unsigned long long>(tick_program_fingerprint(program_)));
+        const std::string cls = name_ + "_compiled_tree";
+
+        out_ += "// Generated from a BT definition by muslisp --emit-cpp; do not edit.\n";
+        out_ += "// Every definition whose tick program has fingerprint " + std::string(fingerprint) + " runs this code.\n";
+        out_ += "#include <cstdint>\n#include <memory>\n#include <string_view>\n\n#include \"bt/compiled_tree.hpp\"\n\n";
+        out_ += "namespace {\n\n";
+        out_ += "class " + cls + " final : public bt::compiled_tree {\n";
+        out_ += "public:\n";
+        out_ += "    [[nodiscard]] std::uint64_t fingerprint() const noexcept override { return " + std::string(fingerprint) + "; }\n";
+        out_ += "    [[nodiscard]] std::string_view name() const noexcept override { return \"" + name_ + "\"; }\n\n";
+        out_ += "    bt::status run(bt::tick_program_kernel& k) const override {\n";
+        for (std::uint32_t pc = 0; pc < code_size_; ++pc) {
+            if (targeted_[pc]) {
+                out_ += "    " + label(pc, code_size_) + ":\n";
+            }
+            emit_instr(program_.code[pc]);
+        }
+        if (targeted_[code_size_]) {
+            out_ += "    done:\n";
+        }
+        out_ += "        return k.st;\n";
+        out_ += "    }\n";
+        out_ += "};\n\n";
+        out_ += "}  // namespace\n\n";
+        out_ += "std::shared_ptr<const bt::compiled_tree> make_" + cls + "() {\n";
+        out_ += "    return std::make_shared<const " + cls + ">();\n";
+        out_ += "}\n\n";
+        out_ += "namespace {\n\n";
+        out_ += "[[maybe_unused]] const bool " + name_ + "_registered = [] {\n";
+        out_ += "    bt::register_compiled_tree(make_" + cls + "());\n";
+        out_ += "    return true;\n";
+        out_ += "}();\n\n";
+        out_ += "}  // namespace\n";
+        return std::move(out_);
+    }
+
+private:
+    void line(const std::string& text) { out_ += "        " + text + "\n"; }
+
+    void visit(const std::string& call, const node& n) { line(call + "  // " + node_comment(n)); }
+
+    std::string go(std::uint32_t target) const { return "goto " + label(target, code_size_) + ";"; }
+
+    void emit_instr(const tick_instr& in) {
+        const node& n = def_.nodes[in.node];
+        const std::string id = std::to_string(in.node);
+        switch (in.op) {
+            case tick_op::enter:
+                visit("k.enter(" + id + ");", n);
+                return;
+            case tick_op::exit:
+                line("k.exit(" + id + ");");
+                return;
+            case tick_op::leaf:
+                switch (n.kind) {
+                    case node_kind::cond:
+                        visit("k.condition(" + id + ");", n);
+                        return;
+                    case node_kind::act:
+                        visit("k.action(" + id + ");", n);
+                        return;
+                    case node_kind::succeed:
+                        visit("k.constant(" + id + ", bt::status::success);", n);
+                        return;
+                    case node_kind::running:
+                        visit("k.constant(" + id + ", bt::status::running);", n);
+                        return;
+                    default:
+                        visit("k.constant(" + id + ", bt::status::failure);", n);
+                        return;
+                }
+            case tick_op::subtree:
+                visit("k.subtree(" + id + ");", n);
+                return;
+            case tick_op::set_status:
+                line("k.st = " + std::string(status_literal(in.value)) + ";");
+                return;
+            case tick_op::jump_unless:
+                line("if (k.st != " + std::string(status_literal(in.value)) + ") " + go(in.target));
+                return;
+            case tick_op::invert:
+                line("k.invert();");
+                return;
+            case tick_op::touch_memory:
+                line("k.touch_memory(" + id + ");");
+                return;
+            case tick_op::repeat_check:
+                line("if (k.repeat_check(" + id + ")) " + go(in.target));
+                return;
+            case tick_op::repeat_step:
+                line("k.repeat_step(" + id + ");");
+                return;
+            case tick_op::retry_step:
+                line("k.retry_step(" + id + ");");
+                return;
+            case tick_op::mem_dispatch:
+                line("switch (k.mem_child(" + id + ")) {");
+                for (std::size_t i = 0; i < n.children.size(); ++i) {
+                    line("    case " + std::to_string(i) + ": " + go(program_.jump_tables[in.aux + i]));
+                }
+                line("    default: " + go(in.target));
+                line("}");
+                return;
+            case tick_op::mem_seq_step:
+                line("if (k.mem_seq_step(" + id + ", " + std::to_string(in.aux) + ")) " + go(in.target));
+                return;
+            case tick_op::mem_sel_step:
+                line("if (k.mem_sel_step(" + id + ", " + std::to_string(in.aux) + ")) " + go(in.target));
+                return;
+            case tick_op::mem_seq_done:
+                line("k.mem_seq_done(" + id + ");");
+                return;
+            case tick_op::mem_sel_done:
+                line("k.mem_sel_done(" + id + ");");
+                return;
+            case tick_op::guard_dispatch: {
+                const std::vector<std::uint32_t>& pcs = program_.guard_tables[in.aux].child_pcs;
+                line("switch (k.guard_dispatch(" + std::to_string(in.aux) + ")) {");
+                for (std::size_t i = 1; i < pcs.size(); ++i) {
+                    line("    case " + std::to_string(i) + ": " + go(pcs[i]));
+                }
+                line("    default: break;");
+                line("}");
+                return;
+            }
+        }
+    }
+
+    const definition& def_;
+    std::string name_;
+    tick_program program_;
+    std::uint32_t code_size_ = 0;
+    std::vector<bool> targeted_;
+    std::string out_;
+};
+
+}  // namespace
+
+void register_compiled_tree(std::shared_ptr<const compiled_tree> tree) {
+    if (!tree) {
+        throw std::invalid_argument("register_compiled_tree: tree is null");
+    }
+    compiled_tree_table& table = compiled_trees();
+    const std::lock_guard<std::mutex> lock(table.mutex);
+    table.trees[tree->fingerprint()] = std::move(tree);
+}
+
+std::shared_ptr<const compiled_tree> find_compiled_tree(std::uint64_t fingerprint) {
+    compiled_tree_table& table = compiled_trees();
+    const std::lock_guard<std::mutex> lock(table.mutex);
+    const auto found = table.trees.find(fingerprint);
+    return found == table.trees.end() ? nullptr : found->second;
+}
+
+std::string emit_compiled_tree_cpp(const definition& def, std::string_view name) {
+    if (!is_identifier(name)) {
+        throw bt_compile_error("compiled tree name must be a C identifier: " + std::string(name));
+    }
+    if (def.root >= def.nodes.size()) {
+        throw bt_compile_error("compiled tree: definition has no root node");
+    }
+    return cpp_emitter(def, name).emit();
+}
+
+void emit_compiled_tree_file(const definition& def, std::string_view name, const std::string& path) {
+    const std::string text = emit_compiled_tree_cpp(def, name);
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        throw std::runtime_error("failed to open file: " + path);
+    }
+    out << text;
+    if (!out) {
+        throw std::runtime_error("failed to write file: " + path);
+    }
+}
+
+}  // namespace bt
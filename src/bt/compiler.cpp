@@ -1,8 +1,19 @@
 #include "bt/compiler.hpp"
 
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <iomanip>
+#include <ios>
+#include <optional>
+#include <sstream>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
+#include "bt/compiled_tree.hpp"
+#include "bt/event_log.hpp"
 #include "muslisp/error.hpp"
 
 namespace bt {
@@ -52,6 +63,51 @@ public:
             return emit_node(std::move(n));
         }
 
+        if (form_name == "par") {
+            // (par success-threshold [failure-threshold] child ...); the failure threshold defaults to
+            // the failure count at which the success threshold can no longer be met.
+            std::size_t first_child = 2;
+            if (items.size() < 3 || !muslisp::is_integer(items[1])) {
+                throw bt_compile_error("par: expected a success threshold and at least one child");
+            }
+            const std::int64_t success_threshold = muslisp::integer_value(items[1]);
+            std::optional<std::int64_t> failure_threshold;
+            if (muslisp::is_integer(items[2])) {
+                failure_threshold = muslisp::integer_value(items[2]);
+                first_child = 3;
+            }
+            const std::size_t child_count = items.size() - first_child;
+            if (child_count == 0) {
+                throw bt_compile_error("par: expects at least one child");
+            }
+            if (child_count > kMaxParChildren) {
+                throw bt_compile_error("par: at most " + std::to_string(kMaxParChildren) + " children");
+            }
+            const auto children = static_cast<std::int64_t>(child_count);
+            if (success_threshold < 1 || success_threshold > children) {
+                throw bt_compile_error("par: success threshold must be between 1 and the child count");
+            }
+            if (!failure_threshold) {
+                failure_threshold = children - success_threshold + 1;
+            }
+            if (*failure_threshold < 1 || *failure_threshold > children) {
+                throw bt_compile_error("par: failure threshold must be between 1 and the child count");
+            }
+
+            node n;
+            n.kind = node_kind::par;
+            for (const std::int64_t threshold : {success_threshold, *failure_threshold}) {
+                arg_value arg;
+                arg.kind = arg_kind::integer;
+                arg.int_v = threshold;
+                n.args.push_back(std::move(arg));
+            }
+            for (std::size_t i = first_child; i < items.size(); ++i) {
+                n.children.push_back(compile_node(items[i]));
+            }
+            return emit_node(std::move(n));
+        }
+
         if (form_name == "invert") {
             require_arity(form_name, items, 2);
             node n;
@@ -126,7 +182,8 @@ public:
             return emit_node(std::move(n));
         }
 
-        if (form_name == "vla-request" || form_name == "vla-wait" || form_name == "vla-cancel") {
+        if (form_name == "vla-request" || form_name == "vla-wait" || form_name == "vla-cancel" ||
+            form_name == "vla-chunk") {
             if ((items.size() % 2u) == 0u) {
                 throw bt_compile_error(form_name + ": expected key/value pairs");
             }
@@ -135,6 +192,8 @@ public:
                 n.kind = node_kind::vla_request;
             } else if (form_name == "vla-wait") {
                 n.kind = node_kind::vla_wait;
+            } else if (form_name == "vla-chunk") {
+                n.kind = node_kind::vla_chunk;
             } else {
                 n.kind = node_kind::vla_cancel;
             }
@@ -212,12 +271,564 @@ private:
     std::vector<node> nodes_;
 };
 
+std::string normalize_option_key(std::string_view raw) {
+    if (!raw.empty() && raw.front() == ':') {
+        raw.remove_prefix(1);
+    }
+    std::string key(raw);
+    for (char& c : key) {
+        if (c == '-') {
+            c = '_';
+        }
+    }
+    return key;
+}
+
+bool is_text_arg(const arg_value& arg) noexcept {
+    return arg.kind == arg_kind::symbol || arg.kind == arg_kind::string;
+}
+
+class bb_key_table {
+public:
+    explicit bb_key_table(std::vector<std::string>& keys) : keys_(keys) {
+        keys_.clear();
+    }
+
+    bb_slot intern(const std::string& key) {
+        const auto [it, inserted] = index_.emplace(key, static_cast<bb_slot>(keys_.size()));
+        if (inserted) {
+            keys_.push_back(key);
+        }
+        return it->second;
+    }
+
+private:
+    std::vector<std::string>& keys_;
+    std::unordered_map<std::string, bb_slot> index_;
+};
+
 }  // namespace
 
+void index_blackboard_keys(definition& def) {
+    bb_key_table table(def.bb_keys);
+    for (node& n : def.nodes) {
+        n.state_key = kNoBbSlot;
+        switch (n.kind) {
+            case node_kind::cond:
+            case node_kind::act:
+                for (const arg_value& arg : n.args) {
+                    if (is_text_arg(arg)) {
+                        (void)table.intern(arg.text);
+                    }
+                }
+                break;
+            case node_kind::plan_action:
+            case node_kind::vla_request:
+            case node_kind::vla_wait:
+            case node_kind::vla_cancel:
+            case node_kind::vla_chunk: {
+                std::string state_key = "state";
+                bool has_action_key = false;
+                for (std::size_t i = 0; i + 1 < n.args.size(); i += 2) {
+                    if (!is_text_arg(n.args[i]) || !is_text_arg(n.args[i + 1])) {
+                        continue;
+                    }
+                    const std::string key = normalize_option_key(n.args[i].text);
+                    if (key == "state_key") {
+                        state_key = n.args[i + 1].text;
+                    } else if (key.size() > 4 && key.ends_with("_key")) {
+                        has_action_key = has_action_key || key == "action_key";
+                        (void)table.intern(n.args[i + 1].text);
+                    }
+                }
+                if (n.kind == node_kind::plan_action) {
+                    n.state_key = table.intern(state_key);
+                    if (!has_action_key) {
+                        (void)table.intern("action");
+                    }
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+namespace {
+
+// Mirrors muslisp's printer for the atoms a DSL arg can hold.
+void write_dsl_arg(std::string& out, const arg_value& arg) {
+    switch (arg.kind) {
+        case arg_kind::nil:
+            out += "nil";
+            return;
+        case arg_kind::boolean:
+            out += arg.bool_v ? "#t" : "#f";
+            return;
+        case arg_kind::integer:
+            out += std::to_string(arg.int_v);
+            return;
+        case arg_kind::floating: {
+            if (std::isnan(arg.float_v)) {
+                out += "nan";
+                return;
+            }
+            if (std::isinf(arg.float_v)) {
+                out += arg.float_v < 0.0 ? "-inf" : "inf";
+                return;
+            }
+            std::ostringstream text;
+            text.setf(std::ios::fmtflags(0), std::ios::floatfield);
+            text << std::setprecision(15) << arg.float_v;
+            const std::string digits = text.str();
+            out += digits;
+            if (digits.find_first_of(".eE") == std::string::npos) {
+                out += ".0";
+            }
+            return;
+        }
+        case arg_kind::symbol:
+            out += arg.text;
+            return;
+        case arg_kind::string:
+            out.push_back('"');
+            for (const char c : arg.text) {
+                switch (c) {
+                    case '\\':
+                        out += "\\\\";
+                        break;
+                    case '"':
+                        out += "\\\"";
+                        break;
+                    case '\n':
+                        out += "\\n";
+                        break;
+                    case '\t':
+                        out += "\\t";
+                        break;
+                    case '\r':
+                        out += "\\r";
+                        break;
+                    default:
+                        out.push_back(c);
+                        break;
+                }
+            }
+            out.push_back('"');
+            return;
+    }
+}
+
+void write_dsl_node(std::string& out, const definition& def, node_id id) {
+    const node& n = def.nodes.at(id);
+    out.push_back('(');
+    out += node_kind_name(n.kind);
+    if (n.kind == node_kind::repeat || n.kind == node_kind::retry) {
+        out.push_back(' ');
+        out += std::to_string(n.int_param);
+    }
+    if (n.kind == node_kind::cond || n.kind == node_kind::act) {
+        out.push_back(' ');
+        out += n.leaf_name;
+    }
+    for (const arg_value& arg : n.args) {
+        out.push_back(' ');
+        write_dsl_arg(out, arg);
+    }
+    for (const node_id child : n.children) {
+        out.push_back(' ');
+        write_dsl_node(out, def, child);
+    }
+    out.push_back(')');
+}
+
+class fnv1a_64 {
+public:
+    void bytes(const void* data, std::size_t size) noexcept {
+        const auto* p = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < size; ++i) {
+            hash_ ^= p[i];
+            hash_ *= 1099511628211ull;
+        }
+    }
+    template <typename T>
+    void scalar(T v) noexcept {
+        bytes(&v, sizeof(v));
+    }
+    void text(const std::string& s) noexcept {
+        scalar(s.size());
+        bytes(s.data(), s.size());
+    }
+    [[nodiscard]] std::uint64_t value() const noexcept { return hash_; }
+
+private:
+    std::uint64_t hash_ = 14695981039346656037ull;
+};
+
+bool same_arg(const arg_value& a, const arg_value& b) noexcept {
+    if (a.kind != b.kind) {
+        return false;
+    }
+    switch (a.kind) {
+        case arg_kind::nil:
+            return true;
+        case arg_kind::boolean:
+            return a.bool_v == b.bool_v;
+        case arg_kind::integer:
+            return a.int_v == b.int_v;
+        case arg_kind::floating:
+            return std::bit_cast<std::uint64_t>(a.float_v) == std::bit_cast<std::uint64_t>(b.float_v);
+        case arg_kind::symbol:
+        case arg_kind::string:
+            return a.text == b.text;
+    }
+    return false;
+}
+
+void hash_node(fnv1a_64& h, const definition& def, node_id id) {
+    const node& n = def.nodes.at(id);
+    h.scalar(static_cast<std::uint8_t>(n.kind));
+    h.scalar(n.int_param);
+    h.text(n.leaf_name);
+    h.scalar(n.args.size());
+    for (const arg_value& arg : n.args) {
+        h.scalar(static_cast<std::uint8_t>(arg.kind));
+        switch (arg.kind) {
+            case arg_kind::nil:
+                break;
+            case arg_kind::boolean:
+                h.scalar(arg.bool_v);
+                break;
+            case arg_kind::integer:
+                h.scalar(arg.int_v);
+                break;
+            case arg_kind::floating:
+                h.scalar(std::bit_cast<std::uint64_t>(arg.float_v));
+                break;
+            case arg_kind::symbol:
+            case arg_kind::string:
+                h.text(arg.text);
+                break;
+        }
+    }
+    h.scalar(n.children.size());
+    for (const node_id child : n.children) {
+        hash_node(h, def, child);
+    }
+}
+
+bool same_node(const definition& a, node_id a_id, const definition& b, node_id b_id) {
+    const node& x = a.nodes.at(a_id);
+    const node& y = b.nodes.at(b_id);
+    if (!same_node_label(x, y) || x.children.size() != y.children.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < x.children.size(); ++i) {
+        if (!same_node(a, x.children[i], b, y.children[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+bool same_node_label(const node& a, const node& b) {
+    if (a.kind != b.kind || a.int_param != b.int_param || a.leaf_name != b.leaf_name ||
+        a.args.size() != b.args.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < a.args.size(); ++i) {
+        if (!same_arg(a.args[i], b.args[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string write_canonical_dsl(const definition& def) {
+    std::string out;
+    out.reserve(def.nodes.size() * 24);
+    write_dsl_node(out, def, def.root);
+    return out;
+}
+
+void ensure_canonical_dsl(const definition& def) {
+    if (def.source_hash.empty() || !def.canonical_dsl_hash.empty()) {
+        return;
+    }
+    def.canonical_dsl = write_canonical_dsl(def);
+    def.canonical_dsl_hash = event_log::hash64_hex(def.canonical_dsl);
+}
+
+std::uint64_t structural_hash(const definition& def) {
+    fnv1a_64 h;
+    hash_node(h, def, def.root);
+    return h.value();
+}
+
+bool structurally_equal(const definition& a, const definition& b) {
+    return same_node(a, a.root, b, b.root);
+}
+
 definition compile_definition(muslisp::value form) {
     compiler_state state;
     node_id root = state.compile_node(form);
-    return state.finish(root);
+    definition def = state.finish(root);
+    index_blackboard_keys(def);
+    return def;
+}
+
+namespace {
+
+class tick_program_builder {
+public:
+    explicit tick_program_builder(const definition& def) : def_(def) {
+        program_.def = &def;
+        program_.code.reserve(def.nodes.size() * 3);
+    }
+
+    tick_program build() && {
+        emit_node(def_.root, 0);
+        return std::move(program_);
+    }
+
+private:
+    std::uint32_t pc() const { return static_cast<std::uint32_t>(program_.code.size()); }
+
+    std::uint32_t emit(tick_op op, node_id id, status value = status::failure) {
+        program_.code.push_back(tick_instr{.op = op, .value = value, .node = id, .target = 0, .aux = 0});
+        return pc() - 1;
+    }
+
+    void patch(const std::vector<std::uint32_t>& jumps, std::uint32_t target) {
+        for (const std::uint32_t at : jumps) {
+            program_.code[at].target = target;
+        }
+    }
+
+    void emit_node(node_id id, std::size_t depth) {
+        const node& n = def_.nodes.at(id);
+        switch (n.kind) {
+            case node_kind::cond:
+            case node_kind::act:
+            case node_kind::succeed:
+            case node_kind::fail:
+            case node_kind::running:
+                program_.max_depth = std::max(program_.max_depth, depth + 1);
+                (void)emit(tick_op::leaf, id);
+                return;
+            case node_kind::seq:
+            case node_kind::sel:
+            case node_kind::invert:
+            case node_kind::repeat:
+            case node_kind::retry:
+            case node_kind::mem_seq:
+            case node_kind::mem_sel:
+                break;
+            default:
+                (void)emit(tick_op::subtree, id);
+                return;
+        }
+
+        program_.max_depth = std::max(program_.max_depth, depth + 1);
+        (void)emit(tick_op::enter, id);
+        std::vector<std::uint32_t> to_exit;
+        std::optional<std::uint32_t> guard_table;
+        switch (n.kind) {
+            case node_kind::seq:
+            case node_kind::sel: {
+                const status keep_going = n.kind == node_kind::seq ? status::success : status::failure;
+                if (n.children.empty()) {
+                    (void)emit(tick_op::set_status, id, keep_going);
+                }
+                if (n.kind == node_kind::sel) {
+                    guard_table = build_guard_table(n);
+                }
+                if (guard_table) {
+                    const std::uint32_t dispatch = emit(tick_op::guard_dispatch, id);
+                    program_.code[dispatch].aux = *guard_table;
+                }
+                for (std::size_t i = 0; i < n.children.size(); ++i) {
+                    if (guard_table && i <= program_.guard_tables[*guard_table].guard_seqs.size()) {
+                        program_.guard_tables[*guard_table].child_pcs.push_back(pc());
+                    }
+                    emit_node(n.children[i], depth + 1);
+                    if (i + 1 < n.children.size()) {
+                        to_exit.push_back(emit(tick_op::jump_unless, id, keep_going));
+                    }
+                }
+                break;
+            }
+            case node_kind::invert:
+                emit_node(n.children.at(0), depth + 1);
+                (void)emit(tick_op::invert, id);
+                break;
+            case node_kind::repeat:
+                to_exit.push_back(emit(tick_op::repeat_check, id));
+                emit_node(n.children.at(0), depth + 1);
+                (void)emit(tick_op::repeat_step, id);
+                break;
+            case node_kind::retry:
+                (void)emit(tick_op::touch_memory, id);
+                emit_node(n.children.at(0), depth + 1);
+                (void)emit(tick_op::retry_step, id);
+                break;
+            case node_kind::mem_seq:
+            case node_kind::mem_sel: {
+                const bool is_seq = n.kind == node_kind::mem_seq;
+                const std::uint32_t dispatch = emit(tick_op::mem_dispatch, id);
+                const auto table = static_cast<std::uint32_t>(program_.jump_tables.size());
+                program_.code[dispatch].aux = table;
+                program_.jump_tables.resize(program_.jump_tables.size() + n.children.size());
+                for (std::size_t i = 0; i < n.children.size(); ++i) {
+                    program_.jump_tables[table + i] = pc();
+                    emit_node(n.children[i], depth + 1);
+                    const std::uint32_t step = emit(is_seq ? tick_op::mem_seq_step : tick_op::mem_sel_step, id);
+                    program_.code[step].aux = static_cast<std::uint32_t>(i);
+                    to_exit.push_back(step);
+                }
+                program_.code[dispatch].target = pc();
+                (void)emit(is_seq ? tick_op::mem_seq_done : tick_op::mem_sel_done, id);
+                break;
+            }
+            default:
+                break;
+        }
+        patch(to_exit, pc());
+        if (guard_table && program_.guard_tables[*guard_table].guards_are_all_children) {
+            program_.guard_tables[*guard_table].child_pcs.push_back(pc());
+        }
+        (void)emit(tick_op::exit, id);
+    }
+
+    // Guard child `child` as `(seq (cond NAME key operand) ...)`: its seq and cond ids, or nullopt.
+    std::optional<std::pair<node_id, node_id>> guard_of(node_id child) const {
+        const node& seq = def_.nodes.at(child);
+        if (seq.kind != node_kind::seq || seq.children.empty()) {
+            return std::nullopt;
+        }
+        const node& cond = def_.nodes.at(seq.children[0]);
+        if (cond.kind != node_kind::cond || cond.args.size() != 2 || !is_text_arg(cond.args[0]) ||
+            cond.args[1].kind == arg_kind::nil) {
+            return std::nullopt;
+        }
+        return std::pair{seq.id, cond.id};
+    }
+
+    // Index into guard_tables of a new table for `sel`, or nullopt when fewer than k_min_guards leading
+    // children are guards on one condition name and key.
+    std::optional<std::uint32_t> build_guard_table(const node& sel) {
+        constexpr std::size_t k_min_guards = 4;
+        tick_guard_table table;
+        const node* first = nullptr;
+        for (const node_id child : sel.children) {
+            const auto guard = guard_of(child);
+            if (!guard) {
+                break;
+            }
+            const node& cond = def_.nodes[guard->second];
+            if (first && (cond.leaf_name != first->leaf_name || cond.args[0].text != first->args[0].text)) {
+                break;
+            }
+            first = first ? first : &cond;
+            table.guard_seqs.push_back(guard->first);
+            table.guard_conds.push_back(guard->second);
+        }
+        const std::size_t guards = table.guard_seqs.size();
+        if (guards < k_min_guards) {
+            return std::nullopt;
+        }
+        const auto key = std::find(def_.bb_keys.begin(), def_.bb_keys.end(), first->args[0].text);
+        if (key == def_.bb_keys.end()) {
+            return std::nullopt;
+        }
+        table.condition = first->leaf_name;
+        table.key_index = static_cast<std::uint32_t>(key - def_.bb_keys.begin());
+        table.guards_are_all_children = guards == sel.children.size();
+
+        const auto none = static_cast<std::uint32_t>(guards);
+        table.has_equality_cases = true;
+        table.bool_cases = {none, none};
+        bool thresholds_ok = true;
+        for (std::size_t i = 0; i < guards; ++i) {
+            const arg_value& operand = def_.nodes[table.guard_conds[i]].args[1];
+            const auto index = static_cast<std::uint32_t>(i);
+            switch (operand.kind) {
+                case arg_kind::integer:
+                    (void)table.int_cases.try_emplace(operand.int_v, index);
+                    break;
+                case arg_kind::boolean:
+                    table.bool_cases[operand.bool_v ? 1 : 0] = std::min(table.bool_cases[operand.bool_v ? 1 : 0], index);
+                    break;
+                case arg_kind::symbol:
+                case arg_kind::string:
+                    (void)table.text_cases.try_emplace(operand.text, index);
+                    break;
+                default:
+                    table.has_equality_cases = false;
+                    break;
+            }
+            const bool numeric = operand.kind == arg_kind::integer || operand.kind == arg_kind::floating;
+            const double threshold = operand.kind == arg_kind::integer ? static_cast<double>(operand.int_v) : operand.float_v;
+            if (!numeric || std::isnan(threshold) || (!table.thresholds.empty() && threshold < table.thresholds.back())) {
+                thresholds_ok = false;
+            } else if (thresholds_ok) {
+                table.thresholds.push_back(threshold);
+            }
+        }
+        if (!table.has_equality_cases) {
+            table.int_cases.clear();
+            table.text_cases.clear();
+        }
+        if (!thresholds_ok) {
+            table.thresholds.clear();
+        }
+        if (!table.has_equality_cases && table.thresholds.empty()) {
+            return std::nullopt;
+        }
+        program_.guard_tables.push_back(std::move(table));
+        return static_cast<std::uint32_t>(program_.guard_tables.size() - 1);
+    }
+
+    const definition& def_;
+    tick_program program_;
+};
+
+}  // namespace
+
+std::uint64_t tick_program_fingerprint(const tick_program& program) {
+    fnv1a_64 h;
+    h.scalar(program.code.size());
+    for (const tick_instr& in : program.code) {
+        h.scalar(static_cast<std::uint8_t>(in.op));
+        h.scalar(static_cast<std::uint8_t>(in.value));
+        h.scalar(in.node);
+        h.scalar(in.target);
+        h.scalar(in.aux);
+        if (in.op == tick_op::leaf) {
+            h.scalar(static_cast<std::uint8_t>(program.def->nodes[in.node].kind));
+        }
+    }
+    h.scalar(program.jump_tables.size());
+    for (const std::uint32_t target : program.jump_tables) {
+        h.scalar(target);
+    }
+    h.scalar(program.guard_tables.size());
+    for (const tick_guard_table& table : program.guard_tables) {
+        h.scalar(table.child_pcs.size());
+        for (const std::uint32_t target : table.child_pcs) {
+            h.scalar(target);
+        }
+    }
+    return h.value();
+}
+
+tick_program compile_tick_program(const definition& def) {
+    tick_program program = tick_program_builder(def).build();
+    program.native = find_compiled_tree(tick_program_fingerprint(program));
+    return program;
 }
 
 }  // namespace bt
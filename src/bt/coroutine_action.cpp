@@ -0,0 +1,204 @@
+#include "bt/coroutine_action.hpp"
+
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+
+#include "bt/instance.hpp"
+#include "bt/runtime.hpp"
+
+namespace bt {
+namespace {
+
+// Coroutine frames are pooled per thread in 64-byte size classes. Actions restart often (every time
+// their branch is re-entered) and their frames are small, so this keeps them off the heap.
+constexpr std::size_t k_frame_granule = 64;
+constexpr std::size_t k_max_pooled_frame = 2048;
+constexpr std::size_t k_frame_classes = k_max_pooled_frame / k_frame_granule;
+constexpr std::uint32_t k_max_free_frames_per_class = 64;
+
+struct free_frame {
+    free_frame* next = nullptr;
+};
+
+// Set once the thread's pool has been destroyed; frames freed after that (by other thread-locals'
+// destructors) go straight back to the heap.
+thread_local bool frame_pool_closed = false;
+
+struct frame_pool {
+    free_frame* heads[k_frame_classes]{};
+    std::uint32_t counts[k_frame_classes]{};
+
+    ~frame_pool() {
+        for (free_frame*& head : heads) {
+            while (head) {
+                ::operator delete(std::exchange(head, head->next));
+            }
+        }
+        frame_pool_closed = true;
+    }
+};
+
+frame_pool& thread_frame_pool() {
+    thread_local frame_pool pool;
+    return pool;
+}
+
+std::size_t frame_class(std::size_t size) noexcept {
+    return (size + k_frame_granule - 1) / k_frame_granule - 1;
+}
+
+}  // namespace
+
+void* action_task::promise_type::operator new(std::size_t size) {
+    if (size == 0 || size > k_max_pooled_frame || frame_pool_closed) {
+        return ::operator new(size);
+    }
+    const std::size_t cls = frame_class(size);
+    frame_pool& pool = thread_frame_pool();
+    if (free_frame* frame = pool.heads[cls]) {
+        pool.heads[cls] = frame->next;
+        --pool.counts[cls];
+        return frame;
+    }
+    return ::operator new((cls + 1) * k_frame_granule);
+}
+
+void action_task::promise_type::operator delete(void* frame, std::size_t size) noexcept {
+    if (size == 0 || size > k_max_pooled_frame || frame_pool_closed) {
+        ::operator delete(frame);
+        return;
+    }
+    const std::size_t cls = frame_class(size);
+    frame_pool& pool = thread_frame_pool();
+    if (pool.counts[cls] >= k_max_free_frames_per_class) {
+        ::operator delete(frame);
+        return;
+    }
+    pool.heads[cls] = ::new (frame) free_frame{pool.heads[cls]};
+    ++pool.counts[cls];
+}
+
+action_task& action_task::operator=(action_task&& other) noexcept {
+    if (this != &other) {
+        reset();
+        handle_ = std::exchange(other.handle_, {});
+    }
+    return *this;
+}
+
+void action_task::reset() noexcept {
+    if (handle_) {
+        std::exchange(handle_, {}).destroy();
+    }
+}
+
+status action_task::tick(tick_context& ctx) {
+    if (!handle_) {
+        throw std::logic_error("action_task::tick: no coroutine");
+    }
+    promise_type& promise = handle_.promise();
+    if (!promise.context_) {
+        reset();
+        throw std::logic_error("coroutine action does not take an action_context parameter");
+    }
+    if (promise.ready_) {
+        if (!promise.ready_(promise.awaiter_, ctx)) {
+            return status::running;
+        }
+        promise.ready_ = nullptr;
+        promise.awaiter_ = nullptr;
+    }
+
+    promise.context_->tick_ = &ctx;
+    handle_.resume();
+    promise.context_->tick_ = nullptr;
+    if (!handle_.done()) {
+        return status::running;
+    }
+
+    const std::exception_ptr error = std::move(promise.error_);
+    const status result = promise.result_;
+    reset();
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return result;
+}
+
+void next_tick::await_suspend(action_handle) noexcept {}
+
+void sleep_for::await_suspend(action_handle h) noexcept {
+    wake_at = h.promise().context().tick().now + delay;
+    h.promise().wait_on(this, [](void* self, tick_context& ctx) { return ctx.now >= static_cast<sleep_for*>(self)->wake_at; });
+}
+
+bool run_job::await_suspend(action_handle h) {
+    tick_context& ctx = h.promise().context().tick();
+    node = h.promise().context().node();
+    if (!ctx.svc.sched) {
+        outcome.status = job_status::failed;
+        outcome.error_text = "no scheduler";
+        return false;
+    }
+
+    job_request req = std::move(request);
+    request.task_name = req.task_name;
+    ctx.watch_job(req, node);
+    id = ctx.svc.sched->submit(std::move(req));
+
+    node_memory& mem = ctx.inst.memory[node];
+    mem.i0 = static_cast<std::int64_t>(id);
+    mem.b0 = true;
+    mem.i1 = static_cast<std::int64_t>(job_status::queued);
+    mem.job_notified = false;
+    ctx.scheduler_event(trace_event_kind::scheduler_submit, id, job_status::queued, "scheduler submitted task " + request.task_name);
+
+    h.promise().wait_on(this, [](void* self, tick_context& c) { return static_cast<run_job*>(self)->poll(c); });
+    return true;
+}
+
+bool run_job::poll(tick_context& ctx) {
+    node_memory& mem = ctx.inst.memory[node];
+    if (!mem.b0 || static_cast<job_id>(mem.i0) != id) {
+        outcome.status = job_status::cancelled;
+        return true;
+    }
+    if (!mem.job_notified) {
+        return false;
+    }
+    mem.job_notified = false;
+
+    const job_info info = ctx.svc.sched->get_info(id);
+    if (info.status != static_cast<job_status>(mem.i1)) {
+        if (info.status == job_status::running) {
+            ctx.scheduler_event(trace_event_kind::scheduler_start, id, info.status, "scheduler started task " + request.task_name);
+        } else if (info.status == job_status::cancelled) {
+            ctx.scheduler_event(trace_event_kind::scheduler_cancel, id, info.status, "scheduler cancelled task " + request.task_name);
+        } else if (info.status == job_status::done || info.status == job_status::failed) {
+            std::string message = "scheduler finished task " + request.task_name;
+            if (!info.error_text.empty()) {
+                message += ": ";
+                message += info.error_text;
+            }
+            ctx.scheduler_event(trace_event_kind::scheduler_finish, id, info.status, std::move(message));
+        }
+        mem.i1 = static_cast<std::int64_t>(info.status);
+    }
+    if (info.status == job_status::queued || info.status == job_status::running) {
+        return false;
+    }
+
+    // Scalars back to their initial state, so the node stops counting as live memory once it returns.
+    mem.b0 = false;
+    mem.i0 = 0;
+    mem.i1 = 0;
+    outcome.status = info.status;
+    outcome.error_text = info.error_text;
+    if (info.status == job_status::done) {
+        (void)ctx.svc.sched->take_result(id, outcome.result);
+    }
+    return true;
+}
+
+}  // namespace bt
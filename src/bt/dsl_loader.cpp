@@ -0,0 +1,72 @@
+#include "bt/dsl_loader.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include "bt/compiler.hpp"
+#include "bt/event_log.hpp"
+#include "muslisp/gc.hpp"
+#include "muslisp/reader.hpp"
+
+namespace bt {
+namespace {
+
+void compile_one(dsl_file_result& out) {
+    std::ifstream in(out.path, std::ios::binary);
+    if (!in) {
+        out.error = "failed to open file";
+        return;
+    }
+    std::ostringstream text;
+    text << in.rdbuf();
+    const std::string source = std::move(text).str();
+    out.source_hash = event_log::hash64_hex(source);
+    out.source_size = source.size();
+    try {
+        definition def = compile_definition(muslisp::read_one(source));
+        def.source_hash = out.source_hash;
+        out.def = std::move(def);
+    } catch (const std::exception& e) {
+        out.error = e.what();
+    }
+}
+
+}  // namespace
+
+std::vector<dsl_file_result> compile_dsl_files(std::span<const std::string> paths, std::size_t workers) {
+    std::vector<dsl_file_result> results(paths.size());
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        results[i].path = paths[i];
+    }
+    if (workers == 0) {
+        workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workers = std::min(workers, paths.size());
+
+    std::atomic<std::size_t> next{0};
+    const auto drain = [&] {
+        muslisp::gc heap;
+        muslisp::gc_thread_heap_scope heap_scope(heap);
+        for (std::size_t i = next.fetch_add(1); i < results.size(); i = next.fetch_add(1)) {
+            compile_one(results[i]);
+        }
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(workers > 0 ? workers - 1 : 0);
+    for (std::size_t i = 1; i < workers; ++i) {
+        threads.emplace_back(drain);
+    }
+    if (workers > 0) {
+        drain();
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    return results;
+}
+
+}  // namespace bt
@@ -0,0 +1,299 @@
+#include "bt/event_binary.hpp"
+
+#include <charconv>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "bt/event_log.hpp"
+
+namespace bt {
+namespace {
+
+constexpr std::uint8_t k_record_string = 0x01;
+constexpr std::uint8_t k_record_raw_line = 0x02;
+constexpr std::uint8_t k_record_event = 0x10;
+constexpr std::uint8_t k_event_has_tick = 0x01;
+constexpr std::uint8_t k_event_templated = 0x02;
+constexpr char k_number_marker = '\x01';
+
+void append_varint(std::string& out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+std::uint64_t zigzag(std::int64_t value) noexcept {
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+std::int64_t unzigzag(std::uint64_t value) noexcept {
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+bool is_number_char(char c) noexcept {
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+// Integers that print back identically and whose zigzag form leaves room for the token tag bit.
+std::optional<std::int64_t> canonical_integer(std::string_view text) noexcept {
+    std::int64_t value = 0;
+    const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc{} || ptr != text.data() + text.size()) {
+        return std::nullopt;
+    }
+    char buffer[24];
+    const auto [end, print_ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    if (print_ec != std::errc{} || std::string_view(buffer, static_cast<std::size_t>(end - buffer)) != text) {
+        return std::nullopt;
+    }
+    if (zigzag(value) >> 63) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+class reader {
+public:
+    explicit reader(std::string_view bytes) : bytes_(bytes) {}
+
+    [[nodiscard]] bool done() const noexcept { return pos_ == bytes_.size(); }
+
+    std::uint8_t byte() {
+        if (pos_ >= bytes_.size()) {
+            throw std::runtime_error("mbt.evt.v1-bin: truncated stream");
+        }
+        return static_cast<std::uint8_t>(bytes_[pos_++]);
+    }
+
+    std::uint64_t varint() {
+        std::uint64_t value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            const std::uint8_t b = byte();
+            value |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+            if ((b & 0x80) == 0) {
+                return value;
+            }
+        }
+        throw std::runtime_error("mbt.evt.v1-bin: varint is too long");
+    }
+
+    std::string_view bytes(std::uint64_t count) {
+        if (count > bytes_.size() - pos_) {
+            throw std::runtime_error("mbt.evt.v1-bin: truncated stream");
+        }
+        const std::string_view out = bytes_.substr(pos_, static_cast<std::size_t>(count));
+        pos_ += static_cast<std::size_t>(count);
+        return out;
+    }
+
+private:
+    std::string_view bytes_;
+    std::size_t pos_ = 0;
+};
+
+}  // namespace
+
+void event_binary_encoder::begin_stream(std::string& out) {
+    strings_.clear();
+    prev_unix_ms_ = 0;
+    prev_seq_ = 0;
+    prev_tick_ = 0;
+    out.append(k_magic);
+    out.push_back(static_cast<char>(k_format_version));
+}
+
+std::uint64_t event_binary_encoder::intern(std::string& out, std::string_view text) {
+    if (const auto found = strings_.find(text); found != strings_.end()) {
+        return found->second;
+    }
+    const std::uint64_t id = strings_.size();
+    strings_.emplace(std::string(text), id);
+    out.push_back(static_cast<char>(k_record_string));
+    append_varint(out, text.size());
+    out.append(text);
+    return id;
+}
+
+bool event_binary_encoder::split_payload(std::string_view data_json) {
+    template_.clear();
+    number_tokens_.clear();
+    bool in_string = false;
+    for (std::size_t i = 0; i < data_json.size();) {
+        const char c = data_json[i];
+        if (c == k_number_marker) {
+            return false;
+        }
+        if (in_string) {
+            template_.push_back(c);
+            if (c == '\\' && i + 1 < data_json.size()) {
+                template_.push_back(data_json[i + 1]);
+                i += 2;
+                continue;
+            }
+            in_string = c != '"';
+            ++i;
+            continue;
+        }
+        if (c == '"') {
+            in_string = true;
+            template_.push_back(c);
+            ++i;
+            continue;
+        }
+        if (c == '-' || (c >= '0' && c <= '9')) {
+            std::size_t end = i + 1;
+            while (end < data_json.size() && is_number_char(data_json[end])) {
+                ++end;
+            }
+            const std::string_view number = data_json.substr(i, end - i);
+            if (const std::optional<std::int64_t> integer = canonical_integer(number)) {
+                append_varint(number_tokens_, zigzag(*integer) << 1);
+            } else {
+                append_varint(number_tokens_, (static_cast<std::uint64_t>(number.size()) << 1) | 1u);
+                number_tokens_.append(number);
+            }
+            template_.push_back(k_number_marker);
+            i = end;
+            continue;
+        }
+        template_.push_back(c);
+        ++i;
+    }
+    return true;
+}
+
+void event_binary_encoder::encode(std::string& out,
+                                  std::string_view contract_version,
+                                  std::string_view type,
+                                  std::string_view run_id,
+                                  std::int64_t unix_ms,
+                                  std::uint64_t seq,
+                                  std::optional<std::uint64_t> tick,
+                                  std::string_view data_json) {
+    const std::uint64_t contract_id = intern(out, contract_version);
+    const std::uint64_t type_id = intern(out, type);
+    const std::uint64_t run_id_id = intern(out, run_id);
+
+    bool templated = split_payload(data_json);
+    std::uint64_t template_id = 0;
+    if (templated) {
+        if (const auto found = strings_.find(std::string_view(template_)); found != strings_.end()) {
+            template_id = found->second;
+        } else if (strings_.size() < k_max_strings) {
+            template_id = intern(out, template_);
+        } else {
+            templated = false;
+        }
+    }
+
+    std::uint8_t tag = k_record_event;
+    if (tick.has_value()) {
+        tag |= k_event_has_tick;
+    }
+    if (templated) {
+        tag |= k_event_templated;
+    }
+    out.push_back(static_cast<char>(tag));
+    append_varint(out, contract_id);
+    append_varint(out, type_id);
+    append_varint(out, run_id_id);
+    append_varint(out, zigzag(static_cast<std::int64_t>(static_cast<std::uint64_t>(unix_ms) -
+                                                        static_cast<std::uint64_t>(prev_unix_ms_))));
+    append_varint(out, zigzag(static_cast<std::int64_t>(seq - prev_seq_)));
+    prev_unix_ms_ = unix_ms;
+    prev_seq_ = seq;
+    if (tick.has_value()) {
+        append_varint(out, zigzag(static_cast<std::int64_t>(*tick - prev_tick_)));
+        prev_tick_ = *tick;
+    }
+    if (templated) {
+        append_varint(out, template_id);
+        out.append(number_tokens_);
+    } else {
+        append_varint(out, data_json.size());
+        out.append(data_json);
+    }
+}
+
+std::string transcode_event_binary_to_jsonl(std::string_view bytes) {
+    reader in(bytes);
+    if (in.bytes(event_binary_encoder::k_magic.size()) != event_binary_encoder::k_magic) {
+        throw std::runtime_error("mbt.evt.v1-bin: missing stream header");
+    }
+    if (in.byte() != event_binary_encoder::k_format_version) {
+        throw std::runtime_error("mbt.evt.v1-bin: unsupported format version");
+    }
+
+    std::vector<std::string_view> strings;
+    auto string_at = [&strings](std::uint64_t id) {
+        if (id >= strings.size()) {
+            throw std::runtime_error("mbt.evt.v1-bin: string id out of range");
+        }
+        return strings[static_cast<std::size_t>(id)];
+    };
+
+    std::string out;
+    std::string payload;
+    std::int64_t unix_ms = 0;
+    std::uint64_t seq = 0;
+    std::uint64_t tick = 0;
+    while (!in.done()) {
+        const std::uint8_t tag = in.byte();
+        if (tag == k_record_string) {
+            strings.push_back(in.bytes(in.varint()));
+            continue;
+        }
+        if (tag == k_record_raw_line) {
+            out.append(in.bytes(in.varint()));
+            out.push_back('\n');
+            continue;
+        }
+        if ((tag & ~(k_event_has_tick | k_event_templated)) != k_record_event) {
+            throw std::runtime_error("mbt.evt.v1-bin: unknown record tag");
+        }
+        const std::string_view contract_version = string_at(in.varint());
+        const std::string_view type = string_at(in.varint());
+        const std::string_view run_id = string_at(in.varint());
+        unix_ms = static_cast<std::int64_t>(static_cast<std::uint64_t>(unix_ms) +
+                                            static_cast<std::uint64_t>(unzigzag(in.varint())));
+        seq += static_cast<std::uint64_t>(unzigzag(in.varint()));
+        std::optional<std::uint64_t> event_tick;
+        if (tag & k_event_has_tick) {
+            tick += static_cast<std::uint64_t>(unzigzag(in.varint()));
+            event_tick = tick;
+        }
+
+        std::string_view data_json;
+        if (tag & k_event_templated) {
+            payload.clear();
+            for (const char c : string_at(in.varint())) {
+                if (c != k_number_marker) {
+                    payload.push_back(c);
+                    continue;
+                }
+                const std::uint64_t token = in.varint();
+                if (token & 1u) {
+                    payload.append(in.bytes(token >> 1));
+                } else {
+                    char buffer[24];
+                    const auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), unzigzag(token >> 1));
+                    if (ec != std::errc{}) {
+                        throw std::runtime_error("mbt.evt.v1-bin: failed to format integer");
+                    }
+                    payload.append(buffer, end);
+                }
+            }
+            data_json = payload;
+        } else {
+            data_json = in.bytes(in.varint());
+        }
+        event_log::append_event_line(out, contract_version, type, run_id, unix_ms, seq, event_tick, data_json);
+        out.push_back('\n');
+    }
+    return out;
+}
+
+}  // namespace bt
@@ -0,0 +1,110 @@
+#include "bt/event_compact.hpp"
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+
+#include "bt/json_writer.hpp"
+#include "json_scan.hpp"
+
+namespace bt {
+namespace {
+
+using namespace json_scan;
+
+// Replaces the member at `i` (name and value) with `replacement`.
+struct member_splice {
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    std::string replacement;
+};
+
+member_splice splice_member(const json_doc& doc, std::uint32_t i, std::string_view line, std::string replacement) {
+    const json_node& n = doc.at(i);
+    // The member name starts one byte after its opening quote.
+    const auto begin = static_cast<std::size_t>(n.key.data() - line.data()) - 1;
+    const auto end = static_cast<std::size_t>(n.source.data() + n.source.size() - line.data());
+    return member_splice{begin, end, std::move(replacement)};
+}
+
+std::string text_field(std::string_view name, std::string_view text) {
+    std::string out = "\"";
+    out += name;
+    out += "\":\"";
+    json_writer::append_escaped(out, text);
+    out += '"';
+    return out;
+}
+
+}  // namespace
+
+std::optional<std::string_view> compact_status_name(std::int64_t status_id) noexcept {
+    if (status_id < 0 || status_id >= static_cast<std::int64_t>(std::size(k_compact_status_names))) {
+        return std::nullopt;
+    }
+    return k_compact_status_names[status_id];
+}
+
+bool compact_event_expander::expand(std::string& line) {
+    thread_local json_doc doc;
+    if (!doc.parse(line) || doc.at(0).kind != json_kind::object) {
+        return false;
+    }
+    const std::uint32_t type_at = doc.member(0, "type");
+    const std::uint32_t data = doc.member(0, "data");
+    if (type_at == k_none || doc.at(type_at).kind != json_kind::string || data == k_none ||
+        doc.at(data).kind != json_kind::object) {
+        return false;
+    }
+    const std::string_view type = doc.at(type_at).text;
+
+    if (type == "run_start") {
+        keys_.clear();
+        return false;
+    }
+    if (type == "bt_def") {
+        // The string_table stays in the line; bt_def payloads admit extra members.
+        const std::uint32_t table = doc.member(data, "string_table");
+        const std::uint32_t keys = doc.member(table, "keys");
+        const std::optional<std::int64_t> base = int_value(doc, doc.member(table, "key_base"));
+        if (keys == k_none || doc.at(keys).kind != json_kind::array || !base || *base < 0) {
+            return false;
+        }
+        auto id = static_cast<std::uint64_t>(*base);
+        for (std::uint32_t k = doc.at(keys).first_child; k != k_none; k = doc.at(k).next_sibling, ++id) {
+            if (doc.at(k).kind == json_kind::string) {
+                keys_[id] = doc.string_value(k);
+            }
+        }
+        return false;
+    }
+
+    std::array<member_splice, 2> splices;
+    std::size_t count = 0;
+    if (const std::uint32_t status = doc.member(data, "status_id"); status != k_none) {
+        if (const std::optional<std::int64_t> id = int_value(doc, status)) {
+            if (const std::optional<std::string_view> name = compact_status_name(*id)) {
+                splices[count++] = splice_member(doc, status, line, text_field("status", *name));
+            }
+        }
+    }
+    if (const std::uint32_t key = doc.member(data, "key_id"); key != k_none) {
+        if (const std::optional<std::int64_t> id = int_value(doc, key); id && *id >= 0) {
+            if (const auto it = keys_.find(static_cast<std::uint64_t>(*id)); it != keys_.end()) {
+                splices[count++] = splice_member(doc, key, line, text_field("key", it->second));
+            }
+        }
+    }
+    if (count == 0) {
+        return false;
+    }
+    // Later members first, so the earlier offsets stay valid.
+    std::sort(splices.begin(), splices.begin() + static_cast<std::ptrdiff_t>(count),
+              [](const member_splice& a, const member_splice& b) { return a.begin > b.begin; });
+    for (std::size_t i = 0; i < count; ++i) {
+        line.replace(splices[i].begin, splices[i].end - splices[i].begin, splices[i].replacement);
+    }
+    return true;
+}
+
+}  // namespace bt
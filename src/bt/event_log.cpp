@@ -1,5 +1,6 @@
 #include "bt/event_log.hpp"
 
+#include <algorithm>
 #include <charconv>
 #include <chrono>
 #include <filesystem>
@@ -7,8 +8,14 @@
 #include <iomanip>
 #include <sstream>
 #include <stdexcept>
+#include <system_error>
 #include <utility>
 
+#include "bt/compiler.hpp"
+#include "bt/event_compact.hpp"
+#include "bt/memory_footprint.hpp"
+#include "bt/profile.hpp"
+#include "muesli_bt/contract/events.hpp"
 #include "muesli_bt/contract/version.hpp"
 
 namespace bt {
@@ -50,28 +57,7 @@ void append_arg_signature(std::ostringstream& out, const arg_value& arg) {
 }
 
 void append_json_escaped(std::string& out, std::string_view text) {
-    for (const char c : text) {
-        switch (c) {
-            case '\\':
-                out += "\\\\";
-                break;
-            case '"':
-                out += "\\\"";
-                break;
-            case '\n':
-                out += "\\n";
-                break;
-            case '\r':
-                out += "\\r";
-                break;
-            case '\t':
-                out += "\\t";
-                break;
-            default:
-                out.push_back(c);
-                break;
-        }
-    }
+    json_writer::append_escaped(out, text);
 }
 
 std::size_t escaped_json_size(std::string_view text) noexcept {
@@ -113,15 +99,36 @@ std::size_t integer_length(Integer value) noexcept {
     return static_cast<std::size_t>(ptr - buffer);
 }
 
+// Segment `index` of the file sink at `base`: the base path itself, then `run.1.jsonl`, `run.2.jsonl`, ...
+std::string segment_file_path(const std::string& base, std::uint64_t index) {
+    if (index == 0) {
+        return base;
+    }
+    const std::filesystem::path base_path(base);
+    std::filesystem::path name = base_path.stem();
+    name += "." + std::to_string(index);
+    name += base_path.extension();
+    return (base_path.parent_path() / name).string();
+}
+
+constexpr std::string_view k_file_layout_async_error = "events: file index and rotation need the synchronous file sink";
+
 }  // namespace
 
 event_log::event_log(std::size_t ring_capacity) : ring_capacity_(ring_capacity) {
     ring_.reserve(ring_capacity_);
+    publish_policy_locked();
+}
+
+event_log::~event_log() {
+    std::lock_guard<std::mutex> file_lock(file_mutex_);
+    close_file_locked();
 }
 
 void event_log::set_enabled(bool enabled) noexcept {
     std::lock_guard<std::mutex> lock(mutex_);
     enabled_ = enabled;
+    publish_policy_locked();
 }
 
 bool event_log::enabled() const noexcept {
@@ -129,9 +136,90 @@ bool event_log::enabled() const noexcept {
     return enabled_;
 }
 
+void event_log::set_emission_policy(const emission_policy& policy) {
+    if (policy.node_sample_every == 0) {
+        throw std::invalid_argument("event_log: node sample interval must be positive");
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    policy_ = policy;
+    policy_.family_mask &= emission_policy::k_all_families;
+    publish_policy_locked();
+}
+
+emission_policy event_log::get_emission_policy() const noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return policy_;
+}
+
+void event_log::publish_policy_locked() noexcept {
+    std::uint64_t bits = policy_.family_mask | (static_cast<std::uint64_t>(policy_.node_sample_every) << 32);
+    if (enabled_) {
+        bits |= k_policy_enabled;
+    }
+    if (policy_.always_emit_failures) {
+        bits |= k_policy_always_failures;
+    }
+    policy_bits_.store(bits, std::memory_order_relaxed);
+}
+
+bool event_log::parse_family(std::string_view text, event_family& out) noexcept {
+    if (!text.empty() && text.front() == ':') {
+        text.remove_prefix(1);
+    }
+    static constexpr std::pair<std::string_view, event_family> k_names[] = {
+        {"lifecycle", event_family::lifecycle},
+        {"node", event_family::node},
+        {"blackboard", event_family::blackboard},
+        {"async", event_family::async},
+        {"outcome", event_family::outcome},
+        {"alert", event_family::alert},
+        {"other", event_family::other},
+    };
+    for (const auto& [name, family] : k_names) {
+        if (text == name) {
+            out = family;
+            return true;
+        }
+    }
+    return false;
+}
+
+event_family event_log::family_of(std::string_view type) noexcept {
+    namespace c = muesli_bt::contract;
+    if (type == c::kEventNodeEnter || type == c::kEventNodeExit || type == c::kEventNodeStatus) {
+        return event_family::node;
+    }
+    if (type == c::kEventTickBegin || type == c::kEventTickEnd || type == c::kEventRunStart || type == c::kEventRunEnd ||
+        type == c::kEventEpisodeBegin || type == c::kEventEpisodeEnd || type == c::kEventBtDef || type == c::kEventGcBegin ||
+        type == c::kEventGcEnd) {
+        return event_family::lifecycle;
+    }
+    if (type == "bb_write" || type == "bb_delete" || type == "bb_snapshot" || type == "bb_delta") {
+        return event_family::blackboard;
+    }
+    if (type == "error" || type == c::kEventBudgetWarning || type == c::kEventDeadlineExceeded ||
+        type == c::kEventTickAudit || type == c::kEventTickDeadlineMissed || type == c::kEventPlannerTimeout ||
+        type == c::kEventVlaTimeout || type == c::kEventHostActionInvalid || type == c::kEventFallbackUsed ||
+        type == c::kEventFallbackFailed) {
+        return event_family::alert;
+    }
+    if (type == c::kEventTickOk || type == c::kEventLateResultDropped || type == c::kEventCancelAcknowledged ||
+        type == c::kEventCancelLate) {
+        return event_family::outcome;
+    }
+    if (type.starts_with("planner_") || type.starts_with("vla_") || type.starts_with("async_") ||
+        type.starts_with("sched_") || type == c::kEventCapCallStart ||
+        type == c::kEventCapCallEnd) {
+        return event_family::async;
+    }
+    return event_family::other;
+}
+
 void event_log::set_ring_capacity(std::size_t capacity) {
     std::lock_guard<std::mutex> lock(mutex_);
     ring_capacity_ = capacity;
+    std::rotate(ring_.begin(), ring_.begin() + static_cast<std::ptrdiff_t>(ring_start_), ring_.end());
+    ring_start_ = 0;
     if (ring_capacity_ == 0) {
         ring_.clear();
         return;
@@ -146,6 +234,15 @@ std::size_t event_log::ring_capacity() const noexcept {
     return ring_capacity_;
 }
 
+std::size_t event_log::ring_memory_bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t bytes = vector_heap_bytes(ring_);
+    for (const std::string& line : ring_) {
+        bytes += string_heap_bytes(line);
+    }
+    return bytes;
+}
+
 void event_log::set_path(std::string path) {
     if (path.empty()) {
         throw std::invalid_argument("events.set-path: path must not be empty");
@@ -155,12 +252,13 @@ void event_log::set_path(std::string path) {
         std::lock_guard<std::mutex> lock(mutex_);
         path_ = std::move(path);
         updated_path = path_;
+        if (async_sink_) {
+            restart_async_sink_locked();
+        }
     }
     std::lock_guard<std::mutex> file_lock(file_mutex_);
     if (file_stream_.is_open() && open_path_ != updated_path) {
-        file_stream_.flush();
-        file_stream_.close();
-        open_path_.clear();
+        close_file_locked();
     }
 }
 
@@ -168,18 +266,17 @@ const std::string& event_log::path() const noexcept {
     return path_;
 }
 
-void event_log::set_file_enabled(bool enabled) noexcept {
+void event_log::set_file_enabled(bool enabled) {
     {
         std::lock_guard<std::mutex> lock(mutex_);
         file_enabled_ = enabled;
+        if (file_async_) {
+            restart_async_sink_locked();
+        }
     }
     if (!enabled) {
         std::lock_guard<std::mutex> file_lock(file_mutex_);
-        if (file_stream_.is_open()) {
-            file_stream_.flush();
-            file_stream_.close();
-        }
-        open_path_.clear();
+        close_file_locked();
     }
 }
 
@@ -188,6 +285,136 @@ bool event_log::file_enabled() const noexcept {
     return file_enabled_;
 }
 
+void event_log::set_file_async(bool enabled, std::size_t queue_lines) {
+    if (enabled && !async_file_sink::supported()) {
+        throw std::runtime_error("events: asynchronous file output is not supported on this platform");
+    }
+    if (queue_lines == 0) {
+        throw std::invalid_argument("events: async queue size must be positive");
+    }
+    // Lines already buffered by the synchronous stream reach the file before the sink appends.
+    std::lock_guard<std::mutex> file_lock(file_mutex_);
+    if (enabled && file_layout_.active()) {
+        throw std::invalid_argument(std::string(k_file_layout_async_error));
+    }
+    if (enabled && file_stream_.is_open()) {
+        close_file_locked();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    file_async_ = enabled;
+    async_queue_lines_ = queue_lines;
+    restart_async_sink_locked();
+}
+
+bool event_log::file_async() const noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return file_async_;
+}
+
+void event_log::set_file_layout(const event_file_layout& layout) {
+    std::lock_guard<std::mutex> file_lock(file_mutex_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (file_async_ && layout.active()) {
+            throw std::invalid_argument(std::string(k_file_layout_async_error));
+        }
+    }
+    close_file_locked();
+    file_layout_ = layout;
+}
+
+event_file_layout event_log::file_layout() const {
+    std::lock_guard<std::mutex> file_lock(file_mutex_);
+    return file_layout_;
+}
+
+std::string event_log::file_segment_path() const {
+    std::lock_guard<std::mutex> file_lock(file_mutex_);
+    return file_stream_.is_open() ? segment_path_ : std::string{};
+}
+
+void event_log::drain_file_async() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (async_sink_) {
+        async_sink_->drain();
+    }
+}
+
+void event_log::set_binary_path(std::string path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (binary_stream_.is_open()) {
+        binary_stream_.close();
+    }
+    binary_path_.clear();
+    if (path.empty()) {
+        return;
+    }
+    const std::filesystem::path fs_path(path);
+    if (fs_path.has_parent_path()) {
+        std::filesystem::create_directories(fs_path.parent_path());
+    }
+    binary_stream_.open(path, std::ios::binary | std::ios::trunc);
+    if (!binary_stream_) {
+        binary_stream_.close();
+        throw std::runtime_error("events: failed to open binary event log: " + path);
+    }
+    binary_buffer_.clear();
+    binary_encoder_.begin_stream(binary_buffer_);
+    binary_stream_.write(binary_buffer_.data(), static_cast<std::streamsize>(binary_buffer_.size()));
+    binary_path_ = std::move(path);
+}
+
+std::string event_log::binary_path() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return binary_path_;
+}
+
+void event_log::set_net_sink(const net_sink_options& options) {
+    auto sink = std::make_shared<net_event_sink>(options);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::swap(net_sink_, sink);
+    }
+    // The previous sink, if any, finishes delivering outside the lock.
+}
+
+void event_log::close_net_sink() {
+    std::shared_ptr<net_event_sink> sink;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::swap(net_sink_, sink);
+    }
+}
+
+std::optional<net_sink_stats> event_log::net_stats() const {
+    std::shared_ptr<net_event_sink> sink;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sink = net_sink_;
+    }
+    if (!sink) {
+        return std::nullopt;
+    }
+    return sink->stats();
+}
+
+bool event_log::flush_net_sink(std::chrono::milliseconds timeout) {
+    std::shared_ptr<net_event_sink> sink;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sink = net_sink_;
+    }
+    return !sink || sink->flush(timeout);
+}
+
+void event_log::restart_async_sink_locked() {
+    // Destroying the previous sink writes out its queue, so a path change keeps every line.
+    async_sink_.reset();
+    if (file_async_ && file_enabled_) {
+        async_sink_ = std::make_unique<async_file_sink>(path_, async_queue_lines_, async_dropped_lines_);
+    }
+}
+
 void event_log::set_flush_on_tick_end(bool enabled) noexcept {
     std::lock_guard<std::mutex> lock(mutex_);
     flush_on_tick_end_ = enabled;
@@ -208,6 +435,30 @@ bool event_log::flush_each_message() const noexcept {
     return flush_each_message_;
 }
 
+void event_log::begin_batch() noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++batch_depth_;
+}
+
+void event_log::end_batch() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (batch_depth_ == 0 || --batch_depth_ != 0) {
+            return;
+        }
+        if (binary_stream_.is_open()) {
+            binary_stream_.flush();
+        }
+    }
+    std::lock_guard<std::mutex> file_lock(file_mutex_);
+    if (file_stream_.is_open()) {
+        file_stream_.flush();
+        if (!file_stream_) {
+            close_file_locked();
+        }
+    }
+}
+
 void event_log::set_tick_audit_enabled(bool enabled) noexcept {
     std::lock_guard<std::mutex> lock(mutex_);
     tick_audit_enabled_ = enabled;
@@ -238,6 +489,16 @@ bool event_log::tick_audit_strict_allocations() const noexcept {
     return tick_audit_strict_allocations_;
 }
 
+void event_log::set_audit_loop_pacer(const loop_pacer* pacer) noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    audit_loop_pacer_ = pacer;
+}
+
+const loop_pacer* event_log::audit_loop_pacer() const noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return audit_loop_pacer_;
+}
+
 void event_log::set_run_id(std::string run_id) {
     if (run_id.empty()) {
         throw std::invalid_argument("set_run_id: run_id must not be empty");
@@ -246,6 +507,10 @@ void event_log::set_run_id(std::string run_id) {
     run_id_ = std::move(run_id);
     seq_ = 0;
     run_started_ = false;
+    bb_keyframe_epoch_.fetch_add(1, std::memory_order_relaxed);
+    // Key ids are scoped to a run; the next bt_def declares them again.
+    std::lock_guard<std::mutex> keys_lock(compact_keys_->mutex);
+    compact_keys_->keys.clear();
 }
 
 std::string event_log::run_id() const {
@@ -306,7 +571,8 @@ void event_log::ensure_run_started(std::string_view tree_hash, std::string_view
     run_started_ = true;
 }
 
-void event_log::emit_bt_def(const definition& def) {
+event_log::bt_def_event event_log::describe_bt_def(const definition& def) {
+    ensure_canonical_dsl(def);
     std::ostringstream graph;
     graph << "root=" << def.root;
     for (const node& n : def.nodes) {
@@ -354,83 +620,224 @@ void event_log::emit_bt_def(const definition& def) {
         }
     }
     data << "]}";
-    ensure_run_started(tree_hash);
-    (void)emit("bt_def", std::nullopt, data.str());
+    return bt_def_event{tree_hash, data.str(), def.bb_keys};
+}
+
+void event_log::emit_bt_def(const definition& def) {
+    emit_bt_def(describe_bt_def(def));
+}
+
+void event_log::emit_bt_def(const bt_def_event& event) {
+    ensure_run_started(event.tree_hash);
+    if (!compact_ids()) {
+        (void)emit("bt_def", std::nullopt, event.data_json);
+        return;
+    }
+
+    std::vector<std::string_view> declared;
+    std::uint32_t key_base = 0;
+    {
+        std::lock_guard<std::mutex> lock(compact_keys_->mutex);
+        key_base = static_cast<std::uint32_t>(compact_keys_->keys.size());
+        for (const std::string& key : event.bb_keys) {
+            const auto id = static_cast<std::uint32_t>(key_base + declared.size());
+            if (compact_keys_->keys.try_emplace(key, compact_key{id, false}).second) {
+                declared.push_back(key);
+            }
+        }
+    }
+
+    std::string data(event.data_json.substr(0, event.data_json.size() - 1));
+    data += ",\"string_table\":{\"profile\":\"";
+    data += k_compact_ids_profile;
+    data += "\",\"statuses\":[";
+    for (std::size_t i = 0; i < std::size(k_compact_status_names); ++i) {
+        data += i == 0 ? "\"" : ",\"";
+        data += k_compact_status_names[i];
+        data += '"';
+    }
+    data += "],\"key_base\":" + std::to_string(key_base) + ",\"keys\":[";
+    for (std::size_t i = 0; i < declared.size(); ++i) {
+        data += i == 0 ? "\"" : ",\"";
+        json_writer::append_escaped(data, declared[i]);
+        data += '"';
+    }
+    data += "]}}";
+    (void)emit("bt_def", std::nullopt, data);
+
+    std::lock_guard<std::mutex> lock(compact_keys_->mutex);
+    for (std::string_view key : declared) {
+        if (const auto it = compact_keys_->keys.find(key); it != compact_keys_->keys.end()) {
+            it->second.declared = true;
+        }
+    }
+}
+
+json_writer& event_log::payload_writer() {
+    thread_local json_writer writer;
+    writer.clear();
+    return writer;
+}
+
+std::uint64_t event_log::emit(std::string_view type, std::optional<std::uint64_t> tick, const json_writer& data) {
+    return emit(type, tick, data.view());
 }
 
 std::uint64_t event_log::emit(std::string_view type, std::optional<std::uint64_t> tick, std::string_view data_json) {
+    ledger_scope charge(ledger_category::events);
+    // Lines are built in a per-thread buffer that keeps its capacity. A listener that emits from
+    // inside its callback gets a fresh buffer, so the line it was handed stays intact.
+    thread_local std::string t_line;
+    thread_local unsigned t_emit_depth = 0;
+    struct emit_depth_guard {
+        emit_depth_guard() noexcept { ++t_emit_depth; }
+        ~emit_depth_guard() { --t_emit_depth; }
+    } depth_guard;
+    std::string nested_line;
+    std::string& line = t_emit_depth == 1 ? t_line : nested_line;
+
+    event_log_allocation_scope allocation_scope(this);
     bool file_enabled = false;
-    bool flush_on_tick_end = true;
-    bool flush_each_message = false;
-    bool capture_stats_enabled = false;
-    bool needs_serialised_line = false;
+    bool flush_now = false;
     std::uint64_t seq = 0;
-    std::string run_id;
-    std::int64_t unix_ms = 0;
-    line_listener listener{};
+    std::shared_ptr<const line_listener> listener;
     {
         std::lock_guard<std::mutex> lock(mutex_);
+        if (shard_) {
+            if (enabled_) {
+                if (deferred_size_ == deferred_.size()) {
+                    deferred_.emplace_back();
+                }
+                deferred_event& ev = deferred_[deferred_size_++];
+                ev.type.assign(type);
+                ev.tick = tick;
+                ev.data_json.assign(data_json);
+            }
+            return 0;
+        }
         seq = ++seq_;
         if (!enabled_) {
             return seq;
         }
-        file_enabled = file_enabled_;
-        flush_on_tick_end = flush_on_tick_end_;
-        flush_each_message = flush_each_message_;
-        capture_stats_enabled = capture_stats_enabled_;
-        run_id = run_id_;
+        std::int64_t unix_ms = 0;
         if (deterministic_time_enabled_) {
             unix_ms = deterministic_unix_ms_;
             deterministic_unix_ms_ += deterministic_step_ms_;
         } else {
             unix_ms = unix_ms_now();
         }
+        file_enabled = file_enabled_;
+        flush_now = flush_each_message_ || !flush_on_tick_end_ || (type == "tick_end" && batch_depth_ == 0);
         listener = line_listener_;
-        needs_serialised_line = file_enabled || ring_capacity_ != 0u || static_cast<bool>(listener);
+
+        // The line is serialised under the lock: straight into the ring slot when nothing else needs
+        // it, otherwise into the line buffer that is then copied into the slot.
+        std::size_t serialised_size = 0u;
+        if (file_enabled || listener || net_sink_) {
+            line.clear();
+            append_event_line(line, runtime_contract_version(), type, run_id_, unix_ms, seq, tick, data_json);
+            serialised_size = line.size();
+            if (ring_capacity_ != 0u) {
+                claim_ring_slot().assign(line);
+            }
+            if (file_enabled && async_sink_) {
+                (void)async_sink_->push(line);
+                file_enabled = false;
+            }
+            if (net_sink_) {
+                (void)net_sink_->push(line, family_of(type) == event_family::alert);
+            }
+        } else if (ring_capacity_ != 0u) {
+            std::string& slot = claim_ring_slot();
+            slot.clear();
+            append_event_line(slot, runtime_contract_version(), type, run_id_, unix_ms, seq, tick, data_json);
+            serialised_size = slot.size();
+        } else if (capture_stats_enabled_) {
+            serialised_size = serialise_event_line_size(type, run_id_, unix_ms, seq, tick, data_json);
+        }
+        if (binary_stream_.is_open()) {
+            binary_buffer_.clear();
+            binary_encoder_.encode(
+                binary_buffer_, runtime_contract_version(), type, run_id_, unix_ms, seq, tick, data_json);
+            binary_stream_.write(binary_buffer_.data(), static_cast<std::streamsize>(binary_buffer_.size()));
+            if (flush_now) {
+                binary_stream_.flush();
+            }
+        }
+        if (capture_stats_enabled_) {
+            ++captured_event_count_;
+            captured_byte_count_ += static_cast<std::uint64_t>(serialised_size);
+        }
     }
 
-    event_log_allocation_scope allocation_scope(this);
-    std::string line;
-    std::size_t serialised_size = 0u;
-    if (needs_serialised_line) {
-        line = serialise_event_line(type, run_id, unix_ms, seq, tick, data_json);
-        serialised_size = line.size();
-    } else if (capture_stats_enabled) {
-        serialised_size = serialise_event_line_size(type, run_id, unix_ms, seq, tick, data_json);
+    if (file_enabled) {
+        append_file_line(type, seq, tick, line, flush_now);
     }
+    if (listener) {
+        (*listener)(line);
+    }
+    return seq;
+}
 
-    if (capture_stats_enabled) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        ++captured_event_count_;
-        captured_byte_count_ += static_cast<std::uint64_t>(serialised_size);
+void event_log::configure_shard(const event_log& canonical) {
+    if (&canonical == this) {
+        return;
     }
+    // Copied wholesale so runtime code that reports the logging mode sees the canonical settings.
+    std::scoped_lock lock(mutex_, canonical.mutex_);
+    shard_ = true;
+    run_started_ = true;
+    enabled_ = canonical.enabled_;
+    policy_ = canonical.policy_;
+    publish_policy_locked();
+    file_enabled_ = canonical.file_enabled_;
+    flush_on_tick_end_ = canonical.flush_on_tick_end_;
+    flush_each_message_ = canonical.flush_each_message_;
+    tick_audit_enabled_ = canonical.tick_audit_enabled_;
+    tick_audit_warmup_complete_ = canonical.tick_audit_warmup_complete_;
+    tick_audit_strict_allocations_ = canonical.tick_audit_strict_allocations_;
+    audit_loop_pacer_ = canonical.audit_loop_pacer_;
+    ring_capacity_ = canonical.ring_capacity_;
+    path_ = canonical.path_;
+    run_id_ = canonical.run_id_;
+    line_listener_ = canonical.line_listener_;
+    allocation_whitelist_enter_ = canonical.allocation_whitelist_enter_;
+    allocation_whitelist_leave_ = canonical.allocation_whitelist_leave_;
+    bb_keyframe_every_.store(canonical.bb_keyframe_every_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    bb_keyframe_epoch_.store(canonical.bb_keyframe_epoch_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    compact_ids_.store(canonical.compact_ids_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    compact_keys_ = canonical.compact_keys_;
+}
 
-    if (needs_serialised_line) {
-        append_ring_line(line);
-        if (file_enabled) {
-            const bool flush_now = flush_each_message || !flush_on_tick_end || type == "tick_end";
-            append_file_line(line, flush_now);
-        }
+void event_log::replay_into(event_log& canonical) {
+    // The shard's owner replays it while no worker is emitting into it. Entries are kept after the
+    // replay so the next wave reuses their string storage.
+    std::size_t count = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        count = deferred_size_;
     }
-    if (listener) {
-        listener(line);
+    for (std::size_t i = 0; i < count; ++i) {
+        const deferred_event& ev = deferred_[i];
+        (void)canonical.emit(ev.type, ev.tick, ev.data_json);
     }
-    return seq;
+    std::lock_guard<std::mutex> lock(mutex_);
+    deferred_size_ = 0;
 }
 
 void event_log::set_line_listener(line_listener listener) {
     std::lock_guard<std::mutex> lock(mutex_);
-    line_listener_ = std::move(listener);
+    line_listener_ = listener ? std::make_shared<const line_listener>(std::move(listener)) : nullptr;
 }
 
 void event_log::clear_line_listener() noexcept {
     std::lock_guard<std::mutex> lock(mutex_);
-    line_listener_ = {};
+    line_listener_.reset();
 }
 
 bool event_log::has_line_listener() const noexcept {
     std::lock_guard<std::mutex> lock(mutex_);
-    return static_cast<bool>(line_listener_);
+    return line_listener_ != nullptr;
 }
 
 void event_log::set_deterministic_time(std::int64_t start_unix_ms, std::int64_t step_ms) noexcept {
@@ -466,6 +873,7 @@ void event_log::clear_capture_stats() noexcept {
     std::lock_guard<std::mutex> lock(mutex_);
     captured_event_count_ = 0u;
     captured_byte_count_ = 0u;
+    async_dropped_lines_.store(0u, std::memory_order_relaxed);
 }
 
 event_log_stats event_log::capture_stats() const noexcept {
@@ -473,6 +881,7 @@ event_log_stats event_log::capture_stats() const noexcept {
     return event_log_stats{
         .event_count = captured_event_count_,
         .byte_count = captured_byte_count_,
+        .dropped_line_count = async_dropped_lines_.load(std::memory_order_relaxed),
     };
 }
 
@@ -539,17 +948,18 @@ std::size_t event_log::serialise_event_line_size(std::string_view type,
     return size;
 }
 
-std::string event_log::serialise_event_line(std::string_view type,
-                                            std::string_view run_id,
-                                            std::int64_t unix_ms,
-                                            std::uint64_t seq,
-                                            std::optional<std::uint64_t> tick,
-                                            std::string_view data_json) {
-    std::string out;
-    out.reserve(serialise_event_line_size(type, run_id, unix_ms, seq, tick, data_json));
+void event_log::append_event_line(std::string& out,
+                                  std::string_view contract_version,
+                                  std::string_view type,
+                                  std::string_view run_id,
+                                  std::int64_t unix_ms,
+                                  std::uint64_t seq,
+                                  std::optional<std::uint64_t> tick,
+                                  std::string_view data_json) {
+    out.reserve(out.size() + serialise_event_line_size(type, run_id, unix_ms, seq, tick, data_json));
 
     out += "{\"schema\":\"mbt.evt.v1\",\"contract_version\":\"";
-    append_json_escaped(out, runtime_contract_version());
+    append_json_escaped(out, contract_version);
     out += "\",\"type\":\"";
     append_json_escaped(out, type);
     out += "\",\"run_id\":\"";
@@ -565,20 +975,34 @@ std::string event_log::serialise_event_line(std::string_view type,
     out += ",\"data\":";
     out.append(data_json);
     out.push_back('}');
+}
+
+std::string event_log::serialise_event_line(std::string_view type,
+                                            std::string_view run_id,
+                                            std::int64_t unix_ms,
+                                            std::uint64_t seq,
+                                            std::optional<std::uint64_t> tick,
+                                            std::string_view data_json) {
+    std::string out;
+    append_event_line(out, runtime_contract_version(), type, run_id, unix_ms, seq, tick, data_json);
     return out;
 }
 
 std::vector<std::string> event_log::snapshot(std::size_t max_count) const {
     std::lock_guard<std::mutex> lock(mutex_);
-    if (max_count == 0 || max_count >= ring_.size()) {
-        return ring_;
+    const std::size_t count = max_count == 0 ? ring_.size() : std::min(max_count, ring_.size());
+    std::vector<std::string> out;
+    out.reserve(count);
+    for (std::size_t i = ring_.size() - count; i < ring_.size(); ++i) {
+        out.push_back(ring_[(ring_start_ + i) % ring_.size()]);
     }
-    return std::vector<std::string>(ring_.end() - static_cast<std::ptrdiff_t>(max_count), ring_.end());
+    return out;
 }
 
 void event_log::clear_ring() {
     std::lock_guard<std::mutex> lock(mutex_);
     ring_.clear();
+    ring_start_ = 0;
 }
 
 void event_log::request_snapshot_bb(bool full) noexcept {
@@ -602,31 +1026,28 @@ bool event_log::consume_snapshot_bb_request(bool* full) noexcept {
     return true;
 }
 
+void event_log::set_bb_delta_keyframe_interval(std::uint64_t keyframe_every) noexcept {
+    bb_keyframe_every_.store(keyframe_every, std::memory_order_relaxed);
+    bb_keyframe_epoch_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void event_log::set_compact_ids(bool enabled) noexcept {
+    compact_ids_.store(enabled, std::memory_order_relaxed);
+}
+
+std::optional<std::uint32_t> event_log::compact_key_id(std::string_view key) const {
+    std::lock_guard<std::mutex> lock(compact_keys_->mutex);
+    const auto it = compact_keys_->keys.find(key);
+    if (it == compact_keys_->keys.end() || !it->second.declared) {
+        return std::nullopt;
+    }
+    return it->second.id;
+}
+
 std::string event_log::json_escape(std::string_view text) {
     std::string out;
     out.reserve(text.size() + 8);
-    for (char c : text) {
-        switch (c) {
-            case '\\':
-                out += "\\\\";
-                break;
-            case '"':
-                out += "\\\"";
-                break;
-            case '\n':
-                out += "\\n";
-                break;
-            case '\r':
-                out += "\\r";
-                break;
-            case '\t':
-                out += "\\t";
-                break;
-            default:
-                out.push_back(c);
-                break;
-        }
-    }
+    json_writer::append_escaped(out, text);
     return out;
 }
 
@@ -637,53 +1058,191 @@ std::string event_log::hash64_hex(std::string_view text) {
     return out.str();
 }
 
-void event_log::append_ring_line(const std::string& line) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (ring_capacity_ == 0) {
-        return;
-    }
-    if (ring_.size() == ring_capacity_) {
-        ring_.erase(ring_.begin());
+std::string& event_log::claim_ring_slot() {
+    if (ring_.size() < ring_capacity_) {
+        return ring_.emplace_back();
     }
-    ring_.push_back(line);
+    // Once full, the oldest line is overwritten in place so its string storage is reused.
+    std::string& slot = ring_[ring_start_];
+    ring_start_ = (ring_start_ + 1) % ring_.size();
+    return slot;
 }
 
-void event_log::append_file_line(const std::string& line, bool flush_now) {
+void event_log::append_file_line(std::string_view type,
+                                 std::uint64_t seq,
+                                 std::optional<std::uint64_t> tick,
+                                 std::string_view line,
+                                 bool flush_now) {
+    std::lock_guard<std::mutex> file_lock(file_mutex_);
     std::string path;
     {
+        // The path is only copied when the stream has to be (re)opened.
         std::lock_guard<std::mutex> lock(mutex_);
-        path = path_;
+        if (!file_stream_.is_open() || open_path_ != path_) {
+            path = path_;
+        }
     }
-    std::lock_guard<std::mutex> file_lock(file_mutex_);
-    if (!file_stream_.is_open() || open_path_ != path) {
-        if (file_stream_.is_open()) {
-            file_stream_.flush();
-            file_stream_.close();
+    if (!path.empty()) {
+        close_file_locked();
+        // Reopening after a layout change or a write error appends to the segment that was open last.
+        const std::uint64_t index = path == segment_base_ ? segment_index_ : 0u;
+        if (!open_segment_locked(path, index, false)) {
+            return;
         }
-        std::filesystem::path fs_path(path);
-        if (fs_path.has_parent_path()) {
-            std::filesystem::create_directories(fs_path.parent_path());
+    }
+    if (should_rotate_locked(line.size())) {
+        const std::string base = open_path_;
+        const std::uint64_t next = segment_index_ + 1u;
+        close_file_locked();
+        if (!open_segment_locked(base, next, true)) {
+            return;
         }
-        file_stream_.open(path, std::ios::app);
+        // Later segments start with the run's identity so each can be read on its own.
+        if (!run_start_line_.empty() && type != muesli_bt::contract::kEventRunStart &&
+            !write_file_line_locked(muesli_bt::contract::kEventRunStart, run_start_seq_, std::nullopt, run_start_line_)) {
+            return;
+        }
+    }
+    if (type == muesli_bt::contract::kEventRunStart) {
+        run_start_line_.assign(line);
+        run_start_seq_ = seq;
+    }
+    if (!write_file_line_locked(type, seq, tick, line)) {
+        return;
+    }
+    if (flush_now) {
+        file_stream_.flush();
         if (!file_stream_) {
-            file_stream_.close();
-            open_path_.clear();
+            close_file_locked();
             return;
         }
-        open_path_ = path;
+        if (index_stream_.is_open()) {
+            index_stream_.flush();
+        }
     }
-    file_stream_ << line << '\n';
+}
+
+bool event_log::open_segment_locked(const std::string& base, std::uint64_t index, bool truncate) {
+    if (base != segment_base_ || index != segment_index_) {
+        if (base != segment_base_) {
+            last_file_tick_.reset();
+        }
+        segment_base_ = base;
+        segment_index_ = index;
+        segment_events_ = 0;
+        segment_counts_.clear();
+    }
+    segment_path_ = segment_file_path(base, index);
+    const std::filesystem::path fs_path(segment_path_);
+    if (fs_path.has_parent_path()) {
+        std::filesystem::create_directories(fs_path.parent_path());
+    }
+    const std::ios::openmode mode = std::ios::out | (truncate ? std::ios::trunc : std::ios::app);
+    file_stream_.open(segment_path_, mode);
     if (!file_stream_) {
         file_stream_.close();
         open_path_.clear();
-        return;
+        return false;
     }
-    if (flush_now) {
+    open_path_ = base;
+    std::error_code ec;
+    const std::uintmax_t existing = truncate ? 0u : std::filesystem::file_size(fs_path, ec);
+    segment_bytes_ = ec ? 0u : static_cast<std::uint64_t>(existing);
+    segment_opened_ = std::chrono::steady_clock::now();
+
+    if (file_layout_.index_every != 0u) {
+        const std::string index_path = segment_path_ + ".idx";
+        std::error_code index_ec;
+        const std::uintmax_t index_size = truncate ? 0u : std::filesystem::file_size(index_path, index_ec);
+        index_stream_.open(index_path, mode);
+        if (index_stream_ && (index_ec || index_size == 0u)) {
+            std::string header = "{\"schema\":\"mbt.evt.idx.v1\",\"segment\":\"";
+            append_json_escaped(header, fs_path.filename().string());
+            header += "\",\"segment_index\":";
+            append_integer(header, index);
+            header += ",\"index_every\":";
+            append_integer(header, file_layout_.index_every);
+            header += '}';
+            index_stream_ << header << '\n';
+        }
+        if (!index_stream_) {
+            index_stream_.close();
+        }
+    }
+    return true;
+}
+
+bool event_log::should_rotate_locked(std::size_t line_size) const noexcept {
+    if (segment_bytes_ == 0u) {
+        return false;
+    }
+    if (file_layout_.rotate_bytes != 0u && segment_bytes_ + line_size + 1u > file_layout_.rotate_bytes) {
+        return true;
+    }
+    return file_layout_.rotate_after.count() != 0 &&
+           std::chrono::steady_clock::now() - segment_opened_ >= file_layout_.rotate_after;
+}
+
+bool event_log::write_file_line_locked(std::string_view type,
+                                       std::uint64_t seq,
+                                       std::optional<std::uint64_t> tick,
+                                       std::string_view line) {
+    if (tick.has_value()) {
+        last_file_tick_ = tick;
+    }
+    if (index_stream_.is_open() && segment_events_ % file_layout_.index_every == 0u) {
+        index_stream_ << "{\"seq\":" << seq << ",\"offset\":" << segment_bytes_;
+        if (last_file_tick_.has_value()) {
+            index_stream_ << ",\"tick\":" << *last_file_tick_;
+        }
+        index_stream_ << "}\n";
+    }
+    file_stream_ << line << '\n';
+    if (!file_stream_) {
+        close_file_locked();
+        return false;
+    }
+    segment_bytes_ += static_cast<std::uint64_t>(line.size()) + 1u;
+    ++segment_events_;
+    if (file_layout_.index_every != 0u) {
+        const auto it = segment_counts_.find(type);
+        if (it != segment_counts_.end()) {
+            ++it->second;
+        } else {
+            segment_counts_.emplace(std::string(type), 1u);
+        }
+    }
+    return true;
+}
+
+void event_log::close_file_locked() {
+    if (file_stream_.is_open()) {
         file_stream_.flush();
-        if (!file_stream_) {
-            file_stream_.close();
-            open_path_.clear();
+        file_stream_.close();
+    }
+    if (index_stream_.is_open()) {
+        // The last counts record in a sidecar covers the whole segment, including earlier opens.
+        index_stream_ << "{\"events\":" << segment_events_ << ",\"bytes\":" << segment_bytes_ << ",\"counts\":{";
+        bool first = true;
+        for (const auto& [type, count] : segment_counts_) {
+            index_stream_ << (first ? "\"" : ",\"") << json_escape(type) << "\":" << count;
+            first = false;
         }
+        index_stream_ << "}}\n";
+        index_stream_.close();
+    }
+    open_path_.clear();
+}
+
+event_log_batch_scope::event_log_batch_scope(event_log* events) noexcept : events_(events) {
+    if (events_) {
+        events_->begin_batch();
+    }
+}
+
+event_log_batch_scope::~event_log_batch_scope() {
+    if (events_) {
+        events_->end_batch();
     }
 }
 
@@ -729,6 +1288,8 @@ std::string event_log::node_kind_name(node_kind kind) {
             return "vla_wait";
         case node_kind::vla_cancel:
             return "vla_cancel";
+        case node_kind::vla_chunk:
+            return "vla_chunk";
         case node_kind::mem_seq:
             return "mem_seq";
         case node_kind::mem_sel:
@@ -739,6 +1300,8 @@ std::string event_log::node_kind_name(node_kind kind) {
             return "reactive_seq";
         case node_kind::reactive_sel:
             return "reactive_sel";
+        case node_kind::par:
+            return "par";
     }
     return "unknown";
 }
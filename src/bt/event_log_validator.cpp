@@ -0,0 +1,1083 @@
+#include "bt/event_log_validator.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include "bt/event_compact.hpp"
+#include "json_scan.hpp"
+
+namespace bt {
+namespace {
+
+using namespace json_scan;
+
+std::size_t utf8_length(std::string_view text) noexcept {
+    std::size_t count = 0;
+    for (const char c : text) {
+        if ((static_cast<unsigned char>(c) & 0xc0u) != 0x80u) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+std::string shorten(std::string_view text) {
+    constexpr std::size_t k_max = 80;
+    return text.size() <= k_max ? std::string(text) : std::string(text.substr(0, k_max)) + "...";
+}
+
+enum type_bit : std::uint8_t {
+    k_type_null = 1u << 0,
+    k_type_boolean = 1u << 1,
+    k_type_object = 1u << 2,
+    k_type_array = 1u << 3,
+    k_type_number = 1u << 4,
+    k_type_string = 1u << 5,
+    k_type_integer = 1u << 6,
+};
+
+}  // namespace
+
+struct event_schema::literal {
+    json_kind kind = json_kind::null;
+    bool flag = false;
+    double number = 0.0;
+    std::string text;
+    std::string source;
+};
+
+struct event_schema::node {
+    bool never = false;
+    std::uint8_t types = 0;
+    std::string type_names;
+    std::optional<literal> const_value;
+    std::vector<literal> enum_values;
+    std::optional<std::size_t> min_length;
+    std::optional<double> minimum;
+    std::optional<double> exclusive_minimum;
+    std::optional<double> maximum;
+    std::optional<double> exclusive_maximum;
+    std::vector<std::string> required;
+    std::vector<std::pair<std::string, std::uint32_t>> properties;
+    bool additional_forbidden = false;
+    std::uint32_t additional = k_none;
+    std::uint32_t items = k_none;
+    std::vector<std::uint32_t> all_of;
+    std::uint32_t if_schema = k_none;
+    std::uint32_t then_schema = k_none;
+    std::uint32_t else_schema = k_none;
+};
+
+event_schema::event_schema() = default;
+event_schema::event_schema(event_schema&&) noexcept = default;
+event_schema& event_schema::operator=(event_schema&&) noexcept = default;
+event_schema::~event_schema() = default;
+
+namespace {
+
+using schema_node = event_schema::node;
+using schema_literal = event_schema::literal;
+
+class schema_compiler {
+public:
+    explicit schema_compiler(const json_doc& doc) : doc_(doc) {}
+
+    std::uint32_t compile(std::uint32_t at, std::vector<schema_node>& out) {
+        const auto index = static_cast<std::uint32_t>(out.size());
+        out.emplace_back();
+        const json_node& n = doc_.at(at);
+        if (n.kind == json_kind::boolean) {
+            out[index].never = !n.flag;
+            return index;
+        }
+        if (n.kind != json_kind::object) {
+            throw std::runtime_error("event schema: subschemas must be objects or booleans");
+        }
+        for (std::uint32_t m = n.first_child; m != k_none; m = doc_.at(m).next_sibling) {
+            const std::string key = doc_.key_of(m);
+            if (key == "type") {
+                read_types(m, out[index]);
+            } else if (key == "const") {
+                out[index].const_value = read_literal(m);
+            } else if (key == "enum") {
+                expect(m, json_kind::array, key);
+                for (std::uint32_t e = doc_.at(m).first_child; e != k_none; e = doc_.at(e).next_sibling) {
+                    out[index].enum_values.push_back(read_literal(e));
+                }
+            } else if (key == "minLength") {
+                out[index].min_length = static_cast<std::size_t>(read_number(m, key));
+            } else if (key == "minimum") {
+                out[index].minimum = read_number(m, key);
+            } else if (key == "exclusiveMinimum") {
+                out[index].exclusive_minimum = read_number(m, key);
+            } else if (key == "maximum") {
+                out[index].maximum = read_number(m, key);
+            } else if (key == "exclusiveMaximum") {
+                out[index].exclusive_maximum = read_number(m, key);
+            } else if (key == "required") {
+                expect(m, json_kind::array, key);
+                for (std::uint32_t e = doc_.at(m).first_child; e != k_none; e = doc_.at(e).next_sibling) {
+                    expect(e, json_kind::string, key);
+                    out[index].required.push_back(doc_.string_value(e));
+                }
+            } else if (key == "properties") {
+                expect(m, json_kind::object, key);
+                for (std::uint32_t p = doc_.at(m).first_child; p != k_none; p = doc_.at(p).next_sibling) {
+                    const std::string name = doc_.key_of(p);
+                    const std::uint32_t child = compile(p, out);
+                    out[index].properties.emplace_back(name, child);
+                }
+            } else if (key == "additionalProperties") {
+                if (doc_.at(m).kind == json_kind::boolean) {
+                    out[index].additional_forbidden = !doc_.at(m).flag;
+                } else {
+                    const std::uint32_t child = compile(m, out);
+                    out[index].additional = child;
+                }
+            } else if (key == "items") {
+                const std::uint32_t child = compile(m, out);
+                out[index].items = child;
+            } else if (key == "allOf") {
+                expect(m, json_kind::array, key);
+                for (std::uint32_t e = doc_.at(m).first_child; e != k_none; e = doc_.at(e).next_sibling) {
+                    const std::uint32_t child = compile(e, out);
+                    out[index].all_of.push_back(child);
+                }
+            } else if (key == "if" || key == "then" || key == "else") {
+                const std::uint32_t child = compile(m, out);
+                (key == "if" ? out[index].if_schema : key == "then" ? out[index].then_schema : out[index].else_schema) =
+                    child;
+            } else if (key != "$schema" && key != "$id" && key != "$comment" && key != "title" &&
+                       key != "description" && key != "default" && key != "examples") {
+                throw std::runtime_error("event schema: unsupported keyword '" + key + "'");
+            }
+        }
+        return index;
+    }
+
+private:
+    void expect(std::uint32_t at, json_kind kind, const std::string& key) const {
+        if (doc_.at(at).kind != kind) {
+            throw std::runtime_error("event schema: malformed '" + key + "'");
+        }
+    }
+
+    double read_number(std::uint32_t at, const std::string& key) const {
+        expect(at, json_kind::number, key);
+        return number_value(doc_.at(at).text);
+    }
+
+    schema_literal read_literal(std::uint32_t at) const {
+        const json_node& n = doc_.at(at);
+        if (n.kind == json_kind::array || n.kind == json_kind::object) {
+            throw std::runtime_error("event schema: only scalar const and enum values are supported");
+        }
+        schema_literal out;
+        out.kind = n.kind;
+        out.flag = n.flag;
+        out.source = std::string(n.source);
+        if (n.kind == json_kind::number) {
+            out.number = number_value(n.text);
+        } else if (n.kind == json_kind::string) {
+            out.text = doc_.string_value(at);
+        }
+        return out;
+    }
+
+    void read_types(std::uint32_t at, schema_node& out) const {
+        const auto add = [&](std::uint32_t t) {
+            expect(t, json_kind::string, "type");
+            const std::string name = doc_.string_value(t);
+            static constexpr std::pair<std::string_view, std::uint8_t> k_types[] = {
+                {"null", k_type_null},     {"boolean", k_type_boolean}, {"object", k_type_object},
+                {"array", k_type_array},   {"number", k_type_number},   {"string", k_type_string},
+                {"integer", k_type_integer},
+            };
+            for (const auto& [type_name, bit] : k_types) {
+                if (name == type_name) {
+                    out.types |= bit;
+                    out.type_names += out.type_names.empty() ? "'" : ", '";
+                    out.type_names += name;
+                    out.type_names += "'";
+                    return;
+                }
+            }
+            throw std::runtime_error("event schema: unknown type '" + name + "'");
+        };
+        if (doc_.at(at).kind == json_kind::array) {
+            for (std::uint32_t t = doc_.at(at).first_child; t != k_none; t = doc_.at(t).next_sibling) {
+                add(t);
+            }
+        } else {
+            add(at);
+        }
+    }
+
+    const json_doc& doc_;
+};
+
+bool literal_matches(const json_doc& doc, std::uint32_t at, const schema_literal& lit) {
+    const json_node& n = doc.at(at);
+    if (n.kind != lit.kind) {
+        return false;
+    }
+    switch (n.kind) {
+        case json_kind::null:
+            return true;
+        case json_kind::boolean:
+            return n.flag == lit.flag;
+        case json_kind::number:
+            return number_value(n.text) == lit.number;
+        case json_kind::string:
+            return n.escaped ? doc.string_value(at) == lit.text : n.text == lit.text;
+        default:
+            return false;
+    }
+}
+
+bool type_matches(const json_doc& doc, std::uint32_t at, std::uint8_t types) {
+    const json_node& n = doc.at(at);
+    switch (n.kind) {
+        case json_kind::null:
+            return (types & k_type_null) != 0;
+        case json_kind::boolean:
+            return (types & k_type_boolean) != 0;
+        case json_kind::object:
+            return (types & k_type_object) != 0;
+        case json_kind::array:
+            return (types & k_type_array) != 0;
+        case json_kind::string:
+            return (types & k_type_string) != 0;
+        case json_kind::number: {
+            if ((types & k_type_number) != 0) {
+                return true;
+            }
+            if ((types & k_type_integer) == 0) {
+                return false;
+            }
+            // Draft 2020-12 counts 3.0 as an integer.
+            const double v = number_value(n.text);
+            return is_integer_literal(n.text) || (std::isfinite(v) && std::floor(v) == v);
+        }
+    }
+    return false;
+}
+
+std::string format_number(double v) {
+    std::ostringstream out;
+    out << v;
+    return out.str();
+}
+
+class schema_checker {
+public:
+    schema_checker(const std::vector<schema_node>& nodes, const json_doc& doc) : nodes_(nodes), doc_(doc) {}
+
+    // Appends "path: message" for each failure; with `errors` null, stops at the first one.
+    bool check(std::uint32_t at, std::uint32_t schema, std::string& path, std::vector<std::string>* errors) const {
+        const schema_node& s = nodes_[schema];
+        const json_node& n = doc_.at(at);
+        bool ok = true;
+        const auto fail = [&](const std::string& message) {
+            ok = false;
+            if (errors) {
+                errors->push_back((path.empty() ? std::string("<root>") : path) + ": " + message);
+            }
+            return errors != nullptr;  // keep going only when collecting
+        };
+
+        if (s.never && !fail("False schema does not allow " + shorten(n.source))) {
+            return false;
+        }
+        if (s.types != 0 && !type_matches(doc_, at, s.types)) {
+            if (!fail(shorten(n.source) + " is not of type " + s.type_names)) {
+                return false;
+            }
+        }
+        if (s.const_value && !literal_matches(doc_, at, *s.const_value) &&
+            !fail(s.const_value->source + " was expected")) {
+            return false;
+        }
+        if (!s.enum_values.empty() &&
+            std::none_of(s.enum_values.begin(), s.enum_values.end(), [&](const schema_literal& lit) {
+                return literal_matches(doc_, at, lit);
+            }) &&
+            !fail(shorten(n.source) + " is not one of the allowed values")) {
+            return false;
+        }
+        if (n.kind == json_kind::string && s.min_length) {
+            const std::size_t length = utf8_length(n.escaped ? std::string_view(doc_.string_value(at)) : n.text);
+            if (length < *s.min_length && !fail(shorten(n.source) + " is too short")) {
+                return false;
+            }
+        }
+        if (n.kind == json_kind::number) {
+            const double v = number_value(n.text);
+            if (s.minimum && v < *s.minimum &&
+                !fail(shorten(n.source) + " is less than the minimum of " + format_number(*s.minimum))) {
+                return false;
+            }
+            if (s.exclusive_minimum && v <= *s.exclusive_minimum &&
+                !fail(shorten(n.source) + " is less than or equal to the minimum of " +
+                      format_number(*s.exclusive_minimum))) {
+                return false;
+            }
+            if (s.maximum && v > *s.maximum &&
+                !fail(shorten(n.source) + " is greater than the maximum of " + format_number(*s.maximum))) {
+                return false;
+            }
+            if (s.exclusive_maximum && v >= *s.exclusive_maximum &&
+                !fail(shorten(n.source) + " is greater than or equal to the maximum of " +
+                      format_number(*s.exclusive_maximum))) {
+                return false;
+            }
+        }
+        if (n.kind == json_kind::object) {
+            for (const std::string& name : s.required) {
+                if (doc_.member(at, name) == k_none && !fail("'" + name + "' is a required property")) {
+                    return false;
+                }
+            }
+            for (std::uint32_t m = n.first_child; m != k_none; m = doc_.at(m).next_sibling) {
+                std::string decoded;
+                if (doc_.at(m).key_escaped) {
+                    decoded = doc_.key_of(m);
+                }
+                const std::string_view key = doc_.at(m).key_escaped ? std::string_view(decoded) : doc_.at(m).key;
+                const auto prop = std::find_if(s.properties.begin(), s.properties.end(), [&](const auto& p) {
+                    return p.first == key;
+                });
+                std::uint32_t child_schema = prop != s.properties.end() ? prop->second : s.additional;
+                if (prop == s.properties.end() && s.additional_forbidden) {
+                    if (!fail("Additional properties are not allowed ('" + std::string(key) + "' was unexpected)")) {
+                        return false;
+                    }
+                    continue;
+                }
+                if (child_schema == k_none) {
+                    continue;
+                }
+                const std::size_t saved = path.size();
+                if (!path.empty()) {
+                    path += '.';
+                }
+                path += key;
+                const bool child_ok = check(m, child_schema, path, errors);
+                path.resize(saved);
+                if (!child_ok) {
+                    ok = false;
+                    if (!errors) {
+                        return false;
+                    }
+                }
+            }
+        }
+        if (n.kind == json_kind::array && s.items != k_none) {
+            std::size_t index = 0;
+            for (std::uint32_t e = n.first_child; e != k_none; e = doc_.at(e).next_sibling, ++index) {
+                const std::size_t saved = path.size();
+                path += (path.empty() ? "" : ".") + std::to_string(index);
+                const bool child_ok = check(e, s.items, path, errors);
+                path.resize(saved);
+                if (!child_ok) {
+                    ok = false;
+                    if (!errors) {
+                        return false;
+                    }
+                }
+            }
+        }
+        for (const std::uint32_t sub : s.all_of) {
+            if (!check(at, sub, path, errors)) {
+                ok = false;
+                if (!errors) {
+                    return false;
+                }
+            }
+        }
+        if (s.if_schema != k_none) {
+            std::string probe_path = path;
+            const bool matched = check(at, s.if_schema, probe_path, nullptr);
+            const std::uint32_t branch = matched ? s.then_schema : s.else_schema;
+            if (branch != k_none && !check(at, branch, path, errors)) {
+                ok = false;
+            }
+        }
+        return ok;
+    }
+
+private:
+    const std::vector<schema_node>& nodes_;
+    const json_doc& doc_;
+};
+
+// The fields of one event that the cross-event checks read, mirroring trace_validator.load_trace.
+struct event_record {
+    std::size_t line_no = 0;
+    bool valid = false;
+    std::string type;
+    std::optional<std::int64_t> seq;
+    std::optional<std::int64_t> tick;
+    std::optional<std::int64_t> node_id;
+    std::optional<std::string> status;
+    std::optional<std::string> job_id;
+    std::optional<bool> accepted;
+    std::optional<double> tick_budget_ms;
+    std::optional<double> tick_elapsed_ms;
+};
+
+std::optional<double> payload_number(const json_doc& doc, std::uint32_t data, std::string_view a, std::string_view b = {}) {
+    std::uint32_t at = doc.member(data, a);
+    if (!b.empty()) {
+        at = doc.member(at, b);
+    }
+    return float_value(doc, at);
+}
+
+void extract_record(const json_doc& doc, event_record& out) {
+    const std::uint32_t root = 0;
+    out.valid = true;
+    const std::uint32_t type = doc.member(root, "type");
+    // Python's str() of the value; only strings are expected here.
+    out.type = type == k_none ? std::string{}
+               : doc.at(type).kind == json_kind::string ? doc.string_value(type)
+                                                        : std::string(doc.at(type).source);
+    out.seq = int_value(doc, doc.member(root, "seq"));
+    out.tick = int_value(doc, doc.member(root, "tick"));
+
+    const std::uint32_t data = doc.member(root, "data");
+    if (data == k_none || doc.at(data).kind != json_kind::object) {
+        return;
+    }
+    out.node_id = int_value(doc, doc.member(data, "node_id"));
+    const std::uint32_t status = doc.member(data, "status");
+    const std::uint32_t root_status = doc.member(data, "root_status");
+    if (status != k_none && doc.at(status).kind == json_kind::string) {
+        out.status = doc.string_value(status);
+    } else if (root_status != k_none && doc.at(root_status).kind == json_kind::string) {
+        out.status = doc.string_value(root_status);
+    } else if (const std::optional<std::int64_t> status_id = int_value(doc, doc.member(data, "status_id"))) {
+        // compact-ids logs; see bt/event_compact.hpp.
+        if (const std::optional<std::string_view> name = compact_status_name(*status_id)) {
+            out.status = std::string(*name);
+        }
+    }
+    const std::uint32_t job = doc.member(data, "job_id");
+    if (job != k_none && doc.at(job).kind != json_kind::null) {
+        const json_node& j = doc.at(job);
+        out.job_id = j.kind == json_kind::string ? doc.string_value(job)
+                     : j.kind == json_kind::boolean ? std::string(j.flag ? "True" : "False")
+                                                    : std::string(j.source);
+    }
+    const std::uint32_t accepted = doc.member(data, "accepted");
+    if (accepted != k_none && doc.at(accepted).kind == json_kind::boolean) {
+        out.accepted = doc.at(accepted).flag;
+    }
+    out.tick_budget_ms = payload_number(doc, data, "tick_budget_ms");
+    if (!out.tick_budget_ms) {
+        out.tick_budget_ms = payload_number(doc, data, "budget", "tick_budget_ms");
+    }
+    for (const auto& [a, b] : {std::pair<std::string_view, std::string_view>{"tick_ms", {}},
+                               {"tick_time_ms", {}},
+                               {"tick_elapsed_ms", {}},
+                               {"budget", "tick_time_ms"},
+                               {"budget", "tick_elapsed_ms"}}) {
+        out.tick_elapsed_ms = payload_number(doc, data, a, b);
+        if (out.tick_elapsed_ms) {
+            break;
+        }
+    }
+}
+
+// Sorted disjoint [first, last] ranges. Sequence numbers and tick ids are almost always contiguous, so
+// a whole log usually needs a single range.
+class interval_set {
+public:
+    [[nodiscard]] bool contains(std::int64_t v) const {
+        auto it = ranges_.upper_bound(v);
+        if (it == ranges_.begin()) {
+            return false;
+        }
+        --it;
+        return v <= it->second;
+    }
+
+    void insert(std::int64_t v) {
+        auto next = ranges_.upper_bound(v);
+        if (next != ranges_.begin()) {
+            auto prev = std::prev(next);
+            if (v <= prev->second) {
+                return;
+            }
+            if (prev->second + 1 == v) {
+                prev->second = v;
+                if (next != ranges_.end() && next->first == v + 1) {
+                    prev->second = next->second;
+                    ranges_.erase(next);
+                }
+                return;
+            }
+        }
+        if (next != ranges_.end() && next->first == v + 1) {
+            const std::int64_t last = next->second;
+            ranges_.erase(next);
+            ranges_.emplace(v, last);
+            return;
+        }
+        ranges_.emplace(v, v);
+    }
+
+private:
+    std::map<std::int64_t, std::int64_t> ranges_;
+};
+
+// Port of trace_validator.validate_trace for one streamed pass. Instead of keeping every event, a
+// tick keeps what the post-pass checks read (its tick_end budget fields, whether it saw
+// deadline_exceeded, and its cancel requests), and only while a check could still need it.
+class trace_checker {
+public:
+    trace_checker(bool tolerate_incomplete_tail, event_log_check_report& report)
+        : tolerate_incomplete_tail_(tolerate_incomplete_tail), report_(report) {}
+
+    void add(const event_record& e) {
+        ++report_.total_events;
+        if (e.node_id) {
+            distinct_nodes_.insert(*e.node_id);
+        }
+        if (e.job_id) {
+            async_jobs_.insert(*e.job_id);
+        }
+        check_seq(e);
+
+        if (e.type == "tick_begin") {
+            tick_begin(e);
+            return;
+        }
+        if (e.type == "tick_end") {
+            tick_end(e);
+            return;
+        }
+        if (e.tick) {
+            if (!open_) {
+                violate("tick_event_outside_delimiters", e, e.seq, e.tick,
+                        "event type " + e.type + " for tick " + std::to_string(*e.tick) +
+                            " occurred outside tick delimiters");
+            } else if (open_->tick != *e.tick) {
+                violate("tick_event_outside_delimiters", e, e.seq, e.tick,
+                        "event type " + e.type + " for tick " + std::to_string(*e.tick) + " occurred inside tick " +
+                            std::to_string(open_->tick));
+            } else {
+                if (e.type == "deadline_exceeded") {
+                    open_->has_deadline = true;
+                } else if (e.type == "async_cancel_requested" && e.seq && e.job_id) {
+                    open_->cancel_requests.emplace_back(*e.job_id, *e.seq);
+                }
+            }
+        }
+
+        if (e.type == "node_exit" && e.tick && e.node_id && e.status &&
+            (*e.status == "success" || *e.status == "failure")) {
+            const auto key = std::make_pair(*e.tick, *e.node_id);
+            if (++terminal_exits_[key] > 1) {
+                violate("duplicate_terminal_node_exit", e, e.seq, e.tick,
+                        "duplicate terminal node_exit for node " + std::to_string(*e.node_id) + " in tick " +
+                            std::to_string(*e.tick));
+            }
+        }
+        async_checks(e);
+    }
+
+    void finish() {
+        if (open_) {
+            if (tolerate_incomplete_tail_) {
+                report_.trace_truncated = true;
+            } else {
+                report_.violations.push_back(event_log_violation{
+                    .code = "missing_tick_end",
+                    .severity = "error",
+                    .message = "tick " + std::to_string(open_->tick) + " started but never emitted tick_end",
+                    .line_no = open_->begin_line,
+                    .seq = open_->begin_seq,
+                    .tick = open_->tick,
+                });
+            }
+        }
+
+        for (const auto& [tick, summary] : ended_) {
+            if (!summary.budget || !summary.elapsed) {
+                if (!summary.has_deadline) {
+                    report_.violations.push_back(event_log_violation{
+                        .code = "budget_check_not_evaluable",
+                        .severity = "info",
+                        .message = "tick " + std::to_string(tick) +
+                                   " does not expose enough budget timing fields for overrun validation",
+                        .line_no = summary.end_line,
+                        .seq = summary.end_seq,
+                        .tick = tick,
+                    });
+                }
+                continue;
+            }
+            if (*summary.elapsed > *summary.budget && !summary.has_deadline) {
+                report_.violations.push_back(event_log_violation{
+                    .code = "missing_deadline_exceeded",
+                    .severity = "error",
+                    .message = "over-budget tick " + std::to_string(tick) + " is missing deadline_exceeded",
+                    .line_no = summary.end_line,
+                    .seq = summary.end_seq,
+                    .tick = tick,
+                });
+            }
+        }
+
+        for (const deadline_snapshot& snapshot : deadlines_) {
+            const auto it = ended_.find(snapshot.tick);
+            if (it == ended_.end() || !completed_ticks_.contains(snapshot.tick)) {
+                continue;
+            }
+            const tick_summary& summary = it->second;
+            const bool over_budget = !summary.budget || !summary.elapsed || *summary.elapsed > *summary.budget;
+            if (!over_budget || snapshot.active_jobs.empty()) {
+                continue;
+            }
+            std::vector<std::string> missing;
+            for (const std::string& job : snapshot.active_jobs) {
+                const bool cancelled = snapshot.seq &&
+                                       std::any_of(summary.cancel_requests.begin(), summary.cancel_requests.end(),
+                                                   [&](const auto& request) {
+                                                       return request.first == job && request.second > *snapshot.seq;
+                                                   });
+                if (!cancelled) {
+                    missing.push_back(job);
+                }
+            }
+            if (missing.empty()) {
+                continue;
+            }
+            std::string joined;
+            for (const std::string& job : missing) {
+                joined += joined.empty() ? job : ", " + job;
+            }
+            report_.violations.push_back(event_log_violation{
+                .code = "missing_cancel_request_after_deadline",
+                .severity = "error",
+                .message = "deadline_exceeded in tick " + std::to_string(snapshot.tick) +
+                           " is missing async_cancel_requested for active job(s): " + joined,
+                .line_no = snapshot.line_no,
+                .seq = snapshot.seq,
+                .tick = snapshot.tick,
+            });
+        }
+
+        report_.completed_ticks = completed_count_;
+        report_.distinct_nodes = distinct_nodes_.size();
+        report_.async_jobs = async_jobs_.size();
+    }
+
+private:
+    struct open_tick {
+        std::int64_t tick = 0;
+        std::size_t begin_line = 0;
+        std::optional<std::int64_t> begin_seq;
+        bool has_deadline = false;
+        std::vector<std::pair<std::string, std::int64_t>> cancel_requests;
+    };
+
+    // What the post-pass needs from the latest completed occurrence of a tick id.
+    struct tick_summary {
+        std::size_t end_line = 0;
+        std::optional<std::int64_t> end_seq;
+        std::optional<double> budget;
+        std::optional<double> elapsed;
+        bool has_deadline = false;
+        std::vector<std::pair<std::string, std::int64_t>> cancel_requests;
+    };
+
+    struct deadline_snapshot {
+        std::int64_t tick = 0;
+        std::optional<std::int64_t> seq;
+        std::size_t line_no = 0;
+        std::vector<std::string> active_jobs;
+    };
+
+    struct async_job_state {
+        std::optional<std::int64_t> submit_seq;
+        std::optional<std::int64_t> cancel_request_seq;
+    };
+
+    void violate(std::string code,
+                 const event_record& e,
+                 std::optional<std::int64_t> seq,
+                 std::optional<std::int64_t> tick,
+                 std::string message) {
+        report_.violations.push_back(event_log_violation{
+            .code = std::move(code),
+            .severity = "error",
+            .message = std::move(message),
+            .line_no = e.line_no,
+            .seq = seq,
+            .tick = tick,
+        });
+    }
+
+    void check_seq(const event_record& e) {
+        if (!e.seq) {
+            violate("missing_seq", e, std::nullopt, e.tick, "event is missing seq");
+            return;
+        }
+        const std::int64_t seq = *e.seq;
+        if (!report_.first_seq) {
+            report_.first_seq = seq;
+        }
+        if (seen_seqs_.contains(seq)) {
+            violate("duplicate_seq", e, seq, e.tick, "duplicate seq " + std::to_string(seq));
+        } else {
+            seen_seqs_.insert(seq);
+        }
+        if (report_.last_seq && seq <= *report_.last_seq) {
+            violate("non_monotonic_seq", e, seq, e.tick,
+                    "seq " + std::to_string(seq) + " is not greater than previous seq " +
+                        std::to_string(*report_.last_seq));
+        }
+        report_.last_seq = seq;
+    }
+
+    void tick_begin(const event_record& e) {
+        if (!e.tick) {
+            violate("unexpected_missing_tick_id", e, e.seq, std::nullopt, "tick_begin is missing tick");
+            return;
+        }
+        const std::int64_t tick = *e.tick;
+        if (open_) {
+            violate(open_->tick == tick ? "duplicate_tick_begin" : "overlapping_ticks", e, e.seq, tick,
+                    "tick_begin for tick " + std::to_string(tick) + " arrived before tick " +
+                        std::to_string(open_->tick) + " closed");
+        }
+        if (completed_ticks_.contains(tick)) {
+            violate("duplicate_tick_id", e, e.seq, tick,
+                    "tick " + std::to_string(tick) + " was already completed earlier in the trace");
+        }
+        // A new begin replaces the tick's record, so an earlier completion no longer counts post-pass.
+        ended_.erase(tick);
+        open_ = open_tick{.tick = tick, .begin_line = e.line_no, .begin_seq = e.seq, .has_deadline = false, .cancel_requests = {}};
+    }
+
+    void tick_end(const event_record& e) {
+        if (!e.tick) {
+            violate("unexpected_missing_tick_id", e, e.seq, std::nullopt, "tick_end is missing tick");
+            return;
+        }
+        const std::int64_t tick = *e.tick;
+        if (!open_) {
+            violate(completed_ticks_.contains(tick) ? "duplicate_tick_end" : "missing_tick_begin", e, e.seq, tick,
+                    "tick_end for tick " + std::to_string(tick) + " does not have a matching open tick_begin");
+            return;
+        }
+        if (open_->tick != tick) {
+            violate("tick_event_outside_delimiters", e, e.seq, tick,
+                    "tick_end for tick " + std::to_string(tick) + " closed while tick " + std::to_string(open_->tick) +
+                        " was open");
+            return;
+        }
+        completed_ticks_.insert(tick);
+        ++completed_count_;
+        tick_summary summary{
+            .end_line = e.line_no,
+            .end_seq = e.seq,
+            .budget = e.tick_budget_ms,
+            .elapsed = e.tick_elapsed_ms,
+            .has_deadline = open_->has_deadline,
+            .cancel_requests = std::move(open_->cancel_requests),
+        };
+        open_.reset();
+        // Ticks that are within budget, and not named by a deadline snapshot, report nothing later.
+        const bool evaluable = summary.budget && summary.elapsed;
+        const bool quiet = evaluable ? *summary.elapsed <= *summary.budget || summary.has_deadline : summary.has_deadline;
+        if (quiet && !deadline_ticks_.contains(tick)) {
+            return;
+        }
+        ended_.insert_or_assign(tick, std::move(summary));
+    }
+
+    void async_checks(const event_record& e) {
+        if (!e.job_id) {
+            if (e.type == "deadline_exceeded" && e.tick) {
+                add_deadline_snapshot(e);
+            }
+            return;
+        }
+        const std::string& job = *e.job_id;
+        const auto error = [&](const std::string& code, const std::string& message) {
+            violate(code, e, e.seq, e.tick, message);
+        };
+        if (e.type == "vla_submit") {
+            active_jobs_.insert(job);
+            async_state_[job] = async_job_state{.submit_seq = e.seq, .cancel_request_seq = std::nullopt};
+        } else if (e.type == "deadline_exceeded" && e.tick) {
+            add_deadline_snapshot(e);
+        } else if (e.type == "async_cancel_requested") {
+            async_state_[job].cancel_request_seq = e.seq;
+        } else if (e.type == "async_cancel_acknowledged") {
+            async_job_state& state = async_state_[job];
+            if (!state.cancel_request_seq) {
+                error("async_cancel_ack_without_request",
+                      "async_cancel_acknowledged for job " + job + " occurred before async_cancel_requested");
+            }
+            if (e.accepted == true) {
+                active_jobs_.erase(job);
+            }
+        } else if ((e.type == "vla_poll" && e.status &&
+                    (*e.status == "done" || *e.status == "cancelled" || *e.status == "error" ||
+                     *e.status == "timeout")) ||
+                   e.type == "vla_result" || e.type == "async_completion_dropped") {
+            if (!async_state_[job].submit_seq) {
+                error("async_terminal_without_submit",
+                      "terminal async event " + e.type + " for job " + job + " occurred before vla_submit");
+            }
+            active_jobs_.erase(job);
+        }
+    }
+
+    void add_deadline_snapshot(const event_record& e) {
+        deadlines_.push_back(deadline_snapshot{
+            .tick = *e.tick,
+            .seq = e.seq,
+            .line_no = e.line_no,
+            .active_jobs = std::vector<std::string>(active_jobs_.begin(), active_jobs_.end()),
+        });
+        deadline_ticks_.insert(*e.tick);
+    }
+
+    bool tolerate_incomplete_tail_;
+    event_log_check_report& report_;
+    interval_set seen_seqs_;
+    interval_set completed_ticks_;
+    std::uint64_t completed_count_ = 0;
+    std::optional<open_tick> open_;
+    std::map<std::int64_t, tick_summary> ended_;
+    std::unordered_set<std::int64_t> deadline_ticks_;
+    std::vector<deadline_snapshot> deadlines_;
+    std::map<std::pair<std::int64_t, std::int64_t>, std::uint32_t> terminal_exits_;
+    std::unordered_set<std::int64_t> distinct_nodes_;
+    std::unordered_set<std::string> async_jobs_;
+    std::set<std::string> active_jobs_;
+    std::unordered_map<std::string, async_job_state> async_state_;
+};
+
+struct line_slice {
+    std::string_view text;
+    std::size_t line_no = 0;
+};
+
+// Parses and schema-checks lines[begin, end) into records; runs on a worker thread.
+void check_lines(const std::vector<line_slice>& lines,
+                 std::size_t begin,
+                 std::size_t end,
+                 const event_schema* schema,
+                 std::vector<event_record>& records,
+                 std::vector<event_log_violation>& violations) {
+    json_doc doc;
+    std::vector<std::string> errors;
+    std::string path;
+    for (std::size_t i = begin; i < end; ++i) {
+        event_record& record = records[i];
+        record = event_record{};
+        record.line_no = lines[i].line_no;
+        if (!doc.parse(lines[i].text)) {
+            violations.push_back(event_log_violation{.code = "invalid_json",
+                                                     .severity = "error",
+                                                     .message = "invalid JSON",
+                                                     .line_no = record.line_no,
+                                                     .seq = std::nullopt,
+                                                     .tick = std::nullopt});
+            continue;
+        }
+        if (doc.at(0).kind != json_kind::object) {
+            violations.push_back(event_log_violation{.code = "invalid_json",
+                                                     .severity = "error",
+                                                     .message = "event is not a JSON object",
+                                                     .line_no = record.line_no,
+                                                     .seq = std::nullopt,
+                                                     .tick = std::nullopt});
+            continue;
+        }
+        extract_record(doc, record);
+        if (!schema) {
+            continue;
+        }
+        const std::uint32_t version = doc.member(0, "schema");
+        if (version == k_none || doc.at(version).kind != json_kind::string || doc.string_value(version) != "mbt.evt.v1") {
+            violations.push_back(event_log_violation{
+                .code = "unsupported_schema",
+                .severity = "error",
+                .message = "unsupported schema '" + (version == k_none ? std::string("None") : std::string(doc.at(version).source)) +
+                           "', expected 'mbt.evt.v1'",
+                .line_no = record.line_no,
+                .seq = record.seq,
+                .tick = record.tick,
+            });
+            continue;
+        }
+        errors.clear();
+        path.clear();
+        schema_checker(schema->nodes(), doc).check(0, 0, path, &errors);
+        for (std::string& message : errors) {
+            violations.push_back(event_log_violation{
+                .code = "schema_violation",
+                .severity = "error",
+                .message = std::move(message),
+                .line_no = record.line_no,
+                .seq = record.seq,
+                .tick = record.tick,
+            });
+        }
+    }
+}
+
+bool is_blank(std::string_view line) noexcept {
+    return line.find_first_not_of(" \t\r\n\f\v") == std::string_view::npos;
+}
+
+}  // namespace
+
+event_schema event_schema::parse(std::string_view json_text) {
+    json_doc doc;
+    if (!doc.parse(json_text)) {
+        throw std::runtime_error("event schema: invalid JSON");
+    }
+    event_schema out;
+    schema_compiler(doc).compile(0, out.nodes_);
+    return out;
+}
+
+event_schema event_schema::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("event schema: cannot open " + path);
+    }
+    std::ostringstream text;
+    text << in.rdbuf();
+    return parse(text.str());
+}
+
+std::size_t event_log_check_report::error_count() const noexcept {
+    return static_cast<std::size_t>(std::count_if(violations.begin(), violations.end(), [](const auto& v) {
+        return v.severity == "error";
+    }));
+}
+
+event_log_check_report check_event_log(std::istream& in, const event_log_check_options& options) {
+    event_log_check_report report;
+    std::vector<event_log_violation> schema_violations;
+    trace_checker trace(options.tolerate_incomplete_tail, report);
+    // The trace checker writes into report.violations; schema and JSON errors are kept apart and
+    // placed first at the end.
+    const std::size_t worker_count = std::max<std::size_t>(
+        1, options.threads != 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency()));
+    const std::size_t chunk_bytes = std::max<std::size_t>(options.chunk_bytes, 4096);
+
+    std::string buffer;
+    std::size_t filled = 0;
+    std::size_t next_line_no = 1;
+    std::vector<line_slice> lines;
+    std::vector<event_record> records;
+    std::vector<std::vector<event_log_violation>> worker_violations(worker_count);
+    bool eof = false;
+    while (!eof) {
+        if (buffer.size() < filled + chunk_bytes) {
+            buffer.resize(filled + chunk_bytes);
+        }
+        in.read(buffer.data() + filled, static_cast<std::streamsize>(buffer.size() - filled));
+        filled += static_cast<std::size_t>(in.gcount());
+        eof = !in;
+        std::string_view data(buffer.data(), filled);
+        std::size_t usable = eof ? filled : data.rfind('\n') + 1;
+        if (!eof && usable == 0) {
+            continue;  // a line longer than the buffer: read more before splitting
+        }
+
+        lines.clear();
+        std::size_t pos = 0;
+        while (pos < usable) {
+            std::size_t end = data.find('\n', pos);
+            if (end == std::string_view::npos || end >= usable) {
+                end = usable;
+            }
+            const std::string_view line = data.substr(pos, end - pos);
+            if (!is_blank(line)) {
+                lines.push_back(line_slice{line, next_line_no});
+            }
+            ++next_line_no;
+            pos = end + 1;
+        }
+
+        records.resize(lines.size());
+        const std::size_t workers = std::min(worker_count, std::max<std::size_t>(1, lines.size() / 256));
+        const std::size_t per_worker = (lines.size() + workers - 1) / std::max<std::size_t>(workers, 1);
+        std::vector<std::thread> threads;
+        for (std::size_t w = 1; w < workers; ++w) {
+            const std::size_t begin = std::min(lines.size(), w * per_worker);
+            const std::size_t end = std::min(lines.size(), begin + per_worker);
+            threads.emplace_back(check_lines, std::cref(lines), begin, end, options.schema, std::ref(records),
+                                 std::ref(worker_violations[w]));
+        }
+        check_lines(lines, 0, std::min(lines.size(), per_worker), options.schema, records, worker_violations[0]);
+        for (std::thread& t : threads) {
+            t.join();
+        }
+        // Workers cover consecutive line ranges, so concatenating keeps line order.
+        for (std::vector<event_log_violation>& found : worker_violations) {
+            std::move(found.begin(), found.end(), std::back_inserter(schema_violations));
+            found.clear();
+        }
+        if (options.check_trace) {
+            for (const event_record& record : records) {
+                if (record.valid) {
+                    trace.add(record);
+                }
+            }
+        } else {
+            for (const event_record& record : records) {
+                report.total_events += record.valid ? 1u : 0u;
+            }
+        }
+
+        // Keep the partial last line for the next read.
+        if (usable < filled) {
+            std::memmove(buffer.data(), buffer.data() + usable, filled - usable);
+        }
+        filled -= usable;
+    }
+    if (options.check_trace) {
+        trace.finish();
+    }
+
+    schema_violations.reserve(schema_violations.size() + report.violations.size());
+    std::move(report.violations.begin(), report.violations.end(), std::back_inserter(schema_violations));
+    report.violations = std::move(schema_violations);
+    report.passed = report.error_count() == 0;
+    return report;
+}
+
+event_log_check_report check_event_log_file(const std::string& path, const event_log_check_options& options) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("log file not found: " + path);
+    }
+    return check_event_log(in, options);
+}
+
+}  // namespace bt
@@ -0,0 +1,259 @@
+#include "bt/frame_ring.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace bt {
+namespace {
+
+constexpr char k_magic[8] = {'M', 'B', 'T', 'F', 'R', 'A', 'M', 'E'};
+constexpr std::uint32_t k_version = 1;
+constexpr std::size_t k_header_bytes = 64;
+constexpr std::size_t k_slot_header_bytes = 128;
+constexpr std::size_t k_encoding_bytes = 16;
+
+struct ring_header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t slot_count;
+    std::uint64_t slot_bytes;
+    std::atomic<std::uint64_t> next_sequence;
+};
+static_assert(sizeof(ring_header) <= k_header_bytes);
+
+struct slot_header {
+    std::atomic<std::uint64_t> lock;
+    std::uint64_t sequence;
+    std::uint64_t size;
+    std::int64_t width;
+    std::int64_t height;
+    std::int64_t channels;
+    std::int64_t timestamp_ms;
+    char encoding[k_encoding_bytes];
+};
+static_assert(sizeof(slot_header) <= k_slot_header_bytes);
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+std::size_t round_up_64(std::size_t n) {
+    return (n + 63) & ~static_cast<std::size_t>(63);
+}
+
+std::string shm_object_name(const std::string& name) {
+    if (name.empty() || name.find('/') != std::string::npos) {
+        throw std::runtime_error("frame ring name must be non-empty and must not contain '/'");
+    }
+    return "/" + name;
+}
+
+ring_header* header_of(void* base) {
+    return static_cast<ring_header*>(base);
+}
+
+}  // namespace
+
+#if defined(_WIN32)
+
+std::shared_ptr<frame_ring> frame_ring::create(std::string, std::size_t, std::size_t) {
+    throw std::runtime_error("frame ring: shared memory is not supported on this platform");
+}
+
+std::shared_ptr<frame_ring> frame_ring::open(std::string) {
+    throw std::runtime_error("frame ring: shared memory is not supported on this platform");
+}
+
+frame_ring::~frame_ring() = default;
+
+#else
+
+std::shared_ptr<frame_ring> frame_ring::create(std::string name, std::size_t slot_count, std::size_t slot_bytes) {
+    if (slot_count == 0 || slot_bytes == 0 || slot_count > 0xffffffffu) {
+        throw std::runtime_error("frame ring: slot_count and slot_bytes must be > 0");
+    }
+    const std::string object = shm_object_name(name);
+    const std::size_t stride = k_slot_header_bytes + round_up_64(slot_bytes);
+    const std::size_t total = k_header_bytes + slot_count * stride;
+
+    (void)::shm_unlink(object.c_str());
+    const int fd = ::shm_open(object.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        throw std::runtime_error("frame ring: shm_open failed for " + object + ": " + std::strerror(errno));
+    }
+    if (::ftruncate(fd, static_cast<off_t>(total)) != 0) {
+        const std::string error = std::strerror(errno);
+        (void)::close(fd);
+        (void)::shm_unlink(object.c_str());
+        throw std::runtime_error("frame ring: ftruncate failed: " + error);
+    }
+    void* base = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    (void)::close(fd);
+    if (base == MAP_FAILED) {
+        (void)::shm_unlink(object.c_str());
+        throw std::runtime_error("frame ring: mmap failed");
+    }
+
+    // ftruncate zero-fills, so every slot starts unlocked with no frame.
+    ring_header* header = header_of(base);
+    header->version = k_version;
+    header->slot_count = static_cast<std::uint32_t>(slot_count);
+    header->slot_bytes = slot_bytes;
+    header->next_sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header->magic, k_magic, sizeof(k_magic));
+    return std::shared_ptr<frame_ring>(new frame_ring(std::move(name), base, total, true));
+}
+
+std::shared_ptr<frame_ring> frame_ring::open(std::string name) {
+    const std::string object = shm_object_name(name);
+    const int fd = ::shm_open(object.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        throw std::runtime_error("frame ring: cannot open " + object + ": " + std::strerror(errno));
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < k_header_bytes) {
+        (void)::close(fd);
+        throw std::runtime_error("frame ring: " + object + " is too small to be a frame ring");
+    }
+    const auto total = static_cast<std::size_t>(st.st_size);
+    // Readers never write, but atomic loads on a PROT_READ mapping are not portable.
+    void* base = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    (void)::close(fd);
+    if (base == MAP_FAILED) {
+        throw std::runtime_error("frame ring: mmap failed");
+    }
+    const ring_header* header = header_of(base);
+    const std::size_t stride = k_slot_header_bytes + round_up_64(header->slot_bytes);
+    if (std::memcmp(header->magic, k_magic, sizeof(k_magic)) != 0 || header->version != k_version ||
+        total < k_header_bytes + header->slot_count * stride) {
+        (void)::munmap(base, total);
+        throw std::runtime_error("frame ring: " + object + " is not a version 1 frame ring");
+    }
+    return std::shared_ptr<frame_ring>(new frame_ring(std::move(name), base, total, false));
+}
+
+frame_ring::~frame_ring() {
+    if (base_ != nullptr) {
+        (void)::munmap(base_, mapped_bytes_);
+    }
+    if (owner_) {
+        (void)::shm_unlink(shm_object_name(name_).c_str());
+    }
+}
+
+#endif
+
+frame_ring::frame_ring(std::string name, void* base, std::size_t mapped_bytes, bool owner)
+    : name_(std::move(name)), base_(base), mapped_bytes_(mapped_bytes), owner_(owner) {
+    const ring_header* header = header_of(base_);
+    slot_count_ = header->slot_count;
+    slot_bytes_ = static_cast<std::size_t>(header->slot_bytes);
+    slot_stride_ = k_slot_header_bytes + round_up_64(slot_bytes_);
+}
+
+std::byte* frame_ring::slot(std::uint64_t sequence) const noexcept {
+    return static_cast<std::byte*>(base_) + k_header_bytes + (sequence % slot_count_) * slot_stride_;
+}
+
+std::uint64_t frame_ring::next_sequence() const noexcept {
+    return header_of(base_)->next_sequence.load(std::memory_order_acquire);
+}
+
+std::uint64_t frame_ring::publish(std::span<const std::byte> bytes, const frame_ring_meta& meta) {
+    if (!owner_) {
+        throw std::logic_error("frame ring: publish on a ring opened for reading");
+    }
+    if (bytes.size() > slot_bytes_) {
+        throw std::length_error("frame ring: frame of " + std::to_string(bytes.size()) + " bytes exceeds slot_bytes " +
+                                std::to_string(slot_bytes_));
+    }
+    ring_header* header = header_of(base_);
+    const std::uint64_t sequence = header->next_sequence.load(std::memory_order_relaxed);
+    std::byte* base = slot(sequence);
+    auto* sh = reinterpret_cast<slot_header*>(base);
+
+    const std::uint64_t lock = sh->lock.load(std::memory_order_relaxed);
+    sh->lock.store(lock + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    sh->sequence = sequence;
+    sh->size = bytes.size();
+    sh->width = meta.width;
+    sh->height = meta.height;
+    sh->channels = meta.channels;
+    sh->timestamp_ms = meta.timestamp_ms;
+    std::memset(sh->encoding, 0, sizeof(sh->encoding));
+    std::memcpy(sh->encoding, meta.encoding.data(), std::min(meta.encoding.size(), sizeof(sh->encoding) - 1));
+    if (!bytes.empty()) {
+        std::memcpy(base + k_slot_header_bytes, bytes.data(), bytes.size());
+    }
+    sh->lock.store(lock + 2, std::memory_order_release);
+    header->next_sequence.store(sequence + 1, std::memory_order_release);
+    return sequence;
+}
+
+bool frame_ring::read(std::uint64_t sequence, std::vector<std::byte>& out, frame_ring_meta* meta) const {
+    if (sequence >= next_sequence()) {
+        return false;
+    }
+    const std::byte* base = slot(sequence);
+    const auto* sh = reinterpret_cast<const slot_header*>(base);
+    const std::uint64_t before = sh->lock.load(std::memory_order_acquire);
+    if ((before & 1u) != 0 || sh->sequence != sequence) {
+        return false;
+    }
+    const auto size = static_cast<std::size_t>(std::min<std::uint64_t>(sh->size, slot_bytes_));
+    out.resize(size);
+    if (size != 0) {
+        std::memcpy(out.data(), base + k_slot_header_bytes, size);
+    }
+    frame_ring_meta copied;
+    copied.width = sh->width;
+    copied.height = sh->height;
+    copied.channels = sh->channels;
+    copied.timestamp_ms = sh->timestamp_ms;
+    copied.encoding.assign(sh->encoding, strnlen(sh->encoding, sizeof(sh->encoding)));
+    const std::uint64_t copied_sequence = sh->sequence;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (sh->lock.load(std::memory_order_relaxed) != before || copied_sequence != sequence) {
+        return false;
+    }
+    if (meta != nullptr) {
+        *meta = std::move(copied);
+    }
+    return true;
+}
+
+std::string frame_ring::ref(std::uint64_t sequence) const {
+    return "shm://" + name_ + "/" + std::to_string(sequence);
+}
+
+std::optional<std::pair<std::string, std::uint64_t>> parse_frame_ring_ref(const std::string& ref) {
+    constexpr std::string_view prefix = "shm://";
+    if (ref.rfind(prefix, 0) != 0) {
+        return std::nullopt;
+    }
+    const std::size_t slash = ref.find('/', prefix.size());
+    if (slash == std::string::npos || slash == prefix.size() || slash + 1 == ref.size()) {
+        return std::nullopt;
+    }
+    std::uint64_t sequence = 0;
+    for (std::size_t i = slash + 1; i < ref.size(); ++i) {
+        if (ref[i] < '0' || ref[i] > '9') {
+            return std::nullopt;
+        }
+        sequence = sequence * 10 + static_cast<std::uint64_t>(ref[i] - '0');
+    }
+    return std::pair<std::string, std::uint64_t>(ref.substr(prefix.size(), slash - prefix.size()), sequence);
+}
+
+}  // namespace bt
@@ -1,18 +1,423 @@
 #include "bt/instance.hpp"
 
+#include <algorithm>
+#include <optional>
+#include <string>
+
+#include "muslisp/gc.hpp"
+
 namespace bt {
+namespace {
+
+muslisp::value materialize_arg(const arg_value& arg) {
+    switch (arg.kind) {
+        case arg_kind::nil:
+            return muslisp::make_nil();
+        case arg_kind::boolean:
+            return muslisp::make_boolean(arg.bool_v);
+        case arg_kind::integer:
+            return muslisp::make_integer(arg.int_v);
+        case arg_kind::floating:
+            return muslisp::make_float(arg.float_v);
+        case arg_kind::symbol:
+            return muslisp::make_symbol(arg.text);
+        case arg_kind::string:
+            return muslisp::make_string(arg.text);
+    }
+    return muslisp::make_nil();
+}
+
+// Read sets larger than this are not worth comparing on every visit; such subtrees are re-ticked.
+constexpr std::size_t k_max_memo_reads = 64;
+
+bool memoisable_composite(node_kind kind) noexcept {
+    switch (kind) {
+        case node_kind::seq:
+        case node_kind::sel:
+        case node_kind::invert:
+        case node_kind::reactive_seq:
+        case node_kind::reactive_sel:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Leaf read set, or nullopt when the leaf is not pure.
+std::optional<std::vector<bb_slot>> leaf_reads(instance& inst, const registry& reg, const node& n) {
+    if (n.kind == node_kind::succeed || n.kind == node_kind::fail) {
+        return std::vector<bb_slot>{};
+    }
+    if (n.kind != node_kind::cond || inst.leaf_binding(n.id) == registry::k_unbound) {
+        return std::nullopt;
+    }
+    const registry::condition_entry& entry = reg.condition_at(inst.leaf_binding(n.id));
+    if (!entry.reads || (entry.native.invoke && !inst.native_leaf_args(n.id))) {
+        return std::nullopt;
+    }
+    std::vector<bb_slot> reads;
+    for (const std::size_t pos : entry.reads->key_args) {
+        if (pos >= n.args.size()) {
+            continue;
+        }
+        const arg_value& arg = n.args[pos];
+        if (arg.kind != arg_kind::symbol && arg.kind != arg_kind::string) {
+            return std::nullopt;
+        }
+        reads.push_back(inst.bb.intern(arg.text));
+    }
+    for (const std::string& key : entry.reads->keys) {
+        reads.push_back(inst.bb.intern(key));
+    }
+    return reads;
+}
+
+// Marks pure subtrees bottom-up from the root and stores each one's deduplicated read set.
+void build_node_memos(instance& inst, const registry& reg) {
+    const definition& def = *inst.def;
+    inst.node_memos.assign(def.nodes.size(), node_memo{});
+    std::vector<std::pair<node_id, bool>> stack{{def.root, false}};
+    std::vector<bb_slot> reads;
+    while (!stack.empty()) {
+        const auto [id, expanded] = stack.back();
+        stack.pop_back();
+        const node& n = def.nodes[id];
+        if (!expanded && memoisable_composite(n.kind)) {
+            stack.emplace_back(id, true);
+            for (const node_id child : n.children) {
+                stack.emplace_back(child, false);
+            }
+            continue;
+        }
+
+        reads.clear();
+        if (memoisable_composite(n.kind)) {
+            bool pure = true;
+            for (const node_id child : n.children) {
+                const node_memo& child_memo = inst.node_memos[child];
+                if (!child_memo.pure) {
+                    pure = false;
+                    break;
+                }
+                reads.insert(reads.end(),
+                             inst.memo_reads.begin() + child_memo.reads_offset,
+                             inst.memo_reads.begin() + child_memo.reads_offset + child_memo.reads_count);
+            }
+            if (!pure) {
+                continue;
+            }
+        } else if (std::optional<std::vector<bb_slot>> leaf = leaf_reads(inst, reg, n)) {
+            reads = std::move(*leaf);
+        } else {
+            continue;
+        }
+
+        std::sort(reads.begin(), reads.end());
+        reads.erase(std::unique(reads.begin(), reads.end()), reads.end());
+        if (reads.size() > k_max_memo_reads) {
+            continue;
+        }
+        node_memo& memo = inst.node_memos[id];
+        memo.pure = true;
+        memo.reads_offset = static_cast<std::uint32_t>(inst.memo_reads.size());
+        memo.reads_count = static_cast<std::uint32_t>(reads.size());
+        inst.memo_reads.insert(inst.memo_reads.end(), reads.begin(), reads.end());
+    }
+}
+
+// Union of the read sets of every condition leaf, which are the only leaves whose result decides
+// which branch runs. Falls back to watching every slot when a condition's reads are not declared.
+void build_wake_reads(instance& inst, const registry& reg) {
+    inst.wake_reads.clear();
+    inst.wake_on_any_write = false;
+    for (const node& n : inst.def->nodes) {
+        if (n.kind != node_kind::cond) {
+            continue;
+        }
+        std::optional<std::vector<bb_slot>> reads = leaf_reads(inst, reg, n);
+        if (!reads) {
+            inst.wake_on_any_write = true;
+            inst.wake_reads.clear();
+            break;
+        }
+        inst.wake_reads.insert(inst.wake_reads.end(), reads->begin(), reads->end());
+    }
+    std::sort(inst.wake_reads.begin(), inst.wake_reads.end());
+    inst.wake_reads.erase(std::unique(inst.wake_reads.begin(), inst.wake_reads.end()), inst.wake_reads.end());
+    inst.bb.watch(inst.waker, inst.wake_reads, inst.wake_on_any_write);
+}
 
-instance::instance(const definition* definition_ptr, std::size_t trace_capacity) : def(definition_ptr), trace(trace_capacity) {
+// Whether a node that is not bound to a native callback can reach Lisp code or Lisp values: span and
+// coroutine leaves get Lisp arguments, and plan-action and the vla-* nodes build Lisp values.
+bool may_run_lisp(node_kind kind) noexcept {
+    switch (kind) {
+        case node_kind::cond:
+        case node_kind::act:
+        case node_kind::plan_action:
+        case node_kind::vla_request:
+        case node_kind::vla_wait:
+        case node_kind::vla_cancel:
+        case node_kind::vla_chunk:
+            return true;
+        default:
+            return false;
+    }
+}
+
+std::shared_ptr<const leaf_link_table> build_leaf_links(const definition* def, const registry& reg) {
+    auto table = std::make_shared<leaf_link_table>();
+    table->def = def;
+    table->generation = reg.generation();
+    const std::size_t node_count = def ? def->nodes.size() : 0u;
+    table->bindings.assign(node_count, registry::k_unbound);
+    for (std::size_t i = 0; i < node_count; ++i) {
+        const node& n = def->nodes[i];
+        std::span<const native_arg_type> signature;
+        bool native = false;
+        if (n.kind == node_kind::cond) {
+            table->bindings[i] = reg.condition_index(n.leaf_name);
+            if (table->bindings[i] != registry::k_unbound) {
+                const auto& entry = reg.condition_at(table->bindings[i]).native;
+                native = entry.invoke != nullptr;
+                signature = entry.signature;
+            }
+        } else if (n.kind == node_kind::act) {
+            table->bindings[i] = reg.action_index(n.leaf_name);
+            if (table->bindings[i] != registry::k_unbound) {
+                const auto& entry = reg.action_at(table->bindings[i]).native;
+                native = entry.invoke != nullptr;
+                signature = entry.signature;
+            }
+        }
+        if (!native) {
+            table->native_only = table->native_only && !may_run_lisp(n.kind);
+            continue;
+        }
+        if (table->native_arg_ranges.empty()) {
+            table->native_arg_ranges.resize(node_count);
+        }
+        native_arg_range& range = table->native_arg_ranges[i];
+        range.offset = static_cast<std::uint32_t>(table->native_args.size());
+        range.valid = registry::decode_native_args(signature, n.args, table->native_args);
+        range.count = static_cast<std::uint32_t>(table->native_args.size()) - range.offset;
+        table->native_only = table->native_only && range.valid;
+    }
+    return table;
+}
+
+}  // namespace
+
+leaf_arg_table::leaf_arg_table(const definition& definition_ref) : def(&definition_ref) {
+    const std::size_t node_count = def->nodes.size();
+    offsets.assign(node_count + 1u, 0u);
+    std::size_t arg_count = 0;
+    for (std::size_t i = 0; i < node_count; ++i) {
+        offsets[i] = static_cast<std::uint32_t>(arg_count);
+        arg_count += def->nodes[i].args.size();
+    }
+    offsets[node_count] = static_cast<std::uint32_t>(arg_count);
+
+    // Allocation only requests a collection, so values stay reachable until the range is rooted below.
+    values.reserve(arg_count);
+    for (const node& n : def->nodes) {
+        for (const arg_value& compiled : n.args) {
+            values.push_back(materialize_arg(compiled));
+        }
+    }
+    if (!values.empty()) {
+        muslisp::default_gc().add_root_range(values.data(), values.size());
+    }
+}
+
+leaf_arg_table::~leaf_arg_table() {
+    if (!values.empty()) {
+        muslisp::default_gc().remove_root_range(values.data());
+    }
+}
+
+std::span<const muslisp::value> leaf_arg_table::args(node_id id) const noexcept {
+    if (static_cast<std::size_t>(id) + 1u >= offsets.size()) {
+        return {};
+    }
+    const std::uint32_t begin = offsets[id];
+    const std::uint32_t end = offsets[id + 1u];
+    return std::span<const muslisp::value>(values.data() + begin, end - begin);
+}
+
+instance::instance(const definition* definition_ptr, std::size_t trace_capacity)
+    : instance(definition_ptr, nullptr, trace_capacity) {}
+
+instance::instance(const definition* definition_ptr,
+                   std::shared_ptr<const leaf_arg_table> shared_leaf_args,
+                   std::size_t trace_capacity)
+    : def(definition_ptr), trace(trace_capacity) {
     if (!def) {
         return;
     }
 
     const std::size_t node_count = def->nodes.size();
-    memory.reserve(node_count);
     active_vla_jobs.reserve(node_count);
     halt_warning_emitted.reserve(node_count);
-    node_stats.reserve(node_count);
     halt_stack.reserve(node_count);
+    if (shared_leaf_args && shared_leaf_args->def == def) {
+        leaf_arg_values = std::move(shared_leaf_args);
+    }
+    prepare_node_slots();
+}
+
+instance::~instance() = default;
+
+void instance::prepare_node_slots() {
+    if (slots_def == def) {
+        return;
+    }
+    slots_def = def;
+    leaf_links.reset();
+    leaf_bindings_generation = 0;
+    node_memos.clear();
+    memo_reads.clear();
+
+    const std::size_t node_count = def ? def->nodes.size() : 0u;
+    memory.clear();
+    memory.resize(node_count);
+    memory_touched.assign(node_count, 0u);
+    live_memory_nodes.assign(node_count, 0u);
+    node_parents.assign(node_count, k_no_parent);
+    job_watchers.assign(node_count, 0u);
+    // Value-initialised in place: copying a prototype would copy every latency histogram bucket.
+    node_stats.clear();
+    node_stats.resize(node_count);
+    for (std::size_t i = 0; i < node_count; ++i) {
+        const node& n = def->nodes[i];
+        node_profile_stats& stats = node_stats[i];
+        stats.id = n.id;
+        stats.name = n.leaf_name.empty() ? std::string("node-") + std::to_string(n.id) : n.leaf_name;
+        for (const node_id child : n.children) {
+            node_parents[child] = static_cast<node_id>(i);
+        }
+    }
+
+    if (!def) {
+        leaf_arg_values.reset();
+    } else if (!leaf_arg_values || leaf_arg_values->def != def) {
+        leaf_arg_values = std::make_shared<const leaf_arg_table>(*def);
+    }
+
+    bb_key_slots.clear();
+    if (def) {
+        bb_key_slots.reserve(def->bb_keys.size());
+        for (const std::string& key : def->bb_keys) {
+            bb_key_slots.push_back(bb.intern(key));
+        }
+    }
+}
+
+std::string instance::uncopyable_state() const {
+    if (!active_vla_jobs.empty() || !vla_prefetches.empty() || !vla_chunks.empty()) {
+        return "VLA jobs are in flight";
+    }
+    for (std::size_t id = 0; id < memory.size(); ++id) {
+        if (memory[id].payload.has_value()) {
+            return "node " + std::to_string(id) + " holds a leaf payload";
+        }
+        if (memory[id].task) {
+            return "node " + std::to_string(id) + " has a suspended coroutine action";
+        }
+    }
+    return {};
+}
+
+void instance::touch_memory(node_id id) noexcept {
+    if (memory_touched[id] != 0u) {
+        return;
+    }
+    memory_touched[id] = 1u;
+    for (node_id at = id; at != k_no_parent; at = node_parents[at]) {
+        ++live_memory_nodes[at];
+    }
+}
+
+void instance::release_idle_memory(node_id id) noexcept {
+    if (memory_touched[id] == 0u) {
+        return;
+    }
+    const node_memory& mem = memory[id];
+    if (mem.i0 != 0 || mem.i1 != 0 || mem.b0 || mem.job_notified || mem.payload.has_value() || mem.task) {
+        return;
+    }
+    memory_touched[id] = 0u;
+    for (node_id at = id; at != k_no_parent; at = node_parents[at]) {
+        --live_memory_nodes[at];
+    }
+}
+
+void instance::clear_node_stats() noexcept {
+    for (node_profile_stats& stats : node_stats) {
+        if (stats.tick_duration.count == 0 && stats.running_returns == 0 && stats.success_returns == 0 &&
+            stats.failure_returns == 0 && stats.alloc_objects == 0) {
+            continue;
+        }
+        if (stats.tick_duration.count != 0) {
+            stats.tick_duration.histogram.reset();
+        }
+        stats.tick_duration.count = 0;
+        stats.tick_duration.last = std::chrono::nanoseconds{0};
+        stats.tick_duration.max = std::chrono::nanoseconds{0};
+        stats.tick_duration.total = std::chrono::nanoseconds{0};
+        stats.tick_duration.over_budget_count = 0;
+        stats.running_returns = 0;
+        stats.success_returns = 0;
+        stats.failure_returns = 0;
+        stats.alloc_objects = 0;
+        stats.alloc_bytes = 0;
+    }
+}
+
+std::span<const muslisp::value> instance::leaf_args(node_id id) const noexcept {
+    return leaf_arg_values ? leaf_arg_values->args(id) : std::span<const muslisp::value>{};
+}
+
+bb_slot instance::bb_key_slot(bb_slot def_key) const noexcept {
+    return def_key < bb_key_slots.size() ? bb_key_slots[def_key] : kNoBbSlot;
+}
+
+void instance::link_leaves(const registry& reg, std::shared_ptr<const leaf_link_table> shared) {
+    prepare_node_slots();
+    if (shared && shared->def == def && shared->generation == reg.generation()) {
+        leaf_links = std::move(shared);
+    } else {
+        leaf_links = build_leaf_links(def, reg);
+    }
+    node_memos.clear();
+    memo_reads.clear();
+    if (incremental_tick && def) {
+        build_node_memos(*this, reg);
+    }
+    if (tick_on_demand && def) {
+        build_wake_reads(*this, reg);
+    }
+    leaf_bindings_generation = reg.generation();
+}
+
+void instance::invalidate_memos() noexcept {
+    for (node_memo& memo : node_memos) {
+        memo.valid = false;
+    }
+}
+
+std::uint32_t instance::leaf_binding(node_id id) const noexcept {
+    if (!leaf_links || id >= leaf_links->bindings.size()) {
+        return registry::k_unbound;
+    }
+    return leaf_links->bindings[id];
+}
+
+std::optional<std::span<const native_arg>> instance::native_leaf_args(node_id id) const noexcept {
+    if (!leaf_links || id >= leaf_links->native_arg_ranges.size() || !leaf_links->native_arg_ranges[id].valid) {
+        return std::nullopt;
+    }
+    const native_arg_range& range = leaf_links->native_arg_ranges[id];
+    return std::span<const native_arg>(leaf_links->native_args.data() + range.offset, range.count);
 }
 
 }  // namespace bt
@@ -0,0 +1,47 @@
+#include "bt/instance_pool.hpp"
+
+#include <utility>
+
+#include "bt/runtime.hpp"
+
+namespace bt {
+
+instance_pool::instance_pool(const definition* def,
+                             std::shared_ptr<const leaf_arg_table> shared_leaf_args,
+                             std::size_t trace_capacity,
+                             std::size_t max_idle)
+    : def_(def), trace_capacity_(trace_capacity), max_idle_(max_idle) {
+    if (shared_leaf_args && shared_leaf_args->def == def) {
+        leaf_args_ = std::move(shared_leaf_args);
+    }
+}
+
+std::unique_ptr<instance> instance_pool::acquire() {
+    if (!idle_.empty()) {
+        std::unique_ptr<instance> inst = std::move(idle_.back());
+        idle_.pop_back();
+        return inst;
+    }
+    auto inst = std::make_unique<instance>(def_, leaf_args_, trace_capacity_);
+    if (!leaf_args_) {
+        leaf_args_ = inst->leaf_arg_values;
+    }
+    return inst;
+}
+
+void instance_pool::release(std::unique_ptr<instance> inst) {
+    if (!inst || inst->def != def_ || inst->slots_def != def_ || inst->trace.capacity() != trace_capacity_ ||
+        idle_.size() >= max_idle_) {
+        return;
+    }
+    recycle(*inst);
+    inst->instance_handle = 0;
+    idle_.push_back(std::move(inst));
+}
+
+void instance_pool::set_trace_capacity(std::size_t capacity) {
+    trace_capacity_ = capacity;
+    idle_.clear();
+}
+
+}  // namespace bt
@@ -0,0 +1,400 @@
+#pragma once
+
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace bt::json_scan {
+
+// The JSON reader shared by the event log validator and the log replay: one line of an event log is
+// parsed into a flat array of nodes that point back into the line's text.
+
+inline constexpr std::uint32_t k_none = 0xffffffffu;
+inline constexpr unsigned k_max_json_depth = 256;
+
+enum class json_kind : std::uint8_t { null, boolean, number, string, array, object };
+
+// One value of a json_doc. Strings and member names point into the parsed text with their escapes
+// still in place; `escaped` says whether they need decoding.
+struct json_node {
+    json_kind kind = json_kind::null;
+    bool flag = false;
+    bool escaped = false;
+    bool key_escaped = false;
+    std::string_view text;    // string contents between the quotes, or the number literal
+    std::string_view key;     // member name when the parent is an object
+    std::string_view source;  // the whole value as written
+    std::uint32_t first_child = k_none;
+    std::uint32_t next_sibling = k_none;
+};
+
+inline void append_utf8(std::string& out, std::uint32_t cp) {
+    if (cp < 0x80u) {
+        out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800u) {
+        out.push_back(static_cast<char>(0xc0u | (cp >> 6)));
+        out.push_back(static_cast<char>(0x80u | (cp & 0x3fu)));
+    } else if (cp < 0x10000u) {
+        out.push_back(static_cast<char>(0xe0u | (cp >> 12)));
+        out.push_back(static_cast<char>(0x80u | ((cp >> 6) & 0x3fu)));
+        out.push_back(static_cast<char>(0x80u | (cp & 0x3fu)));
+    } else {
+        out.push_back(static_cast<char>(0xf0u | (cp >> 18)));
+        out.push_back(static_cast<char>(0x80u | ((cp >> 12) & 0x3fu)));
+        out.push_back(static_cast<char>(0x80u | ((cp >> 6) & 0x3fu)));
+        out.push_back(static_cast<char>(0x80u | (cp & 0x3fu)));
+    }
+}
+
+inline std::uint32_t hex4(std::string_view text, std::size_t at) noexcept {
+    std::uint32_t out = 0;
+    for (std::size_t i = at; i < at + 4; ++i) {
+        const char c = text[i];
+        out <<= 4;
+        if (c >= '0' && c <= '9') {
+            out |= static_cast<std::uint32_t>(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            out |= static_cast<std::uint32_t>(c - 'a' + 10);
+        } else {
+            out |= static_cast<std::uint32_t>(c - 'A' + 10);
+        }
+    }
+    return out;
+}
+
+// Decodes the contents of a string the parser has already checked.
+inline std::string decode_json_string(std::string_view raw) {
+    std::string out;
+    out.reserve(raw.size());
+    for (std::size_t i = 0; i < raw.size(); ++i) {
+        if (raw[i] != '\\') {
+            out.push_back(raw[i]);
+            continue;
+        }
+        const char c = raw[++i];
+        switch (c) {
+            case 'b':
+                out.push_back('\b');
+                break;
+            case 'f':
+                out.push_back('\f');
+                break;
+            case 'n':
+                out.push_back('\n');
+                break;
+            case 'r':
+                out.push_back('\r');
+                break;
+            case 't':
+                out.push_back('\t');
+                break;
+            case 'u': {
+                std::uint32_t cp = hex4(raw, i + 1);
+                i += 4;
+                if (cp >= 0xd800u && cp < 0xdc00u && i + 6 < raw.size() && raw[i + 1] == '\\' && raw[i + 2] == 'u') {
+                    const std::uint32_t low = hex4(raw, i + 3);
+                    if (low >= 0xdc00u && low < 0xe000u) {
+                        cp = 0x10000u + ((cp - 0xd800u) << 10) + (low - 0xdc00u);
+                        i += 6;
+                    }
+                }
+                append_utf8(out, cp);
+                break;
+            }
+            default:
+                out.push_back(c);
+                break;
+        }
+    }
+    return out;
+}
+
+// A JSON value parsed into a flat array of nodes. The vectors keep their capacity across parse()
+// calls, so one document per worker thread parses line after line without allocating.
+class json_doc {
+public:
+    // Parses one complete value with optional surrounding whitespace. Accepts NaN, Infinity and
+    // -Infinity, as Python's json module does.
+    bool parse(std::string_view text) {
+        nodes_.clear();
+        text_ = text;
+        pos_ = 0;
+        skip_ws();
+        if (parse_value(0) == k_none) {
+            return false;
+        }
+        skip_ws();
+        return pos_ == text_.size();
+    }
+
+    [[nodiscard]] const json_node& at(std::uint32_t i) const noexcept { return nodes_[i]; }
+    [[nodiscard]] std::uint32_t size() const noexcept { return static_cast<std::uint32_t>(nodes_.size()); }
+
+    // The last member called `name` (later duplicates win, as in Python), or k_none.
+    [[nodiscard]] std::uint32_t member(std::uint32_t object, std::string_view name) const {
+        if (object == k_none || nodes_[object].kind != json_kind::object) {
+            return k_none;
+        }
+        std::uint32_t found = k_none;
+        for (std::uint32_t i = nodes_[object].first_child; i != k_none; i = nodes_[i].next_sibling) {
+            const json_node& n = nodes_[i];
+            if (n.key_escaped ? decode_json_string(n.key) == name : n.key == name) {
+                found = i;
+            }
+        }
+        return found;
+    }
+
+    [[nodiscard]] std::string string_value(std::uint32_t i) const {
+        const json_node& n = nodes_[i];
+        return n.escaped ? decode_json_string(n.text) : std::string(n.text);
+    }
+
+    [[nodiscard]] std::string key_of(std::uint32_t i) const {
+        const json_node& n = nodes_[i];
+        return n.key_escaped ? decode_json_string(n.key) : std::string(n.key);
+    }
+
+private:
+    void skip_ws() noexcept {
+        while (pos_ < text_.size() &&
+               (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n' || text_[pos_] == '\r')) {
+            ++pos_;
+        }
+    }
+
+    bool consume(std::string_view word) noexcept {
+        if (text_.substr(pos_, word.size()) != word) {
+            return false;
+        }
+        pos_ += word.size();
+        return true;
+    }
+
+    bool scan_string(std::string_view& out, bool& escaped) noexcept {
+        ++pos_;  // opening quote
+        const std::size_t begin = pos_;
+        escaped = false;
+        while (pos_ < text_.size()) {
+            const auto c = static_cast<unsigned char>(text_[pos_]);
+            if (c == '"') {
+                out = text_.substr(begin, pos_ - begin);
+                ++pos_;
+                return true;
+            }
+            if (c < 0x20u) {
+                return false;
+            }
+            if (c == '\\') {
+                escaped = true;
+                if (++pos_ >= text_.size()) {
+                    return false;
+                }
+                const char e = text_[pos_];
+                if (e == 'u') {
+                    if (pos_ + 4 >= text_.size()) {
+                        return false;
+                    }
+                    for (std::size_t i = pos_ + 1; i <= pos_ + 4; ++i) {
+                        if (!std::isxdigit(static_cast<unsigned char>(text_[i]))) {
+                            return false;
+                        }
+                    }
+                    pos_ += 4;
+                } else if (e != '"' && e != '\\' && e != '/' && e != 'b' && e != 'f' && e != 'n' && e != 'r' &&
+                           e != 't') {
+                    return false;
+                }
+            }
+            ++pos_;
+        }
+        return false;
+    }
+
+    bool scan_number() noexcept {
+        const auto digit = [this] { return pos_ < text_.size() && text_[pos_] >= '0' && text_[pos_] <= '9'; };
+        if (pos_ < text_.size() && text_[pos_] == '-') {
+            ++pos_;
+            if (consume("Infinity")) {
+                return true;
+            }
+        }
+        if (!digit()) {
+            return false;
+        }
+        if (text_[pos_] == '0') {
+            ++pos_;
+        } else {
+            while (digit()) {
+                ++pos_;
+            }
+        }
+        if (pos_ < text_.size() && text_[pos_] == '.') {
+            ++pos_;
+            if (!digit()) {
+                return false;
+            }
+            while (digit()) {
+                ++pos_;
+            }
+        }
+        if (pos_ < text_.size() && (text_[pos_] == 'e' || text_[pos_] == 'E')) {
+            ++pos_;
+            if (pos_ < text_.size() && (text_[pos_] == '+' || text_[pos_] == '-')) {
+                ++pos_;
+            }
+            if (!digit()) {
+                return false;
+            }
+            while (digit()) {
+                ++pos_;
+            }
+        }
+        return true;
+    }
+
+    std::uint32_t parse_value(unsigned depth) {
+        if (pos_ >= text_.size() || depth > k_max_json_depth) {
+            return k_none;
+        }
+        const auto index = static_cast<std::uint32_t>(nodes_.size());
+        nodes_.emplace_back();
+        const std::size_t begin = pos_;
+        const char c = text_[pos_];
+        bool ok = true;
+        json_kind kind = json_kind::null;
+        if (c == '{') {
+            kind = json_kind::object;
+            ok = parse_container(index, depth, '}', true);
+        } else if (c == '[') {
+            kind = json_kind::array;
+            ok = parse_container(index, depth, ']', false);
+        } else if (c == '"') {
+            kind = json_kind::string;
+            std::string_view text;
+            bool escaped = false;
+            ok = scan_string(text, escaped);
+            nodes_[index].text = text;
+            nodes_[index].escaped = escaped;
+        } else if (c == 't' || c == 'f') {
+            kind = json_kind::boolean;
+            nodes_[index].flag = c == 't';
+            ok = consume(c == 't' ? "true" : "false");
+        } else if (c == 'n') {
+            ok = consume("null");
+        } else if (c == 'N' || c == 'I') {
+            kind = json_kind::number;
+            ok = consume(c == 'N' ? "NaN" : "Infinity");
+        } else {
+            kind = json_kind::number;
+            ok = scan_number();
+        }
+        if (!ok) {
+            return k_none;
+        }
+        nodes_[index].kind = kind;
+        nodes_[index].source = text_.substr(begin, pos_ - begin);
+        if (kind == json_kind::number) {
+            nodes_[index].text = nodes_[index].source;
+        }
+        return index;
+    }
+
+    bool parse_container(std::uint32_t index, unsigned depth, char close, bool object) {
+        ++pos_;
+        skip_ws();
+        if (pos_ < text_.size() && text_[pos_] == close) {
+            ++pos_;
+            return true;
+        }
+        std::uint32_t last = k_none;
+        while (true) {
+            std::string_view key;
+            bool key_escaped = false;
+            if (object) {
+                if (pos_ >= text_.size() || text_[pos_] != '"' || !scan_string(key, key_escaped)) {
+                    return false;
+                }
+                skip_ws();
+                if (pos_ >= text_.size() || text_[pos_] != ':') {
+                    return false;
+                }
+                ++pos_;
+                skip_ws();
+            }
+            const std::uint32_t child = parse_value(depth + 1);
+            if (child == k_none) {
+                return false;
+            }
+            nodes_[child].key = key;
+            nodes_[child].key_escaped = key_escaped;
+            if (last == k_none) {
+                nodes_[index].first_child = child;
+            } else {
+                nodes_[last].next_sibling = child;
+            }
+            last = child;
+            skip_ws();
+            if (pos_ >= text_.size()) {
+                return false;
+            }
+            if (text_[pos_] == close) {
+                ++pos_;
+                return true;
+            }
+            if (text_[pos_] != ',') {
+                return false;
+            }
+            ++pos_;
+            skip_ws();
+        }
+    }
+
+    std::vector<json_node> nodes_;
+    std::string_view text_;
+    std::size_t pos_ = 0;
+};
+
+inline bool is_integer_literal(std::string_view text) noexcept {
+    return !text.empty() && text.find_first_of(".eEIN") == std::string_view::npos;
+}
+
+inline double number_value(std::string_view text) noexcept {
+    if (text == "NaN") {
+        return std::nan("");
+    }
+    if (text == "Infinity" || text == "-Infinity") {
+        return text.front() == '-' ? -HUGE_VAL : HUGE_VAL;
+    }
+    double out = 0.0;
+    (void)std::from_chars(text.data(), text.data() + text.size(), out);
+    return out;
+}
+
+// The node's value when it is written as an integer (Python's isinstance(v, int) for JSON input).
+inline std::optional<std::int64_t> int_value(const json_doc& doc, std::uint32_t i) noexcept {
+    if (i == k_none || doc.at(i).kind != json_kind::number || !is_integer_literal(doc.at(i).text)) {
+        return std::nullopt;
+    }
+    const std::string_view text = doc.at(i).text;
+    std::int64_t out = 0;
+    const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), out);
+    if (ec != std::errc{} || ptr != text.data() + text.size()) {
+        return std::nullopt;
+    }
+    return out;
+}
+
+inline std::optional<double> float_value(const json_doc& doc, std::uint32_t i) noexcept {
+    if (i == k_none || doc.at(i).kind != json_kind::number) {
+        return std::nullopt;
+    }
+    return number_value(doc.at(i).text);
+}
+
+}  // namespace bt::json_scan
@@ -0,0 +1,160 @@
+#include "bt/json_writer.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <stdexcept>
+
+namespace bt {
+namespace {
+
+template <typename Number>
+void append_number(std::string& out, Number number) {
+    char buffer[32];
+    const auto [ptr, ec] = std::to_chars(buffer, buffer + sizeof(buffer), number);
+    if (ec != std::errc{}) {
+        throw std::runtime_error("json_writer: failed to format number");
+    }
+    out.append(buffer, ptr);
+}
+
+}  // namespace
+
+void json_writer::clear() noexcept {
+    buffer_.clear();
+    empty_bits_ = 0;
+    depth_ = 0;
+    after_key_ = false;
+}
+
+void json_writer::separate() {
+    if (after_key_) {
+        after_key_ = false;
+        return;
+    }
+    if (depth_ == 0) {
+        return;
+    }
+    const std::uint64_t bit = std::uint64_t{1} << (depth_ - 1);
+    if (empty_bits_ & bit) {
+        empty_bits_ &= ~bit;
+    } else {
+        buffer_.push_back(',');
+    }
+}
+
+json_writer& json_writer::begin_object() {
+    separate();
+    if (depth_ == k_max_depth) {
+        throw std::runtime_error("json_writer: nesting is deeper than 64 levels");
+    }
+    buffer_.push_back('{');
+    empty_bits_ |= std::uint64_t{1} << depth_;
+    ++depth_;
+    return *this;
+}
+
+json_writer& json_writer::end_object() {
+    --depth_;
+    buffer_.push_back('}');
+    return *this;
+}
+
+json_writer& json_writer::begin_array() {
+    separate();
+    if (depth_ == k_max_depth) {
+        throw std::runtime_error("json_writer: nesting is deeper than 64 levels");
+    }
+    buffer_.push_back('[');
+    empty_bits_ |= std::uint64_t{1} << depth_;
+    ++depth_;
+    return *this;
+}
+
+json_writer& json_writer::end_array() {
+    --depth_;
+    buffer_.push_back(']');
+    return *this;
+}
+
+json_writer& json_writer::key(std::string_view name) {
+    separate();
+    buffer_.push_back('"');
+    append_escaped(buffer_, name);
+    buffer_ += "\":";
+    after_key_ = true;
+    return *this;
+}
+
+json_writer& json_writer::value(std::string_view text) {
+    separate();
+    buffer_.push_back('"');
+    append_escaped(buffer_, text);
+    buffer_.push_back('"');
+    return *this;
+}
+
+json_writer& json_writer::value(bool flag) {
+    separate();
+    buffer_ += flag ? "true" : "false";
+    return *this;
+}
+
+json_writer& json_writer::value(double number) {
+    if (!std::isfinite(number)) {
+        return null();
+    }
+    separate();
+    append_number(buffer_, number);
+    return *this;
+}
+
+json_writer& json_writer::value(std::int64_t number) {
+    separate();
+    append_number(buffer_, number);
+    return *this;
+}
+
+json_writer& json_writer::value(std::uint64_t number) {
+    separate();
+    append_number(buffer_, number);
+    return *this;
+}
+
+json_writer& json_writer::null() {
+    separate();
+    buffer_ += "null";
+    return *this;
+}
+
+json_writer& json_writer::raw(std::string_view json) {
+    separate();
+    buffer_.append(json);
+    return *this;
+}
+
+void json_writer::append_escaped(std::string& out, std::string_view text) {
+    for (const char c : text) {
+        switch (c) {
+            case '\\':
+                out += "\\\\";
+                break;
+            case '"':
+                out += "\\\"";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            case '\r':
+                out += "\\r";
+                break;
+            case '\t':
+                out += "\\t";
+                break;
+            default:
+                out.push_back(c);
+                break;
+        }
+    }
+}
+
+}  // namespace bt
@@ -0,0 +1,426 @@
+#include "bt/log_replay.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "bt/event_compact.hpp"
+#include "bt/event_log.hpp"
+#include "bt/instance.hpp"
+#include "bt/runtime.hpp"
+#include "bt/sim_clock.hpp"
+#include "json_scan.hpp"
+
+namespace bt {
+namespace {
+
+using namespace json_scan;
+
+using tick_node = std::pair<std::uint64_t, node_id>;
+
+struct tick_record {
+    std::uint64_t tick = 0;
+    std::int64_t unix_ms = 0;
+    std::string root_status;
+    // node_exit events in emission order.
+    std::vector<std::pair<node_id, std::string>> exits;
+    // Blackboard inputs to restore before the tick; std::monostate deletes the key.
+    std::vector<std::pair<std::string, bb_value>> inputs;
+};
+
+std::string text_member(const json_doc& doc, std::uint32_t object, std::string_view name) {
+    const std::uint32_t i = doc.member(object, name);
+    return i != k_none && doc.at(i).kind == json_kind::string ? doc.string_value(i) : std::string();
+}
+
+std::optional<std::uint64_t> uint_member(const json_doc& doc, std::uint32_t object, std::string_view name) {
+    const std::uint32_t i = doc.member(object, name);
+    if (i != k_none && doc.at(i).kind == json_kind::string) {
+        // Job ids are written as strings.
+        const std::string text = doc.string_value(i);
+        std::uint64_t out = 0;
+        const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), out);
+        return ec == std::errc{} && ptr == text.data() + text.size() ? std::optional<std::uint64_t>(out) : std::nullopt;
+    }
+    const std::optional<std::int64_t> v = int_value(doc, i);
+    return v && *v >= 0 ? std::optional<std::uint64_t>(static_cast<std::uint64_t>(*v)) : std::nullopt;
+}
+
+std::vector<double> number_array(const json_doc& doc, std::uint32_t array) {
+    std::vector<double> out;
+    if (array == k_none || doc.at(array).kind != json_kind::array) {
+        return out;
+    }
+    for (std::uint32_t i = doc.at(array).first_child; i != k_none; i = doc.at(i).next_sibling) {
+        out.push_back(float_value(doc, i).value_or(0.0));
+    }
+    return out;
+}
+
+// The inverse of the runtime's bb_value_json: integer literals are int64, other numbers double, and
+// arrays vectors.
+bb_value decode_bb_value(const json_doc& doc, std::uint32_t i) {
+    const json_node& n = doc.at(i);
+    switch (n.kind) {
+        case json_kind::null:
+            return bb_value{};
+        case json_kind::boolean:
+            return bb_value{n.flag};
+        case json_kind::number:
+            if (const std::optional<std::int64_t> v = int_value(doc, i)) {
+                return bb_value{*v};
+            }
+            return bb_value{number_value(n.text)};
+        case json_kind::string:
+            return bb_value{doc.string_value(i)};
+        case json_kind::array:
+            return bb_value{bb_vector(number_array(doc, i))};
+        case json_kind::object:
+            if (const std::uint32_t image = doc.member(i, "image_handle"); image != k_none) {
+                return bb_value{image_handle_ref{.id = int_value(doc, image).value_or(0)}};
+            }
+            if (const std::uint32_t blob = doc.member(i, "blob_handle"); blob != k_none) {
+                return bb_value{blob_handle_ref{.id = int_value(doc, blob).value_or(0)}};
+            }
+            break;
+    }
+    return bb_value{std::string(n.source)};
+}
+
+vla_action decode_vla_action(const json_doc& doc, std::uint32_t object) {
+    vla_action out;
+    const std::string type = text_member(doc, object, "type");
+    if (type == "discrete") {
+        out.type = vla_action_type::discrete;
+        out.discrete_id = text_member(doc, object, "id");
+    } else if (type == "sequence") {
+        out.type = vla_action_type::sequence;
+        const std::uint32_t steps = doc.member(object, "steps");
+        if (steps != k_none && doc.at(steps).kind == json_kind::array) {
+            for (std::uint32_t i = doc.at(steps).first_child; i != k_none; i = doc.at(i).next_sibling) {
+                out.steps.push_back(decode_vla_action(doc, i));
+            }
+        }
+    } else {
+        out.u = number_array(doc, doc.member(object, "u"));
+    }
+    return out;
+}
+
+template <typename Enum, std::size_t N>
+std::optional<Enum> enum_from_name(const std::string& name, const Enum (&values)[N], const char* (*to_name)(Enum) noexcept) {
+    for (const Enum v : values) {
+        if (name == to_name(v)) {
+            return v;
+        }
+    }
+    return std::nullopt;
+}
+
+constexpr vla_job_status k_vla_job_statuses[] = {vla_job_status::queued,
+                                                 vla_job_status::running,
+                                                 vla_job_status::streaming,
+                                                 vla_job_status::done,
+                                                 vla_job_status::error,
+                                                 vla_job_status::timeout,
+                                                 vla_job_status::cancelled};
+constexpr planner_status k_planner_statuses[] = {
+    planner_status::ok, planner_status::timeout, planner_status::noaction, planner_status::error};
+constexpr planner_backend k_planner_backends[] = {planner_backend::mcts, planner_backend::mppi, planner_backend::ilqr};
+
+}  // namespace
+
+struct log_replay::recording {
+    std::string dsl;
+    std::string tree_hash;
+    std::vector<tick_record> ticks;
+    std::map<tick_node, vla_service::vla_job_id> vla_jobs;
+    std::map<tick_node, vla_poll> vla_polls;
+    std::map<tick_node, planner_result> planner_results;
+
+    void add(const json_doc& doc, std::unordered_map<std::string, std::string>& tree_digests);
+};
+
+// Events are folded into the tick opened by the last tick_begin. A blackboard key becomes an input
+// when its recorded value differs from the last value a tree node wrote to it (tracked by digest in
+// `tree_digests`, with "" for a node's delete).
+void log_replay::recording::add(const json_doc& doc, std::unordered_map<std::string, std::string>& tree_digests) {
+    const std::string type = text_member(doc, 0, "type");
+    const std::uint32_t data = doc.member(0, "data");
+    const std::optional<std::uint64_t> tick = uint_member(doc, 0, "tick");
+
+    if (type == "bt_def") {
+        dsl = text_member(doc, data, "dsl");
+        tree_hash = text_member(doc, data, "tree_hash");
+        return;
+    }
+    if (!tick) {
+        return;
+    }
+    if (type == "tick_begin") {
+        if (!ticks.empty() && *tick <= ticks.back().tick) {
+            throw std::runtime_error("log_replay: tick " + std::to_string(*tick) + " does not follow tick " +
+                                     std::to_string(ticks.back().tick) + " (a log of several instances?)");
+        }
+        tick_record& rec = ticks.emplace_back();
+        rec.tick = *tick;
+        rec.unix_ms = int_value(doc, doc.member(0, "unix_ms")).value_or(0);
+        return;
+    }
+    if (ticks.empty() || ticks.back().tick != *tick) {
+        return;
+    }
+    tick_record& rec = ticks.back();
+    const node_id node = static_cast<node_id>(uint_member(doc, data, "node_id").value_or(0));
+
+    if (type == "node_exit") {
+        rec.exits.emplace_back(node, text_member(doc, data, "status"));
+    } else if (type == "tick_end") {
+        rec.root_status = text_member(doc, data, "root_status");
+        if (rec.root_status.empty()) {
+            rec.root_status = text_member(doc, data, "status");
+        }
+    } else if (type == "bb_write" || type == "bb_delete") {
+        if (doc.member(data, "source_node") != k_none) {
+            tree_digests[text_member(doc, data, "key")] = type == "bb_write" ? text_member(doc, data, "value_digest") : "";
+        }
+    } else if (type == "bb_snapshot" || type == "bb_delta") {
+        const std::uint32_t entries = doc.member(data, type == "bb_snapshot" ? "entries" : "set");
+        if (entries != k_none && doc.at(entries).kind == json_kind::array) {
+            for (std::uint32_t e = doc.at(entries).first_child; e != k_none; e = doc.at(e).next_sibling) {
+                const std::uint32_t key = doc.at(e).first_child;
+                const std::uint32_t value = key == k_none ? k_none : doc.at(key).next_sibling;
+                if (value == k_none || doc.at(key).kind != json_kind::string) {
+                    continue;
+                }
+                std::string name = doc.string_value(key);
+                const auto written = tree_digests.find(name);
+                if (written != tree_digests.end() && written->second == event_log::hash64_hex(doc.at(value).source)) {
+                    continue;
+                }
+                rec.inputs.emplace_back(std::move(name), decode_bb_value(doc, value));
+            }
+        }
+        const std::uint32_t deleted = doc.member(data, "deleted");
+        if (deleted != k_none && doc.at(deleted).kind == json_kind::array) {
+            for (std::uint32_t d = doc.at(deleted).first_child; d != k_none; d = doc.at(d).next_sibling) {
+                std::string name = doc.string_value(d);
+                const auto written = tree_digests.find(name);
+                if (written == tree_digests.end() || !written->second.empty()) {
+                    rec.inputs.emplace_back(std::move(name), bb_value{});
+                }
+            }
+        }
+    } else if (type == "vla_submit") {
+        // Prefetches are not replayed; the hit that adopts one carries the same job id.
+        const std::optional<std::uint64_t> job = uint_member(doc, data, "job_id");
+        if (job && text_member(doc, data, "status") != "prefetched") {
+            vla_jobs[{*tick, node}] = *job;
+        }
+    } else if (type == "vla_poll") {
+        const auto st = enum_from_name(text_member(doc, data, "status"), k_vla_job_statuses, vla_job_status_name);
+        vla_polls[{*tick, node}].status = st.value_or(vla_job_status::error);
+    } else if (type == "vla_result") {
+        vla_response response;
+        response.status = vla_status::ok;
+        response.action = decode_vla_action(doc, doc.member(data, "action"));
+        // Written by vla-chunk nodes.
+        if (const std::uint32_t chunk = doc.member(data, "chunk"); chunk != k_none && doc.at(chunk).kind == json_kind::array) {
+            for (std::uint32_t i = doc.at(chunk).first_child; i != k_none; i = doc.at(i).next_sibling) {
+                response.chunk.push_back(vla_chunk_step{.u = number_array(doc, doc.member(i, "u")),
+                                                        .dt_ms = float_value(doc, doc.member(i, "dt_ms")).value_or(0.0)});
+            }
+        }
+        vla_polls[{*tick, node}].final = std::move(response);
+    } else if (type == "async_completion_dropped") {
+        vla_response response;
+        response.status = vla_status::cancelled;
+        vla_polls[{*tick, node}].final = std::move(response);
+    } else if (type == "planner_call_end") {
+        const std::uint32_t action = doc.member(data, "action");
+        if (action == k_none) {
+            return;
+        }
+        planner_result result;
+        result.planner = enum_from_name(text_member(doc, data, "planner"), k_planner_backends, planner_backend_name)
+                             .value_or(planner_backend::mcts);
+        result.status = enum_from_name(text_member(doc, data, "status"), k_planner_statuses, planner_status_name)
+                            .value_or(planner_status::error);
+        const std::vector<double> u = number_array(doc, action);
+        result.action.u.assign(u.begin(), u.end());
+        result.confidence = float_value(doc, doc.member(data, "confidence")).value_or(0.0);
+        result.stats.work_done = int_value(doc, doc.member(data, "work_done")).value_or(0);
+        planner_results[{*tick, node}] = std::move(result);
+    }
+}
+
+log_replay::log_replay(std::unique_ptr<recording> rec) : rec_(std::move(rec)) {}
+log_replay::log_replay(log_replay&&) noexcept = default;
+log_replay& log_replay::operator=(log_replay&&) noexcept = default;
+log_replay::~log_replay() = default;
+
+log_replay log_replay::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("log_replay: cannot open " + path);
+    }
+    return parse(in);
+}
+
+log_replay log_replay::parse(std::istream& in) {
+    auto rec = std::make_unique<recording>();
+    std::unordered_map<std::string, std::string> tree_digests;
+    json_doc doc;
+    compact_event_expander expander;
+    std::string line;
+    std::size_t line_no = 0;
+    while (std::getline(in, line)) {
+        ++line_no;
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        (void)expander.expand(line);
+        if (!doc.parse(line) || doc.at(0).kind != json_kind::object) {
+            throw std::runtime_error("log_replay: line " + std::to_string(line_no) + " is not a JSON object");
+        }
+        rec->add(doc, tree_digests);
+    }
+    if (rec->ticks.empty()) {
+        throw std::runtime_error("log_replay: the log records no ticks");
+    }
+    return log_replay(std::move(rec));
+}
+
+const std::string& log_replay::tree_dsl() const noexcept {
+    return rec_->dsl;
+}
+
+const std::string& log_replay::tree_hash() const noexcept {
+    return rec_->tree_hash;
+}
+
+std::uint64_t log_replay::recorded_ticks() const noexcept {
+    return rec_->ticks.size();
+}
+
+bool log_replay::records_planner_results() const noexcept {
+    return !rec_->planner_results.empty();
+}
+
+std::optional<vla_service::vla_job_id> log_replay::vla_job(std::uint64_t tick, node_id node) const {
+    const auto it = rec_->vla_jobs.find({tick, node});
+    return it != rec_->vla_jobs.end() ? std::optional<vla_service::vla_job_id>(it->second) : std::nullopt;
+}
+
+vla_poll log_replay::vla_poll_at(std::uint64_t tick, node_id node) {
+    const auto it = rec_->vla_polls.find({tick, node});
+    if (it == rec_->vla_polls.end()) {
+        vla_poll pending;
+        pending.status = vla_job_status::running;
+        return pending;
+    }
+    if (report_ && it->second.final.has_value()) {
+        ++report_->injected_vla_results;
+    }
+    return it->second;
+}
+
+std::optional<planner_result> log_replay::planner_result_at(std::uint64_t tick, node_id node) {
+    const auto it = rec_->planner_results.find({tick, node});
+    if (it == rec_->planner_results.end()) {
+        return std::nullopt;
+    }
+    if (report_) {
+        ++report_->injected_planner_results;
+    }
+    return it->second;
+}
+
+log_replay_report log_replay::run(instance& inst, registry& reg, const services& base, const log_replay_options& options) {
+    const auto started = std::chrono::steady_clock::now();
+    log_replay_report report;
+    report.recorded_ticks = rec_->ticks.size();
+    report_ = &report;
+    struct report_reset {
+        log_replay_report*& target;
+        ~report_reset() { target = nullptr; }
+    } reset{report_};
+
+    // Node statuses are read back from the replay's own event stream.
+    std::vector<std::pair<node_id, std::string>> exits;
+    json_doc line_doc;
+    event_log events(0);
+    events.set_enabled(true);
+    events.set_line_listener([&](const std::string& line) {
+        if (line.find("\"type\":\"node_exit\"") == std::string::npos || !line_doc.parse(line)) {
+            return;
+        }
+        const std::uint32_t data = line_doc.member(0, "data");
+        exits.emplace_back(static_cast<node_id>(uint_member(line_doc, data, "node_id").value_or(0)),
+                           text_member(line_doc, data, "status"));
+    });
+
+    sim_clock clock;
+    services svc = base;
+    svc.clock = &clock;
+    svc.obs.events = &events;
+    svc.obs.logger = nullptr;
+    svc.replay = this;
+
+    const std::int64_t origin_ms = rec_->ticks.front().unix_ms;
+    const auto diverge = [&](std::uint64_t tick, std::string kind, node_id node, std::string expected, std::string actual) {
+        report.divergence = log_replay_divergence{
+            .tick = tick, .kind = std::move(kind), .node = node, .expected = std::move(expected), .actual = std::move(actual)};
+    };
+
+    for (const tick_record& rec : rec_->ticks) {
+        if (options.max_ticks != 0 && report.replayed_ticks >= options.max_ticks) {
+            break;
+        }
+        inst.tick_index = rec.tick - 1;
+        clock.set(sim_clock::k_default_start + std::chrono::milliseconds(std::max<std::int64_t>(rec.unix_ms - origin_ms, 0)));
+        for (const auto& [key, value] : rec.inputs) {
+            inst.bb.put(key, value, rec.tick, clock.now(), 0, "log-replay");
+            ++report.injected_bb_writes;
+        }
+
+        exits.clear();
+        const status result = tick(inst, reg, svc);
+        ++report.replayed_ticks;
+
+        // Ticks recorded without node events are compared by root status only.
+        if (!rec.exits.empty()) {
+            const std::size_t shared = std::min(rec.exits.size(), exits.size());
+            for (std::size_t i = 0; i < shared && !report.divergence; ++i) {
+                if (rec.exits[i].first != exits[i].first) {
+                    diverge(rec.tick, "node_order", exits[i].first, std::to_string(rec.exits[i].first),
+                            std::to_string(exits[i].first));
+                } else if (rec.exits[i].second != exits[i].second) {
+                    diverge(rec.tick, "node_status", exits[i].first, rec.exits[i].second, exits[i].second);
+                }
+            }
+            if (!report.divergence && exits.size() > shared) {
+                diverge(rec.tick, "extra_node", exits[shared].first, "-", exits[shared].second);
+            } else if (!report.divergence && rec.exits.size() > shared) {
+                diverge(rec.tick, "missing_node", rec.exits[shared].first, rec.exits[shared].second, "-");
+            }
+        }
+        if (!report.divergence && !rec.root_status.empty() && rec.root_status != status_name(result)) {
+            diverge(rec.tick, "root_status", inst.def ? inst.def->root : 0, rec.root_status, status_name(result));
+        }
+        if (report.divergence) {
+            break;
+        }
+    }
+
+    report.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    return report;
+}
+
+}  // namespace bt
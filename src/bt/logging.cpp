@@ -1,44 +1,297 @@
 #include "bt/logging.hpp"
 
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <thread>
+
 namespace bt {
+namespace {
+
+constexpr std::string_view k_cut_marker = "...";
 
-memory_log_sink::memory_log_sink(std::size_t capacity_records) : capacity_(capacity_records) {
-    records_.reserve(capacity_);
+void append_double(std::string& out, double value) {
+    char buffer[32];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::general, 6);
+    out.append(buffer, result.ptr);
 }
 
-void memory_log_sink::write(const log_record& rec) {
-    std::lock_guard<std::mutex> lock(mutex_);
+void append_arg(std::string& out, const log_arg& arg) {
+    switch (arg.kind) {
+        case log_arg_kind::int64:
+            out += std::to_string(static_cast<std::int64_t>(arg.bits));
+            break;
+        case log_arg_kind::uint64:
+            out += std::to_string(arg.bits);
+            break;
+        case log_arg_kind::float64:
+            append_double(out, std::bit_cast<double>(arg.bits));
+            break;
+        case log_arg_kind::text:
+            out += arg.text;
+            break;
+        case log_arg_kind::float64_list:
+            for (std::size_t i = 0; i < arg.list.size(); ++i) {
+                if (i != 0) {
+                    out.push_back(',');
+                }
+                append_double(out, arg.list[i]);
+            }
+            break;
+    }
+}
 
-    log_record copy = rec;
-    copy.sequence = ++sequence_;
+}  // namespace
+
+std::string format_log_message(std::string_view format, std::span<const log_arg> args) {
+    std::string out;
+    out.reserve(format.size() + 16 * args.size());
+    std::size_t next = 0;
+    for (std::size_t i = 0; i < format.size(); ++i) {
+        if (format[i] == '{' && i + 1 < format.size() && format[i + 1] == '}' && next < args.size()) {
+            append_arg(out, args[next++]);
+            ++i;
+            continue;
+        }
+        out.push_back(format[i]);
+    }
+    return out;
+}
+
+void log_sink::write_deferred(const log_origin& origin,
+                              std::string_view category,
+                              const char* format,
+                              std::span<const log_arg> args) {
+    log_record rec;
+    rec.ts = origin.ts;
+    rec.level = origin.level;
+    rec.tick_index = origin.tick_index;
+    rec.node = origin.node;
+    rec.category = std::string(category);
+    rec.message = format_log_message(format, args);
+    write(rec);
+}
 
+memory_log_sink::memory_log_sink(std::size_t capacity_records)
+    : capacity_(capacity_records), limiters_(std::make_unique<limiter[]>(k_rate_limit_slots)) {}
+
+memory_log_sink::slot* memory_log_sink::slots() {
+    std::call_once(allocate_once_, [this] {
+        slots_.reset(new (std::nothrow) slot[capacity_]);
+        ready_.store(slots_.get(), std::memory_order_release);
+    });
+    return ready_.load(std::memory_order_acquire);
+}
+
+void memory_log_sink::store(const log_origin& origin,
+                            std::string_view category,
+                            const char* format,
+                            std::string_view message,
+                            std::span<const log_arg> args) noexcept {
+    const std::uint64_t sequence = head_.fetch_add(1, std::memory_order_acq_rel) + 1;
     if (capacity_ == 0) {
         return;
     }
+    slot* const ring = slots();
+    if (ring == nullptr) {
+        return;
+    }
 
-    if (records_.size() == capacity_) {
-        records_.erase(records_.begin());
+    // A writer that lapped a slow one waits for it; one that was lapped itself gives the slot up.
+    slot& s = ring[static_cast<std::size_t>((sequence - 1) % capacity_)];
+    std::uint64_t version = s.version.load(std::memory_order_acquire);
+    while (true) {
+        if (version >= 2 * sequence) {
+            return;
+        }
+        if ((version & 1u) != 0) {
+            std::this_thread::yield();
+            version = s.version.load(std::memory_order_acquire);
+            continue;
+        }
+        if (s.version.compare_exchange_weak(version, 2 * sequence - 1, std::memory_order_acq_rel)) {
+            break;
+        }
     }
-    records_.push_back(std::move(copy));
+
+    stored_record& rec = s.rec;
+    rec.sequence = sequence;
+    rec.ts = origin.ts;
+    rec.level = origin.level;
+    rec.tick_index = origin.tick_index;
+    rec.node = origin.node;
+    rec.format = format;
+    rec.truncated = false;
+    std::size_t used = 0;
+    const auto put = [&](const void* data, std::size_t size) {
+        const std::size_t room = k_text_bytes_per_record - used;
+        if (size > room) {
+            size = room;
+            rec.truncated = true;
+        }
+        std::memcpy(rec.text + used, data, size);
+        used += size;
+        return size;
+    };
+    rec.category_size = static_cast<std::uint16_t>(put(category.data(), category.size()));
+    rec.arg_count = 0;
+    if (format == nullptr) {
+        (void)put(message.data(), message.size());
+    } else {
+        for (const log_arg& arg : args.first(std::min(args.size(), k_max_args))) {
+            const std::size_t i = rec.arg_count++;
+            rec.arg_kinds[i] = arg.kind;
+            if (arg.kind == log_arg_kind::text) {
+                rec.arg_bits[i] = put(arg.text.data(), arg.text.size());
+            } else if (arg.kind == log_arg_kind::float64_list) {
+                const std::size_t fit = std::min(arg.list.size(), (k_text_bytes_per_record - used) / sizeof(double));
+                rec.truncated = rec.truncated || fit < arg.list.size();
+                rec.arg_bits[i] = put(arg.list.data(), fit * sizeof(double));
+            } else {
+                rec.arg_bits[i] = arg.bits;
+            }
+        }
+    }
+    rec.text_size = static_cast<std::uint16_t>(used);
+    s.version.store(2 * sequence, std::memory_order_release);
+}
+
+void memory_log_sink::write(const log_record& rec) {
+    store(log_origin{.ts = rec.ts, .level = rec.level, .tick_index = rec.tick_index, .node = rec.node},
+          rec.category,
+          nullptr,
+          rec.message,
+          {});
+}
+
+void memory_log_sink::write_deferred(const log_origin& origin,
+                                     std::string_view category,
+                                     const char* format,
+                                     std::span<const log_arg> args) {
+    store(origin, category, format, {}, args);
+}
+
+bool memory_log_sink::admit(const log_origin& origin, std::string_view category) {
+    const std::uint64_t burst = burst_.load(std::memory_order_relaxed);
+    if (burst == 0) {
+        return true;
+    }
+    const std::size_t hash =
+        std::hash<std::string_view>{}(category) ^ (static_cast<std::size_t>(origin.node) * 0x9e3779b97f4a7c15ull);
+    limiter& l = limiters_[hash % k_rate_limit_slots];
+    const std::int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(origin.ts.time_since_epoch()).count();
+    std::int64_t start = l.window_start.load(std::memory_order_acquire);
+    if (start == k_unset_window || now < start || now - start >= window_ns_.load(std::memory_order_relaxed)) {
+        if (l.window_start.compare_exchange_strong(start, now, std::memory_order_acq_rel)) {
+            l.count.store(0, std::memory_order_relaxed);
+            const std::uint64_t dropped = l.suppressed.exchange(0, std::memory_order_acq_rel);
+            if (dropped > 0) {
+                log_origin summary = origin;
+                summary.level = log_level::warn;
+                const log_arg count[] = {dropped};
+                store(summary, category, "suppressed {} repeated log messages", {}, count);
+            }
+        }
+    }
+    if (l.count.fetch_add(1, std::memory_order_relaxed) < burst) {
+        return true;
+    }
+    l.suppressed.fetch_add(1, std::memory_order_relaxed);
+    suppressed_.fetch_add(1, std::memory_order_relaxed);
+    return false;
 }
 
 std::vector<log_record> memory_log_sink::snapshot() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return records_;
+    std::vector<log_record> out;
+    const slot* const ring = ready_.load(std::memory_order_acquire);
+    const std::uint64_t head = head_.load(std::memory_order_acquire);
+    const std::uint64_t first = std::max(cleared_at_.load(std::memory_order_acquire),
+                                         head > capacity_ ? head - capacity_ : std::uint64_t{0});
+    if (ring == nullptr || head == first) {
+        return out;
+    }
+    out.reserve(static_cast<std::size_t>(head - first));
+    stored_record rec;
+    for (std::uint64_t sequence = first + 1; sequence <= head; ++sequence) {
+        const slot& s = ring[static_cast<std::size_t>((sequence - 1) % capacity_)];
+        const std::uint64_t version = s.version.load(std::memory_order_acquire);
+        if (version != 2 * sequence) {
+            continue;  // still being written, or already overwritten
+        }
+        std::memcpy(static_cast<void*>(&rec), &s.rec, sizeof(rec));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (s.version.load(std::memory_order_relaxed) != version) {
+            continue;
+        }
+
+        log_record& dst = out.emplace_back();
+        dst.sequence = rec.sequence;
+        dst.ts = rec.ts;
+        dst.level = rec.level;
+        dst.tick_index = rec.tick_index;
+        dst.node = rec.node;
+        dst.category.assign(rec.text, rec.category_size);
+        std::size_t at = rec.category_size;
+        if (rec.format == nullptr) {
+            dst.message.assign(rec.text + at, rec.text_size - at);
+        } else {
+            std::vector<double> lists[k_max_args];
+            std::vector<log_arg> args;
+            args.reserve(rec.arg_count);
+            for (std::size_t i = 0; i < rec.arg_count; ++i) {
+                log_arg& arg = args.emplace_back(std::int64_t{0});
+                arg.kind = rec.arg_kinds[i];
+                if (arg.kind == log_arg_kind::text) {
+                    arg.text = std::string_view(rec.text + at, static_cast<std::size_t>(rec.arg_bits[i]));
+                    at += static_cast<std::size_t>(rec.arg_bits[i]);
+                } else if (arg.kind == log_arg_kind::float64_list) {
+                    lists[i].resize(static_cast<std::size_t>(rec.arg_bits[i]) / sizeof(double));
+                    std::memcpy(lists[i].data(), rec.text + at, static_cast<std::size_t>(rec.arg_bits[i]));
+                    arg.list = lists[i];
+                    at += static_cast<std::size_t>(rec.arg_bits[i]);
+                } else {
+                    arg.bits = rec.arg_bits[i];
+                }
+            }
+            dst.message = format_log_message(rec.format, args);
+        }
+        if (rec.truncated) {
+            dst.message += k_cut_marker;
+        }
+    }
+    return out;
 }
 
 std::size_t memory_log_sink::size() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return records_.size();
+    if (ready_.load(std::memory_order_acquire) == nullptr) {
+        return 0;
+    }
+    const std::uint64_t head = head_.load(std::memory_order_acquire);
+    return static_cast<std::size_t>(std::min<std::uint64_t>(head - cleared_at_.load(std::memory_order_acquire), capacity_));
 }
 
 std::size_t memory_log_sink::capacity() const {
     return capacity_;
 }
 
+std::size_t memory_log_sink::memory_bytes() const noexcept {
+    const std::size_t slot_bytes = ready_.load(std::memory_order_acquire) ? capacity_ * sizeof(slot) : 0;
+    return slot_bytes + k_rate_limit_slots * sizeof(limiter);
+}
+
 void memory_log_sink::clear() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    records_.clear();
+    cleared_at_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+void memory_log_sink::set_rate_limit(std::size_t burst, std::chrono::nanoseconds window) noexcept {
+    burst_.store(burst, std::memory_order_relaxed);
+    window_ns_.store(std::max<std::int64_t>(window.count(), 1), std::memory_order_relaxed);
+}
+
+std::uint64_t memory_log_sink::suppressed() const noexcept {
+    return suppressed_.load(std::memory_order_relaxed);
 }
 
 const char* log_level_name(log_level level) noexcept {
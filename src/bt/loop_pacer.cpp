@@ -0,0 +1,167 @@
+#include "bt/loop_pacer.hpp"
+
+#include "bt/json_writer.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <thread>
+
+#if defined(__linux__)
+#include <time.h>
+#endif
+
+namespace bt {
+
+std::optional<overrun_policy> parse_overrun_policy(std::string_view name) noexcept {
+    if (name == "skip") {
+        return overrun_policy::skip;
+    }
+    if (name == "catch-up" || name == "catch_up") {
+        return overrun_policy::catch_up;
+    }
+    if (name == "degrade") {
+        return overrun_policy::degrade;
+    }
+    return std::nullopt;
+}
+
+const char* overrun_policy_name(overrun_policy policy) noexcept {
+    switch (policy) {
+        case overrun_policy::skip:
+            return "skip";
+        case overrun_policy::catch_up:
+            return "catch-up";
+        case overrun_policy::degrade:
+            return "degrade";
+    }
+    return "skip";
+}
+
+loop_pacer::loop_pacer(loop_pacer_options options) : options_(options), period_(options.period) {
+    options_.degrade_max_factor = std::max<std::uint32_t>(options_.degrade_max_factor, 1);
+    options_.degrade_recover_ticks = std::max<std::uint32_t>(options_.degrade_recover_ticks, 1);
+}
+
+void loop_pacer::restart() noexcept {
+    deadline_ = {};
+    anchored_ = false;
+    on_time_streak_ = 0;
+}
+
+void loop_pacer::reset() noexcept {
+    restart();
+    period_ = options_.period;
+    stats_ = {};
+}
+
+std::chrono::nanoseconds loop_pacer::wait_next() {
+    const clock::time_point now = clock::now();
+    if (!anchored_) {
+        deadline_ = now + period_;
+        anchored_ = true;
+    } else if (now > deadline_) {
+        ++stats_.overruns;
+        on_time_streak_ = 0;
+        const auto behind = std::chrono::duration_cast<std::chrono::nanoseconds>(now - deadline_);
+        switch (options_.policy) {
+            case overrun_policy::catch_up:
+                if (behind < period_ * options_.max_catch_up) {
+                    // Released at once; the grid is unchanged, so the next deadline is still behind
+                    // or close to now until the backlog is gone.
+                    ++stats_.caught_up_ticks;
+                    ++stats_.ticks;
+                    record_jitter(behind);
+                    deadline_ += period_;
+                    return behind;
+                }
+                [[fallthrough]];
+            case overrun_policy::skip: {
+                const auto missed = behind / period_ + 1;
+                deadline_ += period_ * missed;
+                stats_.skipped_ticks += static_cast<std::uint64_t>(missed);
+                break;
+            }
+            case overrun_policy::degrade:
+                set_degrade_factor(std::min(stats_.degrade_factor * 2, options_.degrade_max_factor));
+                deadline_ = now + period_;
+                break;
+        }
+    } else if (options_.policy == overrun_policy::degrade && stats_.degrade_factor > 1 &&
+               ++on_time_streak_ >= options_.degrade_recover_ticks) {
+        set_degrade_factor(stats_.degrade_factor / 2);
+        on_time_streak_ = 0;
+    }
+
+    sleep_until(deadline_);
+    const auto lateness = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - deadline_);
+    ++stats_.ticks;
+    record_jitter(lateness);
+    deadline_ += period_;
+    return lateness;
+}
+
+void loop_pacer::sleep_until(clock::time_point deadline) const {
+    const clock::time_point wake = deadline - options_.spin;
+    if (clock::now() < wake) {
+#if defined(__linux__)
+        // steady_clock is CLOCK_MONOTONIC here, so its epoch offsets are valid absolute times.
+        const auto since_epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(wake.time_since_epoch()).count();
+        timespec ts{};
+        ts.tv_sec = static_cast<time_t>(since_epoch / 1'000'000'000);
+        ts.tv_nsec = static_cast<long>(since_epoch % 1'000'000'000);
+        while (::clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+        }
+#else
+        std::this_thread::sleep_until(wake);
+#endif
+    }
+    while (clock::now() < deadline) {
+    }
+}
+
+void loop_pacer::record_jitter(std::chrono::nanoseconds lateness) noexcept {
+    const std::int64_t ns = std::max<std::int64_t>(lateness.count(), 0);
+    stats_.jitter_last_ns = ns;
+    stats_.jitter_max_ns = std::max(stats_.jitter_max_ns, ns);
+    stats_.jitter_total_ns += ns;
+    std::size_t bucket = 0;
+    while (bucket < loop_pacer_stats::k_jitter_bounds_us.size() &&
+           ns > loop_pacer_stats::k_jitter_bounds_us[bucket] * 1000) {
+        ++bucket;
+    }
+    ++stats_.jitter_histogram[bucket];
+}
+
+void loop_pacer::set_degrade_factor(std::uint32_t factor) noexcept {
+    stats_.degrade_factor = std::max<std::uint32_t>(factor, 1);
+    period_ = options_.period * stats_.degrade_factor;
+}
+
+void loop_pacer::write_json(json_writer& out) const {
+    out.begin_object()
+        .field("policy", overrun_policy_name(options_.policy))
+        .field("period_ns", options_.period.count())
+        .field("effective_period_ns", period_.count())
+        .field("spin_ns", options_.spin.count())
+        .field("ticks", stats_.ticks)
+        .field("overruns", stats_.overruns)
+        .field("skipped_ticks", stats_.skipped_ticks)
+        .field("caught_up_ticks", stats_.caught_up_ticks)
+        .field("degrade_factor", stats_.degrade_factor)
+        .field("jitter_last_ns", stats_.jitter_last_ns)
+        .field("jitter_max_ns", stats_.jitter_max_ns)
+        .field("jitter_mean_ns",
+               stats_.ticks > 0 ? stats_.jitter_total_ns / static_cast<std::int64_t>(stats_.ticks) : 0)
+        .key("jitter_bounds_us")
+        .begin_array();
+    for (const std::int64_t bound : loop_pacer_stats::k_jitter_bounds_us) {
+        out.value(bound);
+    }
+    out.end_array().key("jitter_histogram").begin_array();
+    for (const std::uint64_t count : stats_.jitter_histogram) {
+        out.value(count);
+    }
+    out.end_array().end_object();
+}
+
+}  // namespace bt
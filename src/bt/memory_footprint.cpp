@@ -0,0 +1,122 @@
+#include "bt/memory_footprint.hpp"
+
+#include <sstream>
+
+#include "bt/compiler.hpp"
+#include "bt/instance.hpp"
+
+namespace bt {
+namespace {
+
+std::size_t table_bytes(const leaf_arg_table& table) noexcept {
+    return sizeof(leaf_arg_table) + vector_heap_bytes(table.values) + vector_heap_bytes(table.offsets);
+}
+
+std::size_t table_bytes(const leaf_link_table& table) noexcept {
+    return sizeof(leaf_link_table) + vector_heap_bytes(table.bindings) + vector_heap_bytes(table.native_args) +
+           vector_heap_bytes(table.native_arg_ranges);
+}
+
+std::size_t table_bytes(const tick_program& program) noexcept {
+    std::size_t bytes = sizeof(tick_program) + vector_heap_bytes(program.code) +
+                        vector_heap_bytes(program.jump_tables) + vector_heap_bytes(program.guard_tables);
+    for (const tick_guard_table& table : program.guard_tables) {
+        bytes += string_heap_bytes(table.condition) + vector_heap_bytes(table.guard_seqs) +
+                 vector_heap_bytes(table.guard_conds) + vector_heap_bytes(table.child_pcs);
+    }
+    return bytes;
+}
+
+// Tables only `inst` holds belong to its state rather than to the definition.
+template <typename Table>
+std::size_t unshared_bytes(const std::shared_ptr<const Table>& table) noexcept {
+    return table && table.use_count() == 1 ? table_bytes(*table) : 0u;
+}
+
+}  // namespace
+
+std::size_t definition_footprint(const definition& def) noexcept {
+    std::size_t bytes = sizeof(definition) + vector_heap_bytes(def.nodes) + string_heap_bytes(def.source_hash) +
+                        string_heap_bytes(def.canonical_dsl_hash) + string_heap_bytes(def.canonical_dsl) +
+                        vector_heap_bytes(def.bb_keys);
+    for (const node& n : def.nodes) {
+        bytes += vector_heap_bytes(n.children) + string_heap_bytes(n.leaf_name) + vector_heap_bytes(n.args);
+        for (const arg_value& arg : n.args) {
+            bytes += string_heap_bytes(arg.text);
+        }
+    }
+    for (const std::string& key : def.bb_keys) {
+        bytes += string_heap_bytes(key);
+    }
+    return bytes;
+}
+
+instance_footprint measure_instance(const instance& inst) noexcept {
+    instance_footprint out;
+    std::size_t& state = out.state_bytes;
+    state = sizeof(instance) + vector_heap_bytes(inst.memory) + vector_heap_bytes(inst.memory_touched) +
+            vector_heap_bytes(inst.live_memory_nodes) + vector_heap_bytes(inst.node_parents) +
+            hash_heap_bytes(inst.active_vla_jobs) + hash_heap_bytes(inst.vla_prefetches) +
+            hash_heap_bytes(inst.vla_chunks) + vector_heap_bytes(inst.vla_prefetch_nodes) +
+            vector_heap_bytes(inst.job_notifications) + hash_heap_bytes(inst.moved_job_watchers) +
+            hash_heap_bytes(inst.plan_budgets) + hash_heap_bytes(inst.halt_warning_emitted) +
+            vector_heap_bytes(inst.node_stats) + vector_heap_bytes(inst.halt_stack) +
+            vector_heap_bytes(inst.bb_key_slots) + vector_heap_bytes(inst.node_memos) +
+            vector_heap_bytes(inst.memo_reads) + vector_heap_bytes(inst.wake_reads) +
+            vector_heap_bytes(inst.tick_frames) + vector_heap_bytes(inst.node_path_records) +
+            vector_heap_bytes(inst.node_alloc_records) + inst.arena.capacity_bytes() +
+            unshared_bytes(inst.leaf_arg_values) + unshared_bytes(inst.leaf_links) + unshared_bytes(inst.program);
+    for (const auto& [id, chunk] : inst.vla_chunks) {
+        state += vector_heap_bytes(chunk.steps);
+    }
+    for (const node_profile_stats& stats : inst.node_stats) {
+        state += string_heap_bytes(stats.name);
+    }
+    if (inst.job_completions) {
+        state += sizeof(completion_queue);
+    }
+    if (inst.waker) {
+        state += sizeof(tick_waker);
+    }
+    out.blackboard_bytes = inst.bb.memory_bytes();
+    out.trace_bytes = inst.trace.memory_bytes();
+    return out;
+}
+
+std::size_t shared_tables_footprint(const instance& inst, std::unordered_set<const void*>& counted) {
+    std::size_t bytes = 0;
+    if (inst.leaf_arg_values.use_count() > 1 && counted.insert(inst.leaf_arg_values.get()).second) {
+        bytes += table_bytes(*inst.leaf_arg_values);
+    }
+    if (inst.leaf_links.use_count() > 1 && counted.insert(inst.leaf_links.get()).second) {
+        bytes += table_bytes(*inst.leaf_links);
+    }
+    if (inst.program.use_count() > 1 && counted.insert(inst.program.get()).second) {
+        bytes += table_bytes(*inst.program);
+    }
+    return bytes;
+}
+
+std::size_t memory_report::total_bytes() const noexcept {
+    return definition_bytes + instance_state_bytes + blackboard_bytes + trace_bytes + event_ring_bytes +
+           log_ring_bytes + lisp_heap_bytes;
+}
+
+std::string format_memory_report(const memory_report& report) {
+    std::ostringstream out;
+    out << "definition_count=" << report.definition_count << '\n';
+    out << "definition_bytes=" << report.definition_bytes << '\n';
+    out << "instance_count=" << report.instance_count << '\n';
+    out << "idle_instance_count=" << report.idle_instance_count << '\n';
+    out << "instance_state_bytes=" << report.instance_state_bytes << '\n';
+    out << "blackboard_bytes=" << report.blackboard_bytes << '\n';
+    out << "trace_bytes=" << report.trace_bytes << '\n';
+    out << "event_ring_bytes=" << report.event_ring_bytes << '\n';
+    out << "log_ring_bytes=" << report.log_ring_bytes << '\n';
+    out << "lisp_heap_bytes=" << report.lisp_heap_bytes << '\n';
+    out << "lisp_heap_reserved_bytes=" << report.lisp_heap_reserved_bytes << '\n';
+    out << "total_bytes=" << report.total_bytes() << '\n';
+    return out.str();
+}
+
+}  // namespace bt
@@ -0,0 +1,271 @@
+#include "bt/metrics.hpp"
+
+#include <array>
+#include <cstdio>
+#include <stdexcept>
+#include <utility>
+
+#if !defined(_WIN32)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace bt {
+namespace {
+
+// `le` bounds of every exported histogram, in nanoseconds: 1 us to 10 s in 1-2.5-5 steps.
+constexpr std::array<std::int64_t, 22> k_histogram_bounds_ns{
+    1'000,         2'500,         5'000,         10'000,         25'000,         50'000,
+    100'000,       250'000,       500'000,       1'000'000,      2'500'000,      5'000'000,
+    10'000'000,    25'000'000,    50'000'000,    100'000'000,    250'000'000,    500'000'000,
+    1'000'000'000, 2'500'000'000, 5'000'000'000, 10'000'000'000,
+};
+
+void add_relaxed(std::atomic<std::uint64_t>& counter, std::uint64_t by) noexcept {
+    counter.fetch_add(by, std::memory_order_relaxed);
+}
+
+std::uint64_t non_negative_ns(std::chrono::nanoseconds duration) noexcept {
+    return duration.count() > 0 ? static_cast<std::uint64_t>(duration.count()) : 0u;
+}
+
+std::string format_double(double value, int precision) {
+    char buffer[40];
+    std::snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+    return buffer;
+}
+
+void append_family_header(std::string& out, std::string_view name, std::string_view type, std::string_view help) {
+    out.append("# TYPE ").append(name).append(" ").append(type).append("\n");
+    out.append("# HELP ").append(name).append(" ").append(help).append("\n");
+}
+
+#if !defined(_WIN32)
+
+void send_all(int fd, std::string_view bytes) {
+#if defined(MSG_NOSIGNAL)
+    constexpr int k_send_flags = MSG_NOSIGNAL;
+#else
+    constexpr int k_send_flags = 0;
+#endif
+    while (!bytes.empty()) {
+        const ssize_t sent = ::send(fd, bytes.data(), bytes.size(), k_send_flags);
+        if (sent <= 0) {
+            return;
+        }
+        bytes.remove_prefix(static_cast<std::size_t>(sent));
+    }
+}
+
+std::string http_response(std::string_view status, std::string_view content_type, std::string_view body) {
+    std::string response;
+    response.reserve(body.size() + 160u);
+    response.append("HTTP/1.0 ").append(status).append("\r\n");
+    response.append("Content-Type: ").append(content_type).append("\r\n");
+    response.append("Content-Length: ").append(std::to_string(body.size())).append("\r\n");
+    response.append("Connection: close\r\n\r\n");
+    response.append(body);
+    return response;
+}
+
+#endif
+
+}  // namespace
+
+void runtime_metrics::record_tick(std::chrono::nanoseconds duration, bool overrun) noexcept {
+    tick_duration_.record(duration);
+    add_relaxed(tick_ns_total_, non_negative_ns(duration));
+    if (overrun) {
+        add_relaxed(tick_overruns_, 1u);
+    }
+}
+
+void runtime_metrics::record_gc_pause(std::chrono::nanoseconds pause, bool minor) noexcept {
+    gc_pause_.record(pause);
+    add_relaxed(gc_pause_ns_total_, non_negative_ns(pause));
+    if (minor) {
+        add_relaxed(gc_minor_collections_, 1u);
+    }
+}
+
+void runtime_metrics::record_model_service_call(std::chrono::nanoseconds latency) noexcept {
+    model_service_call_.record(latency);
+    add_relaxed(model_service_call_ns_total_, non_negative_ns(latency));
+}
+
+void runtime_metrics::reset() noexcept {
+    tick_duration_.reset();
+    tick_ns_total_.store(0, std::memory_order_relaxed);
+    tick_overruns_.store(0, std::memory_order_relaxed);
+    gc_pause_.reset();
+    gc_pause_ns_total_.store(0, std::memory_order_relaxed);
+    gc_minor_collections_.store(0, std::memory_order_relaxed);
+    model_service_call_.reset();
+    model_service_call_ns_total_.store(0, std::memory_order_relaxed);
+}
+
+void runtime_metrics::append_openmetrics(std::string& out) const {
+    const auto load = [](const std::atomic<std::uint64_t>& counter) {
+        return counter.load(std::memory_order_relaxed);
+    };
+    append_openmetrics_histogram(out,
+                                 "muesli_bt_tick_duration_seconds",
+                                 "Duration of host-driven BT ticks.",
+                                 tick_duration_,
+                                 std::chrono::nanoseconds(static_cast<std::int64_t>(load(tick_ns_total_))));
+    append_openmetrics_counter(out, "muesli_bt_tick_overruns", "Ticks that exceeded their tick budget.", load(tick_overruns_));
+    append_openmetrics_histogram(out,
+                                 "muesli_bt_gc_pause_seconds",
+                                 "Pause time of each default-heap collection.",
+                                 gc_pause_,
+                                 std::chrono::nanoseconds(static_cast<std::int64_t>(load(gc_pause_ns_total_))));
+    append_openmetrics_counter(
+        out, "muesli_bt_gc_minor_collections", "Default-heap collections that were minor.", load(gc_minor_collections_));
+    append_openmetrics_histogram(out,
+                                 "muesli_bt_model_service_call_seconds",
+                                 "Latency of successful model-service invoke calls.",
+                                 model_service_call_,
+                                 std::chrono::nanoseconds(static_cast<std::int64_t>(load(model_service_call_ns_total_))));
+}
+
+void append_openmetrics_counter(std::string& out, std::string_view name, std::string_view help, std::uint64_t value) {
+    append_family_header(out, name, "counter", help);
+    out.append(name).append("_total ").append(std::to_string(value)).append("\n");
+}
+
+void append_openmetrics_gauge(std::string& out, std::string_view name, std::string_view help, double value) {
+    append_family_header(out, name, "gauge", help);
+    out.append(name).append(" ").append(format_double(value, 17)).append("\n");
+}
+
+void append_openmetrics_histogram(std::string& out,
+                                  std::string_view name,
+                                  std::string_view help,
+                                  const latency_histogram& histogram,
+                                  std::chrono::nanoseconds sum) {
+    append_family_header(out, name, "histogram", help);
+
+    std::uint64_t cumulative = 0;
+    std::size_t bucket = 0;
+    for (const std::int64_t bound : k_histogram_bounds_ns) {
+        while (bucket < latency_histogram::k_bucket_count &&
+               latency_histogram::bucket_upper_bound(bucket).count() <= bound) {
+            cumulative += histogram.bucket_count_at(bucket);
+            ++bucket;
+        }
+        out.append(name).append("_bucket{le=\"").append(format_double(static_cast<double>(bound) / 1e9, 9)).append("\"} ");
+        out.append(std::to_string(cumulative)).append("\n");
+    }
+    // Sum the buckets instead of reading count(), so +Inf is never below a finite bound while a
+    // writer is mid-record.
+    for (; bucket < latency_histogram::k_bucket_count; ++bucket) {
+        cumulative += histogram.bucket_count_at(bucket);
+    }
+    out.append(name).append("_bucket{le=\"+Inf\"} ").append(std::to_string(cumulative)).append("\n");
+    out.append(name).append("_count ").append(std::to_string(cumulative)).append("\n");
+    out.append(name).append("_sum ").append(format_double(static_cast<double>(sum.count()) / 1e9, 17)).append("\n");
+}
+
+#if defined(_WIN32)
+
+metrics_endpoint::metrics_endpoint(const std::string& bind_address, std::uint16_t port, render_fn render)
+    : bind_address_(bind_address), port_(port), render_(std::move(render)) {
+    throw std::runtime_error("metrics endpoint: not supported on this platform");
+}
+
+metrics_endpoint::~metrics_endpoint() = default;
+
+void metrics_endpoint::serve() {}
+
+#else
+
+metrics_endpoint::metrics_endpoint(const std::string& bind_address, std::uint16_t port, render_fn render)
+    : bind_address_(bind_address), render_(std::move(render)) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (::inet_pton(AF_INET, bind_address.c_str(), &addr.sin_addr) != 1) {
+        throw std::runtime_error("metrics endpoint: expected an IPv4 address, got " + bind_address);
+    }
+
+    listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd_ < 0) {
+        throw std::runtime_error("metrics endpoint: socket() failed");
+    }
+    const int on = 1;
+    (void)::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (::bind(listen_fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(listen_fd_, 8) != 0) {
+        ::close(listen_fd_);
+        throw std::runtime_error("metrics endpoint: cannot listen on " + bind_address + ":" + std::to_string(port));
+    }
+    socklen_t len = sizeof(addr);
+    if (::getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len) == 0) {
+        port_ = ntohs(addr.sin_port);
+    }
+    thread_ = std::thread([this] { serve(); });
+}
+
+metrics_endpoint::~metrics_endpoint() {
+    stop_.store(true, std::memory_order_relaxed);
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (listen_fd_ >= 0) {
+        ::close(listen_fd_);
+    }
+}
+
+void metrics_endpoint::serve() {
+    // The poll timeout bounds how long the destructor waits for this thread.
+    constexpr int k_poll_ms = 100;
+    constexpr std::size_t k_max_request_bytes = 8192;
+
+    while (!stop_.load(std::memory_order_relaxed)) {
+        pollfd listener{.fd = listen_fd_, .events = POLLIN, .revents = 0};
+        if (::poll(&listener, 1, k_poll_ms) <= 0) {
+            continue;
+        }
+        const int fd = ::accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) {
+            continue;
+        }
+#if defined(SO_NOSIGPIPE)
+        const int on = 1;
+        (void)::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+
+        // Read the request head; a client that stalls for a poll interval is dropped.
+        std::string request;
+        std::array<char, 1024> chunk{};
+        while (request.find("\r\n\r\n") == std::string::npos && request.size() < k_max_request_bytes) {
+            pollfd client{.fd = fd, .events = POLLIN, .revents = 0};
+            if (::poll(&client, 1, k_poll_ms) <= 0) {
+                break;
+            }
+            const ssize_t got = ::recv(fd, chunk.data(), chunk.size(), 0);
+            if (got <= 0) {
+                break;
+            }
+            request.append(chunk.data(), static_cast<std::size_t>(got));
+        }
+
+        const std::string_view line = std::string_view(request).substr(0, request.find("\r\n"));
+        if (line.starts_with("GET /metrics ") || line.starts_with("GET /metrics?")) {
+            try {
+                send_all(fd, http_response("200 OK", k_openmetrics_content_type, render_()));
+            } catch (const std::exception& e) {
+                send_all(fd, http_response("500 Internal Server Error", "text/plain", e.what()));
+            }
+        } else {
+            send_all(fd, http_response("404 Not Found", "text/plain", "try /metrics\n"));
+        }
+        ::close(fd);
+    }
+}
+
+#endif
+
+}  // namespace bt
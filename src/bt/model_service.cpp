@@ -2,14 +2,19 @@
 
 #include <algorithm>
 #include <cctype>
+#include <charconv>
 #include <cmath>
 #include <cstdlib>
+#include <limits>
 #include <optional>
 #include <sstream>
+#include <stdexcept>
 #include <string_view>
 #include <unordered_map>
 #include <utility>
 
+#include "json_scan.hpp"
+
 namespace bt {
 namespace {
 
@@ -431,19 +436,16 @@ model_service_status status_from_name(const std::string& status) {
     return model_service_status::unavailable;
 }
 
-bool contains_json_bool_field(std::string_view text, std::string_view field, bool value) {
-    const std::string quoted_field = json_quote(field);
-    std::size_t pos = 0;
-    while ((pos = text.find(quoted_field, pos)) != std::string_view::npos) {
-        pos += quoted_field.size();
-        skip_ws(text, pos);
-        if (pos >= text.size() || text[pos] != ':') {
-            continue;
-        }
-        ++pos;
-        skip_ws(text, pos);
-        const std::string_view literal = value ? std::string_view("true") : std::string_view("false");
-        if (text.substr(pos, literal.size()) == literal) {
+bool operation_from_name(std::string_view name, model_service_operation& out) {
+    for (const model_service_operation op : {model_service_operation::describe,
+                                             model_service_operation::invoke,
+                                             model_service_operation::start,
+                                             model_service_operation::step,
+                                             model_service_operation::cancel,
+                                             model_service_operation::status,
+                                             model_service_operation::close}) {
+        if (name == model_service_operation_name(op)) {
+            out = op;
             return true;
         }
     }
@@ -467,87 +469,228 @@ std::optional<double> parse_json_number(std::string_view raw) {
     return value;
 }
 
-bool parse_finite_number_array(std::string_view raw) {
-    std::size_t pos = 0;
-    skip_ws(raw, pos);
-    if (pos >= raw.size() || raw[pos] != '[') {
-        return false;
+// A rejection the output gate can make.
+struct output_rule {
+    model_service_status status = model_service_status::invalid_output;
+    std::string_view reason_code;
+    std::string_view message;
+};
+
+// The output gate of one capability, compiled once into flat tables so that checking a response costs
+// one pass over its parsed nodes however many rules there are.
+struct output_policy {
+    // Marker flags that reject the output when set to true at any depth. When several are set, the
+    // rule with the lowest index wins.
+    std::unordered_map<std::string_view, std::uint16_t> flags;
+    std::vector<output_rule> flag_rules;
+    // Top-level member name -> bit of the requirement it satisfies.
+    std::unordered_map<std::string_view, std::uint64_t> required_members;
+    // Requirement bit -> rule reported when no member satisfies it.
+    std::vector<output_rule> required_rules;
+    bool action_chunk = false;
+};
+
+void add_flag_rule(output_policy& policy, std::initializer_list<std::string_view> names, output_rule rule) {
+    const auto index = static_cast<std::uint16_t>(policy.flag_rules.size());
+    policy.flag_rules.push_back(rule);
+    for (std::string_view name : names) {
+        policy.flags.emplace(name, index);
     }
-    ++pos;
-    skip_ws(raw, pos);
-    if (pos < raw.size() && raw[pos] == ']') {
-        return false;
+}
+
+void add_required_rule(output_policy& policy, std::initializer_list<std::string_view> names, output_rule rule) {
+    const std::uint64_t bit = std::uint64_t{1} << policy.required_rules.size();
+    policy.required_rules.push_back(rule);
+    for (std::string_view name : names) {
+        policy.required_members[name] |= bit;
     }
+}
 
-    bool saw_value = false;
-    while (pos < raw.size()) {
-        skip_ws(raw, pos);
-        const std::size_t begin = pos;
-        while (pos < raw.size() && raw[pos] != ',' && raw[pos] != ']') {
-            ++pos;
-        }
-        const std::optional<double> value = parse_json_number(raw.substr(begin, pos - begin));
-        if (!value.has_value()) {
-            return false;
-        }
-        saw_value = true;
-        skip_ws(raw, pos);
-        if (pos < raw.size() && raw[pos] == ',') {
-            ++pos;
-            continue;
+output_policy compile_output_policy(std::string_view capability) {
+    output_policy policy;
+    add_flag_rule(policy,
+                  {"unsafe", "unsafe_output"},
+                  {model_service_status::unsafe_output,
+                   "model_service_unsafe_output",
+                   "model-service output was marked unsafe"});
+    add_flag_rule(policy,
+                  {"policy_violation", "policy_violating"},
+                  {model_service_status::unsafe_output,
+                   "model_service_policy_violation",
+                   "model-service output violated host policy"});
+    add_flag_rule(policy,
+                  {"stale", "stale_result"},
+                  {model_service_status::invalid_output,
+                   "model_service_stale_result",
+                   "model-service output was marked stale"});
+    add_flag_rule(policy,
+                  {"late", "late_result", "deadline_missed"},
+                  {model_service_status::invalid_output,
+                   "model_service_late_result",
+                   "model-service output was marked late"});
+
+    if (capability == "cap.model.world.rollout.v1") {
+        add_required_rule(policy,
+                          {"predicted_states"},
+                          {model_service_status::invalid_output,
+                           "model_service_missing_predicted_states",
+                           "world rollout output is missing predicted_states"});
+    } else if (capability == "cap.model.world.score_trajectory.v1") {
+        add_required_rule(policy,
+                          {"score"},
+                          {model_service_status::invalid_output,
+                           "model_service_missing_score",
+                           "trajectory score output is missing score"});
+    } else if (capability == "cap.vla.action_chunk.v1") {
+        add_required_rule(policy,
+                          {"actions"},
+                          {model_service_status::invalid_output,
+                           "model_service_missing_actions",
+                           "VLA action chunk output is missing actions"});
+        policy.action_chunk = true;
+    } else if (capability == "cap.vla.propose_nav_goal.v1") {
+        add_required_rule(policy,
+                          {"goal", "nav_goal"},
+                          {model_service_status::invalid_output,
+                           "model_service_missing_nav_goal",
+                           "VLA nav-goal output is missing goal or nav_goal"});
+    }
+    return policy;
+}
+
+// Policies of the built-in capabilities, compiled on first use; any other capability gets only the
+// marker flags.
+const output_policy& output_policy_for(std::string_view capability) {
+    static const std::vector<std::pair<std::string, output_policy>> compiled = [] {
+        std::vector<std::pair<std::string, output_policy>> out;
+        for (std::string& name : model_service_required_capabilities()) {
+            output_policy policy = compile_output_policy(name);
+            out.emplace_back(std::move(name), std::move(policy));
         }
-        if (pos < raw.size() && raw[pos] == ']') {
-            ++pos;
-            skip_ws(raw, pos);
-            return saw_value && pos == raw.size();
+        return out;
+    }();
+    static const output_policy generic = compile_output_policy({});
+    for (const auto& [name, policy] : compiled) {
+        if (name == capability) {
+            return policy;
         }
-        return false;
     }
-    return false;
+    return generic;
 }
 
-std::optional<std::pair<std::string, std::string>> validate_action_chunk_shape(std::string_view actions_raw) {
-    std::size_t pos = 0;
-    skip_ws(actions_raw, pos);
-    if (pos >= actions_raw.size() || actions_raw[pos] != '[') {
-        return std::make_pair("model_service_actions_not_array", "VLA action chunk actions must be an array");
-    }
-    ++pos;
-    skip_ws(actions_raw, pos);
-    if (pos < actions_raw.size() && actions_raw[pos] == ']') {
-        return std::make_pair("model_service_actions_empty", "VLA action chunk actions must not be empty");
+std::optional<double> finite_number(const json_scan::json_doc& doc, std::uint32_t i) noexcept {
+    if (i == json_scan::k_none || doc.at(i).kind != json_scan::json_kind::number) {
+        return std::nullopt;
     }
-    if (pos >= actions_raw.size() || actions_raw[pos] != '{') {
-        return std::make_pair("model_service_action_not_object", "VLA action chunk action entries must be objects");
+    const std::string_view text = doc.at(i).text;
+    double out = 0.0;
+    const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), out);
+    if (ec != std::errc{} || ptr != text.data() + text.size() || !std::isfinite(out)) {
+        return std::nullopt;
     }
+    return out;
+}
 
-    const std::size_t first_begin = pos;
-    const std::size_t first_end = scan_json_value(actions_raw, pos);
-    const auto action = parse_top_level_object(actions_raw.substr(first_begin, first_end - first_begin));
-
-    const auto type_it = action.find("type");
-    if (type_it == action.end() || unquote_json_string(type_it->second).empty()) {
-        return std::make_pair("model_service_action_type_missing", "VLA action chunk action is missing type");
+// Checks every action of the chunk, so a runtime that executes the later actions never sees one the
+// gate did not. Each action's values are gathered into one buffer and checked for finiteness in a
+// single branch-free pass.
+std::optional<output_rule> check_action_chunk(const json_scan::json_doc& doc, std::uint32_t actions) {
+    constexpr auto invalid = [](std::string_view code, std::string_view message) {
+        return output_rule{model_service_status::invalid_output, code, message};
+    };
+    if (doc.at(actions).kind != json_scan::json_kind::array) {
+        return invalid("model_service_actions_not_array", "VLA action chunk actions must be an array");
+    }
+    if (doc.at(actions).first_child == json_scan::k_none) {
+        return invalid("model_service_actions_empty", "VLA action chunk actions must not be empty");
+    }
+    thread_local std::vector<double> values;
+    std::size_t dims = 0;
+    for (std::uint32_t action = doc.at(actions).first_child; action != json_scan::k_none;
+         action = doc.at(action).next_sibling) {
+        if (doc.at(action).kind != json_scan::json_kind::object) {
+            return invalid("model_service_action_not_object", "VLA action chunk action entries must be objects");
+        }
+        const std::uint32_t type = doc.member(action, "type");
+        if (type == json_scan::k_none || doc.at(type).kind != json_scan::json_kind::string || doc.at(type).text.empty()) {
+            return invalid("model_service_action_type_missing", "VLA action chunk action is missing type");
+        }
+        const std::uint32_t raw_values = doc.member(action, "values");
+        if (raw_values == json_scan::k_none) {
+            return invalid("model_service_action_values_missing", "VLA action chunk action is missing values");
+        }
+        values.clear();
+        bool numeric = doc.at(raw_values).kind == json_scan::json_kind::array;
+        for (std::uint32_t v = numeric ? doc.at(raw_values).first_child : json_scan::k_none; v != json_scan::k_none;
+             v = doc.at(v).next_sibling) {
+            const json_scan::json_node& node = doc.at(v);
+            double value = 0.0;
+            const auto [ptr, ec] = std::from_chars(node.text.data(), node.text.data() + node.text.size(), value);
+            numeric = numeric && node.kind == json_scan::json_kind::number && ec == std::errc{} &&
+                      ptr == node.text.data() + node.text.size();
+            values.push_back(value);
+        }
+        bool finite = true;
+        for (const double value : values) {
+            finite &= std::isfinite(value);
+        }
+        if (!numeric || !finite || values.empty()) {
+            return invalid("model_service_action_values_invalid",
+                           "VLA action chunk action values must be a non-empty finite numeric array");
+        }
+        if (dims != 0 && values.size() != dims) {
+            return invalid("model_service_action_dims_mismatch",
+                           "VLA action chunk actions must all have the same number of values");
+        }
+        dims = values.size();
+        const std::uint32_t dt = doc.member(action, "dt_ms");
+        if (dt == json_scan::k_none) {
+            return invalid("model_service_action_dt_missing", "VLA action chunk action is missing dt_ms");
+        }
+        const std::optional<double> dt_ms = finite_number(doc, dt);
+        if (!dt_ms.has_value() || *dt_ms <= 0.0) {
+            return invalid("model_service_action_dt_invalid", "VLA action chunk dt_ms must be positive and finite");
+        }
     }
+    return std::nullopt;
+}
 
-    const auto values_it = action.find("values");
-    if (values_it == action.end()) {
-        return std::make_pair("model_service_action_values_missing", "VLA action chunk action is missing values");
+// Runs `policy` over a parsed output object: one pass over all nodes for the marker flags and one
+// over the top-level members for the required fields.
+std::optional<output_rule> check_output_policy(const output_policy& policy, const json_scan::json_doc& doc) {
+    std::uint16_t flagged = std::numeric_limits<std::uint16_t>::max();
+    for (std::uint32_t i = 1; i < doc.size(); ++i) {
+        const json_scan::json_node& node = doc.at(i);
+        if (node.kind != json_scan::json_kind::boolean || !node.flag || node.key.empty() || node.key_escaped) {
+            continue;
+        }
+        if (const auto it = policy.flags.find(node.key); it != policy.flags.end()) {
+            flagged = std::min(flagged, it->second);
+        }
     }
-    if (!parse_finite_number_array(values_it->second)) {
-        return std::make_pair("model_service_action_values_invalid",
-                              "VLA action chunk action values must be a non-empty finite numeric array");
+    if (flagged < policy.flag_rules.size()) {
+        return policy.flag_rules[flagged];
     }
 
-    const auto dt_it = action.find("dt_ms");
-    if (dt_it == action.end()) {
-        return std::make_pair("model_service_action_dt_missing", "VLA action chunk action is missing dt_ms");
+    std::uint64_t satisfied = 0;
+    std::uint32_t actions = json_scan::k_none;
+    for (std::uint32_t i = doc.at(0).first_child; i != json_scan::k_none; i = doc.at(i).next_sibling) {
+        const std::string_view key = doc.at(i).key;
+        if (const auto it = policy.required_members.find(key); it != policy.required_members.end()) {
+            satisfied |= it->second;
+        }
+        if (policy.action_chunk && key == "actions") {
+            actions = i;
+        }
     }
-    const std::optional<double> dt_ms = parse_json_number(dt_it->second);
-    if (!dt_ms.has_value() || *dt_ms <= 0.0) {
-        return std::make_pair("model_service_action_dt_invalid", "VLA action chunk dt_ms must be positive and finite");
+    for (std::size_t bit = 0; bit < policy.required_rules.size(); ++bit) {
+        if ((satisfied & (std::uint64_t{1} << bit)) == 0) {
+            return policy.required_rules[bit];
+        }
+    }
+    if (actions != json_scan::k_none) {
+        return check_action_chunk(doc, actions);
     }
-
     return std::nullopt;
 }
 
@@ -570,8 +713,62 @@ void reject_model_service_output(model_service_response& response,
     response.error_retryable = false;
 }
 
+bool is_model_service_batch_request(const model_service_request& request) {
+    if (request.op != model_service_operation::invoke) {
+        return false;
+    }
+    const auto input = parse_top_level_object(request.input_json);
+    const auto it = input.find("batch");
+    return it != input.end() && !trim_json_view(it->second).empty() && trim_json_view(it->second).front() == '[';
+}
+
+// Field-by-field scan of an envelope that is not strict JSON, kept for services that send one.
+model_service_response lenient_response_from_json(std::string_view text) {
+    const auto object = parse_top_level_object(text);
+    model_service_response out;
+    out.raw_json = text;
+    if (auto it = object.find("version"); it != object.end()) {
+        out.version = unquote_json_string(it->second);
+    }
+    if (auto it = object.find("id"); it != object.end()) {
+        out.id = unquote_json_string(it->second);
+    }
+    if (auto it = object.find("status"); it != object.end()) {
+        out.status = status_from_name(unquote_json_string(it->second));
+    }
+    if (auto it = object.find("output"); it != object.end() && it->second != "null") {
+        out.output_json = it->second;
+    }
+    if (auto it = object.find("session_id"); it != object.end() && it->second != "null") {
+        out.session_id = unquote_json_string(it->second);
+    }
+    if (auto it = object.find("metadata"); it != object.end() && it->second != "null") {
+        out.metadata_json = it->second;
+    }
+    if (auto it = object.find("error"); it != object.end() && it->second != "null") {
+        const auto error = parse_top_level_object(it->second);
+        if (auto eit = error.find("code"); eit != error.end()) {
+            out.error_code = unquote_json_string(eit->second);
+        }
+        if (auto eit = error.find("message"); eit != error.end()) {
+            out.error_message = unquote_json_string(eit->second);
+        }
+        if (auto eit = error.find("retryable"); eit != error.end()) {
+            out.error_retryable = eit->second == "true";
+        }
+    }
+    out.host_reached = false;
+    return out;
+}
+
 }  // namespace
 
+std::future<model_service_response> model_service_client::call_async(const model_service_request& request) {
+    std::promise<model_service_response> promise;
+    promise.set_value(call(request));
+    return promise.get_future();
+}
+
 model_service_response unavailable_model_service_client::call(const model_service_request& request) {
     model_service_response out;
     out.id = request.id;
@@ -635,44 +832,98 @@ std::string model_service_request_to_json(const model_service_request& request)
     return out.str();
 }
 
-model_service_response model_service_response_from_json(const std::string& text) {
-    const auto object = parse_top_level_object(text);
+model_service_response model_service_response_from_json(std::string_view text) {
+    // One document per thread: its node array keeps its capacity, so parsing an envelope allocates
+    // only the strings the response owns.
+    thread_local json_scan::json_doc doc;
+    if (!doc.parse(text) || doc.at(0).kind != json_scan::json_kind::object) {
+        return lenient_response_from_json(text);
+    }
+    const auto string_at = [&](std::uint32_t i) {
+        return doc.at(i).kind == json_scan::json_kind::string ? doc.string_value(i) : std::string();
+    };
+    const auto present = [&](std::uint32_t i) {
+        return i != json_scan::k_none && doc.at(i).kind != json_scan::json_kind::null;
+    };
     model_service_response out;
-    out.raw_json = text;
-    if (auto it = object.find("version"); it != object.end()) {
-        out.version = unquote_json_string(it->second);
+    out.raw_json.assign(text);
+    if (const std::uint32_t i = doc.member(0, "version"); i != json_scan::k_none) {
+        out.version = string_at(i);
     }
-    if (auto it = object.find("id"); it != object.end()) {
-        out.id = unquote_json_string(it->second);
+    if (const std::uint32_t i = doc.member(0, "id"); i != json_scan::k_none) {
+        out.id = string_at(i);
     }
-    if (auto it = object.find("status"); it != object.end()) {
-        out.status = status_from_name(unquote_json_string(it->second));
+    if (const std::uint32_t i = doc.member(0, "status"); i != json_scan::k_none) {
+        out.status = status_from_name(string_at(i));
     }
-    if (auto it = object.find("output"); it != object.end() && it->second != "null") {
-        out.output_json = it->second;
+    if (const std::uint32_t i = doc.member(0, "output"); present(i)) {
+        out.output_json.assign(doc.at(i).source);
     }
-    if (auto it = object.find("session_id"); it != object.end() && it->second != "null") {
-        out.session_id = unquote_json_string(it->second);
+    if (const std::uint32_t i = doc.member(0, "session_id"); present(i)) {
+        out.session_id = string_at(i);
     }
-    if (auto it = object.find("metadata"); it != object.end() && it->second != "null") {
-        out.metadata_json = it->second;
+    if (const std::uint32_t i = doc.member(0, "metadata"); present(i)) {
+        out.metadata_json.assign(doc.at(i).source);
     }
-    if (auto it = object.find("error"); it != object.end() && it->second != "null") {
-        const auto error = parse_top_level_object(it->second);
-        if (auto eit = error.find("code"); eit != error.end()) {
-            out.error_code = unquote_json_string(eit->second);
+    if (const std::uint32_t error = doc.member(0, "error"); present(error)) {
+        if (const std::uint32_t i = doc.member(error, "code"); i != json_scan::k_none) {
+            out.error_code = string_at(i);
         }
-        if (auto eit = error.find("message"); eit != error.end()) {
-            out.error_message = unquote_json_string(eit->second);
-        }
-        if (auto eit = error.find("retryable"); eit != error.end()) {
-            out.error_retryable = eit->second == "true";
+        if (const std::uint32_t i = doc.member(error, "message"); i != json_scan::k_none) {
+            out.error_message = string_at(i);
         }
+        const std::uint32_t retryable = doc.member(error, "retryable");
+        out.error_retryable = retryable != json_scan::k_none &&
+                              doc.at(retryable).kind == json_scan::json_kind::boolean && doc.at(retryable).flag;
     }
     out.host_reached = false;
     return out;
 }
 
+model_service_request model_service_request_from_json(const std::string& text) {
+    const auto object = parse_top_level_object(text);
+    model_service_request out;
+    const std::optional<std::string> op = json_string_value(object, "op");
+    if (!op.has_value() || !operation_from_name(*op, out.op)) {
+        throw std::invalid_argument("model-service request: missing or unknown op");
+    }
+    if (std::optional<std::string> version = json_string_value(object, "version"); version.has_value()) {
+        out.version = std::move(*version);
+    }
+    out.id = json_string_value(object, "id").value_or("");
+    out.capability = json_string_value(object, "capability").value_or("");
+    out.session_id = json_string_value(object, "session_id").value_or("");
+    if (auto it = object.find("deadline_ms"); it != object.end()) {
+        const std::optional<double> deadline = parse_json_number(it->second);
+        if (!deadline.has_value() || *deadline < 0.0) {
+            throw std::invalid_argument("model-service request: deadline_ms must be a non-negative number");
+        }
+        out.deadline_ms = static_cast<std::int64_t>(*deadline);
+    }
+    if (const std::optional<std::string> trace_json = json_object_value(object, "trace"); trace_json.has_value()) {
+        const auto trace = parse_top_level_object(*trace_json);
+        model_service_trace parsed;
+        parsed.run_id = json_string_value(trace, "run_id").value_or("");
+        parsed.tree_id = json_string_value(trace, "tree_id").value_or("");
+        parsed.node_id = json_string_value(trace, "node_id").value_or("");
+        if (auto it = trace.find("tick_id"); it != trace.end()) {
+            parsed.tick_id = static_cast<std::uint64_t>(parse_json_number(it->second).value_or(0.0));
+        }
+        out.trace = std::move(parsed);
+    }
+    if (auto it = object.find("input"); it != object.end() && trim_json_view(it->second) != "null") {
+        out.input_json = std::string(trim_json_view(it->second));
+    }
+    if (auto it = object.find("refs"); it != object.end()) {
+        out.refs_json = parse_top_level_object_array(it->second);
+    }
+    if (const std::optional<std::string> replay_json = json_object_value(object, "replay"); replay_json.has_value()) {
+        const std::string mode = json_string_value(parse_top_level_object(*replay_json), "mode").value_or("live");
+        out.replay_mode = mode == "live" ? std::string() : mode;
+    }
+    return out;
+}
+
 void validate_model_service_response(const model_service_request& request, model_service_response& response) {
     response.host_reached = false;
     if (request.op != model_service_operation::invoke && request.op != model_service_operation::step) {
@@ -698,89 +949,38 @@ void validate_model_service_response(const model_service_request& request, model
         return;
     }
 
-    const auto object = parse_top_level_object(output);
-    if (contains_json_bool_field(output, "unsafe", true) ||
-        contains_json_bool_field(output, "unsafe_output", true)) {
-        reject_model_service_output(response,
-                                    model_service_status::unsafe_output,
-                                    "model_service_unsafe_output",
-                                    "model-service output was marked unsafe");
-        return;
-    }
-    if (contains_json_bool_field(output, "policy_violation", true)) {
-        reject_model_service_output(response,
-                                    model_service_status::unsafe_output,
-                                    "model_service_policy_violation",
-                                    "model-service output violated host policy");
-        return;
-    }
-    if (contains_json_bool_field(output, "policy_violating", true)) {
-        reject_model_service_output(response,
-                                    model_service_status::unsafe_output,
-                                    "model_service_policy_violation",
-                                    "model-service output violated host policy");
+    // Batched outputs are checked item by item in split_model_service_batch_response.
+    if (is_model_service_batch_request(request)) {
+        const auto object = parse_top_level_object(output);
+        const auto it = object.find("batch");
+        if (it == object.end() || trim_json_view(it->second).empty() || trim_json_view(it->second).front() != '[') {
+            reject_model_service_output(response,
+                                        model_service_status::invalid_output,
+                                        "model_service_missing_batch",
+                                        "batched model-service output is missing the batch array");
+            return;
+        }
+        response.validation_ok = true;
         return;
     }
-    if (contains_json_bool_field(output, "stale", true) ||
-        contains_json_bool_field(output, "stale_result", true)) {
+
+    thread_local json_scan::json_doc doc;
+    if (!doc.parse(output) || doc.at(0).kind != json_scan::json_kind::object) {
         reject_model_service_output(response,
                                     model_service_status::invalid_output,
-                                    "model_service_stale_result",
-                                    "model-service output was marked stale");
+                                    "model_service_output_not_object",
+                                    "model-service output must be a JSON object");
         return;
     }
-    if (contains_json_bool_field(output, "late", true) ||
-        contains_json_bool_field(output, "late_result", true) ||
-        contains_json_bool_field(output, "deadline_missed", true)) {
+    if (const std::optional<output_rule> rejected = check_output_policy(output_policy_for(request.capability), doc);
+        rejected.has_value()) {
         reject_model_service_output(response,
-                                    model_service_status::invalid_output,
-                                    "model_service_late_result",
-                                    "model-service output was marked late");
+                                    rejected->status,
+                                    std::string(rejected->reason_code),
+                                    std::string(rejected->message));
         return;
     }
 
-    auto require_field = [&](std::string_view field, std::string reason_code, std::string message) -> bool {
-        if (object.find(std::string(field)) != object.end()) {
-            return true;
-        }
-        reject_model_service_output(response,
-                                    model_service_status::invalid_output,
-                                    std::move(reason_code),
-                                    std::move(message));
-        return false;
-    };
-
-    if (request.capability == "cap.model.world.rollout.v1") {
-        if (!require_field("predicted_states",
-                           "model_service_missing_predicted_states",
-                           "world rollout output is missing predicted_states")) {
-            return;
-        }
-    } else if (request.capability == "cap.model.world.score_trajectory.v1") {
-        if (!require_field("score", "model_service_missing_score", "trajectory score output is missing score")) {
-            return;
-        }
-    } else if (request.capability == "cap.vla.action_chunk.v1") {
-        if (!require_field("actions", "model_service_missing_actions", "VLA action chunk output is missing actions")) {
-            return;
-        }
-        if (const auto invalid = validate_action_chunk_shape(object.at("actions")); invalid.has_value()) {
-            reject_model_service_output(response,
-                                        model_service_status::invalid_output,
-                                        invalid->first,
-                                        invalid->second);
-            return;
-        }
-    } else if (request.capability == "cap.vla.propose_nav_goal.v1") {
-        if (object.find("goal") == object.end() && object.find("nav_goal") == object.end()) {
-            reject_model_service_output(response,
-                                        model_service_status::invalid_output,
-                                        "model_service_missing_nav_goal",
-                                        "VLA nav-goal output is missing goal or nav_goal");
-            return;
-        }
-    }
-
     response.validation_ok = true;
 }
 
@@ -793,6 +993,115 @@ std::vector<std::string> model_service_required_capabilities() {
     };
 }
 
+std::size_t model_service_batch_limit(std::string_view describe_output_json, std::string_view capability) {
+    const std::optional<std::string> descriptor = find_capability_descriptor(describe_output_json, capability);
+    if (!descriptor.has_value()) {
+        return 1;
+    }
+    const std::optional<std::string> batch = json_object_value(parse_top_level_object(*descriptor), "batch");
+    if (!batch.has_value()) {
+        return 1;
+    }
+    const auto batch_fields = parse_top_level_object(*batch);
+    const auto it = batch_fields.find("max_size");
+    if (it == batch_fields.end()) {
+        return 1;
+    }
+    const std::optional<double> max_size = parse_json_number(trim_json_view(it->second));
+    if (!max_size.has_value() || *max_size < 1.0 || *max_size != std::floor(*max_size)) {
+        return 1;
+    }
+    return static_cast<std::size_t>(*max_size);
+}
+
+model_service_request make_model_service_batch_request(const std::vector<model_service_request>& items,
+                                                       std::string id) {
+    model_service_request out;
+    out.id = std::move(id);
+    out.op = model_service_operation::invoke;
+    if (items.empty()) {
+        out.input_json = "{\"batch\":[]}";
+        return out;
+    }
+    out.capability = items.front().capability;
+    out.trace = items.front().trace;
+    out.replay_mode = items.front().replay_mode;
+
+    std::ostringstream input;
+    input << "{\"batch\":[";
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        const model_service_request& item = items[i];
+        if (item.deadline_ms > 0 && (out.deadline_ms <= 0 || item.deadline_ms < out.deadline_ms)) {
+            out.deadline_ms = item.deadline_ms;
+        }
+        if (i != 0) {
+            input << ',';
+        }
+        input << "{\"id\":" << json_quote(item.id) << ",\"input\":" << raw_json_or_empty_object(item.input_json)
+              << ",\"refs\":[";
+        for (std::size_t r = 0; r < item.refs_json.size(); ++r) {
+            if (r != 0) {
+                input << ',';
+            }
+            input << raw_json_or_empty_object(item.refs_json[r]);
+            out.refs_json.push_back(item.refs_json[r]);
+        }
+        input << "]}";
+    }
+    input << "]}";
+    out.input_json = input.str();
+    return out;
+}
+
+std::vector<model_service_response>
+split_model_service_batch_response(const std::vector<model_service_request>& items,
+                                   const model_service_response& response) {
+    std::vector<model_service_response> out;
+    out.reserve(items.size());
+    if (response.status != model_service_status::success) {
+        for (const model_service_request& item : items) {
+            model_service_response failed = response;
+            failed.id = item.id;
+            failed.status = response.status == model_service_status::action_chunk ? model_service_status::invalid_output
+                                                                                  : response.status;
+            if (response.status == model_service_status::action_chunk) {
+                failed.error_code = "model_service_batch_not_split";
+                failed.error_message = "batched model-service invoke returned a single action chunk";
+            }
+            out.push_back(std::move(failed));
+        }
+        return out;
+    }
+
+    const auto object = parse_top_level_object(response.output_json);
+    std::vector<std::string> entries;
+    if (const auto it = object.find("batch"); it != object.end()) {
+        entries = parse_top_level_object_array(it->second);
+    }
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        model_service_response item_response;
+        if (i < entries.size()) {
+            item_response = model_service_response_from_json(entries[i]);
+            if (item_response.id.empty()) {
+                item_response.id = items[i].id;
+            }
+        } else {
+            item_response.id = items[i].id;
+            item_response.status = model_service_status::invalid_output;
+            item_response.error_code = "model_service_batch_incomplete";
+            item_response.error_message = "batched model-service output has fewer entries than requests";
+            item_response.raw_json = model_service_response_to_json(item_response);
+        }
+        item_response.version = response.version;
+        item_response.request_hash = response.request_hash;
+        item_response.response_hash = response.response_hash;
+        item_response.replay_cache_hit = response.replay_cache_hit;
+        validate_model_service_response(items[i], item_response);
+        out.push_back(std::move(item_response));
+    }
+    return out;
+}
+
 model_service_compatibility_result
 check_model_service_compatibility(model_service_client& client,
                                   std::vector<std::string> required_capabilities,
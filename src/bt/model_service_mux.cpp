@@ -0,0 +1,591 @@
+#include "bt/model_service_mux.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <future>
+#include <stdexcept>
+#include <utility>
+
+#include "bt/event_log.hpp"
+
+#if !defined(_WIN32)
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace bt {
+namespace {
+
+constexpr std::string_view k_unix_scheme = "unix://";
+constexpr std::size_t k_frame_header_bytes = 4;
+constexpr std::size_t k_max_frame_bytes = std::size_t{64} << 20;
+// Bounds how long shutdown waits for a thread blocked in poll.
+constexpr int k_poll_ms = 50;
+
+using clock_type = std::chrono::steady_clock;
+
+model_service_response unavailable_response(const std::string& request_id, std::string message) {
+    model_service_response out;
+    out.id = request_id;
+    out.status = model_service_status::unavailable;
+    out.error_code = "model_service_unavailable";
+    out.error_message = std::move(message);
+    out.error_retryable = true;
+    return out;
+}
+
+std::string encode_frame(std::string_view payload) {
+    std::string out(k_frame_header_bytes, '\0');
+    const auto size = static_cast<std::uint32_t>(payload.size());
+    for (std::size_t i = 0; i < k_frame_header_bytes; ++i) {
+        out[i] = static_cast<char>((size >> (8 * i)) & 0xffu);
+    }
+    out.append(payload);
+    return out;
+}
+
+// Moves the first complete frame of `buffer` into `payload`. Returns false when the frame is not
+// complete yet; throws std::length_error for a frame larger than k_max_frame_bytes.
+bool take_frame(std::string& buffer, std::string& payload) {
+    if (buffer.size() < k_frame_header_bytes) {
+        return false;
+    }
+    std::size_t size = 0;
+    for (std::size_t i = 0; i < k_frame_header_bytes; ++i) {
+        size |= static_cast<std::size_t>(static_cast<unsigned char>(buffer[i])) << (8 * i);
+    }
+    if (size > k_max_frame_bytes) {
+        throw std::length_error("model-service mux frame exceeds " + std::to_string(k_max_frame_bytes) + " bytes");
+    }
+    if (buffer.size() < k_frame_header_bytes + size) {
+        return false;
+    }
+    payload.assign(buffer, k_frame_header_bytes, size);
+    buffer.erase(0, k_frame_header_bytes + size);
+    return true;
+}
+
+std::string socket_path_of(std::string_view endpoint) {
+    if (!is_unix_model_service_endpoint(endpoint) || endpoint.size() == k_unix_scheme.size()) {
+        throw std::invalid_argument("model-service endpoint must look like unix:///path/to/socket, got " +
+                                    std::string(endpoint));
+    }
+    return std::string(endpoint.substr(k_unix_scheme.size()));
+}
+
+#if !defined(_WIN32)
+
+#if defined(MSG_NOSIGNAL)
+constexpr int k_send_flags = MSG_NOSIGNAL;
+#else
+constexpr int k_send_flags = 0;
+#endif
+
+bool send_all(int fd, std::string_view bytes) {
+    while (!bytes.empty()) {
+        const ssize_t sent = ::send(fd, bytes.data(), bytes.size(), k_send_flags);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        bytes.remove_prefix(static_cast<std::size_t>(sent));
+    }
+    return true;
+}
+
+sockaddr_un unix_address(const std::string& path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        throw std::invalid_argument("model-service socket path is too long: " + path);
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return addr;
+}
+
+void suppress_sigpipe(int fd) {
+#if defined(SO_NOSIGPIPE)
+    const int on = 1;
+    (void)::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#else
+    (void)fd;
+#endif
+}
+
+#endif
+
+}  // namespace
+
+std::string model_service_dedup_key(const model_service_request& request) {
+    if (request.op != model_service_operation::describe && request.op != model_service_operation::invoke) {
+        return {};
+    }
+    model_service_request shared = request;
+    shared.id.clear();
+    shared.trace.reset();
+    shared.deadline_ms = 0;
+    return event_log::hash64_hex(model_service_request_to_json(shared));
+}
+
+bool is_unix_model_service_endpoint(std::string_view endpoint) noexcept {
+    return endpoint.substr(0, k_unix_scheme.size()) == k_unix_scheme;
+}
+
+#if defined(_WIN32)
+
+struct model_service_mux::connection {};
+struct model_service_mux::flight {};
+
+model_service_mux::model_service_mux(model_service_mux_options options, std::unique_ptr<model_service_client> upstream)
+    : options_(std::move(options)), upstream_(std::move(upstream)) {
+    throw std::runtime_error("model-service mux: Unix-domain sockets are not supported on this platform");
+}
+
+model_service_mux::~model_service_mux() = default;
+
+model_service_mux_stats model_service_mux::stats() const {
+    return {};
+}
+
+std::unique_ptr<model_service_client> make_unix_model_service_client(model_service_config config) {
+    (void)config;
+    return std::make_unique<unavailable_model_service_client>();
+}
+
+#else
+
+struct model_service_mux::connection {
+    int fd = -1;
+    // Serialises replies; fd is closed under it once the reader has exited.
+    std::mutex write_mutex;
+    std::atomic<bool> finished{false};
+    std::thread reader;
+};
+
+struct model_service_mux::flight {
+    struct waiter {
+        std::shared_ptr<connection> conn;
+        std::string id;
+    };
+
+    model_service_request request;
+    // Empty when the call is not shared.
+    std::string key;
+    // Guarded by model_service_mux::mutex_.
+    std::vector<waiter> waiters;
+};
+
+void model_service_mux::reply(const std::shared_ptr<connection>& conn,
+                              const std::string& id,
+                              model_service_response response) {
+    response.id = id;
+    const std::string frame = encode_frame(model_service_response_to_json(response));
+    std::lock_guard<std::mutex> lock(conn->write_mutex);
+    if (conn->fd >= 0) {
+        (void)send_all(conn->fd, frame);
+    }
+}
+
+model_service_mux::model_service_mux(model_service_mux_options options, std::unique_ptr<model_service_client> upstream)
+    : options_(std::move(options)), upstream_(std::move(upstream)) {
+    if (options_.socket_path.empty()) {
+        throw std::invalid_argument("model-service mux: socket_path must not be empty");
+    }
+    if (!upstream_) {
+        throw std::invalid_argument("model-service mux: upstream client must not be null");
+    }
+    if (options_.upstream_workers == 0) {
+        throw std::invalid_argument("model-service mux: upstream_workers must be positive");
+    }
+    const sockaddr_un addr = unix_address(options_.socket_path);
+    listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd_ < 0) {
+        throw std::runtime_error("model-service mux: socket() failed");
+    }
+    (void)::unlink(options_.socket_path.c_str());
+    if (::bind(listen_fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listen_fd_, 64) != 0) {
+        const std::string reason = std::strerror(errno);
+        ::close(listen_fd_);
+        throw std::runtime_error("model-service mux: cannot listen on " + options_.socket_path + ": " + reason);
+    }
+    workers_.reserve(options_.upstream_workers);
+    for (std::size_t i = 0; i < options_.upstream_workers; ++i) {
+        workers_.emplace_back([this] { upstream_loop(); });
+    }
+    accept_thread_ = std::thread([this] { accept_loop(); });
+}
+
+model_service_mux::~model_service_mux() {
+    stop_.store(true, std::memory_order_relaxed);
+    accept_thread_.join();
+    reap_connections(true);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.clear();
+    }
+    work_cv_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+    ::close(listen_fd_);
+    (void)::unlink(options_.socket_path.c_str());
+}
+
+model_service_mux_stats model_service_mux::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void model_service_mux::accept_loop() {
+    while (!stop_.load(std::memory_order_relaxed)) {
+        pollfd listener{.fd = listen_fd_, .events = POLLIN, .revents = 0};
+        if (::poll(&listener, 1, k_poll_ms) > 0) {
+            const int fd = ::accept(listen_fd_, nullptr, nullptr);
+            if (fd >= 0) {
+                suppress_sigpipe(fd);
+                auto conn = std::make_shared<connection>();
+                conn->fd = fd;
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    ++stats_.clients;
+                    ++stats_.clients_accepted;
+                    connections_.push_back(conn);
+                }
+                conn->reader = std::thread([this, conn] { read_loop(conn); });
+            }
+        }
+        reap_connections(false);
+    }
+}
+
+void model_service_mux::reap_connections(bool all) {
+    std::vector<std::shared_ptr<connection>> closing;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto done = [all](const std::shared_ptr<connection>& conn) { return all || conn->finished.load(); };
+        std::copy_if(connections_.begin(), connections_.end(), std::back_inserter(closing), done);
+        connections_.erase(std::remove_if(connections_.begin(), connections_.end(), done), connections_.end());
+        stats_.clients -= closing.size();
+    }
+    for (const std::shared_ptr<connection>& conn : closing) {
+        ::shutdown(conn->fd, SHUT_RDWR);
+        conn->reader.join();
+        std::lock_guard<std::mutex> lock(conn->write_mutex);
+        ::close(conn->fd);
+        conn->fd = -1;
+    }
+}
+
+void model_service_mux::read_loop(const std::shared_ptr<connection>& conn) {
+    std::string buffer;
+    std::string payload;
+    std::array<char, 16384> chunk{};
+    try {
+        while (!stop_.load(std::memory_order_relaxed)) {
+            pollfd client{.fd = conn->fd, .events = POLLIN, .revents = 0};
+            const int ready = ::poll(&client, 1, k_poll_ms);
+            if (ready < 0 && errno != EINTR) {
+                break;
+            }
+            if (ready <= 0) {
+                continue;
+            }
+            const ssize_t got = ::recv(conn->fd, chunk.data(), chunk.size(), 0);
+            if (got <= 0) {
+                break;
+            }
+            buffer.append(chunk.data(), static_cast<std::size_t>(got));
+            while (take_frame(buffer, payload)) {
+                model_service_request request;
+                try {
+                    request = model_service_request_from_json(payload);
+                } catch (const std::invalid_argument& e) {
+                    model_service_response rejected;
+                    rejected.status = model_service_status::invalid_request;
+                    rejected.error_code = "invalid_request";
+                    rejected.error_message = e.what();
+                    reply(conn, {}, std::move(rejected));
+                    continue;
+                }
+                dispatch(conn, std::move(request));
+            }
+        }
+    } catch (const std::length_error&) {
+        // A client that breaks framing is disconnected.
+    }
+    conn->finished.store(true);
+}
+
+void model_service_mux::dispatch(const std::shared_ptr<connection>& conn, model_service_request request) {
+    std::string key = model_service_dedup_key(request);
+    std::unique_lock<std::mutex> lock(mutex_);
+    ++stats_.requests;
+    if (!key.empty()) {
+        if (const auto cached = cache_.find(key); cached != cache_.end()) {
+            if (clock_type::now() < cached->second.expires) {
+                ++stats_.cache_hits;
+                model_service_response response = cached->second.response;
+                lock.unlock();
+                reply(conn, request.id, std::move(response));
+                return;
+            }
+            cache_.erase(cached);
+        }
+        if (const auto running = in_flight_.find(key); running != in_flight_.end()) {
+            ++stats_.deduplicated;
+            running->second->waiters.push_back({conn, request.id});
+            return;
+        }
+    }
+    auto call = std::make_shared<flight>();
+    call->waiters.push_back({conn, request.id});
+    call->request = std::move(request);
+    if (!key.empty()) {
+        in_flight_.emplace(key, call);
+    }
+    call->key = std::move(key);
+    queue_.push_back(std::move(call));
+    lock.unlock();
+    work_cv_.notify_one();
+}
+
+void model_service_mux::upstream_loop() {
+    for (;;) {
+        std::shared_ptr<flight> call;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_cv_.wait(lock, [this] { return stop_.load(std::memory_order_relaxed) || !queue_.empty(); });
+            if (stop_.load(std::memory_order_relaxed)) {
+                return;
+            }
+            call = std::move(queue_.front());
+            queue_.pop_front();
+            ++stats_.upstream_calls;
+        }
+        model_service_response response;
+        try {
+            response = upstream_->call(call->request);
+        } catch (const std::exception& e) {
+            response = unavailable_response(call->request.id, std::string("model-service mux upstream: ") + e.what());
+        }
+        finish(call, std::move(response));
+    }
+}
+
+void model_service_mux::finish(const std::shared_ptr<flight>& call, model_service_response response) {
+    std::vector<flight::waiter> waiters;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!call->key.empty()) {
+            in_flight_.erase(call->key);
+            const bool ok = response.status == model_service_status::success ||
+                            response.status == model_service_status::action_chunk;
+            clock_type::time_point expires{};
+            if (ok && call->request.op == model_service_operation::describe) {
+                expires = clock_type::time_point::max();
+            } else if (ok && options_.cache_ttl_ms > 0) {
+                expires = clock_type::now() + std::chrono::milliseconds(options_.cache_ttl_ms);
+            }
+            if (expires != clock_type::time_point{} && options_.cache_entries > 0) {
+                const std::uint64_t order = next_cache_order_++;
+                cache_[call->key] = cache_entry{.response = response, .expires = expires, .order = order};
+                cache_order_.emplace_back(order, call->key);
+                while (cache_order_.size() > options_.cache_entries) {
+                    const auto& [oldest_order, oldest_key] = cache_order_.front();
+                    if (const auto it = cache_.find(oldest_key); it != cache_.end() && it->second.order == oldest_order) {
+                        cache_.erase(it);
+                    }
+                    cache_order_.pop_front();
+                }
+            }
+        }
+        waiters = std::move(call->waiters);
+    }
+    for (const flight::waiter& waiter : waiters) {
+        reply(waiter.conn, waiter.id, response);
+    }
+}
+
+namespace {
+
+// A request from call_async until its future is completed.
+struct pending_call {
+    std::string id;
+    clock_type::time_point deadline;
+    std::promise<model_service_response> promise;
+};
+using pending_ptr = std::shared_ptr<pending_call>;
+using completion = std::pair<pending_ptr, model_service_response>;
+
+// MMSP client of a model_service_mux over one Unix-domain connection. Requests are written by the
+// calling thread; a reader thread matches responses to requests by id, expires requests past their
+// deadline and fails everything in flight when the connection drops. The next call reconnects.
+class unix_model_service_client final : public model_service_client {
+public:
+    explicit unix_model_service_client(model_service_config config) : config_(std::move(config)) {
+        try {
+            socket_path_ = socket_path_of(config_.endpoint);
+            (void)unix_address(socket_path_);
+        } catch (const std::invalid_argument& e) {
+            endpoint_error_ = e.what();
+        }
+    }
+
+    unix_model_service_client(const unix_model_service_client&) = delete;
+    unix_model_service_client& operator=(const unix_model_service_client&) = delete;
+
+    ~unix_model_service_client() override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (fd_ >= 0) {
+            ::shutdown(fd_, SHUT_RDWR);
+        }
+        lock.unlock();
+        if (reader_.joinable()) {
+            reader_.join();
+        }
+    }
+
+    [[nodiscard]] model_service_response call(const model_service_request& request) override {
+        return call_async(request).get();
+    }
+
+    [[nodiscard]] std::future<model_service_response> call_async(const model_service_request& request) override {
+        auto call = std::make_shared<pending_call>();
+        call->id = request.id;
+        call->deadline = clock_type::now() + std::chrono::milliseconds(std::max<std::int64_t>(config_.request_timeout_ms, 1));
+        std::future<model_service_response> future = call->promise.get_future();
+        if (!endpoint_error_.empty()) {
+            call->promise.set_value(unavailable_response(request.id, endpoint_error_));
+            return future;
+        }
+        const std::string frame = encode_frame(model_service_request_to_json(request));
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (fd_ < 0 && !connect_locked()) {
+            lock.unlock();
+            call->promise.set_value(unavailable_response(request.id, last_error_));
+            return future;
+        }
+        pending_[request.id].push_back(call);
+        if (!send_all(fd_, frame)) {
+            // The reader fails the request along with the rest of the connection.
+            ::shutdown(fd_, SHUT_RDWR);
+        }
+        return future;
+    }
+
+private:
+    // Caller holds mutex_ and fd_ is closed. The previous reader, if any, has already left its last
+    // locked section, so joining it here cannot deadlock.
+    bool connect_locked() {
+        if (reader_.joinable()) {
+            reader_.join();
+        }
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            last_error_ = "model-service mux: socket() failed";
+            return false;
+        }
+        const sockaddr_un addr = unix_address(socket_path_);
+        if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+            last_error_ = "model-service mux at " + socket_path_ + " is not reachable: " + std::strerror(errno);
+            ::close(fd);
+            return false;
+        }
+        suppress_sigpipe(fd);
+        fd_ = fd;
+        reader_ = std::thread([this, fd] { read_loop(fd); });
+        return true;
+    }
+
+    void read_loop(int fd) {
+        std::string buffer;
+        std::string payload;
+        std::array<char, 16384> chunk{};
+        bool open = true;
+        while (open) {
+            pollfd p{.fd = fd, .events = POLLIN, .revents = 0};
+            const int ready = ::poll(&p, 1, k_poll_ms);
+            if (ready < 0 && errno != EINTR) {
+                open = false;
+            } else if (ready > 0) {
+                const ssize_t got = ::recv(fd, chunk.data(), chunk.size(), 0);
+                if (got <= 0) {
+                    open = false;
+                } else {
+                    buffer.append(chunk.data(), static_cast<std::size_t>(got));
+                }
+            }
+            std::vector<completion> done;
+            try {
+                while (take_frame(buffer, payload)) {
+                    model_service_response response = model_service_response_from_json(payload);
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    const auto it = pending_.find(response.id);
+                    if (it == pending_.end()) {
+                        continue;
+                    }
+                    done.emplace_back(std::move(it->second.front()), std::move(response));
+                    it->second.pop_front();
+                    if (it->second.empty()) {
+                        pending_.erase(it);
+                    }
+                }
+            } catch (const std::length_error&) {
+                open = false;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                const auto now = clock_type::now();
+                for (auto it = pending_.begin(); it != pending_.end();) {
+                    auto& calls = it->second;
+                    for (auto call = calls.begin(); call != calls.end();) {
+                        if (!open || now >= (*call)->deadline) {
+                            done.emplace_back(*call,
+                                              unavailable_response((*call)->id,
+                                                                   open ? "model-service response timed out"
+                                                                        : "model-service mux connection closed"));
+                            call = calls.erase(call);
+                        } else {
+                            ++call;
+                        }
+                    }
+                    it = calls.empty() ? pending_.erase(it) : std::next(it);
+                }
+                if (!open) {
+                    ::close(fd);
+                    fd_ = -1;
+                }
+            }
+            for (auto& [call, response] : done) {
+                call->promise.set_value(std::move(response));
+            }
+        }
+    }
+
+    model_service_config config_;
+    std::string socket_path_;
+    std::string endpoint_error_;
+
+    std::mutex mutex_;
+    int fd_ = -1;
+    std::string last_error_;
+    std::unordered_map<std::string, std::deque<pending_ptr>> pending_;
+    std::thread reader_;
+};
+
+}  // namespace
+
+std::unique_ptr<model_service_client> make_unix_model_service_client(model_service_config config) {
+    return std::make_unique<unix_model_service_client>(std::move(config));
+}
+
+#endif
+
+}  // namespace bt
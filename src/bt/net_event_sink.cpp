@@ -0,0 +1,508 @@
+#include "bt/net_event_sink.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MUESLI_BT_HAVE_NET_SINK 1
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#else
+#define MUESLI_BT_HAVE_NET_SINK 0
+#endif
+
+#if MUESLI_BT_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace bt {
+namespace {
+
+constexpr std::size_t k_take_lines = 256;
+
+void put_u16(char* out, std::uint16_t v) noexcept {
+    out[0] = static_cast<char>(v & 0xffu);
+    out[1] = static_cast<char>((v >> 8) & 0xffu);
+}
+
+void put_u32(char* out, std::uint32_t v) noexcept {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<char>((v >> (8 * i)) & 0xffu);
+    }
+}
+
+void put_u64(char* out, std::uint64_t v) noexcept {
+    for (int i = 0; i < 8; ++i) {
+        out[i] = static_cast<char>((v >> (8 * i)) & 0xffu);
+    }
+}
+
+constexpr std::size_t k_dropped_offset = 32;
+
+#if MUESLI_BT_HAVE_NET_SINK
+void set_nonblocking(int fd) noexcept {
+    const int flags = ::fcntl(fd, F_GETFL, 0);
+    (void)::fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    (void)::fcntl(fd, F_SETFD, FD_CLOEXEC);
+}
+
+#if defined(MSG_NOSIGNAL)
+constexpr int k_send_flags = MSG_NOSIGNAL;
+#else
+constexpr int k_send_flags = 0;
+#endif
+#endif
+
+int poll_timeout_ms(std::chrono::steady_clock::time_point now, std::chrono::steady_clock::time_point at) noexcept {
+    if (at <= now) {
+        return 0;
+    }
+    const auto ms = std::chrono::ceil<std::chrono::milliseconds>(at - now).count();
+    return static_cast<int>(std::min<std::int64_t>(ms, 60'000));
+}
+
+}  // namespace
+
+net_event_sink::net_event_sink(net_sink_options options) : options_(std::move(options)) {
+    if (!supported()) {
+        throw std::runtime_error("net_event_sink: network event output is not supported on this platform");
+    }
+    constexpr std::string_view scheme = "tcp://";
+    const std::string_view endpoint = options_.endpoint;
+    if (endpoint.substr(0, scheme.size()) != scheme) {
+        throw std::invalid_argument("net_event_sink: endpoint must look like tcp://host:port");
+    }
+    const std::string_view authority = endpoint.substr(scheme.size());
+    const std::size_t colon = authority.rfind(':');
+    if (colon == std::string_view::npos || colon == 0 || colon + 1 == authority.size()) {
+        throw std::invalid_argument("net_event_sink: endpoint must look like tcp://host:port");
+    }
+    host_.assign(authority.substr(0, colon));
+    std::uint32_t port = 0;
+    for (const char c : authority.substr(colon + 1)) {
+        if (c < '0' || c > '9' || port > 65535u) {
+            throw std::invalid_argument("net_event_sink: invalid port in endpoint");
+        }
+        port = port * 10u + static_cast<std::uint32_t>(c - '0');
+    }
+    if (port == 0 || port > 65535u) {
+        throw std::invalid_argument("net_event_sink: invalid port in endpoint");
+    }
+    port_ = static_cast<std::uint16_t>(port);
+    if (options_.queue_lines == 0 || options_.batch_bytes == 0 || options_.max_buffered_bytes == 0) {
+        throw std::invalid_argument("net_event_sink: queue, batch and buffer sizes must be positive");
+    }
+    if (options_.sample_every == 0) {
+        throw std::invalid_argument("net_event_sink: sample_every must be positive");
+    }
+    if (options_.batch_interval.count() <= 0 || options_.reconnect_interval.count() <= 0) {
+        throw std::invalid_argument("net_event_sink: batch and reconnect intervals must be positive");
+    }
+    slots_.resize(std::bit_ceil(options_.queue_lines));
+    mask_ = slots_.size() - 1;
+
+#if MUESLI_BT_HAVE_NET_SINK
+    int fds[2] = {-1, -1};
+    if (::pipe(fds) != 0) {
+        throw std::runtime_error(std::string("net_event_sink: pipe failed: ") + std::strerror(errno));
+    }
+    set_nonblocking(fds[0]);
+    set_nonblocking(fds[1]);
+    wake_read_fd_ = fds[0];
+    wake_write_fd_ = fds[1];
+#endif
+    thread_ = std::thread([this] { run(); });
+}
+
+net_event_sink::~net_event_sink() {
+    stopping_.store(true);
+    wake();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+#if MUESLI_BT_HAVE_NET_SINK
+    if (wake_read_fd_ >= 0) {
+        ::close(wake_read_fd_);
+    }
+    if (wake_write_fd_ >= 0) {
+        ::close(wake_write_fd_);
+    }
+#endif
+}
+
+bool net_event_sink::supported() noexcept {
+    return MUESLI_BT_HAVE_NET_SINK != 0;
+}
+
+bool net_event_sink::compression_supported() noexcept {
+    return MUESLI_BT_HAVE_ZLIB != 0;
+}
+
+bool net_event_sink::push(std::string_view line, bool essential) {
+    const std::uint64_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) >= slots_.size()) {
+        dropped_queue_full_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    slot& s = slots_[head & mask_];
+    s.line.assign(line);
+    s.essential = essential;
+    head_.store(head + 1);
+    // Pairs with the idle check in run(): either the sender sees the new head before it polls, or
+    // this sees it idle and writes to the wake pipe.
+    if (idle_.load()) {
+        wake();
+    }
+    return true;
+}
+
+bool net_event_sink::flush(std::chrono::milliseconds timeout) {
+    const std::uint64_t target = head_.load();
+    std::uint64_t requested = flush_requested_.load();
+    while (requested < target && !flush_requested_.compare_exchange_weak(requested, target)) {
+    }
+    wake();
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (flushed_.load() < target) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+const net_sink_options& net_event_sink::options() const noexcept {
+    return options_;
+}
+
+net_sink_stats net_event_sink::stats() const {
+    net_sink_stats out;
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        out = stats_;
+    }
+    out.dropped_queue_full = dropped_queue_full_.load(std::memory_order_relaxed);
+    return out;
+}
+
+void net_event_sink::wake() {
+#if MUESLI_BT_HAVE_NET_SINK
+    const char byte = 1;
+    (void)!::write(wake_write_fd_, &byte, 1);
+#endif
+}
+
+void net_event_sink::run() {
+#if MUESLI_BT_HAVE_NET_SINK
+    using clock = std::chrono::steady_clock;
+    std::optional<clock::time_point> stop_deadline;
+    while (true) {
+        clock::time_point now = clock::now();
+        take_lines(now);
+        const bool stopping = stopping_.load();
+        const std::uint64_t taken = tail_.load(std::memory_order_relaxed);
+        const std::uint64_t flush_target = flush_requested_.load();
+        const bool flushing = flush_target > flushed_.load() && taken >= flush_target;
+        if (batch_lines_ != 0 && (stopping || flushing || now - batch_started_ >= options_.batch_interval)) {
+            seal_frame();
+        }
+        enforce_bound();
+        if (socket_fd_ < 0 && now >= next_connect_) {
+            try_connect(now);
+        }
+        if (flushing && frames_.empty()) {
+            flushed_.store(flush_target);
+        }
+        if (stopping) {
+            if (!stop_deadline) {
+                stop_deadline = now + options_.reconnect_interval;
+            }
+            if (frames_.empty() || now >= *stop_deadline) {
+                break;
+            }
+        }
+
+        clock::time_point wake_at = clock::time_point::max();
+        if (batch_lines_ != 0) {
+            wake_at = std::min(wake_at, batch_started_ + options_.batch_interval);
+        }
+        if (socket_fd_ < 0) {
+            wake_at = std::min(wake_at, next_connect_);
+        }
+        if (stop_deadline) {
+            wake_at = std::min(wake_at, *stop_deadline);
+        }
+
+        pollfd fds[2] = {{wake_read_fd_, POLLIN, 0}, {socket_fd_, 0, 0}};
+        nfds_t count = 1;
+        if (socket_fd_ >= 0) {
+            fds[1].events = connecting_ || !frames_.empty() ? POLLOUT : POLLIN;
+            count = 2;
+        }
+        idle_.store(true);
+        int timeout = wake_at == clock::time_point::max() ? -1 : poll_timeout_ms(now, wake_at);
+        if (head_.load() != tail_.load(std::memory_order_relaxed)) {
+            timeout = 0;
+        }
+        const int ready = ::poll(fds, count, timeout);
+        idle_.store(false);
+        if (ready <= 0) {
+            continue;
+        }
+        if ((fds[0].revents & POLLIN) != 0) {
+            char sink[64];
+            while (::read(wake_read_fd_, sink, sizeof(sink)) > 0) {
+            }
+        }
+        if (count == 2 && fds[1].revents != 0) {
+            if (connecting_) {
+                int error = 0;
+                socklen_t len = sizeof(error);
+                (void)::getsockopt(socket_fd_, SOL_SOCKET, SO_ERROR, &error, &len);
+                if (error != 0) {
+                    close_link(false);
+                    continue;
+                }
+                connecting_ = false;
+                std::lock_guard<std::mutex> lock(stats_mutex_);
+                stats_.connected = true;
+                ++stats_.connects;
+            } else if ((fds[1].revents & (POLLIN | POLLHUP | POLLERR)) != 0) {
+                // The collector sends nothing; readable means it closed or reset the connection.
+                char sink[256];
+                const ssize_t got = ::recv(socket_fd_, sink, sizeof(sink), 0);
+                if (got == 0 || (got < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                    close_link(true);
+                    continue;
+                }
+            }
+            if (socket_fd_ >= 0 && !connecting_ && !frames_.empty()) {
+                send_pending();
+            }
+        }
+    }
+
+    // Whatever is still buffered at shutdown never reaches the collector.
+    std::uint64_t undelivered = 0;
+    for (const frame& f : frames_) {
+        undelivered += f.lines;
+    }
+    frames_.clear();
+    if (socket_fd_ >= 0) {
+        ::close(socket_fd_);
+        socket_fd_ = -1;
+    }
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_.dropped_link += undelivered;
+    stats_.buffered_bytes = 0;
+    stats_.connected = false;
+#endif
+}
+
+void net_event_sink::take_lines(std::chrono::steady_clock::time_point now) {
+    std::uint64_t tail = tail_.load(std::memory_order_relaxed);
+    const std::uint64_t head = head_.load(std::memory_order_acquire);
+    std::uint64_t sampled = 0;
+    while (tail != head) {
+        const std::uint64_t end = std::min(head, tail + k_take_lines);
+        for (std::uint64_t i = tail; i < end; ++i) {
+            const slot& s = slots_[i & mask_];
+            if (sampling_ && !s.essential && sample_counter_++ % options_.sample_every != 0) {
+                ++sampled;
+                continue;
+            }
+            if (batch_lines_ == 0) {
+                batch_started_ = now;
+            }
+            batch_.append(s.line);
+            batch_.push_back('\n');
+            ++batch_lines_;
+            if (batch_.size() >= options_.batch_bytes) {
+                seal_frame();
+            }
+        }
+        tail = end;
+        tail_.store(tail, std::memory_order_release);
+    }
+    if (sampled != 0) {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats_.dropped_sampled += sampled;
+    }
+}
+
+void net_event_sink::seal_frame() {
+    if (batch_lines_ == 0) {
+        return;
+    }
+    std::string_view payload = batch_;
+    std::uint8_t codec = k_codec_raw;
+#if MUESLI_BT_HAVE_ZLIB
+    if (options_.compress) {
+        uLongf size = compressBound(static_cast<uLong>(batch_.size()));
+        compress_buffer_.resize(size);
+        if (compress2(reinterpret_cast<Bytef*>(compress_buffer_.data()),
+                      &size,
+                      reinterpret_cast<const Bytef*>(batch_.data()),
+                      static_cast<uLong>(batch_.size()),
+                      Z_BEST_SPEED) == Z_OK &&
+            size < batch_.size()) {
+            payload = std::string_view(compress_buffer_.data(), size);
+            codec = k_codec_deflate;
+        }
+    }
+#endif
+    frame f;
+    f.lines = batch_lines_;
+    f.raw_bytes = batch_.size();
+    f.bytes.resize(k_frame_header_bytes);
+    char* header = f.bytes.data();
+    std::memcpy(header, "MBTN", 4);
+    header[4] = static_cast<char>(k_wire_version);
+    header[5] = static_cast<char>(codec);
+    put_u16(header + 6, 0);
+    put_u64(header + 8, next_seq_++);
+    put_u32(header + 16, static_cast<std::uint32_t>(batch_lines_));
+    put_u32(header + 20, static_cast<std::uint32_t>(batch_.size()));
+    put_u32(header + 24, static_cast<std::uint32_t>(payload.size()));
+    put_u32(header + 28, 0);
+    put_u64(header + k_dropped_offset, 0);
+    f.bytes.append(payload);
+    frames_.push_back(std::move(f));
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats_.buffered_bytes += frames_.back().bytes.size();
+        update_sampling_locked();
+    }
+    batch_.clear();
+    batch_lines_ = 0;
+}
+
+void net_event_sink::update_sampling_locked() {
+    if (options_.overflow != net_overflow_policy::sample) {
+        return;
+    }
+    const std::uint64_t bound = options_.max_buffered_bytes;
+    if (stats_.buffered_bytes > bound - bound / 4) {
+        sampling_ = true;
+    } else if (stats_.buffered_bytes <= bound / 2) {
+        sampling_ = false;
+    }
+    stats_.sampling = sampling_;
+}
+
+void net_event_sink::enforce_bound() {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    update_sampling_locked();
+    const std::uint64_t bound = options_.max_buffered_bytes;
+    // A frame already partly on the wire has to be finished, or the stream loses its framing.
+    const std::size_t keep = front_sent_ != 0 ? 1u : 0u;
+    while (stats_.buffered_bytes > bound && frames_.size() > keep) {
+        const auto victim = frames_.begin() + static_cast<std::ptrdiff_t>(keep);
+        stats_.dropped_overflow += victim->lines;
+        stats_.buffered_bytes -= victim->bytes.size();
+        frames_.erase(victim);
+    }
+}
+
+void net_event_sink::try_connect(std::chrono::steady_clock::time_point now) {
+#if MUESLI_BT_HAVE_NET_SINK
+    next_connect_ = now + options_.reconnect_interval;
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* found = nullptr;
+    const std::string port = std::to_string(port_);
+    if (::getaddrinfo(host_.c_str(), port.c_str(), &hints, &found) != 0 || found == nullptr) {
+        return;
+    }
+    const int fd = ::socket(found->ai_family, found->ai_socktype, found->ai_protocol);
+    if (fd < 0) {
+        ::freeaddrinfo(found);
+        return;
+    }
+    set_nonblocking(fd);
+#if defined(SO_NOSIGPIPE)
+    const int one = 1;
+    (void)::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+    const int rc = ::connect(fd, found->ai_addr, found->ai_addrlen);
+    ::freeaddrinfo(found);
+    if (rc != 0 && errno != EINPROGRESS) {
+        ::close(fd);
+        return;
+    }
+    socket_fd_ = fd;
+    connecting_ = true;
+#else
+    (void)now;
+#endif
+}
+
+void net_event_sink::close_link(bool lost) {
+#if MUESLI_BT_HAVE_NET_SINK
+    ::close(socket_fd_);
+#endif
+    socket_fd_ = -1;
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    if (!connecting_) {
+        ++stats_.disconnects;
+    }
+    connecting_ = false;
+    stats_.connected = false;
+    // The collector got part of the front frame at most; a reconnect must start on a frame boundary.
+    if (lost && front_sent_ != 0 && !frames_.empty()) {
+        stats_.dropped_link += frames_.front().lines;
+        stats_.buffered_bytes -= frames_.front().bytes.size();
+        frames_.pop_front();
+    }
+    front_sent_ = 0;
+}
+
+void net_event_sink::send_pending() {
+#if MUESLI_BT_HAVE_NET_SINK
+    while (!frames_.empty()) {
+        frame& f = frames_.front();
+        if (front_sent_ == 0) {
+            std::uint64_t dropped = dropped_queue_full_.load(std::memory_order_relaxed);
+            {
+                std::lock_guard<std::mutex> lock(stats_mutex_);
+                dropped += stats_.dropped_overflow + stats_.dropped_sampled + stats_.dropped_link;
+            }
+            put_u64(f.bytes.data() + k_dropped_offset, dropped);
+        }
+        const ssize_t sent =
+            ::send(socket_fd_, f.bytes.data() + front_sent_, f.bytes.size() - front_sent_, k_send_flags);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                close_link(true);
+            }
+            return;
+        }
+        front_sent_ += static_cast<std::size_t>(sent);
+        if (front_sent_ < f.bytes.size()) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        ++stats_.frames_sent;
+        stats_.lines_sent += f.lines;
+        stats_.raw_bytes_sent += f.raw_bytes;
+        stats_.wire_bytes_sent += f.bytes.size();
+        stats_.buffered_bytes -= f.bytes.size();
+        front_sent_ = 0;
+        frames_.pop_front();
+    }
+#endif
+}
+
+}  // namespace bt
@@ -0,0 +1,162 @@
+#include "bt/payload_pool.hpp"
+
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace bt {
+
+struct payload_pool::state {
+    struct size_class {
+        std::vector<std::unique_ptr<std::byte[]>> free;
+        std::size_t in_use = 0;
+    };
+
+    mutable std::mutex mutex;
+    std::size_t capacity_bytes = 0;
+    std::size_t reserved_bytes = 0;
+    std::size_t in_use_bytes = 0;
+    std::uint64_t acquired = 0;
+    std::uint64_t reused = 0;
+    std::uint64_t trimmed = 0;
+    std::uint64_t exhausted = 0;
+    // Keyed by slab size.
+    std::map<std::size_t, size_class> classes;
+
+    // Drops free slabs of sizes other than `keep` until `bytes` more fit. Requires the lock.
+    void make_room(std::size_t bytes, std::size_t keep) {
+        for (auto it = classes.begin(); it != classes.end() && reserved_bytes + bytes > capacity_bytes;) {
+            size_class& cls = it->second;
+            while (it->first != keep && !cls.free.empty() && reserved_bytes + bytes > capacity_bytes) {
+                cls.free.pop_back();
+                reserved_bytes -= it->first;
+                ++trimmed;
+            }
+            it = cls.free.empty() && cls.in_use == 0 && it->first != keep ? classes.erase(it) : std::next(it);
+        }
+    }
+
+    void give_back(std::byte* slab, std::size_t bytes) noexcept {
+        // Declared before the lock, so a slab that is not kept is freed after it is released.
+        std::unique_ptr<std::byte[]> owned(slab);
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto it = classes.find(bytes);
+        --it->second.in_use;
+        in_use_bytes -= bytes;
+        if (reserved_bytes <= capacity_bytes) {
+            try {
+                it->second.free.push_back(std::move(owned));
+                return;
+            } catch (const std::bad_alloc&) {
+            }
+        }
+        reserved_bytes -= bytes;
+        if (it->second.free.empty() && it->second.in_use == 0) {
+            classes.erase(it);
+        }
+    }
+};
+
+payload_pool::payload_pool(std::size_t capacity_bytes) : state_(std::make_shared<state>()) {
+    state_->capacity_bytes = capacity_bytes;
+}
+
+payload_pool::~payload_pool() = default;
+
+std::shared_ptr<std::byte[]> payload_pool::acquire(std::size_t bytes) {
+    if (bytes == 0) {
+        throw std::invalid_argument("payload_pool: cannot acquire an empty slab");
+    }
+    std::unique_ptr<std::byte[]> slab;
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        ++state_->acquired;
+        state::size_class& cls = state_->classes[bytes];
+        if (!cls.free.empty()) {
+            slab = std::move(cls.free.back());
+            cls.free.pop_back();
+            ++state_->reused;
+        } else {
+            state_->make_room(bytes, bytes);
+            if (state_->reserved_bytes + bytes > state_->capacity_bytes) {
+                ++state_->exhausted;
+                if (cls.in_use == 0) {
+                    state_->classes.erase(bytes);
+                }
+                throw std::length_error("frame pool exhausted: " + std::to_string(state_->in_use_bytes) + " of " +
+                                        std::to_string(state_->capacity_bytes) + " bytes in use");
+            }
+            state_->reserved_bytes += bytes;
+        }
+        ++cls.in_use;
+        state_->in_use_bytes += bytes;
+    }
+    if (!slab) {
+        try {
+            slab = std::make_unique_for_overwrite<std::byte[]>(bytes);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            state_->reserved_bytes -= bytes;
+            state_->in_use_bytes -= bytes;
+            if (--state_->classes[bytes].in_use == 0 && state_->classes[bytes].free.empty()) {
+                state_->classes.erase(bytes);
+            }
+            throw;
+        }
+    }
+    // If the control block cannot be allocated, the deleter still runs and returns the slab.
+    return std::shared_ptr<std::byte[]>(slab.release(),
+                                        [st = state_, bytes](std::byte* p) { st->give_back(p, bytes); });
+}
+
+void payload_pool::set_capacity(std::size_t bytes) {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->capacity_bytes = bytes;
+    if (state_->reserved_bytes > bytes) {
+        state_->make_room(0, 0);
+    }
+}
+
+std::size_t payload_pool::capacity() const {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->capacity_bytes;
+}
+
+void payload_pool::trim() {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    for (auto it = state_->classes.begin(); it != state_->classes.end();) {
+        state_->reserved_bytes -= it->first * it->second.free.size();
+        state_->trimmed += it->second.free.size();
+        it->second.free.clear();
+        it = it->second.in_use == 0 ? state_->classes.erase(it) : std::next(it);
+    }
+}
+
+payload_pool_stats payload_pool::stats() const {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    payload_pool_stats out;
+    out.capacity_bytes = state_->capacity_bytes;
+    out.reserved_bytes = state_->reserved_bytes;
+    out.in_use_bytes = state_->in_use_bytes;
+    out.acquired = state_->acquired;
+    out.reused = state_->reused;
+    out.trimmed = state_->trimmed;
+    out.exhausted = state_->exhausted;
+    out.classes.reserve(state_->classes.size());
+    for (const auto& [bytes, cls] : state_->classes) {
+        out.slabs_in_use += cls.in_use;
+        out.slabs_free += cls.free.size();
+        out.classes.push_back(payload_pool_class_stats{
+            .slab_bytes = bytes,
+            .slabs = cls.in_use + cls.free.size(),
+            .in_use = cls.in_use,
+        });
+    }
+    return out;
+}
+
+}  // namespace bt
@@ -2,17 +2,23 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cmath>
 #include <cctype>
+#include <cstring>
+#include <exception>
 #include <filesystem>
 #include <fstream>
 #include <functional>
 #include <limits>
+#include <memory>
 #include <optional>
 #include <sstream>
 #include <stdexcept>
 #include <utility>
 
+#include "planner_linalg.hpp"
+
 namespace bt {
 namespace {
 
@@ -188,6 +194,115 @@ std::vector<planner_bound> resolve_bounds(const planner_request& request, const
     return sanitise_bounds(model.action_bounds(), dims);
 }
 
+// Builds the bytes of a result-cache key; values are appended raw, strings with their length.
+class cache_key_writer {
+public:
+    void add(double value) { append(&value, sizeof(value)); }
+    void add(std::int64_t value) { append(&value, sizeof(value)); }
+    void add(bool value) { key_.push_back(value ? '\1' : '\0'); }
+    void add(const std::string& value) {
+        add(static_cast<std::int64_t>(value.size()));
+        key_ += value;
+    }
+    void add(const planner_vector& values) {
+        add(static_cast<std::int64_t>(values.size()));
+        append(values.data(), values.size() * sizeof(double));
+    }
+
+    [[nodiscard]] std::string take() { return std::move(key_); }
+
+private:
+    void append(const void* data, std::size_t size) {
+        const std::size_t at = key_.size();
+        key_.resize(at + size);
+        std::memcpy(key_.data() + at, data, size);
+    }
+
+    std::string key_;
+};
+
+// The result-cache key of `request`: model, backend, every setting that shapes the search, and the
+// state rounded to multiples of cache_quantum. Empty when the request does not use the cache. The
+// seed is left out, which is why cache hits are not replayable.
+std::string result_cache_key(const planner_request& request) {
+    if (!(request.cache_quantum > 0.0) || !std::isfinite(request.cache_quantum) || request.mcts_tree ||
+        request.ilqr_warm_start) {
+        return {};
+    }
+    cache_key_writer key;
+    key.add(request.model_service);
+    key.add(static_cast<std::int64_t>(request.planner));
+    key.add(static_cast<std::int64_t>(request.state.size()));
+    for (double x : request.state) {
+        const double cell = std::round(x / request.cache_quantum);
+        if (!std::isfinite(cell) || std::fabs(cell) > 9.0e18) {
+            return {};
+        }
+        key.add(static_cast<std::int64_t>(cell));
+    }
+
+    key.add(request.budget_ms);
+    key.add(request.work_max);
+    key.add(request.horizon);
+    key.add(request.dt_ms);
+    key.add(static_cast<std::int64_t>(request.bounds.size()));
+    for (const planner_bound& b : request.bounds) {
+        key.add(b.lo);
+        key.add(b.hi);
+    }
+    const planner_constraints& c = request.constraints;
+    key.add(c.max_du);
+    key.add(c.has_smoothness_weight ? c.smoothness_weight : 0.0);
+    key.add(c.has_collision_weight ? c.collision_weight : 0.0);
+    key.add(c.has_goal_tolerance ? c.goal_tolerance : -1.0);
+    key.add(request.top_k);
+    key.add(request.safe_action.action_schema);
+    key.add(request.safe_action.u);
+    key.add(request.action_schema);
+
+    switch (request.planner) {
+        case planner_backend::mcts: {
+            const planner_mcts_config& m = request.mcts;
+            key.add(m.c_ucb);
+            key.add(m.pw_k);
+            key.add(m.pw_alpha);
+            key.add(m.max_depth);
+            key.add(m.gamma);
+            key.add(m.rollout_policy);
+            key.add(m.action_sampler);
+            key.add(m.default_iters);
+            key.add(m.time_check_interval);
+            key.add(m.parallelism);
+            key.add(m.threads);
+            key.add(m.virtual_loss);
+            break;
+        }
+        case planner_backend::mppi: {
+            const planner_mppi_config& m = request.mppi;
+            key.add(m.lambda);
+            key.add(m.sigma);
+            key.add(m.n_samples);
+            key.add(m.n_elite);
+            key.add(m.u_init);
+            key.add(m.u_nominal);
+            break;
+        }
+        case planner_backend::ilqr: {
+            const planner_ilqr_config& m = request.ilqr;
+            key.add(m.max_iters);
+            key.add(m.reg_init);
+            key.add(m.reg_factor);
+            key.add(m.tol_cost);
+            key.add(m.tol_grad);
+            key.add(m.u_init);
+            key.add(static_cast<std::int64_t>(m.derivatives));
+            key.add(m.fd_eps);
+            break;
+        }
+    }
+    return key.take();
+}
+
 std::string resolve_action_schema(const planner_request& request) {
     if (!request.action_schema.empty()) {
         return request.action_schema;
@@ -225,6 +340,60 @@ planner_action make_action(std::string action_schema, planner_vector u) {
     return out;
 }
 
+// Publishes best-so-far results of a running search to request.progress, at most once per
+// request.progress_interval_ms. Does nothing when the request has no progress slot.
+class progress_reporter {
+public:
+    progress_reporter(const planner_request& request,
+                      planner_backend backend,
+                      const planner_model& model,
+                      const std::vector<planner_bound>& bounds,
+                      const std::string& action_schema)
+        : slot_(request.progress),
+          model_(model),
+          bounds_(bounds),
+          interval_(std::chrono::milliseconds(std::max<std::int64_t>(0, request.progress_interval_ms))),
+          start_(std::chrono::steady_clock::now()),
+          next_(start_ + interval_) {
+        snapshot_.planner = backend;
+        snapshot_.status = planner_status::ok;
+        snapshot_.action.action_schema = action_schema;
+        snapshot_.stats.budget_ms = std::max<std::int64_t>(0, request.budget_ms);
+        snapshot_.stats.budget_choice = request.budget_choice;
+        snapshot_.stats.seed = request.seed;
+        snapshot_.stats.note = "partial";
+    }
+
+    [[nodiscard]] bool enabled() const noexcept { return slot_ != nullptr; }
+    [[nodiscard]] bool due(std::chrono::steady_clock::time_point now) const noexcept {
+        return slot_ != nullptr && now >= next_;
+    }
+
+    void publish(std::chrono::steady_clock::time_point now,
+                 const planner_vector& action,
+                 double confidence,
+                 std::int64_t work_done) {
+        snapshot_.action.u = clamp_action_with_bounds(action, bounds_, model_);
+        if (!vector_all_finite(snapshot_.action.u)) {
+            return;
+        }
+        snapshot_.confidence = clamp_confidence(confidence);
+        snapshot_.stats.time_used_ms = elapsed_ms(start_, now);
+        snapshot_.stats.work_done = work_done;
+        slot_->publish(snapshot_);
+        next_ = now + interval_;
+    }
+
+private:
+    planner_progress* slot_;
+    const planner_model& model_;
+    const std::vector<planner_bound>& bounds_;
+    std::chrono::steady_clock::duration interval_;
+    std::chrono::steady_clock::time_point start_;
+    std::chrono::steady_clock::time_point next_;
+    planner_result snapshot_;
+};
+
 void apply_rate_limits(std::vector<planner_vector>& actions, const planner_vector& max_du) {
     if (actions.empty() || max_du.empty()) {
         return;
@@ -310,6 +479,23 @@ double smoothness_penalty(const std::vector<planner_vector>& actions, double smo
     return smoothness_weight * penalty;
 }
 
+// smoothness_penalty over a flat horizon x action_dim sequence.
+double smoothness_penalty(const double* actions, std::size_t horizon, std::size_t action_dim, double smoothness_weight) {
+    if (smoothness_weight <= 0.0 || horizon <= 1) {
+        return 0.0;
+    }
+    double penalty = 0.0;
+    for (std::size_t t = 1; t < horizon; ++t) {
+        const double* prev = actions + (t - 1) * action_dim;
+        const double* cur = actions + t * action_dim;
+        for (std::size_t d = 0; d < action_dim; ++d) {
+            const double delta = cur[d] - prev[d];
+            penalty += delta * delta;
+        }
+    }
+    return smoothness_weight * penalty;
+}
+
 std::optional<double> rollout_cost_with_step(const planner_model& model,
                                              const planner_vector& state,
                                              const std::vector<planner_vector>& actions,
@@ -362,67 +548,6 @@ std::optional<double> stage_cost_deterministic(const planner_model& model,
     return std::isfinite(cost) ? std::optional<double>(cost) : std::nullopt;
 }
 
-bool solve_linear_system(std::vector<double>& a, std::vector<double>& b, std::size_t n, std::size_t rhs_cols) {
-    if (a.size() != n * n || b.size() != n * rhs_cols) {
-        return false;
-    }
-
-    for (std::size_t col = 0; col < n; ++col) {
-        std::size_t pivot = col;
-        double pivot_abs = std::fabs(a[col * n + col]);
-        for (std::size_t r = col + 1; r < n; ++r) {
-            const double v = std::fabs(a[r * n + col]);
-            if (v > pivot_abs) {
-                pivot = r;
-                pivot_abs = v;
-            }
-        }
-        if (pivot_abs < 1.0e-12 || !std::isfinite(pivot_abs)) {
-            return false;
-        }
-
-        if (pivot != col) {
-            for (std::size_t c = 0; c < n; ++c) {
-                std::swap(a[pivot * n + c], a[col * n + c]);
-            }
-            for (std::size_t c = 0; c < rhs_cols; ++c) {
-                std::swap(b[pivot * rhs_cols + c], b[col * rhs_cols + c]);
-            }
-        }
-
-        const double diag = a[col * n + col];
-        for (std::size_t c = 0; c < n; ++c) {
-            a[col * n + c] /= diag;
-        }
-        for (std::size_t c = 0; c < rhs_cols; ++c) {
-            b[col * rhs_cols + c] /= diag;
-        }
-
-        for (std::size_t r = 0; r < n; ++r) {
-            if (r == col) {
-                continue;
-            }
-            const double factor = a[r * n + col];
-            if (factor == 0.0) {
-                continue;
-            }
-            for (std::size_t c = 0; c < n; ++c) {
-                a[r * n + c] -= factor * a[col * n + c];
-            }
-            for (std::size_t c = 0; c < rhs_cols; ++c) {
-                b[r * rhs_cols + c] -= factor * b[col * rhs_cols + c];
-            }
-        }
-    }
-
-    for (double v : b) {
-        if (!std::isfinite(v)) {
-            return false;
-        }
-    }
-    return true;
-}
-
 planner_result make_noaction_result(planner_backend planner, planner_action safe_action) {
     planner_result result;
     result.planner = planner;
@@ -499,6 +624,31 @@ public:
         return {{-1.0, 1.0}};
     }
 
+    bool rollout_cost_batch(const planner_vector& state,
+                            const planner_action_batch& batch,
+                            std::span<double> costs,
+                            planner_rng&) const override {
+        if (state.empty() || batch.action_dim == 0) {
+            return false;
+        }
+        const std::size_t n = batch.samples;
+        std::vector<double> x(n, state[0]);
+        std::vector<double> alive(n, 1.0);
+        std::fill(costs.begin(), costs.end(), 0.0);
+        for (std::size_t t = 0; t < batch.horizon; ++t) {
+            const double* u = batch.row(t, 0);
+            for (std::size_t s = 0; s < n; ++s) {
+                // step() per sample, with `alive` standing in for its stop at done.
+                const double x2 = x[s] + 0.25 * clamp_double(u[s], -1.0, 1.0);
+                const double err = 1.0 - x2;
+                costs[s] += alive[s] * (err * err);
+                alive[s] = std::fabs(err) < 0.05 ? 0.0 : alive[s];
+                x[s] = x2;
+            }
+        }
+        return true;
+    }
+
     std::int64_t default_horizon() const override {
         return 20;
     }
@@ -800,29 +950,81 @@ public:
     }
 };
 
-struct mcts_node;
+// MCTS search tree, stored as index-linked pools so a search does no per-node allocation. A node's
+// children form a singly linked list through `sibling`, in the order they were added; child actions
+// live back to back in `actions`. One tree per thread is kept and cleared between plan() calls, so
+// steady-state searches reuse its capacity.
+struct mcts_tree {
+    static constexpr std::uint32_t k_none = 0xffffffffu;
+
+    struct node {
+        std::int64_t visits = 0;
+        double value_sum = 0.0;
+        std::uint32_t first_child = k_none;
+        std::uint32_t last_child = k_none;
+        std::uint32_t child_count = 0;
+    };
 
-struct mcts_child {
-    planner_vector action;
-    std::int64_t visits = 0;
-    double value_sum = 0.0;
-    std::unique_ptr<mcts_node> next;
-};
+    struct child {
+        std::int64_t visits = 0;
+        double value_sum = 0.0;
+        std::uint32_t action_offset = 0;
+        std::uint32_t action_size = 0;
+        std::uint32_t next = k_none;
+        std::uint32_t sibling = k_none;
+    };
 
-struct mcts_node {
-    std::int64_t visits = 0;
-    double value_sum = 0.0;
-    std::vector<mcts_child> children;
+    std::vector<node> nodes;
+    std::vector<child> children;
+    std::vector<double> actions;
 
-    [[nodiscard]] double q() const {
-        if (visits <= 0) {
-            return 0.0;
+    void clear() noexcept {
+        nodes.clear();
+        children.clear();
+        actions.clear();
+    }
+
+    std::uint32_t add_node() {
+        if (nodes.size() >= k_none) {
+            throw std::length_error("mcts: node pool exhausted");
+        }
+        nodes.emplace_back();
+        return static_cast<std::uint32_t>(nodes.size() - 1);
+    }
+
+    std::uint32_t add_child(std::uint32_t parent, const double* action, std::size_t action_size) {
+        if (children.size() >= k_none || actions.size() + action_size >= k_none) {
+            throw std::length_error("mcts: child pool exhausted");
+        }
+        child c;
+        c.action_offset = static_cast<std::uint32_t>(actions.size());
+        c.action_size = static_cast<std::uint32_t>(action_size);
+        actions.insert(actions.end(), action, action + action_size);
+        const std::uint32_t index = static_cast<std::uint32_t>(children.size());
+        children.push_back(c);
+
+        node& p = nodes[parent];
+        if (p.last_child == k_none) {
+            p.first_child = index;
+        } else {
+            children[p.last_child].sibling = index;
         }
-        return value_sum / static_cast<double>(visits);
+        p.last_child = index;
+        ++p.child_count;
+        return index;
+    }
+
+    void copy_action(const child& c, planner_vector& out) const {
+        out.assign(actions.begin() + c.action_offset, actions.begin() + c.action_offset + c.action_size);
+    }
+
+    static mcts_tree& for_this_thread() {
+        thread_local mcts_tree tree;
+        return tree;
     }
 };
 
-double ucb_score(const mcts_child& child, std::int64_t parent_visits, double c_ucb) {
+double ucb_score(const mcts_tree::child& child, std::int64_t parent_visits, double c_ucb) {
     if (child.visits <= 0) {
         return 1.0e30;
     }
@@ -832,14 +1034,11 @@ double ucb_score(const mcts_child& child, std::int64_t parent_visits, double c_u
     return q + c_ucb * std::sqrt(std::log(parent_n) / child_n);
 }
 
-std::optional<std::size_t> select_child_index(const mcts_node& node, double c_ucb) {
-    if (node.children.empty()) {
-        return std::nullopt;
-    }
-    std::size_t best_idx = 0;
+std::uint32_t select_child_index(const mcts_tree& tree, const mcts_tree::node& node, double c_ucb) {
+    std::uint32_t best_idx = mcts_tree::k_none;
     double best_score = -1.0e300;
-    for (std::size_t i = 0; i < node.children.size(); ++i) {
-        const double score = ucb_score(node.children[i], node.visits, c_ucb);
+    for (std::uint32_t i = node.first_child; i != mcts_tree::k_none; i = tree.children[i].sibling) {
+        const double score = ucb_score(tree.children[i], node.visits, c_ucb);
         if (score > best_score) {
             best_score = score;
             best_idx = i;
@@ -848,188 +1047,679 @@ std::optional<std::size_t> select_child_index(const mcts_node& node, double c_uc
     return best_idx;
 }
 
-planner_result run_mcts_backend(const planner_request& request,
-                                const planner_model& model,
-                                const std::vector<planner_bound>& bounds,
-                                const planner_action& safe_action,
-                                const std::string& action_schema,
-                                std::chrono::steady_clock::time_point deadline) {
-    planner_result result;
-    result.planner = planner_backend::mcts;
-    result.action = safe_action;
+// Runs body(0) .. body(count - 1), offering all but the first to `sched`'s workers. The caller and
+// the workers claim indices through a flag each, and the caller runs every index no worker has
+// claimed by the time it gets there, so a busy pool, a single worker, or a plan that is itself running
+// on a worker only costs parallelism, never a deadlock. Rethrows the first exception a body threw.
+void run_parallel(scheduler* sched, std::size_t count, const std::function<void(std::size_t)>& body) {
+    if (count == 0) {
+        return;
+    }
+    if (!sched || count == 1) {
+        for (std::size_t i = 0; i < count; ++i) {
+            body(i);
+        }
+        return;
+    }
 
-    planner_mcts_config cfg = request.mcts;
-    cfg.gamma = clamp_double(cfg.gamma, 0.0, 1.0);
-    cfg.c_ucb = std::max(0.0, cfg.c_ucb);
-    cfg.pw_k = std::max(0.0, cfg.pw_k);
-    cfg.pw_alpha = std::max(0.0, cfg.pw_alpha);
-    cfg.max_depth = std::max<std::int64_t>(1, cfg.max_depth);
-    cfg.time_check_interval = std::max<std::int64_t>(1, cfg.time_check_interval);
+    // Shared with the jobs, which can outlive this call if the caller claimed their index first.
+    struct batch {
+        explicit batch(std::size_t n) : claimed(n), errors(n) {}
 
-    const std::int64_t iter_cap = std::max<std::int64_t>(
-        1,
-        request.work_max > 0 ? request.work_max : std::max<std::int64_t>(1, cfg.default_iters));
+        std::vector<std::atomic<bool>> claimed;
+        std::vector<std::exception_ptr> errors;
+        std::atomic<std::size_t> finished{0};
+        const std::function<void(std::size_t)>* body = nullptr;
 
-    planner_rng rng(request.seed);
+        void run(std::size_t i) noexcept {
+            try {
+                (*body)(i);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        }
+    };
+    auto shared = std::make_shared<batch>(count);
+    shared->body = &body;
+
+    for (std::size_t i = 1; i < count; ++i) {
+        job_request req;
+        req.task_name = "mcts-worker";
+        req.priority = job_priority::high;
+        req.fn = [shared, i, count] {
+            if (!shared->claimed[i].exchange(true)) {
+                shared->run(i);
+                if (shared->finished.fetch_add(1) + 1 == count) {
+                    shared->finished.notify_all();
+                }
+            }
+            return job_result{};
+        };
+        try {
+            (void)sched->submit(std::move(req));
+        } catch (const std::exception&) {
+            // Left for the caller to run.
+        }
+    }
 
-    mcts_node root;
-    std::int64_t widen_added = 0;
-    bool timed_out = false;
+    for (std::size_t i = 0; i < count; ++i) {
+        if (!shared->claimed[i].exchange(true)) {
+            shared->run(i);
+            (void)shared->finished.fetch_add(1);
+        }
+    }
+    for (std::size_t seen = shared->finished.load(); seen != count; seen = shared->finished.load()) {
+        shared->finished.wait(seen);
+    }
+    for (const std::exception_ptr& error : shared->errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
 
-    std::function<double(const planner_vector&, std::int64_t)> rollout = [&](const planner_vector& state,
-                                                                             std::int64_t depth) -> double {
-        if (depth >= cfg.max_depth) {
-            return 0.0;
+// The per-request parts of a search that do not touch the tree: how to pick an action when widening
+// and how to roll out from a fresh leaf. Both draw from the caller's rng.
+class mcts_policy {
+public:
+    mcts_policy(const planner_mcts_config& cfg,
+                const planner_model& model,
+                const std::vector<planner_bound>& bounds,
+                const planner_action& safe_action)
+        : cfg_(cfg),
+          model_(model),
+          bounds_(bounds),
+          safe_action_(safe_action),
+          random_rollout_(normalized_token(cfg.rollout_policy) == "random"),
+          sample_safe_action_(normalized_token(cfg.action_sampler) == "safe_action" &&
+                              safe_action.u.size() == model.action_dims()) {}
+
+    [[nodiscard]] const planner_mcts_config& config() const noexcept { return cfg_; }
+    [[nodiscard]] const planner_model& model() const noexcept { return model_; }
+
+    planner_vector expansion_action(const planner_vector& state, planner_rng& rng) const {
+        const planner_vector sampled = sample_safe_action_ ? safe_action_.u : model_.sample_action(state, rng);
+        return clamp_action_with_bounds(sampled, bounds_, model_);
+    }
+
+    // Value of taking `action` in `state` and then following the rollout policy.
+    double expand(const planner_vector& state, const planner_vector& action, std::int64_t depth, planner_rng& rng) const {
+        const planner_step_result step_out = model_.step(state, action, rng);
+        double value = step_out.reward;
+        if (!step_out.done) {
+            value += cfg_.gamma * rollout(step_out.next_state, depth + 1, rng);
         }
+        return value;
+    }
 
-        planner_vector action;
-        if (normalized_token(cfg.rollout_policy) == "random") {
-            action = model.sample_action(state, rng);
-        } else {
-            action = model.rollout_action(state, rng);
+private:
+    double rollout(const planner_vector& state, std::int64_t depth, planner_rng& rng) const {
+        if (depth >= cfg_.max_depth) {
+            return 0.0;
         }
-        action = clamp_action_with_bounds(action, bounds, model);
 
-        const planner_step_result step_out = model.step(state, action, rng);
+        const planner_vector sampled = random_rollout_ ? model_.sample_action(state, rng) : model_.rollout_action(state, rng);
+        const planner_vector action = clamp_action_with_bounds(sampled, bounds_, model_);
+
+        const planner_step_result step_out = model_.step(state, action, rng);
         if (step_out.done) {
             return step_out.reward;
         }
-        return step_out.reward + cfg.gamma * rollout(step_out.next_state, depth + 1);
-    };
+        return step_out.reward + cfg_.gamma * rollout(step_out.next_state, depth + 1, rng);
+    }
 
-    std::function<double(mcts_node&, const planner_vector&, std::int64_t)> simulate =
-        [&](mcts_node& node, const planner_vector& state, std::int64_t depth) -> double {
-        if (depth >= cfg.max_depth) {
-            return 0.0;
-        }
+    const planner_mcts_config& cfg_;
+    const planner_model& model_;
+    const std::vector<planner_bound>& bounds_;
+    const planner_action& safe_action_;
+    const bool random_rollout_;
+    const bool sample_safe_action_;
+};
 
-        const double child_cap =
-            cfg.pw_k * std::pow(static_cast<double>(std::max<std::int64_t>(1, node.visits)), cfg.pw_alpha);
-        const bool allow_expand = static_cast<double>(node.children.size()) < child_cap;
+bool mcts_allows_expansion(const planner_mcts_config& cfg, const mcts_tree::node& node) {
+    const double child_cap =
+        cfg.pw_k * std::pow(static_cast<double>(std::max<std::int64_t>(1, node.visits)), cfg.pw_alpha);
+    return static_cast<double>(node.child_count) < child_cap;
+}
 
-        if (allow_expand) {
-            planner_vector sampled;
-            if (normalized_token(cfg.action_sampler) == "safe_action" && safe_action.u.size() == model.action_dims()) {
-                sampled = safe_action.u;
-            } else {
-                sampled = model.sample_action(state, rng);
-            }
+// One iteration at a time, each drawing from one rng stream.
+class mcts_search {
+public:
+    mcts_search(mcts_tree& tree, const mcts_policy& policy, planner_rng& rng)
+        : tree_(tree), policy_(policy), cfg_(policy.config()), rng_(rng) {}
 
-            planner_vector action = clamp_action_with_bounds(sampled, bounds, model);
-            mcts_child child;
-            child.action = action;
+    double simulate(std::uint32_t node_index, const planner_vector& state, std::int64_t depth) {
+        if (depth >= cfg_.max_depth) {
+            return 0.0;
+        }
 
-            const planner_step_result step_out = model.step(state, action, rng);
-            double value = step_out.reward;
-            if (!step_out.done) {
-                value += cfg.gamma * rollout(step_out.next_state, depth + 1);
-            }
+        const mcts_tree::node& node = tree_.nodes[node_index];
+        if (mcts_allows_expansion(cfg_, node)) {
+            const planner_vector action = policy_.expansion_action(state, rng_);
+            const double value = policy_.expand(state, action, depth, rng_);
 
-            child.visits = 1;
-            child.value_sum = value;
-            node.children.push_back(std::move(child));
+            mcts_tree::child& added = tree_.children[tree_.add_child(node_index, action.data(), action.size())];
+            added.visits = 1;
+            added.value_sum = value;
             ++widen_added;
 
-            ++node.visits;
-            node.value_sum += value;
+            mcts_tree::node& expanded = tree_.nodes[node_index];
+            ++expanded.visits;
+            expanded.value_sum += value;
             return value;
         }
 
-        const std::optional<std::size_t> choice = select_child_index(node, cfg.c_ucb);
-        if (!choice.has_value()) {
-            ++node.visits;
+        const std::uint32_t choice = select_child_index(tree_, node, cfg_.c_ucb);
+        if (choice == mcts_tree::k_none) {
+            ++tree_.nodes[node_index].visits;
             return 0.0;
         }
 
-        mcts_child& child = node.children[*choice];
-        const planner_step_result step_out = model.step(state, child.action, rng);
+        tree_.copy_action(tree_.children[choice], action_scratch_);
+        const planner_step_result step_out = policy_.model().step(state, action_scratch_, rng_);
 
         double value = step_out.reward;
         if (!step_out.done) {
-            if (!child.next) {
-                child.next = std::make_unique<mcts_node>();
+            std::uint32_t next = tree_.children[choice].next;
+            if (next == mcts_tree::k_none) {
+                next = tree_.add_node();
+                tree_.children[choice].next = next;
             }
-            value += cfg.gamma * simulate(*child.next, step_out.next_state, depth + 1);
+            value += cfg_.gamma * simulate(next, step_out.next_state, depth + 1);
         }
 
+        mcts_tree::child& child = tree_.children[choice];
         ++child.visits;
         child.value_sum += value;
-        ++node.visits;
-        node.value_sum += value;
+        mcts_tree::node& visited = tree_.nodes[node_index];
+        ++visited.visits;
+        visited.value_sum += value;
         return value;
+    }
+
+    std::int64_t widen_added = 0;
+
+private:
+    mcts_tree& tree_;
+    const mcts_policy& policy_;
+    const planner_mcts_config& cfg_;
+    planner_rng& rng_;
+    planner_vector action_scratch_;
+};
+
+// Tree-parallel search: iterations run in waves of `wave` paths. Paths are selected one after the
+// other, each adding a virtual loss to the children it passes so later paths in the wave spread out;
+// the expansions and rollouts at their leaves then run concurrently, and the results are backed up in
+// path order. Path i of the search draws from its own rng, seeded from the request seed and i, so the
+// tree is the same however many workers the wave runs on.
+class mcts_wave_search {
+public:
+    mcts_wave_search(mcts_tree& tree, const mcts_policy& policy, std::uint64_t seed, std::size_t wave)
+        : tree_(tree), policy_(policy), cfg_(policy.config()), seed_(seed), paths_(wave) {}
+
+    // Runs `count` (at most the wave size) iterations, numbered from first_iteration.
+    void run_wave(std::int64_t first_iteration,
+                  std::size_t count,
+                  const planner_vector& root_state,
+                  scheduler* sched) {
+        for (std::size_t i = 0; i < count; ++i) {
+            std::uint64_t stream = seed_ + static_cast<std::uint64_t>(first_iteration) + i;
+            paths_[i].rng = planner_rng(splitmix64_next(stream));
+            select(paths_[i], root_state);
+        }
+        run_parallel(sched, count, [this](std::size_t i) {
+            path& p = paths_[i];
+            if (p.leaf != mcts_tree::k_none) {
+                p.action = policy_.expansion_action(p.state, p.rng);
+                p.value = policy_.expand(p.state, p.action, p.depth, p.rng);
+            }
+        });
+        for (std::size_t i = 0; i < count; ++i) {
+            back_up(paths_[i]);
+        }
+    }
+
+    std::int64_t widen_added = 0;
+
+private:
+    struct edge {
+        std::uint32_t node = mcts_tree::k_none;
+        std::uint32_t child = mcts_tree::k_none;
+        double reward = 0.0;
     };
 
-    std::int64_t completed_iters = 0;
-    for (std::int64_t i = 0; i < iter_cap; ++i) {
-        if ((i % cfg.time_check_interval) == 0) {
-            const auto now = std::chrono::steady_clock::now();
-            if (now >= deadline) {
-                timed_out = true;
-                break;
+    struct path {
+        std::vector<edge> edges;
+        // Node to widen at the end of the path, or k_none if the path stopped without expanding.
+        std::uint32_t leaf = mcts_tree::k_none;
+        std::int64_t depth = 0;
+        planner_vector state;
+        planner_vector action;
+        double value = 0.0;
+        planner_rng rng{0};
+    };
+
+    void select(path& p, const planner_vector& root_state) {
+        p.edges.clear();
+        p.leaf = mcts_tree::k_none;
+        p.value = 0.0;
+        p.state = root_state;
+
+        std::uint32_t node_index = 0;
+        for (std::int64_t depth = 0; depth < cfg_.max_depth; ++depth) {
+            const bool expand = mcts_allows_expansion(cfg_, tree_.nodes[node_index]);
+            ++tree_.nodes[node_index].visits;
+            if (expand) {
+                p.leaf = node_index;
+                p.depth = depth;
+                return;
+            }
+
+            const std::uint32_t choice = select_child_index(tree_, tree_.nodes[node_index], cfg_.c_ucb);
+            if (choice == mcts_tree::k_none) {
+                return;
+            }
+            mcts_tree::child& child = tree_.children[choice];
+            ++child.visits;
+            child.value_sum -= cfg_.virtual_loss;
+
+            tree_.copy_action(child, p.action);
+            planner_step_result step_out = policy_.model().step(p.state, p.action, p.rng);
+            p.edges.push_back(edge{node_index, choice, step_out.reward});
+            if (step_out.done) {
+                return;
             }
+            p.state = std::move(step_out.next_state);
+
+            std::uint32_t next = tree_.children[choice].next;
+            if (next == mcts_tree::k_none) {
+                next = tree_.add_node();
+                tree_.children[choice].next = next;
+            }
+            node_index = next;
         }
-        (void)simulate(root, request.state, 0);
-        ++completed_iters;
     }
 
-    std::vector<const mcts_child*> sorted_children;
-    sorted_children.reserve(root.children.size());
-    for (const mcts_child& child : root.children) {
-        sorted_children.push_back(&child);
+    void back_up(const path& p) {
+        double value = 0.0;
+        if (p.leaf != mcts_tree::k_none) {
+            mcts_tree::child& added = tree_.children[tree_.add_child(p.leaf, p.action.data(), p.action.size())];
+            added.visits = 1;
+            added.value_sum = p.value;
+            ++widen_added;
+            tree_.nodes[p.leaf].value_sum += p.value;
+            value = p.value;
+        }
+        for (auto it = p.edges.rbegin(); it != p.edges.rend(); ++it) {
+            value = it->reward + cfg_.gamma * value;
+            tree_.children[it->child].value_sum += cfg_.virtual_loss + value;
+            tree_.nodes[it->node].value_sum += value;
+        }
     }
-    std::sort(sorted_children.begin(), sorted_children.end(), [](const mcts_child* lhs, const mcts_child* rhs) {
-        return lhs->visits > rhs->visits;
-    });
 
-    result.trace.mcts.available = true;
-    result.trace.mcts.root_visits = root.visits;
-    result.trace.mcts.root_children = static_cast<std::int64_t>(root.children.size());
-    result.trace.mcts.widen_added = widen_added;
+    mcts_tree& tree_;
+    const mcts_policy& policy_;
+    const planner_mcts_config& cfg_;
+    const std::uint64_t seed_;
+    std::vector<path> paths_;
+};
 
-    const std::size_t top_k = static_cast<std::size_t>(std::max<std::int64_t>(0, request.top_k));
-    for (std::size_t i = 0; i < sorted_children.size() && i < top_k; ++i) {
-        const mcts_child* child = sorted_children[i];
-        planner_top_choice_mcts top;
-        top.action = make_action(action_schema, clamp_action_with_bounds(child->action, bounds, model));
-        top.visits = child->visits;
-        top.q = child->visits > 0 ? child->value_sum / static_cast<double>(child->visits) : 0.0;
-        result.trace.mcts.top_k.push_back(std::move(top));
+// What a planner_mcts_tree keeps between searches. `tree` holds the retained subtree with its root
+// at node 0; `scratch` is the second buffer re-rooting copies into.
+struct mcts_warm_start {
+    mcts_tree tree;
+    mcts_tree scratch;
+    std::vector<std::uint32_t> queue;
+    planner_vector expected_state;
+    std::string model_service;
+    std::size_t action_dims = 0;
+    bool valid = false;
+
+    void clear() noexcept {
+        tree.clear();
+        scratch.clear();
+        valid = false;
     }
+};
 
-    if (!sorted_children.empty()) {
-        const mcts_child* best = sorted_children.front();
-        result.action = make_action(action_schema, clamp_action_with_bounds(best->action, bounds, model));
-        result.confidence = root.visits > 0
-                                ? static_cast<double>(best->visits) /
-                                      static_cast<double>(std::max<std::int64_t>(1, root.visits))
-                                : 0.0;
-        result.status = timed_out ? planner_status::timeout : planner_status::ok;
-    } else {
-        result.status = planner_status::noaction;
-        result.confidence = 0.0;
+bool states_within(const planner_vector& expected, const planner_vector& actual, double tolerance) {
+    if (expected.size() != actual.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        if (!(std::abs(expected[i] - actual[i]) <= tolerance)) {
+            return false;
+        }
     }
+    return true;
+}
 
-    result.stats.work_done = completed_iters;
-    return result;
+// Replaces warm.tree with the subtree under its node `from`, copied breadth-first and cut off after
+// max_nodes nodes. Children of the last copied nodes keep their statistics but lose their subtrees.
+void reroot_tree(mcts_warm_start& warm, std::uint32_t from, std::size_t max_nodes) {
+    const mcts_tree& src = warm.tree;
+    mcts_tree& dst = warm.scratch;
+    dst.clear();
+    warm.queue.clear();
+    warm.queue.push_back(from);
+    (void)dst.add_node();
+
+    // Node i of dst is the copy of src node queue[i].
+    for (std::size_t head = 0; head < warm.queue.size(); ++head) {
+        const mcts_tree::node& from_node = src.nodes[warm.queue[head]];
+        const std::uint32_t to_node = static_cast<std::uint32_t>(head);
+        dst.nodes[to_node].visits = from_node.visits;
+        dst.nodes[to_node].value_sum = from_node.value_sum;
+        for (std::uint32_t c = from_node.first_child; c != mcts_tree::k_none; c = src.children[c].sibling) {
+            const mcts_tree::child& from_child = src.children[c];
+            const std::uint32_t to_child =
+                dst.add_child(to_node, src.actions.data() + from_child.action_offset, from_child.action_size);
+            dst.children[to_child].visits = from_child.visits;
+            dst.children[to_child].value_sum = from_child.value_sum;
+            if (from_child.next != mcts_tree::k_none && warm.queue.size() < max_nodes) {
+                warm.queue.push_back(from_child.next);
+                dst.children[to_child].next = dst.add_node();
+            }
+        }
+    }
+
+    std::swap(warm.tree, warm.scratch);
+    warm.scratch.clear();
 }
 
-planner_result run_mppi_backend(const planner_request& request,
+struct mcts_run_stats {
+    std::int64_t completed_iters = 0;
+    std::int64_t widen_added = 0;
+    bool timed_out = false;
+};
+
+// Publishes the most visited root action of `tree`, the one the search would return now.
+void publish_mcts_progress(progress_reporter& progress,
+                           std::chrono::steady_clock::time_point now,
+                           const mcts_tree& tree,
+                           std::int64_t work_done) {
+    const mcts_tree::node& root = tree.nodes[0];
+    const mcts_tree::child* best = nullptr;
+    for (std::uint32_t i = root.first_child; i != mcts_tree::k_none; i = tree.children[i].sibling) {
+        if (!best || tree.children[i].visits > best->visits) {
+            best = &tree.children[i];
+        }
+    }
+    if (!best) {
+        return;
+    }
+    const auto first = tree.actions.begin() + static_cast<std::ptrdiff_t>(best->action_offset);
+    const planner_vector action(first, first + static_cast<std::ptrdiff_t>(best->action_size));
+    const double confidence =
+        root.visits > 0 ? static_cast<double>(best->visits) / static_cast<double>(root.visits) : 0.0;
+    progress.publish(now, action, confidence, work_done);
+}
+
+mcts_run_stats run_mcts_iterations(mcts_tree& tree,
+                                   const mcts_policy& policy,
+                                   const planner_vector& state,
+                                   std::uint64_t seed,
+                                   std::int64_t iter_cap,
+                                   std::chrono::steady_clock::time_point deadline,
+                                   const cancel_token& cancel,
+                                   progress_reporter* progress) {
+    planner_rng rng(seed);
+    mcts_search search(tree, policy, rng);
+    mcts_run_stats stats;
+    for (std::int64_t i = 0; i < iter_cap; ++i) {
+        if ((i % policy.config().time_check_interval) == 0) {
+            const auto now = std::chrono::steady_clock::now();
+            if (now >= deadline || cancel.cancelled()) {
+                stats.timed_out = true;
+                break;
+            }
+            if (progress && progress->due(now)) {
+                publish_mcts_progress(*progress, now, tree, stats.completed_iters);
+            }
+        }
+        (void)search.simulate(0, state, 0);
+        ++stats.completed_iters;
+    }
+    stats.widen_added = search.widen_added;
+    return stats;
+}
+
+// The root's children after a search, copied out of the tree in the order they were added.
+struct mcts_root_summary {
+    struct candidate {
+        std::size_t action_offset = 0;
+        std::size_t action_size = 0;
+        std::int64_t visits = 0;
+        double value_sum = 0.0;
+        // Subtree under the child (single-tree searches only).
+        std::uint32_t next = mcts_tree::k_none;
+    };
+
+    std::vector<double> actions;
+    std::vector<candidate> candidates;
+    std::int64_t root_visits = 0;
+    mcts_run_stats run;
+
+    void capture(const mcts_tree& tree) {
+        const mcts_tree::node& root = tree.nodes[0];
+        root_visits = root.visits;
+        for (std::uint32_t i = root.first_child; i != mcts_tree::k_none; i = tree.children[i].sibling) {
+            const mcts_tree::child& child = tree.children[i];
+            candidates.push_back(candidate{actions.size(), child.action_size, child.visits, child.value_sum, child.next});
+            actions.insert(actions.end(),
+                           tree.actions.begin() + child.action_offset,
+                           tree.actions.begin() + child.action_offset + child.action_size);
+        }
+    }
+
+    // Adds another tree's root statistics; children with identical actions are counted as one.
+    void merge(const mcts_root_summary& other) {
+        for (const candidate& theirs : other.candidates) {
+            const double* action = other.actions.data() + theirs.action_offset;
+            auto same = std::find_if(candidates.begin(), candidates.end(), [&](const candidate& ours) {
+                return ours.action_size == theirs.action_size &&
+                       std::equal(action, action + theirs.action_size, actions.begin() + ours.action_offset);
+            });
+            if (same != candidates.end()) {
+                same->visits += theirs.visits;
+                same->value_sum += theirs.value_sum;
+            } else {
+                candidates.push_back(candidate{actions.size(), theirs.action_size, theirs.visits, theirs.value_sum});
+                actions.insert(actions.end(), action, action + theirs.action_size);
+            }
+        }
+        root_visits += other.root_visits;
+        run.completed_iters += other.run.completed_iters;
+        run.widen_added += other.run.widen_added;
+        run.timed_out = run.timed_out || other.run.timed_out;
+    }
+};
+
+planner_result run_mcts_backend(const planner_request& request,
                                 const planner_model& model,
                                 const std::vector<planner_bound>& bounds,
                                 const planner_action& safe_action,
                                 const std::string& action_schema,
-                                std::chrono::steady_clock::time_point deadline) {
+                                std::chrono::steady_clock::time_point deadline,
+                                const cancel_token& cancel,
+                                mcts_warm_start* warm,
+                                scheduler* sched) {
     planner_result result;
-    result.planner = planner_backend::mppi;
+    result.planner = planner_backend::mcts;
     result.action = safe_action;
 
-    const std::size_t action_dim = model.action_dims();
-    if (action_dim == 0) {
-        return make_error_result(planner_backend::mppi, safe_action, "mppi: model action dimension is zero");
+    planner_mcts_config cfg = request.mcts;
+    cfg.gamma = clamp_double(cfg.gamma, 0.0, 1.0);
+    cfg.c_ucb = std::max(0.0, cfg.c_ucb);
+    cfg.pw_k = std::max(0.0, cfg.pw_k);
+    cfg.pw_alpha = std::max(0.0, cfg.pw_alpha);
+    cfg.max_depth = std::max<std::int64_t>(1, cfg.max_depth);
+    cfg.time_check_interval = std::max<std::int64_t>(1, cfg.time_check_interval);
+    cfg.reuse_state_tolerance = std::max(0.0, cfg.reuse_state_tolerance);
+    cfg.virtual_loss = std::max(0.0, cfg.virtual_loss);
+
+    const std::string parallelism = normalized_token(cfg.parallelism);
+    if (parallelism != "none" && parallelism != "root" && parallelism != "tree") {
+        throw std::invalid_argument("mcts: unsupported parallelism: " + cfg.parallelism);
     }
+    const std::size_t threads =
+        static_cast<std::size_t>(std::clamp<std::int64_t>(cfg.threads, 1, k_planner_max_threads));
 
-    std::int64_t horizon_i = request.horizon > 0 ? request.horizon : model.default_horizon();
-    if (horizon_i <= 0) {
+    const std::int64_t iter_cap = std::max<std::int64_t>(
+        1,
+        request.work_max > 0 ? request.work_max : std::max<std::int64_t>(1, cfg.default_iters));
+
+    const mcts_policy policy(cfg, model, bounds, safe_action);
+    progress_reporter progress(request, planner_backend::mcts, model, bounds, action_schema);
+    mcts_root_summary summary;
+    std::int64_t reused_visits = 0;
+
+    if (parallelism == "root" && threads > 1) {
+        // Independent trees cannot hand one subtree to the next call.
+        if (warm) {
+            warm->clear();
+            warm = nullptr;
+        }
+        std::vector<mcts_root_summary> per_tree(threads);
+        run_parallel(sched, threads, [&](std::size_t k) {
+            std::uint64_t tree_seed = request.seed;
+            if (k != 0) {
+                tree_seed += k;
+                tree_seed = splitmix64_next(tree_seed);
+            }
+            mcts_tree& tree = mcts_tree::for_this_thread();
+            tree.clear();
+            (void)tree.add_node();
+            // Only the first tree reports progress, so the reporter has one writer.
+            per_tree[k].run = run_mcts_iterations(
+                tree, policy, request.state, tree_seed, iter_cap, deadline, cancel, k == 0 ? &progress : nullptr);
+            per_tree[k].capture(tree);
+        });
+        summary = std::move(per_tree[0]);
+        for (std::size_t k = 1; k < threads; ++k) {
+            summary.merge(per_tree[k]);
+        }
+    } else {
+        mcts_tree& tree = warm ? warm->tree : mcts_tree::for_this_thread();
+        if (warm && warm->valid && warm->model_service == request.model_service &&
+            warm->action_dims == model.action_dims() &&
+            states_within(warm->expected_state, request.state, cfg.reuse_state_tolerance)) {
+            reused_visits = tree.nodes[0].visits;
+        } else {
+            tree.clear();
+            (void)tree.add_node();
+        }
+        if (warm) {
+            // Stays false unless this search finishes and leaves a subtree behind.
+            warm->valid = false;
+        }
+
+        if (parallelism == "tree" && threads > 1) {
+            mcts_wave_search waves(tree, policy, request.seed, threads);
+            while (summary.run.completed_iters < iter_cap) {
+                const auto now = std::chrono::steady_clock::now();
+                if (now >= deadline || cancel.cancelled()) {
+                    summary.run.timed_out = true;
+                    break;
+                }
+                if (progress.due(now)) {
+                    publish_mcts_progress(progress, now, tree, summary.run.completed_iters);
+                }
+                const std::size_t count =
+                    static_cast<std::size_t>(std::min<std::int64_t>(static_cast<std::int64_t>(threads),
+                                                                    iter_cap - summary.run.completed_iters));
+                waves.run_wave(summary.run.completed_iters, count, request.state, sched);
+                summary.run.completed_iters += static_cast<std::int64_t>(count);
+            }
+            summary.run.widen_added = waves.widen_added;
+        } else {
+            summary.run =
+                run_mcts_iterations(tree, policy, request.state, request.seed, iter_cap, deadline, cancel, &progress);
+        }
+        summary.capture(tree);
+    }
+
+    std::vector<const mcts_root_summary::candidate*> sorted_children;
+    sorted_children.reserve(summary.candidates.size());
+    for (const mcts_root_summary::candidate& c : summary.candidates) {
+        sorted_children.push_back(&c);
+    }
+    std::sort(sorted_children.begin(),
+              sorted_children.end(),
+              [](const mcts_root_summary::candidate* lhs, const mcts_root_summary::candidate* rhs) {
+                  return lhs->visits > rhs->visits;
+              });
+
+    result.trace.mcts.available = true;
+    result.trace.mcts.root_visits = summary.root_visits;
+    result.trace.mcts.root_children = static_cast<std::int64_t>(summary.candidates.size());
+    result.trace.mcts.widen_added = summary.run.widen_added;
+    result.trace.mcts.reused_visits = reused_visits;
+
+    planner_vector action;
+    const auto candidate_action = [&](const mcts_root_summary::candidate& c) {
+        action.assign(summary.actions.begin() + static_cast<std::ptrdiff_t>(c.action_offset),
+                      summary.actions.begin() + static_cast<std::ptrdiff_t>(c.action_offset + c.action_size));
+        action = clamp_action_with_bounds(action, bounds, model);
+    };
+    const std::size_t top_k = static_cast<std::size_t>(std::max<std::int64_t>(0, request.top_k));
+    for (std::size_t i = 0; i < sorted_children.size() && i < top_k; ++i) {
+        const mcts_root_summary::candidate* child = sorted_children[i];
+        candidate_action(*child);
+        planner_top_choice_mcts top;
+        top.action = make_action(action_schema, action);
+        top.visits = child->visits;
+        top.q = child->visits > 0 ? child->value_sum / static_cast<double>(child->visits) : 0.0;
+        result.trace.mcts.top_k.push_back(std::move(top));
+    }
+
+    if (!sorted_children.empty()) {
+        const mcts_root_summary::candidate* best = sorted_children.front();
+        candidate_action(*best);
+        result.action = make_action(action_schema, action);
+        result.confidence = summary.root_visits > 0
+                                ? static_cast<double>(best->visits) /
+                                      static_cast<double>(std::max<std::int64_t>(1, summary.root_visits))
+                                : 0.0;
+        result.status = summary.run.timed_out ? planner_status::timeout : planner_status::ok;
+
+        planner_step_result predicted;
+        if (warm && best->next != mcts_tree::k_none && cfg.reuse_max_nodes > 0 &&
+            deterministic_step_eval(model, request.state, action, predicted) && !predicted.done) {
+            reroot_tree(*warm, best->next, static_cast<std::size_t>(cfg.reuse_max_nodes));
+            warm->expected_state = std::move(predicted.next_state);
+            warm->model_service = request.model_service;
+            warm->action_dims = model.action_dims();
+            warm->valid = true;
+        }
+    } else {
+        result.status = planner_status::noaction;
+        result.confidence = 0.0;
+    }
+
+    result.stats.work_done = summary.run.completed_iters;
+    return result;
+}
+
+planner_result run_mppi_backend(const planner_request& request,
+                                const planner_model& model,
+                                const std::vector<planner_bound>& bounds,
+                                const planner_action& safe_action,
+                                const std::string& action_schema,
+                                std::chrono::steady_clock::time_point deadline,
+                                const cancel_token& cancel,
+                                scheduler* sched) {
+    planner_result result;
+    result.planner = planner_backend::mppi;
+    result.action = safe_action;
+
+    const std::size_t action_dim = model.action_dims();
+    if (action_dim == 0) {
+        return make_error_result(planner_backend::mppi, safe_action, "mppi: model action dimension is zero");
+    }
+
+    std::int64_t horizon_i = request.horizon > 0 ? request.horizon : model.default_horizon();
+    if (horizon_i <= 0) {
         horizon_i = 20;
     }
     const std::size_t horizon = static_cast<std::size_t>(horizon_i);
@@ -1076,48 +1766,150 @@ planner_result run_mppi_backend(const planner_request& request,
     }
     apply_rate_limits(u_seq, request.constraints.max_du);
 
-    struct sample_rollout {
-        std::vector<planner_vector> noise;
-        planner_vector first_action;
-        double cost = std::numeric_limits<double>::infinity();
+    const std::size_t width = horizon * action_dim;
+    const std::size_t cap = static_cast<std::size_t>(sample_cap);
+    planner_vector u_nominal(width, 0.0);
+    for (std::size_t t = 0; t < horizon; ++t) {
+        std::copy(u_seq[t].begin(), u_seq[t].end(), u_nominal.begin() + static_cast<std::ptrdiff_t>(t * action_dim));
+    }
+
+    // normal(0, 0) draws nothing, so noise is only drawn for dimensions with a positive sigma.
+    std::vector<std::size_t> noisy_dims;
+    for (std::size_t d = 0; d < action_dim; ++d) {
+        if (sigma[d] > 0.0) {
+            noisy_dims.push_back(d);
+        }
+    }
+
+    // Samples are drawn and rolled out in blocks of k_block. Block b draws from its own rng stream,
+    // split from the request seed, so a sample does not depend on which thread runs its block or
+    // when. `noise` and `actions` hold one row of horizon * action_dim values per sample, and the
+    // reduction below walks them in sample order, so results are the same for any thread count.
+    constexpr std::size_t k_block = 16;
+    const std::size_t block_count = (cap + k_block - 1) / k_block;
+    const std::size_t per_sample = horizon * noisy_dims.size();
+    std::vector<double> noise(cap * width, 0.0);
+    std::vector<double> actions(cap * width, 0.0);
+    std::vector<double> costs(cap, std::numeric_limits<double>::infinity());
+
+    planner_rng probe_rng(request.seed);
+    // An empty batch asks whether the model rolls out blocks itself.
+    const bool batched =
+        model.rollout_cost_batch(request.state, planner_action_batch{0, horizon, action_dim, nullptr}, {}, probe_rng);
+
+    struct block_scratch {
+        std::vector<double> normals;
+        // The block transposed for rollout_cost_batch.
+        std::vector<double> block_u;
+        std::vector<planner_vector> sequence;
     };
+    const auto run_block = [&](std::size_t block, block_scratch& scratch) {
+        std::uint64_t stream = request.seed + block;
+        planner_rng rng(splitmix64_next(stream));
+        const std::size_t first = block * k_block;
+        const std::size_t count = std::min(k_block, cap - first);
+        std::vector<planner_vector>& sequence = scratch.sequence;
+
+        const std::span<double> z(scratch.normals.data(), count * per_sample);
+        if (batched) {
+            rng.fill_normal(z);
+        }
+
+        for (std::size_t s = 0; s < count; ++s) {
+            std::size_t next_normal = s * per_sample;
+            if (!batched) {
+                // Per-sample models may draw from rng while rolling out, so keep the draws interleaved.
+                rng.fill_normal(z.subspan(next_normal, per_sample));
+            }
+            double* e = noise.data() + (first + s) * width;
+            for (std::size_t t = 0; t < horizon; ++t) {
+                for (std::size_t d : noisy_dims) {
+                    e[t * action_dim + d] = sigma[d] * z[next_normal++];
+                }
+            }
+            for (std::size_t t = 0; t < horizon; ++t) {
+                for (std::size_t d = 0; d < action_dim; ++d) {
+                    sequence[t][d] = u_nominal[t * action_dim + d] + e[t * action_dim + d];
+                }
+                sequence[t] = clamp_action_with_bounds(sequence[t], bounds, model);
+            }
+            apply_rate_limits(sequence, request.constraints.max_du);
 
-    std::vector<sample_rollout> samples;
-    samples.reserve(static_cast<std::size_t>(sample_cap));
-
-    planner_rng rng(request.seed);
-    bool timed_out = false;
-    for (std::int64_t i = 0; i < sample_cap; ++i) {
-        if ((i % 8) == 0) {
-            const auto now = std::chrono::steady_clock::now();
-            if (now >= deadline) {
-                timed_out = true;
-                break;
+            double* a = actions.data() + (first + s) * width;
+            for (std::size_t t = 0; t < horizon; ++t) {
+                std::copy(sequence[t].begin(), sequence[t].end(), a + t * action_dim);
+                for (std::size_t d = 0; batched && d < action_dim; ++d) {
+                    scratch.block_u[(t * action_dim + d) * count + s] = sequence[t][d];
+                }
+            }
+            if (!batched) {
+                const std::optional<double> cost =
+                    rollout_cost_with_step(model, request.state, sequence, rng, request.constraints);
+                costs[first + s] = cost.value_or(std::numeric_limits<double>::infinity());
             }
         }
 
-        sample_rollout sample;
-        sample.noise.assign(horizon, planner_vector(action_dim, 0.0));
-
-        std::vector<planner_vector> actions = u_seq;
-        for (std::size_t t = 0; t < horizon; ++t) {
-            for (std::size_t d = 0; d < action_dim; ++d) {
-                const double e = rng.normal(0.0, sigma[d]);
-                sample.noise[t][d] = e;
-                actions[t][d] += e;
+        if (batched) {
+            const std::span<double> block_costs(costs.data() + first, count);
+            const planner_action_batch batch{count, horizon, action_dim, scratch.block_u.data()};
+            if (!model.rollout_cost_batch(request.state, batch, block_costs, rng)) {
+                throw std::runtime_error("mppi: model declined a rollout_cost_batch block after accepting the probe");
+            }
+            for (std::size_t s = 0; s < count; ++s) {
+                block_costs[s] += smoothness_penalty(actions.data() + (first + s) * width,
+                                                     horizon,
+                                                     action_dim,
+                                                     request.constraints.smoothness_weight);
             }
-            actions[t] = clamp_action_with_bounds(actions[t], bounds, model);
         }
-        apply_rate_limits(actions, request.constraints.max_du);
+    };
 
-        const std::optional<double> cost = rollout_cost_with_step(model, request.state, actions, rng, request.constraints);
-        if (!cost.has_value()) {
-            continue;
+    // Workers claim blocks in order from a shared counter until the samples or the budget run out.
+    const std::size_t threads = static_cast<std::size_t>(std::clamp<std::int64_t>(
+        cfg.threads, 1, std::min<std::int64_t>(k_planner_max_threads, static_cast<std::int64_t>(block_count))));
+    std::atomic<std::size_t> next_block{0};
+    std::atomic<bool> timed_out{false};
+    // Best-so-far tracking for progress results, shared by the workers.
+    progress_reporter progress(request, planner_backend::mppi, model, bounds, action_schema);
+    std::mutex progress_mutex;
+    std::size_t progress_best = cap;
+    std::int64_t progress_samples = 0;
+    run_parallel(threads > 1 ? sched : nullptr, threads, [&](std::size_t) {
+        block_scratch scratch{std::vector<double>(k_block * per_sample),
+                              std::vector<double>(k_block * width),
+                              std::vector<planner_vector>(horizon, planner_vector(action_dim, 0.0))};
+        for (std::size_t block = next_block.fetch_add(1); block < block_count; block = next_block.fetch_add(1)) {
+            if (std::chrono::steady_clock::now() >= deadline || cancel.cancelled()) {
+                timed_out.store(true);
+                return;
+            }
+            run_block(block, scratch);
+            if (progress.enabled()) {
+                const std::size_t first = block * k_block;
+                const std::size_t count = std::min(k_block, cap - first);
+                std::lock_guard<std::mutex> lock(progress_mutex);
+                for (std::size_t i = first; i < first + count; ++i) {
+                    if (std::isfinite(costs[i]) && (progress_best == cap || costs[i] < costs[progress_best])) {
+                        progress_best = i;
+                    }
+                }
+                progress_samples += static_cast<std::int64_t>(count);
+                const auto now = std::chrono::steady_clock::now();
+                if (progress_best != cap && progress.due(now)) {
+                    const double* a = actions.data() + progress_best * width;
+                    progress.publish(now, planner_vector(a, a + action_dim), 0.0, progress_samples);
+                }
+            }
         }
+    });
 
-        sample.cost = *cost;
-        sample.first_action = actions.front();
-        samples.push_back(std::move(sample));
+    // Indices of the samples whose rollout produced a finite cost, in draw order.
+    std::vector<std::size_t> samples;
+    samples.reserve(cap);
+    for (std::size_t i = 0; i < cap; ++i) {
+        if (std::isfinite(costs[i])) {
+            samples.push_back(i);
+        }
     }
 
     if (samples.empty()) {
@@ -1131,10 +1923,10 @@ planner_result run_mppi_backend(const planner_request& request,
         order[i] = i;
     }
     std::sort(order.begin(), order.end(), [&](std::size_t lhs, std::size_t rhs) {
-        return samples[lhs].cost < samples[rhs].cost;
+        return costs[samples[lhs]] < costs[samples[rhs]];
     });
 
-    const double cost_min = samples[order.front()].cost;
+    const double cost_min = costs[samples[order.front()]];
     std::vector<double> weights(samples.size(), 0.0);
 
     std::size_t selected = samples.size();
@@ -1145,7 +1937,7 @@ planner_result run_mppi_backend(const planner_request& request,
     double weight_sum = 0.0;
     for (std::size_t rank = 0; rank < selected; ++rank) {
         const std::size_t idx = order[rank];
-        const double exponent = -(samples[idx].cost - cost_min) / cfg.lambda;
+        const double exponent = -(costs[samples[idx]] - cost_min) / cfg.lambda;
         const double w = std::exp(std::max(-80.0, std::min(80.0, exponent)));
         weights[idx] = std::isfinite(w) ? w : 0.0;
         weight_sum += weights[idx];
@@ -1162,21 +1954,22 @@ planner_result run_mppi_backend(const planner_request& request,
         if (w == 0.0) {
             continue;
         }
-        for (std::size_t t = 0; t < horizon; ++t) {
-            for (std::size_t d = 0; d < action_dim; ++d) {
-                u_seq[t][d] += w * samples[i].noise[t][d];
-            }
+        const double* e = noise.data() + samples[i] * width;
+        for (std::size_t k = 0; k < width; ++k) {
+            u_nominal[k] += w * e[k];
         }
     }
 
-    for (planner_vector& u : u_seq) {
-        u = clamp_action_with_bounds(u, bounds, model);
+    for (std::size_t t = 0; t < horizon; ++t) {
+        u_seq[t].assign(u_nominal.begin() + static_cast<std::ptrdiff_t>(t * action_dim),
+                        u_nominal.begin() + static_cast<std::ptrdiff_t>((t + 1) * action_dim));
+        u_seq[t] = clamp_action_with_bounds(u_seq[t], bounds, model);
     }
     apply_rate_limits(u_seq, request.constraints.max_du);
 
     const planner_vector action = u_seq.front();
     result.action = make_action(action_schema, action);
-    result.status = timed_out ? planner_status::timeout : planner_status::ok;
+    result.status = timed_out.load() ? planner_status::timeout : planner_status::ok;
     result.stats.work_done = static_cast<std::int64_t>(samples.size());
 
     double sum_w = 0.0;
@@ -1203,167 +1996,334 @@ planner_result run_mppi_backend(const planner_request& request,
     for (std::size_t rank = 0; rank < order.size() && rank < top_k; ++rank) {
         const std::size_t idx = order[rank];
         planner_top_choice_mppi entry;
-        entry.action = make_action(action_schema, samples[idx].first_action);
+        const double* first = actions.data() + samples[idx] * width;
+        entry.action = make_action(action_schema, planner_vector(first, first + action_dim));
         entry.weight = weights[idx] / weight_sum;
-        entry.cost = samples[idx].cost;
+        entry.cost = costs[samples[idx]];
         result.trace.mppi.top_k.push_back(std::move(entry));
     }
 
     return result;
 }
 
-bool finite_diff_linearise_dynamics(const planner_model& model,
-                                    const planner_vector& x,
-                                    const planner_vector& u,
-                                    const std::vector<planner_bound>& bounds,
-                                    double eps,
-                                    planner_linearisation& out) {
+// The (state, action) points one finite-difference linearisation evaluates, reused across steps and
+// iterations. Point 0 is (x, u); 1 + 2i and 2 + 2i are x +- eps e_i with u; 1 + 2n + 2j and
+// 2 + 2n + 2j are x with the clamped u +- eps e_j; and the four (x +- eps e_i, u +- eps e_j) corners for
+// the cross term follow, in the order ++, +-, -+, --. Dynamics and cost read the same points.
+struct finite_diff_points {
+    std::vector<planner_vector> states;
+    std::vector<planner_vector> actions;
+    std::vector<planner_step_result> results;
+};
+
+// Central-difference linearisation of the dynamics and quadraticisation of the stage cost around
+// (x, u). On failure returns false and sets `error`.
+bool finite_diff_derivatives(const planner_model& model,
+                             const planner_vector& x,
+                             const planner_vector& u,
+                             const std::vector<planner_bound>& bounds,
+                             double eps,
+                             finite_diff_points& pts,
+                             planner_linearisation& dyn,
+                             planner_quadratic_cost& cost,
+                             const char*& error) {
+    error = "ilqr: finite-diff dynamics linearisation failed";
     if (x.empty() || u.empty()) {
         return false;
     }
 
     const std::size_t n = x.size();
     const std::size_t m = u.size();
-    out.state_dim = n;
-    out.action_dim = m;
-    out.A.assign(n * n, 0.0);
-    out.B.assign(n * m, 0.0);
-
+    const std::size_t state_base = 1;
+    const std::size_t action_base = state_base + 2 * n;
+    const std::size_t cross_base = action_base + 2 * m;
+    const std::size_t count = cross_base + 4 * n * m;
+    pts.states.resize(count);
+    pts.actions.resize(count);
+    pts.results.resize(count);
+
+    pts.states[0] = x;
+    pts.actions[0] = u;
     for (std::size_t i = 0; i < n; ++i) {
-        planner_vector xp = x;
-        planner_vector xm = x;
-        xp[i] += eps;
-        xm[i] -= eps;
-
-        planner_step_result sp;
-        planner_step_result sm;
-        if (!deterministic_step_eval(model, xp, u, sp) || !deterministic_step_eval(model, xm, u, sm)) {
-            return false;
+        for (std::size_t sign = 0; sign < 2; ++sign) {
+            planner_vector& xs = pts.states[state_base + 2 * i + sign];
+            xs = x;
+            xs[i] += sign == 0 ? eps : -eps;
+            pts.actions[state_base + 2 * i + sign] = u;
         }
-        if (sp.next_state.size() != n || sm.next_state.size() != n) {
-            return false;
+    }
+    for (std::size_t j = 0; j < m; ++j) {
+        for (std::size_t sign = 0; sign < 2; ++sign) {
+            planner_vector us = u;
+            us[j] += sign == 0 ? eps : -eps;
+            pts.states[action_base + 2 * j + sign] = x;
+            pts.actions[action_base + 2 * j + sign] = clamp_action_with_bounds(us, bounds, model);
         }
-        for (std::size_t r = 0; r < n; ++r) {
-            out.A[r * n + i] = (sp.next_state[r] - sm.next_state[r]) / (2.0 * eps);
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+        for (std::size_t j = 0; j < m; ++j) {
+            const std::size_t corner = cross_base + 4 * (i * m + j);
+            for (std::size_t k = 0; k < 4; ++k) {
+                // k = 2 * (state sign) + (action sign); the perturbed action is the clamped one above.
+                pts.states[corner + k] = pts.states[state_base + 2 * i + k / 2];
+                pts.actions[corner + k] = pts.actions[action_base + 2 * j + k % 2];
+            }
         }
     }
 
-    for (std::size_t j = 0; j < m; ++j) {
-        planner_vector up = u;
-        planner_vector um = u;
-        up[j] += eps;
-        um[j] -= eps;
-        up = clamp_action_with_bounds(up, bounds, model);
-        um = clamp_action_with_bounds(um, bounds, model);
-
-        planner_step_result sp;
-        planner_step_result sm;
-        if (!deterministic_step_eval(model, x, up, sp) || !deterministic_step_eval(model, x, um, sm)) {
-            return false;
+    if (!model.deterministic_step_batch(pts.states, pts.actions, pts.results)) {
+        for (std::size_t p = 0; p < count; ++p) {
+            if (!deterministic_step_eval(model, pts.states[p], pts.actions[p], pts.results[p])) {
+                return false;
+            }
         }
-        if (sp.next_state.size() != n || sm.next_state.size() != n) {
+    }
+    for (std::size_t p = 0; p < count; ++p) {
+        if (pts.results[p].next_state.size() != n) {
             return false;
         }
-        for (std::size_t r = 0; r < n; ++r) {
-            out.B[r * m + j] = (sp.next_state[r] - sm.next_state[r]) / (2.0 * eps);
-        }
     }
-
-    return true;
-}
-
-bool finite_diff_quadraticise_cost(const planner_model& model,
-                                   const planner_vector& x,
-                                   const planner_vector& u,
-                                   const std::vector<planner_bound>& bounds,
-                                   double eps,
-                                   planner_quadratic_cost& out) {
-    if (x.empty() || u.empty()) {
-        return false;
+    error = "ilqr: finite-diff cost quadraticisation failed";
+    for (const planner_step_result& r : pts.results) {
+        if (!std::isfinite(r.reward) || !vector_all_finite(r.next_state)) {
+            return false;
+        }
     }
+    error = nullptr;
 
-    const std::size_t n = x.size();
-    const std::size_t m = u.size();
+    // Stage cost is -reward.
+    const auto c = [&](std::size_t p) { return -pts.results[p].reward; };
+    const double c0 = c(0);
 
-    out.l_x.assign(n, 0.0);
-    out.l_u.assign(m, 0.0);
-    out.l_xx.assign(n * n, 0.0);
-    out.l_uu.assign(m * m, 0.0);
-    out.l_xu.assign(n * m, 0.0);
-
-    const std::optional<double> c0_opt = stage_cost_deterministic(model, x, u);
-    if (!c0_opt.has_value()) {
-        return false;
-    }
-    const double c0 = *c0_opt;
-    out.l0 = c0;
+    dyn.state_dim = n;
+    dyn.action_dim = m;
+    dyn.A.assign(n * n, 0.0);
+    dyn.B.assign(n * m, 0.0);
+    cost.l0 = c0;
+    cost.l_x.assign(n, 0.0);
+    cost.l_u.assign(m, 0.0);
+    cost.l_xx.assign(n * n, 0.0);
+    cost.l_uu.assign(m * m, 0.0);
+    cost.l_xu.assign(n * m, 0.0);
 
     for (std::size_t i = 0; i < n; ++i) {
-        planner_vector xp = x;
-        planner_vector xm = x;
-        xp[i] += eps;
-        xm[i] -= eps;
-
-        const std::optional<double> cp = stage_cost_deterministic(model, xp, u);
-        const std::optional<double> cm = stage_cost_deterministic(model, xm, u);
-        if (!cp.has_value() || !cm.has_value()) {
-            return false;
+        const std::size_t p = state_base + 2 * i;
+        for (std::size_t r = 0; r < n; ++r) {
+            dyn.A[r * n + i] = (pts.results[p].next_state[r] - pts.results[p + 1].next_state[r]) / (2.0 * eps);
         }
-        out.l_x[i] = (*cp - *cm) / (2.0 * eps);
-        out.l_xx[i * n + i] = (*cp - 2.0 * c0 + *cm) / (eps * eps);
+        cost.l_x[i] = (c(p) - c(p + 1)) / (2.0 * eps);
+        cost.l_xx[i * n + i] = (c(p) - 2.0 * c0 + c(p + 1)) / (eps * eps);
     }
-
     for (std::size_t j = 0; j < m; ++j) {
-        planner_vector up = u;
-        planner_vector um = u;
-        up[j] += eps;
-        um[j] -= eps;
-        up = clamp_action_with_bounds(up, bounds, model);
-        um = clamp_action_with_bounds(um, bounds, model);
-
-        const std::optional<double> cp = stage_cost_deterministic(model, x, up);
-        const std::optional<double> cm = stage_cost_deterministic(model, x, um);
-        if (!cp.has_value() || !cm.has_value()) {
-            return false;
+        const std::size_t p = action_base + 2 * j;
+        for (std::size_t r = 0; r < n; ++r) {
+            dyn.B[r * m + j] = (pts.results[p].next_state[r] - pts.results[p + 1].next_state[r]) / (2.0 * eps);
         }
-        out.l_u[j] = (*cp - *cm) / (2.0 * eps);
-        out.l_uu[j * m + j] = (*cp - 2.0 * c0 + *cm) / (eps * eps);
+        cost.l_u[j] = (c(p) - c(p + 1)) / (2.0 * eps);
+        cost.l_uu[j * m + j] = (c(p) - 2.0 * c0 + c(p + 1)) / (eps * eps);
     }
-
     for (std::size_t i = 0; i < n; ++i) {
         for (std::size_t j = 0; j < m; ++j) {
-            planner_vector x_p = x;
-            planner_vector x_m = x;
-            x_p[i] += eps;
-            x_m[i] -= eps;
-
-            planner_vector u_p = u;
-            planner_vector u_m = u;
-            u_p[j] += eps;
-            u_m[j] -= eps;
-            u_p = clamp_action_with_bounds(u_p, bounds, model);
-            u_m = clamp_action_with_bounds(u_m, bounds, model);
-
-            const std::optional<double> cpp = stage_cost_deterministic(model, x_p, u_p);
-            const std::optional<double> cpm = stage_cost_deterministic(model, x_p, u_m);
-            const std::optional<double> cmp = stage_cost_deterministic(model, x_m, u_p);
-            const std::optional<double> cmm = stage_cost_deterministic(model, x_m, u_m);
-            if (!cpp.has_value() || !cpm.has_value() || !cmp.has_value() || !cmm.has_value()) {
+            const std::size_t p = cross_base + 4 * (i * m + j);
+            cost.l_xu[i * m + j] = (c(p) - c(p + 1) - c(p + 2) + c(p + 3)) / (4.0 * eps * eps);
+        }
+    }
+    return true;
+}
+
+// Backward-pass scratch for one iLQR solve, sized once so that iterations do not allocate. The
+// gains are flat: the feedforward term of step t is k_ff[t * m .. t * m + m) and its feedback gain is
+// the m x n row-major block at k_fb[t * m * n].
+struct ilqr_workspace {
+    std::size_t n = 0;
+    std::size_t m = 0;
+    std::vector<double> k_ff;
+    std::vector<double> k_fb;
+    std::vector<double> v_x;
+    std::vector<double> v_xx;
+    std::vector<double> q_x;
+    std::vector<double> q_u;
+    std::vector<double> q_xx;
+    std::vector<double> q_uu;
+    std::vector<double> q_ux;
+    std::vector<double> va;
+    std::vector<double> vb;
+    std::vector<double> chol;
+    std::vector<double> rhs;
+    std::vector<double> quu_k;
+    std::vector<double> quu_kk;
+
+    ilqr_workspace(std::size_t state_dim, std::size_t action_dim, std::size_t horizon)
+        : n(state_dim),
+          m(action_dim),
+          k_ff(horizon * action_dim, 0.0),
+          k_fb(horizon * action_dim * state_dim, 0.0),
+          v_x(state_dim),
+          v_xx(state_dim * state_dim),
+          q_x(state_dim),
+          q_u(action_dim),
+          q_xx(state_dim * state_dim),
+          q_uu(action_dim * action_dim),
+          q_ux(action_dim * state_dim),
+          va(state_dim * state_dim),
+          vb(state_dim * action_dim),
+          chol(action_dim * action_dim),
+          rhs(action_dim * (1 + state_dim)),
+          quu_k(action_dim),
+          quu_kk(action_dim * state_dim) {}
+};
+
+// One Riccati sweep from the terminal cost back to step 0, filling ws.k_ff and ws.k_fb. Q_uu + reg I
+// is factored with Cholesky, so the pass fails (and the caller raises reg) whenever it is not
+// positive definite. NS is the state dimension when non-zero; see planner_linalg.
+template <std::size_t NS>
+bool ilqr_backward_pass(const std::vector<planner_linearisation>& dyn,
+                        const std::vector<planner_quadratic_cost>& stage,
+                        const planner_terminal_quadratic_cost& terminal,
+                        double reg,
+                        ilqr_workspace& ws,
+                        double& grad_inf_norm) {
+    namespace la = planner_linalg;
+    const std::size_t n = la::extent<NS>(ws.n);
+    const std::size_t m = ws.m;
+    const std::size_t cols = 1 + n;
+
+    std::copy(terminal.l_x.begin(), terminal.l_x.end(), ws.v_x.begin());
+    std::copy(terminal.l_xx.begin(), terminal.l_xx.end(), ws.v_xx.begin());
+    grad_inf_norm = 0.0;
+
+    for (std::size_t t = dyn.size(); t-- > 0;) {
+        const double* a = dyn[t].A.data();
+        const double* b = dyn[t].B.data();
+        const planner_quadratic_cost& l = stage[t];
+
+        std::copy(l.l_x.begin(), l.l_x.end(), ws.q_x.begin());
+        la::add_at_x<NS, NS>(a, ws.v_x.data(), ws.q_x.data(), n, n);
+        std::copy(l.l_u.begin(), l.l_u.end(), ws.q_u.begin());
+        la::add_at_x<NS>(b, ws.v_x.data(), ws.q_u.data(), n, m);
+        for (double g : ws.q_u) {
+            grad_inf_norm = std::max(grad_inf_norm, std::fabs(g));
+        }
+
+        la::mul<NS, NS, NS>(ws.v_xx.data(), a, ws.va.data(), n, n, n);
+        la::mul<NS, NS>(ws.v_xx.data(), b, ws.vb.data(), n, n, m);
+
+        std::copy(l.l_xx.begin(), l.l_xx.end(), ws.q_xx.begin());
+        la::add_at_b<NS, NS, NS>(a, ws.va.data(), ws.q_xx.data(), n, n, n);
+        std::copy(l.l_uu.begin(), l.l_uu.end(), ws.q_uu.begin());
+        la::add_at_b<0, NS>(b, ws.vb.data(), ws.q_uu.data(), m, n, m);
+        for (std::size_t i = 0; i < m; ++i) {
+            ws.q_uu[i * m + i] += reg;
+        }
+        for (std::size_t i = 0; i < m; ++i) {
+            for (std::size_t j = 0; j < n; ++j) {
+                ws.q_ux[i * n + j] = l.l_xu[j * m + i];
+            }
+        }
+        la::add_at_b<0, NS, NS>(b, ws.va.data(), ws.q_ux.data(), m, n, n);
+
+        // [k | K] = -Q_uu^-1 [q_u | Q_ux]
+        ws.chol = ws.q_uu;
+        if (!la::cholesky(ws.chol.data(), m)) {
+            return false;
+        }
+        for (std::size_t i = 0; i < m; ++i) {
+            ws.rhs[i * cols] = -ws.q_u[i];
+            for (std::size_t j = 0; j < n; ++j) {
+                ws.rhs[i * cols + 1 + j] = -ws.q_ux[i * n + j];
+            }
+        }
+        la::cholesky_solve(ws.chol.data(), ws.rhs.data(), m, cols);
+        double* k = ws.k_ff.data() + t * m;
+        double* k_mat = ws.k_fb.data() + t * m * n;
+        for (double v : ws.rhs) {
+            if (!std::isfinite(v)) {
                 return false;
             }
-            out.l_xu[i * m + j] = (*cpp - *cpm - *cmp + *cmm) / (4.0 * eps * eps);
         }
-    }
+        for (std::size_t i = 0; i < m; ++i) {
+            k[i] = ws.rhs[i * cols];
+            for (std::size_t j = 0; j < n; ++j) {
+                k_mat[i * n + j] = ws.rhs[i * cols + 1 + j];
+            }
+        }
 
+        // V_x = q_x + K^T (q_u + Q_uu k) + Q_ux^T k
+        la::mul(ws.q_uu.data(), k, ws.quu_k.data(), m, m, 1);
+        for (std::size_t i = 0; i < m; ++i) {
+            ws.quu_k[i] += ws.q_u[i];
+        }
+        std::copy(ws.q_x.begin(), ws.q_x.end(), ws.v_x.begin());
+        la::add_at_x<0, NS>(k_mat, ws.quu_k.data(), ws.v_x.data(), m, n);
+        la::add_at_x<0, NS>(ws.q_ux.data(), k, ws.v_x.data(), m, n);
+
+        // V_xx = Q_xx + K^T Q_uu K + K^T Q_ux + Q_ux^T K, symmetrised
+        la::mul<0, 0, NS>(ws.q_uu.data(), k_mat, ws.quu_kk.data(), m, m, n);
+        std::copy(ws.q_xx.begin(), ws.q_xx.end(), ws.v_xx.begin());
+        la::add_at_b<NS, 0, NS>(k_mat, ws.quu_kk.data(), ws.v_xx.data(), n, m, n);
+        la::add_at_b<NS, 0, NS>(k_mat, ws.q_ux.data(), ws.v_xx.data(), n, m, n);
+        la::add_at_b<NS, 0, NS>(ws.q_ux.data(), k_mat, ws.v_xx.data(), n, m, n);
+        for (std::size_t i = 0; i < n; ++i) {
+            for (std::size_t j = i + 1; j < n; ++j) {
+                const double sym = 0.5 * (ws.v_xx[i * n + j] + ws.v_xx[j * n + i]);
+                ws.v_xx[i * n + j] = sym;
+                ws.v_xx[j * n + i] = sym;
+            }
+        }
+    }
     return true;
 }
 
+// Runs the backward pass with the state dimension fixed at compile time for the common sizes.
+bool ilqr_backward(const std::vector<planner_linearisation>& dyn,
+                   const std::vector<planner_quadratic_cost>& stage,
+                   const planner_terminal_quadratic_cost& terminal,
+                   double reg,
+                   ilqr_workspace& ws,
+                   double& grad_inf_norm) {
+    switch (ws.n) {
+        case 2: return ilqr_backward_pass<2>(dyn, stage, terminal, reg, ws, grad_inf_norm);
+        case 3: return ilqr_backward_pass<3>(dyn, stage, terminal, reg, ws, grad_inf_norm);
+        case 4: return ilqr_backward_pass<4>(dyn, stage, terminal, reg, ws, grad_inf_norm);
+        case 5: return ilqr_backward_pass<5>(dyn, stage, terminal, reg, ws, grad_inf_norm);
+        case 6: return ilqr_backward_pass<6>(dyn, stage, terminal, reg, ws, grad_inf_norm);
+        case 7: return ilqr_backward_pass<7>(dyn, stage, terminal, reg, ws, grad_inf_norm);
+        case 8: return ilqr_backward_pass<8>(dyn, stage, terminal, reg, ws, grad_inf_norm);
+        case 9: return ilqr_backward_pass<9>(dyn, stage, terminal, reg, ws, grad_inf_norm);
+        case 10: return ilqr_backward_pass<10>(dyn, stage, terminal, reg, ws, grad_inf_norm);
+        case 11: return ilqr_backward_pass<11>(dyn, stage, terminal, reg, ws, grad_inf_norm);
+        case 12: return ilqr_backward_pass<12>(dyn, stage, terminal, reg, ws, grad_inf_norm);
+        default: return ilqr_backward_pass<0>(dyn, stage, terminal, reg, ws, grad_inf_norm);
+    }
+}
+
+// What a planner_ilqr_warm_start keeps between solves: the last control sequence already shifted
+// by one step, and the regularisation the solve ended with.
+struct ilqr_warm_start {
+    std::vector<planner_vector> u_seq;
+    double reg = 0.0;
+    std::string model_service;
+    std::size_t action_dims = 0;
+    // Iterations of the most recent solve that started cold, the baseline for iters_saved.
+    std::int64_t cold_iters = 0;
+    bool valid = false;
+
+    void clear() noexcept {
+        u_seq.clear();
+        cold_iters = 0;
+        valid = false;
+    }
+};
+
 planner_result run_ilqr_backend(const planner_request& request,
                                 const planner_model& model,
                                 const std::vector<planner_bound>& bounds,
                                 const planner_action& safe_action,
                                 const std::string& action_schema,
-                                std::chrono::steady_clock::time_point deadline) {
+                                std::chrono::steady_clock::time_point deadline,
+                                const cancel_token& cancel,
+                                ilqr_warm_start* warm,
+                                scheduler* sched) {
     planner_result result;
     result.planner = planner_backend::ilqr;
     result.action = safe_action;
@@ -1394,8 +2354,17 @@ planner_result run_ilqr_backend(const planner_request& request,
     }
     max_iters = std::max<std::int64_t>(1, max_iters);
 
+    const bool warm_started = warm && warm->valid && warm->model_service == request.model_service &&
+                              warm->action_dims == action_dim && warm->u_seq.size() == horizon;
+    if (warm) {
+        // Stays false unless this solve finishes and leaves a sequence behind.
+        warm->valid = false;
+    }
+
     std::vector<planner_vector> u_seq;
-    if (!cfg.u_init.empty()) {
+    if (warm_started) {
+        u_seq = std::move(warm->u_seq);
+    } else if (!cfg.u_init.empty()) {
         u_seq = unpack_sequence(cfg.u_init, action_dim, horizon);
     } else {
         u_seq.assign(horizon, planner_vector(action_dim, 0.0));
@@ -1445,58 +2414,67 @@ planner_result run_ilqr_backend(const planner_request& request,
     }
 
     const double cost_init = cost;
-    double reg = cfg.reg_init;
+    double reg = warm_started ? std::clamp(warm->reg, 1.0e-8, cfg.reg_init) : cfg.reg_init;
     bool timed_out = false;
     bool converged = false;
     std::int64_t completed_iters = 0;
 
-    std::vector<planner_vector> k_seq(horizon, planner_vector(action_dim, 0.0));
-    std::vector<std::vector<double>> k_gain(horizon, std::vector<double>(action_dim * state_dim, 0.0));
+    ilqr_workspace ws(state_dim, action_dim, horizon);
+    std::vector<planner_linearisation> dyn(horizon);
+    std::vector<planner_quadratic_cost> stage(horizon);
+    planner_terminal_quadratic_cost terminal;
+
+    // Linearises step t into dyn[t] and stage[t]; returns the error, or nullptr on success.
+    const auto derive_step = [&](std::size_t t, finite_diff_points& pts) -> const char* {
+        const planner_vector u = clamp_action_with_bounds(u_seq[t], bounds, model);
+        if (cfg.derivatives == planner_ilqr_derivatives_mode::analytic) {
+            if (!model.linearise_dynamics(x_seq[t], u, dyn[t])) {
+                return "ilqr: analytic derivatives unavailable (linearise_dynamics)";
+            }
+            if (!model.quadraticise_cost(x_seq[t], u, stage[t])) {
+                return "ilqr: analytic derivatives unavailable (quadraticise_cost)";
+            }
+        } else {
+            const char* error = nullptr;
+            if (!finite_diff_derivatives(model, x_seq[t], u, bounds, cfg.fd_eps, pts, dyn[t], stage[t], error)) {
+                return error;
+            }
+        }
+
+        if (dyn[t].state_dim != state_dim || dyn[t].action_dim != action_dim ||
+            dyn[t].A.size() != state_dim * state_dim || dyn[t].B.size() != state_dim * action_dim ||
+            stage[t].l_x.size() != state_dim || stage[t].l_u.size() != action_dim ||
+            stage[t].l_xx.size() != state_dim * state_dim || stage[t].l_uu.size() != action_dim * action_dim ||
+            stage[t].l_xu.size() != state_dim * action_dim) {
+            return "ilqr: derivative dimensions mismatch";
+        }
+        return nullptr;
+    };
+    const std::size_t threads = static_cast<std::size_t>(std::clamp<std::int64_t>(
+        cfg.threads, 1, std::min<std::int64_t>(k_planner_max_threads, static_cast<std::int64_t>(horizon))));
+    std::vector<finite_diff_points> fd_points(threads);
+    // Every step is derived even when one fails, so the error reported does not depend on timing.
+    std::vector<const char*> step_error(horizon, nullptr);
+    progress_reporter progress(request, planner_backend::ilqr, model, bounds, action_schema);
 
     for (std::int64_t iter = 0; iter < max_iters; ++iter) {
-        if (std::chrono::steady_clock::now() >= deadline) {
+        if (std::chrono::steady_clock::now() >= deadline || cancel.cancelled()) {
             timed_out = true;
             break;
         }
 
-        std::vector<planner_linearisation> dyn(horizon);
-        std::vector<planner_quadratic_cost> stage(horizon);
-        planner_terminal_quadratic_cost terminal;
-
-        bool derivative_ok = true;
-        for (std::size_t t = 0; t < horizon; ++t) {
-            const planner_vector u = clamp_action_with_bounds(u_seq[t], bounds, model);
-            if (cfg.derivatives == planner_ilqr_derivatives_mode::analytic) {
-                if (!model.linearise_dynamics(x_seq[t], u, dyn[t])) {
-                    result.error = "ilqr: analytic derivatives unavailable (linearise_dynamics)";
-                    derivative_ok = false;
-                    break;
-                }
-                if (!model.quadraticise_cost(x_seq[t], u, stage[t])) {
-                    result.error = "ilqr: analytic derivatives unavailable (quadraticise_cost)";
-                    derivative_ok = false;
-                    break;
-                }
-            } else {
-                if (!finite_diff_linearise_dynamics(model, x_seq[t], u, bounds, cfg.fd_eps, dyn[t])) {
-                    result.error = "ilqr: finite-diff dynamics linearisation failed";
-                    derivative_ok = false;
-                    break;
-                }
-                if (!finite_diff_quadraticise_cost(model, x_seq[t], u, bounds, cfg.fd_eps, stage[t])) {
-                    result.error = "ilqr: finite-diff cost quadraticisation failed";
-                    derivative_ok = false;
-                    break;
-                }
+        // Steps are independent, so workers claim them from a shared counter; the first failing step
+        // in horizon order decides the error.
+        std::atomic<std::size_t> next_step{0};
+        run_parallel(threads > 1 ? sched : nullptr, threads, [&](std::size_t worker) {
+            for (std::size_t t = next_step.fetch_add(1); t < horizon; t = next_step.fetch_add(1)) {
+                step_error[t] = derive_step(t, fd_points[worker]);
             }
-
-            if (dyn[t].state_dim != state_dim || dyn[t].action_dim != action_dim ||
-                dyn[t].A.size() != state_dim * state_dim || dyn[t].B.size() != state_dim * action_dim ||
-                stage[t].l_x.size() != state_dim || stage[t].l_u.size() != action_dim ||
-                stage[t].l_xx.size() != state_dim * state_dim ||
-                stage[t].l_uu.size() != action_dim * action_dim ||
-                stage[t].l_xu.size() != state_dim * action_dim) {
-                result.error = "ilqr: derivative dimensions mismatch";
+        });
+        bool derivative_ok = true;
+        for (const char* error : step_error) {
+            if (error) {
+                result.error = error;
                 derivative_ok = false;
                 break;
             }
@@ -1523,146 +2501,8 @@ planner_result run_ilqr_backend(const planner_request& request,
             terminal.l_xx.assign(state_dim * state_dim, 0.0);
         }
 
-        planner_vector v_x = terminal.l_x;
-        std::vector<double> v_xx = terminal.l_xx;
-
         double grad_inf_norm = 0.0;
-        bool backward_ok = true;
-
-        for (std::size_t t = horizon; t-- > 0;) {
-            const std::vector<double>& a = dyn[t].A;
-            const std::vector<double>& b = dyn[t].B;
-            const planner_quadratic_cost& l = stage[t];
-
-            planner_vector q_x(state_dim, 0.0);
-            planner_vector q_u(action_dim, 0.0);
-            std::vector<double> q_xx(state_dim * state_dim, 0.0);
-            std::vector<double> q_uu(action_dim * action_dim, 0.0);
-            std::vector<double> q_ux(action_dim * state_dim, 0.0);
-
-            for (std::size_t i = 0; i < state_dim; ++i) {
-                double acc = l.l_x[i];
-                for (std::size_t r = 0; r < state_dim; ++r) {
-                    acc += a[r * state_dim + i] * v_x[r];
-                }
-                q_x[i] = acc;
-            }
-
-            for (std::size_t j = 0; j < action_dim; ++j) {
-                double acc = l.l_u[j];
-                for (std::size_t r = 0; r < state_dim; ++r) {
-                    acc += b[r * action_dim + j] * v_x[r];
-                }
-                q_u[j] = acc;
-                grad_inf_norm = std::max(grad_inf_norm, std::fabs(acc));
-            }
-
-            for (std::size_t i = 0; i < state_dim; ++i) {
-                for (std::size_t j = 0; j < state_dim; ++j) {
-                    double acc = l.l_xx[i * state_dim + j];
-                    for (std::size_t r = 0; r < state_dim; ++r) {
-                        for (std::size_t c = 0; c < state_dim; ++c) {
-                            acc += a[r * state_dim + i] * v_xx[r * state_dim + c] * a[c * state_dim + j];
-                        }
-                    }
-                    q_xx[i * state_dim + j] = acc;
-                }
-            }
-
-            for (std::size_t i = 0; i < action_dim; ++i) {
-                for (std::size_t j = 0; j < action_dim; ++j) {
-                    double acc = l.l_uu[i * action_dim + j];
-                    for (std::size_t r = 0; r < state_dim; ++r) {
-                        for (std::size_t c = 0; c < state_dim; ++c) {
-                            acc += b[r * action_dim + i] * v_xx[r * state_dim + c] * b[c * action_dim + j];
-                        }
-                    }
-                    if (i == j) {
-                        acc += reg;
-                    }
-                    q_uu[i * action_dim + j] = acc;
-                }
-            }
-
-            for (std::size_t i = 0; i < action_dim; ++i) {
-                for (std::size_t j = 0; j < state_dim; ++j) {
-                    double acc = l.l_xu[j * action_dim + i];
-                    for (std::size_t r = 0; r < state_dim; ++r) {
-                        for (std::size_t c = 0; c < state_dim; ++c) {
-                            acc += b[r * action_dim + i] * v_xx[r * state_dim + c] * a[c * state_dim + j];
-                        }
-                    }
-                    q_ux[i * state_dim + j] = acc;
-                }
-            }
-
-            std::vector<double> a_sys = q_uu;
-            std::vector<double> rhs(action_dim * (1 + state_dim), 0.0);
-            for (std::size_t i = 0; i < action_dim; ++i) {
-                rhs[i * (1 + state_dim)] = -q_u[i];
-                for (std::size_t j = 0; j < state_dim; ++j) {
-                    rhs[i * (1 + state_dim) + 1 + j] = -q_ux[i * state_dim + j];
-                }
-            }
-
-            if (!solve_linear_system(a_sys, rhs, action_dim, 1 + state_dim)) {
-                backward_ok = false;
-                break;
-            }
-
-            planner_vector k(action_dim, 0.0);
-            std::vector<double> k_mat(action_dim * state_dim, 0.0);
-            for (std::size_t i = 0; i < action_dim; ++i) {
-                k[i] = rhs[i * (1 + state_dim)];
-                for (std::size_t j = 0; j < state_dim; ++j) {
-                    k_mat[i * state_dim + j] = rhs[i * (1 + state_dim) + 1 + j];
-                }
-            }
-            k_seq[t] = k;
-            k_gain[t] = k_mat;
-
-            planner_vector next_v_x(state_dim, 0.0);
-            for (std::size_t i = 0; i < state_dim; ++i) {
-                double term1 = 0.0;
-                double term2 = 0.0;
-                double term3 = 0.0;
-                for (std::size_t a_i = 0; a_i < action_dim; ++a_i) {
-                    term1 += k_mat[a_i * state_dim + i] * q_u[a_i];
-                    term2 += q_ux[a_i * state_dim + i] * k[a_i];
-                    for (std::size_t b_i = 0; b_i < action_dim; ++b_i) {
-                        term3 += k_mat[a_i * state_dim + i] * q_uu[a_i * action_dim + b_i] * k[b_i];
-                    }
-                }
-                next_v_x[i] = q_x[i] + term1 + term2 + term3;
-            }
-
-            std::vector<double> next_v_xx(state_dim * state_dim, 0.0);
-            for (std::size_t i = 0; i < state_dim; ++i) {
-                for (std::size_t j = 0; j < state_dim; ++j) {
-                    double acc = q_xx[i * state_dim + j];
-                    for (std::size_t a_i = 0; a_i < action_dim; ++a_i) {
-                        for (std::size_t b_i = 0; b_i < action_dim; ++b_i) {
-                            acc += k_mat[a_i * state_dim + i] * q_uu[a_i * action_dim + b_i] *
-                                   k_mat[b_i * state_dim + j];
-                        }
-                        acc += k_mat[a_i * state_dim + i] * q_ux[a_i * state_dim + j];
-                        acc += q_ux[a_i * state_dim + i] * k_mat[a_i * state_dim + j];
-                    }
-                    next_v_xx[i * state_dim + j] = acc;
-                }
-            }
-
-            for (std::size_t i = 0; i < state_dim; ++i) {
-                for (std::size_t j = i + 1; j < state_dim; ++j) {
-                    const double sym = 0.5 * (next_v_xx[i * state_dim + j] + next_v_xx[j * state_dim + i]);
-                    next_v_xx[i * state_dim + j] = sym;
-                    next_v_xx[j * state_dim + i] = sym;
-                }
-            }
-
-            v_x = std::move(next_v_x);
-            v_xx = std::move(next_v_xx);
-        }
+        const bool backward_ok = ilqr_backward(dyn, stage, terminal, reg, ws, grad_inf_norm);
 
         if (!backward_ok) {
             reg = std::min(1.0e8, reg * cfg.reg_factor);
@@ -1696,10 +2536,11 @@ planner_result run_ilqr_backend(const planner_request& request,
             for (std::size_t t = 0; t < horizon; ++t) {
                 planner_vector du(action_dim, 0.0);
                 for (std::size_t i = 0; i < action_dim; ++i) {
-                    double val = alpha * k_seq[t][i];
+                    double val = alpha * ws.k_ff[t * action_dim + i];
+                    const double* gain = ws.k_fb.data() + (t * action_dim + i) * state_dim;
                     for (std::size_t j = 0; j < state_dim; ++j) {
                         const double dx = cand_x[t][j] - x_seq[t][j];
-                        val += k_gain[t][i * state_dim + j] * dx;
+                        val += gain[j] * dx;
                     }
                     du[i] = val;
                 }
@@ -1752,6 +2593,14 @@ planner_result run_ilqr_backend(const planner_request& request,
             reg = std::max(1.0e-8, reg / cfg.reg_factor);
             ++completed_iters;
 
+            const auto now = std::chrono::steady_clock::now();
+            if (progress.due(now)) {
+                progress.publish(now,
+                                 u_seq.front(),
+                                 (cost_init - cost) / std::max(1.0, std::fabs(cost_init)),
+                                 completed_iters);
+            }
+
             if (improvement <= cfg.tol_cost || grad_inf_norm <= cfg.tol_grad) {
                 converged = true;
                 break;
@@ -1775,6 +2624,23 @@ planner_result run_ilqr_backend(const planner_request& request,
     result.trace.ilqr.cost_init = cost_init;
     result.trace.ilqr.cost_final = cost;
     result.trace.ilqr.reg_final = reg;
+    result.trace.ilqr.warm_started = warm_started;
+
+    if (warm) {
+        if (warm_started) {
+            result.trace.ilqr.iters_saved = std::max<std::int64_t>(0, warm->cold_iters - completed_iters);
+        } else {
+            warm->cold_iters = completed_iters;
+        }
+        // Receding horizon: step t of the next solve starts from step t + 1 of this one.
+        std::rotate(u_seq.begin(), u_seq.begin() + 1, u_seq.end());
+        u_seq.back() = u_seq[horizon > 1 ? horizon - 2 : 0];
+        warm->u_seq = std::move(u_seq);
+        warm->reg = reg;
+        warm->model_service = request.model_service;
+        warm->action_dims = action_dim;
+        warm->valid = true;
+    }
 
     if (result.status != planner_status::ok && result.status != planner_status::timeout) {
         result.status = planner_status::error;
@@ -1785,6 +2651,44 @@ planner_result run_ilqr_backend(const planner_request& request,
 
 }  // namespace
 
+struct planner_mcts_tree_state {
+    mcts_warm_start warm;
+};
+
+planner_mcts_tree::planner_mcts_tree() : state_(std::make_unique<planner_mcts_tree_state>()) {}
+planner_mcts_tree::~planner_mcts_tree() = default;
+planner_mcts_tree::planner_mcts_tree(planner_mcts_tree&&) noexcept = default;
+planner_mcts_tree& planner_mcts_tree::operator=(planner_mcts_tree&&) noexcept = default;
+
+std::size_t planner_mcts_tree::retained_nodes() const noexcept {
+    return state_ && state_->warm.valid ? state_->warm.tree.nodes.size() : 0;
+}
+
+void planner_mcts_tree::clear() noexcept {
+    if (state_) {
+        state_->warm.clear();
+    }
+}
+
+struct planner_ilqr_warm_start_state {
+    ilqr_warm_start warm;
+};
+
+planner_ilqr_warm_start::planner_ilqr_warm_start() : state_(std::make_unique<planner_ilqr_warm_start_state>()) {}
+planner_ilqr_warm_start::~planner_ilqr_warm_start() = default;
+planner_ilqr_warm_start::planner_ilqr_warm_start(planner_ilqr_warm_start&&) noexcept = default;
+planner_ilqr_warm_start& planner_ilqr_warm_start::operator=(planner_ilqr_warm_start&&) noexcept = default;
+
+std::size_t planner_ilqr_warm_start::retained_steps() const noexcept {
+    return state_ && state_->warm.valid ? state_->warm.u_seq.size() : 0;
+}
+
+void planner_ilqr_warm_start::clear() noexcept {
+    if (state_) {
+        state_->warm.clear();
+    }
+}
+
 planner_rng::planner_rng(std::uint64_t seed) : state_(seed == 0 ? 0x9e3779b97f4a7c15ull : seed) {}
 
 double planner_rng::uniform(double lo, double hi) {
@@ -1835,6 +2739,51 @@ double planner_rng::normal(double mu, double sigma) {
     return mu + sigma * (mag * std::cos(theta));
 }
 
+void planner_rng::fill_normal(std::span<double> out) {
+    constexpr double kScale = 1.0 / 9007199254740992.0;
+    constexpr std::uint64_t kGamma = 0x9e3779b97f4a7c15ull;
+    constexpr std::size_t kPairs = 64;
+
+    std::size_t i = 0;
+    if (i < out.size() && has_spare_normal_) {
+        has_spare_normal_ = false;
+        out[i++] = spare_normal_;
+    }
+
+    double u1[kPairs];
+    double u2[kPairs];
+    while (out.size() - i >= 2) {
+        const std::size_t pairs = std::min(kPairs, (out.size() - i) / 2);
+        // splitmix64 is a counter, so draw j of the block is a pure function of state_ + (j + 1) * gamma.
+        bool rejected = false;
+        for (std::size_t j = 0; j < pairs; ++j) {
+            std::uint64_t a = state_ + (2 * j) * kGamma;
+            std::uint64_t b = state_ + (2 * j + 1) * kGamma;
+            u1[j] = static_cast<double>(splitmix64_next(a) >> 11u) * kScale;
+            u2[j] = static_cast<double>(splitmix64_next(b) >> 11u) * kScale;
+            rejected |= u1[j] <= std::numeric_limits<double>::min();
+        }
+        if (rejected) {
+            // normal() redraws u1 here, which shifts the rest of the stream; let it do this block.
+            for (std::size_t j = 0; j < 2 * pairs; ++j) {
+                out[i++] = normal(0.0, 1.0);
+            }
+            continue;
+        }
+        state_ += 2 * pairs * kGamma;
+        for (std::size_t j = 0; j < pairs; ++j) {
+            const double mag = std::sqrt(-2.0 * std::log(u1[j]));
+            const double theta = 2.0 * kPi * u2[j];
+            out[i + 2 * j] = mag * std::cos(theta);
+            out[i + 2 * j + 1] = mag * std::sin(theta);
+        }
+        i += 2 * pairs;
+    }
+    if (i < out.size()) {
+        out[i] = normal(0.0, 1.0);
+    }
+}
+
 std::uint64_t planner_rng::next_u64() {
     return splitmix64_next(state_);
 }
@@ -1869,10 +2818,23 @@ bool planner_model::rollout_cost(const planner_vector&, const std::vector<planne
     return false;
 }
 
+bool planner_model::rollout_cost_batch(const planner_vector&,
+                                       const planner_action_batch&,
+                                       std::span<double>,
+                                       planner_rng&) const {
+    return false;
+}
+
 bool planner_model::deterministic_step(const planner_vector&, const planner_vector&, planner_step_result&) const {
     return false;
 }
 
+bool planner_model::deterministic_step_batch(std::span<const planner_vector>,
+                                             std::span<const planner_vector>,
+                                             std::span<planner_step_result>) const {
+    return false;
+}
+
 bool planner_model::linearise_dynamics(const planner_vector&, const planner_vector&, planner_linearisation&) const {
     return false;
 }
@@ -1893,6 +2855,17 @@ planner_service::planner_service() {
     register_model("flagship-goal-shared-v1", std::make_shared<flagship_shared_goal_planner_model>());
 }
 
+planner_service::~planner_service() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jsonl_stop_ = true;
+    }
+    jsonl_wake_.notify_all();
+    if (jsonl_writer_.joinable()) {
+        jsonl_writer_.join();
+    }
+}
+
 void planner_service::register_model(std::string name, std::shared_ptr<planner_model> model) {
     if (name.empty()) {
         throw std::invalid_argument("register_model: model name must not be empty");
@@ -1902,6 +2875,8 @@ void planner_service::register_model(std::string name, std::shared_ptr<planner_m
     }
     std::lock_guard<std::mutex> lock(mutex_);
     models_[std::move(name)] = std::move(model);
+    // Cached results may come from the model this one replaces.
+    cache_.clear();
 }
 
 bool planner_service::has_model(std::string_view name) const {
@@ -1909,12 +2884,13 @@ bool planner_service::has_model(std::string_view name) const {
     return models_.find(std::string(name)) != models_.end();
 }
 
-planner_result planner_service::plan(const planner_request& request) {
+planner_result planner_service::plan(const planner_request& request, const cancel_token& cancel) {
     const auto start = std::chrono::steady_clock::now();
 
     planner_result result;
     result.planner = request.planner;
     result.stats.budget_ms = std::max<std::int64_t>(0, request.budget_ms);
+    result.stats.budget_choice = request.budget_choice;
     result.stats.seed = request.seed;
 
     if (request.schema_version != "planner.request.v1") {
@@ -1941,27 +2917,55 @@ planner_result planner_service::plan(const planner_request& request) {
         safe_action.action_schema = action_schema;
     }
 
+    const std::string cache_key = result_cache_key(request);
+    bool cache_hit = false;
+
     if (!model) {
         result = make_error_result(request.planner, safe_action, "planner model not found: " + request.model_service);
     } else if (!model->validate_state(request.state)) {
         result = make_error_result(request.planner, safe_action, "planner state validation failed");
+    } else if (!cache_key.empty() && cache_lookup(cache_key, result)) {
+        cache_hit = true;
+        result.stats.work_done = 0;
+        result.stats.note = "cache_hit";
     } else {
         const auto deadline = start + std::chrono::milliseconds(std::max<std::int64_t>(0, request.budget_ms));
         try {
             switch (request.planner) {
                 case planner_backend::mcts:
-                    result = run_mcts_backend(request, *model, bounds, safe_action, action_schema, deadline);
+                    result = run_mcts_backend(request,
+                                              *model,
+                                              bounds,
+                                              safe_action,
+                                              action_schema,
+                                              deadline,
+                                              cancel,
+                                              request.mcts_tree ? &request.mcts_tree->state().warm : nullptr,
+                                              scheduler_ptr());
                     break;
                 case planner_backend::mppi:
-                    result = run_mppi_backend(request, *model, bounds, safe_action, action_schema, deadline);
+                    result = run_mppi_backend(
+                        request, *model, bounds, safe_action, action_schema, deadline, cancel, scheduler_ptr());
                     break;
                 case planner_backend::ilqr:
-                    result = run_ilqr_backend(request, *model, bounds, safe_action, action_schema, deadline);
+                    result = run_ilqr_backend(request,
+                                              *model,
+                                              bounds,
+                                              safe_action,
+                                              action_schema,
+                                              deadline,
+                                              cancel,
+                                              request.ilqr_warm_start ? &request.ilqr_warm_start->state().warm
+                                                                      : nullptr,
+                                              scheduler_ptr());
                     break;
             }
         } catch (const std::exception& e) {
             result = make_error_result(request.planner, safe_action, std::string("planner backend threw: ") + e.what());
         }
+        if (cancel.cancelled() && result.stats.note.empty()) {
+            result.stats.note = "cancelled";
+        }
     }
 
     if (result.action.action_schema.empty()) {
@@ -1984,14 +2988,27 @@ planner_result planner_service::plan(const planner_request& request) {
         }
     }
 
+    if (request.mcts_tree && result.status == planner_status::error) {
+        // The action the retained subtree hangs off was not the one returned.
+        request.mcts_tree->clear();
+    }
+    if (request.ilqr_warm_start && result.status == planner_status::error) {
+        request.ilqr_warm_start->clear();
+    }
+
     result.confidence = clamp_confidence(result.confidence);
 
     const auto end = std::chrono::steady_clock::now();
     result.stats.budget_ms = std::max<std::int64_t>(0, request.budget_ms);
+    result.stats.budget_choice = request.budget_choice;
     result.stats.time_used_ms = elapsed_ms(start, end);
     result.stats.seed = request.seed;
     result.stats.overrun = result.stats.time_used_ms > result.stats.budget_ms;
 
+    if (!cache_key.empty() && !cache_hit && result.status == planner_status::ok && result.stats.note.empty()) {
+        cache_store(cache_key, result);
+    }
+
     planner_record rec;
     rec.schema_version = "planner.v1";
     rec.ts_ms = now_ms();
@@ -2001,6 +3018,7 @@ planner_result planner_service::plan(const planner_request& request) {
     rec.planner = result.planner;
     rec.status = result.status;
     rec.budget_ms = result.stats.budget_ms;
+    rec.budget_choice = result.stats.budget_choice;
     rec.time_used_ms = result.stats.time_used_ms;
     rec.work_done = result.stats.work_done;
     rec.action = result.action;
@@ -2010,11 +3028,124 @@ planner_result planner_service::plan(const planner_request& request) {
     rec.note = result.stats.note;
     rec.trace = result.trace;
     rec.state_key = request.state_key;
-    append_record(std::move(rec));
+    append_record(rec);
+
+    if (request.progress) {
+        request.progress->finish(result);
+    }
 
     return result;
 }
 
+bool planner_progress::take(planner_result& out) {
+    if ((middle_.load(std::memory_order_acquire) & k_fresh) == 0) {
+        return false;
+    }
+    front_ = middle_.exchange(front_, std::memory_order_acq_rel) & ~k_fresh;
+    std::swap(out, slots_[front_]);
+    return true;
+}
+
+void planner_progress::publish(const planner_result& result) {
+    slots_[back_] = result;
+    back_ = middle_.exchange(back_ | k_fresh, std::memory_order_acq_rel) & ~k_fresh;
+    published_.fetch_add(1, std::memory_order_release);
+}
+
+void planner_progress::finish(const planner_result& result) {
+    publish(result);
+    finished_.store(true, std::memory_order_release);
+}
+
+void planner_service::set_cache_enabled(bool enabled) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cache_enabled_ = enabled;
+    if (!enabled) {
+        cache_.clear();
+    }
+}
+
+bool planner_service::cache_enabled() const noexcept {
+    return cache_enabled_;
+}
+
+void planner_service::set_cache_ttl_ms(std::int64_t ttl_ms) {
+    if (ttl_ms < 0) {
+        throw std::invalid_argument("set_cache_ttl_ms: ttl must be non-negative");
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    cache_ttl_ms_ = ttl_ms;
+}
+
+std::int64_t planner_service::cache_ttl_ms() const noexcept {
+    return cache_ttl_ms_;
+}
+
+void planner_service::set_cache_capacity(std::size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cache_capacity_ = capacity;
+    evict_cache_to(capacity);
+}
+
+std::size_t planner_service::cache_capacity() const noexcept {
+    return cache_capacity_;
+}
+
+void planner_service::clear_cache() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cache_.clear();
+}
+
+bool planner_service::cache_lookup(const std::string& key, planner_result& out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!cache_enabled_) {
+        return false;
+    }
+    const auto it = cache_.find(key);
+    if (it == cache_.end()) {
+        return false;
+    }
+    if (std::chrono::steady_clock::now() >= it->second.expires_at) {
+        cache_.erase(it);
+        return false;
+    }
+    out = it->second.result;
+    return true;
+}
+
+void planner_service::cache_store(const std::string& key, const planner_result& result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!cache_enabled_ || cache_capacity_ == 0) {
+        return;
+    }
+    (void)cache_.erase(key);
+    evict_cache_to(cache_capacity_ - 1);
+    cache_.emplace(key,
+                   cache_entry{
+                       .result = result,
+                       .expires_at = std::chrono::steady_clock::now() + std::chrono::milliseconds(cache_ttl_ms_),
+                   });
+}
+
+void planner_service::evict_cache_to(std::size_t max_entries) {
+    if (cache_.size() <= max_entries) {
+        return;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    std::erase_if(cache_, [&](const auto& entry) { return now >= entry.second.expires_at; });
+    while (cache_.size() > max_entries) {
+        cache_.erase(cache_.begin());
+    }
+}
+
+void planner_service::set_scheduler(scheduler* sched) noexcept {
+    scheduler_.store(sched, std::memory_order_release);
+}
+
+scheduler* planner_service::scheduler_ptr() const noexcept {
+    return scheduler_.load(std::memory_order_acquire);
+}
+
 std::uint64_t planner_service::base_seed() const noexcept {
     return base_seed_;
 }
@@ -2053,19 +3184,34 @@ const std::string& planner_service::jsonl_path() const noexcept {
 }
 
 void planner_service::set_jsonl_enabled(bool enabled) noexcept {
-    jsonl_enabled_ = enabled;
+    jsonl_enabled_.store(enabled, std::memory_order_relaxed);
 }
 
 bool planner_service::jsonl_enabled() const noexcept {
-    return jsonl_enabled_;
+    return jsonl_enabled_.load(std::memory_order_relaxed);
+}
+
+void planner_service::flush_jsonl() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    const std::uint64_t target = record_next_;
+    jsonl_done_.wait(lock, [&] { return !jsonl_writer_.joinable() || jsonl_written_ >= target; });
+}
+
+std::uint64_t planner_service::jsonl_dropped() const noexcept {
+    return jsonl_dropped_.load(std::memory_order_relaxed);
 }
 
 std::vector<planner_record> planner_service::recent_records(std::size_t max_count) const {
     std::lock_guard<std::mutex> lock(mutex_);
-    if (max_count >= records_.size()) {
-        return records_;
+    const std::uint64_t available =
+        std::min<std::uint64_t>(record_next_ - record_history_begin_, records_.size());
+    const std::uint64_t count = std::min<std::uint64_t>(max_count, available);
+    std::vector<planner_record> out;
+    out.reserve(static_cast<std::size_t>(count));
+    for (std::uint64_t n = record_next_ - count; n < record_next_; ++n) {
+        out.push_back(records_[static_cast<std::size_t>(n % record_capacity_)].record);
     }
-    return std::vector<planner_record>(records_.end() - static_cast<std::ptrdiff_t>(max_count), records_.end());
+    return out;
 }
 
 std::string planner_service::dump_recent_records(std::size_t max_count) const {
@@ -2079,7 +3225,8 @@ std::string planner_service::dump_recent_records(std::size_t max_count) const {
 
 void planner_service::clear_records() {
     std::lock_guard<std::mutex> lock(mutex_);
-    records_.clear();
+    // The ring itself stays, since the JSONL writer may not have reached its records yet.
+    record_history_begin_ = record_next_;
 }
 
 void planner_service::set_record_listener(record_listener listener) {
@@ -2087,26 +3234,90 @@ void planner_service::set_record_listener(record_listener listener) {
     record_listener_ = std::move(listener);
 }
 
-void planner_service::append_record(planner_record record) {
-    std::string json_line;
-    bool write_jsonl = false;
+void planner_service::append_record(const planner_record& record) {
+    bool to_jsonl = false;
     record_listener listener;
     {
         std::lock_guard<std::mutex> lock(mutex_);
-        if (record_capacity_ > 0 && records_.size() == record_capacity_) {
-            records_.erase(records_.begin());
+        to_jsonl = jsonl_enabled_.load(std::memory_order_relaxed);
+        const std::size_t index = static_cast<std::size_t>(record_next_ % record_capacity_);
+        if (index == records_.size()) {
+            records_.push_back(record_slot{record, to_jsonl});
+        } else {
+            // Assigning into the old record reuses its strings and vectors.
+            records_[index].record = record;
+            records_[index].to_jsonl = to_jsonl;
         }
-        records_.push_back(record);
-        write_jsonl = jsonl_enabled_;
-        json_line = record_to_json(record);
+        if (to_jsonl && !jsonl_writer_.joinable()) {
+            // Nothing before this record was meant for the file.
+            jsonl_written_ = record_next_;
+            jsonl_writer_ = std::thread([this] { run_jsonl_writer(); });
+        }
+        ++record_next_;
         listener = record_listener_;
     }
 
+    if (to_jsonl) {
+        jsonl_wake_.notify_one();
+    }
     if (listener) {
-        listener(record, json_line);
+        listener(record);
     }
-    if (write_jsonl) {
-        append_jsonl_line(json_line);
+}
+
+void planner_service::run_jsonl_writer() {
+    // Copies of the records being written; kept across batches so their allocations are reused.
+    std::vector<planner_record> batch;
+    std::string text;
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        jsonl_wake_.wait(lock, [this] { return jsonl_stop_ || jsonl_written_ != record_next_; });
+        if (jsonl_written_ == record_next_) {
+            return;
+        }
+
+        const std::uint64_t end = record_next_;
+        std::uint64_t from = jsonl_written_;
+        if (end - from > record_capacity_) {
+            jsonl_dropped_.fetch_add(end - from - record_capacity_, std::memory_order_relaxed);
+            from = end - record_capacity_;
+        }
+        std::size_t count = 0;
+        for (std::uint64_t n = from; n < end; ++n) {
+            const record_slot& slot = records_[static_cast<std::size_t>(n % record_capacity_)];
+            if (!slot.to_jsonl) {
+                continue;
+            }
+            if (count == batch.size()) {
+                batch.emplace_back();
+            }
+            batch[count++] = slot.record;
+        }
+        const std::string path = jsonl_path_;
+        lock.unlock();
+
+        text.clear();
+        for (std::size_t i = 0; i < count; ++i) {
+            text += record_to_json(batch[i]);
+            text += '\n';
+        }
+        if (!text.empty()) {
+            const std::filesystem::path fs_path(path);
+            if (fs_path.has_parent_path()) {
+                std::error_code ec;
+                std::filesystem::create_directories(fs_path.parent_path(), ec);
+            }
+            std::ofstream out(path, std::ios::app);
+            if (out) {
+                out << text;
+            } else {
+                jsonl_dropped_.fetch_add(count, std::memory_order_relaxed);
+            }
+        }
+
+        lock.lock();
+        jsonl_written_ = end;
+        jsonl_done_.notify_all();
     }
 }
 
@@ -2130,6 +3341,10 @@ std::string planner_service::record_to_json(const planner_record& record) const
         << "\"confidence\":" << record.confidence << ','
         << "\"seed\":" << record.seed;
 
+    if (record.budget_choice.adaptive) {
+        out << ",\"budget_mode\":\"adaptive\",\"budget_slack_ms\":" << record.budget_choice.slack_ms
+            << ",\"budget_margin_ms\":" << record.budget_choice.margin_ms;
+    }
     if (record.overrun) {
         out << ",\"overrun\":true";
     }
@@ -2144,7 +3359,8 @@ std::string planner_service::record_to_json(const planner_record& record) const
         out << ",\"trace\":{";
         out << "\"root_visits\":" << record.trace.mcts.root_visits << ','
             << "\"root_children\":" << record.trace.mcts.root_children << ','
-            << "\"widen_added\":" << record.trace.mcts.widen_added;
+            << "\"widen_added\":" << record.trace.mcts.widen_added << ','
+            << "\"reused_visits\":" << record.trace.mcts.reused_visits;
         if (!record.trace.mcts.top_k.empty()) {
             out << ",\"top_k\":[";
             for (std::size_t i = 0; i < record.trace.mcts.top_k.size(); ++i) {
@@ -2180,7 +3396,9 @@ std::string planner_service::record_to_json(const planner_record& record) const
         out << "\"iters\":" << record.trace.ilqr.iters << ','
             << "\"cost_init\":" << record.trace.ilqr.cost_init << ','
             << "\"cost_final\":" << record.trace.ilqr.cost_final << ','
-            << "\"reg_final\":" << record.trace.ilqr.reg_final;
+            << "\"reg_final\":" << record.trace.ilqr.reg_final << ','
+            << "\"warm_started\":" << (record.trace.ilqr.warm_started ? "true" : "false") << ','
+            << "\"iters_saved\":" << record.trace.ilqr.iters_saved;
         if (!record.trace.ilqr.top_k.empty()) {
             out << ",\"top_k\":[";
             for (std::size_t i = 0; i < record.trace.ilqr.top_k.size(); ++i) {
@@ -2200,21 +3418,6 @@ std::string planner_service::record_to_json(const planner_record& record) const
     return out.str();
 }
 
-void planner_service::append_jsonl_line(const std::string& line) {
-    const std::string path = jsonl_path_;
-    std::lock_guard<std::mutex> lock(file_mutex_);
-    const std::filesystem::path fs_path(path);
-    if (fs_path.has_parent_path()) {
-        std::error_code ec;
-        std::filesystem::create_directories(fs_path.parent_path(), ec);
-    }
-    std::ofstream out(path, std::ios::app);
-    if (!out) {
-        return;
-    }
-    out << line << '\n';
-}
-
 const char* planner_status_name(planner_status status) noexcept {
     switch (status) {
         case planner_status::ok:
@@ -0,0 +1,664 @@
+#include "bt/planner_compiled_model.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+#include "muslisp/printer.hpp"
+
+namespace bt {
+namespace {
+
+enum class expr_op : std::uint8_t {
+    constant,
+    load_x,
+    load_u,
+    load_next,
+    load_local,
+    store_local,
+    add,
+    sub,
+    mul,
+    div,
+    neg,
+    min,
+    max,
+    abs,
+    sqrt,
+    exp,
+    log,
+    sin,
+    cos,
+    tan,
+    tanh,
+    atan2,
+    pow,
+    floor,
+    clamp,
+    less,
+    less_equal,
+    greater,
+    greater_equal,
+    equal,
+    logical_not,
+    jump,
+    jump_if_false,
+};
+
+struct expr_instruction {
+    expr_op op = expr_op::constant;
+    std::uint32_t arg = 0;
+    double constant = 0.0;
+};
+
+// Let-bound values and the operand stack share one frame on the C stack.
+constexpr std::size_t k_max_frame = 256;
+
+// One compiled expression. run() reads the state, action and (for cost and done) next state.
+struct expr_program {
+    std::vector<expr_instruction> code;
+    std::size_t locals = 0;
+    std::size_t max_stack = 0;
+
+    double run(const double* x, const double* u, const double* next) const noexcept {
+        double frame[k_max_frame];
+        double* sp = frame + locals;
+        const expr_instruction* const begin = code.data();
+        const expr_instruction* const end = begin + code.size();
+        for (const expr_instruction* ip = begin; ip != end; ++ip) {
+            switch (ip->op) {
+                case expr_op::constant:
+                    *sp++ = ip->constant;
+                    break;
+                case expr_op::load_x:
+                    *sp++ = x[ip->arg];
+                    break;
+                case expr_op::load_u:
+                    *sp++ = u[ip->arg];
+                    break;
+                case expr_op::load_next:
+                    *sp++ = next[ip->arg];
+                    break;
+                case expr_op::load_local:
+                    *sp++ = frame[ip->arg];
+                    break;
+                case expr_op::store_local:
+                    frame[ip->arg] = *--sp;
+                    break;
+                case expr_op::add:
+                    --sp;
+                    sp[-1] += sp[0];
+                    break;
+                case expr_op::sub:
+                    --sp;
+                    sp[-1] -= sp[0];
+                    break;
+                case expr_op::mul:
+                    --sp;
+                    sp[-1] *= sp[0];
+                    break;
+                case expr_op::div:
+                    --sp;
+                    sp[-1] /= sp[0];
+                    break;
+                case expr_op::neg:
+                    sp[-1] = -sp[-1];
+                    break;
+                case expr_op::min:
+                    --sp;
+                    sp[-1] = std::min(sp[-1], sp[0]);
+                    break;
+                case expr_op::max:
+                    --sp;
+                    sp[-1] = std::max(sp[-1], sp[0]);
+                    break;
+                case expr_op::abs:
+                    sp[-1] = std::fabs(sp[-1]);
+                    break;
+                case expr_op::sqrt:
+                    sp[-1] = std::sqrt(sp[-1]);
+                    break;
+                case expr_op::exp:
+                    sp[-1] = std::exp(sp[-1]);
+                    break;
+                case expr_op::log:
+                    sp[-1] = std::log(sp[-1]);
+                    break;
+                case expr_op::sin:
+                    sp[-1] = std::sin(sp[-1]);
+                    break;
+                case expr_op::cos:
+                    sp[-1] = std::cos(sp[-1]);
+                    break;
+                case expr_op::tan:
+                    sp[-1] = std::tan(sp[-1]);
+                    break;
+                case expr_op::tanh:
+                    sp[-1] = std::tanh(sp[-1]);
+                    break;
+                case expr_op::atan2:
+                    --sp;
+                    sp[-1] = std::atan2(sp[-1], sp[0]);
+                    break;
+                case expr_op::pow:
+                    --sp;
+                    sp[-1] = std::pow(sp[-1], sp[0]);
+                    break;
+                case expr_op::floor:
+                    sp[-1] = std::floor(sp[-1]);
+                    break;
+                case expr_op::clamp:
+                    sp -= 2;
+                    sp[-1] = std::min(std::max(sp[-1], sp[0]), sp[1]);
+                    break;
+                case expr_op::less:
+                    --sp;
+                    sp[-1] = sp[-1] < sp[0] ? 1.0 : 0.0;
+                    break;
+                case expr_op::less_equal:
+                    --sp;
+                    sp[-1] = sp[-1] <= sp[0] ? 1.0 : 0.0;
+                    break;
+                case expr_op::greater:
+                    --sp;
+                    sp[-1] = sp[-1] > sp[0] ? 1.0 : 0.0;
+                    break;
+                case expr_op::greater_equal:
+                    --sp;
+                    sp[-1] = sp[-1] >= sp[0] ? 1.0 : 0.0;
+                    break;
+                case expr_op::equal:
+                    --sp;
+                    sp[-1] = sp[-1] == sp[0] ? 1.0 : 0.0;
+                    break;
+                case expr_op::logical_not:
+                    sp[-1] = sp[-1] != 0.0 ? 0.0 : 1.0;
+                    break;
+                case expr_op::jump:
+                    ip = begin + ip->arg - 1;
+                    break;
+                case expr_op::jump_if_false:
+                    if (*--sp == 0.0) {
+                        ip = begin + ip->arg - 1;
+                    }
+                    break;
+            }
+        }
+        return sp[-1];
+    }
+};
+
+struct unary_entry {
+    std::string_view name;
+    expr_op op;
+};
+
+constexpr unary_entry k_unary_ops[] = {
+    {"abs", expr_op::abs},
+    {"sqrt", expr_op::sqrt},
+    {"exp", expr_op::exp},
+    {"log", expr_op::log},
+    {"sin", expr_op::sin},
+    {"cos", expr_op::cos},
+    {"tan", expr_op::tan},
+    {"tanh", expr_op::tanh},
+    {"floor", expr_op::floor},
+    {"not", expr_op::logical_not},
+};
+
+constexpr unary_entry k_binary_ops[] = {
+    {"atan2", expr_op::atan2},
+    {"pow", expr_op::pow},
+    {"<", expr_op::less},
+    {"<=", expr_op::less_equal},
+    {">", expr_op::greater},
+    {">=", expr_op::greater_equal},
+    {"=", expr_op::equal},
+};
+
+class expr_compiler {
+public:
+    expr_compiler(std::string where, std::size_t state_dim, std::size_t action_dim, bool next_visible)
+        : where_(std::move(where)), state_dim_(state_dim), action_dim_(action_dim), next_visible_(next_visible) {}
+
+    expr_program compile(muslisp::value form) {
+        compile_form(form);
+        if (program_.locals + program_.max_stack > k_max_frame) {
+            fail(form, "expression needs more than " + std::to_string(k_max_frame) + " stack slots");
+        }
+        return std::move(program_);
+    }
+
+private:
+    [[noreturn]] void fail(muslisp::value form, const std::string& message) const {
+        throw std::invalid_argument(where_ + ": " + message + " in " + muslisp::write_value(form));
+    }
+
+    void emit(expr_op op, std::uint32_t arg = 0, double constant = 0.0) {
+        program_.code.push_back(expr_instruction{op, arg, constant});
+    }
+
+    // Tracks operand-stack depth: `pushed` values pushed after `popped` were popped.
+    void stack(std::size_t popped, std::size_t pushed) {
+        depth_ -= popped;
+        depth_ += pushed;
+        program_.max_stack = std::max(program_.max_stack, depth_);
+    }
+
+    void push(expr_op op, std::uint32_t arg = 0, double constant = 0.0) {
+        emit(op, arg, constant);
+        stack(0, 1);
+    }
+
+    std::size_t here() const { return program_.code.size(); }
+    void patch(std::size_t at) { program_.code[at].arg = static_cast<std::uint32_t>(here()); }
+
+    static std::vector<muslisp::value> list_items(muslisp::value list) {
+        std::vector<muslisp::value> items;
+        for (muslisp::value it = list; muslisp::is_cons(it); it = muslisp::cdr(it)) {
+            items.push_back(muslisp::car(it));
+        }
+        return items;
+    }
+
+    void compile_form(muslisp::value form) {
+        if (muslisp::is_integer(form)) {
+            push(expr_op::constant, 0, static_cast<double>(muslisp::integer_value(form)));
+            return;
+        }
+        if (muslisp::is_float(form)) {
+            push(expr_op::constant, 0, muslisp::float_value(form));
+            return;
+        }
+        if (muslisp::is_symbol(form)) {
+            const std::string& name = muslisp::symbol_name(form);
+            for (auto it = scope_.rbegin(); it != scope_.rend(); ++it) {
+                if (it->first == name) {
+                    push(expr_op::load_local, it->second);
+                    return;
+                }
+            }
+            fail(form, "unbound name '" + name + "'");
+        }
+        if (!muslisp::is_cons(form) || !muslisp::is_symbol(muslisp::car(form))) {
+            fail(form, "expected a number, a let-bound name or an operator form");
+        }
+
+        const std::string& head = muslisp::symbol_name(muslisp::car(form));
+        const std::vector<muslisp::value> args = list_items(muslisp::cdr(form));
+
+        if (head == "vec.get") {
+            compile_vec_get(form, args);
+        } else if (head == "+" || head == "*") {
+            const expr_op op = head == "+" ? expr_op::add : expr_op::mul;
+            if (args.empty()) {
+                push(expr_op::constant, 0, head == "+" ? 0.0 : 1.0);
+                return;
+            }
+            fold(args, op);
+        } else if (head == "-" || head == "/") {
+            const expr_op op = head == "-" ? expr_op::sub : expr_op::div;
+            if (args.empty()) {
+                fail(form, "'" + head + "' expects at least one argument");
+            }
+            if (args.size() == 1) {
+                if (op == expr_op::sub) {
+                    compile_form(args[0]);
+                    emit(expr_op::neg);
+                } else {
+                    push(expr_op::constant, 0, 1.0);
+                    compile_form(args[0]);
+                    emit(expr_op::div);
+                    stack(2, 1);
+                }
+                return;
+            }
+            fold(args, op);
+        } else if (head == "min" || head == "max") {
+            if (args.empty()) {
+                fail(form, "'" + head + "' expects at least one argument");
+            }
+            fold(args, head == "min" ? expr_op::min : expr_op::max);
+        } else if (head == "clamp") {
+            expect_arity(form, args, 3);
+            for (muslisp::value arg : args) {
+                compile_form(arg);
+            }
+            emit(expr_op::clamp);
+            stack(3, 1);
+        } else if (head == "if") {
+            compile_if(form, args);
+        } else if (head == "and" || head == "or") {
+            compile_logical(args, head == "and");
+        } else if (head == "let") {
+            compile_let(form, args);
+        } else if (const unary_entry* unary = find(k_unary_ops, head)) {
+            expect_arity(form, args, 1);
+            compile_form(args[0]);
+            emit(unary->op);
+        } else if (const unary_entry* binary = find(k_binary_ops, head)) {
+            expect_arity(form, args, 2);
+            compile_form(args[0]);
+            compile_form(args[1]);
+            emit(binary->op);
+            stack(2, 1);
+        } else {
+            fail(form, "unsupported operator '" + head + "'");
+        }
+    }
+
+    template <std::size_t N>
+    static const unary_entry* find(const unary_entry (&table)[N], std::string_view name) {
+        for (const unary_entry& entry : table) {
+            if (entry.name == name) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    void expect_arity(muslisp::value form, const std::vector<muslisp::value>& args, std::size_t count) const {
+        if (args.size() != count) {
+            fail(form, "expected " + std::to_string(count) + " argument(s)");
+        }
+    }
+
+    void fold(const std::vector<muslisp::value>& args, expr_op op) {
+        compile_form(args[0]);
+        for (std::size_t i = 1; i < args.size(); ++i) {
+            compile_form(args[i]);
+            emit(op);
+            stack(2, 1);
+        }
+    }
+
+    void compile_vec_get(muslisp::value form, const std::vector<muslisp::value>& args) {
+        expect_arity(form, args, 2);
+        if (!muslisp::is_symbol(args[0]) || !muslisp::is_integer(args[1])) {
+            fail(form, "vec.get expects x, u or next and a literal index");
+        }
+        const std::string& vec = muslisp::symbol_name(args[0]);
+        const std::int64_t index = muslisp::integer_value(args[1]);
+        expr_op op = expr_op::load_x;
+        std::size_t dims = state_dim_;
+        if (vec == "u") {
+            op = expr_op::load_u;
+            dims = action_dim_;
+        } else if (vec == "next" && next_visible_) {
+            op = expr_op::load_next;
+        } else if (vec != "x") {
+            fail(form, next_visible_ ? "vec.get expects x, u or next" : "vec.get expects x or u");
+        }
+        if (index < 0 || static_cast<std::size_t>(index) >= dims) {
+            fail(form, "index out of range");
+        }
+        push(op, static_cast<std::uint32_t>(index));
+    }
+
+    void compile_if(muslisp::value form, const std::vector<muslisp::value>& args) {
+        expect_arity(form, args, 3);
+        compile_form(args[0]);
+        const std::size_t to_else = here();
+        emit(expr_op::jump_if_false);
+        stack(1, 0);
+        compile_form(args[1]);
+        const std::size_t to_end = here();
+        emit(expr_op::jump);
+        patch(to_else);
+        stack(1, 0);
+        compile_form(args[2]);
+        patch(to_end);
+    }
+
+    // (and a b ...) is 1.0 when every argument is true, (or a b ...) when any is; both stop early.
+    void compile_logical(const std::vector<muslisp::value>& args, bool is_and) {
+        std::vector<std::size_t> exits;
+        for (muslisp::value arg : args) {
+            compile_form(arg);
+            if (!is_and) {
+                emit(expr_op::logical_not);
+            }
+            exits.push_back(here());
+            emit(expr_op::jump_if_false);
+            stack(1, 0);
+        }
+        push(expr_op::constant, 0, is_and ? 1.0 : 0.0);
+        const std::size_t to_end = here();
+        emit(expr_op::jump);
+        for (std::size_t at : exits) {
+            patch(at);
+        }
+        emit(expr_op::constant, 0, is_and ? 0.0 : 1.0);
+        patch(to_end);
+    }
+
+    void compile_let(muslisp::value form, const std::vector<muslisp::value>& args) {
+        if (args.size() != 2) {
+            fail(form, "let expects a binding list and one body expression");
+        }
+        std::vector<std::pair<std::string, std::uint32_t>> bound;
+        for (muslisp::value binding : list_items(args[0])) {
+            const std::vector<muslisp::value> parts = list_items(binding);
+            if (parts.size() != 2 || !muslisp::is_symbol(parts[0])) {
+                fail(binding, "let binding should be (name expr)");
+            }
+            compile_form(parts[1]);
+            const auto slot = static_cast<std::uint32_t>(program_.locals++);
+            emit(expr_op::store_local, slot);
+            stack(1, 0);
+            bound.emplace_back(muslisp::symbol_name(parts[0]), slot);
+        }
+        const std::size_t outer = scope_.size();
+        scope_.insert(scope_.end(), bound.begin(), bound.end());
+        compile_form(args[1]);
+        scope_.resize(outer);
+    }
+
+    std::string where_;
+    std::size_t state_dim_;
+    std::size_t action_dim_;
+    bool next_visible_;
+    expr_program program_;
+    std::size_t depth_ = 0;
+    std::vector<std::pair<std::string, std::uint32_t>> scope_;
+};
+
+class compiled_planner_model final : public planner_model {
+public:
+    compiled_planner_model(std::string name,
+                           std::size_t state_dim,
+                           std::vector<planner_bound> bounds,
+                           std::vector<expr_program> next,
+                           expr_program cost,
+                           std::optional<expr_program> done,
+                           std::int64_t default_horizon,
+                           std::int64_t default_dt_ms)
+        : name_(std::move(name)),
+          state_dim_(state_dim),
+          bounds_(std::move(bounds)),
+          next_(std::move(next)),
+          cost_(std::move(cost)),
+          done_(std::move(done)),
+          default_horizon_(default_horizon),
+          default_dt_ms_(default_dt_ms) {}
+
+    planner_step_result step(const planner_vector& state, const planner_vector& action, planner_rng&) const override {
+        planner_step_result out;
+        evaluate(state, action, out);
+        return out;
+    }
+
+    planner_vector sample_action(const planner_vector&, planner_rng& rng) const override {
+        planner_vector out(bounds_.size());
+        for (std::size_t d = 0; d < bounds_.size(); ++d) {
+            out[d] = rng.uniform(bounds_[d].lo, bounds_[d].hi);
+        }
+        return out;
+    }
+
+    planner_vector clamp_action(const planner_vector& action) const override {
+        planner_vector out(bounds_.size(), 0.0);
+        clamp_into(action, out.data());
+        return out;
+    }
+
+    planner_vector zero_action() const override { return clamp_action(planner_vector(bounds_.size(), 0.0)); }
+
+    bool validate_state(const planner_vector& state) const override {
+        return state.size() == state_dim_ && std::all_of(state.begin(), state.end(), [](double v) {
+                   return std::isfinite(v);
+               });
+    }
+
+    std::size_t action_dims() const override { return bounds_.size(); }
+    std::vector<planner_bound> action_bounds() const override { return bounds_; }
+
+    std::int64_t default_horizon() const override {
+        return default_horizon_ > 0 ? default_horizon_ : planner_model::default_horizon();
+    }
+    std::int64_t default_dt_ms() const override {
+        return default_dt_ms_ > 0 ? default_dt_ms_ : planner_model::default_dt_ms();
+    }
+
+    // Rolls each sample out exactly as step() would, stopping at done and rejecting a sample whose
+    // cost or state stops being finite.
+    bool rollout_cost_batch(const planner_vector& state,
+                            const planner_action_batch& batch,
+                            std::span<double> costs,
+                            planner_rng&) const override {
+        if (state.size() != state_dim_ || batch.action_dim != bounds_.size()) {
+            return false;
+        }
+        std::vector<double> x(state_dim_);
+        std::vector<double> next(state_dim_);
+        std::vector<double> u(bounds_.size());
+        for (std::size_t s = 0; s < batch.samples; ++s) {
+            std::copy(state.begin(), state.end(), x.begin());
+            double total = 0.0;
+            for (std::size_t t = 0; t < batch.horizon; ++t) {
+                for (std::size_t d = 0; d < u.size(); ++d) {
+                    u[d] = std::clamp(batch.row(t, d)[s], bounds_[d].lo, bounds_[d].hi);
+                }
+                bool done = false;
+                const double cost = run(x.data(), u.data(), next.data(), done);
+                if (!std::isfinite(cost) ||
+                    !std::all_of(next.begin(), next.end(), [](double v) { return std::isfinite(v); })) {
+                    total = std::numeric_limits<double>::infinity();
+                    break;
+                }
+                total += cost;
+                x.swap(next);
+                if (done) {
+                    break;
+                }
+            }
+            costs[s] = total;
+        }
+        return true;
+    }
+
+    bool deterministic_step(const planner_vector& state, const planner_vector& action, planner_step_result& out) const override {
+        evaluate(state, action, out);
+        return true;
+    }
+
+    bool deterministic_step_batch(std::span<const planner_vector> states,
+                                  std::span<const planner_vector> actions,
+                                  std::span<planner_step_result> out) const override {
+        for (std::size_t i = 0; i < states.size(); ++i) {
+            evaluate(states[i], actions[i], out[i]);
+        }
+        return true;
+    }
+
+private:
+    void clamp_into(const planner_vector& action, double* out) const {
+        for (std::size_t d = 0; d < bounds_.size(); ++d) {
+            const double v = d < action.size() ? action[d] : 0.0;
+            out[d] = std::clamp(v, bounds_[d].lo, bounds_[d].hi);
+        }
+    }
+
+    // Writes the next state and returns the stage cost.
+    double run(const double* x, const double* u, double* next, bool& done) const noexcept {
+        for (std::size_t i = 0; i < next_.size(); ++i) {
+            next[i] = next_[i].run(x, u, nullptr);
+        }
+        done = done_ && done_->run(x, u, next) != 0.0;
+        return cost_.run(x, u, next);
+    }
+
+    void evaluate(const planner_vector& state, const planner_vector& action, planner_step_result& out) const {
+        if (state.size() != state_dim_) {
+            throw std::runtime_error(name_ + ".step: expected state of size " + std::to_string(state_dim_));
+        }
+        if (action.size() != bounds_.size()) {
+            throw std::runtime_error(name_ + ".step: expected action of size " + std::to_string(bounds_.size()));
+        }
+        const planner_vector u = clamp_action(action);
+        out.next_state.resize(state_dim_);
+        bool done = false;
+        out.reward = -run(state.data(), u.data(), out.next_state.data(), done);
+        out.done = done;
+    }
+
+    std::string name_;
+    std::size_t state_dim_;
+    std::vector<planner_bound> bounds_;
+    std::vector<expr_program> next_;
+    expr_program cost_;
+    std::optional<expr_program> done_;
+    std::int64_t default_horizon_;
+    std::int64_t default_dt_ms_;
+};
+
+}  // namespace
+
+std::shared_ptr<planner_model> compile_planner_model(const std::string& name, const planner_model_definition& def) {
+    const std::string where = "planner model '" + name + "'";
+    if (def.state_dim == 0) {
+        throw std::invalid_argument(where + ": state_dim must be positive");
+    }
+    if (def.action_bounds.empty()) {
+        throw std::invalid_argument(where + ": expected at least one action bound");
+    }
+    for (const planner_bound& b : def.action_bounds) {
+        if (!std::isfinite(b.lo) || !std::isfinite(b.hi) || b.lo > b.hi) {
+            throw std::invalid_argument(where + ": action bounds must be finite with lo <= hi");
+        }
+    }
+    if (def.next_state.size() != def.state_dim) {
+        throw std::invalid_argument(where + ": expected one next-state expression per state dimension");
+    }
+    if (!def.cost) {
+        throw std::invalid_argument(where + ": missing cost expression");
+    }
+
+    const std::size_t action_dim = def.action_bounds.size();
+    std::vector<expr_program> next;
+    next.reserve(def.state_dim);
+    for (std::size_t i = 0; i < def.state_dim; ++i) {
+        next.push_back(expr_compiler(where + " next[" + std::to_string(i) + "]", def.state_dim, action_dim, false)
+                           .compile(def.next_state[i]));
+    }
+    expr_program cost = expr_compiler(where + " cost", def.state_dim, action_dim, true).compile(def.cost);
+    std::optional<expr_program> done;
+    if (def.done) {
+        done = expr_compiler(where + " done", def.state_dim, action_dim, true).compile(def.done);
+    }
+    return std::make_shared<compiled_planner_model>(name,
+                                                    def.state_dim,
+                                                    def.action_bounds,
+                                                    std::move(next),
+                                                    std::move(cost),
+                                                    std::move(done),
+                                                    def.default_horizon,
+                                                    def.default_dt_ms);
+}
+
+}  // namespace bt
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+namespace bt::planner_linalg {
+
+// Small dense kernels for the iLQR backward pass. Matrices are row-major arrays. Every dimension is
+// a template parameter that, when non-zero, replaces the matching run-time argument, so a caller
+// instantiated for a fixed state size gets loops the compiler can unroll; 0 keeps the run-time size.
+
+template <std::size_t N>
+constexpr std::size_t extent(std::size_t runtime) noexcept {
+    return N != 0 ? N : runtime;
+}
+
+// y += A^T x, with A rows x cols.
+template <std::size_t R = 0, std::size_t C = 0>
+void add_at_x(const double* a, const double* x, double* y, std::size_t rows, std::size_t cols) noexcept {
+    const std::size_t r_n = extent<R>(rows);
+    const std::size_t c_n = extent<C>(cols);
+    for (std::size_t r = 0; r < r_n; ++r) {
+        const double xr = x[r];
+        for (std::size_t c = 0; c < c_n; ++c) {
+            y[c] += a[r * c_n + c] * xr;
+        }
+    }
+}
+
+// out = A B, with A rows x inner and B inner x cols.
+template <std::size_t R = 0, std::size_t K = 0, std::size_t C = 0>
+void mul(const double* a, const double* b, double* out, std::size_t rows, std::size_t inner, std::size_t cols) noexcept {
+    const std::size_t r_n = extent<R>(rows);
+    const std::size_t k_n = extent<K>(inner);
+    const std::size_t c_n = extent<C>(cols);
+    for (std::size_t r = 0; r < r_n; ++r) {
+        double* row = out + r * c_n;
+        for (std::size_t c = 0; c < c_n; ++c) {
+            row[c] = 0.0;
+        }
+        for (std::size_t k = 0; k < k_n; ++k) {
+            const double ark = a[r * k_n + k];
+            const double* b_row = b + k * c_n;
+            for (std::size_t c = 0; c < c_n; ++c) {
+                row[c] += ark * b_row[c];
+            }
+        }
+    }
+}
+
+// out += A^T B, with A inner x rows and B inner x cols.
+template <std::size_t R = 0, std::size_t K = 0, std::size_t C = 0>
+void add_at_b(const double* a, const double* b, double* out, std::size_t rows, std::size_t inner, std::size_t cols) noexcept {
+    const std::size_t r_n = extent<R>(rows);
+    const std::size_t k_n = extent<K>(inner);
+    const std::size_t c_n = extent<C>(cols);
+    for (std::size_t k = 0; k < k_n; ++k) {
+        const double* a_row = a + k * r_n;
+        const double* b_row = b + k * c_n;
+        for (std::size_t r = 0; r < r_n; ++r) {
+            const double akr = a_row[r];
+            double* row = out + r * c_n;
+            for (std::size_t c = 0; c < c_n; ++c) {
+                row[c] += akr * b_row[c];
+            }
+        }
+    }
+}
+
+// Factors the symmetric n x n matrix `a` in place as L L^T, leaving L in the lower triangle. Returns
+// false, with `a` partly overwritten, when the matrix is not numerically positive definite.
+template <std::size_t N = 0>
+bool cholesky(double* a, std::size_t n) noexcept {
+    const std::size_t n_n = extent<N>(n);
+    for (std::size_t j = 0; j < n_n; ++j) {
+        double diag = a[j * n_n + j];
+        for (std::size_t k = 0; k < j; ++k) {
+            diag -= a[j * n_n + k] * a[j * n_n + k];
+        }
+        if (!(diag > 1.0e-12) || !std::isfinite(diag)) {
+            return false;
+        }
+        const double l_jj = std::sqrt(diag);
+        a[j * n_n + j] = l_jj;
+        for (std::size_t i = j + 1; i < n_n; ++i) {
+            double acc = a[i * n_n + j];
+            for (std::size_t k = 0; k < j; ++k) {
+                acc -= a[i * n_n + k] * a[j * n_n + k];
+            }
+            a[i * n_n + j] = acc / l_jj;
+        }
+    }
+    return true;
+}
+
+// Solves (L L^T) X = B in place for the n x cols right-hand side `b`, given the factor from cholesky().
+template <std::size_t N = 0, std::size_t C = 0>
+void cholesky_solve(const double* l, double* b, std::size_t n, std::size_t cols) noexcept {
+    const std::size_t n_n = extent<N>(n);
+    const std::size_t c_n = extent<C>(cols);
+    for (std::size_t i = 0; i < n_n; ++i) {
+        double* row = b + i * c_n;
+        for (std::size_t k = 0; k < i; ++k) {
+            const double lik = l[i * n_n + k];
+            const double* prev = b + k * c_n;
+            for (std::size_t c = 0; c < c_n; ++c) {
+                row[c] -= lik * prev[c];
+            }
+        }
+        const double inv = 1.0 / l[i * n_n + i];
+        for (std::size_t c = 0; c < c_n; ++c) {
+            row[c] *= inv;
+        }
+    }
+    for (std::size_t i = n_n; i-- > 0;) {
+        double* row = b + i * c_n;
+        for (std::size_t k = i + 1; k < n_n; ++k) {
+            const double lki = l[k * n_n + i];
+            const double* next = b + k * c_n;
+            for (std::size_t c = 0; c < c_n; ++c) {
+                row[c] -= lki * next[c];
+            }
+        }
+        const double inv = 1.0 / l[i * n_n + i];
+        for (std::size_t c = 0; c < c_n; ++c) {
+            row[c] *= inv;
+        }
+    }
+}
+
+}  // namespace bt::planner_linalg
@@ -1,7 +1,117 @@
 #include "bt/profile.hpp"
 
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#include "bt/instance.hpp"
+#include "muslisp/gc.hpp"
+
 namespace bt {
 
+latency_histogram::latency_histogram(const latency_histogram& other) noexcept {
+    *this = other;
+}
+
+latency_histogram& latency_histogram::operator=(const latency_histogram& other) noexcept {
+    if (this != &other) {
+        for (std::size_t i = 0; i < k_bucket_count; ++i) {
+            buckets_[i].store(other.buckets_[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        count_.store(other.count_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    return *this;
+}
+
+std::size_t latency_histogram::bucket_index(std::chrono::nanoseconds sample) noexcept {
+    const std::uint64_t v = sample.count() > 0 ? static_cast<std::uint64_t>(sample.count()) : 0u;
+    if (v < k_sub_buckets) {
+        return static_cast<std::size_t>(v);
+    }
+    const std::size_t exponent = static_cast<std::size_t>(std::bit_width(v)) - 1u;
+    if (exponent > k_max_exponent) {
+        return k_bucket_count - 1u;
+    }
+    const std::size_t sub = static_cast<std::size_t>(v >> (exponent - k_sub_bucket_bits)) - k_sub_buckets;
+    return k_sub_buckets * (exponent - k_sub_bucket_bits + 1u) + sub;
+}
+
+std::chrono::nanoseconds latency_histogram::bucket_upper_bound(std::size_t bucket) noexcept {
+    if (bucket < k_sub_buckets) {
+        return std::chrono::nanoseconds(static_cast<std::int64_t>(bucket));
+    }
+    const std::size_t exponent = bucket / k_sub_buckets + k_sub_bucket_bits - 1u;
+    const std::uint64_t sub = bucket % k_sub_buckets;
+    const std::size_t shift = exponent - k_sub_bucket_bits;
+    const std::uint64_t upper = ((k_sub_buckets + sub + 1u) << shift) - 1u;
+    return std::chrono::nanoseconds(static_cast<std::int64_t>(upper));
+}
+
+void latency_histogram::record(std::chrono::nanoseconds sample) noexcept {
+    std::atomic<std::uint64_t>& bucket = buckets_[bucket_index(sample)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1u, std::memory_order_relaxed);
+    count_.store(count_.load(std::memory_order_relaxed) + 1u, std::memory_order_relaxed);
+}
+
+void latency_histogram::merge(const latency_histogram& other) noexcept {
+    for (std::size_t i = 0; i < k_bucket_count; ++i) {
+        const std::uint64_t n = other.buckets_[i].load(std::memory_order_relaxed);
+        if (n != 0) {
+            buckets_[i].store(buckets_[i].load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+    }
+    count_.store(count_.load(std::memory_order_relaxed) + other.count_.load(std::memory_order_relaxed),
+                 std::memory_order_relaxed);
+}
+
+void latency_histogram::reset() noexcept {
+    for (std::atomic<std::uint64_t>& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+}
+
+std::uint64_t latency_histogram::count() const noexcept {
+    return count_.load(std::memory_order_relaxed);
+}
+
+std::uint64_t latency_histogram::bucket_count_at(std::size_t bucket) const noexcept {
+    return bucket < k_bucket_count ? buckets_[bucket].load(std::memory_order_relaxed) : 0u;
+}
+
+std::chrono::nanoseconds latency_histogram::quantile(double q) const noexcept {
+    // Walk the buckets rather than trusting count_, which a concurrent writer may have moved on.
+    std::uint64_t total = 0;
+    for (const std::atomic<std::uint64_t>& bucket : buckets_) {
+        total += bucket.load(std::memory_order_relaxed);
+    }
+    if (total == 0) {
+        return std::chrono::nanoseconds{0};
+    }
+    const double clamped = std::clamp(q, 0.0, 1.0);
+    const std::uint64_t rank = std::max<std::uint64_t>(1u, static_cast<std::uint64_t>(std::ceil(clamped * static_cast<double>(total))));
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < k_bucket_count; ++i) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return bucket_upper_bound(i);
+        }
+    }
+    return bucket_upper_bound(k_bucket_count - 1u);
+}
+
+const char* node_profiling_mode_name(node_profiling_mode mode) noexcept {
+    switch (mode) {
+        case node_profiling_mode::off:
+            return "off";
+        case node_profiling_mode::sampled:
+            return "sampled";
+        case node_profiling_mode::full:
+            return "full";
+    }
+    return "full";
+}
+
 void duration_stats::observe(std::chrono::nanoseconds sample, std::chrono::nanoseconds budget) {
     ++count;
     last = sample;
@@ -12,6 +122,124 @@ void duration_stats::observe(std::chrono::nanoseconds sample, std::chrono::nanos
     if (budget.count() > 0 && sample > budget) {
         ++over_budget_count;
     }
+    histogram.record(sample);
+}
+
+std::chrono::nanoseconds duration_stats::percentile(double q) const noexcept {
+    return std::min(histogram.quantile(q), max);
+}
+
+const char* ledger_category_name(ledger_category category) noexcept {
+    switch (category) {
+        case ledger_category::lisp_leaves:
+            return "lisp_leaves";
+        case ledger_category::native_leaves:
+            return "native_leaves";
+        case ledger_category::planner:
+            return "planner";
+        case ledger_category::vla_submit:
+            return "vla_submit";
+        case ledger_category::vla_poll:
+            return "vla_poll";
+        case ledger_category::scheduler:
+            return "scheduler";
+        case ledger_category::bb_write:
+            return "bb_write";
+        case ledger_category::events:
+            return "events";
+        case ledger_category::gc:
+            return "gc";
+        case ledger_category::other:
+            return "other";
+    }
+    return "other";
+}
+
+namespace {
+
+thread_local tick_ledger* t_current_ledger = nullptr;
+
+std::uint64_t elapsed_ns(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) noexcept {
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count();
+    return ns > 0 ? static_cast<std::uint64_t>(ns) : 0u;
+}
+
+}  // namespace
+
+tick_ledger::~tick_ledger() {
+    if (t_current_ledger == this) {
+        t_current_ledger = outer_;
+    }
+}
+
+void tick_ledger::start(const clock_interface& clock, const muslisp::gc* heap) noexcept {
+    clock_ = &clock;
+    heap_ = heap;
+    sample_ = tick_ledger_sample{};
+    open_ = k_none;
+    pause_ns_ = heap_ ? heap_->total_pause_ns() : 0u;
+    started_at_ = clock_->now();
+    since_ = started_at_;
+    outer_ = t_current_ledger;
+    t_current_ledger = this;
+}
+
+void tick_ledger::charge() noexcept {
+    const auto now = clock_->now();
+    std::uint64_t spent = elapsed_ns(since_, now);
+    since_ = now;
+    if (heap_) {
+        const std::uint64_t pause_ns = heap_->total_pause_ns();
+        const std::uint64_t paused = std::min(pause_ns - pause_ns_, spent);
+        pause_ns_ = pause_ns;
+        sample_.ns[static_cast<std::size_t>(ledger_category::gc)] += paused;
+        spent -= paused;
+    }
+    if (open_ != k_none) {
+        sample_.ns[open_] += spent;
+    }
+}
+
+tick_ledger_sample tick_ledger::finish() noexcept {
+    charge();
+    open_ = k_none;
+    sample_.wall_ns = elapsed_ns(started_at_, since_);
+    std::uint64_t claimed = 0;
+    for (std::size_t i = 0; i + 1 < k_ledger_category_count; ++i) {
+        claimed += sample_.ns[i];
+    }
+    sample_.ns[static_cast<std::size_t>(ledger_category::other)] = sample_.wall_ns > claimed ? sample_.wall_ns - claimed : 0u;
+    if (t_current_ledger == this) {
+        t_current_ledger = outer_;
+    }
+    return sample_;
+}
+
+std::uint8_t tick_ledger::enter(ledger_category category) noexcept {
+    charge();
+    const std::uint8_t previous = open_;
+    open_ = static_cast<std::uint8_t>(category);
+    return previous;
+}
+
+void tick_ledger::leave(std::uint8_t previous) noexcept {
+    charge();
+    open_ = previous;
+}
+
+tick_ledger* tick_ledger::current() noexcept {
+    return t_current_ledger;
+}
+
+void tick_ledger_stats::observe(const tick_ledger_sample& sample) noexcept {
+    ++ticks;
+    for (std::size_t i = 0; i < k_ledger_category_count; ++i) {
+        const std::uint64_t ns = sample.ns[i];
+        total_ns[i] += ns;
+        max_ns[i] = std::max(max_ns[i], ns);
+        recent_ns[i] = ticks == 1 ? static_cast<double>(ns)
+                                  : recent_ns[i] + k_recent_alpha * (static_cast<double>(ns) - recent_ns[i]);
+    }
 }
 
 }  // namespace bt
@@ -0,0 +1,129 @@
+#include "bt/profile_clock.hpp"
+
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define MUESLI_BT_HAS_RDTSC 1
+#endif
+
+#if defined(__linux__)
+#include <time.h>
+#endif
+
+namespace bt {
+namespace {
+
+bool invariant_tsc_available() noexcept {
+#if defined(MUESLI_BT_HAS_RDTSC)
+    unsigned eax = 0;
+    unsigned ebx = 0;
+    unsigned ecx = 0;
+    unsigned edx = 0;
+    if (__get_cpuid(0x80000000u, &eax, &ebx, &ecx, &edx) == 0 || eax < 0x80000007u) {
+        return false;
+    }
+    if (__get_cpuid(0x80000007u, &eax, &ebx, &ecx, &edx) == 0) {
+        return false;
+    }
+    return (edx & (1u << 8)) != 0u;
+#else
+    return false;
+#endif
+}
+
+bool monotonic_raw_available() noexcept {
+#if defined(__linux__) && defined(CLOCK_MONOTONIC_RAW)
+    timespec ts{};
+    return clock_gettime(CLOCK_MONOTONIC_RAW, &ts) == 0;
+#else
+    return false;
+#endif
+}
+
+}  // namespace
+
+profile_clock::profile_clock(source preferred) {
+    source_ = preferred;
+    if (source_ == source::tsc && !invariant_tsc_available()) {
+        source_ = source::monotonic_raw;
+    }
+    if (source_ == source::monotonic_raw && !monotonic_raw_available()) {
+        source_ = source::steady;
+    }
+
+    if (source_ == source::tsc) {
+        const auto steady_start = std::chrono::steady_clock::now();
+        const std::uint64_t counter_start = read_counter();
+        auto steady_end = steady_start;
+        while (steady_end - steady_start < std::chrono::milliseconds(2)) {
+            std::this_thread::yield();
+            steady_end = std::chrono::steady_clock::now();
+        }
+        const std::uint64_t counter_end = read_counter();
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(steady_end - steady_start).count();
+        if (counter_end > counter_start && elapsed > 0) {
+            ticks_per_ns_ = static_cast<double>(counter_end - counter_start) / static_cast<double>(elapsed);
+            ns_per_tick_ = 1.0 / ticks_per_ns_;
+        } else {
+            source_ = monotonic_raw_available() ? source::monotonic_raw : source::steady;
+        }
+    }
+
+    counter_base_ = read_counter();
+    steady_base_ = std::chrono::steady_clock::now();
+}
+
+std::uint64_t profile_clock::read_counter() const noexcept {
+    switch (source_) {
+        case source::tsc:
+#if defined(MUESLI_BT_HAS_RDTSC)
+            return __rdtsc();
+#else
+            break;
+#endif
+        case source::monotonic_raw: {
+#if defined(__linux__) && defined(CLOCK_MONOTONIC_RAW)
+            timespec ts{};
+            clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+            return static_cast<std::uint64_t>(ts.tv_sec) * 1'000'000'000u + static_cast<std::uint64_t>(ts.tv_nsec);
+#else
+            break;
+#endif
+        }
+        case source::steady:
+            break;
+    }
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+std::chrono::steady_clock::time_point profile_clock::now() const {
+    if (source_ == source::steady) {
+        return std::chrono::steady_clock::now();
+    }
+    const std::uint64_t ticks = read_counter() - counter_base_;
+    const auto ns = source_ == source::tsc ? static_cast<std::int64_t>(static_cast<double>(ticks) * ns_per_tick_)
+                                           : static_cast<std::int64_t>(ticks);
+    return steady_base_ + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(ns));
+}
+
+const profile_clock& profile_clock::shared() {
+    static const profile_clock clock;
+    return clock;
+}
+
+const char* profile_clock_source_name(profile_clock::source src) noexcept {
+    switch (src) {
+        case profile_clock::source::tsc:
+            return "tsc";
+        case profile_clock::source::monotonic_raw:
+            return "monotonic_raw";
+        case profile_clock::source::steady:
+            return "steady";
+    }
+    return "steady";
+}
+
+}  // namespace bt
@@ -1,39 +1,144 @@
 #include "bt/registry.hpp"
 
+#include <atomic>
+
 namespace bt {
 
-void registry::register_condition(std::string name, condition_fn fn) {
-    conditions_[std::move(name)] = std::move(fn);
+namespace {
+
+// Generations are unique across registries, so a binding made against one registry never looks
+// current for another one (or for a new registry constructed at the same address).
+std::uint64_t next_generation() noexcept {
+    static std::atomic<std::uint64_t> counter{0};
+    return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+bool decode_native_arg(native_arg_type type, const arg_value& arg, native_arg& out) {
+    switch (type) {
+        case native_arg_type::integer:
+            if (arg.kind != arg_kind::integer) {
+                return false;
+            }
+            out.int_v = arg.int_v;
+            return true;
+        case native_arg_type::floating:
+            if (arg.kind == arg_kind::floating) {
+                out.float_v = arg.float_v;
+                return true;
+            }
+            if (arg.kind == arg_kind::integer) {
+                out.float_v = static_cast<double>(arg.int_v);
+                return true;
+            }
+            return false;
+        case native_arg_type::boolean:
+            if (arg.kind != arg_kind::boolean) {
+                return false;
+            }
+            out.bool_v = arg.bool_v;
+            return true;
+        case native_arg_type::text:
+            if (arg.kind != arg_kind::string && arg.kind != arg_kind::symbol) {
+                return false;
+            }
+            out.text = arg.text;
+            return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+registry::registry() : generation_(next_generation()) {}
+
+void registry::register_condition(std::string name, condition_fn fn, std::optional<condition_reads> reads) {
+    condition_entry entry;
+    entry.fn = std::move(fn);
+    entry.reads = std::move(reads);
+    set_condition(std::move(name), std::move(entry));
 }
 
 void registry::register_action(std::string name, action_fn fn, action_halt_fn halt_fn) {
-    if (halt_fn) {
-        action_halts_[name] = std::move(halt_fn);
+    action_entry entry;
+    entry.fn = std::move(fn);
+    entry.halt = std::move(halt_fn);
+    set_action(std::move(name), std::move(entry));
+}
+
+void registry::register_coroutine_action(std::string name, coroutine_action_fn fn) {
+    action_entry entry;
+    entry.coroutine = std::move(fn);
+    set_action(std::move(name), std::move(entry));
+}
+
+void registry::set_condition(std::string name, condition_entry entry) {
+    if (const auto it = condition_indices_.find(name); it != condition_indices_.end()) {
+        conditions_[it->second] = std::move(entry);
     } else {
-        action_halts_.erase(name);
+        condition_indices_.emplace(std::move(name), static_cast<std::uint32_t>(conditions_.size()));
+        conditions_.push_back(std::move(entry));
     }
-    actions_[std::move(name)] = std::move(fn);
+    generation_ = next_generation();
+}
+
+void registry::set_action(std::string name, action_entry entry) {
+    if (const auto it = action_indices_.find(name); it != action_indices_.end()) {
+        actions_[it->second] = std::move(entry);
+    } else {
+        action_indices_.emplace(std::move(name), static_cast<std::uint32_t>(actions_.size()));
+        actions_.push_back(std::move(entry));
+    }
+    generation_ = next_generation();
+}
+
+std::uint32_t registry::condition_index(std::string_view name) const {
+    const auto it = condition_indices_.find(name);
+    return it == condition_indices_.end() ? k_unbound : it->second;
+}
+
+std::uint32_t registry::action_index(std::string_view name) const {
+    const auto it = action_indices_.find(name);
+    return it == action_indices_.end() ? k_unbound : it->second;
 }
 
 const condition_fn* registry::find_condition(std::string_view name) const {
-    const auto it = conditions_.find(std::string(name));
-    return it == conditions_.end() ? nullptr : &it->second;
+    const std::uint32_t index = condition_index(name);
+    return index == k_unbound || !conditions_[index].fn ? nullptr : &conditions_[index].fn;
 }
 
 const action_fn* registry::find_action(std::string_view name) const {
-    const auto it = actions_.find(std::string(name));
-    return it == actions_.end() ? nullptr : &it->second;
+    const std::uint32_t index = action_index(name);
+    return index == k_unbound || !actions_[index].fn ? nullptr : &actions_[index].fn;
 }
 
 const action_halt_fn* registry::find_action_halt(std::string_view name) const {
-    const auto it = action_halts_.find(std::string(name));
-    return it == action_halts_.end() ? nullptr : &it->second;
+    const std::uint32_t index = action_index(name);
+    return index == k_unbound ? nullptr : action_halt_at(index);
+}
+
+bool registry::decode_native_args(std::span<const native_arg_type> signature,
+                                  const std::vector<arg_value>& args,
+                                  std::vector<native_arg>& out) {
+    if (signature.size() != args.size()) {
+        return false;
+    }
+    const std::size_t base = out.size();
+    out.resize(base + args.size());
+    for (std::size_t i = 0; i < args.size(); ++i) {
+        if (!decode_native_arg(signature[i], args[i], out[base + i])) {
+            out.resize(base);
+            return false;
+        }
+    }
+    return true;
 }
 
 void registry::clear() {
     conditions_.clear();
     actions_.clear();
-    action_halts_.clear();
+    condition_indices_.clear();
+    action_indices_.clear();
+    generation_ = next_generation();
 }
 
 }  // namespace bt
@@ -0,0 +1,342 @@
+#include "bt/replay_store.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace bt {
+namespace {
+
+constexpr char k_magic[8] = {'M', 'B', 'T', 'R', 'P', 'I', 'D', 'X'};
+constexpr std::uint32_t k_version = 1;
+
+struct index_header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t reserved;
+    std::uint64_t count;
+};
+static_assert(sizeof(index_header) == 24);
+
+constexpr const char* k_payload_file = "replay.payload";
+constexpr const char* k_index_file = "replay.index";
+constexpr const char* k_journal_file = "replay.journal";
+
+[[noreturn]] void throw_io(const std::string& what, const std::filesystem::path& path) {
+    throw std::runtime_error("replay store: " + what + " " + path.string() + ": " + std::strerror(errno));
+}
+
+#if !defined(_WIN32)
+
+void write_all(int fd, const void* data, std::size_t size, const std::filesystem::path& path) {
+    const auto* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        const ssize_t n = ::write(fd, bytes, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw_io("write failed for", path);
+        }
+        bytes += n;
+        size -= static_cast<std::size_t>(n);
+    }
+}
+
+void pwrite_all(int fd, const void* data, std::size_t size, std::uint64_t offset, const std::filesystem::path& path) {
+    const auto* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        const ssize_t n = ::pwrite(fd, bytes, size, static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw_io("write failed for", path);
+        }
+        bytes += n;
+        size -= static_cast<std::size_t>(n);
+        offset += static_cast<std::uint64_t>(n);
+    }
+}
+
+std::uint64_t file_size(int fd, const std::filesystem::path& path) {
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) {
+        throw_io("cannot stat", path);
+    }
+    return static_cast<std::uint64_t>(st.st_size);
+}
+
+#endif
+
+}  // namespace
+
+replay_store::replay_store(std::filesystem::path directory) : directory_(std::move(directory)) {}
+
+#if defined(_WIN32)
+
+std::shared_ptr<replay_store> replay_store::open(std::filesystem::path) {
+    throw std::runtime_error("replay store: memory-mapped files are not supported on this platform");
+}
+
+replay_store::~replay_store() = default;
+
+void replay_store::put(std::uint64_t, std::string_view) {
+    throw std::runtime_error("replay store: memory-mapped files are not supported on this platform");
+}
+
+std::string replay_store::read_payload(const entry&) const {
+    return {};
+}
+
+void replay_store::map_index() {}
+
+void replay_store::map_payload() {}
+
+void replay_store::unmap() noexcept {}
+
+void replay_store::compact_locked() {}
+
+#else
+
+std::shared_ptr<replay_store> replay_store::open(std::filesystem::path directory) {
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if (ec) {
+        throw std::runtime_error("replay store: cannot create " + directory.string() + ": " + ec.message());
+    }
+    std::shared_ptr<replay_store> store(new replay_store(std::move(directory)));
+
+    const std::filesystem::path payload_path = store->directory_ / k_payload_file;
+    store->payload_fd_ = ::open(payload_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (store->payload_fd_ < 0) {
+        throw_io("cannot open", payload_path);
+    }
+    store->payload_end_ = file_size(store->payload_fd_, payload_path);
+
+    const std::filesystem::path journal_path = store->directory_ / k_journal_file;
+    store->journal_fd_ = ::open(journal_path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (store->journal_fd_ < 0) {
+        throw_io("cannot open", journal_path);
+    }
+
+    store->map_index();
+    store->map_payload();
+
+    // A partial trailing entry is a torn append; entries past the payload cannot be served.
+    const std::uint64_t journal_bytes = file_size(store->journal_fd_, journal_path);
+    std::vector<entry> entries(static_cast<std::size_t>(journal_bytes / sizeof(entry)));
+    if (!entries.empty()) {
+        const std::size_t want = entries.size() * sizeof(entry);
+        if (::pread(store->journal_fd_, entries.data(), want, 0) != static_cast<ssize_t>(want)) {
+            throw_io("cannot read", journal_path);
+        }
+    }
+    for (const entry& e : entries) {
+        if (e.offset + e.size <= store->payload_end_) {
+            store->journal_[e.key] = e;
+        }
+    }
+    return store;
+}
+
+replay_store::~replay_store() {
+    unmap();
+    if (payload_fd_ >= 0) {
+        (void)::close(payload_fd_);
+    }
+    if (journal_fd_ >= 0) {
+        (void)::close(journal_fd_);
+    }
+}
+
+void replay_store::map_index() {
+    const std::filesystem::path path = directory_ / k_index_file;
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno == ENOENT) {
+            return;
+        }
+        throw_io("cannot open", path);
+    }
+    const std::uint64_t bytes = file_size(fd, path);
+    if (bytes < sizeof(index_header)) {
+        (void)::close(fd);
+        throw std::runtime_error("replay store: " + path.string() + " is too small to be a replay index");
+    }
+    void* base = ::mmap(nullptr, static_cast<std::size_t>(bytes), PROT_READ, MAP_SHARED, fd, 0);
+    (void)::close(fd);
+    if (base == MAP_FAILED) {
+        throw_io("cannot map", path);
+    }
+    const auto* header = static_cast<const index_header*>(base);
+    if (std::memcmp(header->magic, k_magic, sizeof(k_magic)) != 0 || header->version != k_version ||
+        bytes < sizeof(index_header) + header->count * sizeof(entry)) {
+        (void)::munmap(base, static_cast<std::size_t>(bytes));
+        throw std::runtime_error("replay store: " + path.string() + " is not a version 1 replay index");
+    }
+    index_base_ = base;
+    index_bytes_ = static_cast<std::size_t>(bytes);
+    index_entries_ = reinterpret_cast<const entry*>(static_cast<const char*>(base) + sizeof(index_header));
+    index_count_ = static_cast<std::size_t>(header->count);
+}
+
+void replay_store::map_payload() {
+    if (payload_end_ == 0) {
+        return;
+    }
+    void* base = ::mmap(nullptr, static_cast<std::size_t>(payload_end_), PROT_READ, MAP_SHARED, payload_fd_, 0);
+    if (base == MAP_FAILED) {
+        throw_io("cannot map", directory_ / k_payload_file);
+    }
+    payload_base_ = base;
+    payload_mapped_ = static_cast<std::size_t>(payload_end_);
+}
+
+void replay_store::unmap() noexcept {
+    if (index_base_ != nullptr) {
+        (void)::munmap(index_base_, index_bytes_);
+    }
+    if (payload_base_ != nullptr) {
+        (void)::munmap(payload_base_, payload_mapped_);
+    }
+    index_base_ = nullptr;
+    index_bytes_ = 0;
+    index_entries_ = nullptr;
+    index_count_ = 0;
+    payload_base_ = nullptr;
+    payload_mapped_ = 0;
+}
+
+std::string replay_store::read_payload(const entry& e) const {
+    if (e.size == 0) {
+        return {};
+    }
+    if (e.offset + e.size <= payload_mapped_) {
+        return std::string(static_cast<const char*>(payload_base_) + e.offset, static_cast<std::size_t>(e.size));
+    }
+    // Appended after the payload was mapped.
+    std::string out(static_cast<std::size_t>(e.size), '\0');
+    std::size_t done = 0;
+    while (done < out.size()) {
+        const ssize_t n = ::pread(payload_fd_, out.data() + done, out.size() - done, static_cast<off_t>(e.offset + done));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            throw_io("cannot read", directory_ / k_payload_file);
+        }
+        done += static_cast<std::size_t>(n);
+    }
+    return out;
+}
+
+void replay_store::put(std::uint64_t key, std::string_view payload) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const entry e{.key = key, .offset = payload_end_, .size = payload.size()};
+    pwrite_all(payload_fd_, payload.data(), payload.size(), e.offset, directory_ / k_payload_file);
+    payload_end_ += payload.size();
+    write_all(journal_fd_, &e, sizeof(e), directory_ / k_journal_file);
+    journal_[key] = e;
+    if (journal_.size() >= k_compact_threshold) {
+        compact_locked();
+    }
+}
+
+void replay_store::compact_locked() {
+    std::vector<entry> merged;
+    merged.reserve(index_count_ + journal_.size());
+    for (std::size_t i = 0; i < index_count_; ++i) {
+        if (journal_.find(index_entries_[i].key) == journal_.end()) {
+            merged.push_back(index_entries_[i]);
+        }
+    }
+    for (const auto& [_, e] : journal_) {
+        merged.push_back(e);
+    }
+    std::sort(merged.begin(), merged.end(), [](const entry& a, const entry& b) { return a.key < b.key; });
+
+    index_header header{};
+    std::memcpy(header.magic, k_magic, sizeof(k_magic));
+    header.version = k_version;
+    header.count = merged.size();
+
+    const std::filesystem::path path = directory_ / k_index_file;
+    std::filesystem::path tmp = path;
+    tmp += ".tmp";
+    const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw_io("cannot open", tmp);
+    }
+    try {
+        write_all(fd, &header, sizeof(header), tmp);
+        write_all(fd, merged.data(), merged.size() * sizeof(entry), tmp);
+    } catch (...) {
+        (void)::close(fd);
+        throw;
+    }
+    (void)::fsync(fd);
+    (void)::close(fd);
+    (void)::fsync(payload_fd_);
+    if (::rename(tmp.c_str(), path.c_str()) != 0) {
+        throw_io("cannot replace", path);
+    }
+    if (::ftruncate(journal_fd_, 0) != 0) {
+        throw_io("cannot truncate", directory_ / k_journal_file);
+    }
+    journal_.clear();
+
+    unmap();
+    map_index();
+    map_payload();
+}
+
+#endif
+
+const replay_store::entry* replay_store::index_find(std::uint64_t key) const noexcept {
+    const entry* end = index_entries_ + index_count_;
+    const entry* it =
+        std::lower_bound(index_entries_, end, key, [](const entry& e, std::uint64_t k) { return e.key < k; });
+    return (it != end && it->key == key) ? it : nullptr;
+}
+
+std::optional<std::string> replay_store::find(std::uint64_t key) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (const auto it = journal_.find(key); it != journal_.end()) {
+        return read_payload(it->second);
+    }
+    if (const entry* e = index_find(key); e != nullptr) {
+        return read_payload(*e);
+    }
+    return std::nullopt;
+}
+
+void replay_store::compact() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!journal_.empty()) {
+        compact_locked();
+    }
+}
+
+std::size_t replay_store::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t out = index_count_;
+    for (const auto& [key, _] : journal_) {
+        if (index_find(key) == nullptr) {
+            ++out;
+        }
+    }
+    return out;
+}
+
+}  // namespace bt
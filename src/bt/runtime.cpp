@@ -1,13 +1,26 @@
 #include "bt/runtime.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <bit>
+#include <charconv>
 #include <cmath>
+#include <functional>
+#include <initializer_list>
+#include <limits>
+#include <memory>
+#include <memory_resource>
 #include <optional>
 #include <sstream>
+#include <thread>
 #include <vector>
 
 #include "bt/blackboard.hpp"
+#include "bt/compiled_tree.hpp"
+#include "bt/log_replay.hpp"
+#include "bt/loop_pacer.hpp"
 #include "bt/planner.hpp"
+#include "bt/profile_clock.hpp"
 #include "bt/vla.hpp"
 #include "muesli_bt/contract/events.hpp"
 #include "muslisp/error.hpp"
@@ -23,8 +36,21 @@ trace_event make_trace_event(trace_event_kind kind) {
     return ev;
 }
 
+trace_record make_trace_record(trace_event_kind kind) {
+    trace_record rec{};
+    rec.kind = kind;
+    return rec;
+}
+
 std::string json_escape(std::string_view text);
 
+// Event payloads built during a tick are written into the ticking instance's arena.
+using scratch_ostream = std::basic_ostringstream<char, std::char_traits<char>, std::pmr::polymorphic_allocator<char>>;
+
+scratch_ostream scratch_stream(tick_context& ctx) {
+    return scratch_ostream(std::ios_base::out, &ctx.inst.arena);
+}
+
 std::int64_t ns_since_epoch(std::chrono::steady_clock::time_point tp) {
     return std::chrono::duration_cast<std::chrono::nanoseconds>(tp.time_since_epoch()).count();
 }
@@ -47,6 +73,13 @@ event_log* resolve_event_log(tick_context& ctx) {
     return ctx.svc.obs.events;
 }
 
+// The event log, if its emission policy wants a `family` event this tick. Checked before building
+// the payload so that suppressed events cost no serialisation.
+event_log* event_log_for(tick_context& ctx, event_family family, bool failure = false) {
+    event_log* events = ctx.svc.obs.events;
+    return events && events->wants(family, ctx.tick_index, failure) ? events : nullptr;
+}
+
 bool trace_capture_enabled(const tick_context& ctx) {
     return ctx.inst.trace_enabled;
 }
@@ -74,7 +107,12 @@ private:
     std::vector<node_id> stack_;
 };
 
-void emit_log(tick_context& ctx, log_level level, std::string category, std::string message);
+void emit_log(tick_context& ctx, log_level level, std::string_view category, std::string_view message);
+void emit_log_deferred(tick_context& ctx,
+                       log_level level,
+                       std::string_view category,
+                       const char* format,
+                       std::initializer_list<log_arg> args);
 
 std::optional<double> tick_budget_ms(const tick_context& ctx) {
     const auto configured = ctx.inst.tree_stats.configured_tick_budget;
@@ -101,11 +139,11 @@ void emit_budget_warning_event(tick_context& ctx,
                                double remaining_ms,
                                double threshold_ms,
                                std::string_view reason) {
-    event_log* events = resolve_event_log(ctx);
+    event_log* events = event_log_for(ctx, event_family::alert);
     if (!events) {
         return;
     }
-    std::ostringstream data;
+    scratch_ostream data = scratch_stream(ctx);
     data << "{\"decision_point\":\"" << event_log::json_escape(decision_point) << "\","
          << "\"remaining_ms\":" << remaining_ms << ','
          << "\"threshold_ms\":" << threshold_ms << ','
@@ -114,7 +152,7 @@ void emit_budget_warning_event(tick_context& ctx,
         data << ",\"node_id\":" << *node;
     }
     data << '}';
-    (void)events->emit(muesli_bt::contract::kEventBudgetWarning, ctx.tick_index, data.str());
+    (void)events->emit(muesli_bt::contract::kEventBudgetWarning, ctx.tick_index, data.view());
 }
 
 void emit_deadline_exceeded_event(tick_context& ctx,
@@ -122,11 +160,11 @@ void emit_deadline_exceeded_event(tick_context& ctx,
                                   std::string_view source,
                                   double tick_budget_ms_value,
                                   double tick_elapsed_ms_value) {
-    event_log* events = resolve_event_log(ctx);
+    event_log* events = event_log_for(ctx, event_family::alert);
     if (!events) {
         return;
     }
-    std::ostringstream data;
+    scratch_ostream data = scratch_stream(ctx);
     data << "{\"source\":\"" << event_log::json_escape(source) << "\","
          << "\"tick_budget_ms\":" << tick_budget_ms_value << ','
          << "\"tick_elapsed_ms\":" << tick_elapsed_ms_value;
@@ -134,7 +172,7 @@ void emit_deadline_exceeded_event(tick_context& ctx,
         data << ",\"node_id\":" << *node;
     }
     data << '}';
-    (void)events->emit(muesli_bt::contract::kEventDeadlineExceeded, ctx.tick_index, data.str());
+    (void)events->emit(muesli_bt::contract::kEventDeadlineExceeded, ctx.tick_index, data.view());
 }
 
 void emit_outcome_event(tick_context& ctx,
@@ -143,26 +181,24 @@ void emit_outcome_event(tick_context& ctx,
                         std::optional<node_id> node = std::nullopt,
                         std::optional<std::string_view> job = std::nullopt,
                         std::optional<std::string_view> reason = std::nullopt) {
-    event_log* events = resolve_event_log(ctx);
+    event_log* events = event_log_for(ctx, event_log::family_of(type));
     if (!events) {
         return;
     }
     event_log_allocation_scope allocation_scope(events);
-    std::ostringstream data;
-    data << "{\"schema_version\":\"runtime_outcome.v1\","
-         << "\"outcome\":\"" << event_log::json_escape(type) << "\","
-         << "\"source\":\"" << event_log::json_escape(source) << "\"";
+    json_writer& data = event_log::payload_writer();
+    data.begin_object().field("schema_version", "runtime_outcome.v1").field("outcome", type).field("source", source);
     if (node.has_value()) {
-        data << ",\"node_id\":" << *node;
+        data.field("node_id", *node);
     }
     if (job.has_value()) {
-        data << ",\"job_id\":\"" << event_log::json_escape(*job) << "\"";
+        data.field("job_id", *job);
     }
     if (reason.has_value()) {
-        data << ",\"reason\":\"" << event_log::json_escape(*reason) << "\"";
+        data.field("reason", *reason);
     }
-    data << '}';
-    (void)events->emit(type, ctx.tick_index, data.str());
+    data.end_object();
+    (void)events->emit(type, ctx.tick_index, data);
 }
 
 bool budget_allows_decision_point(tick_context& ctx, node_id node, std::string_view decision_point, double threshold_ms = 0.25) {
@@ -174,17 +210,14 @@ bool budget_allows_decision_point(tick_context& ctx, node_id node, std::string_v
         return true;
     }
     emit_budget_warning_event(ctx, decision_point, node, *remaining, threshold_ms, "insufficient_budget");
-    emit_log(ctx,
-             log_level::warn,
-             "bt",
-             std::string("budget blocked decision point: ") + std::string(decision_point) + " node=" + std::to_string(node));
+    emit_log_deferred(ctx,
+                      log_level::warn,
+                      "bt",
+                      "budget blocked decision point: {} node={}",
+                      {decision_point, static_cast<std::uint64_t>(node)});
     return false;
 }
 
-std::string status_json(status st) {
-    return std::string("\"") + status_name(st) + "\"";
-}
-
 const char* event_log_sink_name(const event_log& events) {
     const bool enabled = events.enabled();
     if (!enabled) {
@@ -220,15 +253,21 @@ const char* event_log_flush_policy_name(const event_log& events) {
     return "manual";
 }
 
-void append_node_path_json(std::ostringstream& out, const std::vector<node_id>& path) {
-    out << '[';
-    for (std::size_t i = 0; i < path.size(); ++i) {
-        if (i != 0) {
-            out << ',';
-        }
-        out << path[i];
+void append_node_path_records(json_writer& out, const std::vector<node_path_record>& records, std::uint32_t at) {
+    const node_path_record& record = records[at];
+    if (record.parent != node_path_record::k_none) {
+        append_node_path_records(out, records, record.parent);
     }
-    out << ']';
+    out.value(record.node);
+}
+
+void append_node_path_json(json_writer& out, const tick_context& ctx) {
+    out.begin_array();
+    const std::uint32_t at = ctx.terminal_record != node_path_record::k_none ? ctx.terminal_record : ctx.node_path_top;
+    if (at != node_path_record::k_none) {
+        append_node_path_records(out, ctx.inst.node_path_records, at);
+    }
+    out.end_array();
 }
 
 std::int64_t signed_delta(std::size_t after, std::size_t before) {
@@ -242,8 +281,9 @@ void emit_tick_audit_event(tick_context& ctx,
                            double budget_ms,
                            bool deadline_missed,
                            const muslisp::gc_stats_snapshot& gc_start,
-                           const muslisp::gc_stats_snapshot& gc_end) {
-    event_log* events = resolve_event_log(ctx);
+                           const muslisp::gc_stats_snapshot& gc_end,
+                           const tick_ledger_sample* ledger) {
+    event_log* events = event_log_for(ctx, event_family::alert);
     if (!events || !events->tick_audit_enabled()) {
         return;
     }
@@ -270,7 +310,7 @@ void emit_tick_audit_event(tick_context& ctx,
     const bool strict_allocations = events->tick_audit_strict_allocations();
     const bool warmup_complete = events->tick_audit_warmup_complete();
 
-    std::string violation = "none";
+    std::string_view violation = "none";
     if (strict_allocations && warmup_complete && (allocation_count > 0 || allocation_bytes > 0)) {
         violation = "allocation";
     } else if (gc_collections_delta > 0) {
@@ -279,74 +319,144 @@ void emit_tick_audit_event(tick_context& ctx,
         violation = "deadline";
     }
 
-    std::ostringstream data;
-    data << "{\"schema_version\":\"tick_audit.v1\","
-         << "\"tick_id\":" << ctx.tick_index << ','
-         << "\"measurement_window\":\"tick_pre_begin_to_tick_end_pre_audit\","
-         << "\"allocation_count\":" << allocation_count << ','
-         << "\"allocation_bytes\":" << allocation_bytes << ','
-         << "\"heap_live_bytes_before\":" << gc_start.bytes_allocated << ','
-         << "\"heap_live_bytes_after\":" << gc_end.bytes_allocated << ','
-         << "\"heap_live_bytes_delta\":" << heap_live_bytes_delta << ','
-         << "\"gc_collections_delta\":" << gc_collections_delta << ','
-         << "\"gc_pause_ns_delta\":" << gc_pause_ns_delta << ','
-         << "\"gc_live_objects_after\":" << gc_end.live_objects_after_last_gc << ','
-         << "\"gc_freed_objects_delta\":" << gc_freed_objects_delta << ','
-         << "\"gc_forced\":" << (gc_forced_delta > 0 ? "true" : "false") << ','
-         << "\"root_node_id\":" << (ctx.inst.def ? ctx.inst.def->root : 0) << ','
-         << "\"root_status\":" << status_json(root_status) << ','
-         << "\"node_path\":";
-    append_node_path_json(data, ctx.last_node_path.empty() ? ctx.node_path : ctx.last_node_path);
+    json_writer& data = event_log::payload_writer();
+    data.begin_object()
+        .field("schema_version", "tick_audit.v1")
+        .field("tick_id", ctx.tick_index)
+        .field("measurement_window", "tick_pre_begin_to_tick_end_pre_audit")
+        .field("allocation_count", allocation_count)
+        .field("allocation_bytes", allocation_bytes)
+        .field("heap_live_bytes_before", gc_start.bytes_allocated)
+        .field("heap_live_bytes_after", gc_end.bytes_allocated)
+        .field("heap_live_bytes_delta", heap_live_bytes_delta)
+        .field("gc_collections_delta", gc_collections_delta)
+        .field("gc_pause_ns_delta", gc_pause_ns_delta)
+        .field("gc_live_objects_after", gc_end.live_objects_after_last_gc)
+        .field("gc_freed_objects_delta", gc_freed_objects_delta)
+        .field("gc_forced", gc_forced_delta > 0)
+        .field("root_node_id", ctx.inst.def ? ctx.inst.def->root : 0)
+        .field("root_status", status_name(root_status))
+        .key("node_path");
+    append_node_path_json(data, ctx);
     if (ctx.terminal_node_id.has_value()) {
-        data << ",\"terminal_node_id\":" << *ctx.terminal_node_id;
-    }
-    data << ",\"active_async_jobs\":" << ctx.inst.active_vla_jobs.size()
-         << ",\"planner_calls\":" << ctx.planner_calls << ",\"vla_submits\":" << ctx.vla_submits
-         << ",\"vla_polls\":" << ctx.vla_polls << ",\"fallback_used\":false"
-         << ",\"deadline_missed\":" << (deadline_missed ? "true" : "false");
+        data.field("terminal_node_id", *ctx.terminal_node_id);
+    }
+    if (!ctx.inst.node_alloc_records.empty()) {
+        data.key("allocating_nodes").begin_array();
+        for (const node_alloc_record& record : ctx.inst.node_alloc_records) {
+            data.begin_object()
+                .field("node_id", record.node)
+                .field("allocation_count", record.objects)
+                .field("allocation_bytes", record.bytes)
+                .end_object();
+        }
+        data.end_array();
+    }
+    data.field("active_async_jobs", ctx.inst.active_vla_jobs.size())
+        .field("planner_calls", ctx.planner_calls)
+        .field("vla_submits", ctx.vla_submits)
+        .field("vla_polls", ctx.vla_polls)
+        .field("fallback_used", false)
+        .field("deadline_missed", deadline_missed);
     if (configured_budget.count() > 0) {
-        data << ",\"tick_budget_ms\":" << budget_ms;
+        data.field("tick_budget_ms", budget_ms);
+    }
+    data.field("tick_elapsed_ns", elapsed.count()).field("violation", violation);
+    if (ledger) {
+        // Where the tick's wall time went, by subsystem; see bt::tick_ledger.
+        data.key("budget_ledger").begin_object().field("wall_ns", ledger->wall_ns);
+        for (std::size_t i = 0; i < k_ledger_category_count; ++i) {
+            if (ledger->ns[i] != 0) {
+                data.field(ledger_category_name(static_cast<ledger_category>(i)), ledger->ns[i]);
+            }
+        }
+        data.end_object();
     }
-    data << ",\"tick_elapsed_ns\":" << elapsed.count() << ",\"violation\":\"" << violation << "\",";
 
-    data << "\"logging_mode\":{\"enabled\":" << (events->enabled() ? "true" : "false")
-         << ",\"sink\":\"" << event_log_sink_name(*events) << "\","
-         << "\"flush_policy\":\"" << event_log_flush_policy_name(*events) << "\","
-         << "\"includes_canonical_events_in_window\":true";
+    data.key("logging_mode")
+        .begin_object()
+        .field("enabled", events->enabled())
+        .field("sink", event_log_sink_name(*events))
+        .field("flush_policy", event_log_flush_policy_name(*events))
+        .field("includes_canonical_events_in_window", true);
     if (events->ring_capacity() > 0) {
-        data << ",\"ring_size\":" << events->ring_capacity();
+        data.field("ring_size", events->ring_capacity());
     }
     if (events->file_enabled()) {
-        data << ",\"event_log_path\":\"" << event_log::json_escape(events->path()) << "\"";
-    }
-    data << "},\"audit_mode\":{\"enabled\":true,"
-         << "\"strict_allocations\":" << (strict_allocations ? "true" : "false") << ','
-         << "\"strict_gc\":" << (strict_gc ? "true" : "false") << ','
-         << "\"warmup_complete\":" << (warmup_complete ? "true" : "false") << ','
-         << "\"allowed_allocation_count\":0,"
-         << "\"allowed_allocation_bytes\":0,"
-         << "\"gc_policy\":\"" << muslisp::gc::policy_name(policy) << "\"}}";
-
-    (void)events->emit("tick_audit", ctx.tick_index, data.str());
+        data.field("event_log_path", events->path());
+    }
+    data.end_object()
+        .key("audit_mode")
+        .begin_object()
+        .field("enabled", true)
+        .field("strict_allocations", strict_allocations)
+        .field("strict_gc", strict_gc)
+        .field("warmup_complete", warmup_complete)
+        .field("allowed_allocation_count", 0)
+        .field("allowed_allocation_bytes", 0)
+        .field("gc_policy", muslisp::gc::policy_name(policy))
+        .end_object();
+    if (const loop_pacer* pacer = events->audit_loop_pacer()) {
+        data.key("loop_pacing");
+        pacer->write_json(data);
+    }
+    data.end_object();
+
+    (void)events->emit("tick_audit", ctx.tick_index, data);
 }
 
 void emit_event_error(tick_context& ctx,
                       std::string_view severity,
                       std::string_view component,
-                      std::string message,
+                      std::string_view message,
                       std::optional<node_id> node = std::nullopt) {
-    event_log* events = resolve_event_log(ctx);
+    event_log* events = event_log_for(ctx, event_family::alert);
     if (!events) {
         return;
     }
-    std::ostringstream data;
+    scratch_ostream data = scratch_stream(ctx);
     data << "{\"severity\":\"" << event_log::json_escape(severity) << "\",\"component\":\""
          << event_log::json_escape(component) << "\",";
     if (node.has_value()) {
         data << "\"node_id\":" << *node << ',';
     }
     data << "\"message\":\"" << event_log::json_escape(message) << "\"}";
-    (void)events->emit("error", ctx.tick_index, data.str());
+    (void)events->emit("error", ctx.tick_index, data.view());
+}
+
+void emit_trace(tick_context& ctx,
+                trace_record rec,
+                std::string_view key = {},
+                std::string_view value_repr = {},
+                std::string_view message = {}) {
+    if (!ctx.inst.trace_enabled) {
+        return;
+    }
+
+    trace_buffer* buffer = resolve_trace_buffer(ctx);
+    if (!buffer) {
+        return;
+    }
+
+    rec.tick_index = ctx.tick_index;
+    rec.ts = tick_now(ctx);
+    buffer->push(rec, key, value_repr, message);
+}
+
+// Blackboard values are captured unformatted; the trace formats them when it is read.
+void emit_trace_value(tick_context& ctx, trace_record rec, std::string_view key, const bb_value& value) {
+    if (!ctx.inst.trace_enabled) {
+        return;
+    }
+
+    trace_buffer* buffer = resolve_trace_buffer(ctx);
+    if (!buffer) {
+        return;
+    }
+
+    rec.tick_index = ctx.tick_index;
+    rec.ts = tick_now(ctx);
+    buffer->push_value(rec, key, value);
 }
 
 void emit_trace(tick_context& ctx, trace_event ev) {
@@ -361,24 +471,27 @@ void emit_trace(tick_context& ctx, trace_event ev) {
 
     ev.tick_index = ctx.tick_index;
     ev.ts = tick_now(ctx);
-    buffer->push(std::move(ev));
+    buffer->push(ev);
 }
 
-void emit_log(tick_context& ctx, log_level level, std::string category, std::string message) {
-    if (!ctx.svc.obs.logger) {
+// Writes a log message, and mirrors it as an "error" event when the event log is on. The sink's rate
+// limiter is asked first, so a suppressed message costs no formatting at all.
+void write_log(tick_context& ctx,
+               log_level level,
+               std::string_view category,
+               const char* format,
+               std::span<const log_arg> args) {
+    log_sink* logger = ctx.svc.obs.logger;
+    if (!logger) {
         return;
     }
-    log_record rec;
-    rec.ts = tick_now(ctx);
-    rec.level = level;
-    rec.tick_index = ctx.tick_index;
-    rec.node = ctx.current_node;
-    rec.category = std::move(category);
-    rec.message = std::move(message);
-    ctx.svc.obs.logger->write(rec);
+    const log_origin origin{.ts = tick_now(ctx), .level = level, .tick_index = ctx.tick_index, .node = ctx.current_node};
+    if (!logger->admit(origin, category)) {
+        return;
+    }
+    logger->write_deferred(origin, category, format, args);
 
-    event_log* events = resolve_event_log(ctx);
-    if (!events) {
+    if (!resolve_event_log(ctx)) {
         return;
     }
     const char* severity = "info";
@@ -389,21 +502,30 @@ void emit_log(tick_context& ctx, log_level level, std::string category, std::str
     } else if (level == log_level::error) {
         severity = "error";
     }
-    emit_event_error(ctx, severity, category, rec.message, ctx.current_node);
+    emit_event_error(ctx, severity, category, format_log_message(format, args), ctx.current_node);
+}
+
+void emit_log(tick_context& ctx, log_level level, std::string_view category, std::string_view message) {
+    const log_arg args[] = {message};
+    write_log(ctx, level, category, "{}", args);
+}
+
+// Like emit_log, but the message is only formatted from `format` (a string literal) and `args` when the
+// log is read, or when the event log needs it.
+void emit_log_deferred(tick_context& ctx,
+                       log_level level,
+                       std::string_view category,
+                       const char* format,
+                       std::initializer_list<log_arg> args) {
+    write_log(ctx, level, category, format, std::span<const log_arg>(args.begin(), args.size()));
 }
 
 node_profile_stats& node_stats_for(instance& inst, const node& n) {
-    auto it = inst.node_stats.find(n.id);
-    if (it == inst.node_stats.end()) {
-        node_profile_stats stats;
-        stats.id = n.id;
-        stats.name = n.leaf_name.empty() ? std::string("node-") + std::to_string(n.id) : n.leaf_name;
-        it = inst.node_stats.emplace(n.id, std::move(stats)).first;
-    }
-    return it->second;
+    return inst.node_stats[n.id];
 }
 
 node_memory& node_memory_for(instance& inst, node_id id) {
+    inst.touch_memory(id);
     return inst.memory[id];
 }
 
@@ -414,24 +536,6 @@ const node& get_node(const definition& def, node_id id) {
     return def.nodes[id];
 }
 
-muslisp::value materialize_arg(const arg_value& arg) {
-    switch (arg.kind) {
-        case arg_kind::nil:
-            return muslisp::make_nil();
-        case arg_kind::boolean:
-            return muslisp::make_boolean(arg.bool_v);
-        case arg_kind::integer:
-            return muslisp::make_integer(arg.int_v);
-        case arg_kind::floating:
-            return muslisp::make_float(arg.float_v);
-        case arg_kind::symbol:
-            return muslisp::make_symbol(arg.text);
-        case arg_kind::string:
-            return muslisp::make_string(arg.text);
-    }
-    return muslisp::make_nil();
-}
-
 std::string normalize_plan_option(std::string key) {
     if (!key.empty() && key.front() == ':') {
         key.erase(key.begin());
@@ -471,6 +575,13 @@ double arg_as_number(const muslisp::value& v, const std::string& where) {
     throw bt_runtime_error(where + ": expected numeric value");
 }
 
+bool arg_as_bool(const muslisp::value& v, const std::string& where) {
+    if (!muslisp::is_boolean(v)) {
+        throw bt_runtime_error(where + ": expected boolean value");
+    }
+    return muslisp::boolean_value(v);
+}
+
 planner_vector state_from_blackboard(const bb_value& value, const std::string& where) {
     if (const std::int64_t* i = std::get_if<std::int64_t>(&value)) {
         return {static_cast<double>(*i)};
@@ -478,8 +589,8 @@ planner_vector state_from_blackboard(const bb_value& value, const std::string& w
     if (const double* f = std::get_if<double>(&value)) {
         return {*f};
     }
-    if (const planner_vector* vec = std::get_if<planner_vector>(&value)) {
-        return *vec;
+    if (const bb_vector* vec = std::get_if<bb_vector>(&value)) {
+        return planner_vector(vec->begin(), vec->end());
     }
     throw bt_runtime_error(where + ": state must be int, float, or float vector");
 }
@@ -507,7 +618,26 @@ bb_value action_to_blackboard(const planner_action& action) {
     if (action.u.size() == 1) {
         return bb_value{action.u[0]};
     }
-    return bb_value{action.u};
+    return bb_value{bb_vector(std::span<const double>(action.u))};
+}
+
+// The shortest text that reads back as the same double, so logged values replay exactly. With
+// `mark_float`, integral values get a ".0" so a reader can tell them from integers. Non-finite
+// values are written as Python's json module writes them.
+std::string json_double(double v, bool mark_float) {
+    if (std::isnan(v)) {
+        return "NaN";
+    }
+    if (std::isinf(v)) {
+        return v < 0.0 ? "-Infinity" : "Infinity";
+    }
+    char buffer[32];
+    const auto [ptr, ec] = std::to_chars(buffer, buffer + sizeof(buffer), v);
+    std::string out(buffer, ec == std::errc{} ? ptr : buffer);
+    if (mark_float && out.find_first_of(".e") == std::string::npos) {
+        out += ".0";
+    }
+    return out;
 }
 
 std::string bb_value_json(const bb_value& value) {
@@ -521,19 +651,17 @@ std::string bb_value_json(const bb_value& value) {
             } else if constexpr (std::is_same_v<T, std::int64_t>) {
                 return std::to_string(v);
             } else if constexpr (std::is_same_v<T, double>) {
-                std::ostringstream out;
-                out << v;
-                return out.str();
+                return json_double(v, true);
             } else if constexpr (std::is_same_v<T, std::string>) {
                 return "\"" + event_log::json_escape(v) + "\"";
-            } else if constexpr (std::is_same_v<T, std::vector<double>>) {
+            } else if constexpr (std::is_same_v<T, bb_vector>) {
                 std::ostringstream out;
                 out << '[';
                 for (std::size_t i = 0; i < v.size(); ++i) {
                     if (i != 0) {
                         out << ',';
                     }
-                    out << v[i];
+                    out << json_double(v[i], false);
                 }
                 out << ']';
                 return out.str();
@@ -548,6 +676,66 @@ std::string bb_value_json(const bb_value& value) {
         value);
 }
 
+// Opens the tick's blackboard stream for replay: a `bb_snapshot` keyframe when the log's keyframe
+// epoch moved or `keyframe_every` ticks have passed, otherwise a `bb_delta` of the journalled slots
+// (nothing when no slot was written). Either way the journal starts over.
+void emit_bb_journal(event_log& events, instance& inst, std::uint64_t keyframe_every) {
+    blackboard& bb = inst.bb;
+    const std::uint64_t epoch = events.bb_keyframe_epoch();
+    const bool keyframe = inst.bb_keyframe_epoch != epoch || inst.tick_index - inst.bb_keyframe_tick >= keyframe_every;
+    if (!keyframe && bb.journal().empty()) {
+        return;
+    }
+
+    event_log_allocation_scope allocation_scope(&events);
+    json_writer& data = event_log::payload_writer();
+    data.begin_object();
+    if (keyframe) {
+        data.field("keyframe", true);
+        data.key("entries").begin_array();
+        for (const auto& [key, entry] : bb.snapshot()) {
+            if (!std::holds_alternative<std::monostate>(entry.value)) {
+                data.begin_array().value(key).raw(bb_value_json(entry.value)).end_array();
+            }
+        }
+        data.end_array();
+    } else {
+        // A nil write is a delete, as for bb_delete.
+        const auto live = [&bb](bb_slot slot) -> const bb_entry* {
+            const bb_entry* entry = bb.get(slot);
+            return entry && !std::holds_alternative<std::monostate>(entry->value) ? entry : nullptr;
+        };
+        data.field("base_tick", inst.bb_journal_tick);
+        data.key("set").begin_array();
+        for (const bb_slot slot : bb.journal()) {
+            if (const bb_entry* entry = live(slot)) {
+                data.begin_array()
+                    .value(bb.key_name(slot))
+                    .raw(bb_value_json(entry->value))
+                    .value(entry->last_write_tick)
+                    .end_array();
+            }
+        }
+        data.end_array();
+        data.key("deleted").begin_array();
+        for (const bb_slot slot : bb.journal()) {
+            if (!live(slot)) {
+                data.value(bb.key_name(slot));
+            }
+        }
+        data.end_array();
+    }
+    data.end_object();
+    (void)events.emit(keyframe ? "bb_snapshot" : "bb_delta", inst.tick_index, data);
+
+    bb.reset_journal();
+    inst.bb_journal_tick = inst.tick_index;
+    if (keyframe) {
+        inst.bb_keyframe_epoch = epoch;
+        inst.bb_keyframe_tick = inst.tick_index;
+    }
+}
+
 std::string bb_preview_json(const bb_value& value) {
     constexpr std::size_t kMaxPreviewBytes = 4096;
     const std::string preview = bb_value_json(value);
@@ -565,7 +753,12 @@ std::string plan_meta_to_json(const planner_result& result, const planner_reques
         << "\"planner\":\"" << planner_backend_name(result.planner) << "\","
         << "\"status\":\"" << planner_status_name(result.status) << "\","
         << "\"tick_index\":" << request.tick_index << ',' << "\"seed\":" << request.seed << ','
-        << "\"budget_ms\":" << result.stats.budget_ms << ',' << "\"time_used_ms\":" << result.stats.time_used_ms << ','
+        << "\"budget_ms\":" << result.stats.budget_ms << ',';
+    if (result.stats.budget_choice.adaptive) {
+        out << "\"budget_mode\":\"adaptive\",\"budget_slack_ms\":" << result.stats.budget_choice.slack_ms
+            << ",\"budget_margin_ms\":" << result.stats.budget_choice.margin_ms << ',';
+    }
+    out << "\"time_used_ms\":" << result.stats.time_used_ms << ','
         << "\"work_done\":" << result.stats.work_done << ',' << "\"confidence\":" << result.confidence << ','
         << "\"action\":{\"action_schema\":\"" << json_escape(result.action.action_schema) << "\",\"u\":[";
     for (std::size_t i = 0; i < result.action.u.size(); ++i) {
@@ -579,7 +772,8 @@ std::string plan_meta_to_json(const planner_result& result, const planner_reques
     if (result.planner == planner_backend::mcts && result.trace.mcts.available) {
         out << ",\"trace\":{\"root_visits\":" << result.trace.mcts.root_visits
             << ",\"root_children\":" << result.trace.mcts.root_children
-            << ",\"widen_added\":" << result.trace.mcts.widen_added;
+            << ",\"widen_added\":" << result.trace.mcts.widen_added
+            << ",\"reused_visits\":" << result.trace.mcts.reused_visits;
         if (!result.trace.mcts.top_k.empty()) {
             out << ",\"top_k\":[";
             for (std::size_t i = 0; i < result.trace.mcts.top_k.size(); ++i) {
@@ -623,7 +817,9 @@ std::string plan_meta_to_json(const planner_result& result, const planner_reques
         out << '}';
     } else if (result.planner == planner_backend::ilqr && result.trace.ilqr.available) {
         out << ",\"trace\":{\"iters\":" << result.trace.ilqr.iters << ",\"cost_init\":" << result.trace.ilqr.cost_init
-            << ",\"cost_final\":" << result.trace.ilqr.cost_final << ",\"reg_final\":" << result.trace.ilqr.reg_final << '}';
+            << ",\"cost_final\":" << result.trace.ilqr.cost_final << ",\"reg_final\":" << result.trace.ilqr.reg_final
+            << ",\"warm_started\":" << (result.trace.ilqr.warm_started ? "true" : "false")
+            << ",\"iters_saved\":" << result.trace.ilqr.iters_saved << '}';
     }
 
     if (result.stats.overrun) {
@@ -687,7 +883,7 @@ std::string vla_action_to_json(const vla_action& action) {
             if (i != 0) {
                 out << ',';
             }
-            out << action.u[i];
+            out << json_double(action.u[i], false);
         }
         out << ']';
     } else if (action.type == vla_action_type::discrete) {
@@ -824,6 +1020,7 @@ struct vla_request_options {
     std::string model_version = "stub-1";
     std::string frame_id = "base";
     std::int64_t deadline_ms = 20;
+    job_priority priority = job_priority::normal;
     std::int64_t dims = 0;
     double bound_lo = -1.0;
     double bound_hi = 1.0;
@@ -832,6 +1029,8 @@ struct vla_request_options {
     std::optional<std::pair<double, double>> forbidden_range{};
     std::string seed_key;
     std::optional<std::uint64_t> fixed_seed{};
+    std::string prefetch_key;
+    std::string prefetch_state_key;
 };
 
 struct vla_wait_options {
@@ -850,86 +1049,110 @@ struct vla_cancel_options {
     std::string job_key;
 };
 
-vla_request_options parse_vla_request_options(const node& n, const std::vector<muslisp::value>& args) {
+struct vla_chunk_options {
+    vla_request_options request;
+    std::string action_key = "action";
+    // The next chunk is requested once at most this many steps of the current one remain.
+    std::int64_t refill_below = 2;
+    bool interpolate = true;
+    // How long a single-action result is held, for backends that return no chunk.
+    double step_ms = 50.0;
+};
+
+// `form` names the node in errors and default names; `extra`, when given, is offered each option
+// this parser does not know and returns whether it took it.
+vla_request_options parse_vla_request_options(
+    const node& n,
+    std::span<const muslisp::value> args,
+    const std::string& form = "vla-request",
+    const std::function<bool(const std::string&, const muslisp::value&)>& extra = {}) {
     vla_request_options opts;
-    opts.node_name = n.leaf_name.empty() ? ("vla-request-" + std::to_string(n.id)) : n.leaf_name;
+    opts.node_name = n.leaf_name.empty() ? (form + "-" + std::to_string(n.id)) : n.leaf_name;
     opts.job_key = opts.node_name + ".job_id";
 
     for (std::size_t i = 0; i < args.size(); i += 2) {
-        const std::string raw_key = arg_as_text(args[i], "vla-request");
+        const std::string raw_key = arg_as_text(args[i], form);
         const std::string key = normalize_plan_option(raw_key);
         const muslisp::value value = args[i + 1];
 
         if (key == "name") {
-            opts.node_name = arg_as_text(value, "vla-request :name");
+            opts.node_name = arg_as_text(value, form + " :name");
             opts.job_key = opts.node_name + ".job_id";
         } else if (key == "job_key") {
-            opts.job_key = arg_as_text(value, "vla-request :job_key");
+            opts.job_key = arg_as_text(value, form + " :job_key");
         } else if (key == "instruction") {
-            opts.instruction = arg_as_text(value, "vla-request :instruction");
+            opts.instruction = arg_as_text(value, form + " :instruction");
         } else if (key == "instruction_key") {
-            opts.instruction_key = arg_as_text(value, "vla-request :instruction_key");
+            opts.instruction_key = arg_as_text(value, form + " :instruction_key");
         } else if (key == "task_id") {
-            opts.task_id = arg_as_text(value, "vla-request :task_id");
+            opts.task_id = arg_as_text(value, form + " :task_id");
         } else if (key == "task_key") {
-            opts.task_id_key = arg_as_text(value, "vla-request :task_key");
+            opts.task_id_key = arg_as_text(value, form + " :task_key");
         } else if (key == "state_key") {
-            opts.state_key = arg_as_text(value, "vla-request :state_key");
+            opts.state_key = arg_as_text(value, form + " :state_key");
         } else if (key == "image_key") {
-            opts.image_key = arg_as_text(value, "vla-request :image_key");
+            opts.image_key = arg_as_text(value, form + " :image_key");
         } else if (key == "blob_key") {
-            opts.blob_key = arg_as_text(value, "vla-request :blob_key");
+            opts.blob_key = arg_as_text(value, form + " :blob_key");
         } else if (key == "capability") {
-            opts.capability = arg_as_text(value, "vla-request :capability");
+            opts.capability = arg_as_text(value, form + " :capability");
         } else if (key == "model_name") {
-            opts.model_name = arg_as_text(value, "vla-request :model_name");
+            opts.model_name = arg_as_text(value, form + " :model_name");
         } else if (key == "model_version") {
-            opts.model_version = arg_as_text(value, "vla-request :model_version");
+            opts.model_version = arg_as_text(value, form + " :model_version");
         } else if (key == "frame_id") {
-            opts.frame_id = arg_as_text(value, "vla-request :frame_id");
+            opts.frame_id = arg_as_text(value, form + " :frame_id");
         } else if (key == "deadline_ms" || key == "budget_ms") {
-            opts.deadline_ms = arg_as_int(value, "vla-request :deadline_ms");
+            opts.deadline_ms = arg_as_int(value, form + " :deadline_ms");
+        } else if (key == "priority") {
+            if (!parse_job_priority(arg_as_text(value, form + " :priority"), opts.priority)) {
+                throw bt_runtime_error(form + " :priority: expected high, normal or low");
+            }
         } else if (key == "dims") {
-            opts.dims = arg_as_int(value, "vla-request :dims");
+            opts.dims = arg_as_int(value, form + " :dims");
         } else if (key == "bound_lo") {
-            opts.bound_lo = arg_as_number(value, "vla-request :bound_lo");
+            opts.bound_lo = arg_as_number(value, form + " :bound_lo");
         } else if (key == "bound_hi") {
-            opts.bound_hi = arg_as_number(value, "vla-request :bound_hi");
+            opts.bound_hi = arg_as_number(value, form + " :bound_hi");
         } else if (key == "max_abs") {
-            opts.max_abs = arg_as_number(value, "vla-request :max_abs");
+            opts.max_abs = arg_as_number(value, form + " :max_abs");
         } else if (key == "max_delta") {
-            opts.max_delta = arg_as_number(value, "vla-request :max_delta");
+            opts.max_delta = arg_as_number(value, form + " :max_delta");
         } else if (key == "forbidden_lo") {
-            const double lo = arg_as_number(value, "vla-request :forbidden_lo");
+            const double lo = arg_as_number(value, form + " :forbidden_lo");
             if (!opts.forbidden_range.has_value()) {
                 opts.forbidden_range = std::make_pair(lo, lo);
             } else {
                 opts.forbidden_range->first = lo;
             }
         } else if (key == "forbidden_hi") {
-            const double hi = arg_as_number(value, "vla-request :forbidden_hi");
+            const double hi = arg_as_number(value, form + " :forbidden_hi");
             if (!opts.forbidden_range.has_value()) {
                 opts.forbidden_range = std::make_pair(hi, hi);
             } else {
                 opts.forbidden_range->second = hi;
             }
         } else if (key == "seed_key") {
-            opts.seed_key = arg_as_text(value, "vla-request :seed_key");
+            opts.seed_key = arg_as_text(value, form + " :seed_key");
+        } else if (key == "prefetch_key") {
+            opts.prefetch_key = arg_as_text(value, form + " :prefetch_key");
+        } else if (key == "prefetch_state_key") {
+            opts.prefetch_state_key = arg_as_text(value, form + " :prefetch_state_key");
         } else if (key == "seed") {
             const std::optional<std::uint64_t> seed = seed_from_lisp_arg(value);
             if (!seed.has_value()) {
-                throw bt_runtime_error("vla-request :seed: expected non-negative numeric/string/symbol");
+                throw bt_runtime_error(form + " :seed: expected non-negative numeric/string/symbol");
             }
             opts.fixed_seed = seed;
-        } else {
-            throw bt_runtime_error("vla-request: unknown option: " + raw_key);
+        } else if (!extra || !extra(key, value)) {
+            throw bt_runtime_error(form + ": unknown option: " + raw_key);
         }
     }
 
     return opts;
 }
 
-vla_wait_options parse_vla_wait_options(const node& n, const std::vector<muslisp::value>& args) {
+vla_wait_options parse_vla_wait_options(const node& n, std::span<const muslisp::value> args) {
     vla_wait_options opts;
     opts.node_name = n.leaf_name.empty() ? ("vla-request-" + std::to_string(n.id)) : n.leaf_name;
     opts.job_key = opts.node_name + ".job_id";
@@ -963,7 +1186,7 @@ vla_wait_options parse_vla_wait_options(const node& n, const std::vector<muslisp
     return opts;
 }
 
-vla_cancel_options parse_vla_cancel_options(const node& n, const std::vector<muslisp::value>& args) {
+vla_cancel_options parse_vla_cancel_options(const node& n, std::span<const muslisp::value> args) {
     vla_cancel_options opts;
     opts.node_name = n.leaf_name.empty() ? ("vla-request-" + std::to_string(n.id)) : n.leaf_name;
     opts.job_key = opts.node_name + ".job_id";
@@ -985,6 +1208,28 @@ vla_cancel_options parse_vla_cancel_options(const node& n, const std::vector<mus
     return opts;
 }
 
+vla_chunk_options parse_vla_chunk_options(const node& n, std::span<const muslisp::value> args) {
+    vla_chunk_options opts;
+    opts.request = parse_vla_request_options(n, args, "vla-chunk", [&opts](const std::string& key, const muslisp::value& value) {
+        if (key == "action_key") {
+            opts.action_key = arg_as_text(value, "vla-chunk :action_key");
+        } else if (key == "refill_below") {
+            opts.refill_below = arg_as_int(value, "vla-chunk :refill_below");
+        } else if (key == "interpolate") {
+            opts.interpolate = parse_bool_arg(value, "vla-chunk :interpolate");
+        } else if (key == "step_ms") {
+            opts.step_ms = arg_as_number(value, "vla-chunk :step_ms");
+            if (!std::isfinite(opts.step_ms) || opts.step_ms <= 0.0) {
+                throw bt_runtime_error("vla-chunk :step_ms: expected a positive number");
+            }
+        } else {
+            return false;
+        }
+        return true;
+    });
+    return opts;
+}
+
 void clear_job_key_if_present(tick_context& ctx, const std::string& key, const std::string& writer_name) {
     const bb_entry* existing = ctx.bb_get(key);
     if (existing) {
@@ -992,6 +1237,30 @@ void clear_job_key_if_present(tick_context& ctx, const std::string& key, const s
     }
 }
 
+// Folds the tick time spent after each adaptive plan-action's planner returned into that node's
+// estimate, the way TCP smooths round-trip times: a mean and a mean deviation, both moved by alpha.
+void fold_plan_budget_samples(instance& inst, std::uint64_t tick, double tick_ms) {
+    for (auto& [node, budget] : inst.plan_budgets) {
+        if (!budget.pending) {
+            continue;
+        }
+        budget.pending = false;
+        if (budget.pending_tick != tick) {
+            continue;
+        }
+        const double sample = std::max(0.0, tick_ms - budget.planner_done_ms);
+        if (budget.samples == 0) {
+            budget.post_work_ms = sample;
+            budget.post_work_dev_ms = sample / 2.0;
+        } else {
+            const double error = sample - budget.post_work_ms;
+            budget.post_work_ms += budget.alpha * error;
+            budget.post_work_dev_ms += budget.alpha * (std::fabs(error) - budget.post_work_dev_ms);
+        }
+        ++budget.samples;
+    }
+}
+
 class tick_scope {
 public:
     tick_scope(tick_context& ctx,
@@ -1011,6 +1280,9 @@ public:
 
         ctx_.inst.tree_stats.tick_duration.observe(elapsed, ctx_.inst.tree_stats.configured_tick_budget);
         ++ctx_.inst.tree_stats.tick_count;
+        if (!ctx_.inst.plan_budgets.empty()) {
+            fold_plan_budget_samples(ctx_.inst, ctx_.tick_index, elapsed_ms);
+        }
         const bool deadline_missed =
             ctx_.inst.tree_stats.configured_tick_budget.count() > 0 && elapsed > ctx_.inst.tree_stats.configured_tick_budget;
         if (deadline_missed) {
@@ -1034,7 +1306,7 @@ public:
             if (ctx_.svc.vla && !ctx_.inst.active_vla_jobs.empty()) {
                 std::vector<node_id> to_erase;
                 to_erase.reserve(ctx_.inst.active_vla_jobs.size());
-                event_log* events = resolve_event_log(ctx_);
+                event_log* events = event_log_for(ctx_, event_family::async);
                 for (const auto& [node, job] : ctx_.inst.active_vla_jobs) {
                     if (events) {
                         std::ostringstream data;
@@ -1065,21 +1337,21 @@ public:
             }
         }
 
-        trace_event ev = make_trace_event(trace_event_kind::tick_end);
-        ev.node_status = status_;
-        ev.duration = elapsed;
-        emit_trace(ctx_, std::move(ev));
+        trace_record rec = make_trace_record(trace_event_kind::tick_end);
+        rec.node_status = status_;
+        rec.duration = elapsed;
+        emit_trace(ctx_, rec);
 
-        event_log* events = resolve_event_log(ctx_);
+        event_log* events = event_log_for(ctx_, event_family::lifecycle);
         if (events) {
             event_log_allocation_scope allocation_scope(events);
-            std::ostringstream data;
-            data << "{\"root_status\":" << status_json(status_) << ",\"tick_ms\":" << elapsed_ms;
+            json_writer& data = event_log::payload_writer();
+            data.begin_object().field("root_status", status_name(status_)).field("tick_ms", elapsed_ms);
             if (configured_budget.count() > 0) {
-                data << ",\"tick_budget_ms\":" << budget_ms;
+                data.field("tick_budget_ms", budget_ms);
             }
-            data << '}';
-            (void)events->emit("tick_end", ctx_.tick_index, data.str());
+            data.end_object();
+            (void)events->emit("tick_end", ctx_.tick_index, data);
         }
 
         emit_outcome_event(ctx_,
@@ -1090,8 +1362,15 @@ public:
                            std::nullopt,
                            deadline_missed ? std::optional<std::string_view>("tick_budget_overrun") : std::nullopt);
 
+        std::optional<tick_ledger_sample> ledger;
+        if (ctx_.ledger) {
+            ledger = ctx_.ledger->finish();
+            ctx_.inst.tree_stats.ledger.observe(*ledger);
+        }
         const muslisp::gc_stats_snapshot gc_end = muslisp::default_gc().stats();
-        emit_tick_audit_event(ctx_, status_, elapsed, configured_budget, budget_ms, deadline_missed, gc_start_, gc_end);
+        emit_tick_audit_event(
+            ctx_, status_, elapsed, configured_budget, budget_ms, deadline_missed, gc_start_, gc_end, ledger ? &*ledger : nullptr);
+        ctx_.inst.arena.reset();
     }
 
 private:
@@ -1101,131 +1380,540 @@ private:
     status status_ = status::failure;
 };
 
-class node_scope {
-public:
-    node_scope(tick_context& ctx, const node& n)
-        : ctx_(ctx), node_(n), prev_node_(ctx.current_node), started_at_(tick_now(ctx_)) {
-        ctx_.current_node = node_.id;
-        track_node_path_ = ctx_.svc.obs.events && ctx_.svc.obs.events->tick_audit_enabled();
-        if (track_node_path_) {
-            ctx_.node_path.push_back(node_.id);
-        }
-        trace_event ev = make_trace_event(trace_event_kind::node_enter);
-        ev.node = node_.id;
-        emit_trace(ctx_, std::move(ev));
-
-        event_log* events = resolve_event_log(ctx_);
-        if (events) {
-            event_log_allocation_scope allocation_scope(events);
-            std::ostringstream data;
-            data << "{\"node_id\":" << node_.id << '}';
-            (void)events->emit(muesli_bt::contract::kEventNodeEnter, ctx_.tick_index, data.str());
-        }
+// Node durations come from the instance's node timer, by default the shared TSC-backed profile
+// clock rather than the services clock, which may be a slower or simulated one.
+std::chrono::steady_clock::time_point node_timer_now(const tick_context& ctx) {
+    const clock_interface* timer = ctx.inst.node_profiling.timer;
+    return timer ? timer->now() : profile_clock::shared().now();
+}
+
+bool node_visit_sampled(const tick_context& ctx, node_id id) noexcept {
+    const node_profiling_options& opts = ctx.inst.node_profiling;
+    switch (opts.mode) {
+        case node_profiling_mode::full:
+            return true;
+        case node_profiling_mode::off:
+            return false;
+        case node_profiling_mode::sampled:
+            break;
+    }
+    if (opts.every_n_ticks > 1 && ctx.tick_index % opts.every_n_ticks != 0) {
+        return false;
     }
+    if (opts.node_percent >= 100) {
+        return true;
+    }
+    // Mix node id and tick so each tick samples a different subset.
+    std::uint64_t h = (static_cast<std::uint64_t>(id) << 32) ^ ctx.tick_index;
+    h *= 0x9e3779b97f4a7c15ull;
+    h ^= h >> 29;
+    return (h % 100u) < opts.node_percent;
+}
 
-    void set_status(status st) { status_ = st; }
+// Visit bookkeeping shared by the recursive interpreter (node_scope) and the tick program executor.
+tick_frame begin_node_visit(tick_context& ctx, const node& n) {
+    tick_frame frame{.node = n.id,
+                     .prev_node = ctx.current_node,
+                     .track_node_path = ctx.svc.obs.events && ctx.svc.obs.events->tick_audit_enabled()};
+    frame.timed = node_visit_sampled(ctx, n.id);
+    if (frame.timed) {
+        frame.started_at = node_timer_now(ctx);
+    }
+    if (ctx.heap) {
+        frame.heap_objects_at = ctx.heap->total_allocated_objects();
+        frame.heap_bytes_at = ctx.heap->total_allocated_bytes();
+        frame.attributed_objects_at = ctx.attributed_alloc_objects;
+        frame.attributed_bytes_at = ctx.attributed_alloc_bytes;
+    }
+    ctx.current_node = n.id;
+    if (frame.track_node_path) {
+        std::vector<node_path_record>& records = ctx.inst.node_path_records;
+        records.push_back(node_path_record{.node = n.id, .parent = ctx.node_path_top});
+        ctx.node_path_top = static_cast<std::uint32_t>(records.size() - 1);
+        ++ctx.node_path_depth;
+    }
+    if (trace_capture_enabled(ctx)) {
+        trace_record rec = make_trace_record(trace_event_kind::node_enter);
+        rec.node = n.id;
+        emit_trace(ctx, rec);
+    }
 
-    ~node_scope() {
-        const auto end = tick_now(ctx_);
-        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(end - started_at_);
+    event_log* events = event_log_for(ctx, event_family::node);
+    if (events) {
+        event_log_allocation_scope allocation_scope(events);
+        json_writer& data = event_log::payload_writer();
+        data.begin_object().field("node_id", n.id).end_object();
+        (void)events->emit(muesli_bt::contract::kEventNodeEnter, ctx.tick_index, data);
+    }
+    return frame;
+}
 
-        node_profile_stats& stats = node_stats_for(ctx_.inst, node_);
+void end_node_visit(tick_context& ctx, const node& n, const tick_frame& frame, status st) {
+    std::chrono::nanoseconds elapsed{0};
+    node_profile_stats& stats = node_stats_for(ctx.inst, n);
+    if (frame.timed) {
+        elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(node_timer_now(ctx) - frame.started_at);
         stats.tick_duration.observe(elapsed);
-        switch (status_) {
-            case status::success:
-                ++stats.success_returns;
-                break;
-            case status::failure:
-                ++stats.failure_returns;
-                break;
-            case status::running:
-                ++stats.running_returns;
-                break;
+    }
+    switch (st) {
+        case status::success:
+            ++stats.success_returns;
+            break;
+        case status::failure:
+            ++stats.failure_returns;
+            break;
+        case status::running:
+            ++stats.running_returns;
+            break;
+    }
+    if (ctx.heap) {
+        // Self allocations: everything since the visit began, less what nested visits claimed.
+        const std::uint64_t objects = ctx.heap->total_allocated_objects() - frame.heap_objects_at -
+                                      (ctx.attributed_alloc_objects - frame.attributed_objects_at);
+        const std::uint64_t bytes = ctx.heap->total_allocated_bytes() - frame.heap_bytes_at -
+                                    (ctx.attributed_alloc_bytes - frame.attributed_bytes_at);
+        if (objects > 0 || bytes > 0) {
+            stats.alloc_objects += objects;
+            stats.alloc_bytes += bytes;
+            ctx.attributed_alloc_objects += objects;
+            ctx.attributed_alloc_bytes += bytes;
+            if (frame.track_node_path) {
+                ctx.inst.node_alloc_records.push_back(
+                    node_alloc_record{.node = n.id, .objects = objects, .bytes = bytes});
+            }
         }
+    }
 
-        trace_event ev = make_trace_event(trace_event_kind::node_exit);
-        ev.node = node_.id;
-        ev.node_status = status_;
-        ev.duration = elapsed;
-        emit_trace(ctx_, std::move(ev));
+    if (trace_capture_enabled(ctx)) {
+        trace_record rec = make_trace_record(trace_event_kind::node_exit);
+        rec.node = n.id;
+        rec.node_status = st;
+        rec.duration = elapsed;
+        emit_trace(ctx, rec);
+    }
 
-        event_log* events = resolve_event_log(ctx_);
-        if (events) {
-            event_log_allocation_scope allocation_scope(events);
-            std::ostringstream data;
-            data << "{\"node_id\":" << node_.id << ",\"status\":" << status_json(status_)
-                 << ",\"dur_ms\":" << (static_cast<double>(elapsed.count()) / 1'000'000.0) << '}';
-            (void)events->emit(muesli_bt::contract::kEventNodeExit, ctx_.tick_index, data.str());
-            (void)events->emit("node_status", ctx_.tick_index, data.str());
+    event_log* events = event_log_for(ctx, event_family::node, st == status::failure);
+    if (events) {
+        event_log_allocation_scope allocation_scope(events);
+        json_writer& data = event_log::payload_writer();
+        data.begin_object().field("node_id", n.id);
+        if (events->compact_ids()) {
+            data.field("status_id", static_cast<int>(st));
+        } else {
+            data.field("status", status_name(st));
         }
-
-        ctx_.current_node = prev_node_;
-        if (track_node_path_ && !ctx_.node_path.empty()) {
-            ctx_.node_path.pop_back();
+        if (frame.timed) {
+            data.field("dur_ms", static_cast<double>(elapsed.count()) / 1'000'000.0);
         }
+        data.end_object();
+        (void)events->emit(muesli_bt::contract::kEventNodeExit, ctx.tick_index, data);
+        (void)events->emit("node_status", ctx.tick_index, data);
+    }
+
+    if (st != status::running) {
+        ctx.inst.release_idle_memory(n.id);
+    } else if (n.children.empty() && n.kind != node_kind::running && !ctx.inst.running_unwatched) {
+        const node_memory& mem = ctx.inst.memory[n.id];
+        ctx.inst.running_unwatched = ctx.inst.job_watchers[n.id] == 0u || !mem.b0 || mem.i0 == 0;
     }
 
+    ctx.current_node = frame.prev_node;
+    if (frame.track_node_path && ctx.node_path_top != node_path_record::k_none) {
+        ctx.node_path_top = ctx.inst.node_path_records[ctx.node_path_top].parent;
+        --ctx.node_path_depth;
+    }
+}
+
+// The deepest node path reached this tick names the terminal node reported in tick outcomes.
+void note_node_result(tick_context& ctx, const node& n) {
+    if (ctx.node_path_depth >= ctx.terminal_depth) {
+        ctx.terminal_depth = ctx.node_path_depth;
+        ctx.terminal_record = ctx.node_path_top;
+        ctx.terminal_node_id = n.id;
+    }
+}
+
+class node_scope {
+public:
+    node_scope(tick_context& ctx, const node& n) : ctx_(ctx), node_(n), frame_(begin_node_visit(ctx, n)) {}
+
+    node_scope(const node_scope&) = delete;
+    node_scope& operator=(const node_scope&) = delete;
+
+    void set_status(status st) { status_ = st; }
+
+    ~node_scope() { end_node_visit(ctx_, node_, frame_, status_); }
+
 private:
     tick_context& ctx_;
     const node& node_;
-    node_id prev_node_ = 0;
-    std::chrono::steady_clock::time_point started_at_{};
+    tick_frame frame_;
     status status_ = status::failure;
-    bool track_node_path_ = false;
 };
 
-status execute_plan_action(const node& n, tick_context& ctx, const std::vector<muslisp::value>& args) {
-    if (!ctx.svc.planner) {
+// Reports a finished plan-action call: planner events and log, then the action and meta written to
+// the blackboard. Returns the node status for `result`.
+status conclude_plan_action(const node& n,
+                            tick_context& ctx,
+                            const planner_request& request,
+                            const planner_result& result,
+                            std::chrono::steady_clock::time_point planner_call_started,
+                            const std::string& action_key,
+                            const std::string& meta_key) {
+    event_log* events = event_log_for(ctx, event_family::async);
+    if (events) {
+        const auto planner_call_finished = tick_now(ctx);
+        const double elapsed_ms =
+            std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(planner_call_finished - planner_call_started)
+                .count();
+        std::ostringstream data;
+        data << "{\"node_id\":" << n.id << ",\"planner\":\"" << planner_backend_name(result.planner)
+             << "\",\"status\":\"" << planner_status_name(result.status) << "\",\"time_used_ms\":" << elapsed_ms
+             << ",\"work_done\":" << result.stats.work_done << ",\"confidence\":" << json_double(result.confidence, false)
+             << ",\"action\":[";
+        // The action lets bt::log_replay hand the same result back without planning.
+        for (std::size_t i = 0; i < result.action.u.size(); ++i) {
+            data << (i == 0 ? "" : ",") << json_double(result.action.u[i], false);
+        }
+        data << "]}";
+        (void)events->emit(muesli_bt::contract::kEventPlannerCallEnd, ctx.tick_index, data.str());
+    }
+    if (result.status == planner_status::timeout) {
+        emit_outcome_event(ctx, muesli_bt::contract::kEventPlannerTimeout, "plan-action", n.id, std::nullopt, "timeout");
+    }
+
+    if (result.action.u.empty()) {
+        std::string message = "plan-action: planner returned empty action";
+        if (!result.error.empty()) {
+            message += ": ";
+            message += result.error;
+        }
         trace_event ev = make_trace_event(trace_event_kind::error);
         ev.node = n.id;
-        ev.message = "planner service is not available";
+        ev.message = message;
         emit_trace(ctx, std::move(ev));
-        emit_log(ctx, log_level::error, "planner", "planner service is not available");
+        emit_log(ctx, log_level::error, "planner", std::move(message));
         return status::failure;
     }
 
-    planner_request request;
-    request.schema_version = "planner.request.v1";
-    request.node_name = n.leaf_name.empty() ? ("plan-action-" + std::to_string(n.id)) : n.leaf_name;
-    request.tick_index = ctx.tick_index;
-    request.run_id = "inst-" + std::to_string(ctx.inst.instance_handle);
+    for (double v : result.action.u) {
+        if (!std::isfinite(v)) {
+            trace_event ev = make_trace_event(trace_event_kind::error);
+            ev.node = n.id;
+            ev.message = "plan-action: non-finite action value";
+            emit_trace(ctx, std::move(ev));
+            emit_log(ctx, log_level::error, "planner", "plan-action: non-finite action value");
+            return status::failure;
+        }
+    }
 
-    std::string state_key = "state";
-    std::string action_key = "action";
-    std::string model_service = "toy-1d";
-    std::string meta_key;
-    std::string seed_key;
-    std::string safe_action_key;
-    std::string sigma_key;
-    std::string max_du_key;
+    ctx.bb_put(action_key, action_to_blackboard(result.action), request.node_name);
+    if (!meta_key.empty()) {
+        ctx.bb_put(meta_key, bb_value{plan_meta_to_json(result, request)}, request.node_name);
+    }
 
-    for (std::size_t i = 0; i < args.size(); i += 2) {
-        const std::string raw_key = arg_as_text(args[i], "plan-action");
-        const std::string key = normalize_plan_option(raw_key);
-        const muslisp::value value = args[i + 1];
+    emit_log_deferred(ctx,
+                      log_level::info,
+                      "planner",
+                      "planner={} status={} action={} confidence={} work={} time_ms={}",
+                      {planner_backend_name(result.planner),
+                       planner_status_name(result.status),
+                       std::span<const double>(result.action.u.data(), result.action.u.size()),
+                       result.confidence,
+                       result.stats.work_done,
+                       result.stats.time_used_ms});
 
-        if (key == "name") {
-            request.node_name = arg_as_text(value, "plan-action :name");
-            continue;
-        }
-        if (key == "planner") {
-            const std::string planner_name = arg_as_text(value, "plan-action :planner");
-            planner_backend backend = planner_backend::mcts;
-            if (!planner_backend_from_string(planner_name, backend)) {
-                throw bt_runtime_error("plan-action: unsupported planner: " + planner_name);
-            }
-            request.planner = backend;
-            continue;
-        }
-        if (key == "budget_ms") {
-            request.budget_ms = arg_as_int(value, "plan-action :budget_ms");
-            continue;
-        }
-        if (key == "work_max" || key == "iters_max") {
-            request.work_max = arg_as_int(value, "plan-action :work_max");
-            continue;
+    if (result.status != planner_status::ok) {
+        std::string message = "plan-action: planner status is not :ok";
+        if (!result.error.empty()) {
+            message += ": ";
+            message += result.error;
         }
-        if (key == "horizon") {
+        trace_event ev = make_trace_event(result.status == planner_status::error ? trace_event_kind::error
+                                                                                  : trace_event_kind::warning);
+        ev.node = n.id;
+        ev.message = message;
+        emit_trace(ctx, std::move(ev));
+        emit_log(ctx, result.status == planner_status::error ? log_level::error : log_level::warn, "planner", message);
+        return status::failure;
+    }
+
+    return status::success;
+}
+
+// State of a plan-action :async node, kept in its memory slot while a plan runs on the scheduler.
+// The job shares `current` and the warm starts, so halting the node, which drops the slot, only
+// raises the cancel flag of a plan still running; the job ends at the planner's next budget check.
+struct plan_action_job {
+    struct run {
+        planner_request request;
+        planner_progress progress;
+        std::shared_ptr<std::atomic<bool>> cancel = std::make_shared<std::atomic<bool>>(false);
+    };
+
+    plan_action_job() = default;
+    plan_action_job(plan_action_job&&) noexcept = default;
+    plan_action_job& operator=(plan_action_job&&) = delete;
+    ~plan_action_job() {
+        if (current) {
+            current->cancel->store(true, std::memory_order_release);
+        }
+    }
+
+    std::shared_ptr<run> current;
+    std::chrono::steady_clock::time_point started{};
+    // Newest result taken from current->progress.
+    planner_result latest;
+    // Kept across runs, like the synchronous node's :reuse_tree and :warm_start slots.
+    std::shared_ptr<planner_mcts_tree> tree;
+    std::shared_ptr<planner_ilqr_warm_start> warm;
+};
+
+status start_plan_action_job(const node& n, tick_context& ctx, planner_request request, bool reuse_tree, bool warm_start) {
+    if (!ctx.svc.sched) {
+        trace_event ev = make_trace_event(trace_event_kind::error);
+        ev.node = n.id;
+        ev.message = "plan-action: :async needs a scheduler";
+        emit_trace(ctx, std::move(ev));
+        emit_log(ctx, log_level::error, "planner", "plan-action: :async needs a scheduler");
+        return status::failure;
+    }
+
+    node_memory& mem = node_memory_for(ctx.inst, n.id);
+    plan_action_job* existing = mem.payload.get<plan_action_job>();
+    plan_action_job& job = existing ? *existing : mem.payload.emplace<plan_action_job>();
+    if (reuse_tree && request.planner == planner_backend::mcts) {
+        if (!job.tree) {
+            job.tree = std::make_shared<planner_mcts_tree>();
+        }
+        request.mcts_tree = job.tree.get();
+    }
+    if (warm_start && request.planner == planner_backend::ilqr) {
+        if (!job.warm) {
+            job.warm = std::make_shared<planner_ilqr_warm_start>();
+        }
+        request.ilqr_warm_start = job.warm.get();
+    }
+
+    auto run = std::make_shared<plan_action_job::run>();
+    run->request = std::move(request);
+    run->request.progress = &run->progress;
+    job.current = run;
+    job.started = tick_now(ctx);
+    job.latest = planner_result{};
+
+    event_log* events = event_log_for(ctx, event_family::async);
+    if (events) {
+        std::ostringstream data;
+        data << "{\"node_id\":" << n.id << ",\"planner\":\"" << planner_backend_name(run->request.planner)
+             << "\",\"budget_ms\":" << run->request.budget_ms << "}";
+        (void)events->emit(muesli_bt::contract::kEventPlannerCallStart, ctx.tick_index, data.str());
+    }
+
+    job_request req;
+    req.task_name = "plan-action";
+    req.cancel_flag = run->cancel;
+    req.fn = [run, tree = job.tree, warm = job.warm, planner = ctx.svc.planner](const cancel_token& cancel) {
+        try {
+            (void)planner->plan(run->request, cancel);
+        } catch (const std::exception& e) {
+            planner_result failed;
+            failed.planner = run->request.planner;
+            failed.status = planner_status::error;
+            failed.error = std::string("planner threw: ") + e.what();
+            run->progress.finish(failed);
+        }
+        return job_result{};
+    };
+    ++ctx.planner_calls;
+    if (ctx.svc.replay && ctx.svc.replay->records_planner_results()) {
+        // The recorded result is handed over on the tick the job finished (poll_plan_action_job).
+        mem.i0 = 0;
+        mem.b0 = true;
+        mem.job_notified = false;
+        return status::running;
+    }
+    ctx.watch_job(req, n.id);
+    const job_id id = ctx.svc.sched->submit(std::move(req));
+    mem.i0 = static_cast<std::int64_t>(id);
+    mem.b0 = true;
+    mem.job_notified = false;
+    ctx.scheduler_event(trace_event_kind::scheduler_submit, id, job_status::queued, "scheduler submitted task plan-action");
+    return status::running;
+}
+
+// One tick of a plan-action :async node with a plan in flight. Copies the newest best-so-far action
+// to the blackboard while the plan runs, and concludes the call once the final result is in.
+status poll_plan_action_job(const node& n,
+                            tick_context& ctx,
+                            node_memory& mem,
+                            plan_action_job& job,
+                            const std::string& action_key,
+                            const std::string& meta_key) {
+    plan_action_job::run& run = *job.current;
+    if (ctx.svc.replay && mem.i0 == 0) {
+        if (std::optional<planner_result> recorded = ctx.svc.replay->planner_result_at(ctx.tick_index, n.id)) {
+            run.progress.finish(*recorded);
+        }
+    }
+
+    // A job that ended without a final result was cancelled while queued or failed outside plan().
+    bool job_lost = false;
+    if (mem.job_notified) {
+        mem.job_notified = false;
+        const job_info info = ctx.svc.sched->get_info(static_cast<job_id>(mem.i0));
+        job_lost = info.status != job_status::queued && info.status != job_status::running;
+    }
+
+    const bool finished = run.progress.finished();
+    const bool fresh = run.progress.take(job.latest);
+    if (finished || job_lost) {
+        mem.b0 = false;
+        mem.i0 = 0;
+        mem.job_notified = false;
+        const std::shared_ptr<plan_action_job::run> done = std::move(job.current);
+        if (!finished) {
+            trace_event ev = make_trace_event(trace_event_kind::error);
+            ev.node = n.id;
+            ev.message = "plan-action: planner job ended without a result";
+            emit_trace(ctx, std::move(ev));
+            emit_log(ctx, log_level::error, "planner", "plan-action: planner job ended without a result");
+            return status::failure;
+        }
+        return conclude_plan_action(n, ctx, done->request, job.latest, job.started, action_key, meta_key);
+    }
+
+    if (fresh && !job.latest.action.u.empty()) {
+        ctx.bb_put(action_key, action_to_blackboard(job.latest.action), run.request.node_name);
+        if (!meta_key.empty()) {
+            ctx.bb_put(meta_key, bb_value{plan_meta_to_json(job.latest, run.request)}, run.request.node_name);
+        }
+    }
+    return status::running;
+}
+
+// plan-action :budget_mode and the options that go with it.
+struct plan_budget_options {
+    bool adaptive = false;
+    std::int64_t min_ms = 1;
+    std::optional<std::int64_t> max_ms;
+    double guard_ms = 0.0;
+    double alpha = 0.2;
+};
+
+// Gives the planner the tick time left now, less a margin for the work the tick still does after it
+// returns: the node's learned post-planner time plus two deviations, and the fixed guard. Before the
+// node's first sample the margin is the guard alone. The budget is clamped to [min_ms, max_ms], and
+// is max_ms when no tick budget is configured, since there is no slack to measure.
+void choose_plan_budget(tick_context& ctx, node_id node, const plan_budget_options& options, planner_request& request) {
+    const std::int64_t max_ms = std::max(options.min_ms, options.max_ms.value_or(request.budget_ms));
+    instance::plan_budget& learned = ctx.inst.plan_budgets[node];
+    learned.alpha = options.alpha;
+
+    planner_budget_choice choice;
+    choice.adaptive = true;
+    choice.margin_ms = options.guard_ms;
+    if (learned.samples > 0) {
+        choice.margin_ms += learned.post_work_ms + 2.0 * learned.post_work_dev_ms;
+    }
+    std::int64_t budget_ms = max_ms;
+    if (const std::optional<double> remaining = tick_remaining_ms(ctx)) {
+        choice.slack_ms = std::max(0.0, *remaining);
+        budget_ms = static_cast<std::int64_t>(std::floor(std::max(0.0, choice.slack_ms - choice.margin_ms)));
+    }
+    request.budget_ms = std::clamp(budget_ms, options.min_ms, max_ms);
+    request.budget_choice = choice;
+}
+
+status execute_plan_action(const node& n, tick_context& ctx, std::span<const muslisp::value> args) {
+    if (!ctx.svc.planner) {
+        trace_event ev = make_trace_event(trace_event_kind::error);
+        ev.node = n.id;
+        ev.message = "planner service is not available";
+        emit_trace(ctx, std::move(ev));
+        emit_log(ctx, log_level::error, "planner", "planner service is not available");
+        return status::failure;
+    }
+
+    planner_request request;
+    request.schema_version = "planner.request.v1";
+    request.node_name = n.leaf_name.empty() ? ("plan-action-" + std::to_string(n.id)) : n.leaf_name;
+    request.tick_index = ctx.tick_index;
+    request.run_id = "inst-" + std::to_string(ctx.inst.instance_handle);
+
+    std::string state_key = "state";
+    std::string action_key = "action";
+    std::string model_service = "toy-1d";
+    std::string meta_key;
+    std::string seed_key;
+    std::string safe_action_key;
+    std::string sigma_key;
+    std::string max_du_key;
+    bool reuse_tree = false;
+    bool warm_start = false;
+    bool async = false;
+    plan_budget_options budget_options;
+
+    for (std::size_t i = 0; i < args.size(); i += 2) {
+        const std::string raw_key = arg_as_text(args[i], "plan-action");
+        const std::string key = normalize_plan_option(raw_key);
+        const muslisp::value value = args[i + 1];
+
+        if (key == "name") {
+            request.node_name = arg_as_text(value, "plan-action :name");
+            continue;
+        }
+        if (key == "planner") {
+            const std::string planner_name = arg_as_text(value, "plan-action :planner");
+            planner_backend backend = planner_backend::mcts;
+            if (!planner_backend_from_string(planner_name, backend)) {
+                throw bt_runtime_error("plan-action: unsupported planner: " + planner_name);
+            }
+            request.planner = backend;
+            continue;
+        }
+        if (key == "budget_ms") {
+            request.budget_ms = arg_as_int(value, "plan-action :budget_ms");
+            continue;
+        }
+        if (key == "budget_mode") {
+            const std::string mode = arg_as_text(value, "plan-action :budget_mode");
+            if (mode != "fixed" && mode != "adaptive") {
+                throw bt_runtime_error("plan-action: unsupported budget_mode: " + mode);
+            }
+            budget_options.adaptive = mode == "adaptive";
+            continue;
+        }
+        if (key == "budget_min_ms") {
+            budget_options.min_ms = arg_as_int(value, "plan-action :budget_min_ms");
+            if (budget_options.min_ms < 0) {
+                throw bt_runtime_error("plan-action: budget_min_ms must be >= 0");
+            }
+            continue;
+        }
+        if (key == "budget_max_ms") {
+            budget_options.max_ms = arg_as_int(value, "plan-action :budget_max_ms");
+            continue;
+        }
+        if (key == "budget_margin_ms") {
+            budget_options.guard_ms = arg_as_number(value, "plan-action :budget_margin_ms");
+            if (!(budget_options.guard_ms >= 0.0)) {
+                throw bt_runtime_error("plan-action: budget_margin_ms must be >= 0");
+            }
+            continue;
+        }
+        if (key == "budget_alpha") {
+            budget_options.alpha = arg_as_number(value, "plan-action :budget_alpha");
+            if (!(budget_options.alpha > 0.0 && budget_options.alpha <= 1.0)) {
+                throw bt_runtime_error("plan-action: budget_alpha must be in (0, 1]");
+            }
+            continue;
+        }
+        if (key == "work_max" || key == "iters_max") {
+            request.work_max = arg_as_int(value, "plan-action :work_max");
+            continue;
+        }
+        if (key == "horizon") {
             request.horizon = arg_as_int(value, "plan-action :horizon");
             continue;
         }
@@ -1269,6 +1957,10 @@ status execute_plan_action(const node& n, tick_context& ctx, const std::vector<m
             request.top_k = arg_as_int(value, "plan-action :top_k");
             continue;
         }
+        if (key == "cache_quantum") {
+            request.cache_quantum = arg_as_number(value, "plan-action :cache_quantum");
+            continue;
+        }
 
         if (key == "gamma") {
             request.mcts.gamma = arg_as_number(value, "plan-action :gamma");
@@ -1298,6 +1990,44 @@ status execute_plan_action(const node& n, tick_context& ctx, const std::vector<m
             request.mcts.action_sampler = arg_as_text(value, "plan-action :action_sampler");
             continue;
         }
+        if (key == "parallelism") {
+            request.mcts.parallelism = arg_as_text(value, "plan-action :parallelism");
+            continue;
+        }
+        if (key == "threads") {
+            request.mcts.threads = arg_as_int(value, "plan-action :threads");
+            request.mppi.threads = request.mcts.threads;
+            request.ilqr.threads = request.mcts.threads;
+            continue;
+        }
+        if (key == "virtual_loss") {
+            request.mcts.virtual_loss = arg_as_number(value, "plan-action :virtual_loss");
+            continue;
+        }
+        if (key == "reuse_tree") {
+            reuse_tree = arg_as_bool(value, "plan-action :reuse_tree");
+            continue;
+        }
+        if (key == "reuse_tolerance") {
+            request.mcts.reuse_state_tolerance = arg_as_number(value, "plan-action :reuse_tolerance");
+            continue;
+        }
+        if (key == "reuse_max_nodes") {
+            request.mcts.reuse_max_nodes = arg_as_int(value, "plan-action :reuse_max_nodes");
+            continue;
+        }
+        if (key == "warm_start") {
+            warm_start = arg_as_bool(value, "plan-action :warm_start");
+            continue;
+        }
+        if (key == "async") {
+            async = arg_as_bool(value, "plan-action :async");
+            continue;
+        }
+        if (key == "progress_ms") {
+            request.progress_interval_ms = arg_as_int(value, "plan-action :progress_ms");
+            continue;
+        }
 
         if (key == "lambda") {
             request.mppi.lambda = arg_as_number(value, "plan-action :lambda");
@@ -1383,14 +2113,30 @@ status execute_plan_action(const node& n, tick_context& ctx, const std::vector<m
 
     request.model_service = model_service;
     request.state_key = state_key;
+    if (budget_options.adaptive && async) {
+        // An async plan runs past the tick, so there is no tick slack to size it by.
+        throw bt_runtime_error("plan-action: budget_mode \"adaptive\" cannot be combined with :async");
+    }
+    if (budget_options.max_ms && *budget_options.max_ms < budget_options.min_ms) {
+        throw bt_runtime_error("plan-action: budget_max_ms must be >= budget_min_ms");
+    }
 
-    const bb_entry* state_entry = ctx.bb_get(state_key);
+    if (async) {
+        node_memory& mem = node_memory_for(ctx.inst, n.id);
+        plan_action_job* job = mem.payload.get<plan_action_job>();
+        if (job && job->current) {
+            return poll_plan_action_job(n, ctx, mem, *job, action_key, meta_key);
+        }
+    }
+
+    const bb_slot state_slot = ctx.inst.bb_key_slot(n.state_key);
+    const bb_entry* state_entry = state_slot != kNoBbSlot ? ctx.bb_get(state_slot) : ctx.bb_get(state_key);
     if (!state_entry) {
         trace_event ev = make_trace_event(trace_event_kind::error);
         ev.node = n.id;
         ev.message = "plan-action: missing state key: " + state_key;
         emit_trace(ctx, std::move(ev));
-        emit_log(ctx, log_level::error, "planner", "plan-action: missing state key: " + state_key);
+        emit_log_deferred(ctx, log_level::error, "planner", "plan-action: missing state key: {}", {state_key});
         return status::failure;
     }
 
@@ -1411,7 +2157,7 @@ status execute_plan_action(const node& n, tick_context& ctx, const std::vector<m
             try {
                 request.safe_action.u = state_from_blackboard(safe_entry->value, "plan-action safe_action");
             } catch (const std::exception& e) {
-                emit_log(ctx, log_level::warn, "planner", std::string("plan-action: invalid safe_action_key: ") + e.what());
+                emit_log_deferred(ctx, log_level::warn, "planner", "plan-action: invalid safe_action_key: {}", {e.what()});
             }
         }
     }
@@ -1421,7 +2167,7 @@ status execute_plan_action(const node& n, tick_context& ctx, const std::vector<m
             try {
                 request.mppi.sigma = state_from_blackboard(sigma_entry->value, "plan-action sigma");
             } catch (const std::exception& e) {
-                emit_log(ctx, log_level::warn, "planner", std::string("plan-action: invalid sigma_key: ") + e.what());
+                emit_log_deferred(ctx, log_level::warn, "planner", "plan-action: invalid sigma_key: {}", {e.what()});
             }
         }
     }
@@ -1431,7 +2177,7 @@ status execute_plan_action(const node& n, tick_context& ctx, const std::vector<m
             try {
                 request.constraints.max_du = state_from_blackboard(max_du_entry->value, "plan-action max_du");
             } catch (const std::exception& e) {
-                emit_log(ctx, log_level::warn, "planner", std::string("plan-action: invalid max_du_key: ") + e.what());
+                emit_log_deferred(ctx, log_level::warn, "planner", "plan-action: invalid max_du_key: {}", {e.what()});
             }
         }
     }
@@ -1458,19 +2204,50 @@ status execute_plan_action(const node& n, tick_context& ctx, const std::vector<m
         return status::failure;
     }
 
-    event_log* events = resolve_event_log(ctx);
+    if (async) {
+        return start_plan_action_job(n, ctx, std::move(request), reuse_tree, warm_start);
+    }
+
+    if (reuse_tree && request.planner == planner_backend::mcts) {
+        // The node's search tree lives in its memory slot, so halting the node or resetting the
+        // instance drops it.
+        node_payload& slot = node_memory_for(ctx.inst, n.id).payload;
+        planner_mcts_tree* tree = slot.get<planner_mcts_tree>();
+        request.mcts_tree = tree ? tree : &slot.emplace<planner_mcts_tree>();
+    }
+    if (warm_start && request.planner == planner_backend::ilqr) {
+        node_payload& slot = node_memory_for(ctx.inst, n.id).payload;
+        planner_ilqr_warm_start* warm = slot.get<planner_ilqr_warm_start>();
+        request.ilqr_warm_start = warm ? warm : &slot.emplace<planner_ilqr_warm_start>();
+    }
+
+    if (budget_options.adaptive) {
+        choose_plan_budget(ctx, n.id, budget_options, request);
+    }
+
+    event_log* events = event_log_for(ctx, event_family::async);
     const auto planner_call_started = tick_now(ctx);
     if (events) {
         std::ostringstream data;
         data << "{\"node_id\":" << n.id << ",\"planner\":\"" << planner_backend_name(request.planner)
-             << "\",\"budget_ms\":" << request.budget_ms << "}";
+             << "\",\"budget_ms\":" << request.budget_ms;
+        if (request.budget_choice.adaptive) {
+            data << ",\"budget_mode\":\"adaptive\",\"budget_slack_ms\":" << request.budget_choice.slack_ms
+                 << ",\"budget_margin_ms\":" << request.budget_choice.margin_ms;
+        }
+        data << "}";
         (void)events->emit(muesli_bt::contract::kEventPlannerCallStart, ctx.tick_index, data.str());
     }
 
     planner_result result;
     try {
         ++ctx.planner_calls;
-        result = ctx.svc.planner->plan(request);
+        std::optional<planner_result> recorded;
+        if (ctx.svc.replay) {
+            recorded = ctx.svc.replay->planner_result_at(ctx.tick_index, n.id);
+        }
+        ledger_scope charge(ctx.ledger, ledger_category::planner);
+        result = recorded ? std::move(*recorded) : ctx.svc.planner->plan(request);
     } catch (const std::exception& e) {
         if (events) {
             const auto planner_call_finished = tick_now(ctx);
@@ -1487,134 +2264,64 @@ status execute_plan_action(const node& n, tick_context& ctx, const std::vector<m
         ev.node = n.id;
         ev.message = std::string("plan-action: planner threw: ") + e.what();
         emit_trace(ctx, std::move(ev));
-        emit_log(ctx, log_level::error, "planner", std::string("plan-action: planner threw: ") + e.what());
-        return status::failure;
-    }
-
-    if (events) {
-        const auto planner_call_finished = tick_now(ctx);
-        const double elapsed_ms =
-            std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(planner_call_finished - planner_call_started)
-                .count();
-        std::ostringstream data;
-        data << "{\"node_id\":" << n.id << ",\"planner\":\"" << planner_backend_name(result.planner)
-             << "\",\"status\":\"" << planner_status_name(result.status) << "\",\"time_used_ms\":" << elapsed_ms
-             << ",\"work_done\":" << result.stats.work_done << "}";
-        (void)events->emit(muesli_bt::contract::kEventPlannerCallEnd, ctx.tick_index, data.str());
-    }
-    if (result.status == planner_status::timeout) {
-        emit_outcome_event(ctx, muesli_bt::contract::kEventPlannerTimeout, "plan-action", n.id, std::nullopt, "timeout");
-    }
-
-    if (result.action.u.empty()) {
-        std::string message = "plan-action: planner returned empty action";
-        if (!result.error.empty()) {
-            message += ": ";
-            message += result.error;
-        }
-        trace_event ev = make_trace_event(trace_event_kind::error);
-        ev.node = n.id;
-        ev.message = message;
-        emit_trace(ctx, std::move(ev));
-        emit_log(ctx, log_level::error, "planner", std::move(message));
+        emit_log_deferred(ctx, log_level::error, "planner", "plan-action: planner threw: {}", {e.what()});
         return status::failure;
     }
-
-    for (double v : result.action.u) {
-        if (!std::isfinite(v)) {
-            trace_event ev = make_trace_event(trace_event_kind::error);
-            ev.node = n.id;
-            ev.message = "plan-action: non-finite action value";
-            emit_trace(ctx, std::move(ev));
-            emit_log(ctx, log_level::error, "planner", "plan-action: non-finite action value");
-            return status::failure;
-        }
-    }
-
-    ctx.bb_put(action_key, action_to_blackboard(result.action), request.node_name);
-    if (!meta_key.empty()) {
-        ctx.bb_put(meta_key, bb_value{plan_meta_to_json(result, request)}, request.node_name);
-    }
-
-    std::ostringstream msg;
-    msg << "planner=" << planner_backend_name(result.planner) << " status=" << planner_status_name(result.status)
-        << " action=";
-    for (std::size_t i = 0; i < result.action.u.size(); ++i) {
-        if (i != 0) {
-            msg << ',';
-        }
-        msg << result.action.u[i];
-    }
-    msg << " confidence=" << result.confidence << " work=" << result.stats.work_done
-        << " time_ms=" << result.stats.time_used_ms;
-    emit_log(ctx, log_level::info, "planner", msg.str());
-
-    if (result.status != planner_status::ok) {
-        std::string message = "plan-action: planner status is not :ok";
-        if (!result.error.empty()) {
-            message += ": ";
-            message += result.error;
-        }
-        trace_event ev = make_trace_event(result.status == planner_status::error ? trace_event_kind::error
-                                                                                  : trace_event_kind::warning);
-        ev.node = n.id;
-        ev.message = message;
-        emit_trace(ctx, std::move(ev));
-        emit_log(ctx, result.status == planner_status::error ? log_level::error : log_level::warn, "planner", message);
-        return status::failure;
+    if (budget_options.adaptive) {
+        // Whatever the tick spends from here on is the next post-planner sample; see tick_scope.
+        instance::plan_budget& learned = ctx.inst.plan_budgets[n.id];
+        learned.pending = true;
+        learned.pending_tick = ctx.tick_index;
+        learned.planner_done_ms =
+            std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(tick_now(ctx) - ctx.tick_started_at).count();
     }
 
-    return status::success;
+    return conclude_plan_action(n, ctx, request, result, planner_call_started, action_key, meta_key);
 }
 
-status execute_vla_request(const node& n, tick_context& ctx, const std::vector<muslisp::value>& args) {
-    if (!ctx.svc.vla) {
-        trace_event ev = make_trace_event(trace_event_kind::error);
-        ev.node = n.id;
-        ev.message = "vla-request: VLA service is not available";
-        emit_trace(ctx, std::move(ev));
-        emit_log(ctx, log_level::error, "vla", "vla-request: VLA service is not available");
-        return status::failure;
-    }
-
-    const vla_request_options opts = parse_vla_request_options(n, args);
-
-    if (const bb_entry* existing = ctx.bb_get(opts.job_key); existing) {
-        if (const auto* existing_id = std::get_if<std::int64_t>(&existing->value); existing_id && *existing_id > 0) {
-            return status::running;
-        }
-    }
+// A prefetch is consumed when the request the node builds on its real tick hashes the same. The
+// observation timestamp is left out: the predicted state is necessarily written before the real one.
+std::uint64_t vla_prefetch_hash(vla_request request) {
+    request.observation.timestamp_ms = 0;
+    return vla_service::hash_request(request);
+}
 
-    const bb_entry* state_entry = ctx.bb_get(opts.state_key);
+// Builds the request a vla-request node would submit this tick, reading its state from `state_key`
+// (the node's own state key, or its predicted next state when prefetching).
+std::optional<vla_request> build_vla_request(tick_context& ctx,
+                                             const vla_request_options& opts,
+                                             const std::string& state_key,
+                                             std::string& error) {
+    const bb_entry* state_entry = ctx.bb_get(state_key);
     if (!state_entry) {
-        emit_log(ctx, log_level::error, "vla", "vla-request: missing state key: " + opts.state_key);
-        return status::failure;
+        error = "vla-request: missing state key: " + state_key;
+        return std::nullopt;
     }
 
     planner_vector state;
     try {
         state = state_from_blackboard(state_entry->value, "vla-request state");
     } catch (const std::exception& e) {
-        emit_log(ctx, log_level::error, "vla", std::string("vla-request: invalid state: ") + e.what());
-        return status::failure;
+        error = std::string("vla-request: invalid state: ") + e.what();
+        return std::nullopt;
     }
     if (state.empty()) {
-        emit_log(ctx, log_level::error, "vla", "vla-request: state must not be empty");
-        return status::failure;
+        error = "vla-request: state must not be empty";
+        return std::nullopt;
     }
 
     std::string instruction = opts.instruction;
     if (instruction.empty()) {
         const bb_entry* instruction_entry = ctx.bb_get(opts.instruction_key);
         if (!instruction_entry) {
-            emit_log(ctx, log_level::error, "vla", "vla-request: missing instruction key: " + opts.instruction_key);
-            return status::failure;
+            error = "vla-request: missing instruction key: " + opts.instruction_key;
+            return std::nullopt;
         }
         if (const auto* s = std::get_if<std::string>(&instruction_entry->value)) {
             instruction = *s;
         } else {
-            emit_log(ctx, log_level::error, "vla", "vla-request: instruction must be string");
-            return status::failure;
+            error = "vla-request: instruction must be string";
+            return std::nullopt;
         }
     }
 
@@ -1627,24 +2334,24 @@ status execute_vla_request(const node& n, tick_context& ctx, const std::vector<m
             } else if (const auto* i = std::get_if<std::int64_t>(&task_entry->value)) {
                 task_id = std::to_string(*i);
             } else {
-                emit_log(ctx, log_level::error, "vla", "vla-request: task_key must map to string or int");
-                return status::failure;
+                error = "vla-request: task_key must map to string or int";
+                return std::nullopt;
             }
         }
     }
 
     const std::int64_t dims = (opts.dims > 0) ? opts.dims : static_cast<std::int64_t>(state.size());
     if (dims <= 0) {
-        emit_log(ctx, log_level::error, "vla", "vla-request: dims must be > 0");
-        return status::failure;
+        error = "vla-request: dims must be > 0";
+        return std::nullopt;
     }
     if (!std::isfinite(opts.bound_lo) || !std::isfinite(opts.bound_hi) || opts.bound_lo > opts.bound_hi) {
-        emit_log(ctx, log_level::error, "vla", "vla-request: invalid bounds");
-        return status::failure;
+        error = "vla-request: invalid bounds";
+        return std::nullopt;
     }
     if (opts.deadline_ms <= 0) {
-        emit_log(ctx, log_level::error, "vla", "vla-request: deadline_ms must be > 0");
-        return status::failure;
+        error = "vla-request: deadline_ms must be > 0";
+        return std::nullopt;
     }
 
     vla_request request;
@@ -1652,6 +2359,7 @@ status execute_vla_request(const node& n, tick_context& ctx, const std::vector<m
     request.task_id = task_id;
     request.instruction = instruction;
     request.deadline_ms = opts.deadline_ms;
+    request.priority = opts.priority;
     request.model.name = opts.model_name;
     request.model.version = opts.model_version;
     request.node_name = opts.node_name;
@@ -1664,26 +2372,26 @@ status execute_vla_request(const node& n, tick_context& ctx, const std::vector<m
     request.constraints.max_delta = std::max(0.0, opts.max_delta);
     if (opts.forbidden_range.has_value()) {
         if (opts.forbidden_range->first > opts.forbidden_range->second) {
-            emit_log(ctx, log_level::error, "vla", "vla-request: forbidden range must be ordered");
-            return status::failure;
+            error = "vla-request: forbidden range must be ordered";
+            return std::nullopt;
         }
         request.constraints.forbidden_ranges.push_back(*opts.forbidden_range);
     }
 
-    request.observation.state = state;
+    request.observation.state.assign(state.begin(), state.end());
     request.observation.frame_id = opts.frame_id;
     request.observation.timestamp_ms = ms_since_epoch(state_entry->last_write_ts);
 
     if (!opts.image_key.empty()) {
         const bb_entry* image_entry = ctx.bb_get(opts.image_key);
         if (!image_entry) {
-            emit_log(ctx, log_level::error, "vla", "vla-request: missing image key: " + opts.image_key);
-            return status::failure;
+            error = "vla-request: missing image key: " + opts.image_key;
+            return std::nullopt;
         }
         const std::optional<image_handle_ref> image = image_from_blackboard(image_entry->value);
         if (!image.has_value()) {
-            emit_log(ctx, log_level::error, "vla", "vla-request: image key does not hold image_handle");
-            return status::failure;
+            error = "vla-request: image key does not hold image_handle";
+            return std::nullopt;
         }
         request.observation.image = *image;
     }
@@ -1691,13 +2399,13 @@ status execute_vla_request(const node& n, tick_context& ctx, const std::vector<m
     if (!opts.blob_key.empty()) {
         const bb_entry* blob_entry = ctx.bb_get(opts.blob_key);
         if (!blob_entry) {
-            emit_log(ctx, log_level::error, "vla", "vla-request: missing blob key: " + opts.blob_key);
-            return status::failure;
+            error = "vla-request: missing blob key: " + opts.blob_key;
+            return std::nullopt;
         }
         const std::optional<blob_handle_ref> blob = blob_from_blackboard(blob_entry->value);
         if (!blob.has_value()) {
-            emit_log(ctx, log_level::error, "vla", "vla-request: blob key does not hold blob_handle");
-            return status::failure;
+            error = "vla-request: blob key does not hold blob_handle";
+            return std::nullopt;
         }
         request.observation.blob = *blob;
     }
@@ -1718,29 +2426,159 @@ status execute_vla_request(const node& n, tick_context& ctx, const std::vector<m
         request.seed = vla_service::hash64(request.run_id + "::" + request.node_name + "::" + std::to_string(ctx.tick_index));
     }
 
+    return request;
+}
+
+status execute_vla_request(const node& n, tick_context& ctx, std::span<const muslisp::value> args) {
+    if (!ctx.svc.vla) {
+        trace_event ev = make_trace_event(trace_event_kind::error);
+        ev.node = n.id;
+        ev.message = "vla-request: VLA service is not available";
+        emit_trace(ctx, std::move(ev));
+        emit_log(ctx, log_level::error, "vla", "vla-request: VLA service is not available");
+        return status::failure;
+    }
+
+    const vla_request_options opts = parse_vla_request_options(n, args);
+
+    if (const bb_entry* existing = ctx.bb_get(opts.job_key); existing) {
+        if (const auto* existing_id = std::get_if<std::int64_t>(&existing->value); existing_id && *existing_id > 0) {
+            return status::running;
+        }
+    }
+
+    std::string error;
+    std::optional<vla_request> built = build_vla_request(ctx, opts, opts.state_key, error);
+    if (!built.has_value()) {
+        emit_log(ctx, log_level::error, "vla", error);
+        return status::failure;
+    }
+    vla_request& request = *built;
+
+    if (const auto prefetched = ctx.inst.vla_prefetches.find(n.id); prefetched != ctx.inst.vla_prefetches.end()) {
+        const instance::vla_prefetch prefetch = prefetched->second;
+        ctx.inst.vla_prefetches.erase(prefetched);
+        if (prefetch.match_hash == vla_prefetch_hash(request)) {
+            ctx.inst.active_vla_jobs[n.id] = prefetch.job;
+            ctx.bb_put(opts.job_key, bb_value{static_cast<std::int64_t>(prefetch.job)}, opts.node_name);
+            if (event_log* events = event_log_for(ctx, event_family::async); events) {
+                std::ostringstream data;
+                data << "{\"job_id\":\"" << prefetch.job << "\",\"node_id\":" << n.id << ",\"status\":\"prefetch_hit\"}";
+                (void)events->emit("vla_submit", ctx.tick_index, data.str());
+            }
+            emit_log_deferred(ctx, log_level::info, "vla", "prefetch hit job={}", {static_cast<std::uint64_t>(prefetch.job)});
+            return status::running;
+        }
+        // A stale prefetch is left to the submit below: it shares this node's owner key, so the
+        // service supersedes (cancels) it.
+    }
+
     if (!budget_allows_decision_point(ctx, n.id, "vla_submit")) {
         return status::failure;
     }
 
     ++ctx.vla_submits;
-    const vla_service::vla_job_id id = ctx.svc.vla->submit(request);
+    const vla_service::vla_job_id id = [&] {
+        ledger_scope charge(ctx.ledger, ledger_category::vla_submit);
+        return ctx.svc.replay ? ctx.svc.replay->vla_job(ctx.tick_index, n.id).value_or(1) : ctx.svc.vla->submit(request);
+    }();
     ctx.inst.active_vla_jobs[n.id] = id;
     ctx.bb_put(opts.job_key, bb_value{static_cast<std::int64_t>(id)}, opts.node_name);
 
-    if (event_log* events = resolve_event_log(ctx); events) {
+    if (event_log* events = event_log_for(ctx, event_family::async); events) {
         std::ostringstream data;
         data << "{\"job_id\":\"" << id << "\",\"node_id\":" << n.id << ",\"status\":\"submitted\"}";
         (void)events->emit("vla_submit", ctx.tick_index, data.str());
     }
 
-    std::ostringstream msg;
-    msg << "submitted job=" << id << " capability=" << request.capability << " model=" << request.model.name
-        << " deadline_ms=" << request.deadline_ms;
-    emit_log(ctx, log_level::info, "vla", msg.str());
+    emit_log_deferred(ctx,
+                      log_level::info,
+                      "vla",
+                      "submitted job={} capability={} model={} deadline_ms={}",
+                      {static_cast<std::uint64_t>(id), request.capability, request.model.name, request.deadline_ms});
     return status::running;
 }
 
-status execute_vla_wait(const node& n, tick_context& ctx, const std::vector<muslisp::value>& args) {
+const std::vector<node_id>& vla_prefetch_nodes(instance& inst) {
+    if (inst.vla_prefetch_def != inst.def) {
+        inst.vla_prefetch_nodes.clear();
+        for (const node& n : inst.def->nodes) {
+            if (n.kind != node_kind::vla_request) {
+                continue;
+            }
+            for (const arg_value& arg : n.args) {
+                if (normalize_plan_option(arg.text) == "prefetch_key") {
+                    inst.vla_prefetch_nodes.push_back(n.id);
+                    break;
+                }
+            }
+        }
+        inst.vla_prefetch_def = inst.def;
+    }
+    return inst.vla_prefetch_nodes;
+}
+
+// Runs after the root has been ticked. Every vla-request node whose :prefetch_key is set and which
+// has no job in flight submits its next request now, built from the predicted state, so the result
+// may already be ready when the node next ticks. Prefetching is best effort: a request that cannot be
+// built, or a tick with no budget left, simply skips it.
+void prefetch_vla_requests(tick_context& ctx) {
+    // A replay answers the node's own submit with the job the prefetch would have handed it.
+    if (!ctx.svc.vla || ctx.svc.replay) {
+        return;
+    }
+    for (const node_id id : vla_prefetch_nodes(ctx.inst)) {
+        const node& n = ctx.inst.def->nodes[id];
+        try {
+            const vla_request_options opts = parse_vla_request_options(n, ctx.inst.leaf_args(id));
+            const bb_entry* condition = ctx.bb_get(opts.prefetch_key);
+            if (!condition) {
+                continue;
+            }
+            const auto* flag = std::get_if<bool>(&condition->value);
+            const auto* count = std::get_if<std::int64_t>(&condition->value);
+            if (!(flag && *flag) && !(count && *count != 0)) {
+                continue;
+            }
+            if (const bb_entry* existing = ctx.bb_get(opts.job_key); existing) {
+                if (const auto* existing_id = std::get_if<std::int64_t>(&existing->value); existing_id && *existing_id > 0) {
+                    continue;
+                }
+            }
+
+            std::string error;
+            const std::string& state_key = opts.prefetch_state_key.empty() ? opts.state_key : opts.prefetch_state_key;
+            const std::optional<vla_request> request = build_vla_request(ctx, opts, state_key, error);
+            if (!request.has_value()) {
+                continue;
+            }
+            const std::uint64_t match_hash = vla_prefetch_hash(*request);
+            if (const auto it = ctx.inst.vla_prefetches.find(id);
+                it != ctx.inst.vla_prefetches.end() && it->second.match_hash == match_hash) {
+                continue;
+            }
+            if (const std::optional<double> remaining = tick_remaining_ms(ctx); remaining.has_value() && *remaining <= 0.0) {
+                return;
+            }
+
+            ++ctx.vla_submits;
+            const vla_service::vla_job_id job = [&] {
+                ledger_scope charge(ctx.ledger, ledger_category::vla_submit);
+                return ctx.svc.vla->submit(*request);
+            }();
+            ctx.inst.vla_prefetches[id] = instance::vla_prefetch{.job = job, .match_hash = match_hash};
+            if (event_log* events = event_log_for(ctx, event_family::async); events) {
+                std::ostringstream data;
+                data << "{\"job_id\":\"" << job << "\",\"node_id\":" << id << ",\"status\":\"prefetched\"}";
+                (void)events->emit("vla_submit", ctx.tick_index, data.str());
+            }
+        } catch (const std::exception& e) {
+            emit_log_deferred(ctx, log_level::warn, "vla", "vla-request prefetch skipped: {}", {e.what()});
+        }
+    }
+}
+
+status execute_vla_wait(const node& n, tick_context& ctx, std::span<const muslisp::value> args) {
     if (!ctx.svc.vla) {
         emit_log(ctx, log_level::error, "vla", "vla-wait: VLA service is not available");
         return status::failure;
@@ -1751,7 +2589,7 @@ status execute_vla_wait(const node& n, tick_context& ctx, const std::vector<musl
     const bb_entry* job_entry = ctx.bb_get(opts.job_key);
     if (!job_entry) {
         ctx.inst.active_vla_jobs.erase(n.id);
-        emit_log(ctx, log_level::error, "vla", "vla-wait: missing job key: " + opts.job_key);
+        emit_log_deferred(ctx, log_level::error, "vla", "vla-wait: missing job key: {}", {opts.job_key});
         return status::failure;
     }
     const auto* id_raw = std::get_if<std::int64_t>(&job_entry->value);
@@ -1767,9 +2605,12 @@ status execute_vla_wait(const node& n, tick_context& ctx, const std::vector<musl
 
     const auto id = static_cast<vla_service::vla_job_id>(*id_raw);
     ++ctx.vla_polls;
-    const vla_poll poll = ctx.svc.vla->poll(id);
+    const vla_poll poll = [&] {
+        ledger_scope charge(ctx.ledger, ledger_category::vla_poll);
+        return ctx.svc.replay ? ctx.svc.replay->vla_poll_at(ctx.tick_index, n.id) : ctx.svc.vla->poll(id);
+    }();
 
-    if (event_log* events = resolve_event_log(ctx); events) {
+    if (event_log* events = event_log_for(ctx, event_family::async); events) {
         std::ostringstream data;
         data << "{\"job_id\":\"" << id << "\",\"node_id\":" << n.id << ",\"status\":\""
              << vla_job_status_name(poll.status) << "\"}";
@@ -1786,7 +2627,7 @@ status execute_vla_wait(const node& n, tick_context& ctx, const std::vector<musl
         clamp_confidence(poll.partial->confidence) >= opts.early_confidence && action_is_finite(*poll.partial->action_candidate)) {
         ctx.bb_put(opts.action_key, action_to_blackboard(*poll.partial->action_candidate), opts.node_name);
         if (opts.cancel_on_early_commit) {
-            if (event_log* events = resolve_event_log(ctx); events) {
+            if (event_log* events = event_log_for(ctx, event_family::async); events) {
                 std::ostringstream data;
                 data << "{\"job_id\":\"" << id << "\",\"node_id\":" << n.id << ",\"reason\":\"early_commit\"}";
                 (void)events->emit(muesli_bt::contract::kEventAsyncCancelRequested, ctx.tick_index, data.str());
@@ -1810,10 +2651,11 @@ status execute_vla_wait(const node& n, tick_context& ctx, const std::vector<musl
             clear_job_key_if_present(ctx, opts.job_key, opts.node_name);
             ctx.inst.active_vla_jobs.erase(n.id);
         }
-        emit_log(ctx,
-                 log_level::info,
-                 "vla",
-                 "vla-wait: early-committed partial action with confidence=" + std::to_string(poll.partial->confidence));
+        emit_log_deferred(ctx,
+                          log_level::info,
+                          "vla",
+                          "vla-wait: early-committed partial action with confidence={}",
+                          {poll.partial->confidence});
         return status::success;
     }
 
@@ -1829,10 +2671,11 @@ status execute_vla_wait(const node& n, tick_context& ctx, const std::vector<musl
             ctx.inst.active_vla_jobs.erase(n.id);
         }
         emit_log(ctx, log_level::info, "vla", "vla-wait: committed final action");
-        if (event_log* events = resolve_event_log(ctx); events) {
+        if (event_log* events = event_log_for(ctx, event_family::async); events) {
             std::ostringstream data;
+            const std::string action = vla_action_to_json(poll.final->action);
             data << "{\"job_id\":\"" << id << "\",\"node_id\":" << n.id << ",\"status\":\"ok\",\"digest\":\""
-                 << event_log::hash64_hex(vla_action_to_json(poll.final->action)) << "\"}";
+                 << event_log::hash64_hex(action) << "\",\"action\":" << action << "}";
             (void)events->emit("vla_result", ctx.tick_index, data.str());
         }
         return status::success;
@@ -1840,7 +2683,7 @@ status execute_vla_wait(const node& n, tick_context& ctx, const std::vector<musl
 
     if ((poll.status == vla_job_status::cancelled || poll.status == vla_job_status::timeout) && poll.final.has_value() &&
         poll.final->status == vla_status::cancelled) {
-        if (event_log* events = resolve_event_log(ctx); events) {
+        if (event_log* events = event_log_for(ctx, event_family::async); events) {
             std::ostringstream data;
             data << "{\"job_id\":\"" << id << "\",\"node_id\":" << n.id << ",\"reason\":\"completion_after_cancel\"}";
             (void)events->emit(muesli_bt::contract::kEventAsyncCompletionDropped, ctx.tick_index, data.str());
@@ -1876,7 +2719,7 @@ status execute_vla_wait(const node& n, tick_context& ctx, const std::vector<musl
     return status::failure;
 }
 
-status execute_vla_cancel(const node& n, tick_context& ctx, const std::vector<muslisp::value>& args) {
+status execute_vla_cancel(const node& n, tick_context& ctx, std::span<const muslisp::value> args) {
     if (!ctx.svc.vla) {
         emit_log(ctx, log_level::error, "vla", "vla-cancel: VLA service is not available");
         return status::failure;
@@ -1896,7 +2739,7 @@ status execute_vla_cancel(const node& n, tick_context& ctx, const std::vector<mu
     }
 
     const auto id = static_cast<vla_service::vla_job_id>(*id_raw);
-    if (event_log* events = resolve_event_log(ctx); events) {
+    if (event_log* events = event_log_for(ctx, event_family::async); events) {
         std::ostringstream req_data;
         req_data << "{\"job_id\":\"" << id << "\",\"node_id\":" << n.id << ",\"reason\":\"explicit_cancel\"}";
         (void)events->emit(muesli_bt::contract::kEventAsyncCancelRequested, ctx.tick_index, req_data.str());
@@ -1904,8 +2747,8 @@ status execute_vla_cancel(const node& n, tick_context& ctx, const std::vector<mu
     const bool accepted = ctx.svc.vla->cancel(id);
     clear_job_key_if_present(ctx, opts.job_key, opts.node_name);
     ctx.inst.active_vla_jobs.erase(n.id);
-    emit_log(ctx, log_level::info, "vla", "vla-cancel: cancelled job=" + std::to_string(id));
-    if (event_log* events = resolve_event_log(ctx); events) {
+    emit_log_deferred(ctx, log_level::info, "vla", "vla-cancel: cancelled job={}", {static_cast<std::uint64_t>(id)});
+    if (event_log* events = event_log_for(ctx, event_family::async); events) {
         std::ostringstream ack_data;
         ack_data << "{\"job_id\":\"" << id << "\",\"node_id\":" << n.id << ",\"accepted\":"
                  << (accepted ? "true" : "false") << "}";
@@ -1926,8 +2769,203 @@ status execute_vla_cancel(const node& n, tick_context& ctx, const std::vector<mu
     return status::success;
 }
 
+std::string vla_chunk_to_json(const std::vector<vla_chunk_step>& steps) {
+    std::ostringstream out;
+    out << '[';
+    for (std::size_t k = 0; k < steps.size(); ++k) {
+        out << (k == 0 ? "{\"u\":[" : ",{\"u\":[");
+        for (std::size_t i = 0; i < steps[k].u.size(); ++i) {
+            if (i != 0) {
+                out << ',';
+            }
+            out << json_double(steps[k].u[i], false);
+        }
+        out << "],\"dt_ms\":" << json_double(steps[k].dt_ms, false) << '}';
+    }
+    out << ']';
+    return out.str();
+}
+
+// Takes the finished job's result as the node's new chunk, timed from this tick. Returns an empty
+// string on success and the failure reason otherwise.
+std::string take_vla_chunk_result(const node& n,
+                                  tick_context& ctx,
+                                  const vla_chunk_options& opts,
+                                  instance::vla_chunk_buffer& buffer,
+                                  std::uint64_t id,
+                                  const vla_poll& poll) {
+    if (poll.status != vla_job_status::done || !poll.final.has_value() || poll.final->status != vla_status::ok) {
+        if (poll.status == vla_job_status::timeout ||
+            (poll.final.has_value() && poll.final->status == vla_status::timeout)) {
+            emit_outcome_event(ctx, muesli_bt::contract::kEventVlaTimeout, "vla_chunk", n.id, std::to_string(id), "timeout");
+        }
+        if (!poll.final.has_value()) {
+            return "vla-chunk: job status=" + std::string(vla_job_status_name(poll.status));
+        }
+        std::string reason = "vla-chunk: status=" + std::string(vla_status_name(poll.final->status));
+        if (!poll.final->explanation.empty()) {
+            reason += " " + poll.final->explanation;
+        }
+        return reason;
+    }
+
+    std::vector<vla_chunk_step> steps = poll.final->chunk;
+    if (steps.empty() && poll.final->action.type == vla_action_type::continuous) {
+        steps.push_back(vla_chunk_step{.u = poll.final->action.u, .dt_ms = opts.step_ms});
+    }
+    const bool usable = !steps.empty() && std::all_of(steps.begin(), steps.end(), [](const vla_chunk_step& step) {
+        return !step.u.empty() && std::isfinite(step.dt_ms) && step.dt_ms > 0.0 &&
+               std::all_of(step.u.begin(), step.u.end(), [](double v) { return std::isfinite(v); });
+    });
+    if (!usable) {
+        return "vla-chunk: result holds no finite continuous action";
+    }
+
+    buffer.steps = std::move(steps);
+    buffer.started_at = ctx.now;
+    if (event_log* events = event_log_for(ctx, event_family::async); events) {
+        std::ostringstream data;
+        const std::string action = vla_action_to_json(poll.final->action);
+        data << "{\"job_id\":\"" << id << "\",\"node_id\":" << n.id << ",\"status\":\"ok\",\"digest\":\""
+             << event_log::hash64_hex(action) << "\",\"action\":" << action
+             << ",\"chunk\":" << vla_chunk_to_json(buffer.steps) << "}";
+        (void)events->emit("vla_result", ctx.tick_index, data.str());
+    }
+    emit_log_deferred(ctx, log_level::info, "vla", "vla-chunk: buffered {} steps", {static_cast<std::uint64_t>(buffer.steps.size())});
+    return {};
+}
+
+// Executes a buffered action chunk. Each tick writes the step the chunk has reached, measured from
+// the tick its result arrived, interpolated toward the next step when :interpolate is on. While at
+// most :refill_below steps remain, the next chunk is requested in the background; it replaces the
+// current one when it arrives. The node fails only when it has no step to serve and no request in
+// flight.
+status execute_vla_chunk(const node& n, tick_context& ctx, std::span<const muslisp::value> args) {
+    if (!ctx.svc.vla) {
+        emit_log(ctx, log_level::error, "vla", "vla-chunk: VLA service is not available");
+        return status::failure;
+    }
+
+    const vla_chunk_options opts = parse_vla_chunk_options(n, args);
+    instance::vla_chunk_buffer& buffer = ctx.inst.vla_chunks[n.id];
+
+    std::string failure_reason;
+    if (buffer.job != 0 && budget_allows_decision_point(ctx, n.id, "vla_poll")) {
+        const std::uint64_t id = buffer.job;
+        ++ctx.vla_polls;
+        const vla_poll poll = [&] {
+            ledger_scope charge(ctx.ledger, ledger_category::vla_poll);
+            return ctx.svc.replay ? ctx.svc.replay->vla_poll_at(ctx.tick_index, n.id) : ctx.svc.vla->poll(id);
+        }();
+        if (event_log* events = event_log_for(ctx, event_family::async); events) {
+            std::ostringstream data;
+            data << "{\"job_id\":\"" << id << "\",\"node_id\":" << n.id << ",\"status\":\""
+                 << vla_job_status_name(poll.status) << "\"}";
+            (void)events->emit("vla_poll", ctx.tick_index, data.str());
+        }
+        if (poll.status != vla_job_status::queued && poll.status != vla_job_status::running &&
+            poll.status != vla_job_status::streaming) {
+            buffer.job = 0;
+            ctx.inst.active_vla_jobs.erase(n.id);
+            failure_reason = take_vla_chunk_result(n, ctx, opts, buffer, id, poll);
+        }
+    }
+
+    std::size_t remaining = 0;
+    if (!buffer.steps.empty()) {
+        const double elapsed_ms = std::max(0.0, std::chrono::duration<double, std::milli>(ctx.now - buffer.started_at).count());
+        double step_start = 0.0;
+        for (std::size_t k = 0; k < buffer.steps.size(); ++k) {
+            const vla_chunk_step& step = buffer.steps[k];
+            if (elapsed_ms < step_start + step.dt_ms) {
+                vla_action action;
+                action.u = step.u;
+                if (opts.interpolate && k + 1 < buffer.steps.size() && buffer.steps[k + 1].u.size() == step.u.size()) {
+                    const double alpha = std::clamp((elapsed_ms - step_start) / step.dt_ms, 0.0, 1.0);
+                    for (std::size_t i = 0; i < action.u.size(); ++i) {
+                        action.u[i] += alpha * (buffer.steps[k + 1].u[i] - action.u[i]);
+                    }
+                }
+                ctx.bb_put(opts.action_key, action_to_blackboard(action), opts.request.node_name);
+                remaining = buffer.steps.size() - k;
+                break;
+            }
+            step_start += step.dt_ms;
+        }
+        if (remaining == 0) {
+            buffer.steps.clear();
+        }
+    }
+
+    // A failed request is retried from the next tick, not this one.
+    if (buffer.job == 0 && failure_reason.empty() && remaining <= static_cast<std::size_t>(std::max<std::int64_t>(0, opts.refill_below))) {
+        std::string error;
+        const std::optional<vla_request> request = build_vla_request(ctx, opts.request, opts.request.state_key, error);
+        if (!request.has_value()) {
+            failure_reason = error;
+        } else if (budget_allows_decision_point(ctx, n.id, "vla_submit")) {
+            ++ctx.vla_submits;
+            const vla_service::vla_job_id id = [&] {
+                ledger_scope charge(ctx.ledger, ledger_category::vla_submit);
+                return ctx.svc.replay ? ctx.svc.replay->vla_job(ctx.tick_index, n.id).value_or(1) : ctx.svc.vla->submit(*request);
+            }();
+            buffer.job = id;
+            ctx.inst.active_vla_jobs[n.id] = id;
+            if (event_log* events = event_log_for(ctx, event_family::async); events) {
+                std::ostringstream data;
+                data << "{\"job_id\":\"" << id << "\",\"node_id\":" << n.id << ",\"status\":\"submitted\"}";
+                (void)events->emit("vla_submit", ctx.tick_index, data.str());
+            }
+        }
+    }
+
+    if (!failure_reason.empty()) {
+        emit_log(ctx, remaining > 0 ? log_level::warn : log_level::error, "vla", failure_reason);
+    }
+    if (remaining > 0) {
+        return status::success;
+    }
+    return buffer.job != 0 && failure_reason.empty() ? status::running : status::failure;
+}
+
 status tick_node(node_id id, tick_context& ctx);
 
+void ensure_leaves_linked(tick_context& ctx) {
+    if (ctx.inst.leaf_bindings_generation != ctx.reg.generation()) {
+        ctx.inst.link_leaves(ctx.reg);
+    }
+}
+
+// Callback index bound to a cond/act leaf, relinking the instance first if the registry changed.
+std::uint32_t leaf_binding(tick_context& ctx, node_id id) {
+    ensure_leaves_linked(ctx);
+    return ctx.inst.leaf_binding(id);
+}
+
+// Memo of a pure node under incremental ticking, or nullptr.
+node_memo* pure_node_memo(tick_context& ctx, node_id id) {
+    if (!ctx.inst.incremental_tick) {
+        return nullptr;
+    }
+    ensure_leaves_linked(ctx);
+    if (id >= ctx.inst.node_memos.size() || !ctx.inst.node_memos[id].pure) {
+        return nullptr;
+    }
+    return &ctx.inst.node_memos[id];
+}
+
+bool memo_current(const instance& inst, const node_memo& memo) {
+    if (!memo.valid) {
+        return false;
+    }
+    for (std::uint32_t i = 0; i < memo.reads_count; ++i) {
+        if (inst.bb.write_version(inst.memo_reads[memo.reads_offset + i]) > memo.evaluated_at) {
+            return false;
+        }
+    }
+    return true;
+}
+
 std::size_t clamp_child_index(const node& n, std::int64_t raw_index) {
     if (raw_index < 0) {
         return 0;
@@ -1967,10 +3005,9 @@ void emit_node_halt(tick_context& ctx, node_id halted_node, std::string_view rea
     if (!trace_capture_enabled(ctx)) {
         return;
     }
-    trace_event ev = make_trace_event(trace_event_kind::node_halt);
-    ev.node = halted_node;
-    ev.message = std::string(reason);
-    emit_trace(ctx, std::move(ev));
+    trace_record rec = make_trace_record(trace_event_kind::node_halt);
+    rec.node = halted_node;
+    emit_trace(ctx, rec, {}, {}, reason);
 }
 
 void emit_node_preempt(tick_context& ctx, node_id from_node, node_id to_node, std::string_view reason) {
@@ -2020,6 +3057,7 @@ bool try_cancel_scheduler_leaf(tick_context& ctx, node_memory& mem, std::string_
     mem.b0 = false;
     mem.i0 = 0;
     mem.i1 = static_cast<std::int64_t>(job_status::unknown);
+    mem.job_notified = false;
     return true;
 }
 
@@ -2028,6 +3066,8 @@ void halt_subtree_impl(tick_context& ctx, node_id root, std::string_view reason)
         return;
     }
 
+    // Only the root and nodes whose subtree holds touched memory are visited; the rest are idle.
+    const std::uint32_t live = ctx.inst.live_memory_nodes[root];
     halt_stack_scope stack_scope(ctx.inst);
     std::vector<node_id>& stack = stack_scope.get();
     stack.push_back(root);
@@ -2038,12 +3078,18 @@ void halt_subtree_impl(tick_context& ctx, node_id root, std::string_view reason)
 
         emit_node_halt(ctx, id, reason);
 
-        const auto mem_it = ctx.inst.memory.find(id);
-        if (n.kind == node_kind::act && mem_it != ctx.inst.memory.end()) {
-            node_memory& mem = mem_it->second;
+        const bool has_memory = ctx.inst.memory_touched[id] != 0u;
+        if (n.kind == node_kind::act && has_memory) {
+            node_memory& mem = ctx.inst.memory[id];
             bool halted = false;
 
-            if (const action_halt_fn* halt_fn = ctx.reg.find_action_halt(n.leaf_name); halt_fn) {
+            const std::uint32_t binding = leaf_binding(ctx, id);
+            const action_halt_fn* halt_fn = binding == registry::k_unbound ? nullptr : ctx.reg.action_halt_at(binding);
+            if (mem.task) {
+                // Destroying the frame below is the halt; only a job it awaits needs cancelling.
+                (void)try_cancel_scheduler_leaf(ctx, mem, reason);
+                halted = true;
+            } else if (halt_fn) {
                 try {
                     (*halt_fn)(ctx, id, mem);
                     halted = true;
@@ -2063,11 +3109,20 @@ void halt_subtree_impl(tick_context& ctx, node_id root, std::string_view reason)
             }
         }
 
-        if (mem_it != ctx.inst.memory.end()) {
-            mem_it->second = node_memory{};
+        if (has_memory) {
+            ctx.inst.memory[id] = node_memory{};
+            ctx.inst.memory_touched[id] = 0u;
         }
+        ctx.inst.live_memory_nodes[id] = 0u;
         for (node_id child : n.children) {
-            stack.push_back(child);
+            if (ctx.inst.live_memory_nodes[child] != 0u) {
+                stack.push_back(child);
+            }
+        }
+    }
+    if (live != 0u) {
+        for (node_id at = ctx.inst.node_parents[root]; at != instance::k_no_parent; at = ctx.inst.node_parents[at]) {
+            ctx.inst.live_memory_nodes[at] -= live;
         }
     }
 }
@@ -2218,19 +3273,289 @@ status tick_reactive_sel(const node& n, tick_context& ctx) {
     return status::failure;
 }
 
+status tick_condition(const node& n, tick_context& ctx) {
+    const std::uint32_t binding = leaf_binding(ctx, n.id);
+    if (binding == registry::k_unbound) {
+        trace_event ev = make_trace_event(trace_event_kind::error);
+        ev.node = n.id;
+        ev.message = "missing condition callback: " + n.leaf_name;
+        emit_trace(ctx, std::move(ev));
+        emit_log_deferred(ctx, log_level::error, "bt", "missing condition callback: {}", {n.leaf_name});
+        return status::failure;
+    }
+
+    const registry::condition_entry& entry = ctx.reg.condition_at(binding);
+    const auto precomputed = std::find_if(ctx.precomputed_conditions.begin(),
+                                          ctx.precomputed_conditions.end(),
+                                          [&](const precomputed_condition& result) { return result.node == n.id; });
+    try {
+        bool out = false;
+        if (precomputed != ctx.precomputed_conditions.end()) {
+            if (precomputed->threw) {
+                throw bt_runtime_error(precomputed->error);
+            }
+            out = precomputed->value;
+        } else if (entry.native.invoke) {
+            const std::optional<std::span<const native_arg>> native = ctx.inst.native_leaf_args(n.id);
+            if (!native) {
+                throw bt_runtime_error("native condition arguments do not match its signature: " + n.leaf_name);
+            }
+            ledger_scope charge(ctx.ledger, ledger_category::native_leaves);
+            out = entry.native.invoke(entry.native.callable.get(), ctx, *native);
+        } else {
+            ledger_scope charge(ctx.ledger, ledger_category::lisp_leaves);
+            out = entry.fn(ctx, ctx.inst.leaf_args(n.id));
+        }
+        return out ? status::success : status::failure;
+    } catch (const std::exception& e) {
+        ++ctx.condition_errors;
+        trace_event ev = make_trace_event(trace_event_kind::error);
+        ev.node = n.id;
+        ev.message = std::string("condition threw: ") + e.what();
+        emit_trace(ctx, std::move(ev));
+        emit_log_deferred(ctx, log_level::error, "bt", "condition threw: {}", {e.what()});
+        return status::failure;
+    }
+}
+
+status tick_action(const node& n, tick_context& ctx) {
+    const std::uint32_t binding = leaf_binding(ctx, n.id);
+    if (binding == registry::k_unbound) {
+        trace_event ev = make_trace_event(trace_event_kind::error);
+        ev.node = n.id;
+        ev.message = "missing action callback: " + n.leaf_name;
+        emit_trace(ctx, std::move(ev));
+        emit_log_deferred(ctx, log_level::error, "bt", "missing action callback: {}", {n.leaf_name});
+        return status::failure;
+    }
+
+    node_memory& mem = node_memory_for(ctx.inst, n.id);
+    const registry::action_entry& entry = ctx.reg.action_at(binding);
+    try {
+        if (entry.coroutine) {
+            ledger_scope charge(ctx.ledger, ledger_category::native_leaves);
+            if (!mem.task) {
+                mem.task = entry.coroutine(action_context(n.id, ctx.inst.leaf_args(n.id)));
+            }
+            return mem.task.tick(ctx);
+        }
+        if (entry.native.invoke) {
+            const std::optional<std::span<const native_arg>> native = ctx.inst.native_leaf_args(n.id);
+            if (!native) {
+                throw bt_runtime_error("native action arguments do not match its signature: " + n.leaf_name);
+            }
+            ledger_scope charge(ctx.ledger, ledger_category::native_leaves);
+            return entry.native.invoke(entry.native.callable.get(), ctx, n.id, mem, *native);
+        }
+        ledger_scope charge(ctx.ledger, ledger_category::lisp_leaves);
+        return entry.fn(ctx, n.id, mem, ctx.inst.leaf_args(n.id));
+    } catch (const std::exception& e) {
+        trace_event ev = make_trace_event(trace_event_kind::error);
+        ev.node = n.id;
+        ev.message = std::string("action threw: ") + e.what();
+        emit_trace(ctx, std::move(ev));
+        emit_log_deferred(ctx, log_level::error, "bt", "action threw: {}", {e.what()});
+        return status::failure;
+    }
+}
+
+// One thread-safe child condition of a `par` node. Whoever claims the slot first, a scheduler worker
+// or the ticking thread, evaluates it; the batch outlives the tick if a job has not started yet.
+struct par_condition_slot {
+    node_id node = 0;
+    const registry::condition_entry* entry = nullptr;
+    std::span<const native_arg> args;
+    std::atomic<bool> claimed{false};
+    bool value = false;
+    bool threw = false;
+    std::string error;
+};
+
+struct par_condition_batch {
+    par_condition_batch(const tick_context& tick, std::size_t count) : ctx(tick), slots(count) {}
+
+    tick_context ctx;
+    std::vector<par_condition_slot> slots;
+    std::atomic<std::size_t> pending{0};
+};
+
+void run_par_condition(par_condition_batch& batch, par_condition_slot& slot) {
+    if (slot.claimed.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+    tick_context local = batch.ctx;
+    local.current_node = slot.node;
+    local.ledger = nullptr;
+    try {
+        slot.value = slot.entry->native.invoke(slot.entry->native.callable.get(), local, slot.args);
+    } catch (const std::exception& e) {
+        slot.threw = true;
+        slot.error = e.what();
+    } catch (...) {
+        slot.threw = true;
+        slot.error = "unknown exception";
+    }
+    batch.pending.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+// The entry of child `id` when it is a bound native condition declared thread-safe.
+const registry::condition_entry* thread_safe_condition(tick_context& ctx, node_id id) {
+    const node& child = get_node(*ctx.inst.def, id);
+    if (child.kind != node_kind::cond) {
+        return nullptr;
+    }
+    const std::uint32_t binding = leaf_binding(ctx, id);
+    if (binding == registry::k_unbound) {
+        return nullptr;
+    }
+    const registry::condition_entry& entry = ctx.reg.condition_at(binding);
+    if (!entry.native.invoke || !entry.reads || !entry.reads->thread_safe || !ctx.inst.native_leaf_args(id)) {
+        return nullptr;
+    }
+    return &entry;
+}
+
+// Evaluates the thread-safe condition children of `n` that have not completed, one per scheduler job
+// with the ticking thread taking any job no worker has started. Empty when fewer than two qualify,
+// there is no scheduler, or read tracing needs every read on the ticking thread.
+std::vector<precomputed_condition> evaluate_par_conditions(const node& n, tick_context& ctx, std::uint64_t completed) {
+    std::vector<precomputed_condition> out;
+    if (!ctx.svc.sched || ctx.inst.read_trace_enabled) {
+        return out;
+    }
+    std::vector<std::pair<node_id, const registry::condition_entry*>> eligible;
+    for (std::size_t i = 0; i < n.children.size(); ++i) {
+        if ((completed & (std::uint64_t{1} << i)) != 0u) {
+            continue;
+        }
+        if (const registry::condition_entry* entry = thread_safe_condition(ctx, n.children[i])) {
+            eligible.emplace_back(n.children[i], entry);
+        }
+    }
+    if (eligible.size() < 2) {
+        return out;
+    }
+
+    auto batch = std::make_shared<par_condition_batch>(ctx, eligible.size());
+    for (std::size_t i = 0; i < eligible.size(); ++i) {
+        par_condition_slot& slot = batch->slots[i];
+        slot.node = eligible[i].first;
+        slot.entry = eligible[i].second;
+        slot.args = *ctx.inst.native_leaf_args(slot.node);
+    }
+    batch->pending.store(eligible.size(), std::memory_order_release);
+    for (std::size_t i = 1; i < eligible.size(); ++i) {
+        job_request req;
+        req.task_name = "par-condition";
+        req.priority = job_priority::high;
+        req.fn = [batch, i]() {
+            run_par_condition(*batch, batch->slots[i]);
+            return job_result{};
+        };
+        try {
+            (void)ctx.svc.sched->submit(std::move(req));
+        } catch (const std::exception&) {
+            // A full scheduler leaves the slot for the ticking thread.
+        }
+    }
+    for (par_condition_slot& slot : batch->slots) {
+        run_par_condition(*batch, slot);
+    }
+    while (batch->pending.load(std::memory_order_acquire) != 0u) {
+        std::this_thread::yield();
+    }
+
+    out.reserve(batch->slots.size());
+    for (par_condition_slot& slot : batch->slots) {
+        out.push_back(precomputed_condition{slot.node, slot.value, slot.threw, std::move(slot.error)});
+    }
+    return out;
+}
+
+// i0 and i1 hold the masks of children that succeeded and failed since the node started; b0 marks a
+// node resumed from an earlier tick, whose not-yet-visited children may still be running.
+status tick_par(const node& n, tick_context& ctx) {
+    node_memory& mem = node_memory_for(ctx.inst, n.id);
+    const auto success_threshold = static_cast<int>(n.args[0].int_v);
+    const auto failure_threshold = static_cast<int>(n.args[1].int_v);
+    auto succeeded = static_cast<std::uint64_t>(mem.i0);
+    auto failed = static_cast<std::uint64_t>(mem.i1);
+    const bool resumed = mem.b0;
+
+    const std::vector<precomputed_condition> precomputed = evaluate_par_conditions(n, ctx, succeeded | failed);
+    const std::span<const precomputed_condition> outer_precomputed = ctx.precomputed_conditions;
+    if (!precomputed.empty()) {
+        ctx.precomputed_conditions = precomputed;
+    }
+
+    status result = status::running;
+    std::size_t visited = 0;
+    for (; visited < n.children.size(); ++visited) {
+        const std::uint64_t bit = std::uint64_t{1} << visited;
+        if (((succeeded | failed) & bit) != 0u) {
+            continue;
+        }
+        const status child_st = tick_node(n.children[visited], ctx);
+        if (child_st == status::success) {
+            succeeded |= bit;
+        } else if (child_st == status::failure) {
+            failed |= bit;
+        }
+        if (std::popcount(succeeded) >= success_threshold) {
+            result = status::success;
+            break;
+        }
+        if (std::popcount(failed) >= failure_threshold) {
+            result = status::failure;
+            break;
+        }
+    }
+    ctx.precomputed_conditions = outer_precomputed;
+
+    if (result == status::running) {
+        mem.i0 = static_cast<std::int64_t>(succeeded);
+        mem.i1 = static_cast<std::int64_t>(failed);
+        mem.b0 = true;
+        return status::running;
+    }
+    for (std::size_t i = 0; i < n.children.size(); ++i) {
+        const bool completed = ((succeeded | failed) & (std::uint64_t{1} << i)) != 0u;
+        if (!completed && (i < visited || resumed)) {
+            halt_subtree_impl(ctx, n.children[i], "par complete");
+        }
+    }
+    mem = node_memory{};
+    return result;
+}
+
 status tick_node(node_id id, tick_context& ctx) {
     const node& n = get_node(*ctx.inst.def, id);
     node_scope scope(ctx, n);
 
-    auto finalize = [&ctx, &n, &scope](status st) {
-        if (ctx.node_path.size() >= ctx.last_node_path.size()) {
-            ctx.last_node_path = ctx.node_path;
-            ctx.terminal_node_id = n.id;
-        }
+    std::optional<std::uint64_t> memo_started_at;
+    const std::uint64_t condition_errors_before = ctx.condition_errors;
+    auto finalize = [&](status st) {
+        note_node_result(ctx, n);
         scope.set_status(st);
+        if (memo_started_at && ctx.condition_errors == condition_errors_before && id < ctx.inst.node_memos.size() &&
+            ctx.inst.node_memos[id].pure) {
+            node_memo& memo = ctx.inst.node_memos[id];
+            memo.result = st;
+            memo.evaluated_at = *memo_started_at;
+            memo.valid = true;
+        }
         return st;
     };
 
+    // Pure subtrees are not descended while nothing they read has been written since their memo.
+    if (node_memo* memo = pure_node_memo(ctx, id)) {
+        if (memo_current(ctx.inst, *memo)) {
+            ++ctx.inst.tree_stats.memo_hit_count;
+            return finalize(memo->result);
+        }
+        memo_started_at = ctx.inst.bb.write_count();
+    }
+
     switch (n.kind) {
         case node_kind::seq: {
             for (node_id child : n.children) {
@@ -2273,6 +3598,9 @@ status tick_node(node_id id, tick_context& ctx) {
         case node_kind::reactive_sel:
             return finalize(tick_reactive_sel(n, ctx));
 
+        case node_kind::par:
+            return finalize(tick_par(n, ctx));
+
         case node_kind::invert: {
             const status st = tick_node(n.children[0], ctx);
             if (st == status::success) {
@@ -2323,134 +3651,62 @@ status tick_node(node_id id, tick_context& ctx) {
             return finalize(status::failure);
         }
 
-        case node_kind::cond: {
-            const condition_fn* fn = ctx.reg.find_condition(n.leaf_name);
-            if (!fn) {
-                trace_event ev = make_trace_event(trace_event_kind::error);
-                ev.node = n.id;
-                ev.message = "missing condition callback: " + n.leaf_name;
-                emit_trace(ctx, std::move(ev));
-                emit_log(ctx, log_level::error, "bt", "missing condition callback: " + n.leaf_name);
-                return finalize(status::failure);
-            }
+        case node_kind::cond:
+            return finalize(tick_condition(n, ctx));
 
-            std::vector<muslisp::value> args;
-            args.reserve(n.args.size());
-            muslisp::gc_root_scope roots(muslisp::default_gc());
-            for (const arg_value& compiled : n.args) {
-                args.push_back(materialize_arg(compiled));
-                roots.add(&args.back());
-            }
+        case node_kind::act:
+            return finalize(tick_action(n, ctx));
 
+        case node_kind::plan_action: {
+            const std::span<const muslisp::value> args = ctx.inst.leaf_args(n.id);
             try {
-                const bool out = (*fn)(ctx, std::span<const muslisp::value>(args));
-                return finalize(out ? status::success : status::failure);
+                return finalize(execute_plan_action(n, ctx, args));
             } catch (const std::exception& e) {
                 trace_event ev = make_trace_event(trace_event_kind::error);
                 ev.node = n.id;
-                ev.message = std::string("condition threw: ") + e.what();
+                ev.message = std::string("plan-action failed: ") + e.what();
                 emit_trace(ctx, std::move(ev));
-                emit_log(ctx, log_level::error, "bt", std::string("condition threw: ") + e.what());
+                emit_log_deferred(ctx, log_level::error, "planner", "plan-action failed: {}", {e.what()});
                 return finalize(status::failure);
             }
         }
 
-        case node_kind::act: {
-            const action_fn* fn = ctx.reg.find_action(n.leaf_name);
-            if (!fn) {
-                trace_event ev = make_trace_event(trace_event_kind::error);
-                ev.node = n.id;
-                ev.message = "missing action callback: " + n.leaf_name;
-                emit_trace(ctx, std::move(ev));
-                emit_log(ctx, log_level::error, "bt", "missing action callback: " + n.leaf_name);
+        case node_kind::vla_request: {
+            const std::span<const muslisp::value> args = ctx.inst.leaf_args(n.id);
+            try {
+                return finalize(execute_vla_request(n, ctx, args));
+            } catch (const std::exception& e) {
+                emit_log_deferred(ctx, log_level::error, "vla", "vla-request failed: {}", {e.what()});
                 return finalize(status::failure);
             }
+        }
 
-            node_memory& mem = node_memory_for(ctx.inst, n.id);
-            std::vector<muslisp::value> args;
-            args.reserve(n.args.size());
-            muslisp::gc_root_scope roots(muslisp::default_gc());
-            for (const arg_value& compiled : n.args) {
-                args.push_back(materialize_arg(compiled));
-                roots.add(&args.back());
-            }
-
+        case node_kind::vla_wait: {
+            const std::span<const muslisp::value> args = ctx.inst.leaf_args(n.id);
             try {
-                return finalize((*fn)(ctx, n.id, mem, std::span<const muslisp::value>(args)));
+                return finalize(execute_vla_wait(n, ctx, args));
             } catch (const std::exception& e) {
-                trace_event ev = make_trace_event(trace_event_kind::error);
-                ev.node = n.id;
-                ev.message = std::string("action threw: ") + e.what();
-                emit_trace(ctx, std::move(ev));
-                emit_log(ctx, log_level::error, "bt", std::string("action threw: ") + e.what());
+                emit_log_deferred(ctx, log_level::error, "vla", "vla-wait failed: {}", {e.what()});
                 return finalize(status::failure);
             }
         }
 
-        case node_kind::plan_action: {
-            std::vector<muslisp::value> args;
-            args.reserve(n.args.size());
-            muslisp::gc_root_scope roots(muslisp::default_gc());
-            for (const arg_value& compiled : n.args) {
-                args.push_back(materialize_arg(compiled));
-                roots.add(&args.back());
-            }
+        case node_kind::vla_cancel: {
+            const std::span<const muslisp::value> args = ctx.inst.leaf_args(n.id);
             try {
-                return finalize(execute_plan_action(n, ctx, args));
+                return finalize(execute_vla_cancel(n, ctx, args));
             } catch (const std::exception& e) {
-                trace_event ev = make_trace_event(trace_event_kind::error);
-                ev.node = n.id;
-                ev.message = std::string("plan-action failed: ") + e.what();
-                emit_trace(ctx, std::move(ev));
-                emit_log(ctx, log_level::error, "planner", std::string("plan-action failed: ") + e.what());
-                return finalize(status::failure);
-            }
-        }
-
-        case node_kind::vla_request: {
-            std::vector<muslisp::value> args;
-            args.reserve(n.args.size());
-            muslisp::gc_root_scope roots(muslisp::default_gc());
-            for (const arg_value& compiled : n.args) {
-                args.push_back(materialize_arg(compiled));
-                roots.add(&args.back());
-            }
-            try {
-                return finalize(execute_vla_request(n, ctx, args));
-            } catch (const std::exception& e) {
-                emit_log(ctx, log_level::error, "vla", std::string("vla-request failed: ") + e.what());
+                emit_log_deferred(ctx, log_level::error, "vla", "vla-cancel failed: {}", {e.what()});
                 return finalize(status::failure);
             }
         }
 
-        case node_kind::vla_wait: {
-            std::vector<muslisp::value> args;
-            args.reserve(n.args.size());
-            muslisp::gc_root_scope roots(muslisp::default_gc());
-            for (const arg_value& compiled : n.args) {
-                args.push_back(materialize_arg(compiled));
-                roots.add(&args.back());
-            }
+        case node_kind::vla_chunk: {
+            const std::span<const muslisp::value> args = ctx.inst.leaf_args(n.id);
             try {
-                return finalize(execute_vla_wait(n, ctx, args));
+                return finalize(execute_vla_chunk(n, ctx, args));
             } catch (const std::exception& e) {
-                emit_log(ctx, log_level::error, "vla", std::string("vla-wait failed: ") + e.what());
-                return finalize(status::failure);
-            }
-        }
-
-        case node_kind::vla_cancel: {
-            std::vector<muslisp::value> args;
-            args.reserve(n.args.size());
-            muslisp::gc_root_scope roots(muslisp::default_gc());
-            for (const arg_value& compiled : n.args) {
-                args.push_back(materialize_arg(compiled));
-                roots.add(&args.back());
-            }
-            try {
-                return finalize(execute_vla_cancel(n, ctx, args));
-            } catch (const std::exception& e) {
-                emit_log(ctx, log_level::error, "vla", std::string("vla-cancel failed: ") + e.what());
+                emit_log_deferred(ctx, log_level::error, "vla", "vla-chunk failed: {}", {e.what()});
                 return finalize(status::failure);
             }
         }
@@ -2466,58 +3722,472 @@ status tick_node(node_id id, tick_context& ctx) {
     return finalize(status::failure);
 }
 
+status tick_program_leaf(const node& n, tick_context& ctx) {
+    switch (n.kind) {
+        case node_kind::cond:
+            return tick_condition(n, ctx);
+        case node_kind::act:
+            return tick_action(n, ctx);
+        case node_kind::succeed:
+            return status::success;
+        case node_kind::running:
+            return status::running;
+        default:
+            return status::failure;
+    }
+}
+
+// Index of the first guard of `table` whose comparison can hold, or nullopt when the guards are not
+// bound to a comparison the table supports or read tracing must see every guard's read.
+std::optional<std::uint32_t> first_possible_guard(const tick_guard_table& table, tick_context& ctx) {
+    if (ctx.inst.read_trace_enabled) {
+        return std::nullopt;
+    }
+    const std::uint32_t binding = leaf_binding(ctx, table.guard_conds.front());
+    if (binding == registry::k_unbound) {
+        return std::nullopt;
+    }
+    const registry::condition_entry& entry = ctx.reg.condition_at(binding);
+    if (!entry.reads) {
+        return std::nullopt;
+    }
+    const auto none = static_cast<std::uint32_t>(table.guard_conds.size());
+    const bb_entry* value = table.key_index < ctx.inst.bb_key_slots.size()
+                                ? ctx.inst.bb.get(ctx.inst.bb_key_slots[table.key_index])
+                                : nullptr;
+    switch (entry.reads->test) {
+        case condition_test::bb_equals: {
+            if (!table.has_equality_cases) {
+                return std::nullopt;
+            }
+            if (!value) {
+                return none;
+            }
+            if (const auto* i = std::get_if<std::int64_t>(&value->value)) {
+                const auto found = table.int_cases.find(*i);
+                return found == table.int_cases.end() ? none : found->second;
+            }
+            if (const auto* b = std::get_if<bool>(&value->value)) {
+                return table.bool_cases[*b ? 1 : 0];
+            }
+            if (const auto* s = std::get_if<std::string>(&value->value)) {
+                const auto found = table.text_cases.find(*s);
+                return found == table.text_cases.end() ? none : found->second;
+            }
+            return none;
+        }
+        case condition_test::bb_less: {
+            if (table.thresholds.empty()) {
+                return std::nullopt;
+            }
+            double number = 0.0;
+            if (!value) {
+                return none;
+            } else if (const auto* i = std::get_if<std::int64_t>(&value->value)) {
+                number = static_cast<double>(*i);
+            } else if (const auto* f = std::get_if<double>(&value->value)) {
+                number = *f;
+            } else {
+                return none;
+            }
+            // The first threshold above the value; NaN is below none of them.
+            const auto found = std::upper_bound(table.thresholds.begin(), table.thresholds.end(), number);
+            return static_cast<std::uint32_t>(found - table.thresholds.begin());
+        }
+        case condition_test::opaque:
+            break;
+    }
+    return std::nullopt;
+}
+
+// The visits a guard child makes when its condition fails, without calling the condition.
+void replay_failed_guard(tick_context& ctx, const node& seq, const node& cond) {
+    const tick_frame seq_frame = begin_node_visit(ctx, seq);
+    const tick_frame cond_frame = begin_node_visit(ctx, cond);
+    note_node_result(ctx, cond);
+    end_node_visit(ctx, cond, cond_frame, status::failure);
+    note_node_result(ctx, seq);
+    end_node_visit(ctx, seq, seq_frame, status::failure);
+}
+
+}  // namespace
+
+tick_program_kernel::tick_program_kernel(const tick_program& program, tick_context& ctx)
+    : program_(program), def_(*program.def), ctx_(ctx) {
+    frames_.swap(ctx.inst.tick_frames);
+    frames_.clear();
+    frames_.reserve(program.max_depth);
+}
+
+tick_program_kernel::~tick_program_kernel() {
+    frames_.clear();
+    frames_.swap(ctx_.inst.tick_frames);
+}
+
+void tick_program_kernel::enter(node_id id) {
+    frames_.push_back(begin_node_visit(ctx_, def_.nodes[id]));
+}
+
+void tick_program_kernel::exit(node_id id) {
+    const node& n = def_.nodes[id];
+    note_node_result(ctx_, n);
+    end_node_visit(ctx_, n, frames_.back(), st);
+    frames_.pop_back();
+}
+
+void tick_program_kernel::leaf(node_id id) {
+    const node& n = def_.nodes[id];
+    frames_.push_back(begin_node_visit(ctx_, n));
+    st = tick_program_leaf(n, ctx_);
+    note_node_result(ctx_, n);
+    end_node_visit(ctx_, n, frames_.back(), st);
+    frames_.pop_back();
+}
+
+void tick_program_kernel::condition(node_id id) {
+    const node& n = def_.nodes[id];
+    frames_.push_back(begin_node_visit(ctx_, n));
+    st = tick_condition(n, ctx_);
+    note_node_result(ctx_, n);
+    end_node_visit(ctx_, n, frames_.back(), st);
+    frames_.pop_back();
+}
+
+void tick_program_kernel::action(node_id id) {
+    const node& n = def_.nodes[id];
+    frames_.push_back(begin_node_visit(ctx_, n));
+    st = tick_action(n, ctx_);
+    note_node_result(ctx_, n);
+    end_node_visit(ctx_, n, frames_.back(), st);
+    frames_.pop_back();
+}
+
+void tick_program_kernel::constant(node_id id, status result) {
+    const node& n = def_.nodes[id];
+    frames_.push_back(begin_node_visit(ctx_, n));
+    st = result;
+    note_node_result(ctx_, n);
+    end_node_visit(ctx_, n, frames_.back(), st);
+    frames_.pop_back();
+}
+
+void tick_program_kernel::subtree(node_id id) {
+    st = tick_node(id, ctx_);
+}
+
+void tick_program_kernel::invert() noexcept {
+    if (st == status::success) {
+        st = status::failure;
+    } else if (st == status::failure) {
+        st = status::success;
+    }
+}
+
+void tick_program_kernel::touch_memory(node_id id) {
+    (void)node_memory_for(ctx_.inst, id);
+}
+
+bool tick_program_kernel::repeat_check(node_id id) {
+    if (node_memory_for(ctx_.inst, id).i0 >= def_.nodes[id].int_param) {
+        st = status::success;
+        return true;
+    }
+    return false;
+}
+
+void tick_program_kernel::repeat_step(node_id id) {
+    if (st == status::success) {
+        node_memory& mem = ctx_.inst.memory[id];
+        ++mem.i0;
+        st = mem.i0 >= def_.nodes[id].int_param ? status::success : status::running;
+    }
+}
+
+void tick_program_kernel::retry_step(node_id id) {
+    node_memory& mem = ctx_.inst.memory[id];
+    if (st == status::success) {
+        mem.i0 = 0;
+    } else if (st == status::failure) {
+        ++mem.i0;
+        st = mem.i0 <= def_.nodes[id].int_param ? status::running : status::failure;
+    }
+}
+
+std::uint32_t tick_program_kernel::mem_child(node_id id) {
+    const node& n = def_.nodes[id];
+    return static_cast<std::uint32_t>(clamp_child_index(n, node_memory_for(ctx_.inst, id).i0));
+}
+
+bool tick_program_kernel::mem_seq_step(node_id id, std::uint32_t child) {
+    if (st == status::success) {
+        return false;
+    }
+    ctx_.inst.memory[id].i0 = static_cast<std::int64_t>(child);
+    return true;
+}
+
+bool tick_program_kernel::mem_sel_step(node_id id, std::uint32_t child) {
+    if (st == status::failure) {
+        return false;
+    }
+    node_memory& mem = ctx_.inst.memory[id];
+    if (st == status::success) {
+        mem.i0 = 0;
+        mem.b0 = false;
+        halt_all_children(ctx_, def_.nodes[id], "mem-sel success");
+    } else {
+        mem.i0 = static_cast<std::int64_t>(child);
+        mem.b0 = true;
+    }
+    return true;
+}
+
+void tick_program_kernel::mem_seq_done(node_id id) {
+    ctx_.inst.memory[id].i0 = 0;
+    halt_all_children(ctx_, def_.nodes[id], "mem-seq complete");
+    st = status::success;
+}
+
+void tick_program_kernel::mem_sel_done(node_id id) {
+    node_memory& mem = ctx_.inst.memory[id];
+    mem.i0 = 0;
+    mem.b0 = false;
+    st = status::failure;
+}
+
+std::uint32_t tick_program_kernel::guard_dispatch(std::uint32_t table_index) {
+    const tick_guard_table& table = program_.guard_tables[table_index];
+    const std::optional<std::uint32_t> first = first_possible_guard(table, ctx_);
+    if (!first || *first == 0u) {
+        return 0;
+    }
+    for (std::uint32_t i = 0; i < *first; ++i) {
+        replay_failed_guard(ctx_, def_.nodes[table.guard_seqs[i]], def_.nodes[table.guard_conds[i]]);
+    }
+    st = status::failure;
+    return *first;
+}
+
+void tick_program_kernel::unwind() {
+    while (!frames_.empty()) {
+        const tick_frame frame = frames_.back();
+        frames_.pop_back();
+        end_node_visit(ctx_, def_.nodes[frame.node], frame, status::failure);
+    }
+}
+
+namespace {
+
+// Runs a compiled tick program from the root. Visits produce the same events, stats, and node path
+// updates as tick_node; if a callback escapes with a non-std exception, open frames are closed as
+// failures, as node_scope would during unwinding.
+status run_tick_program(const tick_program& program, tick_context& ctx) {
+    tick_program_kernel k(program, ctx);
+    const tick_instr* code = program.code.data();
+    const std::uint32_t code_size = static_cast<std::uint32_t>(program.code.size());
+    std::uint32_t pc = 0;
+    try {
+        while (pc < code_size) {
+            const tick_instr& in = code[pc++];
+            switch (in.op) {
+                case tick_op::enter:
+                    k.enter(in.node);
+                    break;
+                case tick_op::exit:
+                    k.exit(in.node);
+                    break;
+                case tick_op::leaf:
+                    k.leaf(in.node);
+                    break;
+                case tick_op::subtree:
+                    k.subtree(in.node);
+                    break;
+                case tick_op::set_status:
+                    k.st = in.value;
+                    break;
+                case tick_op::jump_unless:
+                    if (k.st != in.value) {
+                        pc = in.target;
+                    }
+                    break;
+                case tick_op::invert:
+                    k.invert();
+                    break;
+                case tick_op::touch_memory:
+                    k.touch_memory(in.node);
+                    break;
+                case tick_op::repeat_check:
+                    if (k.repeat_check(in.node)) {
+                        pc = in.target;
+                    }
+                    break;
+                case tick_op::repeat_step:
+                    k.repeat_step(in.node);
+                    break;
+                case tick_op::retry_step:
+                    k.retry_step(in.node);
+                    break;
+                case tick_op::mem_dispatch: {
+                    const std::uint32_t index = k.mem_child(in.node);
+                    pc = index < program.def->nodes[in.node].children.size() ? program.jump_tables[in.aux + index]
+                                                                              : in.target;
+                    break;
+                }
+                case tick_op::mem_seq_step:
+                    if (k.mem_seq_step(in.node, in.aux)) {
+                        pc = in.target;
+                    }
+                    break;
+                case tick_op::mem_sel_step:
+                    if (k.mem_sel_step(in.node, in.aux)) {
+                        pc = in.target;
+                    }
+                    break;
+                case tick_op::mem_seq_done:
+                    k.mem_seq_done(in.node);
+                    break;
+                case tick_op::mem_sel_done:
+                    k.mem_sel_done(in.node);
+                    break;
+                case tick_op::guard_dispatch:
+                    if (const std::uint32_t first = k.guard_dispatch(in.aux); first != 0u) {
+                        pc = program.guard_tables[in.aux].child_pcs[first];
+                    }
+                    break;
+            }
+        }
+    } catch (...) {
+        k.unwind();
+        throw;
+    }
+    return k.st;
+}
+
+// Runs the ahead-of-time translation of `program`; same contract as run_tick_program.
+status run_compiled_tree(const compiled_tree& tree, const tick_program& program, tick_context& ctx) {
+    tick_program_kernel k(program, ctx);
+    try {
+        return tree.run(k);
+    } catch (...) {
+        k.unwind();
+        throw;
+    }
+}
+
+status tick_root(tick_context& ctx) {
+    instance& inst = ctx.inst;
+    if (!inst.tick_program_enabled || inst.incremental_tick) {
+        return tick_node(inst.def->root, ctx);
+    }
+    if (!inst.program || inst.program->def != inst.def) {
+        inst.program = std::make_shared<const tick_program>(compile_tick_program(*inst.def));
+    }
+    if (inst.program->native && inst.compiled_tree_enabled) {
+        return run_compiled_tree(*inst.program->native, *inst.program, ctx);
+    }
+    return run_tick_program(*inst.program, ctx);
+}
+
 }  // namespace
 
-void tick_context::bb_put(std::string key, bb_value value, std::string writer_name) {
+void tick_context::bb_put(std::string_view key, bb_value value, std::string_view writer_name) {
+    bb_put(inst.bb.intern(key), std::move(value), writer_name);
+}
+
+void tick_context::bb_put(bb_slot slot, bb_value value, std::string_view writer_name) {
+    ledger_scope charge(ledger, ledger_category::bb_write);
     const auto ts = tick_now(*this);
-    const bool delete_semantics = std::holds_alternative<std::monostate>(value);
-    inst.bb.put(key, value, tick_index, ts, current_node, std::move(writer_name));
+    const bb_entry& entry = inst.bb.put(slot, std::move(value), tick_index, ts, current_node, writer_name);
+    const bb_value& stored = entry.value;
+    const std::string& key = inst.bb.key_name(slot);
+    const bool delete_semantics = std::holds_alternative<std::monostate>(stored);
 
-    trace_event ev = make_trace_event(trace_event_kind::bb_write);
-    ev.node = current_node;
-    ev.key = key;
-    ev.value_repr = bb_value_repr(value);
-    emit_trace(*this, std::move(ev));
+    if (inst.trace_enabled) {
+        trace_record rec = make_trace_record(trace_event_kind::bb_write);
+        rec.node = current_node;
+        emit_trace_value(*this, rec, key, stored);
+    }
 
-    event_log* events = resolve_event_log(*this);
+    event_log* events = event_log_for(*this, event_family::blackboard);
     if (!events) {
         return;
     }
+    std::optional<std::uint32_t> key_id;
+    if (events->compact_ids()) {
+        key_id = events->compact_key_id(key);
+    }
+    const auto write_key = [&](scratch_ostream& data) {
+        if (key_id) {
+            data << "{\"key_id\":" << *key_id;
+        } else {
+            data << "{\"key\":\"" << event_log::json_escape(key) << "\"";
+        }
+    };
     if (delete_semantics) {
-        std::ostringstream data;
-        data << "{\"key\":\"" << event_log::json_escape(key) << "\"";
+        scratch_ostream data = scratch_stream(*this);
+        write_key(data);
         if (current_node != 0) {
             data << ",\"source_node\":" << current_node;
         }
         data << '}';
-        (void)events->emit("bb_delete", tick_index, data.str());
+        (void)events->emit("bb_delete", tick_index, data.view());
         return;
     }
 
-    const std::string raw_json = bb_value_json(value);
-    std::ostringstream data;
-    data << "{\"key\":\"" << event_log::json_escape(key) << "\","
-         << "\"value_digest\":\"" << event_log::hash64_hex(raw_json) << "\","
-         << "\"preview\":" << bb_preview_json(value);
+    const std::string raw_json = bb_value_json(stored);
+    scratch_ostream data = scratch_stream(*this);
+    write_key(data);
+    data << ",\"value_digest\":\"" << event_log::hash64_hex(raw_json) << "\","
+         << "\"preview\":" << bb_preview_json(stored);
     if (current_node != 0) {
         data << ",\"source_node\":" << current_node;
     }
     data << '}';
-    (void)events->emit("bb_write", tick_index, data.str());
+    (void)events->emit("bb_write", tick_index, data.view());
 }
 
 const bb_entry* tick_context::bb_get(std::string_view key) {
-    const bb_entry* out = inst.bb.get(key);
+    const bb_slot slot = inst.bb.find_slot(key);
+    if (slot != kNoBbSlot) {
+        return bb_get(slot);
+    }
     if (inst.read_trace_enabled) {
-        trace_event ev = make_trace_event(trace_event_kind::bb_read);
-        ev.node = current_node;
-        ev.key = std::string(key);
-        ev.value_repr = out ? bb_value_repr(out->value) : "<missing>";
-        emit_trace(*this, std::move(ev));
+        trace_record rec = make_trace_record(trace_event_kind::bb_read);
+        rec.node = current_node;
+        emit_trace(*this, rec, key, "<missing>");
+    }
+    return nullptr;
+}
+
+const bb_entry* tick_context::bb_get(bb_slot slot) {
+    const bb_entry* out = inst.bb.get(slot);
+    if (inst.read_trace_enabled) {
+        trace_record rec = make_trace_record(trace_event_kind::bb_read);
+        rec.node = current_node;
+        const std::string_view key = slot == kNoBbSlot ? std::string_view() : std::string_view(inst.bb.key_name(slot));
+        if (out) {
+            emit_trace_value(*this, rec, key, out->value);
+        } else {
+            emit_trace(*this, rec, key, "<missing>");
+        }
     }
     return out;
 }
 
+void tick_context::watch_job(job_request& req, node_id id) {
+    if (!inst.job_completions) {
+        inst.job_completions = std::make_shared<completion_queue>();
+        if (inst.waker) {
+            inst.job_completions->set_waker(inst.waker);
+        }
+    }
+    req.completions = inst.job_completions;
+    req.completion_tag = id;
+    if (id < inst.job_watchers.size()) {
+        inst.job_watchers[id] = 1u;
+    }
+}
+
 void tick_context::scheduler_event(trace_event_kind kind, job_id job, job_status st, std::string message) {
     std::string log_message = message;
     trace_event ev = make_trace_event(kind);
@@ -2533,7 +4203,7 @@ void tick_context::scheduler_event(trace_event_kind kind, job_id job, job_status
     }
     emit_log(*this, log_level::debug, "scheduler", std::move(log_message));
 
-    event_log* events = resolve_event_log(*this);
+    event_log* events = event_log_for(*this, event_family::async);
     if (!events) {
         return;
     }
@@ -2571,14 +4241,73 @@ void tick_context::scheduler_event(trace_event_kind kind, job_id job, job_status
     (void)events->emit(type, tick_index, data.str());
 }
 
-status tick(instance& inst, registry& reg, services& svc) {
-    if (!inst.def) {
-        throw bt_runtime_error("BT tick: instance has no definition");
+namespace {
+
+// Raises job_notified on the leaves whose watched jobs moved since the last tick. Notifications for
+// a job the leaf no longer holds (halted, reset, resubmitted) are dropped.
+void drain_job_notifications(instance& inst) {
+    if (!inst.job_completions || inst.job_completions->empty()) {
+        return;
+    }
+    inst.job_notifications.clear();
+    inst.job_completions->drain(inst.job_notifications);
+    for (const completion_queue::notification& note : inst.job_notifications) {
+        std::uint64_t tag = note.tag;
+        if (!inst.moved_job_watchers.empty()) {
+            if (const auto moved = inst.moved_job_watchers.find(note.job); moved != inst.moved_job_watchers.end()) {
+                tag = moved->second;
+            }
+        }
+        if (tag >= inst.memory.size()) {
+            continue;
+        }
+        node_memory& mem = inst.memory[tag];
+        if (mem.b0 && static_cast<job_id>(mem.i0) == note.job) {
+            mem.job_notified = true;
+        } else {
+            inst.moved_job_watchers.erase(note.job);
+        }
     }
+}
 
+// Takes the wake reasons that made an on-demand instance tick now and counts them per reason.
+void take_wake_reasons(instance& inst) {
+    const auto now = std::chrono::steady_clock::now();
+    std::uint32_t bits = inst.waker->take();
+    if (inst.tick_max_interval.count() > 0 && now - inst.last_tick_at >= inst.tick_max_interval) {
+        bits |= wake_bits(wake_reason::timer);
+    }
+    if (inst.running_unwatched) {
+        bits |= wake_bits(wake_reason::running);
+    }
+    for (std::size_t i = 0; i < inst.wake_counts.size(); ++i) {
+        if ((bits & (1u << i)) != 0) {
+            ++inst.wake_counts[i];
+        }
+    }
+    inst.last_tick_at = now;
+}
+
+// One instance's tick inside an open GC tick scope. `remaining_ms` receives the budget left, if any.
+status run_tick(instance& inst, registry& reg, services& svc, std::optional<double>& remaining_ms) {
+    tick_ledger ledger;
+    const bool ledgered = inst.node_profiling.mode != node_profiling_mode::off ||
+                          (svc.obs.events && svc.obs.events->tick_audit_enabled());
+    if (ledgered) {
+        ledger.start(profile_clock::shared(), &muslisp::default_gc());
+    }
+    inst.prepare_node_slots();
+    inst.node_path_records.clear();
+    inst.node_alloc_records.clear();
+    {
+        ledger_scope charge(ledger_category::scheduler);
+        if (inst.tick_on_demand) {
+            take_wake_reasons(inst);
+        }
+        drain_job_notifications(inst);
+    }
     ++inst.tick_index;
     const auto tick_start = svc.clock ? svc.clock->now() : std::chrono::steady_clock::now();
-    muslisp::gc_tick_scope gc_tick(muslisp::default_gc());
     const muslisp::gc_stats_snapshot gc_start = muslisp::default_gc().stats();
     auto tick_deadline = std::chrono::steady_clock::time_point::max();
     if (inst.tree_stats.configured_tick_budget.count() > 0) {
@@ -2591,21 +4320,26 @@ status tick(instance& inst, registry& reg, services& svc) {
                      .now = tick_start,
                      .tick_started_at = tick_start,
                      .tick_deadline = tick_deadline,
-                     .current_node = inst.def->root};
+                     .current_node = inst.def->root,
+                     .heap = &muslisp::default_gc(),
+                     .ledger = ledgered ? &ledger : nullptr};
 
     if (svc.obs.events) {
         svc.obs.events->ensure_run_started();
+    }
+    if (svc.obs.events && svc.obs.events->wants(event_family::lifecycle, inst.tick_index)) {
         event_log_allocation_scope allocation_scope(svc.obs.events);
-        std::ostringstream data;
+        json_writer& data = event_log::payload_writer();
         const auto budget_ms =
             std::chrono::duration_cast<std::chrono::milliseconds>(inst.tree_stats.configured_tick_budget).count();
+        data.begin_object();
         if (budget_ms > 0) {
-            data << "{\"tick_budget_ms\":" << budget_ms << '}';
-        } else {
-            data << "{}";
+            data.field("tick_budget_ms", budget_ms);
         }
-        (void)svc.obs.events->emit("tick_begin", inst.tick_index, data.str());
-
+        data.end_object();
+        (void)svc.obs.events->emit("tick_begin", inst.tick_index, data);
+    }
+    if (svc.obs.events && svc.obs.events->wants(event_family::blackboard, inst.tick_index)) {
         bool full_snapshot = false;
         if (svc.obs.events->consume_snapshot_bb_request(&full_snapshot)) {
             constexpr std::size_t kSnapshotLimit = 256;
@@ -2623,22 +4357,113 @@ status tick(instance& inst, registry& reg, services& svc) {
             snap << "]}";
             (void)svc.obs.events->emit("bb_snapshot", inst.tick_index, snap.str());
         }
+        const std::uint64_t keyframe_every = svc.obs.events->bb_delta_keyframe_interval();
+        if (keyframe_every > 0) {
+            emit_bb_journal(*svc.obs.events, inst, keyframe_every);
+        }
     }
 
-    trace_event ev = make_trace_event(trace_event_kind::tick_begin);
-    ev.node = inst.def->root;
-    emit_trace(ctx, std::move(ev));
+    trace_record rec = make_trace_record(trace_event_kind::tick_begin);
+    rec.node = inst.def->root;
+    emit_trace(ctx, rec);
 
     tick_scope scope(ctx, tick_start, gc_start);
-    const status result = tick_node(inst.def->root, ctx);
+    inst.running_unwatched = false;
+    const status result = tick_root(ctx);
+    if (result != status::running) {
+        inst.running_unwatched = false;
+    }
+    prefetch_vla_requests(ctx);
     scope.set_status(result);
+    remaining_ms = tick_remaining_ms(ctx);
     return result;
 }
 
+std::chrono::nanoseconds slack_from_ms(double remaining_ms) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::duration<double, std::milli>(remaining_ms));
+}
+
+}  // namespace
+
+status tick(instance& inst, registry& reg, services& svc) {
+    if (!inst.def) {
+        throw bt_runtime_error("BT tick: instance has no definition");
+    }
+
+    muslisp::gc_tick_scope gc_tick(muslisp::default_gc());
+    std::optional<double> remaining_ms;
+    const status result = run_tick(inst, reg, svc, remaining_ms);
+    if (remaining_ms.has_value()) {
+        gc_tick.set_slack(slack_from_ms(*remaining_ms));
+    }
+    return result;
+}
+
+void prepare_wave(std::span<instance* const> insts, registry& reg) {
+    for (const instance* inst : insts) {
+        if (!inst || !inst->def) {
+            throw bt_runtime_error("BT tick wave: instance has no definition");
+        }
+    }
+
+    // Link tables and tick programs depend only on the definition (and registry generation), so the
+    // first instance of each definition builds them and the rest adopt its copies.
+    struct shared_state {
+        const definition* def = nullptr;
+        std::shared_ptr<const leaf_link_table> links;
+        std::shared_ptr<const tick_program> program;
+    };
+    std::vector<shared_state> shared;
+    for (instance* inst : insts) {
+        inst->prepare_node_slots();
+        auto found = std::find_if(
+            shared.begin(), shared.end(), [inst](const shared_state& state) { return state.def == inst->def; });
+        if (found == shared.end()) {
+            found = shared.insert(shared.end(), shared_state{.def = inst->def, .links = nullptr, .program = nullptr});
+        }
+        if (inst->leaf_bindings_generation != reg.generation()) {
+            inst->link_leaves(reg, found->links);
+        }
+        found->links = inst->leaf_links;
+        if (inst->tick_program_enabled && !inst->incremental_tick) {
+            if (!inst->program || inst->program->def != inst->def) {
+                inst->program = found->program ? found->program
+                                               : std::make_shared<const tick_program>(compile_tick_program(*inst->def));
+            }
+            found->program = inst->program;
+        }
+    }
+}
+
+void tick_wave(std::span<instance* const> insts, registry& reg, services& svc, std::span<status> out) {
+    if (out.size() < insts.size()) {
+        throw bt_runtime_error("BT tick wave: status span is shorter than the instance span");
+    }
+    prepare_wave(insts, reg);
+
+    event_log_batch_scope batch(svc.obs.events);
+    muslisp::gc_tick_scope gc_tick(muslisp::default_gc());
+    std::optional<double> wave_slack_ms;
+    for (std::size_t i = 0; i < insts.size(); ++i) {
+        instance& inst = *insts[i];
+        svc.obs.trace = &inst.trace;
+        std::optional<double> remaining_ms;
+        out[i] = run_tick(inst, reg, svc, remaining_ms);
+        if (remaining_ms.has_value()) {
+            wave_slack_ms = wave_slack_ms ? std::min(*wave_slack_ms, *remaining_ms) : *remaining_ms;
+        }
+    }
+    if (wave_slack_ms.has_value()) {
+        gc_tick.set_slack(slack_from_ms(*wave_slack_ms));
+    }
+}
+
 void halt_subtree(instance& inst, registry& reg, services& svc, node_id root, std::string_view reason) {
     if (!inst.def) {
         return;
     }
+    inst.prepare_node_slots();
     tick_context ctx{.inst = inst,
                      .reg = reg,
                      .svc = svc,
@@ -2648,11 +4473,318 @@ void halt_subtree(instance& inst, registry& reg, services& svc, node_id root, st
     halt_subtree_impl(ctx, root, reason);
 }
 
-void reset(instance& inst) {
-    inst.memory.clear();
+std::size_t swap_definition(instance& inst,
+                            const definition* new_def,
+                            registry& reg,
+                            services& svc,
+                            std::shared_ptr<const leaf_arg_table> shared_leaf_args) {
+    if (!inst.def || !new_def || new_def->nodes.empty()) {
+        throw std::invalid_argument("swap_definition: instance and definition must both have nodes");
+    }
+    inst.prepare_node_slots();
+    const definition& old_def = *inst.def;
+
+    // Walk both trees in parallel from the roots; an old node that loses its match roots a halted subtree.
+    constexpr node_id k_unmatched = ~node_id{0};
+    std::vector<node_id> old_to_new(old_def.nodes.size(), k_unmatched);
+    std::vector<node_id> halt_roots;
+    std::vector<std::pair<node_id, node_id>> pending{{old_def.root, new_def->root}};
+    while (!pending.empty()) {
+        const auto [old_id, new_id] = pending.back();
+        pending.pop_back();
+        const node& old_node = get_node(old_def, old_id);
+        const node& new_node = get_node(*new_def, new_id);
+        if (!same_node_label(old_node, new_node)) {
+            halt_roots.push_back(old_id);
+            continue;
+        }
+        old_to_new[old_id] = new_id;
+        for (std::size_t i = 0; i < old_node.children.size(); ++i) {
+            if (i < new_node.children.size()) {
+                pending.emplace_back(old_node.children[i], new_node.children[i]);
+            } else {
+                halt_roots.push_back(old_node.children[i]);
+            }
+        }
+    }
+
+    std::size_t halted = 0;
+    if (!halt_roots.empty()) {
+        tick_context ctx{.inst = inst,
+                         .reg = reg,
+                         .svc = svc,
+                         .tick_index = inst.tick_index,
+                         .now = svc.clock ? svc.clock->now() : std::chrono::steady_clock::now(),
+                         .current_node = old_def.root};
+        std::vector<node_id> stack;
+        for (const node_id root : halt_roots) {
+            stack.push_back(root);
+            while (!stack.empty()) {
+                const node_id id = stack.back();
+                stack.pop_back();
+                ++halted;
+                if (const auto it = inst.active_vla_jobs.find(id); it != inst.active_vla_jobs.end()) {
+                    if (svc.vla) {
+                        (void)svc.vla->cancel(it->second);
+                    }
+                    inst.active_vla_jobs.erase(it);
+                }
+                if (const auto it = inst.vla_prefetches.find(id); it != inst.vla_prefetches.end()) {
+                    if (svc.vla) {
+                        (void)svc.vla->cancel(it->second.job);
+                    }
+                    inst.vla_prefetches.erase(it);
+                }
+                inst.vla_chunks.erase(id);
+                const node& n = get_node(old_def, id);
+                stack.insert(stack.end(), n.children.begin(), n.children.end());
+            }
+            halt_subtree_impl(ctx, root, "swap");
+        }
+    }
+
+    std::vector<node_memory> old_memory = std::move(inst.memory);
+    std::vector<std::uint8_t> old_touched = std::move(inst.memory_touched);
+    std::vector<node_profile_stats> old_stats = std::move(inst.node_stats);
+    const auto old_vla_jobs = std::move(inst.active_vla_jobs);
+    const auto old_prefetches = std::move(inst.vla_prefetches);
+    auto old_chunks = std::move(inst.vla_chunks);
+    const auto old_warnings = std::move(inst.halt_warning_emitted);
+    const auto old_watchers = std::move(inst.moved_job_watchers);
+    const auto old_plan_budgets = std::move(inst.plan_budgets);
     inst.active_vla_jobs.clear();
+    inst.vla_prefetches.clear();
+    inst.vla_chunks.clear();
+    inst.plan_budgets.clear();
     inst.halt_warning_emitted.clear();
+    inst.moved_job_watchers.clear();
+
+    inst.def = new_def;
+    if (shared_leaf_args && shared_leaf_args->def == new_def) {
+        inst.leaf_arg_values = std::move(shared_leaf_args);
+    }
+    inst.prepare_node_slots();
+
+    for (node_id old_id = 0; old_id < old_to_new.size(); ++old_id) {
+        const node_id new_id = old_to_new[old_id];
+        if (new_id == k_unmatched) {
+            continue;
+        }
+        node_memory& mem = inst.memory[new_id];
+        mem = std::move(old_memory[old_id]);
+        if (old_touched[old_id] != 0u) {
+            inst.touch_memory(new_id);
+        }
+        node_profile_stats& stats = inst.node_stats[new_id];
+        const node_id stats_id = stats.id;
+        stats = std::move(old_stats[old_id]);
+        stats.id = stats_id;
+        if (const auto it = old_vla_jobs.find(old_id); it != old_vla_jobs.end()) {
+            inst.active_vla_jobs.emplace(new_id, it->second);
+        }
+        if (const auto it = old_prefetches.find(old_id); it != old_prefetches.end()) {
+            inst.vla_prefetches.emplace(new_id, it->second);
+        }
+        if (const auto it = old_chunks.find(old_id); it != old_chunks.end()) {
+            inst.vla_chunks.emplace(new_id, std::move(it->second));
+        }
+        if (const auto it = old_plan_budgets.find(old_id); it != old_plan_budgets.end()) {
+            inst.plan_budgets.emplace(new_id, it->second);
+        }
+        if (old_warnings.contains(old_id)) {
+            inst.halt_warning_emitted.insert(new_id);
+        }
+        if (new_id != old_id && mem.b0 && mem.i0 > 0) {
+            inst.moved_job_watchers.emplace(static_cast<job_id>(mem.i0), new_id);
+        }
+    }
+    // Watchers moved by an earlier swap follow their node again.
+    for (const auto& [job, old_id] : old_watchers) {
+        if (old_id < old_to_new.size() && old_to_new[old_id] != k_unmatched) {
+            inst.moved_job_watchers.insert_or_assign(job, old_to_new[old_id]);
+        }
+    }
+    return halted;
+}
+
+void reset(instance& inst) {
+    // Untouched nodes already hold default memory, so only subtrees with live memory are walked.
+    if (inst.def && inst.slots_def == inst.def && inst.def->root < inst.memory.size() &&
+        inst.live_memory_nodes[inst.def->root] != 0u) {
+        halt_stack_scope stack_scope(inst);
+        std::vector<node_id>& stack = stack_scope.get();
+        stack.push_back(inst.def->root);
+        while (!stack.empty()) {
+            const node_id id = stack.back();
+            stack.pop_back();
+            if (inst.memory_touched[id] != 0u) {
+                inst.memory[id] = node_memory{};
+                inst.memory_touched[id] = 0u;
+            }
+            inst.live_memory_nodes[id] = 0u;
+            for (const node_id child : inst.def->nodes[id].children) {
+                if (inst.live_memory_nodes[child] != 0u) {
+                    stack.push_back(child);
+                }
+            }
+        }
+    }
+    // clear() on an empty unordered container still walks its bucket array.
+    if (!inst.active_vla_jobs.empty()) {
+        inst.active_vla_jobs.clear();
+    }
+    if (!inst.moved_job_watchers.empty()) {
+        inst.moved_job_watchers.clear();
+    }
+    if (!inst.vla_prefetches.empty()) {
+        inst.vla_prefetches.clear();
+    }
+    if (!inst.vla_chunks.empty()) {
+        inst.vla_chunks.clear();
+    }
+    if (!inst.halt_warning_emitted.empty()) {
+        inst.halt_warning_emitted.clear();
+    }
+    inst.running_unwatched = false;
     inst.bb.clear();
+    inst.invalidate_memos();
+}
+
+void recycle(instance& inst) {
+    reset(inst);
+    inst.bb.clear_histories();
+    inst.bb.reset_journal();
+    inst.tick_index = 0;
+    inst.trace_enabled = true;
+    inst.read_trace_enabled = false;
+    inst.bb_keyframe_epoch = 0;
+    inst.bb_keyframe_tick = 0;
+    inst.bb_journal_tick = 0;
+    inst.tree_stats = tree_profile_stats{};
+    if (!inst.plan_budgets.empty()) {
+        inst.plan_budgets.clear();
+    }
+    inst.clear_node_stats();
+    inst.node_profiling = node_profiling_options{};
+    set_incremental_tick(inst, false);
+    set_tick_on_demand(inst, false);
+    inst.wake_counts = {};
+    inst.wake_skip_count = 0;
+    inst.tick_program_enabled = true;
+    inst.compiled_tree_enabled = true;
+    // Jobs started before the recycle may still post to the old queue; a fresh one is made on demand.
+    inst.job_completions.reset();
+    inst.job_notifications.clear();
+    inst.tick_frames.clear();
+    inst.node_path_records.clear();
+    inst.node_alloc_records.clear();
+    inst.trace.clear();
+    inst.trace.set_value_preview(trace_buffer::k_default_value_preview);
+}
+
+void fork_state(const instance& src, instance& dst) {
+    if (dst.def != src.def) {
+        throw bt_runtime_error("BT fork: instances run different definitions");
+    }
+    if (const std::string reason = src.uncopyable_state(); !reason.empty()) {
+        throw bt_runtime_error("BT fork: " + reason);
+    }
+    reset(dst);
+    dst.prepare_node_slots();
+    dst.bb = src.bb.fork();
+    dst.bb_key_slots.clear();
+    for (const std::string& key : dst.def->bb_keys) {
+        dst.bb_key_slots.push_back(dst.bb.intern(key));
+    }
+    if (src.slots_def == src.def) {
+        for (std::size_t id = 0; id < src.memory.size(); ++id) {
+            if (src.memory_touched[id] == 0u) {
+                continue;
+            }
+            node_memory& mem = dst.memory[id];
+            mem.i0 = src.memory[id].i0;
+            mem.i1 = src.memory[id].i1;
+            mem.b0 = src.memory[id].b0;
+            dst.touch_memory(static_cast<node_id>(id));
+        }
+    }
+    dst.tick_index = src.tick_index;
+    dst.tree_stats.configured_tick_budget = src.tree_stats.configured_tick_budget;
+    dst.trace_enabled = src.trace_enabled;
+    dst.read_trace_enabled = src.read_trace_enabled;
+    dst.tick_program_enabled = src.tick_program_enabled;
+    dst.compiled_tree_enabled = src.compiled_tree_enabled;
+    set_incremental_tick(dst, src.incremental_tick);
+    // The forked blackboard replaced dst's, watch and all; this re-derives the watch on the next tick.
+    set_tick_on_demand(dst, src.tick_on_demand, src.tick_max_interval);
+    dst.running_unwatched = src.running_unwatched;
+}
+
+void set_incremental_tick(instance& inst, bool enabled) {
+    if (inst.incremental_tick == enabled) {
+        return;
+    }
+    inst.incremental_tick = enabled;
+    // Forces link_leaves to build (or drop) the memo tables on the next tick.
+    inst.leaf_bindings_generation = 0;
+}
+
+void set_tick_on_demand(instance& inst, bool enabled, std::chrono::nanoseconds max_interval) {
+    if (!enabled) {
+        if (!inst.tick_on_demand) {
+            return;
+        }
+        inst.tick_on_demand = false;
+        inst.tick_max_interval = std::chrono::nanoseconds{0};
+        inst.bb.watch(nullptr, {});
+        if (inst.job_completions) {
+            inst.job_completions->set_waker(nullptr);
+        }
+        inst.waker.reset();
+        inst.wake_reads.clear();
+        inst.wake_on_any_write = false;
+        return;
+    }
+    if (!inst.waker) {
+        inst.waker = std::make_shared<tick_waker>();
+    }
+    inst.tick_on_demand = true;
+    inst.tick_max_interval = std::max(max_interval, std::chrono::nanoseconds{0});
+    if (inst.job_completions) {
+        inst.job_completions->set_waker(inst.waker);
+    }
+    inst.waker->notify(wake_reason::initial);
+    // Forces link_leaves to derive the wake set and watch it on the next tick.
+    inst.leaf_bindings_generation = 0;
+}
+
+std::uint32_t tick_due(const instance& inst, std::chrono::steady_clock::time_point now) {
+    if (!inst.tick_on_demand || !inst.waker) {
+        return wake_bits(wake_reason::timer);
+    }
+    std::uint32_t bits = inst.waker->pending();
+    if (inst.tick_max_interval.count() > 0 && now - inst.last_tick_at >= inst.tick_max_interval) {
+        bits |= wake_bits(wake_reason::timer);
+    }
+    if (inst.running_unwatched) {
+        bits |= wake_bits(wake_reason::running);
+    }
+    return bits;
+}
+
+std::uint32_t wait_for_wake(instance& inst, std::chrono::steady_clock::time_point deadline) {
+    for (;;) {
+        const auto now = std::chrono::steady_clock::now();
+        const std::uint32_t bits = tick_due(inst, now);
+        if (bits != 0 || now >= deadline) {
+            return bits;
+        }
+        auto until = deadline;
+        if (inst.tick_max_interval.count() > 0) {
+            until = std::min(until, inst.last_tick_at + inst.tick_max_interval);
+        }
+        (void)inst.waker->wait_until(until);
+    }
 }
 
 std::string dump_stats(const instance& inst) {
@@ -2660,29 +4792,117 @@ std::string dump_stats(const instance& inst) {
 
     out << "tick_count=" << inst.tree_stats.tick_count << '\n';
     out << "tick_overrun_count=" << inst.tree_stats.tick_overrun_count << '\n';
+    out << "memo_hit_count=" << inst.tree_stats.memo_hit_count << '\n';
     out << "tick_last_ns=" << inst.tree_stats.tick_duration.last.count() << '\n';
     out << "tick_max_ns=" << inst.tree_stats.tick_duration.max.count() << '\n';
     out << "tick_total_ns=" << inst.tree_stats.tick_duration.total.count() << '\n';
+    for (const reported_quantile& rq : k_reported_quantiles) {
+        out << "tick_" << rq.label << "_ns=" << inst.tree_stats.tick_duration.percentile(rq.q).count() << '\n';
+    }
 
-    std::vector<node_id> ids;
-    ids.reserve(inst.node_stats.size());
-    for (const auto& [id, _] : inst.node_stats) {
-        ids.push_back(id);
+    const tick_ledger_stats& ledger = inst.tree_stats.ledger;
+    if (ledger.ticks > 0) {
+        out << "ledger_ticks=" << ledger.ticks << '\n';
+        for (std::size_t i = 0; i < k_ledger_category_count; ++i) {
+            out << "ledger " << ledger_category_name(static_cast<ledger_category>(i)) << " total_ns=" << ledger.total_ns[i]
+                << " max_ns=" << ledger.max_ns[i] << " recent_ns=" << static_cast<std::uint64_t>(ledger.recent_ns[i])
+                << '\n';
+        }
     }
-    std::sort(ids.begin(), ids.end());
 
-    for (node_id id : ids) {
-        const auto it = inst.node_stats.find(id);
-        if (it == inst.node_stats.end()) {
+    if (inst.tick_on_demand) {
+        out << "tick_mode=on_demand\n";
+        out << "tick_max_interval_ns=" << inst.tick_max_interval.count() << '\n';
+        out << "wake_set=" << (inst.wake_on_any_write ? std::string("all") : std::to_string(inst.wake_reads.size()))
+            << '\n';
+    }
+    if (inst.tick_on_demand || inst.wake_skip_count > 0) {
+        for (std::size_t i = 0; i < inst.wake_counts.size(); ++i) {
+            out << "wake_" << wake_reason_name(static_cast<wake_reason>(1u << i)) << "_count=" << inst.wake_counts[i]
+                << '\n';
+        }
+        out << "wake_skip_count=" << inst.wake_skip_count << '\n';
+    }
+
+    out << "node_profiling=" << node_profiling_mode_name(inst.node_profiling.mode) << '\n';
+    if (inst.node_profiling.mode == node_profiling_mode::sampled) {
+        out << "node_profiling_every_n_ticks=" << inst.node_profiling.every_n_ticks << '\n';
+        out << "node_profiling_node_percent=" << inst.node_profiling.node_percent << '\n';
+    }
+    out << "node_timer="
+        << (inst.node_profiling.timer ? "custom" : profile_clock_source_name(profile_clock::shared().active_source())) << '\n';
+
+    for (const node_profile_stats& n : inst.node_stats) {
+        if (n.success_returns + n.failure_returns + n.running_returns == 0) {
             continue;
         }
-        const node_profile_stats& n = it->second;
         out << "node " << n.id << " (" << n.name << ")"
             << " success=" << n.success_returns << " failure=" << n.failure_returns
-            << " running=" << n.running_returns << " last_ns=" << n.tick_duration.last.count()
-            << " max_ns=" << n.tick_duration.max.count() << '\n';
+            << " running=" << n.running_returns << " alloc_objects=" << n.alloc_objects
+            << " alloc_bytes=" << n.alloc_bytes << " timed=" << n.tick_duration.count
+            << " last_ns=" << n.tick_duration.last.count()
+            << " max_ns=" << n.tick_duration.max.count();
+        for (const reported_quantile& rq : k_reported_quantiles) {
+            out << ' ' << rq.label << "_ns=" << n.tick_duration.percentile(rq.q).count();
+        }
+        out << '\n';
+    }
+
+    return out.str();
+}
+
+std::string dump_flamegraph(const instance& inst, std::string_view root_frame) {
+    if (!inst.def || inst.node_stats.size() != inst.def->nodes.size()) {
+        return {};
+    }
+    const definition& def = *inst.def;
+
+    constexpr node_id k_no_parent = std::numeric_limits<node_id>::max();
+    std::vector<node_id> parents(def.nodes.size(), k_no_parent);
+    for (const node& n : def.nodes) {
+        for (const node_id child : n.children) {
+            if (child < parents.size()) {
+                parents[child] = n.id;
+            }
+        }
     }
 
+    std::ostringstream out;
+    std::vector<node_id> chain;
+    for (const node& n : def.nodes) {
+        std::chrono::nanoseconds self = inst.node_stats[n.id].tick_duration.total;
+        for (const node_id child : n.children) {
+            if (child < inst.node_stats.size()) {
+                self -= inst.node_stats[child].tick_duration.total;
+            }
+        }
+        if (self.count() <= 0) {
+            continue;
+        }
+
+        chain.clear();
+        for (node_id at = n.id; at != k_no_parent && chain.size() <= def.nodes.size(); at = parents[at]) {
+            chain.push_back(at);
+        }
+        std::string stack(root_frame);
+        for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+            const node& frame = def.nodes[*it];
+            if (!stack.empty()) {
+                stack.push_back(';');
+            }
+            stack += node_kind_name(frame.kind);
+            if (frame.leaf_name.empty()) {
+                stack += '#' + std::to_string(frame.id);
+                continue;
+            }
+            stack.push_back(':');
+            // `;` separates frames and the last space separates the count.
+            for (const char ch : frame.leaf_name) {
+                stack.push_back(ch == ';' || ch == ' ' ? '_' : ch);
+            }
+        }
+        out << stack << ' ' << self.count() << '\n';
+    }
     return out.str();
 }
 
@@ -2731,6 +4951,16 @@ std::string dump_blackboard(const instance& inst) {
     return out.str();
 }
 
+void set_node_profiling(instance& inst, node_profiling_options options) {
+    if (options.every_n_ticks == 0) {
+        throw std::invalid_argument("node profiling tick interval must be at least 1");
+    }
+    if (options.node_percent == 0 || options.node_percent > 100) {
+        throw std::invalid_argument("node profiling percentage must be between 1 and 100");
+    }
+    inst.node_profiling = options;
+}
+
 void set_tick_budget_ms(instance& inst, std::int64_t budget_ms) {
     if (budget_ms < 0) {
         throw std::invalid_argument("tick budget must be non-negative");
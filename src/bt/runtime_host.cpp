@@ -1,22 +1,33 @@
 #include "bt/runtime_host.hpp"
 
 #include <algorithm>
+#include <charconv>
 #include <chrono>
 #include <cstdlib>
 #include <cctype>
 #include <cmath>
+#include <condition_variable>
+#include <deque>
 #include <filesystem>
 #include <fstream>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <sstream>
 #include <stdexcept>
 #include <thread>
+#include <unordered_set>
 #include <utility>
 
+#include "bt/compiler.hpp"
+#include "bt/dsl_loader.hpp"
 #include "muesli_bt/contract/events.hpp"
 #include "muslisp/error.hpp"
 #include "muslisp/gc.hpp"
 #include "muslisp/printer.hpp"
+#include "muslisp/runtime_context.hpp"
+#include "json_scan.hpp"
 
 namespace bt {
 namespace {
@@ -101,8 +112,8 @@ std::vector<double> bb_value_as_vector(const bb_value& value, const std::string&
     if (const auto* f = std::get_if<double>(&value)) {
         return {*f};
     }
-    if (const auto* vec = std::get_if<std::vector<double>>(&value)) {
-        return *vec;
+    if (const auto* vec = std::get_if<bb_vector>(&value)) {
+        return vec->to_vector();
     }
     throw std::runtime_error(where + ": expected numeric or numeric-vector blackboard value");
 }
@@ -123,7 +134,7 @@ bool bb_value_truthy(const bb_value& value) {
     if (const auto* s = std::get_if<std::string>(&value)) {
         return !s->empty() && *s != "0" && *s != "false";
     }
-    if (const auto* vec = std::get_if<std::vector<double>>(&value)) {
+    if (const auto* vec = std::get_if<bb_vector>(&value)) {
         return !vec->empty();
     }
     return true;
@@ -159,6 +170,8 @@ std::string gc_lifecycle_payload_json(const muslisp::gc_lifecycle_event& event)
          << "\"policy\":\"" << muslisp::gc::policy_name(event.policy) << "\","
          << "\"forced\":" << (event.forced ? "true" : "false") << ","
          << "\"in_tick\":" << (event.in_tick ? "true" : "false") << ","
+         << "\"generation\":\"" << (event.minor ? "minor" : "full") << "\","
+         << "\"incremental\":" << (event.incremental ? "true" : "false") << ","
          << "\"heap_live_bytes_before\":" << event.heap_live_bytes_before << ","
          << "\"live_objects_before\":" << event.live_objects_before;
     if (!event.begin) {
@@ -168,11 +181,30 @@ std::string gc_lifecycle_payload_json(const muslisp::gc_lifecycle_event& event)
              << ",\"mark_time_ns\":" << event.mark_time_ns
              << ",\"sweep_time_ns\":" << event.sweep_time_ns
              << ",\"pause_time_ns\":" << event.pause_time_ns;
+        if (event.incremental) {
+            data << ",\"slice_count\":" << event.slice_count;
+        }
     }
     data << '}';
     return data.str();
 }
 
+// Payload of the `error` event a heap limit incident is logged as: a warning when the soft limit turns
+// the collector aggressive, an error when the hard limit starts refusing allocations.
+std::string gc_limit_payload_json(const muslisp::gc_limit_event& event) {
+    const bool hard = event.kind == muslisp::gc_limit_kind::hard_limit_exceeded;
+    std::ostringstream data;
+    data << "{\"severity\":\"" << (hard ? "error" : "warning") << "\","
+         << "\"component\":\"gc\","
+         << "\"message\":\"" << (hard ? "heap hard limit refused an allocation" : "heap passed its soft limit") << "\","
+         << "\"kind\":\"" << (hard ? "hard_limit_exceeded" : "soft_limit_reached") << "\","
+         << "\"heap_live_bytes\":" << event.heap_live_bytes << ","
+         << "\"limit_bytes\":" << event.limit_bytes << ","
+         << "\"request_bytes\":" << event.request_bytes << ","
+         << "\"in_tick\":" << (event.in_tick ? "true" : "false") << '}';
+    return data.str();
+}
+
 std::filesystem::path model_service_cache_file(const model_service_config& config, const std::string& request_hash) {
     return std::filesystem::path(config.replay_cache_path) / (request_hash + ".json");
 }
@@ -243,16 +275,66 @@ std::string bounds_to_json_array(const std::vector<std::pair<double, double>>& b
     return out.str();
 }
 
-std::string vla_request_to_model_service_input_json(const vla_request& request) {
+// A frame the service should read alongside the request: a frame:// ref from the HTTP frame store,
+// or an shm:// ref into the frame ring for the request's image or blob handle.
+struct vla_model_service_frame {
+    std::string name;
+    std::string ref;
+    bool image = true;
+};
+
+std::vector<vla_model_service_frame> vla_model_service_frames(const vla_request& request, const vla_service& vla) {
+    std::vector<vla_model_service_frame> frames;
+    if (request.observation.frame_id.rfind("frame://", 0) == 0) {
+        frames.push_back(vla_model_service_frame{.name = "camera1", .ref = request.observation.frame_id});
+    }
+    if (request.observation.image.has_value()) {
+        if (const std::optional<image_info> info = vla.get_image_info(*request.observation.image);
+            info.has_value() && !info->frame_ref.empty()) {
+            frames.push_back(vla_model_service_frame{.name = info->frame_id, .ref = info->frame_ref});
+        }
+    }
+    if (request.observation.blob.has_value()) {
+        if (const std::optional<blob_info> info = vla.get_blob_info(*request.observation.blob);
+            info.has_value() && !info->frame_ref.empty()) {
+            frames.push_back(vla_model_service_frame{
+                .name = info->tag.empty() ? std::string("blob") : info->tag,
+                .ref = info->frame_ref,
+                .image = false,
+            });
+        }
+    }
+    return frames;
+}
+
+std::vector<std::string> vla_model_service_frame_refs(const std::vector<vla_model_service_frame>& frames) {
+    std::vector<std::string> refs;
+    refs.reserve(frames.size());
+    for (const vla_model_service_frame& frame : frames) {
+        refs.push_back(frame.ref);
+    }
+    return refs;
+}
+
+std::string vla_request_to_model_service_input_json(const vla_request& request,
+                                                    const std::vector<vla_model_service_frame>& frames) {
     std::ostringstream out;
     out << "{\"task_id\":\"" << json_escape_string_fragment(request.task_id) << "\","
         << "\"instruction\":\"" << json_escape_string_fragment(request.instruction) << "\","
         << "\"observation\":{\"state\":" << json_number_array(request.observation.state)
         << ",\"timestamp_ms\":" << request.observation.timestamp_ms
         << ",\"frame_id\":\"" << json_escape_string_fragment(request.observation.frame_id) << "\"";
-    if (request.observation.frame_id.rfind("frame://", 0) == 0) {
-        out << ",\"images\":{\"camera1\":{\"ref\":\"" << json_escape_string_fragment(request.observation.frame_id)
-            << "\"}}";
+    bool first_image = true;
+    for (const vla_model_service_frame& frame : frames) {
+        if (!frame.image) {
+            continue;
+        }
+        out << (first_image ? ",\"images\":{" : ",") << '"' << json_escape_string_fragment(frame.name)
+            << "\":{\"ref\":\"" << json_escape_string_fragment(frame.ref) << "\"}";
+        first_image = false;
+    }
+    if (!first_image) {
+        out << '}';
     }
     out << "},\"action_space\":{\"type\":\"" << json_escape_string_fragment(request.action_space.type)
         << "\",\"dims\":" << request.action_space.dims << ",\"bounds\":" << bounds_to_json_array(request.action_space.bounds)
@@ -262,58 +344,51 @@ std::string vla_request_to_model_service_input_json(const vla_request& request)
     return out.str();
 }
 
-std::vector<std::string> vla_model_service_frame_refs(const vla_request& request) {
-    std::vector<std::string> refs;
-    if (request.observation.frame_id.rfind("frame://", 0) == 0) {
-        refs.push_back(request.observation.frame_id);
-    }
-    return refs;
-}
-
-std::string frame_ref_to_model_service_ref_json(std::string_view ref) {
-    return "{\"type\":\"frame\",\"name\":\"camera1\",\"ref\":\"" + json_escape_string_fragment(ref) + "\"}";
+std::string frame_to_model_service_ref_json(const vla_model_service_frame& frame) {
+    const char* type = frame.ref.rfind("shm://", 0) == 0 ? "shm_frame" : "frame";
+    return std::string("{\"type\":\"") + type + "\",\"name\":\"" + json_escape_string_fragment(frame.name) +
+           "\",\"ref\":\"" + json_escape_string_fragment(frame.ref) + "\"}";
 }
 
-std::optional<std::vector<double>> extract_first_action_values(std::string_view output_json) {
-    const std::size_t actions_pos = output_json.find("\"actions\"");
-    if (actions_pos == std::string_view::npos) {
-        return std::nullopt;
-    }
-    const std::size_t values_pos = output_json.find("\"values\"", actions_pos);
-    if (values_pos == std::string_view::npos) {
-        return std::nullopt;
-    }
-    const std::size_t begin = output_json.find('[', values_pos);
-    if (begin == std::string_view::npos) {
-        return std::nullopt;
+// Every action of `output.actions`, in order. Empty when any action has no finite values; the chunk
+// is dropped (leaving only the first action) when any step lacks a positive dt_ms.
+std::vector<vla_chunk_step> extract_action_chunk(std::string_view output_json) {
+    json_scan::json_doc doc;
+    if (!doc.parse(output_json)) {
+        return {};
     }
-    const std::size_t end = output_json.find(']', begin + 1);
-    if (end == std::string_view::npos || end <= begin + 1) {
-        return std::nullopt;
+    const std::uint32_t actions = doc.member(0, "actions");
+    if (actions == json_scan::k_none || doc.at(actions).kind != json_scan::json_kind::array) {
+        return {};
     }
-
-    std::vector<double> values;
-    std::string raw(output_json.substr(begin + 1, end - begin - 1));
-    const char* cursor = raw.c_str();
-    while (*cursor != '\0') {
-        while (*cursor == ' ' || *cursor == '\t' || *cursor == '\n' || *cursor == '\r' || *cursor == ',') {
-            ++cursor;
+    std::vector<vla_chunk_step> chunk;
+    bool timed = true;
+    for (std::uint32_t a = doc.at(actions).first_child; a != json_scan::k_none; a = doc.at(a).next_sibling) {
+        const std::uint32_t values = doc.member(a, "values");
+        if (values == json_scan::k_none || doc.at(values).kind != json_scan::json_kind::array) {
+            return {};
         }
-        if (*cursor == '\0') {
-            break;
+        vla_chunk_step step;
+        for (std::uint32_t v = doc.at(values).first_child; v != json_scan::k_none; v = doc.at(v).next_sibling) {
+            const std::optional<double> value = json_scan::float_value(doc, v);
+            if (!value.has_value() || !std::isfinite(*value)) {
+                return {};
+            }
+            step.u.push_back(*value);
         }
-        char* next = nullptr;
-        const double value = std::strtod(cursor, &next);
-        if (next == cursor || !std::isfinite(value)) {
-            return std::nullopt;
+        if (step.u.empty()) {
+            return {};
         }
-        values.push_back(value);
-        cursor = next;
+        const std::optional<double> dt_ms = json_scan::float_value(doc, doc.member(a, "dt_ms"));
+        timed = timed && dt_ms.has_value() && std::isfinite(*dt_ms) && *dt_ms > 0.0;
+        step.dt_ms = dt_ms.value_or(0.0);
+        chunk.push_back(std::move(step));
     }
-    if (values.empty()) {
-        return std::nullopt;
+    if (!timed && !chunk.empty()) {
+        chunk.resize(1);
+        chunk.front().dt_ms = 0.0;
     }
-    return values;
+    return chunk;
 }
 
 struct model_service_vla_trace {
@@ -386,8 +461,8 @@ vla_response action_chunk_to_vla_response(const vla_request& request,
     if (response.validation_checked && !response.validation_ok) {
         return model_service_error_to_vla_response(request, response, trace);
     }
-    const std::optional<std::vector<double>> values = extract_first_action_values(response.output_json);
-    if (!values.has_value()) {
+    std::vector<vla_chunk_step> chunk = extract_action_chunk(response.output_json);
+    if (chunk.empty()) {
         vla_response invalid;
         invalid.status = vla_status::invalid;
         invalid.model = request.model;
@@ -400,7 +475,10 @@ vla_response action_chunk_to_vla_response(const vla_request& request,
     out.status = vla_status::ok;
     out.model = request.model;
     out.action.type = vla_action_type::continuous;
-    out.action.u = *values;
+    out.action.u = chunk.front().u;
+    if (chunk.front().dt_ms > 0.0) {
+        out.chunk = std::move(chunk);
+    }
     out.confidence = 1.0;
     out.explanation = "model-service action chunk";
     attach_model_service_vla_trace(out, trace);
@@ -408,6 +486,7 @@ vla_response action_chunk_to_vla_response(const vla_request& request,
 }
 
 model_service_request make_vla_model_service_request(const vla_request& request,
+                                                     const std::vector<vla_model_service_frame>& frames,
                                                      model_service_operation op,
                                                      std::string id,
                                                      std::string session_id = {}) {
@@ -416,9 +495,9 @@ model_service_request make_vla_model_service_request(const vla_request& request,
     out.op = op;
     out.capability = request.capability;
     out.deadline_ms = request.deadline_ms;
-    out.input_json = vla_request_to_model_service_input_json(request);
-    for (const std::string& ref : vla_model_service_frame_refs(request)) {
-        out.refs_json.push_back(frame_ref_to_model_service_ref_json(ref));
+    out.input_json = vla_request_to_model_service_input_json(request, frames);
+    for (const vla_model_service_frame& frame : frames) {
+        out.refs_json.push_back(frame_to_model_service_ref_json(frame));
     }
     out.session_id = std::move(session_id);
     out.trace = model_service_trace{
@@ -445,11 +524,19 @@ public:
             return out;
         }
 
+        const model_service_config& config = host_->model_service_config_ref();
+        if (config.batch_window_ms > 0 && config.replay_mode == "live") {
+            if (const std::size_t limit = host_->model_service_batch_limit(request.capability); limit > 1) {
+                return infer_batched(request, cancel_flag, limit, config.batch_window_ms);
+            }
+        }
+
         const std::string request_key = std::to_string(vla_service::hash_request(request));
         model_service_vla_trace trace;
-        trace.frame_refs = vla_model_service_frame_refs(request);
+        const std::vector<vla_model_service_frame> frames = vla_model_service_frames(request, host_->vla_ref());
+        trace.frame_refs = vla_model_service_frame_refs(frames);
         model_service_response start = host_->call_model_service(make_vla_model_service_request(
-            request, model_service_operation::start, "vla-start-" + request_key));
+            request, frames, model_service_operation::start, "vla-start-" + request_key));
         append_model_service_vla_trace(trace, start);
         if (start.status == model_service_status::action_chunk || start.status == model_service_status::success) {
             return action_chunk_to_vla_response(request, start, trace);
@@ -472,14 +559,14 @@ public:
         while (true) {
             if (cancel_flag.load() && !cancellation_late_injected) {
                 model_service_response cancel = host_->call_model_service(make_vla_model_service_request(
-                    request, model_service_operation::cancel, "vla-cancel-" + request_key, start.session_id));
+                    request, frames, model_service_operation::cancel, "vla-cancel-" + request_key, start.session_id));
                 append_model_service_vla_trace(trace, cancel);
                 if (cancel.error_code == "model_service_fault_cancellation_late") {
                     cancellation_late_injected = true;
                     continue;
                 }
                 model_service_response close = host_->call_model_service(make_vla_model_service_request(
-                    request, model_service_operation::close, "vla-close-" + request_key, start.session_id));
+                    request, frames, model_service_operation::close, "vla-close-" + request_key, start.session_id));
                 append_model_service_vla_trace(trace, close);
                 vla_response out;
                 out.status = vla_status::cancelled;
@@ -493,10 +580,10 @@ public:
                 std::chrono::steady_clock::now() - started).count();
             if (request.deadline_ms > 0 && elapsed > request.deadline_ms) {
                 model_service_response cancel = host_->call_model_service(make_vla_model_service_request(
-                    request, model_service_operation::cancel, "vla-timeout-cancel-" + request_key, start.session_id));
+                    request, frames, model_service_operation::cancel, "vla-timeout-cancel-" + request_key, start.session_id));
                 append_model_service_vla_trace(trace, cancel);
                 model_service_response close = host_->call_model_service(make_vla_model_service_request(
-                    request, model_service_operation::close, "vla-timeout-close-" + request_key, start.session_id));
+                    request, frames, model_service_operation::close, "vla-timeout-close-" + request_key, start.session_id));
                 append_model_service_vla_trace(trace, close);
                 vla_response out;
                 out.status = vla_status::timeout;
@@ -507,7 +594,7 @@ public:
             }
 
             model_service_response step = host_->call_model_service(make_vla_model_service_request(
-                request,
+                request, frames,
                 model_service_operation::step,
                 "vla-step-" + request_key + "-" + std::to_string(++step_index),
                 start.session_id));
@@ -525,29 +612,140 @@ public:
             }
 
             model_service_response close = host_->call_model_service(make_vla_model_service_request(
-                request, model_service_operation::close, "vla-close-" + request_key, start.session_id));
+                request, frames, model_service_operation::close, "vla-close-" + request_key, start.session_id));
             append_model_service_vla_trace(trace, close);
             return action_chunk_to_vla_response(request, step, trace);
         }
     }
 
 private:
+    struct batch_item {
+        model_service_request invoke;
+        std::optional<model_service_response> response;
+    };
+
+    // Queues the request and waits for it to be answered by a batched invoke. Whichever waiting job
+    // finds no leader becomes one: it holds the window open until it closes or `limit` requests are
+    // queued, takes up to `limit` of them and hands leadership on before calling the service, so the
+    // next window fills while that batch is in flight.
+    vla_response infer_batched(const vla_request& request,
+                               std::atomic<bool>& cancel_flag,
+                               std::size_t limit,
+                               std::int64_t window_ms) {
+        const auto started = std::chrono::steady_clock::now();
+        const std::string request_key = std::to_string(vla_service::hash_request(request));
+        model_service_vla_trace trace;
+        const std::vector<vla_model_service_frame> frames = vla_model_service_frames(request, host_->vla_ref());
+        trace.frame_refs = vla_model_service_frame_refs(frames);
+        auto item = std::make_shared<batch_item>();
+        item->invoke =
+            make_vla_model_service_request(request, frames, model_service_operation::invoke, "vla-invoke-" + request_key);
+
+        std::unique_lock<std::mutex> lock(batch_mutex_);
+        batch_pending_.push_back(item);
+        batch_cv_.notify_all();
+        while (!item->response.has_value()) {
+            if (cancel_flag.load()) {
+                if (const auto it = std::find(batch_pending_.begin(), batch_pending_.end(), item);
+                    it != batch_pending_.end()) {
+                    batch_pending_.erase(it);
+                    vla_response out;
+                    out.status = vla_status::cancelled;
+                    out.model = request.model;
+                    out.explanation = "cancelled";
+                    attach_model_service_vla_trace(out, trace);
+                    return out;
+                }
+            }
+            if (batch_leader_active_) {
+                batch_cv_.wait_for(lock, std::chrono::milliseconds(1));
+                continue;
+            }
+
+            batch_leader_active_ = true;
+            batch_cv_.wait_until(lock, std::chrono::steady_clock::now() + std::chrono::milliseconds(window_ms), [&] {
+                return batch_pending_.size() >= limit || item->response.has_value();
+            });
+            const std::size_t count = std::min(limit, batch_pending_.size());
+            std::vector<std::shared_ptr<batch_item>> batch(batch_pending_.begin(),
+                                                           batch_pending_.begin() + static_cast<std::ptrdiff_t>(count));
+            batch_pending_.erase(batch_pending_.begin(), batch_pending_.begin() + static_cast<std::ptrdiff_t>(count));
+            batch_leader_active_ = false;
+            batch_cv_.notify_all();
+            if (batch.empty()) {
+                continue;
+            }
+
+            lock.unlock();
+            std::vector<model_service_request> invokes;
+            invokes.reserve(batch.size());
+            for (const std::shared_ptr<batch_item>& queued : batch) {
+                invokes.push_back(queued->invoke);
+            }
+            const model_service_response response = host_->call_model_service(make_model_service_batch_request(
+                invokes, "vla-batch-" + invokes.front().id + "-" + std::to_string(invokes.size())));
+            std::vector<model_service_response> split = split_model_service_batch_response(invokes, response);
+            lock.lock();
+            for (std::size_t i = 0; i < batch.size(); ++i) {
+                batch[i]->response = std::move(split[i]);
+            }
+            batch_cv_.notify_all();
+        }
+        lock.unlock();
+
+        append_model_service_vla_trace(trace, *item->response);
+        const auto elapsed =
+            std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started).count();
+        if (request.deadline_ms > 0 && elapsed > request.deadline_ms) {
+            vla_response out;
+            out.status = vla_status::timeout;
+            out.model = request.model;
+            out.explanation = "deadline exceeded";
+            attach_model_service_vla_trace(out, trace);
+            return out;
+        }
+        return action_chunk_to_vla_response(request, *item->response, trace);
+    }
+
     runtime_host* host_ = nullptr;
+    std::mutex batch_mutex_;
+    std::condition_variable batch_cv_;
+    std::deque<std::shared_ptr<batch_item>> batch_pending_;
+    bool batch_leader_active_ = false;
 };
 
+// Key of a request in an indexed replay cache: the 64-bit value of its "fnv1a64:<hex>" hash.
+std::uint64_t model_service_replay_key(const std::string& request_hash) {
+    const std::size_t colon = request_hash.find(':');
+    const std::size_t start = colon == std::string::npos ? 0 : colon + 1;
+    std::uint64_t key = 0;
+    (void)std::from_chars(request_hash.data() + start, request_hash.data() + request_hash.size(), key, 16);
+    return key;
+}
+
 std::optional<model_service_response> read_model_service_cache(const model_service_config& config,
+                                                               const replay_store* store,
                                                                const std::string& request_hash) {
     if (config.replay_cache_path.empty()) {
         return std::nullopt;
     }
-    const std::filesystem::path path = model_service_cache_file(config, request_hash);
-    std::ifstream in(path);
-    if (!in) {
-        return std::nullopt;
+    std::string text;
+    if (store) {
+        std::optional<std::string> stored = store->find(model_service_replay_key(request_hash));
+        if (!stored.has_value()) {
+            return std::nullopt;
+        }
+        text = std::move(*stored);
+    } else {
+        const std::filesystem::path path = model_service_cache_file(config, request_hash);
+        std::ifstream in(path);
+        if (!in) {
+            return std::nullopt;
+        }
+        std::ostringstream buffer;
+        buffer << in.rdbuf();
+        text = buffer.str();
     }
-    std::ostringstream buffer;
-    buffer << in.rdbuf();
-    std::string text = buffer.str();
     while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) {
         text.pop_back();
     }
@@ -561,11 +759,17 @@ std::optional<model_service_response> read_model_service_cache(const model_servi
 }
 
 void write_model_service_cache(const model_service_config& config,
+                               replay_store* store,
                                const std::string& request_hash,
                                const model_service_response& response) {
     if (config.replay_cache_path.empty()) {
         return;
     }
+    const std::string& json = response.raw_json.empty() ? model_service_response_to_json(response) : response.raw_json;
+    if (store) {
+        store->put(model_service_replay_key(request_hash), json);
+        return;
+    }
     std::error_code ec;
     std::filesystem::create_directories(config.replay_cache_path, ec);
     if (ec) {
@@ -576,7 +780,7 @@ void write_model_service_cache(const model_service_config& config,
     if (!out) {
         return;
     }
-    out << (response.raw_json.empty() ? model_service_response_to_json(response) : response.raw_json);
+    out << json;
 }
 
 model_service_response model_service_replay_miss(const model_service_request& request, const std::string& request_hash) {
@@ -705,13 +909,17 @@ std::optional<model_service_response> injected_model_service_fault(const model_s
 
 }  // namespace
 
-runtime_host::runtime_host()
-    : scheduler_(0),
+runtime_host::runtime_host() : runtime_host(runtime_host_options{}) {}
+
+runtime_host::runtime_host(runtime_host_options options)
+    : scheduler_(options.scheduler_workers, scheduler_limits{}, std::move(options.scheduler_threads)),
       logs_(4096),
       events_(8192),
       vla_(&scheduler_),
       owned_clock_(std::make_unique<system_clock_service>()),
       owned_robot_(std::make_unique<demo_robot_service>()) {
+    // Instances root their leaf arguments in the default heap, so make sure it outlives this host.
+    (void)muslisp::default_gc();
     install_demo_callbacks(*this);
 
     clock_ = owned_clock_.get();
@@ -721,12 +929,16 @@ runtime_host::runtime_host()
                                 std::chrono::duration_cast<std::chrono::milliseconds>(
                                     std::chrono::system_clock::now().time_since_epoch())
                                     .count()));
-    planner_.set_record_listener([this](const planner_record& rec, const std::string& json) {
+    planner_.set_scheduler(&scheduler_);
+    planner_.set_record_listener([this](const planner_record& rec) {
         std::optional<std::uint64_t> tick{};
         if (rec.tick_index > 0) {
             tick = rec.tick_index;
         }
-        std::string data = std::string("{\"record\":") + json + '}';
+        if (!events_.wants(event_family::async, tick)) {
+            return;
+        }
+        std::string data = std::string("{\"record\":") + planner_.record_to_json(rec) + '}';
         (void)events_.emit("planner_v1", tick, data);
     });
     vla_.set_record_listener([this](const vla_record& rec, const std::string& json) {
@@ -751,6 +963,24 @@ runtime_host::runtime_host()
 std::int64_t runtime_host::store_definition(definition def) {
     const std::int64_t handle = next_definition_handle_++;
     definitions_[handle] = std::move(def);
+    definition_handles_[&definitions_.at(handle)] = handle;
+    return handle;
+}
+
+std::int64_t runtime_host::intern_definition(definition def) {
+    if (def.source_hash.empty()) {
+        return store_definition(std::move(def));
+    }
+    const std::uint64_t key = structural_hash(def);
+    const auto it = canonical_definitions_.find(key);
+    if (it != canonical_definitions_.end()) {
+        const definition* existing = find_definition(it->second);
+        if (existing && structurally_equal(*existing, def)) {
+            return it->second;
+        }
+    }
+    const std::int64_t handle = store_definition(std::move(def));
+    canonical_definitions_.insert_or_assign(key, handle);
     return handle;
 }
 
@@ -761,10 +991,27 @@ std::int64_t runtime_host::create_instance(std::int64_t definition_handle) {
     }
 
     const std::int64_t handle = next_instance_handle_++;
-    auto inst = std::make_unique<instance>(def);
+    definition_cache& cache = definition_caches_[definition_handle];
+    if (!cache.pool) {
+        cache.pool = std::make_unique<instance_pool>(def, cache.leaf_args.lock(), instance_trace_capacity_);
+    }
+    std::unique_ptr<instance> inst = cache.pool->acquire();
+    cache.leaf_args = inst->leaf_arg_values;
     inst->instance_handle = handle;
+    // A recycled instance is still linked unless callbacks were registered since it was released.
+    if (!inst->leaf_links || inst->leaf_bindings_generation != registry_.generation()) {
+        inst->link_leaves(registry_, cache.leaf_links.lock());
+    }
+    cache.leaf_links = inst->leaf_links;
+    inst->bb.set_handle_refs(vla_.handle_refs());
     set_tick_budget_ms(*inst, 20);
-    events_.emit_bt_def(*def);
+    // Describing a definition builds its canonical DSL, so skip it while nobody is listening.
+    if (events_.enabled()) {
+        if (!cache.bt_def) {
+            cache.bt_def = event_log::describe_bt_def(*def);
+        }
+        events_.emit_bt_def(*cache.bt_def);
+    }
     instances_[handle] = std::move(inst);
     return handle;
 }
@@ -779,6 +1026,45 @@ const definition* runtime_host::find_definition(std::int64_t handle) const {
     return it == definitions_.end() ? nullptr : &it->second;
 }
 
+std::optional<std::int64_t> runtime_host::find_dsl_definition(const std::string& source_hash,
+                                                              std::size_t source_size) const {
+    const auto it = dsl_cache_.find(source_hash);
+    if (it == dsl_cache_.end() || it->second.source_size != source_size || !find_definition(it->second.handle)) {
+        return std::nullopt;
+    }
+    return it->second.handle;
+}
+
+void runtime_host::remember_dsl_definition(const std::string& source_hash,
+                                           std::size_t source_size,
+                                           std::int64_t handle) {
+    if (!find_definition(handle)) {
+        throw std::invalid_argument("remember_dsl_definition: unknown definition handle");
+    }
+    dsl_cache_[source_hash] = dsl_cache_entry{handle, source_size};
+}
+
+std::vector<std::int64_t> runtime_host::load_dsl_files(std::span<const std::string> paths, std::size_t workers) {
+    std::vector<dsl_file_result> results = compile_dsl_files(paths, workers);
+    for (const dsl_file_result& result : results) {
+        if (!result.def.has_value()) {
+            throw std::runtime_error(result.path + ": " + result.error);
+        }
+    }
+    std::vector<std::int64_t> handles;
+    handles.reserve(results.size());
+    for (dsl_file_result& result : results) {
+        if (const std::optional<std::int64_t> cached = find_dsl_definition(result.source_hash, result.source_size)) {
+            handles.push_back(*cached);
+            continue;
+        }
+        const std::int64_t handle = intern_definition(std::move(*result.def));
+        remember_dsl_definition(result.source_hash, result.source_size, handle);
+        handles.push_back(handle);
+    }
+    return handles;
+}
+
 instance* runtime_host::find_instance(std::int64_t handle) {
     const auto it = instances_.find(handle);
     return it == instances_.end() ? nullptr : it->second.get();
@@ -794,6 +1080,9 @@ status runtime_host::tick_instance(std::int64_t handle) {
     if (!inst) {
         throw std::invalid_argument("tick_instance: unknown instance handle");
     }
+    if (first_tick_at_.load(std::memory_order_relaxed) == 0) {
+        note_first_tick();
+    }
 
     services svc;
     svc.sched = &scheduler_;
@@ -805,7 +1094,133 @@ status runtime_host::tick_instance(std::int64_t handle) {
     svc.planner = &planner_;
     svc.vla = &vla_;
 
-    return tick(*inst, registry_, svc);
+    if (!metrics_.enabled()) {
+        return tick(*inst, registry_, svc);
+    }
+    const std::uint64_t overruns_before = inst->tree_stats.tick_overrun_count;
+    const status result = tick(*inst, registry_, svc);
+    metrics_.record_tick(inst->tree_stats.tick_duration.last, inst->tree_stats.tick_overrun_count != overruns_before);
+    return result;
+}
+
+void runtime_host::note_first_tick() {
+    std::int64_t expected = 0;
+    const std::int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+    if (first_tick_at_.compare_exchange_strong(expected, now) && first_tick_listener_) {
+        first_tick_listener_();
+    }
+}
+
+std::optional<std::chrono::steady_clock::time_point> runtime_host::first_tick_time() const noexcept {
+    const std::int64_t at = first_tick_at_.load(std::memory_order_relaxed);
+    if (at == 0) {
+        return std::nullopt;
+    }
+    return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(at));
+}
+
+void runtime_host::set_first_tick_listener(std::function<void()> listener) {
+    first_tick_listener_ = std::move(listener);
+}
+
+log_replay_report runtime_host::replay_instance(std::int64_t handle, log_replay& replay, const log_replay_options& options) {
+    instance* inst = find_instance(handle);
+    if (!inst) {
+        throw std::invalid_argument("replay_instance: unknown instance handle");
+    }
+
+    services svc;
+    svc.sched = &scheduler_;
+    svc.obs.trace = &inst->trace;
+    svc.robot = robot_;
+    svc.planner = &planner_;
+    svc.vla = &vla_;
+    return replay.run(*inst, registry_, svc, options);
+}
+
+void runtime_host::tick_instances(std::span<const std::int64_t> handles, std::span<status> out) {
+    if (out.size() < handles.size()) {
+        throw std::invalid_argument("tick_instances: status span is shorter than the handle span");
+    }
+    wave_instances_.clear();
+    wave_instances_.reserve(handles.size());
+    for (const std::int64_t handle : handles) {
+        instance* inst = find_instance(handle);
+        if (!inst) {
+            throw std::invalid_argument("tick_instances: unknown instance handle");
+        }
+        wave_instances_.push_back(inst);
+    }
+    if (first_tick_at_.load(std::memory_order_relaxed) == 0 && !handles.empty()) {
+        note_first_tick();
+    }
+
+    services svc;
+    svc.sched = &scheduler_;
+    svc.obs.logger = &logs_;
+    svc.obs.events = &events_;
+    svc.clock = clock_;
+    svc.robot = robot_;
+    svc.planner = &planner_;
+    svc.vla = &vla_;
+
+    if (!metrics_.enabled()) {
+        if (tick_pool_) {
+            tick_pooled_wave(svc, out);
+            return;
+        }
+        tick_wave(wave_instances_, registry_, svc, out);
+        return;
+    }
+
+    wave_overruns_.clear();
+    for (const instance* inst : wave_instances_) {
+        wave_overruns_.push_back(inst->tree_stats.tick_overrun_count);
+    }
+    if (tick_pool_) {
+        tick_pooled_wave(svc, out);
+    } else {
+        tick_wave(wave_instances_, registry_, svc, out);
+    }
+    // Recorded here, on the calling thread, so the histograms keep a single writer under a tick pool.
+    for (std::size_t i = 0; i < wave_instances_.size(); ++i) {
+        const tree_profile_stats& stats = wave_instances_[i]->tree_stats;
+        metrics_.record_tick(stats.tick_duration.last, stats.tick_overrun_count != wave_overruns_[i]);
+    }
+}
+
+void runtime_host::tick_pooled_wave(services& svc, std::span<status> out) {
+    const std::uint64_t sequential_before = tick_pool_->sequential_waves();
+    tick_pool_->tick_wave(wave_instances_, registry_, svc, out);
+    if (sequential_before == 0 && tick_pool_->sequential_waves() != 0) {
+        logs_.write(log_record{.ts = std::chrono::steady_clock::now(),
+                               .level = log_level::warn,
+                               .category = "bt",
+                               .message = "tick workers: a wave with Lisp leaves was ticked on the calling thread; "
+                                          "only trees whose leaves are all native callbacks tick in parallel"});
+    }
+}
+
+void runtime_host::set_tick_workers(std::size_t count) {
+    if (count == tick_workers()) {
+        return;
+    }
+    tick_pool_.reset();
+    if (count > 1) {
+        tick_pool_ = std::make_unique<tick_worker_pool>(
+            count, [](event_log& shard, const muslisp::gc_lifecycle_event& event) {
+                if (!shard.wants(event_family::lifecycle)) {
+                    return;
+                }
+                (void)shard.emit(event.begin ? muesli_bt::contract::kEventGcBegin : muesli_bt::contract::kEventGcEnd,
+                                 std::nullopt,
+                                 gc_lifecycle_payload_json(event));
+            });
+    }
+}
+
+std::size_t runtime_host::tick_workers() const noexcept {
+    return tick_pool_ ? tick_pool_->worker_count() : 1u;
 }
 
 void runtime_host::reset_instance(std::int64_t handle) {
@@ -816,6 +1231,104 @@ void runtime_host::reset_instance(std::int64_t handle) {
     reset(*inst);
 }
 
+void runtime_host::release_instance(std::int64_t handle) {
+    const auto it = instances_.find(handle);
+    if (it == instances_.end()) {
+        throw std::invalid_argument("release_instance: unknown instance handle");
+    }
+    instance& inst = *it->second;
+    if (inst.def && inst.slots_def == inst.def && inst.live_memory_nodes[inst.def->root] != 0u) {
+        services svc;
+        svc.sched = &scheduler_;
+        svc.obs.trace = &inst.trace;
+        svc.obs.logger = &logs_;
+        svc.obs.events = &events_;
+        svc.clock = clock_;
+        svc.robot = robot_;
+        svc.planner = &planner_;
+        svc.vla = &vla_;
+        halt_subtree(inst, registry_, svc, inst.def->root, "release");
+    }
+
+    std::unique_ptr<instance> owned = std::move(it->second);
+    instances_.erase(it);
+    const auto def = definition_handles_.find(owned->def);
+    if (def == definition_handles_.end()) {
+        return;
+    }
+    definition_cache& cache = definition_caches_[def->second];
+    if (cache.pool) {
+        cache.pool->release(std::move(owned));
+    }
+}
+
+void runtime_host::set_instance_trace_capacity(std::size_t capacity) {
+    instance_trace_capacity_ = capacity;
+    for (auto& [handle, cache] : definition_caches_) {
+        if (cache.pool) {
+            cache.pool->set_trace_capacity(capacity);
+        }
+    }
+}
+
+std::size_t runtime_host::idle_instance_count(std::int64_t definition_handle) const {
+    const auto it = definition_caches_.find(definition_handle);
+    return it == definition_caches_.end() || !it->second.pool ? 0u : it->second.pool->idle_count();
+}
+
+std::int64_t runtime_host::fork_instance(std::int64_t handle) {
+    const instance* src = find_instance(handle);
+    if (!src) {
+        throw std::invalid_argument("fork_instance: unknown instance handle");
+    }
+    const auto def = definition_handles_.find(src->def);
+    if (def == definition_handles_.end()) {
+        throw std::invalid_argument("fork_instance: instance definition is not stored in this host");
+    }
+    const std::int64_t fork_handle = create_instance(def->second);
+    try {
+        fork_state(*src, *instances_.at(fork_handle));
+    } catch (...) {
+        instances_.erase(fork_handle);
+        throw;
+    }
+    return fork_handle;
+}
+
+std::size_t runtime_host::swap_instance_definition(std::int64_t instance_handle, std::int64_t definition_handle) {
+    instance* inst = find_instance(instance_handle);
+    if (!inst) {
+        throw std::invalid_argument("swap_instance_definition: unknown instance handle");
+    }
+    const definition* def = find_definition(definition_handle);
+    if (!def) {
+        throw std::invalid_argument("swap_instance_definition: unknown definition handle");
+    }
+
+    services svc;
+    svc.sched = &scheduler_;
+    svc.obs.trace = &inst->trace;
+    svc.obs.logger = &logs_;
+    svc.obs.events = &events_;
+    svc.clock = clock_;
+    svc.robot = robot_;
+    svc.planner = &planner_;
+    svc.vla = &vla_;
+
+    definition_cache& cache = definition_caches_[definition_handle];
+    const std::size_t halted = swap_definition(*inst, def, registry_, svc, cache.leaf_args.lock());
+    cache.leaf_args = inst->leaf_arg_values;
+    inst->link_leaves(registry_, cache.leaf_links.lock());
+    cache.leaf_links = inst->leaf_links;
+    if (events_.enabled()) {
+        if (!cache.bt_def) {
+            cache.bt_def = event_log::describe_bt_def(*def);
+        }
+        events_.emit_bt_def(*cache.bt_def);
+    }
+    return halted;
+}
+
 registry& runtime_host::callbacks() noexcept {
     return registry_;
 }
@@ -848,17 +1361,51 @@ const vla_service& runtime_host::vla_ref() const {
     return vla_;
 }
 
-void runtime_host::set_model_service_client(model_service_config config, std::unique_ptr<model_service_client> client) {
+void runtime_host::set_model_service_client(model_service_config config,
+                                            std::unique_ptr<model_service_client> client,
+                                            std::unique_ptr<model_service_client> hedge_client) {
+    std::shared_ptr<frame_ring> ring;
+    if (!config.frame_ring_name.empty()) {
+        ring = frame_ring::create(config.frame_ring_name, config.frame_ring_slots, config.frame_ring_slot_bytes);
+    }
+    std::shared_ptr<replay_store> store;
+    if (config.replay_cache_format == "indexed" && !config.replay_cache_path.empty()) {
+        store = replay_store::open(config.replay_cache_path);
+    } else if (config.replay_cache_format != "files" && config.replay_cache_format != "indexed") {
+        throw std::invalid_argument("model-service replay_cache_format must be files or indexed");
+    }
+    vla_.attach_frame_ring(std::move(ring));
+    model_service_replay_store_ = std::move(store);
     model_service_config_ = std::move(config);
     model_service_client_ = std::move(client);
+    model_service_hedge_client_ = std::move(hedge_client);
     model_service_fault_index_ = 0;
+    {
+        std::lock_guard<std::mutex> lock(model_service_latency_mutex_);
+        model_service_latency_ms_.clear();
+        model_service_latency_next_ = 0;
+        model_service_hedge_stats_ = {};
+    }
+    {
+        std::lock_guard<std::mutex> lock(model_service_describe_mutex_);
+        model_service_describe_output_.reset();
+        model_service_failed_check_.reset();
+    }
+    model_service_check_pending_.store(false);
     vla_.register_backend("model-service", std::make_shared<model_service_vla_backend>(this));
 }
 
 void runtime_host::clear_model_service_client() noexcept {
     model_service_client_.reset();
+    model_service_hedge_client_.reset();
+    model_service_replay_store_.reset();
+    vla_.attach_frame_ring(nullptr);
     model_service_config_ = model_service_config{};
     model_service_fault_index_ = 0;
+    model_service_check_pending_.store(false);
+    std::lock_guard<std::mutex> lock(model_service_describe_mutex_);
+    model_service_describe_output_.reset();
+    model_service_failed_check_.reset();
 }
 
 bool runtime_host::model_service_configured() const noexcept {
@@ -875,7 +1422,7 @@ model_service_response runtime_host::call_model_service(const model_service_requ
     const std::string replay_mode = request.replay_mode.empty() ? model_service_config_.replay_mode
                                                                 : request.replay_mode;
     if (replay_mode == "replay") {
-        if (std::optional<model_service_response> cached = read_model_service_cache(model_service_config_, request_hash);
+        if (std::optional<model_service_response> cached = read_model_service_cache(model_service_config_, model_service_replay_store_.get(), request_hash);
             cached.has_value()) {
             validate_model_service_response(request, *cached);
             return *cached;
@@ -884,7 +1431,9 @@ model_service_response runtime_host::call_model_service(const model_service_requ
     }
 
     model_service_response response;
-    if (model_service_fault_index_ < model_service_config_.fault_schedule.size()) {
+    if (std::optional<model_service_response> refused = model_service_first_use_refusal(request); refused.has_value()) {
+        response = std::move(*refused);
+    } else if (model_service_fault_index_ < model_service_config_.fault_schedule.size()) {
         const std::string fault = model_service_config_.fault_schedule[model_service_fault_index_++];
         if (std::optional<model_service_response> injected = injected_model_service_fault(request, fault);
             injected.has_value()) {
@@ -895,7 +1444,7 @@ model_service_response runtime_host::call_model_service(const model_service_requ
         unavailable_model_service_client unavailable;
         response = unavailable.call(request);
     } else if (response.id.empty()) {
-        response = model_service_client_->call(request);
+        response = call_model_service_client(request);
     }
 
     response.request_hash = request_hash;
@@ -906,11 +1455,124 @@ model_service_response runtime_host::call_model_service(const model_service_requ
     response.replay_cache_hit = false;
     validate_model_service_response(request, response);
     if (replay_mode == "record") {
-        write_model_service_cache(model_service_config_, request_hash, response);
+        write_model_service_cache(model_service_config_, model_service_replay_store_.get(), request_hash, response);
     }
     return response;
 }
 
+model_service_response runtime_host::call_model_service_client(const model_service_request& request) {
+    const auto start = std::chrono::steady_clock::now();
+    const std::optional<std::chrono::nanoseconds> delay =
+        request.op == model_service_operation::invoke ? model_service_hedge_delay() : std::nullopt;
+    const auto usable = [&request](const model_service_response& response) {
+        if (response.status != model_service_status::success && response.status != model_service_status::action_chunk) {
+            return false;
+        }
+        model_service_response checked = response;
+        validate_model_service_response(request, checked);
+        return !checked.validation_checked || checked.validation_ok;
+    };
+    const auto finish = [&](model_service_response response) {
+        if (request.op == model_service_operation::invoke && usable(response)) {
+            record_model_service_latency(std::chrono::steady_clock::now() - start);
+        }
+        return response;
+    };
+
+    if (!delay.has_value()) {
+        return finish(model_service_client_->call(request));
+    }
+    std::future<model_service_response> primary = model_service_client_->call_async(request);
+    if (primary.wait_for(*delay) == std::future_status::ready) {
+        return finish(primary.get());
+    }
+
+    // Sessions are not hedged, so the duplicate of an invoke is independent; it gets its own id so
+    // that a pipelined connection can tell the two responses apart.
+    model_service_request duplicate = request;
+    duplicate.id += ".hedge";
+    model_service_client& secondary = model_service_hedge_client_ ? *model_service_hedge_client_ : *model_service_client_;
+    std::future<model_service_response> hedge = secondary.call_async(duplicate);
+    {
+        std::lock_guard<std::mutex> lock(model_service_latency_mutex_);
+        ++model_service_hedge_stats_.hedged;
+    }
+
+    // Whichever answers first is taken if usable; an unusable answer waits for the other one.
+    const auto take_hedge = [&request](std::future<model_service_response>& future) {
+        model_service_response response = future.get();
+        response.id = request.id;
+        response.raw_json = model_service_response_to_json(response);
+        return response;
+    };
+    const auto count_hedge_win = [this] {
+        std::lock_guard<std::mutex> lock(model_service_latency_mutex_);
+        ++model_service_hedge_stats_.hedge_wins;
+    };
+    constexpr auto k_poll = std::chrono::microseconds(200);
+    for (;;) {
+        if (primary.wait_for(k_poll) == std::future_status::ready) {
+            model_service_response response = primary.get();
+            if (usable(response)) {
+                return finish(std::move(response));
+            }
+            model_service_response other = take_hedge(hedge);
+            if (!usable(other)) {
+                return response;
+            }
+            count_hedge_win();
+            return finish(std::move(other));
+        }
+        if (hedge.wait_for(std::chrono::microseconds(0)) == std::future_status::ready) {
+            model_service_response response = take_hedge(hedge);
+            if (!usable(response)) {
+                return finish(primary.get());
+            }
+            count_hedge_win();
+            return finish(std::move(response));
+        }
+    }
+}
+
+std::optional<std::chrono::nanoseconds> runtime_host::model_service_hedge_delay() const {
+    const double percentile = model_service_config_.hedge_percentile;
+    if (!(percentile > 0.0 && percentile < 100.0)) {
+        return std::nullopt;
+    }
+    constexpr std::size_t k_min_samples = 16;
+    std::vector<double> samples;
+    {
+        std::lock_guard<std::mutex> lock(model_service_latency_mutex_);
+        if (model_service_latency_ms_.size() < k_min_samples) {
+            return std::nullopt;
+        }
+        samples = model_service_latency_ms_;
+    }
+    const auto rank = static_cast<std::size_t>(percentile / 100.0 * static_cast<double>(samples.size() - 1));
+    std::nth_element(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(rank), samples.end());
+    const double delay_ms = std::max(samples[rank], static_cast<double>(model_service_config_.hedge_min_delay_ms));
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double, std::milli>(delay_ms));
+}
+
+void runtime_host::record_model_service_latency(std::chrono::steady_clock::duration latency) {
+    const double ms = std::chrono::duration<double, std::milli>(latency).count();
+    std::lock_guard<std::mutex> lock(model_service_latency_mutex_);
+    if (metrics_.enabled()) {
+        metrics_.record_model_service_call(std::chrono::duration_cast<std::chrono::nanoseconds>(latency));
+    }
+    if (model_service_latency_ms_.size() < k_model_service_latency_window) {
+        model_service_latency_ms_.push_back(ms);
+        return;
+    }
+    model_service_latency_ms_[model_service_latency_next_] = ms;
+    model_service_latency_next_ = (model_service_latency_next_ + 1) % k_model_service_latency_window;
+}
+
+model_service_hedge_stats runtime_host::model_service_hedge_stats_snapshot() const {
+    std::lock_guard<std::mutex> lock(model_service_latency_mutex_);
+    return model_service_hedge_stats_;
+}
+
 model_service_compatibility_result runtime_host::check_model_service_compatibility() {
     if (!model_service_client_) {
         unavailable_model_service_client unavailable;
@@ -921,6 +1583,59 @@ model_service_compatibility_result runtime_host::check_model_service_compatibili
                                                  model_service_config_.request_timeout_ms);
 }
 
+void runtime_host::check_model_service_on_first_use() {
+    {
+        std::lock_guard<std::mutex> lock(model_service_describe_mutex_);
+        model_service_failed_check_.reset();
+    }
+    model_service_check_pending_.store(true);
+}
+
+std::optional<model_service_response> runtime_host::model_service_first_use_refusal(
+    const model_service_request& request) {
+    if (request.op == model_service_operation::describe || !model_service_check_pending_.load()) {
+        return std::nullopt;
+    }
+    std::lock_guard<std::mutex> lock(model_service_describe_mutex_);
+    if (!model_service_failed_check_.has_value()) {
+        if (!model_service_check_pending_.load()) {
+            return std::nullopt;
+        }
+        model_service_compatibility_result check = check_model_service_compatibility();
+        if (check.compatible) {
+            model_service_check_pending_.store(false);
+            return std::nullopt;
+        }
+        model_service_failed_check_ = std::move(check);
+    }
+    model_service_response refused;
+    refused.id = request.id;
+    refused.status = model_service_status::unavailable;
+    refused.error_code = "model_service_incompatible";
+    refused.error_message = "compatibility check failed: " + (model_service_failed_check_->error_code.empty()
+                                                                  ? model_service_failed_check_->error_message
+                                                                  : model_service_failed_check_->error_code);
+    return refused;
+}
+
+std::size_t runtime_host::model_service_batch_limit(const std::string& capability) {
+    std::lock_guard<std::mutex> lock(model_service_describe_mutex_);
+    if (!model_service_client_) {
+        return 1;
+    }
+    if (!model_service_describe_output_.has_value()) {
+        model_service_request request;
+        request.id = "model-service-describe-batch";
+        request.op = model_service_operation::describe;
+        request.deadline_ms = model_service_config_.request_timeout_ms;
+        const model_service_response response = model_service_client_->call(request);
+        // A failed describe is remembered as "no batching" rather than retried on every request.
+        model_service_describe_output_ =
+            response.status == model_service_status::success ? response.output_json : std::string("{}");
+    }
+    return bt::model_service_batch_limit(*model_service_describe_output_, capability);
+}
+
 memory_log_sink& runtime_host::logs() noexcept {
     return logs_;
 }
@@ -939,6 +1654,7 @@ const event_log& runtime_host::events() const noexcept {
 
 void runtime_host::set_clock_interface(clock_interface* clock) noexcept {
     clock_ = clock ? clock : owned_clock_.get();
+    clock_before_sim_ = nullptr;
 }
 
 clock_interface* runtime_host::clock_interface_ptr() noexcept {
@@ -949,6 +1665,32 @@ const clock_interface* runtime_host::clock_interface_ptr() const noexcept {
     return clock_;
 }
 
+sim_clock& runtime_host::enable_simulated_time() {
+    if (!sim_clock_) {
+        sim_clock_ = std::make_unique<sim_clock>();
+    }
+    if (clock_before_sim_ == nullptr) {
+        clock_before_sim_ = clock_;
+        clock_ = sim_clock_.get();
+    }
+    return *sim_clock_;
+}
+
+void runtime_host::disable_simulated_time() noexcept {
+    if (clock_before_sim_ != nullptr) {
+        clock_ = clock_before_sim_;
+        clock_before_sim_ = nullptr;
+    }
+}
+
+sim_clock* runtime_host::simulated_clock() noexcept {
+    return clock_before_sim_ != nullptr ? sim_clock_.get() : nullptr;
+}
+
+bool runtime_host::settle_jobs(std::chrono::steady_clock::duration timeout) {
+    return scheduler_.wait_idle(timeout);
+}
+
 void runtime_host::set_robot_interface(robot_interface* robot) noexcept {
     robot_ = robot ? robot : owned_robot_.get();
 }
@@ -970,12 +1712,15 @@ void runtime_host::enable_deterministic_test_mode(std::uint64_t planner_seed,
     }
     deterministic_test_mode_enabled_ = true;
     planner_.set_base_seed(planner_seed);
+    // A cache hit returns an action planned from an earlier seed.
+    planner_.set_cache_enabled(false);
     events_.set_run_id(std::move(run_id));
     events_.set_deterministic_time(unix_ms_start, unix_ms_step);
 }
 
 void runtime_host::disable_deterministic_test_mode() noexcept {
     deterministic_test_mode_enabled_ = false;
+    planner_.set_cache_enabled(true);
     events_.clear_deterministic_time();
 }
 
@@ -990,13 +1735,109 @@ void runtime_host::clear_logs() {
 
 void runtime_host::clear_all() {
     definitions_.clear();
+    definition_handles_.clear();
+    dsl_cache_.clear();
+    canonical_definitions_.clear();
+    definition_caches_.clear();
+    instance_trace_capacity_ = instance::k_default_trace_capacity;
+    wave_instances_.clear();
+    tick_pool_.reset();
     instances_.clear();
     registry_.clear();
     logs_.clear();
     events_.clear_ring();
     planner_.clear_records();
     vla_.clear_records();
+    vla_.clear_handles();
+    vla_.payload_pool_ref().set_capacity(payload_pool::k_default_capacity_bytes);
     clear_model_service_client();
+    stop_metrics_endpoint();
+    metrics_.set_enabled(false);
+    metrics_.reset();
+}
+
+void runtime_host::set_metrics_enabled(bool enabled) noexcept {
+    metrics_.set_enabled(enabled);
+}
+
+bool runtime_host::metrics_enabled() const noexcept {
+    return metrics_.enabled();
+}
+
+runtime_metrics& runtime_host::metrics() noexcept {
+    return metrics_;
+}
+
+std::string runtime_host::render_metrics() const {
+    std::string out;
+    out.reserve(16384);
+    metrics_.append_openmetrics(out);
+
+    const scheduler_profile_stats sched = scheduler_.stats_snapshot();
+    append_openmetrics_counter(out, "muesli_bt_scheduler_jobs_submitted", "Jobs submitted to the scheduler.", sched.submitted);
+    append_openmetrics_counter(out, "muesli_bt_scheduler_jobs_completed", "Jobs that completed.", sched.completed);
+    append_openmetrics_counter(out, "muesli_bt_scheduler_jobs_failed", "Jobs that failed.", sched.failed);
+    append_openmetrics_counter(out, "muesli_bt_scheduler_jobs_cancelled", "Jobs cancelled, including expired ones.", sched.cancelled);
+    append_openmetrics_counter(out, "muesli_bt_scheduler_jobs_expired", "Jobs whose deadline passed while queued.", sched.expired);
+    append_openmetrics_counter(
+        out, "muesli_bt_scheduler_queue_overflows", "Submits made while every job slot was busy.", sched.queue_overflow);
+    const std::uint64_t finished = sched.completed + sched.failed + sched.cancelled;
+    append_openmetrics_gauge(out,
+                             "muesli_bt_scheduler_jobs_in_flight",
+                             "Jobs submitted but not yet finished: queued plus running.",
+                             static_cast<double>(sched.submitted > finished ? sched.submitted - finished : 0u));
+    append_openmetrics_histogram(out,
+                                 "muesli_bt_scheduler_queue_delay_seconds",
+                                 "Time jobs waited in the queue before a worker started them.",
+                                 sched.queue_delay.histogram,
+                                 sched.queue_delay.total);
+    append_openmetrics_histogram(out,
+                                 "muesli_bt_scheduler_run_time_seconds",
+                                 "Time workers spent running jobs.",
+                                 sched.run_time.histogram,
+                                 sched.run_time.total);
+
+    const event_log_stats events = events_.capture_stats();
+    append_openmetrics_counter(
+        out, "muesli_bt_event_log_events", "Events emitted while event-log capture stats were enabled.", events.event_count);
+    append_openmetrics_counter(
+        out, "muesli_bt_event_log_bytes", "Serialised event bytes while event-log capture stats were enabled.", events.byte_count);
+    append_openmetrics_counter(
+        out, "muesli_bt_event_log_dropped_lines", "Lines the asynchronous file sink dropped.", events.dropped_line_count);
+    if (const std::optional<net_sink_stats> net = events_.net_stats()) {
+        append_openmetrics_counter(out, "muesli_bt_event_net_frames", "Frames the network event sink sent.", net->frames_sent);
+        append_openmetrics_counter(
+            out, "muesli_bt_event_net_dropped_lines", "Lines the network event sink did not deliver.", net->dropped_lines());
+    }
+
+    const vla_cache_stats cache = vla_.cache_stats();
+    append_openmetrics_counter(out, "muesli_bt_vla_cache_hits", "VLA response cache hits.", cache.hits);
+    append_openmetrics_counter(out, "muesli_bt_vla_cache_misses", "VLA response cache misses.", cache.misses);
+    append_openmetrics_counter(out, "muesli_bt_vla_cache_evictions", "VLA cache entries dropped to stay within capacity.", cache.evictions);
+    append_openmetrics_gauge(out, "muesli_bt_vla_cache_entries", "Live VLA response cache entries.", static_cast<double>(cache.size));
+
+    const model_service_hedge_stats hedges = model_service_hedge_stats_snapshot();
+    append_openmetrics_counter(out, "muesli_bt_model_service_hedged_calls", "Invoke calls that were hedged.", hedges.hedged);
+    append_openmetrics_counter(
+        out, "muesli_bt_model_service_hedge_wins", "Hedged calls answered first by the duplicate.", hedges.hedge_wins);
+
+    out += "# EOF\n";
+    return out;
+}
+
+std::uint16_t runtime_host::start_metrics_endpoint(std::uint16_t port, const std::string& bind_address) {
+    metrics_endpoint_.reset();
+    metrics_endpoint_ = std::make_unique<metrics_endpoint>(bind_address, port, [this] { return render_metrics(); });
+    metrics_.set_enabled(true);
+    return metrics_endpoint_->port();
+}
+
+void runtime_host::stop_metrics_endpoint() noexcept {
+    metrics_endpoint_.reset();
+}
+
+std::uint16_t runtime_host::metrics_endpoint_port() const noexcept {
+    return metrics_endpoint_ ? metrics_endpoint_->port() : 0u;
 }
 
 std::string runtime_host::dump_instance_stats(std::int64_t handle) const {
@@ -1023,6 +1864,66 @@ std::string runtime_host::dump_instance_blackboard(std::int64_t handle) const {
     return dump_blackboard(*inst);
 }
 
+std::string runtime_host::dump_instance_flamegraph(std::int64_t handle) const {
+    const instance* inst = find_instance(handle);
+    if (!inst) {
+        throw std::invalid_argument("dump_instance_flamegraph: unknown instance handle");
+    }
+    return bt::dump_flamegraph(*inst);
+}
+
+std::string runtime_host::dump_flamegraph() const {
+    std::vector<std::int64_t> handles;
+    handles.reserve(instances_.size());
+    for (const auto& [handle, inst] : instances_) {
+        handles.push_back(handle);
+    }
+    std::sort(handles.begin(), handles.end());
+
+    std::string out;
+    for (const std::int64_t handle : handles) {
+        out += bt::dump_flamegraph(*instances_.at(handle), "inst-" + std::to_string(handle));
+    }
+    return out;
+}
+
+bt::memory_report runtime_host::memory_report() const {
+    bt::memory_report report;
+    std::unordered_set<const void*> shared_tables;
+    const auto add_instance = [&](const instance& inst) {
+        const instance_footprint footprint = measure_instance(inst);
+        report.instance_state_bytes += footprint.state_bytes;
+        report.blackboard_bytes += footprint.blackboard_bytes;
+        report.trace_bytes += footprint.trace_bytes;
+        // Instances of one definition share these tables; count each once, under the definition.
+        report.definition_bytes += shared_tables_footprint(inst, shared_tables);
+    };
+
+    report.definition_count = definitions_.size();
+    for (const auto& [handle, def] : definitions_) {
+        report.definition_bytes += definition_footprint(def);
+    }
+    report.instance_count = instances_.size();
+    for (const auto& [handle, inst] : instances_) {
+        add_instance(*inst);
+    }
+    for (const auto& [handle, cache] : definition_caches_) {
+        if (!cache.pool) {
+            continue;
+        }
+        report.idle_instance_count += cache.pool->idle_count();
+        for (const std::unique_ptr<instance>& inst : cache.pool->idle()) {
+            add_instance(*inst);
+        }
+    }
+    report.event_ring_bytes = events_.ring_memory_bytes();
+    report.log_ring_bytes = logs_.memory_bytes();
+    const muslisp::gc_stats_snapshot heap = muslisp::default_gc().stats();
+    report.lisp_heap_bytes = heap.bytes_allocated;
+    report.lisp_heap_reserved_bytes = heap.pool_reserved_bytes;
+    return report;
+}
+
 std::string runtime_host::dump_scheduler_stats() const {
     const scheduler_profile_stats stats = scheduler_.stats_snapshot();
 
@@ -1032,8 +1933,48 @@ std::string runtime_host::dump_scheduler_stats() const {
     out << "completed=" << stats.completed << '\n';
     out << "failed=" << stats.failed << '\n';
     out << "cancelled=" << stats.cancelled << '\n';
+    out << "queue_overflow=" << stats.queue_overflow << '\n';
+    out << "expired=" << stats.expired << '\n';
     out << "queue_delay_last_ns=" << stats.queue_delay.last.count() << '\n';
     out << "run_time_last_ns=" << stats.run_time.last.count() << '\n';
+    out << "queue_delay_max_ns=" << stats.queue_delay.max.count() << '\n';
+    out << "run_time_max_ns=" << stats.run_time.max.count() << '\n';
+    for (const reported_quantile& rq : k_reported_quantiles) {
+        out << "queue_delay_" << rq.label << "_ns=" << stats.queue_delay.percentile(rq.q).count() << '\n';
+    }
+    for (const reported_quantile& rq : k_reported_quantiles) {
+        out << "run_time_" << rq.label << "_ns=" << stats.run_time.percentile(rq.q).count() << '\n';
+    }
+    for (std::size_t i = 0; i < k_job_priority_count; ++i) {
+        const duration_stats& delay = stats.queue_delay_by_priority[i];
+        const char* name = job_priority_name(static_cast<job_priority>(i));
+        out << "queue_delay_" << name << "_count=" << delay.count << '\n';
+        out << "queue_delay_" << name << "_max_ns=" << delay.max.count() << '\n';
+        out << "queue_delay_" << name << "_p99_ns=" << delay.percentile(0.99).count() << '\n';
+    }
+
+    const scheduler_thread_options& threads = scheduler_.thread_options();
+    out << "workers=" << scheduler_.worker_count() << '\n';
+    out << "worker_name_prefix=" << threads.name_prefix << '\n';
+    out << "worker_cpus=";
+    for (std::size_t i = 0; i < threads.cpus.size(); ++i) {
+        out << (i == 0 ? "" : ",") << threads.cpus[i];
+    }
+    out << '\n';
+    if (threads.fifo_priority.has_value()) {
+        out << "worker_fifo_priority=" << *threads.fifo_priority << '\n';
+    }
+    if (threads.nice.has_value()) {
+        out << "worker_nice=" << *threads.nice << '\n';
+    }
+    const std::vector<std::string> setup_errors = scheduler_.thread_setup_errors();
+    out << "thread_setup_errors=" << setup_errors.size() << '\n';
+    for (const std::string& error : setup_errors) {
+        out << "thread_setup_error=" << error << '\n';
+    }
+    out << "tick_workers=" << tick_workers() << '\n';
+    out << "tick_waves_parallel=" << (tick_pool_ ? tick_pool_->parallel_waves() : 0) << '\n';
+    out << "tick_waves_sequential=" << (tick_pool_ ? tick_pool_->sequential_waves() : 0) << '\n';
     return out.str();
 }
 
@@ -1054,37 +1995,134 @@ std::string runtime_host::dump_vla_records(std::size_t max_count) const {
     return vla_.dump_recent_records(max_count);
 }
 
-runtime_host& default_runtime_host() {
-    static runtime_host host;
+namespace {
+
+std::mutex g_default_host_options_mutex;
+runtime_host_options g_default_host_options;
+bool g_default_host_created = false;
+
+runtime_host_options take_default_runtime_host_options() {
+    std::lock_guard<std::mutex> lock(g_default_host_options_mutex);
+    g_default_host_created = true;
+    return std::move(g_default_host_options);
+}
+
+}  // namespace
+
+void set_default_runtime_host_options(runtime_host_options options) {
+    std::lock_guard<std::mutex> lock(g_default_host_options_mutex);
+    if (g_default_host_created) {
+        throw std::logic_error("set_default_runtime_host_options: default runtime host already exists");
+    }
+    g_default_host_options = std::move(options);
+}
+
+void report_heap_events(runtime_host& host, muslisp::gc& heap) {
     runtime_host* host_ptr = &host;
-    muslisp::default_gc().set_lifecycle_listener([host_ptr](const muslisp::gc_lifecycle_event& event) {
+    heap.set_lifecycle_listener([host_ptr](const muslisp::gc_lifecycle_event& event) {
+        if (!event.begin && host_ptr->metrics_enabled()) {
+            host_ptr->metrics().record_gc_pause(std::chrono::nanoseconds(static_cast<std::int64_t>(event.pause_time_ns)),
+                                                event.minor);
+        }
+        if (!host_ptr->events().wants(event_family::lifecycle)) {
+            return;
+        }
         (void)host_ptr->events().emit(event.begin ? muesli_bt::contract::kEventGcBegin
                                                   : muesli_bt::contract::kEventGcEnd,
                                       std::nullopt,
                                       gc_lifecycle_payload_json(event));
     });
+    heap.set_limit_listener([host_ptr](const muslisp::gc_limit_event& event) {
+        if (host_ptr->events().wants(event_family::alert)) {
+            (void)host_ptr->events().emit("error", std::nullopt, gc_limit_payload_json(event));
+        }
+    });
+}
+
+runtime_host& default_runtime_host() {
+    if (muslisp::runtime_context* context = muslisp::current_runtime_context()) {
+        return context->host();
+    }
+    static runtime_host host(take_default_runtime_host_options());
+    report_heap_events(host, muslisp::default_gc());
     return host;
 }
 
 void install_demo_callbacks(runtime_host& host) {
     registry& reg = host.callbacks();
 
-    reg.register_condition("always-true", [](tick_context&, std::span<const muslisp::value>) { return true; });
-    reg.register_condition("always-false", [](tick_context&, std::span<const muslisp::value>) { return false; });
-
-    reg.register_condition("bb-has", [](tick_context& ctx, std::span<const muslisp::value> args) {
-        const std::string key = require_key_arg(args, 0, "bb-has");
-        return ctx.bb_get(key) != nullptr;
-    });
-
-    reg.register_condition("bb-truthy", [](tick_context& ctx, std::span<const muslisp::value> args) {
-        const std::string key = require_key_arg(args, 0, "bb-truthy");
-        const bb_entry* entry = ctx.bb_get(key);
-        if (!entry) {
+    reg.register_condition(
+        "always-true", [](tick_context&, std::span<const muslisp::value>) { return true; }, condition_reads{});
+    reg.register_condition(
+        "always-false", [](tick_context&, std::span<const muslisp::value>) { return false; }, condition_reads{});
+
+    reg.register_condition(
+        "bb-has",
+        [](tick_context& ctx, std::span<const muslisp::value> args) {
+            const std::string key = require_key_arg(args, 0, "bb-has");
+            return ctx.bb_get(key) != nullptr;
+        },
+        condition_reads{.key_args = {0}, .keys = {}});
+
+    reg.register_condition(
+        "bb-truthy",
+        [](tick_context& ctx, std::span<const muslisp::value> args) {
+            const std::string key = require_key_arg(args, 0, "bb-truthy");
+            const bb_entry* entry = ctx.bb_get(key);
+            if (!entry) {
+                return false;
+            }
+            return bb_value_truthy(entry->value);
+        },
+        condition_reads{.key_args = {0}, .keys = {}});
+
+    reg.register_condition(
+        "bb-eq",
+        [](tick_context& ctx, std::span<const muslisp::value> args) {
+            const std::string key = require_key_arg(args, 0, "bb-eq");
+            if (args.size() != 2) {
+                throw std::runtime_error("bb-eq: expected key and value");
+            }
+            const bb_entry* entry = ctx.bb_get(key);
+            if (!entry) {
+                return false;
+            }
+            const muslisp::value operand = args[1];
+            if (const auto* i = std::get_if<std::int64_t>(&entry->value)) {
+                return muslisp::is_integer(operand) && muslisp::integer_value(operand) == *i;
+            }
+            if (const auto* f = std::get_if<double>(&entry->value)) {
+                return muslisp::is_float(operand) && muslisp::float_value(operand) == *f;
+            }
+            if (const auto* b = std::get_if<bool>(&entry->value)) {
+                return muslisp::is_boolean(operand) && muslisp::boolean_value(operand) == *b;
+            }
+            if (const auto* s = std::get_if<std::string>(&entry->value)) {
+                return (muslisp::is_symbol(operand) && muslisp::symbol_name(operand) == *s) ||
+                       (muslisp::is_string(operand) && muslisp::string_value(operand) == *s);
+            }
             return false;
-        }
-        return bb_value_truthy(entry->value);
-    });
+        },
+        condition_reads{.key_args = {0}, .keys = {}, .test = condition_test::bb_equals});
+
+    reg.register_condition(
+        "bb-lt",
+        [](tick_context& ctx, std::span<const muslisp::value> args) {
+            const std::string key = require_key_arg(args, 0, "bb-lt");
+            const double threshold = require_floaty_arg(args, 1, "bb-lt");
+            const bb_entry* entry = ctx.bb_get(key);
+            if (!entry) {
+                return false;
+            }
+            if (const auto* i = std::get_if<std::int64_t>(&entry->value)) {
+                return static_cast<double>(*i) < threshold;
+            }
+            if (const auto* f = std::get_if<double>(&entry->value)) {
+                return *f < threshold;
+            }
+            return false;
+        },
+        condition_reads{.key_args = {0}, .keys = {}, .test = condition_test::bb_less});
 
     reg.register_condition("battery-ok", [](tick_context& ctx, std::span<const muslisp::value>) {
         if (!ctx.svc.robot) {
@@ -1159,21 +2197,24 @@ void install_demo_callbacks(runtime_host& host) {
                             return status::success;
                         });
 
-    reg.register_condition("goal-reached-1d", [](tick_context& ctx, std::span<const muslisp::value> args) {
-        const std::string state_key = require_key_arg_or_default(args, 0, "goal-reached-1d", "state");
-        const double goal = args.size() > 1 ? require_floaty_arg(args, 1, "goal-reached-1d") : 1.0;
-        const double tol = args.size() > 2 ? require_floaty_arg(args, 2, "goal-reached-1d") : 0.05;
+    reg.register_condition(
+        "goal-reached-1d",
+        [](tick_context& ctx, std::span<const muslisp::value> args) {
+            const std::string state_key = require_key_arg_or_default(args, 0, "goal-reached-1d", "state");
+            const double goal = args.size() > 1 ? require_floaty_arg(args, 1, "goal-reached-1d") : 1.0;
+            const double tol = args.size() > 2 ? require_floaty_arg(args, 2, "goal-reached-1d") : 0.05;
 
-        const bb_entry* state_entry = ctx.bb_get(state_key);
-        if (!state_entry) {
-            return false;
-        }
-        const std::vector<double> state = bb_value_as_vector(state_entry->value, "goal-reached-1d");
-        if (state.empty()) {
-            return false;
-        }
-        return std::fabs(goal - state[0]) <= tol;
-    });
+            const bb_entry* state_entry = ctx.bb_get(state_key);
+            if (!state_entry) {
+                return false;
+            }
+            const std::vector<double> state = bb_value_as_vector(state_entry->value, "goal-reached-1d");
+            if (state.empty()) {
+                return false;
+            }
+            return std::fabs(goal - state[0]) <= tol;
+        },
+        condition_reads{.key_args = {0}, .keys = {"state"}});
 
     reg.register_action("apply-planned-1d", [](tick_context& ctx, node_id, node_memory&, std::span<const muslisp::value> args) {
         const std::string state_key = require_key_arg_or_default(args, 0, "apply-planned-1d", "state");
@@ -1198,20 +2239,23 @@ void install_demo_callbacks(runtime_host& host) {
         return status::success;
     });
 
-    reg.register_condition("ptz-target-centred", [](tick_context& ctx, std::span<const muslisp::value> args) {
-        const std::string state_key = require_key_arg_or_default(args, 0, "ptz-target-centred", "ptz-state");
-        const double tol = args.size() > 1 ? require_floaty_arg(args, 1, "ptz-target-centred") : 0.05;
-        const bb_entry* state_entry = ctx.bb_get(state_key);
-        if (!state_entry) {
-            return false;
-        }
-        const std::vector<double> state = bb_value_as_vector(state_entry->value, "ptz-target-centred state");
-        if (state.size() < 4) {
-            return false;
-        }
-        const double dist = std::sqrt(state[2] * state[2] + state[3] * state[3]);
-        return dist <= tol;
-    });
+    reg.register_condition(
+        "ptz-target-centred",
+        [](tick_context& ctx, std::span<const muslisp::value> args) {
+            const std::string state_key = require_key_arg_or_default(args, 0, "ptz-target-centred", "ptz-state");
+            const double tol = args.size() > 1 ? require_floaty_arg(args, 1, "ptz-target-centred") : 0.05;
+            const bb_entry* state_entry = ctx.bb_get(state_key);
+            if (!state_entry) {
+                return false;
+            }
+            const std::vector<double> state = bb_value_as_vector(state_entry->value, "ptz-target-centred state");
+            if (state.size() < 4) {
+                return false;
+            }
+            const double dist = std::sqrt(state[2] * state[2] + state[3] * state[3]);
+            return dist <= tol;
+        },
+        condition_reads{.key_args = {0}, .keys = {"ptz-state"}});
 
     reg.register_action("apply-planned-ptz", [](tick_context& ctx, node_id, node_memory&, std::span<const muslisp::value> args) {
         const std::string state_key = require_key_arg_or_default(args, 0, "apply-planned-ptz", "ptz-state");
@@ -1272,27 +2316,57 @@ void install_demo_callbacks(runtime_host& host) {
         return ctx.svc.robot->search_target(ctx, mem);
     });
 
-    reg.register_action("async-sleep-ms", [](tick_context& ctx, node_id, node_memory& mem, std::span<const muslisp::value> args) {
+    reg.register_action("async-sleep-ms", [](tick_context& ctx, node_id node, node_memory& mem, std::span<const muslisp::value> args) {
         if (!ctx.svc.sched) {
             return status::failure;
         }
 
         const std::int64_t delay_ms = args.empty() ? 1 : require_int_arg(args, 0, "async-sleep-ms");
 
+        // Under a simulated clock the sleep is a deadline on that clock, kept in i1 with no job, so
+        // it ends on the same tick however fast the simulation runs.
+        if (ctx.svc.clock && ctx.svc.clock->simulated()) {
+            const std::int64_t now_ns =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(ctx.now.time_since_epoch()).count();
+            if (!mem.b0) {
+                mem.b0 = true;
+                mem.i0 = 0;
+                mem.i1 = now_ns + delay_ms * 1'000'000;
+                return status::running;
+            }
+            if (mem.i0 == 0) {
+                if (now_ns < mem.i1) {
+                    return status::running;
+                }
+                mem = node_memory{};
+                return status::success;
+            }
+            // A job submitted before the clock became simulated finishes as a job below.
+        }
+
         if (!mem.b0) {
             job_request req;
             req.task_name = "async-sleep-ms";
-            req.fn = [delay_ms] {
-                std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
-                job_result out;
-                out.payload = delay_ms;
-                return out;
+            ctx.watch_job(req, node);
+            const auto sleep = [delay_ms](const cancel_token& cancel) {
+                // Sleep in short slices so a cancelled job frees its worker promptly.
+                const auto wake_at = std::chrono::steady_clock::now() + std::chrono::milliseconds(delay_ms);
+                while (!cancel.cancelled()) {
+                    const auto now = std::chrono::steady_clock::now();
+                    if (now >= wake_at) {
+                        break;
+                    }
+                    const auto slice = std::min<std::chrono::steady_clock::duration>(wake_at - now, std::chrono::milliseconds(1));
+                    std::this_thread::sleep_for(slice);
+                }
+                return delay_ms;
             };
 
-            const job_id id = ctx.svc.sched->submit(std::move(req));
+            const job_id id = ctx.svc.sched->submit_typed<std::int64_t>(std::move(req), sleep).id;
             mem.i0 = static_cast<std::int64_t>(id);
             mem.b0 = true;
             mem.i1 = status_to_memory(job_status::queued);
+            mem.job_notified = false;
             ctx.scheduler_event(trace_event_kind::scheduler_submit,
                                 id,
                                 job_status::queued,
@@ -1300,6 +2374,12 @@ void install_demo_callbacks(runtime_host& host) {
             return status::running;
         }
 
+        // Nothing happened to the job since the last poll; skip the scheduler lookup.
+        if (!mem.job_notified) {
+            return status::running;
+        }
+        mem.job_notified = false;
+
         const job_id id = static_cast<job_id>(mem.i0);
         const job_info info = ctx.svc.sched->get_info(id);
 
@@ -1324,12 +2404,11 @@ void install_demo_callbacks(runtime_host& host) {
             return status::running;
         }
 
-        mem.b0 = false;
-        mem.i0 = 0;
-        mem.i1 = status_to_memory(job_status::unknown);
+        // Back to the initial state, so the finished leaf no longer counts as holding memory.
+        mem = node_memory{};
         if (info.status == job_status::done) {
-            job_result out;
-            (void)ctx.svc.sched->try_get_result(id, out);
+            // Frees the slot's result now rather than when the slot is recycled.
+            (void)ctx.svc.sched->take(typed_job<std::int64_t>{.id = id});
             return status::success;
         }
 
@@ -1,14 +1,77 @@
 #include "bt/scheduler.hpp"
 
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <exception>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 namespace bt {
 namespace {
 
-std::size_t effective_worker_count(std::size_t requested) {
-    if (requested > 0) {
-        return requested;
+// Heap order for ready jobs: the top is the earliest deadline, then the earliest submission.
+bool starts_later(const auto& a, const auto& b) noexcept {
+    if (a.deadline != b.deadline) {
+        return a.deadline > b.deadline;
+    }
+    return a.order > b.order;
+}
+
+#if defined(__linux__)
+void append_setup_error(std::string& out, const char* what, int err) {
+    if (!out.empty()) {
+        out += "; ";
+    }
+    out += what;
+    out += ": ";
+    out += std::strerror(err);
+}
+#endif
+
+}  // namespace
+
+completion_queue::~completion_queue() {
+    entry* node = head_.exchange(nullptr, std::memory_order_acquire);
+    while (node) {
+        entry* next = node->next;
+        delete node;
+        node = next;
+    }
+}
+
+void completion_queue::push(job_id job, std::uint64_t tag) {
+    auto* node = new entry{.value = notification{.job = job, .tag = tag}};
+    node->next = head_.load(std::memory_order_relaxed);
+    while (!head_.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
     }
+    if (const std::shared_ptr<tick_waker> waker = waker_.load()) {
+        waker->notify(wake_reason::job_complete);
+    }
+}
+
+void completion_queue::drain(std::vector<notification>& out) {
+    entry* node = head_.exchange(nullptr, std::memory_order_acquire);
+    // The list is newest first; append it reversed.
+    const std::size_t first = out.size();
+    while (node) {
+        out.push_back(node->value);
+        entry* next = node->next;
+        delete node;
+        node = next;
+    }
+    std::reverse(out.begin() + static_cast<std::ptrdiff_t>(first), out.end());
+}
+
+std::size_t default_scheduler_worker_count() noexcept {
     const auto hc = std::thread::hardware_concurrency();
     if (hc == 0) {
         return 2;
@@ -16,12 +79,64 @@ std::size_t effective_worker_count(std::size_t requested) {
     return hc > 4 ? 4 : hc;
 }
 
-}  // namespace
+std::string apply_scheduler_thread_options(const scheduler_thread_options& options, std::size_t worker_index) {
+    std::string errors;
+#if defined(__linux__)
+    if (!options.name_prefix.empty()) {
+        // The kernel keeps 15 bytes plus the terminator; shorten the prefix rather than lose the index.
+        std::string suffix = "-";
+        suffix += std::to_string(worker_index);
+        const std::string name = options.name_prefix.substr(0, 15 - std::min<std::size_t>(suffix.size(), 15)) + suffix;
+        if (const int rc = pthread_setname_np(pthread_self(), name.c_str()); rc != 0) {
+            append_setup_error(errors, "thread name", rc);
+        }
+    }
+    if (!options.cpus.empty()) {
+        const int cpu = options.cpus[worker_index % options.cpus.size()];
+        if (cpu < 0 || cpu >= CPU_SETSIZE) {
+            append_setup_error(errors, ("cpu affinity " + std::to_string(cpu)).c_str(), EINVAL);
+        } else {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            if (const int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set); rc != 0) {
+                append_setup_error(errors, ("cpu affinity " + std::to_string(cpu)).c_str(), rc);
+            }
+        }
+    }
+    if (options.nice.has_value()) {
+        // On Linux the nice value is per thread; PRIO_PROCESS with a thread id targets only that thread.
+        const auto tid = static_cast<id_t>(::syscall(SYS_gettid));
+        if (::setpriority(PRIO_PROCESS, tid, *options.nice) != 0) {
+            append_setup_error(errors, ("nice " + std::to_string(*options.nice)).c_str(), errno);
+        }
+    }
+    if (options.fifo_priority.has_value()) {
+        sched_param param{};
+        param.sched_priority = *options.fifo_priority;
+        if (const int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param); rc != 0) {
+            append_setup_error(errors, ("SCHED_FIFO priority " + std::to_string(*options.fifo_priority)).c_str(), rc);
+        }
+    }
+#else
+    (void)worker_index;
+    if (!options.cpus.empty() || options.fifo_priority.has_value() || options.nice.has_value()) {
+        errors = "thread affinity and priority settings are only supported on Linux";
+    }
+#endif
+    return errors;
+}
 
-thread_pool_scheduler::thread_pool_scheduler(std::size_t worker_count) : worker_count_(effective_worker_count(worker_count)) {
+thread_pool_scheduler::thread_pool_scheduler(std::size_t worker_count,
+                                             scheduler_limits limits,
+                                             scheduler_thread_options threads)
+    : worker_count_(worker_count > 0 ? worker_count : default_scheduler_worker_count()), limits_(limits), threads_(std::move(threads)) {
+    if (limits_.max_retained_finished == 0) {
+        throw std::invalid_argument("thread_pool_scheduler: max_retained_finished must be positive");
+    }
     workers_.reserve(worker_count_);
     for (std::size_t i = 0; i < worker_count_; ++i) {
-        workers_.emplace_back([this] { worker_loop(); });
+        workers_.emplace_back([this, i] { worker_loop(i); });
     }
 }
 
@@ -38,75 +153,177 @@ thread_pool_scheduler::~thread_pool_scheduler() {
     }
 }
 
+thread_pool_scheduler::job_state* thread_pool_scheduler::find_locked(job_id id) const noexcept {
+    const std::uint64_t index = id & 0xffffffffu;
+    if (index >= slots_.size()) {
+        return nullptr;
+    }
+    job_state* state = slots_[index].get();
+    return state->in_use && state->id == id ? state : nullptr;
+}
+
+thread_pool_scheduler::job_state& thread_pool_scheduler::acquire_slot_locked() {
+    if (free_slots_.empty()) {
+        if (slots_.size() >= limits_.max_jobs) {
+            if (!finished_.empty()) {
+                recycle_locked(finished_.front());
+                finished_.pop();
+            } else {
+                ++stats_.queue_overflow;
+                if (limits_.overflow == queue_overflow_policy::reject) {
+                    throw std::runtime_error("scheduler submit: job table full");
+                }
+            }
+        }
+        if (free_slots_.empty()) {
+            if (slots_.size() >= 0xffffffffu) {
+                throw std::runtime_error("scheduler submit: job table full");
+            }
+            free_slots_.push_back(static_cast<std::uint32_t>(slots_.size()));
+            slots_.push_back(std::make_unique<job_state>());
+        }
+    }
+
+    const std::uint32_t index = free_slots_.back();
+    free_slots_.pop_back();
+    job_state& state = *slots_[index];
+    state.in_use = true;
+    state.id = (static_cast<job_id>(state.generation) << 32) | index;
+    return state;
+}
+
+std::atomic<bool>& thread_pool_scheduler::cancel_flag_of(job_state& state) noexcept {
+    return state.request.cancel_flag ? *state.request.cancel_flag : state.cancel_signal;
+}
+
+void thread_pool_scheduler::notify(job_state& state) {
+    if (state.request.completions) {
+        state.request.completions->push(state.id, state.request.completion_tag);
+    }
+}
+
+void thread_pool_scheduler::retire_locked(job_state& state) {
+    notify(state);
+    if (--live_jobs_ == 0) {
+        idle_cv_.notify_all();
+    }
+    state.request.completions.reset();
+    finished_.push(static_cast<std::uint32_t>(state.id & 0xffffffffu));
+    while (finished_.size() > limits_.max_retained_finished) {
+        recycle_locked(finished_.front());
+        finished_.pop();
+    }
+}
+
+void thread_pool_scheduler::recycle_locked(std::uint32_t index) {
+    job_state& state = *slots_[index];
+    // Strings and the result keep no stale data but keep their capacity for the next job.
+    state.in_use = false;
+    state.generation = state.generation == 0xffffffffu ? 1 : state.generation + 1;
+    state.status = job_status::queued;
+    state.timing = job_timing{};
+    state.task_name.clear();
+    state.error_text.clear();
+    state.request = job_request{};
+    state.result.reset();
+    state.cancel_requested = false;
+    state.cancel_signal.store(false, std::memory_order_relaxed);
+    free_slots_.push_back(index);
+}
+
 job_id thread_pool_scheduler::submit(job_request req) {
+    ledger_scope charge(ledger_category::scheduler);
     if (!req.fn) {
         throw std::invalid_argument("scheduler submit: empty job function");
     }
 
-    auto state = std::make_shared<job_state>();
-
+    job_id id = 0;
     {
         std::lock_guard<std::mutex> lock(mutex_);
-        state->id = next_job_id_++;
-        state->status = job_status::queued;
-        state->timing.submitted_at = std::chrono::steady_clock::now();
-        state->task_name = req.task_name;
-        state->request = std::move(req);
-
-        jobs_[state->id] = state;
-        queue_.push(state->id);
+        job_state& state = acquire_slot_locked();
+        state.status = job_status::queued;
+        state.timing.submitted_at = std::chrono::steady_clock::now();
+        state.task_name = req.task_name;
+        state.request = std::move(req);
+
+        id = state.id;
+        std::vector<ready_job>& heap = ready_[static_cast<std::size_t>(state.request.priority)];
+        heap.push_back(ready_job{.deadline = state.request.deadline.value_or(std::chrono::steady_clock::time_point::max()),
+                                 .order = next_order_++,
+                                 .id = id});
+        std::push_heap(heap.begin(), heap.end(), [](const ready_job& a, const ready_job& b) { return starts_later(a, b); });
+        ++ready_count_;
+        ++live_jobs_;
         ++stats_.submitted;
     }
 
     cv_.notify_one();
-    return state->id;
+    return id;
 }
 
 job_info thread_pool_scheduler::get_info(job_id id) const {
+    ledger_scope charge(ledger_category::scheduler);
     std::lock_guard<std::mutex> lock(mutex_);
-    const auto it = jobs_.find(id);
-    if (it == jobs_.end()) {
+    const job_state* state = find_locked(id);
+    if (!state) {
         return job_info{};
     }
 
     job_info info;
-    info.status = it->second->status;
-    info.timing = it->second->timing;
-    info.task_name = it->second->task_name;
-    info.error_text = it->second->error_text;
+    info.status = state->status;
+    info.timing = state->timing;
+    info.task_name = state->task_name;
+    info.error_text = state->error_text;
     return info;
 }
 
 bool thread_pool_scheduler::try_get_result(job_id id, job_result& out) {
+    ledger_scope charge(ledger_category::scheduler);
     std::lock_guard<std::mutex> lock(mutex_);
-    const auto it = jobs_.find(id);
-    if (it == jobs_.end()) {
+    const job_state* state = find_locked(id);
+    if (!state) {
         return false;
     }
-    if (it->second->status != job_status::done || !it->second->result.has_value()) {
+    if (state->status != job_status::done || !state->result.has_value()) {
         return false;
     }
-    out = *(it->second->result);
+    out = *(state->result);
+    return true;
+}
+
+bool thread_pool_scheduler::take_result(job_id id, job_result& out) {
+    ledger_scope charge(ledger_category::scheduler);
+    std::lock_guard<std::mutex> lock(mutex_);
+    job_state* state = find_locked(id);
+    if (!state || state->status != job_status::done || !state->result.has_value()) {
+        return false;
+    }
+    out = std::move(*state->result);
+    state->result.reset();
     return true;
 }
 
 bool thread_pool_scheduler::cancel(job_id id) {
+    ledger_scope charge(ledger_category::scheduler);
     std::lock_guard<std::mutex> lock(mutex_);
-    const auto it = jobs_.find(id);
-    if (it == jobs_.end()) {
+    job_state* found = find_locked(id);
+    if (!found) {
         return false;
     }
 
-    auto& state = *(it->second);
+    auto& state = *found;
     if (state.status == job_status::done || state.status == job_status::failed || state.status == job_status::cancelled) {
         return false;
     }
 
     state.cancel_requested = true;
+    cancel_flag_of(state).store(true, std::memory_order_release);
     if (state.status == job_status::queued) {
         state.status = job_status::cancelled;
         state.timing.finished_at = std::chrono::steady_clock::now();
         ++stats_.cancelled;
+        // The id stays in ready_; the worker that pops it sees the job is no longer queued.
+        retire_locked(state);
     }
 
     return true;
@@ -117,39 +334,79 @@ scheduler_profile_stats thread_pool_scheduler::stats_snapshot() const {
     return stats_;
 }
 
-void thread_pool_scheduler::worker_loop() {
+bool thread_pool_scheduler::wait_idle(std::chrono::steady_clock::duration timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return idle_cv_.wait_for(lock, timeout, [this] { return live_jobs_ == 0; });
+}
+
+std::size_t thread_pool_scheduler::slot_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return slots_.size();
+}
+
+std::vector<std::string> thread_pool_scheduler::thread_setup_errors() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return thread_setup_errors_;
+}
+
+job_id thread_pool_scheduler::pop_ready_locked() {
+    for (std::vector<ready_job>& heap : ready_) {
+        if (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), [](const ready_job& a, const ready_job& b) { return starts_later(a, b); });
+            const job_id id = heap.back().id;
+            heap.pop_back();
+            --ready_count_;
+            return id;
+        }
+    }
+    return 0;
+}
+
+void thread_pool_scheduler::worker_loop(std::size_t index) {
+    if (std::string errors = apply_scheduler_thread_options(threads_, index); !errors.empty()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        thread_setup_errors_.push_back("worker " + std::to_string(index) + ": " + std::move(errors));
+    }
+
     while (true) {
-        std::shared_ptr<job_state> state;
+        job_state* state = nullptr;
 
         {
             std::unique_lock<std::mutex> lock(mutex_);
-            cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
-            if (stopping_ && queue_.empty()) {
+            cv_.wait(lock, [this] { return stopping_ || ready_count_ > 0; });
+            if (stopping_ && ready_count_ == 0) {
                 return;
             }
 
-            const job_id id = queue_.front();
-            queue_.pop();
-
-            const auto it = jobs_.find(id);
-            if (it == jobs_.end()) {
+            state = find_locked(pop_ready_locked());
+            if (!state || state->status != job_status::queued) {
                 continue;
             }
-            state = it->second;
 
-            if (state->status == job_status::cancelled) {
+            const auto start = std::chrono::steady_clock::now();
+            if (state->request.deadline.has_value() && *state->request.deadline <= start) {
+                state->status = job_status::cancelled;
+                state->timing.finished_at = start;
+                state->error_text = "deadline passed before the job started";
+                ++stats_.cancelled;
+                ++stats_.expired;
+                retire_locked(*state);
                 continue;
             }
-
-            const auto start = std::chrono::steady_clock::now();
             state->status = job_status::running;
             state->timing.started_at = start;
             ++stats_.started;
-            stats_.queue_delay.observe(std::chrono::duration_cast<std::chrono::nanoseconds>(start - state->timing.submitted_at));
+            notify(*state);
+            const auto queue_delay = std::chrono::duration_cast<std::chrono::nanoseconds>(start - state->timing.submitted_at);
+            stats_.queue_delay.observe(queue_delay);
+            stats_.queue_delay_by_priority[static_cast<std::size_t>(state->request.priority)].observe(queue_delay);
         }
 
+        // A running job is never recycled, so `state` stays valid until it is retired below. The job
+        // function is moved out there and destroyed after the lock is released.
+        job_function finished_fn;
         try {
-            job_result result = state->request.fn();
+            job_result result = state->request.fn(cancel_token(&cancel_flag_of(*state)));
 
             std::lock_guard<std::mutex> lock(mutex_);
             const auto finish = std::chrono::steady_clock::now();
@@ -164,6 +421,8 @@ void thread_pool_scheduler::worker_loop() {
                 state->result = std::move(result);
                 ++stats_.completed;
             }
+            finished_fn = std::move(state->request.fn);
+            retire_locked(*state);
         } catch (const std::exception& e) {
             std::lock_guard<std::mutex> lock(mutex_);
             const auto finish = std::chrono::steady_clock::now();
@@ -172,6 +431,8 @@ void thread_pool_scheduler::worker_loop() {
             state->status = job_status::failed;
             state->error_text = e.what();
             ++stats_.failed;
+            finished_fn = std::move(state->request.fn);
+            retire_locked(*state);
         } catch (...) {
             std::lock_guard<std::mutex> lock(mutex_);
             const auto finish = std::chrono::steady_clock::now();
@@ -180,6 +441,8 @@ void thread_pool_scheduler::worker_loop() {
             state->status = job_status::failed;
             state->error_text = "unknown exception";
             ++stats_.failed;
+            finished_fn = std::move(state->request.fn);
+            retire_locked(*state);
         }
     }
 }
@@ -202,4 +465,27 @@ const char* job_status_name(job_status st) noexcept {
     return "unknown";
 }
 
+const char* job_priority_name(job_priority priority) noexcept {
+    switch (priority) {
+        case job_priority::high:
+            return "high";
+        case job_priority::normal:
+            return "normal";
+        case job_priority::low:
+            return "low";
+    }
+    return "normal";
+}
+
+bool parse_job_priority(std::string_view text, job_priority& out) noexcept {
+    for (std::size_t i = 0; i < k_job_priority_count; ++i) {
+        const auto priority = static_cast<job_priority>(i);
+        if (text == job_priority_name(priority)) {
+            out = priority;
+            return true;
+        }
+    }
+    return false;
+}
+
 }  // namespace bt
@@ -1,6 +1,9 @@
 #include "bt/serialisation.hpp"
 
+#include <algorithm>
 #include <array>
+#include <bit>
+#include <chrono>
 #include <cstdint>
 #include <cstring>
 #include <fstream>
@@ -9,13 +12,30 @@
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <type_traits>
 #include <utility>
+#include <variant>
+
+#include "bt/compiler.hpp"
+#include "bt/runtime.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MUESLI_BT_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define MUESLI_BT_HAVE_MMAP 0
+#endif
 
 namespace bt {
 namespace {
 
 constexpr std::array<char, 4> k_magic{'M', 'B', 'T', '1'};
-constexpr std::uint32_t k_format_version = 1;
+// Version 1 is the legacy field-by-field stream; version 2 is the flat image read by definition_view.
+constexpr std::uint32_t k_format_version_stream = 1;
+constexpr std::uint32_t k_format_version_flat = 2;
 constexpr std::uint8_t k_endianness_little = 1;
 constexpr std::uint32_t k_max_serialised_items = 1'000'000;
 
@@ -33,45 +53,6 @@ void read_exact(std::ifstream& in, void* data, std::size_t size, const std::stri
     }
 }
 
-void write_u8(std::ofstream& out, std::uint8_t v, const std::string& where) {
-    write_exact(out, &v, sizeof(v), where);
-}
-
-void write_u32(std::ofstream& out, std::uint32_t v, const std::string& where) {
-    const std::array<std::uint8_t, 4> bytes{
-        static_cast<std::uint8_t>(v & 0xFFu),
-        static_cast<std::uint8_t>((v >> 8) & 0xFFu),
-        static_cast<std::uint8_t>((v >> 16) & 0xFFu),
-        static_cast<std::uint8_t>((v >> 24) & 0xFFu),
-    };
-    write_exact(out, bytes.data(), bytes.size(), where);
-}
-
-void write_u64(std::ofstream& out, std::uint64_t v, const std::string& where) {
-    const std::array<std::uint8_t, 8> bytes{
-        static_cast<std::uint8_t>(v & 0xFFu),
-        static_cast<std::uint8_t>((v >> 8) & 0xFFu),
-        static_cast<std::uint8_t>((v >> 16) & 0xFFu),
-        static_cast<std::uint8_t>((v >> 24) & 0xFFu),
-        static_cast<std::uint8_t>((v >> 32) & 0xFFu),
-        static_cast<std::uint8_t>((v >> 40) & 0xFFu),
-        static_cast<std::uint8_t>((v >> 48) & 0xFFu),
-        static_cast<std::uint8_t>((v >> 56) & 0xFFu),
-    };
-    write_exact(out, bytes.data(), bytes.size(), where);
-}
-
-void write_i64(std::ofstream& out, std::int64_t v, const std::string& where) {
-    write_u64(out, static_cast<std::uint64_t>(v), where);
-}
-
-void write_f64(std::ofstream& out, double v, const std::string& where) {
-    std::uint64_t bits = 0;
-    static_assert(sizeof(bits) == sizeof(v));
-    std::memcpy(&bits, &v, sizeof(bits));
-    write_u64(out, bits, where);
-}
-
 std::uint8_t read_u8(std::ifstream& in, const std::string& where) {
     std::uint8_t v = 0;
     read_exact(in, &v, sizeof(v), where);
@@ -112,16 +93,6 @@ double read_f64(std::ifstream& in, const std::string& where) {
     return out;
 }
 
-void write_string(std::ofstream& out, const std::string& text, const std::string& where) {
-    if (text.size() > static_cast<std::size_t>(std::numeric_limits<std::uint32_t>::max())) {
-        throw std::runtime_error(where + ": string too long");
-    }
-    write_u32(out, static_cast<std::uint32_t>(text.size()), where);
-    if (!text.empty()) {
-        write_exact(out, text.data(), text.size(), where);
-    }
-}
-
 std::string read_string(std::ifstream& in, const std::string& where) {
     const std::uint32_t len = read_u32(in, where);
     if (len > k_max_serialised_items * 16) {
@@ -136,57 +107,13 @@ std::string read_string(std::ifstream& in, const std::string& where) {
 }
 
 bool is_valid_node_kind(std::uint8_t raw) {
-    return raw <= static_cast<std::uint8_t>(node_kind::reactive_sel);
+    return raw <= static_cast<std::uint8_t>(node_kind::vla_chunk);
 }
 
 bool is_valid_arg_kind(std::uint8_t raw) {
     return raw <= static_cast<std::uint8_t>(arg_kind::string);
 }
 
-const char* node_kind_name(node_kind kind) {
-    switch (kind) {
-        case node_kind::seq:
-            return "seq";
-        case node_kind::sel:
-            return "sel";
-        case node_kind::invert:
-            return "invert";
-        case node_kind::repeat:
-            return "repeat";
-        case node_kind::retry:
-            return "retry";
-        case node_kind::cond:
-            return "cond";
-        case node_kind::act:
-            return "act";
-        case node_kind::succeed:
-            return "succeed";
-        case node_kind::fail:
-            return "fail";
-        case node_kind::running:
-            return "running";
-        case node_kind::plan_action:
-            return "plan-action";
-        case node_kind::vla_request:
-            return "vla-request";
-        case node_kind::vla_wait:
-            return "vla-wait";
-        case node_kind::vla_cancel:
-            return "vla-cancel";
-        case node_kind::mem_seq:
-            return "mem-seq";
-        case node_kind::mem_sel:
-            return "mem-sel";
-        case node_kind::async_seq:
-            return "async-seq";
-        case node_kind::reactive_seq:
-            return "reactive-seq";
-        case node_kind::reactive_sel:
-            return "reactive-sel";
-    }
-    return "unknown";
-}
-
 std::string dot_escape(std::string_view text) {
     std::string out;
     out.reserve(text.size() + 8);
@@ -260,6 +187,17 @@ void validate_definition(const definition& def) {
                     throw std::runtime_error("bt.load: composite nodes require at least one child");
                 }
                 break;
+            case node_kind::par: {
+                const auto children = static_cast<std::int64_t>(n.children.size());
+                const bool thresholds_valid = n.args.size() == 2 && n.args[0].kind == arg_kind::integer &&
+                                              n.args[1].kind == arg_kind::integer && n.args[0].int_v >= 1 &&
+                                              n.args[0].int_v <= children && n.args[1].int_v >= 1 &&
+                                              n.args[1].int_v <= children;
+                if (n.children.empty() || n.children.size() > kMaxParChildren || !thresholds_valid) {
+                    throw std::runtime_error("bt.load: par nodes require 1-64 children and two thresholds within the child count");
+                }
+                break;
+            }
             case node_kind::invert:
             case node_kind::repeat:
             case node_kind::retry:
@@ -284,6 +222,7 @@ void validate_definition(const definition& def) {
             case node_kind::vla_request:
             case node_kind::vla_wait:
             case node_kind::vla_cancel:
+            case node_kind::vla_chunk:
                 if (!n.children.empty()) {
                     throw std::runtime_error("bt.load: planner/vla nodes cannot have children");
                 }
@@ -292,72 +231,288 @@ void validate_definition(const definition& def) {
     }
 }
 
-}  // namespace
 
-void save_definition_binary(const definition& def, const std::string& path) {
-    std::ofstream out(path, std::ios::binary);
-    if (!out) {
-        throw std::runtime_error("bt.save: failed to open file: " + path);
+// Flat image layout (all integers little-endian; sections start on 8-byte boundaries):
+//   header       k_flat_header_bytes, field offsets below
+//   nodes        node_count records of k_flat_node_bytes
+//   args         arg_total records of k_flat_arg_bytes
+//   children     child_total u32 node ids
+//   bb keys      bb_key_count (u32 offset, u32 size) string refs
+//   strings      string pool referenced by (offset, size) pairs relative to its start
+constexpr std::size_t k_flat_header_bytes = 80;
+constexpr std::size_t k_flat_node_bytes = 40;
+constexpr std::size_t k_flat_arg_bytes = 24;
+constexpr std::size_t k_flat_string_ref_bytes = 8;
+
+namespace flat_header {
+constexpr std::size_t version = 4;
+constexpr std::size_t endianness = 8;
+constexpr std::size_t node_count = 12;
+constexpr std::size_t root = 16;
+constexpr std::size_t child_total = 20;
+constexpr std::size_t arg_total = 24;
+constexpr std::size_t bb_key_count = 28;
+constexpr std::size_t nodes_offset = 32;
+constexpr std::size_t children_offset = 40;
+constexpr std::size_t args_offset = 48;
+constexpr std::size_t bb_keys_offset = 56;
+constexpr std::size_t strings_offset = 64;
+constexpr std::size_t strings_size = 72;
+}  // namespace flat_header
+
+namespace flat_node {
+constexpr std::size_t kind = 0;
+constexpr std::size_t state_key = 4;
+constexpr std::size_t int_param = 8;
+constexpr std::size_t first_child = 16;
+constexpr std::size_t child_count = 20;
+constexpr std::size_t first_arg = 24;
+constexpr std::size_t arg_count = 28;
+constexpr std::size_t name_offset = 32;
+constexpr std::size_t name_size = 36;
+}  // namespace flat_node
+
+namespace flat_arg {
+constexpr std::size_t kind = 0;
+constexpr std::size_t bool_v = 1;
+constexpr std::size_t payload = 8;
+constexpr std::size_t text_offset = 16;
+constexpr std::size_t text_size = 20;
+}  // namespace flat_arg
+
+template <typename T>
+T decode_le(const std::byte* bytes) noexcept {
+    std::make_unsigned_t<T> raw = 0;
+    for (std::size_t i = 0; i < sizeof(T); ++i) {
+        raw |= static_cast<std::make_unsigned_t<T>>(std::to_integer<std::uint8_t>(bytes[i])) << (8u * i);
     }
+    return static_cast<T>(raw);
+}
+
+std::size_t align8(std::size_t n) noexcept {
+    return (n + 7u) & ~std::size_t{7};
+}
+
+// Builds a flat image in memory so the file is written with one call.
+class flat_writer {
+public:
+    explicit flat_writer(std::size_t size) : bytes_(size, std::byte{0}) {}
+
+    template <typename T>
+    void put(std::size_t offset, T v) {
+        auto raw = static_cast<std::make_unsigned_t<T>>(v);
+        for (std::size_t i = 0; i < sizeof(T); ++i) {
+            bytes_[offset + i] = static_cast<std::byte>((raw >> (8u * i)) & 0xFFu);
+        }
+    }
+
+    void put_bytes(std::size_t offset, std::string_view text) {
+        std::memcpy(bytes_.data() + offset, text.data(), text.size());
+    }
+
+    [[nodiscard]] const std::vector<std::byte>& bytes() const noexcept { return bytes_; }
+
+private:
+    std::vector<std::byte> bytes_;
+};
+
+std::uint32_t checked_u32(std::size_t v, const char* what) {
+    if (v > k_max_serialised_items * 16ull) {
+        throw std::runtime_error(std::string("bt.save: ") + what + " is too large to serialise");
+    }
+    return static_cast<std::uint32_t>(v);
+}
 
+std::vector<std::byte> encode_flat_definition(const definition& def) {
     if (def.nodes.size() > k_max_serialised_items) {
         throw std::runtime_error("bt.save: too many nodes to serialise");
     }
 
-    write_exact(out, k_magic.data(), k_magic.size(), "bt.save");
-    write_u32(out, k_format_version, "bt.save");
-    write_u8(out, k_endianness_little, "bt.save");
-    write_u8(out, 0, "bt.save");
-    write_u8(out, 0, "bt.save");
-    write_u8(out, 0, "bt.save");
-    write_u32(out, static_cast<std::uint32_t>(def.nodes.size()), "bt.save");
-    write_u32(out, static_cast<std::uint32_t>(def.root), "bt.save");
-
+    std::size_t child_total = 0;
+    std::size_t arg_total = 0;
+    std::size_t string_bytes = 0;
     for (const node& n : def.nodes) {
-        write_u8(out, static_cast<std::uint8_t>(n.kind), "bt.save");
-        write_u8(out, 0, "bt.save");
-        write_u8(out, 0, "bt.save");
-        write_u8(out, 0, "bt.save");
-        write_i64(out, n.int_param, "bt.save");
-
-        if (n.children.size() > k_max_serialised_items) {
-            throw std::runtime_error("bt.save: node has too many children");
-        }
-        write_u32(out, static_cast<std::uint32_t>(n.children.size()), "bt.save");
-        for (node_id child : n.children) {
-            write_u32(out, static_cast<std::uint32_t>(child), "bt.save");
+        child_total += n.children.size();
+        arg_total += n.args.size();
+        string_bytes += n.leaf_name.size();
+        for (const arg_value& arg : n.args) {
+            if (arg.kind == arg_kind::symbol || arg.kind == arg_kind::string) {
+                string_bytes += arg.text.size();
+            }
         }
+    }
+    for (const std::string& key : def.bb_keys) {
+        string_bytes += key.size();
+    }
+
+    const std::size_t nodes_offset = k_flat_header_bytes;
+    const std::size_t args_offset = nodes_offset + def.nodes.size() * k_flat_node_bytes;
+    const std::size_t children_offset = args_offset + arg_total * k_flat_arg_bytes;
+    const std::size_t bb_keys_offset = align8(children_offset + child_total * sizeof(std::uint32_t));
+    const std::size_t strings_offset = bb_keys_offset + def.bb_keys.size() * k_flat_string_ref_bytes;
+    flat_writer out(align8(strings_offset + string_bytes));
 
-        write_string(out, n.leaf_name, "bt.save");
+    out.put_bytes(0, std::string_view(k_magic.data(), k_magic.size()));
+    out.put(flat_header::version, k_format_version_flat);
+    out.put(flat_header::endianness, k_endianness_little);
+    out.put(flat_header::node_count, checked_u32(def.nodes.size(), "node count"));
+    out.put(flat_header::root, static_cast<std::uint32_t>(def.root));
+    out.put(flat_header::child_total, checked_u32(child_total, "child count"));
+    out.put(flat_header::arg_total, checked_u32(arg_total, "arg count"));
+    out.put(flat_header::bb_key_count, checked_u32(def.bb_keys.size(), "blackboard key count"));
+    out.put(flat_header::nodes_offset, static_cast<std::uint64_t>(nodes_offset));
+    out.put(flat_header::children_offset, static_cast<std::uint64_t>(children_offset));
+    out.put(flat_header::args_offset, static_cast<std::uint64_t>(args_offset));
+    out.put(flat_header::bb_keys_offset, static_cast<std::uint64_t>(bb_keys_offset));
+    out.put(flat_header::strings_offset, static_cast<std::uint64_t>(strings_offset));
+    out.put(flat_header::strings_size, static_cast<std::uint64_t>(string_bytes));
+
+    std::size_t string_cursor = 0;
+    auto put_string = [&](std::size_t offset_field, std::size_t size_field, std::string_view text) {
+        out.put(offset_field, checked_u32(string_cursor, "string pool"));
+        out.put(size_field, checked_u32(text.size(), "string"));
+        out.put_bytes(strings_offset + string_cursor, text);
+        string_cursor += text.size();
+    };
 
-        if (n.args.size() > k_max_serialised_items) {
-            throw std::runtime_error("bt.save: node has too many args");
+    std::size_t child_cursor = 0;
+    std::size_t arg_cursor = 0;
+    for (std::size_t i = 0; i < def.nodes.size(); ++i) {
+        const node& n = def.nodes[i];
+        const std::size_t record = nodes_offset + i * k_flat_node_bytes;
+        out.put(record + flat_node::kind, static_cast<std::uint8_t>(n.kind));
+        out.put(record + flat_node::state_key, n.state_key);
+        out.put(record + flat_node::int_param, n.int_param);
+        out.put(record + flat_node::first_child, static_cast<std::uint32_t>(child_cursor));
+        out.put(record + flat_node::child_count, static_cast<std::uint32_t>(n.children.size()));
+        out.put(record + flat_node::first_arg, static_cast<std::uint32_t>(arg_cursor));
+        out.put(record + flat_node::arg_count, static_cast<std::uint32_t>(n.args.size()));
+        put_string(record + flat_node::name_offset, record + flat_node::name_size, n.leaf_name);
+
+        for (node_id child : n.children) {
+            out.put(children_offset + child_cursor * sizeof(std::uint32_t), static_cast<std::uint32_t>(child));
+            ++child_cursor;
         }
-        write_u32(out, static_cast<std::uint32_t>(n.args.size()), "bt.save");
         for (const arg_value& arg : n.args) {
-            write_u8(out, static_cast<std::uint8_t>(arg.kind), "bt.save");
+            const std::size_t arg_record = args_offset + arg_cursor * k_flat_arg_bytes;
+            out.put(arg_record + flat_arg::kind, static_cast<std::uint8_t>(arg.kind));
             switch (arg.kind) {
                 case arg_kind::nil:
                     break;
                 case arg_kind::boolean:
-                    write_u8(out, arg.bool_v ? 1 : 0, "bt.save");
+                    out.put(arg_record + flat_arg::bool_v, static_cast<std::uint8_t>(arg.bool_v ? 1 : 0));
                     break;
                 case arg_kind::integer:
-                    write_i64(out, arg.int_v, "bt.save");
+                    out.put(arg_record + flat_arg::payload, arg.int_v);
                     break;
-                case arg_kind::floating:
-                    write_f64(out, arg.float_v, "bt.save");
+                case arg_kind::floating: {
+                    std::uint64_t bits = 0;
+                    std::memcpy(&bits, &arg.float_v, sizeof(bits));
+                    out.put(arg_record + flat_arg::payload, bits);
                     break;
+                }
                 case arg_kind::symbol:
                 case arg_kind::string:
-                    write_string(out, arg.text, "bt.save");
+                    put_string(arg_record + flat_arg::text_offset, arg_record + flat_arg::text_size, arg.text);
                     break;
             }
+            ++arg_cursor;
         }
     }
+    for (std::size_t i = 0; i < def.bb_keys.size(); ++i) {
+        const std::size_t ref = bb_keys_offset + i * k_flat_string_ref_bytes;
+        put_string(ref, ref + 4, def.bb_keys[i]);
+    }
+    return out.bytes();
+}
+
+definition load_definition_stream(const std::string& path);
+
+}  // namespace
+
+const char* node_kind_name(node_kind kind) noexcept {
+    switch (kind) {
+        case node_kind::seq:
+            return "seq";
+        case node_kind::sel:
+            return "sel";
+        case node_kind::invert:
+            return "invert";
+        case node_kind::repeat:
+            return "repeat";
+        case node_kind::retry:
+            return "retry";
+        case node_kind::cond:
+            return "cond";
+        case node_kind::act:
+            return "act";
+        case node_kind::succeed:
+            return "succeed";
+        case node_kind::fail:
+            return "fail";
+        case node_kind::running:
+            return "running";
+        case node_kind::plan_action:
+            return "plan-action";
+        case node_kind::vla_request:
+            return "vla-request";
+        case node_kind::vla_wait:
+            return "vla-wait";
+        case node_kind::vla_cancel:
+            return "vla-cancel";
+        case node_kind::mem_seq:
+            return "mem-seq";
+        case node_kind::mem_sel:
+            return "mem-sel";
+        case node_kind::async_seq:
+            return "async-seq";
+        case node_kind::reactive_seq:
+            return "reactive-seq";
+        case node_kind::reactive_sel:
+            return "reactive-sel";
+        case node_kind::par:
+            return "par";
+        case node_kind::vla_chunk:
+            return "vla-chunk";
+    }
+    return "unknown";
+}
+
+std::vector<std::byte> encode_definition_binary(const definition& def) {
+    return encode_flat_definition(def);
+}
+
+void save_definition_binary(const definition& def, const std::string& path) {
+    const std::vector<std::byte> image = encode_flat_definition(def);
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        throw std::runtime_error("bt.save: failed to open file: " + path);
+    }
+    write_exact(out, image.data(), image.size(), "bt.save");
 }
 
 definition load_definition_binary(const std::string& path) {
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            throw std::runtime_error("bt.load: failed to open file: " + path);
+        }
+        std::array<char, 4> magic{};
+        read_exact(in, magic.data(), magic.size(), "bt.load");
+        if (magic != k_magic) {
+            throw std::runtime_error("bt.load: invalid header (expected MBT1)");
+        }
+        if (read_u32(in, "bt.load") == k_format_version_stream) {
+            return load_definition_stream(path);
+        }
+    }
+    const mapped_definition_file file(path);
+    return file.view().materialise();
+}
+
+namespace {
+
+definition load_definition_stream(const std::string& path) {
     std::ifstream in(path, std::ios::binary);
     if (!in) {
         throw std::runtime_error("bt.load: failed to open file: " + path);
@@ -370,7 +525,7 @@ definition load_definition_binary(const std::string& path) {
     }
 
     const std::uint32_t version = read_u32(in, "bt.load");
-    if (version != k_format_version) {
+    if (version != k_format_version_stream) {
         throw std::runtime_error("bt.load: unsupported format version " + std::to_string(version));
     }
 
@@ -457,9 +612,12 @@ definition load_definition_binary(const std::string& path) {
     }
 
     validate_definition(def);
+    index_blackboard_keys(def);
     return def;
 }
 
+}  // namespace
+
 void export_definition_dot(const definition& def, const std::string& path) {
     validate_definition(def);
 
@@ -493,4 +651,580 @@ void export_definition_dot(const definition& def, const std::string& path) {
     }
 }
 
+struct definition_view::node_record {
+    node_kind kind = node_kind::seq;
+    bb_slot state_key = kNoBbSlot;
+    std::int64_t int_param = 0;
+    std::uint32_t first_child = 0;
+    std::uint32_t child_count = 0;
+    std::uint32_t first_arg = 0;
+    std::uint32_t arg_count = 0;
+    std::uint32_t name_offset = 0;
+    std::uint32_t name_size = 0;
+};
+
+template <typename T>
+T definition_view::load(std::uint64_t offset) const {
+    return decode_le<T>(image_.data() + offset);
+}
+
+definition_view::node_record definition_view::node_at(node_id id) const {
+    const std::uint64_t record = nodes_offset_ + static_cast<std::uint64_t>(id) * k_flat_node_bytes;
+    node_record out;
+    out.kind = static_cast<node_kind>(load<std::uint8_t>(record + flat_node::kind));
+    out.state_key = load<std::uint32_t>(record + flat_node::state_key);
+    out.int_param = load<std::int64_t>(record + flat_node::int_param);
+    out.first_child = load<std::uint32_t>(record + flat_node::first_child);
+    out.child_count = load<std::uint32_t>(record + flat_node::child_count);
+    out.first_arg = load<std::uint32_t>(record + flat_node::first_arg);
+    out.arg_count = load<std::uint32_t>(record + flat_node::arg_count);
+    out.name_offset = load<std::uint32_t>(record + flat_node::name_offset);
+    out.name_size = load<std::uint32_t>(record + flat_node::name_size);
+    return out;
+}
+
+std::string_view definition_view::string_at(std::uint32_t offset, std::uint32_t size) const {
+    return {reinterpret_cast<const char*>(image_.data() + strings_offset_ + offset), size};
+}
+
+definition_view definition_view::open(std::span<const std::byte> image) {
+    if (image.size() < k_flat_header_bytes) {
+        throw std::runtime_error("bt.load: file is too small for a flat definition");
+    }
+    if (std::memcmp(image.data(), k_magic.data(), k_magic.size()) != 0) {
+        throw std::runtime_error("bt.load: invalid header (expected MBT1)");
+    }
+
+    definition_view v;
+    v.image_ = image;
+    const auto version = v.load<std::uint32_t>(flat_header::version);
+    if (version != k_format_version_flat) {
+        throw std::runtime_error("bt.load: unsupported flat format version " + std::to_string(version));
+    }
+    if (v.load<std::uint8_t>(flat_header::endianness) != k_endianness_little) {
+        throw std::runtime_error("bt.load: unsupported endianness marker");
+    }
+
+    v.node_count_ = v.load<std::uint32_t>(flat_header::node_count);
+    v.root_ = v.load<std::uint32_t>(flat_header::root);
+    v.child_total_ = v.load<std::uint32_t>(flat_header::child_total);
+    v.arg_total_ = v.load<std::uint32_t>(flat_header::arg_total);
+    v.bb_key_count_ = v.load<std::uint32_t>(flat_header::bb_key_count);
+    v.nodes_offset_ = v.load<std::uint64_t>(flat_header::nodes_offset);
+    v.children_offset_ = v.load<std::uint64_t>(flat_header::children_offset);
+    v.args_offset_ = v.load<std::uint64_t>(flat_header::args_offset);
+    v.bb_keys_offset_ = v.load<std::uint64_t>(flat_header::bb_keys_offset);
+    v.strings_offset_ = v.load<std::uint64_t>(flat_header::strings_offset);
+    v.strings_size_ = v.load<std::uint64_t>(flat_header::strings_size);
+
+    if (v.node_count_ == 0) {
+        throw std::runtime_error("bt.load: file has no nodes");
+    }
+    if (v.node_count_ > k_max_serialised_items || v.child_total_ > k_max_serialised_items ||
+        v.arg_total_ > k_max_serialised_items || v.bb_key_count_ > k_max_serialised_items) {
+        throw std::runtime_error("bt.load: node count is too large");
+    }
+    if (v.root_ >= v.node_count_) {
+        throw std::runtime_error("bt.load: root node id out of range");
+    }
+
+    // Counts are bounded above, so these products cannot overflow.
+    const auto section_fits = [&](std::uint64_t offset, std::uint64_t bytes) {
+        return offset <= image.size() && bytes <= image.size() - offset;
+    };
+    if (!section_fits(v.nodes_offset_, v.node_count_ * k_flat_node_bytes) ||
+        !section_fits(v.args_offset_, v.arg_total_ * k_flat_arg_bytes) ||
+        !section_fits(v.children_offset_, v.child_total_ * sizeof(std::uint32_t)) ||
+        !section_fits(v.bb_keys_offset_, v.bb_key_count_ * k_flat_string_ref_bytes) ||
+        !section_fits(v.strings_offset_, v.strings_size_)) {
+        throw std::runtime_error("bt.load: section out of range");
+    }
+    const auto string_fits = [&](std::uint32_t offset, std::uint32_t size) {
+        return static_cast<std::uint64_t>(offset) + size <= v.strings_size_;
+    };
+
+    for (node_id id = 0; id < v.node_count_; ++id) {
+        const node_record n = v.node_at(id);
+        if (!is_valid_node_kind(static_cast<std::uint8_t>(n.kind))) {
+            throw std::runtime_error("bt.load: invalid node kind");
+        }
+        if (static_cast<std::uint64_t>(n.first_child) + n.child_count > v.child_total_ ||
+            static_cast<std::uint64_t>(n.first_arg) + n.arg_count > v.arg_total_) {
+            throw std::runtime_error("bt.load: node record out of range");
+        }
+        if (!string_fits(n.name_offset, n.name_size)) {
+            throw std::runtime_error("bt.load: string reference out of range");
+        }
+        if (n.state_key != kNoBbSlot && n.state_key >= v.bb_key_count_) {
+            throw std::runtime_error("bt.load: blackboard key out of range");
+        }
+    }
+    for (std::size_t i = 0; i < v.child_total_; ++i) {
+        if (v.load<std::uint32_t>(v.children_offset_ + i * sizeof(std::uint32_t)) >= v.node_count_) {
+            throw std::runtime_error("bt.load: child node id out of range");
+        }
+    }
+    for (std::size_t i = 0; i < v.arg_total_; ++i) {
+        const std::uint64_t record = v.args_offset_ + i * k_flat_arg_bytes;
+        const auto raw_kind = v.load<std::uint8_t>(record + flat_arg::kind);
+        if (!is_valid_arg_kind(raw_kind)) {
+            throw std::runtime_error("bt.load: invalid arg kind");
+        }
+        const auto kind = static_cast<arg_kind>(raw_kind);
+        if ((kind == arg_kind::symbol || kind == arg_kind::string) &&
+            !string_fits(v.load<std::uint32_t>(record + flat_arg::text_offset), v.load<std::uint32_t>(record + flat_arg::text_size))) {
+            throw std::runtime_error("bt.load: string reference out of range");
+        }
+    }
+    for (std::size_t i = 0; i < v.bb_key_count_; ++i) {
+        const std::uint64_t ref = v.bb_keys_offset_ + i * k_flat_string_ref_bytes;
+        if (!string_fits(v.load<std::uint32_t>(ref), v.load<std::uint32_t>(ref + 4))) {
+            throw std::runtime_error("bt.load: string reference out of range");
+        }
+    }
+    return v;
+}
+
+node_kind definition_view::kind(node_id id) const {
+    return node_at(id).kind;
+}
+
+std::int64_t definition_view::int_param(node_id id) const {
+    return node_at(id).int_param;
+}
+
+bb_slot definition_view::state_key(node_id id) const {
+    return node_at(id).state_key;
+}
+
+std::size_t definition_view::child_count(node_id id) const {
+    return node_at(id).child_count;
+}
+
+node_id definition_view::child(node_id id, std::size_t index) const {
+    const std::uint64_t slot = static_cast<std::uint64_t>(node_at(id).first_child) + index;
+    return load<std::uint32_t>(children_offset_ + slot * sizeof(std::uint32_t));
+}
+
+std::string_view definition_view::leaf_name(node_id id) const {
+    const node_record n = node_at(id);
+    return string_at(n.name_offset, n.name_size);
+}
+
+std::size_t definition_view::arg_count(node_id id) const {
+    return node_at(id).arg_count;
+}
+
+arg_value definition_view::arg(node_id id, std::size_t index) const {
+    const std::uint64_t record = args_offset_ + (static_cast<std::uint64_t>(node_at(id).first_arg) + index) * k_flat_arg_bytes;
+    arg_value out;
+    out.kind = static_cast<arg_kind>(load<std::uint8_t>(record + flat_arg::kind));
+    switch (out.kind) {
+        case arg_kind::nil:
+            break;
+        case arg_kind::boolean:
+            out.bool_v = load<std::uint8_t>(record + flat_arg::bool_v) != 0;
+            break;
+        case arg_kind::integer:
+            out.int_v = load<std::int64_t>(record + flat_arg::payload);
+            break;
+        case arg_kind::floating: {
+            const auto bits = load<std::uint64_t>(record + flat_arg::payload);
+            std::memcpy(&out.float_v, &bits, sizeof(bits));
+            break;
+        }
+        case arg_kind::symbol:
+        case arg_kind::string:
+            out.text = string_at(load<std::uint32_t>(record + flat_arg::text_offset), load<std::uint32_t>(record + flat_arg::text_size));
+            break;
+    }
+    return out;
+}
+
+std::string_view definition_view::bb_key(std::size_t index) const {
+    const std::uint64_t ref = bb_keys_offset_ + index * k_flat_string_ref_bytes;
+    return string_at(load<std::uint32_t>(ref), load<std::uint32_t>(ref + 4));
+}
+
+definition definition_view::materialise() const {
+    definition def;
+    def.root = root_;
+    def.nodes.resize(node_count_);
+    for (node_id id = 0; id < node_count_; ++id) {
+        const node_record record = node_at(id);
+        node& n = def.nodes[id];
+        n.id = id;
+        n.kind = record.kind;
+        n.int_param = record.int_param;
+        n.state_key = record.state_key;
+        n.leaf_name = string_at(record.name_offset, record.name_size);
+        n.children.reserve(record.child_count);
+        for (std::size_t i = 0; i < record.child_count; ++i) {
+            n.children.push_back(load<std::uint32_t>(children_offset_ + (static_cast<std::uint64_t>(record.first_child) + i) * sizeof(std::uint32_t)));
+        }
+        n.args.reserve(record.arg_count);
+        for (std::size_t i = 0; i < record.arg_count; ++i) {
+            n.args.push_back(arg(id, i));
+        }
+    }
+    def.bb_keys.reserve(bb_key_count_);
+    for (std::size_t i = 0; i < bb_key_count_; ++i) {
+        def.bb_keys.emplace_back(bb_key(i));
+    }
+    validate_definition(def);
+    return def;
+}
+
+mapped_definition_file::mapped_definition_file(const std::string& path) {
+#if MUESLI_BT_HAVE_MMAP
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("bt.load: failed to open file: " + path);
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("bt.load: failed to stat file: " + path);
+    }
+    size_ = static_cast<std::size_t>(info.st_size);
+    if (size_ > 0) {
+        void* mapped = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("bt.load: failed to map file: " + path);
+        }
+        data_ = static_cast<const std::byte*>(mapped);
+        mapped_ = true;
+    }
+    ::close(fd);
+#else
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        throw std::runtime_error("bt.load: failed to open file: " + path);
+    }
+    owned_.resize(static_cast<std::size_t>(in.tellg()));
+    in.seekg(0);
+    read_exact(in, owned_.data(), owned_.size(), "bt.load");
+    data_ = owned_.data();
+    size_ = owned_.size();
+#endif
+}
+
+mapped_definition_file::~mapped_definition_file() {
+#if MUESLI_BT_HAVE_MMAP
+    if (mapped_) {
+        ::munmap(const_cast<std::byte*>(data_), size_);
+    }
+#endif
+}
+
+namespace {
+
+constexpr std::array<char, 4> k_checkpoint_magic{'M', 'B', 'T', 'S'};
+constexpr std::uint32_t k_checkpoint_version = 1;
+
+enum class checkpoint_tag : std::uint8_t { nil, boolean, integer, floating, string, vector };
+
+// Node ids, kinds, leaf names, parameters and children: what node memory and leaf bindings are keyed
+// by, so a checkpoint only restores into a tree whose node ids mean the same thing.
+std::uint64_t checkpoint_layout_hash(const definition& def) {
+    std::uint64_t h = 14695981039346656037ull;
+    const auto mix = [&h](std::uint64_t v) {
+        for (int i = 0; i < 8; ++i) {
+            h ^= (v >> (8 * i)) & 0xFFu;
+            h *= 1099511628211ull;
+        }
+    };
+    mix(def.nodes.size());
+    mix(def.root);
+    for (const node& n : def.nodes) {
+        mix(static_cast<std::uint64_t>(n.kind));
+        mix(static_cast<std::uint64_t>(n.int_param));
+        mix(n.leaf_name.size());
+        for (const char c : n.leaf_name) {
+            mix(static_cast<unsigned char>(c));
+        }
+        mix(n.children.size());
+        for (const node_id child : n.children) {
+            mix(child);
+        }
+    }
+    return h;
+}
+
+class checkpoint_writer {
+public:
+    template <typename T>
+    void put(T v) {
+        auto raw = static_cast<std::make_unsigned_t<T>>(v);
+        for (std::size_t i = 0; i < sizeof(T); ++i) {
+            bytes_.push_back(static_cast<std::byte>((raw >> (8u * i)) & 0xFFu));
+        }
+    }
+
+    void put_f64(double v) { put(std::bit_cast<std::uint64_t>(v)); }
+
+    void put_string(std::string_view text) {
+        put(checked_u32(text.size(), "string"));
+        const auto* data = reinterpret_cast<const std::byte*>(text.data());
+        bytes_.insert(bytes_.end(), data, data + text.size());
+    }
+
+    std::vector<std::byte> take() && { return std::move(bytes_); }
+
+private:
+    std::vector<std::byte> bytes_;
+};
+
+class checkpoint_reader {
+public:
+    explicit checkpoint_reader(std::span<const std::byte> image) : image_(image) {}
+
+    template <typename T>
+    T get() {
+        need(sizeof(T));
+        std::make_unsigned_t<T> raw = 0;
+        for (std::size_t i = 0; i < sizeof(T); ++i) {
+            raw |= static_cast<std::make_unsigned_t<T>>(std::to_integer<std::uint8_t>(image_[pos_ + i])) << (8u * i);
+        }
+        pos_ += sizeof(T);
+        return static_cast<T>(raw);
+    }
+
+    double get_f64() { return std::bit_cast<double>(get<std::uint64_t>()); }
+
+    std::string get_string() {
+        const std::uint32_t size = get<std::uint32_t>();
+        need(size);
+        std::string out(reinterpret_cast<const char*>(image_.data() + pos_), size);
+        pos_ += size;
+        return out;
+    }
+
+    [[nodiscard]] bool done() const noexcept { return pos_ == image_.size(); }
+    // A count of records at least `min_size` bytes each, checked against the bytes left.
+    std::uint32_t get_count(std::size_t min_size) {
+        const std::uint32_t count = get<std::uint32_t>();
+        if (count > (image_.size() - pos_) / min_size) {
+            throw std::runtime_error("bt.restore: checkpoint is truncated");
+        }
+        return count;
+    }
+
+private:
+    void need(std::size_t size) const {
+        if (image_.size() - pos_ < size) {
+            throw std::runtime_error("bt.restore: checkpoint is truncated");
+        }
+    }
+
+    std::span<const std::byte> image_;
+    std::size_t pos_ = 0;
+};
+
+void put_checkpoint_value(checkpoint_writer& out, const std::string& key, const bb_value& value) {
+    if (const auto* b = std::get_if<bool>(&value)) {
+        out.put(static_cast<std::uint8_t>(checkpoint_tag::boolean));
+        out.put(static_cast<std::uint8_t>(*b ? 1 : 0));
+    } else if (const auto* i = std::get_if<std::int64_t>(&value)) {
+        out.put(static_cast<std::uint8_t>(checkpoint_tag::integer));
+        out.put(*i);
+    } else if (const auto* f = std::get_if<double>(&value)) {
+        out.put(static_cast<std::uint8_t>(checkpoint_tag::floating));
+        out.put_f64(*f);
+    } else if (const auto* text = std::get_if<std::string>(&value)) {
+        out.put(static_cast<std::uint8_t>(checkpoint_tag::string));
+        out.put_string(*text);
+    } else if (const auto* vec = std::get_if<bb_vector>(&value)) {
+        out.put(static_cast<std::uint8_t>(checkpoint_tag::vector));
+        out.put(checked_u32(vec->size(), "vector"));
+        for (const double x : *vec) {
+            out.put_f64(x);
+        }
+    } else if (std::holds_alternative<std::monostate>(value)) {
+        out.put(static_cast<std::uint8_t>(checkpoint_tag::nil));
+    } else {
+        throw std::runtime_error("bt.checkpoint: blackboard key " + key + " holds a " + bb_value_type_name(value) +
+                                 ", which only exists in this process");
+    }
+}
+
+bb_value get_checkpoint_value(checkpoint_reader& in) {
+    switch (static_cast<checkpoint_tag>(in.get<std::uint8_t>())) {
+        case checkpoint_tag::nil:
+            return std::monostate{};
+        case checkpoint_tag::boolean:
+            return in.get<std::uint8_t>() != 0u;
+        case checkpoint_tag::integer:
+            return in.get<std::int64_t>();
+        case checkpoint_tag::floating:
+            return in.get_f64();
+        case checkpoint_tag::string:
+            return in.get_string();
+        case checkpoint_tag::vector: {
+            const std::uint32_t size = in.get<std::uint32_t>();
+            if (size > k_max_serialised_items * 16ull) {
+                throw std::runtime_error("bt.restore: vector is too large");
+            }
+            std::vector<double> values;
+            values.reserve(size);
+            for (std::uint32_t i = 0; i < size; ++i) {
+                values.push_back(in.get_f64());
+            }
+            return bb_vector(std::move(values));
+        }
+    }
+    throw std::runtime_error("bt.restore: unknown blackboard value tag");
+}
+
+struct checkpoint_memory {
+    node_id node = 0;
+    std::int64_t i0 = 0;
+    std::int64_t i1 = 0;
+    bool b0 = false;
+};
+
+struct checkpoint_entry {
+    std::string key;
+    bb_value value;
+    std::uint64_t last_write_tick = 0;
+    std::int64_t age_ns = 0;
+    node_id writer_node = 0;
+    std::string writer_name;
+};
+
+}  // namespace
+
+std::vector<std::byte> encode_instance_checkpoint(const instance& inst) {
+    if (!inst.def) {
+        throw std::runtime_error("bt.checkpoint: instance has no definition");
+    }
+    if (const std::string reason = inst.uncopyable_state(); !reason.empty()) {
+        throw std::runtime_error("bt.checkpoint: " + reason);
+    }
+    checkpoint_writer out;
+    for (const char c : k_checkpoint_magic) {
+        out.put(static_cast<std::uint8_t>(c));
+    }
+    out.put(k_checkpoint_version);
+    out.put(checkpoint_layout_hash(*inst.def));
+    out.put(inst.tick_index);
+
+    const bool slots_ready = inst.slots_def == inst.def;
+    const std::size_t touched =
+        slots_ready ? static_cast<std::size_t>(std::count_if(inst.memory_touched.begin(),
+                                                             inst.memory_touched.end(),
+                                                             [](std::uint8_t t) { return t != 0u; }))
+                    : 0u;
+    out.put(checked_u32(touched, "node memory"));
+    for (std::size_t id = 0; slots_ready && id < inst.memory.size(); ++id) {
+        if (inst.memory_touched[id] == 0u) {
+            continue;
+        }
+        const node_memory& mem = inst.memory[id];
+        out.put(static_cast<std::uint32_t>(id));
+        out.put(mem.i0);
+        out.put(mem.i1);
+        out.put(static_cast<std::uint8_t>(mem.b0 ? 1 : 0));
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    const std::vector<std::pair<std::string, bb_entry>> entries = inst.bb.snapshot();
+    out.put(checked_u32(entries.size(), "blackboard"));
+    for (const auto& [key, entry] : entries) {
+        out.put_string(key);
+        put_checkpoint_value(out, key, entry.value);
+        out.put(entry.last_write_tick);
+        out.put(static_cast<std::int64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now - entry.last_write_ts).count()));
+        out.put(static_cast<std::uint32_t>(entry.last_writer_node_id));
+        out.put_string(entry.last_writer_name);
+    }
+    return std::move(out).take();
+}
+
+void restore_instance_checkpoint(instance& inst, std::span<const std::byte> image) {
+    if (!inst.def) {
+        throw std::runtime_error("bt.restore: instance has no definition");
+    }
+    checkpoint_reader in(image);
+    for (const char c : k_checkpoint_magic) {
+        if (in.get<std::uint8_t>() != static_cast<std::uint8_t>(c)) {
+            throw std::runtime_error("bt.restore: invalid header (expected MBTS)");
+        }
+    }
+    if (const std::uint32_t version = in.get<std::uint32_t>(); version != k_checkpoint_version) {
+        throw std::runtime_error("bt.restore: unsupported checkpoint version " + std::to_string(version));
+    }
+    if (in.get<std::uint64_t>() != checkpoint_layout_hash(*inst.def)) {
+        throw std::runtime_error("bt.restore: checkpoint was taken from a different tree");
+    }
+    const std::uint64_t tick_index = in.get<std::uint64_t>();
+
+    // Node id, i0, i1 and b0.
+    std::vector<checkpoint_memory> memory(in.get_count(21));
+    for (checkpoint_memory& mem : memory) {
+        mem.node = in.get<std::uint32_t>();
+        if (mem.node >= inst.def->nodes.size()) {
+            throw std::runtime_error("bt.restore: node id out of range");
+        }
+        mem.i0 = in.get<std::int64_t>();
+        mem.i1 = in.get<std::int64_t>();
+        mem.b0 = in.get<std::uint8_t>() != 0u;
+    }
+    // Key size, tag, tick, age, writer node and writer name size.
+    std::vector<checkpoint_entry> entries(in.get_count(29));
+    for (checkpoint_entry& entry : entries) {
+        entry.key = in.get_string();
+        entry.value = get_checkpoint_value(in);
+        entry.last_write_tick = in.get<std::uint64_t>();
+        entry.age_ns = in.get<std::int64_t>();
+        entry.writer_node = in.get<std::uint32_t>();
+        entry.writer_name = in.get_string();
+    }
+    if (!in.done()) {
+        throw std::runtime_error("bt.restore: trailing bytes after checkpoint");
+    }
+
+    reset(inst);
+    inst.prepare_node_slots();
+    for (const checkpoint_memory& mem : memory) {
+        node_memory& slot = inst.memory[mem.node];
+        slot.i0 = mem.i0;
+        slot.i1 = mem.i1;
+        slot.b0 = mem.b0;
+        inst.touch_memory(mem.node);
+    }
+    const auto now = std::chrono::steady_clock::now();
+    for (checkpoint_entry& entry : entries) {
+        inst.bb.put(entry.key,
+                    std::move(entry.value),
+                    entry.last_write_tick,
+                    now - std::chrono::nanoseconds(entry.age_ns),
+                    entry.writer_node,
+                    entry.writer_name);
+    }
+    inst.tick_index = tick_index;
+}
+
+void save_instance_checkpoint(const instance& inst, const std::string& path) {
+    const std::vector<std::byte> image = encode_instance_checkpoint(inst);
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        throw std::runtime_error("bt.checkpoint: failed to open file: " + path);
+    }
+    write_exact(out, image.data(), image.size(), "bt.checkpoint");
+}
+
+void load_instance_checkpoint(instance& inst, const std::string& path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        throw std::runtime_error("bt.restore: failed to open file: " + path);
+    }
+    std::vector<std::byte> image(static_cast<std::size_t>(in.tellg()));
+    in.seekg(0);
+    read_exact(in, image.data(), image.size(), "bt.restore");
+    restore_instance_checkpoint(inst, image);
+}
+
 }  // namespace bt
@@ -0,0 +1,376 @@
+#include "bt/shm_exchange.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <ctime>
+#endif
+
+namespace bt {
+namespace {
+
+constexpr char k_magic[8] = {'M', 'B', 'T', 'S', 'H', 'M', 'E', 'X'};
+constexpr std::uint32_t k_version = 1;
+constexpr std::size_t k_header_bytes = 64;
+constexpr std::size_t k_buffer_header_bytes = 64;
+// A reader that keeps finding a buffer mid-write gives up after this many copies; only a writer that
+// died while publishing holds a buffer that long.
+constexpr int k_read_attempts = 1024;
+
+struct exchange_header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t obs_capacity;
+    std::uint32_t act_capacity;
+    std::atomic<std::uint32_t> closed;
+    std::atomic<std::uint32_t> obs_doorbell;
+    std::atomic<std::uint32_t> act_doorbell;
+    std::atomic<std::uint32_t> obs_waiters;
+    std::atomic<std::uint32_t> act_waiters;
+    std::atomic<std::uint64_t> obs_seq;
+    std::atomic<std::uint64_t> act_seq;
+};
+static_assert(sizeof(exchange_header) <= k_header_bytes);
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+struct buffer_header {
+    std::atomic<std::uint64_t> lock;
+    std::uint64_t seq;
+    std::int64_t t_ms;
+    std::int64_t aux;
+    std::uint32_t flags;
+    std::uint32_t count;
+};
+static_assert(sizeof(buffer_header) <= k_buffer_header_bytes);
+
+std::size_t round_up_64(std::size_t n) {
+    return (n + 63) & ~static_cast<std::size_t>(63);
+}
+
+std::size_t buffer_stride(std::size_t capacity) {
+    return k_buffer_header_bytes + round_up_64(capacity * sizeof(double));
+}
+
+std::string shm_object_name(const std::string& name) {
+    if (name.empty() || name.find('/') != std::string::npos) {
+        throw std::runtime_error("shm exchange name must be non-empty and must not contain '/'");
+    }
+    return "/" + name;
+}
+
+exchange_header* header_of(void* base) {
+    return static_cast<exchange_header*>(base);
+}
+
+std::atomic<std::uint64_t>& seq_word(exchange_header* header, shm_channel channel) {
+    return channel == shm_channel::observation ? header->obs_seq : header->act_seq;
+}
+
+std::atomic<std::uint32_t>& doorbell_word(exchange_header* header, shm_channel channel) {
+    return channel == shm_channel::observation ? header->obs_doorbell : header->act_doorbell;
+}
+
+std::atomic<std::uint32_t>& waiters_word(exchange_header* header, shm_channel channel) {
+    return channel == shm_channel::observation ? header->obs_waiters : header->act_waiters;
+}
+
+void spin_pause() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// Parks until `word` no longer holds `expected`, a wake arrives or `timeout` passes. The word lives in
+// a MAP_SHARED mapping, so the futex is a shared (not process-private) one.
+void park(std::atomic<std::uint32_t>& word, std::uint32_t expected, std::chrono::microseconds timeout) {
+#if defined(__linux__)
+    timespec ts{};
+    ts.tv_sec = static_cast<time_t>(timeout.count() / 1000000);
+    ts.tv_nsec = static_cast<long>((timeout.count() % 1000000) * 1000);
+    (void)::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT, expected, &ts, nullptr, 0);
+#else
+    if (word.load(std::memory_order_acquire) == expected) {
+        std::this_thread::sleep_for(std::min(timeout, std::chrono::microseconds(100)));
+    }
+#endif
+}
+
+void wake_all(std::atomic<std::uint32_t>& word) noexcept {
+#if defined(__linux__)
+    (void)::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE, 0x7fffffff, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+}  // namespace
+
+#if defined(_WIN32)
+
+std::shared_ptr<shm_exchange> shm_exchange::create(std::string, std::size_t, std::size_t) {
+    throw std::runtime_error("shm exchange: shared memory is not supported on this platform");
+}
+
+std::shared_ptr<shm_exchange> shm_exchange::open(std::string) {
+    throw std::runtime_error("shm exchange: shared memory is not supported on this platform");
+}
+
+shm_exchange::~shm_exchange() = default;
+
+#else
+
+std::shared_ptr<shm_exchange> shm_exchange::create(std::string name, std::size_t obs_capacity, std::size_t act_capacity) {
+    if (obs_capacity == 0 || act_capacity == 0 || obs_capacity > 0xffffffffu || act_capacity > 0xffffffffu) {
+        throw std::runtime_error("shm exchange: obs_capacity and act_capacity must be > 0");
+    }
+    const std::string object = shm_object_name(name);
+    const std::size_t total = k_header_bytes + 2 * buffer_stride(obs_capacity) + 2 * buffer_stride(act_capacity);
+
+    (void)::shm_unlink(object.c_str());
+    const int fd = ::shm_open(object.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        throw std::runtime_error("shm exchange: shm_open failed for " + object + ": " + std::strerror(errno));
+    }
+    if (::ftruncate(fd, static_cast<off_t>(total)) != 0) {
+        const std::string error = std::strerror(errno);
+        (void)::close(fd);
+        (void)::shm_unlink(object.c_str());
+        throw std::runtime_error("shm exchange: ftruncate failed: " + error);
+    }
+    void* base = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    (void)::close(fd);
+    if (base == MAP_FAILED) {
+        (void)::shm_unlink(object.c_str());
+        throw std::runtime_error("shm exchange: mmap failed");
+    }
+
+    // ftruncate zero-fills, so both channels start empty with unlocked buffers.
+    exchange_header* header = header_of(base);
+    header->version = k_version;
+    header->obs_capacity = static_cast<std::uint32_t>(obs_capacity);
+    header->act_capacity = static_cast<std::uint32_t>(act_capacity);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header->magic, k_magic, sizeof(k_magic));
+    return std::shared_ptr<shm_exchange>(new shm_exchange(std::move(name), base, total, true));
+}
+
+std::shared_ptr<shm_exchange> shm_exchange::open(std::string name) {
+    const std::string object = shm_object_name(name);
+    const int fd = ::shm_open(object.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        throw std::runtime_error("shm exchange: cannot open " + object + ": " + std::strerror(errno));
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < k_header_bytes) {
+        (void)::close(fd);
+        throw std::runtime_error("shm exchange: " + object + " is too small to be an exchange");
+    }
+    const auto total = static_cast<std::size_t>(st.st_size);
+    void* base = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    (void)::close(fd);
+    if (base == MAP_FAILED) {
+        throw std::runtime_error("shm exchange: mmap failed");
+    }
+    const exchange_header* header = header_of(base);
+    if (std::memcmp(header->magic, k_magic, sizeof(k_magic)) != 0 || header->version != k_version ||
+        header->obs_capacity == 0 || header->act_capacity == 0 ||
+        total < k_header_bytes + 2 * buffer_stride(header->obs_capacity) + 2 * buffer_stride(header->act_capacity)) {
+        (void)::munmap(base, total);
+        throw std::runtime_error("shm exchange: " + object + " is not a version 1 exchange");
+    }
+    return std::shared_ptr<shm_exchange>(new shm_exchange(std::move(name), base, total, false));
+}
+
+shm_exchange::~shm_exchange() {
+    if (base_ != nullptr) {
+        (void)::munmap(base_, mapped_bytes_);
+    }
+    if (owner_) {
+        (void)::shm_unlink(shm_object_name(name_).c_str());
+    }
+}
+
+#endif
+
+shm_exchange::shm_exchange(std::string name, void* base, std::size_t mapped_bytes, bool owner)
+    : name_(std::move(name)), base_(base), mapped_bytes_(mapped_bytes), owner_(owner) {
+    const exchange_header* header = header_of(base_);
+    obs_capacity_ = header->obs_capacity;
+    act_capacity_ = header->act_capacity;
+    obs_stride_ = buffer_stride(obs_capacity_);
+    act_stride_ = buffer_stride(act_capacity_);
+}
+
+std::size_t shm_exchange::capacity(shm_channel channel) const noexcept {
+    return channel == shm_channel::observation ? obs_capacity_ : act_capacity_;
+}
+
+std::byte* shm_exchange::buffer(shm_channel channel, std::uint64_t seq) const noexcept {
+    std::byte* base = static_cast<std::byte*>(base_) + k_header_bytes;
+    if (channel == shm_channel::observation) {
+        return base + (seq % 2) * obs_stride_;
+    }
+    return base + 2 * obs_stride_ + (seq % 2) * act_stride_;
+}
+
+std::uint64_t shm_exchange::latest(shm_channel channel) const noexcept {
+    return seq_word(header_of(base_), channel).load(std::memory_order_acquire);
+}
+
+std::uint64_t shm_exchange::publish(shm_channel channel,
+                                    std::span<const double> values,
+                                    std::int64_t t_ms,
+                                    std::uint32_t flags,
+                                    std::int64_t aux) {
+    if (values.size() > capacity(channel)) {
+        throw std::length_error("shm exchange: message of " + std::to_string(values.size()) +
+                                " values exceeds capacity " + std::to_string(capacity(channel)));
+    }
+    exchange_header* header = header_of(base_);
+    std::atomic<std::uint64_t>& seq_at = seq_word(header, channel);
+    const std::uint64_t seq = seq_at.load(std::memory_order_relaxed) + 1;
+    std::byte* base = buffer(channel, seq);
+    auto* bh = reinterpret_cast<buffer_header*>(base);
+
+    const std::uint64_t lock = bh->lock.load(std::memory_order_relaxed);
+    bh->lock.store(lock + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bh->seq = seq;
+    bh->t_ms = t_ms;
+    bh->aux = aux;
+    bh->flags = flags;
+    bh->count = static_cast<std::uint32_t>(values.size());
+    if (!values.empty()) {
+        std::memcpy(base + k_buffer_header_bytes, values.data(), values.size() * sizeof(double));
+    }
+    bh->lock.store(lock + 2, std::memory_order_release);
+
+    // Sequentially consistent with the waiter's registration in wait(), so either the waiter sees the
+    // new seq or this sees the waiter and wakes it.
+    seq_at.store(seq, std::memory_order_seq_cst);
+    std::atomic<std::uint32_t>& doorbell = doorbell_word(header, channel);
+    doorbell.fetch_add(1, std::memory_order_seq_cst);
+    if (waiters_word(header, channel).load(std::memory_order_seq_cst) != 0) {
+        wake_all(doorbell);
+    }
+    return seq;
+}
+
+bool shm_exchange::read(shm_channel channel, shm_message& out) const {
+    const std::size_t cap = capacity(channel);
+    for (int attempt = 0; attempt < k_read_attempts; ++attempt) {
+        const std::uint64_t seq = latest(channel);
+        if (seq == 0) {
+            return false;
+        }
+        const std::byte* base = buffer(channel, seq);
+        const auto* bh = reinterpret_cast<const buffer_header*>(base);
+        const std::uint64_t before = bh->lock.load(std::memory_order_acquire);
+        if ((before & 1u) != 0 || bh->seq != seq) {
+            spin_pause();
+            continue;
+        }
+        const std::size_t count = std::min<std::size_t>(bh->count, cap);
+        out.values.resize(count);
+        if (count != 0) {
+            std::memcpy(out.values.data(), base + k_buffer_header_bytes, count * sizeof(double));
+        }
+        const std::int64_t t_ms = bh->t_ms;
+        const std::int64_t aux = bh->aux;
+        const std::uint32_t flags = bh->flags;
+        const std::uint64_t copied_seq = bh->seq;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (bh->lock.load(std::memory_order_relaxed) != before || copied_seq != seq) {
+            continue;
+        }
+        out.seq = seq;
+        out.t_ms = t_ms;
+        out.aux = aux;
+        out.flags = flags;
+        return true;
+    }
+    return false;
+}
+
+bool shm_exchange::wait(shm_channel channel,
+                        std::uint64_t after_seq,
+                        std::chrono::microseconds timeout,
+                        std::chrono::microseconds spin) const {
+    exchange_header* header = header_of(base_);
+    const auto started = std::chrono::steady_clock::now();
+    const auto deadline = started + timeout;
+    const auto spin_until = started + std::min(spin, timeout);
+    for (std::uint32_t round = 1;; ++round) {
+        if (latest(channel) > after_seq) {
+            return true;
+        }
+        if (closed()) {
+            return false;
+        }
+        if (std::chrono::steady_clock::now() >= spin_until) {
+            break;
+        }
+        // Yielding now and then lets a peer that shares this core publish while we spin.
+        if ((round & 63u) == 0) {
+            std::this_thread::yield();
+        } else {
+            spin_pause();
+        }
+    }
+
+    std::atomic<std::uint32_t>& doorbell = doorbell_word(header, channel);
+    std::atomic<std::uint32_t>& waiters = waiters_word(header, channel);
+    waiters.fetch_add(1, std::memory_order_seq_cst);
+    bool arrived = false;
+    while (true) {
+        const std::uint32_t ring = doorbell.load(std::memory_order_seq_cst);
+        if (seq_word(header, channel).load(std::memory_order_seq_cst) > after_seq) {
+            arrived = true;
+            break;
+        }
+        if (closed()) {
+            break;
+        }
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            break;
+        }
+        park(doorbell, ring, std::chrono::duration_cast<std::chrono::microseconds>(deadline - now));
+    }
+    waiters.fetch_sub(1, std::memory_order_seq_cst);
+    return arrived;
+}
+
+void shm_exchange::close() noexcept {
+    exchange_header* header = header_of(base_);
+    header->closed.store(1, std::memory_order_seq_cst);
+    for (const shm_channel channel : {shm_channel::observation, shm_channel::action}) {
+        std::atomic<std::uint32_t>& doorbell = doorbell_word(header, channel);
+        doorbell.fetch_add(1, std::memory_order_seq_cst);
+        wake_all(doorbell);
+    }
+}
+
+bool shm_exchange::closed() const noexcept {
+    return header_of(base_)->closed.load(std::memory_order_acquire) != 0;
+}
+
+}  // namespace bt
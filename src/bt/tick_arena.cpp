@@ -0,0 +1,89 @@
+#include "bt/tick_arena.hpp"
+
+#include <algorithm>
+#include <new>
+
+namespace bt {
+
+struct tick_arena::spill_block {
+    spill_block* next = nullptr;
+    std::size_t alignment = 0;
+};
+
+namespace {
+
+std::size_t round_up(std::size_t value, std::size_t alignment) noexcept {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace
+
+tick_arena::tick_arena(std::size_t initial_bytes) : capacity_(initial_bytes) {}
+
+tick_arena::~tick_arena() {
+    reset();
+}
+
+void tick_arena::reset() {
+    high_water_ = std::max(high_water_, used_ + spilled_bytes_);
+    while (spills_) {
+        spill_block* block = spills_;
+        spills_ = block->next;
+        const std::size_t alignment = block->alignment;
+        block->~spill_block();
+        ::operator delete(static_cast<void*>(block), std::align_val_t{alignment});
+    }
+    if (spilled_bytes_ > 0) {
+        ++overflow_count_;
+        capacity_ = round_up(std::max(capacity_ * 2, used_ + spilled_bytes_), alignof(std::max_align_t));
+        buffer_ = std::make_unique_for_overwrite<std::byte[]>(capacity_);
+    }
+    used_ = 0;
+    spilled_bytes_ = 0;
+}
+
+std::size_t tick_arena::capacity_bytes() const noexcept {
+    return capacity_;
+}
+
+std::size_t tick_arena::used_bytes() const noexcept {
+    return used_ + spilled_bytes_;
+}
+
+std::size_t tick_arena::high_water_bytes() const noexcept {
+    return std::max(high_water_, used_ + spilled_bytes_);
+}
+
+std::uint64_t tick_arena::overflow_count() const noexcept {
+    return overflow_count_;
+}
+
+void* tick_arena::do_allocate(std::size_t bytes, std::size_t alignment) {
+    if (capacity_ > used_) {
+        if (!buffer_) {
+            buffer_ = std::make_unique_for_overwrite<std::byte[]>(capacity_);
+        }
+        void* p = buffer_.get() + used_;
+        std::size_t space = capacity_ - used_;
+        if (std::align(alignment, bytes, p, space)) {
+            used_ = capacity_ - space + bytes;
+            return p;
+        }
+    }
+
+    // Spilled blocks are chained through a header in front of the payload and freed by reset().
+    alignment = std::max(alignment, alignof(spill_block));
+    const std::size_t header = round_up(sizeof(spill_block), alignment);
+    void* raw = ::operator new(header + bytes, std::align_val_t{alignment});
+    spills_ = ::new (raw) spill_block{spills_, alignment};
+    spilled_bytes_ += bytes;
+    return static_cast<std::byte*>(raw) + header;
+}
+
+void tick_arena::do_deallocate(void*, std::size_t, std::size_t) noexcept {}
+
+bool tick_arena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+}  // namespace bt
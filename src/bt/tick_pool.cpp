@@ -0,0 +1,164 @@
+#include "bt/tick_pool.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace bt {
+
+tick_worker_pool::tick_worker_pool(std::size_t worker_count, heap_event_sink on_heap_event)
+    : on_heap_event_(std::move(on_heap_event)) {
+    if (worker_count == 0) {
+        throw std::invalid_argument("tick_worker_pool: worker count must be positive");
+    }
+    workers_.reserve(worker_count);
+    for (std::size_t i = 0; i < worker_count; ++i) {
+        auto w = std::make_unique<worker>();
+        w->heap = std::make_unique<muslisp::gc>();
+        // Each worker heap gets the process heap's limits as its own bound.
+        w->heap->set_limits(muslisp::default_gc().limits());
+        if (on_heap_event_) {
+            w->heap->set_lifecycle_listener([this, raw = w.get()](const muslisp::gc_lifecycle_event& event) {
+                on_heap_event_(raw->shard, event);
+            });
+        }
+        workers_.push_back(std::move(w));
+    }
+    for (const std::unique_ptr<worker>& w : workers_) {
+        w->thread = std::thread([this, raw = w.get()] { worker_loop(*raw); });
+    }
+}
+
+tick_worker_pool::~tick_worker_pool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wave_cv_.notify_all();
+    for (const std::unique_ptr<worker>& w : workers_) {
+        if (w->thread.joinable()) {
+            w->thread.join();
+        }
+        // Workers only tick native-only waves, which hand no Lisp value out of a slice (leaf args are
+        // materialised on the calling thread and symbols are permanent), so nothing outside the heap
+        // points into it.
+        w->heap->clear_lifecycle_listener();
+        w->heap.reset();
+    }
+}
+
+std::size_t tick_worker_pool::worker_count() const noexcept {
+    return workers_.size();
+}
+
+void tick_worker_pool::tick_wave(std::span<instance* const> insts,
+                                 registry& reg,
+                                 services& svc,
+                                 std::span<status> out) {
+    if (out.size() < insts.size()) {
+        throw bt_runtime_error("BT tick wave: status span is shorter than the instance span");
+    }
+    sorted_.assign(insts.begin(), insts.end());
+    std::sort(sorted_.begin(), sorted_.end());
+    if (std::adjacent_find(sorted_.begin(), sorted_.end()) != sorted_.end()) {
+        throw bt_runtime_error("BT tick wave: an instance appears more than once in a parallel wave");
+    }
+    if (insts.size() < 2) {
+        bt::tick_wave(insts, reg, svc, out);
+        return;
+    }
+
+    // Everything slices would otherwise build lazily and share is built here, before any worker runs.
+    prepare_wave(insts, reg);
+    // Lisp leaves share the global env and process-heap objects, which worker threads must not write,
+    // so a wave with any of them is ticked on the calling thread.
+    if (std::any_of(insts.begin(), insts.end(), [](const instance* inst) { return !inst->leaf_links->native_only; })) {
+        ++sequential_waves_;
+        bt::tick_wave(insts, reg, svc, out);
+        return;
+    }
+    ++parallel_waves_;
+    if (svc.obs.events) {
+        svc.obs.events->ensure_run_started();
+    }
+
+    const muslisp::gc& process_heap = muslisp::default_gc();
+    const std::size_t slice = (insts.size() + workers_.size() - 1) / workers_.size();
+    for (std::size_t i = 0; i < workers_.size(); ++i) {
+        worker& w = *workers_[i];
+        const std::size_t begin = std::min(insts.size(), i * slice);
+        const std::size_t end = std::min(insts.size(), begin + slice);
+        w.insts = insts.subspan(begin, end - begin);
+        w.out = out.subspan(begin, end - begin);
+        w.error = nullptr;
+        w.heap->set_policy(process_heap.policy());
+        w.heap->set_incremental_slice_budget(process_heap.incremental_slice_budget());
+        if (svc.obs.events) {
+            w.shard.configure_shard(*svc.obs.events);
+        }
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        reg_ = &reg;
+        svc_ = svc;
+        pending_ = workers_.size();
+        ++wave_;
+        wave_cv_.notify_all();
+        done_cv_.wait(lock, [this] { return pending_ == 0; });
+    }
+
+    std::exception_ptr error;
+    {
+        event_log_batch_scope batch(svc.obs.events);
+        for (const std::unique_ptr<worker>& w : workers_) {
+            if (svc.obs.events) {
+                w->shard.replay_into(*svc.obs.events);
+            }
+            if (!error) {
+                error = w->error;
+            }
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void tick_worker_pool::worker_loop(worker& w) {
+    std::uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wave_cv_.wait(lock, [this, seen] { return stopping_ || wave_ != seen; });
+            if (stopping_) {
+                return;
+            }
+            seen = wave_;
+        }
+
+        run_slice(w);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--pending_ == 0) {
+            done_cv_.notify_one();
+        }
+    }
+}
+
+void tick_worker_pool::run_slice(worker& w) {
+    if (w.insts.empty()) {
+        return;
+    }
+    try {
+        muslisp::gc_thread_heap_scope heap_scope(*w.heap);
+        services slice_svc = svc_;
+        if (slice_svc.obs.events) {
+            slice_svc.obs.events = &w.shard;
+        }
+        bt::tick_wave(w.insts, *reg_, slice_svc, w.out);
+    } catch (...) {
+        w.error = std::current_exception();
+    }
+}
+
+}  // namespace bt
@@ -0,0 +1,49 @@
+#include "bt/tick_wake.hpp"
+
+namespace bt {
+
+const char* wake_reason_name(wake_reason reason) noexcept {
+    switch (reason) {
+        case wake_reason::none:
+            return "none";
+        case wake_reason::initial:
+            return "initial";
+        case wake_reason::bb_write:
+            return "bb_write";
+        case wake_reason::job_complete:
+            return "job_complete";
+        case wake_reason::timer:
+            return "timer";
+        case wake_reason::running:
+            return "running";
+    }
+    return "unknown";
+}
+
+void tick_waker::notify(wake_reason reason) noexcept {
+    const std::uint32_t bit = wake_bits(reason);
+    // Both sides use sequentially consistent order: either the waiter's predicate sees the bit, or
+    // this sees the waiter and wakes it under the mutex.
+    if ((pending_.fetch_or(bit) & bit) != 0) {
+        return;
+    }
+    if (waiters_.load() != 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cv_.notify_all();
+    }
+}
+
+std::uint32_t tick_waker::wait_until(std::chrono::steady_clock::time_point deadline) {
+    if (const std::uint32_t bits = pending_.load(); bits != 0) {
+        return bits;
+    }
+    waiters_.fetch_add(1);
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait_until(lock, deadline, [this] { return pending_.load() != 0; });
+    }
+    waiters_.fetch_sub(1);
+    return pending_.load();
+}
+
+}  // namespace bt
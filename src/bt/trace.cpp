@@ -1,42 +1,287 @@
 #include "bt/trace.hpp"
 
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <variant>
+
 namespace bt {
+namespace {
+
+constexpr std::string_view k_evicted_text = "<evicted>";
+
+std::uint32_t clamp_count(std::size_t count) noexcept {
+    return static_cast<std::uint32_t>(std::min<std::size_t>(count, std::numeric_limits<std::uint32_t>::max()));
+}
+
+// Formats a value captured by push_value() the way bb_value_repr would have at push time.
+std::string format_value(const trace_record& rec, std::string_view bytes) {
+    bb_value value;
+    bool cut = false;
+    switch (rec.value_kind) {
+        case trace_value_kind::text:
+            return std::string(bytes);
+        case trace_value_kind::nil:
+            break;
+        case trace_value_kind::boolean:
+            value = rec.value_bits != 0;
+            break;
+        case trace_value_kind::int64:
+            value = static_cast<std::int64_t>(rec.value_bits);
+            break;
+        case trace_value_kind::float64:
+            value = std::bit_cast<double>(rec.value_bits);
+            break;
+        case trace_value_kind::string:
+            value = std::string(bytes);
+            cut = bytes.size() < rec.value_count;
+            break;
+        case trace_value_kind::float64_vector: {
+            std::vector<double> values(bytes.size() / sizeof(double));
+            std::memcpy(values.data(), bytes.data(), values.size() * sizeof(double));
+            cut = values.size() < rec.value_count;
+            value = bb_vector(std::move(values));
+            break;
+        }
+        case trace_value_kind::image_handle:
+            value = image_handle_ref{static_cast<std::int64_t>(rec.value_bits)};
+            break;
+        case trace_value_kind::blob_handle:
+            value = blob_handle_ref{static_cast<std::int64_t>(rec.value_bits)};
+            break;
+    }
+    std::string out = bb_value_repr(value);
+    if (cut && rec.value_kind == trace_value_kind::float64_vector) {
+        out.insert(out.size() - 1, out.size() > 2 ? ",..." : "...");
+    } else if (cut) {
+        out += "...";
+    }
+    return out;
+}
+
+}  // namespace
+
+trace_buffer::trace_buffer(std::size_t capacity_events)
+    : capacity_(capacity_events), text_capacity_(capacity_events * k_text_bytes_per_event) {}
+
+bool trace_buffer::allocate() noexcept {
+    if (!allocation_tried_) {
+        allocation_tried_ = true;
+        slots_.reset(new (std::nothrow) slot[capacity_]);
+        text_.reset(new (std::nothrow) char[text_capacity_]);
+        if (!slots_ || !text_) {
+            slots_.reset();
+            text_.reset();
+        }
+    }
+    return slots_ != nullptr;
+}
+
+void trace_buffer::push(const trace_record& rec,
+                        std::string_view key,
+                        std::string_view value_repr,
+                        std::string_view message) noexcept {
+    trace_record text_rec = rec;
+    text_rec.value_kind = trace_value_kind::text;
+    append(text_rec, key, value_repr, message);
+}
+
+void trace_buffer::push_value(const trace_record& rec, std::string_view key, const bb_value& value) noexcept {
+    trace_record typed = rec;
+    std::string_view bytes;
+    std::visit(
+        [&](const auto& v) {
+            using T = std::decay_t<decltype(v)>;
+            if constexpr (std::is_same_v<T, std::monostate>) {
+                typed.value_kind = trace_value_kind::nil;
+            } else if constexpr (std::is_same_v<T, bool>) {
+                typed.value_kind = trace_value_kind::boolean;
+                typed.value_bits = v ? 1u : 0u;
+            } else if constexpr (std::is_same_v<T, std::int64_t>) {
+                typed.value_kind = trace_value_kind::int64;
+                typed.value_bits = static_cast<std::uint64_t>(v);
+            } else if constexpr (std::is_same_v<T, double>) {
+                typed.value_kind = trace_value_kind::float64;
+                typed.value_bits = std::bit_cast<std::uint64_t>(v);
+            } else if constexpr (std::is_same_v<T, std::string>) {
+                typed.value_kind = trace_value_kind::string;
+                typed.value_count = clamp_count(v.size());
+                bytes = std::string_view(v).substr(0, value_preview_);
+            } else if constexpr (std::is_same_v<T, bb_vector>) {
+                typed.value_kind = trace_value_kind::float64_vector;
+                typed.value_count = clamp_count(v.size());
+                bytes = std::string_view(reinterpret_cast<const char*>(v.data()),
+                                         std::min(v.size(), value_preview_) * sizeof(double));
+            } else if constexpr (std::is_same_v<T, image_handle_ref>) {
+                typed.value_kind = trace_value_kind::image_handle;
+                typed.value_bits = static_cast<std::uint64_t>(v.id);
+            } else {
+                typed.value_kind = trace_value_kind::blob_handle;
+                typed.value_bits = static_cast<std::uint64_t>(v.id);
+            }
+        },
+        value);
+    append(typed, key, bytes, {});
+}
 
-trace_buffer::trace_buffer(std::size_t capacity_events) : capacity_(capacity_events) {
-    events_.reserve(capacity_);
+void trace_buffer::set_value_preview(std::size_t elements) noexcept {
+    value_preview_ = elements;
 }
 
-void trace_buffer::push(trace_event ev) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    ev.sequence = ++sequence_;
+std::size_t trace_buffer::value_preview() const noexcept {
+    return value_preview_;
+}
 
-    if (capacity_ == 0) {
+void trace_buffer::append(trace_record rec,
+                          std::string_view key,
+                          std::string_view value_repr,
+                          std::string_view message) noexcept {
+    const std::uint64_t sequence = head_.load(std::memory_order_relaxed) + 1;
+    if (capacity_ == 0 || !allocate()) {
+        head_.store(sequence, std::memory_order_release);
         return;
     }
 
-    if (events_.size() == capacity_) {
-        events_.erase(events_.begin());
+    // Text that could never fit is cut so that one event cannot evict its own start.
+    std::size_t budget = text_capacity_;
+    key = key.substr(0, budget);
+    budget -= key.size();
+    value_repr = value_repr.substr(0, budget);
+    budget -= value_repr.size();
+    message = message.substr(0, budget);
+
+    const std::uint64_t text_offset = text_end_.load(std::memory_order_relaxed);
+    const std::uint64_t text_size = key.size() + value_repr.size() + message.size();
+    if (text_size > 0) {
+        // Readers re-check text_end_ after copying, so reserve before overwriting old bytes.
+        text_end_.store(text_offset + text_size, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        write_text(text_offset, key);
+        write_text(text_offset + key.size(), value_repr);
+        write_text(text_offset + key.size() + value_repr.size(), message);
     }
-    events_.push_back(std::move(ev));
+
+    slot& s = slots_[next_slot_];
+    const std::uint64_t version = s.version.load(std::memory_order_relaxed);
+    s.version.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    s.rec = rec;
+    s.rec.sequence = sequence;
+    s.rec.text_offset = text_offset;
+    s.rec.key_size = static_cast<std::uint32_t>(key.size());
+    s.rec.value_size = static_cast<std::uint32_t>(value_repr.size());
+    s.rec.message_size = static_cast<std::uint32_t>(message.size());
+    s.version.store(version + 2, std::memory_order_release);
+
+    next_slot_ = next_slot_ + 1 == capacity_ ? 0 : next_slot_ + 1;
+    head_.store(sequence, std::memory_order_release);
+}
+
+void trace_buffer::push(const trace_event& ev) noexcept {
+    trace_record rec;
+    rec.kind = ev.kind;
+    rec.node_status = ev.node_status;
+    rec.job_st = ev.job_st;
+    rec.node = ev.node;
+    rec.tick_index = ev.tick_index;
+    rec.ts = ev.ts;
+    rec.duration = ev.duration;
+    rec.job = ev.job;
+    push(rec, ev.key, ev.value_repr, ev.message);
+}
+
+void trace_buffer::write_text(std::uint64_t offset, std::string_view text) noexcept {
+    const std::size_t at = static_cast<std::size_t>(offset % text_capacity_);
+    const std::size_t first = std::min(text.size(), text_capacity_ - at);
+    std::memcpy(text_.get() + at, text.data(), first);
+    std::memcpy(text_.get(), text.data() + first, text.size() - first);
+}
+
+void trace_buffer::read_text(std::uint64_t offset, std::size_t size, std::string& out) const {
+    out.resize(size);
+    const std::size_t at = static_cast<std::size_t>(offset % text_capacity_);
+    const std::size_t first = std::min(size, text_capacity_ - at);
+    std::memcpy(out.data(), text_.get() + at, first);
+    std::memcpy(out.data() + first, text_.get(), size - first);
 }
 
 std::vector<trace_event> trace_buffer::snapshot() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return events_;
+    std::vector<trace_event> out;
+    const std::uint64_t head = head_.load(std::memory_order_acquire);
+    const std::uint64_t first = std::max(cleared_at_.load(std::memory_order_acquire),
+                                         head > capacity_ ? head - capacity_ : std::uint64_t{0});
+    if (head == first || !slots_) {
+        return out;
+    }
+    out.reserve(static_cast<std::size_t>(head - first));
+    for (std::uint64_t sequence = first + 1; sequence <= head; ++sequence) {
+        const slot& s = slots_[static_cast<std::size_t>((sequence - 1) % capacity_)];
+        trace_record rec;
+        std::uint64_t version = 0;
+        do {
+            version = s.version.load(std::memory_order_acquire);
+            rec = s.rec;
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((version & 1u) != 0 || s.version.load(std::memory_order_relaxed) != version);
+        if (rec.sequence != sequence) {
+            continue;  // overwritten by a newer event since head was read
+        }
+
+        trace_event& ev = out.emplace_back();
+        ev.kind = rec.kind;
+        ev.sequence = rec.sequence;
+        ev.tick_index = rec.tick_index;
+        ev.ts = rec.ts;
+        ev.node = rec.node;
+        ev.node_status = rec.node_status;
+        ev.duration = rec.duration;
+        ev.job = rec.job;
+        ev.job_st = rec.job_st;
+        std::string value_bytes;
+        if (rec.key_size + rec.value_size + rec.message_size > 0) {
+            read_text(rec.text_offset, rec.key_size, ev.key);
+            read_text(rec.text_offset + rec.key_size, rec.value_size, value_bytes);
+            read_text(rec.text_offset + rec.key_size + rec.value_size, rec.message_size, ev.message);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (text_end_.load(std::memory_order_relaxed) > rec.text_offset + text_capacity_) {
+                for (std::string* text : {&ev.key, &ev.message}) {
+                    if (!text->empty()) {
+                        text->assign(k_evicted_text);
+                    }
+                }
+                if (rec.value_size > 0) {
+                    ev.value_repr = k_evicted_text;
+                    continue;
+                }
+            }
+        }
+        ev.value_repr = format_value(rec, value_bytes);
+    }
+    return out;
 }
 
-std::size_t trace_buffer::size() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return events_.size();
+std::size_t trace_buffer::size() const noexcept {
+    const std::uint64_t head = head_.load(std::memory_order_acquire);
+    const std::uint64_t retained = head - std::min(head, cleared_at_.load(std::memory_order_acquire));
+    return static_cast<std::size_t>(std::min<std::uint64_t>(retained, capacity_));
 }
 
-std::size_t trace_buffer::capacity() const {
+std::size_t trace_buffer::capacity() const noexcept {
     return capacity_;
 }
 
-void trace_buffer::clear() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    events_.clear();
+bool trace_buffer::allocated() const noexcept {
+    return slots_ != nullptr;
+}
+
+std::size_t trace_buffer::memory_bytes() const noexcept {
+    return slots_ ? capacity_ * sizeof(slot) + text_capacity_ : 0;
+}
+
+void trace_buffer::clear() noexcept {
+    cleared_at_.store(head_.load(std::memory_order_relaxed), std::memory_order_release);
 }
 
 const char* trace_event_kind_name(trace_event_kind kind) noexcept {
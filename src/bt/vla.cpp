@@ -1,6 +1,7 @@
 #include "bt/vla.hpp"
 
 #include <algorithm>
+#include <charconv>
 #include <cmath>
 #include <filesystem>
 #include <fstream>
@@ -192,50 +193,124 @@ std::optional<std::string> validate_request_shape(const vla_request& request) {
     return std::nullopt;
 }
 
-bool validate_and_clamp_action(const vla_request& request, vla_action& action, std::string& reason) {
-    if (action.type != vla_action_type::continuous) {
-        return true;
-    }
-
-    const std::size_t dims = static_cast<std::size_t>(request.action_space.dims);
-    if (action.u.size() != dims) {
-        reason = "response.action dimensions do not match action space";
-        return false;
+// The output gate of one request, compiled once and applied to its action and to every step of its
+// chunk. Bounds are kept as separate lower and upper arrays so the clamps run as plain loops over the
+// action, and forbidden ranges are sorted and merged so each value is checked with one binary search
+// however many ranges the constraints list.
+class action_gate {
+public:
+    explicit action_gate(const vla_request& request)
+        : max_abs_(request.constraints.max_abs_value), max_delta_(request.constraints.max_delta) {
+        lo_.reserve(request.action_space.bounds.size());
+        hi_.reserve(request.action_space.bounds.size());
+        for (const auto& [lo, hi] : request.action_space.bounds) {
+            lo_.push_back(lo);
+            hi_.push_back(hi);
+        }
+        for (const auto& [lo, hi] : request.constraints.forbidden_ranges) {
+            if (lo <= hi) {
+                forbidden_.emplace_back(lo, hi);
+            }
+        }
+        std::sort(forbidden_.begin(), forbidden_.end());
+        std::size_t merged = 0;
+        for (std::size_t i = 0; i < forbidden_.size(); ++i) {
+            if (merged != 0 && forbidden_[i].first <= forbidden_[merged - 1].second) {
+                forbidden_[merged - 1].second = std::max(forbidden_[merged - 1].second, forbidden_[i].second);
+            } else {
+                forbidden_[merged++] = forbidden_[i];
+            }
+        }
+        forbidden_.resize(merged);
     }
 
-    for (std::size_t i = 0; i < dims; ++i) {
-        if (!std::isfinite(action.u[i])) {
+    // Checks `u` and clamps it in place. max_delta is measured from `previous` when it is not empty.
+    bool apply(std::vector<double>& u, const std::vector<double>& previous, std::string& reason) const {
+        const std::size_t dims = lo_.size();
+        if (u.size() != dims) {
+            reason = "response.action dimensions do not match action space";
+            return false;
+        }
+        bool finite = true;
+        for (const double value : u) {
+            finite &= std::isfinite(value);
+        }
+        if (!finite) {
             reason = "response.action contains non-finite value";
             return false;
         }
-        const auto [lo, hi] = request.action_space.bounds[i];
-        action.u[i] = std::clamp(action.u[i], lo, hi);
-
-        if (std::fabs(action.u[i]) > request.constraints.max_abs_value) {
-            action.u[i] = std::copysign(request.constraints.max_abs_value, action.u[i]);
+        for (std::size_t i = 0; i < dims; ++i) {
+            u[i] = std::clamp(u[i], lo_[i], hi_[i]);
         }
-
-        for (const auto& [f_lo, f_hi] : request.constraints.forbidden_ranges) {
-            if (action.u[i] >= f_lo && action.u[i] <= f_hi) {
-                reason = "response.action intersects forbidden range";
-                return false;
+        for (std::size_t i = 0; i < dims; ++i) {
+            if (std::fabs(u[i]) > max_abs_) {
+                u[i] = std::copysign(max_abs_, u[i]);
             }
         }
-    }
-
-    if (!request.observation.state.empty()) {
-        const std::size_t n = std::min(request.observation.state.size(), action.u.size());
+        if (!forbidden_.empty()) {
+            for (const double value : u) {
+                if (in_forbidden_range(value)) {
+                    reason = "response.action intersects forbidden range";
+                    return false;
+                }
+            }
+        }
+        const std::size_t n = std::min(previous.size(), dims);
         for (std::size_t i = 0; i < n; ++i) {
-            const double delta = std::fabs(action.u[i] - request.observation.state[i]);
-            if (delta > request.constraints.max_delta) {
-                action.u[i] = request.observation.state[i] +
-                              std::copysign(request.constraints.max_delta, action.u[i] - request.observation.state[i]);
-                const auto [lo, hi] = request.action_space.bounds[i];
-                action.u[i] = std::clamp(action.u[i], lo, hi);
+            const double delta = u[i] - previous[i];
+            if (std::fabs(delta) > max_delta_) {
+                u[i] = std::clamp(previous[i] + std::copysign(max_delta_, delta), lo_[i], hi_[i]);
             }
         }
+        return true;
+    }
+
+private:
+    [[nodiscard]] bool in_forbidden_range(double value) const noexcept {
+        const auto after = std::upper_bound(forbidden_.begin(),
+                                            forbidden_.end(),
+                                            value,
+                                            [](double v, const std::pair<double, double>& range) {
+                                                return v < range.first;
+                                            });
+        return after != forbidden_.begin() && value <= std::prev(after)->second;
+    }
+
+    std::vector<double> lo_;
+    std::vector<double> hi_;
+    double max_abs_ = 1.0;
+    double max_delta_ = 1.0;
+    std::vector<std::pair<double, double>> forbidden_;
+};
+
+bool validate_and_clamp_action(const action_gate& gate,
+                               const vla_request& request,
+                               vla_action& action,
+                               std::string& reason) {
+    if (action.type != vla_action_type::continuous) {
+        return true;
     }
+    return gate.apply(action.u, request.observation.state, reason);
+}
 
+// Gates every step of an action chunk like a single action. A step's max_delta is measured from the
+// step before it, the first step's from the observed state.
+bool validate_and_clamp_chunk(const action_gate& gate,
+                              const vla_request& request,
+                              std::vector<vla_chunk_step>& chunk,
+                              std::string& reason) {
+    const std::vector<double>* previous = &request.observation.state;
+    for (vla_chunk_step& step : chunk) {
+        if (!std::isfinite(step.dt_ms) || step.dt_ms <= 0.0) {
+            reason = "response.chunk step dt_ms must be positive and finite";
+            return false;
+        }
+        if (!gate.apply(step.u, *previous, reason)) {
+            reason = "response.chunk: " + reason;
+            return false;
+        }
+        previous = &step.u;
+    }
     return true;
 }
 
@@ -354,8 +429,59 @@ private:
     std::function<std::optional<vla_response>(std::uint64_t)> lookup_fn_;
 };
 
+// The observation handles a submitted request holds until its backend has run, or until the
+// scheduler drops the job without running it.
+class observation_refs {
+public:
+    observation_refs(std::shared_ptr<vla_handle_refs> refs, const vla_observation& obs) : refs_(std::move(refs)) {
+        if (obs.image.has_value() && refs_->retain_image(*obs.image)) {
+            image_ = obs.image;
+        }
+        if (obs.blob.has_value() && refs_->retain_blob(*obs.blob)) {
+            blob_ = obs.blob;
+        }
+    }
+    observation_refs(const observation_refs&) = delete;
+    observation_refs& operator=(const observation_refs&) = delete;
+    ~observation_refs() { release(); }
+
+    void release() {
+        if (image_.has_value()) {
+            (void)refs_->release_image(*std::exchange(image_, std::nullopt));
+        }
+        if (blob_.has_value()) {
+            (void)refs_->release_blob(*std::exchange(blob_, std::nullopt));
+        }
+    }
+
+private:
+    std::shared_ptr<vla_handle_refs> refs_;
+    std::optional<image_handle_ref> image_;
+    std::optional<blob_handle_ref> blob_;
+};
+
 }  // namespace
 
+bool vla_handle_refs::retain_image(image_handle_ref handle) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return service_ != nullptr && service_->retain_image(handle);
+}
+
+bool vla_handle_refs::release_image(image_handle_ref handle) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return service_ != nullptr && service_->release_image(handle);
+}
+
+bool vla_handle_refs::retain_blob(blob_handle_ref handle) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return service_ != nullptr && service_->retain_blob(handle);
+}
+
+bool vla_handle_refs::release_blob(blob_handle_ref handle) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return service_ != nullptr && service_->release_blob(handle);
+}
+
 void capability_registry::register_capability(capability_descriptor descriptor) {
     if (descriptor.name.empty()) {
         throw std::invalid_argument("register_capability: capability name must not be empty");
@@ -384,10 +510,11 @@ std::optional<capability_descriptor> capability_registry::describe(std::string_v
     return it->second;
 }
 
-vla_service::vla_service(scheduler* sched) : sched_(sched) {
+vla_service::vla_service(scheduler* sched) : sched_(sched), handle_refs_(std::make_shared<vla_handle_refs>()) {
     if (!sched_) {
         throw std::invalid_argument("vla_service: scheduler pointer must not be null");
     }
+    handle_refs_->service_ = this;
     records_.reserve(record_capacity_);
 
     capability_descriptor cap;
@@ -425,6 +552,10 @@ vla_service::vla_service(scheduler* sched) : sched_(sched) {
 }
 
 vla_service::~vla_service() {
+    {
+        std::lock_guard<std::mutex> lock(handle_refs_->mutex_);
+        handle_refs_->service_ = nullptr;
+    }
     std::vector<job_id> scheduler_jobs;
     {
         std::lock_guard<std::mutex> lock(mutex_);
@@ -434,7 +565,8 @@ vla_service::~vla_service() {
         scheduler_jobs.reserve(jobs_.size());
         for (auto& [_, state] : jobs_) {
             state->cancel_requested.store(true);
-            if (!is_terminal(state->status) && state->scheduler_job_id != 0) {
+            // A cancelled or timed-out job can still be running its backend; wait for those too.
+            if (state->scheduler_job_id != 0) {
                 scheduler_jobs.push_back(state->scheduler_job_id);
             }
         }
@@ -468,6 +600,7 @@ vla_service::vla_job_id vla_service::submit(const vla_request& request) {
 
     vla_record immediate_record;
     bool emit_immediate_record = false;
+    vla_job_id superseded_id = 0;
 
     {
         std::lock_guard<std::mutex> lock(mutex_);
@@ -568,22 +701,19 @@ vla_service::vla_job_id vla_service::submit(const vla_request& request) {
             if (active_it != active_owner_jobs_.end()) {
                 const auto old_it = jobs_.find(active_it->second);
                 if (old_it != jobs_.end() && !is_terminal(old_it->second->status)) {
-                    old_it->second->cancel_requested.store(true);
+                    // Cancelled once the lock is released, so a job still queued is finalised too.
                     old_it->second->superseded = true;
-                    if (old_it->second->scheduler_job_id != 0) {
-                        (void)sched_->cancel(old_it->second->scheduler_job_id);
-                    }
+                    superseded_id = old_it->first;
                 }
             }
             active_owner_jobs_[owner_key] = state->id;
 
-            const auto cache_it = cache_.find(state->request_hash);
-            if (cache_it != cache_.end() && now < cache_it->second.expires_at) {
+            if (std::optional<vla_response> cached = cache_.find(state->request_hash, now); cached.has_value()) {
                 state->status = vla_job_status::done;
                 state->cache_hit = true;
                 state->started_at = now;
                 state->finished_at = now;
-                state->final = cache_it->second.response;
+                state->final = std::move(cached);
 
                 immediate_record.ts_ms = now_ms();
                 immediate_record.run_id = request.run_id;
@@ -610,6 +740,9 @@ vla_service::vla_job_id vla_service::submit(const vla_request& request) {
         }
     }
 
+    if (superseded_id != 0) {
+        (void)cancel(superseded_id);
+    }
     if (emit_immediate_record) {
         append_record(immediate_record);
         return state->id;
@@ -649,7 +782,12 @@ vla_service::vla_job_id vla_service::submit(const vla_request& request) {
 
     job_request req;
     req.task_name = "vla.submit";
-    req.fn = [this, state, backend] {
+    req.priority = request.priority;
+    req.deadline = state->submitted_at + std::chrono::milliseconds(request.deadline_ms);
+    // Scheduler-side cancellation sets the same flag the backend polls.
+    req.cancel_flag = std::shared_ptr<std::atomic<bool>>(state, &state->cancel_requested);
+    auto held = std::make_shared<observation_refs>(handle_refs_, request.observation);
+    req.fn = [this, state, backend, held] {
         vla_record rec;
         {
             std::lock_guard<std::mutex> lock(mutex_);
@@ -680,8 +818,11 @@ vla_service::vla_job_id vla_service::submit(const vla_request& request) {
             response.model = state->request.model;
             response.explanation = "backend unknown exception";
         }
+        held->release();
 
         const auto finish = std::chrono::steady_clock::now();
+        std::optional<vla_response> cache_response;
+        vla_response_cache::clock::time_point cache_expires_at{};
 
         {
             std::lock_guard<std::mutex> lock(mutex_);
@@ -698,7 +839,9 @@ vla_service::vla_job_id vla_service::submit(const vla_request& request) {
 
             std::string invalid_reason;
             if (response.status == vla_status::ok) {
-                if (!validate_and_clamp_action(state->request, response.action, invalid_reason)) {
+                const action_gate gate(state->request);
+                if (!validate_and_clamp_action(gate, state->request, response.action, invalid_reason) ||
+                    !validate_and_clamp_chunk(gate, state->request, response.chunk, invalid_reason)) {
                     response.status = vla_status::invalid;
                     response.explanation = invalid_reason;
                 }
@@ -717,12 +860,9 @@ vla_service::vla_job_id vla_service::submit(const vla_request& request) {
             }
 
             if (response.status == vla_status::ok) {
-                cache_[state->request_hash] = cache_entry{
-                    .response = response,
-                    .expires_at = finish + std::chrono::milliseconds(cache_ttl_ms_),
-                };
+                cache_response = response;
+                cache_expires_at = finish + std::chrono::milliseconds(cache_ttl_ms_);
                 replay_store_[state->request_hash] = response;
-                evict_cache_if_needed();
             }
 
             rec.ts_ms = now_ms();
@@ -750,7 +890,11 @@ vla_service::vla_job_id vla_service::submit(const vla_request& request) {
             rec.completion_dropped = state->completion_dropped;
         }
 
-        append_record(rec);
+        // Outside mutex_: the cache locks only the shard the hash falls in.
+        if (cache_response.has_value()) {
+            cache_.insert(state->request_hash, std::move(*cache_response), cache_expires_at);
+        }
+        append_record(std::move(rec));
         return job_result{};
     };
 
@@ -895,20 +1039,42 @@ image_handle_ref vla_service::create_image(std::int64_t width,
                                            std::int64_t channels,
                                            std::string encoding,
                                            std::int64_t timestamp_ms,
-                                           std::string frame_id) {
+                                           std::string frame_id,
+                                           std::span<const std::byte> payload) {
     if (width <= 0 || height <= 0 || channels <= 0) {
         throw std::invalid_argument("create_image: dimensions/channels must be > 0");
     }
+    std::string frame_ref;
+    retained_payload pooled;
+    if (!payload.empty()) {
+        frame_ref = store_frame(payload,
+                                frame_ring_meta{
+                                    .width = width,
+                                    .height = height,
+                                    .channels = channels,
+                                    .encoding = encoding,
+                                    .timestamp_ms = timestamp_ms,
+                                },
+                                pooled,
+                                "create_image");
+    }
+    const bool in_process = pooled.owner != nullptr;
     std::lock_guard<std::mutex> lock(mutex_);
     const std::int64_t id = next_image_id_++;
-    images_[id] = image_info{
-        .id = id,
-        .width = width,
-        .height = height,
-        .channels = channels,
-        .encoding = std::move(encoding),
-        .timestamp_ms = timestamp_ms,
-        .frame_id = std::move(frame_id),
+    images_[id] = image_record{
+        .info =
+            image_info{
+                .id = id,
+                .width = width,
+                .height = height,
+                .channels = channels,
+                .encoding = std::move(encoding),
+                .timestamp_ms = timestamp_ms,
+                .frame_id = std::move(frame_id),
+                .frame_ref = std::move(frame_ref),
+                .in_process = in_process,
+            },
+        .payload = std::move(pooled),
     };
     return image_handle_ref{.id = id};
 }
@@ -916,29 +1082,171 @@ image_handle_ref vla_service::create_image(std::int64_t width,
 blob_handle_ref vla_service::create_blob(std::int64_t size_bytes,
                                          std::string mime_type,
                                          std::int64_t timestamp_ms,
-                                         std::string tag) {
+                                         std::string tag,
+                                         std::span<const std::byte> payload) {
     if (size_bytes < 0) {
         throw std::invalid_argument("create_blob: size_bytes must be >= 0");
     }
+    std::string frame_ref;
+    retained_payload pooled;
+    if (!payload.empty()) {
+        if (static_cast<std::size_t>(size_bytes) != payload.size()) {
+            throw std::invalid_argument("create_blob: size_bytes does not match the payload size");
+        }
+        frame_ref = store_frame(payload,
+                                frame_ring_meta{.encoding = mime_type, .timestamp_ms = timestamp_ms},
+                                pooled,
+                                "create_blob");
+    }
+    const bool in_process = pooled.owner != nullptr;
     std::lock_guard<std::mutex> lock(mutex_);
     const std::int64_t id = next_blob_id_++;
-    blobs_[id] = blob_info{
-        .id = id,
-        .size_bytes = size_bytes,
-        .mime_type = std::move(mime_type),
-        .timestamp_ms = timestamp_ms,
-        .tag = std::move(tag),
+    blobs_[id] = blob_record{
+        .info =
+            blob_info{
+                .id = id,
+                .size_bytes = size_bytes,
+                .mime_type = std::move(mime_type),
+                .timestamp_ms = timestamp_ms,
+                .tag = std::move(tag),
+                .frame_ref = std::move(frame_ref),
+                .in_process = in_process,
+            },
+        .payload = std::move(pooled),
     };
     return blob_handle_ref{.id = id};
 }
 
+image_handle_ref vla_service::adopt_image(std::int64_t width,
+                                          std::int64_t height,
+                                          std::int64_t channels,
+                                          std::string encoding,
+                                          std::int64_t timestamp_ms,
+                                          std::string frame_id,
+                                          retained_payload payload) {
+    if (width <= 0 || height <= 0 || channels <= 0) {
+        throw std::invalid_argument("adopt_image: dimensions/channels must be > 0");
+    }
+    if (!payload.owner || payload.bytes.empty()) {
+        throw std::invalid_argument("adopt_image: payload must not be empty");
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    const std::int64_t id = next_image_id_++;
+    images_[id] = image_record{
+        .info =
+            image_info{
+                .id = id,
+                .width = width,
+                .height = height,
+                .channels = channels,
+                .encoding = std::move(encoding),
+                .timestamp_ms = timestamp_ms,
+                .frame_id = std::move(frame_id),
+                .frame_ref = {},
+                .in_process = true,
+            },
+        .payload = std::move(payload),
+    };
+    return image_handle_ref{.id = id};
+}
+
+blob_handle_ref vla_service::adopt_blob(std::string mime_type,
+                                        std::int64_t timestamp_ms,
+                                        std::string tag,
+                                        retained_payload payload) {
+    if (!payload.owner || payload.bytes.empty()) {
+        throw std::invalid_argument("adopt_blob: payload must not be empty");
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    const std::int64_t id = next_blob_id_++;
+    blobs_[id] = blob_record{
+        .info =
+            blob_info{
+                .id = id,
+                .size_bytes = static_cast<std::int64_t>(payload.bytes.size()),
+                .mime_type = std::move(mime_type),
+                .timestamp_ms = timestamp_ms,
+                .tag = std::move(tag),
+                .frame_ref = {},
+                .in_process = true,
+            },
+        .payload = std::move(payload),
+    };
+    return blob_handle_ref{.id = id};
+}
+
+std::string vla_service::store_frame(std::span<const std::byte> payload,
+                                     const frame_ring_meta& meta,
+                                     retained_payload& pooled,
+                                     const char* where) {
+    {
+        std::lock_guard<std::mutex> lock(frame_ring_mutex_);
+        if (frame_ring_) {
+            return frame_ring_->ref(frame_ring_->publish(payload, meta));
+        }
+    }
+    std::shared_ptr<std::byte[]> slab;
+    try {
+        slab = payload_pool_.acquire(payload.size());
+    } catch (const std::length_error& e) {
+        throw std::length_error(std::string(where) + ": " + e.what());
+    }
+    std::copy(payload.begin(), payload.end(), slab.get());
+    pooled.bytes = std::span<const std::byte>(slab.get(), payload.size());
+    pooled.owner = std::move(slab);
+    return {};
+}
+
+payload_pool& vla_service::payload_pool_ref() noexcept {
+    return payload_pool_;
+}
+
+const payload_pool& vla_service::payload_pool_ref() const noexcept {
+    return payload_pool_;
+}
+
+std::size_t vla_service::live_images() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return images_.size();
+}
+
+std::size_t vla_service::live_blobs() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return blobs_.size();
+}
+
+void vla_service::clear_handles() {
+    std::unordered_map<std::int64_t, image_record> images;
+    std::unordered_map<std::int64_t, blob_record> blobs;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        images.swap(images_);
+        blobs.swap(blobs_);
+    }
+    // Payload owners are dropped here, outside the lock.
+}
+
+std::shared_ptr<vla_handle_refs> vla_service::handle_refs() const noexcept {
+    return handle_refs_;
+}
+
+void vla_service::attach_frame_ring(std::shared_ptr<frame_ring> ring) {
+    std::lock_guard<std::mutex> lock(frame_ring_mutex_);
+    frame_ring_ = std::move(ring);
+}
+
+std::shared_ptr<frame_ring> vla_service::attached_frame_ring() const {
+    std::lock_guard<std::mutex> lock(frame_ring_mutex_);
+    return frame_ring_;
+}
+
 std::optional<image_info> vla_service::get_image_info(image_handle_ref handle) const {
     std::lock_guard<std::mutex> lock(mutex_);
     const auto it = images_.find(handle.id);
     if (it == images_.end()) {
         return std::nullopt;
     }
-    return it->second;
+    return it->second.info;
 }
 
 std::optional<blob_info> vla_service::get_blob_info(blob_handle_ref handle) const {
@@ -947,7 +1255,78 @@ std::optional<blob_info> vla_service::get_blob_info(blob_handle_ref handle) cons
     if (it == blobs_.end()) {
         return std::nullopt;
     }
-    return it->second;
+    return it->second.info;
+}
+
+std::optional<retained_payload> vla_service::image_payload(image_handle_ref handle) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = images_.find(handle.id);
+    if (it == images_.end() || !it->second.payload.owner) {
+        return std::nullopt;
+    }
+    return it->second.payload;
+}
+
+std::optional<retained_payload> vla_service::blob_payload(blob_handle_ref handle) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = blobs_.find(handle.id);
+    if (it == blobs_.end() || !it->second.payload.owner) {
+        return std::nullopt;
+    }
+    return it->second.payload;
+}
+
+bool vla_service::retain_image(image_handle_ref handle) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = images_.find(handle.id);
+    if (it == images_.end()) {
+        return false;
+    }
+    ++it->second.refs;
+    return true;
+}
+
+bool vla_service::release_image(image_handle_ref handle) {
+    retained_payload dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto it = images_.find(handle.id);
+        if (it == images_.end()) {
+            return false;
+        }
+        if (--it->second.refs == 0) {
+            dropped = std::move(it->second.payload);
+            images_.erase(it);
+        }
+    }
+    // The owner's destructor (a message deleter, a loan return) runs outside the lock.
+    return true;
+}
+
+bool vla_service::retain_blob(blob_handle_ref handle) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = blobs_.find(handle.id);
+    if (it == blobs_.end()) {
+        return false;
+    }
+    ++it->second.refs;
+    return true;
+}
+
+bool vla_service::release_blob(blob_handle_ref handle) {
+    retained_payload dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto it = blobs_.find(handle.id);
+        if (it == blobs_.end()) {
+            return false;
+        }
+        if (--it->second.refs == 0) {
+            dropped = std::move(it->second.payload);
+            blobs_.erase(it);
+        }
+    }
+    return true;
 }
 
 std::string vla_service::dump_recent_records(std::size_t max_count) const {
@@ -1010,49 +1389,93 @@ std::int64_t vla_service::cache_ttl_ms() const noexcept {
 }
 
 void vla_service::set_cache_capacity(std::size_t capacity) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    cache_capacity_ = capacity;
-    evict_cache_if_needed();
+    cache_.set_capacity(capacity);
 }
 
 std::size_t vla_service::cache_capacity() const noexcept {
-    return cache_capacity_;
+    return cache_.capacity();
 }
 
-std::uint64_t vla_service::hash64(std::string_view text) noexcept {
-    std::uint64_t hash = 1469598103934665603ull;
+vla_cache_stats vla_service::cache_stats() const noexcept {
+    return cache_.stats();
+}
+
+hash64_stream& hash64_stream::operator<<(std::string_view text) noexcept {
     for (unsigned char c : text) {
-        hash ^= static_cast<std::uint64_t>(c);
-        hash *= 1099511628211ull;
+        hash_ ^= static_cast<std::uint64_t>(c);
+        hash_ *= 1099511628211ull;
     }
-    return hash;
+    return *this;
 }
 
-std::uint64_t vla_service::hash_request(const vla_request& request) {
-    std::ostringstream out;
-    out << request.capability << '\n' << request.task_id << '\n' << request.instruction << '\n'
-        << request.observation.timestamp_ms << '\n' << request.observation.frame_id << '\n';
+hash64_stream& hash64_stream::operator<<(char c) noexcept {
+    hash_ ^= static_cast<std::uint64_t>(static_cast<unsigned char>(c));
+    hash_ *= 1099511628211ull;
+    return *this;
+}
+
+hash64_stream& hash64_stream::operator<<(std::int64_t value) noexcept {
+    char buffer[24];
+    const auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    return *this << std::string_view(buffer, static_cast<std::size_t>(end - buffer));
+}
+
+hash64_stream& hash64_stream::operator<<(double value) noexcept {
+    // The default ostream format for double is %g with precision 6.
+    char buffer[32];
+    const auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::general, 6);
+    return *this << std::string_view(buffer, static_cast<std::size_t>(end - buffer));
+}
+
+std::uint64_t vla_service::hash64(std::string_view text) noexcept {
+    return (hash64_stream{} << text).value();
+}
+
+namespace {
+
+// Writes the canonical request text to `out`, either a std::ostream or a hash64_stream.
+template <typename Out>
+void write_canonical_request(Out& out, const vla_request& request) {
+    out << std::string_view(request.capability) << '\n' << std::string_view(request.task_id) << '\n'
+        << std::string_view(request.instruction) << '\n' << request.observation.timestamp_ms << '\n'
+        << std::string_view(request.observation.frame_id) << '\n';
     if (request.observation.image.has_value()) {
-        out << "img:" << request.observation.image->id << '\n';
+        out << std::string_view("img:") << request.observation.image->id << '\n';
     }
     if (request.observation.blob.has_value()) {
-        out << "blob:" << request.observation.blob->id << '\n';
+        out << std::string_view("blob:") << request.observation.blob->id << '\n';
     }
-    out << "state:";
+    out << std::string_view("state:");
     for (double v : request.observation.state) {
         out << v << ',';
     }
-    out << '\n' << "dims:" << request.action_space.dims << '\n';
+    out << '\n' << std::string_view("dims:") << request.action_space.dims << '\n';
     for (const auto& [lo, hi] : request.action_space.bounds) {
         out << lo << ':' << hi << ';';
     }
-    out << '\n' << "model:" << request.model.name << ':' << request.model.version << '\n';
-    out << "deadline:" << request.deadline_ms << '\n';
-    out << "max_abs:" << request.constraints.max_abs_value << " max_delta:" << request.constraints.max_delta << '\n';
-    return hash64(out.str());
+    out << '\n' << std::string_view("model:") << std::string_view(request.model.name) << ':'
+        << std::string_view(request.model.version) << '\n';
+    out << std::string_view("deadline:") << request.deadline_ms << '\n';
+    out << std::string_view("max_abs:") << request.constraints.max_abs_value << std::string_view(" max_delta:")
+        << request.constraints.max_delta << '\n';
+}
+
+}  // namespace
+
+std::uint64_t vla_service::hash_request(const vla_request& request) {
+    hash64_stream out;
+    write_canonical_request(out, request);
+    return out.value();
 }
 
-void vla_service::append_record(const vla_record& record) {
+std::string vla_service::canonical_request(const vla_request& request) {
+    std::ostringstream out;
+    write_canonical_request(out, request);
+    return out.str();
+}
+
+void vla_service::append_record(vla_record record) {
+    record.cache_stats = cache_.stats();
     std::string json_line;
     bool write_json = false;
     record_listener listener;
@@ -1095,6 +1518,9 @@ std::string vla_service::record_to_json(const vla_record& record) const {
         << "\"replay_hit\":" << (record.replay_hit ? "true" : "false") << ','
         << "\"superseded\":" << (record.superseded ? "true" : "false") << ','
         << "\"completion_dropped\":" << (record.completion_dropped ? "true" : "false") << ','
+        << "\"cache\":{\"hits\":" << record.cache_stats.hits << ",\"misses\":" << record.cache_stats.misses
+        << ",\"evictions\":" << record.cache_stats.evictions << ",\"expirations\":" << record.cache_stats.expirations
+        << ",\"size\":" << record.cache_stats.size << ",\"capacity\":" << record.cache_stats.capacity << "},"
         << "\"model_service\":{\"request_hashes\":";
     append_json_string_array(out, record.model_service_request_hashes);
     out << ",\"response_hashes\":";
@@ -1144,16 +1570,134 @@ std::string vla_service::make_owner_key(const vla_request& request) const {
     return request.run_id + "::" + request.node_name;
 }
 
-void vla_service::evict_cache_if_needed() {
-    while (cache_.size() > cache_capacity_) {
-        auto it = cache_.begin();
-        if (it == cache_.end()) {
+vla_response_cache::vla_response_cache(std::size_t capacity) : capacity_(capacity) {}
+
+vla_response_cache::shard& vla_response_cache::shard_for(std::uint64_t key) noexcept {
+    // Request hashes are FNV-1a, whose high bits mix best.
+    return shards_[(key >> 32) % k_shard_count];
+}
+
+void vla_response_cache::erase_locked(shard& s, std::list<entry>::iterator it) {
+    s.index.erase(it->key);
+    s.lru.erase(it);
+    size_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void vla_response_cache::expire_locked(shard& s, clock::time_point now) {
+    while (!s.expiries.empty() && s.expiries.top().at <= now) {
+        const expiry top = s.expiries.top();
+        s.expiries.pop();
+        const auto it = s.index.find(top.key);
+        if (it != s.index.end() && it->second->expires_at == top.at) {
+            erase_locked(s, it->second);
+            expirations_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+std::optional<vla_response> vla_response_cache::find(std::uint64_t key, clock::time_point now) {
+    shard& s = shard_for(key);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    expire_locked(s, now);
+    const auto it = s.index.find(key);
+    if (it == s.index.end()) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return std::nullopt;
+    }
+    s.lru.splice(s.lru.begin(), s.lru, it->second);
+    it->second->last_use = use_counter_.fetch_add(1, std::memory_order_relaxed);
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return it->second->response;
+}
+
+void vla_response_cache::insert(std::uint64_t key, vla_response response, clock::time_point expires_at) {
+    if (capacity_.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    {
+        shard& s = shard_for(key);
+        std::lock_guard<std::mutex> lock(s.mutex);
+        expire_locked(s, clock::now());
+        const std::uint64_t use = use_counter_.fetch_add(1, std::memory_order_relaxed);
+        if (const auto it = s.index.find(key); it != s.index.end()) {
+            it->second->response = std::move(response);
+            it->second->expires_at = expires_at;
+            it->second->last_use = use;
+            s.lru.splice(s.lru.begin(), s.lru, it->second);
+        } else {
+            s.lru.push_front(
+                entry{.key = key, .response = std::move(response), .expires_at = expires_at, .last_use = use});
+            s.index.emplace(key, s.lru.begin());
+            size_.fetch_add(1, std::memory_order_relaxed);
+        }
+        s.expiries.push(expiry{.at = expires_at, .key = key});
+        // Refreshed and evicted keys leave stale heap items behind; rebuild before they dominate.
+        if (s.expiries.size() > 2 * s.index.size() + 64) {
+            std::vector<expiry> live;
+            live.reserve(s.lru.size());
+            for (const entry& e : s.lru) {
+                live.push_back(expiry{.at = e.expires_at, .key = e.key});
+            }
+            s.expiries = decltype(s.expiries)(std::greater<>{}, std::move(live));
+        }
+    }
+    evict_to_capacity();
+}
+
+void vla_response_cache::evict_to_capacity() {
+    while (size_.load(std::memory_order_relaxed) > capacity_.load(std::memory_order_relaxed)) {
+        // Shards are locked one at a time, so the oldest tail can change before it is taken; the
+        // re-check below only requires that the chosen shard still has an entry to give up.
+        shard* oldest = nullptr;
+        std::uint64_t oldest_use = 0;
+        for (shard& s : shards_) {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            if (!s.lru.empty() && (oldest == nullptr || s.lru.back().last_use < oldest_use)) {
+                oldest = &s;
+                oldest_use = s.lru.back().last_use;
+            }
+        }
+        if (oldest == nullptr) {
             return;
         }
-        cache_.erase(it);
+        std::lock_guard<std::mutex> lock(oldest->mutex);
+        if (!oldest->lru.empty()) {
+            erase_locked(*oldest, std::prev(oldest->lru.end()));
+            evictions_.fetch_add(1, std::memory_order_relaxed);
+        }
     }
 }
 
+void vla_response_cache::set_capacity(std::size_t capacity) {
+    capacity_.store(capacity, std::memory_order_relaxed);
+    evict_to_capacity();
+}
+
+std::size_t vla_response_cache::capacity() const noexcept {
+    return capacity_.load(std::memory_order_relaxed);
+}
+
+void vla_response_cache::clear() {
+    for (shard& s : shards_) {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        size_.fetch_sub(s.lru.size(), std::memory_order_relaxed);
+        s.lru.clear();
+        s.index.clear();
+        s.expiries = {};
+    }
+}
+
+vla_cache_stats vla_response_cache::stats() const noexcept {
+    return vla_cache_stats{
+        .hits = hits_.load(std::memory_order_relaxed),
+        .misses = misses_.load(std::memory_order_relaxed),
+        .evictions = evictions_.load(std::memory_order_relaxed),
+        .expirations = expirations_.load(std::memory_order_relaxed),
+        .size = size_.load(std::memory_order_relaxed),
+        .capacity = capacity_.load(std::memory_order_relaxed),
+    };
+}
+
 const char* vla_status_name(vla_status status) noexcept {
     switch (status) {
         case vla_status::ok:
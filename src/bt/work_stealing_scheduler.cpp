@@ -0,0 +1,629 @@
+#include "bt/work_stealing_scheduler.hpp"
+
+#include <exception>
+#include <stdexcept>
+#include <utility>
+
+namespace bt {
+namespace {
+
+std::int64_t to_ns(std::chrono::steady_clock::time_point t) noexcept {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+std::chrono::steady_clock::time_point from_ns(std::int64_t ns) noexcept {
+    return std::chrono::steady_clock::time_point(
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(ns)));
+}
+
+void merge_duration(duration_stats& into, const duration_stats& from) noexcept {
+    into.count += from.count;
+    into.total += from.total;
+    into.over_budget_count += from.over_budget_count;
+    if (from.max > into.max) {
+        into.max = from.max;
+    }
+    into.histogram.merge(from.histogram);
+}
+
+}  // namespace
+
+work_stealing_scheduler::job_deque::job_deque() : slots_(std::make_unique<std::atomic<job_id>[]>(k_deque_capacity)) {}
+
+bool work_stealing_scheduler::job_deque::full() const noexcept {
+    const std::int64_t b = bottom_.load(std::memory_order_relaxed);
+    const std::int64_t t = top_.load(std::memory_order_acquire);
+    return b - t >= static_cast<std::int64_t>(k_deque_capacity);
+}
+
+void work_stealing_scheduler::job_deque::push(job_id id) noexcept {
+    const std::int64_t b = bottom_.load(std::memory_order_relaxed);
+    slots_[static_cast<std::size_t>(b) & (k_deque_capacity - 1)].store(id, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+}
+
+bool work_stealing_scheduler::job_deque::pop(job_id& out) noexcept {
+    const std::int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t t = top_.load(std::memory_order_relaxed);
+    if (t > b) {
+        bottom_.store(b + 1, std::memory_order_relaxed);
+        return false;
+    }
+    out = slots_[static_cast<std::size_t>(b) & (k_deque_capacity - 1)].load(std::memory_order_relaxed);
+    if (t == b) {
+        // Last element: race thieves for it.
+        const bool won = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+        return won;
+    }
+    return true;
+}
+
+bool work_stealing_scheduler::job_deque::steal(job_id& out) noexcept {
+    std::int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const std::int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) {
+        return false;
+    }
+    const job_id id = slots_[static_cast<std::size_t>(t) & (k_deque_capacity - 1)].load(std::memory_order_relaxed);
+    if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return false;
+    }
+    out = id;
+    return true;
+}
+
+work_stealing_scheduler::inject_queue::inject_queue() : cells_(std::make_unique<cell[]>(k_inject_capacity)) {
+    for (std::size_t i = 0; i < k_inject_capacity; ++i) {
+        cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool work_stealing_scheduler::inject_queue::push(job_id id) noexcept {
+    std::uint64_t pos = tail_.load(std::memory_order_relaxed);
+    while (true) {
+        cell& c = cells_[pos & (k_inject_capacity - 1)];
+        const std::uint64_t seq = c.sequence.load(std::memory_order_acquire);
+        const auto diff = static_cast<std::int64_t>(seq - pos);
+        if (diff == 0) {
+            if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                c.id = id;
+                c.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = tail_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool work_stealing_scheduler::inject_queue::pop(job_id& out) noexcept {
+    std::uint64_t pos = head_.load(std::memory_order_relaxed);
+    while (true) {
+        cell& c = cells_[pos & (k_inject_capacity - 1)];
+        const std::uint64_t seq = c.sequence.load(std::memory_order_acquire);
+        const auto diff = static_cast<std::int64_t>(seq - (pos + 1));
+        if (diff == 0) {
+            if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                out = c.id;
+                c.sequence.store(pos + k_inject_capacity, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = head_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+work_stealing_scheduler::work_stealing_scheduler(std::size_t worker_count, scheduler_thread_options threads)
+    : threads_(std::move(threads)),
+      directory_(std::make_unique<std::atomic<segment*>[]>(k_max_segments)),
+      retained_(std::make_unique<std::atomic<job_id>[]>(k_retained_finished)) {
+    const std::size_t count = worker_count > 0 ? worker_count : default_scheduler_worker_count();
+    workers_.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        auto w = std::make_unique<worker>();
+        w->owner = this;
+        w->index = i;
+        workers_.push_back(std::move(w));
+    }
+    // Workers steal from each other, so start them only once every deque exists.
+    for (const auto& w : workers_) {
+        w->thread = std::thread([this, self = w.get()] { worker_loop(*self); });
+    }
+}
+
+work_stealing_scheduler::~work_stealing_scheduler() {
+    stopping_.store(true);
+    wake_epoch_.fetch_add(1);
+    wake_epoch_.notify_all();
+    for (const auto& w : workers_) {
+        if (w->thread.joinable()) {
+            w->thread.join();
+        }
+    }
+    for (std::size_t i = 0; i < k_max_segments; ++i) {
+        delete directory_[i].load(std::memory_order_relaxed);
+    }
+}
+
+work_stealing_scheduler::worker*& work_stealing_scheduler::current_worker() noexcept {
+    thread_local worker* current = nullptr;
+    return current;
+}
+
+work_stealing_scheduler::job_state* work_stealing_scheduler::slot(job_id id) const noexcept {
+    const std::uint32_t index = static_cast<std::uint32_t>(id & 0xffffffffu);
+    const std::size_t seg = index / k_jobs_per_segment;
+    if (seg >= k_max_segments) {
+        return nullptr;
+    }
+    segment* s = directory_[seg].load(std::memory_order_acquire);
+    return s ? &s->jobs[index % k_jobs_per_segment] : nullptr;
+}
+
+work_stealing_scheduler::job_state& work_stealing_scheduler::slot_at(std::uint32_t index) const noexcept {
+    return directory_[index / k_jobs_per_segment].load(std::memory_order_acquire)->jobs[index % k_jobs_per_segment];
+}
+
+std::uint32_t work_stealing_scheduler::acquire_slot() {
+    std::uint64_t head = free_head_.load(std::memory_order_acquire);
+    while ((head & 0xffffffffu) != 0) {
+        const auto index = static_cast<std::uint32_t>(head & 0xffffffffu) - 1;
+        // A stale read here fails the CAS below: the tag changes on every push and pop.
+        const std::uint32_t next = slot_at(index).next_free.load(std::memory_order_relaxed);
+        const std::uint64_t popped = (((head >> 32) + 1) << 32) | next;
+        if (free_head_.compare_exchange_weak(head, popped, std::memory_order_acquire, std::memory_order_acquire)) {
+            return index;
+        }
+    }
+
+    const std::uint32_t index = next_slot_.fetch_add(1);
+    if (index >= k_max_segments * k_jobs_per_segment) {
+        next_slot_.fetch_sub(1);
+        throw std::runtime_error("work_stealing_scheduler: job table is full");
+    }
+    std::atomic<segment*>& entry = directory_[index / k_jobs_per_segment];
+    segment* s = entry.load(std::memory_order_acquire);
+    if (!s) {
+        auto fresh = std::make_unique<segment>();
+        if (entry.compare_exchange_strong(s, fresh.get(), std::memory_order_acq_rel, std::memory_order_acquire)) {
+            fresh.release();
+        }
+    }
+    return index;
+}
+
+void work_stealing_scheduler::release_slot(std::uint32_t index) noexcept {
+    job_state& job = slot_at(index);
+    std::uint64_t head = free_head_.load(std::memory_order_relaxed);
+    std::uint64_t pushed = 0;
+    do {
+        job.next_free.store(static_cast<std::uint32_t>(head & 0xffffffffu), std::memory_order_relaxed);
+        pushed = (((head >> 32) + 1) << 32) | (std::uint64_t{index} + 1);
+    } while (!free_head_.compare_exchange_weak(head, pushed, std::memory_order_release, std::memory_order_relaxed));
+}
+
+bool work_stealing_scheduler::pin(job_state& job, job_id id) noexcept {
+    const std::uint64_t generation = id >> 32;
+    std::uint64_t lease = job.lease.load(std::memory_order_acquire);
+    while (true) {
+        if ((lease >> 32) != generation) {
+            return false;
+        }
+        if ((lease & k_lease_recycling) != 0) {
+            std::this_thread::yield();
+            lease = job.lease.load(std::memory_order_acquire);
+            continue;
+        }
+        if (job.lease.compare_exchange_weak(lease, lease + 1, std::memory_order_acquire, std::memory_order_acquire)) {
+            return true;
+        }
+    }
+}
+
+void work_stealing_scheduler::unpin(job_state& job) noexcept {
+    job.lease.fetch_sub(1, std::memory_order_release);
+}
+
+bool work_stealing_scheduler::claim_exclusive(job_state& job, job_id id) noexcept {
+    const std::uint64_t generation = id >> 32;
+    std::uint64_t lease = job.lease.load(std::memory_order_acquire);
+    while (true) {
+        if ((lease >> 32) != generation) {
+            return false;
+        }
+        if ((lease & (k_lease_recycling | k_lease_pins)) != 0) {
+            std::this_thread::yield();
+            lease = job.lease.load(std::memory_order_acquire);
+            continue;
+        }
+        if (job.lease.compare_exchange_weak(lease, lease | k_lease_recycling, std::memory_order_acquire,
+                                            std::memory_order_acquire)) {
+            return true;
+        }
+    }
+}
+
+void work_stealing_scheduler::recycle_claimed(job_state& job, job_id id) noexcept {
+    // Strings and the result keep no stale data but keep their capacity for the next job.
+    job.state.store(slot_state::empty, std::memory_order_relaxed);
+    job.retire_marks.store(0, std::memory_order_relaxed);
+    job.submitted_at = {};
+    job.task_name.clear();
+    job.request = job_request{};
+    job.result.reset();
+    job.error_text.clear();
+    job.cancel_signal.store(false, std::memory_order_relaxed);
+    job.started_ns.store(0, std::memory_order_relaxed);
+    job.finished_ns.store(0, std::memory_order_relaxed);
+    const auto generation = static_cast<std::uint32_t>(id >> 32);
+    const std::uint64_t next = generation == 0xffffffffu ? 1 : std::uint64_t{generation} + 1;
+    job.lease.store(next << 32, std::memory_order_release);
+    release_slot(static_cast<std::uint32_t>(id & 0xffffffffu));
+}
+
+void work_stealing_scheduler::try_recycle(job_id id) noexcept {
+    job_state* job = slot(id);
+    if (job && claim_exclusive(*job, id)) {
+        recycle_claimed(*job, id);
+    }
+}
+
+void work_stealing_scheduler::settle(job_state& job, job_id id) noexcept {
+    if ((job.retire_marks.fetch_or(k_mark_settled, std::memory_order_acq_rel) & k_mark_taken) != 0) {
+        try_recycle(id);
+        return;
+    }
+    // Entries may already be recycled by take_result; evicting those is a no-op.
+    const std::uint64_t seq = retained_cursor_.fetch_add(1, std::memory_order_relaxed);
+    const job_id evicted = retained_[seq % k_retained_finished].exchange(id, std::memory_order_acq_rel);
+    if (evicted != 0) {
+        try_recycle(evicted);
+    }
+}
+
+job_id work_stealing_scheduler::submit(job_request req) {
+    ledger_scope charge(ledger_category::scheduler);
+    if (!req.fn) {
+        throw std::invalid_argument("scheduler submit: empty job function");
+    }
+    const std::uint32_t index = acquire_slot();
+    job_state& job = slot_at(index);
+    const job_id id = ((job.lease.load(std::memory_order_acquire) >> 32) << 32) | index;
+
+    worker* self = current_worker();
+    const bool local = self && self->owner == this && !self->deque.full();
+    try {
+        job.submitted_at = std::chrono::steady_clock::now();
+        job.task_name = req.task_name;
+        job.request = std::move(req);
+    } catch (...) {
+        recycle_claimed(job, id);
+        throw;
+    }
+    job.state.store(slot_state::queued);
+    if (local) {
+        self->deque.push(id);
+    } else if (!injected_.push(id)) {
+        recycle_claimed(job, id);
+        throw std::runtime_error("work_stealing_scheduler: job queue is full");
+    }
+    submitted_.fetch_add(1, std::memory_order_relaxed);
+    wake_one();
+    return id;
+}
+
+void work_stealing_scheduler::wake_one() noexcept {
+    // Pairs with the sleep check in worker_loop: either a sleeper re-checks after this job was
+    // published, or this sees it asleep and bumps the epoch it waits on. The fence orders the
+    // relaxed deque push before the sleeper count is read.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers_.load() > 0) {
+        wake_epoch_.fetch_add(1);
+        wake_epoch_.notify_one();
+    }
+}
+
+job_info work_stealing_scheduler::get_info(job_id id) const {
+    ledger_scope charge(ledger_category::scheduler);
+    job_state* job = slot(id);
+    if (!job || !pin(*job, id)) {
+        return job_info{};
+    }
+    job_info info;
+    try {
+        switch (job->state.load(std::memory_order_acquire)) {
+            case slot_state::empty:
+                unpin(*job);
+                return job_info{};
+            case slot_state::queued:
+                info.status = job_status::queued;
+                break;
+            case slot_state::running:
+            case slot_state::running_cancel_requested:
+                info.status = job_status::running;
+                break;
+            case slot_state::done:
+                info.status = job_status::done;
+                break;
+            case slot_state::failed:
+                info.status = job_status::failed;
+                info.error_text = job->error_text;
+                break;
+            case slot_state::cancelled:
+                info.status = job_status::cancelled;
+                info.error_text = job->error_text;
+                break;
+        }
+        info.timing.submitted_at = job->submitted_at;
+        if (const std::int64_t ns = job->started_ns.load(std::memory_order_acquire); ns != 0) {
+            info.timing.started_at = from_ns(ns);
+        }
+        if (const std::int64_t ns = job->finished_ns.load(std::memory_order_acquire); ns != 0) {
+            info.timing.finished_at = from_ns(ns);
+        }
+        info.task_name = job->task_name;
+    } catch (...) {
+        unpin(*job);
+        throw;
+    }
+    unpin(*job);
+    return info;
+}
+
+bool work_stealing_scheduler::try_get_result(job_id id, job_result& out) {
+    ledger_scope charge(ledger_category::scheduler);
+    job_state* job = slot(id);
+    if (!job || !pin(*job, id)) {
+        return false;
+    }
+    bool found = false;
+    try {
+        if (job->state.load(std::memory_order_acquire) == slot_state::done && job->result.has_value()) {
+            out = *job->result;
+            found = true;
+        }
+    } catch (...) {
+        unpin(*job);
+        throw;
+    }
+    unpin(*job);
+    return found;
+}
+
+bool work_stealing_scheduler::take_result(job_id id, job_result& out) {
+    ledger_scope charge(ledger_category::scheduler);
+    job_state* job = slot(id);
+    if (!job || !claim_exclusive(*job, id)) {
+        return false;
+    }
+    if (job->state.load(std::memory_order_acquire) != slot_state::done || !job->result.has_value()) {
+        job->lease.fetch_and(~k_lease_recycling, std::memory_order_release);
+        return false;
+    }
+    out = std::move(*job->result);
+    job->result.reset();
+    if ((job->retire_marks.fetch_or(k_mark_taken, std::memory_order_acq_rel) & k_mark_settled) != 0) {
+        recycle_claimed(*job, id);
+    } else {
+        job->lease.fetch_and(~k_lease_recycling, std::memory_order_release);
+    }
+    return true;
+}
+
+bool work_stealing_scheduler::cancel(job_id id) {
+    ledger_scope charge(ledger_category::scheduler);
+    job_state* job = slot(id);
+    if (!job || !pin(*job, id)) {
+        return false;
+    }
+    bool cancelled = false;
+    slot_state st = job->state.load(std::memory_order_acquire);
+    while (true) {
+        if (st == slot_state::queued) {
+            if (job->state.compare_exchange_weak(st, slot_state::cancelled)) {
+                job->finished_ns.store(to_ns(std::chrono::steady_clock::now()), std::memory_order_release);
+                cancelled_while_queued_.fetch_add(1, std::memory_order_relaxed);
+                // Winning the CAS makes this thread the job's last writer. The id is still queued;
+                // the worker that dequeues it settles the slot, and the pin keeps it from being
+                // recycled before then.
+                try {
+                    notify_finished(*job, id);
+                } catch (...) {
+                    unpin(*job);
+                    throw;
+                }
+                cancelled = true;
+                break;
+            }
+        } else if (st == slot_state::running) {
+            if (job->state.compare_exchange_weak(st, slot_state::running_cancel_requested)) {
+                cancel_flag_of(*job).store(true, std::memory_order_release);
+                cancelled = true;
+                break;
+            }
+        } else {
+            cancelled = st == slot_state::running_cancel_requested;
+            break;
+        }
+    }
+    unpin(*job);
+    return cancelled;
+}
+
+std::atomic<bool>& work_stealing_scheduler::cancel_flag_of(job_state& job) noexcept {
+    return job.request.cancel_flag ? *job.request.cancel_flag : job.cancel_signal;
+}
+
+void work_stealing_scheduler::notify_finished(job_state& job, job_id id) {
+    if (job.request.completions) {
+        job.request.completions->push(id, job.request.completion_tag);
+        job.request.completions.reset();
+    }
+}
+
+std::vector<std::string> work_stealing_scheduler::thread_setup_errors() const {
+    std::vector<std::string> out;
+    for (const auto& w : workers_) {
+        std::lock_guard<std::mutex> lock(w->stats_mutex);
+        if (!w->setup_error.empty()) {
+            out.push_back("worker " + std::to_string(w->index) + ": " + w->setup_error);
+        }
+    }
+    return out;
+}
+
+scheduler_profile_stats work_stealing_scheduler::stats_snapshot() const {
+    scheduler_profile_stats out;
+    for (const auto& w : workers_) {
+        std::lock_guard<std::mutex> lock(w->stats_mutex);
+        out.started += w->stats.started;
+        out.completed += w->stats.completed;
+        out.failed += w->stats.failed;
+        out.cancelled += w->stats.cancelled;
+        out.expired += w->stats.expired;
+        merge_duration(out.queue_delay, w->stats.queue_delay);
+        for (std::size_t i = 0; i < k_job_priority_count; ++i) {
+            merge_duration(out.queue_delay_by_priority[i], w->stats.queue_delay_by_priority[i]);
+        }
+        merge_duration(out.run_time, w->stats.run_time);
+    }
+    out.submitted = submitted_.load(std::memory_order_relaxed);
+    out.cancelled += cancelled_while_queued_.load(std::memory_order_relaxed);
+    out.queue_delay.last = std::chrono::nanoseconds(last_queue_delay_ns_.load(std::memory_order_relaxed));
+    out.run_time.last = std::chrono::nanoseconds(last_run_time_ns_.load(std::memory_order_relaxed));
+    return out;
+}
+
+bool work_stealing_scheduler::find_work(worker& self, job_id& out) noexcept {
+    if (self.deque.pop(out) || injected_.pop(out)) {
+        return true;
+    }
+    const std::size_t count = workers_.size();
+    for (std::size_t i = 1; i < count; ++i) {
+        if (workers_[(self.index + i) % count]->deque.steal(out)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void work_stealing_scheduler::run_job(worker& self, job_id id) {
+    // A queued id is dequeued exactly once, and its slot is not recycled before then.
+    job_state& job = *slot(id);
+    slot_state expected = slot_state::queued;
+    if (!job.state.compare_exchange_strong(expected, slot_state::running)) {
+        // Cancelled while queued.
+        settle(job, id);
+        return;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    if (job.request.deadline.has_value() && *job.request.deadline <= start) {
+        job.error_text = "deadline passed before the job started";
+        job.request.fn = nullptr;
+        job.finished_ns.store(to_ns(start), std::memory_order_release);
+        job.state.store(slot_state::cancelled);
+        notify_finished(job, id);
+        settle(job, id);
+        std::lock_guard<std::mutex> lock(self.stats_mutex);
+        ++self.stats.cancelled;
+        ++self.stats.expired;
+        return;
+    }
+    job.started_ns.store(to_ns(start), std::memory_order_release);
+    if (job.request.completions) {
+        job.request.completions->push(id, job.request.completion_tag);
+    }
+    const auto queue_delay = std::chrono::duration_cast<std::chrono::nanoseconds>(start - job.submitted_at);
+    last_queue_delay_ns_.store(queue_delay.count(), std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(self.stats_mutex);
+        ++self.stats.started;
+        self.stats.queue_delay.observe(queue_delay);
+        self.stats.queue_delay_by_priority[static_cast<std::size_t>(job.request.priority)].observe(queue_delay);
+    }
+
+    slot_state final_state = slot_state::failed;
+    try {
+        job.result = job.request.fn(cancel_token(&cancel_flag_of(job)));
+        final_state = slot_state::done;
+    } catch (const std::exception& e) {
+        job.error_text = e.what();
+    } catch (...) {
+        job.error_text = "unknown exception";
+    }
+    // Drop the job's captures now rather than when the scheduler is destroyed.
+    job.request.fn = nullptr;
+
+    const auto finish = std::chrono::steady_clock::now();
+    const auto run_time = std::chrono::duration_cast<std::chrono::nanoseconds>(finish - start);
+    job.finished_ns.store(to_ns(finish), std::memory_order_release);
+    if (final_state == slot_state::done) {
+        expected = slot_state::running;
+        if (!job.state.compare_exchange_strong(expected, slot_state::done)) {
+            // Cancelled while running: the result is discarded.
+            final_state = slot_state::cancelled;
+            job.result.reset();
+            job.state.store(slot_state::cancelled);
+        }
+    } else {
+        job.state.store(slot_state::failed);
+    }
+    notify_finished(job, id);
+    settle(job, id);
+
+    last_run_time_ns_.store(run_time.count(), std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(self.stats_mutex);
+    self.stats.run_time.observe(run_time);
+    switch (final_state) {
+        case slot_state::done:
+            ++self.stats.completed;
+            break;
+        case slot_state::cancelled:
+            ++self.stats.cancelled;
+            break;
+        default:
+            ++self.stats.failed;
+            break;
+    }
+}
+
+void work_stealing_scheduler::worker_loop(worker& self) {
+    current_worker() = &self;
+    if (std::string errors = apply_scheduler_thread_options(threads_, self.index); !errors.empty()) {
+        std::lock_guard<std::mutex> lock(self.stats_mutex);
+        self.setup_error = std::move(errors);
+    }
+    job_id id = 0;
+    while (true) {
+        if (find_work(self, id)) {
+            run_job(self, id);
+            continue;
+        }
+        sleepers_.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const std::uint32_t epoch = wake_epoch_.load();
+        if (find_work(self, id)) {
+            sleepers_.fetch_sub(1);
+            run_job(self, id);
+            continue;
+        }
+        if (stopping_.load()) {
+            sleepers_.fetch_sub(1);
+            return;
+        }
+        wake_epoch_.wait(epoch);
+        sleepers_.fetch_sub(1);
+    }
+}
+
+}  // namespace bt
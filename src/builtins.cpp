@@ -1,16 +1,21 @@
 #include "muslisp/builtins.hpp"
 
+#include "compiled_eval.hpp"
+
 #include <algorithm>
 #include <array>
 #include <chrono>
 #include <cmath>
+#include <charconv>
 #include <cctype>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <limits>
 #include <optional>
+#include <span>
 #include <sstream>
 #include <thread>
 #include <utility>
@@ -18,7 +23,9 @@
 #include "bt/blackboard.hpp"
 #include "bt/compiler.hpp"
 #include "bt/event_log.hpp"
+#include "bt/model_service_mux.hpp"
 #include "bt/planner.hpp"
+#include "bt/planner_compiled_model.hpp"
 #include "bt/runtime_host.hpp"
 #include "bt/serialisation.hpp"
 #include "bt/status.hpp"
@@ -26,19 +33,21 @@
 #include "muslisp/error.hpp"
 #include "muslisp/env_builtins.hpp"
 #include "muslisp/gc.hpp"
+#include "muslisp/persistent.hpp"
 #include "muslisp/printer.hpp"
 #include "muslisp/reader.hpp"
+#include "muslisp/snapshot.hpp"
 
 namespace muslisp {
 namespace {
 
-void require_arity(const std::string& name, const std::vector<value>& args, std::size_t expected) {
+void require_arity(const std::string& name, std::span<const value> args, std::size_t expected) {
     if (args.size() != expected) {
         throw lisp_error(name + ": expected " + std::to_string(expected) + " arguments, got " + std::to_string(args.size()));
     }
 }
 
-void require_min_arity(const std::string& name, const std::vector<value>& args, std::size_t min_expected) {
+void require_min_arity(const std::string& name, std::span<const value> args, std::size_t min_expected) {
     if (args.size() < min_expected) {
         throw lisp_error(name + ": expected at least " + std::to_string(min_expected) + " arguments, got " +
                          std::to_string(args.size()));
@@ -59,6 +68,13 @@ value require_vec_arg(value v, const std::string& where) {
     return v;
 }
 
+value require_f64vec_arg(value v, const std::string& where) {
+    if (!is_f64vec(v)) {
+        throw lisp_error(where + ": expected f64vec");
+    }
+    return v;
+}
+
 value require_map_arg(value v, const std::string& where) {
     if (!is_map(v)) {
         throw lisp_error(where + ": expected map");
@@ -66,6 +82,38 @@ value require_map_arg(value v, const std::string& where) {
     return v;
 }
 
+value require_pmap_arg(value v, const std::string& where) {
+    if (!is_pmap(v)) {
+        throw lisp_error(where + ": expected pmap");
+    }
+    return v;
+}
+
+value require_pvec_arg(value v, const std::string& where) {
+    if (!is_pvec(v)) {
+        throw lisp_error(where + ": expected pvec");
+    }
+    return v;
+}
+
+value require_transient_arg(value v, bool is_transient, const char* kind, const std::string& where) {
+    if (!is_transient) {
+        throw lisp_error(where + ": expected transient " + kind);
+    }
+    if (!is_live_transient(v)) {
+        throw lisp_error(where + ": transient used after persistent!");
+    }
+    return v;
+}
+
+value require_transient_pmap_arg(value v, const std::string& where) {
+    return require_transient_arg(v, is_pmap(v) && v->pmap_data().transient, "pmap", where);
+}
+
+value require_transient_pvec_arg(value v, const std::string& where) {
+    return require_transient_arg(v, is_pvec(v) && v->pvec_data().transient, "pvec", where);
+}
+
 value require_pq_arg(value v, const std::string& where) {
     if (!is_pq(v)) {
         throw lisp_error(where + ": expected pq");
@@ -74,7 +122,7 @@ value require_pq_arg(value v, const std::string& where) {
 }
 
 value require_rng_arg(value v, const std::string& where) {
-    if (!is_rng(v) || !v->rng_data) {
+    if (!is_rng(v) || !v->rng_data()) {
         throw lisp_error(where + ": expected rng");
     }
     return v;
@@ -186,6 +234,18 @@ void write_text_file(const std::string& path, const std::string& text, const std
     }
 }
 
+// Streams write_value(v) into the file; use only for values that are known to be writable.
+void write_value_file(const std::string& path, value v, const std::string& where) {
+    std::ofstream out(path);
+    if (!out) {
+        throw lisp_error(where + ": failed to open file for write: " + path);
+    }
+    write_value(out, v);
+    if (!out) {
+        throw lisp_error(where + ": failed while writing file: " + path);
+    }
+}
+
 value events_dump_list(std::size_t max_count = 0) {
     const auto lines = bt::default_runtime_host().events().snapshot(max_count);
     std::vector<value> out;
@@ -218,7 +278,7 @@ double number_as_double(const numeric& n) {
     return n.is_int ? static_cast<double>(n.int_value) : n.float_value;
 }
 
-bool contains_float(const std::vector<value>& args) {
+bool contains_float(std::span<const value> args) {
     for (value arg : args) {
         if (is_float(arg)) {
             return true;
@@ -241,17 +301,9 @@ double require_pq_priority(value v, const std::string& where) {
     throw lisp_error(where + ": expected numeric priority");
 }
 
-bool pq_heap_compare(const pq_entry& lhs, const pq_entry& rhs) {
-    if (lhs.priority != rhs.priority) {
-        return lhs.priority > rhs.priority;
-    }
-    return lhs.sequence > rhs.sequence;
-}
-
-value pq_entry_to_pair(const pq_entry& entry) {
+value pq_entry_to_pair(double priority_value, value payload) {
     gc_root_scope roots(default_gc());
-    value priority = make_float(entry.priority);
-    value payload = entry.payload;
+    value priority = make_float(priority_value);
     roots.add(&priority);
     roots.add(&payload);
 
@@ -264,6 +316,28 @@ value pq_entry_to_pair(const pq_entry& entry) {
     return list_from_vector(pair);
 }
 
+std::uint32_t require_pq_handle(pq_payload& queue, value v, const std::string& where) {
+    const std::int64_t handle = require_int_arg(v, where);
+    if (handle < 0 || !queue.holds(static_cast<std::uint64_t>(handle))) {
+        throw lisp_error(where + ": handle is not in the queue");
+    }
+    return static_cast<std::uint32_t>(handle);
+}
+
+void require_pq_sequence_left(const pq_payload& queue, const std::string& where) {
+    if (queue.next_sequence == std::numeric_limits<std::uint64_t>::max()) {
+        throw lisp_error(where + ": insertion sequence overflow");
+    }
+}
+
+// Pops the entry at `slot` as a (priority value) list.
+value pq_take(value pq_obj, std::uint32_t slot) {
+    pq_payload& queue = pq_obj->pq_data();
+    const value payload = queue.slot_payloads[slot];
+    const pq_key key = queue.remove(slot);
+    return pq_entry_to_pair(key.priority, payload);
+}
+
 std::uint64_t splitmix64_next(std::uint64_t& state) {
     state += 0x9e3779b97f4a7c15ull;
     std::uint64_t z = state;
@@ -272,13 +346,43 @@ std::uint64_t splitmix64_next(std::uint64_t& state) {
     return z ^ (z >> 31u);
 }
 
-double rng_next_unit(value rng_obj) {
+double unit_from_bits(std::uint64_t bits) {
     // Use top 53 random bits for deterministic [0,1) doubles.
     constexpr double kScale = 1.0 / 9007199254740992.0;
-    const std::uint64_t bits = splitmix64_next(rng_obj->rng_data->state);
     return static_cast<double>(bits >> 11u) * kScale;
 }
 
+double rng_next_unit(value rng_obj) {
+    return unit_from_bits(splitmix64_next(rng_obj->rng_data()->state));
+}
+
+// Box-Muller pair from the next two draws.
+void rng_next_normal_pair(std::uint64_t& state, double& z0, double& z1) {
+    constexpr double kTwoPi = 6.28318530717958647692;
+    double u1 = unit_from_bits(splitmix64_next(state));
+    if (u1 <= 0.0) {
+        u1 = std::numeric_limits<double>::min();
+    }
+    const double u2 = unit_from_bits(splitmix64_next(state));
+
+    const double r = std::sqrt(-2.0 * std::log(u1));
+    const double theta = kTwoPi * u2;
+    z0 = r * std::cos(theta);
+    z1 = r * std::sin(theta);
+}
+
+// Resizes `vec_obj` to `n` items, each make_float(sample(i)).
+template <typename Sample>
+void fill_vec_with_floats(value vec_obj, std::size_t n, Sample&& sample) {
+    std::vector<value>& items = vec_obj->vec_data();
+    items.resize(n, make_nil());
+    gc& heap = default_gc();
+    for (std::size_t i = 0; i < n; ++i) {
+        items[i] = make_float(sample(i));
+        heap.write_barrier(vec_obj, items[i]);
+    }
+}
+
 bool checked_add(std::int64_t lhs, std::int64_t rhs, std::int64_t& out) {
 #if defined(__clang__) || defined(__GNUC__)
     return !__builtin_add_overflow(lhs, rhs, &out);
@@ -333,12 +437,16 @@ void bind_primitive(env_ptr global_env, const std::string& name, primitive_fn fn
     define(global_env, name, make_primitive(name, std::move(fn)));
 }
 
-value builtin_cons(const std::vector<value>& args) {
+void bind_primitive(env_ptr global_env, const std::string& name, primitive_span_fn fn) {
+    define(global_env, name, make_primitive(name, fn));
+}
+
+value builtin_cons(std::span<const value> args) {
     require_arity("cons", args, 2);
     return make_cons(args[0], args[1]);
 }
 
-value builtin_car(const std::vector<value>& args) {
+value builtin_car(std::span<const value> args) {
     require_arity("car", args, 1);
     if (!is_cons(args[0])) {
         throw lisp_error("car: expected cons");
@@ -346,7 +454,7 @@ value builtin_car(const std::vector<value>& args) {
     return car(args[0]);
 }
 
-value builtin_cdr(const std::vector<value>& args) {
+value builtin_cdr(std::span<const value> args) {
     require_arity("cdr", args, 1);
     if (!is_cons(args[0])) {
         throw lisp_error("cdr: expected cons");
@@ -354,21 +462,21 @@ value builtin_cdr(const std::vector<value>& args) {
     return cdr(args[0]);
 }
 
-value builtin_null(const std::vector<value>& args) {
+value builtin_null(std::span<const value> args) {
     require_arity("null?", args, 1);
     return make_boolean(is_nil(args[0]));
 }
 
-value builtin_eq(const std::vector<value>& args) {
+value builtin_eq(std::span<const value> args) {
     require_arity("eq?", args, 2);
     return make_boolean(eq_values(args[0], args[1]));
 }
 
-value builtin_list(const std::vector<value>& args) {
+value builtin_list(std::span<const value> args) {
     return list_from_vector(args);
 }
 
-value builtin_add(const std::vector<value>& args) {
+value builtin_add(std::span<const value> args) {
     if (args.empty()) {
         return make_integer(0);
     }
@@ -392,7 +500,7 @@ value builtin_add(const std::vector<value>& args) {
     return make_integer(sum);
 }
 
-value builtin_sub(const std::vector<value>& args) {
+value builtin_sub(std::span<const value> args) {
     require_min_arity("-", args, 1);
 
     const bool float_mode = contains_float(args);
@@ -425,7 +533,7 @@ value builtin_sub(const std::vector<value>& args) {
     return make_integer(result);
 }
 
-value builtin_mul(const std::vector<value>& args) {
+value builtin_mul(std::span<const value> args) {
     if (args.empty()) {
         return make_integer(1);
     }
@@ -449,7 +557,7 @@ value builtin_mul(const std::vector<value>& args) {
     return make_integer(result);
 }
 
-value builtin_div(const std::vector<value>& args) {
+value builtin_div(std::span<const value> args) {
     require_min_arity("/", args, 1);
 
     double result = number_as_double(as_numeric(args.front(), "/"));
@@ -464,7 +572,7 @@ value builtin_div(const std::vector<value>& args) {
     return make_float(result);
 }
 
-value builtin_num_eq(const std::vector<value>& args) {
+value builtin_num_eq(std::span<const value> args) {
     require_min_arity("=", args, 2);
 
     for (std::size_t i = 1; i < args.size(); ++i) {
@@ -485,7 +593,7 @@ value builtin_num_eq(const std::vector<value>& args) {
     return make_boolean(true);
 }
 
-value builtin_less(const std::vector<value>& args) {
+value builtin_less(std::span<const value> args) {
     require_min_arity("<", args, 2);
 
     for (std::size_t i = 1; i < args.size(); ++i) {
@@ -501,7 +609,7 @@ value builtin_less(const std::vector<value>& args) {
     return make_boolean(true);
 }
 
-value builtin_greater(const std::vector<value>& args) {
+value builtin_greater(std::span<const value> args) {
     require_min_arity(">", args, 2);
 
     for (std::size_t i = 1; i < args.size(); ++i) {
@@ -517,7 +625,7 @@ value builtin_greater(const std::vector<value>& args) {
     return make_boolean(true);
 }
 
-value builtin_less_equal(const std::vector<value>& args) {
+value builtin_less_equal(std::span<const value> args) {
     require_min_arity("<=", args, 2);
 
     for (std::size_t i = 1; i < args.size(); ++i) {
@@ -533,7 +641,7 @@ value builtin_less_equal(const std::vector<value>& args) {
     return make_boolean(true);
 }
 
-value builtin_greater_equal(const std::vector<value>& args) {
+value builtin_greater_equal(std::span<const value> args) {
     require_min_arity(">=", args, 2);
 
     for (std::size_t i = 1; i < args.size(); ++i) {
@@ -549,22 +657,22 @@ value builtin_greater_equal(const std::vector<value>& args) {
     return make_boolean(true);
 }
 
-value builtin_number_pred(const std::vector<value>& args) {
+value builtin_number_pred(std::span<const value> args) {
     require_arity("number?", args, 1);
     return make_boolean(is_number(args[0]));
 }
 
-value builtin_integer_pred(const std::vector<value>& args) {
+value builtin_integer_pred(std::span<const value> args) {
     require_arity("integer?", args, 1);
     return make_boolean(is_integer(args[0]));
 }
 
-value builtin_float_pred(const std::vector<value>& args) {
+value builtin_float_pred(std::span<const value> args) {
     require_arity("float?", args, 1);
     return make_boolean(is_float(args[0]));
 }
 
-value builtin_zero_pred(const std::vector<value>& args) {
+value builtin_zero_pred(std::span<const value> args) {
     require_arity("zero?", args, 1);
     if (is_integer(args[0])) {
         return make_boolean(integer_value(args[0]) == 0);
@@ -696,7 +804,7 @@ value builtin_rng_int(const std::vector<value>& args) {
     const std::uint64_t bound = static_cast<std::uint64_t>(n);
     const std::uint64_t threshold = static_cast<std::uint64_t>(-bound) % bound;
     while (true) {
-        const std::uint64_t r = splitmix64_next(rng_obj->rng_data->state);
+        const std::uint64_t r = splitmix64_next(rng_obj->rng_data()->state);
         if (r >= threshold) {
             return make_integer(static_cast<std::int64_t>(r % bound));
         }
@@ -715,25 +823,106 @@ value builtin_rng_normal(const std::vector<value>& args) {
         return make_float(mu);
     }
 
-    if (rng_obj->rng_data->has_spare_normal) {
-        rng_obj->rng_data->has_spare_normal = false;
-        return make_float(mu + sigma * rng_obj->rng_data->spare_normal);
+    if (rng_obj->rng_data()->has_spare_normal) {
+        rng_obj->rng_data()->has_spare_normal = false;
+        return make_float(mu + sigma * rng_obj->rng_data()->spare_normal);
     }
 
-    constexpr double kTwoPi = 6.28318530717958647692;
-    double u1 = rng_next_unit(rng_obj);
-    if (u1 <= 0.0) {
-        u1 = std::numeric_limits<double>::min();
+    double z0 = 0.0;
+    double z1 = 0.0;
+    rng_next_normal_pair(rng_obj->rng_data()->state, z0, z1);
+    rng_obj->rng_data()->spare_normal = z1;
+    rng_obj->rng_data()->has_spare_normal = true;
+    return make_float(mu + sigma * z0);
+}
+
+// The bulk fills below draw exactly what `n` calls of the scalar builtin would, in the same order, so a
+// seeded rng gives the same samples either way; they only skip the per-call argument checks and dispatch.
+
+value builtin_rng_fill_uniform(const std::vector<value>& args) {
+    require_arity("rng.fill-uniform!", args, 5);
+    value rng_obj = require_rng_arg(args[0], "rng.fill-uniform!");
+    value vec_obj = require_vec_arg(args[1], "rng.fill-uniform!");
+    const std::size_t n = require_non_negative_capacity(args[2], "rng.fill-uniform!");
+    const double lo = number_as_double(as_numeric(args[3], "rng.fill-uniform!"));
+    const double hi = number_as_double(as_numeric(args[4], "rng.fill-uniform!"));
+    if (lo > hi) {
+        throw lisp_error("rng.fill-uniform!: expected lo <= hi");
+    }
+    if (lo == hi) {
+        fill_vec_with_floats(vec_obj, n, [lo](std::size_t) { return lo; });
+        return vec_obj;
+    }
+
+    // splitmix64 is counter-based: draw i depends only on the starting state, so the loop carries no
+    // dependency between samples.
+    constexpr std::uint64_t kGamma = 0x9e3779b97f4a7c15ull;
+    std::uint64_t& state = rng_obj->rng_data()->state;
+    const std::uint64_t start = state;
+    fill_vec_with_floats(vec_obj, n, [start, lo, hi](std::size_t i) {
+        std::uint64_t counter = start + kGamma * static_cast<std::uint64_t>(i);
+        return lo + (hi - lo) * unit_from_bits(splitmix64_next(counter));
+    });
+    state = start + kGamma * static_cast<std::uint64_t>(n);
+    return vec_obj;
+}
+
+value builtin_rng_fill_normal(const std::vector<value>& args) {
+    require_arity("rng.fill-normal!", args, 5);
+    value rng_obj = require_rng_arg(args[0], "rng.fill-normal!");
+    value vec_obj = require_vec_arg(args[1], "rng.fill-normal!");
+    const std::size_t n = require_non_negative_capacity(args[2], "rng.fill-normal!");
+    const double mu = number_as_double(as_numeric(args[3], "rng.fill-normal!"));
+    const double sigma = number_as_double(as_numeric(args[4], "rng.fill-normal!"));
+    if (sigma < 0.0) {
+        throw lisp_error("rng.fill-normal!: expected sigma >= 0");
+    }
+    if (sigma == 0.0) {
+        fill_vec_with_floats(vec_obj, n, [mu](std::size_t) { return mu; });
+        return vec_obj;
     }
-    const double u2 = rng_next_unit(rng_obj);
 
-    const double r = std::sqrt(-2.0 * std::log(u1));
-    const double theta = kTwoPi * u2;
-    const double z0 = r * std::cos(theta);
-    const double z1 = r * std::sin(theta);
-    rng_obj->rng_data->spare_normal = z1;
-    rng_obj->rng_data->has_spare_normal = true;
-    return make_float(mu + sigma * z0);
+    rng_state& rng = *rng_obj->rng_data();
+    fill_vec_with_floats(vec_obj, n, [&rng, mu, sigma](std::size_t) {
+        if (rng.has_spare_normal) {
+            rng.has_spare_normal = false;
+            return mu + sigma * rng.spare_normal;
+        }
+        double z0 = 0.0;
+        double z1 = 0.0;
+        rng_next_normal_pair(rng.state, z0, z1);
+        rng.spare_normal = z1;
+        rng.has_spare_normal = true;
+        return mu + sigma * z0;
+    });
+    return vec_obj;
+}
+
+value builtin_rng_fill_int(const std::vector<value>& args) {
+    require_arity("rng.fill-int!", args, 4);
+    value rng_obj = require_rng_arg(args[0], "rng.fill-int!");
+    value vec_obj = require_vec_arg(args[1], "rng.fill-int!");
+    const std::size_t n = require_non_negative_capacity(args[2], "rng.fill-int!");
+    const std::int64_t bound_arg = require_int_arg(args[3], "rng.fill-int!");
+    if (bound_arg <= 0) {
+        throw lisp_error("rng.fill-int!: expected n > 0");
+    }
+
+    const std::uint64_t bound = static_cast<std::uint64_t>(bound_arg);
+    const std::uint64_t threshold = static_cast<std::uint64_t>(-bound) % bound;
+    std::uint64_t& state = rng_obj->rng_data()->state;
+    std::vector<value>& items = vec_obj->vec_data();
+    items.resize(n, make_nil());
+    gc& heap = default_gc();
+    for (value& item : items) {
+        std::uint64_t r = splitmix64_next(state);
+        while (r < threshold) {
+            r = splitmix64_next(state);
+        }
+        item = make_integer(static_cast<std::int64_t>(r % bound));
+        heap.write_barrier(vec_obj, item);
+    }
+    return vec_obj;
 }
 
 value builtin_vec_make(const std::vector<value>& args) {
@@ -750,46 +939,48 @@ value builtin_vec_make(const std::vector<value>& args) {
 value builtin_vec_len(const std::vector<value>& args) {
     require_arity("vec.len", args, 1);
     value vec_obj = require_vec_arg(args[0], "vec.len");
-    return make_integer(to_int64_size(vec_obj->vec_data.size(), "vec.len"));
+    return make_integer(to_int64_size(vec_obj->vec_data().size(), "vec.len"));
 }
 
 value builtin_vec_get(const std::vector<value>& args) {
     require_arity("vec.get", args, 2);
     value vec_obj = require_vec_arg(args[0], "vec.get");
-    const std::size_t index = require_non_negative_index(args[1], vec_obj->vec_data.size(), "vec.get");
-    return vec_obj->vec_data[index];
+    const std::size_t index = require_non_negative_index(args[1], vec_obj->vec_data().size(), "vec.get");
+    return vec_obj->vec_data()[index];
 }
 
 value builtin_vec_set(const std::vector<value>& args) {
     require_arity("vec.set!", args, 3);
     value vec_obj = require_vec_arg(args[0], "vec.set!");
-    const std::size_t index = require_non_negative_index(args[1], vec_obj->vec_data.size(), "vec.set!");
-    vec_obj->vec_data[index] = args[2];
+    const std::size_t index = require_non_negative_index(args[1], vec_obj->vec_data().size(), "vec.set!");
+    vec_obj->vec_data()[index] = args[2];
+    default_gc().write_barrier(vec_obj, args[2]);
     return args[2];
 }
 
 value builtin_vec_push(const std::vector<value>& args) {
     require_arity("vec.push!", args, 2);
     value vec_obj = require_vec_arg(args[0], "vec.push!");
-    vec_obj->vec_data.push_back(args[1]);
-    return make_integer(to_int64_size(vec_obj->vec_data.size() - 1, "vec.push!"));
+    vec_obj->vec_data().push_back(args[1]);
+    default_gc().write_barrier(vec_obj, args[1]);
+    return make_integer(to_int64_size(vec_obj->vec_data().size() - 1, "vec.push!"));
 }
 
 value builtin_vec_pop(const std::vector<value>& args) {
     require_arity("vec.pop!", args, 1);
     value vec_obj = require_vec_arg(args[0], "vec.pop!");
-    if (vec_obj->vec_data.empty()) {
+    if (vec_obj->vec_data().empty()) {
         throw lisp_error("vec.pop!: vector is empty");
     }
-    value out = vec_obj->vec_data.back();
-    vec_obj->vec_data.pop_back();
+    value out = vec_obj->vec_data().back();
+    vec_obj->vec_data().pop_back();
     return out;
 }
 
 value builtin_vec_clear(const std::vector<value>& args) {
     require_arity("vec.clear!", args, 1);
     value vec_obj = require_vec_arg(args[0], "vec.clear!");
-    vec_obj->vec_data.clear();
+    vec_obj->vec_data().clear();
     return make_nil();
 }
 
@@ -797,10 +988,230 @@ value builtin_vec_reserve(const std::vector<value>& args) {
     require_arity("vec.reserve!", args, 2);
     value vec_obj = require_vec_arg(args[0], "vec.reserve!");
     const std::size_t capacity = require_non_negative_capacity(args[1], "vec.reserve!");
-    vec_obj->vec_data.reserve(capacity);
+    vec_obj->vec_data().reserve(capacity);
     return make_nil();
 }
 
+double require_number_value(value v, const std::string& where);
+value numeric_vector_to_lisp_list(std::span<const double> values);
+
+// The f64vec loops below are written so the compiler can vectorise them without -ffast-math:
+// elementwise loops are plain indexed loops over the raw storage, and reductions keep four
+// independent accumulators instead of one serial floating-point chain.
+constexpr std::size_t k_f64vec_lanes = 4;
+
+double f64vec_dot(const double* a, const double* b, std::size_t n) {
+    double lanes[k_f64vec_lanes] = {0.0, 0.0, 0.0, 0.0};
+    std::size_t i = 0;
+    for (; i + k_f64vec_lanes <= n; i += k_f64vec_lanes) {
+        for (std::size_t lane = 0; lane < k_f64vec_lanes; ++lane) {
+            lanes[lane] += a[i + lane] * b[i + lane];
+        }
+    }
+    for (; i < n; ++i) {
+        lanes[0] += a[i] * b[i];
+    }
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+template <typename Pick>
+double f64vec_reduce(const double* a, std::size_t n, Pick pick) {
+    double lanes[k_f64vec_lanes] = {a[0], a[0], a[0], a[0]};
+    std::size_t i = 0;
+    for (; i + k_f64vec_lanes <= n; i += k_f64vec_lanes) {
+        for (std::size_t lane = 0; lane < k_f64vec_lanes; ++lane) {
+            lanes[lane] = pick(lanes[lane], a[i + lane]);
+        }
+    }
+    for (; i < n; ++i) {
+        lanes[0] = pick(lanes[0], a[i]);
+    }
+    return pick(pick(lanes[0], lanes[1]), pick(lanes[2], lanes[3]));
+}
+
+std::size_t require_same_length(value a, value b, const std::string& where) {
+    const std::size_t n = a->f64vec_data().size();
+    if (b->f64vec_data().size() != n) {
+        throw lisp_error(where + ": length mismatch (" + std::to_string(n) + " vs " +
+                         std::to_string(b->f64vec_data().size()) + ")");
+    }
+    return n;
+}
+
+// Returns the optional destination argument at `index`, or a fresh f64vec of length `n`. The
+// destination may be one of the inputs.
+value f64vec_destination(const std::vector<value>& args, std::size_t index, std::size_t n, const std::string& where) {
+    if (args.size() <= index) {
+        return make_f64vec(n);
+    }
+    value out = require_f64vec_arg(args[index], where);
+    if (out->f64vec_data().size() != n) {
+        throw lisp_error(where + ": destination length mismatch");
+    }
+    return out;
+}
+
+void require_non_empty_f64vec(value v, const std::string& where) {
+    if (v->f64vec_data().empty()) {
+        throw lisp_error(where + ": f64vec is empty");
+    }
+}
+
+value builtin_f64vec_make(const std::vector<value>& args) {
+    if (args.size() != 1 && args.size() != 2) {
+        throw lisp_error("f64vec.make: expected 1 or 2 arguments");
+    }
+    const std::size_t length = require_non_negative_capacity(args[0], "f64vec.make");
+    const double fill = args.size() == 2 ? require_number_value(args[1], "f64vec.make") : 0.0;
+    return make_f64vec(length, fill);
+}
+
+value builtin_f64vec_from(const std::vector<value>& args) {
+    require_arity("f64vec.from", args, 1);
+    value source = args[0];
+    if (is_f64vec(source)) {
+        return make_f64vec(std::span<const double>(source->f64vec_data()));
+    }
+    if (is_vec(source)) {
+        const std::vector<value>& items = source->vec_data();
+        value out = make_f64vec(items.size());
+        f64_storage& data = out->f64vec_data();
+        for (std::size_t i = 0; i < items.size(); ++i) {
+            data[i] = require_number_value(items[i], "f64vec.from");
+        }
+        return out;
+    }
+    if (!is_proper_list(source)) {
+        throw lisp_error("f64vec.from: expected list, vec or f64vec");
+    }
+    std::size_t length = 0;
+    for (value cursor = source; !is_nil(cursor); cursor = cdr(cursor)) {
+        ++length;
+    }
+    value out = make_f64vec(length);
+    double* data = out->f64vec_data().data();
+    for (value cursor = source; !is_nil(cursor); cursor = cdr(cursor)) {
+        *data++ = require_number_value(car(cursor), "f64vec.from");
+    }
+    return out;
+}
+
+value builtin_f64vec_to_list(const std::vector<value>& args) {
+    require_arity("f64vec.to-list", args, 1);
+    value vec_obj = require_f64vec_arg(args[0], "f64vec.to-list");
+    return numeric_vector_to_lisp_list(vec_obj->f64vec_data());
+}
+
+value builtin_f64vec_len(const std::vector<value>& args) {
+    require_arity("f64vec.len", args, 1);
+    value vec_obj = require_f64vec_arg(args[0], "f64vec.len");
+    return make_integer(to_int64_size(vec_obj->f64vec_data().size(), "f64vec.len"));
+}
+
+value builtin_f64vec_get(const std::vector<value>& args) {
+    require_arity("f64vec.get", args, 2);
+    value vec_obj = require_f64vec_arg(args[0], "f64vec.get");
+    const std::size_t index = require_non_negative_index(args[1], vec_obj->f64vec_data().size(), "f64vec.get");
+    return make_float(vec_obj->f64vec_data()[index]);
+}
+
+value builtin_f64vec_set(const std::vector<value>& args) {
+    require_arity("f64vec.set!", args, 3);
+    value vec_obj = require_f64vec_arg(args[0], "f64vec.set!");
+    const std::size_t index = require_non_negative_index(args[1], vec_obj->f64vec_data().size(), "f64vec.set!");
+    vec_obj->f64vec_data()[index] = require_number_value(args[2], "f64vec.set!");
+    return args[2];
+}
+
+template <typename Op>
+value f64vec_elementwise(const std::vector<value>& args, const std::string& where, Op op) {
+    if (args.size() != 2 && args.size() != 3) {
+        throw lisp_error(where + ": expected 2 or 3 arguments");
+    }
+    value a_obj = require_f64vec_arg(args[0], where);
+    value b_obj = require_f64vec_arg(args[1], where);
+    const std::size_t n = require_same_length(a_obj, b_obj, where);
+    value out_obj = f64vec_destination(args, 2, n, where);
+    const double* a = a_obj->f64vec_data().data();
+    const double* b = b_obj->f64vec_data().data();
+    double* out = out_obj->f64vec_data().data();
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = op(a[i], b[i]);
+    }
+    return out_obj;
+}
+
+value builtin_f64vec_add(const std::vector<value>& args) {
+    return f64vec_elementwise(args, "f64vec.add", [](double a, double b) { return a + b; });
+}
+
+value builtin_f64vec_mul(const std::vector<value>& args) {
+    return f64vec_elementwise(args, "f64vec.mul", [](double a, double b) { return a * b; });
+}
+
+value builtin_f64vec_scale(const std::vector<value>& args) {
+    if (args.size() != 2 && args.size() != 3) {
+        throw lisp_error("f64vec.scale: expected 2 or 3 arguments");
+    }
+    value a_obj = require_f64vec_arg(args[0], "f64vec.scale");
+    const double k = require_number_value(args[1], "f64vec.scale");
+    const std::size_t n = a_obj->f64vec_data().size();
+    value out_obj = f64vec_destination(args, 2, n, "f64vec.scale");
+    const double* a = a_obj->f64vec_data().data();
+    double* out = out_obj->f64vec_data().data();
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = a[i] * k;
+    }
+    return out_obj;
+}
+
+value builtin_f64vec_dot(const std::vector<value>& args) {
+    require_arity("f64vec.dot", args, 2);
+    value a_obj = require_f64vec_arg(args[0], "f64vec.dot");
+    value b_obj = require_f64vec_arg(args[1], "f64vec.dot");
+    const std::size_t n = require_same_length(a_obj, b_obj, "f64vec.dot");
+    return make_float(f64vec_dot(a_obj->f64vec_data().data(), b_obj->f64vec_data().data(), n));
+}
+
+value builtin_f64vec_norm(const std::vector<value>& args) {
+    require_arity("f64vec.norm", args, 1);
+    value a_obj = require_f64vec_arg(args[0], "f64vec.norm");
+    const double* a = a_obj->f64vec_data().data();
+    return make_float(std::sqrt(f64vec_dot(a, a, a_obj->f64vec_data().size())));
+}
+
+value builtin_f64vec_min(const std::vector<value>& args) {
+    require_arity("f64vec.min", args, 1);
+    value a_obj = require_f64vec_arg(args[0], "f64vec.min");
+    require_non_empty_f64vec(a_obj, "f64vec.min");
+    return make_float(f64vec_reduce(a_obj->f64vec_data().data(), a_obj->f64vec_data().size(), [](double m, double x) {
+        return x < m ? x : m;
+    }));
+}
+
+value builtin_f64vec_max(const std::vector<value>& args) {
+    require_arity("f64vec.max", args, 1);
+    value a_obj = require_f64vec_arg(args[0], "f64vec.max");
+    require_non_empty_f64vec(a_obj, "f64vec.max");
+    return make_float(f64vec_reduce(a_obj->f64vec_data().data(), a_obj->f64vec_data().size(), [](double m, double x) {
+        return x > m ? x : m;
+    }));
+}
+
+value builtin_f64vec_argmax(const std::vector<value>& args) {
+    require_arity("f64vec.argmax", args, 1);
+    value a_obj = require_f64vec_arg(args[0], "f64vec.argmax");
+    require_non_empty_f64vec(a_obj, "f64vec.argmax");
+    // Find the maximum with the vectorised reduction, then scan once for its first position.
+    const f64_storage& data = a_obj->f64vec_data();
+    const double best = f64vec_reduce(data.data(), data.size(), [](double m, double x) { return x > m ? x : m; });
+    std::size_t index = 0;
+    while (index + 1 < data.size() && data[index] != best) {
+        ++index;
+    }
+    return make_integer(to_int64_size(index, "f64vec.argmax"));
+}
+
 value builtin_map_make(const std::vector<value>& args) {
     require_arity("map.make", args, 0);
     return make_map();
@@ -810,8 +1221,8 @@ value builtin_map_get(const std::vector<value>& args) {
     require_arity("map.get", args, 3);
     value map_obj = require_map_arg(args[0], "map.get");
     const map_key key = map_key_from_value(args[1], "map.get");
-    const auto it = map_obj->map_data.find(key);
-    if (it == map_obj->map_data.end()) {
+    const auto it = map_obj->map_data().find(key);
+    if (it == map_obj->map_data().end()) {
         return args[2];
     }
     return it->second;
@@ -821,14 +1232,15 @@ value builtin_map_has(const std::vector<value>& args) {
     require_arity("map.has?", args, 2);
     value map_obj = require_map_arg(args[0], "map.has?");
     const map_key key = map_key_from_value(args[1], "map.has?");
-    return make_boolean(map_obj->map_data.find(key) != map_obj->map_data.end());
+    return make_boolean(map_obj->map_data().find(key) != map_obj->map_data().end());
 }
 
 value builtin_map_set(const std::vector<value>& args) {
     require_arity("map.set!", args, 3);
     value map_obj = require_map_arg(args[0], "map.set!");
     const map_key key = map_key_from_value(args[1], "map.set!");
-    map_obj->map_data[key] = args[2];
+    map_obj->map_data()[key] = args[2];
+    default_gc().write_barrier(map_obj, args[2]);
     return args[2];
 }
 
@@ -836,22 +1248,183 @@ value builtin_map_del(const std::vector<value>& args) {
     require_arity("map.del!", args, 2);
     value map_obj = require_map_arg(args[0], "map.del!");
     const map_key key = map_key_from_value(args[1], "map.del!");
-    return make_boolean(map_obj->map_data.erase(key) > 0);
+    return make_boolean(map_obj->map_data().erase(key) > 0);
 }
 
 value builtin_map_keys(const std::vector<value>& args) {
     require_arity("map.keys", args, 1);
     value map_obj = require_map_arg(args[0], "map.keys");
     std::vector<value> keys;
-    keys.reserve(map_obj->map_data.size());
+    keys.reserve(map_obj->map_data().size());
     gc_root_scope roots(default_gc());
-    for (const auto& [key, _] : map_obj->map_data) {
+    for (const auto& [key, _] : map_obj->map_data()) {
         keys.push_back(map_key_to_value(key));
         roots.add(&keys.back());
     }
     return list_from_vector(keys);
 }
 
+value builtin_pmap_make(const std::vector<value>& args) {
+    require_arity("pmap.make", args, 0);
+    return make_pmap();
+}
+
+value builtin_pmap_count(const std::vector<value>& args) {
+    require_arity("pmap.count", args, 1);
+    return make_integer(to_int64_size(pmap_count(require_pmap_arg(args[0], "pmap.count")), "pmap.count"));
+}
+
+value builtin_pmap_get(const std::vector<value>& args) {
+    require_arity("pmap.get", args, 3);
+    value pmap_obj = require_pmap_arg(args[0], "pmap.get");
+    const value* found = pmap_find(pmap_obj, map_key_from_value(args[1], "pmap.get"));
+    return found ? *found : args[2];
+}
+
+value builtin_pmap_has(const std::vector<value>& args) {
+    require_arity("pmap.has?", args, 2);
+    value pmap_obj = require_pmap_arg(args[0], "pmap.has?");
+    return make_boolean(pmap_find(pmap_obj, map_key_from_value(args[1], "pmap.has?")) != nullptr);
+}
+
+value builtin_pmap_set(const std::vector<value>& args) {
+    require_arity("pmap.set", args, 3);
+    value pmap_obj = require_pmap_arg(args[0], "pmap.set");
+    return pmap_assoc(pmap_obj, map_key_from_value(args[1], "pmap.set"), args[2]);
+}
+
+value builtin_pmap_del(const std::vector<value>& args) {
+    require_arity("pmap.del", args, 2);
+    value pmap_obj = require_pmap_arg(args[0], "pmap.del");
+    return pmap_dissoc(pmap_obj, map_key_from_value(args[1], "pmap.del"));
+}
+
+value builtin_pmap_keys(const std::vector<value>& args) {
+    require_arity("pmap.keys", args, 1);
+    value pmap_obj = require_pmap_arg(args[0], "pmap.keys");
+    std::vector<value> keys;
+    keys.reserve(pmap_count(pmap_obj));
+    pmap_for_each(pmap_obj, [&keys](const map_key& key, value) { keys.push_back(map_key_to_value(key)); });
+    return list_from_vector(keys);
+}
+
+value builtin_pmap_from_map(const std::vector<value>& args) {
+    require_arity("pmap.from-map", args, 1);
+    value map_obj = require_map_arg(args[0], "pmap.from-map");
+    value out = pmap_transient(make_pmap());
+    for (const auto& [key, mapped] : map_obj->map_data()) {
+        pmap_assoc_in_place(out, key, mapped);
+    }
+    return pmap_persistent(out);
+}
+
+value builtin_pmap_transient(const std::vector<value>& args) {
+    require_arity("pmap.transient", args, 1);
+    return pmap_transient(require_pmap_arg(args[0], "pmap.transient"));
+}
+
+value builtin_pmap_set_bang(const std::vector<value>& args) {
+    require_arity("pmap.set!", args, 3);
+    value transient = require_transient_pmap_arg(args[0], "pmap.set!");
+    pmap_assoc_in_place(transient, map_key_from_value(args[1], "pmap.set!"), args[2]);
+    return args[2];
+}
+
+value builtin_pmap_del_bang(const std::vector<value>& args) {
+    require_arity("pmap.del!", args, 2);
+    value transient = require_transient_pmap_arg(args[0], "pmap.del!");
+    return make_boolean(pmap_dissoc_in_place(transient, map_key_from_value(args[1], "pmap.del!")));
+}
+
+value builtin_pmap_persistent(const std::vector<value>& args) {
+    require_arity("pmap.persistent!", args, 1);
+    return pmap_persistent(require_transient_pmap_arg(args[0], "pmap.persistent!"));
+}
+
+value builtin_pvec_make(const std::vector<value>& args) {
+    require_arity("pvec.make", args, 0);
+    return make_pvec();
+}
+
+value builtin_pvec_len(const std::vector<value>& args) {
+    require_arity("pvec.len", args, 1);
+    return make_integer(to_int64_size(pvec_count(require_pvec_arg(args[0], "pvec.len")), "pvec.len"));
+}
+
+value builtin_pvec_get(const std::vector<value>& args) {
+    require_arity("pvec.get", args, 2);
+    value pvec_obj = require_pvec_arg(args[0], "pvec.get");
+    return pvec_get(pvec_obj, require_non_negative_index(args[1], pvec_count(pvec_obj), "pvec.get"));
+}
+
+value builtin_pvec_set(const std::vector<value>& args) {
+    require_arity("pvec.set", args, 3);
+    value pvec_obj = require_pvec_arg(args[0], "pvec.set");
+    return pvec_assoc(pvec_obj, require_non_negative_index(args[1], pvec_count(pvec_obj), "pvec.set"), args[2]);
+}
+
+value builtin_pvec_push(const std::vector<value>& args) {
+    require_arity("pvec.push", args, 2);
+    return pvec_conj(require_pvec_arg(args[0], "pvec.push"), args[1]);
+}
+
+value builtin_pvec_pop(const std::vector<value>& args) {
+    require_arity("pvec.pop", args, 1);
+    value pvec_obj = require_pvec_arg(args[0], "pvec.pop");
+    if (pvec_count(pvec_obj) == 0) {
+        throw lisp_error("pvec.pop: vector is empty");
+    }
+    return pvec_pop(pvec_obj);
+}
+
+value builtin_pvec_from_list(const std::vector<value>& args) {
+    require_arity("pvec.from-list", args, 1);
+    if (!is_proper_list(args[0])) {
+        throw lisp_error("pvec.from-list: expected proper list");
+    }
+    value out = pvec_transient(make_pvec());
+    for (value cursor = args[0]; !is_nil(cursor); cursor = cdr(cursor)) {
+        pvec_conj_in_place(out, car(cursor));
+    }
+    return pvec_persistent(out);
+}
+
+value builtin_pvec_transient(const std::vector<value>& args) {
+    require_arity("pvec.transient", args, 1);
+    return pvec_transient(require_pvec_arg(args[0], "pvec.transient"));
+}
+
+value builtin_pvec_set_bang(const std::vector<value>& args) {
+    require_arity("pvec.set!", args, 3);
+    value transient = require_transient_pvec_arg(args[0], "pvec.set!");
+    pvec_assoc_in_place(transient, require_non_negative_index(args[1], pvec_count(transient), "pvec.set!"), args[2]);
+    return args[2];
+}
+
+value builtin_pvec_push_bang(const std::vector<value>& args) {
+    require_arity("pvec.push!", args, 2);
+    value transient = require_transient_pvec_arg(args[0], "pvec.push!");
+    pvec_conj_in_place(transient, args[1]);
+    return make_integer(to_int64_size(pvec_count(transient) - 1, "pvec.push!"));
+}
+
+value builtin_pvec_pop_bang(const std::vector<value>& args) {
+    require_arity("pvec.pop!", args, 1);
+    value transient = require_transient_pvec_arg(args[0], "pvec.pop!");
+    const std::size_t count = pvec_count(transient);
+    if (count == 0) {
+        throw lisp_error("pvec.pop!: vector is empty");
+    }
+    value out = pvec_get(transient, count - 1);
+    pvec_pop_in_place(transient);
+    return out;
+}
+
+value builtin_pvec_persistent(const std::vector<value>& args) {
+    require_arity("pvec.persistent!", args, 1);
+    return pvec_persistent(require_transient_pvec_arg(args[0], "pvec.persistent!"));
+}
+
 value builtin_pq_make(const std::vector<value>& args) {
     if (args.size() > 1) {
         throw lisp_error("pq.make: expected 0 or 1 arguments");
@@ -866,51 +1439,93 @@ value builtin_pq_make(const std::vector<value>& args) {
 value builtin_pq_len(const std::vector<value>& args) {
     require_arity("pq.len", args, 1);
     value pq_obj = require_pq_arg(args[0], "pq.len");
-    return make_integer(to_int64_size(pq_obj->pq_data.size(), "pq.len"));
+    return make_integer(to_int64_size(pq_obj->pq_data().size(), "pq.len"));
 }
 
 value builtin_pq_empty(const std::vector<value>& args) {
     require_arity("pq.empty?", args, 1);
     value pq_obj = require_pq_arg(args[0], "pq.empty?");
-    return make_boolean(pq_obj->pq_data.empty());
+    return make_boolean(pq_obj->pq_data().size() == 0);
 }
 
 value builtin_pq_push(const std::vector<value>& args) {
     require_arity("pq.push!", args, 3);
     value pq_obj = require_pq_arg(args[0], "pq.push!");
     const double priority = require_pq_priority(args[1], "pq.push!");
-    if (pq_obj->pq_next_sequence == std::numeric_limits<std::uint64_t>::max()) {
-        throw lisp_error("pq.push!: insertion sequence overflow");
-    }
+    pq_payload& queue = pq_obj->pq_data();
+    require_pq_sequence_left(queue, "pq.push!");
+    (void)queue.insert(priority, args[2]);
+    default_gc().write_barrier(pq_obj, args[2]);
+    return make_integer(to_int64_size(queue.size(), "pq.push!"));
+}
+
+value builtin_pq_insert(const std::vector<value>& args) {
+    require_arity("pq.insert!", args, 3);
+    value pq_obj = require_pq_arg(args[0], "pq.insert!");
+    const double priority = require_pq_priority(args[1], "pq.insert!");
+    pq_payload& queue = pq_obj->pq_data();
+    require_pq_sequence_left(queue, "pq.insert!");
+    const std::uint32_t slot = queue.insert(priority, args[2]);
+    default_gc().write_barrier(pq_obj, args[2]);
+    return make_integer(slot);
+}
+
+value builtin_pq_update(const std::vector<value>& args) {
+    require_arity("pq.update!", args, 3);
+    value pq_obj = require_pq_arg(args[0], "pq.update!");
+    pq_payload& queue = pq_obj->pq_data();
+    const std::uint32_t slot = require_pq_handle(queue, args[1], "pq.update!");
+    queue.update(slot, require_pq_priority(args[2], "pq.update!"));
+    return make_nil();
+}
 
-    pq_entry entry;
-    entry.priority = priority;
-    entry.sequence = pq_obj->pq_next_sequence++;
-    entry.payload = args[2];
-    pq_obj->pq_data.push_back(entry);
-    std::push_heap(pq_obj->pq_data.begin(), pq_obj->pq_data.end(), pq_heap_compare);
-    return make_integer(to_int64_size(pq_obj->pq_data.size(), "pq.push!"));
+value builtin_pq_remove(const std::vector<value>& args) {
+    require_arity("pq.remove!", args, 2);
+    value pq_obj = require_pq_arg(args[0], "pq.remove!");
+    const std::uint32_t slot = require_pq_handle(pq_obj->pq_data(), args[1], "pq.remove!");
+    return pq_take(pq_obj, slot);
+}
+
+value builtin_pq_from_list(const std::vector<value>& args) {
+    require_arity("pq.from-list", args, 1);
+    if (!is_proper_list(args[0])) {
+        throw lisp_error("pq.from-list: expected list of (priority value) pairs");
+    }
+    const std::vector<value> entries = vector_from_list(args[0]);
+    value pq_obj = make_pq(entries.size());
+    pq_payload& queue = pq_obj->pq_data();
+    gc& heap = default_gc();
+    for (value entry : entries) {
+        if (!is_cons(entry) || !is_cons(cdr(entry)) || !is_nil(cdr(cdr(entry)))) {
+            throw lisp_error("pq.from-list: expected list of (priority value) pairs");
+        }
+        const double priority = require_pq_priority(car(entry), "pq.from-list");
+        const value payload = car(cdr(entry));
+        (void)queue.append_unordered(priority, queue.next_sequence++, payload);
+        heap.write_barrier(pq_obj, payload);
+    }
+    queue.heapify();
+    return pq_obj;
 }
 
 value builtin_pq_peek(const std::vector<value>& args) {
     require_arity("pq.peek", args, 1);
     value pq_obj = require_pq_arg(args[0], "pq.peek");
-    if (pq_obj->pq_data.empty()) {
+    const pq_payload& queue = pq_obj->pq_data();
+    if (queue.size() == 0) {
         throw lisp_error("pq.peek: priority queue is empty");
     }
-    return pq_entry_to_pair(pq_obj->pq_data.front());
+    const pq_key& top = queue.heap.front();
+    return pq_entry_to_pair(top.priority, queue.slot_payloads[top.slot]);
 }
 
 value builtin_pq_pop(const std::vector<value>& args) {
     require_arity("pq.pop!", args, 1);
     value pq_obj = require_pq_arg(args[0], "pq.pop!");
-    if (pq_obj->pq_data.empty()) {
+    if (pq_obj->pq_data().size() == 0) {
         throw lisp_error("pq.pop!: priority queue is empty");
     }
-    std::pop_heap(pq_obj->pq_data.begin(), pq_obj->pq_data.end(), pq_heap_compare);
-    const pq_entry out = pq_obj->pq_data.back();
-    pq_obj->pq_data.pop_back();
-    return pq_entry_to_pair(out);
+    return pq_take(pq_obj, pq_obj->pq_data().heap.front().slot);
 }
 
 void print_gc_snapshot(const gc_stats_snapshot& snapshot) {
@@ -922,6 +1537,13 @@ void print_gc_snapshot(const gc_stats_snapshot& snapshot) {
     std::cout << "total GC pause ns: " << snapshot.total_pause_ns << '\n';
     std::cout << "freed objects total: " << snapshot.freed_objects_total << '\n';
     std::cout << "forced collection count: " << snapshot.forced_collection_count << '\n';
+    std::cout << "minor collection count: " << snapshot.minor_collection_count << '\n';
+    std::cout << "young objects: " << snapshot.young_objects << '\n';
+    std::cout << "promoted objects total: " << snapshot.promoted_objects_total << '\n';
+    std::cout << "pool reserved bytes: " << snapshot.pool_reserved_bytes << '\n';
+    std::cout << "pool free cells: " << snapshot.pool_free_cells << '\n';
+    std::cout << "memory pressure: " << (snapshot.memory_pressure ? "yes" : "no") << '\n';
+    std::cout << "hard limit failures: " << snapshot.hard_limit_failures << '\n';
 }
 
 value builtin_heap_stats(const std::vector<value>& args) {
@@ -958,18 +1580,68 @@ value builtin_gc_set_policy(const std::vector<value>& args) {
     }
     gc_policy policy = gc_policy::default_policy;
     if (!gc::parse_policy(text, policy)) {
-        throw lisp_error("gc.set-policy!: expected :default, :between-ticks, :manual, or :fail-on-tick-gc");
+        throw lisp_error("gc.set-policy!: expected :default, :between-ticks, :manual, :fail-on-tick-gc, or :incremental");
     }
     default_gc().set_policy(policy);
     return gc_policy_to_lisp(policy);
 }
 
+std::optional<value> map_lookup_option(value map_obj, const std::string& normalized_key);
+void map_set_symbol(value map_obj, const std::string& key_name, value v);
+std::int64_t require_non_negative_int(value v, const std::string& where);
+
+value gc_limits_to_lisp(const gc_limits& limits) {
+    value out = make_map();
+    gc_root_scope roots(default_gc());
+    roots.add(&out);
+    const gc_stats_snapshot snapshot = default_gc().stats();
+    map_set_symbol(out, "soft_limit_bytes", make_integer(static_cast<std::int64_t>(limits.soft_limit_bytes)));
+    map_set_symbol(out, "hard_limit_bytes", make_integer(static_cast<std::int64_t>(limits.hard_limit_bytes)));
+    map_set_symbol(out, "growth_factor", make_float(limits.growth_factor));
+    map_set_symbol(out, "nursery_objects", make_integer(static_cast<std::int64_t>(limits.nursery_objects)));
+    map_set_symbol(out, "heap_live_bytes", make_integer(static_cast<std::int64_t>(snapshot.bytes_allocated)));
+    map_set_symbol(out, "memory_pressure", make_boolean(snapshot.memory_pressure));
+    map_set_symbol(out, "soft_limit_crossings", make_integer(static_cast<std::int64_t>(snapshot.soft_limit_crossings)));
+    map_set_symbol(out, "hard_limit_failures", make_integer(static_cast<std::int64_t>(snapshot.hard_limit_failures)));
+    return out;
+}
+
+value builtin_gc_limits(const std::vector<value>& args) {
+    require_arity("gc.limits", args, 0);
+    return gc_limits_to_lisp(default_gc().limits());
+}
+
+value builtin_gc_set_limits(const std::vector<value>& args) {
+    require_arity("gc.set-limits!", args, 1);
+    const value opts = require_map_arg(args[0], "gc.set-limits!");
+    // Keys that are absent keep their current setting.
+    gc_limits limits = default_gc().limits();
+    if (const auto soft = map_lookup_option(opts, "soft_limit_bytes")) {
+        limits.soft_limit_bytes = static_cast<std::size_t>(require_non_negative_int(*soft, "gc.set-limits! :soft_limit_bytes"));
+    }
+    if (const auto hard = map_lookup_option(opts, "hard_limit_bytes")) {
+        limits.hard_limit_bytes = static_cast<std::size_t>(require_non_negative_int(*hard, "gc.set-limits! :hard_limit_bytes"));
+    }
+    if (const auto factor = map_lookup_option(opts, "growth_factor")) {
+        limits.growth_factor = require_number_value(*factor, "gc.set-limits! :growth_factor");
+    }
+    if (const auto nursery = map_lookup_option(opts, "nursery_objects")) {
+        limits.nursery_objects = static_cast<std::size_t>(require_non_negative_int(*nursery, "gc.set-limits! :nursery_objects"));
+    }
+    try {
+        default_gc().set_limits(limits);
+    } catch (const std::invalid_argument& e) {
+        throw lisp_error(std::string("gc.set-limits!: ") + e.what());
+    }
+    return gc_limits_to_lisp(default_gc().limits());
+}
+
 value builtin_print(const std::vector<value>& args) {
     for (std::size_t i = 0; i < args.size(); ++i) {
         if (i > 0) {
             std::cout << ' ';
         }
-        std::cout << print_value(args[i]);
+        print_value(std::cout, args[i]);
     }
     std::cout << std::endl;
     return make_nil();
@@ -1021,7 +1693,7 @@ std::string require_bb_key(value v, const std::string& where) {
     throw lisp_error(where + ": expected key as symbol or string");
 }
 
-value numeric_vector_to_lisp_list(const std::vector<double>& values);
+value numeric_vector_to_lisp_list(std::span<const double> values);
 
 bt::bb_value to_bb_value(value v, const std::string& where) {
     if (is_nil(v)) {
@@ -1048,6 +1720,9 @@ bt::bb_value to_bb_value(value v, const std::string& where) {
     if (is_blob_handle(v)) {
         return bt::bb_value{bt::blob_handle_ref{.id = blob_handle_id(v)}};
     }
+    if (is_f64vec(v)) {
+        return bt::bb_value{bt::bb_vector(std::span<const double>(v->f64vec_data()))};
+    }
     if (is_proper_list(v)) {
         const std::vector<value> items = vector_from_list(v);
         std::vector<double> out;
@@ -1079,8 +1754,8 @@ value bb_value_to_lisp_value(const bt::bb_value& v) {
     if (const auto* s = std::get_if<std::string>(&v)) {
         return make_string(*s);
     }
-    if (const auto* vec = std::get_if<std::vector<double>>(&v)) {
-        return numeric_vector_to_lisp_list(*vec);
+    if (const auto* vec = std::get_if<bt::bb_vector>(&v)) {
+        return numeric_vector_to_lisp_list(vec->view());
     }
     if (const auto* image = std::get_if<bt::image_handle_ref>(&v)) {
         return make_image_handle(image->id);
@@ -1130,7 +1805,7 @@ std::string normalize_option_key(std::string key) {
 }
 
 std::optional<value> map_lookup_option(value map_obj, const std::string& normalized_key) {
-    for (const auto& [key, val] : map_obj->map_data) {
+    for (const auto& [key, val] : map_obj->map_data()) {
         if (key.type != map_key_type::symbol && key.type != map_key_type::string) {
             continue;
         }
@@ -1155,6 +1830,9 @@ std::vector<double> lisp_to_numeric_vector(value v, const std::string& where) {
     if (is_integer(v) || is_float(v)) {
         return {require_number_value(v, where)};
     }
+    if (is_f64vec(v)) {
+        return std::vector<double>(v->f64vec_data().begin(), v->f64vec_data().end());
+    }
     if (!is_proper_list(v)) {
         throw lisp_error(where + ": expected numeric list or number");
     }
@@ -1167,7 +1845,15 @@ std::vector<double> lisp_to_numeric_vector(value v, const std::string& where) {
     return out;
 }
 
-value numeric_vector_to_lisp_list(const std::vector<double>& values) {
+bt::planner_vector lisp_to_planner_vector(value v, const std::string& where) {
+    if (is_f64vec(v)) {
+        return bt::planner_vector(std::span<const double>(v->f64vec_data()));
+    }
+    const std::vector<double> values = lisp_to_numeric_vector(v, where);
+    return bt::planner_vector(values.begin(), values.end());
+}
+
+value numeric_vector_to_lisp_list(std::span<const double> values) {
     std::vector<value> items;
     items.reserve(values.size());
     gc_root_scope roots(default_gc());
@@ -1186,7 +1872,8 @@ map_key symbol_key(const std::string& name) {
 }
 
 void map_set_symbol(value map_obj, const std::string& key_name, value v) {
-    map_obj->map_data[symbol_key(key_name)] = v;
+    map_obj->map_data()[symbol_key(key_name)] = v;
+    default_gc().write_barrier(map_obj, v);
 }
 
 std::string require_text_value(value v, const std::string& where) {
@@ -1376,132 +2063,196 @@ value vla_response_to_lisp(const bt::vla_response& response) {
     return out;
 }
 
-std::string json_escape(std::string_view input) {
-    std::string out;
-    out.reserve(input.size() + 8);
-    for (char c : input) {
-        switch (c) {
+// JSON codec behind json.encode/json.decode and the capability payloads.
+//
+// Encoding appends into one caller-owned buffer instead of building a string per value. Decoding is a
+// single pass over the input: string bodies are scanned a word at a time for the next quote or backslash,
+// unescaped strings and keys are copied straight from the input into their Lisp objects, and numbers are
+// parsed in place with std::from_chars.
+
+constexpr std::uint64_t kJsonByteOnes = 0x0101010101010101ull;
+constexpr std::uint64_t kJsonByteHighs = 0x8080808080808080ull;
+
+// Non-zero when some byte of `word` equals `byte`; exact for the lowest matching byte.
+constexpr std::uint64_t json_word_has_byte(std::uint64_t word, unsigned char byte) noexcept {
+    const std::uint64_t x = word ^ (kJsonByteOnes * byte);
+    return (x - kJsonByteOnes) & ~x & kJsonByteHighs;
+}
+
+void append_json_escaped(std::string& out, std::string_view input) {
+    std::size_t run_start = 0;
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        const char* escaped = nullptr;
+        switch (input[i]) {
             case '\\':
-                out += "\\\\";
+                escaped = "\\\\";
                 break;
             case '"':
-                out += "\\\"";
+                escaped = "\\\"";
                 break;
             case '\n':
-                out += "\\n";
+                escaped = "\\n";
                 break;
             case '\r':
-                out += "\\r";
+                escaped = "\\r";
                 break;
             case '\t':
-                out += "\\t";
+                escaped = "\\t";
                 break;
             default:
-                out.push_back(c);
-                break;
+                continue;
         }
+        out.append(input.substr(run_start, i - run_start));
+        out.append(escaped);
+        run_start = i + 1;
     }
-    return out;
+    out.append(input.substr(run_start));
+}
+
+void append_json_string(std::string& out, std::string_view text) {
+    out.push_back('"');
+    append_json_escaped(out, text);
+    out.push_back('"');
 }
 
-std::string map_key_to_json_object_key(const map_key& key) {
+void append_json_integer(std::string& out, std::int64_t v) {
+    char buffer[24];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), v);
+    out.append(buffer, result.ptr);
+}
+
+// Same text as `std::ostream << double` with the default precision (printf "%g").
+void append_json_double(std::string& out, double v) {
+    char buffer[32];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), v, std::chars_format::general, 6);
+    out.append(buffer, result.ptr);
+}
+
+void append_json_object_key(std::string& out, const map_key& key) {
     switch (key.type) {
         case map_key_type::symbol:
         case map_key_type::string:
-            return key.text_data;
+            append_json_string(out, key.text_data);
+            return;
         case map_key_type::integer:
-            return std::to_string(key.integer_data);
-        case map_key_type::floating: {
-            std::ostringstream out;
-            out << key.float_data;
-            return out.str();
-        }
+            out.push_back('"');
+            append_json_integer(out, key.integer_data);
+            out.push_back('"');
+            return;
+        case map_key_type::floating:
+            out.push_back('"');
+            append_json_double(out, key.float_data);
+            out.push_back('"');
+            return;
     }
-    return "";
 }
 
-std::string value_to_json(value v);
-
-std::string list_to_json(value list_v) {
-    if (!is_proper_list(list_v)) {
-        throw lisp_error("json.encode: expected proper list");
-    }
-    const std::vector<value> items = vector_from_list(list_v);
-    std::ostringstream out;
-    out << '[';
-    for (std::size_t i = 0; i < items.size(); ++i) {
-        if (i != 0) {
-            out << ',';
-        }
-        out << value_to_json(items[i]);
-    }
-    out << ']';
-    return out.str();
-}
-
-std::string value_to_json(value v) {
-    if (is_nil(v)) {
-        return "null";
+void append_json(std::string& out, value v) {
+    if (is_nil(v)) {
+        out.append("null");
+        return;
     }
     if (is_boolean(v)) {
-        return boolean_value(v) ? "true" : "false";
+        out.append(boolean_value(v) ? "true" : "false");
+        return;
     }
     if (is_integer(v)) {
-        return std::to_string(integer_value(v));
+        append_json_integer(out, integer_value(v));
+        return;
     }
     if (is_float(v)) {
         const double d = float_value(v);
         if (!std::isfinite(d)) {
             throw lisp_error("json.encode: non-finite floats are not supported");
         }
-        std::ostringstream out;
-        out << d;
-        return out.str();
+        append_json_double(out, d);
+        return;
     }
     if (is_string(v)) {
-        return "\"" + json_escape(string_value(v)) + "\"";
+        append_json_string(out, string_value(v));
+        return;
     }
     if (is_symbol(v)) {
-        return "\"" + json_escape(symbol_name(v)) + "\"";
+        append_json_string(out, symbol_name(v));
+        return;
     }
     if (is_cons(v)) {
-        return list_to_json(v);
+        if (!is_proper_list(v)) {
+            throw lisp_error("json.encode: expected proper list");
+        }
+        out.push_back('[');
+        for (value cursor = v; !is_nil(cursor); cursor = cdr(cursor)) {
+            if (cursor != v) {
+                out.push_back(',');
+            }
+            append_json(out, car(cursor));
+        }
+        out.push_back(']');
+        return;
+    }
+    if (is_f64vec(v)) {
+        out.push_back('[');
+        const f64_storage& items = v->f64vec_data();
+        for (std::size_t i = 0; i < items.size(); ++i) {
+            if (i != 0) {
+                out.push_back(',');
+            }
+            if (!std::isfinite(items[i])) {
+                throw lisp_error("json.encode: non-finite floats are not supported");
+            }
+            append_json_double(out, items[i]);
+        }
+        out.push_back(']');
+        return;
     }
     if (is_vec(v)) {
-        std::ostringstream out;
-        out << '[';
-        for (std::size_t i = 0; i < v->vec_data.size(); ++i) {
+        out.push_back('[');
+        const auto& items = v->vec_data();
+        for (std::size_t i = 0; i < items.size(); ++i) {
             if (i != 0) {
-                out << ',';
+                out.push_back(',');
             }
-            out << value_to_json(v->vec_data[i]);
+            append_json(out, items[i]);
         }
-        out << ']';
-        return out.str();
+        out.push_back(']');
+        return;
     }
     if (is_map(v)) {
-        std::ostringstream out;
-        out << '{';
+        out.push_back('{');
         bool first = true;
-        for (const auto& [k, mapped] : v->map_data) {
+        for (const auto& [k, mapped] : v->map_data()) {
             if (!first) {
-                out << ',';
+                out.push_back(',');
             }
             first = false;
-            out << "\"" << json_escape(map_key_to_json_object_key(k)) << "\":" << value_to_json(mapped);
+            append_json_object_key(out, k);
+            out.push_back(':');
+            append_json(out, mapped);
         }
-        out << '}';
-        return out.str();
+        out.push_back('}');
+        return;
     }
     if (is_image_handle(v)) {
-        return "{\"type\":\"image_handle\",\"id\":" + std::to_string(image_handle_id(v)) + "}";
+        out.append("{\"type\":\"image_handle\",\"id\":");
+        append_json_integer(out, image_handle_id(v));
+        out.push_back('}');
+        return;
     }
     if (is_blob_handle(v)) {
-        return "{\"type\":\"blob_handle\",\"id\":" + std::to_string(blob_handle_id(v)) + "}";
+        out.append("{\"type\":\"blob_handle\",\"id\":");
+        append_json_integer(out, blob_handle_id(v));
+        out.push_back('}');
+        return;
     }
     throw lisp_error("json.encode: unsupported value type: " + std::string(type_name(type_of(v))));
 }
 
+std::string value_to_json(value v) {
+    std::string out;
+    append_json(out, v);
+    return out;
+}
+
 class json_parser {
 public:
     explicit json_parser(std::string_view input) : input_(input) {}
@@ -1521,7 +2272,11 @@ private:
     char get() noexcept { return eof() ? '\0' : input_[pos_++]; }
 
     void skip_ws() {
-        while (!eof() && std::isspace(static_cast<unsigned char>(peek()))) {
+        while (!eof()) {
+            const char c = input_[pos_];
+            if (c != ' ' && c != '\n' && c != '\r' && c != '\t') {
+                return;
+            }
             ++pos_;
         }
     }
@@ -1582,56 +2337,92 @@ private:
         if (c == '{') {
             return parse_object();
         }
-        if (c == '-' || std::isdigit(static_cast<unsigned char>(c))) {
+        if (c == '-' || (c >= '0' && c <= '9')) {
             return parse_number();
         }
         throw lisp_error("json.decode: unexpected token");
     }
 
-    std::string parse_string() {
+    // Advances to the next quote or backslash, eight bytes at a time while a full word remains.
+    void scan_string_body() {
+        const char* data = input_.data();
+        while (pos_ + sizeof(std::uint64_t) <= input_.size()) {
+            std::uint64_t word = 0;
+            std::memcpy(&word, data + pos_, sizeof(word));
+            if ((json_word_has_byte(word, '"') | json_word_has_byte(word, '\\')) != 0) {
+                break;
+            }
+            pos_ += sizeof(word);
+        }
+        while (!eof() && input_[pos_] != '"' && input_[pos_] != '\\') {
+            ++pos_;
+        }
+    }
+
+    // Returns the decoded body. Strings without escapes are a view into the input; strings with escapes
+    // are decoded into `scratch_` and the view points there until the next call.
+    std::string_view parse_string() {
         expect('"', "\"");
-        std::string out;
+        const std::size_t start = pos_;
+        scan_string_body();
+        if (eof()) {
+            throw lisp_error("json.decode: unterminated string");
+        }
+        if (input_[pos_] == '"') {
+            return input_.substr(start, pos_++ - start);
+        }
+
+        scratch_.assign(input_.substr(start, pos_ - start));
         while (!eof()) {
             const char c = get();
             if (c == '"') {
-                return out;
+                return scratch_;
             }
-            if (c == '\\') {
-                if (eof()) {
-                    throw lisp_error("json.decode: invalid escape");
-                }
-                const char esc = get();
-                switch (esc) {
-                    case '"':
-                    case '\\':
-                    case '/':
-                        out.push_back(esc);
-                        break;
-                    case 'b':
-                        out.push_back('\b');
-                        break;
-                    case 'f':
-                        out.push_back('\f');
-                        break;
-                    case 'n':
-                        out.push_back('\n');
-                        break;
-                    case 'r':
-                        out.push_back('\r');
-                        break;
-                    case 't':
-                        out.push_back('\t');
-                        break;
-                    default:
-                        throw lisp_error("json.decode: unsupported escape sequence");
-                }
-            } else {
-                out.push_back(c);
+            if (c != '\\') {
+                scratch_.push_back(c);
+                continue;
+            }
+            if (eof()) {
+                throw lisp_error("json.decode: invalid escape");
             }
+            const char esc = get();
+            switch (esc) {
+                case '"':
+                case '\\':
+                case '/':
+                    scratch_.push_back(esc);
+                    break;
+                case 'b':
+                    scratch_.push_back('\b');
+                    break;
+                case 'f':
+                    scratch_.push_back('\f');
+                    break;
+                case 'n':
+                    scratch_.push_back('\n');
+                    break;
+                case 'r':
+                    scratch_.push_back('\r');
+                    break;
+                case 't':
+                    scratch_.push_back('\t');
+                    break;
+                default:
+                    throw lisp_error("json.decode: unsupported escape sequence");
+            }
+            const std::size_t run_start = pos_;
+            scan_string_body();
+            scratch_.append(input_.substr(run_start, pos_ - run_start));
         }
         throw lisp_error("json.decode: unterminated string");
     }
 
+    void skip_digits() {
+        while (!eof() && input_[pos_] >= '0' && input_[pos_] <= '9') {
+            ++pos_;
+        }
+    }
+
     value parse_number() {
         const std::size_t start = pos_;
         if (peek() == '-') {
@@ -1640,16 +2431,12 @@ private:
         if (!std::isdigit(static_cast<unsigned char>(peek()))) {
             throw lisp_error("json.decode: invalid number");
         }
-        while (std::isdigit(static_cast<unsigned char>(peek()))) {
-            ++pos_;
-        }
+        skip_digits();
         bool is_float_num = false;
         if (peek() == '.') {
             is_float_num = true;
             ++pos_;
-            while (std::isdigit(static_cast<unsigned char>(peek()))) {
-                ++pos_;
-            }
+            skip_digits();
         }
         if (peek() == 'e' || peek() == 'E') {
             is_float_num = true;
@@ -1660,20 +2447,24 @@ private:
             if (!std::isdigit(static_cast<unsigned char>(peek()))) {
                 throw lisp_error("json.decode: invalid exponent");
             }
-            while (std::isdigit(static_cast<unsigned char>(peek()))) {
-                ++pos_;
-            }
+            skip_digits();
         }
 
-        const std::string token(input_.substr(start, pos_ - start));
+        const char* first = input_.data() + start;
+        const char* last = input_.data() + pos_;
         if (!is_float_num) {
-            try {
-                return make_integer(std::stoll(token));
-            } catch (...) {
-                // Fall through to float parse.
+            std::int64_t parsed = 0;
+            const auto result = std::from_chars(first, last, parsed);
+            if (result.ec == std::errc{} && result.ptr == last) {
+                return make_integer(parsed);
             }
+            // Out of int64 range: fall through to a float parse.
+        }
+        double parsed = 0.0;
+        if (std::from_chars(first, last, parsed).ec == std::errc::result_out_of_range) {
+            // from_chars reports underflow as an error; keep strtod's rounding towards zero for those.
+            parsed = std::strtod(std::string(first, last).c_str(), nullptr);
         }
-        const double parsed = std::strtod(token.c_str(), nullptr);
         if (!std::isfinite(parsed)) {
             throw lisp_error("json.decode: non-finite number");
         }
@@ -1682,20 +2473,24 @@ private:
 
     value parse_array() {
         expect('[', "[");
-        skip_ws();
-        std::vector<value> items;
-        gc_root_scope roots(default_gc());
         if (consume_if(']')) {
             return make_nil();
         }
+        value head = make_nil();
+        value tail = make_nil();
+        gc_root_scope roots(default_gc());
+        roots.add(&head);
         while (true) {
-            value item = parse_value();
-            roots.add(&item);
-            items.push_back(item);
-            roots.add(&items.back());
-            skip_ws();
+            value cell = make_cons(parse_value(), make_nil());
+            if (is_nil(head)) {
+                head = cell;
+            } else {
+                tail->cdr_data = cell;
+                default_gc().write_barrier(tail, cell);
+            }
+            tail = cell;
             if (consume_if(']')) {
-                return list_from_vector(items);
+                return head;
             }
             expect(',', ",");
         }
@@ -1706,25 +2501,22 @@ private:
         value out = make_map();
         gc_root_scope roots(default_gc());
         roots.add(&out);
-        skip_ws();
         if (consume_if('}')) {
             return out;
         }
+        map_key map_k;
+        map_k.type = map_key_type::string;
         while (true) {
             skip_ws();
             if (peek() != '"') {
                 throw lisp_error("json.decode: expected string key");
             }
-            const std::string key = parse_string();
+            map_k.text_data.assign(parse_string());
             skip_ws();
             expect(':', ":");
             value mapped = parse_value();
-            roots.add(&mapped);
-            map_key map_k;
-            map_k.type = map_key_type::string;
-            map_k.text_data = key;
-            out->map_data[map_k] = mapped;
-            skip_ws();
+            out->map_data().insert_or_assign(map_k, mapped);
+            default_gc().write_barrier(out, mapped);
             if (consume_if('}')) {
                 return out;
             }
@@ -1734,6 +2526,7 @@ private:
 
     std::string_view input_;
     std::size_t pos_ = 0;
+    std::string scratch_;
 };
 
 std::optional<std::uint64_t> maybe_seed_from_value(value v, const std::string& where) {
@@ -1776,6 +2569,10 @@ bt::vla_request parse_vla_request_map(value request_map) {
     if (req.deadline_ms <= 0) {
         throw lisp_error("vla.submit: deadline_ms must be > 0");
     }
+    const std::string priority = map_lookup_text_or(request_map, "priority", "normal", "vla.submit priority");
+    if (!bt::parse_job_priority(priority, req.priority)) {
+        throw lisp_error("vla.submit: priority must be high, normal or low");
+    }
     req.run_id = map_lookup_text_or(request_map, "run_id", req.run_id, "vla.submit run_id");
     req.node_name = map_lookup_text_or(request_map, "node_name", req.node_name, "vla.submit node_name");
     req.tick_index = static_cast<std::uint64_t>(
@@ -1975,6 +2772,15 @@ value bt_node_to_dsl(const bt::definition& def, bt::node_id id) {
                 form.push_back(bt_node_to_dsl(def, child));
             }
             break;
+        case bt::node_kind::par:
+            form.push_back(make_symbol("par"));
+            for (const bt::arg_value& arg : n.args) {
+                form.push_back(bt_arg_to_lisp_value(arg));
+            }
+            for (bt::node_id child : n.children) {
+                form.push_back(bt_node_to_dsl(def, child));
+            }
+            break;
         case bt::node_kind::invert:
             form.push_back(make_symbol("invert"));
             if (n.children.size() != 1) {
@@ -2045,6 +2851,12 @@ value bt_node_to_dsl(const bt::definition& def, bt::node_id id) {
                 form.push_back(bt_arg_to_lisp_value(arg));
             }
             break;
+        case bt::node_kind::vla_chunk:
+            form.push_back(make_symbol("vla-chunk"));
+            for (const bt::arg_value& arg : n.args) {
+                form.push_back(bt_arg_to_lisp_value(arg));
+            }
+            break;
     }
 
     return list_from_vector(form);
@@ -2060,19 +2872,14 @@ value bt_definition_to_dsl(const bt::definition& def) {
     return bt_node_to_dsl(def, def.root);
 }
 
-void attach_dsl_identity_metadata(bt::definition& def, std::string_view source_text) {
-    const value canonical_dsl = bt_definition_to_dsl(def);
-    def.source_hash = bt::event_log::hash64_hex(source_text);
-    def.canonical_dsl = write_value(canonical_dsl);
-    def.canonical_dsl_hash = bt::event_log::hash64_hex(def.canonical_dsl);
-}
 
 value builtin_bt_compile(const std::vector<value>& args) {
     require_arity("bt.compile", args, 1);
     try {
         bt::definition def = bt::compile_definition(args[0]);
-        attach_dsl_identity_metadata(def, write_value(args[0]));
-        const std::int64_t handle = bt::default_runtime_host().store_definition(std::move(def));
+        // The canonical DSL is built on first use (bt::ensure_canonical_dsl), not per compile.
+        def.source_hash = bt::event_log::hash64_hex(write_value(args[0]));
+        const std::int64_t handle = bt::default_runtime_host().intern_definition(std::move(def));
         return make_bt_def(handle);
     } catch (const bt::bt_compile_error& e) {
         throw lisp_error(std::string("bt.compile: ") + e.what());
@@ -2098,7 +2905,7 @@ value builtin_bt_save_dsl(const std::vector<value>& args) {
         throw lisp_error("bt.save-dsl: unknown definition");
     }
     const value dsl = bt_definition_to_dsl(*def);
-    write_text_file(path, write_value(dsl), "bt.save-dsl");
+    write_value_file(path, dsl, "bt.save-dsl");
     return make_boolean(true);
 }
 
@@ -2123,10 +2930,17 @@ value builtin_bt_load_dsl(const std::vector<value>& args) {
     const std::string path = require_path_arg(args[0], "bt.load-dsl");
     try {
         const std::string source = read_text_file(path, "bt.load-dsl");
+        bt::runtime_host& host = bt::default_runtime_host();
+        // Definitions are never modified after they are stored, so unchanged text can share one.
+        const std::string source_hash = bt::event_log::hash64_hex(source);
+        if (const auto cached = host.find_dsl_definition(source_hash, source.size())) {
+            return make_bt_def(*cached);
+        }
         value form = read_one(source);
         bt::definition def = bt::compile_definition(form);
-        attach_dsl_identity_metadata(def, source);
-        const std::int64_t handle = bt::default_runtime_host().store_definition(std::move(def));
+        def.source_hash = source_hash;
+        const std::int64_t handle = host.intern_definition(std::move(def));
+        host.remember_dsl_definition(source_hash, source.size(), handle);
         return make_bt_def(handle);
     } catch (const parse_error& e) {
         throw lisp_error("bt.load-dsl: " + path + ": " + std::string(e.what()));
@@ -2137,6 +2951,41 @@ value builtin_bt_load_dsl(const std::vector<value>& args) {
     }
 }
 
+value builtin_bt_load_dsl_files(const std::vector<value>& args) {
+    if (args.size() != 1 && args.size() != 2) {
+        throw lisp_error("bt.load-dsl-files: expected 1 or 2 arguments");
+    }
+    if (!is_proper_list(args[0])) {
+        throw lisp_error("bt.load-dsl-files: expected list of file path strings");
+    }
+    std::vector<std::string> paths;
+    for (const value path : vector_from_list(args[0])) {
+        paths.push_back(require_path_arg(path, "bt.load-dsl-files"));
+    }
+    std::size_t workers = 0;
+    if (args.size() == 2) {
+        if (!is_integer(args[1]) || integer_value(args[1]) <= 0) {
+            throw lisp_error("bt.load-dsl-files: expected positive worker count");
+        }
+        workers = static_cast<std::size_t>(integer_value(args[1]));
+    }
+
+    std::vector<std::int64_t> handles;
+    try {
+        handles = bt::default_runtime_host().load_dsl_files(paths, workers);
+    } catch (const std::exception& e) {
+        throw lisp_error(std::string("bt.load-dsl-files: ") + e.what());
+    }
+    std::vector<value> defs;
+    defs.reserve(handles.size());
+    gc_root_scope roots(default_gc());
+    for (const std::int64_t handle : handles) {
+        defs.push_back(make_bt_def(handle));
+        roots.add(&defs.back());
+    }
+    return list_from_vector(defs);
+}
+
 value builtin_bt_save_binary(const std::vector<value>& args) {
     require_arity("bt.save", args, 2);
     const std::int64_t def_handle = require_bt_def_handle(args[0], "bt.save");
@@ -2197,6 +3046,41 @@ value builtin_bt_tick(const std::vector<value>& args) {
     }
 }
 
+value builtin_bt_tick_all(const std::vector<value>& args) {
+    require_arity("bt.tick-all", args, 1);
+    if (!is_proper_list(args[0])) {
+        throw lisp_error("bt.tick-all: expected list of bt_instance");
+    }
+    std::vector<std::int64_t> handles;
+    for (value item : vector_from_list(args[0])) {
+        handles.push_back(require_bt_instance_handle(item, "bt.tick-all"));
+    }
+    std::vector<bt::status> statuses(handles.size(), bt::status::failure);
+    try {
+        bt::default_runtime_host().tick_instances(handles, statuses);
+    } catch (const std::exception& e) {
+        throw lisp_error(std::string("bt.tick-all: ") + e.what());
+    }
+
+    std::vector<value> out;
+    out.reserve(statuses.size());
+    for (const bt::status st : statuses) {
+        out.push_back(status_to_symbol(st));
+    }
+    return list_from_vector(out);
+}
+
+value builtin_bt_set_tick_workers(const std::vector<value>& args) {
+    require_arity("bt.set-tick-workers", args, 1);
+    const std::int64_t count = require_non_negative_int(args[0], "bt.set-tick-workers");
+    try {
+        bt::default_runtime_host().set_tick_workers(static_cast<std::size_t>(count));
+    } catch (const std::exception& e) {
+        throw lisp_error(std::string("bt.set-tick-workers: ") + e.what());
+    }
+    return make_nil();
+}
+
 value builtin_bt_reset(const std::vector<value>& args) {
     require_arity("bt.reset", args, 1);
     const std::int64_t inst_handle = require_bt_instance_handle(args[0], "bt.reset");
@@ -2208,6 +3092,122 @@ value builtin_bt_reset(const std::vector<value>& args) {
     }
 }
 
+value builtin_bt_release_instance(const std::vector<value>& args) {
+    require_arity("bt.release-instance", args, 1);
+    const std::int64_t inst_handle = require_bt_instance_handle(args[0], "bt.release-instance");
+    try {
+        bt::default_runtime_host().release_instance(inst_handle);
+    } catch (const std::exception& e) {
+        throw lisp_error(std::string("bt.release-instance: ") + e.what());
+    }
+    return make_nil();
+}
+
+value builtin_bt_replay_log(const std::vector<value>& args) {
+    if (args.size() != 2 && args.size() != 3) {
+        throw lisp_error("bt.replay-log: expected 2 or 3 arguments");
+    }
+    const std::int64_t inst_handle = require_bt_instance_handle(args[0], "bt.replay-log");
+    const std::string path = require_path_arg(args[1], "bt.replay-log");
+    bt::log_replay_options options;
+    if (args.size() == 3) {
+        options.max_ticks = static_cast<std::uint64_t>(require_non_negative_int(args[2], "bt.replay-log"));
+    }
+    bt::log_replay_report report;
+    try {
+        bt::log_replay replay = bt::log_replay::load(path);
+        report = bt::default_runtime_host().replay_instance(inst_handle, replay, options);
+    } catch (const std::exception& e) {
+        throw lisp_error(std::string("bt.replay-log: ") + e.what());
+    }
+
+    value out = make_map();
+    gc_root_scope roots(default_gc());
+    roots.add(&out);
+    map_set_symbol(out, "recorded_ticks", make_integer(static_cast<std::int64_t>(report.recorded_ticks)));
+    map_set_symbol(out, "replayed_ticks", make_integer(static_cast<std::int64_t>(report.replayed_ticks)));
+    map_set_symbol(out, "injected_bb_writes", make_integer(static_cast<std::int64_t>(report.injected_bb_writes)));
+    map_set_symbol(out, "injected_vla_results", make_integer(static_cast<std::int64_t>(report.injected_vla_results)));
+    map_set_symbol(out, "injected_planner_results",
+                   make_integer(static_cast<std::int64_t>(report.injected_planner_results)));
+    map_set_symbol(out, "elapsed_ms", make_float(report.elapsed_ms));
+    map_set_symbol(out, "diverged", make_boolean(report.divergence.has_value()));
+    if (report.divergence) {
+        value divergence = make_map();
+        roots.add(&divergence);
+        map_set_symbol(divergence, "tick", make_integer(static_cast<std::int64_t>(report.divergence->tick)));
+        map_set_symbol(divergence, "kind", keyword_symbol(report.divergence->kind));
+        map_set_symbol(divergence, "node_id", make_integer(report.divergence->node));
+        map_set_symbol(divergence, "expected", make_string(report.divergence->expected));
+        map_set_symbol(divergence, "actual", make_string(report.divergence->actual));
+        map_set_symbol(out, "divergence", divergence);
+    } else {
+        map_set_symbol(out, "divergence", make_nil());
+    }
+    return out;
+}
+
+value builtin_bt_set_trace_capacity(const std::vector<value>& args) {
+    require_arity("bt.set-trace-capacity", args, 1);
+    const std::int64_t capacity = require_non_negative_int(args[0], "bt.set-trace-capacity");
+    bt::default_runtime_host().set_instance_trace_capacity(static_cast<std::size_t>(capacity));
+    return make_nil();
+}
+
+value builtin_bt_fork(const std::vector<value>& args) {
+    require_arity("bt.fork", args, 1);
+    const std::int64_t inst_handle = require_bt_instance_handle(args[0], "bt.fork");
+    try {
+        return make_bt_instance(bt::default_runtime_host().fork_instance(inst_handle));
+    } catch (const std::exception& e) {
+        throw lisp_error(std::string("bt.fork: ") + e.what());
+    }
+}
+
+value builtin_bt_checkpoint(const std::vector<value>& args) {
+    require_arity("bt.checkpoint", args, 2);
+    const std::int64_t inst_handle = require_bt_instance_handle(args[0], "bt.checkpoint");
+    const std::string path = require_path_arg(args[1], "bt.checkpoint");
+    const bt::instance* inst = bt::default_runtime_host().find_instance(inst_handle);
+    if (!inst) {
+        throw lisp_error("bt.checkpoint: unknown instance");
+    }
+    try {
+        bt::save_instance_checkpoint(*inst, path);
+    } catch (const std::exception& e) {
+        throw lisp_error(e.what());
+    }
+    return make_boolean(true);
+}
+
+value builtin_bt_restore(const std::vector<value>& args) {
+    require_arity("bt.restore", args, 2);
+    const std::int64_t inst_handle = require_bt_instance_handle(args[0], "bt.restore");
+    const std::string path = require_path_arg(args[1], "bt.restore");
+    bt::instance* inst = bt::default_runtime_host().find_instance(inst_handle);
+    if (!inst) {
+        throw lisp_error("bt.restore: unknown instance");
+    }
+    try {
+        bt::load_instance_checkpoint(*inst, path);
+    } catch (const std::exception& e) {
+        throw lisp_error(e.what());
+    }
+    return make_boolean(true);
+}
+
+value builtin_bt_swap_definition(const std::vector<value>& args) {
+    require_arity("bt.swap-definition", args, 2);
+    const std::int64_t inst_handle = require_bt_instance_handle(args[0], "bt.swap-definition");
+    const std::int64_t def_handle = require_bt_def_handle(args[1], "bt.swap-definition");
+    try {
+        const std::size_t halted = bt::default_runtime_host().swap_instance_definition(inst_handle, def_handle);
+        return make_integer(static_cast<std::int64_t>(halted));
+    } catch (const std::exception& e) {
+        throw lisp_error(std::string("bt.swap-definition: ") + e.what());
+    }
+}
+
 value builtin_bt_status_to_symbol(const std::vector<value>& args) {
     require_arity("bt.status->symbol", args, 1);
     if (!is_symbol(args[0])) {
@@ -2226,6 +3226,78 @@ value builtin_bt_stats(const std::vector<value>& args) {
     return make_string(bt::default_runtime_host().dump_instance_stats(inst_handle));
 }
 
+value builtin_bt_flamegraph(const std::vector<value>& args) {
+    if (args.size() > 1) {
+        throw lisp_error("bt.flamegraph: expected 0 or 1 arguments");
+    }
+    bt::runtime_host& host = bt::default_runtime_host();
+    if (args.empty()) {
+        return make_string(host.dump_flamegraph());
+    }
+    const std::int64_t inst_handle = require_bt_instance_handle(args[0], "bt.flamegraph");
+    if (!host.find_instance(inst_handle)) {
+        throw lisp_error("bt.flamegraph: unknown instance");
+    }
+    return make_string(host.dump_instance_flamegraph(inst_handle));
+}
+
+value builtin_bt_latency_histogram(const std::vector<value>& args) {
+    if (args.empty() || args.size() > 2) {
+        throw lisp_error("bt.latency-histogram: expected 1 or 2 arguments");
+    }
+
+    bt::runtime_host& host = bt::default_runtime_host();
+    bt::latency_histogram histogram;
+    if (is_symbol(args[0])) {
+        if (args.size() != 1) {
+            throw lisp_error("bt.latency-histogram: scheduler histograms take no node id");
+        }
+        const std::string name = symbol_name(args[0]);
+        const bt::scheduler_profile_stats stats = host.scheduler_ref().stats_snapshot();
+        if (name == "queue-delay") {
+            histogram = stats.queue_delay.histogram;
+        } else if (name == "run-time") {
+            histogram = stats.run_time.histogram;
+        } else {
+            throw lisp_error("bt.latency-histogram: expected queue-delay or run-time");
+        }
+    } else {
+        const std::int64_t inst_handle = require_bt_instance_handle(args[0], "bt.latency-histogram");
+        const bt::instance* inst = host.find_instance(inst_handle);
+        if (!inst) {
+            throw lisp_error("bt.latency-histogram: unknown instance");
+        }
+        if (args.size() == 1) {
+            histogram = inst->tree_stats.tick_duration.histogram;
+        } else {
+            if (!is_integer(args[1])) {
+                throw lisp_error("bt.latency-histogram: expected integer node id");
+            }
+            const std::int64_t id = integer_value(args[1]);
+            if (id < 0 || static_cast<std::uint64_t>(id) >= inst->node_stats.size()) {
+                throw lisp_error("bt.latency-histogram: node id out of range");
+            }
+            histogram = inst->node_stats[static_cast<std::size_t>(id)].tick_duration.histogram;
+        }
+    }
+
+    gc_root_scope roots(default_gc());
+    std::vector<value> out;
+    out.reserve(bt::latency_histogram::k_bucket_count);
+    for (std::size_t i = 0; i < bt::latency_histogram::k_bucket_count; ++i) {
+        const std::uint64_t n = histogram.bucket_count_at(i);
+        if (n == 0) {
+            continue;
+        }
+        // Both integers are fixnums, so only the finished pairs need rooting.
+        const std::vector<value> pair{make_integer(bt::latency_histogram::bucket_upper_bound(i).count()),
+                                      make_integer(static_cast<std::int64_t>(n))};
+        out.push_back(list_from_vector(pair));
+        roots.add(&out.back());
+    }
+    return list_from_vector(out);
+}
+
 value builtin_bt_blackboard_dump(const std::vector<value>& args) {
     require_arity("bt.blackboard.dump", args, 1);
     const std::int64_t inst_handle = require_bt_instance_handle(args[0], "bt.blackboard.dump");
@@ -2251,6 +3323,117 @@ value builtin_bt_blackboard_get(const std::vector<value>& args) {
     return bb_value_to_lisp_value(entry->value);
 }
 
+value builtin_bt_blackboard_get_f64vec(const std::vector<value>& args) {
+    if (args.size() != 2 && args.size() != 3) {
+        throw lisp_error("bt.blackboard.get-f64vec: expected 2 or 3 arguments");
+    }
+    const std::int64_t inst_handle = require_bt_instance_handle(args[0], "bt.blackboard.get-f64vec");
+    const std::string key = require_bb_key(args[1], "bt.blackboard.get-f64vec");
+
+    const bt::instance* inst = bt::default_runtime_host().find_instance(inst_handle);
+    if (!inst) {
+        throw lisp_error("bt.blackboard.get-f64vec: unknown instance");
+    }
+
+    const bt::bb_entry* entry = inst->bb.get(key);
+    if (!entry) {
+        return args.size() == 3 ? args[2] : make_nil();
+    }
+    const auto* vec = std::get_if<bt::bb_vector>(&entry->value);
+    if (!vec) {
+        throw lisp_error("bt.blackboard.get-f64vec: entry is not a numeric vector");
+    }
+    return make_f64vec(vec->view());
+}
+
+value builtin_bt_blackboard_track_history(const std::vector<value>& args) {
+    require_arity("bt.blackboard.track-history", args, 3);
+    const std::int64_t inst_handle = require_bt_instance_handle(args[0], "bt.blackboard.track-history");
+    const std::string key = require_bb_key(args[1], "bt.blackboard.track-history");
+    const std::int64_t capacity = require_non_negative_int(args[2], "bt.blackboard.track-history");
+
+    bt::instance* inst = bt::default_runtime_host().find_instance(inst_handle);
+    if (!inst) {
+        throw lisp_error("bt.blackboard.track-history: unknown instance");
+    }
+    inst->bb.set_history(inst->bb.intern(key), static_cast<std::size_t>(capacity));
+    return make_nil();
+}
+
+// The history kept for `key` on the instance in args[0]; every history query shares these errors.
+const bt::bb_history& require_bb_history(const std::vector<value>& args, const std::string& where) {
+    const std::int64_t inst_handle = require_bt_instance_handle(args[0], where);
+    const std::string key = require_bb_key(args[1], where);
+
+    const bt::instance* inst = bt::default_runtime_host().find_instance(inst_handle);
+    if (!inst) {
+        throw lisp_error(where + ": unknown instance");
+    }
+    const bt::bb_history* history = inst->bb.history(inst->bb.find_slot(key));
+    if (!history) {
+        throw lisp_error(where + ": key has no history: " + key);
+    }
+    return *history;
+}
+
+value builtin_bt_blackboard_history(const std::vector<value>& args) {
+    if (args.size() != 2 && args.size() != 3) {
+        throw lisp_error("bt.blackboard.history: expected 2 or 3 arguments");
+    }
+    const bt::bb_history& history = require_bb_history(args, "bt.blackboard.history");
+    std::size_t count = history.size();
+    if (args.size() == 3) {
+        count = std::min(count, static_cast<std::size_t>(require_non_negative_int(args[2], "bt.blackboard.history")));
+    }
+
+    gc_root_scope roots(default_gc());
+    std::vector<value> out;
+    out.reserve(count);
+    for (std::size_t age = 0; age < count; ++age) {
+        out.push_back(bb_value_to_lisp_value(history.recent(age).value));
+        roots.add(&out.back());
+    }
+    return list_from_vector(out);
+}
+
+value builtin_bt_blackboard_at_tick(const std::vector<value>& args) {
+    if (args.size() != 3 && args.size() != 4) {
+        throw lisp_error("bt.blackboard.at-tick: expected 3 or 4 arguments");
+    }
+    const bt::bb_history& history = require_bb_history(args, "bt.blackboard.at-tick");
+    const std::int64_t tick = require_non_negative_int(args[2], "bt.blackboard.at-tick");
+
+    const bt::bb_history_sample* sample = history.at_tick(static_cast<std::uint64_t>(tick));
+    if (!sample) {
+        return args.size() == 4 ? args[3] : make_nil();
+    }
+    return bb_value_to_lisp_value(sample->value);
+}
+
+bt::bb_window_stats bb_history_window(const std::vector<value>& args, const std::string& where) {
+    if (args.size() != 2 && args.size() != 3) {
+        throw lisp_error(where + ": expected 2 or 3 arguments");
+    }
+    const bt::bb_history& history = require_bb_history(args, where);
+    const std::int64_t k = args.size() == 3 ? require_non_negative_int(args[2], where) : 0;
+    return history.window(static_cast<std::size_t>(k));
+}
+
+value builtin_bt_blackboard_window_mean(const std::vector<value>& args) {
+    const bt::bb_window_stats stats = bb_history_window(args, "bt.blackboard.window-mean");
+    return stats.count == 0 ? make_nil() : make_float(stats.mean());
+}
+
+value builtin_bt_blackboard_window_min(const std::vector<value>& args) {
+    const bt::bb_window_stats stats = bb_history_window(args, "bt.blackboard.window-min");
+    return stats.count == 0 ? make_nil() : make_float(stats.min);
+}
+
+value builtin_bt_blackboard_window_max(const std::vector<value>& args) {
+    const bt::bb_window_stats stats = bb_history_window(args, "bt.blackboard.window-max");
+    return stats.count == 0 ? make_nil() : make_float(stats.max);
+}
+
 value builtin_events_enable(const std::vector<value>& args) {
     require_arity("events.enable", args, 1);
     if (!is_boolean(args[0])) {
@@ -2287,6 +3470,212 @@ value builtin_events_set_flush_each_message(const std::vector<value>& args) {
     return make_nil();
 }
 
+value builtin_events_set_file_async(const std::vector<value>& args) {
+    if (args.empty() || args.size() > 2) {
+        throw lisp_error("events.set-file-async: expected 1 or 2 arguments");
+    }
+    if (!is_boolean(args[0])) {
+        throw lisp_error("events.set-file-async: expected boolean");
+    }
+    std::size_t queue_lines = bt::async_file_sink::k_default_queue_lines;
+    if (args.size() == 2) {
+        const std::int64_t raw = require_non_negative_int(args[1], "events.set-file-async");
+        if (raw == 0) {
+            throw lisp_error("events.set-file-async: queue size must be positive");
+        }
+        queue_lines = static_cast<std::size_t>(raw);
+    }
+    try {
+        bt::default_runtime_host().events().set_file_async(boolean_value(args[0]), queue_lines);
+    } catch (const std::exception& e) {
+        throw lisp_error(std::string("events.set-file-async: ") + e.what());
+    }
+    return make_nil();
+}
+
+value builtin_events_set_binary_path(const std::vector<value>& args) {
+    require_arity("events.set-binary-path", args, 1);
+    std::string path;
+    if (is_string(args[0])) {
+        path = string_value(args[0]);
+        if (path.empty()) {
+            throw lisp_error("events.set-binary-path: path must not be empty");
+        }
+    } else if (!is_nil(args[0])) {
+        throw lisp_error("events.set-binary-path: expected string path or nil");
+    }
+    try {
+        bt::default_runtime_host().events().set_binary_path(std::move(path));
+    } catch (const std::exception& e) {
+        throw lisp_error(std::string("events.set-binary-path: ") + e.what());
+    }
+    return make_nil();
+}
+
+value builtin_events_set_net_sink(const std::vector<value>& args) {
+    if (args.empty() || args.size() > 2) {
+        throw lisp_error("events.set-net-sink: expected 1 or 2 arguments");
+    }
+    auto& events = bt::default_runtime_host().events();
+    if (is_nil(args[0])) {
+        if (args.size() == 2) {
+            throw lisp_error("events.set-net-sink: options need an endpoint");
+        }
+        events.close_net_sink();
+        return make_nil();
+    }
+    if (!is_string(args[0])) {
+        throw lisp_error("events.set-net-sink: expected endpoint string or nil");
+    }
+    bt::net_sink_options options;
+    options.endpoint = string_value(args[0]);
+    if (args.size() == 2) {
+        const value opts = require_map_arg(args[1], "events.set-net-sink");
+        const auto size_option = [&](const std::string& key, std::size_t fallback) {
+            const std::optional<value> found = map_lookup_option(opts, key);
+            return found ? static_cast<std::size_t>(require_non_negative_int(*found, "events.set-net-sink " + key))
+                         : fallback;
+        };
+        options.queue_lines = size_option("queue_lines", options.queue_lines);
+        options.batch_bytes = size_option("batch_bytes", options.batch_bytes);
+        options.max_buffered_bytes = size_option("max_buffered_bytes", options.max_buffered_bytes);
+        options.sample_every = static_cast<std::uint32_t>(size_option("sample_every", options.sample_every));
+        options.batch_interval =
+            std::chrono::milliseconds(size_option("batch_ms", static_cast<std::size_t>(options.batch_interval.count())));
+        options.reconnect_interval = std::chrono::milliseconds(
+            size_option("reconnect_ms", static_cast<std::size_t>(options.reconnect_interval.count())));
+        const std::string overflow =
+            normalize_option_key(map_lookup_text_or(opts, "overflow", "drop_oldest", "events.set-net-sink overflow"));
+        if (overflow == "drop_oldest") {
+            options.overflow = bt::net_overflow_policy::drop_oldest;
+        } else if (overflow == "sample") {
+            options.overflow = bt::net_overflow_policy::sample;
+        } else {
+            throw lisp_error("events.set-net-sink: overflow must be drop-oldest or sample");
+        }
+        if (const std::optional<value> compress = map_lookup_option(opts, "compress")) {
+            if (!is_boolean(*compress)) {
+                throw lisp_error("events.set-net-sink compress: expected boolean");
+            }
+            options.compress = boolean_value(*compress);
+        }
+    }
+    try {
+        events.set_net_sink(options);
+    } catch (const std::exception& e) {
+        throw lisp_error(std::string("events.set-net-sink: ") + e.what());
+    }
+    return make_nil();
+}
+
+value builtin_events_net_stats(const std::vector<value>& args) {
+    require_arity("events.net-stats", args, 0);
+    const std::optional<bt::net_sink_stats> stats = bt::default_runtime_host().events().net_stats();
+    if (!stats) {
+        return make_nil();
+    }
+    value out = make_map();
+    gc_root_scope roots(default_gc());
+    roots.add(&out);
+    const auto put = [&](const char* key, std::uint64_t v) {
+        map_set_symbol(out, key, make_integer(static_cast<std::int64_t>(v)));
+    };
+    map_set_symbol(out, "connected", make_boolean(stats->connected));
+    map_set_symbol(out, "sampling", make_boolean(stats->sampling));
+    put("frames_sent", stats->frames_sent);
+    put("lines_sent", stats->lines_sent);
+    put("raw_bytes_sent", stats->raw_bytes_sent);
+    put("wire_bytes_sent", stats->wire_bytes_sent);
+    put("buffered_bytes", stats->buffered_bytes);
+    put("connects", stats->connects);
+    put("disconnects", stats->disconnects);
+    put("dropped_queue_full", stats->dropped_queue_full);
+    put("dropped_overflow", stats->dropped_overflow);
+    put("dropped_sampled", stats->dropped_sampled);
+    put("dropped_link", stats->dropped_link);
+    put("dropped_lines", stats->dropped_lines());
+    return out;
+}
+
+value builtin_events_set_file_index(const std::vector<value>& args) {
+    require_arity("events.set-file-index", args, 1);
+    const std::int64_t every = require_non_negative_int(args[0], "events.set-file-index");
+    auto& events = bt::default_runtime_host().events();
+    bt::event_file_layout layout = events.file_layout();
+    layout.index_every = static_cast<std::uint64_t>(every);
+    try {
+        events.set_file_layout(layout);
+    } catch (const std::exception& e) {
+        throw lisp_error(std::string("events.set-file-index: ") + e.what());
+    }
+    return make_nil();
+}
+
+value builtin_events_set_file_rotation(const std::vector<value>& args) {
+    if (args.empty() || args.size() > 2) {
+        throw lisp_error("events.set-file-rotation: expected 1 or 2 arguments");
+    }
+    const std::int64_t max_bytes = require_non_negative_int(args[0], "events.set-file-rotation");
+    const std::int64_t max_ms = args.size() == 2 ? require_non_negative_int(args[1], "events.set-file-rotation") : 0;
+    auto& events = bt::default_runtime_host().events();
+    bt::event_file_layout layout = events.file_layout();
+    layout.rotate_bytes = static_cast<std::uint64_t>(max_bytes);
+    layout.rotate_after = std::chrono::milliseconds(max_ms);
+    try {
+        events.set_file_layout(layout);
+    } catch (const std::exception& e) {
+        throw lisp_error(std::string("events.set-file-rotation: ") + e.what());
+    }
+    return make_nil();
+}
+
+value builtin_events_set_policy(const std::vector<value>& args) {
+    if (args.empty() || args.size() > 3) {
+        throw lisp_error("events.set-policy: expected 1 to 3 arguments");
+    }
+    bt::emission_policy policy;
+    const auto family_text = [](value v) -> std::optional<std::string> {
+        if (is_symbol(v)) {
+            return symbol_name(v);
+        }
+        if (is_string(v)) {
+            return string_value(v);
+        }
+        return std::nullopt;
+    };
+    if (const std::optional<std::string> text = family_text(args[0]); text && (*text == ":all" || *text == "all")) {
+        policy.family_mask = bt::emission_policy::k_all_families;
+    } else if (is_proper_list(args[0])) {
+        policy.family_mask = 0;
+        for (value cursor = args[0]; !is_nil(cursor); cursor = cdr(cursor)) {
+            const std::optional<std::string> name = family_text(car(cursor));
+            bt::event_family family = bt::event_family::other;
+            if (!name || !bt::event_log::parse_family(*name, family)) {
+                throw lisp_error(
+                    "events.set-policy: expected families :lifecycle, :node, :blackboard, :async, :outcome, :alert, or :other");
+            }
+            policy.family_mask |= bt::emission_policy::bit(family);
+        }
+    } else {
+        throw lisp_error("events.set-policy: expected :all or a list of event families");
+    }
+    if (args.size() >= 2) {
+        const std::int64_t every = require_non_negative_int(args[1], "events.set-policy");
+        if (every == 0 || every > std::numeric_limits<std::uint32_t>::max()) {
+            throw lisp_error("events.set-policy: node sample interval must be a positive 32-bit integer");
+        }
+        policy.node_sample_every = static_cast<std::uint32_t>(every);
+    }
+    if (args.size() == 3) {
+        if (!is_boolean(args[2])) {
+            throw lisp_error("events.set-policy: expected boolean for always-emit-failures");
+        }
+        policy.always_emit_failures = boolean_value(args[2]);
+    }
+    bt::default_runtime_host().events().set_emission_policy(policy);
+    return make_nil();
+}
+
 value builtin_events_enable_tick_audit(const std::vector<value>& args) {
     require_arity("events.enable-tick-audit", args, 1);
     if (!is_boolean(args[0])) {
@@ -2323,11 +3712,32 @@ value builtin_events_snapshot_bb(const std::vector<value>& args) {
     return make_nil();
 }
 
+value builtin_events_set_bb_deltas(const std::vector<value>& args) {
+    require_arity("events.set-bb-deltas", args, 1);
+    const std::int64_t raw = require_non_negative_int(args[0], "events.set-bb-deltas");
+    bt::default_runtime_host().events().set_bb_delta_keyframe_interval(static_cast<std::uint64_t>(raw));
+    return make_nil();
+}
+
+value builtin_events_set_compact_ids(const std::vector<value>& args) {
+    require_arity("events.set-compact-ids", args, 1);
+    if (!is_boolean(args[0])) {
+        throw lisp_error("events.set-compact-ids: expected boolean");
+    }
+    bt::default_runtime_host().events().set_compact_ids(boolean_value(args[0]));
+    return make_nil();
+}
+
 value builtin_bt_scheduler_stats(const std::vector<value>& args) {
     require_arity("bt.scheduler.stats", args, 0);
     return make_string(bt::default_runtime_host().dump_scheduler_stats());
 }
 
+value builtin_bt_memory_report(const std::vector<value>& args) {
+    require_arity("bt.memory-report", args, 0);
+    return make_string(bt::format_memory_report(bt::default_runtime_host().memory_report()));
+}
+
 value builtin_bt_set_tick_budget_ms(const std::vector<value>& args) {
     require_arity("bt.set-tick-budget-ms", args, 2);
     const std::int64_t inst_handle = require_bt_instance_handle(args[0], "bt.set-tick-budget-ms");
@@ -2343,6 +3753,184 @@ value builtin_bt_set_tick_budget_ms(const std::vector<value>& args) {
     return make_nil();
 }
 
+value builtin_bt_set_incremental_tick(const std::vector<value>& args) {
+    require_arity("bt.set-incremental-tick", args, 2);
+    const std::int64_t inst_handle = require_bt_instance_handle(args[0], "bt.set-incremental-tick");
+    if (!is_boolean(args[1])) {
+        throw lisp_error("bt.set-incremental-tick: expected boolean");
+    }
+
+    bt::instance* inst = bt::default_runtime_host().find_instance(inst_handle);
+    if (!inst) {
+        throw lisp_error("bt.set-incremental-tick: unknown instance");
+    }
+    bt::set_incremental_tick(*inst, boolean_value(args[1]));
+    return make_nil();
+}
+
+value builtin_bt_set_tick_on_demand(const std::vector<value>& args) {
+    if (args.size() != 2 && args.size() != 3) {
+        throw lisp_error("bt.set-tick-on-demand: expected 2 or 3 arguments");
+    }
+    const std::int64_t inst_handle = require_bt_instance_handle(args[0], "bt.set-tick-on-demand");
+    if (!is_boolean(args[1])) {
+        throw lisp_error("bt.set-tick-on-demand: expected boolean");
+    }
+    std::int64_t max_interval_ms = 0;
+    if (args.size() == 3) {
+        max_interval_ms = require_non_negative_int(args[2], "bt.set-tick-on-demand");
+    }
+
+    bt::instance* inst = bt::default_runtime_host().find_instance(inst_handle);
+    if (!inst) {
+        throw lisp_error("bt.set-tick-on-demand: unknown instance");
+    }
+    bt::set_tick_on_demand(*inst, boolean_value(args[1]), std::chrono::milliseconds(max_interval_ms));
+    return make_nil();
+}
+
+value wake_reasons_to_list(std::uint32_t bits) {
+    static constexpr std::pair<bt::wake_reason, const char*> k_names[] = {
+        {bt::wake_reason::initial, "initial"},
+        {bt::wake_reason::bb_write, "bb-write"},
+        {bt::wake_reason::job_complete, "job-complete"},
+        {bt::wake_reason::timer, "timer"},
+        {bt::wake_reason::running, "running"},
+    };
+    std::vector<value> out;
+    for (const auto& [reason, name] : k_names) {
+        if ((bits & bt::wake_bits(reason)) != 0) {
+            out.push_back(make_symbol(name));
+        }
+    }
+    return list_from_vector(out);
+}
+
+value builtin_bt_tick_if_due(const std::vector<value>& args) {
+    if (args.size() != 1 && args.size() != 2) {
+        throw lisp_error("bt.tick-if-due: expected 1 or 2 arguments");
+    }
+    const std::int64_t inst_handle = require_bt_instance_handle(args[0], "bt.tick-if-due");
+    try {
+        bt::runtime_host& host = bt::default_runtime_host();
+        bt::instance* inst = host.find_instance(inst_handle);
+        if (!inst) {
+            throw lisp_error("bt.tick-if-due: unknown instance");
+        }
+        if (args.size() == 2) {
+            apply_tick_blackboard_inputs(*inst, args[1]);
+        }
+        if (bt::tick_due(*inst, std::chrono::steady_clock::now()) == 0) {
+            ++inst->wake_skip_count;
+            return make_nil();
+        }
+        return status_to_symbol(host.tick_instance(inst_handle));
+    } catch (const lisp_error&) {
+        throw;
+    } catch (const std::exception& e) {
+        throw lisp_error(std::string("bt.tick-if-due: ") + e.what());
+    }
+}
+
+value builtin_bt_wait_for_wake(const std::vector<value>& args) {
+    require_arity("bt.wait-for-wake", args, 2);
+    const std::int64_t inst_handle = require_bt_instance_handle(args[0], "bt.wait-for-wake");
+    const std::int64_t timeout_ms = require_non_negative_int(args[1], "bt.wait-for-wake");
+    bt::instance* inst = bt::default_runtime_host().find_instance(inst_handle);
+    if (!inst) {
+        throw lisp_error("bt.wait-for-wake: unknown instance");
+    }
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    return wake_reasons_to_list(bt::wait_for_wake(*inst, deadline));
+}
+
+value builtin_bt_set_metrics_enabled(const std::vector<value>& args) {
+    require_arity("bt.set-metrics-enabled", args, 1);
+    if (!is_boolean(args[0])) {
+        throw lisp_error("bt.set-metrics-enabled: expected boolean");
+    }
+    bt::default_runtime_host().set_metrics_enabled(boolean_value(args[0]));
+    return make_nil();
+}
+
+value builtin_bt_metrics(const std::vector<value>& args) {
+    require_arity("bt.metrics", args, 0);
+    return make_string(bt::default_runtime_host().render_metrics());
+}
+
+value builtin_bt_metrics_serve(const std::vector<value>& args) {
+    if (args.empty() || args.size() > 2) {
+        throw lisp_error("bt.metrics-serve: expected 1 or 2 arguments");
+    }
+    if (!is_integer(args[0]) || integer_value(args[0]) < 0 || integer_value(args[0]) > 65535) {
+        throw lisp_error("bt.metrics-serve: expected port 0..65535");
+    }
+    std::string bind_address = "127.0.0.1";
+    if (args.size() == 2) {
+        if (!is_string(args[1])) {
+            throw lisp_error("bt.metrics-serve: expected bind address string");
+        }
+        bind_address = string_value(args[1]);
+    }
+    try {
+        const std::uint16_t port = bt::default_runtime_host().start_metrics_endpoint(
+            static_cast<std::uint16_t>(integer_value(args[0])), bind_address);
+        return make_integer(port);
+    } catch (const std::runtime_error& e) {
+        throw lisp_error(std::string("bt.metrics-serve: ") + e.what());
+    }
+}
+
+value builtin_bt_metrics_stop(const std::vector<value>& args) {
+    require_arity("bt.metrics-stop", args, 0);
+    bt::default_runtime_host().stop_metrics_endpoint();
+    return make_nil();
+}
+
+value builtin_bt_set_node_profiling(const std::vector<value>& args) {
+    if (args.size() < 2 || args.size() > 4) {
+        throw lisp_error("bt.set-node-profiling: expected 2 to 4 arguments");
+    }
+    const std::int64_t inst_handle = require_bt_instance_handle(args[0], "bt.set-node-profiling");
+    if (!is_symbol(args[1])) {
+        throw lisp_error("bt.set-node-profiling: expected mode symbol off, sampled or full");
+    }
+
+    bt::node_profiling_options options;
+    const std::string mode = symbol_name(args[1]);
+    if (mode == "off" || mode == "full") {
+        if (args.size() != 2) {
+            throw lisp_error("bt.set-node-profiling: " + mode + " takes no sampling arguments");
+        }
+        options.mode = mode == "off" ? bt::node_profiling_mode::off : bt::node_profiling_mode::full;
+    } else if (mode == "sampled") {
+        options.mode = bt::node_profiling_mode::sampled;
+        for (std::size_t i = 2; i < args.size(); ++i) {
+            if (!is_integer(args[i]) || integer_value(args[i]) < 1) {
+                throw lisp_error("bt.set-node-profiling: expected positive integer sampling arguments");
+            }
+        }
+        if (args.size() > 2) {
+            options.every_n_ticks = static_cast<std::uint32_t>(std::min<std::int64_t>(integer_value(args[2]), std::numeric_limits<std::uint32_t>::max()));
+        }
+        if (args.size() > 3) {
+            if (integer_value(args[3]) > 100) {
+                throw lisp_error("bt.set-node-profiling: node percentage must be at most 100");
+            }
+            options.node_percent = static_cast<std::uint32_t>(integer_value(args[3]));
+        }
+    } else {
+        throw lisp_error("bt.set-node-profiling: expected mode symbol off, sampled or full");
+    }
+
+    bt::instance* inst = bt::default_runtime_host().find_instance(inst_handle);
+    if (!inst) {
+        throw lisp_error("bt.set-node-profiling: unknown instance");
+    }
+    bt::set_node_profiling(*inst, options);
+    return make_nil();
+}
+
 value builtin_hash64(const std::vector<value>& args) {
     require_arity("hash64", args, 1);
     std::string text;
@@ -2357,9 +3945,38 @@ value builtin_hash64(const std::vector<value>& args) {
     return make_integer(static_cast<std::int64_t>(h & 0x7fffffffffffffffull));
 }
 
+value builtin_closure_compile_info(const std::vector<value>& args) {
+    require_arity("closure.compile-info", args, 1);
+    if (!is_closure(args[0])) {
+        throw lisp_error("closure.compile-info: expected closure");
+    }
+    const std::shared_ptr<compiled_closure>& compiled = closure_compiled(args[0]);
+    value out = make_map();
+    gc_root_scope roots(default_gc());
+    roots.add(&out);
+    map_set_symbol(out, "compiled", make_boolean(compiled != nullptr));
+    if (!compiled) {
+        // The reason is not kept with the closure; compiling again reproduces it.
+        std::string reason;
+        (void)try_compile_closure(closure_params(args[0]), closure_body(args[0]), &reason);
+        map_set_symbol(out, "reason", make_string(reason));
+        return out;
+    }
+    map_set_symbol(out, "reason", make_nil());
+    map_set_symbol(out, "instructions", make_integer(static_cast<std::int64_t>(compiled->code.size())));
+    map_set_symbol(out, "locals", make_integer(static_cast<std::int64_t>(compiled->local_count)));
+    map_set_symbol(out, "max_stack", make_integer(static_cast<std::int64_t>(compiled->max_stack)));
+    map_set_symbol(out, "nested_lambdas", make_integer(static_cast<std::int64_t>(compiled->lambdas.size())));
+    return out;
+}
+
 value builtin_json_encode(const std::vector<value>& args) {
     require_arity("json.encode", args, 1);
-    return make_string(value_to_json(args[0]));
+    // Reused across calls so repeated encodes of similar payloads do not regrow a fresh string.
+    thread_local std::string buffer;
+    buffer.clear();
+    append_json(buffer, args[0]);
+    return make_string(buffer);
 }
 
 value builtin_json_decode(const std::vector<value>& args) {
@@ -2385,8 +4002,24 @@ value require_blob_handle_arg(value v, const std::string& where) {
     return v;
 }
 
+// Optional trailing payload of image.make/blob.make; the string's bytes go to the frame ring.
+std::span<const std::byte> optional_payload_arg(const std::vector<value>& args,
+                                                std::size_t index,
+                                                const std::string& where) {
+    if (args.size() <= index) {
+        return {};
+    }
+    if (!is_string(args[index])) {
+        throw lisp_error(where + ": expected string");
+    }
+    const std::string& data = string_value(args[index]);
+    return std::as_bytes(std::span<const char>(data.data(), data.size()));
+}
+
 value builtin_image_make(const std::vector<value>& args) {
-    require_arity("image.make", args, 6);
+    if (args.size() < 6 || args.size() > 7) {
+        throw lisp_error("image.make: expected 6 or 7 arguments");
+    }
     const std::int64_t width = require_int_arg(args[0], "image.make width");
     const std::int64_t height = require_int_arg(args[1], "image.make height");
     const std::int64_t channels = require_int_arg(args[2], "image.make channels");
@@ -2394,21 +4027,35 @@ value builtin_image_make(const std::vector<value>& args) {
     const std::int64_t timestamp_ms = require_int_arg(args[4], "image.make timestamp_ms");
     const std::string frame_id = require_text_value(args[5], "image.make frame_id");
 
-    const bt::image_handle_ref handle = bt::default_runtime_host().vla_ref().create_image(
-        width, height, channels, encoding, timestamp_ms, frame_id);
-    return make_image_handle(handle.id);
+    const std::span<const std::byte> payload = optional_payload_arg(args, 6, "image.make data");
+
+    try {
+        const bt::image_handle_ref handle = bt::default_runtime_host().vla_ref().create_image(
+            width, height, channels, encoding, timestamp_ms, frame_id, payload);
+        return make_image_handle(handle.id);
+    } catch (const std::exception& e) {
+        throw lisp_error(std::string("image.make: ") + e.what());
+    }
 }
 
 value builtin_blob_make(const std::vector<value>& args) {
-    require_arity("blob.make", args, 4);
+    if (args.size() < 4 || args.size() > 5) {
+        throw lisp_error("blob.make: expected 4 or 5 arguments");
+    }
     const std::int64_t size_bytes = require_int_arg(args[0], "blob.make size_bytes");
     const std::string mime_type = require_text_value(args[1], "blob.make mime_type");
     const std::int64_t timestamp_ms = require_int_arg(args[2], "blob.make timestamp_ms");
     const std::string tag = require_text_value(args[3], "blob.make tag");
 
-    const bt::blob_handle_ref handle =
-        bt::default_runtime_host().vla_ref().create_blob(size_bytes, mime_type, timestamp_ms, tag);
-    return make_blob_handle(handle.id);
+    const std::span<const std::byte> payload = optional_payload_arg(args, 4, "blob.make data");
+
+    try {
+        const bt::blob_handle_ref handle =
+            bt::default_runtime_host().vla_ref().create_blob(size_bytes, mime_type, timestamp_ms, tag, payload);
+        return make_blob_handle(handle.id);
+    } catch (const std::exception& e) {
+        throw lisp_error(std::string("blob.make: ") + e.what());
+    }
 }
 
 value builtin_image_info(const std::vector<value>& args) {
@@ -2429,6 +4076,8 @@ value builtin_image_info(const std::vector<value>& args) {
     map_set_symbol(out, "encoding", make_string(info->encoding));
     map_set_symbol(out, "timestamp_ms", make_integer(info->timestamp_ms));
     map_set_symbol(out, "frame_id", make_string(info->frame_id));
+    map_set_symbol(out, "frame_ref", make_string(info->frame_ref));
+    map_set_symbol(out, "in_process", make_boolean(info->in_process));
     return out;
 }
 
@@ -2448,9 +4097,75 @@ value builtin_blob_info(const std::vector<value>& args) {
     map_set_symbol(out, "mime_type", make_string(info->mime_type));
     map_set_symbol(out, "timestamp_ms", make_integer(info->timestamp_ms));
     map_set_symbol(out, "tag", make_string(info->tag));
+    map_set_symbol(out, "frame_ref", make_string(info->frame_ref));
+    map_set_symbol(out, "in_process", make_boolean(info->in_process));
     return out;
 }
 
+value builtin_image_retain(const std::vector<value>& args) {
+    require_arity("image.retain", args, 1);
+    const value image = require_image_handle_arg(args[0], "image.retain");
+    return make_boolean(bt::default_runtime_host().vla_ref().retain_image(bt::image_handle_ref{.id = image_handle_id(image)}));
+}
+
+value builtin_image_release(const std::vector<value>& args) {
+    require_arity("image.release", args, 1);
+    const value image = require_image_handle_arg(args[0], "image.release");
+    return make_boolean(bt::default_runtime_host().vla_ref().release_image(bt::image_handle_ref{.id = image_handle_id(image)}));
+}
+
+value builtin_blob_retain(const std::vector<value>& args) {
+    require_arity("blob.retain", args, 1);
+    const value blob = require_blob_handle_arg(args[0], "blob.retain");
+    return make_boolean(bt::default_runtime_host().vla_ref().retain_blob(bt::blob_handle_ref{.id = blob_handle_id(blob)}));
+}
+
+value builtin_blob_release(const std::vector<value>& args) {
+    require_arity("blob.release", args, 1);
+    const value blob = require_blob_handle_arg(args[0], "blob.release");
+    return make_boolean(bt::default_runtime_host().vla_ref().release_blob(bt::blob_handle_ref{.id = blob_handle_id(blob)}));
+}
+
+value builtin_image_pool_stats(const std::vector<value>& args) {
+    require_arity("image.pool-stats", args, 0);
+    const bt::vla_service& vla = bt::default_runtime_host().vla_ref();
+    const bt::payload_pool_stats stats = vla.payload_pool_ref().stats();
+
+    value out = make_map();
+    gc_root_scope roots(default_gc());
+    roots.add(&out);
+    map_set_symbol(out, "capacity_bytes", make_integer(static_cast<std::int64_t>(stats.capacity_bytes)));
+    map_set_symbol(out, "reserved_bytes", make_integer(static_cast<std::int64_t>(stats.reserved_bytes)));
+    map_set_symbol(out, "in_use_bytes", make_integer(static_cast<std::int64_t>(stats.in_use_bytes)));
+    map_set_symbol(out, "slabs_in_use", make_integer(static_cast<std::int64_t>(stats.slabs_in_use)));
+    map_set_symbol(out, "slabs_free", make_integer(static_cast<std::int64_t>(stats.slabs_free)));
+    map_set_symbol(out, "acquired", make_integer(static_cast<std::int64_t>(stats.acquired)));
+    map_set_symbol(out, "reused", make_integer(static_cast<std::int64_t>(stats.reused)));
+    map_set_symbol(out, "trimmed", make_integer(static_cast<std::int64_t>(stats.trimmed)));
+    map_set_symbol(out, "exhausted", make_integer(static_cast<std::int64_t>(stats.exhausted)));
+    map_set_symbol(out, "live_images", make_integer(static_cast<std::int64_t>(vla.live_images())));
+    map_set_symbol(out, "live_blobs", make_integer(static_cast<std::int64_t>(vla.live_blobs())));
+
+    std::vector<value> classes;
+    classes.reserve(stats.classes.size());
+    for (const bt::payload_pool_class_stats& cls : stats.classes) {
+        classes.push_back(make_map());
+        roots.add(&classes.back());
+        map_set_symbol(classes.back(), "slab_bytes", make_integer(static_cast<std::int64_t>(cls.slab_bytes)));
+        map_set_symbol(classes.back(), "slabs", make_integer(static_cast<std::int64_t>(cls.slabs)));
+        map_set_symbol(classes.back(), "in_use", make_integer(static_cast<std::int64_t>(cls.in_use)));
+    }
+    map_set_symbol(out, "classes", list_from_vector(classes));
+    return out;
+}
+
+value builtin_image_set_pool_capacity(const std::vector<value>& args) {
+    require_arity("image.set-pool-capacity", args, 1);
+    const std::int64_t bytes = require_non_negative_int(args[0], "image.set-pool-capacity");
+    bt::default_runtime_host().vla_ref().payload_pool_ref().set_capacity(static_cast<std::size_t>(bytes));
+    return make_nil();
+}
+
 bt::capability_descriptor echo_capability_descriptor() {
     bt::capability_descriptor cap;
     cap.name = "cap.echo.v1";
@@ -2865,9 +4580,21 @@ value builtin_cap_call(const std::vector<value>& args) {
     return out;
 }
 
+// unix:// endpoints reach a bt::model_service_mux and need no bridge; the others are websocket
+// endpoints of the optional bridge.
+std::unique_ptr<bt::model_service_client> make_model_service_client(const bt::model_service_config& config) {
+    if (bt::is_unix_model_service_endpoint(config.endpoint)) {
+        return bt::make_unix_model_service_client(config);
+    }
+#if defined(MUESLI_BT_WITH_MODEL_SERVICE_BRIDGE) && MUESLI_BT_WITH_MODEL_SERVICE_BRIDGE
+    return bt::make_websocket_model_service_client(config);
+#else
+    throw std::runtime_error("optional model-service bridge is not built");
+#endif
+}
+
 value builtin_model_service_configure(const std::vector<value>& args) {
     require_arity("model-service.configure", args, 1);
-#if defined(MUESLI_BT_WITH_MODEL_SERVICE_BRIDGE) && MUESLI_BT_WITH_MODEL_SERVICE_BRIDGE
     const value config_map = require_map_arg(args[0], "model-service.configure");
     bt::model_service_config config;
     config.endpoint = map_lookup_text_or(config_map, "endpoint", config.endpoint, "model-service.configure endpoint");
@@ -2881,10 +4608,53 @@ value builtin_model_service_configure(const std::vector<value>& args) {
                                             "model-service.configure replay_mode");
     config.replay_cache_path = map_lookup_text_or(config_map, "replay_cache_path", config.replay_cache_path,
                                                   "model-service.configure replay_cache_path");
+    config.replay_cache_format = map_lookup_text_or(config_map, "replay_cache_format", config.replay_cache_format,
+                                                    "model-service.configure replay_cache_format");
+    if (config.replay_cache_format != "files" && config.replay_cache_format != "indexed") {
+        throw lisp_error("model-service.configure replay_cache_format: expected \"files\" or \"indexed\"");
+    }
     config.fault_schedule = split_csv_text(map_lookup_text_or(config_map,
                                                               "fault_schedule",
                                                               join_csv_text(config.fault_schedule),
                                                               "model-service.configure fault_schedule"));
+    const std::int64_t pool_size =
+        map_lookup_int_or(config_map, "connection_pool_size", static_cast<std::int64_t>(config.connection_pool_size),
+                          "model-service.configure connection_pool_size");
+    if (pool_size < 1) {
+        throw lisp_error("model-service.configure connection_pool_size: expected positive integer");
+    }
+    config.connection_pool_size = static_cast<std::size_t>(pool_size);
+    config.batch_window_ms =
+        map_lookup_int_or(config_map, "batch_window_ms", config.batch_window_ms,
+                          "model-service.configure batch_window_ms");
+    if (config.batch_window_ms < 0) {
+        throw lisp_error("model-service.configure batch_window_ms: expected non-negative integer");
+    }
+    config.frame_ring_name = map_lookup_text_or(config_map, "frame_ring_name", config.frame_ring_name,
+                                                "model-service.configure frame_ring_name");
+    const std::int64_t ring_slots =
+        map_lookup_int_or(config_map, "frame_ring_slots", static_cast<std::int64_t>(config.frame_ring_slots),
+                          "model-service.configure frame_ring_slots");
+    const std::int64_t ring_slot_bytes =
+        map_lookup_int_or(config_map, "frame_ring_slot_bytes", static_cast<std::int64_t>(config.frame_ring_slot_bytes),
+                          "model-service.configure frame_ring_slot_bytes");
+    if (ring_slots < 1 || ring_slot_bytes < 1) {
+        throw lisp_error("model-service.configure frame_ring_slots/frame_ring_slot_bytes: expected positive integer");
+    }
+    config.frame_ring_slots = static_cast<std::size_t>(ring_slots);
+    config.frame_ring_slot_bytes = static_cast<std::size_t>(ring_slot_bytes);
+    config.hedge_percentile = map_lookup_number_or(config_map, "hedge_percentile", config.hedge_percentile,
+                                                   "model-service.configure hedge_percentile");
+    if (!(config.hedge_percentile >= 0.0 && config.hedge_percentile < 100.0)) {
+        throw lisp_error("model-service.configure hedge_percentile: expected number in [0, 100)");
+    }
+    config.hedge_min_delay_ms = map_lookup_int_or(config_map, "hedge_min_delay_ms", config.hedge_min_delay_ms,
+                                                  "model-service.configure hedge_min_delay_ms");
+    if (config.hedge_min_delay_ms < 0) {
+        throw lisp_error("model-service.configure hedge_min_delay_ms: expected non-negative integer");
+    }
+    config.hedge_endpoint = map_lookup_text_or(config_map, "hedge_endpoint", config.hedge_endpoint,
+                                               "model-service.configure hedge_endpoint");
     if (const std::optional<value> required_v = map_lookup_option(config_map, "required"); required_v.has_value()) {
         if (!is_boolean(*required_v)) {
             throw lisp_error("model-service.configure required: expected boolean");
@@ -2898,7 +4668,28 @@ value builtin_model_service_configure(const std::vector<value>& args) {
         }
         check_compatibility = boolean_value(*check_v);
     }
-    bt::default_runtime_host().set_model_service_client(config, bt::make_websocket_model_service_client(config));
+    bool check_on_first_use = false;
+    if (const std::optional<value> lazy_v = map_lookup_option(config_map, "check_on_first_use"); lazy_v.has_value()) {
+        if (!is_boolean(*lazy_v)) {
+            throw lisp_error("model-service.configure check_on_first_use: expected boolean");
+        }
+        check_on_first_use = boolean_value(*lazy_v);
+    }
+    try {
+        std::unique_ptr<bt::model_service_client> hedge_client;
+        if (!config.hedge_endpoint.empty()) {
+            bt::model_service_config hedge_config = config;
+            hedge_config.endpoint = config.hedge_endpoint;
+            hedge_client = make_model_service_client(hedge_config);
+        }
+        bt::default_runtime_host().set_model_service_client(
+            config, make_model_service_client(config), std::move(hedge_client));
+    } catch (const std::runtime_error& e) {
+        throw lisp_error(std::string("model-service.configure: ") + e.what());
+    }
+    if (check_on_first_use && !check_compatibility) {
+        bt::default_runtime_host().check_model_service_on_first_use();
+    }
     if (check_compatibility) {
         const bt::model_service_compatibility_result check =
             bt::default_runtime_host().check_model_service_compatibility();
@@ -2908,10 +4699,6 @@ value builtin_model_service_configure(const std::vector<value>& args) {
         }
     }
     return make_boolean(true);
-#else
-    (void)args;
-    throw lisp_error("model-service.configure: optional model-service bridge is not built");
-#endif
 }
 
 value builtin_model_service_check(const std::vector<value>& args) {
@@ -2936,10 +4723,22 @@ value builtin_model_service_info(const std::vector<value>& args) {
     map_set_symbol(out, "endpoint", make_string(config.endpoint));
     map_set_symbol(out, "connect_timeout_ms", make_integer(config.connect_timeout_ms));
     map_set_symbol(out, "request_timeout_ms", make_integer(config.request_timeout_ms));
+    map_set_symbol(out, "connection_pool_size", make_integer(static_cast<std::int64_t>(config.connection_pool_size)));
     map_set_symbol(out, "required", make_boolean(config.required));
     map_set_symbol(out, "replay_mode", make_string(config.replay_mode));
     map_set_symbol(out, "replay_cache_path", make_string(config.replay_cache_path));
+    map_set_symbol(out, "replay_cache_format", make_string(config.replay_cache_format));
     map_set_symbol(out, "fault_schedule", make_string(join_csv_text(config.fault_schedule)));
+    map_set_symbol(out, "batch_window_ms", make_integer(config.batch_window_ms));
+    map_set_symbol(out, "frame_ring_name", make_string(config.frame_ring_name));
+    map_set_symbol(out, "frame_ring_slots", make_integer(static_cast<std::int64_t>(config.frame_ring_slots)));
+    map_set_symbol(out, "frame_ring_slot_bytes", make_integer(static_cast<std::int64_t>(config.frame_ring_slot_bytes)));
+    map_set_symbol(out, "hedge_percentile", make_float(config.hedge_percentile));
+    map_set_symbol(out, "hedge_min_delay_ms", make_integer(config.hedge_min_delay_ms));
+    map_set_symbol(out, "hedge_endpoint", make_string(config.hedge_endpoint));
+    const bt::model_service_hedge_stats hedge = host.model_service_hedge_stats_snapshot();
+    map_set_symbol(out, "hedged", make_integer(static_cast<std::int64_t>(hedge.hedged)));
+    map_set_symbol(out, "hedge_wins", make_integer(static_cast<std::int64_t>(hedge.hedge_wins)));
     return out;
 }
 
@@ -3005,7 +4804,7 @@ bt::planner_action planner_action_from_lisp(value action_v, const std::string& w
     }
     bt::planner_action action;
     action.action_schema = require_text_value(*schema_v, where + " action_schema");
-    action.u = lisp_to_numeric_vector(*u_v, where + " u");
+    action.u = lisp_to_planner_vector(*u_v, where + " u");
     return action;
 }
 
@@ -3072,7 +4871,7 @@ bt::planner_request parse_planner_request_map(value request_map) {
     if (!state_v.has_value()) {
         throw lisp_error("planner.plan: missing required state");
     }
-    request.state = lisp_to_numeric_vector(*state_v, "planner.plan state");
+    request.state = lisp_to_planner_vector(*state_v, "planner.plan state");
 
     const std::optional<value> budget_v = map_lookup_option(request_map, "budget_ms");
     if (!budget_v.has_value()) {
@@ -3112,6 +4911,9 @@ bt::planner_request parse_planner_request_map(value request_map) {
     if (const std::optional<value> top_k_v = map_lookup_option(request_map, "top_k"); top_k_v.has_value()) {
         request.top_k = require_int_arg(*top_k_v, "planner.plan top_k");
     }
+    if (const std::optional<value> quantum_v = map_lookup_option(request_map, "cache_quantum"); quantum_v.has_value()) {
+        request.cache_quantum = require_number_value(*quantum_v, "planner.plan cache_quantum");
+    }
 
     if (const std::optional<value> bounds_v = map_lookup_option(request_map, "bounds"); bounds_v.has_value()) {
         const std::vector<std::pair<double, double>> rows = lisp_to_bounds(*bounds_v, "planner.plan bounds");
@@ -3128,7 +4930,7 @@ bt::planner_request parse_planner_request_map(value request_map) {
         constraints_v.has_value()) {
         const value constraints_map = require_map_arg(*constraints_v, "planner.plan constraints");
         if (const std::optional<value> max_du_v = map_lookup_option(constraints_map, "max_du"); max_du_v.has_value()) {
-            request.constraints.max_du = lisp_to_numeric_vector(*max_du_v, "planner.plan constraints.max_du");
+            request.constraints.max_du = lisp_to_planner_vector(*max_du_v, "planner.plan constraints.max_du");
         }
         if (const std::optional<value> smooth_v = map_lookup_option(constraints_map, "smoothness_weight");
             smooth_v.has_value()) {
@@ -3180,6 +4982,11 @@ bt::planner_request parse_planner_request_map(value request_map) {
             map_lookup_text_or(cfg_map, "rollout_policy", request.mcts.rollout_policy, "planner.plan mcts rollout_policy");
         request.mcts.action_sampler =
             map_lookup_text_or(cfg_map, "action_sampler", request.mcts.action_sampler, "planner.plan mcts action_sampler");
+        request.mcts.parallelism =
+            map_lookup_text_or(cfg_map, "parallelism", request.mcts.parallelism, "planner.plan mcts parallelism");
+        request.mcts.threads = map_lookup_int_or(cfg_map, "threads", request.mcts.threads, "planner.plan mcts threads");
+        request.mcts.virtual_loss =
+            map_lookup_number_or(cfg_map, "virtual_loss", request.mcts.virtual_loss, "planner.plan mcts virtual_loss");
     }
 
     if (const std::optional<value> mppi_v = map_lookup_option(request_map, "mppi"); mppi_v.has_value()) {
@@ -3188,15 +4995,16 @@ bt::planner_request parse_planner_request_map(value request_map) {
         request.mppi.n_samples =
             map_lookup_int_or(cfg_map, "n_samples", request.mppi.n_samples, "planner.plan mppi n_samples");
         request.mppi.n_elite = map_lookup_int_or(cfg_map, "n_elite", request.mppi.n_elite, "planner.plan mppi n_elite");
+        request.mppi.threads = map_lookup_int_or(cfg_map, "threads", request.mppi.threads, "planner.plan mppi threads");
         if (const std::optional<value> sigma_v = map_lookup_option(cfg_map, "sigma"); sigma_v.has_value()) {
-            request.mppi.sigma = lisp_to_numeric_vector(*sigma_v, "planner.plan mppi sigma");
+            request.mppi.sigma = lisp_to_planner_vector(*sigma_v, "planner.plan mppi sigma");
         }
         if (const std::optional<value> u_init_v = map_lookup_option(cfg_map, "u_init"); u_init_v.has_value()) {
-            request.mppi.u_init = lisp_to_numeric_vector(*u_init_v, "planner.plan mppi u_init");
+            request.mppi.u_init = lisp_to_planner_vector(*u_init_v, "planner.plan mppi u_init");
         }
         if (const std::optional<value> u_nominal_v = map_lookup_option(cfg_map, "u_nominal");
             u_nominal_v.has_value()) {
-            request.mppi.u_nominal = lisp_to_numeric_vector(*u_nominal_v, "planner.plan mppi u_nominal");
+            request.mppi.u_nominal = lisp_to_planner_vector(*u_nominal_v, "planner.plan mppi u_nominal");
         }
     }
 
@@ -3213,11 +5021,12 @@ bt::planner_request parse_planner_request_map(value request_map) {
         request.ilqr.tol_grad =
             map_lookup_number_or(cfg_map, "tol_grad", request.ilqr.tol_grad, "planner.plan ilqr tol_grad");
         request.ilqr.fd_eps = map_lookup_number_or(cfg_map, "fd_eps", request.ilqr.fd_eps, "planner.plan ilqr fd_eps");
+        request.ilqr.threads = map_lookup_int_or(cfg_map, "threads", request.ilqr.threads, "planner.plan ilqr threads");
         if (const std::optional<value> mode_v = map_lookup_option(cfg_map, "derivatives"); mode_v.has_value()) {
             request.ilqr.derivatives = planner_derivatives_mode_from_value(*mode_v, "planner.plan ilqr derivatives");
         }
         if (const std::optional<value> u_init_v = map_lookup_option(cfg_map, "u_init"); u_init_v.has_value()) {
-            request.ilqr.u_init = lisp_to_numeric_vector(*u_init_v, "planner.plan ilqr u_init");
+            request.ilqr.u_init = lisp_to_planner_vector(*u_init_v, "planner.plan ilqr u_init");
         }
     }
 
@@ -3265,6 +5074,7 @@ value builtin_planner_plan(const std::vector<value>& args) {
         map_set_symbol(trace, "root_visits", make_integer(result.trace.mcts.root_visits));
         map_set_symbol(trace, "root_children", make_integer(result.trace.mcts.root_children));
         map_set_symbol(trace, "widen_added", make_integer(result.trace.mcts.widen_added));
+        map_set_symbol(trace, "reused_visits", make_integer(result.trace.mcts.reused_visits));
         std::vector<value> entries;
         entries.reserve(result.trace.mcts.top_k.size());
         for (const bt::planner_top_choice_mcts& top : result.trace.mcts.top_k) {
@@ -3307,6 +5117,8 @@ value builtin_planner_plan(const std::vector<value>& args) {
         map_set_symbol(trace, "cost_init", make_float(result.trace.ilqr.cost_init));
         map_set_symbol(trace, "cost_final", make_float(result.trace.ilqr.cost_final));
         map_set_symbol(trace, "reg_final", make_float(result.trace.ilqr.reg_final));
+        map_set_symbol(trace, "warm_started", make_boolean(result.trace.ilqr.warm_started));
+        map_set_symbol(trace, "iters_saved", make_integer(result.trace.ilqr.iters_saved));
         if (!result.trace.ilqr.top_k.empty()) {
             std::vector<value> entries;
             entries.reserve(result.trace.ilqr.top_k.size());
@@ -3352,6 +5164,53 @@ value builtin_planner_get_base_seed(const std::vector<value>& args) {
     return make_integer(static_cast<std::int64_t>(seed & 0x7fffffffffffffffull));
 }
 
+value builtin_planner_define_model(const std::vector<value>& args) {
+    require_arity("planner.define-model", args, 2);
+    const std::string name = require_text_value(args[0], "planner.define-model name");
+    const value spec = require_map_arg(args[1], "planner.define-model");
+
+    bt::planner_model_definition def;
+    const std::int64_t state_dim = map_lookup_int_or(spec, "state_dim", 0, "planner.define-model state_dim");
+    if (state_dim <= 0) {
+        throw lisp_error("planner.define-model: state_dim must be a positive integer");
+    }
+    def.state_dim = static_cast<std::size_t>(state_dim);
+    const std::optional<value> bounds_v = map_lookup_option(spec, "bounds");
+    if (!bounds_v.has_value()) {
+        throw lisp_error("planner.define-model: missing bounds");
+    }
+    for (const auto& [lo, hi] : lisp_to_bounds(*bounds_v, "planner.define-model bounds")) {
+        bt::planner_bound b;
+        b.lo = lo;
+        b.hi = hi;
+        def.action_bounds.push_back(b);
+    }
+    const std::optional<value> next_v = map_lookup_option(spec, "next");
+    if (!next_v.has_value() || !is_proper_list(*next_v)) {
+        throw lisp_error("planner.define-model: next must be a list of expressions, one per state dimension");
+    }
+    def.next_state = vector_from_list(*next_v);
+    const std::optional<value> cost_v = map_lookup_option(spec, "cost");
+    if (!cost_v.has_value()) {
+        throw lisp_error("planner.define-model: missing cost");
+    }
+    def.cost = *cost_v;
+    if (const std::optional<value> done_v = map_lookup_option(spec, "done"); done_v.has_value() && !is_nil(*done_v)) {
+        def.done = *done_v;
+    }
+    def.default_horizon = map_lookup_int_or(spec, "horizon", 0, "planner.define-model horizon");
+    def.default_dt_ms = map_lookup_int_or(spec, "dt_ms", 0, "planner.define-model dt_ms");
+
+    std::shared_ptr<bt::planner_model> model;
+    try {
+        model = bt::compile_planner_model(name, def);
+    } catch (const std::exception& e) {
+        throw lisp_error(std::string("planner.define-model: ") + e.what());
+    }
+    bt::default_runtime_host().planner_ref().register_model(name, std::move(model));
+    return make_string(name);
+}
+
 }  // namespace
 
 void install_core_builtins(env_ptr global_env) {
@@ -3394,17 +5253,27 @@ void install_core_builtins(env_ptr global_env) {
     bind_primitive(global_env, "time.now-ms", builtin_time_now_ms);
     bind_primitive(global_env, "time.sleep-ms", builtin_time_sleep_ms);
     bind_primitive(global_env, "hash64", builtin_hash64);
+    bind_primitive(global_env, "closure.compile-info", builtin_closure_compile_info);
     bind_primitive(global_env, "json.encode", builtin_json_encode);
     bind_primitive(global_env, "json.decode", builtin_json_decode);
     bind_primitive(global_env, "image.make", builtin_image_make);
     bind_primitive(global_env, "image.info", builtin_image_info);
+    bind_primitive(global_env, "image.retain", builtin_image_retain);
+    bind_primitive(global_env, "image.release", builtin_image_release);
+    bind_primitive(global_env, "image.pool-stats", builtin_image_pool_stats);
+    bind_primitive(global_env, "image.set-pool-capacity", builtin_image_set_pool_capacity);
     bind_primitive(global_env, "blob.make", builtin_blob_make);
     bind_primitive(global_env, "blob.info", builtin_blob_info);
+    bind_primitive(global_env, "blob.retain", builtin_blob_retain);
+    bind_primitive(global_env, "blob.release", builtin_blob_release);
 
     bind_primitive(global_env, "rng.make", builtin_rng_make);
     bind_primitive(global_env, "rng.uniform", builtin_rng_uniform);
     bind_primitive(global_env, "rng.normal", builtin_rng_normal);
     bind_primitive(global_env, "rng.int", builtin_rng_int);
+    bind_primitive(global_env, "rng.fill-uniform!", builtin_rng_fill_uniform);
+    bind_primitive(global_env, "rng.fill-normal!", builtin_rng_fill_normal);
+    bind_primitive(global_env, "rng.fill-int!", builtin_rng_fill_int);
     bind_primitive(global_env, "cap.list", builtin_cap_list);
     bind_primitive(global_env, "cap.describe", builtin_cap_describe);
     bind_primitive(global_env, "cap.call", builtin_cap_call);
@@ -3416,15 +5285,25 @@ void install_core_builtins(env_ptr global_env) {
     bind_primitive(global_env, "vla.poll", builtin_vla_poll);
     bind_primitive(global_env, "vla.cancel", builtin_vla_cancel);
     bind_primitive(global_env, "planner.plan", builtin_planner_plan);
+    bind_primitive(global_env, "planner.define-model", builtin_planner_define_model);
     bind_primitive(global_env, "planner.set-base-seed", builtin_planner_set_base_seed);
     bind_primitive(global_env, "planner.get-base-seed", builtin_planner_get_base_seed);
     bind_primitive(global_env, "events.enable", builtin_events_enable);
     bind_primitive(global_env, "events.set-path", builtin_events_set_path);
     bind_primitive(global_env, "events.set-ring-size", builtin_events_set_ring_size);
     bind_primitive(global_env, "events.set-flush-each-message", builtin_events_set_flush_each_message);
+    bind_primitive(global_env, "events.set-file-async", builtin_events_set_file_async);
+    bind_primitive(global_env, "events.set-file-index", builtin_events_set_file_index);
+    bind_primitive(global_env, "events.set-file-rotation", builtin_events_set_file_rotation);
+    bind_primitive(global_env, "events.set-binary-path", builtin_events_set_binary_path);
+    bind_primitive(global_env, "events.set-net-sink", builtin_events_set_net_sink);
+    bind_primitive(global_env, "events.net-stats", builtin_events_net_stats);
+    bind_primitive(global_env, "events.set-policy", builtin_events_set_policy);
     bind_primitive(global_env, "events.enable-tick-audit", builtin_events_enable_tick_audit);
     bind_primitive(global_env, "events.dump", builtin_events_dump);
     bind_primitive(global_env, "events.snapshot-bb", builtin_events_snapshot_bb);
+    bind_primitive(global_env, "events.set-bb-deltas", builtin_events_set_bb_deltas);
+    bind_primitive(global_env, "events.set-compact-ids", builtin_events_set_compact_ids);
     install_env_capability_builtins(global_env);
 
     bind_primitive(global_env, "vec.make", builtin_vec_make);
@@ -3436,6 +5315,21 @@ void install_core_builtins(env_ptr global_env) {
     bind_primitive(global_env, "vec.clear!", builtin_vec_clear);
     bind_primitive(global_env, "vec.reserve!", builtin_vec_reserve);
 
+    bind_primitive(global_env, "f64vec.make", builtin_f64vec_make);
+    bind_primitive(global_env, "f64vec.from", builtin_f64vec_from);
+    bind_primitive(global_env, "f64vec.to-list", builtin_f64vec_to_list);
+    bind_primitive(global_env, "f64vec.len", builtin_f64vec_len);
+    bind_primitive(global_env, "f64vec.get", builtin_f64vec_get);
+    bind_primitive(global_env, "f64vec.set!", builtin_f64vec_set);
+    bind_primitive(global_env, "f64vec.add", builtin_f64vec_add);
+    bind_primitive(global_env, "f64vec.mul", builtin_f64vec_mul);
+    bind_primitive(global_env, "f64vec.scale", builtin_f64vec_scale);
+    bind_primitive(global_env, "f64vec.dot", builtin_f64vec_dot);
+    bind_primitive(global_env, "f64vec.norm", builtin_f64vec_norm);
+    bind_primitive(global_env, "f64vec.min", builtin_f64vec_min);
+    bind_primitive(global_env, "f64vec.max", builtin_f64vec_max);
+    bind_primitive(global_env, "f64vec.argmax", builtin_f64vec_argmax);
+
     bind_primitive(global_env, "map.make", builtin_map_make);
     bind_primitive(global_env, "map.get", builtin_map_get);
     bind_primitive(global_env, "map.has?", builtin_map_has);
@@ -3443,41 +5337,112 @@ void install_core_builtins(env_ptr global_env) {
     bind_primitive(global_env, "map.del!", builtin_map_del);
     bind_primitive(global_env, "map.keys", builtin_map_keys);
 
+    bind_primitive(global_env, "pmap.make", builtin_pmap_make);
+    bind_primitive(global_env, "pmap.count", builtin_pmap_count);
+    bind_primitive(global_env, "pmap.get", builtin_pmap_get);
+    bind_primitive(global_env, "pmap.has?", builtin_pmap_has);
+    bind_primitive(global_env, "pmap.set", builtin_pmap_set);
+    bind_primitive(global_env, "pmap.del", builtin_pmap_del);
+    bind_primitive(global_env, "pmap.keys", builtin_pmap_keys);
+    bind_primitive(global_env, "pmap.from-map", builtin_pmap_from_map);
+    bind_primitive(global_env, "pmap.transient", builtin_pmap_transient);
+    bind_primitive(global_env, "pmap.set!", builtin_pmap_set_bang);
+    bind_primitive(global_env, "pmap.del!", builtin_pmap_del_bang);
+    bind_primitive(global_env, "pmap.persistent!", builtin_pmap_persistent);
+
+    bind_primitive(global_env, "pvec.make", builtin_pvec_make);
+    bind_primitive(global_env, "pvec.len", builtin_pvec_len);
+    bind_primitive(global_env, "pvec.get", builtin_pvec_get);
+    bind_primitive(global_env, "pvec.set", builtin_pvec_set);
+    bind_primitive(global_env, "pvec.push", builtin_pvec_push);
+    bind_primitive(global_env, "pvec.pop", builtin_pvec_pop);
+    bind_primitive(global_env, "pvec.from-list", builtin_pvec_from_list);
+    bind_primitive(global_env, "pvec.transient", builtin_pvec_transient);
+    bind_primitive(global_env, "pvec.set!", builtin_pvec_set_bang);
+    bind_primitive(global_env, "pvec.push!", builtin_pvec_push_bang);
+    bind_primitive(global_env, "pvec.pop!", builtin_pvec_pop_bang);
+    bind_primitive(global_env, "pvec.persistent!", builtin_pvec_persistent);
+
     bind_primitive(global_env, "pq.make", builtin_pq_make);
     bind_primitive(global_env, "pq.len", builtin_pq_len);
     bind_primitive(global_env, "pq.empty?", builtin_pq_empty);
     bind_primitive(global_env, "pq.push!", builtin_pq_push);
     bind_primitive(global_env, "pq.peek", builtin_pq_peek);
     bind_primitive(global_env, "pq.pop!", builtin_pq_pop);
+    bind_primitive(global_env, "pq.insert!", builtin_pq_insert);
+    bind_primitive(global_env, "pq.update!", builtin_pq_update);
+    bind_primitive(global_env, "pq.remove!", builtin_pq_remove);
+    bind_primitive(global_env, "pq.from-list", builtin_pq_from_list);
 
     bind_primitive(global_env, "heap-stats", builtin_heap_stats);
     bind_primitive(global_env, "gc-stats", builtin_gc_stats);
     bind_primitive(global_env, "gc.policy", builtin_gc_policy);
     bind_primitive(global_env, "gc.set-policy!", builtin_gc_set_policy);
+    bind_primitive(global_env, "gc.limits", builtin_gc_limits);
+    bind_primitive(global_env, "gc.set-limits!", builtin_gc_set_limits);
 
     bind_primitive(global_env, "print", builtin_print);
     bind_primitive(global_env, "write", builtin_write);
     bind_primitive(global_env, "write-to-string", builtin_write_to_string);
     bind_primitive(global_env, "save", builtin_save);
+    bind_primitive(global_env, "snapshot.save", [global_env](const std::vector<value>& args) {
+        require_arity("snapshot.save", args, 1);
+        const snapshot_stats stats = save_snapshot(global_env, require_path_arg(args[0], "snapshot.save"));
+        return make_integer(static_cast<std::int64_t>(stats.bindings));
+    });
+    bind_primitive(global_env, "snapshot.load", [global_env](const std::vector<value>& args) {
+        require_arity("snapshot.load", args, 1);
+        const snapshot_stats stats = load_snapshot(global_env, require_path_arg(args[0], "snapshot.load"));
+        return make_integer(static_cast<std::int64_t>(stats.bindings));
+    });
 
     bind_primitive(global_env, "bt.compile", builtin_bt_compile);
     bind_primitive(global_env, "bt.to-dsl", builtin_bt_to_dsl);
     bind_primitive(global_env, "bt.save-dsl", builtin_bt_save_dsl);
     bind_primitive(global_env, "bt.export-dot", builtin_bt_export_dot);
     bind_primitive(global_env, "bt.load-dsl", builtin_bt_load_dsl);
+    bind_primitive(global_env, "bt.load-dsl-files", builtin_bt_load_dsl_files);
     bind_primitive(global_env, "bt.save", builtin_bt_save_binary);
     bind_primitive(global_env, "bt.load", builtin_bt_load_binary);
     bind_primitive(global_env, "bt.new-instance", builtin_bt_new_instance);
     bind_primitive(global_env, "bt.tick", builtin_bt_tick);
+    bind_primitive(global_env, "bt.tick-all", builtin_bt_tick_all);
+    bind_primitive(global_env, "bt.set-tick-workers", builtin_bt_set_tick_workers);
     bind_primitive(global_env, "bt.reset", builtin_bt_reset);
+    bind_primitive(global_env, "bt.swap-definition", builtin_bt_swap_definition);
+    bind_primitive(global_env, "bt.fork", builtin_bt_fork);
+    bind_primitive(global_env, "bt.release-instance", builtin_bt_release_instance);
+    bind_primitive(global_env, "bt.set-trace-capacity", builtin_bt_set_trace_capacity);
+    bind_primitive(global_env, "bt.replay-log", builtin_bt_replay_log);
+    bind_primitive(global_env, "bt.checkpoint", builtin_bt_checkpoint);
+    bind_primitive(global_env, "bt.restore", builtin_bt_restore);
     bind_primitive(global_env, "bt.status->symbol", builtin_bt_status_to_symbol);
 
     bind_primitive(global_env, "bt.stats", builtin_bt_stats);
+    bind_primitive(global_env, "bt.flamegraph", builtin_bt_flamegraph);
+    bind_primitive(global_env, "bt.latency-histogram", builtin_bt_latency_histogram);
     bind_primitive(global_env, "bt.blackboard.dump", builtin_bt_blackboard_dump);
     bind_primitive(global_env, "bt.blackboard.get", builtin_bt_blackboard_get);
+    bind_primitive(global_env, "bt.blackboard.get-f64vec", builtin_bt_blackboard_get_f64vec);
+    bind_primitive(global_env, "bt.blackboard.track-history", builtin_bt_blackboard_track_history);
+    bind_primitive(global_env, "bt.blackboard.history", builtin_bt_blackboard_history);
+    bind_primitive(global_env, "bt.blackboard.at-tick", builtin_bt_blackboard_at_tick);
+    bind_primitive(global_env, "bt.blackboard.window-mean", builtin_bt_blackboard_window_mean);
+    bind_primitive(global_env, "bt.blackboard.window-min", builtin_bt_blackboard_window_min);
+    bind_primitive(global_env, "bt.blackboard.window-max", builtin_bt_blackboard_window_max);
     bind_primitive(global_env, "bt.scheduler.stats", builtin_bt_scheduler_stats);
+    bind_primitive(global_env, "bt.memory-report", builtin_bt_memory_report);
 
     bind_primitive(global_env, "bt.set-tick-budget-ms", builtin_bt_set_tick_budget_ms);
+    bind_primitive(global_env, "bt.set-incremental-tick", builtin_bt_set_incremental_tick);
+    bind_primitive(global_env, "bt.set-tick-on-demand", builtin_bt_set_tick_on_demand);
+    bind_primitive(global_env, "bt.tick-if-due", builtin_bt_tick_if_due);
+    bind_primitive(global_env, "bt.wait-for-wake", builtin_bt_wait_for_wake);
+    bind_primitive(global_env, "bt.set-metrics-enabled", builtin_bt_set_metrics_enabled);
+    bind_primitive(global_env, "bt.metrics", builtin_bt_metrics);
+    bind_primitive(global_env, "bt.metrics-serve", builtin_bt_metrics_serve);
+    bind_primitive(global_env, "bt.metrics-stop", builtin_bt_metrics_stop);
+    bind_primitive(global_env, "bt.set-node-profiling", builtin_bt_set_node_profiling);
 }
 
 }  // namespace muslisp
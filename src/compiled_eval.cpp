@@ -1,9 +1,11 @@
 #include "compiled_eval.hpp"
 
-#include <deque>
+#include <algorithm>
 #include <optional>
+#include <span>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -20,46 +22,105 @@ bool is_symbol_named(value v, const std::string& name) {
 
 struct compile_scope {
     std::unordered_map<std::string, std::size_t> locals;
+    // Names bound at this level: the closure's parameters or a let's bindings, plus names defined in
+    // that body. A define of one of them rebinds its slot.
+    std::unordered_set<std::string> level;
     std::size_t next_slot = 0;
 };
 
-class rooted_value_stack {
+// One closure body being compiled. A nested lambda gets its own unit, whose free names are resolved
+// against the enclosing unit's scope at the point where the lambda appears.
+struct compile_unit {
+    explicit compile_unit(compiled_closure& code) : out(code) {}
+
+    compiled_closure& out;
+    compile_unit* enclosing = nullptr;
+    const compile_scope* enclosing_scope = nullptr;
+    std::vector<compiled_capture> captures;
+    std::unordered_set<std::string> capture_names;
+    // Every name the body refers to without binding it (captures and globals).
+    std::unordered_set<std::string> free_names;
+    // Free names of the nested lambdas made so far; a later define of one of them is not compiled.
+    std::unordered_set<std::string> lambda_free_names;
+    std::string failure;
+};
+
+// Locals and operands of one compiled frame live in a single buffer sized from the closure's computed
+// `max_stack`. The GC scans it as one root stack ([base, top)), so push/pop are plain pointer moves.
+class vm_frame {
 public:
+    vm_frame(std::size_t local_count, std::size_t max_stack)
+        : slots_(local_count + max_stack, make_nil()),
+          local_count_(local_count),
+          stack_base_(slots_.data() + local_count),
+          stack_limit_(slots_.data() + slots_.size()),
+          top_(stack_base_) {
+        default_gc().add_root_stack(slots_.data(), &top_);
+    }
+
+    ~vm_frame() { default_gc().remove_root_range(slots_.data()); }
+
+    vm_frame(const vm_frame&) = delete;
+    vm_frame& operator=(const vm_frame&) = delete;
+
+    [[nodiscard]] std::size_t local_count() const noexcept { return local_count_; }
+    value& local(std::size_t index) { return slots_[index]; }
+
     void push(value v) {
-        values_.push_back(v);
-        default_gc().add_root_slot(&values_.back());
+        if (top_ == stack_limit_) {
+            throw eval_error("compiled closure: stack overflow");
+        }
+        *top_++ = v;
     }
 
-    [[nodiscard]] bool empty() const noexcept { return values_.empty(); }
-    [[nodiscard]] std::size_t size() const noexcept { return values_.size(); }
+    [[nodiscard]] bool empty() const noexcept { return top_ == stack_base_; }
+    [[nodiscard]] std::size_t size() const noexcept { return static_cast<std::size_t>(top_ - stack_base_); }
 
     value pop() {
-        if (values_.empty()) {
+        if (empty()) {
             throw eval_error("compiled closure: stack underflow");
         }
-        value out = values_.back();
-        default_gc().remove_root_slot(&values_.back());
-        values_.pop_back();
-        return out;
+        return *--top_;
     }
 
-    void discard() {
-        if (values_.empty()) {
+    void discard() { (void)pop(); }
+
+    value& top() {
+        if (empty()) {
             throw eval_error("compiled closure: stack underflow");
         }
-        default_gc().remove_root_slot(&values_.back());
-        values_.pop_back();
+        return top_[-1];
     }
 
-    value& top() {
-        if (values_.empty()) {
+    // Value `depth` slots below the top (0 is the top).
+    [[nodiscard]] value peek(std::size_t depth) const {
+        if (depth >= size()) {
+            throw eval_error("compiled closure: stack underflow");
+        }
+        return top_[-1 - static_cast<std::ptrdiff_t>(depth)];
+    }
+
+    // The top `count` values, bottom first. They stay on (and rooted by) the stack until dropped.
+    [[nodiscard]] std::span<const value> top_span(std::size_t count) const {
+        if (count > size()) {
             throw eval_error("compiled closure: stack underflow");
         }
-        return values_.back();
+        return {top_ - static_cast<std::ptrdiff_t>(count), count};
+    }
+
+    void drop(std::size_t count) {
+        if (count > size()) {
+            throw eval_error("compiled closure: stack underflow");
+        }
+        top_ -= static_cast<std::ptrdiff_t>(count);
     }
 
 private:
-    std::deque<value> values_;
+    std::vector<value> slots_;
+    std::size_t local_count_ = 0;
+    value* stack_base_ = nullptr;
+    value* stack_limit_ = nullptr;
+    value* top_ = nullptr;
 };
 
 void emit(compiled_closure& out,
@@ -75,24 +136,141 @@ void emit(compiled_closure& out,
     out.code.push_back(std::move(instr));
 }
 
-bool compile_expr(value expr, const compile_scope& scope, compiled_closure& out, bool tail_position);
+bool compile_expr(value expr, const compile_scope& scope, compile_unit& unit, bool tail_position);
+bool compile_lambda(std::vector<std::string> params,
+                    std::vector<value> body,
+                    value self_symbol,
+                    const compile_scope& scope,
+                    compile_unit& unit);
+
+bool fail(compile_unit& unit, std::string reason) {
+    if (unit.failure.empty()) {
+        unit.failure = std::move(reason);
+    }
+    return false;
+}
+
+bool parse_lambda_params(value params_expr, std::vector<std::string>& out) {
+    if (!is_proper_list(params_expr)) {
+        return false;
+    }
+    for (value param = params_expr; is_cons(param); param = cdr(param)) {
+        if (!is_symbol(car(param))) {
+            return false;
+        }
+        out.push_back(symbol_name(car(param)));
+    }
+    return true;
+}
+
+void reserve_locals(const compile_scope& scope, compile_unit& unit) {
+    unit.out.local_count = std::max(unit.out.local_count, scope.next_slot);
+}
+
+// True when `name` is bound by an enclosing body, in which case the unit captures it.
+bool resolve_capture(compile_unit& unit, value symbol) {
+    const std::string& name = symbol_name(symbol);
+    unit.free_names.insert(name);
+    if (unit.capture_names.contains(name)) {
+        return true;
+    }
+    if (!unit.enclosing) {
+        return false;
+    }
+    compiled_capture capture;
+    capture.symbol = symbol;
+    if (const auto local = unit.enclosing_scope->locals.find(name); local != unit.enclosing_scope->locals.end()) {
+        capture.slot = local->second;
+    } else if (resolve_capture(*unit.enclosing, symbol)) {
+        capture.from_env = true;
+    } else {
+        return false;
+    }
+    unit.captures.push_back(capture);
+    unit.capture_names.insert(name);
+    return true;
+}
+
+// `(define name expr)` or `(define (name params...) body...)` at the top level of a body. The name gets
+// a local slot for the rest of the body: the one it already has when this level bound it, otherwise a
+// new one that shadows any outer binding, which is how `define` treats the interpreter's envs.
+bool compile_define_form(const std::vector<value>& args, compile_scope& scope, compile_unit& unit) {
+    if (args.size() < 2) {
+        return fail(unit, "define: expected a name and a value");
+    }
+
+    value name = nullptr;
+    bool is_function = false;
+    std::vector<std::string> params;
+    if (is_symbol(args[0])) {
+        if (args.size() != 2) {
+            return fail(unit, "define: expected a name and one value");
+        }
+        name = args[0];
+    } else if (is_cons(args[0]) && is_symbol(car(args[0])) && parse_lambda_params(cdr(args[0]), params)) {
+        name = car(args[0]);
+        is_function = true;
+    } else {
+        return fail(unit, "define: malformed name or function signature");
+    }
+
+    // A lambda made earlier in this body holds the values it saw then, while the interpreter's closure
+    // would see this define, so that combination stays interpreted.
+    const std::string& name_text = symbol_name(name);
+    if (unit.lambda_free_names.contains(name_text)) {
+        return fail(unit, "define of `" + name_text + "` after a nested lambda that refers to it");
+    }
+
+    if (is_function) {
+        std::vector<value> body(args.begin() + 1, args.end());
+        if (!compile_lambda(std::move(params), std::move(body), name, scope, unit)) {
+            return false;
+        }
+    } else if (!compile_expr(args[1], scope, unit, false)) {
+        return false;
+    }
+
+    std::size_t slot = 0;
+    if (scope.level.contains(name_text)) {
+        slot = scope.locals.at(name_text);
+    } else {
+        slot = scope.next_slot++;
+        scope.locals[name_text] = slot;
+        scope.level.insert(name_text);
+        reserve_locals(scope, unit);
+    }
+    emit(unit.out, compiled_opcode::store_local, slot);
+    emit(unit.out, compiled_opcode::load_local, slot);
+    return true;
+}
 
 bool compile_sequence(const std::vector<value>& exprs,
                       const compile_scope& scope,
-                      compiled_closure& out,
-                      bool tail_position) {
+                      compile_unit& unit,
+                      bool tail_position,
+                      bool is_body = false) {
     if (exprs.empty()) {
-        emit(out, compiled_opcode::push_const, 0, make_nil());
+        emit(unit.out, compiled_opcode::push_const, 0, make_nil());
         return true;
     }
 
+    // Only a closure or let body may define names, so each define runs exactly once, in order.
+    compile_scope body_scope = scope;
     for (std::size_t i = 0; i < exprs.size(); ++i) {
         const bool is_last = i + 1 == exprs.size();
-        if (!compile_expr(exprs[i], scope, out, tail_position && is_last)) {
+        const value expr = exprs[i];
+        if (is_cons(expr) && is_symbol_named(car(expr), "define")) {
+            if (!is_body) {
+                return fail(unit, "define is only compiled at the top level of a closure or let body");
+            }
+            if (!is_proper_list(expr) || !compile_define_form(vector_from_list(cdr(expr)), body_scope, unit)) {
+                return fail(unit, "define: expected a proper list");
+            }
+        } else if (!compile_expr(expr, body_scope, unit, tail_position && is_last)) {
             return false;
         }
         if (!is_last) {
-            emit(out, compiled_opcode::pop);
+            emit(unit.out, compiled_opcode::pop);
         }
     }
     return true;
@@ -100,18 +278,19 @@ bool compile_sequence(const std::vector<value>& exprs,
 
 bool compile_if_form(const std::vector<value>& args,
                      const compile_scope& scope,
-                     compiled_closure& out,
+                     compile_unit& unit,
                      bool tail_position) {
     if (args.size() != 2 && args.size() != 3) {
-        return false;
+        return fail(unit, "if: expected 2 or 3 arguments");
     }
-    if (!compile_expr(args[0], scope, out, false)) {
+    compiled_closure& out = unit.out;
+    if (!compile_expr(args[0], scope, unit, false)) {
         return false;
     }
 
     const std::size_t false_jump = out.code.size();
     emit(out, compiled_opcode::jump_if_false, 0);
-    if (!compile_expr(args[1], scope, out, tail_position)) {
+    if (!compile_expr(args[1], scope, unit, tail_position)) {
         return false;
     }
 
@@ -120,7 +299,7 @@ bool compile_if_form(const std::vector<value>& args,
     out.code[false_jump].index = out.code.size();
 
     if (args.size() == 3) {
-        if (!compile_expr(args[2], scope, out, tail_position)) {
+        if (!compile_expr(args[2], scope, unit, tail_position)) {
             return false;
         }
     } else {
@@ -133,8 +312,9 @@ bool compile_if_form(const std::vector<value>& args,
 
 bool compile_and_form(const std::vector<value>& args,
                       const compile_scope& scope,
-                      compiled_closure& out,
+                      compile_unit& unit,
                       bool tail_position) {
+    compiled_closure& out = unit.out;
     if (args.empty()) {
         emit(out, compiled_opcode::push_const, 0, make_boolean(true));
         return true;
@@ -143,7 +323,7 @@ bool compile_and_form(const std::vector<value>& args,
     std::vector<std::size_t> exit_jumps;
     for (std::size_t i = 0; i < args.size(); ++i) {
         const bool is_last = i + 1 == args.size();
-        if (!compile_expr(args[i], scope, out, tail_position && is_last)) {
+        if (!compile_expr(args[i], scope, unit, tail_position && is_last)) {
             return false;
         }
         if (!is_last) {
@@ -162,8 +342,9 @@ bool compile_and_form(const std::vector<value>& args,
 
 bool compile_or_form(const std::vector<value>& args,
                      const compile_scope& scope,
-                     compiled_closure& out,
+                     compile_unit& unit,
                      bool tail_position) {
+    compiled_closure& out = unit.out;
     if (args.empty()) {
         emit(out, compiled_opcode::push_const, 0, make_nil());
         return true;
@@ -172,7 +353,7 @@ bool compile_or_form(const std::vector<value>& args,
     std::vector<std::size_t> exit_jumps;
     for (std::size_t i = 0; i < args.size(); ++i) {
         const bool is_last = i + 1 == args.size();
-        if (!compile_expr(args[i], scope, out, tail_position && is_last)) {
+        if (!compile_expr(args[i], scope, unit, tail_position && is_last)) {
             return false;
         }
         if (!is_last) {
@@ -189,122 +370,265 @@ bool compile_or_form(const std::vector<value>& args,
     return true;
 }
 
+bool compile_cond_form(const std::vector<value>& args,
+                       const compile_scope& scope,
+                       compile_unit& unit,
+                       bool tail_position) {
+    compiled_closure& out = unit.out;
+    std::vector<std::size_t> end_jumps;
+    bool has_else = false;
+    for (std::size_t i = 0; i < args.size(); ++i) {
+        if (!is_proper_list(args[i]) || is_nil(args[i])) {
+            return fail(unit, "cond: each clause must be a non-empty proper list");
+        }
+        const std::vector<value> clause = vector_from_list(args[i]);
+        const std::vector<value> body(clause.begin() + 1, clause.end());
+        if (is_symbol_named(clause[0], "else")) {
+            if (i + 1 != args.size()) {
+                return fail(unit, "cond: else clause must be last");
+            }
+            if (!compile_sequence(body, scope, unit, tail_position)) {
+                return false;
+            }
+            has_else = true;
+            break;
+        }
+
+        if (!compile_expr(clause[0], scope, unit, false)) {
+            return false;
+        }
+        if (body.empty()) {
+            // A clause without a body yields its (truthy) test value.
+            end_jumps.push_back(out.code.size());
+            emit(out, compiled_opcode::jump_if_truthy_keep, 0);
+            emit(out, compiled_opcode::pop);
+            continue;
+        }
+        const std::size_t next_clause = out.code.size();
+        emit(out, compiled_opcode::jump_if_false, 0);
+        if (!compile_sequence(body, scope, unit, tail_position)) {
+            return false;
+        }
+        end_jumps.push_back(out.code.size());
+        emit(out, compiled_opcode::jump, 0);
+        out.code[next_clause].index = out.code.size();
+    }
+    if (!has_else) {
+        emit(out, compiled_opcode::push_const, 0, make_nil());
+    }
+
+    const std::size_t end_target = out.code.size();
+    for (std::size_t jump_index : end_jumps) {
+        out.code[jump_index].index = end_target;
+    }
+    return true;
+}
+
 bool compile_let_form(const std::vector<value>& args,
                       const compile_scope& scope,
-                      compiled_closure& out,
+                      compile_unit& unit,
                       bool tail_position) {
     if (args.size() < 2) {
-        return false;
+        return fail(unit, "let: expected bindings and a body");
     }
     value bindings_expr = args[0];
     if (!is_proper_list(bindings_expr)) {
-        return false;
+        return fail(unit, "let: expected binding list");
     }
 
     const std::vector<value> bindings = vector_from_list(bindings_expr);
     compile_scope body_scope = scope;
+    body_scope.level.clear();
     std::vector<std::pair<value, std::size_t>> compiled_bindings;
     compiled_bindings.reserve(bindings.size());
 
     for (value binding_expr : bindings) {
         if (!is_proper_list(binding_expr)) {
-            return false;
+            return fail(unit, "let: each binding must be a (name expr) pair");
         }
         const std::vector<value> binding_items = vector_from_list(binding_expr);
         if (binding_items.size() != 2 || !is_symbol(binding_items[0])) {
-            return false;
+            return fail(unit, "let: each binding must be a symbol and one expression");
+        }
+        const std::string& name = symbol_name(binding_items[0]);
+        std::size_t slot = 0;
+        if (body_scope.level.contains(name)) {
+            // A repeated name rebinds, as define does in the interpreter's let env.
+            slot = body_scope.locals.at(name);
+        } else {
+            slot = body_scope.next_slot++;
+            body_scope.locals[name] = slot;
+            body_scope.level.insert(name);
         }
-        const std::size_t slot = body_scope.next_slot++;
-        body_scope.locals[symbol_name(binding_items[0])] = slot;
         compiled_bindings.emplace_back(binding_items[1], slot);
     }
-    if (body_scope.next_slot > out.local_count) {
-        out.local_count = body_scope.next_slot;
-    }
+    reserve_locals(body_scope, unit);
 
     for (const auto& [init_expr, slot] : compiled_bindings) {
-        if (!compile_expr(init_expr, scope, out, false)) {
+        if (!compile_expr(init_expr, scope, unit, false)) {
             return false;
         }
-        emit(out, compiled_opcode::store_local, slot);
+        emit(unit.out, compiled_opcode::store_local, slot);
     }
 
     std::vector<value> body(args.begin() + 1, args.end());
-    return compile_sequence(body, body_scope, out, tail_position);
+    return compile_sequence(body, body_scope, unit, tail_position, true);
 }
 
-bool compile_call_form(const std::vector<value>& items,
-                       const compile_scope& scope,
-                       compiled_closure& out,
-                       bool tail_position) {
-    if (items.empty()) {
-        return false;
+// Quasiquote templates are rebuilt on every evaluation, as the interpreter does: make_list gathers runs
+// of elements and append_lists joins them with the spliced lists.
+bool compile_quasiquote(value expr, std::size_t depth, const compile_scope& scope, compile_unit& unit) {
+    compiled_closure& out = unit.out;
+    if (!is_cons(expr)) {
+        emit(out, compiled_opcode::push_const, 0, expr);
+        return true;
+    }
+    if (!is_proper_list(expr)) {
+        return fail(unit, "quasiquote: improper list template");
     }
 
-    if (!compile_expr(items[0], scope, out, false)) {
-        return false;
+    const std::vector<value> items = vector_from_list(expr);
+    const auto wrap = [&](value head, value inner, std::size_t inner_depth) {
+        emit(out, compiled_opcode::push_const, 0, head);
+        if (!compile_quasiquote(inner, inner_depth, scope, unit)) {
+            return false;
+        }
+        emit(out, compiled_opcode::make_list, 2);
+        return true;
+    };
+
+    if (is_symbol_named(items[0], "unquote") || is_symbol_named(items[0], "unquote-splicing") ||
+        is_symbol_named(items[0], "quasiquote")) {
+        if (items.size() != 2) {
+            return fail(unit, symbol_name(items[0]) + ": expected 1 argument");
+        }
+        if (is_symbol_named(items[0], "quasiquote")) {
+            return wrap(items[0], items[1], depth + 1);
+        }
+        if (depth > 1) {
+            return wrap(items[0], items[1], depth - 1);
+        }
+        if (is_symbol_named(items[0], "unquote-splicing")) {
+            return fail(unit, "unquote-splicing outside a list template");
+        }
+        return compile_expr(items[1], scope, unit, false);
+    }
+
+    std::size_t segments = 0;
+    std::size_t run = 0;
+    for (value item : items) {
+        const bool splice = is_cons(item) && is_proper_list(item) && is_symbol_named(car(item), "unquote-splicing");
+        if (splice && depth == 1) {
+            if (!is_cons(cdr(item)) || !is_nil(cdr(cdr(item)))) {
+                return fail(unit, "unquote-splicing: expected 1 argument");
+            }
+            if (run != 0) {
+                emit(out, compiled_opcode::make_list, run);
+                ++segments;
+                run = 0;
+            }
+            if (!compile_expr(car(cdr(item)), scope, unit, false)) {
+                return false;
+            }
+            ++segments;
+            continue;
+        }
+        if (!compile_quasiquote(item, depth, scope, unit)) {
+            return false;
+        }
+        ++run;
+    }
+    if (segments == 0) {
+        emit(out, compiled_opcode::make_list, run);
+        return true;
+    }
+    if (run != 0) {
+        emit(out, compiled_opcode::make_list, run);
+        ++segments;
     }
-    for (std::size_t i = 1; i < items.size(); ++i) {
-        if (!compile_expr(items[i], scope, out, false)) {
+    emit(out, compiled_opcode::append_lists, segments);
+    return true;
+}
+
+bool compile_call_form(const std::vector<value>& items,
+                       const compile_scope& scope,
+                       compile_unit& unit,
+                       bool tail_position) {
+    for (value item : items) {
+        if (!compile_expr(item, scope, unit, false)) {
             return false;
         }
     }
 
-    emit(out, tail_position ? compiled_opcode::tail_call : compiled_opcode::call, items.size() - 1);
+    emit(unit.out, tail_position ? compiled_opcode::tail_call : compiled_opcode::call, items.size() - 1);
     return true;
 }
 
-bool compile_list_form(value expr, const compile_scope& scope, compiled_closure& out, bool tail_position) {
+bool compile_list_form(value expr, const compile_scope& scope, compile_unit& unit, bool tail_position) {
     if (!is_proper_list(expr)) {
-        return false;
+        return fail(unit, "improper list form");
     }
 
     const std::vector<value> items = vector_from_list(expr);
-    if (items.empty()) {
-        return false;
-    }
-
     value head = items[0];
     std::vector<value> args(items.begin() + 1, items.end());
 
-    if (is_symbol_named(head, "quote")) {
-        if (args.size() != 1) {
-            return false;
-        }
-        emit(out, compiled_opcode::push_const, 0, args[0]);
-        return true;
-    }
-    if (is_symbol_named(head, "if")) {
-        return compile_if_form(args, scope, out, tail_position);
-    }
-    if (is_symbol_named(head, "begin")) {
-        return compile_sequence(args, scope, out, tail_position);
-    }
-    if (is_symbol_named(head, "let")) {
-        return compile_let_form(args, scope, out, tail_position);
-    }
-    if (is_symbol_named(head, "and")) {
-        return compile_and_form(args, scope, out, tail_position);
-    }
-    if (is_symbol_named(head, "or")) {
-        return compile_or_form(args, scope, out, tail_position);
-    }
-
     if (is_symbol(head)) {
         const std::string& special = symbol_name(head);
-        if (special == "cond" || special == "define" || special == "lambda" || special == "quasiquote" ||
-            special == "load" || special == "bt" || special == "defbt" || special == "unquote" ||
+        if (special == "quote") {
+            if (args.size() != 1) {
+                return fail(unit, "quote: expected 1 argument");
+            }
+            emit(unit.out, compiled_opcode::push_const, 0, args[0]);
+            return true;
+        }
+        if (special == "if") {
+            return compile_if_form(args, scope, unit, tail_position);
+        }
+        if (special == "begin") {
+            return compile_sequence(args, scope, unit, tail_position);
+        }
+        if (special == "let") {
+            return compile_let_form(args, scope, unit, tail_position);
+        }
+        if (special == "and") {
+            return compile_and_form(args, scope, unit, tail_position);
+        }
+        if (special == "or") {
+            return compile_or_form(args, scope, unit, tail_position);
+        }
+        if (special == "cond") {
+            return compile_cond_form(args, scope, unit, tail_position);
+        }
+        if (special == "quasiquote") {
+            if (args.size() != 1) {
+                return fail(unit, "quasiquote: expected 1 argument");
+            }
+            return compile_quasiquote(args[0], 1, scope, unit);
+        }
+        if (special == "lambda") {
+            std::vector<std::string> params;
+            if (args.size() < 2 || !parse_lambda_params(args[0], params)) {
+                return fail(unit, "lambda: expected a parameter list of symbols and a body");
+            }
+            return compile_lambda(std::move(params), std::vector<value>(args.begin() + 1, args.end()), nullptr,
+                                  scope, unit);
+        }
+        if (special == "define") {
+            return fail(unit, "define is only compiled at the top level of a closure or let body");
+        }
+        if (special == "load" || special == "bt" || special == "defbt" || special == "unquote" ||
             special == "unquote-splicing") {
-            return false;
+            return fail(unit, "`" + special + "` is left to the evaluator");
         }
     }
 
-    return compile_call_form(items, scope, out, tail_position);
+    return compile_call_form(items, scope, unit, tail_position);
 }
 
-bool compile_expr(value expr, const compile_scope& scope, compiled_closure& out, bool tail_position) {
+bool compile_expr(value expr, const compile_scope& scope, compile_unit& unit, bool tail_position) {
     if (!expr) {
-        return false;
+        return fail(unit, "null expression");
     }
 
     switch (type_of(expr)) {
@@ -323,48 +647,275 @@ bool compile_expr(value expr, const compile_scope& scope, compiled_closure& out,
         case value_type::bt_instance:
         case value_type::image_handle:
         case value_type::blob_handle:
-            emit(out, compiled_opcode::push_const, 0, expr);
+        case value_type::pmap:
+        case value_type::pvec:
+        case value_type::f64vec:
+            emit(unit.out, compiled_opcode::push_const, 0, expr);
             return true;
         case value_type::symbol: {
             const auto found = scope.locals.find(symbol_name(expr));
             if (found != scope.locals.end()) {
-                emit(out, compiled_opcode::load_local, found->second);
+                emit(unit.out, compiled_opcode::load_local, found->second);
+            } else if (resolve_capture(unit, expr)) {
+                emit(unit.out, compiled_opcode::load_captured, 0, expr, symbol_name(expr));
             } else {
-                emit(out, compiled_opcode::load_name, 0, nullptr, symbol_name(expr));
+                emit(unit.out, compiled_opcode::load_global, 0, expr, symbol_name(expr));
             }
             return true;
         }
         case value_type::cons:
-            return compile_list_form(expr, scope, out, tail_position);
+            return compile_list_form(expr, scope, unit, tail_position);
     }
 
-    return false;
-}
-
-std::vector<value> pop_call_args(rooted_value_stack& stack, std::size_t argc) {
-    std::vector<value> args(argc);
-    for (std::size_t i = argc; i > 0; --i) {
-        args[i - 1] = stack.pop();
-    }
-    return args;
+    return fail(unit, "unknown value type");
 }
 
-}  // namespace
+// Worst-case operand depth over all paths, so a frame can be sized once up front.
+std::size_t compute_max_stack(const std::vector<compiled_instruction>& code);
 
-std::shared_ptr<compiled_closure> try_compile_closure(const std::vector<std::string>& params,
-                                                      const std::vector<value>& body) {
+bool compile_body(const std::vector<std::string>& params, const std::vector<value>& body, compile_unit& unit) {
     compile_scope scope;
     scope.next_slot = params.size();
     for (std::size_t i = 0; i < params.size(); ++i) {
         scope.locals[params[i]] = i;
+        scope.level.insert(params[i]);
     }
+    unit.out.local_count = params.size();
+    if (!compile_sequence(body, scope, unit, true, true)) {
+        return false;
+    }
+    emit(unit.out, compiled_opcode::return_value);
+    unit.out.max_stack = compute_max_stack(unit.out.code);
+    return true;
+}
 
+// Compiles a nested lambda into its own shared code and emits make_closure. The lambda captures, by
+// value, the enclosing locals it refers to; that matches the interpreter's captured env because locals
+// only change through define, and compile_define_form refuses a define the lambda could observe.
+bool compile_lambda(std::vector<std::string> params,
+                    std::vector<value> body,
+                    value self_symbol,
+                    const compile_scope& scope,
+                    compile_unit& unit) {
+    auto code = std::make_shared<compiled_closure>();
+    code->shared = true;
+    compile_unit inner(*code);
+    inner.enclosing = &unit;
+    inner.enclosing_scope = &scope;
+    if (self_symbol) {
+        // The function sees itself through its own env; treat the name as captured.
+        inner.captures.push_back(compiled_capture{self_symbol, true, 0});
+        inner.capture_names.insert(symbol_name(self_symbol));
+    }
+    if (!compile_body(params, body, inner)) {
+        return fail(unit, "nested lambda: " + inner.failure);
+    }
+
+    for (const std::string& name : inner.free_names) {
+        if (!self_symbol || name != symbol_name(self_symbol)) {
+            unit.lambda_free_names.insert(name);
+        }
+    }
+    compiled_lambda lambda;
+    lambda.params = std::move(params);
+    lambda.body = std::move(body);
+    lambda.self_symbol = self_symbol;
+    lambda.code = std::move(code);
+    // The self capture is bound by make_closure, not copied from the enclosing frame.
+    for (const compiled_capture& capture : inner.captures) {
+        if (capture.symbol != self_symbol) {
+            lambda.captures.push_back(capture);
+        }
+    }
+    unit.out.lambdas.push_back(std::move(lambda));
+    emit(unit.out, compiled_opcode::make_closure, unit.out.lambdas.size() - 1);
+    return true;
+}
+
+std::uint64_t env_chain_stamp(env_ptr scope, std::size_t depth) {
+    std::uint64_t stamp = 0;
+    for (std::size_t i = 0; i < depth && scope; ++i, scope = scope->parent) {
+        stamp += scope->shape_version;
+    }
+    return stamp;
+}
+
+value load_global_cached(const compiled_instruction& instr, env_ptr scope) {
+    if (const std::optional<global_cell_cache::entry> cached = instr.global_cell.load();
+        cached && (cached->depth == 0 || env_chain_stamp(scope, cached->depth) == cached->stamp)) {
+        return *cached->cell;
+    }
+    std::size_t depth = 0;
+    value* cell = lookup_cell(scope, instr.literal, &depth);
+    if (!cell) {
+        throw name_error("unbound symbol: " + instr.text);
+    }
+    instr.global_cell.store(global_cell_cache::entry{cell, env_chain_stamp(scope, depth), depth});
+    return *cell;
+}
+
+value captured_value(env_ptr scope, value symbol) {
+    const auto found = scope->bindings.find(symbol);
+    if (found == scope->bindings.end()) {
+        throw eval_error("compiled closure: missing capture " + symbol_name(symbol));
+    }
+    return found->second;
+}
+
+value append_lists(std::span<const value> lists) {
+    std::vector<value> items;
+    for (value list : lists) {
+        if (!is_proper_list(list)) {
+            throw lisp_error("unquote-splicing: expected list value");
+        }
+        for (value cursor = list; is_cons(cursor); cursor = cdr(cursor)) {
+            items.push_back(car(cursor));
+        }
+    }
+    return list_from_vector(items);
+}
+
+template <typename Frame>
+value instantiate_lambda(const compiled_lambda& lambda, Frame& stack, env_ptr lookup_env) {
+    env_ptr scope = lookup_env;
+    if (!lambda.captures.empty() || lambda.self_symbol) {
+        scope = make_env(lookup_env);
+        for (const compiled_capture& capture : lambda.captures) {
+            define(scope, capture.symbol,
+                   capture.from_env ? captured_value(lookup_env, capture.symbol) : stack.local(capture.slot));
+        }
+    }
+    const value fn = make_closure(lambda.params, lambda.body, scope, lambda.code);
+    if (lambda.self_symbol) {
+        define(scope, lambda.self_symbol, fn);
+    }
+    return fn;
+}
+
+call_site_kind classify_callee(value callee) {
+    if (is_primitive(callee)) {
+        return primitive_span_function(callee) ? call_site_kind::span_primitive : call_site_kind::primitive;
+    }
+    if (is_closure(callee) && closure_compiled(callee)) {
+        return call_site_kind::compiled_closure;
+    }
+    return call_site_kind::generic;
+}
+
+// Call sites of `owner` cache only callees of the heap running them, so a worker heap never writes
+// into (or leaves dangling pointers in) code owned by the process heap. Shared code is reachable from
+// closures other than `owner`, which the write barrier does not cover, so it caches only old callees.
+call_site_kind resolve_call_site(const compiled_instruction& site, value owner, value callee, bool shared_code) {
+    if (const std::optional<call_site_cache::entry> cached = site.call_site.load(); cached && cached->callee == callee) {
+        return cached->kind;
+    }
+    const call_site_kind kind = classify_callee(callee);
+    gc& heap = default_gc();
+    if (heap.owns(owner) && heap.owns(callee) && (!shared_code || callee->old)) {
+        site.call_site.store(call_site_cache::entry{callee, kind});
+        heap.write_barrier(owner, callee);
+    }
+    return kind;
+}
+
+// `scratch` backs the vector calling convention; span primitives and compiled closures read the
+// operands in place.
+value invoke_call_site(call_site_kind kind, value callee, std::span<const value> args, std::vector<value>& scratch) {
+    switch (kind) {
+        case call_site_kind::span_primitive:
+            return callee->primitive_span_data()(args);
+        case call_site_kind::primitive:
+            scratch.assign(args.begin(), args.end());
+            return callee->primitive_data()(scratch);
+        case call_site_kind::compiled_closure:
+            return execute_compiled_closure(callee, args);
+        case call_site_kind::unresolved:
+        case call_site_kind::generic:
+            break;
+    }
+    scratch.assign(args.begin(), args.end());
+    return invoke_callable(callee, scratch);
+}
+
+std::size_t compute_max_stack(const std::vector<compiled_instruction>& code) {
+    constexpr std::size_t kUnvisited = static_cast<std::size_t>(-1);
+    std::vector<std::size_t> depth_at(code.size() + 1, kUnvisited);
+    std::vector<std::size_t> pending{0};
+    depth_at[0] = 0;
+    std::size_t max_depth = 0;
+
+    const auto visit = [&](std::size_t target, std::size_t depth) {
+        if (target < depth_at.size() && depth_at[target] == kUnvisited) {
+            depth_at[target] = depth;
+            pending.push_back(target);
+        }
+    };
+
+    while (!pending.empty()) {
+        const std::size_t ip = pending.back();
+        pending.pop_back();
+        if (ip >= code.size()) {
+            continue;
+        }
+        const compiled_instruction& instr = code[ip];
+        std::size_t depth = depth_at[ip];
+        switch (instr.opcode) {
+            case compiled_opcode::push_const:
+            case compiled_opcode::load_local:
+            case compiled_opcode::load_global:
+            case compiled_opcode::load_captured:
+            case compiled_opcode::make_closure:
+                ++depth;
+                max_depth = std::max(max_depth, depth);
+                visit(ip + 1, depth);
+                break;
+            case compiled_opcode::store_local:
+            case compiled_opcode::pop:
+                visit(ip + 1, depth == 0 ? 0 : depth - 1);
+                break;
+            case compiled_opcode::jump:
+                visit(instr.index, depth);
+                break;
+            case compiled_opcode::jump_if_false:
+                depth = depth == 0 ? 0 : depth - 1;
+                visit(ip + 1, depth);
+                visit(instr.index, depth);
+                break;
+            case compiled_opcode::jump_if_false_keep:
+            case compiled_opcode::jump_if_truthy_keep:
+                visit(ip + 1, depth);
+                visit(instr.index, depth);
+                break;
+            case compiled_opcode::make_list:
+            case compiled_opcode::append_lists:
+                depth = depth > instr.index ? depth - instr.index + 1 : 1;
+                max_depth = std::max(max_depth, depth);
+                visit(ip + 1, depth);
+                break;
+            case compiled_opcode::call:
+                visit(ip + 1, depth > instr.index ? depth - instr.index : 1);
+                break;
+            case compiled_opcode::tail_call:
+            case compiled_opcode::return_value:
+                break;
+        }
+    }
+    return max_depth;
+}
+
+}  // namespace
+
+std::shared_ptr<compiled_closure> try_compile_closure(const std::vector<std::string>& params,
+                                                      const std::vector<value>& body,
+                                                      std::string* why_not) {
     auto compiled = std::make_shared<compiled_closure>();
-    compiled->local_count = params.size();
-    if (!compile_sequence(body, scope, *compiled, true)) {
+    compile_unit unit(*compiled);
+    if (!compile_body(params, body, unit)) {
+        if (why_not) {
+            *why_not = unit.failure;
+        }
         return nullptr;
     }
-    emit(*compiled, compiled_opcode::return_value);
     return compiled;
 }
 
@@ -376,23 +927,28 @@ void compiled_closure_mark_children(const std::shared_ptr<compiled_closure>& com
         if (instr.literal) {
             heap.mark_value(instr.literal);
         }
+        if (const std::optional<call_site_cache::entry> cached = instr.call_site.load(); cached && cached->callee) {
+            heap.mark_value(cached->callee);
+        }
+    }
+    for (const compiled_lambda& lambda : compiled->lambdas) {
+        for (value expr : lambda.body) {
+            heap.mark_value(expr);
+        }
+        compiled_closure_mark_children(lambda.code, heap);
     }
 }
 
-value execute_compiled_closure(value fn_value, const std::vector<value>& args) {
+value execute_compiled_closure(value fn_value, std::span<const value> args) {
     value active_fn = fn_value;
-    std::vector<value> active_args = args;
+    // The first call reads its arguments in place; a tail call copies the next ones here.
+    std::vector<value> bounce_args;
+    std::span<const value> active_args = args;
     std::size_t tail_bounce_count = 0;
 
     while (true) {
         gc_root_scope input_roots(default_gc());
         input_roots.add(&active_fn);
-        for (value& arg : active_args) {
-            input_roots.add(&arg);
-        }
-        if (tail_bounce_count != 0 && (tail_bounce_count & 63u) == 0u) {
-            default_gc().maybe_collect();
-        }
 
         const auto& compiled = closure_compiled(active_fn);
         if (!compiled) {
@@ -405,88 +961,178 @@ value execute_compiled_closure(value fn_value, const std::vector<value>& args) {
 
         bool reuse_frame = false;
         value next_fn = nullptr;
-        std::vector<value> next_args;
 
         {
-            std::vector<value> locals(compiled->local_count, make_nil());
-            gc_root_scope local_roots(default_gc());
-            for (value& local : locals) {
-                local_roots.add(&local);
-            }
+            vm_frame stack(compiled->local_count, compiled->max_stack);
             for (std::size_t i = 0; i < active_args.size(); ++i) {
-                locals[i] = active_args[i];
+                stack.local(i) = active_args[i];
+            }
+            // Polled once the arguments are rooted by the frame.
+            if (tail_bounce_count != 0 && (tail_bounce_count & 63u) == 0u) {
+                default_gc().maybe_collect();
             }
 
-            rooted_value_stack stack;
+            std::vector<value> call_args;
             const env_ptr lookup_env = closure_env(active_fn);
+            const bool shared_code = compiled->shared;
+            const compiled_instruction* const code = compiled->code.data();
+            const std::size_t code_size = compiled->code.size();
             std::size_t ip = 0;
-            while (ip < compiled->code.size()) {
-                const compiled_instruction& instr = compiled->code[ip];
-                switch (instr.opcode) {
-                    case compiled_opcode::push_const:
-                        stack.push(instr.literal);
+
+            // Handlers are written once; with GNU labels-as-values each one jumps straight to the next
+            // handler (direct threading), otherwise VM_NEXT falls back to the switch.
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+            static void* const dispatch_table[] = {
+                &&op_push_const,
+                &&op_load_local,
+                &&op_load_global,
+                &&op_load_captured,
+                &&op_store_local,
+                &&op_pop,
+                &&op_jump,
+                &&op_jump_if_false,
+                &&op_jump_if_false_keep,
+                &&op_jump_if_truthy_keep,
+                &&op_make_list,
+                &&op_append_lists,
+                &&op_make_closure,
+                &&op_call,
+                &&op_tail_call,
+                &&op_return_value,
+            };
+#define VM_CASE(op) \
+    case compiled_opcode::op: \
+    op_##op:
+#define VM_NEXT()                                                                  \
+    do {                                                                           \
+        if (ip >= code_size) {                                                     \
+            goto vm_exit;                                                          \
+        }                                                                          \
+        goto* dispatch_table[static_cast<std::size_t>(code[ip].opcode)];           \
+    } while (false)
+#else
+#define VM_CASE(op) case compiled_opcode::op:
+#define VM_NEXT() continue
+#endif
+            while (ip < code_size) {
+                switch (code[ip].opcode) {
+                    VM_CASE(push_const) {
+                        stack.push(code[ip].literal);
                         ++ip;
-                        break;
-                    case compiled_opcode::load_local:
-                        if (instr.index >= locals.size()) {
+                        VM_NEXT();
+                    }
+                    VM_CASE(load_local) {
+                        const compiled_instruction& instr = code[ip];
+                        if (instr.index >= stack.local_count()) {
                             throw eval_error("compiled closure: invalid local slot");
                         }
-                        stack.push(locals[instr.index]);
+                        stack.push(stack.local(instr.index));
                         ++ip;
-                        break;
-                    case compiled_opcode::load_name:
-                        stack.push(lookup(lookup_env, instr.text));
+                        VM_NEXT();
+                    }
+                    VM_CASE(load_global) {
+                        stack.push(load_global_cached(code[ip], lookup_env));
+                        ++ip;
+                        VM_NEXT();
+                    }
+                    VM_CASE(load_captured) {
+                        stack.push(captured_value(lookup_env, code[ip].literal));
                         ++ip;
-                        break;
-                    case compiled_opcode::store_local: {
-                        if (instr.index >= locals.size()) {
+                        VM_NEXT();
+                    }
+                    VM_CASE(store_local) {
+                        const compiled_instruction& instr = code[ip];
+                        if (instr.index >= stack.local_count()) {
                             throw eval_error("compiled closure: invalid local slot");
                         }
-                        locals[instr.index] = stack.pop();
+                        const value stored = stack.pop();
+                        stack.local(instr.index) = stored;
                         ++ip;
-                        break;
+                        VM_NEXT();
                     }
-                    case compiled_opcode::pop:
+                    VM_CASE(pop) {
                         stack.discard();
                         ++ip;
-                        break;
-                    case compiled_opcode::jump:
-                        ip = instr.index;
-                        break;
-                    case compiled_opcode::jump_if_false: {
+                        VM_NEXT();
+                    }
+                    VM_CASE(jump) {
+                        ip = code[ip].index;
+                        VM_NEXT();
+                    }
+                    VM_CASE(jump_if_false) {
                         value cond = stack.pop();
-                        ip = is_truthy(cond) ? ip + 1 : instr.index;
-                        break;
+                        ip = is_truthy(cond) ? ip + 1 : code[ip].index;
+                        VM_NEXT();
+                    }
+                    VM_CASE(jump_if_false_keep) {
+                        ip = is_truthy(stack.top()) ? ip + 1 : code[ip].index;
+                        VM_NEXT();
+                    }
+                    VM_CASE(jump_if_truthy_keep) {
+                        ip = is_truthy(stack.top()) ? code[ip].index : ip + 1;
+                        VM_NEXT();
                     }
-                    case compiled_opcode::jump_if_false_keep:
-                        ip = is_truthy(stack.top()) ? ip + 1 : instr.index;
-                        break;
-                    case compiled_opcode::jump_if_truthy_keep:
-                        ip = is_truthy(stack.top()) ? instr.index : ip + 1;
-                        break;
-                    case compiled_opcode::call: {
-                        std::vector<value> call_args = pop_call_args(stack, instr.index);
-                        value callee = stack.pop();
-                        stack.push(invoke_callable(callee, call_args));
+                    VM_CASE(make_list) {
+                        const std::size_t count = code[ip].index;
+                        const value list = list_from_vector(stack.top_span(count));
+                        stack.drop(count);
+                        stack.push(list);
                         ++ip;
-                        break;
+                        VM_NEXT();
                     }
-                    case compiled_opcode::tail_call: {
-                        std::vector<value> call_args = pop_call_args(stack, instr.index);
-                        value callee = stack.pop();
-                        if (is_closure(callee) && closure_compiled(callee)) {
+                    VM_CASE(append_lists) {
+                        const std::size_t count = code[ip].index;
+                        const value list = append_lists(stack.top_span(count));
+                        stack.drop(count);
+                        stack.push(list);
+                        ++ip;
+                        VM_NEXT();
+                    }
+                    VM_CASE(make_closure) {
+                        stack.push(instantiate_lambda(compiled->lambdas[code[ip].index], stack, lookup_env));
+                        ++ip;
+                        VM_NEXT();
+                    }
+                    VM_CASE(call) {
+                        // Arguments stay on the rooted stack for the duration of the call.
+                        const compiled_instruction& instr = code[ip];
+                        const std::size_t argc = instr.index;
+                        const value callee = stack.peek(argc);
+                        const value result = invoke_call_site(
+                            resolve_call_site(instr, active_fn, callee, shared_code), callee, stack.top_span(argc), call_args);
+                        stack.drop(argc + 1);
+                        stack.push(result);
+                        ++ip;
+                        VM_NEXT();
+                    }
+                    VM_CASE(tail_call) {
+                        const compiled_instruction& instr = code[ip];
+                        const std::size_t argc = instr.index;
+                        const value callee = stack.peek(argc);
+                        const call_site_kind kind = resolve_call_site(instr, active_fn, callee, shared_code);
+                        if (kind == call_site_kind::compiled_closure) {
+                            const std::span<const value> next_args = stack.top_span(argc);
+                            bounce_args.assign(next_args.begin(), next_args.end());
                             next_fn = callee;
-                            next_args = std::move(call_args);
                             reuse_frame = true;
-                            ip = compiled->code.size();
-                            break;
+                            ip = code_size;
+                            VM_NEXT();
                         }
-                        return invoke_callable(callee, call_args);
+                        return invoke_call_site(kind, callee, stack.top_span(argc), call_args);
                     }
-                    case compiled_opcode::return_value:
+                    VM_CASE(return_value) {
                         return stack.empty() ? make_nil() : stack.pop();
+                    }
                 }
             }
+#if defined(__GNUC__)
+        vm_exit:;
+#pragma GCC diagnostic pop
+#endif
+#undef VM_CASE
+#undef VM_NEXT
         }
 
         if (!reuse_frame) {
@@ -494,7 +1140,7 @@ value execute_compiled_closure(value fn_value, const std::vector<value>& args) {
         }
 
         active_fn = next_fn;
-        active_args = std::move(next_args);
+        active_args = bounce_args;
         ++tail_bounce_count;
     }
 }
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <optional>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -13,35 +17,182 @@ namespace muslisp {
 enum class compiled_opcode {
     push_const,
     load_local,
-    load_name,
+    load_global,
+    load_captured,
     store_local,
     pop,
     jump,
     jump_if_false,
     jump_if_false_keep,
     jump_if_truthy_keep,
+    make_list,
+    append_lists,
+    make_closure,
     call,
     tail_call,
     return_value,
 };
 
+// How a call site invoked its last callee; see compiled_instruction::call_site.
+enum class call_site_kind : std::uint8_t {
+    unresolved,
+    span_primitive,
+    primitive,
+    compiled_closure,
+    generic,
+};
+
+// The binding cell a load_global resolved, shared by every thread running the code. The three fields
+// are published as one record under a seqlock (`version_` is odd while a writer fills them): a reader
+// that sees the version move ignores what it read and resolves again, and a writer that finds another
+// one mid-store leaves the cache to it.
+class global_cell_cache {
+public:
+    struct entry {
+        value* cell = nullptr;
+        std::uint64_t stamp = 0;
+        std::size_t depth = 0;
+    };
+
+    global_cell_cache() = default;
+    // Instructions are only copied while they are emitted, before anything resolves; copies start empty.
+    global_cell_cache(const global_cell_cache&) noexcept {}
+    global_cell_cache& operator=(const global_cell_cache&) noexcept { return *this; }
+
+    [[nodiscard]] std::optional<entry> load() const noexcept {
+        const std::uint64_t before = version_.load(std::memory_order_acquire);
+        if (before == 0 || (before & 1u) != 0) {
+            return std::nullopt;
+        }
+        const entry read{cell_.load(std::memory_order_relaxed), stamp_.load(std::memory_order_relaxed),
+                         depth_.load(std::memory_order_relaxed)};
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (version_.load(std::memory_order_relaxed) != before) {
+            return std::nullopt;
+        }
+        return read;
+    }
+
+    void store(const entry& resolved) noexcept {
+        std::uint64_t version = version_.load(std::memory_order_relaxed);
+        if ((version & 1u) != 0 || !version_.compare_exchange_strong(version, version + 1, std::memory_order_relaxed)) {
+            return;
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        cell_.store(resolved.cell, std::memory_order_relaxed);
+        stamp_.store(resolved.stamp, std::memory_order_relaxed);
+        depth_.store(resolved.depth, std::memory_order_relaxed);
+        version_.store(version + 2, std::memory_order_release);
+    }
+
+private:
+    std::atomic<std::uint64_t> version_{0};
+    std::atomic<value*> cell_{nullptr};
+    std::atomic<std::uint64_t> stamp_{0};
+    std::atomic<std::size_t> depth_{0};
+};
+
+// A call site's monomorphic cache: the last callee and how it was invoked, published together under
+// the same seqlock scheme as global_cell_cache so a reader never pairs one callee with another's kind.
+class call_site_cache {
+public:
+    struct entry {
+        value callee = nullptr;
+        call_site_kind kind = call_site_kind::unresolved;
+    };
+
+    call_site_cache() = default;
+    // Instructions are only copied while they are emitted, before any call; copies start empty.
+    call_site_cache(const call_site_cache&) noexcept {}
+    call_site_cache& operator=(const call_site_cache&) noexcept { return *this; }
+
+    [[nodiscard]] std::optional<entry> load() const noexcept {
+        const std::uint64_t before = version_.load(std::memory_order_acquire);
+        if (before == 0 || (before & 1u) != 0) {
+            return std::nullopt;
+        }
+        const entry read{callee_.load(std::memory_order_relaxed), kind_.load(std::memory_order_relaxed)};
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (version_.load(std::memory_order_relaxed) != before) {
+            return std::nullopt;
+        }
+        return read;
+    }
+
+    void store(const entry& resolved) noexcept {
+        std::uint64_t version = version_.load(std::memory_order_relaxed);
+        if ((version & 1u) != 0 || !version_.compare_exchange_strong(version, version + 1, std::memory_order_relaxed)) {
+            return;
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        callee_.store(resolved.callee, std::memory_order_relaxed);
+        kind_.store(resolved.kind, std::memory_order_relaxed);
+        version_.store(version + 2, std::memory_order_release);
+    }
+
+private:
+    std::atomic<std::uint64_t> version_{0};
+    std::atomic<value> callee_{nullptr};
+    std::atomic<call_site_kind> kind_{call_site_kind::unresolved};
+};
+
 struct compiled_instruction {
     compiled_opcode opcode = compiled_opcode::push_const;
     std::size_t index = 0;
     value literal = nullptr;
     std::string text;
+
+    // load_captured: `literal` is the symbol of a capture, read from the closure's own env.
+    // load_global: `literal` is the interned symbol and `text` its name for errors. The binding cell is resolved
+    // on first execution against the closure env. The entry's `stamp` sums the shape versions of the envs
+    // searched before the owner, so a later shadowing define forces a re-resolve.
+    mutable global_cell_cache global_cell;
+
+    // call/tail_call: monomorphic inline cache. While the callee is the cached one the site skips type
+    // dispatch and calls it the way the entry's `kind` says; a different callee re-fills the cache. The
+    // cached callee is marked with the closure's literals.
+    mutable call_site_cache call_site;
+};
+
+struct compiled_closure;
+
+// A value a nested lambda captures when the enclosing frame creates it: one of the frame's locals, or
+// (`from_env`) one of the enclosing closure's own captures.
+struct compiled_capture {
+    value symbol = nullptr;
+    bool from_env = false;
+    std::size_t slot = 0;
+};
+
+// A lambda nested in a compiled body. It is compiled with the body, and make_closure instantiates it
+// with a fresh env holding its captures (plus itself under `self_symbol` for an internal function
+// define), so every instance shares `code`.
+struct compiled_lambda {
+    std::vector<std::string> params;
+    std::vector<value> body;
+    std::vector<compiled_capture> captures;
+    value self_symbol = nullptr;
+    std::shared_ptr<compiled_closure> code;
 };
 
 struct compiled_closure {
     std::vector<compiled_instruction> code;
+    std::vector<compiled_lambda> lambdas;
     std::size_t local_count = 0;
+    std::size_t max_stack = 0;
+    // Code of a nested lambda, shared by all of its instances.
+    bool shared = false;
 };
 
 [[nodiscard]] const std::shared_ptr<compiled_closure>& closure_compiled(value v);
 void set_closure_compiled(value v, std::shared_ptr<compiled_closure> compiled);
+// Returns nullptr when the body uses a form the compiler leaves to the evaluator, and then says which
+// one in `why_not`.
 std::shared_ptr<compiled_closure> try_compile_closure(const std::vector<std::string>& params,
-                                                      const std::vector<value>& body);
+                                                      const std::vector<value>& body,
+                                                      std::string* why_not = nullptr);
 void compiled_closure_mark_children(const std::shared_ptr<compiled_closure>& compiled, gc& heap);
-value execute_compiled_closure(value fn_value, const std::vector<value>& args);
+// `args` must stay rooted by the caller until the call returns.
+value execute_compiled_closure(value fn_value, std::span<const value> args);
 
 }  // namespace muslisp
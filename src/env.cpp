@@ -1,6 +1,7 @@
 #include "muslisp/env.hpp"
 
 #include "muslisp/error.hpp"
+#include "muslisp/value.hpp"
 
 namespace muslisp {
 
@@ -21,21 +22,58 @@ env_ptr make_env(env_ptr parent) {
     return default_gc().allocate<env>(parent);
 }
 
-void define(env_ptr scope, const std::string& name, value bound_value) {
+void define(env_ptr scope, value symbol, value bound_value) {
     if (!scope) {
         throw lisp_error("define: null environment");
     }
-    scope->bindings[name] = bound_value;
+    const auto [it, inserted] = scope->bindings.try_emplace(symbol, bound_value);
+    if (inserted) {
+        ++scope->shape_version;
+    } else {
+        it->second = bound_value;
+    }
+    default_gc().write_barrier(scope, bound_value);
 }
 
-value lookup(env_ptr scope, const std::string& name) {
+void define(env_ptr scope, const std::string& name, value bound_value) {
+    define(scope, make_symbol(name), bound_value);
+}
+
+value lookup(env_ptr scope, value symbol) {
     for (env_ptr cursor = scope; cursor; cursor = cursor->parent) {
-        const auto it = cursor->bindings.find(name);
+        const auto it = cursor->bindings.find(symbol);
         if (it != cursor->bindings.end()) {
             return it->second;
         }
     }
-    throw name_error("unbound symbol: " + name);
+    throw name_error("unbound symbol: " + symbol_name(symbol));
+}
+
+value lookup(env_ptr scope, const std::string& name) {
+    const value symbol = find_symbol(name);
+    if (!symbol) {
+        throw name_error("unbound symbol: " + name);
+    }
+    return lookup(scope, symbol);
+}
+
+value* lookup_cell(env_ptr scope, value symbol, std::size_t* depth) {
+    std::size_t hops = 0;
+    for (env_ptr cursor = scope; cursor; cursor = cursor->parent, ++hops) {
+        const auto it = cursor->bindings.find(symbol);
+        if (it != cursor->bindings.end()) {
+            if (depth) {
+                *depth = hops;
+            }
+            return &it->second;
+        }
+    }
+    return nullptr;
+}
+
+value* lookup_cell(env_ptr scope, const std::string& name, std::size_t* depth) {
+    const value symbol = find_symbol(name);
+    return symbol ? lookup_cell(scope, symbol, depth) : nullptr;
 }
 
 }  // namespace muslisp
@@ -1,10 +1,13 @@
 #include "muslisp/env_api.hpp"
 
+#include <functional>
 #include <mutex>
 #include <stdexcept>
 #include <unordered_map>
 #include <utility>
 
+#include "muslisp/runtime_context.hpp"
+
 namespace muslisp {
 namespace {
 
@@ -25,7 +28,18 @@ public:
             throw std::invalid_argument("env.register-backend: backend pointer must not be null");
         }
         std::lock_guard<std::mutex> lock(mutex_);
-        backends_[name] = std::move(backend);
+        backends_[name] = backend_entry{.backend = std::move(backend), .factory = {}};
+    }
+
+    void register_factory(const std::string& name, env_backend_factory factory) {
+        if (name.empty()) {
+            throw std::invalid_argument("env.register-backend: backend name must not be empty");
+        }
+        if (!factory) {
+            throw std::invalid_argument("env.register-backend: backend factory must not be empty");
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        backends_[name] = backend_entry{.backend = nullptr, .factory = std::move(factory)};
     }
 
     std::vector<std::string> backend_names() const {
@@ -57,16 +71,36 @@ public:
         if (name.empty()) {
             throw std::invalid_argument("env.attach: backend name must not be empty");
         }
-        std::lock_guard<std::mutex> lock(mutex_);
+        std::unique_lock<std::mutex> lock(mutex_);
         if (attached_backend_) {
             throw std::runtime_error("env.attach: backend already attached: " + attached_name_);
         }
-        const auto it = backends_.find(name);
+        auto it = backends_.find(name);
         if (it == backends_.end()) {
             throw std::runtime_error("env.attach: unknown backend: " + name);
         }
+        if (!it->second.backend) {
+            // Built outside the lock: a factory may be slow, and may itself use the env API.
+            const env_backend_factory factory = it->second.factory;
+            lock.unlock();
+            std::shared_ptr<env_backend> built = factory();
+            if (!built) {
+                throw std::runtime_error("env.attach: backend factory returned null: " + name);
+            }
+            lock.lock();
+            it = backends_.find(name);
+            if (it == backends_.end()) {
+                throw std::runtime_error("env.attach: unknown backend: " + name);
+            }
+            if (attached_backend_) {
+                throw std::runtime_error("env.attach: backend already attached: " + attached_name_);
+            }
+            if (!it->second.backend) {
+                it->second.backend = std::move(built);
+            }
+        }
         attached_name_ = name;
-        attached_backend_ = it->second;
+        attached_backend_ = it->second.backend;
     }
 
     void detach() {
@@ -76,13 +110,22 @@ public:
     }
 
 private:
+    // `backend` stays null until the first attach when the backend was registered as a factory.
+    struct backend_entry {
+        std::shared_ptr<env_backend> backend;
+        env_backend_factory factory;
+    };
+
     mutable std::mutex mutex_{};
-    std::unordered_map<std::string, std::shared_ptr<env_backend>> backends_{};
+    std::unordered_map<std::string, backend_entry> backends_{};
     std::string attached_name_{};
     std::shared_ptr<env_backend> attached_backend_{};
 };
 
 env_api_registry& registry() {
+    if (runtime_context* context = current_runtime_context()) {
+        return context->local<env_api_registry>();
+    }
     static env_api_registry r;
     return r;
 }
@@ -97,6 +140,10 @@ void env_api_register_backend(const std::string& name, std::shared_ptr<env_backe
     registry().register_backend(name, std::move(backend));
 }
 
+void env_api_register_backend_factory(const std::string& name, env_backend_factory factory) {
+    registry().register_factory(name, std::move(factory));
+}
+
 std::vector<std::string> env_api_registered_backends() {
     return registry().backend_names();
 }
@@ -4,16 +4,25 @@
 #include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <condition_variable>
 #include <cstdint>
+#include <exception>
 #include <fstream>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <span>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 #include <thread>
 #include <utility>
+#include <variant>
 #include <vector>
 
+#include "bt/instance.hpp"
+#include "bt/loop_pacer.hpp"
 #include "bt/runtime_host.hpp"
 #include "muesli_bt/contract/events.hpp"
 #include "muslisp/env_api.hpp"
@@ -21,6 +30,7 @@
 #include "muslisp/eval.hpp"
 #include "muslisp/gc.hpp"
 #include "muslisp/printer.hpp"
+#include "muslisp/runtime_context.hpp"
 #include "muslisp/value.hpp"
 
 namespace muslisp {
@@ -30,6 +40,85 @@ constexpr const char* kEnvApiVersion = "env.api.v1";
 constexpr std::int64_t kDefaultTickHz = 20;
 constexpr std::int64_t kDefaultStepsPerTick = 1;
 
+// The time env observations are stamped with: the runtime host's simulated clock while simulated
+// time is on, otherwise steady_clock.
+std::chrono::steady_clock::time_point env_now() {
+    if (const bt::sim_clock* clock = bt::default_runtime_host().simulated_clock()) {
+        return clock->now();
+    }
+    return std::chrono::steady_clock::now();
+}
+
+// Writes a typed observation into a BT instance's blackboard. Backends write the same keys in
+// the same order every tick, so the slot for each write is found by checking the slot cached at
+// that position before falling back to interning the key.
+class blackboard_observation_sink final : public env_observation_sink {
+public:
+    // Starts a new observation for `inst`. The slot cache survives as long as the blackboard does.
+    void begin(bt::instance& inst) {
+        if (&inst.bb != bb_) {
+            bb_ = &inst.bb;
+            cache_.clear();
+        }
+        tick_ = inst.tick_index + 1;
+        ts_ = env_now();
+        written_.clear();
+    }
+
+    void put_bool(std::string_view key, bool v) override { write(key, bt::bb_value{v}); }
+    void put_integer(std::string_view key, std::int64_t v) override { write(key, bt::bb_value{v}); }
+    void put_number(std::string_view key, double v) override { write(key, bt::bb_value{v}); }
+    void put_vector(std::string_view key, std::span<const double> v) override {
+        write(key, bt::bb_value{bt::bb_vector(v)});
+    }
+    void put_string(std::string_view key, std::string_view v) override {
+        write(key, bt::bb_value{std::string(v)});
+    }
+    void put_image(std::string_view key, std::int64_t image_id) override {
+        write(key, bt::bb_value{bt::image_handle_ref{.id = image_id}});
+    }
+    void put_blob(std::string_view key, std::int64_t blob_id) override {
+        write(key, bt::bb_value{bt::blob_handle_ref{.id = blob_id}});
+    }
+
+    [[nodiscard]] const bt::blackboard* blackboard() const noexcept { return bb_; }
+    // Slots written by the last observation, in write order.
+    [[nodiscard]] std::span<const bt::bb_slot> written() const noexcept { return written_; }
+    [[nodiscard]] const bt::bb_value* find(std::string_view key) const {
+        for (const bt::bb_slot slot : written_) {
+            if (bb_->key_name(slot) == key) {
+                const bt::bb_entry* entry = bb_->get(slot);
+                return entry ? &entry->value : nullptr;
+            }
+        }
+        return nullptr;
+    }
+
+private:
+    void write(std::string_view key, bt::bb_value v) {
+        const std::size_t at = written_.size();
+        bt::bb_slot slot;
+        if (at < cache_.size() && bb_->key_name(cache_[at]) == key) {
+            slot = cache_[at];
+        } else {
+            slot = bb_->intern(key);
+            if (at < cache_.size()) {
+                cache_[at] = slot;
+            } else {
+                cache_.push_back(slot);
+            }
+        }
+        bb_->put(slot, std::move(v), tick_, ts_, 0, "env.observe");
+        written_.push_back(slot);
+    }
+
+    bt::blackboard* bb_ = nullptr;
+    std::vector<bt::bb_slot> cache_;
+    std::vector<bt::bb_slot> written_;
+    std::uint64_t tick_ = 0;
+    std::chrono::steady_clock::time_point ts_{};
+};
+
 struct env_runtime_state {
     std::int64_t tick_hz = kDefaultTickHz;
     std::int64_t steps_per_tick = kDefaultStepsPerTick;
@@ -42,11 +131,19 @@ struct env_runtime_state {
     bool event_log_flush_each_message = false;
     std::int64_t episode = 0;
     std::int64_t step = 0;
-    std::chrono::steady_clock::time_point time_origin = std::chrono::steady_clock::now();
-    std::chrono::steady_clock::time_point next_deadline{};
+    std::chrono::steady_clock::time_point time_origin = env_now();
+    bt::overrun_policy overrun_policy = bt::overrun_policy::skip;
+    std::int64_t pacing_spin_us = 100;
+    bt::loop_pacer pacer{};
+    // Handle of the BT instance the last :observe_into run wrote to, or -1.
+    std::int64_t typed_obs_instance = -1;
+    blackboard_observation_sink typed_obs_sink{};
 };
 
 env_runtime_state& runtime_state() {
+    if (runtime_context* context = current_runtime_context()) {
+        return context->local<env_runtime_state>();
+    }
     static env_runtime_state state;
     return state;
 }
@@ -97,7 +194,8 @@ map_key symbol_key(const std::string& name) {
 }
 
 void map_set_symbol(value map_obj, const std::string& key_name, value v) {
-    map_obj->map_data[symbol_key(key_name)] = v;
+    map_obj->map_data()[symbol_key(key_name)] = v;
+    default_gc().write_barrier(map_obj, v);
 }
 
 std::string normalize_option_key(std::string key) {
@@ -116,7 +214,7 @@ std::optional<value> map_lookup_option(value map_obj, const std::string& normali
     if (!is_map(map_obj)) {
         return std::nullopt;
     }
-    for (const auto& [key, val] : map_obj->map_data) {
+    for (const auto& [key, val] : map_obj->map_data()) {
         if (key.type != map_key_type::symbol && key.type != map_key_type::string) {
             continue;
         }
@@ -136,9 +234,9 @@ std::optional<value> map_lookup_any(value map_obj, std::initializer_list<std::st
     return std::nullopt;
 }
 
-std::int64_t monotonic_ms_from_origin(const env_runtime_state& state) {
-    const auto now = std::chrono::steady_clock::now();
-    return std::chrono::duration_cast<std::chrono::milliseconds>(now - state.time_origin).count();
+std::int64_t monotonic_ms_from_origin(const env_runtime_state& state,
+                                      std::chrono::steady_clock::time_point at = env_now()) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(at - state.time_origin).count();
 }
 
 std::shared_ptr<env_backend> attached_backend_or_throw() {
@@ -184,6 +282,25 @@ void apply_common_runtime_options(value opts_map, const std::string& where) {
         state.realtime = require_bool(*realtime, where + " :realtime");
     }
 
+    if (const auto policy = map_lookup_option(opts_map, "overrun_policy")) {
+        if (!is_string(*policy)) {
+            throw lisp_error(where + " :overrun_policy: expected string");
+        }
+        const auto parsed = bt::parse_overrun_policy(string_value(*policy));
+        if (!parsed.has_value()) {
+            throw lisp_error(where + " :overrun_policy: expected \"skip\", \"catch-up\" or \"degrade\"");
+        }
+        state.overrun_policy = *parsed;
+    }
+
+    if (const auto spin_us = map_lookup_option(opts_map, "pacing_spin_us")) {
+        const std::int64_t parsed = require_int(*spin_us, where + " :pacing_spin_us");
+        if (parsed < 0) {
+            throw lisp_error(where + " :pacing_spin_us: expected >= 0");
+        }
+        state.pacing_spin_us = parsed;
+    }
+
     if (const auto log_path = map_lookup_option(opts_map, "log_path")) {
         if (!is_string(*log_path)) {
             throw lisp_error(where + " :log_path: expected string");
@@ -212,7 +329,14 @@ void apply_common_runtime_options(value opts_map, const std::string& where) {
     }
 }
 
-void enrich_observation(value obs_map) {
+// Where a pipelined observation came from: when its acquisition finished and the env step count
+// when it started. Unpipelined observations are stamped with the current time and step.
+struct observation_origin {
+    std::chrono::steady_clock::time_point acquired_at{};
+    std::int64_t step = 0;
+};
+
+void enrich_observation(value obs_map, const std::optional<observation_origin>& origin = std::nullopt) {
     if (!is_map(obs_map)) {
         throw lisp_error("env.observe: backend returned non-map observation");
     }
@@ -234,13 +358,128 @@ void enrich_observation(value obs_map) {
             throw lisp_error("env.observe: t_ms must be integer");
         }
     } else {
-        map_set_symbol(obs_map, "t_ms", make_integer(monotonic_ms_from_origin(state)));
+        const auto at = origin.has_value() ? origin->acquired_at : env_now();
+        map_set_symbol(obs_map, "t_ms", make_integer(monotonic_ms_from_origin(state, at)));
     }
 
     map_set_symbol(obs_map, "episode", make_integer(state.episode));
-    map_set_symbol(obs_map, "step", make_integer(state.step));
+    map_set_symbol(obs_map, "step", make_integer(origin.has_value() ? origin->step : state.step));
 }
 
+// Acquires observations on a dedicated thread so that acquiring the observation for tick N+1
+// overlaps tick N's on_tick, act and step. The worker fills its own snapshot and hands it over
+// under the lock, so a finished snapshot is never written while the loop reads it.
+class observation_pipeline {
+public:
+    struct snapshot {
+        std::unique_ptr<env_observation> observation;
+        observation_origin origin;
+    };
+
+    explicit observation_pipeline(std::shared_ptr<env_backend> backend)
+        : backend_(std::move(backend)), worker_([this] { run(); }) {}
+
+    ~observation_pipeline() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        worker_.join();
+    }
+
+    observation_pipeline(const observation_pipeline&) = delete;
+    observation_pipeline& operator=(const observation_pipeline&) = delete;
+
+    // Starts acquiring the next observation; `step` is the env step count it is taken at.
+    void request(std::int64_t step) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            discard_locked();
+            requested_ = true;
+            requested_step_ = step;
+        }
+        cv_.notify_all();
+    }
+
+    // Waits for the requested observation. Rethrows what acquire_observation() threw.
+    snapshot take() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!requested_ && !in_flight_ && !ready_) {
+            throw std::logic_error("observation pipeline: take without request");
+        }
+        cv_.wait(lock, [this] { return ready_; });
+        ready_ = false;
+        if (error_) {
+            std::exception_ptr error = std::exchange(error_, nullptr);
+            std::rethrow_exception(error);
+        }
+        if (!front_.observation) {
+            throw std::runtime_error("backend returned no pipelined observation");
+        }
+        return std::move(front_);
+    }
+
+    // Waits out an acquisition in flight and drops it, so the backend can be reset or observed
+    // directly.
+    void discard() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return !in_flight_; });
+        discard_locked();
+    }
+
+private:
+    void discard_locked() {
+        requested_ = false;
+        ready_ = false;
+        error_ = nullptr;
+        front_ = {};
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            cv_.wait(lock, [this] { return stop_ || requested_; });
+            if (stop_) {
+                return;
+            }
+            requested_ = false;
+            in_flight_ = true;
+            snapshot back;
+            back.origin.step = requested_step_;
+            std::exception_ptr error;
+            lock.unlock();
+            try {
+                back.observation = backend_->acquire_observation();
+            } catch (...) {
+                error = std::current_exception();
+            }
+            back.origin.acquired_at = std::chrono::steady_clock::now();
+            lock.lock();
+            in_flight_ = false;
+            // A request made while this acquisition ran supersedes it.
+            if (!requested_) {
+                front_ = std::move(back);
+                error_ = error;
+                ready_ = true;
+            }
+            cv_.notify_all();
+        }
+    }
+
+    std::shared_ptr<env_backend> backend_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+    bool requested_ = false;
+    bool in_flight_ = false;
+    bool ready_ = false;
+    std::int64_t requested_step_ = 0;
+    snapshot front_;
+    std::exception_ptr error_;
+    std::thread worker_;
+};
+
 bool obs_done(value obs_map) {
     if (!is_map(obs_map)) {
         return false;
@@ -249,6 +488,102 @@ bool obs_done(value obs_map) {
     return done && is_boolean(*done) && boolean_value(*done);
 }
 
+value typed_field_to_lisp(const bt::bb_value& v) {
+    if (const auto* b = std::get_if<bool>(&v)) {
+        return make_boolean(*b);
+    }
+    if (const auto* i = std::get_if<std::int64_t>(&v)) {
+        return make_integer(*i);
+    }
+    if (const auto* f = std::get_if<double>(&v)) {
+        return make_float(*f);
+    }
+    if (const auto* s = std::get_if<std::string>(&v)) {
+        return make_string(*s);
+    }
+    if (const auto* vec = std::get_if<bt::bb_vector>(&v)) {
+        value out = make_nil();
+        gc_root_scope roots(default_gc());
+        roots.add(&out);
+        for (std::size_t i = vec->size(); i > 0; --i) {
+            out = make_cons(make_float((*vec)[i - 1]), out);
+        }
+        return out;
+    }
+    if (const auto* image = std::get_if<bt::image_handle_ref>(&v)) {
+        return make_image_handle(image->id);
+    }
+    if (const auto* blob = std::get_if<bt::blob_handle_ref>(&v)) {
+        return make_blob_handle(blob->id);
+    }
+    return make_nil();
+}
+
+std::string json_escape(std::string_view input);
+
+std::string typed_field_to_json(const bt::bb_value& v) {
+    const auto number = [](double d) { return std::isfinite(d) ? std::to_string(d) : std::string("null"); };
+    if (const auto* b = std::get_if<bool>(&v)) {
+        return *b ? "true" : "false";
+    }
+    if (const auto* i = std::get_if<std::int64_t>(&v)) {
+        return std::to_string(*i);
+    }
+    if (const auto* f = std::get_if<double>(&v)) {
+        return number(*f);
+    }
+    if (const auto* s = std::get_if<std::string>(&v)) {
+        return "\"" + json_escape(*s) + "\"";
+    }
+    if (const auto* vec = std::get_if<bt::bb_vector>(&v)) {
+        std::string out = "[";
+        for (std::size_t i = 0; i < vec->size(); ++i) {
+            if (i > 0) {
+                out += ',';
+            }
+            out += number((*vec)[i]);
+        }
+        return out + "]";
+    }
+    if (const auto* image = std::get_if<bt::image_handle_ref>(&v)) {
+        return "{\"type\":\"image_handle\",\"id\":" + std::to_string(image->id) + "}";
+    }
+    if (const auto* blob = std::get_if<bt::blob_handle_ref>(&v)) {
+        return "{\"type\":\"blob_handle\",\"id\":" + std::to_string(blob->id) + "}";
+    }
+    return "null";
+}
+
+// The last typed observation, as a JSON object; the event log records it in tick_begin.
+std::string typed_observation_json(const blackboard_observation_sink& sink) {
+    std::string out = "{";
+    for (const bt::bb_slot slot : sink.written()) {
+        const bt::bb_entry* entry = sink.blackboard()->get(slot);
+        if (out.size() > 1) {
+            out += ',';
+        }
+        out += '"';
+        out += json_escape(sink.blackboard()->key_name(slot));
+        out += "\":";
+        out += entry ? typed_field_to_json(entry->value) : "null";
+    }
+    return out + "}";
+}
+
+// The small map on_tick receives for a typed observation: obs_schema, t_ms and done when the
+// backend wrote them. enrich_observation adds the rest of the metadata.
+value typed_observation_view(const blackboard_observation_sink& sink) {
+    value view = make_map();
+    gc_root_scope roots(default_gc());
+    roots.add(&view);
+    for (const char* key : {"obs_schema", "t_ms", "done"}) {
+        if (const bt::bb_value* field = sink.find(key)) {
+            map_set_symbol(view, key, typed_field_to_lisp(*field));
+        }
+    }
+    return view;
+}
+
 bool on_tick_result_indicates_success(value result) {
     if (is_boolean(result)) {
         return boolean_value(result);
@@ -384,11 +719,11 @@ std::string value_to_json(value v) {
         case value_type::vec: {
             std::ostringstream out;
             out << '[';
-            for (std::size_t i = 0; i < v->vec_data.size(); ++i) {
+            for (std::size_t i = 0; i < v->vec_data().size(); ++i) {
                 if (i > 0) {
                     out << ',';
                 }
-                out << value_to_json(v->vec_data[i]);
+                out << value_to_json(v->vec_data()[i]);
             }
             out << ']';
             return out.str();
@@ -397,7 +732,7 @@ std::string value_to_json(value v) {
             std::ostringstream out;
             out << '{';
             bool first = true;
-            for (const auto& [k, mapped] : v->map_data) {
+            for (const auto& [k, mapped] : v->map_data()) {
                 if (!first) {
                     out << ',';
                 }
@@ -491,7 +826,8 @@ public:
                              std::int64_t tick_hz,
                              const std::optional<std::string>& event_log_path,
                              const std::optional<std::size_t>& ring_capacity,
-                             bool flush_each_message)
+                             bool flush_each_message,
+                             const bt::loop_pacer* pacer)
         : events_(bt::default_runtime_host().events()),
           saved_enabled_(events_.enabled()),
           saved_file_enabled_(events_.file_enabled()),
@@ -500,7 +836,8 @@ public:
           saved_ring_capacity_(events_.ring_capacity()),
           saved_path_(events_.path()),
           saved_run_id_(events_.run_id()),
-          saved_tick_hz_(events_.tick_hz()) {
+          saved_tick_hz_(events_.tick_hz()),
+          saved_pacer_(events_.audit_loop_pacer()) {
         if (ring_capacity.has_value()) {
             events_.set_ring_capacity(*ring_capacity);
         }
@@ -512,11 +849,13 @@ public:
         events_.set_flush_on_tick_end(true);
         events_.set_flush_each_message(flush_each_message);
         events_.set_tick_hz(static_cast<double>(tick_hz));
+        events_.set_audit_loop_pacer(pacer);
         events_.set_run_id(make_env_run_event_run_id(backend_name));
         events_.ensure_run_started("", event_capabilities_json(backend_name, backend_info, reset_supported, realtime));
     }
 
     ~scoped_env_run_event_log() {
+        events_.set_audit_loop_pacer(saved_pacer_);
         events_.set_tick_hz(saved_tick_hz_);
         events_.set_run_id(saved_run_id_);
         events_.set_path(saved_path_);
@@ -539,6 +878,7 @@ private:
     std::string saved_path_;
     std::string saved_run_id_;
     double saved_tick_hz_;
+    const bt::loop_pacer* saved_pacer_;
 };
 
 value invoke_callable_unary(value fn, value arg, const std::string& where) {
@@ -635,7 +975,9 @@ void emit_canonical_tick_begin(bt::event_log& events,
                                std::int64_t tick_index,
                                value obs,
                                std::optional<std::string> schema_version,
-                               double tick_budget_ms) {
+                               double tick_budget_ms,
+                               bool obs_pipelined = false,
+                               const std::string* obs_fields_json = nullptr) {
     value data = make_map();
     gc_root_scope roots(default_gc());
     roots.add(&data);
@@ -646,10 +988,23 @@ void emit_canonical_tick_begin(bt::event_log& events,
     if (const auto t_ms = map_lookup_option(obs, "t_ms")) {
         map_set_symbol(data, "obs_t_ms", *t_ms);
     }
+    if (obs_pipelined) {
+        // The observation was acquired during the previous tick; its `step` is the env step count
+        // at which acquisition started.
+        map_set_symbol(data, "obs_pipelined", make_boolean(true));
+        if (const auto step = map_lookup_option(obs, "step")) {
+            map_set_symbol(data, "obs_step", *step);
+        }
+    }
     if (schema_version.has_value()) {
         map_set_symbol(data, "schema_version", make_string(*schema_version));
     }
-    (void)events.emit(muesli_bt::contract::kEventTickBegin, static_cast<std::uint64_t>(tick_index), value_to_json(data));
+    std::string json = value_to_json(data);
+    if (obs_fields_json != nullptr) {
+        // Fields of a typed observation live on the blackboard, not in `obs`.
+        json.insert(json.size() - 1, ",\"obs_fields\":" + *obs_fields_json);
+    }
+    (void)events.emit(muesli_bt::contract::kEventTickBegin, static_cast<std::uint64_t>(tick_index), json);
 }
 
 void emit_canonical_tick_end(bt::event_log& events,
@@ -748,10 +1103,12 @@ void emit_canonical_run_end(bt::event_log& events,
                             std::int64_t last_episode_steps,
                             std::int64_t fallback_count,
                             std::int64_t overrun_count,
+                            value pacing,
                             std::optional<std::uint64_t> tick = std::nullopt) {
     value data = make_map();
     gc_root_scope roots(default_gc());
     roots.add(&data);
+    roots.add(&pacing);
     map_set_symbol(data, "status", make_string(status_text));
     map_set_symbol(data, "reason", make_string(reason));
     map_set_symbol(data, "episodes_completed", make_integer(episodes_completed));
@@ -759,6 +1116,9 @@ void emit_canonical_run_end(bt::event_log& events,
     map_set_symbol(data, "last_episode_steps", make_integer(last_episode_steps));
     map_set_symbol(data, "fallback_count", make_integer(fallback_count));
     map_set_symbol(data, "overrun_count", make_integer(overrun_count));
+    if (!is_nil(pacing)) {
+        map_set_symbol(data, "pacing", pacing);
+    }
     (void)events.emit(muesli_bt::contract::kEventRunEnd, tick, value_to_json(data));
 }
 
@@ -771,6 +1131,22 @@ void emit_record(value observer_fn, bool has_observer, const std::string& log_pa
     }
 }
 
+// Rebuilds the pacer when the rate, policy or spin window changed since it was last configured.
+bt::loop_pacer& configured_pacer(env_runtime_state& state, std::int64_t tick_hz) {
+    const auto period = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::duration<double>(1.0 / static_cast<double>(tick_hz)));
+    const auto spin = std::chrono::nanoseconds(std::chrono::microseconds(state.pacing_spin_us));
+    const bt::loop_pacer_options& current = state.pacer.options();
+    if (current.period != period || current.policy != state.overrun_policy || current.spin != spin) {
+        state.pacer = bt::loop_pacer(bt::loop_pacer_options{
+            .period = period,
+            .policy = state.overrun_policy,
+            .spin = spin,
+        });
+    }
+    return state.pacer;
+}
+
 bool perform_step_and_pacing(env_backend& backend, std::int64_t tick_hz, bool realtime) {
     env_runtime_state& state = runtime_state();
     const bool can_continue = backend.step();
@@ -779,26 +1155,154 @@ bool perform_step_and_pacing(env_backend& backend, std::int64_t tick_hz, bool re
     }
 
     if (!realtime) {
-        state.next_deadline = std::chrono::steady_clock::time_point{};
+        state.pacer.restart();
         return can_continue;
     }
+    (void)configured_pacer(state, tick_hz).wait_next();
+    return can_continue;
+}
 
-    const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
-        std::chrono::duration<double>(1.0 / static_cast<double>(tick_hz)));
+struct simulated_time_options {
+    bool enabled = false;
+    std::chrono::milliseconds settle_timeout{10000};
+};
 
-    const auto now = std::chrono::steady_clock::now();
-    if (state.next_deadline.time_since_epoch().count() == 0) {
-        state.next_deadline = now + period;
+simulated_time_options parse_simulated_time_options(value config, const std::string& where, bool realtime) {
+    simulated_time_options out;
+    if (const auto enabled = map_lookup_option(config, "simulated_time")) {
+        out.enabled = require_bool(*enabled, where + " :simulated_time");
     }
-    if (now < state.next_deadline) {
-        std::this_thread::sleep_until(state.next_deadline);
+    if (const auto timeout = map_lookup_option(config, "settle_timeout_ms")) {
+        const std::int64_t parsed = require_int(*timeout, where + " :settle_timeout_ms");
+        if (parsed <= 0) {
+            throw lisp_error(where + " :settle_timeout_ms: expected > 0");
+        }
+        out.settle_timeout = std::chrono::milliseconds(parsed);
     }
-    const auto after_sleep = std::chrono::steady_clock::now();
-    state.next_deadline += period;
-    if (state.next_deadline < after_sleep) {
-        state.next_deadline = after_sleep;
+    if (out.enabled && realtime) {
+        throw lisp_error(where + " :simulated_time: cannot be combined with :realtime");
     }
-    return can_continue;
+    return out;
+}
+
+// Holds the runtime host on simulated time for one run and puts the previous clock back when the
+// run ends. A backend that reports supports().simulated_time drives the clock from the t_ms of its
+// observations; otherwise the clock advances one tick period per step. After every step the run
+// waits for all scheduler jobs, so a job submitted on tick N has finished when tick N+1 starts,
+// however long it took in wall time, and a rerun sees it finish on the same tick.
+class simulated_time_run {
+public:
+    simulated_time_run(std::string where,
+                       bool backend_clock,
+                       std::chrono::nanoseconds tick_period,
+                       std::chrono::milliseconds settle_timeout)
+        : where_(std::move(where)),
+          host_(bt::default_runtime_host()),
+          owns_clock_(host_.simulated_clock() == nullptr),
+          clock_(host_.enable_simulated_time()),
+          backend_clock_(backend_clock),
+          tick_period_(tick_period),
+          settle_timeout_(settle_timeout),
+          sim_started_(clock_.now()),
+          wall_started_(std::chrono::steady_clock::now()) {}
+
+    ~simulated_time_run() {
+        if (owns_clock_) {
+            host_.disable_simulated_time();
+        }
+    }
+
+    simulated_time_run(const simulated_time_run&) = delete;
+    simulated_time_run& operator=(const simulated_time_run&) = delete;
+
+    // Forgets how backend time maps onto the clock; called after a reset, which may restart t_ms.
+    void restart() noexcept { anchor_.reset(); }
+
+    void observed(std::optional<std::int64_t> t_ms) {
+        if (!backend_clock_ || !t_ms.has_value()) {
+            return;
+        }
+        if (!anchor_.has_value()) {
+            anchor_ = anchor{.at = clock_.now(), .t_ms = *t_ms};
+            return;
+        }
+        clock_.set(anchor_->at + std::chrono::milliseconds(*t_ms - anchor_->t_ms));
+    }
+
+    void stepped() {
+        if (!host_.settle_jobs(settle_timeout_)) {
+            throw std::runtime_error(where_ + ": scheduler jobs still running after settle_timeout_ms");
+        }
+        if (!backend_clock_) {
+            clock_.advance(tick_period_);
+        }
+    }
+
+    [[nodiscard]] double sim_elapsed_ms() const {
+        return std::chrono::duration<double, std::milli>(clock_.now() - sim_started_).count();
+    }
+
+    // Simulated time over wall time since the run started.
+    [[nodiscard]] double realtime_factor() const {
+        const double wall_ms =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wall_started_).count();
+        return wall_ms > 0.0 ? sim_elapsed_ms() / wall_ms : 0.0;
+    }
+
+    void write_summary(value out) const {
+        map_set_symbol(out, "sim_time_ms", make_float(sim_elapsed_ms()));
+        map_set_symbol(out, "realtime_factor", make_float(realtime_factor()));
+    }
+
+private:
+    struct anchor {
+        std::chrono::steady_clock::time_point at{};
+        std::int64_t t_ms = 0;
+    };
+
+    std::string where_;
+    bt::runtime_host& host_;
+    bool owns_clock_;
+    bt::sim_clock& clock_;
+    bool backend_clock_;
+    std::chrono::nanoseconds tick_period_;
+    std::chrono::milliseconds settle_timeout_;
+    std::chrono::steady_clock::time_point sim_started_;
+    std::chrono::steady_clock::time_point wall_started_;
+    std::optional<anchor> anchor_;
+};
+
+std::optional<std::int64_t> observation_t_ms(value obs) {
+    if (const auto t_ms = map_lookup_option(obs, "t_ms"); t_ms.has_value() && is_integer(*t_ms)) {
+        return integer_value(*t_ms);
+    }
+    return std::nullopt;
+}
+
+value pacing_summary_value(const bt::loop_pacer& pacer) {
+    const bt::loop_pacer_stats& stats = pacer.stats();
+    value out = make_map();
+    value histogram = make_nil();
+    gc_root_scope roots(default_gc());
+    roots.add(&out);
+    roots.add(&histogram);
+    map_set_symbol(out, "policy", make_string(bt::overrun_policy_name(pacer.options().policy)));
+    map_set_symbol(out, "period_ns", make_integer(pacer.options().period.count()));
+    map_set_symbol(out, "effective_period_ns", make_integer(pacer.period().count()));
+    map_set_symbol(out, "ticks", make_integer(static_cast<std::int64_t>(stats.ticks)));
+    map_set_symbol(out, "overruns", make_integer(static_cast<std::int64_t>(stats.overruns)));
+    map_set_symbol(out, "skipped_ticks", make_integer(static_cast<std::int64_t>(stats.skipped_ticks)));
+    map_set_symbol(out, "caught_up_ticks", make_integer(static_cast<std::int64_t>(stats.caught_up_ticks)));
+    map_set_symbol(out, "degrade_factor", make_integer(stats.degrade_factor));
+    map_set_symbol(out, "jitter_max_ns", make_integer(stats.jitter_max_ns));
+    map_set_symbol(out,
+                   "jitter_mean_ns",
+                   make_integer(stats.ticks > 0 ? stats.jitter_total_ns / static_cast<std::int64_t>(stats.ticks) : 0));
+    for (auto it = stats.jitter_histogram.rbegin(); it != stats.jitter_histogram.rend(); ++it) {
+        histogram = make_cons(make_integer(static_cast<std::int64_t>(*it)), histogram);
+    }
+    map_set_symbol(out, "jitter_histogram", histogram);
+    return out;
 }
 
 value builtin_env_info(const std::vector<value>& args) {
@@ -823,6 +1327,10 @@ value builtin_env_info(const std::vector<value>& args) {
         map_set_symbol(supports, "headless", make_boolean(false));
         map_set_symbol(supports, "realtime_pacing", make_boolean(false));
         map_set_symbol(supports, "deterministic_seed", make_boolean(false));
+        map_set_symbol(supports, "pipelined_observe", make_boolean(false));
+        map_set_symbol(supports, "typed_observe", make_boolean(false));
+        map_set_symbol(supports, "batched_step", make_boolean(false));
+        map_set_symbol(supports, "simulated_time", make_boolean(false));
         map_set_symbol(out, "supports", supports);
         return out;
     }
@@ -843,7 +1351,14 @@ value builtin_env_info(const std::vector<value>& args) {
     map_set_symbol(supports, "headless", make_boolean(flags.headless));
     map_set_symbol(supports, "realtime_pacing", make_boolean(flags.realtime_pacing));
     map_set_symbol(supports, "deterministic_seed", make_boolean(flags.deterministic_seed));
+    map_set_symbol(supports, "pipelined_observe", make_boolean(flags.pipelined_observe));
+    map_set_symbol(supports, "typed_observe", make_boolean(flags.typed_observe));
+    map_set_symbol(supports, "batched_step", make_boolean(flags.batched_step));
+    map_set_symbol(supports, "simulated_time", make_boolean(flags.simulated_time));
     map_set_symbol(out, "supports", supports);
+    if (flags.batched_step) {
+        map_set_symbol(out, "env_count", make_integer(static_cast<std::int64_t>(backend->env_count())));
+    }
 
     const std::string notes = backend->notes();
     if (!notes.empty()) {
@@ -855,9 +1370,10 @@ value builtin_env_info(const std::vector<value>& args) {
         if (!is_map(backend_info)) {
             throw lisp_error("env.info: backend info must be map or nil");
         }
-        for (const auto& [key, val] : backend_info->map_data) {
-            if (out->map_data.find(key) == out->map_data.end()) {
-                out->map_data[key] = val;
+        for (const auto& [key, val] : backend_info->map_data()) {
+            if (out->map_data().find(key) == out->map_data().end()) {
+                out->map_data()[key] = val;
+                default_gc().write_barrier(out, val);
             }
         }
     }
@@ -876,8 +1392,8 @@ value builtin_env_attach(const std::vector<value>& args) {
     env_runtime_state& state = runtime_state();
     state.episode = 0;
     state.step = 0;
-    state.time_origin = std::chrono::steady_clock::now();
-    state.next_deadline = std::chrono::steady_clock::time_point{};
+    state.time_origin = env_now();
+    state.pacer.restart();
     return make_nil();
 }
 
@@ -923,8 +1439,8 @@ value builtin_env_reset(const std::vector<value>& args) {
     env_runtime_state& state = runtime_state();
     ++state.episode;
     state.step = 0;
-    state.time_origin = std::chrono::steady_clock::now();
-    state.next_deadline = std::chrono::steady_clock::time_point{};
+    state.time_origin = env_now();
+    state.pacer.restart();
     if (seed.has_value()) {
         state.seed = seed;
     }
@@ -947,6 +1463,29 @@ value builtin_env_observe(const std::vector<value>& args) {
     return obs;
 }
 
+value builtin_env_observation(const std::vector<value>& args) {
+    require_arity("env.observation", args, 0);
+    const env_runtime_state& state = runtime_state();
+    const blackboard_observation_sink& sink = state.typed_obs_sink;
+    const bt::instance* inst = state.typed_obs_instance >= 0
+                                   ? bt::default_runtime_host().find_instance(state.typed_obs_instance)
+                                   : nullptr;
+    if (inst == nullptr || &inst->bb != sink.blackboard()) {
+        return make_nil();
+    }
+
+    value obs = make_map();
+    gc_root_scope roots(default_gc());
+    roots.add(&obs);
+    for (const bt::bb_slot slot : sink.written()) {
+        const bt::bb_entry* entry = sink.blackboard()->get(slot);
+        value field = entry ? typed_field_to_lisp(entry->value) : make_nil();
+        map_set_symbol(obs, sink.blackboard()->key_name(slot), field);
+    }
+    enrich_observation(obs);
+    return obs;
+}
+
 value builtin_env_act(const std::vector<value>& args) {
     require_arity("env.act", args, 1);
     const std::shared_ptr<env_backend> backend = attached_backend_or_throw();
@@ -1090,6 +1629,7 @@ value builtin_env_run_loop(const std::vector<value>& args) {
     if (const auto realtime_opt = map_lookup_option(config, "realtime")) {
         realtime = require_bool(*realtime_opt, "env.run-loop :realtime");
     }
+    const simulated_time_options sim_options = parse_simulated_time_options(config, "env.run-loop", realtime);
 
     std::optional<std::string> schema_version{};
     if (const auto schema_opt = map_lookup_option(config, "schema_version")) {
@@ -1134,6 +1674,28 @@ value builtin_env_run_loop(const std::vector<value>& args) {
             require_bool(*flush_opt, "env.run-loop :event_log_flush_each_message");
     }
 
+    bool pipeline_observe = false;
+    if (const auto pipeline_opt = map_lookup_option(config, "pipeline_observe")) {
+        pipeline_observe = require_bool(*pipeline_opt, "env.run-loop :pipeline_observe");
+    }
+    if (pipeline_observe && !backend->supports().pipelined_observe) {
+        throw lisp_error("env.run-loop :pipeline_observe: backend does not support pipelined observation");
+    }
+
+    std::optional<std::int64_t> observe_into{};
+    if (const auto into_opt = map_lookup_option(config, "observe_into")) {
+        if (!is_bt_instance(*into_opt)) {
+            throw lisp_error("env.run-loop :observe_into: expected bt_instance");
+        }
+        if (!backend->supports().typed_observe) {
+            throw lisp_error("env.run-loop :observe_into: backend does not support typed observation");
+        }
+        if (pipeline_observe) {
+            throw lisp_error("env.run-loop :observe_into: cannot be combined with :pipeline_observe");
+        }
+        observe_into = bt_handle(*into_opt);
+    }
+
     try {
         backend->configure(config);
     } catch (const std::exception& e) {
@@ -1143,6 +1705,14 @@ value builtin_env_run_loop(const std::vector<value>& args) {
     value backend_info = backend->info();
     roots.add(&backend_info);
 
+    bt::loop_pacer& pacer = configured_pacer(runtime_state(), tick_hz);
+    pacer.reset();
+
+    std::optional<observation_pipeline> pipeline;
+    if (pipeline_observe) {
+        pipeline.emplace(backend);
+    }
+
     const bool backend_supports_reset = backend->supports().reset;
     scoped_env_run_event_log canonical_events_scope(
         backend_name,
@@ -1152,7 +1722,8 @@ value builtin_env_run_loop(const std::vector<value>& args) {
         tick_hz,
         event_log_path,
         event_log_ring_size,
-        event_log_flush_each_message);
+        event_log_flush_each_message,
+        realtime ? &pacer : nullptr);
     bt::event_log& canonical_events = canonical_events_scope.get();
     std::optional<std::int64_t> seed{};
     if (const auto seed_opt = map_lookup_option(config, "seed")) {
@@ -1163,6 +1734,11 @@ value builtin_env_run_loop(const std::vector<value>& args) {
 
     const auto tick_period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
         std::chrono::duration<double>(1.0 / static_cast<double>(tick_hz)));
+    std::optional<simulated_time_run> sim_time;
+    if (sim_options.enabled) {
+        sim_time.emplace("env.run-loop", backend->supports().simulated_time, tick_period, sim_options.settle_timeout);
+        runtime_state().time_origin = env_now();
+    }
     std::int64_t episodes_completed = 0;
     std::int64_t steps_total = 0;
     std::int64_t last_episode_steps = 0;
@@ -1191,6 +1767,12 @@ value builtin_env_run_loop(const std::vector<value>& args) {
         map_set_symbol(out, "final_obs", final_obs);
         map_set_symbol(out, "fallback_count", make_integer(fallback_count));
         map_set_symbol(out, "overrun_count", make_integer(overrun_count));
+        if (realtime) {
+            map_set_symbol(out, "pacing", pacing_summary_value(pacer));
+        }
+        if (sim_time.has_value()) {
+            sim_time->write_summary(out);
+        }
         return out;
     };
 
@@ -1207,6 +1789,7 @@ value builtin_env_run_loop(const std::vector<value>& args) {
                                last_episode_steps,
                                fallback_count,
                                overrun_count,
+                               realtime ? pacing_summary_value(pacer) : make_nil(),
                                steps_total > 0 ? std::optional<std::uint64_t>(static_cast<std::uint64_t>(steps_total))
                                                : std::nullopt);
         return make_result(status_symbol, reason);
@@ -1222,6 +1805,9 @@ value builtin_env_run_loop(const std::vector<value>& args) {
         bool have_last_good_action = false;
         last_good_action = make_nil();
 
+        if (pipeline.has_value()) {
+            pipeline->discard();
+        }
         if (backend_supports_reset) {
             try {
                 obs = backend->reset(seed);
@@ -1232,26 +1818,68 @@ value builtin_env_run_loop(const std::vector<value>& args) {
             env_runtime_state& state = runtime_state();
             ++state.episode;
             state.step = 0;
-            state.time_origin = std::chrono::steady_clock::now();
-            state.next_deadline = std::chrono::steady_clock::time_point{};
+            state.time_origin = env_now();
+            state.pacer.restart();
+            if (sim_time.has_value()) {
+                sim_time->restart();
+            }
             enrich_observation(obs);
             final_obs = obs;
         }
 
         emit_canonical_episode_begin(canonical_events, episode_index + 1, episode_max, step_max, steps_total);
+        if (pipeline.has_value()) {
+            pipeline->request(runtime_state().step);
+        }
 
         for (std::int64_t k = 0; k < step_max; ++k) {
             bool used_fallback = false;
             bool overrun = false;
             std::optional<std::string> tick_schema = schema_version;
             const auto tick_started = std::chrono::steady_clock::now();
+            // The tick budget runs on simulated time from the observation on, and on wall time from
+            // here otherwise.
+            auto budget_started = tick_started;
 
             try {
-                obs = backend->observe();
-                enrich_observation(obs);
+                std::optional<observation_origin> obs_origin;
+                if (pipeline.has_value()) {
+                    observation_pipeline::snapshot next = pipeline->take();
+                    // The next tick's observation is acquired while this tick runs.
+                    pipeline->request(runtime_state().step);
+                    obs = next.observation->to_value();
+                    obs_origin = next.origin;
+                } else if (observe_into.has_value()) {
+                    bt::instance* inst = bt::default_runtime_host().find_instance(*observe_into);
+                    if (inst == nullptr) {
+                        throw lisp_error("env.run-loop :observe_into: unknown bt_instance handle");
+                    }
+                    env_runtime_state& state = runtime_state();
+                    state.typed_obs_instance = *observe_into;
+                    state.typed_obs_sink.begin(*inst);
+                    backend->observe_into(state.typed_obs_sink);
+                    obs = typed_observation_view(state.typed_obs_sink);
+                } else {
+                    obs = backend->observe();
+                }
+                enrich_observation(obs, obs_origin);
                 final_obs = obs;
+                if (sim_time.has_value()) {
+                    sim_time->observed(observation_t_ms(obs));
+                    budget_started = env_now();
+                }
                 const double tick_budget_ms = 1000.0 / static_cast<double>(tick_hz);
-                emit_canonical_tick_begin(canonical_events, steps_total + 1, obs, tick_schema, tick_budget_ms);
+                std::optional<std::string> obs_fields_json;
+                if (observe_into.has_value() && canonical_events.enabled()) {
+                    obs_fields_json = typed_observation_json(runtime_state().typed_obs_sink);
+                }
+                emit_canonical_tick_begin(canonical_events,
+                                          steps_total + 1,
+                                          obs,
+                                          tick_schema,
+                                          tick_budget_ms,
+                                          obs_origin.has_value(),
+                                          obs_fields_json ? &*obs_fields_json : nullptr);
 
                 on_tick_result = invoke_callable_unary(on_tick_fn, obs, "env.run-loop on_tick");
                 if (is_map(on_tick_result)) {
@@ -1268,8 +1896,12 @@ value builtin_env_run_loop(const std::vector<value>& args) {
 
                 // Use a per-tick deadline so long external pauses (e.g. paused simulator UI)
                 // do not permanently force fallback actions after resume.
-                const auto tick_deadline = tick_started + tick_period;
-                if (std::chrono::steady_clock::now() > tick_deadline) {
+                // A degraded pacer stretches the period, and with it the budget.
+                const auto tick_deadline =
+                    budget_started +
+                    (realtime ? std::chrono::duration_cast<std::chrono::steady_clock::duration>(pacer.period())
+                              : tick_period);
+                if (env_now() > tick_deadline) {
                     overrun = true;
                     ++overrun_count;
                 }
@@ -1302,6 +1934,9 @@ value builtin_env_run_loop(const std::vector<value>& args) {
                     have_last_good_action = true;
                 }
                 const bool can_continue = perform_step_and_pacing(*backend, tick_hz, realtime);
+                if (sim_time.has_value()) {
+                    sim_time->stepped();
+                }
                 ++steps_total;
                 ++episode_steps;
                 const auto tick_finished = std::chrono::steady_clock::now();
@@ -1385,6 +2020,9 @@ value builtin_env_run_loop(const std::vector<value>& args) {
                     safety_action = safe_action;
                 }
 
+                if (pipeline.has_value()) {
+                    pipeline->discard();
+                }
                 if (!is_nil(safety_action)) {
                     ++fallback_count;
                     bool fallback_published = false;
@@ -1489,6 +2127,235 @@ value builtin_env_run_loop(const std::vector<value>& args) {
     return finish_run(":stopped", "episode_max reached");
 }
 
+// Steps every copy of a batched backend under its own BT instance. Each tick observes all copies
+// into their instances' blackboards, ticks the instances of copies still running as one wave, reads
+// each instance's action vector back from the blackboard and steps the copies together. No Lisp
+// value is built inside the loop.
+value builtin_env_run_batch(const std::vector<value>& args) {
+    require_arity("env.run-batch", args, 2);
+    if (!is_map(args[0])) {
+        throw lisp_error("env.run-batch: expected config map");
+    }
+    if (!is_proper_list(args[1])) {
+        throw lisp_error("env.run-batch: expected list of bt_instance");
+    }
+
+    const std::shared_ptr<env_backend> backend = attached_backend_or_throw();
+    if (!backend->supports().batched_step) {
+        throw lisp_error("env.run-batch: backend does not support batched stepping");
+    }
+
+    const value config = args[0];
+    const auto max_ticks_opt = map_lookup_option(config, "max_ticks");
+    if (!max_ticks_opt.has_value()) {
+        throw lisp_error("env.run-batch: required key is max_ticks");
+    }
+    const std::int64_t max_ticks = require_int(*max_ticks_opt, "env.run-batch :max_ticks");
+    if (max_ticks <= 0) {
+        throw lisp_error("env.run-batch :max_ticks: expected > 0");
+    }
+    std::string action_key = "action";
+    if (const auto key_opt = map_lookup_option(config, "action_key")) {
+        action_key = require_text(*key_opt, "env.run-batch :action_key");
+    }
+    std::vector<double> safe_action;
+    if (const auto safe_opt = map_lookup_option(config, "safe_action")) {
+        if (!is_proper_list(*safe_opt)) {
+            throw lisp_error("env.run-batch :safe_action: expected list of numbers");
+        }
+        for (value item : vector_from_list(*safe_opt)) {
+            if (is_integer(item)) {
+                safe_action.push_back(static_cast<double>(integer_value(item)));
+            } else if (is_float(item)) {
+                safe_action.push_back(float_value(item));
+            } else {
+                throw lisp_error("env.run-batch :safe_action: expected list of numbers");
+            }
+        }
+    }
+    bool stop_when_done = true;
+    if (const auto done_opt = map_lookup_option(config, "stop_when_done")) {
+        stop_when_done = require_bool(*done_opt, "env.run-batch :stop_when_done");
+    }
+    std::optional<std::int64_t> seed = runtime_state().seed;
+    if (const auto seed_opt = map_lookup_option(config, "seed")) {
+        seed = require_int(*seed_opt, "env.run-batch :seed");
+    }
+    std::int64_t tick_hz = runtime_state().tick_hz;
+    if (const auto tick_hz_opt = map_lookup_option(config, "tick_hz")) {
+        tick_hz = require_int(*tick_hz_opt, "env.run-batch :tick_hz");
+        if (tick_hz <= 0) {
+            throw lisp_error("env.run-batch :tick_hz: expected > 0");
+        }
+    }
+    const simulated_time_options sim_options = parse_simulated_time_options(config, "env.run-batch", false);
+
+    std::vector<std::int64_t> handles;
+    for (value item : vector_from_list(args[1])) {
+        if (!is_bt_instance(item)) {
+            throw lisp_error("env.run-batch: expected list of bt_instance");
+        }
+        handles.push_back(bt_handle(item));
+    }
+    const std::size_t copies = backend->env_count();
+    if (handles.size() != copies) {
+        throw lisp_error("env.run-batch: backend runs " + std::to_string(copies) + " copies but " +
+                         std::to_string(handles.size()) + " bt_instance values were given");
+    }
+
+    if (backend->supports().reset) {
+        try {
+            (void)backend->reset(seed);
+        } catch (const std::exception& e) {
+            throw lisp_error(std::string("env.run-batch: reset failed: ") + e.what());
+        }
+    }
+
+    bt::runtime_host& host = bt::default_runtime_host();
+    std::vector<blackboard_observation_sink> sinks(copies);
+    std::vector<env_observation_sink*> sink_ptrs(copies);
+    std::vector<std::span<const double>> actions(copies);
+    std::vector<bool> done(copies, false);
+    std::vector<std::int64_t> copy_ticks(copies, 0);
+    std::vector<std::optional<bt::status>> last_status(copies);
+    std::vector<std::int64_t> active_handles;
+    std::vector<std::size_t> active_copies;
+    std::vector<bt::status> wave_status;
+    active_handles.reserve(copies);
+    active_copies.reserve(copies);
+    for (std::size_t i = 0; i < copies; ++i) {
+        sink_ptrs[i] = &sinks[i];
+    }
+
+    std::optional<simulated_time_run> sim_time;
+    if (sim_options.enabled) {
+        sim_time.emplace("env.run-batch",
+                         backend->supports().simulated_time,
+                         std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::duration<double>(1.0 / static_cast<double>(tick_hz))),
+                         sim_options.settle_timeout);
+    }
+
+    std::int64_t ticks = 0;
+    std::int64_t copy_ticks_total = 0;
+    std::int64_t fallback_count = 0;
+    std::string status_symbol = ":stopped";
+    std::string reason = "max_ticks reached";
+    const auto started = std::chrono::steady_clock::now();
+    try {
+        for (; ticks < max_ticks; ++ticks) {
+            for (std::size_t i = 0; i < copies; ++i) {
+                bt::instance* inst = host.find_instance(handles[i]);
+                if (inst == nullptr) {
+                    throw std::runtime_error("unknown bt_instance handle");
+                }
+                sinks[i].begin(*inst);
+            }
+            backend->observe_batch_into(sink_ptrs);
+            if (sim_time.has_value()) {
+                // The copies share one simulation, so copy 0 carries the time for all of them.
+                const bt::bb_value* t_ms = sinks.empty() ? nullptr : sinks[0].find("t_ms");
+                sim_time->observed(t_ms != nullptr && std::holds_alternative<std::int64_t>(*t_ms)
+                                       ? std::optional<std::int64_t>(std::get<std::int64_t>(*t_ms))
+                                       : std::nullopt);
+            }
+
+            active_handles.clear();
+            active_copies.clear();
+            for (std::size_t i = 0; i < copies; ++i) {
+                if (stop_when_done && !done[i]) {
+                    const bt::bb_value* copy_done = sinks[i].find("done");
+                    done[i] = copy_done != nullptr && std::holds_alternative<bool>(*copy_done) &&
+                              std::get<bool>(*copy_done);
+                }
+                if (!done[i]) {
+                    active_handles.push_back(handles[i]);
+                    active_copies.push_back(i);
+                }
+            }
+            if (active_handles.empty()) {
+                status_symbol = ":ok";
+                reason = "all copies done";
+                break;
+            }
+
+            wave_status.assign(active_handles.size(), bt::status::failure);
+            host.tick_instances(active_handles, wave_status);
+
+            for (std::size_t i = 0; i < copies; ++i) {
+                actions[i] = done[i] ? std::span<const double>(safe_action) : std::span<const double>{};
+            }
+            for (std::size_t k = 0; k < active_copies.size(); ++k) {
+                const std::size_t i = active_copies[k];
+                last_status[i] = wave_status[k];
+                ++copy_ticks[i];
+                const bt::instance* inst = host.find_instance(handles[i]);
+                const bt::bb_entry* entry = inst != nullptr ? inst->bb.get(action_key) : nullptr;
+                const auto* u = entry != nullptr ? std::get_if<bt::bb_vector>(&entry->value) : nullptr;
+                if (u != nullptr && !u->empty()) {
+                    actions[i] = std::span<const double>(u->data(), u->size());
+                } else {
+                    actions[i] = safe_action;
+                    ++fallback_count;
+                }
+            }
+            copy_ticks_total += static_cast<std::int64_t>(active_copies.size());
+
+            backend->act_batch(actions);
+            if (!backend->step_batch()) {
+                ++ticks;
+                reason = "backend step returned false";
+                break;
+            }
+            if (sim_time.has_value()) {
+                sim_time->stepped();
+            }
+        }
+    } catch (const std::exception& e) {
+        status_symbol = ":error";
+        reason = e.what();
+    }
+    const double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    value out = make_map();
+    value per_copy = make_nil();
+    gc_root_scope roots(default_gc());
+    roots.add(&out);
+    roots.add(&per_copy);
+    std::vector<value> copy_maps;
+    copy_maps.reserve(copies);
+    std::int64_t done_count = 0;
+    for (std::size_t i = 0; i < copies; ++i) {
+        value copy = make_map();
+        copy_maps.push_back(copy);
+        roots.add(&copy_maps.back());
+        map_set_symbol(copy, "done", make_boolean(done[i]));
+        map_set_symbol(copy, "ticks", make_integer(copy_ticks[i]));
+        map_set_symbol(copy,
+                       "last_status",
+                       last_status[i].has_value() ? make_symbol(bt::status_name(*last_status[i])) : make_nil());
+        done_count += done[i] ? 1 : 0;
+    }
+    per_copy = list_from_vector(copy_maps);
+
+    map_set_symbol(out, "status", make_symbol(status_symbol));
+    map_set_symbol(out, "ok", make_boolean(status_symbol != ":error"));
+    map_set_symbol(out, "reason", make_string(reason));
+    map_set_symbol(out, "ticks", make_integer(ticks));
+    map_set_symbol(out, "envs", make_integer(static_cast<std::int64_t>(copies)));
+    map_set_symbol(out, "envs_done", make_integer(done_count));
+    map_set_symbol(out, "env_ticks", make_integer(copy_ticks_total));
+    map_set_symbol(out, "fallback_count", make_integer(fallback_count));
+    map_set_symbol(out, "elapsed_ms", make_float(elapsed_s * 1000.0));
+    map_set_symbol(out, "env_ticks_per_s",
+                   make_float(elapsed_s > 0.0 ? static_cast<double>(copy_ticks_total) / elapsed_s : 0.0));
+    map_set_symbol(out, "copies", per_copy);
+    if (sim_time.has_value()) {
+        sim_time->write_summary(out);
+    }
+    return out;
+}
+
 }  // namespace
 
 void install_env_capability_builtins(env_ptr global_env) {
@@ -1497,9 +2364,11 @@ void install_env_capability_builtins(env_ptr global_env) {
     bind_primitive(global_env, "env.configure", builtin_env_configure);
     bind_primitive(global_env, "env.reset", builtin_env_reset);
     bind_primitive(global_env, "env.observe", builtin_env_observe);
+    bind_primitive(global_env, "env.observation", builtin_env_observation);
     bind_primitive(global_env, "env.act", builtin_env_act);
     bind_primitive(global_env, "env.step", builtin_env_step);
     bind_primitive(global_env, "env.run-loop", builtin_env_run_loop);
+    bind_primitive(global_env, "env.run-batch", builtin_env_run_batch);
     bind_primitive(global_env, "env.debug-draw", builtin_env_debug_draw);
 }
 
@@ -0,0 +1,292 @@
+#include "muslisp/env_shm.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bt/shm_exchange.hpp"
+#include "muslisp/gc.hpp"
+
+namespace muslisp {
+namespace {
+
+constexpr std::int64_t k_default_obs_capacity = 64;
+constexpr std::int64_t k_default_act_capacity = 16;
+constexpr std::int64_t k_default_timeout_ms = 1000;
+
+std::string normalize_option_key(std::string key) {
+    if (!key.empty() && key.front() == ':') {
+        key.erase(key.begin());
+    }
+    for (char& c : key) {
+        if (c == '-') {
+            c = '_';
+        }
+    }
+    return key;
+}
+
+std::optional<value> map_lookup_option(value map_obj, const std::string& normalized_key) {
+    for (const auto& [key, val] : map_obj->map_data()) {
+        if (key.type != map_key_type::symbol && key.type != map_key_type::string) {
+            continue;
+        }
+        if (normalize_option_key(key.text_data) == normalized_key) {
+            return val;
+        }
+    }
+    return std::nullopt;
+}
+
+void map_set_symbol(value map_obj, const std::string& key_name, value v) {
+    map_key key;
+    key.type = map_key_type::symbol;
+    key.text_data = key_name;
+    map_obj->map_data()[key] = v;
+    default_gc().write_barrier(map_obj, v);
+}
+
+std::int64_t option_int_or(value opts, const std::string& key, std::int64_t fallback, std::int64_t min_value) {
+    const auto v = map_lookup_option(opts, key);
+    if (!v.has_value()) {
+        return fallback;
+    }
+    if (!is_integer(*v) || integer_value(*v) < min_value) {
+        throw std::runtime_error("configure: " + key + " must be an integer >= " + std::to_string(min_value));
+    }
+    return integer_value(*v);
+}
+
+// Lockstep exchange with a host process: step() publishes the tick's action (an empty one holds the
+// host's previous command) and waits for an observation newer than the last one the BT read. A host
+// that publishes on its own clock instead makes step() return as soon as a newer observation exists.
+class shm_env_backend final : public env_backend {
+public:
+    ~shm_env_backend() override {
+        if (exchange_ && created_) {
+            exchange_->close();
+        }
+    }
+
+    [[nodiscard]] std::string backend_version() const override {
+        return "shm.exchange.v1";
+    }
+
+    [[nodiscard]] env_backend_supports supports() const override {
+        env_backend_supports out;
+        out.reset = true;
+        out.headless = true;
+        out.typed_observe = true;
+        out.simulated_time = true;
+        return out;
+    }
+
+    [[nodiscard]] std::string notes() const override {
+        return "Shared-memory observation/action exchange with an out-of-process simulator";
+    }
+
+    [[nodiscard]] value info() const override {
+        if (!exchange_) {
+            return make_nil();
+        }
+        value out = make_map();
+        gc_root_scope roots(default_gc());
+        roots.add(&out);
+        map_set_symbol(out, "shm_name", make_string(exchange_->name()));
+        map_set_symbol(out, "obs_capacity",
+                       make_integer(static_cast<std::int64_t>(exchange_->capacity(bt::shm_channel::observation))));
+        map_set_symbol(out, "act_capacity",
+                       make_integer(static_cast<std::int64_t>(exchange_->capacity(bt::shm_channel::action))));
+        map_set_symbol(out, "obs_seq",
+                       make_integer(static_cast<std::int64_t>(exchange_->latest(bt::shm_channel::observation))));
+        map_set_symbol(out, "act_seq",
+                       make_integer(static_cast<std::int64_t>(exchange_->latest(bt::shm_channel::action))));
+        map_set_symbol(out, "host_closed", make_boolean(exchange_->closed()));
+        return out;
+    }
+
+    void configure(value opts) override {
+        if (!is_map(opts)) {
+            throw std::runtime_error("configure: expected map");
+        }
+        timeout_ = std::chrono::milliseconds(option_int_or(opts, "timeout_ms", timeout_.count(), 1));
+        spin_ = std::chrono::microseconds(option_int_or(opts, "spin_us", spin_.count(), 0));
+        if (const auto schema = map_lookup_option(opts, "obs_schema")) {
+            if (!is_string(*schema)) {
+                throw std::runtime_error("configure: obs_schema must be string");
+            }
+            obs_schema_ = string_value(*schema);
+        }
+
+        const auto name = map_lookup_option(opts, "shm_name");
+        if (!name.has_value()) {
+            return;
+        }
+        if (!is_string(*name)) {
+            throw std::runtime_error("configure: shm_name must be string");
+        }
+        bool create = false;
+        if (const auto create_opt = map_lookup_option(opts, "create")) {
+            if (!is_boolean(*create_opt)) {
+                throw std::runtime_error("configure: create must be boolean");
+            }
+            create = boolean_value(*create_opt);
+        }
+        std::shared_ptr<bt::shm_exchange> exchange;
+        if (create) {
+            const auto obs_capacity = option_int_or(opts, "obs_capacity", k_default_obs_capacity, 1);
+            const auto act_capacity = option_int_or(opts, "act_capacity", k_default_act_capacity, 1);
+            exchange = bt::shm_exchange::create(string_value(*name), static_cast<std::size_t>(obs_capacity),
+                                                static_cast<std::size_t>(act_capacity));
+        } else {
+            exchange = bt::shm_exchange::open(string_value(*name));
+        }
+        if (exchange_ && created_) {
+            exchange_->close();
+        }
+        exchange_ = std::move(exchange);
+        created_ = create;
+        obs_ = bt::shm_message{};
+        pending_action_.clear();
+    }
+
+    [[nodiscard]] value reset(std::optional<std::int64_t> seed) override {
+        bt::shm_exchange& exchange = require_exchange();
+        const std::uint64_t after = exchange.latest(bt::shm_channel::observation);
+        std::uint32_t flags = bt::shm_message::k_flag_reset;
+        if (seed.has_value()) {
+            flags |= bt::shm_message::k_flag_seed;
+        }
+        (void)exchange.publish(bt::shm_channel::action, {}, obs_.t_ms, flags, seed.value_or(0));
+        pending_action_.clear();
+        if (!exchange.wait(bt::shm_channel::observation, after, timeout_, spin_)) {
+            throw_no_observation(exchange, "reset");
+        }
+        read_observation(exchange);
+        return observation_value();
+    }
+
+    [[nodiscard]] value observe() override {
+        bt::shm_exchange& exchange = require_exchange();
+        ensure_observation(exchange);
+        read_observation(exchange);
+        return observation_value();
+    }
+
+    void observe_into(env_observation_sink& sink) override {
+        bt::shm_exchange& exchange = require_exchange();
+        ensure_observation(exchange);
+        read_observation(exchange);
+        sink.put_string("obs_schema", obs_schema_);
+        sink.put_integer("t_ms", obs_.t_ms);
+        sink.put_vector("obs", obs_.values);
+        sink.put_bool("done", (obs_.flags & bt::shm_message::k_flag_done) != 0);
+    }
+
+    void act(value action) override {
+        const std::size_t capacity = require_exchange().capacity(bt::shm_channel::action);
+        if (!is_map(action)) {
+            throw std::runtime_error("expected action map");
+        }
+        const auto u = map_lookup_option(action, "u");
+        if (!u.has_value() || !is_proper_list(*u)) {
+            throw std::runtime_error("action map needs a list of numbers under 'u'");
+        }
+        pending_action_.clear();
+        for (value item = *u; is_cons(item); item = cdr(item)) {
+            const value v = car(item);
+            if (!is_number(v)) {
+                throw std::runtime_error("u must be list of numbers");
+            }
+            pending_action_.push_back(is_integer(v) ? static_cast<double>(integer_value(v)) : float_value(v));
+        }
+        if (pending_action_.size() > capacity) {
+            const std::size_t size = pending_action_.size();
+            pending_action_.clear();
+            throw std::runtime_error("u has " + std::to_string(size) + " entries but act_capacity is " +
+                                     std::to_string(capacity));
+        }
+    }
+
+    [[nodiscard]] bool step() override {
+        bt::shm_exchange& exchange = require_exchange();
+        if (exchange.closed()) {
+            return false;
+        }
+        (void)exchange.publish(bt::shm_channel::action, pending_action_, obs_.t_ms);
+        pending_action_.clear();
+        if (exchange.wait(bt::shm_channel::observation, obs_.seq, timeout_, spin_)) {
+            return true;
+        }
+        if (exchange.closed()) {
+            return false;
+        }
+        throw_no_observation(exchange, "step");
+    }
+
+private:
+    bt::shm_exchange& require_exchange() const {
+        if (!exchange_) {
+            throw std::runtime_error("shm backend is not connected; configure it with :shm_name");
+        }
+        return *exchange_;
+    }
+
+    void ensure_observation(bt::shm_exchange& exchange) const {
+        if (exchange.latest(bt::shm_channel::observation) == 0 &&
+            !exchange.wait(bt::shm_channel::observation, 0, timeout_, spin_)) {
+            throw_no_observation(exchange, "observe");
+        }
+    }
+
+    void read_observation(bt::shm_exchange& exchange) {
+        if (!exchange.read(bt::shm_channel::observation, obs_)) {
+            throw std::runtime_error("shm exchange " + exchange.name() + ": observation buffer stayed locked");
+        }
+    }
+
+    [[noreturn]] void throw_no_observation(const bt::shm_exchange& exchange, const char* what) const {
+        if (exchange.closed()) {
+            throw std::runtime_error(std::string(what) + ": shm exchange " + exchange.name() + " was closed");
+        }
+        throw std::runtime_error(std::string(what) + ": no observation from the host within " +
+                                 std::to_string(timeout_.count()) + " ms");
+    }
+
+    [[nodiscard]] value observation_value() const {
+        value obs = make_map();
+        value values = make_nil();
+        gc_root_scope roots(default_gc());
+        roots.add(&obs);
+        roots.add(&values);
+        for (std::size_t i = obs_.values.size(); i > 0; --i) {
+            values = make_cons(make_float(obs_.values[i - 1]), values);
+        }
+        map_set_symbol(obs, "obs_schema", make_string(obs_schema_));
+        map_set_symbol(obs, "t_ms", make_integer(obs_.t_ms));
+        map_set_symbol(obs, "obs", values);
+        map_set_symbol(obs, "done", make_boolean((obs_.flags & bt::shm_message::k_flag_done) != 0));
+        return obs;
+    }
+
+    std::shared_ptr<bt::shm_exchange> exchange_;
+    bool created_ = false;
+    std::chrono::milliseconds timeout_{k_default_timeout_ms};
+    std::chrono::microseconds spin_{bt::shm_exchange::k_default_spin};
+    std::string obs_schema_ = "env.obs.v1";
+    bt::shm_message obs_;
+    std::vector<double> pending_action_;
+};
+
+}  // namespace
+
+std::shared_ptr<env_backend> make_shm_env_backend() {
+    return std::make_shared<shm_env_backend>();
+}
+
+}  // namespace muslisp
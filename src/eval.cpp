@@ -5,12 +5,15 @@
 #include <fstream>
 #include <list>
 #include <sstream>
+#include <stdexcept>
+#include <string>
 #include <utility>
 
 #include "bt/compiler.hpp"
 #include "bt/runtime_host.hpp"
 #include "muslisp/env_api.hpp"
 #include "muslisp/env_builtins.hpp"
+#include "muslisp/env_shm.hpp"
 #include "muslisp/error.hpp"
 #include "muslisp/gc.hpp"
 #include "muslisp/reader.hpp"
@@ -363,9 +366,8 @@ value eval_define_form(const std::vector<value>& args, env_ptr scope) {
 
     if (is_symbol(args[0])) {
         expect_exact("define", args, 2);
-        const std::string name = symbol_name(args[0]);
         value bound = eval_non_tail(args[1], scope);
-        define(scope, name, bound);
+        define(scope, args[0], bound);
         return bound;
     }
 
@@ -386,9 +388,8 @@ value eval_define_form(const std::vector<value>& args, env_ptr scope) {
 
         const auto params = parse_params(list_from_vector(param_values));
         std::vector<value> body(args.begin() + 1, args.end());
-        const std::string function_name = symbol_name(signature[0]);
         value fn = make_closure(params, body, scope);
-        define(scope, function_name, fn);
+        define(scope, signature[0], fn);
         return fn;
     }
 
@@ -482,7 +483,7 @@ eval_outcome eval_let_form(const std::vector<value>& args, env_ptr scope, eval_p
         }
 
         value init_value = eval_non_tail(binding_items[1], scope);
-        define(child_scope, symbol_name(binding_items[0]), init_value);
+        define(child_scope, binding_items[0], init_value);
     }
 
     std::vector<value> body(args.begin() + 1, args.end());
@@ -546,7 +547,7 @@ value eval_defbt_form(const std::vector<value>& args, env_ptr scope) {
         throw lisp_error("defbt: first argument must be a symbol");
     }
     value compiled = eval_bt_form({args[1]});
-    define(scope, symbol_name(args[0]), compiled);
+    define(scope, args[0], compiled);
     return compiled;
 }
 
@@ -685,8 +686,9 @@ eval_outcome apply_callable_in_position(value fn_value, const std::vector<value>
 
         env_ptr call_scope = make_env(closure_env(fn_value));
         scoped_env_root call_scope_root(default_gc(), call_scope);
-        for (std::size_t i = 0; i < params.size(); ++i) {
-            define(call_scope, params[i], args[i]);
+        const auto& param_symbols = closure_param_symbols(fn_value);
+        for (std::size_t i = 0; i < param_symbols.size(); ++i) {
+            define(call_scope, param_symbols[i], args[i]);
         }
         if (call_position == eval_position::tail) {
             return eval_sequence_step(closure_body(fn_value), call_scope, eval_position::tail);
@@ -724,9 +726,12 @@ eval_outcome eval_step_in_position(value expr, env_ptr scope, eval_position posi
         case value_type::bt_instance:
         case value_type::image_handle:
         case value_type::blob_handle:
+        case value_type::pmap:
+        case value_type::pvec:
+        case value_type::f64vec:
             return make_eval_result(expr);
         case value_type::symbol:
-            return make_eval_result(lookup(scope, symbol_name(expr)));
+            return make_eval_result(lookup(scope, expr));
         case value_type::cons:
             return eval_list_form_in_position(expr, scope, position);
     }
@@ -821,9 +826,17 @@ value eval_source(std::string_view source, env_ptr scope) {
 
 env_ptr create_global_env(runtime_config config) {
     env_api_reset();
+    env_api_register_backend_factory("shm", make_shm_env_backend);
     reset_env_capability_runtime_state();
     env_ptr global = make_env();
     install_core_builtins(global);
+    if (config.heap_limits().has_value()) {
+        try {
+            default_gc().set_limits(*config.heap_limits());
+        } catch (const std::invalid_argument& e) {
+            throw lisp_error(std::string("create_global_env: ") + e.what());
+        }
+    }
     registrar reg(global);
     bt::runtime_host& host = bt::default_runtime_host();
     for (const auto& ext : config.extensions()) {
@@ -35,7 +35,7 @@ void registrar::ensure_registerable_name(const std::string& full_name, const cha
     if (full_name.empty()) {
         throw lisp_error(std::string(where) + ": name must not be empty");
     }
-    if (global_env_->bindings.find(full_name) != global_env_->bindings.end()) {
+    if (const value symbol = find_symbol(full_name); symbol && global_env_->bindings.count(symbol) != 0) {
         throw lisp_error(std::string(where) + ": symbol already defined: " + full_name);
     }
 }
@@ -51,4 +51,12 @@ const std::vector<std::unique_ptr<extension>>& runtime_config::extensions() cons
     return extensions_;
 }
 
+void runtime_config::set_heap_limits(const gc_limits& limits) {
+    heap_limits_ = limits;
+}
+
+const std::optional<gc_limits>& runtime_config::heap_limits() const noexcept {
+    return heap_limits_;
+}
+
 }  // namespace muslisp
@@ -1,37 +1,187 @@
 #include "muslisp/gc.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <stdexcept>
+#include <string>
 
 #include "muslisp/env.hpp"
+#include "muslisp/error.hpp"
 #include "muslisp/value.hpp"
 
+#if defined(__SANITIZE_ADDRESS__)
+#define MUSLISP_GC_ASAN 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define MUSLISP_GC_ASAN 1
+#endif
+#endif
+
+#if defined(MUSLISP_GC_ASAN)
+#include <sanitizer/asan_interface.h>
+#endif
+
 namespace muslisp {
+namespace {
+
+// Pooled cells never go back to the system allocator, so poison free cells (past the free-list link) for
+// AddressSanitizer builds to keep use-after-free reports working.
+void poison_free_cell(void* cell, std::size_t cell_bytes) noexcept {
+#if defined(MUSLISP_GC_ASAN)
+    ASAN_POISON_MEMORY_REGION(static_cast<std::byte*>(cell) + sizeof(void*), cell_bytes - sizeof(void*));
+#else
+    (void)cell;
+    (void)cell_bytes;
+#endif
+}
+
+void unpoison_cell(void* cell, std::size_t cell_bytes) noexcept {
+#if defined(MUSLISP_GC_ASAN)
+    ASAN_UNPOISON_MEMORY_REGION(cell, cell_bytes);
+#else
+    (void)cell;
+    (void)cell_bytes;
+#endif
+}
+
+std::atomic<std::uint16_t> g_next_heap_id{1};
+thread_local gc* t_thread_heap = nullptr;
+
+}  // namespace
 
-gc::gc() = default;
+gc::gc() : heap_id_(g_next_heap_id.fetch_add(1, std::memory_order_relaxed)) {}
 
 gc::~gc() {
-    gc_node* cursor = head_;
-    while (cursor) {
-        gc_node* next = cursor->next;
-        delete cursor;
-        cursor = next;
+    for (gc_node* list : {young_head_, head_}) {
+        gc_node* cursor = list;
+        while (cursor) {
+            gc_node* next = cursor->next;
+            destroy_node(cursor);
+            cursor = next;
+        }
+    }
+}
+
+void* gc::allocate_cell(std::uint8_t size_class, std::size_t bytes) {
+    if (size_class == kUnpooledSizeClass) {
+        return ::operator new(bytes);
+    }
+    if (!free_lists_[size_class]) {
+        refill_size_class(size_class);
+    }
+    free_cell* cell = free_lists_[size_class];
+    free_lists_[size_class] = cell->next;
+    --pool_free_cells_;
+    unpoison_cell(cell, (static_cast<std::size_t>(size_class) + 1) * kCellGranule);
+    return cell;
+}
+
+void gc::release_cell(void* memory, std::uint8_t size_class) noexcept {
+    if (size_class == kUnpooledSizeClass) {
+        ::operator delete(memory);
+        return;
+    }
+    auto* cell = static_cast<free_cell*>(memory);
+    cell->next = free_lists_[size_class];
+    free_lists_[size_class] = cell;
+    ++pool_free_cells_;
+    poison_free_cell(cell, (static_cast<std::size_t>(size_class) + 1) * kCellGranule);
+}
+
+void gc::refill_size_class(std::uint8_t size_class) {
+    const std::size_t cell_bytes = (static_cast<std::size_t>(size_class) + 1) * kCellGranule;
+    slabs_.push_back(std::make_unique<std::byte[]>(kSlabBytes));
+    std::byte* slab = slabs_.back().get();
+    for (std::size_t offset = 0; offset + cell_bytes <= kSlabBytes; offset += cell_bytes) {
+        release_cell(new (slab + offset) free_cell{}, size_class);
+    }
+}
+
+void gc::destroy_node(gc_node* node) noexcept {
+    const std::uint8_t size_class = node->size_class;
+    node->~gc_node();
+    release_cell(node, size_class);
+}
+
+void gc::check_hard_limit(gc_node* node, std::size_t bytes) {
+    // bytes_allocated_ counts garbage made since the last collection, and collecting here would free the
+    // caller's unrooted temporaries. So crossing the limit makes the next safe point a full collection,
+    // and only refuses the allocation when the last measured live set leaves no room for it or garbage
+    // has doubled the heap.
+    const std::size_t limit = limits_.hard_limit_bytes;
+    collection_requested_ = true;
+    requested_reason_ = gc_collection_reason::threshold;
+    full_collection_requested_ = true;
+    const bool live_over = live_bytes_after_full_ + bytes > limit;
+    const bool garbage_over = bytes_allocated_ + bytes - limit > limit;
+    if (!live_over && !garbage_over) {
+        return;
+    }
+    destroy_node(node);
+    ++hard_limit_failures_;
+    if (!hard_limit_reported_) {
+        hard_limit_reported_ = true;
+        emit_limit(gc_limit_kind::hard_limit_exceeded, limit, bytes);
     }
+    throw heap_limit_error("gc: heap limit of " + std::to_string(limit) + " bytes reached (" +
+                           std::to_string(live_over ? live_bytes_after_full_ : bytes_allocated_) + " live, allocating " +
+                           std::to_string(bytes) + ")");
 }
 
 void gc::link_node(gc_node* node, std::size_t bytes) {
-    node->next = head_;
-    head_ = node;
+    if (limits_.hard_limit_bytes != 0 && bytes_allocated_ + bytes > limits_.hard_limit_bytes) {
+        check_hard_limit(node, bytes);
+    }
+    node->next = young_head_;
+    young_head_ = node;
 
+    ++young_objects_;
+    young_bytes_ += bytes;
     ++allocated_objects_current_;
     ++total_allocated_objects_;
+    total_allocated_bytes_ += bytes;
     bytes_allocated_ += bytes;
 
-    if (allocated_objects_current_ > next_gc_threshold_) {
+    if (young_objects_ > limits_.nursery_objects) {
         collection_requested_ = true;
         requested_reason_ = gc_collection_reason::threshold;
     }
+    if (limits_.soft_limit_bytes != 0 && bytes_allocated_ >= pressure_trigger_bytes_) {
+        collection_requested_ = true;
+        requested_reason_ = gc_collection_reason::threshold;
+        if (!memory_pressure_) {
+            memory_pressure_ = true;
+            ++soft_limit_crossings_;
+            emit_limit(gc_limit_kind::soft_limit_reached, limits_.soft_limit_bytes, 0);
+        }
+    }
+}
+
+std::size_t gc::threshold_after(std::size_t live_count) const noexcept {
+    return std::max<std::size_t>(256, static_cast<std::size_t>(static_cast<double>(live_count) * limits_.growth_factor));
+}
+
+void gc::update_memory_pressure() noexcept {
+    live_bytes_after_full_ = bytes_allocated_;
+    full_collection_requested_ = false;
+    if (limits_.hard_limit_bytes == 0 || bytes_allocated_ <= limits_.hard_limit_bytes) {
+        hard_limit_reported_ = false;
+    }
+    if (limits_.soft_limit_bytes == 0 || bytes_allocated_ < limits_.soft_limit_bytes) {
+        memory_pressure_ = false;
+        pressure_trigger_bytes_ = limits_.soft_limit_bytes;
+        return;
+    }
+    // Still over after a full collection: collect again after a little growth rather than on every
+    // allocation, so a heap that really needs this much memory does not thrash.
+    memory_pressure_ = true;
+    pressure_trigger_bytes_ = bytes_allocated_ + std::max(bytes_allocated_ / 8, kSlabBytes);
+}
+
+void gc::remember(gc_node* node) {
+    node->remembered = true;
+    remembered_.push_back(node);
 }
 
 void gc::request_collection() {
@@ -40,7 +190,7 @@ void gc::request_collection() {
 }
 
 void gc::maybe_collect() {
-    if (!collection_requested_) {
+    if (!collection_requested_ && incremental_phase_ == incremental_phase::idle) {
         return;
     }
     if (policy_ == gc_policy::manual) {
@@ -52,6 +202,12 @@ void gc::maybe_collect() {
     if (policy_ == gc_policy::fail_on_tick_gc && in_tick()) {
         throw std::runtime_error("gc: collection requested during tick under fail-on-tick-gc policy");
     }
+    if (policy_ == gc_policy::incremental) {
+        if (!in_tick()) {
+            (void)step(incremental_slice_budget_);
+        }
+        return;
+    }
     const gc_collection_reason reason =
         policy_ == gc_policy::between_ticks ? gc_collection_reason::between_ticks : requested_reason_;
     collect_impl(reason, false);
@@ -65,6 +221,10 @@ void gc::collect() {
 }
 
 void gc::collect_impl(gc_collection_reason reason, bool forced) {
+    if (incremental_phase_ != incremental_phase::idle) {
+        complete_incremental_cycle();
+    }
+
     const auto pause_start = std::chrono::steady_clock::now();
     const std::uint64_t collection_id = collection_count_ + 1;
     const std::size_t live_objects_before = allocated_objects_current_;
@@ -77,25 +237,37 @@ void gc::collect_impl(gc_collection_reason reason, bool forced) {
     begin.policy = policy_;
     begin.forced = forced;
     begin.in_tick = in_tick();
+    begin.minor = !forced && !memory_pressure_ && !full_collection_requested_ &&
+                  allocated_objects_current_ - young_objects_ <= next_gc_threshold_;
     begin.heap_live_bytes_before = heap_live_bytes_before;
     begin.live_objects_before = live_objects_before;
     emit_lifecycle(begin);
 
+    // Forced collections, memory pressure, a crossed hard limit and an old generation past its threshold
+    // take a full mark/sweep; everything else is a minor collection over the young list, seeded by the
+    // roots and the remembered set.
+    const std::size_t old_objects = allocated_objects_current_ - young_objects_;
+    const bool minor = !forced && !memory_pressure_ && !full_collection_requested_ && old_objects <= next_gc_threshold_;
+
     const auto mark_start = std::chrono::steady_clock::now();
-    for (value* slot : root_slots_) {
-        if (slot) {
-            mark_value(*slot);
+    marking_minor_ = minor;
+    mark_roots();
+    if (minor) {
+        for (gc_node* node : remembered_) {
+            node->gc_mark_children(*this);
         }
     }
-
-    for (env_ptr root : root_envs_) {
-        mark_env(root);
-    }
-
-    mark_interned_symbols(*this);
+    marking_minor_ = false;
 
     const auto mark_end = std::chrono::steady_clock::now();
-    const sweep_result swept = sweep();
+    const sweep_result swept = minor ? sweep_minor() : sweep_full();
+    finish_sweep(swept);
+    if (minor) {
+        ++minor_collection_count_;
+    } else {
+        next_gc_threshold_ = threshold_after(swept.live_count);
+        update_memory_pressure();
+    }
     const auto sweep_end = std::chrono::steady_clock::now();
 
     const auto mark_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(mark_end - mark_start).count();
@@ -116,6 +288,7 @@ void gc::collect_impl(gc_collection_reason reason, bool forced) {
     end.policy = policy_;
     end.forced = forced;
     end.in_tick = in_tick();
+    end.minor = minor;
     end.heap_live_bytes_before = heap_live_bytes_before;
     end.heap_live_bytes_after = swept.live_bytes;
     end.live_objects_before = live_objects_before;
@@ -127,16 +300,46 @@ void gc::collect_impl(gc_collection_reason reason, bool forced) {
     emit_lifecycle(end);
 }
 
+void gc::mark_roots() {
+    for (value* slot : root_slots_) {
+        if (slot) {
+            mark_value(*slot);
+        }
+    }
+
+    for (const root_range& range : root_ranges_) {
+        const value* end = range.top ? *range.top : range.begin + range.count;
+        for (const value* it = range.begin; it < end; ++it) {
+            mark_value(*it);
+        }
+    }
+
+    for (env_ptr root : root_envs_) {
+        mark_env(root);
+    }
+}
+
 void gc::mark_node(gc_node* node) {
-    if (!node || node->marked) {
+    if (!node || node->heap_id != heap_id_ || node->marked || (marking_minor_ && node->old)) {
         return;
     }
 
     node->marked = true;
+    if (incremental_phase_ == incremental_phase::marking) {
+        gray_.push_back(node);
+        return;
+    }
     node->gc_mark_children(*this);
 }
 
+gc_node* gc::as_gc_node(value v) noexcept {
+    return v;
+}
+
 void gc::mark_value(value v) {
+    if (is_immediate(v)) {
+        return;
+    }
     mark_node(v);
 }
 
@@ -144,7 +347,49 @@ void gc::mark_env(env_ptr env) {
     mark_node(env);
 }
 
-gc::sweep_result gc::sweep() {
+gc::sweep_result gc::sweep_minor() {
+    std::size_t survivors = 0;
+    std::size_t survivor_bytes = 0;
+    std::size_t freed_count = 0;
+
+    gc_node* cursor = young_head_;
+    while (cursor) {
+        gc_node* next = cursor->next;
+        if (!cursor->marked) {
+            destroy_node(cursor);
+            ++freed_count;
+        } else {
+            cursor->marked = false;
+            cursor->old = true;
+            cursor->next = head_;
+            head_ = cursor;
+            ++survivors;
+            survivor_bytes += cursor->gc_size_bytes();
+        }
+        cursor = next;
+    }
+
+    promoted_objects_total_ += survivors;
+    const std::size_t old_count = allocated_objects_current_ - young_objects_;
+    const std::size_t old_bytes = bytes_allocated_ - young_bytes_;
+    return sweep_result{
+        .live_count = old_count + survivors, .live_bytes = old_bytes + survivor_bytes, .freed_count = freed_count};
+}
+
+gc::sweep_result gc::sweep_full() {
+    // Remembered nodes may be freed below, so drop the set before sweeping.
+    for (gc_node* node : remembered_) {
+        node->remembered = false;
+    }
+    remembered_.clear();
+
+    while (young_head_) {
+        gc_node* node = young_head_;
+        young_head_ = node->next;
+        node->next = head_;
+        head_ = node;
+    }
+
     gc_node** link = &head_;
     std::size_t live_count = 0;
     std::size_t live_bytes = 0;
@@ -154,29 +399,218 @@ gc::sweep_result gc::sweep() {
         gc_node* node = *link;
         if (!node->marked) {
             *link = node->next;
-            delete node;
+            destroy_node(node);
             ++freed_count;
             continue;
         }
 
+        if (!node->old) {
+            node->old = true;
+            ++promoted_objects_total_;
+        }
         node->marked = false;
         ++live_count;
         live_bytes += node->gc_size_bytes();
         link = &node->next;
     }
 
-    allocated_objects_current_ = live_count;
-    live_objects_after_last_gc_ = live_count;
-    bytes_allocated_ = live_bytes;
+    return sweep_result{.live_count = live_count, .live_bytes = live_bytes, .freed_count = freed_count};
+}
+
+void gc::finish_sweep(const sweep_result& result) {
+    // Every young survivor is now old, so no old-to-young edges remain.
+    for (gc_node* node : remembered_) {
+        node->remembered = false;
+    }
+    remembered_.clear();
+    young_head_ = nullptr;
+    young_objects_ = 0;
+    young_bytes_ = 0;
 
-    const std::size_t min_threshold = 256;
-    const std::size_t grown = live_count * 2;
-    next_gc_threshold_ = grown > min_threshold ? grown : min_threshold;
+    allocated_objects_current_ = result.live_count;
+    live_objects_after_last_gc_ = result.live_count;
+    bytes_allocated_ = result.live_bytes;
 
     collection_requested_ = false;
     requested_reason_ = gc_collection_reason::requested;
+}
 
-    return sweep_result{.live_count = live_count, .live_bytes = live_bytes, .freed_count = freed_count};
+bool gc::step(std::chrono::nanoseconds budget) {
+    if (incremental_phase_ == incremental_phase::idle) {
+        if (!collection_requested_) {
+            return false;
+        }
+        // Nursery-only collections are short, so they still run in one go.
+        if (!memory_pressure_ && allocated_objects_current_ - young_objects_ <= next_gc_threshold_) {
+            collect_impl(requested_reason_, false);
+            return false;
+        }
+        start_incremental_cycle(requested_reason_);
+    }
+    run_incremental_slice(std::chrono::steady_clock::now() + budget);
+    return incremental_phase_ != incremental_phase::idle;
+}
+
+void gc::start_incremental_cycle(gc_collection_reason reason) {
+    cycle_ = incremental_cycle{};
+    cycle_.collection_id = collection_count_ + 1;
+    cycle_.reason = reason;
+    cycle_.live_objects_before = allocated_objects_current_;
+    cycle_.heap_live_bytes_before = bytes_allocated_;
+
+    gc_lifecycle_event begin;
+    begin.begin = true;
+    begin.collection_id = cycle_.collection_id;
+    begin.reason = reason;
+    begin.policy = policy_;
+    begin.in_tick = in_tick();
+    begin.incremental = true;
+    begin.heap_live_bytes_before = cycle_.heap_live_bytes_before;
+    begin.live_objects_before = cycle_.live_objects_before;
+    emit_lifecycle(begin);
+
+    incremental_phase_ = incremental_phase::marking;
+    collection_requested_ = false;
+    mark_roots();
+}
+
+void gc::run_incremental_slice(std::chrono::steady_clock::time_point deadline) {
+    const auto slice_start = std::chrono::steady_clock::now();
+    ++cycle_.slice_count;
+    ++incremental_slice_count_;
+
+    if (incremental_phase_ == incremental_phase::marking) {
+        if (drain_gray(deadline)) {
+            finish_incremental_mark();
+        }
+        const auto mark_end = std::chrono::steady_clock::now();
+        cycle_.mark_time_ns += static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(mark_end - slice_start).count());
+        total_pause_ns_ += static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(mark_end - slice_start).count());
+        if (incremental_phase_ == incremental_phase::marking || mark_end >= deadline) {
+            return;
+        }
+    }
+
+    const auto sweep_start = std::chrono::steady_clock::now();
+    const bool done = sweep_incremental(deadline);
+    const auto sweep_ns = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - sweep_start).count());
+    cycle_.sweep_time_ns += sweep_ns;
+    total_pause_ns_ += sweep_ns;
+    if (done) {
+        finish_incremental_cycle();
+    }
+}
+
+bool gc::drain_gray(std::chrono::steady_clock::time_point deadline) {
+    constexpr std::size_t kClockCheckInterval = 256;
+    std::size_t scanned = 0;
+    while (!gray_.empty()) {
+        gc_node* node = gray_.back();
+        gray_.pop_back();
+        node->gc_mark_children(*this);
+        if (++scanned % kClockCheckInterval == 0 && std::chrono::steady_clock::now() >= deadline) {
+            return gray_.empty();
+        }
+    }
+    return true;
+}
+
+void gc::finish_incremental_mark() {
+    // Roots are not barriered, so rescan them and drain to completion before sweeping.
+    mark_roots();
+    (void)drain_gray(std::chrono::steady_clock::time_point::max());
+
+    // Survivors become old before the mutator resumes so the generational barrier sees them; their
+    // remembered entries are stale because everything live is now old.
+    for (gc_node* node : remembered_) {
+        node->remembered = false;
+    }
+    remembered_.clear();
+    while (young_head_) {
+        gc_node* node = young_head_;
+        young_head_ = node->next;
+        if (node->marked) {
+            node->old = true;
+            ++promoted_objects_total_;
+        }
+        node->next = head_;
+        head_ = node;
+    }
+    young_objects_ = 0;
+    young_bytes_ = 0;
+
+    incremental_phase_ = incremental_phase::sweeping;
+    cycle_.sweep_link = &head_;
+}
+
+bool gc::sweep_incremental(std::chrono::steady_clock::time_point deadline) {
+    constexpr std::size_t kClockCheckInterval = 256;
+    std::size_t visited = 0;
+    gc_node** link = cycle_.sweep_link;
+    while (*link) {
+        gc_node* node = *link;
+        if (!node->marked) {
+            *link = node->next;
+            destroy_node(node);
+            ++cycle_.swept.freed_count;
+        } else {
+            node->marked = false;
+            ++cycle_.swept.live_count;
+            cycle_.swept.live_bytes += node->gc_size_bytes();
+            link = &node->next;
+        }
+        if (++visited % kClockCheckInterval == 0 && std::chrono::steady_clock::now() >= deadline) {
+            cycle_.sweep_link = link;
+            return *link == nullptr;
+        }
+    }
+    cycle_.sweep_link = link;
+    return true;
+}
+
+void gc::finish_incremental_cycle() {
+    const sweep_result& swept = cycle_.swept;
+    incremental_phase_ = incremental_phase::idle;
+
+    // Objects allocated during the cycle are still on the young list and count as live.
+    allocated_objects_current_ = swept.live_count + young_objects_;
+    bytes_allocated_ = swept.live_bytes + young_bytes_;
+    live_objects_after_last_gc_ = swept.live_count;
+    next_gc_threshold_ = threshold_after(swept.live_count);
+    update_memory_pressure();
+    collection_count_ = cycle_.collection_id;
+    freed_objects_total_ += swept.freed_count;
+    if (young_objects_ > limits_.nursery_objects) {
+        collection_requested_ = true;
+        requested_reason_ = gc_collection_reason::threshold;
+    }
+
+    gc_lifecycle_event end;
+    end.begin = false;
+    end.collection_id = cycle_.collection_id;
+    end.reason = cycle_.reason;
+    end.policy = policy_;
+    end.in_tick = in_tick();
+    end.incremental = true;
+    end.slice_count = cycle_.slice_count;
+    end.heap_live_bytes_before = cycle_.heap_live_bytes_before;
+    end.heap_live_bytes_after = swept.live_bytes;
+    end.live_objects_before = cycle_.live_objects_before;
+    end.live_objects_after = swept.live_count;
+    end.freed_objects = swept.freed_count;
+    end.mark_time_ns = cycle_.mark_time_ns;
+    end.sweep_time_ns = cycle_.sweep_time_ns;
+    end.pause_time_ns = cycle_.mark_time_ns + cycle_.sweep_time_ns;
+    emit_lifecycle(end);
+}
+
+void gc::complete_incremental_cycle() {
+    while (incremental_phase_ != incremental_phase::idle) {
+        run_incremental_slice(std::chrono::steady_clock::time_point::max());
+    }
 }
 
 void gc::add_root_slot(value* slot) {
@@ -193,6 +627,28 @@ void gc::remove_root_slot(value* slot) {
     }
 }
 
+void gc::add_root_range(const value* begin, std::size_t count) {
+    if (!begin || count == 0) {
+        return;
+    }
+    root_ranges_.push_back(root_range{.begin = begin, .count = count});
+}
+
+void gc::add_root_stack(const value* begin, value* const* top) {
+    if (!begin || !top) {
+        return;
+    }
+    root_ranges_.push_back(root_range{.begin = begin, .count = 0, .top = top});
+}
+
+void gc::remove_root_range(const value* begin) {
+    const auto it = std::find_if(
+        root_ranges_.rbegin(), root_ranges_.rend(), [begin](const root_range& range) { return range.begin == begin; });
+    if (it != root_ranges_.rend()) {
+        root_ranges_.erase(std::next(it).base());
+    }
+}
+
 void gc::register_root_env(env_ptr env) {
     if (!env) {
         return;
@@ -210,6 +666,7 @@ void gc::unregister_root_env(env_ptr env) {
 gc_stats_snapshot gc::stats() const noexcept {
     gc_stats_snapshot snapshot;
     snapshot.total_allocated_objects = total_allocated_objects_;
+    snapshot.total_allocated_bytes = total_allocated_bytes_;
     snapshot.live_objects_after_last_gc = live_objects_after_last_gc_;
     snapshot.bytes_allocated = bytes_allocated_;
     snapshot.next_gc_threshold = next_gc_threshold_;
@@ -217,6 +674,17 @@ gc_stats_snapshot gc::stats() const noexcept {
     snapshot.total_pause_ns = total_pause_ns_;
     snapshot.freed_objects_total = freed_objects_total_;
     snapshot.forced_collection_count = forced_collection_count_;
+    snapshot.minor_collection_count = minor_collection_count_;
+    snapshot.young_objects = young_objects_;
+    snapshot.promoted_objects_total = promoted_objects_total_;
+    snapshot.remembered_set_size = remembered_.size();
+    snapshot.pool_reserved_bytes = slabs_.size() * kSlabBytes;
+    snapshot.pool_free_cells = pool_free_cells_;
+    snapshot.incremental_cycle_active = incremental_phase_ != incremental_phase::idle;
+    snapshot.incremental_slice_count = incremental_slice_count_;
+    snapshot.memory_pressure = memory_pressure_;
+    snapshot.soft_limit_crossings = soft_limit_crossings_;
+    snapshot.hard_limit_failures = hard_limit_failures_;
     return snapshot;
 }
 
@@ -232,15 +700,39 @@ void gc::enter_tick() noexcept {
     ++tick_depth_;
 }
 
-void gc::exit_tick() {
+void gc::exit_tick(std::optional<std::chrono::nanoseconds> slack) {
     if (tick_depth_ > 0) {
         --tick_depth_;
     }
-    if (tick_depth_ == 0 && collection_requested_ && policy_ == gc_policy::between_ticks) {
+    if (tick_depth_ != 0) {
+        return;
+    }
+    if (collection_requested_ && policy_ == gc_policy::between_ticks) {
         collect_impl(gc_collection_reason::between_ticks, false);
+        return;
+    }
+    if (policy_ == gc_policy::incremental &&
+        (collection_requested_ || incremental_phase_ != incremental_phase::idle)) {
+        // No slack left means the tick overran; leave the work for a later tick.
+        if (slack.has_value() && slack->count() <= 0) {
+            return;
+        }
+        (void)step(slack.has_value() ? std::min(*slack, incremental_slice_budget_) : incremental_slice_budget_);
     }
 }
 
+void gc::set_incremental_slice_budget(std::chrono::nanoseconds budget) noexcept {
+    incremental_slice_budget_ = budget;
+}
+
+std::chrono::nanoseconds gc::incremental_slice_budget() const noexcept {
+    return incremental_slice_budget_;
+}
+
+bool gc::incremental_cycle_active() const noexcept {
+    return incremental_phase_ != incremental_phase::idle;
+}
+
 bool gc::in_tick() const noexcept {
     return tick_depth_ > 0;
 }
@@ -253,6 +745,45 @@ void gc::clear_lifecycle_listener() {
     lifecycle_listener_ = {};
 }
 
+void gc::set_limits(const gc_limits& limits) {
+    if (!(limits.growth_factor >= 1.0)) {
+        throw std::invalid_argument("gc limits: growth_factor must be >= 1");
+    }
+    if (limits.nursery_objects == 0) {
+        throw std::invalid_argument("gc limits: nursery_objects must be >= 1");
+    }
+    if (limits.soft_limit_bytes != 0 && limits.hard_limit_bytes != 0 && limits.soft_limit_bytes > limits.hard_limit_bytes) {
+        throw std::invalid_argument("gc limits: soft_limit_bytes must not exceed hard_limit_bytes");
+    }
+    limits_ = limits;
+    // Re-evaluated against the current heap; a heap already past the new soft limit reports the
+    // crossing on its next allocation.
+    memory_pressure_ = false;
+    pressure_trigger_bytes_ = limits_.soft_limit_bytes;
+    hard_limit_reported_ = false;
+}
+
+void gc::set_limit_listener(limit_listener listener) {
+    limit_listener_ = std::move(listener);
+}
+
+void gc::clear_limit_listener() {
+    limit_listener_ = {};
+}
+
+void gc::emit_limit(gc_limit_kind kind, std::size_t limit_bytes, std::size_t request_bytes) {
+    if (!limit_listener_) {
+        return;
+    }
+    gc_limit_event event;
+    event.kind = kind;
+    event.heap_live_bytes = bytes_allocated_;
+    event.limit_bytes = limit_bytes;
+    event.request_bytes = request_bytes;
+    event.in_tick = in_tick();
+    limit_listener_(event);
+}
+
 std::string_view gc::policy_name(gc_policy policy) noexcept {
     switch (policy) {
         case gc_policy::default_policy:
@@ -263,6 +794,8 @@ std::string_view gc::policy_name(gc_policy policy) noexcept {
             return "manual";
         case gc_policy::fail_on_tick_gc:
             return "fail-on-tick-gc";
+        case gc_policy::incremental:
+            return "incremental";
     }
     return "default";
 }
@@ -301,6 +834,10 @@ bool gc::parse_policy(std::string_view text, gc_policy& out) noexcept {
         out = gc_policy::fail_on_tick_gc;
         return true;
     }
+    if (text == "incremental") {
+        out = gc_policy::incremental;
+        return true;
+    }
     return false;
 }
 
@@ -311,10 +848,21 @@ void gc::emit_lifecycle(const gc_lifecycle_event& event) {
 }
 
 gc& default_gc() {
+    if (t_thread_heap) {
+        return *t_thread_heap;
+    }
     static gc heap;
     return heap;
 }
 
+gc_thread_heap_scope::gc_thread_heap_scope(gc& heap) noexcept : previous_(t_thread_heap) {
+    t_thread_heap = &heap;
+}
+
+gc_thread_heap_scope::~gc_thread_heap_scope() {
+    t_thread_heap = previous_;
+}
+
 gc_root_scope::gc_root_scope(gc& heap) : heap_(heap), begin_index_(heap.root_slots_.size()) {}
 
 gc_root_scope::~gc_root_scope() {
@@ -330,7 +878,11 @@ gc_tick_scope::gc_tick_scope(gc& heap) : heap_(heap) {
 }
 
 gc_tick_scope::~gc_tick_scope() {
-    heap_.exit_tick();
+    heap_.exit_tick(slack_);
+}
+
+void gc_tick_scope::set_slack(std::chrono::nanoseconds slack) noexcept {
+    slack_ = slack;
 }
 
 }  // namespace muslisp
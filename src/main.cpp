@@ -1,18 +1,31 @@
 #include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <charconv>
+#include <cstdint>
 #include <cstdlib>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <optional>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
 #include <vector>
 
+#include "bt/compiled_tree.hpp"
+#include "bt/compiler.hpp"
+#include "bt/model_service_mux.hpp"
+#include "bt/runtime_host.hpp"
 #include "muslisp/error.hpp"
 #include "muslisp/eval.hpp"
 #include "muslisp/gc.hpp"
 #include "muslisp/printer.hpp"
 #include "muslisp/reader.hpp"
+#include "muslisp/snapshot.hpp"
 #include "repl_support.hpp"
 
 #if defined(MUESLI_BT_HAVE_LINENOISE)
@@ -126,6 +139,85 @@ model_service_start_options parse_model_service_start_options(int argc, char** a
     return opts;
 }
 
+int parse_int_option(const std::string& option, std::string_view text) {
+    int value = 0;
+    const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc{} || end != text.data() + text.size()) {
+        throw muslisp::lisp_error(option + ": expected an integer, got '" + std::string(text) + "'");
+    }
+    return value;
+}
+
+// "2,3" or "4-7" or a mix of both.
+std::vector<int> parse_cpu_list(const std::string& option, std::string_view text) {
+    std::vector<int> cpus;
+    while (!text.empty()) {
+        const std::size_t comma = text.find(',');
+        const std::string_view item = text.substr(0, comma);
+        const std::size_t dash = item.find('-', 1);
+        if (dash == std::string_view::npos) {
+            cpus.push_back(parse_int_option(option, item));
+        } else {
+            const int first = parse_int_option(option, item.substr(0, dash));
+            const int last = parse_int_option(option, item.substr(dash + 1));
+            if (last < first) {
+                throw muslisp::lisp_error(option + ": empty cpu range '" + std::string(item) + "'");
+            }
+            for (int cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        }
+        text = comma == std::string_view::npos ? std::string_view{} : text.substr(comma + 1);
+    }
+    if (cpus.empty()) {
+        throw muslisp::lisp_error(option + ": expected a cpu list");
+    }
+    return cpus;
+}
+
+// Consumes leading --sched-* options; `index` is left at the first other argument.
+bool parse_scheduler_options(int argc, char** argv, int& index, bt::runtime_host_options& out) {
+    bool any = false;
+    for (; index < argc; ++index) {
+        const std::string arg = argv[index];
+        if (arg == "--sched-workers") {
+            const int workers = parse_int_option(arg, next_option_value(argc, argv, index, arg));
+            if (workers <= 0) {
+                throw muslisp::lisp_error(arg + ": expected a positive worker count");
+            }
+            out.scheduler_workers = static_cast<std::size_t>(workers);
+        } else if (arg == "--sched-cpus") {
+            out.scheduler_threads.cpus = parse_cpu_list(arg, next_option_value(argc, argv, index, arg));
+        } else if (arg == "--sched-fifo") {
+            const int priority = parse_int_option(arg, next_option_value(argc, argv, index, arg));
+            if (priority < 1 || priority > 99) {
+                throw muslisp::lisp_error(arg + ": priority must be in 1..99");
+            }
+            out.scheduler_threads.fifo_priority = priority;
+        } else if (arg == "--sched-nice") {
+            const int nice = parse_int_option(arg, next_option_value(argc, argv, index, arg));
+            if (nice < -20 || nice > 19) {
+                throw muslisp::lisp_error(arg + ": nice level must be in -20..19");
+            }
+            out.scheduler_threads.nice = nice;
+        } else if (arg == "--sched-thread-name") {
+            out.scheduler_threads.name_prefix = next_option_value(argc, argv, index, arg);
+        } else {
+            break;
+        }
+        any = true;
+    }
+    return any;
+}
+
+void write_profile(const std::filesystem::path& path) {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("--profile-out: cannot write " + path.string());
+    }
+    out << bt::default_runtime_host().dump_flamegraph();
+}
+
 std::string build_model_service_start_command(const model_service_start_options& opts) {
     std::ostringstream cmd;
     if (opts.service_dir.has_value()) {
@@ -160,12 +252,151 @@ int run_model_service_start(int argc, char** argv) {
     return 0;
 }
 
+// Serves a bt::model_service_mux on SOCKET_PATH until SIGINT or SIGTERM.
+int run_model_service_mux(int argc, char** argv) {
+    if (argc < 3) {
+        throw muslisp::lisp_error("--model-service-mux: expected SOCKET_PATH");
+    }
+    bt::model_service_mux_options mux_options;
+    mux_options.socket_path = argv[2];
+    bt::model_service_config upstream;
+    for (int i = 3; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--endpoint") {
+            upstream.endpoint = next_option_value(argc, argv, i, arg);
+            continue;
+        }
+        const int value = parse_int_option(arg, next_option_value(argc, argv, i, arg));
+        if (value < 0 || (value == 0 && arg != "--cache-ttl-ms")) {
+            throw muslisp::lisp_error(arg + ": expected a positive integer");
+        }
+        if (arg == "--connection-pool-size") {
+            upstream.connection_pool_size = static_cast<std::size_t>(value);
+        } else if (arg == "--connect-timeout-ms") {
+            upstream.connect_timeout_ms = value;
+        } else if (arg == "--request-timeout-ms") {
+            upstream.request_timeout_ms = value;
+        } else if (arg == "--workers") {
+            mux_options.upstream_workers = static_cast<std::size_t>(value);
+        } else if (arg == "--cache-ttl-ms") {
+            mux_options.cache_ttl_ms = value;
+        } else if (arg == "--cache-entries") {
+            mux_options.cache_entries = static_cast<std::size_t>(value);
+        } else {
+            throw muslisp::lisp_error("unknown model-service mux option: " + arg);
+        }
+    }
+#if defined(_WIN32)
+    throw muslisp::lisp_error("--model-service-mux: not supported on this platform");
+#else
+    // Blocked before any thread starts, so every thread inherits the mask and sigwait sees the signal.
+    sigset_t stop_signals;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, nullptr);
+
+    std::unique_ptr<bt::model_service_client> client;
+    if (bt::is_unix_model_service_endpoint(upstream.endpoint)) {
+        client = bt::make_unix_model_service_client(upstream);
+    } else {
+#if defined(MUESLI_BT_WITH_MODEL_SERVICE_BRIDGE) && MUESLI_BT_WITH_MODEL_SERVICE_BRIDGE
+        client = bt::make_websocket_model_service_client(upstream);
+#else
+        throw muslisp::lisp_error("--model-service-mux: optional model-service bridge is not built");
+#endif
+    }
+    const bt::model_service_mux mux(std::move(mux_options), std::move(client));
+    std::cerr << "model-service mux: unix://" << mux.options().socket_path << " -> " << upstream.endpoint << '\n';
+    int signal = 0;
+    (void)sigwait(&stop_signals, &signal);
+    const bt::model_service_mux_stats stats = mux.stats();
+    std::cerr << "model-service mux: " << stats.requests << " requests, " << stats.upstream_calls << " upstream calls, "
+              << stats.deduplicated << " deduplicated, " << stats.cache_hits << " cache hits\n";
+    return 0;
+#endif
+}
+
+int run_emit_cpp(int argc, char** argv) {
+    if (argc != 5) {
+        throw muslisp::lisp_error("--emit-cpp: expected NAME DSL_FILE OUT_CPP");
+    }
+    const std::string name = argv[2];
+    const bt::definition def = bt::compile_definition(muslisp::read_one(read_text_file(argv[3])));
+    bt::emit_compiled_tree_file(def, name, argv[4]);
+    return 0;
+}
+
+// With --startup-timing, prints to stderr how long each start-up phase took and how long after
+// start the first BT tick began.
+class startup_timer {
+public:
+    explicit startup_timer(bool enabled) : enabled_(enabled) {}
+
+    void phase(std::string_view name) {
+        const auto now = std::chrono::steady_clock::now();
+        if (enabled_) {
+            std::cerr << "startup: " << name << ' ' << ms(now - last_) << " ms\n";
+        }
+        last_ = now;
+    }
+
+    void report_first_tick(bt::runtime_host& host) const {
+        if (!enabled_) {
+            return;
+        }
+        host.set_first_tick_listener([origin = origin_] {
+            std::cerr << "startup: first tick after " << ms(std::chrono::steady_clock::now() - origin) << " ms\n";
+        });
+    }
+
+private:
+    static double ms(std::chrono::steady_clock::duration d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    }
+
+    bool enabled_;
+    std::chrono::steady_clock::time_point origin_ = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point last_ = origin_;
+};
+
 int print_usage() {
     std::cout
         << "usage:\n"
-        << "  muslisp [script.lisp]\n"
+        << "  muslisp [scheduler options] [observability options] [start-up options] [snapshot options]\n"
+        << "          [script.lisp]\n"
         << "  muslisp --model-service-start [--model-service-dir DIR] [--host HOST] [--port PORT]\n"
         << "                                [--log-level LEVEL] [--replay-path PATH] [--no-mock]\n"
+        << "  muslisp --model-service-mux SOCKET_PATH [--endpoint URL] [--workers N] [--cache-ttl-ms N]\n"
+        << "                              [--cache-entries N] [--connection-pool-size N]\n"
+        << "                              [--connect-timeout-ms N] [--request-timeout-ms N]\n"
+        << "                             share one model-service connection among local muslisp\n"
+        << "                             processes, which configure :endpoint \"unix://SOCKET_PATH\"\n"
+        << "  muslisp --emit-cpp NAME DSL_FILE OUT_CPP\n"
+        << "                             write the tree in DSL_FILE as a compiled_tree C++ source\n"
+        << "\n"
+        << "scheduler options:\n"
+        << "  --sched-workers N          job scheduler worker threads\n"
+        << "                             (default: min(hardware threads, 4))\n"
+        << "  --sched-cpus LIST          pin worker i to the i-th cpu of LIST, e.g. 2,3 or 4-7\n"
+        << "  --sched-fifo PRIO          run workers under SCHED_FIFO at PRIO (1-99)\n"
+        << "  --sched-nice N             nice level for workers (-20..19)\n"
+        << "  --sched-thread-name NAME   worker thread name prefix (default mbt-sched)\n"
+        << "\n"
+        << "observability options:\n"
+        << "  --profile-out PATH         on exit, write per-node collapsed stacks of every live BT\n"
+        << "                             instance to PATH (flamegraph.pl, inferno, speedscope)\n"
+        << "  --metrics-port N           serve OpenMetrics at http://127.0.0.1:N/metrics (0 picks a port)\n"
+        << "  --metrics-bind ADDR        IPv4 address the metrics endpoint binds (default 127.0.0.1)\n"
+        << "\n"
+        << "start-up options:\n"
+        << "  --preload-dsl FILE         compile FILE before the script runs; repeatable, files compile in\n"
+        << "                             parallel and later bt.load-dsl calls on them reuse the result\n"
+        << "  --startup-timing           print the time of each start-up phase and of the first tick\n"
+        << "\n"
+        << "snapshot options:\n"
+        << "  --snapshot PATH            restore global bindings from a snapshot before the script runs\n"
+        << "  --save-snapshot PATH       after the script or REPL, save the global bindings to PATH\n"
         << "\n"
         << "model service discovery:\n"
         << "  --model-service-dir DIR, MUESLI_MODEL_SERVICE_DIR, ../muesli-model-service, then PATH\n";
@@ -186,7 +417,8 @@ int run_script(const std::string& path, muslisp::env_ptr env) {
 
     for (muslisp::value expr : exprs) {
         result = muslisp::eval(expr, env);
-        std::cout << muslisp::print_value(result) << '\n';
+        muslisp::print_value(std::cout, result);
+        std::cout << '\n';
         muslisp::default_gc().maybe_collect();
     }
 
@@ -315,7 +547,8 @@ int run_repl(muslisp::env_ptr env) {
 
             for (muslisp::value expr : exprs) {
                 result = muslisp::eval(expr, env);
-                std::cout << muslisp::print_value(result) << '\n';
+                muslisp::print_value(std::cout, result);
+                std::cout << '\n';
                 muslisp::default_gc().maybe_collect();
             }
             buffer.clear();
@@ -345,11 +578,77 @@ int main(int argc, char** argv) {
         if (argc > 1 && std::string(argv[1]) == "--model-service-start") {
             return run_model_service_start(argc, argv);
         }
+        if (argc > 1 && std::string(argv[1]) == "--model-service-mux") {
+            return run_model_service_mux(argc, argv);
+        }
+        if (argc > 1 && std::string(argv[1]) == "--emit-cpp") {
+            return run_emit_cpp(argc, argv);
+        }
+        int arg_index = 1;
+        bt::runtime_host_options host_options;
+        if (parse_scheduler_options(argc, argv, arg_index, host_options)) {
+            bt::set_default_runtime_host_options(std::move(host_options));
+        }
+        std::optional<std::filesystem::path> profile_out;
+        std::optional<std::uint16_t> metrics_port;
+        std::string metrics_bind = "127.0.0.1";
+        std::optional<std::string> snapshot_in;
+        std::optional<std::string> snapshot_out;
+        std::vector<std::string> preload_dsl;
+        bool startup_timing = false;
+        for (; arg_index < argc; ++arg_index) {
+            const std::string arg = argv[arg_index];
+            if (arg == "--profile-out") {
+                profile_out = std::filesystem::path(next_option_value(argc, argv, arg_index, arg));
+            } else if (arg == "--metrics-port") {
+                const int port = parse_int_option(arg, next_option_value(argc, argv, arg_index, arg));
+                if (port < 0 || port > 65535) {
+                    throw muslisp::lisp_error(arg + ": port must be in 0..65535");
+                }
+                metrics_port = static_cast<std::uint16_t>(port);
+            } else if (arg == "--metrics-bind") {
+                metrics_bind = next_option_value(argc, argv, arg_index, arg);
+            } else if (arg == "--snapshot") {
+                snapshot_in = next_option_value(argc, argv, arg_index, arg);
+            } else if (arg == "--save-snapshot") {
+                snapshot_out = next_option_value(argc, argv, arg_index, arg);
+            } else if (arg == "--preload-dsl") {
+                preload_dsl.push_back(next_option_value(argc, argv, arg_index, arg));
+            } else if (arg == "--startup-timing") {
+                startup_timing = true;
+            } else {
+                break;
+            }
+        }
+        startup_timer timer(startup_timing);
         muslisp::env_ptr env = muslisp::create_global_env();
-        if (argc > 1) {
-            return run_script(argv[1], env);
+        timer.phase("global-env");
+        timer.report_first_tick(bt::default_runtime_host());
+        if (!preload_dsl.empty()) {
+            try {
+                (void)bt::default_runtime_host().load_dsl_files(preload_dsl);
+            } catch (const std::runtime_error& e) {
+                throw muslisp::lisp_error(std::string("--preload-dsl: ") + e.what());
+            }
+            timer.phase("preload-dsl");
+        }
+        if (snapshot_in.has_value()) {
+            (void)muslisp::load_snapshot(env, *snapshot_in);
+            timer.phase("snapshot");
+        }
+        if (metrics_port.has_value()) {
+            const std::uint16_t port = bt::default_runtime_host().start_metrics_endpoint(*metrics_port, metrics_bind);
+            std::cerr << "metrics: http://" << metrics_bind << ':' << port << "/metrics\n";
+            timer.phase("metrics");
+        }
+        const int code = arg_index < argc ? run_script(argv[arg_index], env) : run_repl(env);
+        if (profile_out.has_value()) {
+            write_profile(*profile_out);
+        }
+        if (snapshot_out.has_value() && code == 0) {
+            (void)muslisp::save_snapshot(env, *snapshot_out);
         }
-        return run_repl(env);
+        return code;
     } catch (const std::exception& e) {
         std::cerr << "fatal: " << e.what() << '\n';
         return 1;
@@ -0,0 +1,675 @@
+#include "muslisp/persistent.hpp"
+
+#include <bit>
+#include <string>
+#include <utility>
+
+#include "muslisp/error.hpp"
+
+namespace muslisp {
+namespace {
+
+constexpr unsigned kBits = 5;
+constexpr std::size_t kWidth = std::size_t{1} << kBits;
+constexpr std::size_t kMask = kWidth - 1;
+constexpr unsigned kHashBits = 64;
+
+std::uint64_t next_edit_id() {
+    static std::uint64_t counter = 0;
+    return ++counter;
+}
+
+std::uint64_t key_hash(const map_key& key) {
+    // map_key_hash is the identity for integers; finalise it so consecutive keys spread across levels.
+    std::uint64_t h = static_cast<std::uint64_t>(map_key_hash{}(key));
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+std::uint32_t hash_bit(std::uint64_t hash, unsigned shift) {
+    return std::uint32_t{1} << ((hash >> shift) & kMask);
+}
+
+std::size_t slot_index(std::uint32_t bitmap, std::uint32_t bit) {
+    return static_cast<std::size_t>(std::popcount(bitmap & (bit - 1)));
+}
+
+hamt_node* new_hamt_node(std::uint64_t edit) {
+    hamt_node* node = default_gc().allocate<hamt_node>();
+    node->edit = edit;
+    return node;
+}
+
+// Returns `node` itself when the caller's transient owns it, otherwise a copy owned by `edit`.
+hamt_node* editable(hamt_node* node, std::uint64_t edit) {
+    if (edit != 0 && node->edit == edit) {
+        return node;
+    }
+    hamt_node* copy = new_hamt_node(edit);
+    copy->bitmap = node->bitmap;
+    copy->collision = node->collision;
+    copy->slots = node->slots;
+    return copy;
+}
+
+void set_mapped(hamt_node* node, std::size_t index, value mapped) {
+    node->slots[index].mapped = mapped;
+    default_gc().write_barrier(node, mapped);
+}
+
+void set_child(hamt_node* node, std::size_t index, hamt_node* child) {
+    node->slots[index] = hamt_node::slot{.key = {}, .mapped = nullptr, .child = child};
+    default_gc().write_barrier(node, child);
+}
+
+hamt_node* make_pair_node(unsigned shift,
+                          std::uint64_t hash_a,
+                          const map_key& key_a,
+                          value mapped_a,
+                          std::uint64_t hash_b,
+                          const map_key& key_b,
+                          value mapped_b,
+                          std::uint64_t edit) {
+    hamt_node* node = new_hamt_node(edit);
+    if (shift >= kHashBits) {
+        node->collision = true;
+        node->slots.push_back({.key = key_a, .mapped = mapped_a});
+        node->slots.push_back({.key = key_b, .mapped = mapped_b});
+        return node;
+    }
+
+    const std::uint32_t bit_a = hash_bit(hash_a, shift);
+    const std::uint32_t bit_b = hash_bit(hash_b, shift);
+    if (bit_a == bit_b) {
+        node->bitmap = bit_a;
+        hamt_node::slot branch;
+        branch.child = make_pair_node(shift + kBits, hash_a, key_a, mapped_a, hash_b, key_b, mapped_b, edit);
+        node->slots.push_back(std::move(branch));
+        return node;
+    }
+    node->bitmap = bit_a | bit_b;
+    if (bit_a < bit_b) {
+        node->slots.push_back({.key = key_a, .mapped = mapped_a});
+        node->slots.push_back({.key = key_b, .mapped = mapped_b});
+    } else {
+        node->slots.push_back({.key = key_b, .mapped = mapped_b});
+        node->slots.push_back({.key = key_a, .mapped = mapped_a});
+    }
+    return node;
+}
+
+hamt_node* hamt_assoc(hamt_node* node,
+                      unsigned shift,
+                      std::uint64_t hash,
+                      const map_key& key,
+                      value mapped,
+                      std::uint64_t edit,
+                      bool& added) {
+    if (!node) {
+        hamt_node* fresh = new_hamt_node(edit);
+        fresh->bitmap = hash_bit(hash, shift);
+        fresh->slots.push_back({.key = key, .mapped = mapped});
+        added = true;
+        return fresh;
+    }
+
+    if (node->collision) {
+        for (std::size_t i = 0; i < node->slots.size(); ++i) {
+            if (node->slots[i].key == key) {
+                if (node->slots[i].mapped == mapped) {
+                    return node;
+                }
+                hamt_node* out = editable(node, edit);
+                set_mapped(out, i, mapped);
+                return out;
+            }
+        }
+        hamt_node* out = editable(node, edit);
+        out->slots.push_back({.key = key, .mapped = mapped});
+        default_gc().write_barrier(out, mapped);
+        added = true;
+        return out;
+    }
+
+    const std::uint32_t bit = hash_bit(hash, shift);
+    const std::size_t index = slot_index(node->bitmap, bit);
+    if ((node->bitmap & bit) == 0) {
+        hamt_node* out = editable(node, edit);
+        out->slots.insert(out->slots.begin() + static_cast<std::ptrdiff_t>(index),
+                          hamt_node::slot{.key = key, .mapped = mapped});
+        out->bitmap |= bit;
+        default_gc().write_barrier(out, mapped);
+        added = true;
+        return out;
+    }
+
+    const hamt_node::slot& existing = node->slots[index];
+    if (existing.child) {
+        hamt_node* child = hamt_assoc(existing.child, shift + kBits, hash, key, mapped, edit, added);
+        if (child == existing.child) {
+            return node;
+        }
+        hamt_node* out = editable(node, edit);
+        set_child(out, index, child);
+        return out;
+    }
+    if (existing.key == key) {
+        if (existing.mapped == mapped) {
+            return node;
+        }
+        hamt_node* out = editable(node, edit);
+        set_mapped(out, index, mapped);
+        return out;
+    }
+
+    hamt_node* split = make_pair_node(
+        shift + kBits, key_hash(existing.key), existing.key, existing.mapped, hash, key, mapped, edit);
+    hamt_node* out = editable(node, edit);
+    set_child(out, index, split);
+    added = true;
+    return out;
+}
+
+// Returns the updated node, or nullptr when the node became empty.
+hamt_node* hamt_dissoc(hamt_node* node,
+                       unsigned shift,
+                       std::uint64_t hash,
+                       const map_key& key,
+                       std::uint64_t edit,
+                       bool& removed) {
+    if (node->collision) {
+        for (std::size_t i = 0; i < node->slots.size(); ++i) {
+            if (node->slots[i].key == key) {
+                removed = true;
+                if (node->slots.size() == 1) {
+                    return nullptr;
+                }
+                hamt_node* out = editable(node, edit);
+                out->slots.erase(out->slots.begin() + static_cast<std::ptrdiff_t>(i));
+                return out;
+            }
+        }
+        return node;
+    }
+
+    const std::uint32_t bit = hash_bit(hash, shift);
+    if ((node->bitmap & bit) == 0) {
+        return node;
+    }
+    const std::size_t index = slot_index(node->bitmap, bit);
+    const hamt_node::slot& existing = node->slots[index];
+    if (existing.child) {
+        hamt_node* child = hamt_dissoc(existing.child, shift + kBits, hash, key, edit, removed);
+        if (child == existing.child) {
+            return node;
+        }
+        if (child) {
+            hamt_node* out = editable(node, edit);
+            set_child(out, index, child);
+            return out;
+        }
+    } else if (!(existing.key == key)) {
+        return node;
+    } else {
+        removed = true;
+    }
+
+    if (node->slots.size() == 1) {
+        return nullptr;
+    }
+    hamt_node* out = editable(node, edit);
+    out->slots.erase(out->slots.begin() + static_cast<std::ptrdiff_t>(index));
+    out->bitmap &= ~bit;
+    return out;
+}
+
+const value* hamt_find(const hamt_node* node, std::uint64_t hash, const map_key& key) {
+    unsigned shift = 0;
+    while (node) {
+        if (node->collision) {
+            for (const hamt_node::slot& entry : node->slots) {
+                if (entry.key == key) {
+                    return &entry.mapped;
+                }
+            }
+            return nullptr;
+        }
+        const std::uint32_t bit = hash_bit(hash, shift);
+        if ((node->bitmap & bit) == 0) {
+            return nullptr;
+        }
+        const hamt_node::slot& entry = node->slots[slot_index(node->bitmap, bit)];
+        if (!entry.child) {
+            return entry.key == key ? &entry.mapped : nullptr;
+        }
+        node = entry.child;
+        shift += kBits;
+    }
+    return nullptr;
+}
+
+void hamt_for_each(const hamt_node* node, const std::function<void(const map_key&, value)>& fn) {
+    if (!node) {
+        return;
+    }
+    for (const hamt_node::slot& entry : node->slots) {
+        if (entry.child) {
+            hamt_for_each(entry.child, fn);
+        } else {
+            fn(entry.key, entry.mapped);
+        }
+    }
+}
+
+value require_pmap(value v, const char* where) {
+    if (!is_pmap(v)) {
+        throw lisp_error(std::string(where) + ": expected pmap");
+    }
+    return v;
+}
+
+value require_pvec(value v, const char* where) {
+    if (!is_pvec(v)) {
+        throw lisp_error(std::string(where) + ": expected pvec");
+    }
+    return v;
+}
+
+template <typename Payload>
+std::uint64_t require_live_edit(const Payload& data, const char* where) {
+    if (!data.transient) {
+        throw lisp_error(std::string(where) + ": expected transient");
+    }
+    if (data.edit == 0) {
+        throw lisp_error(std::string(where) + ": transient used after persistent!");
+    }
+    return data.edit;
+}
+
+value make_pmap_from(hamt_node* root, std::size_t count) {
+    value out = make_pmap();
+    out->pmap_data().root = root;
+    out->pmap_data().count = count;
+    return out;
+}
+
+// ---- pvec -------------------------------------------------------------------------------------------
+
+pvec_node* new_pvec_node(std::uint64_t edit) {
+    pvec_node* node = default_gc().allocate<pvec_node>();
+    node->edit = edit;
+    return node;
+}
+
+pvec_node* editable(pvec_node* node, std::uint64_t edit) {
+    if (edit != 0 && node->edit == edit) {
+        return node;
+    }
+    pvec_node* copy = new_pvec_node(edit);
+    copy->items = node->items;
+    copy->children = node->children;
+    return copy;
+}
+
+std::size_t tail_offset(std::size_t count) {
+    return count < kWidth ? 0 : ((count - 1) >> kBits) << kBits;
+}
+
+const std::vector<value>& leaf_for(const pvec_payload& data, std::size_t index) {
+    if (index >= tail_offset(data.count)) {
+        return data.tail;
+    }
+    const pvec_node* node = data.root;
+    for (unsigned level = data.shift; level > 0; level -= kBits) {
+        node = node->children[(index >> level) & kMask];
+    }
+    return node->items;
+}
+
+pvec_node* pvec_do_assoc(unsigned level, pvec_node* node, std::size_t index, value item, std::uint64_t edit) {
+    pvec_node* out = editable(node, edit);
+    if (level == 0) {
+        out->items[index & kMask] = item;
+        default_gc().write_barrier(out, item);
+        return out;
+    }
+    const std::size_t sub = (index >> level) & kMask;
+    pvec_node* child = pvec_do_assoc(level - kBits, node->children[sub], index, item, edit);
+    out->children[sub] = child;
+    default_gc().write_barrier(out, child);
+    return out;
+}
+
+pvec_node* new_path(unsigned level, pvec_node* node, std::uint64_t edit) {
+    if (level == 0) {
+        return node;
+    }
+    pvec_node* out = new_pvec_node(edit);
+    out->children.push_back(new_path(level - kBits, node, edit));
+    return out;
+}
+
+// `count` is the element count before the tail is pushed.
+pvec_node* push_tail(std::size_t count, unsigned level, pvec_node* parent, pvec_node* tail_node, std::uint64_t edit) {
+    pvec_node* out = editable(parent, edit);
+    const std::size_t sub = ((count - 1) >> level) & kMask;
+    pvec_node* child = nullptr;
+    if (level == kBits) {
+        child = tail_node;
+    } else if (sub < parent->children.size()) {
+        child = push_tail(count, level - kBits, parent->children[sub], tail_node, edit);
+    } else {
+        child = new_path(level - kBits, tail_node, edit);
+    }
+    if (sub < out->children.size()) {
+        out->children[sub] = child;
+    } else {
+        out->children.push_back(child);
+    }
+    default_gc().write_barrier(out, child);
+    return out;
+}
+
+// Returns nullptr when the subtree becomes empty. `count` is the element count before the pop.
+pvec_node* pop_tail(std::size_t count, unsigned level, pvec_node* node, std::uint64_t edit) {
+    const std::size_t sub = ((count - 2) >> level) & kMask;
+    if (level > kBits) {
+        pvec_node* child = pop_tail(count, level - kBits, node->children[sub], edit);
+        if (!child && sub == 0) {
+            return nullptr;
+        }
+        pvec_node* out = editable(node, edit);
+        if (child) {
+            out->children[sub] = child;
+            default_gc().write_barrier(out, child);
+        } else {
+            out->children.pop_back();
+        }
+        return out;
+    }
+    if (sub == 0) {
+        return nullptr;
+    }
+    pvec_node* out = editable(node, edit);
+    out->children.pop_back();
+    return out;
+}
+
+void pvec_conj_into(pvec_payload& data, gc_node* owner, value item, std::uint64_t edit) {
+    if (data.count - tail_offset(data.count) < kWidth) {
+        data.tail.push_back(item);
+        default_gc().write_barrier(owner, item);
+        ++data.count;
+        return;
+    }
+
+    pvec_node* tail_node = new_pvec_node(edit);
+    tail_node->items = std::move(data.tail);
+    pvec_node* root = nullptr;
+    if ((data.count >> kBits) > (std::size_t{1} << data.shift)) {
+        root = new_pvec_node(edit);
+        root->children.push_back(data.root);
+        root->children.push_back(new_path(data.shift, tail_node, edit));
+        data.shift += kBits;
+    } else {
+        root = push_tail(data.count, data.shift, data.root, tail_node, edit);
+    }
+    data.root = root;
+    default_gc().write_barrier(owner, root);
+    data.tail.clear();
+    data.tail.reserve(kWidth);
+    data.tail.push_back(item);
+    default_gc().write_barrier(owner, item);
+    ++data.count;
+}
+
+void pvec_pop_from(pvec_payload& data, std::uint64_t edit, const char* where) {
+    if (data.count == 0) {
+        throw lisp_error(std::string(where) + ": vector is empty");
+    }
+    if (data.count == 1) {
+        data.root = new_pvec_node(edit);
+        data.tail.clear();
+        data.count = 0;
+        data.shift = kBits;
+        return;
+    }
+    if (data.count - tail_offset(data.count) > 1) {
+        data.tail.pop_back();
+        --data.count;
+        return;
+    }
+
+    std::vector<value> new_tail = leaf_for(data, data.count - 2);
+    pvec_node* root = pop_tail(data.count, data.shift, data.root, edit);
+    if (!root) {
+        root = new_pvec_node(edit);
+    }
+    if (data.shift > kBits && root->children.size() == 1) {
+        root = root->children.front();
+        data.shift -= kBits;
+    }
+    data.root = root;
+    data.tail = std::move(new_tail);
+    --data.count;
+}
+
+value copy_pvec(const pvec_payload& data) {
+    value out = make_pvec();
+    pvec_payload& copy = out->pvec_data();
+    copy.root = data.root;
+    copy.tail = data.tail;
+    copy.count = data.count;
+    copy.shift = data.shift;
+    return out;
+}
+
+}  // namespace
+
+void hamt_node::gc_mark_children(gc& heap) {
+    for (const slot& entry : slots) {
+        if (entry.child) {
+            heap.mark_node(entry.child);
+        } else {
+            heap.mark_value(entry.mapped);
+        }
+    }
+}
+
+std::size_t hamt_node::gc_size_bytes() const {
+    return sizeof(hamt_node) + slots.capacity() * sizeof(slot);
+}
+
+void pvec_node::gc_mark_children(gc& heap) {
+    for (value item : items) {
+        heap.mark_value(item);
+    }
+    for (pvec_node* child : children) {
+        heap.mark_node(child);
+    }
+}
+
+std::size_t pvec_node::gc_size_bytes() const {
+    return sizeof(pvec_node) + items.capacity() * sizeof(value) + children.capacity() * sizeof(pvec_node*);
+}
+
+value make_pmap() {
+    return default_gc().allocate<object>(value_type::pmap);
+}
+
+std::size_t pmap_count(value pmap) {
+    return require_pmap(pmap, "pmap_count")->pmap_data().count;
+}
+
+const value* pmap_find(value pmap, const map_key& key) {
+    return hamt_find(require_pmap(pmap, "pmap_find")->pmap_data().root, key_hash(key), key);
+}
+
+value pmap_assoc(value pmap, const map_key& key, value mapped) {
+    const pmap_payload& data = require_pmap(pmap, "pmap_assoc")->pmap_data();
+    bool added = false;
+    hamt_node* root = hamt_assoc(data.root, 0, key_hash(key), key, mapped, 0, added);
+    if (root == data.root && !data.transient) {
+        return pmap;
+    }
+    return make_pmap_from(root, data.count + (added ? 1 : 0));
+}
+
+value pmap_dissoc(value pmap, const map_key& key) {
+    const pmap_payload& data = require_pmap(pmap, "pmap_dissoc")->pmap_data();
+    if (!data.root) {
+        return data.transient ? make_pmap() : pmap;
+    }
+    bool removed = false;
+    hamt_node* root = hamt_dissoc(data.root, 0, key_hash(key), key, 0, removed);
+    if (!removed && !data.transient) {
+        return pmap;
+    }
+    return make_pmap_from(root, data.count - (removed ? 1 : 0));
+}
+
+void pmap_for_each(value pmap, const std::function<void(const map_key&, value)>& fn) {
+    hamt_for_each(require_pmap(pmap, "pmap_for_each")->pmap_data().root, fn);
+}
+
+value pmap_transient(value pmap) {
+    const pmap_payload& data = require_pmap(pmap, "pmap_transient")->pmap_data();
+    value out = make_pmap_from(data.root, data.count);
+    out->pmap_data().transient = true;
+    out->pmap_data().edit = next_edit_id();
+    return out;
+}
+
+void pmap_assoc_in_place(value transient, const map_key& key, value mapped) {
+    pmap_payload& data = require_pmap(transient, "pmap_assoc_in_place")->pmap_data();
+    const std::uint64_t edit = require_live_edit(data, "pmap_assoc_in_place");
+    bool added = false;
+    data.root = hamt_assoc(data.root, 0, key_hash(key), key, mapped, edit, added);
+    default_gc().write_barrier(transient, data.root);
+    if (added) {
+        ++data.count;
+    }
+}
+
+bool pmap_dissoc_in_place(value transient, const map_key& key) {
+    pmap_payload& data = require_pmap(transient, "pmap_dissoc_in_place")->pmap_data();
+    const std::uint64_t edit = require_live_edit(data, "pmap_dissoc_in_place");
+    if (!data.root) {
+        return false;
+    }
+    bool removed = false;
+    data.root = hamt_dissoc(data.root, 0, key_hash(key), key, edit, removed);
+    default_gc().write_barrier(transient, data.root);
+    if (removed) {
+        --data.count;
+    }
+    return removed;
+}
+
+value pmap_persistent(value transient) {
+    pmap_payload& data = require_pmap(transient, "pmap_persistent")->pmap_data();
+    (void)require_live_edit(data, "pmap_persistent");
+    data.edit = 0;
+    return make_pmap_from(data.root, data.count);
+}
+
+value make_pvec() {
+    value out = default_gc().allocate<object>(value_type::pvec);
+    out->pvec_data().root = new_pvec_node(0);
+    return out;
+}
+
+std::size_t pvec_count(value pvec) {
+    return require_pvec(pvec, "pvec_count")->pvec_data().count;
+}
+
+value pvec_get(value pvec, std::size_t index) {
+    const pvec_payload& data = require_pvec(pvec, "pvec_get")->pvec_data();
+    if (index >= data.count) {
+        throw lisp_error("pvec_get: index out of range");
+    }
+    return leaf_for(data, index)[index & kMask];
+}
+
+value pvec_assoc(value pvec, std::size_t index, value item) {
+    const pvec_payload& data = require_pvec(pvec, "pvec_assoc")->pvec_data();
+    if (index >= data.count) {
+        throw lisp_error("pvec_assoc: index out of range");
+    }
+    value out = copy_pvec(data);
+    pvec_payload& copy = out->pvec_data();
+    if (index >= tail_offset(copy.count)) {
+        copy.tail[index & kMask] = item;
+    } else {
+        copy.root = pvec_do_assoc(copy.shift, copy.root, index, item, 0);
+    }
+    return out;
+}
+
+value pvec_conj(value pvec, value item) {
+    value out = copy_pvec(require_pvec(pvec, "pvec_conj")->pvec_data());
+    pvec_conj_into(out->pvec_data(), out, item, 0);
+    return out;
+}
+
+value pvec_pop(value pvec) {
+    value out = copy_pvec(require_pvec(pvec, "pvec_pop")->pvec_data());
+    pvec_pop_from(out->pvec_data(), 0, "pvec_pop");
+    return out;
+}
+
+value pvec_transient(value pvec) {
+    value out = copy_pvec(require_pvec(pvec, "pvec_transient")->pvec_data());
+    out->pvec_data().transient = true;
+    out->pvec_data().edit = next_edit_id();
+    return out;
+}
+
+void pvec_assoc_in_place(value transient, std::size_t index, value item) {
+    pvec_payload& data = require_pvec(transient, "pvec_assoc_in_place")->pvec_data();
+    const std::uint64_t edit = require_live_edit(data, "pvec_assoc_in_place");
+    if (index >= data.count) {
+        throw lisp_error("pvec_assoc_in_place: index out of range");
+    }
+    if (index >= tail_offset(data.count)) {
+        data.tail[index & kMask] = item;
+        default_gc().write_barrier(transient, item);
+        return;
+    }
+    data.root = pvec_do_assoc(data.shift, data.root, index, item, edit);
+    default_gc().write_barrier(transient, data.root);
+}
+
+void pvec_conj_in_place(value transient, value item) {
+    pvec_payload& data = require_pvec(transient, "pvec_conj_in_place")->pvec_data();
+    pvec_conj_into(data, transient, item, require_live_edit(data, "pvec_conj_in_place"));
+}
+
+void pvec_pop_in_place(value transient) {
+    pvec_payload& data = require_pvec(transient, "pvec_pop_in_place")->pvec_data();
+    pvec_pop_from(data, require_live_edit(data, "pvec_pop_in_place"), "pvec_pop_in_place");
+    default_gc().write_barrier(transient, data.root);
+}
+
+value pvec_persistent(value transient) {
+    pvec_payload& data = require_pvec(transient, "pvec_persistent")->pvec_data();
+    (void)require_live_edit(data, "pvec_persistent");
+    data.edit = 0;
+    return copy_pvec(data);
+}
+
+bool is_live_transient(value v) {
+    if (is_pmap(v)) {
+        return v->pmap_data().transient && v->pmap_data().edit != 0;
+    }
+    if (is_pvec(v)) {
+        return v->pvec_data().transient && v->pvec_data().edit != 0;
+    }
+    return false;
+}
+
+}  // namespace muslisp
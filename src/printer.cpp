@@ -1,183 +1,288 @@
 #include "muslisp/printer.hpp"
 
+#include <charconv>
 #include <cmath>
-#include <iomanip>
-#include <ios>
-#include <sstream>
+#include <ostream>
 #include <string_view>
 
 #include "muslisp/error.hpp"
+#include "muslisp/persistent.hpp"
 
 namespace muslisp {
 namespace {
 
-std::string escape_string(const std::string& input) {
-    std::string out;
-    out.reserve(input.size());
-    for (char c : input) {
-        switch (c) {
+// Everything is appended to one buffer. With a stream attached the buffer is flushed whenever it
+// passes k_flush_bytes, so streaming a large structure needs only a bounded amount of memory.
+class print_buffer {
+public:
+    static constexpr std::size_t k_flush_bytes = 64 * 1024;
+
+    explicit print_buffer(std::string& text, std::ostream* stream = nullptr) : text_(text), stream_(stream) {}
+
+    void put(char c) { text_.push_back(c); }
+    void put(std::string_view s) { text_.append(s); }
+
+    void maybe_flush() {
+        if (stream_ && text_.size() >= k_flush_bytes) {
+            flush();
+        }
+    }
+
+    void flush() {
+        if (stream_) {
+            stream_->write(text_.data(), static_cast<std::streamsize>(text_.size()));
+            text_.clear();
+        }
+    }
+
+private:
+    std::string& text_;
+    std::ostream* stream_;
+};
+
+// Rough output size, used to reserve the string once. Atoms whose printed length needs formatting
+// (numbers) are counted at a typical width; walking the structure is all this costs.
+std::size_t estimate_size(value v) {
+    std::size_t total = 0;
+    value cursor = v;
+    while (is_cons(cursor)) {
+        total += 1 + estimate_size(car(cursor));
+        cursor = cdr(cursor);
+    }
+    if (is_nil(cursor)) {
+        return total + (is_cons(v) ? 2 : 3);
+    }
+    if (is_symbol(cursor)) {
+        return total + symbol_name(cursor).size();
+    }
+    if (is_string(cursor)) {
+        return total + string_value(cursor).size() + 2;
+    }
+    return total + 8;
+}
+
+void append_escaped(print_buffer& out, const std::string& input) {
+    std::size_t run = 0;
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        std::string_view escape;
+        switch (input[i]) {
             case '\\':
-                out += "\\\\";
+                escape = "\\\\";
                 break;
             case '"':
-                out += "\\\"";
+                escape = "\\\"";
                 break;
             case '\n':
-                out += "\\n";
+                escape = "\\n";
                 break;
             case '\t':
-                out += "\\t";
+                escape = "\\t";
                 break;
             case '\r':
-                out += "\\r";
+                escape = "\\r";
                 break;
             default:
-                out.push_back(c);
-                break;
+                continue;
         }
+        out.put(std::string_view(input).substr(run, i - run));
+        out.put(escape);
+        run = i + 1;
     }
-    return out;
+    out.put(std::string_view(input).substr(run));
+}
+
+void append_integer(print_buffer& out, std::int64_t v) {
+    char buffer[24];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), v);
+    out.put(std::string_view(buffer, static_cast<std::size_t>(result.ptr - buffer)));
 }
 
-std::string format_float(double v) {
+void append_float(print_buffer& out, double v) {
     if (std::isnan(v)) {
-        return "nan";
+        out.put("nan");
+        return;
     }
     if (std::isinf(v)) {
-        return v < 0.0 ? "-inf" : "inf";
+        out.put(v < 0.0 ? "-inf" : "inf");
+        return;
     }
 
-    std::ostringstream out;
-    out.setf(std::ios::fmtflags(0), std::ios::floatfield);
-    out << std::setprecision(15) << v;
-    std::string text = out.str();
+    // Same digits as printf("%.15g"), without a stringstream per number.
+    char buffer[32];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), v, std::chars_format::general, 15);
+    const std::string_view text(buffer, static_cast<std::size_t>(result.ptr - buffer));
+    out.put(text);
+    if (text.find_first_of(".eE") == std::string_view::npos) {
+        out.put(".0");
+    }
+}
 
-    if (text.find('.') == std::string::npos && text.find('e') == std::string::npos &&
-        text.find('E') == std::string::npos) {
-        text += ".0";
+std::string write_error_message(value_type t) {
+    return "write: cannot serialise " + std::string(type_name(t)) + " as readable data";
+}
+
+void append_opaque(print_buffer& out, value_type type, bool readable, std::string_view tag) {
+    if (readable) {
+        throw lisp_error(write_error_message(type));
     }
-    return text;
+    out.put(tag);
 }
 
-std::string print_impl(value v, bool readable);
+void append_counted(print_buffer& out, value_type type, bool readable, std::string_view tag, std::size_t count) {
+    append_opaque(out, type, readable, tag);
+    append_integer(out, static_cast<std::int64_t>(count));
+    out.put('>');
+}
+
+void append_value(print_buffer& out, value v, bool readable);
 
-void append_list(std::ostringstream& out, value list_value, bool readable) {
-    out << "(";
+// Walks the spine iteratively, so only nesting through car recurses.
+void append_list(print_buffer& out, value list_value, bool readable) {
+    out.put('(');
     value cursor = list_value;
     bool first = true;
 
     while (is_cons(cursor)) {
         if (!first) {
-            out << " ";
+            out.put(' ');
         }
-        out << print_impl(car(cursor), readable);
+        append_value(out, car(cursor), readable);
+        out.maybe_flush();
         cursor = cdr(cursor);
         first = false;
     }
 
     if (!is_nil(cursor)) {
         if (!first) {
-            out << " ";
+            out.put(' ');
         }
-        out << ". " << print_impl(cursor, readable);
+        out.put(". ");
+        append_value(out, cursor, readable);
     }
 
-    out << ")";
+    out.put(')');
 }
 
-std::string write_error_message(value_type t) {
-    return "write: cannot serialise " + std::string(type_name(t)) + " as readable data";
-}
-
-std::string print_impl(value v, bool readable) {
+void append_value(print_buffer& out, value v, bool readable) {
     if (!v) {
         throw lisp_error("print_value: null value");
     }
 
     switch (type_of(v)) {
         case value_type::nil:
-            return "nil";
+            out.put("nil");
+            return;
         case value_type::boolean:
-            return boolean_value(v) ? "#t" : "#f";
+            out.put(boolean_value(v) ? "#t" : "#f");
+            return;
         case value_type::integer:
-            return std::to_string(integer_value(v));
+            append_integer(out, integer_value(v));
+            return;
         case value_type::floating:
             if (readable && !std::isfinite(float_value(v))) {
                 throw lisp_error("write: non-finite floats are not readable");
             }
-            return format_float(float_value(v));
+            append_float(out, float_value(v));
+            return;
         case value_type::symbol:
-            return symbol_name(v);
+            out.put(symbol_name(v));
+            return;
         case value_type::string:
-            return "\"" + escape_string(string_value(v)) + "\"";
-        case value_type::cons: {
-            std::ostringstream out;
+            out.put('"');
+            append_escaped(out, string_value(v));
+            out.put('"');
+            return;
+        case value_type::cons:
             append_list(out, v, readable);
-            return out.str();
-        }
+            return;
         case value_type::primitive_fn:
-            if (readable) {
-                throw lisp_error(write_error_message(value_type::primitive_fn));
-            }
-            return "<primitive:" + primitive_name(v) + ">";
+            append_opaque(out, value_type::primitive_fn, readable, "<primitive:");
+            out.put(primitive_name(v));
+            out.put('>');
+            return;
         case value_type::closure:
-            if (readable) {
-                throw lisp_error(write_error_message(value_type::closure));
-            }
-            return "<closure>";
+            append_opaque(out, value_type::closure, readable, "<closure>");
+            return;
         case value_type::vec:
-            if (readable) {
-                throw lisp_error(write_error_message(value_type::vec));
-            }
-            return "<vec:" + std::to_string(v->vec_data.size()) + ">";
+            append_counted(out, value_type::vec, readable, "<vec:", v->vec_data().size());
+            return;
         case value_type::map:
-            if (readable) {
-                throw lisp_error(write_error_message(value_type::map));
-            }
-            return "<map:" + std::to_string(v->map_data.size()) + ">";
+            append_counted(out, value_type::map, readable, "<map:", v->map_data().size());
+            return;
         case value_type::pq:
-            if (readable) {
-                throw lisp_error(write_error_message(value_type::pq));
-            }
-            return "<pq:" + std::to_string(v->pq_data.size()) + ">";
+            append_counted(out, value_type::pq, readable, "<pq:", v->pq_data().size());
+            return;
         case value_type::rng:
-            if (readable) {
-                throw lisp_error(write_error_message(value_type::rng));
-            }
-            return "<rng>";
+            append_opaque(out, value_type::rng, readable, "<rng>");
+            return;
         case value_type::bt_def:
-            if (readable) {
-                throw lisp_error(write_error_message(value_type::bt_def));
-            }
-            return "<bt_def:" + std::to_string(bt_handle(v)) + ">";
+            append_opaque(out, value_type::bt_def, readable, "<bt_def:");
+            append_integer(out, bt_handle(v));
+            out.put('>');
+            return;
         case value_type::bt_instance:
-            if (readable) {
-                throw lisp_error(write_error_message(value_type::bt_instance));
-            }
-            return "<bt_instance:" + std::to_string(bt_handle(v)) + ">";
+            append_opaque(out, value_type::bt_instance, readable, "<bt_instance:");
+            append_integer(out, bt_handle(v));
+            out.put('>');
+            return;
         case value_type::image_handle:
-            if (readable) {
-                throw lisp_error(write_error_message(value_type::image_handle));
-            }
-            return "<image_handle:" + std::to_string(image_handle_id(v)) + ">";
+            append_opaque(out, value_type::image_handle, readable, "<image_handle:");
+            append_integer(out, image_handle_id(v));
+            out.put('>');
+            return;
         case value_type::blob_handle:
-            if (readable) {
-                throw lisp_error(write_error_message(value_type::blob_handle));
-            }
-            return "<blob_handle:" + std::to_string(blob_handle_id(v)) + ">";
+            append_opaque(out, value_type::blob_handle, readable, "<blob_handle:");
+            append_integer(out, blob_handle_id(v));
+            out.put('>');
+            return;
+        case value_type::pmap:
+            append_counted(out, value_type::pmap, readable, "<pmap:", pmap_count(v));
+            return;
+        case value_type::pvec:
+            append_counted(out, value_type::pvec, readable, "<pvec:", pvec_count(v));
+            return;
+        case value_type::f64vec:
+            append_counted(out, value_type::f64vec, readable, "<f64vec:", v->f64vec_data().size());
+            return;
     }
 
-    return "<unknown>";
+    out.put("<unknown>");
+}
+
+std::string print_to_string(value v, bool readable) {
+    std::string text;
+    if (is_cons(v)) {
+        text.reserve(estimate_size(v));
+    }
+    print_buffer out(text);
+    append_value(out, v, readable);
+    return text;
+}
+
+void print_to_stream(std::ostream& stream, value v, bool readable) {
+    std::string text;
+    text.reserve(print_buffer::k_flush_bytes + 256);
+    print_buffer out(text, &stream);
+    append_value(out, v, readable);
+    out.flush();
 }
 
 }  // namespace
 
 std::string print_value(value v) {
-    return print_impl(v, false);
+    return print_to_string(v, false);
 }
 
 std::string write_value(value v) {
-    return print_impl(v, true);
+    return print_to_string(v, true);
+}
+
+void print_value(std::ostream& out, value v) {
+    print_to_stream(out, v, false);
+}
+
+void write_value(std::ostream& out, value v) {
+    print_to_stream(out, v, true);
 }
 
 }  // namespace muslisp
@@ -1,17 +1,24 @@
 #include "muslisp/reader.hpp"
 
+#include <array>
 #include <cstddef>
 #include <charconv>
-#include <cctype>
-#include <cerrno>
 #include <cstdlib>
 #include <string>
 
 #include "muslisp/error.hpp"
+#include "muslisp/gc.hpp"
 
 namespace muslisp {
 namespace {
 
+// Matches std::isspace in the C locale without the locale lookup.
+[[nodiscard]] constexpr bool is_space(char c) noexcept {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Tokens are slices of `source_`: symbols are interned straight from the slice, strings without escapes
+// are copied once into their string object, and lists are built cell by cell without a staging vector.
 class parser {
 public:
     explicit parser(std::string_view source) : source_(source) {}
@@ -63,7 +70,7 @@ private:
     void skip_ws_and_comments() {
         while (!eof()) {
             const char c = peek();
-            if (std::isspace(static_cast<unsigned char>(c))) {
+            if (is_space(c)) {
                 ++pos_;
                 continue;
             }
@@ -91,12 +98,10 @@ private:
             throw parse_error_here("unexpected ')'", false);
         }
         if (c == '\'') {
-            value quoted = read_expr();
-            return list_from_vector({make_symbol("quote"), quoted});
+            return wrap("quote", read_expr());
         }
         if (c == '`') {
-            value qq = read_expr();
-            return list_from_vector({make_symbol("quasiquote"), qq});
+            return wrap("quasiquote", read_expr());
         }
         if (c == ',') {
             if (eof()) {
@@ -104,11 +109,9 @@ private:
             }
             if (peek() == '@') {
                 ++pos_;
-                value splice = read_expr();
-                return list_from_vector({make_symbol("unquote-splicing"), splice});
+                return wrap("unquote-splicing", read_expr());
             }
-            value unquoted = read_expr();
-            return list_from_vector({make_symbol("unquote"), unquoted});
+            return wrap("unquote", read_expr());
         }
         if (c == '"') {
             return read_string();
@@ -116,8 +119,13 @@ private:
         return read_atom(c);
     }
 
+    [[nodiscard]] static value wrap(std::string_view head, value form) {
+        return make_cons(make_symbol(head), make_cons(form, make_nil()));
+    }
+
     [[nodiscard]] value read_list() {
-        std::vector<value> items;
+        value head = make_nil();
+        value tail = nullptr;
         while (true) {
             skip_ws_and_comments();
             if (eof()) {
@@ -125,14 +133,29 @@ private:
             }
             if (peek() == ')') {
                 ++pos_;
-                return list_from_vector(items);
+                return head;
+            }
+            value cell = make_cons(read_expr(), make_nil());
+            if (tail) {
+                tail->cdr_data = cell;
+                default_gc().write_barrier(tail, cell);
+            } else {
+                head = cell;
             }
-            items.push_back(read_expr());
+            tail = cell;
         }
     }
 
     [[nodiscard]] value read_string() {
-        std::string out;
+        const std::size_t start = pos_;
+        while (!eof() && peek() != '"' && peek() != '\\') {
+            ++pos_;
+        }
+        if (!eof() && peek() == '"') {
+            return make_string(source_.substr(start, pos_++ - start));
+        }
+
+        std::string out(source_.substr(start, pos_ - start));
         while (true) {
             if (eof()) {
                 throw parse_error_here("unterminated string", true);
@@ -173,14 +196,15 @@ private:
     }
 
     [[nodiscard]] static bool delimiter(char c) {
-        return std::isspace(static_cast<unsigned char>(c)) || c == '(' || c == ')' || c == ';';
+        return is_space(c) || c == '(' || c == ')' || c == ';';
     }
 
-    [[nodiscard]] value read_atom(char first_char) {
-        std::string token(1, first_char);
+    [[nodiscard]] value read_atom(char) {
+        const std::size_t start = pos_ - 1;
         while (!eof() && !delimiter(peek())) {
-            token.push_back(get());
+            ++pos_;
         }
+        const std::string_view token = source_.substr(start, pos_ - start);
 
         if (token == "#t") {
             return make_boolean(true);
@@ -192,8 +216,7 @@ private:
             return make_nil();
         }
 
-        const bool maybe_float = token.find('.') != std::string::npos || token.find('e') != std::string::npos ||
-                                 token.find('E') != std::string::npos;
+        const bool maybe_float = token.find_first_of(".eE") != std::string_view::npos;
 
         if (!maybe_float) {
             std::int64_t integer = 0;
@@ -206,13 +229,20 @@ private:
         }
 
         if (maybe_float) {
-            errno = 0;
-            char* parse_end = nullptr;
-            const double parsed = std::strtod(token.c_str(), &parse_end);
-            if (parse_end == token.c_str() + token.size() && errno != ERANGE) {
-                return make_float(parsed);
+            // strtod needs a terminated buffer; numeric tokens are short, so keep the copy on the stack.
+            std::array<char, 64> small{};
+            std::string large;
+            const char* text = nullptr;
+            if (token.size() < small.size()) {
+                token.copy(small.data(), token.size());
+                text = small.data();
+            } else {
+                large.assign(token);
+                text = large.c_str();
             }
-            if (parse_end == token.c_str() + token.size() && errno == ERANGE) {
+            char* parse_end = nullptr;
+            const double parsed = std::strtod(text, &parse_end);
+            if (parse_end == text + token.size()) {
                 return make_float(parsed);
             }
         }
@@ -0,0 +1,55 @@
+#include "muslisp/runtime_context.hpp"
+
+#include <utility>
+
+#include "muslisp/eval.hpp"
+
+namespace muslisp {
+namespace {
+
+thread_local runtime_context* t_context = nullptr;
+
+}  // namespace
+
+runtime_context::runtime_context() : runtime_context(runtime_config{}) {}
+
+runtime_context::runtime_context(runtime_config config, bt::runtime_host_options host_options) {
+    // The shared singletons must exist before the first context allocates anything of its own.
+    (void)make_nil();
+    (void)make_boolean(true);
+    runtime_context_scope bind(*this);
+    host_ = std::make_unique<bt::runtime_host>(std::move(host_options));
+    bt::report_heap_events(*host_, heap_);
+    global_ = create_global_env(std::move(config));
+}
+
+runtime_context::~runtime_context() {
+    runtime_context_scope bind(*this);
+    if (global_) {
+        heap_.unregister_root_env(global_);
+    }
+    host_.reset();
+    locals_.clear();
+    heap_.clear_lifecycle_listener();
+    heap_.clear_limit_listener();
+}
+
+value runtime_context::eval_source(std::string_view source) {
+    runtime_context_scope bind(*this);
+    return muslisp::eval_source(source, global_);
+}
+
+runtime_context* current_runtime_context() noexcept {
+    return t_context;
+}
+
+runtime_context_scope::runtime_context_scope(runtime_context& context) noexcept
+    : previous_(t_context), heap_scope_(context.heap()) {
+    t_context = &context;
+}
+
+runtime_context_scope::~runtime_context_scope() {
+    t_context = previous_;
+}
+
+}  // namespace muslisp
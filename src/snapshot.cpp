@@ -0,0 +1,836 @@
+#include "muslisp/snapshot.hpp"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "bt/runtime_host.hpp"
+#include "bt/serialisation.hpp"
+#include "compiled_eval.hpp"
+#include "muslisp/error.hpp"
+#include "muslisp/persistent.hpp"
+#include "muslisp/value.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MUESLI_SNAPSHOT_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define MUESLI_SNAPSHOT_HAVE_MMAP 0
+#endif
+
+namespace muslisp {
+namespace {
+
+// Layout (little-endian): magic, version, object count, env count, then one record per object and one
+// per env. A value reference is a u64: 0 for none, the raw bits of an immediate (whose low two bits
+// are never zero), or (object index + 1) << 2. An env reference is a u32: 0 for none, else index + 1.
+// Env 0 is the saved global env.
+constexpr std::array<char, 4> k_magic{'M', 'L', 'S', '1'};
+constexpr std::uint32_t k_format_version = 2;
+
+std::uint8_t type_tag(value_type type) {
+    return static_cast<std::uint8_t>(type);
+}
+
+class snapshot_encoder {
+public:
+    snapshot_encoder(env_ptr global, snapshot_stats& stats) : stats_(stats) { (void)env_ref(global); }
+
+    std::vector<std::byte> encode() {
+        std::size_t next_object = 0;
+        std::size_t next_env = 0;
+        while (next_object < objects_.size() || next_env < envs_.size()) {
+            while (next_object < objects_.size()) {
+                encode_object(objects_[next_object++]);
+            }
+            if (next_env < envs_.size()) {
+                encode_env(envs_[next_env], next_env == 0);
+                ++next_env;
+            }
+        }
+        stats_.objects = objects_.size();
+        stats_.envs = envs_.size();
+
+        std::vector<std::byte> out;
+        out.reserve(16u + object_records_.size() + env_records_.size());
+        append(out, k_magic.data(), k_magic.size());
+        put_u32(out, k_format_version);
+        put_u32(out, checked_count(objects_.size()));
+        put_u32(out, checked_count(envs_.size()));
+        append(out, object_records_.data(), object_records_.size());
+        append(out, env_records_.data(), env_records_.size());
+        return out;
+    }
+
+private:
+    static void append(std::vector<std::byte>& out, const void* data, std::size_t size) {
+        const auto* bytes = static_cast<const std::byte*>(data);
+        out.insert(out.end(), bytes, bytes + size);
+    }
+
+    static void put_u8(std::vector<std::byte>& out, std::uint8_t v) { out.push_back(static_cast<std::byte>(v)); }
+
+    static void put_u32(std::vector<std::byte>& out, std::uint32_t v) {
+        for (int shift = 0; shift < 32; shift += 8) {
+            put_u8(out, static_cast<std::uint8_t>(v >> shift));
+        }
+    }
+
+    static void put_u64(std::vector<std::byte>& out, std::uint64_t v) {
+        for (int shift = 0; shift < 64; shift += 8) {
+            put_u8(out, static_cast<std::uint8_t>(v >> shift));
+        }
+    }
+
+    static void put_f64(std::vector<std::byte>& out, double v) { put_u64(out, std::bit_cast<std::uint64_t>(v)); }
+
+    static void put_string(std::vector<std::byte>& out, std::string_view text) {
+        put_u32(out, checked_count(text.size()));
+        append(out, text.data(), text.size());
+    }
+
+    static std::uint32_t checked_count(std::size_t count) {
+        if (count > 0xffffffffu) {
+            throw lisp_error("snapshot.save: too many items to serialise");
+        }
+        return static_cast<std::uint32_t>(count);
+    }
+
+    std::uint64_t ref(value v) {
+        if (!v) {
+            return 0;
+        }
+        if (is_immediate(v)) {
+            return value_bits(v);
+        }
+        const auto [found, inserted] = object_index_.try_emplace(v, objects_.size());
+        if (inserted) {
+            require_saveable(v);
+            objects_.push_back(v);
+        }
+        return (static_cast<std::uint64_t>(found->second) + 1u) << 2u;
+    }
+
+    std::uint32_t env_ref(env_ptr scope) {
+        if (!scope) {
+            return 0;
+        }
+        const auto [found, inserted] = env_index_.try_emplace(scope, envs_.size());
+        if (inserted) {
+            envs_.push_back(scope);
+        }
+        return checked_count(found->second + 1u);
+    }
+
+    static void require_saveable(value v) {
+        switch (v->type) {
+            case value_type::bt_instance:
+            case value_type::image_handle:
+            case value_type::blob_handle:
+                throw lisp_error("snapshot.save: cannot save " + std::string(type_name(v->type)) +
+                                 " values; create them after loading");
+            case value_type::pmap:
+            case value_type::pvec:
+                if (is_live_transient(v)) {
+                    throw lisp_error("snapshot.save: cannot save a live transient; seal it first");
+                }
+                return;
+            default:
+                return;
+        }
+    }
+
+    void put_map_key(const map_key& key) {
+        std::vector<std::byte>& out = object_records_;
+        put_u8(out, static_cast<std::uint8_t>(key.type));
+        switch (key.type) {
+            case map_key_type::symbol:
+            case map_key_type::string:
+                put_string(out, key.text_data);
+                break;
+            case map_key_type::integer:
+                put_u64(out, static_cast<std::uint64_t>(key.integer_data));
+                break;
+            case map_key_type::floating:
+                put_f64(out, key.float_data);
+                break;
+        }
+    }
+
+    void encode_object(value v) {
+        std::vector<std::byte>& out = object_records_;
+        put_u8(out, type_tag(v->type));
+        switch (v->type) {
+            case value_type::nil:
+                break;
+            case value_type::boolean:
+                put_u8(out, v->boolean_data ? 1u : 0u);
+                break;
+            case value_type::integer:
+                put_u64(out, static_cast<std::uint64_t>(v->integer_data));
+                break;
+            case value_type::floating:
+                put_f64(out, v->float_data);
+                break;
+            case value_type::symbol:
+            case value_type::string:
+            case value_type::primitive_fn:
+                put_string(out, v->text_data);
+                break;
+            case value_type::cons: {
+                const std::uint64_t car_ref = ref(v->car_data);
+                const std::uint64_t cdr_ref = ref(v->cdr_data);
+                put_u64(out, car_ref);
+                put_u64(out, cdr_ref);
+                break;
+            }
+            case value_type::closure: {
+                const std::vector<std::string>& params = v->closure_params_data();
+                put_u32(out, checked_count(params.size()));
+                for (const std::string& param : params) {
+                    put_string(out, param);
+                }
+                const std::vector<value>& body = v->closure_body_data();
+                put_u32(out, checked_count(body.size()));
+                for (value expr : body) {
+                    put_u64(out, ref(expr));
+                }
+                put_u32(out, env_ref(v->closure_env_data()));
+                break;
+            }
+            case value_type::vec:
+                put_u32(out, checked_count(v->vec_data().size()));
+                for (value item : v->vec_data()) {
+                    put_u64(out, ref(item));
+                }
+                break;
+            case value_type::map:
+                put_u32(out, checked_count(v->map_data().size()));
+                for (const auto& [key, mapped] : v->map_data()) {
+                    put_map_key(key);
+                    put_u64(out, ref(mapped));
+                }
+                break;
+            case value_type::pq: {
+                const pq_payload& queue = v->pq_data();
+                put_u64(out, queue.next_sequence);
+                put_u32(out, checked_count(queue.size()));
+                for (const pq_key& key : queue.heap) {
+                    put_f64(out, key.priority);
+                    put_u64(out, key.sequence);
+                    put_u32(out, key.slot);
+                    put_u64(out, ref(queue.slot_payloads[key.slot]));
+                }
+                break;
+            }
+            case value_type::rng: {
+                const rng_state& state = *v->rng_data();
+                put_u64(out, state.state);
+                put_u8(out, state.has_spare_normal ? 1u : 0u);
+                put_f64(out, state.spare_normal);
+                break;
+            }
+            case value_type::bt_def: {
+                const bt::definition* def = bt::default_runtime_host().find_definition(v->integer_data);
+                if (!def) {
+                    throw lisp_error("snapshot.save: unknown BT definition handle " + std::to_string(v->integer_data));
+                }
+                const std::vector<std::byte> image = bt::encode_definition_binary(*def);
+                put_u64(out, image.size());
+                append(out, image.data(), image.size());
+                ++stats_.bt_definitions;
+                break;
+            }
+            case value_type::pmap:
+                put_u32(out, checked_count(pmap_count(v)));
+                pmap_for_each(v, [this](const map_key& key, value mapped) {
+                    put_map_key(key);
+                    put_u64(object_records_, ref(mapped));
+                });
+                break;
+            case value_type::pvec: {
+                const std::size_t count = pvec_count(v);
+                put_u32(out, checked_count(count));
+                for (std::size_t i = 0; i < count; ++i) {
+                    put_u64(out, ref(pvec_get(v, i)));
+                }
+                break;
+            }
+            case value_type::f64vec:
+                put_u32(out, checked_count(v->f64vec_data().size()));
+                for (double item : v->f64vec_data()) {
+                    put_f64(out, item);
+                }
+                break;
+            case value_type::bt_instance:
+            case value_type::image_handle:
+            case value_type::blob_handle:
+                break;
+        }
+    }
+
+    void encode_env(env_ptr scope, bool global) {
+        // Collected first: ref() may append object records, which live in the other buffer.
+        std::vector<std::pair<std::uint64_t, std::uint64_t>> bindings;
+        bindings.reserve(scope->bindings.size());
+        for (const auto& [symbol, bound] : scope->bindings) {
+            if (global && is_primitive(bound) && primitive_name(bound) == symbol_name(symbol)) {
+                continue;
+            }
+            bindings.emplace_back(ref(symbol), ref(bound));
+        }
+        if (global) {
+            stats_.bindings = bindings.size();
+        }
+
+        std::vector<std::byte>& out = env_records_;
+        put_u32(out, global ? 0u : env_ref(scope->parent));
+        put_u32(out, checked_count(bindings.size()));
+        for (const auto& [symbol_ref, value_ref] : bindings) {
+            put_u64(out, symbol_ref);
+            put_u64(out, value_ref);
+        }
+    }
+
+    snapshot_stats& stats_;
+    std::unordered_map<value, std::size_t> object_index_;
+    std::vector<value> objects_;
+    std::unordered_map<env_ptr, std::size_t> env_index_;
+    std::vector<env_ptr> envs_;
+    std::vector<std::byte> object_records_;
+    std::vector<std::byte> env_records_;
+};
+
+class mapped_snapshot_file {
+public:
+    explicit mapped_snapshot_file(const std::string& path) {
+#if MUESLI_SNAPSHOT_HAVE_MMAP
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw lisp_error("snapshot.load: failed to open file: " + path);
+        }
+        struct stat info {};
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            throw lisp_error("snapshot.load: failed to stat file: " + path);
+        }
+        size_ = static_cast<std::size_t>(info.st_size);
+        if (size_ > 0) {
+            void* mapped = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                ::close(fd);
+                throw lisp_error("snapshot.load: failed to map file: " + path);
+            }
+            data_ = static_cast<const std::byte*>(mapped);
+            mapped_ = true;
+        }
+        ::close(fd);
+#else
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in) {
+            throw lisp_error("snapshot.load: failed to open file: " + path);
+        }
+        owned_.resize(static_cast<std::size_t>(in.tellg()));
+        in.seekg(0);
+        in.read(reinterpret_cast<char*>(owned_.data()), static_cast<std::streamsize>(owned_.size()));
+        if (!in) {
+            throw lisp_error("snapshot.load: failed to read file: " + path);
+        }
+        data_ = owned_.data();
+        size_ = owned_.size();
+#endif
+    }
+
+    ~mapped_snapshot_file() {
+#if MUESLI_SNAPSHOT_HAVE_MMAP
+        if (mapped_) {
+            ::munmap(const_cast<std::byte*>(data_), size_);
+        }
+#endif
+    }
+
+    mapped_snapshot_file(const mapped_snapshot_file&) = delete;
+    mapped_snapshot_file& operator=(const mapped_snapshot_file&) = delete;
+
+    [[nodiscard]] std::span<const std::byte> bytes() const noexcept { return {data_, size_}; }
+
+private:
+    const std::byte* data_ = nullptr;
+    std::size_t size_ = 0;
+    bool mapped_ = false;
+    std::vector<std::byte> owned_;
+};
+
+// Bounds-checked cursor over the mapped image.
+class snapshot_reader {
+public:
+    explicit snapshot_reader(std::span<const std::byte> bytes) : bytes_(bytes) {}
+
+    [[nodiscard]] std::size_t position() const noexcept { return pos_; }
+    void seek(std::size_t pos) noexcept { pos_ = pos; }
+
+    std::span<const std::byte> take(std::size_t size) {
+        if (size > bytes_.size() - pos_) {
+            throw lisp_error("snapshot.load: truncated snapshot");
+        }
+        const std::span<const std::byte> out = bytes_.subspan(pos_, size);
+        pos_ += size;
+        return out;
+    }
+
+    std::uint8_t u8() { return static_cast<std::uint8_t>(take(1)[0]); }
+
+    std::uint32_t u32() {
+        const std::span<const std::byte> b = take(4);
+        std::uint32_t v = 0;
+        for (int i = 3; i >= 0; --i) {
+            v = (v << 8u) | static_cast<std::uint8_t>(b[static_cast<std::size_t>(i)]);
+        }
+        return v;
+    }
+
+    std::uint64_t u64() {
+        const std::span<const std::byte> b = take(8);
+        std::uint64_t v = 0;
+        for (int i = 7; i >= 0; --i) {
+            v = (v << 8u) | static_cast<std::uint8_t>(b[static_cast<std::size_t>(i)]);
+        }
+        return v;
+    }
+
+    double f64() { return std::bit_cast<double>(u64()); }
+
+    std::string_view string() {
+        const std::span<const std::byte> b = take(u32());
+        return {reinterpret_cast<const char*>(b.data()), b.size()};
+    }
+
+    // A count of items at least `min_item_bytes` long each, rejected up front if the rest of the image
+    // cannot hold them.
+    std::uint32_t count(std::size_t min_item_bytes) {
+        const std::uint32_t n = u32();
+        if (static_cast<std::uint64_t>(n) * min_item_bytes > bytes_.size() - pos_) {
+            throw lisp_error("snapshot.load: truncated snapshot");
+        }
+        return n;
+    }
+
+private:
+    std::span<const std::byte> bytes_;
+    std::size_t pos_ = 0;
+};
+
+class snapshot_decoder {
+public:
+    snapshot_decoder(std::span<const std::byte> bytes, env_ptr global, snapshot_stats& stats)
+        : in_(bytes), global_(global), stats_(stats) {
+        for (const auto& [symbol, bound] : global->bindings) {
+            if (is_primitive(bound)) {
+                primitives_.try_emplace(primitive_name(bound), bound);
+            }
+        }
+    }
+
+    void decode() {
+        const std::span<const std::byte> magic = in_.take(k_magic.size());
+        if (std::memcmp(magic.data(), k_magic.data(), k_magic.size()) != 0) {
+            throw lisp_error("snapshot.load: invalid header (expected MLS1)");
+        }
+        const std::uint32_t version = in_.u32();
+        if (version != k_format_version) {
+            throw lisp_error("snapshot.load: unsupported format version " + std::to_string(version));
+        }
+        const std::uint32_t object_count = in_.count(1);
+        const std::uint32_t env_count = in_.count(8);
+        if (env_count == 0) {
+            throw lisp_error("snapshot.load: snapshot has no global env");
+        }
+
+        // Pass 1: allocate every object, complete for atoms and as an empty shell for containers, and
+        // every env. Collections only run at eval safe points, so nothing here needs rooting.
+        offsets_.resize(object_count);
+        objects_.assign(object_count, nullptr);
+        for (std::uint32_t i = 0; i < object_count; ++i) {
+            offsets_[i] = in_.position();
+            objects_[i] = allocate_object();
+        }
+        const std::size_t envs_offset = in_.position();
+        envs_.assign(env_count, nullptr);
+        envs_[0] = global_;
+        for (std::uint32_t i = 1; i < env_count; ++i) {
+            envs_[i] = make_env();
+        }
+
+        // Pass 2: resolve references. Persistent collections are built on first reference.
+        for (std::uint32_t i = 0; i < object_count; ++i) {
+            if (objects_[i] == nullptr) {
+                (void)object_at(i);
+            } else {
+                fill_object(i);
+            }
+        }
+        in_.seek(envs_offset);
+        for (std::uint32_t i = 0; i < env_count; ++i) {
+            fill_env(i);
+        }
+        // The compiler walks the body, so it runs once every cons has been filled.
+        for (value closure : closures_) {
+            set_closure_compiled(closure, try_compile_closure(closure->closure_params_data(), closure->closure_body_data()));
+        }
+
+        stats_.objects = object_count;
+        stats_.envs = env_count;
+    }
+
+private:
+    [[nodiscard]] static bool is_persistent(value_type type) noexcept {
+        return type == value_type::pmap || type == value_type::pvec;
+    }
+
+    value_type read_type() {
+        const std::uint8_t tag = in_.u8();
+        if (tag > type_tag(value_type::f64vec)) {
+            throw lisp_error("snapshot.load: unknown value type " + std::to_string(tag));
+        }
+        return static_cast<value_type>(tag);
+    }
+
+    map_key read_map_key() {
+        map_key key;
+        const std::uint8_t tag = in_.u8();
+        if (tag > static_cast<std::uint8_t>(map_key_type::floating)) {
+            throw lisp_error("snapshot.load: unknown map key type");
+        }
+        key.type = static_cast<map_key_type>(tag);
+        switch (key.type) {
+            case map_key_type::symbol:
+            case map_key_type::string:
+                key.text_data = in_.string();
+                break;
+            case map_key_type::integer:
+                key.integer_data = static_cast<std::int64_t>(in_.u64());
+                break;
+            case map_key_type::floating:
+                key.float_data = in_.f64();
+                break;
+        }
+        return key;
+    }
+
+    // Reads one object record. Atoms come back complete; containers come back empty and are filled in
+    // pass 2; persistent collections come back null and are skipped.
+    value allocate_object() {
+        const value_type type = read_type();
+        switch (type) {
+            case value_type::nil:
+                return make_nil();
+            case value_type::boolean:
+                return make_boolean(in_.u8() != 0);
+            case value_type::integer:
+                // Only values outside the immediate ranges are boxed, so these come back boxed too.
+                return make_integer(static_cast<std::int64_t>(in_.u64()));
+            case value_type::floating:
+                return make_float(in_.f64());
+            case value_type::symbol:
+                return make_symbol(in_.string());
+            case value_type::string:
+                return make_string(in_.string());
+            case value_type::primitive_fn: {
+                const std::string_view name = in_.string();
+                const auto found = primitives_.find(std::string(name));
+                if (found == primitives_.end()) {
+                    throw lisp_error("snapshot.load: primitive " + std::string(name) + " is not bound in this runtime");
+                }
+                return found->second;
+            }
+            case value_type::cons:
+                (void)in_.take(16);
+                return make_cons(make_nil(), make_nil());
+            case value_type::closure: {
+                std::vector<std::string> params(in_.count(4));
+                for (std::string& param : params) {
+                    param = in_.string();
+                }
+                (void)in_.take(static_cast<std::size_t>(in_.count(8)) * 8u);
+                (void)in_.u32();
+                return make_closure(params, {}, nullptr);
+            }
+            case value_type::vec:
+                (void)in_.take(static_cast<std::size_t>(in_.count(8)) * 8u);
+                return make_vec();
+            case value_type::map: {
+                const std::uint32_t count = in_.count(9);
+                for (std::uint32_t i = 0; i < count; ++i) {
+                    (void)read_map_key();
+                    (void)in_.u64();
+                }
+                return make_map();
+            }
+            case value_type::pq:
+                (void)in_.u64();
+                (void)in_.take(static_cast<std::size_t>(in_.count(28)) * 28u);
+                return make_pq();
+            case value_type::rng: {
+                const value out = make_rng(in_.u64());
+                out->rng_data()->has_spare_normal = in_.u8() != 0;
+                out->rng_data()->spare_normal = in_.f64();
+                return out;
+            }
+            case value_type::bt_def: {
+                const std::uint64_t size = in_.u64();
+                const std::span<const std::byte> image = in_.take(static_cast<std::size_t>(size));
+                bt::definition def;
+                try {
+                    def = bt::definition_view::open(image).materialise();
+                } catch (const std::exception& e) {
+                    throw lisp_error(std::string("snapshot.load: bad BT definition: ") + e.what());
+                }
+                ++stats_.bt_definitions;
+                return make_bt_def(bt::default_runtime_host().store_definition(std::move(def)));
+            }
+            case value_type::pmap: {
+                const std::uint32_t count = in_.count(9);
+                for (std::uint32_t i = 0; i < count; ++i) {
+                    (void)read_map_key();
+                    (void)in_.u64();
+                }
+                return nullptr;
+            }
+            case value_type::pvec:
+                (void)in_.take(static_cast<std::size_t>(in_.count(8)) * 8u);
+                return nullptr;
+            case value_type::f64vec: {
+                const value out = make_f64vec(in_.count(8));
+                for (double& item : out->f64vec_data()) {
+                    item = in_.f64();
+                }
+                return out;
+            }
+            case value_type::bt_instance:
+            case value_type::image_handle:
+            case value_type::blob_handle:
+                break;
+        }
+        throw lisp_error("snapshot.load: unexpected " + std::string(type_name(type)) + " record");
+    }
+
+    value resolve(std::uint64_t ref) {
+        if (ref == 0) {
+            return nullptr;
+        }
+        if ((ref & 0x3u) != 0) {
+            return value_from_bits(ref);
+        }
+        const std::uint64_t index = (ref >> 2u) - 1u;
+        if (index >= objects_.size()) {
+            throw lisp_error("snapshot.load: object reference out of range");
+        }
+        return object_at(static_cast<std::size_t>(index));
+    }
+
+    env_ptr resolve_env(std::uint32_t ref) {
+        if (ref == 0) {
+            return nullptr;
+        }
+        if (ref > envs_.size()) {
+            throw lisp_error("snapshot.load: env reference out of range");
+        }
+        return envs_[ref - 1u];
+    }
+
+    value object_at(std::size_t index) {
+        if (objects_[index] != nullptr) {
+            return objects_[index];
+        }
+        // A persistent collection not built yet. They are immutable, so they cannot contain themselves;
+        // reaching one twice on the same build path means the file is corrupt.
+        if (building_.size() < objects_.size()) {
+            building_.resize(objects_.size(), 0u);
+        }
+        if (building_[index] != 0u) {
+            throw lisp_error("snapshot.load: persistent collection contains itself");
+        }
+        building_[index] = 1u;
+        const std::size_t saved = in_.position();
+        in_.seek(offsets_[index]);
+        const value_type type = read_type();
+        value built = nullptr;
+        if (type == value_type::pmap) {
+            value transient = pmap_transient(make_pmap());
+            const std::uint32_t count = in_.u32();
+            for (std::uint32_t i = 0; i < count; ++i) {
+                const map_key key = read_map_key();
+                pmap_assoc_in_place(transient, key, resolve(in_.u64()));
+            }
+            built = pmap_persistent(transient);
+        } else {
+            value transient = pvec_transient(make_pvec());
+            const std::uint32_t count = in_.u32();
+            for (std::uint32_t i = 0; i < count; ++i) {
+                pvec_conj_in_place(transient, resolve(in_.u64()));
+            }
+            built = pvec_persistent(transient);
+        }
+        in_.seek(saved);
+        objects_[index] = built;
+        return built;
+    }
+
+    void fill_object(std::size_t index) {
+        value out = objects_[index];
+        gc& heap = default_gc();
+        in_.seek(offsets_[index]);
+        const value_type type = read_type();
+        switch (type) {
+            case value_type::cons:
+                out->car_data = resolve(in_.u64());
+                out->cdr_data = resolve(in_.u64());
+                heap.write_barrier(out, out->car_data);
+                heap.write_barrier(out, out->cdr_data);
+                break;
+            case value_type::closure: {
+                const std::uint32_t param_count = in_.u32();
+                for (std::uint32_t i = 0; i < param_count; ++i) {
+                    (void)in_.string();
+                }
+                std::vector<value>& body = out->closure_body_data();
+                body.resize(in_.u32());
+                for (value& expr : body) {
+                    expr = resolve(in_.u64());
+                    heap.write_barrier(out, expr);
+                }
+                out->closure_env_data() = resolve_env(in_.u32());
+                heap.write_barrier(out, out->closure_env_data());
+                closures_.push_back(out);
+                break;
+            }
+            case value_type::vec: {
+                std::vector<value>& items = out->vec_data();
+                items.resize(in_.u32());
+                for (value& item : items) {
+                    item = resolve(in_.u64());
+                    heap.write_barrier(out, item);
+                }
+                break;
+            }
+            case value_type::map: {
+                const std::uint32_t count = in_.u32();
+                map_storage& entries = out->map_data();
+                entries.reserve(count);
+                for (std::uint32_t i = 0; i < count; ++i) {
+                    map_key key = read_map_key();
+                    const value mapped = resolve(in_.u64());
+                    entries.insert_or_assign(std::move(key), mapped);
+                    heap.write_barrier(out, mapped);
+                }
+                break;
+            }
+            case value_type::pq: {
+                // Entries keep their slots so handles stay valid across a save and load.
+                pq_payload& queue = out->pq_data();
+                queue.next_sequence = in_.u64();
+                const std::uint32_t count = in_.u32();
+                for (std::uint32_t i = 0; i < count; ++i) {
+                    pq_key key;
+                    key.priority = in_.f64();
+                    key.sequence = in_.u64();
+                    key.slot = in_.u32();
+                    const value payload = resolve(in_.u64());
+                    if (key.slot == pq_payload::k_free_slot || queue.holds(key.slot)) {
+                        throw lisp_error("snapshot.load: bad priority queue slot");
+                    }
+                    if (key.slot >= queue.slot_positions.size()) {
+                        queue.slot_positions.resize(key.slot + 1u, pq_payload::k_free_slot);
+                        queue.slot_payloads.resize(key.slot + 1u, nullptr);
+                    }
+                    queue.slot_positions[key.slot] = static_cast<std::uint32_t>(queue.heap.size());
+                    queue.slot_payloads[key.slot] = payload;
+                    queue.heap.push_back(key);
+                    heap.write_barrier(out, payload);
+                }
+                for (std::uint32_t slot = 0; slot < queue.slot_positions.size(); ++slot) {
+                    if (!queue.holds(slot)) {
+                        queue.free_slots.push_back(slot);
+                    }
+                }
+                queue.heapify();
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    void fill_env(std::size_t index) {
+        env_ptr scope = envs_[index];
+        const std::uint32_t parent_ref = in_.u32();
+        if (index != 0) {
+            scope->parent = resolve_env(parent_ref);
+            default_gc().write_barrier(scope, scope->parent);
+        }
+        const std::uint32_t count = in_.count(16);
+        for (std::uint32_t i = 0; i < count; ++i) {
+            const value symbol = resolve(in_.u64());
+            const value bound = resolve(in_.u64());
+            if (!is_symbol(symbol)) {
+                throw lisp_error("snapshot.load: binding name is not a symbol");
+            }
+            define(scope, symbol, bound);
+        }
+        if (index == 0) {
+            stats_.bindings = count;
+        }
+    }
+
+    snapshot_reader in_;
+    env_ptr global_;
+    snapshot_stats& stats_;
+    std::unordered_map<std::string, value> primitives_;
+    std::vector<std::size_t> offsets_;
+    std::vector<value> objects_;
+    std::vector<std::uint8_t> building_;
+    std::vector<env_ptr> envs_;
+    std::vector<value> closures_;
+};
+
+}  // namespace
+
+snapshot_stats save_snapshot(env_ptr global, const std::string& path) {
+    if (!global) {
+        throw lisp_error("snapshot.save: null environment");
+    }
+    snapshot_stats stats;
+    const std::vector<std::byte> image = snapshot_encoder(global, stats).encode();
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw lisp_error("snapshot.save: failed to open file: " + path);
+    }
+    out.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+    if (!out) {
+        throw lisp_error("snapshot.save: write failure: " + path);
+    }
+    return stats;
+}
+
+snapshot_stats load_snapshot(env_ptr global, const std::string& path) {
+    if (!global) {
+        throw lisp_error("snapshot.load: null environment");
+    }
+    const mapped_snapshot_file file(path);
+    snapshot_stats stats;
+    snapshot_decoder(file.bytes(), global, stats).decode();
+    return stats;
+}
+
+}  // namespace muslisp
@@ -1,30 +1,69 @@
 #include "muslisp/value.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <functional>
 #include <mutex>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 
 #include "compiled_eval.hpp"
 #include "muslisp/env.hpp"
 #include "muslisp/error.hpp"
+#include "muslisp/persistent.hpp"
 
 namespace muslisp {
 namespace {
 
+std::unique_ptr<object_payload> make_payload(value_type type) {
+    switch (type) {
+        case value_type::primitive_fn:
+            return std::make_unique<primitive_payload>();
+        case value_type::closure:
+            return std::make_unique<closure_payload>();
+        case value_type::vec:
+            return std::make_unique<vec_payload>();
+        case value_type::map:
+            return std::make_unique<map_payload>();
+        case value_type::pq:
+            return std::make_unique<pq_payload>();
+        case value_type::rng:
+            return std::make_unique<rng_payload>();
+        case value_type::pmap:
+            return std::make_unique<pmap_payload>();
+        case value_type::pvec:
+            return std::make_unique<pvec_payload>();
+        case value_type::f64vec:
+            return std::make_unique<f64vec_payload>();
+        default:
+            return nullptr;
+    }
+}
+
 value make_object(value_type type) {
     return default_gc().allocate<object>(type);
 }
 
 void require_type(value v, value_type expected, const std::string& where) {
-    if (!v || v->type != expected) {
+    if (!is_heap_value(v) || v->type != expected) {
         throw lisp_error(where + ": expected " + std::string(type_name(expected)));
     }
 }
 
-std::unordered_map<std::string, value>& symbol_table() {
-    static std::unordered_map<std::string, value> table;
+// Transparent hash so readers can intern from a std::string_view without building a key string.
+struct symbol_name_hash {
+    using is_transparent = void;
+    [[nodiscard]] std::size_t operator()(std::string_view name) const noexcept {
+        return std::hash<std::string_view>{}(name);
+    }
+};
+
+using symbol_table_map = std::unordered_map<std::string, value, symbol_name_hash, std::equal_to<>>;
+
+symbol_table_map& symbol_table() {
+    static symbol_table_map table;
     return table;
 }
 
@@ -33,6 +72,19 @@ std::mutex& symbol_table_mutex() {
     return mutex;
 }
 
+// Interned symbols and the nil/boolean singletons are shared by every heap and runtime_context in the
+// process, so they live on a heap of their own that is never collected and outlives all of them.
+// Guarded by symbol_table_mutex().
+gc& permanent_heap() {
+    static gc heap;
+    return heap;
+}
+
+value make_permanent_object(value_type type) {
+    std::lock_guard<std::mutex> lock(symbol_table_mutex());
+    return permanent_heap().allocate<object>(type);
+}
+
 double number_to_double(value v) {
     if (is_integer(v)) {
         return static_cast<double>(integer_value(v));
@@ -84,7 +136,7 @@ std::size_t map_key_hash::operator()(const map_key& key) const noexcept {
     return seed;
 }
 
-object::object(value_type value_type_tag) : type(value_type_tag) {}
+object::object(value_type value_type_tag) : type(value_type_tag), payload(make_payload(value_type_tag)) {}
 
 void object::gc_mark_children(gc& heap) {
     switch (type) {
@@ -93,25 +145,36 @@ void object::gc_mark_children(gc& heap) {
             heap.mark_value(cdr_data);
             break;
         case value_type::closure:
-            for (value expr : closure_body_data) {
+            for (value expr : closure_body_data()) {
                 heap.mark_value(expr);
             }
-            heap.mark_env(closure_env_data);
-            compiled_closure_mark_children(closure_compiled_data, heap);
+            heap.mark_env(closure_env_data());
+            compiled_closure_mark_children(closure_compiled_data(), heap);
             break;
         case value_type::vec:
-            for (value elem : vec_data) {
+            for (value elem : vec_data()) {
                 heap.mark_value(elem);
             }
             break;
         case value_type::map:
-            for (const auto& [_, mapped] : map_data) {
+            for (const auto& [_, mapped] : map_data()) {
                 heap.mark_value(mapped);
             }
             break;
         case value_type::pq:
-            for (const pq_entry& entry : pq_data) {
-                heap.mark_value(entry.payload);
+            for (value payload : pq_data().slot_payloads) {
+                if (payload) {
+                    heap.mark_value(payload);
+                }
+            }
+            break;
+        case value_type::pmap:
+            heap.mark_node(pmap_data().root);
+            break;
+        case value_type::pvec:
+            heap.mark_node(pvec_data().root);
+            for (value item : pvec_data().tail) {
+                heap.mark_value(item);
             }
             break;
         default:
@@ -120,60 +183,172 @@ void object::gc_mark_children(gc& heap) {
 }
 
 std::size_t object::gc_size_bytes() const {
-    return sizeof(object);
+    return sizeof(object) + (payload ? payload->size_bytes() : 0);
+}
+
+namespace {
+
+constexpr std::size_t k_pq_arity = 4;
+
+bool pq_key_before(const pq_key& lhs, const pq_key& rhs) noexcept {
+    if (lhs.priority != rhs.priority) {
+        return lhs.priority < rhs.priority;
+    }
+    return lhs.sequence < rhs.sequence;
+}
+
+}  // namespace
+
+std::uint32_t pq_payload::claim_slot(value payload) {
+    std::uint32_t slot = 0;
+    if (!free_slots.empty()) {
+        slot = free_slots.back();
+        free_slots.pop_back();
+        slot_payloads[slot] = payload;
+    } else {
+        if (slot_positions.size() >= k_free_slot) {
+            throw lisp_error("pq: too many entries");
+        }
+        slot = static_cast<std::uint32_t>(slot_positions.size());
+        slot_payloads.push_back(payload);
+        slot_positions.push_back(k_free_slot);
+    }
+    return slot;
+}
+
+void pq_payload::place(std::size_t index, const pq_key& key) {
+    heap[index] = key;
+    slot_positions[key.slot] = static_cast<std::uint32_t>(index);
+}
+
+void pq_payload::sift_up(std::size_t index) {
+    const pq_key key = heap[index];
+    while (index > 0) {
+        const std::size_t parent = (index - 1) / k_pq_arity;
+        if (!pq_key_before(key, heap[parent])) {
+            break;
+        }
+        place(index, heap[parent]);
+        index = parent;
+    }
+    place(index, key);
+}
+
+void pq_payload::sift_down(std::size_t index) {
+    const pq_key key = heap[index];
+    const std::size_t count = heap.size();
+    while (true) {
+        const std::size_t first = index * k_pq_arity + 1;
+        if (first >= count) {
+            break;
+        }
+        const std::size_t last = std::min(first + k_pq_arity, count);
+        std::size_t best = first;
+        for (std::size_t child = first + 1; child < last; ++child) {
+            if (pq_key_before(heap[child], heap[best])) {
+                best = child;
+            }
+        }
+        if (!pq_key_before(heap[best], key)) {
+            break;
+        }
+        place(index, heap[best]);
+        index = best;
+    }
+    place(index, key);
+}
+
+std::uint32_t pq_payload::insert(double priority, value payload) {
+    const std::uint32_t slot = append_unordered(priority, next_sequence++, payload);
+    sift_up(heap.size() - 1);
+    return slot;
+}
+
+std::uint32_t pq_payload::append_unordered(double priority, std::uint64_t sequence, value payload) {
+    const std::uint32_t slot = claim_slot(payload);
+    heap.push_back(pq_key{.priority = priority, .sequence = sequence, .slot = slot});
+    slot_positions[slot] = static_cast<std::uint32_t>(heap.size() - 1);
+    return slot;
+}
+
+void pq_payload::heapify() {
+    if (heap.size() < 2) {
+        return;
+    }
+    for (std::size_t index = (heap.size() - 2) / k_pq_arity + 1; index-- > 0;) {
+        sift_down(index);
+    }
+}
+
+void pq_payload::update(std::uint32_t slot, double priority) {
+    const std::size_t index = slot_positions[slot];
+    const double old_priority = heap[index].priority;
+    heap[index].priority = priority;
+    if (priority < old_priority) {
+        sift_up(index);
+    } else {
+        sift_down(index);
+    }
+}
+
+pq_key pq_payload::remove(std::uint32_t slot) {
+    const std::size_t index = slot_positions[slot];
+    const pq_key out = heap[index];
+    const pq_key last = heap.back();
+    heap.pop_back();
+    if (index < heap.size()) {
+        place(index, last);
+        if (index > 0 && pq_key_before(last, heap[(index - 1) / k_pq_arity])) {
+            sift_up(index);
+        } else {
+            sift_down(index);
+        }
+    }
+    slot_positions[slot] = k_free_slot;
+    slot_payloads[slot] = nullptr;
+    free_slots.push_back(slot);
+    return out;
 }
 
 value make_nil() {
-    static value nil_value = [] {
-        return make_object(value_type::nil);
-    }();
-    static bool rooted = [] {
-        default_gc().add_root_slot(&nil_value);
-        return true;
-    }();
-    (void)rooted;
+    static const value nil_value = make_permanent_object(value_type::nil);
     return nil_value;
 }
 
 value make_boolean(bool v) {
-    static value true_value = [] {
-        auto out = make_object(value_type::boolean);
+    static const value true_value = [] {
+        auto out = make_permanent_object(value_type::boolean);
         out->boolean_data = true;
         return out;
     }();
-    static bool true_rooted = [] {
-        default_gc().add_root_slot(&true_value);
-        return true;
-    }();
-    (void)true_rooted;
-
-    static value false_value = [] {
-        auto out = make_object(value_type::boolean);
+    static const value false_value = [] {
+        auto out = make_permanent_object(value_type::boolean);
         out->boolean_data = false;
         return out;
     }();
-    static bool false_rooted = [] {
-        default_gc().add_root_slot(&false_value);
-        return true;
-    }();
-    (void)false_rooted;
 
     return v ? true_value : false_value;
 }
 
 value make_integer(std::int64_t v) {
+    if (v >= kFixnumMin && v <= kFixnumMax) {
+        return value_from_bits((static_cast<std::uint64_t>(v) << 1) | 0x1u);
+    }
     auto out = make_object(value_type::integer);
     out->integer_data = v;
     return out;
 }
 
 value make_float(double v) {
+    if (value immediate = nullptr; try_make_flonum(v, immediate)) {
+        return immediate;
+    }
     auto out = make_object(value_type::floating);
     out->float_data = v;
     return out;
 }
 
-value make_symbol(const std::string& name) {
+value make_symbol(std::string_view name) {
     std::lock_guard<std::mutex> lock(symbol_table_mutex());
     auto& table = symbol_table();
 
@@ -182,15 +357,22 @@ value make_symbol(const std::string& name) {
         return found->second;
     }
 
-    auto sym = make_object(value_type::symbol);
-    sym->text_data = name;
-    table.emplace(name, sym);
+    auto sym = permanent_heap().allocate<object>(value_type::symbol);
+    sym->text_data.assign(name);
+    table.emplace(sym->text_data, sym);
     return sym;
 }
 
-value make_string(const std::string& text) {
+value find_symbol(std::string_view name) {
+    std::lock_guard<std::mutex> lock(symbol_table_mutex());
+    const auto& table = symbol_table();
+    const auto found = table.find(name);
+    return found != table.end() ? found->second : nullptr;
+}
+
+value make_string(std::string_view text) {
     auto out = make_object(value_type::string);
-    out->text_data = text;
+    out->text_data.assign(text);
     return out;
 }
 
@@ -204,22 +386,41 @@ value make_cons(value car_value, value cdr_value) {
 value make_primitive(const std::string& name, primitive_fn fn) {
     auto out = make_object(value_type::primitive_fn);
     out->text_data = name;
-    out->primitive_data = std::move(fn);
+    out->primitive_data() = std::move(fn);
+    return out;
+}
+
+value make_primitive(const std::string& name, primitive_span_fn fn) {
+    auto out = make_object(value_type::primitive_fn);
+    out->text_data = name;
+    out->primitive_data() = [fn](const std::vector<value>& args) { return fn(args); };
+    out->primitive_span_data() = fn;
     return out;
 }
 
 value make_closure(const std::vector<std::string>& params, const std::vector<value>& body, env_ptr captured_env) {
+    return make_closure(params, body, captured_env, try_compile_closure(params, body));
+}
+
+value make_closure(const std::vector<std::string>& params,
+                   const std::vector<value>& body,
+                   env_ptr captured_env,
+                   std::shared_ptr<compiled_closure> compiled) {
     auto out = make_object(value_type::closure);
-    out->closure_params_data = params;
-    out->closure_body_data = body;
-    out->closure_env_data = captured_env;
-    out->closure_compiled_data = try_compile_closure(params, body);
+    out->closure_params_data() = params;
+    out->closure_param_symbols_data().reserve(params.size());
+    for (const std::string& param : params) {
+        out->closure_param_symbols_data().push_back(make_symbol(param));
+    }
+    out->closure_body_data() = body;
+    out->closure_env_data() = captured_env;
+    out->closure_compiled_data() = std::move(compiled);
     return out;
 }
 
 value make_vec(std::size_t capacity) {
     auto out = make_object(value_type::vec);
-    out->vec_data.reserve(capacity);
+    out->vec_data().reserve(capacity);
     return out;
 }
 
@@ -229,41 +430,55 @@ value make_map() {
 
 value make_pq(std::size_t capacity) {
     auto out = make_object(value_type::pq);
-    out->pq_data.reserve(capacity);
-    out->pq_next_sequence = 0;
+    pq_payload& queue = out->pq_data();
+    queue.heap.reserve(capacity);
+    queue.slot_payloads.reserve(capacity);
+    queue.slot_positions.reserve(capacity);
     return out;
 }
 
 value make_rng(std::uint64_t seed) {
     auto out = make_object(value_type::rng);
-    out->rng_data = std::make_shared<rng_state>();
-    out->rng_data->state = seed;
-    out->rng_data->has_spare_normal = false;
-    out->rng_data->spare_normal = 0.0;
+    out->rng_data() = std::make_shared<rng_state>();
+    out->rng_data()->state = seed;
+    out->rng_data()->has_spare_normal = false;
+    out->rng_data()->spare_normal = 0.0;
     return out;
 }
 
 value make_bt_def(std::int64_t handle) {
     auto out = make_object(value_type::bt_def);
-    out->bt_handle_data = handle;
+    out->integer_data = handle;
     return out;
 }
 
 value make_bt_instance(std::int64_t handle) {
     auto out = make_object(value_type::bt_instance);
-    out->bt_handle_data = handle;
+    out->integer_data = handle;
     return out;
 }
 
 value make_image_handle(std::int64_t handle) {
     auto out = make_object(value_type::image_handle);
-    out->image_handle_data = handle;
+    out->integer_data = handle;
     return out;
 }
 
 value make_blob_handle(std::int64_t handle) {
     auto out = make_object(value_type::blob_handle);
-    out->blob_handle_data = handle;
+    out->integer_data = handle;
+    return out;
+}
+
+value make_f64vec(std::size_t length, double fill) {
+    auto out = make_object(value_type::f64vec);
+    out->f64vec_data().assign(length, fill);
+    return out;
+}
+
+value make_f64vec(std::span<const double> values) {
+    auto out = make_object(value_type::f64vec);
+    out->f64vec_data().assign(values.begin(), values.end());
     return out;
 }
 
@@ -271,6 +486,12 @@ value_type type_of(value v) {
     if (!v) {
         throw lisp_error("null value");
     }
+    if (is_fixnum(v)) {
+        return value_type::integer;
+    }
+    if (is_flonum(v)) {
+        return value_type::floating;
+    }
     return v->type;
 }
 
@@ -310,80 +531,86 @@ std::string_view type_name(value_type t) {
             return "image_handle";
         case value_type::blob_handle:
             return "blob_handle";
+        case value_type::pmap:
+            return "pmap";
+        case value_type::pvec:
+            return "pvec";
+        case value_type::f64vec:
+            return "f64vec";
     }
     return "unknown";
 }
 
 bool is_nil(value v) {
-    return v && v->type == value_type::nil;
+    return is_heap_value(v) && v->type == value_type::nil;
 }
 
 bool is_boolean(value v) {
-    return v && v->type == value_type::boolean;
-}
-
-bool is_integer(value v) {
-    return v && v->type == value_type::integer;
-}
-
-bool is_float(value v) {
-    return v && v->type == value_type::floating;
-}
-
-bool is_number(value v) {
-    return is_integer(v) || is_float(v);
+    return is_heap_value(v) && v->type == value_type::boolean;
 }
 
 bool is_symbol(value v) {
-    return v && v->type == value_type::symbol;
+    return is_heap_value(v) && v->type == value_type::symbol;
 }
 
 bool is_string(value v) {
-    return v && v->type == value_type::string;
+    return is_heap_value(v) && v->type == value_type::string;
 }
 
 bool is_cons(value v) {
-    return v && v->type == value_type::cons;
+    return is_heap_value(v) && v->type == value_type::cons;
 }
 
 bool is_primitive(value v) {
-    return v && v->type == value_type::primitive_fn;
+    return is_heap_value(v) && v->type == value_type::primitive_fn;
 }
 
 bool is_closure(value v) {
-    return v && v->type == value_type::closure;
+    return is_heap_value(v) && v->type == value_type::closure;
 }
 
 bool is_vec(value v) {
-    return v && v->type == value_type::vec;
+    return is_heap_value(v) && v->type == value_type::vec;
 }
 
 bool is_map(value v) {
-    return v && v->type == value_type::map;
+    return is_heap_value(v) && v->type == value_type::map;
 }
 
 bool is_pq(value v) {
-    return v && v->type == value_type::pq;
+    return is_heap_value(v) && v->type == value_type::pq;
 }
 
 bool is_rng(value v) {
-    return v && v->type == value_type::rng;
+    return is_heap_value(v) && v->type == value_type::rng;
 }
 
 bool is_bt_def(value v) {
-    return v && v->type == value_type::bt_def;
+    return is_heap_value(v) && v->type == value_type::bt_def;
 }
 
 bool is_bt_instance(value v) {
-    return v && v->type == value_type::bt_instance;
+    return is_heap_value(v) && v->type == value_type::bt_instance;
 }
 
 bool is_image_handle(value v) {
-    return v && v->type == value_type::image_handle;
+    return is_heap_value(v) && v->type == value_type::image_handle;
 }
 
 bool is_blob_handle(value v) {
-    return v && v->type == value_type::blob_handle;
+    return is_heap_value(v) && v->type == value_type::blob_handle;
+}
+
+bool is_pmap(value v) {
+    return is_heap_value(v) && v->type == value_type::pmap;
+}
+
+bool is_pvec(value v) {
+    return is_heap_value(v) && v->type == value_type::pvec;
+}
+
+bool is_f64vec(value v) {
+    return is_heap_value(v) && v->type == value_type::f64vec;
 }
 
 bool is_truthy(value v) {
@@ -401,12 +628,12 @@ bool boolean_value(value v) {
     return v->boolean_data;
 }
 
-std::int64_t integer_value(value v) {
+std::int64_t boxed_integer_value(value v) {
     require_type(v, value_type::integer, "integer_value");
     return v->integer_data;
 }
 
-double float_value(value v) {
+double boxed_float_value(value v) {
     require_type(v, value_type::floating, "float_value");
     return v->float_data;
 }
@@ -433,7 +660,12 @@ value cdr(value v) {
 
 const primitive_fn& primitive_function(value v) {
     require_type(v, value_type::primitive_fn, "primitive_function");
-    return v->primitive_data;
+    return v->primitive_data();
+}
+
+primitive_span_fn primitive_span_function(value v) {
+    require_type(v, value_type::primitive_fn, "primitive_span_function");
+    return v->primitive_span_data();
 }
 
 const std::string& primitive_name(value v) {
@@ -443,47 +675,56 @@ const std::string& primitive_name(value v) {
 
 const std::vector<std::string>& closure_params(value v) {
     require_type(v, value_type::closure, "closure_params");
-    return v->closure_params_data;
+    return v->closure_params_data();
+}
+
+const std::vector<value>& closure_param_symbols(value v) {
+    require_type(v, value_type::closure, "closure_param_symbols");
+    return v->closure_param_symbols_data();
 }
 
 const std::vector<value>& closure_body(value v) {
     require_type(v, value_type::closure, "closure_body");
-    return v->closure_body_data;
+    return v->closure_body_data();
 }
 
 env_ptr closure_env(value v) {
     require_type(v, value_type::closure, "closure_env");
-    return v->closure_env_data;
+    return v->closure_env_data();
 }
 
 const std::shared_ptr<compiled_closure>& closure_compiled(value v) {
     require_type(v, value_type::closure, "closure_compiled");
-    return v->closure_compiled_data;
+    return v->closure_compiled_data();
 }
 
 void set_closure_compiled(value v, std::shared_ptr<compiled_closure> compiled) {
     require_type(v, value_type::closure, "set_closure_compiled");
-    v->closure_compiled_data = std::move(compiled);
+    v->closure_compiled_data() = std::move(compiled);
 }
 
 std::int64_t bt_handle(value v) {
     if (!is_bt_def(v) && !is_bt_instance(v)) {
         throw lisp_error("bt_handle: expected bt_def or bt_instance");
     }
-    return v->bt_handle_data;
+    return v->integer_data;
 }
 
 std::int64_t image_handle_id(value v) {
     require_type(v, value_type::image_handle, "image_handle_id");
-    return v->image_handle_data;
+    return v->integer_data;
 }
 
 std::int64_t blob_handle_id(value v) {
     require_type(v, value_type::blob_handle, "blob_handle_id");
-    return v->blob_handle_data;
+    return v->integer_data;
 }
 
 value list_from_vector(const std::vector<value>& items) {
+    return list_from_vector(std::span<const value>(items));
+}
+
+value list_from_vector(std::span<const value> items) {
     value out = make_nil();
     for (auto it = items.rbegin(); it != items.rend(); ++it) {
         out = make_cons(*it, out);
@@ -536,11 +777,4 @@ bool eq_values(value lhs, value rhs) {
     return false;
 }
 
-void mark_interned_symbols(gc& heap) {
-    std::lock_guard<std::mutex> lock(symbol_table_mutex());
-    for (const auto& [_, sym] : symbol_table()) {
-        heap.mark_value(sym);
-    }
-}
-
 }  // namespace muslisp
@@ -0,0 +1,63 @@
+#!/usr/bin/env python3
+
+from __future__ import annotations
+
+import sys
+from pathlib import Path
+
+
+REPO_ROOT = Path(__file__).resolve().parents[1]
+sys.path.insert(0, str(REPO_ROOT / "tools"))
+
+import event_log_binary  # noqa: E402
+
+
+JSONL_FIXTURES = sorted((REPO_ROOT / "tests" / "fixtures" / "mbt.evt.v1").glob("*.jsonl")) + sorted(
+    (REPO_ROOT / "fixtures").glob("*/events.jsonl")
+)
+BINARY_FIXTURE = REPO_ROOT / "tests" / "fixtures" / "mbt.evt.v1-bin" / "minimal_run.mbtb"
+BINARY_FIXTURE_SOURCE = REPO_ROOT / "tests" / "fixtures" / "mbt.evt.v1" / "minimal_run.jsonl"
+
+
+def check(condition: bool, message: str) -> None:
+    if not condition:
+        raise AssertionError(message)
+
+
+def main() -> int:
+    check(bool(JSONL_FIXTURES), "expected JSONL fixtures")
+    for path in JSONL_FIXTURES:
+        jsonl = path.read_bytes()
+        encoded = event_log_binary.encode_jsonl(jsonl)
+        check(event_log_binary.decode_to_jsonl(encoded) == jsonl, f"round trip changed {path}")
+        check(len(encoded) < len(jsonl), f"binary encoding should be smaller than {path}")
+
+    # The committed stream pins the format: it was written by the encoder and must keep decoding.
+    binary = BINARY_FIXTURE.read_bytes()
+    source = BINARY_FIXTURE_SOURCE.read_bytes()
+    check(event_log_binary.decode_to_jsonl(binary) == source, "binary fixture should decode to minimal_run.jsonl")
+    check(event_log_binary.encode_jsonl(source) == binary, "encoder output for minimal_run.jsonl changed")
+
+    # Lines that are not canonical envelopes survive as raw records.
+    odd = (
+        b'{"schema":"mbt.evt.v1","contract_version":"1.0.0","type":"x\\u0041","run_id":"r","unix_ms":1,"seq":1,"data":{}}\n'
+        b'{"schema":"mbt.evt.v1","contract_version":"1.0.0","type":"x","run_id":"r","unix_ms":01,"seq":2,"data":{}}\n'
+        b"not json at all\n"
+        b'{"schema":"mbt.evt.v1","contract_version":"1.0.0","type":"x","run_id":"r","unix_ms":-5,"seq":3,"tick":9,'
+        b'"data":{"n":[1.50,-0,1e3,99999999999999999999],"s":"7\\"8"}}\n'
+    )
+    check(event_log_binary.decode_to_jsonl(event_log_binary.encode_jsonl(odd)) == odd, "non-canonical lines should round trip")
+
+    for corrupt in (binary[:-1], b"MBTX" + binary[4:], binary[:5] + b"\x7f"):
+        try:
+            event_log_binary.decode_to_jsonl(corrupt)
+        except event_log_binary.FormatError:
+            continue
+        raise AssertionError("corrupt binary streams should be rejected")
+
+    print(f"event_log_binary: {len(JSONL_FIXTURES)} fixtures round-tripped")
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+
+from __future__ import annotations
+
+import sys
+import tempfile
+from pathlib import Path
+
+
+REPO_ROOT = Path(__file__).resolve().parents[1]
+sys.path.insert(0, str(REPO_ROOT / "tools"))
+
+import event_log_index  # noqa: E402
+
+
+FIXTURES = sorted((REPO_ROOT / "tests" / "fixtures" / "mbt.evt.v1").glob("*.jsonl"))
+
+
+def check(condition: bool, message: str) -> None:
+    if not condition:
+        raise AssertionError(message)
+
+
+def naive_from_tick(lines: list[bytes], tick: int) -> list[bytes]:
+    for i, line in enumerate(lines):
+        line_tick = event_log_index.line_fields(line.rstrip(b"\n"))[2]
+        if line_tick is not None and line_tick >= tick:
+            return lines[i:]
+    return []
+
+
+def main() -> int:
+    check(bool(FIXTURES), "expected JSONL fixtures")
+    with tempfile.TemporaryDirectory() as tmp:
+        for fixture in FIXTURES:
+            lines = fixture.read_bytes().splitlines(keepends=True)
+            ticks = sorted({t for t in (event_log_index.line_fields(l.rstrip(b"\n"))[2] for l in lines) if t is not None})
+
+            log = Path(tmp) / fixture.name
+            log.write_bytes(b"".join(lines))
+            check(event_log_index.main(["build", str(log), "--every", "3"]) == 0, f"build failed for {fixture}")
+            header, entries, closed = event_log_index.read_index(Path(str(log) + ".idx"))
+            check(header["index_every"] == 3 and len(entries) == (len(lines) + 2) // 3, f"bad entries for {fixture}")
+            check(closed is not None and closed["events"] == len(lines), f"bad counts record for {fixture}")
+            for entry in entries:
+                body = log.read_bytes()
+                check(entry["offset"] == 0 or body[entry["offset"] - 1 : entry["offset"]] == b"\n",
+                      "offsets should point at line starts")
+            for tick in ticks + [ticks[-1] + 1 if ticks else 1]:
+                check(list(event_log_index.lines_from_tick(log, tick)) == naive_from_tick(lines, tick),
+                      f"seek to tick {tick} in {fixture.name} should match a scan")
+
+            # Split into rotated segments the way the runtime does: later ones start with the run_start copy.
+            if len(lines) < 6 or b'"type":"run_start"' not in lines[0]:
+                continue
+            base = Path(tmp) / "split" / fixture.name
+            base.parent.mkdir(exist_ok=True)
+            cut = len(lines) // 2
+            parts = [lines[:cut], [lines[0]] + lines[cut:]]
+            for k, part in enumerate(parts):
+                segment = event_log_index.segment_path(base, k)
+                segment.write_bytes(b"".join(part))
+                Path(str(segment) + ".idx").write_bytes(
+                    event_log_index.build_index(b"".join(part), segment.name, k, 2)
+                )
+            check(event_log_index.segment_paths(base) == [base, event_log_index.segment_path(base, 1)],
+                  "segments should be found in order")
+            for tick in ticks:
+                check(list(event_log_index.lines_from_tick(base, tick)) == naive_from_tick(lines, tick),
+                      f"seek to tick {tick} across segments of {fixture.name} should match a scan")
+            expected: dict[str, int] = {}
+            for line in lines:
+                event_type = event_log_index.line_fields(line.rstrip(b"\n"))[0]
+                expected[event_type] = expected.get(event_type, 0) + 1
+            check(event_log_index.total_counts(base) == expected, f"segment counts should add up for {fixture.name}")
+
+    print(f"event log index checks passed for {len(FIXTURES)} fixtures")
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+
+from __future__ import annotations
+
+import json
+import subprocess
+import sys
+import tempfile
+from pathlib import Path
+
+
+REPO_ROOT = Path(__file__).resolve().parents[1]
+sys.path.insert(0, str(REPO_ROOT / "tools"))
+
+from trace_validator import CheckConfig, validate_trace  # noqa: E402
+
+
+SCHEMA = REPO_ROOT / "schemas" / "event_log" / "v1" / "mbt.evt.v1.schema.json"
+FIXTURES = sorted((REPO_ROOT / "tests" / "fixtures" / "mbt.evt.v1").glob("*.jsonl")) + sorted(
+    (REPO_ROOT / "fixtures").glob("*/events.jsonl")
+)
+
+
+def check(condition: bool, message: str) -> None:
+    if not condition:
+        raise AssertionError(message)
+
+
+def run_native(binary: str, log: Path, *extra: str) -> tuple[int, dict]:
+    with tempfile.TemporaryDirectory() as tmp:
+        report_path = Path(tmp) / "report.json"
+        proc = subprocess.run(
+            [binary, *extra, "--report", str(report_path), str(log)],
+            cwd=REPO_ROOT,
+            capture_output=True,
+            text=True,
+            check=False,
+        )
+        check(proc.returncode in (0, 1), f"{log}: native validator failed: {proc.stderr}")
+        return proc.returncode, json.loads(report_path.read_text(encoding="utf-8"))
+
+
+def mutations(lines: list[str]) -> dict[str, list[str]]:
+    """Copies of a fixture with one invariant broken each."""
+    events = [json.loads(line) for line in lines]
+    out: dict[str, list[str]] = {}
+    ends = [i for i, event in enumerate(events) if event.get("type") == "tick_end"]
+    if ends:
+        out["drop_tick_end"] = lines[: ends[0]] + lines[ends[0] + 1 :]
+        out["truncated_tail"] = lines[: ends[-1]]
+    if len(lines) > 3:
+        out["duplicate_line"] = lines[:3] + [lines[2]] + lines[3:]
+        out["swapped_lines"] = lines[:1] + [lines[2], lines[1]] + lines[3:]
+        stripped = dict(events[2])
+        stripped.pop("seq", None)
+        out["missing_seq"] = lines[:2] + [json.dumps(stripped)] + lines[3:]
+    begins = [i for i, event in enumerate(events) if event.get("type") == "tick_begin"]
+    if len(begins) > 1:
+        out["repeated_tick"] = lines + [lines[begins[0]], lines[ends[0]]] if ends else lines
+    return out
+
+
+def compare(binary: str, log: Path, label: str, tolerate: bool) -> None:
+    config = CheckConfig(tolerate_incomplete_tail=tolerate)
+    expected = validate_trace(str(log), config).to_dict()
+    extra = ["--no-schema"] + (["--tolerate-incomplete-tail"] if tolerate else [])
+    code, actual = run_native(binary, log, *extra)
+    check(code == (0 if expected["passed"] else 1), f"{label}: exit code {code} disagrees with Python")
+    for key in ("passed", "trace_truncated", "summary", "violation_counts"):
+        check(actual[key] == expected[key], f"{label}: {key} differs: native={actual[key]} python={expected[key]}")
+    native = [(v["code"], v.get("line_no"), v["message"]) for v in actual["violations"]]
+    python = [(v["code"], v.get("line_no"), v["message"]) for v in expected["violations"]]
+    check(native == python, f"{label}: violations differ:\nnative={native}\npython={python}")
+
+
+def main() -> int:
+    if len(sys.argv) != 2:
+        print("usage: check_native_event_log_validator.py <muesli_evt_validate>", file=sys.stderr)
+        return 2
+    binary = sys.argv[1]
+    check(bool(FIXTURES), "expected JSONL fixtures")
+
+    with tempfile.TemporaryDirectory() as tmp:
+        for fixture in FIXTURES:
+            label = str(fixture.relative_to(REPO_ROOT))
+            compare(binary, fixture, label, tolerate=False)
+            lines = [line for line in fixture.read_text(encoding="utf-8").splitlines() if line.strip()]
+            for name, mutated in mutations(lines).items():
+                path = Path(tmp) / f"{fixture.parent.name}-{fixture.stem}-{name}.jsonl"
+                path.write_text("\n".join(mutated) + "\n", encoding="utf-8")
+                compare(binary, path, f"{label} [{name}]", tolerate=False)
+                compare(binary, path, f"{label} [{name}, tolerant]", tolerate=True)
+
+        # Schema errors fail the log even when every trace rule holds.
+        minimal = REPO_ROOT / "tests" / "fixtures" / "mbt.evt.v1" / "minimal_run.jsonl"
+        code, report = run_native(binary, minimal, "--schema", str(SCHEMA))
+        check(code == 0 and report["passed"], "minimal fixture should pass schema and trace checks")
+        events = [json.loads(line) for line in minimal.read_text(encoding="utf-8").splitlines() if line.strip()]
+        events[0]["contract_version"] = ""
+        events[1]["unexpected"] = 1
+        broken = Path(tmp) / "schema-broken.jsonl"
+        broken.write_text("".join(json.dumps(event) + "\n" for event in events) + "{not json\n", encoding="utf-8")
+        code, report = run_native(binary, broken, "--schema", str(SCHEMA), "--threads", "2")
+        check(code == 1, "schema violations should fail the log")
+        codes = [v["code"] for v in report["violations"]]
+        check(codes.count("schema_violation") >= 2, f"expected schema violations, got {codes}")
+        check("invalid_json" in codes, f"expected invalid_json, got {codes}")
+
+        try:
+            import jsonschema  # noqa: F401
+        except ImportError:
+            jsonschema = None
+        if jsonschema is not None:
+            import validate_log
+
+            for fixture in FIXTURES:
+                python_ok = validate_log.main(["--schema", str(SCHEMA), str(fixture)]) == 0
+                code, _ = run_native(binary, fixture, "--no-trace")
+                check((code == 0) == python_ok, f"{fixture}: schema verdict differs from validate_log.py")
+
+    print("native event log validator parity: ok")
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
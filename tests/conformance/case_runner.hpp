@@ -0,0 +1,169 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "muslisp/gc.hpp"
+
+namespace conformance {
+
+struct test_case {
+    std::string name;
+    std::vector<std::string> tags;
+    std::function<void()> run;
+    // Cases that touch process-wide state (the ROS2 env backend, rclcpp) run one at a time on the
+    // calling thread after the concurrent ones.
+    bool exclusive = false;
+};
+
+struct run_options {
+    // A case runs when it carries any of these tags; empty selects every case.
+    std::vector<std::string> tags;
+    // Worker threads for non-exclusive cases; 0 uses every hardware thread.
+    std::size_t jobs = 0;
+    bool list = false;
+};
+
+// Accepts `--tag TAG` (repeatable, or comma-separated), `--jobs N` and `--list`.
+inline run_options parse_run_options(int argc, char** argv) {
+    run_options out;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument(arg + " needs a value");
+            }
+            return argv[++i];
+        };
+        if (arg == "--tag") {
+            const std::string value = next();
+            std::size_t start = 0;
+            while (start <= value.size()) {
+                const std::size_t comma = std::min(value.find(',', start), value.size());
+                if (comma > start) {
+                    out.tags.push_back(value.substr(start, comma - start));
+                }
+                start = comma + 1;
+            }
+        } else if (arg == "--jobs") {
+            out.jobs = static_cast<std::size_t>(std::stoul(next()));
+        } else if (arg == "--list") {
+            out.list = true;
+        } else {
+            throw std::invalid_argument("unknown argument " + arg + " (expected --tag TAG, --jobs N or --list)");
+        }
+    }
+    return out;
+}
+
+inline bool case_selected(const test_case& c, const run_options& options) {
+    if (options.tags.empty()) {
+        return true;
+    }
+    return std::any_of(c.tags.begin(), c.tags.end(), [&](const std::string& tag) {
+        return std::find(options.tags.begin(), options.tags.end(), tag) != options.tags.end();
+    });
+}
+
+// Runs the selected cases and prints one [PASS]/[FAIL] line per case in table order. Each worker
+// allocates on its own GC heap, freed when the worker finishes. Returns the process exit code.
+inline int run_cases(const std::vector<test_case>& cases, const run_options& options, std::string_view suite) {
+    std::vector<const test_case*> selected;
+    for (const test_case& c : cases) {
+        if (case_selected(c, options)) {
+            selected.push_back(&c);
+        }
+    }
+    if (options.list) {
+        for (const test_case* c : selected) {
+            std::cout << c->name << " [";
+            for (std::size_t i = 0; i < c->tags.size(); ++i) {
+                std::cout << (i == 0 ? "" : ",") << c->tags[i];
+            }
+            std::cout << "]" << (c->exclusive ? " exclusive" : "") << '\n';
+        }
+        return 0;
+    }
+    if (selected.empty()) {
+        std::cerr << "no " << suite << " cases match the selected tags\n";
+        return 1;
+    }
+
+    struct outcome {
+        std::string error;
+        bool failed = false;
+        double elapsed_ms = 0.0;
+    };
+    std::vector<outcome> outcomes(selected.size());
+    const auto run_one = [&](std::size_t i) {
+        const auto start = std::chrono::steady_clock::now();
+        try {
+            selected[i]->run();
+        } catch (const std::exception& e) {
+            outcomes[i].failed = true;
+            outcomes[i].error = e.what();
+        } catch (...) {
+            outcomes[i].failed = true;
+            outcomes[i].error = "unknown exception";
+        }
+        outcomes[i].elapsed_ms =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    std::vector<std::size_t> shared;
+    for (std::size_t i = 0; i < selected.size(); ++i) {
+        if (!selected[i]->exclusive) {
+            shared.push_back(i);
+        }
+    }
+    const std::size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+    const std::size_t jobs = std::min(options.jobs != 0 ? options.jobs : hardware, shared.size());
+    std::atomic<std::size_t> next{0};
+    std::vector<std::thread> workers;
+    for (std::size_t w = 0; w < jobs; ++w) {
+        workers.emplace_back([&] {
+            muslisp::gc heap;
+            muslisp::gc_thread_heap_scope heap_scope(heap);
+            for (std::size_t k = next.fetch_add(1); k < shared.size(); k = next.fetch_add(1)) {
+                run_one(shared[k]);
+            }
+        });
+    }
+    for (std::thread& t : workers) {
+        t.join();
+    }
+    for (std::size_t i = 0; i < selected.size(); ++i) {
+        if (selected[i]->exclusive) {
+            run_one(i);
+        }
+    }
+
+    std::size_t passed = 0;
+    for (std::size_t i = 0; i < selected.size(); ++i) {
+        if (outcomes[i].failed) {
+            std::cerr << "[FAIL] " << selected[i]->name << ": " << outcomes[i].error << '\n';
+        } else {
+            ++passed;
+            std::cout << "[PASS] " << selected[i]->name << " (" << static_cast<long long>(outcomes[i].elapsed_ms)
+                      << " ms)\n";
+        }
+    }
+    if (passed != selected.size()) {
+        std::cerr << suite << ": " << (selected.size() - passed) << " of " << selected.size() << " cases failed.\n";
+        return 1;
+    }
+    std::cout << "All " << suite << " tests passed (" << passed << "/" << selected.size() << ").\n";
+    return 0;
+}
+
+}  // namespace conformance
@@ -13,23 +13,6 @@
 
 namespace conformance {
 
-class stepped_clock final : public bt::clock_interface {
-public:
-    stepped_clock() = default;
-
-    std::chrono::steady_clock::time_point now() const override { return now_; }
-
-    void advance_ms(std::int64_t ms) {
-        if (ms <= 0) {
-            return;
-        }
-        now_ += std::chrono::milliseconds(ms);
-    }
-
-private:
-    std::chrono::steady_clock::time_point now_{};
-};
-
 struct scripted_vla_behaviour {
     std::int64_t steps_before_complete = 8;
     std::int64_t step_sleep_ms = 1;
@@ -29,6 +29,7 @@
 #include "muslisp/eval.hpp"
 #include "muslisp/value.hpp"
 #include "ros2/extension.hpp"
+#include "tests/conformance/case_runner.hpp"
 #include "tests/ros2_test_harness.hpp"
 
 namespace {
@@ -352,7 +353,7 @@ std::optional<muslisp::value> map_lookup_text_key(muslisp::value map_obj, const
     if (!muslisp::is_map(map_obj)) {
         return std::nullopt;
     }
-    for (const auto& [map_key, map_value] : map_obj->map_data) {
+    for (const auto& [map_key, map_value] : map_obj->map_data()) {
         if ((map_key.type == muslisp::map_key_type::string || map_key.type == muslisp::map_key_type::symbol) &&
             map_key.text_data == key) {
             return map_value;
@@ -1225,30 +1226,46 @@ void cleanup_runtime() {
     muslisp::env_api_reset();
 }
 
-void run_case(const std::string& label, const std::function<void()>& fn) {
-    try {
-        fn();
-        std::cout << "[PASS] " << label << '\n';
-    } catch (...) {
-        cleanup_runtime();
-        throw;
-    }
-    cleanup_runtime();
+// Every case drives the process-wide ROS2 env backend, so they run one at a time with a reset after
+// each.
+conformance::test_case l2_case(std::string name, std::vector<std::string> tags, void (*fn)()) {
+    return conformance::test_case{
+        .name = std::move(name),
+        .tags = std::move(tags),
+        .run =
+            [fn] {
+                try {
+                    fn();
+                } catch (...) {
+                    cleanup_runtime();
+                    throw;
+                }
+                cleanup_runtime();
+            },
+        .exclusive = true,
+    };
 }
 
 }  // namespace
 
-int main() {
+int main(int argc, char** argv) {
+    conformance::run_options options;
     try {
-        run_case("ros2 rosbag replay conformance", test_ros2_rosbag_replay_conformance);
-        run_case("ros2 rosbag clamp conformance", test_ros2_rosbag_clamp_conformance);
-        run_case("ros2 rosbag invalid-action fallback conformance", test_ros2_rosbag_invalid_action_fallback_conformance);
-        run_case("ros2 rosbag preemption fallback conformance", test_ros2_rosbag_preemption_fallback_conformance);
-        run_case("ros2 reset policy artefact", test_ros2_reset_unsupported_policy_artifact);
-        return 0;
+        options = conformance::parse_run_options(argc, argv);
     } catch (const std::exception& e) {
-        std::cerr << "[FAIL] " << e.what() << '\n';
-        cleanup_runtime();
-        return 1;
+        std::cerr << "muesli_bt_conformance_l2_rosbag_tests: " << e.what() << '\n';
+        return 2;
     }
+    const std::vector<conformance::test_case> tests = {
+        l2_case("ros2 rosbag replay conformance", {"rosbag", "replay"}, test_ros2_rosbag_replay_conformance),
+        l2_case("ros2 rosbag clamp conformance", {"rosbag", "clamp"}, test_ros2_rosbag_clamp_conformance),
+        l2_case("ros2 rosbag invalid-action fallback conformance",
+                {"rosbag", "fallback"},
+                test_ros2_rosbag_invalid_action_fallback_conformance),
+        l2_case("ros2 rosbag preemption fallback conformance",
+                {"rosbag", "fallback", "preemption"},
+                test_ros2_rosbag_preemption_fallback_conformance),
+        l2_case("ros2 reset policy artefact", {"reset", "artefact"}, test_ros2_reset_unsupported_policy_artifact),
+    };
+    return conformance::run_cases(tests, options, "L2 rosbag conformance");
 }
@@ -2,7 +2,6 @@
 #include <cctype>
 #include <cstdint>
 #include <cmath>
-#include <functional>
 #include <iostream>
 #include <memory>
 #include <stdexcept>
@@ -14,6 +13,7 @@
 
 #include "bt/compiler.hpp"
 #include "bt/runtime_host.hpp"
+#include "bt/sim_clock.hpp"
 #if MUESLI_BT_WITH_ROS2_INTEGRATION
 #include "muslisp/env.hpp"
 #include "muslisp/env_api.hpp"
@@ -24,6 +24,7 @@
 #endif
 #include "muslisp/reader.hpp"
 #include "muslisp/value.hpp"
+#include "tests/conformance/case_runner.hpp"
 #include "tests/conformance/mock_backend.hpp"
 
 namespace {
@@ -220,12 +221,12 @@ bt::vla_request make_request(const std::string& model_name,
     return req;
 }
 
-void install_burn_action(bt::runtime_host& host, conformance::stepped_clock& clock) {
+void install_burn_action(bt::runtime_host& host, bt::sim_clock& clock) {
     host.callbacks().register_action(
         "burn-ms",
         [&clock](bt::tick_context&, bt::node_id, bt::node_memory&, std::span<const muslisp::value> args) {
             const std::int64_t ms = (args.empty() || !muslisp::is_integer(args[0])) ? 1 : muslisp::integer_value(args[0]);
-            clock.advance_ms(ms);
+            clock.advance(std::chrono::milliseconds(ms));
             return bt::status::success;
         });
 }
@@ -254,8 +255,7 @@ void test_tick_semantics_events_balanced() {
 void test_budget_gate_blocks_planner_start() {
     bt::runtime_host host;
     bt::install_demo_callbacks(host);
-    conformance::stepped_clock clock;
-    host.set_clock_interface(&clock);
+    bt::sim_clock& clock = host.enable_simulated_time();
     install_burn_action(host, clock);
 
     const std::int64_t inst = create_instance(host,
@@ -277,11 +277,68 @@ void test_budget_gate_blocks_planner_start() {
     check(!has_type(lines, "planner_call_start"), "budget gate: planner call should not start");
 }
 
+void test_adaptive_plan_budget_tracks_tick_slack() {
+    bt::runtime_host host;
+    bt::install_demo_callbacks(host);
+    bt::sim_clock& clock = host.enable_simulated_time();
+    install_burn_action(host, clock);
+
+    const auto plan_budget = [&](std::int64_t budget_min_ms) {
+        const std::int64_t inst = create_instance(
+            host,
+            "(seq "
+            "  (act burn-ms 3) "
+            "  (plan-action :name \"adaptive-plan\" :planner :mcts :state_key state :action_key action "
+            "               :meta_key plan-meta :work_max 16 :budget_mode \"adaptive\" :budget_max_ms 15 "
+            "               :budget_min_ms " +
+                std::to_string(budget_min_ms) +
+                ") "
+                "  (act burn-ms 6))");
+        bt::instance* inst_ptr = host.find_instance(inst);
+        check(inst_ptr != nullptr, "adaptive budget: missing instance");
+        bt::set_tick_budget_ms(*inst_ptr, 20);
+        inst_ptr->bb.put("state", bt::bb_value{0.0}, 0, clock.now(), 0, "conformance");
+        std::vector<std::string> metas;
+        for (int tick = 0; tick < 3; ++tick) {
+            check(host.tick_instance(inst) == bt::status::success, "adaptive budget: tick should succeed");
+            const bt::bb_entry* meta = inst_ptr->bb.get("plan-meta");
+            const std::string* text = meta ? std::get_if<std::string>(&meta->value) : nullptr;
+            check(text != nullptr, "adaptive budget: missing plan meta");
+            metas.push_back(*text);
+        }
+        return metas;
+    };
+
+    // Each tick has 17 ms left when the planner starts and spends 6 ms after it returns. The first
+    // plan has no sample and gets the max; the second keeps 6 ms + 2 * 3 ms of deviation back; the
+    // third sees the deviation decay by alpha (0.2) toward 0.
+    const std::vector<std::string> metas = plan_budget(1);
+    check(metas[0].find("\"budget_ms\":15,\"budget_mode\":\"adaptive\",\"budget_slack_ms\":17,\"budget_margin_ms\":0") !=
+              std::string::npos,
+          "adaptive budget: the first plan should get budget_max_ms");
+    check(metas[1].find("\"budget_ms\":5,\"budget_mode\":\"adaptive\",\"budget_slack_ms\":17,\"budget_margin_ms\":12") !=
+              std::string::npos,
+          "adaptive budget: the second plan should keep the learned post-planner work back");
+    check(metas[2].find("\"budget_ms\":6,") != std::string::npos &&
+              metas[2].find("\"budget_margin_ms\":10.8") != std::string::npos,
+          "adaptive budget: the margin should follow the smoothed deviation");
+
+    const std::vector<std::string> clamped = plan_budget(8);
+    check(clamped[1].find("\"budget_ms\":8,") != std::string::npos, "adaptive budget: budget_min_ms should clamp");
+
+    const auto lines = host.events().snapshot();
+    bool start_reports_mode = false;
+    for (const std::string& line : lines) {
+        start_reports_mode = start_reports_mode || (line_has_type(line, "planner_call_start") &&
+                                                    line.find("\"budget_mode\":\"adaptive\"") != std::string::npos);
+    }
+    check(start_reports_mode, "adaptive budget: planner_call_start should report the budget mode");
+}
+
 void test_deadline_overrun_requests_async_cancellation() {
     bt::runtime_host host;
     bt::install_demo_callbacks(host);
-    conformance::stepped_clock clock;
-    host.set_clock_interface(&clock);
+    bt::sim_clock& clock = host.enable_simulated_time();
     install_burn_action(host, clock);
 
     auto backend = std::make_shared<conformance::scripted_vla_backend>(conformance::scripted_vla_behaviour{
@@ -573,43 +630,39 @@ void test_ros2_transport_conformance() {
 
 }  // namespace
 
-int main() {
-    const std::vector<std::pair<std::string, std::function<void()>>> tests = {
-        {"tick semantics events balanced", test_tick_semantics_events_balanced},
-        {"budget gate blocks planner start", test_budget_gate_blocks_planner_start},
-        {"deadline overrun requests async cancellation", test_deadline_overrun_requests_async_cancellation},
-        {"async lifecycle and idempotent cancel", test_async_lifecycle_and_idempotent_cancel},
-        {"determinism trace reproducibility", test_determinism_trace_reproducibility},
-#if MUESLI_BT_WITH_ROS2_INTEGRATION
-        {"ros2 info surface conformance", test_ros2_info_surface_conformance},
-        {"ros2 reset policy conformance", test_ros2_reset_policy_conformance},
-        {"ros2 transport conformance", test_ros2_transport_conformance},
-#endif
-    };
+int main(int argc, char** argv) {
+    conformance::run_options options;
+    try {
+        options = conformance::parse_run_options(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << "muesli_bt_conformance_tests: " << e.what() << '\n';
+        return 2;
+    }
 
-    const auto cleanup = []() {
+    // Tags: the contract area a case covers; `sim-time` cases run on the host's simulated clock and
+    // never wait, `wall-clock` cases exercise real scheduler threads and deadlines.
+    const std::vector<conformance::test_case> tests = {
+        {"tick semantics events balanced", {"tick", "events"}, test_tick_semantics_events_balanced},
+        {"budget gate blocks planner start", {"budget", "planner", "sim-time"}, test_budget_gate_blocks_planner_start},
+        {"adaptive plan budget tracks tick slack", {"budget", "planner", "sim-time"}, test_adaptive_plan_budget_tracks_tick_slack},
+        {"deadline overrun requests async cancellation",
+         {"deadline", "async", "sim-time"},
+         test_deadline_overrun_requests_async_cancellation},
+        {"async lifecycle and idempotent cancel", {"async", "cancel", "wall-clock"}, test_async_lifecycle_and_idempotent_cancel},
+        {"determinism trace reproducibility", {"determinism", "planner"}, test_determinism_trace_reproducibility},
 #if MUESLI_BT_WITH_ROS2_INTEGRATION
-        if (rclcpp::ok()) {
-            rclcpp::shutdown();
-        }
-        muslisp::env_api_reset();
+        {"ros2 info surface conformance", {"ros2"}, test_ros2_info_surface_conformance, true},
+        {"ros2 reset policy conformance", {"ros2", "reset"}, test_ros2_reset_policy_conformance, true},
+        {"ros2 transport conformance", {"ros2", "transport"}, test_ros2_transport_conformance, true},
 #endif
     };
 
-    std::size_t passed = 0;
-    for (const auto& [name, fn] : tests) {
-        try {
-            fn();
-            ++passed;
-            std::cout << "[PASS] " << name << '\n';
-        } catch (const std::exception& e) {
-            std::cerr << "[FAIL] " << name << ": " << e.what() << '\n';
-            cleanup();
-            return 1;
-        }
+    const int result = conformance::run_cases(tests, options, "conformance");
+#if MUESLI_BT_WITH_ROS2_INTEGRATION
+    if (rclcpp::ok()) {
+        rclcpp::shutdown();
     }
-
-    std::cout << "All conformance tests passed (" << passed << "/" << tests.size() << ").\n";
-    cleanup();
-    return 0;
+    muslisp::env_api_reset();
+#endif
+    return result;
 }
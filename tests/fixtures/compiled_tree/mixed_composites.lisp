@@ -0,0 +1,7 @@
+(sel (seq (cond bb-eq mode idle) (act test-script "sf"))
+     (seq (cond bb-eq mode walk) (invert (act test-script "fsr")))
+     (seq (cond bb-eq mode 3) (act test-script "s"))
+     (seq (cond bb-eq mode #t) (fail))
+     (mem-seq (act test-script "rs") (retry 1 (act test-script "ffs")) (repeat 2 (act test-script "s")))
+     (mem-sel (act test-script "f") (act test-script "rfs") (succeed))
+     (reactive-seq (act test-script "s") (running)))
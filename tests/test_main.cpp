@@ -1,11 +1,22 @@
+#include <any>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <cmath>
 #include <chrono>
 #include <cstdint>
 #include <filesystem>
 #include <functional>
 #include <fstream>
+#include <future>
 #include <iostream>
+#include <limits>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <thread>
@@ -13,11 +24,37 @@
 #include <utility>
 #include <vector>
 
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+#if !defined(_WIN32)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "bt/compiled_tree.hpp"
+#include "bt/event_compact.hpp"
+#include "bt/event_log_validator.hpp"
 #include "bt/instance.hpp"
+#include "bt/instance_pool.hpp"
+#include "bt/latest_mailbox.hpp"
 #include "bt/logging.hpp"
+#include "bt/loop_pacer.hpp"
+#include "bt/memory_footprint.hpp"
 #include "bt/model_service.hpp"
+#include "bt/model_service_mux.hpp"
+#include "bt/planner_compiled_model.hpp"
+#include "bt/profile_clock.hpp"
+#include "bt/replay_store.hpp"
 #include "bt/runtime_host.hpp"
+#include "bt/serialisation.hpp"
+#include "bt/shm_exchange.hpp"
 #include "bt/trace.hpp"
+#include "bt/work_stealing_scheduler.hpp"
+#include "../src/bt/planner_linalg.hpp"
 #include "../src/compiled_eval.hpp"
 #include "../src/repl_support.hpp"
 #if MUESLI_BT_WITH_PYBULLET_INTEGRATION
@@ -33,8 +70,10 @@
 #include "muslisp/error.hpp"
 #include "muslisp/eval.hpp"
 #include "muslisp/gc.hpp"
+#include "muslisp/persistent.hpp"
 #include "muslisp/printer.hpp"
 #include "muslisp/reader.hpp"
+#include "muslisp/runtime_context.hpp"
 
 namespace {
 
@@ -244,6 +283,16 @@ void test_reader_basics() {
     const auto exprs = read_all("1 ; comment\n2");
     check(exprs.size() == 2, "comment handling failed");
 
+    // Tokens are slices of the source: symbols must intern to the same object and strings must not alias it.
+    const std::string owned_source = "(act \"plain\" \"esc\\\"aped\" +1.5 -7 sym sym)";
+    const auto tokens = vector_from_list(read_one(owned_source));
+    check(tokens.size() == 7, "sliced token count mismatch");
+    check(tokens[0] == make_symbol("act") && tokens[5] == tokens[6], "sliced symbols should be interned");
+    check(string_value(tokens[1]) == "plain" && string_value(tokens[2]) == "esc\"aped", "sliced string mismatch");
+    check(is_float(tokens[3]) && float_value(tokens[3]) == 1.5, "+1.5 should still parse through strtod");
+    check(is_integer(tokens[4]) && integer_value(tokens[4]) == -7, "negative integer slice mismatch");
+    check(is_float(read_one(std::string(80, '1') + ".0")), "long float tokens should parse");
+
     try {
         (void)read_all("(");
         throw std::runtime_error("expected parse error for incomplete list");
@@ -265,6 +314,17 @@ void test_environment_shadowing() {
     check(integer_value(lookup(global, "x")) == 1, "global lookup failed");
     check(integer_value(lookup(child, "x")) == 3, "shadowed lookup failed");
     check(integer_value(lookup(child, "y")) == 2, "child lookup failed");
+    check(integer_value(lookup(child, make_symbol("x"))) == 3, "symbol-keyed lookup failed");
+    check(child->bindings.count(make_symbol("y")) == 1, "bindings should be keyed by interned symbol");
+
+    bool unbound_threw = false;
+    try {
+        (void)lookup(child, "never-interned-env-name");
+    } catch (const name_error&) {
+        unbound_threw = true;
+    }
+    check(unbound_threw, "unbound string lookup should throw");
+    check(find_symbol("never-interned-env-name") == nullptr, "string lookup should not intern unbound names");
 }
 
 void test_error_hierarchy_basics() {
@@ -652,16 +712,130 @@ void test_compiled_closure_path() {
     check(is_integer(recursive_result) && integer_value(recursive_result) == 0,
           "compiled recursive closure should run correctly");
 
-    value unsupported_cond = eval_text("(lambda (x) (cond ((> x 0) x) (else 0)))", env);
-    check(is_closure(unsupported_cond), "unsupported cond test should produce a closure");
-    check(!closure_compiled(unsupported_cond), "unsupported closure should fall back to the evaluator");
-    value unsupported_result = invoke_callable(unsupported_cond, {make_integer(2)});
-    check(is_integer(unsupported_result) && integer_value(unsupported_result) == 2,
-          "unsupported closure fallback should preserve semantics");
+    value collects_mid_call = eval_text("(lambda (x) (list (+ x 1) (begin (gc-stats) (+ x 2))))", env);
+    check(closure_compiled(collects_mid_call)->max_stack == 5, "compiled closure should size its operand stack");
+    check(print_value(invoke_callable(collects_mid_call, {make_integer(4)})) == "(5 6)",
+          "operands on the compiled VM stack should survive a collection");
+
+    value read_offset = eval_text("(lambda () offset)", env);
+    check(integer_value(invoke_callable(read_offset, {})) == 3, "compiled global read should resolve its binding");
+    (void)eval_text("(define offset 5)", env);
+    check(integer_value(invoke_callable(read_offset, {})) == 5, "cached global cell should observe redefinition");
+
+    value shadowed = eval_text(
+        "(begin "
+        "  (define (shadow-probe) "
+        "    (define get (lambda () offset)) "
+        "    (define before (get)) "
+        "    (define offset 100) "
+        "    (list before (get))) "
+        "  (shadow-probe))",
+        env);
+    check(print_value(shadowed) == "(5 100)", "cached global cell should be invalidated by a shadowing define");
+
+    value cond_closure = eval_text("(lambda (x) (cond ((> x 0) x) (else 0)))", env);
+    check(static_cast<bool>(closure_compiled(cond_closure)), "cond should compile");
+    check(integer_value(invoke_callable(cond_closure, {make_integer(2)})) == 2, "compiled cond should preserve semantics");
+
+    value nested = eval_text("(lambda (x) (lambda (y) (+ x y)))", env);
+    check(static_cast<bool>(closure_compiled(nested)), "nested lambda should compile");
+    value adder = invoke_callable(nested, {make_integer(3)});
+    check(static_cast<bool>(closure_compiled(adder)) && integer_value(invoke_callable(adder, {make_integer(4)})) == 7,
+          "compiled inner lambda should capture the enclosing local");
+
+    value unsupported_load = eval_text("(lambda (path) (load path))", env);
+    check(!closure_compiled(unsupported_load), "load should fall back to the evaluator");
+}
+
+void test_compiled_forms_match_evaluator() {
+    using namespace muslisp;
+
+    env_ptr env = create_global_env();
+    (void)eval_text("(define xs (list 1 2 3)) (define offset 10)", env);
+    // Each expression runs once at top level (interpreted) and once as the body of a compiled closure.
+    const std::vector<std::string> cases = {
+        "(cond ((> offset 5) 'big) (else 'small))",
+        "(cond ((memq-like) 1))",
+        "(cond (#f 1) ((+ 1 2)))",
+        "(cond (#f 1))",
+        "(cond (#f 1) (else))",
+        "`(a ,offset ,@xs b)",
+        "`(,@xs)",
+        "`(,@xs ,@nil ,@xs)",
+        "`(a `(b ,(c ,offset)))",
+        "`(1 (2 ,(+ 1 2)) ,@(list 4 5))",
+        "(let ((y 2)) (define z (* y offset)) (list y z))",
+        "(let ((a 1) (a 2)) a)",
+        "(let () (define n 5) (define (sum k acc) (if (= k 0) acc (sum (- k 1) (+ acc k)))) (sum n 0))",
+        "((lambda (x) ((lambda (y) ((lambda (z) (list x y z offset)) 3)) 2)) 1)",
+        "(let ((make (lambda (k) (lambda (v) (+ k v))))) (list ((make 1) 10) ((make 2) 10)))",
+    };
+    (void)eval_text("(define (memq-like) #f)", env);
+    for (const std::string& expr : cases) {
+        const std::string interpreted = print_value(eval_text(expr, env));
+        value fn = eval_text("(lambda () " + expr + ")", env);
+        check(static_cast<bool>(closure_compiled(fn)), "form should compile: " + expr);
+        const std::string compiled = print_value(invoke_callable(fn, {}));
+        check(compiled == interpreted, "compiled result mismatch for " + expr + ": " + compiled + " vs " + interpreted);
+    }
+
+    bool splice_error = false;
+    try {
+        (void)invoke_callable(eval_text("(lambda () `(a ,@offset))", env), {});
+    } catch (const lisp_error&) {
+        splice_error = true;
+    }
+    check(splice_error, "splicing a non-list should still fail");
+
+    // A define that an earlier lambda could observe stays interpreted, with the reason reported.
+    value observed = eval_text(
+        "(lambda () (define get (lambda () offset)) (define before (get)) (define offset 100) (list before (get)))",
+        env);
+    check(!closure_compiled(observed), "define after a lambda that refers to the name should not compile");
+    check(print_value(invoke_callable(observed, {})) == "(10 100)", "interpreted fallback should see the define");
+    (void)eval_text(
+        "(define info (closure.compile-info (lambda () (define get (lambda () offset)) (define offset 1) (get))))",
+        env);
+    check(print_value(eval_text("(map.get info 'compiled 1)", env)) == "#f", "closure.compile-info should report a fallback");
+    check(string_value(eval_text("(map.get info 'reason nil)", env)).find("offset") != std::string::npos,
+          "closure.compile-info should name the define");
+    check(integer_value(eval_text(
+              "(map.get (closure.compile-info (lambda (x) (let ((f (lambda (y) y))) (f x)))) 'nested_lambdas 0)",
+              env)) == 1,
+          "closure.compile-info should count nested lambdas");
+}
+
+void test_compiled_call_site_caches() {
+    using namespace muslisp;
 
-    value unsupported_nested = eval_text("(lambda (x) (lambda (y) (+ x y)))", env);
-    check(is_closure(unsupported_nested), "unsupported nested-lambda test should produce a closure");
-    check(!closure_compiled(unsupported_nested), "nested lambda should currently fall back to the evaluator");
+    env_ptr env = create_global_env();
+    check(primitive_span_function(eval_text("+", env)) != nullptr, "arithmetic should use the span calling convention");
+    check(primitive_span_function(eval_text("print", env)) == nullptr, "other builtins keep the vector convention");
+
+    value site = eval_text("(begin (define (callee x) (+ x 1)) (define (site x) (callee x)) site)", env);
+    check(static_cast<bool>(closure_compiled(site)), "call site closure should compile");
+    check(integer_value(invoke_callable(site, {make_integer(1)})) == 2, "cached compiled closure call mismatch");
+    check(integer_value(invoke_callable(site, {make_integer(2)})) == 3, "cache hit should call the same closure");
+
+    // Rebinding the callee swaps its kind; each call site must re-dispatch.
+    (void)eval_text("(define callee car)", env);
+    check(integer_value(eval_text("(site (list 7 8))", env)) == 7, "call site should re-dispatch to a span primitive");
+    (void)eval_text("(define callee sqrt)", env);
+    check(print_value(eval_text("(site 16)", env)) == "4.0", "call site should re-dispatch to a vector primitive");
+    (void)eval_text("(define callee (lambda (x) `(,x)))", env);
+    check(print_value(eval_text("(site 4)", env)) == "(4)", "call site should re-dispatch to an interpreted closure");
+
+    // Tail calls through the cache bounce without growing the host stack, and keep their arguments live.
+    value loop = eval_text(
+        "(begin "
+        "  (define (loop-vm n acc) (if (= n 0) acc (loop-vm (- n 1) (cons n acc)))) "
+        "  loop-vm)",
+        env);
+    value built = invoke_callable(loop, {make_integer(20000), make_nil()});
+    check(print_value(eval_text("(car (loop-vm 20000 nil))", env)) == "1" && is_cons(built),
+          "tail calls should keep bounce arguments across collections");
+    check(print_value(eval_text("(list (< 1 2 3) (* 2 3.5) (- 5) (cons 1 2))", env)) == "(#t 7.0 -5 (1 . 2))",
+          "span primitives should keep their variadic semantics");
 }
 
 void test_tail_call_optimisation_and_or() {
@@ -725,6 +899,136 @@ void test_gc_env_root_stack_regression() {
           "global env root should survive repeated begin evaluation after collection");
 }
 
+void test_gc_minor_collections_respect_write_barrier() {
+    using namespace muslisp;
+
+    env_ptr env = create_global_env();
+    (void)eval_text("(define cfg (map.make)) (define slots (vec.make 1)) (vec.push! slots 0)", env);
+    default_gc().collect();
+
+    const std::uint64_t minors_before = default_gc().stats().minor_collection_count;
+    (void)eval_text(
+        "(define (churn n) "
+        "  (if (= n 0) "
+        "      0 "
+        "      (begin (map.set! cfg 'k (list n n n)) (vec.set! slots 0 (list n)) (churn (- n 1)))))",
+        env);
+    (void)eval_text("(churn 6000)", env);
+    (void)eval_text("(define late (list 4 5 6))", env);
+    (void)eval_text("(churn 3000)", env);
+
+    check(default_gc().stats().minor_collection_count > minors_before, "churn should trigger minor collections");
+    check(print_value(eval_text("(map.get cfg 'k nil)", env)) == "(1 1 1)",
+          "young values stored in an old map should survive minor collections");
+    check(print_value(eval_text("(vec.get slots 0)", env)) == "(1)",
+          "young values stored in an old vec should survive minor collections");
+    check(print_value(eval_text("late", env)) == "(4 5 6)",
+          "young values bound in an old env should survive minor collections");
+
+    default_gc().collect();
+    check(default_gc().stats().young_objects == 0 && default_gc().stats().remembered_set_size == 0,
+          "a full collection should empty the nursery and remembered set");
+}
+
+void test_immediate_numbers_round_trip_without_allocating() {
+    using namespace muslisp;
+
+    const std::int64_t ints[] = {0, -1, 42, kFixnumMin, kFixnumMax, kFixnumMax + 1,
+                                 std::numeric_limits<std::int64_t>::min()};
+    for (std::int64_t n : ints) {
+        const value v = make_integer(n);
+        check(is_integer(v) && !is_float(v) && integer_value(v) == n, "integer should round-trip");
+        check(is_immediate(v) == (n >= kFixnumMin && n <= kFixnumMax), "only fixnum-range integers are immediate");
+    }
+
+    const double floats[] = {0.0, -0.0, 1.5, -2.25, 1e-300, 1e300, 5e-324, 3.0e-77,
+                             std::numeric_limits<double>::infinity(), std::numeric_limits<double>::quiet_NaN()};
+    for (double d : floats) {
+        const value v = make_float(d);
+        check(is_float(v) && type_of(v) == value_type::floating, "float should keep its type");
+        check(std::bit_cast<std::uint64_t>(float_value(v)) == std::bit_cast<std::uint64_t>(d),
+              "float should round-trip bit-exactly");
+    }
+    check(is_immediate(make_float(1.5)) && is_immediate(make_float(0.0)), "common doubles should be immediate");
+    check(!is_immediate(make_float(1e300)), "out-of-range doubles should be boxed");
+
+    env_ptr env = create_global_env();
+    (void)eval_text("(define (score n acc) (if (= n 0) acc (score (- n 1) (+ acc (* 0.5 n)))))", env);
+    const std::size_t allocated_before = default_gc().stats().total_allocated_objects;
+    check(float_value(eval_text("(score 2000 0.0)", env)) == 1000500.0, "float scoring loop result mismatch");
+    check(default_gc().stats().total_allocated_objects - allocated_before < 100,
+          "numeric loops should not allocate per arithmetic result");
+}
+
+void test_gc_pools_recycle_swept_cells() {
+    using namespace muslisp;
+
+    static_assert(sizeof(object) <= 128, "scalar and cons cells should stay small");
+    check(make_cons(make_integer(1), make_nil())->payload == nullptr, "cons cells should not carry a payload");
+    check(make_vec(4)->payload != nullptr, "vec cells should carry an out-of-line payload");
+
+    env_ptr env = create_global_env();
+    default_gc().collect();
+    (void)eval_text("(define (garbage n) (if (= n 0) 0 (begin (list n n n n) (garbage (- n 1)))))", env);
+    (void)eval_text("(garbage 4000)", env);
+    default_gc().collect();
+    const gc_stats_snapshot warmed = default_gc().stats();
+    check(warmed.pool_reserved_bytes > 0 && warmed.pool_free_cells > 0, "swept cells should return to the pools");
+
+    (void)eval_text("(garbage 4000)", env);
+    default_gc().collect();
+    check(default_gc().stats().pool_reserved_bytes == warmed.pool_reserved_bytes,
+          "steady-state churn should reuse pooled cells instead of reserving new slabs");
+}
+
+void test_gc_incremental_policy_runs_in_slices() {
+    using namespace muslisp;
+
+    env_ptr env = create_global_env();
+    (void)eval_text("(define slots (vec.make 1)) (vec.push! slots 0)", env);
+    (void)eval_text("(define (build n acc) (if (= n 0) acc (build (- n 1) (cons n acc))))", env);
+    default_gc().collect();
+
+    std::vector<gc_lifecycle_event> ends;
+    default_gc().set_lifecycle_listener([&ends](const gc_lifecycle_event& event) {
+        if (!event.begin && event.incremental) {
+            ends.push_back(event);
+        }
+    });
+    default_gc().set_policy(gc_policy::incremental);
+    default_gc().set_incremental_slice_budget(std::chrono::nanoseconds(0));
+
+    for (int i = 0; i < 8 && ends.empty(); ++i) {
+        (void)eval_text("(define big (build 3000 nil))", env);
+        (void)eval_text("(vec.set! slots 0 (list 7 8 9))", env);
+    }
+    if (default_gc().incremental_cycle_active()) {
+        const std::uint64_t slices_before = default_gc().stats().incremental_slice_count;
+        {
+            gc_tick_scope overran(default_gc());
+            overran.set_slack(std::chrono::nanoseconds(0));
+        }
+        check(default_gc().stats().incremental_slice_count == slices_before,
+              "an overrun tick should not run incremental GC work");
+    }
+    while (default_gc().step(std::chrono::nanoseconds(0))) {
+        (void)eval_text("(vec.set! slots 0 (list 7 8 9))", env);
+    }
+
+    default_gc().clear_lifecycle_listener();
+    default_gc().set_policy(gc_policy::default_policy);
+    default_gc().set_incremental_slice_budget(std::chrono::milliseconds(1));
+
+    check(!ends.empty(), "old-generation pressure should start an incremental cycle");
+    check(ends.front().slice_count > 1 && ends.front().freed_objects > 0,
+          "an incremental cycle should free garbage over several slices");
+    check(print_value(eval_text("(vec.get slots 0)", env)) == "(7 8 9)",
+          "values stored while an incremental cycle marks should survive");
+    (void)eval_text("(define (count xs n) (if (null? xs) n (count (cdr xs) (+ n 1))))", env);
+    check(integer_value(eval_text("(count big 0)", env)) == 3000, "live data should survive incremental cycles");
+    default_gc().collect();
+}
+
 void test_gc_duplicate_env_roots_are_stack_like() {
     using namespace muslisp;
 
@@ -864,6 +1168,47 @@ void test_load_write_save_and_roundtrip() {
     }
 }
 
+void test_printer_streams_large_structures() {
+    using namespace muslisp;
+
+    env_ptr env = create_global_env();
+    gc_root_scope roots(default_gc());
+
+    // A long list of mixed atoms and nested lists, longer than one streaming flush.
+    value big = eval_text("(begin (define (build i acc) (if (= i 0) acc "
+                          "(build (- i 1) (cons (list i (* i 0.25) \"q\\\"x\\ty\" 'sym (list 1e21 -0.0)) acc)))) "
+                          "(build 20000 (cons 1.5 2)))",
+                          env);
+    roots.add(&big);
+    const std::string text = write_value(big);
+    check(text.size() > 2 * 64 * 1024, "test structure should span several flushes");
+    check(text.starts_with("((1 0.25 \"q\\\"x\\ty\" sym (1e+21 -0.0)) (2 0.5 "),
+          "printer output prefix mismatch: " + text.substr(0, 60));
+    check(text.ends_with(" 1.5 . 2)"), "improper tails should print after the last element");
+
+    std::ostringstream streamed;
+    write_value(streamed, big);
+    check(streamed.str() == text, "streamed write_value should match the string form");
+    std::ostringstream printed;
+    print_value(printed, big);
+    check(printed.str() == print_value(big), "streamed print_value should match the string form");
+
+    check(print_value(read_one(text)) == print_value(big), "written text should read back to the same structure");
+    check(print_value(eval_text("(list 100.0 0.1 1e-7 123456789012345678.0 (/ 1.0 3))", env)) ==
+              "(100.0 0.1 1e-07 1.23456789012346e+17 0.333333333333333)",
+          "float formatting should match %.15g with a .0 suffix for integral values");
+    check(print_value(eval_text("(cons 1 2)", env)) == "(1 . 2)", "dotted pairs should print");
+
+    std::ostringstream rejected;
+    bool threw = false;
+    try {
+        write_value(rejected, eval_text("(list 1 (vec.make))", env));
+    } catch (const lisp_error& e) {
+        threw = std::string(e.what()) == "write: cannot serialise vec as readable data";
+    }
+    check(threw, "streamed write_value should reject unreadable values");
+}
+
 void test_load_resolves_nested_relative_paths_from_loaded_file() {
     using namespace muslisp;
 
@@ -913,6 +1258,113 @@ void test_bt_dsl_save_load_roundtrip() {
     (void)eval_text("(define tree3 (bt.load-dsl " + dsl_path_lisp + "))", env);
     (void)eval_text("(define inst3 (bt.new-instance tree3))", env);
     check(symbol_name(eval_text("(bt.tick inst3)", env)) == "success", "bt.load-dsl tree tick should succeed");
+
+    // Unchanged text hits the parse cache and returns the stored definition; edited text recompiles.
+    check(print_value(eval_text("(bt.load-dsl " + dsl_path_lisp + ")", env)) == print_value(eval_text("tree3", env)),
+          "bt.load-dsl of unchanged text should reuse the cached definition");
+    {
+        std::ofstream out(dsl_path, std::ios::trunc);
+        out << "(seq (act bb-put-int foo 7) (cond bb-has foo))";
+    }
+    (void)eval_text("(define tree4 (bt.load-dsl " + dsl_path_lisp + "))", env);
+    check(print_value(eval_text("tree4", env)) != print_value(eval_text("tree3", env)),
+          "bt.load-dsl of edited text should compile a new definition");
+    check(print_value(eval_text("(bt.to-dsl tree4)", env)) == "(seq (act bb-put-int foo 7) (cond bb-has foo))",
+          "recompiled definition should reflect the edited text");
+}
+
+void test_bt_load_dsl_files_compiles_in_parallel() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
+
+    std::vector<std::filesystem::path> paths;
+    std::string path_list = "(list";
+    for (int i = 0; i < 6; ++i) {
+        paths.push_back(temp_file_path("dsl_files_" + std::to_string(i)));
+        std::ofstream out(paths.back(), std::ios::trunc);
+        out << "(seq (act bb-put-int foo " << i << ") (cond bb-has foo))";
+        path_list.append(" ").append(lisp_string_literal(paths.back().string()));
+    }
+    path_list += ")";
+
+    (void)eval_text("(define single (bt.load-dsl " + lisp_string_literal(paths[2].string()) + "))", env);
+    const value defs = eval_text("(bt.load-dsl-files " + path_list + " 3)", env);
+    check(is_proper_list(defs) && vector_from_list(defs).size() == paths.size(),
+          "bt.load-dsl-files should return one definition per file");
+    check(print_value(vector_from_list(defs)[2]) == print_value(eval_text("single", env)),
+          "bt.load-dsl-files should reuse definitions bt.load-dsl already stored");
+    const bt::definition* last = bt::default_runtime_host().find_definition(bt_handle(vector_from_list(defs)[5]));
+    check(last != nullptr && bt::write_canonical_dsl(*last) == "(seq (act bb-put-int foo 5) (cond bb-has foo))",
+          "definitions should come back in path order");
+    (void)eval_text("(define inst (bt.new-instance (car (bt.load-dsl-files " + path_list + "))))", env);
+    check(symbol_name(eval_text("(bt.tick inst)", env)) == "success", "a file-loaded tree should tick");
+    check(print_value(eval_text("(bt.load-dsl " + lisp_string_literal(paths[4].string()) + ")", env)) ==
+              print_value(vector_from_list(defs)[4]),
+          "bt.load-dsl should hit the definitions bt.load-dsl-files cached");
+
+    const auto bad = temp_file_path("dsl_files_bad");
+    {
+        std::ofstream out(bad, std::ios::trunc);
+        out << "(seq (bogus-node))";
+    }
+    const std::size_t stored = bt::default_runtime_host().memory_report().definition_count;
+    const std::string with_bad = "(list " + lisp_string_literal(paths[0].string()) + " " +
+                                 lisp_string_literal(bad.string()) + ")";
+    try {
+        (void)eval_text("(bt.load-dsl-files " + with_bad + ")", env);
+        throw std::runtime_error("expected bt.load-dsl-files to fail on a bad file");
+    } catch (const lisp_error& e) {
+        check(std::string(e.what()).rfind("bt.load-dsl-files: " + bad.string() + ": ", 0) == 0,
+              "bt.load-dsl-files should name the file that failed");
+    }
+    check(bt::default_runtime_host().memory_report().definition_count == stored,
+          "a failed bt.load-dsl-files should store nothing");
+    expect_lisp_error_message("(bt.load-dsl-files (list 1))", env, "bt.load-dsl-files: expected file path string",
+                              "bt.load-dsl-files path type");
+    expect_lisp_error_message("(bt.load-dsl-files (list) 0)", env, "bt.load-dsl-files: expected positive worker count",
+                              "bt.load-dsl-files worker count");
+
+    for (const auto& path : paths) {
+        std::filesystem::remove(path);
+    }
+    std::filesystem::remove(bad);
+}
+
+void test_bt_compile_shares_structurally_identical_definitions() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
+
+    (void)eval_text("(define a (bt.compile '(sel (seq (cond bb-has foo) (act bb-put-int foo 1)) (succeed))))", env);
+    (void)eval_text("(define b (bt.compile '(sel   (seq (cond bb-has foo) (act bb-put-int foo 1))  (succeed))))", env);
+    (void)eval_text("(define c (bt.compile '(sel (seq (cond bb-has foo) (act bb-put-int foo 2)) (succeed))))", env);
+    check(bt_handle(eval_text("a", env)) == bt_handle(eval_text("b", env)),
+          "bt.compile of an identical tree should return the stored definition");
+    check(bt_handle(eval_text("a", env)) != bt_handle(eval_text("c", env)),
+          "bt.compile of a different tree should store a new definition");
+
+    bt::runtime_host& host = bt::default_runtime_host();
+    const bt::definition* def_a = host.find_definition(bt_handle(eval_text("a", env)));
+    check(def_a && def_a->canonical_dsl.empty(), "bt.compile should leave the canonical DSL for first use");
+    bt::ensure_canonical_dsl(*def_a);
+    check(def_a->canonical_dsl == string_value(eval_text("(write-to-string (bt.to-dsl a))", env)) &&
+              def_a->canonical_dsl_hash == bt::event_log::hash64_hex(def_a->canonical_dsl),
+          "ensure_canonical_dsl should fill the canonical DSL and its hash");
+
+    (void)eval_text("(define inst-a (bt.new-instance a))", env);
+    (void)eval_text("(define inst-b (bt.new-instance b))", env);
+    const bt::instance* inst_a = host.find_instance(bt_handle(eval_text("inst-a", env)));
+    const bt::instance* inst_b = host.find_instance(bt_handle(eval_text("inst-b", env)));
+    check(inst_a && inst_b && inst_a->def == inst_b->def, "instances of a shared definition should share node storage");
+    check(symbol_name(eval_text("(bt.tick inst-a)", env)) == "success", "shared definition should tick");
+
+    // `bt` forms carry no canonical DSL and are always stored separately.
+    (void)eval_text("(define d (bt (succeed)))", env);
+    (void)eval_text("(define e (bt (succeed)))", env);
+    check(bt_handle(eval_text("d", env)) != bt_handle(eval_text("e", env)), "bt forms should not be interned");
 }
 
 void test_bt_dsl_roundtrip_representative_shapes() {
@@ -961,6 +1413,11 @@ void test_bt_dsl_roundtrip_representative_shapes() {
             "  (vla-cancel :name \"policy\" :job_key policy-job))",
             {"vla-request", "vla-wait", "vla-cancel"},
         },
+        {
+            "leaf-atoms",
+            "(retry 2 (seq (act bb-put-float speed 2.0 -0.25 1e+20) (cond bb-has #t #f nil 7 \"q\\\"t\\tx\")))",
+            {"retry 2", "2.0", "-0.25", "#f nil 7"},
+        },
     };
 
     std::size_t pass_count = 0;
@@ -976,6 +1433,9 @@ void test_bt_dsl_roundtrip_representative_shapes() {
             check(canonical.find(fragment) != std::string::npos,
                   tc.name + ": canonical DSL missing fragment: " + fragment + " in " + canonical);
         }
+        const bt::definition* def = bt::default_runtime_host().find_definition(bt_handle(eval_text("tree", env)));
+        check(def && bt::write_canonical_dsl(*def) == canonical,
+              tc.name + ": lazily written canonical DSL should match bt.to-dsl: " + canonical);
 
         (void)eval_text("(define tree-from-canonical (bt.compile (bt.to-dsl tree)))", env);
         const std::string canonical_again =
@@ -1111,10 +1571,10 @@ void test_bt_binary_save_load_roundtrip_and_validation() {
     } catch (const lisp_error&) {
     }
 
-    const auto unsupported_arg_path = temp_file_path("unsupported_arg", ".mbt");
-    {
-        std::ofstream out(unsupported_arg_path, std::ios::binary);
-        check(static_cast<bool>(out), "failed to open unsupported_arg test file");
+    // Hand-written legacy (version 1) stream: one act node, optionally with an unsupported arg kind.
+    auto write_v1_stream = [](const std::filesystem::path& path, bool unsupported_arg) {
+        std::ofstream out(path, std::ios::binary);
+        check(static_cast<bool>(out), "failed to open v1 stream test file");
 
         auto write_u8 = [&](std::uint8_t v) { out.put(static_cast<char>(v)); };
         auto write_u32 = [&](std::uint32_t v) {
@@ -1148,10 +1608,22 @@ void test_bt_binary_save_load_roundtrip_and_validation() {
         write_u64(0);         // int_param
         write_u32(0);         // children
         write_str("always-success");
-        write_u32(1);         // arg count
-        write_u8(99);         // unsupported arg kind
-    }
+        if (unsupported_arg) {
+            write_u32(1);     // arg count
+            write_u8(99);     // unsupported arg kind
+        } else {
+            write_u32(0);     // arg count
+        }
+    };
 
+    const auto legacy_path = temp_file_path("legacy_stream", ".mbt");
+    write_v1_stream(legacy_path, false);
+    (void)eval_text("(define legacy (bt.load " + lisp_string_literal(legacy_path.string()) + "))", env);
+    check(symbol_name(eval_text("(bt.tick (bt.new-instance legacy))", env)) == "success",
+          "bt.load should still read version 1 streams");
+
+    const auto unsupported_arg_path = temp_file_path("unsupported_arg", ".mbt");
+    write_v1_stream(unsupported_arg_path, true);
     try {
         (void)eval_text("(bt.load " + lisp_string_literal(unsupported_arg_path.string()) + ")", env);
         throw std::runtime_error("expected bt.load unsupported-arg failure");
@@ -1159,574 +1631,2695 @@ void test_bt_binary_save_load_roundtrip_and_validation() {
     }
 }
 
-void test_list_and_predicate_builtins() {
+void test_bt_leaf_bindings_follow_registry_generation() {
     using namespace muslisp;
 
+    reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
     env_ptr env = create_global_env();
 
-    const auto second = eval_text("(car (cdr (list 1 2 3)))", env);
-    check(integer_value(second) == 2, "car/cdr/list failed");
+    (void)eval_text("(define tree (bt (seq (cond test-probe) (act test-step))))", env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    const bt::instance* inst = host.find_instance(bt_handle(eval_text("inst", env)));
+    check(inst && inst->leaf_bindings_generation == host.callbacks().generation(),
+          "bt.new-instance should link leaves against the host registry");
+    check(symbol_name(eval_text("(bt.tick inst)", env)) == "failure", "unregistered condition should fail");
+
+    int steps = 0;
+    const std::uint64_t before = host.callbacks().generation();
+    host.callbacks().register_condition("test-probe", [](bt::tick_context&, std::span<const value>) { return true; });
+    host.callbacks().register_action(
+        "test-step", [&steps](bt::tick_context&, bt::node_id, bt::node_memory&, std::span<const value>) {
+            ++steps;
+            return bt::status::success;
+        });
+    check(host.callbacks().generation() != before, "registration should advance the registry generation");
+    check(symbol_name(eval_text("(bt.tick inst)", env)) == "success", "tick should relink newly registered leaves");
+    check(steps == 1 && inst->leaf_bindings_generation == host.callbacks().generation(),
+          "relinked action should run through its bound index");
+
+    host.callbacks().register_condition("test-probe", [](bt::tick_context&, std::span<const value>) { return false; });
+    check(symbol_name(eval_text("(bt.tick inst)", env)) == "failure", "re-registration should replace the bound callback");
+    check(steps == 1, "action should not run after the replaced condition fails");
+    check(host.callbacks().condition_index("test-probe") != bt::registry::k_unbound &&
+              host.callbacks().action_index("missing-leaf") == bt::registry::k_unbound,
+          "registry should expose callback indices by name");
+}
 
-    const auto null_true = eval_text("(null? (cdr (list 1)))", env);
-    check(boolean_value(null_true), "null? expected true");
+void test_bt_native_leaf_callbacks_decode_args_at_link_time() {
+    using namespace muslisp;
 
-    const auto eq_symbol = eval_text("(eq? 'a 'a)", env);
-    check(boolean_value(eq_symbol), "eq? symbol interning behavior failed");
+    reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
+    env_ptr env = create_global_env();
 
-    const auto eq_int = eval_text("(eq? 4 4)", env);
-    check(boolean_value(eq_int), "eq? integer equality failed");
+    std::int64_t seen_int = 0;
+    double seen_float = 0.0;
+    std::string seen_text;
+    host.callbacks().register_native_condition(
+        "test-native-check",
+        [&](bt::tick_context&, std::int64_t limit, double scale, std::string_view tag) {
+            seen_int = limit;
+            seen_float = scale;
+            seen_text = std::string(tag);
+            return limit > 0;
+        });
+    int steps = 0;
+    host.callbacks().register_native_action(
+        "test-native-step", [&steps](bt::tick_context&, bt::node_id, bt::node_memory& mem, bool finish) mutable {
+            ++steps;
+            ++mem.i0;
+            return finish ? bt::status::success : bt::status::running;
+        });
+    check(host.callbacks().find_condition("test-native-check") == nullptr,
+          "find_condition should only return span-based callbacks");
 
-    const auto eq_list = eval_text("(eq? (list 1) (list 1))", env);
-    check(!boolean_value(eq_list), "eq? list pointer equality failed");
+    (void)eval_text("(define tree (bt (seq (cond test-native-check 3 2 \"front\") (act test-native-step #t))))", env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    check(symbol_name(eval_text("(bt.tick inst)", env)) == "success", "native leaves should tick");
+    check(seen_int == 3 && seen_float == 2.0 && seen_text == "front",
+          "native condition should receive decoded args, widening integers to double");
+    check(steps == 1, "native action should run once");
+
+    (void)eval_text("(define bad (bt (cond test-native-check \"three\" 2 \"front\")))", env);
+    (void)eval_text("(define bad-inst (bt.new-instance bad))", env);
+    seen_int = 0;
+    check(symbol_name(eval_text("(bt.tick bad-inst)", env)) == "failure", "mismatched native args should fail the leaf");
+    check(seen_int == 0, "mismatched native args should not reach the callback");
 }
 
-void test_gc_and_stats_builtins() {
+void test_bt_incremental_tick_skips_unchanged_guards() {
     using namespace muslisp;
 
+    reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
     env_ptr env = create_global_env();
-    default_gc().set_policy(gc_policy::default_policy);
 
-    for (int i = 0; i < 2000; ++i) {
-        (void)eval_text("(list 1 2 3 4 5 6 7 8 9 10)", env);
-    }
+    int guard_calls = 0;
+    host.callbacks().register_native_condition(
+        "test-guard",
+        [&guard_calls](bt::tick_context& ctx, std::string_view key) {
+            ++guard_calls;
+            const bt::bb_entry* entry = ctx.bb_get(key);
+            return entry && std::holds_alternative<bool>(entry->value) && std::get<bool>(entry->value);
+        },
+        bt::condition_reads{.key_args = {0}, .keys = {}});
 
-    default_gc().collect();
-    const gc_stats_snapshot stats = default_gc().stats();
+    (void)eval_text(
+        "(define tree (bt (reactive-seq (seq (cond test-guard armed) (invert (cond test-guard alarm))) (running))))",
+        env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    (void)eval_text("(bt.set-incremental-tick inst #t)", env);
+    bt::instance* inst = host.find_instance(bt_handle(eval_text("inst", env)));
+    check(inst != nullptr, "incremental test instance should exist");
+    const auto now = std::chrono::steady_clock::now();
+    inst->bb.put("armed", bt::bb_value{true}, 0, now, 0, "test");
 
-    check(stats.total_allocated_objects > 0, "gc stats should report allocated objects");
-    check(stats.live_objects_after_last_gc > 0, "gc stats should report live objects");
-    check(stats.total_allocated_objects >= stats.live_objects_after_last_gc,
-          "total allocated should be >= live after last gc");
-    check(stats.next_gc_threshold >= stats.live_objects_after_last_gc,
-          "next gc threshold should be >= live after last gc");
+    check(symbol_name(eval_text("(bt.tick inst)", env)) == "running", "guards should pass on the first tick");
+    check(guard_calls == 2, "first incremental tick should evaluate every guard");
+    check(symbol_name(eval_text("(bt.tick inst)", env)) == "running", "memoised guards should keep their result");
+    check(guard_calls == 2 && inst->tree_stats.memo_hit_count == 1, "unchanged guard subtree should be skipped");
 
-    const auto heap_stats_result = eval_text("(heap-stats)", env);
-    check(is_nil(heap_stats_result), "heap-stats should return nil");
+    inst->bb.put("unrelated", bt::bb_value{std::int64_t{1}}, 2, now, 0, "test");
+    (void)eval_text("(bt.tick inst)", env);
+    check(guard_calls == 2, "writes outside the read set should not invalidate the memo");
 
-    const auto gc_stats_result = eval_text("(gc-stats)", env);
-    check(is_nil(gc_stats_result), "gc-stats should return nil");
+    inst->bb.put("alarm", bt::bb_value{true}, 2, now, 0, "test");
+    check(symbol_name(eval_text("(bt.tick inst)", env)) == "failure", "a write to a read key should re-evaluate guards");
+    check(guard_calls == 3, "re-evaluation should only re-run the guard whose key changed");
 
-    check(symbol_name(eval_text("(gc.policy)", env)) == ":default", "gc.policy default mismatch");
-    check(symbol_name(eval_text("(gc.set-policy! \"between-ticks\")", env)) == ":between-ticks",
-          "gc.set-policy! between-ticks mismatch");
-    check(default_gc().policy() == gc_policy::between_ticks, "C++ GC policy should be between-ticks");
-    check(symbol_name(eval_text("(gc.set-policy! \"manual\")", env)) == ":manual", "gc.set-policy! manual mismatch");
-    check(default_gc().policy() == gc_policy::manual, "C++ GC policy should be manual");
-    check(symbol_name(eval_text("(gc.set-policy! \"fail-on-tick-gc\")", env)) == ":fail-on-tick-gc",
-          "gc.set-policy! fail-on-tick-gc mismatch");
-    check(default_gc().policy() == gc_policy::fail_on_tick_gc, "C++ GC policy should be fail-on-tick-gc");
-    expect_lisp_error_message("(gc.set-policy! \"sometimes\")",
-                              env,
-                              "gc.set-policy!: expected :default, :between-ticks, :manual, or :fail-on-tick-gc",
-                              "gc.set-policy! invalid policy");
-    (void)eval_text("(gc.set-policy! \"default\")", env);
-    check(default_gc().policy() == gc_policy::default_policy, "GC policy should reset to default");
+    (void)eval_text("(bt.set-incremental-tick inst #f)", env);
+    (void)eval_text("(bt.tick inst)", env);
+    (void)eval_text("(bt.tick inst)", env);
+    check(guard_calls == 7, "ticks without incremental mode should always evaluate guards");
+    expect_lisp_error_message("(bt.set-incremental-tick inst 1)", env, "bt.set-incremental-tick: expected boolean",
+                              "bt.set-incremental-tick type");
 }
 
-void test_gc_lifecycle_events() {
+void test_bt_tick_on_demand_wakes_on_read_keys_jobs_and_timer() {
     using namespace muslisp;
 
+    reset_bt_runtime_host();
     bt::runtime_host& host = bt::default_runtime_host();
-    host.events().set_enabled(true);
-    host.events().set_ring_capacity(64);
-    host.events().clear_ring();
-    default_gc().set_policy(gc_policy::default_policy);
+    env_ptr env = create_global_env();
 
-    default_gc().collect();
+    int guard_calls = 0;
+    host.callbacks().register_native_condition(
+        "test-wake-guard",
+        [&guard_calls](bt::tick_context& ctx, std::string_view key) {
+            ++guard_calls;
+            const bt::bb_entry* entry = ctx.bb_get(key);
+            return entry && std::holds_alternative<bool>(entry->value) && std::get<bool>(entry->value);
+        },
+        bt::condition_reads{.key_args = {0}, .keys = {}});
 
-    const std::vector<std::string> lines = host.events().snapshot();
-    bool saw_begin = false;
-    bool saw_end = false;
-    bool saw_schema = false;
-    bool saw_forced = false;
-    for (const std::string& line : lines) {
-        saw_begin = saw_begin || line.find("\"type\":\"gc_begin\"") != std::string::npos;
-        saw_end = saw_end || line.find("\"type\":\"gc_end\"") != std::string::npos;
-        saw_schema = saw_schema || line.find("\"schema_version\":\"gc.lifecycle.v1\"") != std::string::npos;
-        saw_forced = saw_forced || line.find("\"reason\":\"forced\"") != std::string::npos;
-    }
-    check(saw_begin, "GC lifecycle should emit gc_begin");
-    check(saw_end, "GC lifecycle should emit gc_end");
-    check(saw_schema, "GC lifecycle should emit gc.lifecycle.v1 payload");
-    check(saw_forced, "GC lifecycle should record forced collection reason");
+    (void)eval_text("(define tree (bt (reactive-seq (cond test-wake-guard armed) (running))))", env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    (void)eval_text("(bt.set-tick-on-demand inst #t)", env);
+    bt::instance* inst = host.find_instance(bt_handle(eval_text("inst", env)));
+    check(inst != nullptr, "on-demand test instance should exist");
+    const auto now = std::chrono::steady_clock::now();
+
+    check(symbol_name(eval_text("(bt.tick-if-due inst)", env)) == "failure", "the first on-demand tick should be due");
+    check(inst->wake_reads.size() == 1 && !inst->wake_on_any_write, "wake set should be the guard's declared read");
+    check(is_nil(eval_text("(bt.tick-if-due inst)", env)), "nothing changed, so no tick should be due");
+    inst->bb.put("unrelated", bt::bb_value{std::int64_t{1}}, 0, now, 0, "test");
+    check(is_nil(eval_text("(bt.tick-if-due inst)", env)), "writes outside the wake set should not wake");
+    check(guard_calls == 1, "skipped ticks should not run the tree");
+
+    inst->bb.put("armed", bt::bb_value{true}, 0, now, 0, "test");
+    check(bt::tick_due(*inst, now) == bt::wake_bits(bt::wake_reason::bb_write), "a read key change should wake");
+    check(symbol_name(eval_text("(bt.tick-if-due inst)", env)) == "running", "the woken tick should see the change");
+    inst->bb.put("armed", bt::bb_value{true}, 0, now, 0, "test");
+    check(is_nil(eval_text("(bt.tick-if-due inst)", env)), "rewriting the same value should not wake");
+    check(is_nil(eval_text("(bt.wait-for-wake inst 0)", env)), "wait-for-wake should time out with no reasons");
+    check(inst->wake_skip_count == 3, "skipped polls should be counted");
+
+    bt::completion_queue queue;
+    queue.set_waker(inst->waker);
+    std::thread pusher([&queue] { queue.push(7, 0); });
+    const value reasons = eval_text("(bt.wait-for-wake inst 5000)", env);
+    pusher.join();
+    check(is_proper_list(reasons) && vector_from_list(reasons).size() == 1 &&
+              symbol_name(vector_from_list(reasons)[0]) == "job-complete",
+          "a job completion on another thread should wake the waiter");
+    (void)eval_text("(bt.tick-if-due inst)", env);
+    check(guard_calls == 3, "a job wake should tick once");
+
+    (void)eval_text("(bt.set-tick-on-demand inst #t 1)", env);
+    (void)eval_text("(bt.tick-if-due inst)", env);
+    const value timed = eval_text("(bt.wait-for-wake inst 5000)", env);
+    check(symbol_name(vector_from_list(timed)[0]) == "timer", "max interval should wake through the timer");
+    check(bt::dump_stats(*inst).find("tick_mode=on_demand") != std::string::npos,
+          "stats should report on-demand ticking");
+
+    (void)eval_text("(bt.set-tick-on-demand inst #f)", env);
+    check(!inst->bb.watched(inst->bb.find_slot("armed")), "turning on-demand off should drop the watch");
+    check(symbol_name(eval_text("(bt.tick-if-due inst)", env)) == "running", "fixed-rate ticks should always be due");
+    expect_lisp_error_message("(bt.set-tick-on-demand inst 1)", env, "bt.set-tick-on-demand: expected boolean",
+                              "bt.set-tick-on-demand type");
+
+    // A leaf running without a watched job has nothing to wake it, so it is polled on every call.
+    int poll_steps = 0;
+    host.callbacks().register_action(
+        "test-wake-poll", [&poll_steps](bt::tick_context&, bt::node_id, bt::node_memory&, std::span<const value>) {
+            return ++poll_steps < 3 ? bt::status::running : bt::status::success;
+        });
+    (void)eval_text("(define polled (bt.new-instance (bt (act test-wake-poll))))", env);
+    (void)eval_text("(bt.set-tick-on-demand polled #t)", env);
+    bt::instance* polled = host.find_instance(bt_handle(eval_text("polled", env)));
+    check(symbol_name(eval_text("(bt.tick-if-due polled)", env)) == "running", "the first poll tick should run");
+    check(bt::tick_due(*polled, std::chrono::steady_clock::now()) == bt::wake_bits(bt::wake_reason::running),
+          "an unwatched running leaf should keep the instance due");
+    check(symbol_name(eval_text("(bt.tick-if-due polled)", env)) == "running" &&
+              symbol_name(eval_text("(bt.tick-if-due polled)", env)) == "success",
+          "an on-demand instance without a timer should not stall on an unwatched running leaf");
+    check(is_nil(eval_text("(bt.tick-if-due polled)", env)), "a finished tree should stop polling");
+    check(bt::dump_stats(*polled).find("wake_running_count=2") != std::string::npos,
+          "stats should count the polled ticks");
 }
 
-void test_gc_during_argument_evaluation() {
+void test_bt_memory_report_accounts_instances() {
     using namespace muslisp;
 
+    reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
     env_ptr env = create_global_env();
-    default_gc().set_policy(gc_policy::default_policy);
 
-    // Calling gc-stats while evaluating later arguments must not invalidate earlier values.
-    value out = eval_text("(begin (define x (list 1 2 3)) (list x (gc-stats) x))", env);
-    const auto items = vector_from_list(out);
-    check(items.size() == 3, "list size mismatch");
-    check(print_value(items[0]) == "(1 2 3)", "first retained value mismatch");
-    check(is_nil(items[1]), "gc-stats return value mismatch");
-    check(print_value(items[2]) == "(1 2 3)", "second retained value mismatch");
+    const bt::memory_report empty = host.memory_report();
+    check(empty.definition_count == 0 && empty.instance_count == 0 && empty.instance_state_bytes == 0,
+          "a fresh host should hold no definitions or instances");
+
+    (void)eval_text("(define tree (bt (seq (act bb-put-int foo 42) (cond bb-has foo))))", env);
+    (void)eval_text("(define a (bt.new-instance tree))", env);
+    (void)eval_text("(bt.tick a)", env);
+    const bt::memory_report one = host.memory_report();
+    check(one.definition_count == 1 && one.instance_count == 1, "report should count the definition and instance");
+    check(one.definition_bytes > 0 && one.instance_state_bytes > 0, "report should size definitions and instances");
+    check(one.blackboard_bytes > 0, "a blackboard holding a key should have a footprint");
+
+    bt::instance* inst = host.find_instance(bt_handle(eval_text("a", env)));
+    check(inst != nullptr, "memory report test instance should exist");
+    const bt::instance_footprint footprint = bt::measure_instance(*inst);
+    check(footprint.total_bytes() == one.instance_state_bytes + one.blackboard_bytes + one.trace_bytes,
+          "with one instance the report should be its footprint");
+
+    (void)eval_text("(define b (bt.new-instance tree))", env);
+    (void)eval_text("(bt.tick b)", env);
+    const bt::memory_report two = host.memory_report();
+    check(two.instance_count == 2 && two.instance_state_bytes > one.instance_state_bytes,
+          "a second instance should add its state");
+    check(two.total_bytes() > one.total_bytes(), "total should grow with instances");
+
+    const std::string text = string_value(eval_text("(bt.memory-report)", env));
+    check(text.find("instance_count=2\n") != std::string::npos && text.find("total_bytes=") != std::string::npos,
+          "bt.memory-report should format the report");
+    expect_lisp_error_message("(bt.memory-report 1)", env, "bt.memory-report: expected 0 arguments, got 1",
+                              "bt.memory-report arity");
 }
 
-void test_math_time_and_domain_errors() {
+void test_bt_tick_program_matches_recursive_interpreter() {
     using namespace muslisp;
 
+    reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
     env_ptr env = create_global_env();
 
-    value sqrt_value = eval_text("(sqrt 4)", env);
-    check(is_float(sqrt_value), "sqrt should return float");
-    check_close(float_value(sqrt_value), 2.0, 1e-12, "sqrt(4) mismatch");
+    host.callbacks().register_native_action(
+        "test-script", [](bt::tick_context&, bt::node_id, bt::node_memory& mem, std::string_view script) {
+            const char c = script[static_cast<std::size_t>(mem.i1++) % script.size()];
+            return c == 's' ? bt::status::success : (c == 'r' ? bt::status::running : bt::status::failure);
+        });
 
-    value log_value = eval_text("(log 1)", env);
-    check(is_float(log_value), "log should return float");
-    check_close(float_value(log_value), 0.0, 1e-12, "log(1) mismatch");
+    (void)eval_text(
+        "(define tree (bt (sel (seq (act test-script \"sf\") (invert (act test-script \"fsr\")))"
+        "  (mem-seq (act test-script \"rs\") (retry 1 (act test-script \"ffs\")) (repeat 2 (act test-script \"s\")))"
+        "  (mem-sel (act test-script \"f\") (act test-script \"rfs\") (succeed))"
+        "  (reactive-seq (act test-script \"s\") (running)))))",
+        env);
+    (void)eval_text("(define program-inst (bt.new-instance tree))", env);
+    (void)eval_text("(define recursive-inst (bt.new-instance tree))", env);
+    bt::instance* program_inst = host.find_instance(bt_handle(eval_text("program-inst", env)));
+    bt::instance* recursive_inst = host.find_instance(bt_handle(eval_text("recursive-inst", env)));
+    check(program_inst != nullptr && recursive_inst != nullptr, "tick program test instances should exist");
+    recursive_inst->tick_program_enabled = false;
+
+    for (int i = 0; i < 12; ++i) {
+        const std::string program_st = symbol_name(eval_text("(bt.tick program-inst)", env));
+        const std::string recursive_st = symbol_name(eval_text("(bt.tick recursive-inst)", env));
+        check(program_st == recursive_st, "tick program status should match the recursive interpreter");
+    }
+    check(program_inst->program != nullptr && recursive_inst->program == nullptr,
+          "only the enabled instance should compile a tick program");
+
+    for (std::size_t id = 0; id < program_inst->def->nodes.size(); ++id) {
+        const bt::node_profile_stats& a = program_inst->node_stats[id];
+        const bt::node_profile_stats& b = recursive_inst->node_stats[id];
+        check(a.success_returns == b.success_returns && a.failure_returns == b.failure_returns &&
+                  a.running_returns == b.running_returns,
+              "tick program node returns should match the recursive interpreter");
+        check(program_inst->memory[id].i0 == recursive_inst->memory[id].i0 &&
+                  program_inst->memory[id].b0 == recursive_inst->memory[id].b0,
+              "tick program node memory should match the recursive interpreter");
+    }
 
-    value exp_value = eval_text("(exp 0)", env);
-    check(is_float(exp_value), "exp should return float");
-    check_close(float_value(exp_value), 1.0, 1e-12, "exp(0) mismatch");
+    const std::vector<bt::trace_event> program_trace = program_inst->trace.snapshot();
+    const std::vector<bt::trace_event> recursive_trace = recursive_inst->trace.snapshot();
+    check(program_trace.size() == recursive_trace.size(), "tick program trace should have the same length");
+    for (std::size_t i = 0; i < std::min(program_trace.size(), recursive_trace.size()); ++i) {
+        check(program_trace[i].kind == recursive_trace[i].kind && program_trace[i].node == recursive_trace[i].node &&
+                  program_trace[i].node_status == recursive_trace[i].node_status,
+              "tick program trace events should match the recursive interpreter");
+    }
+}
 
-    value atan2_value = eval_text("(atan2 1 1)", env);
-    check(is_float(atan2_value), "atan2 should return float");
-    check_close(float_value(atan2_value), 0.7853981633974483, 1e-12, "atan2(1, 1) mismatch");
-
-    value abs_i = eval_text("(abs -7)", env);
-    check(is_integer(abs_i) && integer_value(abs_i) == 7, "abs over integer mismatch");
-    value abs_f = eval_text("(abs -2.5)", env);
-    check(is_float(abs_f), "abs over float should return float");
-    check_close(float_value(abs_f), 2.5, 1e-12, "abs over float mismatch");
-
-    value clamp_i = eval_text("(clamp 9 0 5)", env);
-    check(is_integer(clamp_i) && integer_value(clamp_i) == 5, "clamp int mismatch");
-    value clamp_f = eval_text("(clamp 0.2 0.3 0.9)", env);
-    check(is_float(clamp_f), "clamp float should return float");
-    check_close(float_value(clamp_f), 0.3, 1e-12, "clamp float mismatch");
+void test_bt_tick_program_dispatches_guard_selectors() {
+    using namespace muslisp;
 
-    value t1 = eval_text("(time.now-ms)", env);
-    std::this_thread::sleep_for(std::chrono::milliseconds(2));
-    value t2 = eval_text("(time.now-ms)", env);
-    check(is_integer(t1) && is_integer(t2), "time.now-ms should return integer");
-    check(integer_value(t2) >= integer_value(t1), "time.now-ms should be monotonic");
-    const auto sleep_start = std::chrono::steady_clock::now();
-    value sleep_result = eval_text("(time.sleep-ms 2)", env);
-    const auto sleep_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::steady_clock::now() - sleep_start);
-    check(is_nil(sleep_result), "time.sleep-ms should return nil");
-    check(sleep_elapsed.count() >= 1, "time.sleep-ms should block for a measurable interval");
+    reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
+    env_ptr env = create_global_env();
 
-    try {
-        (void)eval_text("(sqrt -1)", env);
-        throw std::runtime_error("expected sqrt domain error");
-    } catch (const lisp_error&) {
+    int mode_checks = 0;
+    const bt::condition_fn bb_eq = *host.callbacks().find_condition("bb-eq");
+    host.callbacks().register_condition(
+        "test-mode-is",
+        [&mode_checks, bb_eq](bt::tick_context& ctx, std::span<const muslisp::value> args) {
+            ++mode_checks;
+            return bb_eq(ctx, args);
+        },
+        bt::condition_reads{.key_args = {0}, .keys = {}, .test = bt::condition_test::bb_equals});
+
+    (void)eval_text("(define modes (bt (sel (seq (cond test-mode-is mode idle) (act bb-put-int out 1)) "
+                    "(seq (cond test-mode-is mode walk) (act bb-put-int out 2)) "
+                    "(seq (cond test-mode-is mode 3) (act bb-put-int out 3)) "
+                    "(seq (cond test-mode-is mode walk) (act bb-put-int out 4)) "
+                    "(seq (cond test-mode-is mode #t) (act bb-put-int out 5)) "
+                    "(act bb-put-int out 0))))",
+                    env);
+    (void)eval_text("(define program-inst (bt.new-instance modes))", env);
+    (void)eval_text("(define recursive-inst (bt.new-instance modes))", env);
+    bt::instance* program_inst = host.find_instance(bt_handle(eval_text("program-inst", env)));
+    bt::instance* recursive_inst = host.find_instance(bt_handle(eval_text("recursive-inst", env)));
+    recursive_inst->tick_program_enabled = false;
+
+    const std::vector<std::pair<std::string, std::int64_t>> cases = {
+        {"'walk", 2}, {"3", 3}, {"#t", 5}, {"'swim", 0}, {"\"idle\"", 1}, {"3.0", 0}, {"#f", 0}};
+    for (const auto& [mode, out] : cases) {
+        const std::string inputs = "'((mode " + (mode.starts_with("'") ? mode.substr(1) : mode) + "))";
+        mode_checks = 0;
+        (void)eval_text("(bt.tick program-inst " + inputs + ")", env);
+        const int program_checks = mode_checks;
+        (void)eval_text("(bt.tick recursive-inst " + inputs + ")", env);
+        check(integer_value(eval_text("(bt.blackboard.get program-inst 'out -1)", env)) == out &&
+                  integer_value(eval_text("(bt.blackboard.get recursive-inst 'out -1)", env)) == out,
+              "guard dispatch should pick the branch serial evaluation picks for mode " + mode);
+        check(program_checks <= 1, "guard dispatch should evaluate at most the matching guard for mode " + mode);
     }
-    try {
-        (void)eval_text("(log 0)", env);
-        throw std::runtime_error("expected log domain error");
-    } catch (const lisp_error&) {
+    check(program_inst->program != nullptr && program_inst->program->guard_tables.size() == 1u,
+          "the guard selector should compile to one dispatch table");
+
+    for (std::size_t id = 0; id < program_inst->def->nodes.size(); ++id) {
+        const bt::node_profile_stats& a = program_inst->node_stats[id];
+        const bt::node_profile_stats& b = recursive_inst->node_stats[id];
+        check(a.success_returns == b.success_returns && a.failure_returns == b.failure_returns,
+              "guard dispatch should keep every node's return counts");
     }
-    try {
-        (void)eval_text("(time.sleep-ms -1)", env);
-        throw std::runtime_error("expected time.sleep-ms domain error");
-    } catch (const lisp_error&) {
+    const std::vector<bt::trace_event> program_trace = program_inst->trace.snapshot();
+    const std::vector<bt::trace_event> recursive_trace = recursive_inst->trace.snapshot();
+    check(program_trace.size() == recursive_trace.size(), "guard dispatch trace should have the same length");
+    for (std::size_t i = 0; i < std::min(program_trace.size(), recursive_trace.size()); ++i) {
+        check(program_trace[i].kind == recursive_trace[i].kind && program_trace[i].node == recursive_trace[i].node &&
+                  program_trace[i].node_status == recursive_trace[i].node_status,
+              "guard dispatch trace events should match serial evaluation");
+    }
+
+    // Numeric thresholds: the first guard whose bound is above the value.
+    (void)eval_text("(define speeds (bt.new-instance (bt (sel (seq (cond bb-lt speed 0) (act bb-put-int band -1)) "
+                    "(seq (cond bb-lt speed 1.5) (act bb-put-int band 1)) "
+                    "(seq (cond bb-lt speed 3) (act bb-put-int band 2)) "
+                    "(seq (cond bb-lt speed 10.0) (act bb-put-int band 3))))))",
+                    env);
+    const std::vector<std::pair<std::string, std::string>> speeds = {
+        {"-2", "-1"}, {"0", "1"}, {"1.5", "2"}, {"9", "3"}, {"10.0", "-9"}, {"fast", "-9"}};
+    for (const auto& [speed, band] : speeds) {
+        (void)eval_text("(bt.tick speeds '((band -9) (speed " + speed + ")))", env);
+        check(print_value(eval_text("(bt.blackboard.get speeds 'band -9)", env)) == band,
+              "threshold dispatch should pick the right band for speed " + speed);
     }
 }
 
-void test_rng_determinism_and_ranges() {
+void test_bt_compiled_tree_matches_interpreter() {
     using namespace muslisp;
 
+    reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
     env_ptr env = create_global_env();
-    value seq = eval_text(
-        "(begin "
-        "  (define r (rng.make 42)) "
-        "  (list "
-        "    (rng.int r 1000) "
-        "    (rng.int r 1000) "
-        "    (rng.int r 1000) "
-        "    (rng.int r 1000) "
-        "    (rng.int r 1000) "
-        "    (rng.int r 1000) "
-        "    (rng.int r 1000) "
-        "    (rng.int r 1000)))",
-        env);
-    const std::vector<value> items = vector_from_list(seq);
-    const std::vector<std::int64_t> expected = {413, 291, 858, 764, 250, 62, 925, 908};
-    check(items.size() == expected.size(), "rng.int deterministic sequence size mismatch");
-    for (std::size_t i = 0; i < expected.size(); ++i) {
-        check(is_integer(items[i]), "rng.int should return integer");
-        check(integer_value(items[i]) == expected[i], "rng.int deterministic sequence mismatch");
-    }
-
-    value uniform_ok = eval_text(
-        "(begin "
-        "  (define r (rng.make 7)) "
-        "  (define (check i) "
-        "    (if (= i 0) #t "
-        "      (let ((x (rng.uniform r -1.25 3.5))) "
-        "        (if (>= x -1.25) (if (<= x 3.5) (check (- i 1)) #f) #f)))) "
-        "  (check 200))",
-        env);
-    check(is_boolean(uniform_ok) && boolean_value(uniform_ok), "rng.uniform range check failed");
+    host.events().set_enabled(true);
+    host.events().set_ring_capacity(4096);
 
-    value int_ok = eval_text(
-        "(begin "
-        "  (define r (rng.make 9)) "
-        "  (define (check i) "
-        "    (if (= i 0) #t "
-        "      (let ((x (rng.int r 17))) "
-        "        (if (>= x 0) (if (< x 17) (check (- i 1)) #f) #f)))) "
-        "  (check 200))",
-        env);
-    check(is_boolean(int_ok) && boolean_value(int_ok), "rng.int range check failed");
+    host.callbacks().register_native_action(
+        "test-script", [](bt::tick_context&, bt::node_id, bt::node_memory& mem, std::string_view script) {
+            const char c = script[static_cast<std::size_t>(mem.i1++) % script.size()];
+            return c == 's' ? bt::status::success : (c == 'r' ? bt::status::running : bt::status::failure);
+        });
 
-    value normal_repeat = eval_text(
-        "(begin "
-        "  (define r1 (rng.make 123)) "
-        "  (define r2 (rng.make 123)) "
-        "  (define a1 (rng.normal r1 0.0 1.0)) "
-        "  (define a2 (rng.normal r1 0.0 1.0)) "
-        "  (define b1 (rng.normal r2 0.0 1.0)) "
-        "  (define b2 (rng.normal r2 0.0 1.0)) "
-        "  (if (= a1 b1) (= a2 b2) #f))",
-        env);
-    check(is_boolean(normal_repeat) && boolean_value(normal_repeat), "rng.normal should be deterministic for fixed seed");
+    // Same tree as tests/fixtures/compiled_tree/mixed_composites.lisp, which the build compiles into
+    // this binary with muesli_bt_add_compiled_tree.
+    (void)eval_text("(define tree (bt (sel (seq (cond bb-eq mode idle) (act test-script \"sf\"))"
+                    "  (seq (cond bb-eq mode walk) (invert (act test-script \"fsr\")))"
+                    "  (seq (cond bb-eq mode 3) (act test-script \"s\"))"
+                    "  (seq (cond bb-eq mode #t) (fail))"
+                    "  (mem-seq (act test-script \"rs\") (retry 1 (act test-script \"ffs\")) (repeat 2 (act test-script \"s\")))"
+                    "  (mem-sel (act test-script \"f\") (act test-script \"rfs\") (succeed))"
+                    "  (reactive-seq (act test-script \"s\") (running)))))",
+                    env);
+    (void)eval_text("(define native-inst (bt.new-instance tree))", env);
+    (void)eval_text("(define recursive-inst (bt.new-instance tree))", env);
+    bt::instance* native_inst = host.find_instance(bt_handle(eval_text("native-inst", env)));
+    bt::instance* recursive_inst = host.find_instance(bt_handle(eval_text("recursive-inst", env)));
+    check(native_inst != nullptr && recursive_inst != nullptr, "compiled tree test instances should exist");
+    recursive_inst->tick_program_enabled = false;
+
+    // Node events of one tick, without the fields that differ between runs.
+    const auto node_events = [&host, &env](const std::string& tick) {
+        host.events().clear_ring();
+        const std::string st = symbol_name(eval_text(tick, env));
+        std::vector<std::string> out{st};
+        for (const std::string& line : host.events().snapshot()) {
+            if (line.find("\"type\":\"node_") == std::string::npos) {
+                continue;
+            }
+            const std::size_t type = line.find("\"type\":");
+            const std::size_t data = line.find("\"data\":");
+            out.push_back(line.substr(type, line.find(",\"run_id\"") - type) +
+                          line.substr(data, line.find(",\"dur_ms\"", data) - data));
+        }
+        return out;
+    };
 
-    try {
-        (void)eval_text("(begin (define r (rng.make 1)) (rng.int r 0))", env);
-        throw std::runtime_error("expected rng.int n>0 validation error");
-    } catch (const lisp_error&) {
+    const std::vector<std::string> modes = {"walk", "idle", "swim", "3", "#t", "swim", "swim", "idle"};
+    for (int i = 0; i < 16; ++i) {
+        const std::string inputs = " '((mode " + modes[static_cast<std::size_t>(i) % modes.size()] + ")))";
+        const std::vector<std::string> native = node_events("(bt.tick native-inst" + inputs);
+        const std::vector<std::string> recursive = node_events("(bt.tick recursive-inst" + inputs);
+        check(native.size() > 1, "compiled tree ticks should log node events");
+        check(native == recursive, "compiled tree tick " + std::to_string(i) + " should log the interpreter's node events");
     }
+    check(native_inst->program != nullptr && native_inst->program->native != nullptr &&
+              native_inst->program->native->name() == "mixed_composites",
+          "the fixture tree should run its registered compiled tree");
+    check(native_inst->program->native->fingerprint() == bt::tick_program_fingerprint(*native_inst->program),
+          "the compiled tree should carry its program fingerprint");
+
+    for (std::size_t id = 0; id < native_inst->def->nodes.size(); ++id) {
+        const bt::node_profile_stats& a = native_inst->node_stats[id];
+        const bt::node_profile_stats& b = recursive_inst->node_stats[id];
+        check(a.success_returns == b.success_returns && a.failure_returns == b.failure_returns &&
+                  a.running_returns == b.running_returns,
+              "compiled tree node returns should match the interpreter");
+        check(native_inst->memory[id].i0 == recursive_inst->memory[id].i0 &&
+                  native_inst->memory[id].b0 == recursive_inst->memory[id].b0,
+              "compiled tree node memory should match the interpreter");
+    }
+
+    // A different tree has a different program and falls back to the interpreter loop.
+    (void)eval_text("(define other (bt.new-instance (bt (seq (succeed) (act test-script \"s\")))))", env);
+    (void)eval_text("(bt.tick other)", env);
+    const bt::instance* other = host.find_instance(bt_handle(eval_text("other", env)));
+    check(other->program != nullptr && other->program->native == nullptr, "other trees should not pick up the compiled tree");
+
+    const bt::definition& def = *native_inst->def;
+    const std::string source = bt::emit_compiled_tree_cpp(def, "fixture_copy");
+    check(source.find("class fixture_copy_compiled_tree final : public bt::compiled_tree") != std::string::npos &&
+              source.find("std::shared_ptr<const bt::compiled_tree> make_fixture_copy_compiled_tree()") != std::string::npos &&
+              source.find("switch (k.guard_dispatch(0))") != std::string::npos &&
+              source.find("k.constant(11, bt::status::failure);  // fail") != std::string::npos,
+          "emitted C++ should unroll the tick program");
+    bool rejected = false;
     try {
-        (void)eval_text("(begin (define r (rng.make 1)) (rng.normal r 0.0 -1.0))", env);
-        throw std::runtime_error("expected rng.normal sigma>=0 validation error");
-    } catch (const lisp_error&) {
+        (void)bt::emit_compiled_tree_cpp(def, "not-an-identifier");
+    } catch (const bt::bt_compile_error&) {
+        rejected = true;
     }
+    check(rejected, "emit_compiled_tree_cpp should reject names that are not identifiers");
 }
 
-void test_vec_gc_growth_and_fuzz() {
+void test_bt_tick_all_ticks_instances_as_one_wave() {
     using namespace muslisp;
 
+    reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
     env_ptr env = create_global_env();
-    (void)eval_text("(define v (vec.make 1))", env);
 
-    for (int i = 0; i < 256; ++i) {
-        (void)eval_text("(vec.push! v (list 'item " + std::to_string(i) + "))", env);
-        if ((i % 23) == 0) {
-            default_gc().collect();
-        }
-    }
-    default_gc().collect();
+    (void)eval_text("(define tree (bt (seq (cond bb-has target) (act running-then-success 1))))", env);
+    (void)eval_text("(define other (bt (fail)))", env);
+    (void)eval_text("(define a (bt.new-instance tree))", env);
+    (void)eval_text("(define b (bt.new-instance tree))", env);
+    (void)eval_text("(define c (bt.new-instance other))", env);
+    bt::instance* a = host.find_instance(bt_handle(eval_text("a", env)));
+    bt::instance* b = host.find_instance(bt_handle(eval_text("b", env)));
+    bt::instance* c = host.find_instance(bt_handle(eval_text("c", env)));
+    check(a && b && c, "tick-all test instances should exist");
+    check(a->leaf_links != nullptr && a->leaf_links == b->leaf_links,
+          "instances of one definition should share a leaf link table");
+    a->bb.put("target", bt::bb_value{true}, 0, std::chrono::steady_clock::now(), 0, "test");
+
+    value statuses = eval_text("(bt.tick-all (list a b c))", env);
+    check(print_value(statuses) == "(running failure failure)", "bt.tick-all should return statuses in order");
+    check(a->tick_index == 1 && b->tick_index == 1 && c->tick_index == 1, "bt.tick-all should tick each instance once");
+    check(a->program != nullptr && a->program == b->program && c->program != a->program,
+          "instances of one definition should share the tick program within a wave");
+    check(print_value(eval_text("(bt.tick-all (list a))", env)) == "(success)",
+          "bt.tick-all should resume running instances");
+    check(!a->trace.snapshot().empty() && !b->trace.snapshot().empty(),
+          "bt.tick-all should record into each instance's own trace");
+
+    host.callbacks().register_condition("test-wave-ready", [](bt::tick_context&, std::span<const value>) {
+        return true;
+    });
+    (void)eval_text("(bt.tick-all (list a b))", env);
+    check(a->leaf_links == b->leaf_links && a->leaf_bindings_generation == host.callbacks().generation(),
+          "instances relinked in one wave should share the new link table");
 
-    value len = eval_text("(vec.len v)", env);
-    check(is_integer(len) && integer_value(len) == 256, "vec.len mismatch after growth");
-    for (int i = 0; i < 256; ++i) {
-        value got = eval_text("(vec.get v " + std::to_string(i) + ")", env);
-        check(print_value(got) == "(item " + std::to_string(i) + ")", "vec retained value mismatch after GC");
-    }
+    check(is_nil(eval_text("(bt.tick-all '())", env)), "bt.tick-all on an empty list returns an empty list");
+    expect_lisp_error_message(
+        "(bt.tick-all (list a 1))", env, "bt.tick-all: expected bt_instance", "bt.tick-all element type");
+    check(a->tick_index == 3, "a rejected wave should not tick any instance");
+}
 
-    (void)eval_text("(vec.set! v 7 (list 'replaced 7))", env);
-    default_gc().collect();
-    check(print_value(eval_text("(vec.get v 7)", env)) == "(replaced 7)", "vec.set! overwrite mismatch");
+void test_bt_parallel_tick_all_matches_sequential_waves() {
+    using namespace muslisp;
 
-    std::vector<std::int64_t> model;
-    std::uint64_t state = 0x123456789abcdef0ull;
-    auto next = [&]() {
-        state = state * 6364136223846793005ull + 1442695040888963407ull;
-        return state;
-    };
-    (void)eval_text("(define vf (vec.make 2))", env);
-    for (int step = 0; step < 400; ++step) {
-        const std::uint64_t r = next();
-        if (model.empty() || (r % 3u == 0u)) {
-            const std::int64_t value_i = static_cast<std::int64_t>((next() % 4000u)) - 2000;
-            (void)eval_text("(vec.push! vf " + std::to_string(value_i) + ")", env);
-            model.push_back(value_i);
-        } else if (r % 3u == 1u) {
-            const std::size_t idx = static_cast<std::size_t>(next() % model.size());
-            const std::int64_t value_i = static_cast<std::int64_t>((next() % 4000u)) - 2000;
-            (void)eval_text("(vec.set! vf " + std::to_string(idx) + " " + std::to_string(value_i) + ")", env);
-            model[idx] = value_i;
-        } else {
-            const std::size_t idx = static_cast<std::size_t>(next() % model.size());
-            value got = eval_text("(vec.get vf " + std::to_string(idx) + ")", env);
-            check(is_integer(got), "vec.get in fuzz should return integer");
-            check(integer_value(got) == model[idx], "vec fuzz model mismatch");
+    std::atomic<int> off_thread_steps{0};
+    const std::thread::id caller = std::this_thread::get_id();
+    auto run = [&](std::size_t workers) {
+        reset_bt_runtime_host();
+        bt::runtime_host& host = bt::default_runtime_host();
+        env_ptr env = create_global_env();
+        host.callbacks().register_native_action(
+            "test-countdown", [&](bt::tick_context&, bt::node_id, bt::node_memory& mem, std::int64_t steps) {
+                (void)make_string("worker heap allocation");
+                off_thread_steps += std::this_thread::get_id() != caller ? 1 : 0;
+                return ++mem.i0 >= steps ? bt::status::success : bt::status::running;
+            });
+        host.callbacks().register_native_condition("test-wave-go", [](bt::tick_context&) { return true; });
+        host.set_tick_workers(workers);
+        check(host.tick_workers() == std::max<std::size_t>(workers, 1), "tick worker count should be applied");
+
+        (void)eval_text("(events.enable #t)", env);
+        (void)eval_text("(events.set-ring-size 4096)", env);
+        (void)eval_text("(define tree (bt (seq (cond test-wave-go) (act test-countdown 3))))", env);
+        (void)eval_text("(define swarm (list (bt.new-instance tree) (bt.new-instance tree) (bt.new-instance tree)"
+                        " (bt.new-instance tree) (bt.new-instance tree)))",
+                        env);
+        std::vector<std::string> statuses;
+        for (int i = 0; i < 3; ++i) {
+            statuses.push_back(print_value(eval_text("(bt.tick-all swarm)", env)));
+        }
+        if (workers > 1) {
+            check(host.dump_scheduler_stats().find("tick_waves_parallel=3\ntick_waves_sequential=0\n") !=
+                      std::string::npos,
+                  "native-only waves should count as parallel");
         }
 
-        if ((step % 37) == 0) {
-            default_gc().collect();
+        std::vector<std::string> events;
+        for (const value row : vector_from_list(eval_text("(events.dump 4096)", env))) {
+            // Sequence numbers, timings and GC events (which heap collects differs) may differ; payloads
+            // are compared up to their first timing field.
+            const std::string line = string_value(row);
+            const std::size_t type_at = line.find("\"type\":");
+            const std::string type = line.substr(type_at, line.find(',', type_at) - type_at);
+            const std::size_t data_at = line.find("\"data\":");
+            const std::size_t timing_at = std::min(line.find("_ms\":", data_at), line.find("_ns\":", data_at));
+            if (type.find("\"gc_") == std::string::npos) {
+                events.push_back(type + line.substr(data_at, timing_at - data_at));
+            }
         }
+        return std::make_pair(statuses, events);
+    };
+
+    const auto sequential = run(0);
+    check(off_thread_steps == 0, "sequential waves should tick on the calling thread");
+    const auto parallel = run(3);
+    check(off_thread_steps == 15, "native-only waves should tick on the workers");
+    check(sequential.first == std::vector<std::string>{"(running running running running running)",
+                                                       "(running running running running running)",
+                                                       "(success success success success success)"},
+          "sequential waves should tick every instance");
+    check(parallel.first == sequential.first, "parallel waves should return the same statuses");
+    check(parallel.second.size() == sequential.second.size(), "parallel waves should emit the same events");
+    bool same_events = parallel.second.size() == sequential.second.size();
+    for (std::size_t i = 0; same_events && i < parallel.second.size(); ++i) {
+        same_events = parallel.second[i] == sequential.second[i];
     }
-    check(integer_value(eval_text("(vec.len vf)", env)) == static_cast<std::int64_t>(model.size()), "vec fuzz len mismatch");
-    for (std::size_t i = 0; i < model.size(); ++i) {
-        value got = eval_text("(vec.get vf " + std::to_string(i) + ")", env);
-        check(integer_value(got) == model[i], "vec fuzz final state mismatch");
-    }
+    check(same_events, "parallel waves should merge events in wave order");
+
+    env_ptr env = create_global_env();
+    expect_lisp_error_message("(bt.set-tick-workers -1)", env, "bt.set-tick-workers: expected non-negative integer",
+                              "bt.set-tick-workers negative");
+    (void)eval_text("(bt.set-tick-workers 2)", env);
+    (void)eval_text("(define i (bt.new-instance (bt (succeed))))", env);
+    expect_lisp_error_message("(bt.tick-all (list i i))", env,
+                              "bt.tick-all: BT tick wave: an instance appears more than once in a parallel wave",
+                              "parallel wave duplicate instance");
+
+    // A wave with a span leaf, which gets Lisp arguments, stays on the calling thread.
+    bt::runtime_host& host = bt::default_runtime_host();
+    std::vector<std::thread::id> leaf_threads;
+    host.callbacks().register_action(
+        "test-wave-span", [&leaf_threads](bt::tick_context&, bt::node_id, bt::node_memory&, std::span<const value>) {
+            leaf_threads.push_back(std::this_thread::get_id());
+            return bt::status::success;
+        });
+    (void)eval_text("(define spanned (bt (act test-wave-span 1)))", env);
+    check(print_value(eval_text("(bt.tick-all (list (bt.new-instance spanned) (bt.new-instance spanned)"
+                                " (bt.new-instance spanned)))",
+                                env)) == "(success success success)",
+          "a wave with span leaves should still tick every instance");
+    check(leaf_threads.size() == 3u &&
+              std::all_of(leaf_threads.begin(), leaf_threads.end(),
+                          [](std::thread::id id) { return id == std::this_thread::get_id(); }),
+          "span leaves should run on the calling thread");
+    check(host.dump_scheduler_stats().find("tick_waves_sequential=1\n") != std::string::npos,
+          "a wave ticked on the calling thread should be counted");
+    const std::vector<bt::log_record> logs = host.logs().snapshot();
+    check(std::count_if(logs.begin(), logs.end(),
+                        [](const bt::log_record& rec) {
+                            return rec.level == bt::log_level::warn &&
+                                   rec.message.find("ticked on the calling thread") != std::string::npos;
+                        }) == 1,
+          "the first wave ticked on the calling thread should log one warning");
+    (void)eval_text("(bt.set-tick-workers 0)", env);
 }
 
-void test_map_gc_rehash_and_ops() {
+void test_bt_tick_arena_backs_tick_event_payloads() {
     using namespace muslisp;
 
+    bt::tick_arena arena(64);
+    {
+        std::pmr::string text(200, 'x', &arena);
+        check(arena.used_bytes() >= 200, "an allocation larger than the arena buffer should spill");
+    }
+    arena.reset();
+    check(arena.overflow_count() == 1 && arena.capacity_bytes() >= 200, "reset should regrow an overrun arena");
+    {
+        std::pmr::string text(200, 'x', &arena);
+    }
+    arena.reset();
+    check(arena.overflow_count() == 1 && arena.used_bytes() == 0, "a regrown arena should absorb the same tick");
+
+    reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
     env_ptr env = create_global_env();
-    (void)eval_text("(define m (map.make))", env);
+    host.events().set_enabled(true);
+    host.events().set_ring_capacity(4);
+    host.events().clear_ring();
+    host.events().set_tick_audit_enabled(true);
 
-    for (int i = 0; i < 400; ++i) {
-        const std::string key = "\"k" + std::to_string(i) + "\"";
-        (void)eval_text("(map.set! m " + key + " (list 'v " + std::to_string(i) + "))", env);
-        if ((i % 41) == 0) {
-            default_gc().collect();
-        }
+    (void)eval_text("(define inst (bt.new-instance (bt (seq (act bb-put-int counter 1) (succeed) (succeed)))))", env);
+    bt::instance* inst = host.find_instance(bt_handle(eval_text("inst", env)));
+    check(inst != nullptr, "tick arena test instance should exist");
+    (void)eval_text("(bt.tick inst)", env);
+    const std::uint64_t overflows = inst->arena.overflow_count();
+    for (int i = 0; i < 4; ++i) {
+        (void)eval_text("(bt.tick inst)", env);
     }
-    default_gc().collect();
+    check(inst->arena.high_water_bytes() > 0, "bb_write payloads should be built in the instance arena");
+    check(inst->arena.used_bytes() == 0, "the tick arena should be reset at tick end");
+    check(inst->arena.overflow_count() == overflows, "steady-state ticks should not outgrow the tick arena");
 
-    for (int i = 0; i < 400; ++i) {
-        const std::string key = "\"k" + std::to_string(i) + "\"";
-        value got = eval_text("(map.get m " + key + " nil)", env);
-        check(print_value(got) == "(v " + std::to_string(i) + ")", "map retrieval mismatch after GC/rehash");
-    }
+    const std::vector<std::string> lines = host.events().snapshot();
+    check(lines.size() == 4, "a full event ring should keep its capacity");
+    check(lines.back().find("\"type\":\"tick_audit\"") != std::string::npos,
+          "the newest ring line should be the last event emitted");
+    host.events().set_ring_capacity(2);
+    const std::vector<std::string> shrunk = host.events().snapshot();
+    check(shrunk.size() == 2 && shrunk[0] == lines[2] && shrunk[1] == lines[3],
+          "shrinking a wrapped ring should keep the newest lines in order");
+    host.events().set_tick_audit_enabled(false);
+}
 
-    (void)eval_text("(map.set! m \"k12\" (list 'new 12))", env);
-    check(print_value(eval_text("(map.get m \"k12\" nil)", env)) == "(new 12)", "map overwrite mismatch");
-    check(boolean_value(eval_text("(map.has? m \"k12\")", env)), "map.has? should be true");
-    check(boolean_value(eval_text("(map.del! m \"k12\")", env)), "map.del! should return true on existing key");
-    check(!boolean_value(eval_text("(map.has? m \"k12\")", env)), "map.has? should be false after delete");
-    check(boolean_value(eval_text("(null? (map.get m \"k12\" nil))", env)), "map.get should return default for missing key");
+void test_event_log_emission_policy_filters_before_payloads() {
+    using namespace muslisp;
 
-    value keys = eval_text("(map.keys m)", env);
-    check(is_proper_list(keys), "map.keys should return a proper list");
-    check(integer_value(eval_text("(vec.len (vec.make 0))", env)) == 0, "sanity check for vec.make default path");
+    check(bt::event_log::family_of("node_exit") == bt::event_family::node, "node_exit should be a node event");
+    check(bt::event_log::family_of("deadline_exceeded") == bt::event_family::alert, "deadline_exceeded should be an alert");
+    check(bt::event_log::family_of("tick_ok") == bt::event_family::outcome, "tick_ok should be an outcome event");
+    check(bt::event_log::family_of("sched_submit") == bt::event_family::async, "scheduler events should be async");
+    check(bt::event_log::family_of("custom") == bt::event_family::other, "unknown types should be other");
+
+    reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
+    env_ptr env = create_global_env();
+    host.events().set_enabled(true);
+    host.events().set_ring_capacity(4096);
+    host.events().clear_ring();
+    auto count_type = [&host](std::string_view type) {
+        const std::string needle = "\"type\":\"" + std::string(type) + "\"";
+        std::size_t count = 0;
+        for (const std::string& line : host.events().snapshot()) {
+            if (line.find(needle) != std::string::npos) {
+                ++count;
+            }
+        }
+        return count;
+    };
+
+    (void)eval_text("(define inst (bt.new-instance (bt (seq (act bb-put-int counter 1) (succeed) (fail)))))", env);
+    (void)eval_text("(events.set-policy '(lifecycle alert))", env);
+    host.events().set_tick_audit_enabled(true);
+    (void)eval_text("(bt.tick inst)", env);
+    check(count_type("tick_begin") == 1 && count_type("tick_end") == 1, "lifecycle events should pass the policy");
+    check(count_type("tick_audit") == 1, "tick audits should pass as alerts");
+    check(count_type("node_enter") == 0 && count_type("bb_write") == 0 && count_type("tick_ok") == 0,
+          "masked families should not be emitted");
+    check(count_type("node_exit") == 2 && count_type("node_status") == 2,
+          "failing node exits should bypass the node mask");
+    host.events().set_tick_audit_enabled(false);
+
+    (void)eval_text("(events.set-policy '(:lifecycle) 1 #f)", env);
+    host.events().clear_ring();
+    (void)eval_text("(bt.tick inst)", env);
+    check(count_type("node_exit") == 0, "failures should respect the mask when the failure rule is off");
+
+    (void)eval_text("(events.set-policy 'all 4)", env);
+    host.events().clear_ring();
+    for (int i = 0; i < 8; ++i) {
+        (void)eval_text("(bt.tick inst)", env);
+    }
+    check(count_type("tick_begin") == 8, "node sampling should not thin lifecycle events");
+    check(count_type("node_enter") == 8, "node events should be kept for one tick in four");
+    check(count_type("node_exit") == 8 + 6 * 2, "sampled ticks should keep every exit and other ticks only failing exits");
+
+    const bt::emission_policy policy = host.events().get_emission_policy();
+    check(policy.family_mask == bt::emission_policy::k_all_families && policy.node_sample_every == 4,
+          "event log should report the configured policy");
+    host.events().set_enabled(false);
+    check(!host.events().wants(bt::event_family::alert), "a disabled log should want nothing");
+    host.events().set_enabled(true);
 
+    bool threw = false;
     try {
-        (void)eval_text("(map.set! m '(bad key) 1)", env);
-        throw std::runtime_error("expected map key type validation error");
+        (void)eval_text("(events.set-policy '(:nodes))", env);
     } catch (const lisp_error&) {
+        threw = true;
     }
+    check(threw, "unknown event families should be rejected");
+    (void)eval_text("(events.set-policy 'all 1 #t)", env);
 }
 
-void test_pq_builtins_gc_and_errors() {
+void test_event_log_bb_deltas_and_keyframes() {
     using namespace muslisp;
 
-    env_ptr env = create_global_env();
+    bt::blackboard bb;
+    const auto now = std::chrono::steady_clock::now();
+    const bt::bb_slot a = bb.intern("a");
+    const bt::bb_slot b = bb.intern("b");
+    (void)bb.put(a, bt::bb_value{std::int64_t{1}}, 1, now, 0, "test");
+    (void)bb.put(b, bt::bb_value{true}, 1, now, 0, "test");
+    (void)bb.put(a, bt::bb_value{std::int64_t{2}}, 1, now, 0, "test");
+    check(bb.journal().size() == 2 && bb.journal()[0] == a && bb.journal()[1] == b,
+          "journal should list each written slot once in first-write order");
+    bb.reset_journal();
+    check(bb.journal().empty(), "reset_journal should empty the journal");
+    bb.clear();
+    check(bb.journal().size() == 2, "clear should journal every slot");
 
-    value pq_value = eval_text("(pq.make)", env);
-    check(is_pq(pq_value), "pq.make should return pq handle");
+    reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
+    env_ptr env = create_global_env();
+    host.events().set_enabled(true);
+    host.events().set_ring_capacity(4096);
+    auto lines_of = [&host](std::string_view type) {
+        const std::string needle = "\"type\":\"" + std::string(type) + "\"";
+        std::vector<std::string> out;
+        for (const std::string& line : host.events().snapshot()) {
+            if (line.find(needle) != std::string::npos) {
+                out.push_back(line);
+            }
+        }
+        return out;
+    };
 
-    value empty_meta = eval_text("(begin (define q0 (pq.make)) (list (pq.len q0) (pq.empty? q0)))", env);
-    {
-        const auto fields = vector_from_list(empty_meta);
-        check(fields.size() == 2, "pq empty metadata shape mismatch");
-        check(is_integer(fields[0]) && integer_value(fields[0]) == 0, "pq.len should start at zero");
-        check(is_boolean(fields[1]) && boolean_value(fields[1]), "pq.empty? should be true for new queue");
-    }
+    (void)eval_text("(define inst (bt.new-instance (bt (seq (act bb-put-int counter 1) (succeed)))))", env);
+    (void)eval_text("(bt.tick inst)", env);
+    host.events().clear_ring();
+    (void)eval_text("(events.set-bb-deltas 3)", env);
+    check(host.events().bb_delta_keyframe_interval() == 3, "event log should report the keyframe interval");
 
-    auto check_pair = [&](value pair_value, double expected_priority, const std::string& expected_symbol, const std::string& where) {
-        const auto pair = vector_from_list(pair_value);
-        check(pair.size() == 2, where + ": pair shape mismatch");
-        check(is_float(pair[0]), where + ": priority should be float");
-        check_close(float_value(pair[0]), expected_priority, 1e-12, where + ": priority mismatch");
-        check(is_symbol(pair[1]), where + ": payload should be symbol");
-        check(symbol_name(pair[1]) == expected_symbol, where + ": payload symbol mismatch");
+    bt::instance* inst = host.find_instance(bt_handle(eval_text("inst", env)));
+    check(inst != nullptr, "instance should exist");
+    (void)eval_text("(bt.tick inst)", env);
+    std::vector<std::string> keyframes = lines_of("bb_snapshot");
+    check(keyframes.size() == 1 && keyframes[0].find("\"keyframe\":true") != std::string::npos &&
+              keyframes[0].find("[\"counter\",1]") != std::string::npos,
+          "the first tick after enabling deltas should emit a full keyframe");
+    check(lines_of("bb_delta").empty(), "a keyframe tick should not also emit a delta");
+
+    (void)inst->bb.put(inst->bb.intern("goal"), bt::bb_value{std::string("dock")}, inst->tick_index, now, 0, "host");
+    (void)eval_text("(bt.tick inst)", env);
+    std::vector<std::string> deltas = lines_of("bb_delta");
+    check(deltas.size() == 1, "a tick with writes should emit one delta");
+    check(deltas[0].find("[\"counter\",1,") != std::string::npos && deltas[0].find("[\"goal\",\"dock\",") != std::string::npos &&
+              deltas[0].find("\"deleted\":[]") != std::string::npos,
+          "a delta should carry the written keys and their values");
+
+    (void)inst->bb.put(inst->bb.intern("goal"), bt::bb_value{}, inst->tick_index, now, 0, "host");
+    (void)eval_text("(bt.tick inst)", env);
+    deltas = lines_of("bb_delta");
+    check(deltas.size() == 2 && deltas[1].find("\"deleted\":[\"goal\"]") != std::string::npos,
+          "nil writes should appear as deleted keys");
+
+    (void)eval_text("(bt.tick inst)", env);
+    keyframes = lines_of("bb_snapshot");
+    check(keyframes.size() == 2 && keyframes[1].find("goal") == std::string::npos,
+          "a keyframe should follow every interval and omit deleted keys");
+
+    (void)eval_text("(events.set-bb-deltas 0)", env);
+    host.events().clear_ring();
+    (void)eval_text("(bt.tick inst)", env);
+    check(lines_of("bb_delta").empty() && lines_of("bb_snapshot").empty(), "0 should turn deltas off");
+}
+
+void test_event_log_compact_ids() {
+    using namespace muslisp;
+
+    const auto record = [](bool compact) {
+        reset_bt_runtime_host();
+        bt::runtime_host& host = bt::default_runtime_host();
+        env_ptr env = create_global_env();
+        host.events().set_enabled(true);
+        host.events().set_ring_capacity(4096);
+        host.events().set_run_id("compact-ids");
+        host.events().set_deterministic_time(1'700'000'000'000);
+        (void)eval_text(compact ? "(events.set-compact-ids #t)" : "(events.set-compact-ids #f)", env);
+        (void)eval_text("(define inst (bt.new-instance (bt (seq (act bb-put-int counter 1) (act always-success)))))",
+                        env);
+        for (int i = 0; i < 4; ++i) {
+            (void)eval_text("(bt.tick inst)", env);
+        }
+        // Collections may run in one recording and not the other; seq and unix_ms shift with them.
+        std::vector<std::string> lines;
+        for (std::string& line : host.events().snapshot()) {
+            if (line.find("\"type\":\"gc_") == std::string::npos) {
+                lines.push_back(std::move(line));
+            }
+        }
+        host.events().clear_deterministic_time();
+        host.events().set_compact_ids(false);
+        return lines;
+    };
+    // Leaves out measured times, whose digits differ between recordings.
+    const auto bytes_of = [](const std::vector<std::string>& lines) {
+        std::size_t total = 0;
+        for (const std::string& line : lines) {
+            if (line.find("\"type\":\"tick_") == std::string::npos) {
+                total += std::min(line.size(), line.find(",\"dur_ms\":"));
+            }
+        }
+        return total;
     };
 
-    value ordered = eval_text(
-        "(begin "
-        "  (define q1 (pq.make)) "
-        "  (list "
-        "    (pq.push! q1 3 'c) "
-        "    (pq.push! q1 1.5 'b) "
-        "    (pq.push! q1 1 'a) "
-        "    (pq.pop! q1) "
-        "    (pq.pop! q1) "
-        "    (pq.pop! q1) "
-        "    (pq.empty? q1)))",
-        env);
-    {
-        const auto fields = vector_from_list(ordered);
-        check(fields.size() == 7, "pq ordering result shape mismatch");
-        check(is_integer(fields[0]) && integer_value(fields[0]) == 1, "pq.push! should return size=1");
-        check(is_integer(fields[1]) && integer_value(fields[1]) == 2, "pq.push! should return size=2");
-        check(is_integer(fields[2]) && integer_value(fields[2]) == 3, "pq.push! should return size=3");
-        check_pair(fields[3], 1.0, "a", "pq.pop order[0]");
-        check_pair(fields[4], 1.5, "b", "pq.pop order[1]");
-        check_pair(fields[5], 3.0, "c", "pq.pop order[2]");
-        check(is_boolean(fields[6]) && boolean_value(fields[6]), "pq.empty? should be true after draining");
+    const std::vector<std::string> canonical = record(false);
+    std::vector<std::string> compact = record(true);
+    check(canonical.size() == compact.size(), "compact ids should not change which events are emitted");
+    check(bytes_of(compact) < bytes_of(canonical), "compact ids should shrink the log");
+
+    bool declared = false;
+    std::size_t rewritten = 0;
+    bt::compact_event_expander expander;
+    for (std::size_t i = 0; i < compact.size(); ++i) {
+        if (compact[i].find("\"type\":\"bt_def\"") != std::string::npos) {
+            declared = compact[i].find("\"string_table\":{\"profile\":\"compact-ids.v1\"") != std::string::npos &&
+                       compact[i].find("\"keys\":[\"counter\"]") != std::string::npos;
+            (void)expander.expand(compact[i]);
+            continue;
+        }
+        const bool node_or_key = compact[i].find("\"status_id\":") != std::string::npos ||
+                                 compact[i].find("\"key_id\":") != std::string::npos;
+        check(expander.expand(compact[i]) == node_or_key, "only lines with ids should be rewritten");
+        if (!node_or_key) {
+            continue;
+        }
+        ++rewritten;
+        // Durations are measured, so compare up to them.
+        const auto payload = [](const std::string& line) {
+            const std::size_t begin = line.find(",\"data\":");
+            return line.substr(begin, line.find(",\"dur_ms\":") - begin);
+        };
+        check(payload(compact[i]) == payload(canonical[i]),
+              "an expanded line should carry its canonical payload: " + compact[i]);
     }
+    check(declared, "bt_def should declare the tree's keys in its string table");
+    check(rewritten > 0, "node and blackboard events should carry ids");
+    check(bt::compact_status_name(2) == std::optional<std::string_view>("running") && !bt::compact_status_name(3),
+          "status ids should follow the status enum");
+}
 
-    value tie_order = eval_text(
-        "(begin "
-        "  (define q2 (pq.make)) "
-        "  (pq.push! q2 2 'first) "
-        "  (pq.push! q2 2.0 'second) "
-        "  (list (pq.pop! q2) (pq.pop! q2)))",
-        env);
-    {
-        const auto fields = vector_from_list(tie_order);
-        check(fields.size() == 2, "pq tie-order result shape mismatch");
-        check_pair(fields[0], 2.0, "first", "pq tie-order[0]");
-        check_pair(fields[1], 2.0, "second", "pq tie-order[1]");
-    }
+void test_bt_flat_binary_view_and_shared_leaf_args() {
+    using namespace muslisp;
 
-    value peek_meta = eval_text(
-        "(begin "
-        "  (define q3 (pq.make)) "
-        "  (pq.push! q3 4 'x) "
-        "  (list (pq.peek q3) (pq.len q3) (pq.pop! q3) (pq.empty? q3)))",
-        env);
-    {
-        const auto fields = vector_from_list(peek_meta);
-        check(fields.size() == 4, "pq.peek metadata shape mismatch");
-        check_pair(fields[0], 4.0, "x", "pq.peek pair");
-        check(is_integer(fields[1]) && integer_value(fields[1]) == 1, "pq.peek should not mutate queue");
-        check_pair(fields[2], 4.0, "x", "pq.pop after peek");
-        check(is_boolean(fields[3]) && boolean_value(fields[3]), "queue should be empty after pop");
-    }
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
 
-    eval_text(
-        "(begin "
-        "  (define qgc (pq.make)) "
-        "  (define (fill i) "
-        "    (if (= i 64) "
-        "        nil "
-        "        (begin "
-        "          (pq.push! qgc i (list 'node i (list i (+ i 1)))) "
-        "          (fill (+ i 1))))) "
-        "  (fill 0))",
-        env);
-    default_gc().collect();
-    for (int i = 0; i < 64; ++i) {
-        value entry = eval_text("(pq.pop! qgc)", env);
-        const auto pair = vector_from_list(entry);
-        check(pair.size() == 2, "pq gc payload pair shape mismatch");
-        check(is_float(pair[0]), "pq gc payload priority should be float");
-        check_close(float_value(pair[0]), static_cast<double>(i), 1e-12, "pq gc payload priority mismatch");
-        const std::string expected = "(node " + std::to_string(i) + " (" + std::to_string(i) + " " + std::to_string(i + 1) + "))";
-        check(print_value(pair[1]) == expected, "pq gc payload value mismatch");
-        if ((i % 9) == 0) {
-            default_gc().collect();
-        }
+    (void)eval_text("(define tree (bt (seq (cond bb-has foo) (act always-success 7 \"txt\") (succeed))))", env);
+    const auto bin_path = temp_file_path("tree_flat", ".mbt");
+    (void)eval_text("(bt.save tree " + lisp_string_literal(bin_path.string()) + ")", env);
+
+    std::vector<std::byte> image;
+    {
+        const bt::mapped_definition_file file(bin_path.string());
+        image.assign(file.bytes().begin(), file.bytes().end());
+        const bt::definition_view view = file.view();
+        check(view.node_count() == 4, "flat view should expose every node");
+        const bt::node_id root = view.root();
+        check(view.kind(root) == bt::node_kind::seq && view.child_count(root) == 3, "flat view root should be the seq");
+        const bt::node_id act = view.child(root, 1);
+        check(view.leaf_name(act) == "always-success", "flat view should read leaf names in place");
+        check(view.arg_count(act) == 2, "flat view should expose leaf args");
+        check(view.arg(act, 0).int_v == 7 && view.arg(act, 1).text == "txt", "flat view should decode leaf args");
+        check(view.leaf_name(view.child(root, 0)) == "bb-has", "flat view should read cond names");
     }
-    check(boolean_value(eval_text("(pq.empty? qgc)", env)), "pq should be empty after gc-drain loop");
 
-    auto expect_lisp_error = [&](const std::string& expr, const std::string& label) {
+    const auto expect_rejected = [&](std::vector<std::byte> bytes, const std::string& label) {
         try {
-            (void)eval_text(expr, env);
-            throw std::runtime_error("expected lisp_error: " + label);
-        } catch (const lisp_error&) {
+            (void)bt::definition_view::open(bytes);
+            throw std::runtime_error("expected flat view rejection: " + label);
+        } catch (const std::runtime_error& e) {
+            check(std::string(e.what()).rfind("bt.load:", 0) == 0, "flat view rejection should be a bt.load error: " + label);
         }
     };
+    expect_rejected(std::vector<std::byte>(image.begin(), image.begin() + static_cast<std::ptrdiff_t>(image.size() / 2)),
+                    "truncated");
+    std::vector<std::byte> bad_root = image;
+    bad_root[16] = std::byte{0xFF};
+    bad_root[17] = std::byte{0xFF};
+    expect_rejected(bad_root, "root out of range");
+
+    const auto truncated_path = temp_file_path("tree_flat_truncated", ".mbt");
+    {
+        std::ofstream out(truncated_path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size() - 8));
+    }
+    try {
+        (void)eval_text("(bt.load " + lisp_string_literal(truncated_path.string()) + ")", env);
+        throw std::runtime_error("expected bt.load truncated-image failure");
+    } catch (const lisp_error& e) {
+        check(std::string(e.what()).find("bt.load:") != std::string::npos, "truncated image should fail in bt.load");
+    }
 
-    expect_lisp_error("(begin (define qe (pq.make)) (pq.pop! qe))", "pq.pop! on empty");
-    expect_lisp_error("(begin (define qe (pq.make)) (pq.peek qe))", "pq.peek on empty");
-    expect_lisp_error("(begin (define qe (pq.make)) (pq.push! qe 'bad 1))", "pq.push! non-numeric priority");
-    expect_lisp_error("(begin (define qe (pq.make)) (pq.push! qe (/ 1 0) 1))", "pq.push! infinite priority");
-    expect_lisp_error("(begin (define qe (pq.make)) (pq.push! qe (/ 0 0) 1))", "pq.push! nan priority");
-    expect_lisp_error("(write-to-string (pq.make))", "write-to-string should reject pq");
+    (void)eval_text("(define loaded (bt.load " + lisp_string_literal(bin_path.string()) + "))", env);
+    (void)eval_text("(define inst-a (bt.new-instance loaded))", env);
+    (void)eval_text("(define inst-b (bt.new-instance loaded))", env);
+    bt::runtime_host& host = bt::default_runtime_host();
+    const bt::instance* inst_a = host.find_instance(bt_handle(eval_text("inst-a", env)));
+    const bt::instance* inst_b = host.find_instance(bt_handle(eval_text("inst-b", env)));
+    check(inst_a && inst_b, "instances of the loaded tree should exist");
+    check(inst_a->leaf_arg_values && inst_a->leaf_arg_values == inst_b->leaf_arg_values,
+          "instances of one definition should share the materialised leaf arg table");
+    check(symbol_name(eval_text("(bt.tick inst-a)", env)) == "failure", "loaded flat tree should tick");
 }
 
-void test_continuous_mcts_smoke_deterministic() {
+void test_list_and_predicate_builtins() {
     using namespace muslisp;
 
     env_ptr env = create_global_env();
-    const std::string program =
-        "(begin "
-        "  (define goal 1.0) "
-        "  (define (step x a) "
-        "    (let ((a2 (clamp a -1.0 1.0))) "
-        "      (let ((x2 (+ x (* 0.25 a2)))) "
-        "        (- 0.0 (abs (- goal x2)))))) "
-        "  (define (pw-allow? n-visits n-children k alpha) "
-        "    (< n-children (* k (exp (* alpha (log (if (< n-visits 1) 1 n-visits))))))) "
-        "  (define (ucb q n parent-n c) "
-        "    (if (= n 0) 1.0e30 (+ q (* c (sqrt (/ (log (if (< parent-n 1) 1 parent-n)) n)))))) "
-        "  (define (child.new a) "
-        "    (let ((m (map.make))) "
-        "      (begin (map.set! m 'a a) (map.set! m 'n 0) (map.set! m 'w 0.0) m))) "
-        "  (define (child.q ch) "
-        "    (let ((n (map.get ch 'n 0)) (w (map.get ch 'w 0.0))) "
-        "      (if (= n 0) 0.0 (/ w n)))) "
-        "  (define (node.new) "
-        "    (let ((m (map.make))) "
-        "      (begin (map.set! m 'n 0) (map.set! m 'w 0.0) (map.set! m 'children (vec.make 4)) m))) "
-        "  (define (select-child children i nch parent-n c best best-score) "
-        "    (if (>= i nch) "
-        "        best "
-        "        (let ((ch (vec.get children i))) "
-        "          (let ((score (ucb (child.q ch) (map.get ch 'n 0) parent-n c))) "
-        "            (if (> score best-score) "
-        "                (select-child children (+ i 1) nch parent-n c ch score) "
-        "                (select-child children (+ i 1) nch parent-n c best best-score)))))) "
-        "  (define (simulate root x rng c k alpha) "
-        "    (let ((n (map.get root 'n 0)) (children (map.get root 'children nil))) "
-        "      (let ((nch (vec.len children))) "
-        "        (if (pw-allow? n nch k alpha) "
-        "            (let ((a (rng.uniform rng -1.0 1.0))) "
-        "              (let ((ch (child.new a)) (v (step x a))) "
-        "                (begin "
-        "                  (vec.push! children ch) "
-        "                  (map.set! ch 'n (+ (map.get ch 'n 0) 1)) "
-        "                  (map.set! ch 'w (+ (map.get ch 'w 0.0) v)) "
-        "                  (map.set! root 'n (+ n 1)) "
-        "                  (map.set! root 'w (+ (map.get root 'w 0.0) v)) "
-        "                  v))) "
-        "            (let ((ch (select-child children 0 nch n c nil -1.0e30))) "
-        "              (let ((v (step x (map.get ch 'a 0.0)))) "
-        "                (begin "
-        "                  (map.set! ch 'n (+ (map.get ch 'n 0) 1)) "
-        "                  (map.set! ch 'w (+ (map.get ch 'w 0.0) v)) "
-        "                  (map.set! root 'n (+ n 1)) "
-        "                  (map.set! root 'w (+ (map.get root 'w 0.0) v)) "
-        "                  v))))))) "
-        "  (define (search-loop root x rng i iters c k alpha) "
-        "    (if (>= i iters) "
-        "        root "
-        "        (begin "
-        "          (simulate root x rng c k alpha) "
-        "          (search-loop root x rng (+ i 1) iters c k alpha)))) "
-        "  (define (best-child children i nch best best-n) "
-        "    (if (>= i nch) "
-        "        best "
-        "        (let ((ch (vec.get children i)) (cn (map.get (vec.get children i) 'n 0))) "
-        "          (if (> cn best-n) "
-        "              (best-child children (+ i 1) nch ch cn) "
-        "              (best-child children (+ i 1) nch best best-n))))) "
-        "  (define (mcts.search x0 seed iters) "
-        "    (let ((rng (rng.make seed)) (root (node.new)) (c 1.2) (k 2.0) (alpha 0.5)) "
-        "      (begin "
-        "        (search-loop root x0 rng 0 iters c k alpha) "
-        "        (let ((children (map.get root 'children nil))) "
-        "          (let ((best (best-child children 0 (vec.len children) nil -1))) "
-        "            (map.get best 'a 0.0)))))) "
-        "  (let ((a1 (mcts.search 0.0 42 350)) (a2 (mcts.search 0.0 42 350))) "
-        "    (list a1 a2)))";
 
-    value out = eval_text(program, env);
-    const std::vector<value> pair = vector_from_list(out);
-    check(pair.size() == 2, "mcts smoke output shape mismatch");
-    check(is_float(pair[0]) && is_float(pair[1]), "mcts smoke should return float actions");
-    const double a1 = float_value(pair[0]);
-    const double a2 = float_value(pair[1]);
-    check(a1 > 0.0, "mcts smoke action should move toward positive goal");
-    check_close(a1, a2, 1e-12, "mcts smoke should be deterministic for fixed seed");
+    const auto second = eval_text("(car (cdr (list 1 2 3)))", env);
+    check(integer_value(second) == 2, "car/cdr/list failed");
+
+    const auto null_true = eval_text("(null? (cdr (list 1)))", env);
+    check(boolean_value(null_true), "null? expected true");
+
+    const auto eq_symbol = eval_text("(eq? 'a 'a)", env);
+    check(boolean_value(eq_symbol), "eq? symbol interning behavior failed");
+
+    const auto eq_int = eval_text("(eq? 4 4)", env);
+    check(boolean_value(eq_int), "eq? integer equality failed");
+
+    const auto eq_list = eval_text("(eq? (list 1) (list 1))", env);
+    check(!boolean_value(eq_list), "eq? list pointer equality failed");
 }
 
-void test_planner_plan_builtin_determinism_bounds_budget_and_sanity() {
+void test_gc_and_stats_builtins() {
     using namespace muslisp;
 
-    reset_bt_runtime_host();
     env_ptr env = create_global_env();
+    default_gc().set_policy(gc_policy::default_policy);
 
-    try {
-        (void)eval_text("(planner.plan (map.make))", env);
-        throw std::runtime_error("expected planner.plan request validation failure");
-    } catch (const lisp_error&) {
+    for (int i = 0; i < 2000; ++i) {
+        (void)eval_text("(list 1 2 3 4 5 6 7 8 9 10)", env);
     }
 
-    value out = eval_text(
-        "(begin "
-        "  (define req (map.make)) "
-        "  (map.set! req 'schema_version \"planner.request.v1\") "
-        "  (map.set! req 'planner \"mcts\") "
-        "  (map.set! req 'model_service \"toy-1d\") "
-        "  (map.set! req 'state 0.0) "
-        "  (map.set! req 'seed 42) "
-        "  (map.set! req 'budget_ms 16) "
-        "  (map.set! req 'work_max 400) "
+    default_gc().collect();
+    const gc_stats_snapshot stats = default_gc().stats();
+
+    check(stats.total_allocated_objects > 0, "gc stats should report allocated objects");
+    check(stats.live_objects_after_last_gc > 0, "gc stats should report live objects");
+    check(stats.total_allocated_objects >= stats.live_objects_after_last_gc,
+          "total allocated should be >= live after last gc");
+    check(stats.next_gc_threshold >= stats.live_objects_after_last_gc,
+          "next gc threshold should be >= live after last gc");
+
+    const auto heap_stats_result = eval_text("(heap-stats)", env);
+    check(is_nil(heap_stats_result), "heap-stats should return nil");
+
+    const auto gc_stats_result = eval_text("(gc-stats)", env);
+    check(is_nil(gc_stats_result), "gc-stats should return nil");
+
+    check(symbol_name(eval_text("(gc.policy)", env)) == ":default", "gc.policy default mismatch");
+    check(symbol_name(eval_text("(gc.set-policy! \"between-ticks\")", env)) == ":between-ticks",
+          "gc.set-policy! between-ticks mismatch");
+    check(default_gc().policy() == gc_policy::between_ticks, "C++ GC policy should be between-ticks");
+    check(symbol_name(eval_text("(gc.set-policy! \"manual\")", env)) == ":manual", "gc.set-policy! manual mismatch");
+    check(default_gc().policy() == gc_policy::manual, "C++ GC policy should be manual");
+    check(symbol_name(eval_text("(gc.set-policy! \"fail-on-tick-gc\")", env)) == ":fail-on-tick-gc",
+          "gc.set-policy! fail-on-tick-gc mismatch");
+    check(default_gc().policy() == gc_policy::fail_on_tick_gc, "C++ GC policy should be fail-on-tick-gc");
+    check(symbol_name(eval_text("(gc.set-policy! \"incremental\")", env)) == ":incremental",
+          "gc.set-policy! incremental mismatch");
+    check(default_gc().policy() == gc_policy::incremental, "C++ GC policy should be incremental");
+    expect_lisp_error_message("(gc.set-policy! \"sometimes\")",
+                              env,
+                              "gc.set-policy!: expected :default, :between-ticks, :manual, :fail-on-tick-gc, or :incremental",
+                              "gc.set-policy! invalid policy");
+    (void)eval_text("(gc.set-policy! \"default\")", env);
+    check(default_gc().policy() == gc_policy::default_policy, "GC policy should reset to default");
+}
+
+void test_gc_lifecycle_events() {
+    using namespace muslisp;
+
+    bt::runtime_host& host = bt::default_runtime_host();
+    host.events().set_enabled(true);
+    host.events().set_ring_capacity(64);
+    host.events().clear_ring();
+    default_gc().set_policy(gc_policy::default_policy);
+
+    default_gc().collect();
+
+    const std::vector<std::string> lines = host.events().snapshot();
+    bool saw_begin = false;
+    bool saw_end = false;
+    bool saw_schema = false;
+    bool saw_forced = false;
+    for (const std::string& line : lines) {
+        saw_begin = saw_begin || line.find("\"type\":\"gc_begin\"") != std::string::npos;
+        saw_end = saw_end || line.find("\"type\":\"gc_end\"") != std::string::npos;
+        saw_schema = saw_schema || line.find("\"schema_version\":\"gc.lifecycle.v1\"") != std::string::npos;
+        saw_forced = saw_forced || line.find("\"reason\":\"forced\"") != std::string::npos;
+    }
+    check(saw_begin, "GC lifecycle should emit gc_begin");
+    check(saw_end, "GC lifecycle should emit gc_end");
+    check(saw_schema, "GC lifecycle should emit gc.lifecycle.v1 payload");
+    check(saw_forced, "GC lifecycle should record forced collection reason");
+}
+
+void test_gc_heap_limits() {
+    using namespace muslisp;
+
+    bt::runtime_host& host = bt::default_runtime_host();
+    host.events().set_enabled(true);
+    host.events().set_ring_capacity(64);
+    host.events().clear_ring();
+    env_ptr env = create_global_env();
+    (void)eval_text("(define (build n acc) (if (= n 0) acc (build (- n 1) (cons n acc))))", env);
+    default_gc().set_policy(gc_policy::default_policy);
+    default_gc().collect();
+
+    // Soft limit: crossing it makes every requested collection a full one.
+    const std::size_t live = default_gc().stats().bytes_allocated;
+    gc_limits limits;
+    limits.soft_limit_bytes = live + 4096;
+    default_gc().set_limits(limits);
+    const gc_stats_snapshot before = default_gc().stats();
+    (void)eval_text("(define keep (build 2000 nil))", env);
+    const gc_stats_snapshot soft = default_gc().stats();
+    check(soft.soft_limit_crossings == before.soft_limit_crossings + 1, "crossing the soft limit should be counted once");
+    check(soft.memory_pressure, "a heap still above its soft limit should report memory pressure");
+    check(soft.collection_count > before.collection_count &&
+              soft.minor_collection_count == before.minor_collection_count,
+          "collections under memory pressure should be full collections");
+
+    // Garbage made between safe points does not count against the hard limit; crossing it only makes the
+    // next safe point a full collection.
+    (void)eval_text("(define (churn n) (if (= n 0) 0 (+ (car (list 4 n n n)) (churn (- n 1)))))", env);
+    default_gc().set_limits(gc_limits{});
+    default_gc().collect();
+    const std::size_t settled = default_gc().stats().bytes_allocated;
+    default_gc().set_policy(gc_policy::manual);
+    (void)eval_text("(churn 1000)", env);
+    const std::size_t churned = default_gc().stats().bytes_allocated - settled;
+    check(churned > 4096, "churn should allocate garbage");
+    default_gc().set_policy(gc_policy::default_policy);
+    default_gc().collect();
+    gc_limits roomy;
+    roomy.hard_limit_bytes = default_gc().stats().bytes_allocated + churned / 2;
+    default_gc().set_limits(roomy);
+    const gc_stats_snapshot before_churn = default_gc().stats();
+    check(integer_value(eval_text("(churn 1000)", env)) == 4000, "garbage under a roomy live set should not fail");
+    const gc_stats_snapshot after_churn = default_gc().stats();
+    check(after_churn.hard_limit_failures == before_churn.hard_limit_failures,
+          "crossing the hard limit with garbage should not refuse allocations");
+    check(after_churn.collection_count > before_churn.collection_count &&
+              after_churn.minor_collection_count == before_churn.minor_collection_count &&
+              after_churn.bytes_allocated <= roomy.hard_limit_bytes,
+          "the safe point after a crossing should run a full collection");
+
+    // Without a safe point, garbage is refused once it doubles the heap; the incident is logged once.
+    default_gc().set_policy(gc_policy::manual);
+    host.events().clear_ring();
+    const auto hard_incidents = [&host] {
+        std::size_t count = 0;
+        for (const std::string& line : host.events().snapshot()) {
+            count += line.find("\"kind\":\"hard_limit_exceeded\"") != std::string::npos ? 1u : 0u;
+        }
+        return count;
+    };
+    std::size_t refused = 0;
+    for (std::size_t i = 0; refused < 3 && i < 1'000'000; ++i) {
+        try {
+            (void)make_string(std::string(200, 'x'));
+        } catch (const heap_limit_error&) {
+            ++refused;
+        }
+    }
+    check(refused == 3 && default_gc().stats().bytes_allocated <= 2 * roomy.hard_limit_bytes,
+          "garbage should be refused at twice the hard limit");
+    check(hard_incidents() == 1, "a hard limit crossing should be logged once");
+    default_gc().set_policy(gc_policy::default_policy);
+    default_gc().collect();
+
+    // Hard limit: the allocation fails with a catchable error and is logged as an incident.
+    limits.soft_limit_bytes = 0;
+    limits.hard_limit_bytes = default_gc().stats().bytes_allocated + 4096;
+    default_gc().set_limits(limits);
+    bool threw = false;
+    try {
+        (void)eval_text("(define big (build 5000 nil))", env);
+    } catch (const heap_limit_error&) {
+        threw = true;
+    }
+    check(threw, "allocating past the hard limit should throw heap_limit_error");
+    check(default_gc().stats().hard_limit_failures > soft.hard_limit_failures, "hard limit failures should be counted");
+    bool saw_incident = false;
+    for (const std::string& line : host.events().snapshot()) {
+        saw_incident = saw_incident || (line.find("\"type\":\"error\"") != std::string::npos &&
+                                        line.find("\"kind\":\"hard_limit_exceeded\"") != std::string::npos);
+    }
+    check(saw_incident, "a refused allocation should be logged as a gc incident");
+
+    default_gc().set_limits(gc_limits{});
+    check(print_value(eval_text("(map.get (gc.set-limits! (begin (define m (map.make)) (map.set! m 'growth_factor 3.0) m)) 'growth_factor 0)", env)) ==
+              "3.0",
+          "gc.set-limits! should return the updated limits");
+    bool rejected = false;
+    try {
+        (void)eval_text("(gc.set-limits! (begin (define m (map.make)) (map.set! m 'growth_factor 0.5) m))", env);
+    } catch (const lisp_error&) {
+        rejected = true;
+    }
+    check(rejected, "gc.set-limits! should reject a growth factor below 1");
+    check(integer_value(eval_text("(map.get (gc.limits) 'hard_limit_bytes 0)", env)) == 0,
+          "gc.limits should report the restored hard limit");
+    default_gc().set_limits(gc_limits{});
+    default_gc().collect();
+}
+
+void test_runtime_contexts_are_isolated() {
+    using namespace muslisp;
+
+    constexpr int kContexts = 4;
+    std::vector<std::unique_ptr<runtime_context>> contexts;
+    for (int i = 0; i < kContexts; ++i) {
+        contexts.push_back(std::make_unique<runtime_context>());
+    }
+    check(&bt::default_runtime_host() != &contexts[0]->host(),
+          "a context's host should not be the process host outside a scope");
+    {
+        runtime_context_scope bind(*contexts[0]);
+        check(&bt::default_runtime_host() == &contexts[0]->host() && &default_gc() == &contexts[0]->heap(),
+              "a bound context should provide default_runtime_host and default_gc");
+    }
+
+    std::vector<std::string> results(kContexts);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kContexts; ++i) {
+        threads.emplace_back([&, i] {
+            runtime_context& context = *contexts[i];
+            (void)context.eval_source("(define id " + std::to_string(i) + ")");
+            (void)context.eval_source("(define (build n acc) (if (= n 0) acc (build (- n 1) (cons n acc))))");
+            (void)context.eval_source("(define inst (bt.new-instance (bt (seq (cond always-true) (act running-then-success)))))");
+            for (int round = 0; round < 40; ++round) {
+                (void)context.eval_source("(define keep (build 400 nil))");
+                (void)context.eval_source("(bt.tick inst)");
+            }
+            context.heap().collect();
+            results[i] = print_value(context.eval_source("(list id inst (car keep))"));
+        });
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    for (int i = 0; i < kContexts; ++i) {
+        check(results[i] == print_value(contexts[0]->eval_source("(list " + std::to_string(i) + " inst 1)")),
+              "each context should keep its own globals and number its own instances from the start");
+        check(contexts[i]->heap().stats().collection_count > 0, "each context should collect its own heap");
+    }
+    check(!contexts[1]->global_env()->bindings.empty() &&
+              print_value(contexts[1]->eval_source("id")) == "1",
+          "a context's globals should survive the other contexts' threads");
+    contexts.clear();
+    check(print_value(eval_text("'after-contexts", create_global_env())) == "after-contexts",
+          "the process runtime should work after contexts are destroyed");
+}
+
+void test_gc_during_argument_evaluation() {
+    using namespace muslisp;
+
+    env_ptr env = create_global_env();
+    default_gc().set_policy(gc_policy::default_policy);
+
+    // Calling gc-stats while evaluating later arguments must not invalidate earlier values.
+    value out = eval_text("(begin (define x (list 1 2 3)) (list x (gc-stats) x))", env);
+    const auto items = vector_from_list(out);
+    check(items.size() == 3, "list size mismatch");
+    check(print_value(items[0]) == "(1 2 3)", "first retained value mismatch");
+    check(is_nil(items[1]), "gc-stats return value mismatch");
+    check(print_value(items[2]) == "(1 2 3)", "second retained value mismatch");
+}
+
+void test_math_time_and_domain_errors() {
+    using namespace muslisp;
+
+    env_ptr env = create_global_env();
+
+    value sqrt_value = eval_text("(sqrt 4)", env);
+    check(is_float(sqrt_value), "sqrt should return float");
+    check_close(float_value(sqrt_value), 2.0, 1e-12, "sqrt(4) mismatch");
+
+    value log_value = eval_text("(log 1)", env);
+    check(is_float(log_value), "log should return float");
+    check_close(float_value(log_value), 0.0, 1e-12, "log(1) mismatch");
+
+    value exp_value = eval_text("(exp 0)", env);
+    check(is_float(exp_value), "exp should return float");
+    check_close(float_value(exp_value), 1.0, 1e-12, "exp(0) mismatch");
+
+    value atan2_value = eval_text("(atan2 1 1)", env);
+    check(is_float(atan2_value), "atan2 should return float");
+    check_close(float_value(atan2_value), 0.7853981633974483, 1e-12, "atan2(1, 1) mismatch");
+
+    value abs_i = eval_text("(abs -7)", env);
+    check(is_integer(abs_i) && integer_value(abs_i) == 7, "abs over integer mismatch");
+    value abs_f = eval_text("(abs -2.5)", env);
+    check(is_float(abs_f), "abs over float should return float");
+    check_close(float_value(abs_f), 2.5, 1e-12, "abs over float mismatch");
+
+    value clamp_i = eval_text("(clamp 9 0 5)", env);
+    check(is_integer(clamp_i) && integer_value(clamp_i) == 5, "clamp int mismatch");
+    value clamp_f = eval_text("(clamp 0.2 0.3 0.9)", env);
+    check(is_float(clamp_f), "clamp float should return float");
+    check_close(float_value(clamp_f), 0.3, 1e-12, "clamp float mismatch");
+
+    value t1 = eval_text("(time.now-ms)", env);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    value t2 = eval_text("(time.now-ms)", env);
+    check(is_integer(t1) && is_integer(t2), "time.now-ms should return integer");
+    check(integer_value(t2) >= integer_value(t1), "time.now-ms should be monotonic");
+    const auto sleep_start = std::chrono::steady_clock::now();
+    value sleep_result = eval_text("(time.sleep-ms 2)", env);
+    const auto sleep_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - sleep_start);
+    check(is_nil(sleep_result), "time.sleep-ms should return nil");
+    check(sleep_elapsed.count() >= 1, "time.sleep-ms should block for a measurable interval");
+
+    try {
+        (void)eval_text("(sqrt -1)", env);
+        throw std::runtime_error("expected sqrt domain error");
+    } catch (const lisp_error&) {
+    }
+    try {
+        (void)eval_text("(log 0)", env);
+        throw std::runtime_error("expected log domain error");
+    } catch (const lisp_error&) {
+    }
+    try {
+        (void)eval_text("(time.sleep-ms -1)", env);
+        throw std::runtime_error("expected time.sleep-ms domain error");
+    } catch (const lisp_error&) {
+    }
+}
+
+void test_rng_bulk_fills_match_scalar_draws() {
+    using namespace muslisp;
+
+    env_ptr env = create_global_env();
+    const auto same_draws = [&](const std::string& name, const std::string& params, int n) {
+        value filled = eval_text("(begin (define a (rng.make 11)) (define v (vec.make)) (rng.fill-" + name + "! a v " +
+                                     std::to_string(n) + " " + params + ") v)",
+                                 env);
+        value drawn = eval_text("(begin (define b (rng.make 11)) (define w (vec.make)) "
+                                "(define (draw i) (if (= i 0) w (begin (vec.push! w (rng." +
+                                    name + " b " + params + ")) (draw (- i 1))))) (draw " + std::to_string(n) + "))",
+                                env);
+        const std::vector<value>& got = filled->vec_data();
+        const std::vector<value>& want = drawn->vec_data();
+        if (got.size() != want.size()) {
+            return false;
+        }
+        for (std::size_t i = 0; i < got.size(); ++i) {
+            if (print_value(got[i]) != print_value(want[i])) {
+                return false;
+            }
+        }
+        // Both generators must also be left in the same state.
+        return print_value(eval_text("(list (rng.uniform a 0 1) (rng.normal a 0 1))", env)) ==
+               print_value(eval_text("(list (rng.uniform b 0 1) (rng.normal b 0 1))", env));
+    };
+
+    check(same_draws("uniform", "-2 3", 37), "rng.fill-uniform! should match rng.uniform draws");
+    check(same_draws("uniform", "-2 3", 0), "empty fill should not draw");
+    check(same_draws("normal", "0.5 2", 7), "rng.fill-normal! should match rng.normal draws");
+    check(same_draws("int", "6", 25), "rng.fill-int! should match rng.int draws");
+
+    // The vec is resized to n in place and returned.
+    value reused = eval_text("(begin (define r (rng.make 3)) (define v (vec.make)) (vec.push! v 'x) "
+                             "(rng.fill-uniform! r v 4 0 1) (list (eq? v (rng.fill-int! r v 3 2)) (vec.len v)))",
+                             env);
+    check(print_value(reused) == "(#t 3)", "bulk fills should resize and return the vec they were given");
+    check(print_value(eval_text("(begin (rng.fill-normal! r v 2 4.0 0) (list (vec.len v) (vec.get v 0) (vec.get v 1)))",
+                                env)) == "(2 4.0 4.0)",
+          "sigma 0 should fill with mu");
+
+    expect_lisp_error_message("(rng.fill-uniform! r v 3 2 1)", env, "rng.fill-uniform!: expected lo <= hi",
+                              "fill-uniform bounds");
+    expect_lisp_error_message("(rng.fill-normal! r v 3 0 -1)", env, "rng.fill-normal!: expected sigma >= 0",
+                              "fill-normal sigma");
+    expect_lisp_error_message("(rng.fill-int! r v 3 0)", env, "rng.fill-int!: expected n > 0", "fill-int bound");
+}
+
+void test_f64vec_arithmetic_and_conversions() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
+    (void)eval_text("(define a (f64vec.from '(1 2 3 4 5)))", env);
+    (void)eval_text("(define b (f64vec.make 5 2))", env);
+    check(print_value(eval_text("a", env)) == "<f64vec:5>", "f64vec should print its length");
+    check(print_value(eval_text("(f64vec.to-list (f64vec.add a b))", env)) == "(3.0 4.0 5.0 6.0 7.0)",
+          "f64vec.add should add elementwise");
+    check(print_value(eval_text("(f64vec.to-list (f64vec.mul a b))", env)) == "(2.0 4.0 6.0 8.0 10.0)",
+          "f64vec.mul should multiply elementwise");
+    check(print_value(eval_text("(f64vec.to-list (f64vec.scale a 0.5))", env)) == "(0.5 1.0 1.5 2.0 2.5)",
+          "f64vec.scale should scale every element");
+    check(float_value(eval_text("(f64vec.dot a b)", env)) == 30.0, "f64vec.dot should cover the tail past four lanes");
+    check(float_value(eval_text("(f64vec.norm (f64vec.from '(3 4)))", env)) == 5.0, "f64vec.norm is the L2 norm");
+
+    // A destination argument is written in place, and may alias an input.
+    check(print_value(eval_text("(begin (f64vec.add a b a) (f64vec.scale a 2 a) (f64vec.to-list a))", env)) ==
+              "(6.0 8.0 10.0 12.0 14.0)",
+          "in-place destinations should be updated and returned");
+
+    (void)eval_text("(define scan (f64vec.from (list 4 -1 9.5 2 9.5 0 3 -7 1)))", env);
+    check(float_value(eval_text("(f64vec.min scan)", env)) == -7.0, "f64vec.min should find the smallest element");
+    check(float_value(eval_text("(f64vec.max scan)", env)) == 9.5, "f64vec.max should find the largest element");
+    check(integer_value(eval_text("(f64vec.argmax scan)", env)) == 2, "f64vec.argmax should return the first maximum");
+    check(print_value(eval_text("(begin (f64vec.set! scan 8 20) (list (f64vec.get scan 8) (f64vec.argmax scan)))", env)) ==
+              "(20.0 8)",
+          "f64vec.set! should store numbers as floats");
+
+    // Snapshots keep the raw doubles.
+    const auto path = temp_file_path("f64vec", ".snapshot");
+    const std::string path_lisp = lisp_string_literal(path.string());
+    (void)eval_text("(snapshot.save " + path_lisp + ")", env);
+    reset_bt_runtime_host();
+    env_ptr restored = create_global_env();
+    (void)eval_text("(snapshot.load " + path_lisp + ")", restored);
+    check(print_value(eval_text("(f64vec.to-list a)", restored)) == "(6.0 8.0 10.0 12.0 14.0)",
+          "f64vecs should round-trip through snapshots");
+    std::filesystem::remove(path);
+
+    // Blackboard values go in and out without passing through lists.
+    (void)eval_text("(define inst (bt.new-instance (bt.compile '(act always-success))))", env);
+    (void)eval_text("(bt.tick inst (list (list 'scan scan)))", env);
+    check(print_value(eval_text("(bt.blackboard.get inst 'scan)", env)) == "(4.0 -1.0 9.5 2.0 9.5 0.0 3.0 -7.0 20.0)",
+          "f64vec blackboard inputs should be stored as numeric vectors");
+    check(float_value(eval_text("(f64vec.dot (bt.blackboard.get-f64vec inst 'scan) (f64vec.make 9 1))", env)) == 40.0,
+          "bt.blackboard.get-f64vec should read numeric vectors back");
+    check(is_nil(eval_text("(bt.blackboard.get-f64vec inst 'missing)", env)), "missing keys should return the default");
+    check(string_value(eval_text("(json.encode (f64vec.from '(1 0.5)))", env)) == "[1,0.5]",
+          "json.encode should write f64vecs as arrays");
+
+    expect_lisp_error_message("(f64vec.add a (f64vec.make 2))", env, "f64vec.add: length mismatch (5 vs 2)",
+                              "f64vec length mismatch");
+    expect_lisp_error_message("(f64vec.max (f64vec.make 0))", env, "f64vec.max: f64vec is empty", "f64vec empty max");
+    expect_lisp_error_message("(f64vec.from '(1 x))", env, "f64vec.from: expected numeric value", "f64vec non-numeric");
+    expect_lisp_error_message("(f64vec.scale a 2 (f64vec.make 3))", env, "f64vec.scale: destination length mismatch",
+                              "f64vec destination length");
+}
+
+void test_rng_determinism_and_ranges() {
+    using namespace muslisp;
+
+    env_ptr env = create_global_env();
+    value seq = eval_text(
+        "(begin "
+        "  (define r (rng.make 42)) "
+        "  (list "
+        "    (rng.int r 1000) "
+        "    (rng.int r 1000) "
+        "    (rng.int r 1000) "
+        "    (rng.int r 1000) "
+        "    (rng.int r 1000) "
+        "    (rng.int r 1000) "
+        "    (rng.int r 1000) "
+        "    (rng.int r 1000)))",
+        env);
+    const std::vector<value> items = vector_from_list(seq);
+    const std::vector<std::int64_t> expected = {413, 291, 858, 764, 250, 62, 925, 908};
+    check(items.size() == expected.size(), "rng.int deterministic sequence size mismatch");
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        check(is_integer(items[i]), "rng.int should return integer");
+        check(integer_value(items[i]) == expected[i], "rng.int deterministic sequence mismatch");
+    }
+
+    value uniform_ok = eval_text(
+        "(begin "
+        "  (define r (rng.make 7)) "
+        "  (define (check i) "
+        "    (if (= i 0) #t "
+        "      (let ((x (rng.uniform r -1.25 3.5))) "
+        "        (if (>= x -1.25) (if (<= x 3.5) (check (- i 1)) #f) #f)))) "
+        "  (check 200))",
+        env);
+    check(is_boolean(uniform_ok) && boolean_value(uniform_ok), "rng.uniform range check failed");
+
+    value int_ok = eval_text(
+        "(begin "
+        "  (define r (rng.make 9)) "
+        "  (define (check i) "
+        "    (if (= i 0) #t "
+        "      (let ((x (rng.int r 17))) "
+        "        (if (>= x 0) (if (< x 17) (check (- i 1)) #f) #f)))) "
+        "  (check 200))",
+        env);
+    check(is_boolean(int_ok) && boolean_value(int_ok), "rng.int range check failed");
+
+    value normal_repeat = eval_text(
+        "(begin "
+        "  (define r1 (rng.make 123)) "
+        "  (define r2 (rng.make 123)) "
+        "  (define a1 (rng.normal r1 0.0 1.0)) "
+        "  (define a2 (rng.normal r1 0.0 1.0)) "
+        "  (define b1 (rng.normal r2 0.0 1.0)) "
+        "  (define b2 (rng.normal r2 0.0 1.0)) "
+        "  (if (= a1 b1) (= a2 b2) #f))",
+        env);
+    check(is_boolean(normal_repeat) && boolean_value(normal_repeat), "rng.normal should be deterministic for fixed seed");
+
+    try {
+        (void)eval_text("(begin (define r (rng.make 1)) (rng.int r 0))", env);
+        throw std::runtime_error("expected rng.int n>0 validation error");
+    } catch (const lisp_error&) {
+    }
+    try {
+        (void)eval_text("(begin (define r (rng.make 1)) (rng.normal r 0.0 -1.0))", env);
+        throw std::runtime_error("expected rng.normal sigma>=0 validation error");
+    } catch (const lisp_error&) {
+    }
+}
+
+void test_vec_gc_growth_and_fuzz() {
+    using namespace muslisp;
+
+    env_ptr env = create_global_env();
+    (void)eval_text("(define v (vec.make 1))", env);
+
+    for (int i = 0; i < 256; ++i) {
+        (void)eval_text("(vec.push! v (list 'item " + std::to_string(i) + "))", env);
+        if ((i % 23) == 0) {
+            default_gc().collect();
+        }
+    }
+    default_gc().collect();
+
+    value len = eval_text("(vec.len v)", env);
+    check(is_integer(len) && integer_value(len) == 256, "vec.len mismatch after growth");
+    for (int i = 0; i < 256; ++i) {
+        value got = eval_text("(vec.get v " + std::to_string(i) + ")", env);
+        check(print_value(got) == "(item " + std::to_string(i) + ")", "vec retained value mismatch after GC");
+    }
+
+    (void)eval_text("(vec.set! v 7 (list 'replaced 7))", env);
+    default_gc().collect();
+    check(print_value(eval_text("(vec.get v 7)", env)) == "(replaced 7)", "vec.set! overwrite mismatch");
+
+    std::vector<std::int64_t> model;
+    std::uint64_t state = 0x123456789abcdef0ull;
+    auto next = [&]() {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        return state;
+    };
+    (void)eval_text("(define vf (vec.make 2))", env);
+    for (int step = 0; step < 400; ++step) {
+        const std::uint64_t r = next();
+        if (model.empty() || (r % 3u == 0u)) {
+            const std::int64_t value_i = static_cast<std::int64_t>((next() % 4000u)) - 2000;
+            (void)eval_text("(vec.push! vf " + std::to_string(value_i) + ")", env);
+            model.push_back(value_i);
+        } else if (r % 3u == 1u) {
+            const std::size_t idx = static_cast<std::size_t>(next() % model.size());
+            const std::int64_t value_i = static_cast<std::int64_t>((next() % 4000u)) - 2000;
+            (void)eval_text("(vec.set! vf " + std::to_string(idx) + " " + std::to_string(value_i) + ")", env);
+            model[idx] = value_i;
+        } else {
+            const std::size_t idx = static_cast<std::size_t>(next() % model.size());
+            value got = eval_text("(vec.get vf " + std::to_string(idx) + ")", env);
+            check(is_integer(got), "vec.get in fuzz should return integer");
+            check(integer_value(got) == model[idx], "vec fuzz model mismatch");
+        }
+
+        if ((step % 37) == 0) {
+            default_gc().collect();
+        }
+    }
+    check(integer_value(eval_text("(vec.len vf)", env)) == static_cast<std::int64_t>(model.size()), "vec fuzz len mismatch");
+    for (std::size_t i = 0; i < model.size(); ++i) {
+        value got = eval_text("(vec.get vf " + std::to_string(i) + ")", env);
+        check(integer_value(got) == model[i], "vec fuzz final state mismatch");
+    }
+}
+
+void test_map_gc_rehash_and_ops() {
+    using namespace muslisp;
+
+    env_ptr env = create_global_env();
+    (void)eval_text("(define m (map.make))", env);
+
+    for (int i = 0; i < 400; ++i) {
+        const std::string key = "\"k" + std::to_string(i) + "\"";
+        (void)eval_text("(map.set! m " + key + " (list 'v " + std::to_string(i) + "))", env);
+        if ((i % 41) == 0) {
+            default_gc().collect();
+        }
+    }
+    default_gc().collect();
+
+    for (int i = 0; i < 400; ++i) {
+        const std::string key = "\"k" + std::to_string(i) + "\"";
+        value got = eval_text("(map.get m " + key + " nil)", env);
+        check(print_value(got) == "(v " + std::to_string(i) + ")", "map retrieval mismatch after GC/rehash");
+    }
+
+    (void)eval_text("(map.set! m \"k12\" (list 'new 12))", env);
+    check(print_value(eval_text("(map.get m \"k12\" nil)", env)) == "(new 12)", "map overwrite mismatch");
+    check(boolean_value(eval_text("(map.has? m \"k12\")", env)), "map.has? should be true");
+    check(boolean_value(eval_text("(map.del! m \"k12\")", env)), "map.del! should return true on existing key");
+    check(!boolean_value(eval_text("(map.has? m \"k12\")", env)), "map.has? should be false after delete");
+    check(boolean_value(eval_text("(null? (map.get m \"k12\" nil))", env)), "map.get should return default for missing key");
+
+    value keys = eval_text("(map.keys m)", env);
+    check(is_proper_list(keys), "map.keys should return a proper list");
+    check(integer_value(eval_text("(vec.len (vec.make 0))", env)) == 0, "sanity check for vec.make default path");
+
+    try {
+        (void)eval_text("(map.set! m '(bad key) 1)", env);
+        throw std::runtime_error("expected map key type validation error");
+    } catch (const lisp_error&) {
+    }
+}
+
+void test_persistent_pmap_pvec_share_and_seal() {
+    using namespace muslisp;
+
+    env_ptr env = create_global_env();
+    auto int_key = [](std::int64_t i) {
+        map_key key;
+        key.type = map_key_type::integer;
+        key.integer_data = i;
+        return key;
+    };
+
+    (void)eval_text("(define p0 (pmap.set (pmap.make) 'a 1))", env);
+    (void)eval_text("(define p1 (pmap.set p0 'b 2))", env);
+    (void)eval_text("(define p2 (pmap.del p1 'a))", env);
+    check(integer_value(eval_text("(pmap.count p0)", env)) == 1, "pmap.set should not change the old version");
+    check(integer_value(eval_text("(pmap.count p1)", env)) == 2, "pmap.set count mismatch");
+    check(!boolean_value(eval_text("(pmap.has? p2 'a)", env)), "pmap.del should drop the key");
+    check(integer_value(eval_text("(pmap.get p1 'a 0)", env)) == 1, "pmap.del should not change the old version");
+    check(print_value(eval_text("p1", env)) == "<pmap:2>", "pmap printer mismatch");
+
+    // Enough keys to force several trie levels; every older version must stay intact.
+    value versioned = make_pmap();
+    std::vector<value> versions;
+    for (int i = 0; i < 5000; ++i) {
+        versioned = pmap_assoc(versioned, int_key(i), make_integer(i * 2));
+        if ((i % 1000) == 0) {
+            versions.push_back(versioned);
+        }
+    }
+    gc_root_scope roots(default_gc());
+    roots.add(&versioned);
+    for (value& version : versions) {
+        roots.add(&version);
+    }
+    default_gc().collect();
+    check(pmap_count(versioned) == 5000, "large pmap count mismatch");
+    for (int i = 0; i < 5000; i += 7) {
+        const value* found = pmap_find(versioned, int_key(i));
+        check(found && integer_value(*found) == i * 2, "large pmap lookup mismatch");
+    }
+    check(pmap_count(versions[0]) == 1 && pmap_count(versions[4]) == 4001, "pmap snapshot counts mismatch");
+    check(pmap_find(versions[1], int_key(1001)) == nullptr, "pmap snapshot should not see later keys");
+    value shrunk = versioned;
+    roots.add(&shrunk);
+    for (int i = 0; i < 5000; i += 2) {
+        shrunk = pmap_dissoc(shrunk, int_key(i));
+    }
+    check(pmap_count(shrunk) == 2500 && pmap_count(versioned) == 5000, "pmap_dissoc should leave the source intact");
+
+    // Past 32 + 32 * 32 items the root overflows into a third level; pops must walk back down.
+    value vec_version = make_pvec();
+    roots.add(&vec_version);
+    for (int i = 0; i < 1100; ++i) {
+        vec_version = pvec_conj(vec_version, make_integer(i));
+    }
+    value vec_edited = pvec_assoc(vec_version, 1050, make_integer(-1));
+    roots.add(&vec_edited);
+    default_gc().collect();
+    check(pvec_count(vec_version) == 1100, "pvec count mismatch");
+    check(integer_value(pvec_get(vec_version, 1050)) == 1050, "pvec_assoc should not change the source");
+    check(integer_value(pvec_get(vec_edited, 1050)) == -1, "pvec_assoc mismatch");
+    for (int i = 0; i < 1100; ++i) {
+        check(integer_value(pvec_get(vec_version, static_cast<std::size_t>(i))) == i, "pvec lookup mismatch");
+    }
+    value popped = vec_version;
+    roots.add(&popped);
+    for (int i = 0; i < 1070; ++i) {
+        popped = pvec_pop(popped);
+    }
+    check(pvec_count(popped) == 30 && integer_value(pvec_get(popped, 29)) == 29, "pvec_pop mismatch");
+
+    (void)eval_text("(define t (pvec.transient (pvec.make)))", env);
+    (void)eval_text("(define (fill i) (if (< i 200) (begin (pvec.push! t (* i i)) (fill (+ i 1))) nil))", env);
+    (void)eval_text("(fill 0)", env);
+    check(integer_value(eval_text("(pvec.pop! t)", env)) == 199 * 199, "pvec.pop! should return the last item");
+    (void)eval_text("(define sealed (pvec.persistent! t))", env);
+    check(integer_value(eval_text("(pvec.len sealed)", env)) == 199, "sealed pvec length mismatch");
+    check(integer_value(eval_text("(pvec.get (pvec.set sealed 3 7) 3)", env)) == 7, "pvec.set after seal mismatch");
+    check(integer_value(eval_text("(pvec.get sealed 3)", env)) == 9, "sealed pvec should stay unchanged");
+    expect_lisp_error_message("(pvec.push! t 1)", env, "pvec.push!: transient used after persistent!", "sealed pvec transient");
+    expect_lisp_error_message("(pvec.push! sealed 1)", env, "pvec.push!: expected transient pvec", "persistent pvec push!");
+    expect_lisp_error_message("(pvec.get sealed 199)", env, "pvec.get: index out of range", "pvec index");
+
+    (void)eval_text("(define m (map.make))", env);
+    (void)eval_text("(map.set! m \"x\" 1)", env);
+    (void)eval_text("(define tm (pmap.transient (pmap.from-map m)))", env);
+    (void)eval_text("(pmap.set! tm \"y\" 2)", env);
+    check(boolean_value(eval_text("(pmap.del! tm \"x\")", env)), "pmap.del! should report a removed key");
+    (void)eval_text("(define pm (pmap.persistent! tm))", env);
+    check(print_value(eval_text("(pmap.keys pm)", env)) == "(\"y\")", "pmap transient batch mismatch");
+    expect_lisp_error_message("(pmap.set! tm 1 1)", env, "pmap.set!: transient used after persistent!", "sealed pmap transient");
+    expect_lisp_error_message("(pmap.get m 1 nil)", env, "pmap.get: expected pmap", "pmap type check");
+}
+
+void test_pq_builtins_gc_and_errors() {
+    using namespace muslisp;
+
+    env_ptr env = create_global_env();
+
+    value pq_value = eval_text("(pq.make)", env);
+    check(is_pq(pq_value), "pq.make should return pq handle");
+
+    value empty_meta = eval_text("(begin (define q0 (pq.make)) (list (pq.len q0) (pq.empty? q0)))", env);
+    {
+        const auto fields = vector_from_list(empty_meta);
+        check(fields.size() == 2, "pq empty metadata shape mismatch");
+        check(is_integer(fields[0]) && integer_value(fields[0]) == 0, "pq.len should start at zero");
+        check(is_boolean(fields[1]) && boolean_value(fields[1]), "pq.empty? should be true for new queue");
+    }
+
+    auto check_pair = [&](value pair_value, double expected_priority, const std::string& expected_symbol, const std::string& where) {
+        const auto pair = vector_from_list(pair_value);
+        check(pair.size() == 2, where + ": pair shape mismatch");
+        check(is_float(pair[0]), where + ": priority should be float");
+        check_close(float_value(pair[0]), expected_priority, 1e-12, where + ": priority mismatch");
+        check(is_symbol(pair[1]), where + ": payload should be symbol");
+        check(symbol_name(pair[1]) == expected_symbol, where + ": payload symbol mismatch");
+    };
+
+    value ordered = eval_text(
+        "(begin "
+        "  (define q1 (pq.make)) "
+        "  (list "
+        "    (pq.push! q1 3 'c) "
+        "    (pq.push! q1 1.5 'b) "
+        "    (pq.push! q1 1 'a) "
+        "    (pq.pop! q1) "
+        "    (pq.pop! q1) "
+        "    (pq.pop! q1) "
+        "    (pq.empty? q1)))",
+        env);
+    {
+        const auto fields = vector_from_list(ordered);
+        check(fields.size() == 7, "pq ordering result shape mismatch");
+        check(is_integer(fields[0]) && integer_value(fields[0]) == 1, "pq.push! should return size=1");
+        check(is_integer(fields[1]) && integer_value(fields[1]) == 2, "pq.push! should return size=2");
+        check(is_integer(fields[2]) && integer_value(fields[2]) == 3, "pq.push! should return size=3");
+        check_pair(fields[3], 1.0, "a", "pq.pop order[0]");
+        check_pair(fields[4], 1.5, "b", "pq.pop order[1]");
+        check_pair(fields[5], 3.0, "c", "pq.pop order[2]");
+        check(is_boolean(fields[6]) && boolean_value(fields[6]), "pq.empty? should be true after draining");
+    }
+
+    value tie_order = eval_text(
+        "(begin "
+        "  (define q2 (pq.make)) "
+        "  (pq.push! q2 2 'first) "
+        "  (pq.push! q2 2.0 'second) "
+        "  (list (pq.pop! q2) (pq.pop! q2)))",
+        env);
+    {
+        const auto fields = vector_from_list(tie_order);
+        check(fields.size() == 2, "pq tie-order result shape mismatch");
+        check_pair(fields[0], 2.0, "first", "pq tie-order[0]");
+        check_pair(fields[1], 2.0, "second", "pq tie-order[1]");
+    }
+
+    value peek_meta = eval_text(
+        "(begin "
+        "  (define q3 (pq.make)) "
+        "  (pq.push! q3 4 'x) "
+        "  (list (pq.peek q3) (pq.len q3) (pq.pop! q3) (pq.empty? q3)))",
+        env);
+    {
+        const auto fields = vector_from_list(peek_meta);
+        check(fields.size() == 4, "pq.peek metadata shape mismatch");
+        check_pair(fields[0], 4.0, "x", "pq.peek pair");
+        check(is_integer(fields[1]) && integer_value(fields[1]) == 1, "pq.peek should not mutate queue");
+        check_pair(fields[2], 4.0, "x", "pq.pop after peek");
+        check(is_boolean(fields[3]) && boolean_value(fields[3]), "queue should be empty after pop");
+    }
+
+    eval_text(
+        "(begin "
+        "  (define qgc (pq.make)) "
+        "  (define (fill i) "
+        "    (if (= i 64) "
+        "        nil "
+        "        (begin "
+        "          (pq.push! qgc i (list 'node i (list i (+ i 1)))) "
+        "          (fill (+ i 1))))) "
+        "  (fill 0))",
+        env);
+    default_gc().collect();
+    for (int i = 0; i < 64; ++i) {
+        value entry = eval_text("(pq.pop! qgc)", env);
+        const auto pair = vector_from_list(entry);
+        check(pair.size() == 2, "pq gc payload pair shape mismatch");
+        check(is_float(pair[0]), "pq gc payload priority should be float");
+        check_close(float_value(pair[0]), static_cast<double>(i), 1e-12, "pq gc payload priority mismatch");
+        const std::string expected = "(node " + std::to_string(i) + " (" + std::to_string(i) + " " + std::to_string(i + 1) + "))";
+        check(print_value(pair[1]) == expected, "pq gc payload value mismatch");
+        if ((i % 9) == 0) {
+            default_gc().collect();
+        }
+    }
+    check(boolean_value(eval_text("(pq.empty? qgc)", env)), "pq should be empty after gc-drain loop");
+
+    auto expect_lisp_error = [&](const std::string& expr, const std::string& label) {
+        try {
+            (void)eval_text(expr, env);
+            throw std::runtime_error("expected lisp_error: " + label);
+        } catch (const lisp_error&) {
+        }
+    };
+
+    expect_lisp_error("(begin (define qe (pq.make)) (pq.pop! qe))", "pq.pop! on empty");
+    expect_lisp_error("(begin (define qe (pq.make)) (pq.peek qe))", "pq.peek on empty");
+    expect_lisp_error("(begin (define qe (pq.make)) (pq.push! qe 'bad 1))", "pq.push! non-numeric priority");
+    expect_lisp_error("(begin (define qe (pq.make)) (pq.push! qe (/ 1 0) 1))", "pq.push! infinite priority");
+    expect_lisp_error("(begin (define qe (pq.make)) (pq.push! qe (/ 0 0) 1))", "pq.push! nan priority");
+    expect_lisp_error("(write-to-string (pq.make))", "write-to-string should reject pq");
+}
+
+void test_pq_handles_update_remove_and_heapify() {
+    using namespace muslisp;
+
+    env_ptr env = create_global_env();
+
+    // Random inserts, updates and removes against a brute-force model, then a full drain.
+    value pq_obj = make_pq();
+    pq_payload& queue = pq_obj->pq_data();
+    struct model_entry {
+        double priority;
+        std::uint64_t sequence;
+        std::int64_t id;
+    };
+    std::vector<std::optional<model_entry>> model;
+    std::uint64_t rng = 0x1234567u;
+    const auto next = [&rng](std::uint64_t bound) {
+        rng = rng * 6364136223846793005ull + 1442695040888963407ull;
+        return (rng >> 33u) % bound;
+    };
+    std::vector<std::uint32_t> live;
+    std::int64_t next_id = 0;
+    for (int step = 0; step < 2000; ++step) {
+        const std::uint64_t op = live.empty() ? 0 : next(4);
+        if (op <= 1) {
+            const double priority = static_cast<double>(next(50));
+            const std::uint64_t sequence = queue.next_sequence;
+            const std::uint32_t slot = queue.insert(priority, make_integer(next_id));
+            if (slot >= model.size()) {
+                model.resize(slot + 1u);
+            }
+            check(!model[slot].has_value(), "pq insert should claim a free slot");
+            model[slot] = model_entry{priority, sequence, next_id++};
+            live.push_back(slot);
+        } else {
+            const std::size_t pick = next(live.size());
+            const std::uint32_t slot = live[pick];
+            if (op == 2) {
+                const double priority = static_cast<double>(next(50));
+                queue.update(slot, priority);
+                model[slot]->priority = priority;
+            } else {
+                check(integer_value(queue.slot_payloads[slot]) == model[slot]->id, "pq payload should follow its slot");
+                (void)queue.remove(slot);
+                model[slot].reset();
+                live[pick] = live.back();
+                live.pop_back();
+            }
+        }
+    }
+    check(queue.size() == live.size(), "pq size should match the model");
+    while (queue.size() > 0) {
+        std::optional<std::uint32_t> best;
+        for (std::uint32_t slot = 0; slot < model.size(); ++slot) {
+            if (model[slot] && (!best || model[slot]->priority < model[*best]->priority ||
+                                (model[slot]->priority == model[*best]->priority &&
+                                 model[slot]->sequence < model[*best]->sequence))) {
+                best = slot;
+            }
+        }
+        const std::uint32_t top = queue.heap.front().slot;
+        check(best.has_value() && top == *best, "pq should pop in (priority, insertion) order after updates");
+        (void)queue.remove(top);
+        model[top].reset();
+    }
+
+    // The Lisp surface: handles from insert!, decrease-key, remove by handle.
+    value drained = eval_text("(begin (define q (pq.make)) (define a (pq.insert! q 5 'a)) (define b (pq.insert! q 3 'b)) "
+                              "(define c (pq.insert! q 4 'c)) (pq.update! q a 1) (pq.update! q b 9) "
+                              "(list (pq.remove! q c) (pq.pop! q) (pq.pop! q) (pq.empty? q)))",
+                              env);
+    check(print_value(drained) == "((4.0 c) (1.0 a) (9.0 b) #t)", "pq.update!/pq.remove! should reorder by handle");
+    expect_lisp_error_message("(pq.update! q a 2)", env, "pq.update!: handle is not in the queue", "stale pq handle");
+    expect_lisp_error_message("(pq.remove! q -1)", env, "pq.remove!: handle is not in the queue", "negative pq handle");
+
+    // from-list heapifies in one pass; entry i gets handle i and ties keep list order.
+    value built = eval_text("(begin (define h (pq.from-list (list (list 7 'g) (list 2 'x) (list 2 'y) (list 0.5 'z) "
+                            "(list 9 'n) (list 3 'k)))) (pq.update! h 0 0) "
+                            "(list (pq.len h) (pq.pop! h) (pq.pop! h) (pq.pop! h) (pq.pop! h)))",
+                            env);
+    check(print_value(built) == "(6 (0.0 g) (0.5 z) (2.0 x) (2.0 y))", "pq.from-list should heapify with list-order ties");
+    expect_lisp_error_message("(pq.from-list (list (list 1)))", env,
+                              "pq.from-list: expected list of (priority value) pairs", "pq.from-list shape");
+
+    // Handles survive a snapshot round trip.
+    reset_bt_runtime_host();
+    (void)eval_text("(define saved (pq.make)) (define far (pq.insert! saved 8 'far))", env);
+    (void)eval_text("(define near (pq.insert! saved 2 'near))", env);
+    const auto path = temp_file_path("pq_handles", ".snapshot");
+    const std::string path_lisp = lisp_string_literal(path.string());
+    (void)eval_text("(snapshot.save " + path_lisp + ")", env);
+    env_ptr restored = create_global_env();
+    (void)eval_text("(snapshot.load " + path_lisp + ")", restored);
+    check(print_value(eval_text("(begin (pq.update! saved far 0) (list (pq.pop! saved) (pq.remove! saved near) "
+                                "(pq.empty? saved)))",
+                                restored)) == "((0.0 far) (2.0 near) #t)",
+          "pq handles should survive snapshots");
+    std::filesystem::remove(path);
+}
+
+void test_continuous_mcts_smoke_deterministic() {
+    using namespace muslisp;
+
+    env_ptr env = create_global_env();
+    const std::string program =
+        "(begin "
+        "  (define goal 1.0) "
+        "  (define (step x a) "
+        "    (let ((a2 (clamp a -1.0 1.0))) "
+        "      (let ((x2 (+ x (* 0.25 a2)))) "
+        "        (- 0.0 (abs (- goal x2)))))) "
+        "  (define (pw-allow? n-visits n-children k alpha) "
+        "    (< n-children (* k (exp (* alpha (log (if (< n-visits 1) 1 n-visits))))))) "
+        "  (define (ucb q n parent-n c) "
+        "    (if (= n 0) 1.0e30 (+ q (* c (sqrt (/ (log (if (< parent-n 1) 1 parent-n)) n)))))) "
+        "  (define (child.new a) "
+        "    (let ((m (map.make))) "
+        "      (begin (map.set! m 'a a) (map.set! m 'n 0) (map.set! m 'w 0.0) m))) "
+        "  (define (child.q ch) "
+        "    (let ((n (map.get ch 'n 0)) (w (map.get ch 'w 0.0))) "
+        "      (if (= n 0) 0.0 (/ w n)))) "
+        "  (define (node.new) "
+        "    (let ((m (map.make))) "
+        "      (begin (map.set! m 'n 0) (map.set! m 'w 0.0) (map.set! m 'children (vec.make 4)) m))) "
+        "  (define (select-child children i nch parent-n c best best-score) "
+        "    (if (>= i nch) "
+        "        best "
+        "        (let ((ch (vec.get children i))) "
+        "          (let ((score (ucb (child.q ch) (map.get ch 'n 0) parent-n c))) "
+        "            (if (> score best-score) "
+        "                (select-child children (+ i 1) nch parent-n c ch score) "
+        "                (select-child children (+ i 1) nch parent-n c best best-score)))))) "
+        "  (define (simulate root x rng c k alpha) "
+        "    (let ((n (map.get root 'n 0)) (children (map.get root 'children nil))) "
+        "      (let ((nch (vec.len children))) "
+        "        (if (pw-allow? n nch k alpha) "
+        "            (let ((a (rng.uniform rng -1.0 1.0))) "
+        "              (let ((ch (child.new a)) (v (step x a))) "
+        "                (begin "
+        "                  (vec.push! children ch) "
+        "                  (map.set! ch 'n (+ (map.get ch 'n 0) 1)) "
+        "                  (map.set! ch 'w (+ (map.get ch 'w 0.0) v)) "
+        "                  (map.set! root 'n (+ n 1)) "
+        "                  (map.set! root 'w (+ (map.get root 'w 0.0) v)) "
+        "                  v))) "
+        "            (let ((ch (select-child children 0 nch n c nil -1.0e30))) "
+        "              (let ((v (step x (map.get ch 'a 0.0)))) "
+        "                (begin "
+        "                  (map.set! ch 'n (+ (map.get ch 'n 0) 1)) "
+        "                  (map.set! ch 'w (+ (map.get ch 'w 0.0) v)) "
+        "                  (map.set! root 'n (+ n 1)) "
+        "                  (map.set! root 'w (+ (map.get root 'w 0.0) v)) "
+        "                  v))))))) "
+        "  (define (search-loop root x rng i iters c k alpha) "
+        "    (if (>= i iters) "
+        "        root "
+        "        (begin "
+        "          (simulate root x rng c k alpha) "
+        "          (search-loop root x rng (+ i 1) iters c k alpha)))) "
+        "  (define (best-child children i nch best best-n) "
+        "    (if (>= i nch) "
+        "        best "
+        "        (let ((ch (vec.get children i)) (cn (map.get (vec.get children i) 'n 0))) "
+        "          (if (> cn best-n) "
+        "              (best-child children (+ i 1) nch ch cn) "
+        "              (best-child children (+ i 1) nch best best-n))))) "
+        "  (define (mcts.search x0 seed iters) "
+        "    (let ((rng (rng.make seed)) (root (node.new)) (c 1.2) (k 2.0) (alpha 0.5)) "
+        "      (begin "
+        "        (search-loop root x0 rng 0 iters c k alpha) "
+        "        (let ((children (map.get root 'children nil))) "
+        "          (let ((best (best-child children 0 (vec.len children) nil -1))) "
+        "            (map.get best 'a 0.0)))))) "
+        "  (let ((a1 (mcts.search 0.0 42 350)) (a2 (mcts.search 0.0 42 350))) "
+        "    (list a1 a2)))";
+
+    value out = eval_text(program, env);
+    const std::vector<value> pair = vector_from_list(out);
+    check(pair.size() == 2, "mcts smoke output shape mismatch");
+    check(is_float(pair[0]) && is_float(pair[1]), "mcts smoke should return float actions");
+    const double a1 = float_value(pair[0]);
+    const double a2 = float_value(pair[1]);
+    check(a1 > 0.0, "mcts smoke action should move toward positive goal");
+    check_close(a1, a2, 1e-12, "mcts smoke should be deterministic for fixed seed");
+}
+
+void test_mcts_tree_reuse_warm_starts_from_executed_action() {
+    using namespace muslisp;
+
+    bt::planner_service planner;
+    bt::planner_mcts_tree tree;
+    bt::planner_request request;
+    request.planner = bt::planner_backend::mcts;
+    request.model_service = "toy-1d";
+    request.state = {0.0};
+    request.budget_ms = 1000;
+    request.work_max = 400;
+    request.seed = 7;
+    request.mcts_tree = &tree;
+
+    const bt::planner_result first = planner.plan(request);
+    check(first.trace.mcts.reused_visits == 0, "a fresh MCTS tree should report no reused visits");
+    check(tree.retained_nodes() > 0, "MCTS should keep the subtree under the returned action");
+
+    // toy-1d moves by 0.25 * action, so this is the state the retained subtree was grown for.
+    request.state = {0.25 * first.action.u[0]};
+    const bt::planner_result second = planner.plan(request);
+    check(second.trace.mcts.reused_visits > 0, "a matching state should warm-start from the retained subtree");
+    check(second.trace.mcts.root_visits == second.trace.mcts.reused_visits + second.stats.work_done,
+          "root visits should combine reused visits and this search's iterations");
+
+    request.state = {0.9};
+    const bt::planner_result moved = planner.plan(request);
+    check(moved.trace.mcts.reused_visits == 0, "a state outside the tolerance should start a fresh tree");
+
+    request.state = {0.0};
+    request.mcts.reuse_max_nodes = 1;
+    (void)planner.plan(request);
+    check(tree.retained_nodes() == 1, "the retained subtree should be capped at reuse_max_nodes");
+
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
+    (void)eval_text(
+        "(define tree "
+        "  (bt.compile "
+        "    '(seq "
+        "       (plan-action :name \"warm-plan\" :planner :mcts :budget_ms 1000 :work_max 200 :reuse_tree #t "
+        "                    :model_service \"toy-1d\" :state_key state :action_key action :meta_key plan-meta) "
+        "       (act apply-planned-1d state action state))))",
+        env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    check(symbol_name(eval_text("(bt.tick inst '((state 0.0)))", env)) == "success", "warm plan tick 1 should succeed");
+    check(symbol_name(eval_text("(bt.tick inst)", env)) == "success", "warm plan tick 2 should succeed");
+
+    bt::instance* inst = bt::default_runtime_host().find_instance(bt_handle(eval_text("inst", env)));
+    check(inst && std::any_of(inst->memory.begin(),
+                              inst->memory.end(),
+                              [](const bt::node_memory& mem) { return mem.payload.holds<bt::planner_mcts_tree>(); }),
+          "plan-action :reuse_tree should keep its tree in node memory");
+    const bt::bb_entry* meta = inst->bb.get("plan-meta");
+    const std::string* meta_text = meta ? std::get_if<std::string>(&meta->value) : nullptr;
+    check(meta_text && meta_text->find("\"reused_visits\":0") == std::string::npos &&
+              meta_text->find("\"reused_visits\":") != std::string::npos,
+          "the second plan-action tick should reuse the first tick's tree");
+}
+
+void test_mcts_parallel_modes_are_reproducible() {
+    bt::planner_service planner;
+    bt::thread_pool_scheduler sched(4);
+    bt::planner_request request;
+    request.planner = bt::planner_backend::mcts;
+    request.model_service = "toy-1d";
+    request.state = {0.0};
+    request.budget_ms = 10000;
+    request.work_max = 300;
+    request.seed = 11;
+    request.mcts.threads = 4;
+
+    for (const char* mode : {"root", "tree"}) {
+        request.mcts.parallelism = mode;
+        planner.set_scheduler(&sched);
+        const bt::planner_result pooled = planner.plan(request);
+        const bt::planner_result again = planner.plan(request);
+        planner.set_scheduler(nullptr);
+        const bt::planner_result inline_run = planner.plan(request);
+
+        const std::string where = std::string("mcts ") + mode + " parallelism";
+        check(pooled.status == bt::planner_status::ok, where + " should plan");
+        check(pooled.action.u.size() == 1 && pooled.action.u[0] > 0.0, where + " should move toward the goal");
+        check(pooled.action.u == again.action.u && pooled.action.u == inline_run.action.u &&
+                  pooled.trace.mcts.root_visits == inline_run.trace.mcts.root_visits &&
+                  pooled.trace.mcts.root_children == inline_run.trace.mcts.root_children,
+              where + " should not depend on worker availability");
+        const std::int64_t expected_work = std::string(mode) == "root" ? 4 * request.work_max : request.work_max;
+        check(pooled.stats.work_done == expected_work, where + " work_done mismatch");
+    }
+
+    // A plan running on the only worker still finishes: it runs the shares nobody else picks up.
+    bt::thread_pool_scheduler single(1);
+    planner.set_scheduler(&single);
+    request.mcts.parallelism = "root";
+    const bt::job_id id = single.submit(bt::job_request{
+        .task_name = "plan", .fn = [&planner, request] { return bt::job_result{.payload = planner.plan(request)}; }});
+    const auto give_up = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (single.get_info(id).status != bt::job_status::done && std::chrono::steady_clock::now() < give_up) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    check(single.get_info(id).status == bt::job_status::done, "a parallel plan on a saturated pool should not deadlock");
+
+    request.mcts.parallelism = "sideways";
+    check(planner.plan(request).status == bt::planner_status::error, "unknown mcts parallelism should be an error");
+}
+
+class batch_probe_model final : public bt::planner_model {
+public:
+    explicit batch_probe_model(bool batched) : batched_(batched) {}
+
+    bt::planner_step_result step(const bt::planner_vector& state, const bt::planner_vector& action, bt::planner_rng&) const override {
+        const double x = state[0] + 0.1 * (action[0] - action[1]);
+        return bt::planner_step_result{{x}, -((x - 1.0) * (x - 1.0)), false};
+    }
+    bt::planner_vector sample_action(const bt::planner_vector&, bt::planner_rng& rng) const override {
+        return {rng.uniform(-1.0, 1.0), rng.uniform(-1.0, 1.0)};
+    }
+    bt::planner_vector clamp_action(const bt::planner_vector& action) const override { return action; }
+    bt::planner_vector zero_action() const override { return {0.0, 0.0}; }
+    std::size_t action_dims() const override { return 2; }
+
+    bool rollout_cost_batch(const bt::planner_vector& state,
+                            const bt::planner_action_batch& batch,
+                            std::span<double> costs,
+                            bt::planner_rng&) const override {
+        if (!batched_) {
+            return false;
+        }
+        for (std::size_t s = 0; s < batch.samples; ++s) {
+            double x = state[0];
+            double cost = 0.0;
+            for (std::size_t t = 0; t < batch.horizon; ++t) {
+                x = x + 0.1 * (batch.row(t, 0)[s] - batch.row(t, 1)[s]);
+                cost += (x - 1.0) * (x - 1.0);
+            }
+            costs[s] = cost;
+        }
+        ++batch_calls;
+        return true;
+    }
+
+    bool deterministic_step_batch(std::span<const bt::planner_vector> states,
+                                  std::span<const bt::planner_vector> actions,
+                                  std::span<bt::planner_step_result> out) const override {
+        if (!batched_) {
+            return false;
+        }
+        bt::planner_rng unused(0);
+        for (std::size_t i = 0; i < states.size(); ++i) {
+            out[i] = step(states[i], actions[i], unused);
+        }
+        ++step_batch_calls;
+        return true;
+    }
+
+    mutable int batch_calls = 0;
+    mutable std::atomic<int> step_batch_calls{0};
+
+private:
+    bool batched_;
+};
+
+void test_mppi_batched_rollouts_match_per_sample_rollouts() {
+    // fill_normal continues the normal() stream exactly, including the cached second value of a pair.
+    for (std::size_t n : {std::size_t{0}, std::size_t{1}, std::size_t{2}, std::size_t{7}, std::size_t{300}}) {
+        bt::planner_rng scalar(99);
+        bt::planner_rng batch(99);
+        (void)scalar.normal(0.0, 1.0);
+        (void)batch.normal(0.0, 1.0);
+        std::vector<double> filled(n);
+        batch.fill_normal(filled);
+        for (std::size_t i = 0; i < n; ++i) {
+            check(filled[i] == scalar.normal(0.0, 1.0), "fill_normal should match repeated normal() calls");
+        }
+        check(batch.normal(0.0, 1.0) == scalar.normal(0.0, 1.0), "fill_normal should leave the stream in step");
+    }
+
+    bt::planner_service planner;
+    auto batched = std::make_shared<batch_probe_model>(true);
+    planner.register_model("probe-batched", batched);
+    planner.register_model("probe-stepped", std::make_shared<batch_probe_model>(false));
+
+    bt::planner_request request;
+    request.planner = bt::planner_backend::mppi;
+    request.state = {0.0};
+    request.budget_ms = 10000;
+    request.horizon = 12;
+    request.seed = 5;
+    request.mppi.n_samples = 70;
+    request.mppi.sigma = {0.4, 0.0};
+    request.constraints.smoothness_weight = 0.05;
+    request.model_service = "probe-batched";
+    const bt::planner_result via_batch = planner.plan(request);
+    request.model_service = "probe-stepped";
+    const bt::planner_result via_step = planner.plan(request);
+
+    check(batched->batch_calls > 1, "MPPI should roll out blocks through rollout_cost_batch");
+    check(via_batch.status == bt::planner_status::ok && via_batch.action.u == via_step.action.u &&
+              via_batch.confidence == via_step.confidence && via_batch.stats.work_done == 70,
+          "batched and per-sample MPPI rollouts should agree exactly");
+}
+
+void test_mppi_threads_match_serial_result() {
+    bt::planner_service planner;
+    bt::thread_pool_scheduler sched(4);
+    planner.set_scheduler(&sched);
+    planner.register_model("probe-stepped", std::make_shared<batch_probe_model>(false));
+
+    for (const char* model : {"toy-1d", "probe-stepped"}) {
+        bt::planner_request request;
+        request.planner = bt::planner_backend::mppi;
+        request.model_service = model;
+        request.state = {0.2};
+        request.budget_ms = 10000;
+        request.horizon = 20;
+        request.seed = 17;
+        request.top_k = 4;
+        request.mppi.n_samples = 300;
+
+        request.mppi.threads = 1;
+        const bt::planner_result serial = planner.plan(request);
+        request.mppi.threads = 4;
+        const bt::planner_result sharded = planner.plan(request);
+
+        const std::string where = std::string("mppi threads on ") + model;
+        check(serial.status == bt::planner_status::ok && sharded.status == bt::planner_status::ok, where + " should plan");
+        check(serial.action.u == sharded.action.u && serial.confidence == sharded.confidence &&
+                  serial.stats.work_done == 300 && sharded.stats.work_done == 300,
+              where + " should match the serial result bit for bit");
+        check(serial.trace.mppi.top_k.size() == sharded.trace.mppi.top_k.size(), where + " top_k size mismatch");
+        for (std::size_t i = 0; i < serial.trace.mppi.top_k.size(); ++i) {
+            check(serial.trace.mppi.top_k[i].cost == sharded.trace.mppi.top_k[i].cost &&
+                      serial.trace.mppi.top_k[i].weight == sharded.trace.mppi.top_k[i].weight,
+                  where + " top_k should match");
+        }
+    }
+}
+
+void test_ilqr_finite_diff_threads_and_batches_match_serial() {
+    bt::planner_service planner;
+    bt::thread_pool_scheduler sched(4);
+    planner.set_scheduler(&sched);
+    auto batched = std::make_shared<batch_probe_model>(true);
+    planner.register_model("probe-stepped", std::make_shared<batch_probe_model>(false));
+    planner.register_model("probe-batched", batched);
+
+    bt::planner_request request;
+    request.planner = bt::planner_backend::ilqr;
+    request.state = {0.2};
+    request.budget_ms = 10000;
+    request.horizon = 15;
+    request.ilqr.derivatives = bt::planner_ilqr_derivatives_mode::finite_diff;
+
+    request.model_service = "probe-stepped";
+    const bt::planner_result serial = planner.plan(request);
+    check(serial.status == bt::planner_status::ok, "finite-diff iLQR should solve the probe model");
+    for (const char* model : {"probe-stepped", "probe-batched"}) {
+        for (std::int64_t threads : {1, 4}) {
+            request.model_service = model;
+            request.ilqr.threads = threads;
+            const bt::planner_result other = planner.plan(request);
+            const std::string where = std::string(model) + " threads=" + std::to_string(threads);
+            check(other.status == serial.status && other.action.u == serial.action.u &&
+                      other.trace.ilqr.iters == serial.trace.ilqr.iters &&
+                      other.trace.ilqr.cost_final == serial.trace.ilqr.cost_final,
+                  where + " should match the serial per-point solve");
+        }
+    }
+    check(batched->step_batch_calls.load() > 0, "a batching model should receive the perturbation points in batches");
+}
+
+void test_planner_linalg_kernels_match_reference() {
+    namespace la = bt::planner_linalg;
+
+    // M = G^T G + I is symmetric positive definite.
+    const std::size_t n = 4;
+    const std::vector<double> g = {1.0, 2.0, 0.5, -1.0, 0.0, 1.5, 2.0, 0.25, -0.5, 0.0, 1.0, 3.0, 2.0, -1.0, 0.0, 1.0};
+    std::vector<double> m(n * n, 0.0);
+    la::add_at_b(g.data(), g.data(), m.data(), n, n, n);
+    for (std::size_t i = 0; i < n; ++i) {
+        m[i * n + i] += 1.0;
+    }
+    std::vector<double> fixed(n * n, 0.0);
+    la::add_at_b<4, 4, 4>(g.data(), g.data(), fixed.data(), n, n, n);
+    for (std::size_t i = 0; i < n; ++i) {
+        fixed[i * n + i] += 1.0;
+    }
+    check(fixed == m, "fixed-size kernels should match run-time sizes");
+
+    const std::vector<double> x = {1.0, -2.0, 0.5, 3.0, 0.0, 1.0, -1.0, 2.0};  // 4 x 2
+    std::vector<double> b(n * 2, 0.0);
+    la::mul(m.data(), x.data(), b.data(), n, n, 2);
+    std::vector<double> factor = m;
+    check(la::cholesky<4>(factor.data(), n), "cholesky should factor an SPD matrix");
+    la::cholesky_solve<4>(factor.data(), b.data(), n, 2);
+    for (std::size_t i = 0; i < x.size(); ++i) {
+        check_close(b[i], x[i], 1.0e-9, "cholesky_solve should recover the right-hand side");
+    }
+
+    std::vector<double> indefinite = {1.0, 2.0, 2.0, 1.0};
+    check(!la::cholesky(indefinite.data(), 2), "cholesky should reject an indefinite matrix");
+}
+
+void test_ilqr_warm_start_shifts_previous_solution() {
+    using namespace muslisp;
+
+    bt::planner_service planner;
+    bt::planner_ilqr_warm_start warm;
+    bt::planner_request request;
+    request.planner = bt::planner_backend::ilqr;
+    request.model_service = "toy-1d";
+    request.state = {-1.0};
+    request.budget_ms = 1000;
+    request.horizon = 10;
+    request.ilqr.max_iters = 30;
+    request.ilqr_warm_start = &warm;
+
+    const bt::planner_result cold = planner.plan(request);
+    check(cold.status == bt::planner_status::ok, "cold iLQR solve should succeed");
+    check(!cold.trace.ilqr.warm_started && cold.trace.ilqr.iters_saved == 0,
+          "a fresh warm start should report a cold solve");
+    check(warm.retained_steps() == 10, "iLQR should keep the shifted control sequence");
+
+    // toy-1d moves by 0.25 * action, so this is where the executed first control leads.
+    request.state = {-1.0 + 0.25 * cold.action.u[0]};
+    const bt::planner_result warmed = planner.plan(request);
+    check(warmed.status == bt::planner_status::ok, "warm iLQR solve should succeed");
+    check(warmed.trace.ilqr.warm_started, "a matching horizon should start from the shifted sequence");
+    check(warmed.trace.ilqr.iters <= cold.trace.ilqr.iters, "the shifted sequence should not need more iterations");
+    check(warmed.trace.ilqr.iters_saved == cold.trace.ilqr.iters - warmed.trace.ilqr.iters,
+          "iters_saved should compare against the last cold solve");
+    check(warmed.trace.ilqr.cost_init <= cold.trace.ilqr.cost_init,
+          "the shifted sequence should start cheaper than zero controls");
+
+    request.horizon = 12;
+    const bt::planner_result resized = planner.plan(request);
+    check(!resized.trace.ilqr.warm_started, "a different horizon should start cold");
+
+    request.model_service = "missing-model";
+    (void)planner.plan(request);
+    check(warm.retained_steps() == 0, "an error result should drop the retained sequence");
+
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
+    (void)eval_text(
+        "(define tree "
+        "  (bt.compile "
+        "    '(seq "
+        "       (plan-action :name \"warm-ilqr\" :planner :ilqr :budget_ms 1000 :horizon 10 :warm_start #t "
+        "                    :model_service \"toy-1d\" :state_key state :action_key action :meta_key plan-meta) "
+        "       (act apply-planned-1d state action state))))",
+        env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    check(symbol_name(eval_text("(bt.tick inst '((state -1.0)))", env)) == "success", "warm iLQR tick 1 should succeed");
+    check(symbol_name(eval_text("(bt.tick inst)", env)) == "success", "warm iLQR tick 2 should succeed");
+
+    bt::instance* inst = bt::default_runtime_host().find_instance(bt_handle(eval_text("inst", env)));
+    check(inst && std::any_of(inst->memory.begin(),
+                              inst->memory.end(),
+                              [](const bt::node_memory& mem) { return mem.payload.holds<bt::planner_ilqr_warm_start>(); }),
+          "plan-action :warm_start should keep its solution in node memory");
+    const bt::bb_entry* meta = inst->bb.get("plan-meta");
+    const std::string* meta_text = meta ? std::get_if<std::string>(&meta->value) : nullptr;
+    check(meta_text && meta_text->find("\"warm_started\":true") != std::string::npos,
+          "the second plan-action tick should warm-start from the first tick's solution");
+}
+
+void test_planner_define_model_compiles_lisp_dynamics() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
+    // toy-1d written as Lisp: same dynamics, cost and done test, so plans should match bit for bit.
+    check(string_value(eval_text(
+              "(begin "
+              "  (define spec (map.make)) "
+              "  (map.set! spec 'state_dim 1) "
+              "  (map.set! spec 'bounds '((-1.0 1.0))) "
+              "  (map.set! spec 'next '((+ (vec.get x 0) (* 0.25 (vec.get u 0))))) "
+              "  (map.set! spec 'cost '(let ((err (- 1.0 (vec.get next 0)))) (* err err))) "
+              "  (map.set! spec 'done '(< (abs (- 1.0 (vec.get next 0))) 0.05)) "
+              "  (planner.define-model \"lisp-1d\" spec))",
+              env)) == "lisp-1d",
+          "planner.define-model should return the model name");
+
+    bt::planner_service& planner = bt::default_runtime_host().planner_ref();
+    for (bt::planner_backend backend : {bt::planner_backend::mppi, bt::planner_backend::ilqr}) {
+        bt::planner_request request;
+        request.planner = backend;
+        request.state = {-0.4};
+        request.budget_ms = 10000;
+        request.horizon = 12;
+        request.seed = 5;
+        request.ilqr.derivatives = bt::planner_ilqr_derivatives_mode::finite_diff;
+        request.model_service = "toy-1d";
+        const bt::planner_result native = planner.plan(request);
+        request.model_service = "lisp-1d";
+        const bt::planner_result compiled = planner.plan(request);
+        const std::string where = std::string("lisp-1d ") + bt::planner_backend_name(backend);
+        check(compiled.status == native.status && compiled.action.u == native.action.u &&
+                  compiled.confidence == native.confidence,
+              where + " should plan exactly like toy-1d");
+    }
+
+    gc_root_scope roots(default_gc());
+    bt::planner_model_definition def;
+    def.state_dim = 2;
+    def.action_bounds = {{-2.0, 2.0}};
+    def.next_state.push_back(read_one("(if (> (vec.get u 0) 0) (max (vec.get x 0) (vec.get x 1)) (- (vec.get x 0)))"));
+    roots.add(&def.next_state[0]);
+    def.next_state.push_back(read_one("(and (vec.get x 0) (or 0 (not 0)))"));
+    roots.add(&def.next_state[1]);
+    def.cost = read_one("(clamp (pow (vec.get u 0) 2) 0 3)");
+    roots.add(&def.cost);
+    const std::shared_ptr<bt::planner_model> model = bt::compile_planner_model("probe", def);
+    bt::planner_step_result out;
+    check(model->deterministic_step({1.5, 3.0}, {5.0}, out), "compiled models should step deterministically");
+    check(out.next_state == bt::planner_vector{3.0, 1.0} && out.reward == -3.0 && !out.done,
+          "compiled expressions should follow if/max/and/or/clamp/pow semantics and clamp the action");
+    check(model->deterministic_step({1.5, 3.0}, {-1.0}, out) && out.next_state == bt::planner_vector{-1.5, 1.0} &&
+              out.reward == -1.0,
+          "the false branch of if should be taken for a non-positive action");
+
+    const auto rejects = [&](const char* next, const char* fragment) {
+        bt::planner_model_definition bad = def;
+        bad.next_state[0] = read_one(next);
+        roots.add(&bad.next_state[0]);
+        try {
+            (void)bt::compile_planner_model("bad", bad);
+        } catch (const std::invalid_argument& e) {
+            return std::string(e.what()).find(fragment) != std::string::npos;
+        }
+        return false;
+    };
+    check(rejects("(print (vec.get x 0))", "unsupported operator 'print'"), "unknown operators should be rejected");
+    check(rejects("(vec.get next 0)", "vec.get expects x or u"), "next-state expressions cannot read next");
+    check(rejects("(vec.get x 2)", "index out of range"), "vec.get indices should be range-checked");
+    check(rejects("(+ y 1)", "unbound name 'y'"), "free names should be rejected");
+    check(rejects("(let ((y 2)) (* y (vec.get x 0)))", "") == false, "let-bound names should compile");
+}
+
+void test_planner_progress_streams_anytime_results() {
+    using namespace muslisp;
+
+    bt::planner_progress slot;
+    bt::planner_result seen;
+    check(!slot.take(seen) && !slot.finished(), "an empty progress slot should have nothing to take");
+    bt::planner_result partial;
+    partial.action.u = {0.1};
+    slot.publish(partial);
+    partial.action.u = {0.2};
+    slot.publish(partial);
+    check(slot.take(seen) && seen.action.u == bt::planner_vector{0.2}, "take should return the newest result");
+    check(!slot.take(seen), "take should not return the same result twice");
+    partial.action.u = {0.3};
+    slot.finish(partial);
+    check(slot.finished() && slot.take(seen) && seen.action.u == bt::planner_vector{0.3},
+          "the final result should follow finished()");
+    check(slot.published() == 3, "published should count the final result");
+
+    bt::planner_service planner;
+    bt::planner_request request;
+    request.model_service = "toy-1d";
+    request.state = {-1.0};
+    request.budget_ms = 5000;
+    request.seed = 17;
+    request.progress_interval_ms = 0;
+
+    const auto run_backend = [&](bt::planner_backend backend, const char* name) {
+        request.planner = backend;
+        request.progress = nullptr;
+        const bt::planner_result plain = planner.plan(request);
+
+        bt::planner_progress progress;
+        request.progress = &progress;
+        const bt::planner_result streamed = planner.plan(request);
+        check(streamed.action.u == plain.action.u && streamed.stats.work_done == plain.stats.work_done,
+              std::string(name) + ": publishing progress should not change the result");
+        check(progress.finished() && progress.published() >= 2,
+              std::string(name) + ": the backend should publish partial results before the final one");
+
+        bt::planner_result last;
+        check(progress.take(last) && last.action.u == streamed.action.u && last.stats.note.empty(),
+              std::string(name) + ": the slot should end with the final result");
+    };
+    request.work_max = 2000;
+    run_backend(bt::planner_backend::mcts, "mcts");
+    request.work_max = 0;
+    request.mppi.n_samples = 256;
+    run_backend(bt::planner_backend::mppi, "mppi");
+    request.horizon = 10;
+    run_backend(bt::planner_backend::ilqr, "ilqr");
+
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
+    (void)eval_text(
+        "(define tree "
+        "  (bt.compile "
+        "    '(plan-action :name \"anytime\" :planner :mcts :budget_ms 5000 :work_max 8000 :async #t "
+        "                  :progress_ms 1 :model_service \"toy-1d\" :state_key state :action_key action "
+        "                  :meta_key plan-meta)))",
+        env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    check(symbol_name(eval_text("(bt.tick inst '((state -1.0)))", env)) == "running",
+          "an :async plan-action should return running while it plans");
+
+    bt::instance* inst = bt::default_runtime_host().find_instance(bt_handle(eval_text("inst", env)));
+    bool saw_partial = false;
+    std::string final_status;
+    for (int i = 0; i < 500 && final_status.empty(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        const std::string st = symbol_name(eval_text("(bt.tick inst)", env));
+        const bt::bb_entry* meta = inst ? inst->bb.get("plan-meta") : nullptr;
+        const std::string* meta_text = meta ? std::get_if<std::string>(&meta->value) : nullptr;
+        if (st == "running") {
+            saw_partial = saw_partial || (meta_text && meta_text->find("\"note\":\"partial\"") != std::string::npos &&
+                                          inst->bb.get("action") != nullptr);
+        } else {
+            final_status = st;
+            check(meta_text && meta_text->find("\"note\":\"partial\"") == std::string::npos,
+                  "the final result should replace the partial meta");
+        }
+    }
+    check(saw_partial, "partial actions should reach the blackboard while the plan runs");
+    check(final_status == "success", "the :async plan should finish with its final result");
+
+    // Resetting the instance drops the node's slot, which cancels a plan still in flight.
+    (void)eval_text(
+        "(define long-tree "
+        "  (bt.compile "
+        "    '(plan-action :name \"long\" :planner :mcts :budget_ms 5000 :work_max 100000000 :async #t "
+        "                  :model_service \"toy-1d\" :state_key state :action_key action)))",
+        env);
+    (void)eval_text("(define long-inst (bt.new-instance long-tree))", env);
+    check(symbol_name(eval_text("(bt.tick long-inst '((state -1.0)))", env)) == "running",
+          "the long :async plan should start");
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    (void)eval_text("(bt.reset long-inst)", env);
+    bool cancelled = false;
+    for (int i = 0; i < 500 && !cancelled; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        for (const bt::planner_record& rec : bt::default_runtime_host().planner_ref().recent_records(4)) {
+            cancelled = cancelled || (rec.node_name == "long" && rec.note == "cancelled");
+        }
+    }
+    check(cancelled, "resetting the instance should cancel the running plan");
+}
+
+void test_planner_result_cache_quantised_state() {
+    bt::planner_service planner;
+    bt::planner_request request;
+    request.planner = bt::planner_backend::mcts;
+    request.model_service = "toy-1d";
+    request.state = {-1.0};
+    request.budget_ms = 1000;
+    request.work_max = 200;
+    request.seed = 1;
+    request.cache_quantum = 0.1;
+
+    const bt::planner_result first = planner.plan(request);
+    check(first.status == bt::planner_status::ok && first.stats.note.empty(), "the first plan should search");
+
+    request.state = {-1.02};
+    request.seed = 2;
+    const bt::planner_result hit = planner.plan(request);
+    check(hit.stats.note == "cache_hit" && hit.stats.work_done == 0 && hit.action.u == first.action.u,
+          "a state in the same cell should return the cached result");
+    const std::vector<bt::planner_record> records = planner.recent_records(1);
+    check(records.size() == 1 && records[0].note == "cache_hit", "the planner record should log the cache hit");
+
+    request.state = {-0.8};
+    check(planner.plan(request).stats.note.empty(), "a state in another cell should search");
+    request.state = {-1.0};
+    request.top_k = 5;
+    check(planner.plan(request).stats.note.empty(), "a different configuration should search");
+    request.top_k = 3;
+    request.cache_quantum = 0.0;
+    check(planner.plan(request).stats.note.empty(), "requests without a quantum should not use the cache");
+    request.cache_quantum = 0.1;
+    check(planner.plan(request).stats.note == "cache_hit", "the cached entry should still be there");
+
+    bt::planner_mcts_tree tree;
+    request.mcts_tree = &tree;
+    check(planner.plan(request).stats.note.empty(), "warm-started requests should not use the cache");
+    request.mcts_tree = nullptr;
+
+    planner.set_cache_capacity(1);
+    request.state = {0.5};
+    (void)planner.plan(request);
+    request.state = {-1.0};
+    check(planner.plan(request).stats.note.empty(), "capacity 1 should keep only the newest entry");
+
+    planner.set_cache_ttl_ms(0);
+    request.state = {0.9};
+    (void)planner.plan(request);
+    check(planner.plan(request).stats.note.empty(), "expired entries should not hit");
+    planner.set_cache_ttl_ms(750);
+    (void)planner.plan(request);
+    planner.set_cache_enabled(false);
+    check(planner.plan(request).stats.note.empty(), "a disabled cache should not hit");
+
+    reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
+    host.enable_deterministic_test_mode();
+    check(!host.planner_ref().cache_enabled(), "deterministic test mode should disable the planner cache");
+    host.disable_deterministic_test_mode();
+    check(host.planner_ref().cache_enabled(), "leaving deterministic test mode should enable the planner cache");
+}
+
+void test_planner_records_ring_and_jsonl_writer() {
+    const std::filesystem::path path = temp_file_path("planner_records", ".jsonl");
+    std::filesystem::remove(path);
+
+    std::vector<std::uint64_t> heard;
+    bt::planner_service planner;
+    planner.set_record_listener([&](const bt::planner_record& rec) { heard.push_back(rec.tick_index); });
+    planner.set_jsonl_path(path.string());
+
+    bt::planner_request request;
+    request.model_service = "toy-1d";
+    request.state = {-1.0};
+    request.work_max = 1;
+    request.tick_index = 1;
+    (void)planner.plan(request);
+
+    planner.set_jsonl_enabled(true);
+    for (std::uint64_t tick = 2; tick <= 4; ++tick) {
+        request.tick_index = tick;
+        (void)planner.plan(request);
+    }
+    planner.flush_jsonl();
+
+    std::ifstream in(path);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(in, line);) {
+        lines.push_back(line);
+    }
+    check(lines.size() == 3, "only records logged with JSONL on should reach the file");
+    check(!lines.empty() && lines.front().find("\"tick_index\":2") != std::string::npos &&
+              lines.back().find("\"tick_index\":4") != std::string::npos,
+          "the writer should keep record order");
+    check(planner.jsonl_dropped() == 0, "a flushed writer should not drop records");
+    check(heard == std::vector<std::uint64_t>{1, 2, 3, 4}, "the listener should see every record in order");
+
+    planner.set_jsonl_enabled(false);
+    for (std::uint64_t tick = 5; tick <= 4100; ++tick) {
+        request.tick_index = tick;
+        (void)planner.plan(request);
+    }
+    const std::vector<bt::planner_record> kept = planner.recent_records(10000);
+    check(kept.size() == 4096 && kept.front().tick_index == 5 && kept.back().tick_index == 4100,
+          "the record ring should keep the newest records in order");
+    check(planner.recent_records(2).front().tick_index == 4099, "recent_records should return the newest records");
+
+    planner.clear_records();
+    check(planner.recent_records(10).empty(), "clear_records should empty the history");
+    (void)planner.plan(request);
+    check(planner.recent_records(10).size() == 1, "records after clear_records should be kept");
+    std::filesystem::remove(path);
+}
+
+void test_planner_vector_inline_and_heap_storage() {
+    using bt::planner_vector;
+
+    planner_vector small{1.0, 2.0, 3.0};
+    check(small.is_inline() && small.size() == 3 && small[2] == 3.0, "short planner_vector should be inline");
+    check(reinterpret_cast<std::uintptr_t>(small.data()) % planner_vector::k_alignment == 0,
+          "inline planner_vector storage should be aligned");
+
+    planner_vector big(planner_vector::k_inline_capacity + 1, 0.5);
+    check(!big.is_inline() && big.size() == planner_vector::k_inline_capacity + 1, "long planner_vector should spill");
+    check(reinterpret_cast<std::uintptr_t>(big.data()) % planner_vector::k_alignment == 0,
+          "heap planner_vector storage should be aligned");
+
+    planner_vector grown;
+    for (std::size_t i = 0; i < 40; ++i) {
+        grown.push_back(static_cast<double>(i));
+    }
+    check(grown.size() == 40 && grown[0] == 0.0 && grown[39] == 39.0, "push_back past inline capacity keeps values");
+    grown.resize(2);
+    grown.insert(grown.end(), small.begin(), small.end());
+    grown.erase(grown.begin());
+    check(grown == planner_vector({1.0, 1.0, 2.0, 3.0}), "insert/erase should behave like std::vector");
+
+    const double* heap_data = big.data();
+    planner_vector moved(std::move(big));
+    check(moved.data() == heap_data && big.empty() && big.is_inline(), "moving a spilled vector should steal its block");
+    planner_vector moved_inline(std::move(small));
+    check(moved_inline == planner_vector({1.0, 2.0, 3.0}) && small.empty(), "moving an inline vector should copy it");
+    moved = moved_inline;
+    check(moved == moved_inline && moved.data() == heap_data, "copy-assignment should reuse a heap block");
+
+    const std::span<const double> view = moved_inline;
+    check(view.size() == 3 && view[1] == 2.0, "planner_vector should convert to a span");
+
+    bt::planner_service planner;
+    bt::planner_request request;
+    request.planner = bt::planner_backend::mcts;
+    request.state = {0.0};
+    request.budget_ms = 1000;
+    request.work_max = 64;
+    request.seed = 7;
+    const bt::planner_result result = planner.plan(request);
+    check(result.status == bt::planner_status::ok && result.action.u.is_inline(),
+          "planner actions of typical size should stay inline");
+}
+
+void test_planner_plan_builtin_determinism_bounds_budget_and_sanity() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
+
+    try {
+        (void)eval_text("(planner.plan (map.make))", env);
+        throw std::runtime_error("expected planner.plan request validation failure");
+    } catch (const lisp_error&) {
+    }
+
+    value out = eval_text(
+        "(begin "
+        "  (define req (map.make)) "
+        "  (map.set! req 'schema_version \"planner.request.v1\") "
+        "  (map.set! req 'planner \"mcts\") "
+        "  (map.set! req 'model_service \"toy-1d\") "
+        "  (map.set! req 'state 0.0) "
+        "  (map.set! req 'seed 42) "
+        "  (map.set! req 'budget_ms 16) "
+        "  (map.set! req 'work_max 400) "
         "  (map.set! req 'bounds (list (list -0.4 0.4))) "
         "  (define mcts (map.make)) "
         "  (map.set! mcts 'max_depth 16) "
@@ -1740,2581 +4333,6980 @@ void test_planner_plan_builtin_determinism_bounds_budget_and_sanity() {
         "        (map.get (map.get r1 'stats nil) 'work_done 0)))",
         env);
 
-    const std::vector<value> fields = vector_from_list(out);
-    check(fields.size() == 5, "planner.plan mcts deterministic output shape mismatch");
-    check(is_float(fields[0]) && is_float(fields[1]), "planner.plan mcts action should be float");
-    check_close(float_value(fields[0]), float_value(fields[1]), 1e-12, "planner.plan mcts should be deterministic");
-    check(float_value(fields[0]) >= -0.4 && float_value(fields[0]) <= 0.4, "planner.plan should clamp by bounds");
-    check(is_symbol(fields[2]) && (symbol_name(fields[2]) == ":ok" || symbol_name(fields[2]) == ":timeout"),
-          "planner.plan mcts status should be :ok or :timeout");
-    check(is_integer(fields[3]) && integer_value(fields[3]) >= 0, "planner.plan time_used_ms should be non-negative int");
-    check(is_integer(fields[4]) && integer_value(fields[4]) > 0, "planner.plan work_done should be positive");
+    const std::vector<value> fields = vector_from_list(out);
+    check(fields.size() == 5, "planner.plan mcts deterministic output shape mismatch");
+    check(is_float(fields[0]) && is_float(fields[1]), "planner.plan mcts action should be float");
+    check_close(float_value(fields[0]), float_value(fields[1]), 1e-12, "planner.plan mcts should be deterministic");
+    check(float_value(fields[0]) >= -0.4 && float_value(fields[0]) <= 0.4, "planner.plan should clamp by bounds");
+    check(is_symbol(fields[2]) && (symbol_name(fields[2]) == ":ok" || symbol_name(fields[2]) == ":timeout"),
+          "planner.plan mcts status should be :ok or :timeout");
+    check(is_integer(fields[3]) && integer_value(fields[3]) >= 0, "planner.plan time_used_ms should be non-negative int");
+    check(is_integer(fields[4]) && integer_value(fields[4]) > 0, "planner.plan work_done should be positive");
+
+    value budget_out = eval_text(
+        "(begin "
+        "  (define req (map.make)) "
+        "  (map.set! req 'schema_version \"planner.request.v1\") "
+        "  (map.set! req 'planner \"mcts\") "
+        "  (map.set! req 'model_service \"toy-1d\") "
+        "  (map.set! req 'state 0.0) "
+        "  (map.set! req 'seed 99) "
+        "  (map.set! req 'budget_ms 1) "
+        "  (map.set! req 'work_max 100000) "
+        "  (define r (planner.plan req)) "
+        "  (list (map.get r 'status 'none) "
+        "        (map.get (map.get r 'stats nil) 'time_used_ms 0) "
+        "        (map.get (map.get r 'stats nil) 'work_done 0)))",
+        env);
+
+    const std::vector<value> budget_fields = vector_from_list(budget_out);
+    check(budget_fields.size() == 3, "planner.plan budget output shape mismatch");
+    check(is_symbol(budget_fields[0]), "planner.plan budget status should be symbol");
+    check(is_integer(budget_fields[1]), "planner.plan budget time should be integer");
+    check(integer_value(budget_fields[1]) <= 40, "planner.plan should honor bounded-time budget");
+    check(is_integer(budget_fields[2]) && integer_value(budget_fields[2]) > 0,
+          "planner.plan budget run should still perform work");
+
+    value mppi_det = eval_text(
+        "(begin "
+        "  (define req (map.make)) "
+        "  (map.set! req 'schema_version \"planner.request.v1\") "
+        "  (map.set! req 'planner \"mppi\") "
+        "  (map.set! req 'model_service \"toy-1d\") "
+        "  (map.set! req 'state 0.0) "
+        "  (map.set! req 'seed 123) "
+        "  (map.set! req 'budget_ms 16) "
+        "  (map.set! req 'work_max 128) "
+        "  (map.set! req 'horizon 12) "
+        "  (define cfg (map.make)) "
+        "  (map.set! cfg 'lambda 0.8) "
+        "  (map.set! cfg 'sigma (list 0.35)) "
+        "  (map.set! cfg 'n_samples 128) "
+        "  (map.set! req 'mppi cfg) "
+        "  (define r1 (planner.plan req)) "
+        "  (define r2 (planner.plan req)) "
+        "  (list (car (map.get (map.get r1 'action nil) 'u (list 0.0))) "
+        "        (car (map.get (map.get r2 'action nil) 'u (list 0.0))) "
+        "        (map.get r1 'status ':none)))",
+        env);
+    const std::vector<value> mppi_fields = vector_from_list(mppi_det);
+    check(mppi_fields.size() == 3, "planner.plan mppi deterministic shape mismatch");
+    check(is_float(mppi_fields[0]) && is_float(mppi_fields[1]), "planner.plan mppi actions should be float");
+    check_close(float_value(mppi_fields[0]), float_value(mppi_fields[1]), 1e-12,
+                "planner.plan mppi should be deterministic for fixed seed");
+    check(is_symbol(mppi_fields[2]) && (symbol_name(mppi_fields[2]) == ":ok" || symbol_name(mppi_fields[2]) == ":timeout"),
+          "planner.plan mppi status should be :ok or :timeout");
+
+    value ilqr_ok = eval_text(
+        "(begin "
+        "  (define req (map.make)) "
+        "  (map.set! req 'schema_version \"planner.request.v1\") "
+        "  (map.set! req 'planner \"ilqr\") "
+        "  (map.set! req 'model_service \"toy-1d\") "
+        "  (map.set! req 'state -1.0) "
+        "  (map.set! req 'seed 9) "
+        "  (map.set! req 'budget_ms 20) "
+        "  (map.set! req 'work_max 20) "
+        "  (map.set! req 'horizon 12) "
+        "  (define cfg (map.make)) "
+        "  (map.set! cfg 'max_iters 20) "
+        "  (map.set! cfg 'derivatives \"analytic\") "
+        "  (map.set! req 'ilqr cfg) "
+        "  (define r (planner.plan req)) "
+        "  (list (map.get r 'status ':none) "
+        "        (car (map.get (map.get r 'action nil) 'u (list 0.0)))))",
+        env);
+    const std::vector<value> ilqr_ok_fields = vector_from_list(ilqr_ok);
+    check(ilqr_ok_fields.size() == 2, "planner.plan ilqr output shape mismatch");
+    check(is_symbol(ilqr_ok_fields[0]) && (symbol_name(ilqr_ok_fields[0]) == ":ok" || symbol_name(ilqr_ok_fields[0]) == ":timeout"),
+          "planner.plan ilqr status should be :ok or :timeout");
+    check(is_float(ilqr_ok_fields[1]) && float_value(ilqr_ok_fields[1]) > 0.0,
+          "planner.plan ilqr should move positive from x=-1.0");
+
+    value ilqr_missing_deriv = eval_text(
+        "(begin "
+        "  (define req (map.make)) "
+        "  (map.set! req 'schema_version \"planner.request.v1\") "
+        "  (map.set! req 'planner \"ilqr\") "
+        "  (map.set! req 'model_service \"ptz-track\") "
+        "  (map.set! req 'state (list 0.0 0.0 0.0 0.0)) "
+        "  (map.set! req 'budget_ms 8) "
+        "  (map.set! req 'work_max 4) "
+        "  (map.set! req 'horizon 4) "
+        "  (define cfg (map.make)) "
+        "  (map.set! cfg 'derivatives \"analytic\") "
+        "  (map.set! req 'ilqr cfg) "
+        "  (planner.plan req))",
+        env);
+    check(is_map(ilqr_missing_deriv), "planner.plan ilqr missing-derivatives should return map");
+    check(symbol_name(eval_text("(map.get (planner.plan req) 'status ':none)", env)) == ":error",
+          "planner.plan ilqr analytic without derivatives should return :error");
+
+    value sanity = eval_text(
+        "(begin "
+        "  (define (step x u) (+ x (* 0.25 (clamp u -1.0 1.0)))) "
+        "  (define (run req x n) "
+        "    (if (= n 0) "
+        "        x "
+        "        (begin "
+        "          (map.set! req 'state x) "
+        "          (define r (planner.plan req)) "
+        "          (define u (car (map.get (map.get r 'action nil) 'u (list 0.0)))) "
+        "          (run req (step x u) (- n 1))))) "
+        "  (define mreq (map.make)) "
+        "  (map.set! mreq 'schema_version \"planner.request.v1\") "
+        "  (map.set! mreq 'planner \"mppi\") "
+        "  (map.set! mreq 'model_service \"toy-1d\") "
+        "  (map.set! mreq 'budget_ms 12) "
+        "  (map.set! mreq 'work_max 96) "
+        "  (map.set! mreq 'horizon 10) "
+        "  (define mcfg (map.make)) "
+        "  (map.set! mcfg 'lambda 1.0) "
+        "  (map.set! mcfg 'sigma (list 0.3)) "
+        "  (map.set! mcfg 'n_samples 96) "
+        "  (map.set! mreq 'mppi mcfg) "
+        "  (define ireq (map.make)) "
+        "  (map.set! ireq 'schema_version \"planner.request.v1\") "
+        "  (map.set! ireq 'planner \"ilqr\") "
+        "  (map.set! ireq 'model_service \"toy-1d\") "
+        "  (map.set! ireq 'budget_ms 20) "
+        "  (map.set! ireq 'work_max 16) "
+        "  (map.set! ireq 'horizon 10) "
+        "  (define icfg (map.make)) "
+        "  (map.set! icfg 'max_iters 16) "
+        "  (map.set! icfg 'derivatives \"analytic\") "
+        "  (map.set! ireq 'ilqr icfg) "
+        "  (list (run mreq -1.0 8) (run ireq -1.0 8)))",
+        env);
+    const std::vector<value> sanity_fields = vector_from_list(sanity);
+    check(sanity_fields.size() == 2, "planner sanity output shape mismatch");
+    check(is_float(sanity_fields[0]) && float_value(sanity_fields[0]) > -0.95, "mppi should improve 1D integrator");
+    check(is_float(sanity_fields[1]) && float_value(sanity_fields[1]) > -0.95, "ilqr should improve 1D integrator");
+
+    value uni = eval_text(
+        "(begin "
+        "  (define req (map.make)) "
+        "  (map.set! req 'schema_version \"planner.request.v1\") "
+        "  (map.set! req 'planner \"mppi\") "
+        "  (map.set! req 'model_service \"toy-unicycle\") "
+        "  (map.set! req 'state (list 0.0 0.0 0.0 1.0 0.0)) "
+        "  (map.set! req 'budget_ms 12) "
+        "  (map.set! req 'work_max 96) "
+        "  (map.set! req 'horizon 12) "
+        "  (define cfg (map.make)) "
+        "  (map.set! cfg 'lambda 1.0) "
+        "  (map.set! cfg 'sigma (list 0.25 0.35)) "
+        "  (map.set! cfg 'n_samples 96) "
+        "  (map.set! req 'mppi cfg) "
+        "  (define r (planner.plan req)) "
+        "  (list (map.get r 'status ':none) "
+        "        (car (map.get (map.get r 'action nil) 'u (list 0.0)))))",
+        env);
+    const std::vector<value> uni_fields = vector_from_list(uni);
+    check(uni_fields.size() == 2, "toy-unicycle planner output shape mismatch");
+    check(is_symbol(uni_fields[0]) && (symbol_name(uni_fields[0]) == ":ok" || symbol_name(uni_fields[0]) == ":timeout"),
+          "toy-unicycle mppi status should be :ok or :timeout");
+    check(is_float(uni_fields[1]) && float_value(uni_fields[1]) > 0.0, "toy-unicycle mppi should command forward velocity");
+}
+
+void test_plan_action_node_blackboard_meta_and_logs() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
+
+    check(is_nil(eval_text("(planner.set-base-seed 4242)", env)), "planner.set-base-seed should return nil");
+    check(is_integer(eval_text("(planner.get-base-seed)", env)) &&
+              integer_value(eval_text("(planner.get-base-seed)", env)) == 4242,
+          "planner.get-base-seed should return configured value");
+
+    (void)eval_text(
+        "(define tree "
+        "  (bt.compile "
+        "    '(seq "
+        "       (plan-action :name \"toy-plan\" :planner :mcts :budget_ms 20 :work_max 300 "
+        "                    :model_service \"toy-1d\" :state_key state :action_key action :meta_key plan-meta) "
+        "       (act apply-planned-1d state action state))))",
+        env);
+    check(string_value(eval_text("(write-to-string (bt.to-dsl tree))", env)).find("(plan-action") != std::string::npos,
+          "bt.to-dsl should include plan-action node");
+    (void)eval_text("(define inst-a (bt.new-instance tree))", env);
+    (void)eval_text("(define inst-b (bt.new-instance tree))", env);
+
+    check(symbol_name(eval_text("(bt.tick inst-a '((state 0.0)))", env)) == "success",
+          "plan-action tree tick should succeed");
+    check(symbol_name(eval_text("(bt.tick inst-b '((state 0.0)))", env)) == "success",
+          "plan-action tree tick on second instance should succeed");
+
+    bt::runtime_host& host = bt::default_runtime_host();
+    const std::int64_t inst_a_handle = bt_handle(eval_text("inst-a", env));
+    const std::int64_t inst_b_handle = bt_handle(eval_text("inst-b", env));
+    bt::instance* inst_a = host.find_instance(inst_a_handle);
+    bt::instance* inst_b = host.find_instance(inst_b_handle);
+    check(inst_a && inst_b, "plan-action test instances should exist");
+
+    const bt::bb_entry* action_a = inst_a->bb.get("action");
+    const bt::bb_entry* action_b = inst_b->bb.get("action");
+    check(action_a && action_b, "plan-action should write action key");
+
+    double action_a_value = 0.0;
+    double action_b_value = 0.0;
+    if (const double* f = std::get_if<double>(&action_a->value)) {
+        action_a_value = *f;
+    } else if (const bt::bb_vector* vec = std::get_if<bt::bb_vector>(&action_a->value)) {
+        check(!vec->empty(), "plan-action vector action should not be empty");
+        action_a_value = (*vec)[0];
+    } else {
+        throw std::runtime_error("plan-action action value should be numeric");
+    }
+    if (const double* f = std::get_if<double>(&action_b->value)) {
+        action_b_value = *f;
+    } else if (const bt::bb_vector* vec = std::get_if<bt::bb_vector>(&action_b->value)) {
+        check(!vec->empty(), "plan-action vector action should not be empty");
+        action_b_value = (*vec)[0];
+    } else {
+        throw std::runtime_error("plan-action action value should be numeric");
+    }
+    check_close(action_a_value, action_b_value, 1e-12,
+                "plan-action should be deterministic for same base seed/node/tick/state");
+
+    const bt::bb_entry* state_a = inst_a->bb.get("state");
+    check(state_a, "apply-planned-1d should update state");
+    check(std::holds_alternative<double>(state_a->value), "updated state should be float");
+    check(std::get<double>(state_a->value) > 0.0, "planned action should move state toward goal");
+
+    const bt::bb_entry* meta_a = inst_a->bb.get("plan-meta");
+    check(meta_a && std::holds_alternative<std::string>(meta_a->value), "plan-action should write meta key");
+    check(std::get<std::string>(meta_a->value).find("\"status\"") != std::string::npos,
+          "plan-action meta should include status");
+
+    value planner_events = eval_text("(events.dump 200)", env);
+    check(is_proper_list(planner_events), "events.dump should return list");
+    const auto planner_rows = vector_from_list(planner_events);
+    bool saw_planner_v1 = false;
+    bool saw_planner_schema = false;
+    bool saw_planner_node = false;
+    for (const value& row : planner_rows) {
+        if (!is_string(row)) {
+            continue;
+        }
+        const std::string line = string_value(row);
+        if (line.find("\"type\":\"planner_v1\"") != std::string::npos) {
+            saw_planner_v1 = true;
+        }
+        if (line.find("\"schema_version\":\"planner.v1\"") != std::string::npos) {
+            saw_planner_schema = true;
+        }
+        if (line.find("\"node_name\":\"toy-plan\"") != std::string::npos) {
+            saw_planner_node = true;
+        }
+    }
+    check(saw_planner_v1, "events should include planner_v1");
+    check(saw_planner_schema, "planner_v1 should include stable planner schema");
+    check(saw_planner_node, "planner_v1 should include node name");
+
+    (void)eval_text(
+        "(define bad-tree "
+        "  (bt.compile "
+        "    '(plan-action :name \"bad\" :model_service \"toy-1d\" :state_key missing :action_key action)))",
+        env);
+    (void)eval_text("(define bad-inst (bt.new-instance bad-tree))", env);
+    check(symbol_name(eval_text("(bt.tick bad-inst)", env)) == "failure",
+          "plan-action should fail on missing state key");
+}
+
+void test_plan_action_node_with_all_planner_backends() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
+
+    (void)eval_text(
+        "(define tree-mcts "
+        "  (bt.compile '(plan-action :name \"mcts-node\" :planner :mcts :budget_ms 24 :work_max 240 "
+        "                          :model_service \"toy-1d\" :state_key state :action_key action)))",
+        env);
+    (void)eval_text(
+        "(define tree-mppi "
+        "  (bt.compile '(plan-action :name \"mppi-node\" :planner :mppi :budget_ms 24 :work_max 96 "
+        "                          :horizon 10 :lambda 1.0 :sigma 0.3 :n_samples 96 "
+        "                          :model_service \"toy-1d\" :state_key state :action_key action)))",
+        env);
+    (void)eval_text(
+        "(define tree-ilqr "
+        "  (bt.compile '(plan-action :name \"ilqr-node\" :planner :ilqr :budget_ms 24 :work_max 12 "
+        "                          :horizon 10 :max_iters 12 :derivatives :analytic "
+        "                          :model_service \"toy-1d\" :state_key state :action_key action)))",
+        env);
+
+    (void)eval_text("(define inst-mcts (bt.new-instance tree-mcts))", env);
+    (void)eval_text("(define inst-mppi (bt.new-instance tree-mppi))", env);
+    (void)eval_text("(define inst-ilqr (bt.new-instance tree-ilqr))", env);
+
+    check(symbol_name(eval_text("(bt.tick inst-mcts '((state -1.0)))", env)) == "success",
+          "plan-action mcts backend should succeed");
+    check(symbol_name(eval_text("(bt.tick inst-mppi '((state -1.0)))", env)) == "success",
+          "plan-action mppi backend should succeed");
+    check(symbol_name(eval_text("(bt.tick inst-ilqr '((state -1.0)))", env)) == "success",
+          "plan-action ilqr backend should succeed");
+
+    bt::runtime_host& host = bt::default_runtime_host();
+    const std::int64_t h_mcts = bt_handle(eval_text("inst-mcts", env));
+    const std::int64_t h_mppi = bt_handle(eval_text("inst-mppi", env));
+    const std::int64_t h_ilqr = bt_handle(eval_text("inst-ilqr", env));
+    bt::instance* i_mcts = host.find_instance(h_mcts);
+    bt::instance* i_mppi = host.find_instance(h_mppi);
+    bt::instance* i_ilqr = host.find_instance(h_ilqr);
+    check(i_mcts && i_mppi && i_ilqr, "backend test instances should exist");
+    check(i_mcts->bb.get("action") != nullptr, "mcts backend should publish action");
+    check(i_mppi->bb.get("action") != nullptr, "mppi backend should publish action");
+    check(i_ilqr->bb.get("action") != nullptr, "ilqr backend should publish action");
+}
+
+void test_hash64_builtin() {
+    using namespace muslisp;
+
+    env_ptr env = create_global_env();
+    value h1 = eval_text("(hash64 \"planner-seed\")", env);
+    value h2 = eval_text("(hash64 \"planner-seed\")", env);
+    value h3 = eval_text("(hash64 \"planner-seed-2\")", env);
+
+    check(is_integer(h1) && is_integer(h2) && is_integer(h3), "hash64 should return integer");
+    check(integer_value(h1) == integer_value(h2), "hash64 should be deterministic");
+    check(integer_value(h1) != integer_value(h3), "hash64 should vary with input");
+}
+
+void test_json_and_handle_builtins() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
+
+    value img = eval_text("(image.make 320 240 3 \"rgb8\" 1234 \"cam0\")", env);
+    check(is_image_handle(img), "image.make should return image_handle");
+    value img_info = eval_text("(image.info (image.make 64 48 1 \"gray8\" 222 \"cam1\"))", env);
+    check(is_map(img_info), "image.info should return map");
+    check(integer_value(eval_text("(map.get (image.info (image.make 10 20 3 \"rgb8\" 555 \"cam2\")) 'w -1)", env)) == 10,
+          "image.info width mismatch");
+
+    value blob = eval_text("(blob.make 1024 \"application/octet-stream\" 777 \"snapshot\")", env);
+    check(is_blob_handle(blob), "blob.make should return blob_handle");
+    check(integer_value(eval_text("(map.get (blob.info (blob.make 99 \"text/plain\" 111 \"note\")) 'size_bytes -1)", env)) == 99,
+          "blob.info size mismatch");
+    check(boolean_value(eval_text("(map.get (blob.info (blob.make 3 \"text/plain\" 1 \"note\" \"abc\")) 'in_process #f)", env)),
+          "blob.make payload without a frame ring should be held in process");
+
+    value json_out = eval_text(
+        "(begin "
+        "  (define m (map.make)) "
+        "  (map.set! m 'a 1) "
+        "  (map.set! m 'b (list 2 3)) "
+        "  (define s (json.encode m)) "
+        "  (define d (json.decode s)) "
+        "  (list s (map.get d \"a\" -1) (map.get d \"b\" nil)))",
+        env);
+    const std::vector<value> fields = vector_from_list(json_out);
+    check(fields.size() == 3, "json roundtrip shape mismatch");
+    check(is_string(fields[0]), "json.encode should return string");
+    check(integer_value(fields[1]) == 1, "json.decode object key/value mismatch");
+    check(print_value(fields[2]) == "(2 3)", "json.decode array mismatch");
+}
+
+void test_adopted_handle_payload_lifetime() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
+    bt::vla_service& vla = bt::default_runtime_host().vla_ref();
+
+    auto pixels = std::make_shared<std::vector<std::byte>>(64 * 48 * 3, std::byte{7});
+    std::weak_ptr<std::vector<std::byte>> watch = pixels;
+    const bt::image_handle_ref image = vla.adopt_image(
+        64, 48, 3, "rgb8", 100, "cam0", bt::retained_payload{.owner = pixels, .bytes = std::as_bytes(std::span(*pixels))});
+    const std::byte* data = pixels->data();
+    pixels.reset();
+    check(!watch.expired(), "an adopted payload should be kept alive by its handle");
+
+    const auto payload = vla.image_payload(image);
+    check(payload.has_value() && payload->bytes.data() == data && payload->bytes.size() == 64 * 48 * 3,
+          "image_payload should return the adopted bytes without copying them");
+    const auto info = vla.get_image_info(image);
+    check(info.has_value() && info->in_process && info->frame_ref.empty(), "adopted images should be marked in process");
+
+    define(env, "adopted-img", make_image_handle(image.id));
+    check(boolean_value(eval_text("(map.get (image.info adopted-img) 'in_process #f)", env)),
+          "image.info should report in_process");
+    check(boolean_value(eval_text("(image.retain adopted-img)", env)), "image.retain should accept a live handle");
+    check(boolean_value(eval_text("(image.release adopted-img)", env)), "image.release should accept a live handle");
+    check(!watch.expired(), "a retained handle should survive one release");
+    check(payload.has_value(), "a payload copy should share ownership");
+    check(boolean_value(eval_text("(image.release adopted-img)", env)), "the last image.release should succeed");
+    check(!vla.get_image_info(image).has_value(), "the last release should forget the handle");
+    check(!watch.expired(), "a payload copy held by a reader should outlive the release");
+    check(payload->bytes.data() == data, "a released handle's payload copy should still point at the bytes");
+    check(!boolean_value(eval_text("(image.release adopted-img)", env)), "releasing a forgotten handle should return #f");
+    expect_lisp_error_message(
+        "(image.info adopted-img)", env, "image.info: unknown handle", "image.info after the last release");
+
+    auto cloud = std::make_shared<std::string>("xyzxyzxyz");
+    std::weak_ptr<std::string> cloud_watch = cloud;
+    const bt::blob_handle_ref blob = vla.adopt_blob(
+        "application/x-test", 5, "cloud", bt::retained_payload{.owner = cloud, .bytes = std::as_bytes(std::span(*cloud))});
+    cloud.reset();
+    check(vla.get_blob_info(blob)->size_bytes == 9, "adopt_blob should take its size from the payload");
+    check(vla.release_blob(blob) && cloud_watch.expired(), "the last blob release should drop the payload owner");
+}
+
+void test_payload_pool_recycles_frames() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
+    bt::vla_service& vla = host.vla_ref();
+    env_ptr env = create_global_env();
+    (void)eval_text("(define inst (bt.new-instance (bt (succeed))))", env);
+    bt::instance* inst = host.find_instance(bt_handle(eval_text("inst", env)));
+    check(inst != nullptr, "payload pool test instance should exist");
+
+    const auto bytes_of = [](const std::string& text) {
+        return std::as_bytes(std::span<const char>(text.data(), text.size()));
+    };
+
+    // A camera at 4x4 rgb8 writing one frame per tick to the blackboard and dropping its own handle.
+    const std::string pixels(48, 'p');
+    const std::uint64_t acquired_before = vla.payload_pool_ref().stats().acquired;
+    const std::uint64_t reused_before = vla.payload_pool_ref().stats().reused;
+    for (std::uint64_t tick = 1; tick <= 50; ++tick) {
+        const bt::image_handle_ref frame = vla.create_image(4, 4, 3, "rgb8", 0, "cam", bytes_of(pixels));
+        inst->bb.put("frame", bt::bb_value{frame}, tick, std::chrono::steady_clock::now(), 0, "camera");
+        check(vla.release_image(frame), "the camera should drop its own reference");
+    }
+    bt::payload_pool_stats stats = vla.payload_pool_ref().stats();
+    check(vla.live_images() == 1, "only the frame on the blackboard should stay live");
+    const auto camera_class = std::find_if(stats.classes.begin(), stats.classes.end(), [](const auto& cls) {
+        return cls.slab_bytes == 48;
+    });
+    check(stats.acquired - acquired_before == 50 && stats.reused - reused_before >= 48,
+          "per-frame payloads should reuse slabs instead of allocating");
+    check(camera_class != stats.classes.end() && camera_class->slabs <= 2 && camera_class->in_use == 1,
+          "the camera's resolution should be served by a bounded set of slabs");
+    {
+        const bt::image_handle_ref on_bb = std::get<bt::image_handle_ref>(inst->bb.get("frame")->value);
+        const std::optional<bt::retained_payload> held = vla.image_payload(on_bb);
+        check(held.has_value() &&
+                  std::string(reinterpret_cast<const char*>(held->bytes.data()), held->bytes.size()) == pixels,
+              "the pooled payload should hold the frame's bytes");
+    }
+
+    // A pending request holds its observation until the backend has run.
+    const bt::image_handle_ref request_frame = vla.create_image(4, 4, 3, "rgb8", 0, "cam", bytes_of(pixels));
+    bt::vla_request req;
+    req.capability = "vla.rt2";
+    req.instruction = "look";
+    req.observation.image = request_frame;
+    req.action_space.dims = 1;
+    req.action_space.bounds = {{-1.0, 1.0}};
+    req.model.name = "rt2-stub";
+    const bt::vla_service::vla_job_id job = vla.submit(req);
+    check(vla.release_image(request_frame), "the caller should drop its reference after submitting");
+    const auto until = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!vla.poll(job).final.has_value() && std::chrono::steady_clock::now() < until) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    check(vla.poll(job).final.has_value(), "the request should finish");
+    for (int i = 0; i < 1000 && vla.get_image_info(request_frame).has_value(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    check(!vla.get_image_info(request_frame).has_value(), "a finished request should drop its observation");
+
+    // Deleting the entry and releasing the instance drop the blackboard's references.
+    inst->bb.put("frame", bt::bb_value{}, 51, std::chrono::steady_clock::now(), 0, "camera");
+    check(vla.live_images() == 0 && vla.payload_pool_ref().stats().in_use_bytes == 0,
+          "a deleted blackboard entry should release its frame");
+    const bt::image_handle_ref kept = vla.create_image(4, 4, 3, "rgb8", 0, "cam", bytes_of(pixels));
+    inst->bb.put("frame", bt::bb_value{kept}, 52, std::chrono::steady_clock::now(), 0, "camera");
+    (void)vla.release_image(kept);
+    host.release_instance(bt_handle(eval_text("inst", env)));
+    check(vla.live_images() == 0, "releasing the instance should release its blackboard frames");
+
+    // The capacity bounds slabs in use; a new size evicts free slabs of other sizes first.
+    const std::uint64_t exhausted_before = vla.payload_pool_ref().stats().exhausted;
+    vla.payload_pool_ref().set_capacity(100);
+    const bt::image_handle_ref a = vla.create_image(8, 8, 1, "gray8", 0, "cam", bytes_of(std::string(64, 'a')));
+    bool exhausted = false;
+    try {
+        (void)vla.create_image(8, 8, 1, "gray8", 0, "cam", bytes_of(std::string(64, 'b')));
+    } catch (const std::length_error&) {
+        exhausted = true;
+    }
+    check(exhausted, "slabs in use beyond the capacity should be refused");
+    (void)vla.release_image(a);
+    stats = vla.payload_pool_ref().stats();
+    check(stats.exhausted - exhausted_before == 1 && stats.in_use_bytes == 0 && stats.reserved_bytes <= 100,
+          "slabs in use should never exceed the capacity");
+    check(std::none_of(stats.classes.begin(), stats.classes.end(), [](const auto& cls) { return cls.slab_bytes == 48; }),
+          "a new slab size should evict free slabs of other sizes");
+
+    check(integer_value(eval_text("(map.get (image.pool-stats) 'exhausted -1)", env)) ==
+              static_cast<std::int64_t>(exhausted_before + 1),
+          "image.pool-stats should report exhausted acquisitions");
+    (void)eval_text("(image.set-pool-capacity 0)", env);
+    check(integer_value(eval_text("(map.get (image.pool-stats) 'reserved_bytes -1)", env)) == 0,
+          "a zero capacity should drop every free slab");
+    expect_lisp_error_message("(image.make 2 2 1 \"gray8\" 0 \"cam\" \"abcd\")",
+                              env,
+                              "image.make: create_image: frame pool exhausted: 0 of 0 bytes in use",
+                              "image.make with an exhausted pool");
+    reset_bt_runtime_host();
+    check(vla.payload_pool_ref().capacity() == bt::payload_pool::k_default_capacity_bytes,
+          "a host reset should restore the pool capacity");
+}
+
+void test_json_codec_string_scan_and_numbers() {
+    using namespace muslisp;
+
+    env_ptr env = create_global_env();
+
+    // Escapes on either side of the word-at-a-time scan boundary must decode the same way.
+    for (std::size_t offset = 0; offset < 20; ++offset) {
+        const std::string prefix(offset, 'x');
+        const std::string json = "\"" + prefix + "\\\"q\\\\\\n" + prefix + "\"";
+        value decoded = eval_text("(json.decode " + print_value(make_string(json)) + ")", env);
+        check(is_string(decoded), "json.decode string shape mismatch");
+        check(string_value(decoded) == prefix + "\"q\\\n" + prefix, "json.decode escape decoding mismatch");
+    }
+    expect_lisp_error_message("(json.decode \"\\\"abcdefghijklmnop\")", env, "json.decode: unterminated string", "json unterminated");
+    expect_lisp_error_message("(json.decode \"\\\"ab\\\\u0041\\\"\")", env, "json.decode: unsupported escape sequence", "json \\u");
+
+    value frame = eval_text(
+        "(json.decode \"{\\\"pose\\\": {\\\"x\\\": 1.5, \\\"y\\\": -2}, \\\"ranges\\\": [0.25, 1e3, 12, 9223372036854775808],"
+        " \\\"id\\\": \\\"frame-000000000042\\\", \\\"ok\\\": true, \\\"none\\\": null}\")",
+        env);
+    check(is_map(frame), "json.decode object should return map");
+    gc_root_scope roots(default_gc());
+    roots.add(&frame);
+    define(env, "frame", frame);
+    check(float_value(eval_text("(map.get (map.get frame \"pose\" nil) \"x\" 0)", env)) == 1.5, "nested float mismatch");
+    check(integer_value(eval_text("(map.get (map.get frame \"pose\" nil) \"y\" 0)", env)) == -2, "nested integer mismatch");
+    check(print_value(eval_text("(map.get frame \"ranges\" nil)", env)) == "(0.25 1000.0 12 9.22337203685478e+18)",
+          "array decode mismatch (int64 overflow should decode as float)");
+    check(string_value(eval_text("(map.get frame \"id\" nil)", env)) == "frame-000000000042", "long key/string mismatch");
+    check(float_value(eval_text("(json.decode \"1e-400\")", env)) == 0.0, "underflow should round to zero");
+    expect_lisp_error_message("(json.decode \"1e400\")", env, "json.decode: non-finite number", "json overflow");
+
+    // Encoding appends into a reused buffer; consecutive results must not leak into each other.
+    check(string_value(eval_text("(json.encode (list 1 0.1 \"a\\nb\" 1e-07 'sym))", env)) == "[1,0.1,\"a\\nb\",1e-07,\"sym\"]",
+          "json.encode scalar formatting mismatch");
+    check(string_value(eval_text("(json.encode (list))", env)) == "null", "json.encode empty list mismatch");
+    value round_trip = eval_text("(json.decode (json.encode (map.get frame \"pose\" nil)))", env);
+    check(is_map(round_trip) && round_trip->map_data().size() == 2, "json round trip through reused buffer mismatch");
+}
+
+void test_capability_registry_call_echo() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
+
+    value caps = eval_text("(cap.list)", env);
+    check(is_proper_list(caps), "cap.list should return list");
+    bool saw_echo = false;
+    for (value cap_name : vector_from_list(caps)) {
+        if (is_string(cap_name) && string_value(cap_name) == "cap.echo.v1") {
+            saw_echo = true;
+        }
+    }
+    check(saw_echo, "cap.list should include cap.echo.v1");
+
+    value desc = eval_text("(cap.describe \"cap.echo.v1\")", env);
+    check(is_map(desc), "cap.describe cap.echo.v1 should return map");
+    check(string_value(eval_text("(map.get (cap.describe \"cap.echo.v1\") 'name \"\")", env)) == "cap.echo.v1",
+          "cap.describe echo name mismatch");
+    check(string_value(eval_text("(map.get (cap.describe \"cap.echo.v1\") 'safety_class \"\")", env)) == "safe",
+          "cap.describe echo safety_class mismatch");
+
+    value response = eval_text(
+        "(begin "
+        "  (define req (map.make)) "
+        "  (define payload (map.make)) "
+        "  (map.set! payload 'message \"hello\") "
+        "  (map.set! payload 'n 7) "
+        "  (map.set! req 'schema_version \"cap.echo.request.v1\") "
+        "  (map.set! req 'capability \"cap.echo.v1\") "
+        "  (map.set! req 'operation \"echo\") "
+        "  (map.set! req 'request_id \"echo-1\") "
+        "  (map.set! req 'payload payload) "
+        "  (define response (cap.call req)) "
+        "  response)",
+        env);
+    check(is_map(response), "cap.call should return map");
+    check(symbol_name(eval_text("(map.get response 'status ':none)", env)) == ":ok", "cap.call echo status mismatch");
+    check(string_value(eval_text("(map.get response 'request_id \"\")", env)) == "echo-1",
+          "cap.call should preserve request_id");
+    check(string_value(eval_text("(map.get (map.get response 'echo (map.make)) 'message \"\")", env)) == "hello",
+          "cap.call should echo payload");
+    check(integer_value(eval_text("(map.get (map.get response 'echo (map.make)) 'n -1)", env)) == 7,
+          "cap.call should preserve payload fields");
+
+    value model_desc = eval_text("(cap.describe \"cap.model.world.rollout.v1\")", env);
+    check(is_map(model_desc), "cap.describe model rollout should return map");
+    check(string_value(eval_text("(map.get (cap.describe \"cap.model.world.rollout.v1\") 'name \"\")", env)) ==
+              "cap.model.world.rollout.v1",
+          "cap.describe model rollout name mismatch");
+
+    bt::default_runtime_host().events().clear_ring();
+    (void)eval_text(
+        "(define model_response "
+        " (begin "
+        "  (define input (map.make)) "
+        "  (map.set! input 'state (map.make)) "
+        "  (map.set! input 'actions (list)) "
+        "  (define req (map.make)) "
+        "  (map.set! req 'capability \"cap.model.world.rollout.v1\") "
+        "  (map.set! req 'operation \"invoke\") "
+        "  (map.set! req 'request_id \"rollout-1\") "
+        "  (map.set! req 'deadline_ms 25) "
+        "  (map.set! req 'input input) "
+        "  (cap.call req)))",
+        env);
+    value model_response = eval_text("model_response", env);
+    check(is_map(model_response), "model-service cap.call should return map");
+    check(symbol_name(eval_text("(map.get model_response 'status ':none)", env)) == ":unavailable",
+          "unconfigured model-service cap.call should return :unavailable");
+    check(string_value(eval_text("(map.get model_response 'error_code \"\")", env)) == "model_service_unconfigured",
+          "unconfigured model-service cap.call error code mismatch");
+    check(!string_value(eval_text("(map.get model_response 'request_hash \"\")", env)).empty(),
+          "model-service cap.call should expose request_hash");
+    check(!string_value(eval_text("(map.get model_response 'response_hash \"\")", env)).empty(),
+          "model-service cap.call should expose response_hash");
+    check(!boolean_value(eval_text("(map.get model_response 'replay_cache_hit true)", env)),
+          "unconfigured model-service cap.call should not be a replay cache hit");
+    check(symbol_name(eval_text("(map.get model_response 'validation_status ':missing)", env)) == ":not_checked",
+          "unconfigured model-service cap.call should not run output validation");
+    check(!boolean_value(eval_text("(map.get model_response 'host_reached true)", env)),
+          "unconfigured model-service cap.call must not reach host");
+    const std::vector<std::string> cap_events = bt::default_runtime_host().events().snapshot();
+    bool saw_cap_start = false;
+    bool saw_cap_end = false;
+    for (const std::string& line : cap_events) {
+        saw_cap_start = saw_cap_start || line.find("\"type\":\"cap_call_start\"") != std::string::npos;
+        saw_cap_end = saw_cap_end || line.find("\"type\":\"cap_call_end\"") != std::string::npos;
+    }
+    check(saw_cap_start, "model-service cap.call should emit cap_call_start");
+    check(saw_cap_end, "model-service cap.call should emit cap_call_end");
+    value check_result = eval_text("(model-service.check)", env);
+    check(is_map(check_result), "model-service.check should return map");
+    check(!boolean_value(eval_text("(map.get (model-service.check) 'compatible true)", env)),
+          "unconfigured model-service.check should be incompatible");
+    check(string_value(eval_text("(map.get (model-service.check) 'error_code \"\")", env)) ==
+              "model_service_unconfigured",
+          "unconfigured model-service.check should report model_service_unconfigured");
+
+    value rejected = eval_text(
+        "(begin "
+        "  (define req (map.make)) "
+        "  (map.set! req 'schema_version \"cap.echo.request.v1\") "
+        "  (map.set! req 'capability \"cap.echo.v1\") "
+        "  (map.set! req 'operation \"nope\") "
+        "  (define rejected (cap.call req)) "
+        "  rejected)",
+        env);
+    check(is_map(rejected), "cap.call rejected operation should return map");
+    check(symbol_name(eval_text("(map.get rejected 'status ':none)", env)) == ":rejected",
+          "cap.call unsupported operation should return :rejected");
+
+    expect_lisp_error_message(
+        "(begin "
+        "  (define req (map.make)) "
+        "  (map.set! req 'schema_version \"cap.echo.request.v1\") "
+        "  (map.set! req 'capability \"cap.unknown.v1\") "
+        "  (map.set! req 'operation \"echo\") "
+        "  (cap.call req))",
+        env,
+        "cap.call: unknown capability",
+        "cap.call unknown capability");
+}
+
+void test_model_service_protocol_skeleton() {
+    bt::model_service_request request;
+    request.id = "req-1";
+    request.op = bt::model_service_operation::invoke;
+    request.capability = "cap.model.world.rollout.v1";
+    request.deadline_ms = 100;
+
+    bt::unavailable_model_service_client client;
+    bt::model_service_response response = client.call(request);
+
+    check(std::string(bt::model_service_operation_name(request.op)) == "invoke",
+          "model service operation name mismatch");
+    const std::string envelope = bt::model_service_request_to_json(request);
+    check(envelope.find("\"version\":\"0.2\"") != std::string::npos, "model service envelope version missing");
+    check(envelope.find("\"op\":\"invoke\"") != std::string::npos, "model service envelope operation missing");
+    check(envelope.find("\"capability\":\"cap.model.world.rollout.v1\"") != std::string::npos,
+          "model service envelope capability missing");
+
+    const bt::model_service_response parsed = bt::model_service_response_from_json(
+        "{\"version\":\"0.2\",\"id\":\"req-1\",\"status\":\"action_chunk\","
+        "\"output\":{\"actions\":[{\"type\":\"joint_targets\",\"values\":[0.1],\"dt_ms\":33}]},"
+        "\"session_id\":\"sess-1\",\"error\":null,"
+        "\"metadata\":{\"capability\":\"cap.vla.action_chunk.v1\",\"backend\":\"smolvla\"}}");
+    check(parsed.id == "req-1", "model service parsed response id mismatch");
+    check(parsed.status == bt::model_service_status::action_chunk, "model service parsed status mismatch");
+    check(parsed.output_json.find("\"actions\"") != std::string::npos,
+          "model service parsed output should preserve raw actions JSON");
+    check(parsed.session_id == "sess-1", "model service parsed session id mismatch");
+    check(parsed.metadata_json.find("\"smolvla\"") != std::string::npos,
+          "model service parsed metadata should preserve raw JSON");
+    check(parsed.output_json == "{\"actions\":[{\"type\":\"joint_targets\",\"values\":[0.1],\"dt_ms\":33}]}",
+          "model service parsed output should be the value as written");
+
+    const std::string_view error_envelope =
+        "{ \"version\":\"0.2\", \"id\":\"req-\\u00e9\\n\", \"status\":\"error\", \"output\":null,"
+        " \"error\":{\"code\":\"model_busy\",\"message\":\"say \\\"later\\\"\",\"retryable\":true} }";
+    const bt::model_service_response errored = bt::model_service_response_from_json(error_envelope);
+    check(errored.id == "req-\xc3\xa9\n", "model service parsed id should decode escapes");
+    check(errored.output_json == "{}", "model service null output should stay the empty object");
+    check(errored.error_code == "model_busy" && errored.error_message == "say \"later\"" && errored.error_retryable,
+          "model service parsed error fields mismatch");
+    check(errored.raw_json == error_envelope, "model service parsed response should keep the raw envelope");
+
+    const bt::model_service_response lenient = bt::model_service_response_from_json(
+        "{\"id\":\"req-2\",\"status\":\"success\",\"output\":{\"ok\":true},}");
+    check(lenient.id == "req-2" && lenient.status == bt::model_service_status::success &&
+              lenient.output_json == "{\"ok\":true}",
+          "model service envelope that is not strict JSON should still parse");
+
+    check(std::string(bt::model_service_status_name(response.status)) == "unavailable",
+          "model service unavailable status mismatch");
+    check(bt::model_service_status_terminal(response.status), "unavailable should be terminal");
+    check(response.id == "req-1", "model service response should preserve request id");
+    check(response.error_code == "model_service_unconfigured",
+          "model service unavailable error code mismatch");
+    check(!response.host_reached, "unconfigured model service must not reach host execution");
+
+    struct fake_describe_client final : bt::model_service_client {
+        bt::model_service_response call(const bt::model_service_request& req) override {
+            bt::model_service_response out;
+            out.id = req.id;
+            out.status = bt::model_service_status::success;
+            out.output_json =
+                "{\"capabilities\":["
+                "{\"id\":\"cap.model.world.rollout.v1\",\"mode\":\"invoke\","
+                "\"input_schema\":\"mms://schemas/cap.model.world.rollout.request.v1\","
+                "\"output_schema\":\"mms://schemas/cap.model.world.rollout.result.v1\","
+                "\"supports_cancel\":false,\"supports_deadline\":true,\"freshness\":{},"
+                "\"replay\":{\"supported\":true}},"
+                "{\"id\":\"cap.model.world.score_trajectory.v1\",\"mode\":\"invoke\","
+                "\"input_schema\":\"mms://schemas/cap.model.world.score_trajectory.request.v1\","
+                "\"output_schema\":\"mms://schemas/cap.model.world.score_trajectory.result.v1\","
+                "\"supports_cancel\":false,\"supports_deadline\":true,\"freshness\":{},"
+                "\"replay\":{\"supported\":true}},"
+                "{\"id\":\"cap.vla.action_chunk.v1\",\"mode\":\"session\","
+                "\"input_schema\":\"mms://schemas/cap.vla.action_chunk.request.v1\","
+                "\"output_schema\":\"mms://schemas/cap.vla.action_chunk.result.v1\","
+                "\"supports_cancel\":true,\"supports_deadline\":true,"
+                "\"freshness\":{\"expects_fresh_observation\":true},"
+                "\"replay\":{\"supported\":false}},"
+                "{\"id\":\"cap.vla.propose_nav_goal.v1\",\"mode\":\"invoke\","
+                "\"input_schema\":\"mms://schemas/cap.vla.propose_nav_goal.request.v1\","
+                "\"output_schema\":\"mms://schemas/cap.vla.propose_nav_goal.result.v1\","
+                "\"supports_cancel\":false,\"supports_deadline\":true,\"freshness\":{},"
+                "\"replay\":{\"supported\":true}}"
+                "]}";
+            return out;
+        }
+    };
+    fake_describe_client compatible_client;
+    const bt::model_service_compatibility_result compatible =
+        bt::check_model_service_compatibility(compatible_client);
+    check(compatible.compatible, "complete describe response should be compatible");
+    check(compatible.missing_capabilities.empty(), "compatible describe should not report missing capabilities");
+    check(compatible.invalid_capabilities.empty(), "compatible describe should not report invalid capabilities");
+    check(compatible.descriptor_errors.empty(), "compatible describe should not report descriptor errors");
+
+    struct missing_describe_client final : bt::model_service_client {
+        bt::model_service_response call(const bt::model_service_request& req) override {
+            bt::model_service_response out;
+            out.id = req.id;
+            out.status = bt::model_service_status::success;
+            out.output_json = "{\"capabilities\":[{\"id\":\"cap.model.world.rollout.v1\"}]}";
+            return out;
+        }
+    };
+    missing_describe_client missing_client;
+    const bt::model_service_compatibility_result missing =
+        bt::check_model_service_compatibility(missing_client);
+    check(!missing.compatible, "missing describe response should be incompatible");
+    check(missing.error_code == "model_service_capability_missing",
+          "missing describe response should report capability_missing");
+    check(!missing.missing_capabilities.empty(), "missing describe response should list missing capabilities");
+
+    struct invalid_descriptor_client final : bt::model_service_client {
+        bt::model_service_response call(const bt::model_service_request& req) override {
+            bt::model_service_response out;
+            out.id = req.id;
+            out.status = bt::model_service_status::success;
+            out.output_json =
+                "{\"capabilities\":["
+                "{\"id\":\"cap.model.world.rollout.v1\",\"mode\":\"invoke\","
+                "\"input_schema\":\"mms://schemas/cap.model.world.rollout.request.v1\","
+                "\"output_schema\":\"mms://schemas/cap.model.world.rollout.result.v1\","
+                "\"supports_cancel\":false,\"supports_deadline\":true,\"freshness\":{},"
+                "\"replay\":{\"supported\":true}},"
+                "{\"id\":\"cap.model.world.score_trajectory.v1\",\"mode\":\"invoke\","
+                "\"input_schema\":\"mms://schemas/cap.model.world.score_trajectory.request.v1\","
+                "\"output_schema\":\"mms://schemas/cap.model.world.score_trajectory.result.v1\","
+                "\"supports_cancel\":false,\"supports_deadline\":true,\"freshness\":{},"
+                "\"replay\":{\"supported\":true}},"
+                "{\"id\":\"cap.vla.action_chunk.v1\",\"mode\":\"invoke\","
+                "\"input_schema\":\"mms://schemas/cap.vla.action_chunk.request.v1\","
+                "\"output_schema\":\"mms://schemas/cap.vla.action_chunk.result.v1\","
+                "\"supports_cancel\":false,\"supports_deadline\":true,"
+                "\"freshness\":{\"expects_fresh_observation\":false},"
+                "\"replay\":{\"supported\":false}},"
+                "{\"id\":\"cap.vla.propose_nav_goal.v1\",\"mode\":\"invoke\","
+                "\"input_schema\":\"mms://schemas/cap.vla.propose_nav_goal.request.v1\","
+                "\"output_schema\":\"mms://schemas/cap.vla.propose_nav_goal.result.v1\","
+                "\"supports_cancel\":false,\"supports_deadline\":true,\"freshness\":{},"
+                "\"replay\":{\"supported\":true}}"
+                "]}";
+            return out;
+        }
+    };
+    invalid_descriptor_client invalid_descriptor;
+    const bt::model_service_compatibility_result invalid_compatibility =
+        bt::check_model_service_compatibility(invalid_descriptor);
+    check(!invalid_compatibility.compatible, "invalid descriptor response should be incompatible");
+    check(invalid_compatibility.error_code == "model_service_descriptor_invalid",
+          "invalid descriptor response should report descriptor_invalid");
+    check(invalid_compatibility.invalid_capabilities.size() == 1 &&
+              invalid_compatibility.invalid_capabilities.front() == "cap.vla.action_chunk.v1",
+          "invalid descriptor response should report the invalid capability");
+    check(!invalid_compatibility.descriptor_errors.empty(),
+          "invalid descriptor response should include descriptor diagnostics");
+
+    struct replay_fake_client final : bt::model_service_client {
+        int calls = 0;
+        bt::model_service_response call(const bt::model_service_request& req) override {
+            ++calls;
+            bt::model_service_response out;
+            out.id = req.id;
+            out.status = bt::model_service_status::success;
+            out.output_json = "{\"predicted_states\":[{\"vector\":[0.0]}]}";
+            out.metadata_json = "{\"backend\":\"fake\"}";
+            out.raw_json = bt::model_service_response_to_json(out);
+            return out;
+        }
+    };
+
+    bt::runtime_host host;
+    const std::filesystem::path cache_dir = temp_file_path("model_service_replay_cache", "");
+    std::filesystem::remove_all(cache_dir);
+    bt::model_service_config record_cfg;
+    record_cfg.replay_mode = "record";
+    record_cfg.replay_cache_path = cache_dir.string();
+    auto record_client = std::make_unique<replay_fake_client>();
+    replay_fake_client* record_client_ptr = record_client.get();
+    host.set_model_service_client(record_cfg, std::move(record_client));
+
+    bt::model_service_request cache_request;
+    cache_request.id = "cache-1";
+    cache_request.op = bt::model_service_operation::invoke;
+    cache_request.capability = "cap.model.world.rollout.v1";
+    cache_request.input_json = "{\"state\":{\"vector\":[0.0]},\"actions\":[]}";
+    const bt::model_service_response recorded = host.call_model_service(cache_request);
+    check(recorded.status == bt::model_service_status::success, "recorded model-service call should succeed");
+    check(recorded.validation_checked, "recorded model-service call should run validation");
+    check(recorded.validation_ok, "recorded model-service call should pass validation");
+    check(!recorded.request_hash.empty(), "recorded model-service call should have request hash");
+    check(!recorded.response_hash.empty(), "recorded model-service call should have response hash");
+    check(record_client_ptr->calls == 1, "recording should call live model-service client once");
+    check(std::filesystem::exists(cache_dir / (recorded.request_hash + ".json")),
+          "recording should write replay cache file");
+
+    bt::model_service_config replay_cfg;
+    replay_cfg.replay_mode = "replay";
+    replay_cfg.replay_cache_path = cache_dir.string();
+    host.set_model_service_client(replay_cfg, nullptr);
+    const bt::model_service_response replayed = host.call_model_service(cache_request);
+    check(replayed.status == bt::model_service_status::success, "replayed model-service call should succeed");
+    check(replayed.validation_checked, "replayed model-service call should run validation");
+    check(replayed.validation_ok, "replayed model-service call should pass validation");
+    check(replayed.replay_cache_hit, "replayed model-service call should report cache hit");
+    check(replayed.request_hash == recorded.request_hash, "replayed model-service request hash mismatch");
+    check(replayed.response_hash == recorded.response_hash, "replayed model-service response hash mismatch");
+    std::filesystem::remove_all(cache_dir);
+
+    record_cfg.replay_cache_format = "indexed";
+    host.set_model_service_client(record_cfg, std::make_unique<replay_fake_client>());
+    const bt::model_service_response indexed_recorded = host.call_model_service(cache_request);
+    check(std::filesystem::exists(cache_dir / "replay.payload") &&
+              !std::filesystem::exists(cache_dir / (indexed_recorded.request_hash + ".json")),
+          "indexed recording should append to the replay store instead of writing a file");
+    replay_cfg.replay_cache_format = "indexed";
+    host.set_model_service_client(replay_cfg, nullptr);
+    const bt::model_service_response indexed_replayed = host.call_model_service(cache_request);
+    check(indexed_replayed.replay_cache_hit && indexed_replayed.response_hash == indexed_recorded.response_hash,
+          "indexed replay should return the recorded response");
+    host.clear_model_service_client();
+    std::filesystem::remove_all(cache_dir);
+
+    struct invalid_output_client final : bt::model_service_client {
+        bt::model_service_response call(const bt::model_service_request& req) override {
+            bt::model_service_response out;
+            out.id = req.id;
+            out.status = bt::model_service_status::success;
+            out.output_json = "{\"score\":1.0}";
+            out.raw_json = bt::model_service_response_to_json(out);
+            return out;
+        }
+    };
+    host.set_model_service_client(bt::model_service_config{}, std::make_unique<invalid_output_client>());
+    const bt::model_service_response invalid = host.call_model_service(cache_request);
+    check(invalid.status == bt::model_service_status::invalid_output,
+          "world rollout missing predicted_states should be invalid_output");
+    check(invalid.validation_checked, "invalid model-service output should run validation");
+    check(!invalid.validation_ok, "invalid model-service output should fail validation");
+    check(invalid.validation_reason_code == "model_service_missing_predicted_states",
+          "invalid model-service output reason mismatch");
+    check(!invalid.host_reached, "invalid model-service output must not reach host");
+
+    struct unsafe_output_client final : bt::model_service_client {
+        bt::model_service_response call(const bt::model_service_request& req) override {
+            bt::model_service_response out;
+            out.id = req.id;
+            out.status = bt::model_service_status::success;
+            out.output_json = "{\"predicted_states\":[],\"unsafe\":true}";
+            out.raw_json = bt::model_service_response_to_json(out);
+            return out;
+        }
+    };
+    host.set_model_service_client(bt::model_service_config{}, std::make_unique<unsafe_output_client>());
+    const bt::model_service_response unsafe = host.call_model_service(cache_request);
+    check(unsafe.status == bt::model_service_status::unsafe_output,
+          "unsafe model-service output should be unsafe_output");
+    check(unsafe.validation_reason_code == "model_service_unsafe_output",
+          "unsafe model-service output reason mismatch");
+    check(!unsafe.host_reached, "unsafe model-service output must not reach host");
+
+    struct fault_schedule_live_client final : bt::model_service_client {
+        int calls = 0;
+        bt::model_service_response call(const bt::model_service_request& req) override {
+            ++calls;
+            bt::model_service_response out;
+            out.id = req.id;
+            out.status = bt::model_service_status::success;
+            out.output_json = "{\"predicted_states\":[{\"vector\":[1.0]}]}";
+            out.raw_json = bt::model_service_response_to_json(out);
+            return out;
+        }
+    };
+    bt::model_service_config fault_cfg;
+    fault_cfg.fault_schedule = {
+        "invalid_output",
+        "unsafe_output",
+        "stale_result",
+        "timeout",
+        "unavailable",
+        "none",
+    };
+    auto fault_client = std::make_unique<fault_schedule_live_client>();
+    fault_schedule_live_client* fault_client_ptr = fault_client.get();
+    host.set_model_service_client(fault_cfg, std::move(fault_client));
+
+    const bt::model_service_response fault_invalid = host.call_model_service(cache_request);
+    check(fault_invalid.status == bt::model_service_status::invalid_output,
+          "fault invalid_output should produce invalid_output");
+    check(fault_invalid.validation_reason_code == "model_service_missing_predicted_states",
+          "fault invalid_output reason mismatch");
+
+    const bt::model_service_response fault_unsafe = host.call_model_service(cache_request);
+    check(fault_unsafe.status == bt::model_service_status::unsafe_output,
+          "fault unsafe_output should produce unsafe_output");
+    check(fault_unsafe.validation_reason_code == "model_service_unsafe_output",
+          "fault unsafe_output reason mismatch");
+
+    const bt::model_service_response fault_stale = host.call_model_service(cache_request);
+    check(fault_stale.status == bt::model_service_status::invalid_output,
+          "fault stale_result should produce invalid_output");
+    check(fault_stale.validation_reason_code == "model_service_stale_result",
+          "fault stale_result reason mismatch");
+
+    const bt::model_service_response fault_timeout = host.call_model_service(cache_request);
+    check(fault_timeout.status == bt::model_service_status::timeout,
+          "fault timeout should produce timeout");
+    check(fault_timeout.error_code == "model_service_fault_timeout",
+          "fault timeout error code mismatch");
+
+    const bt::model_service_response fault_unavailable = host.call_model_service(cache_request);
+    check(fault_unavailable.status == bt::model_service_status::unavailable,
+          "fault unavailable should produce unavailable");
+    check(fault_unavailable.error_code == "model_service_fault_unavailable",
+          "fault unavailable error code mismatch");
+
+    const bt::model_service_response fault_passthrough = host.call_model_service(cache_request);
+    check(fault_passthrough.status == bt::model_service_status::success,
+          "fault none should call live model-service client");
+    check(fault_passthrough.validation_ok, "fault none live result should validate");
+    check(fault_client_ptr->calls == 1, "fault schedule should only call live client for passthrough fault");
+}
+
+void test_model_service_output_policy() {
+    const auto gate = [](std::string capability, std::string output) {
+        bt::model_service_request request;
+        request.op = bt::model_service_operation::invoke;
+        request.capability = std::move(capability);
+        bt::model_service_response response;
+        response.status = bt::model_service_status::success;
+        response.output_json = std::move(output);
+        bt::validate_model_service_response(request, response);
+        return response;
+    };
+
+    bt::model_service_response r = gate("cap.model.world.rollout.v1",
+                                        "{\"predicted_states\":[],\"meta\":{\"stale\":true,\"unsafe\":true}}");
+    check(r.status == bt::model_service_status::unsafe_output && r.validation_reason_code == "model_service_unsafe_output",
+          "nested marker flags should be found and the first rule should win");
+    r = gate("cap.model.world.rollout.v1", "{\"predicted_states\":[],\"stale\":false}");
+    check(r.validation_ok, "a false marker flag should not reject the output");
+    r = gate("cap.vla.propose_nav_goal.v1", "{\"nav_goal\":{\"x\":1}}");
+    check(r.validation_ok, "either alternative of a required field should satisfy it");
+    r = gate("cap.vla.propose_nav_goal.v1", "{\"target\":{}}");
+    check(r.validation_reason_code == "model_service_missing_nav_goal", "a missing required field should reject");
+    r = gate("cap.custom.v1", "{\"late_result\":true}");
+    check(r.validation_reason_code == "model_service_late_result",
+          "capabilities without their own policy should still check marker flags");
+    r = gate("cap.vla.action_chunk.v1", "{\"actions\":[{\"type\":\"joint_targets\",\"values\":[1e999],\"dt_ms\":33}]}");
+    check(r.validation_reason_code == "model_service_action_values_invalid",
+          "out-of-range action values should be rejected as non-finite");
+    r = gate("cap.vla.action_chunk.v1", "{\"actions\":[{\"type\":\"joint_targets\",\"values\":[0.5],\"dt_ms\":0}]}");
+    check(r.validation_reason_code == "model_service_action_dt_invalid", "a zero dt_ms should be rejected");
+    r = gate("cap.model.world.score_trajectory.v1", "{\"score\":1,}");
+    check(r.validation_reason_code == "model_service_output_not_object", "output that is not JSON should be rejected");
+}
+
+void test_model_service_vla_batching() {
+    struct batching_client final : bt::model_service_client {
+        std::mutex mutex;
+        int describes = 0;
+        int sessions = 0;
+        std::vector<std::size_t> batch_sizes;
+        bt::model_service_response call(const bt::model_service_request& req) override {
+            std::lock_guard<std::mutex> lock(mutex);
+            bt::model_service_response out;
+            out.id = req.id;
+            out.status = bt::model_service_status::success;
+            if (req.op == bt::model_service_operation::describe) {
+                ++describes;
+                out.output_json =
+                    "{\"capabilities\":[{\"id\":\"cap.vla.action_chunk.v1\",\"mode\":\"session\","
+                    "\"batch\":{\"max_size\":4}}]}";
+                return out;
+            }
+            if (req.op == bt::model_service_operation::start) {
+                ++sessions;
+                out.status = bt::model_service_status::action_chunk;
+                out.output_json = "{\"actions\":[{\"type\":\"joint_targets\",\"values\":[0.5],\"dt_ms\":33}]}";
+                return out;
+            }
+            // One action per batch item, 0.1 * N for the item whose instruction is "move-N".
+            std::string entries;
+            std::size_t items = 0;
+            for (std::size_t pos = req.input_json.find("\"id\":\"vla-invoke-"); pos != std::string::npos;
+                 pos = req.input_json.find("\"id\":\"vla-invoke-", pos + 1)) {
+                const std::size_t move = req.input_json.find("move-", pos);
+                const int n = req.input_json[move + 5] - '0';
+                entries += std::string(items == 0 ? "" : ",") +
+                           "{\"status\":\"action_chunk\",\"output\":{\"actions\":[{\"type\":\"joint_targets\","
+                           "\"values\":[" + std::to_string(0.1 * n) + "],\"dt_ms\":33}]}}";
+                ++items;
+            }
+            batch_sizes.push_back(items);
+            out.output_json = "{\"batch\":[" + entries + "]}";
+            return out;
+        }
+    };
+
+    const auto make_request = [](int n) {
+        bt::vla_request req;
+        req.capability = "cap.vla.action_chunk.v1";
+        req.task_id = "batch-task";
+        req.instruction = "move-" + std::to_string(n);
+        req.deadline_ms = 2000;
+        req.action_space.dims = 1;
+        req.action_space.bounds = {{-1.0, 1.0}};
+        req.model.name = "model-service";
+        req.model.version = "mmsp";
+        req.node_name = "vla-" + std::to_string(n);
+        return req;
+    };
+    const auto wait_final = [](bt::runtime_host& host, bt::vla_service::vla_job_id id) {
+        const auto until = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        bt::vla_poll polled = host.vla_ref().poll(id);
+        while (!polled.final.has_value() && std::chrono::steady_clock::now() < until) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            polled = host.vla_ref().poll(id);
+        }
+        return polled;
+    };
+
+    bt::runtime_host host(bt::runtime_host_options{.scheduler_workers = 4});
+    bt::model_service_config cfg;
+    cfg.batch_window_ms = 50;
+    auto client = std::make_unique<batching_client>();
+    batching_client* client_ptr = client.get();
+    host.set_model_service_client(cfg, std::move(client));
+    check(host.model_service_batch_limit("cap.vla.action_chunk.v1") == 4, "describe batch max_size should be read");
+    check(host.model_service_batch_limit("cap.vla.propose_nav_goal.v1") == 1,
+          "capability without a batch descriptor should not batch");
+
+    std::vector<bt::vla_service::vla_job_id> ids;
+    for (int n = 1; n <= 3; ++n) {
+        ids.push_back(host.vla_ref().submit(make_request(n)));
+    }
+    for (int n = 1; n <= 3; ++n) {
+        const bt::vla_poll polled = wait_final(host, ids[static_cast<std::size_t>(n - 1)]);
+        check(polled.final.has_value() && polled.final->status == bt::vla_status::ok,
+              "batched VLA job should complete ok");
+        check(polled.final->action.u.size() == 1 && std::fabs(polled.final->action.u[0] - 0.1 * n) < 1.0e-9,
+              "batched VLA job should receive its own batch entry");
+        check(!polled.final->model_service_request_hashes.empty(), "batched VLA job should record the batch hash");
+    }
+    check(client_ptr->describes == 1, "describe should be sent once and cached");
+    check(client_ptr->sessions == 0, "batched VLA jobs should not open sessions");
+    std::size_t batched_items = 0;
+    std::size_t largest_batch = 0;
+    for (const std::size_t size : client_ptr->batch_sizes) {
+        batched_items += size;
+        largest_batch = std::max(largest_batch, size);
+    }
+    check(batched_items == 3, "every VLA job should be sent in exactly one batch");
+    check(largest_batch >= 2, "jobs submitted together should share a batch");
+
+    bt::model_service_config unbatched_cfg;
+    auto unbatched_client = std::make_unique<batching_client>();
+    batching_client* unbatched_ptr = unbatched_client.get();
+    host.set_model_service_client(unbatched_cfg, std::move(unbatched_client));
+    const bt::vla_poll unbatched = wait_final(host, host.vla_ref().submit(make_request(4)));
+    check(unbatched.final.has_value() && unbatched.final->status == bt::vla_status::ok,
+          "unbatched VLA job should complete ok");
+    check(unbatched_ptr->sessions == 1 && unbatched_ptr->batch_sizes.empty(),
+          "batch_window_ms 0 should keep the session path");
+    check(unbatched_ptr->describes == 0, "batch_window_ms 0 should not send describe");
+
+    std::vector<bt::model_service_request> items(2);
+    items[0].id = "a";
+    items[0].capability = "cap.vla.action_chunk.v1";
+    items[0].deadline_ms = 300;
+    items[1].id = "b";
+    items[1].capability = "cap.vla.action_chunk.v1";
+    items[1].deadline_ms = 200;
+    const bt::model_service_request batch = bt::make_model_service_batch_request(items, "batch-1");
+    check(batch.deadline_ms == 200, "batch deadline should be the earliest item deadline");
+    bt::model_service_response partial;
+    partial.status = bt::model_service_status::success;
+    partial.output_json =
+        "{\"batch\":[{\"status\":\"action_chunk\",\"output\":{\"actions\":[{\"type\":\"joint_targets\","
+        "\"values\":[0.1],\"dt_ms\":33}]}}]}";
+    const std::vector<bt::model_service_response> split = bt::split_model_service_batch_response(items, partial);
+    check(split.size() == 2 && split[0].validation_ok && split[0].id == "a", "first batch entry should validate");
+    check(split[1].status == bt::model_service_status::invalid_output &&
+              split[1].error_code == "model_service_batch_incomplete",
+          "missing batch entry should be invalid_output");
+}
+
+void test_model_service_frame_ring() {
+#if !defined(_WIN32)
+    const std::string ring_name = "muesli-bt-test-" + std::to_string(static_cast<long long>(::getpid()));
+    const auto bytes_of = [](const std::string& text) {
+        return std::as_bytes(std::span<const char>(text.data(), text.size()));
+    };
+    const auto text_of = [](const std::vector<std::byte>& bytes) {
+        return std::string(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    };
+
+    {
+        const std::shared_ptr<bt::frame_ring> ring = bt::frame_ring::create(ring_name, 2, 16);
+        const std::shared_ptr<bt::frame_ring> reader = bt::frame_ring::open(ring_name);
+        check(reader->slot_count() == 2 && reader->slot_bytes() == 16, "opened ring should read the layout header");
+
+        const std::uint64_t first = ring->publish(bytes_of("frame-0"), bt::frame_ring_meta{
+                                                                           .width = 2,
+                                                                           .height = 1,
+                                                                           .channels = 3,
+                                                                           .encoding = "rgb8",
+                                                                           .timestamp_ms = 10,
+                                                                       });
+        std::vector<std::byte> out;
+        bt::frame_ring_meta meta;
+        check(first == 0 && reader->read(first, out, &meta) && text_of(out) == "frame-0",
+              "a second mapping should read the published frame");
+        check(meta.width == 2 && meta.channels == 3 && meta.encoding == "rgb8" && meta.timestamp_ms == 10,
+              "frame metadata should travel with the slot");
+        check(!reader->read(1, out), "unpublished sequences should not read");
+
+        (void)ring->publish(bytes_of("frame-1"), {});
+        (void)ring->publish(bytes_of("frame-2"), {});
+        check(!reader->read(first, out), "a frame overwritten by wrap-around should not read");
+        check(reader->read(2, out) && text_of(out) == "frame-2", "the newest frame should read after wrap-around");
+
+        bool too_large = false;
+        try {
+            (void)ring->publish(bytes_of(std::string(17, 'x')), {});
+        } catch (const std::length_error&) {
+            too_large = true;
+        }
+        check(too_large, "frames larger than slot_bytes should be rejected");
+
+        const auto parsed = bt::parse_frame_ring_ref(ring->ref(2));
+        check(parsed.has_value() && parsed->first == ring_name && parsed->second == 2, "shm refs should round-trip");
+        check(!bt::parse_frame_ring_ref("frame://camera1/2").has_value(), "frame:// refs are not ring refs");
+    }
+    bool unlinked = false;
+    try {
+        (void)bt::frame_ring::open(ring_name);
+    } catch (const std::runtime_error&) {
+        unlinked = true;
+    }
+    check(unlinked, "the owning ring should unlink its shared-memory object");
+
+    struct refs_client final : bt::model_service_client {
+        std::mutex mutex;
+        std::vector<std::string> refs_json;
+        std::string input_json;
+        bt::model_service_response call(const bt::model_service_request& req) override {
+            std::lock_guard<std::mutex> lock(mutex);
+            refs_json = req.refs_json;
+            input_json = req.input_json;
+            bt::model_service_response out;
+            out.id = req.id;
+            out.status = bt::model_service_status::action_chunk;
+            out.output_json = "{\"actions\":[{\"type\":\"joint_targets\",\"values\":[0.25],\"dt_ms\":33}]}";
+            return out;
+        }
+    };
+
+    bt::runtime_host host;
+    const bt::image_handle_ref pooled = host.vla_ref().create_image(1, 1, 1, "gray8", 0, "cam", bytes_of("x"));
+    const std::optional<bt::image_info> pooled_info = host.vla_ref().get_image_info(pooled);
+    check(pooled_info.has_value() && pooled_info->in_process && pooled_info->frame_ref.empty(),
+          "image payloads without a frame ring should be held in process");
+
+    bt::model_service_config cfg;
+    cfg.frame_ring_name = ring_name;
+    cfg.frame_ring_slots = 4;
+    cfg.frame_ring_slot_bytes = 64;
+    auto client = std::make_unique<refs_client>();
+    refs_client* client_ptr = client.get();
+    host.set_model_service_client(cfg, std::move(client));
+
+    const std::string pixels = "abcdefghijkl";
+    const bt::image_handle_ref image =
+        host.vla_ref().create_image(2, 2, 3, "rgb8", 42, "wrist", bytes_of(pixels));
+    const std::optional<bt::image_info> info = host.vla_ref().get_image_info(image);
+    check(info.has_value() && info->frame_ref == "shm://" + ring_name + "/0", "image payload should get a ring ref");
+    std::vector<std::byte> mapped;
+    check(bt::frame_ring::open(ring_name)->read(0, mapped) && text_of(mapped) == pixels,
+          "a service mapping the ring by name should read the image bytes");
+
+    bt::vla_request req;
+    req.capability = "cap.vla.action_chunk.v1";
+    req.instruction = "look";
+    req.observation.image = image;
+    req.action_space.dims = 1;
+    req.action_space.bounds = {{-1.0, 1.0}};
+    req.model.name = "model-service";
+    const bt::vla_service::vla_job_id id = host.vla_ref().submit(req);
+    const auto until = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    bt::vla_poll polled = host.vla_ref().poll(id);
+    while (!polled.final.has_value() && std::chrono::steady_clock::now() < until) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        polled = host.vla_ref().poll(id);
+    }
+    check(polled.final.has_value() && polled.final->status == bt::vla_status::ok, "ring-backed VLA job should run");
+    {
+        std::lock_guard<std::mutex> lock(client_ptr->mutex);
+        check(client_ptr->refs_json.size() == 1 &&
+                  client_ptr->refs_json[0] == "{\"type\":\"shm_frame\",\"name\":\"wrist\",\"ref\":\"shm://" + ring_name +
+                                                  "/0\"}",
+              "model-service refs should carry the image's shm ref");
+        check(client_ptr->input_json.find("\"images\":{\"wrist\":{\"ref\":\"shm://" + ring_name + "/0\"}}") !=
+                  std::string::npos,
+              "model-service input should name the image by its frame id");
+    }
+    check(polled.final->frame_refs.size() == 1 && polled.final->frame_refs[0] == info->frame_ref,
+          "VLA records should keep the shm frame ref");
+
+    host.clear_model_service_client();
+    check(!host.vla_ref().attached_frame_ring(), "clearing the model service should detach the frame ring");
+#endif
+}
+
+void test_model_service_hedged_invoke() {
+    // Answers from a thread after `delay_ms`, so call_async returns before the response exists.
+    struct delayed_client final : bt::model_service_client {
+        explicit delayed_client(std::string name) : backend(std::move(name)) {}
+        ~delayed_client() override {
+            for (std::thread& t : threads) {
+                t.join();
+            }
+        }
+        bt::model_service_response respond(const bt::model_service_request& req) const {
+            bt::model_service_response out;
+            out.id = req.id;
+            out.status = bt::model_service_status::success;
+            out.output_json = valid ? "{\"predicted_states\":[{\"vector\":[0.0]}]}" : "{}";
+            out.metadata_json = "{\"backend\":\"" + backend + "\"}";
+            out.raw_json = bt::model_service_response_to_json(out);
+            return out;
+        }
+        bt::model_service_response call(const bt::model_service_request& req) override { return respond(req); }
+        std::future<bt::model_service_response> call_async(const bt::model_service_request& req) override {
+            auto promise = std::make_shared<std::promise<bt::model_service_response>>();
+            std::future<bt::model_service_response> future = promise->get_future();
+            const int delay = delay_ms.load();
+            if (delay == 0) {
+                promise->set_value(respond(req));
+                return future;
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            threads.emplace_back([this, promise, req, delay] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+                promise->set_value(respond(req));
+            });
+            return future;
+        }
+        std::string backend;
+        std::atomic<int> delay_ms{0};
+        bool valid = true;
+        std::mutex mutex;
+        std::vector<std::thread> threads;
+    };
+
+    bt::runtime_host host;
+    bt::model_service_config cfg;
+    cfg.hedge_percentile = 90.0;
+    cfg.hedge_min_delay_ms = 5;
+    auto primary = std::make_unique<delayed_client>("primary");
+    auto secondary = std::make_unique<delayed_client>("secondary");
+    delayed_client* primary_ptr = primary.get();
+    delayed_client* secondary_ptr = secondary.get();
+    host.set_model_service_client(cfg, std::move(primary), std::move(secondary));
+
+    bt::model_service_request req;
+    req.id = "rollout-1";
+    req.op = bt::model_service_operation::invoke;
+    req.capability = "cap.model.world.rollout.v1";
+    req.input_json = "{\"state\":{\"vector\":[0.0]},\"actions\":[]}";
+    for (int i = 0; i < 16; ++i) {
+        (void)host.call_model_service(req);
+    }
+    check(host.model_service_hedge_stats_snapshot().hedged == 0, "calls should not be hedged before latencies are known");
+
+    primary_ptr->delay_ms = 300;
+    const auto start = std::chrono::steady_clock::now();
+    const bt::model_service_response won = host.call_model_service(req);
+    check(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(250),
+          "a hedged call should not wait for the slow primary");
+    check(won.metadata_json.find("secondary") != std::string::npos && won.id == req.id,
+          "the hedge response should win under the original request id");
+    check(won.validation_ok && !won.request_hash.empty(), "the winning response should be validated and hashed");
+    bt::model_service_hedge_stats stats = host.model_service_hedge_stats_snapshot();
+    check(stats.hedged == 1 && stats.hedge_wins == 1, "hedge counters should record the win");
+
+    secondary_ptr->valid = false;
+    const bt::model_service_response kept = host.call_model_service(req);
+    check(kept.metadata_json.find("primary") != std::string::npos && kept.validation_ok,
+          "an invalid hedge response should not beat a valid primary");
+    stats = host.model_service_hedge_stats_snapshot();
+    check(stats.hedged == 2 && stats.hedge_wins == 1, "a lost hedge should not count as a win");
+    host.clear_model_service_client();
+}
+
+void test_model_service_check_on_first_use() {
+    using namespace muslisp;
+
+    struct counting_client final : bt::model_service_client {
+        explicit counting_client(int& describes, int& invokes) : describe_calls(describes), invoke_calls(invokes) {}
+        bt::model_service_response call(const bt::model_service_request& req) override {
+            bt::model_service_response out;
+            out.id = req.id;
+            out.status = bt::model_service_status::success;
+            if (req.op == bt::model_service_operation::describe) {
+                ++describe_calls;
+                out.output_json = "{\"capabilities\":[{\"id\":\"cap.model.world.rollout.v1\"}]}";
+            } else {
+                ++invoke_calls;
+            }
+            return out;
+        }
+        int& describe_calls;
+        int& invoke_calls;
+    };
+
+    reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
+    int describes = 0;
+    int invokes = 0;
+    host.set_model_service_client(bt::model_service_config{}, std::make_unique<counting_client>(describes, invokes));
+    host.check_model_service_on_first_use();
+    check(describes == 0, "a deferred check should not call the service when configured");
+
+    bt::model_service_request request;
+    request.id = "first-use";
+    request.op = bt::model_service_operation::invoke;
+    request.capability = "cap.model.world.rollout.v1";
+    bt::model_service_response response = host.call_model_service(request);
+    check(describes == 1 && invokes == 0, "the first call should run the describe check and stop there");
+    check(response.error_code == "model_service_incompatible" && response.id == "first-use",
+          "an incompatible service should refuse the call");
+    response = host.call_model_service(request);
+    check(describes == 1 && invokes == 0, "the failed check should be kept, not repeated");
+
+    bt::model_service_request describe;
+    describe.id = "describe";
+    describe.op = bt::model_service_operation::describe;
+    (void)host.call_model_service(describe);
+    check(describes == 2, "describe calls should pass a failed deferred check");
+
+    host.set_model_service_client(bt::model_service_config{}, std::make_unique<counting_client>(describes, invokes));
+    (void)host.call_model_service(request);
+    check(describes == 2 && invokes == 1, "a new client should drop the deferred check");
+
+    env_ptr env = create_global_env();
+    (void)eval_text("(define cfg (map.make))", env);
+    (void)eval_text("(map.set! cfg 'check_on_first_use 1)", env);
+    expect_lisp_error_message("(model-service.configure cfg)", env,
+                              "model-service.configure check_on_first_use: expected boolean",
+                              "model-service.configure check_on_first_use type");
+}
+
+void test_model_service_mux() {
+#if !defined(_WIN32)
+    // Holds every call for 100 ms so concurrent duplicates overlap.
+    struct counting_upstream final : bt::model_service_client {
+        explicit counting_upstream(std::atomic<int>& counter) : calls(counter) {}
+        bt::model_service_response call(const bt::model_service_request& req) override {
+            ++calls;
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            bt::model_service_response out;
+            out.id = req.id;
+            out.status = bt::model_service_status::success;
+            out.output_json = req.op == bt::model_service_operation::describe ? "{\"capabilities\":[]}"
+                                                                             : "{\"predicted_states\":[{\"vector\":[1.0]}]}";
+            out.raw_json = bt::model_service_response_to_json(out);
+            return out;
+        }
+        std::atomic<int>& calls;
+    };
+
+    std::atomic<int> upstream_calls{0};
+    const std::filesystem::path socket_path = temp_file_path("mux", ".sock");
+    bt::model_service_mux_options options;
+    options.socket_path = socket_path.string();
+    auto mux = std::make_unique<bt::model_service_mux>(options, std::make_unique<counting_upstream>(upstream_calls));
+    check(std::filesystem::exists(socket_path), "the mux should listen on its socket path");
+
+    bt::model_service_config cfg;
+    cfg.endpoint = "unix://" + socket_path.string();
+    cfg.request_timeout_ms = 2000;
+    check(bt::is_unix_model_service_endpoint(cfg.endpoint), "unix:// endpoints should be recognised");
+    std::unique_ptr<bt::model_service_client> first = bt::make_unix_model_service_client(cfg);
+    std::unique_ptr<bt::model_service_client> second = bt::make_unix_model_service_client(cfg);
+
+    bt::model_service_request req;
+    req.op = bt::model_service_operation::invoke;
+    req.capability = "cap.model.world.rollout.v1";
+    req.input_json = "{\"state\":{\"vector\":[1.0]}}";
+    bt::model_service_request other = req;
+    req.id = "client-a";
+    other.id = "client-b";
+    other.deadline_ms = 250;
+    check(bt::model_service_dedup_key(req) == bt::model_service_dedup_key(other),
+          "the dedup key should ignore ids and deadlines");
+    std::future<bt::model_service_response> a = first->call_async(req);
+    std::future<bt::model_service_response> b = second->call_async(other);
+    const bt::model_service_response got_a = a.get();
+    const bt::model_service_response got_b = b.get();
+    check(got_a.status == bt::model_service_status::success && got_a.id == "client-a",
+          "the first client should get its own id back");
+    check(got_b.status == bt::model_service_status::success && got_b.id == "client-b" &&
+              got_b.output_json == got_a.output_json,
+          "the second client should share the response under its own id");
+    check(upstream_calls == 1, "identical in-flight invokes should reach the upstream once");
+
+    bt::model_service_request describe;
+    describe.id = "describe-1";
+    describe.op = bt::model_service_operation::describe;
+    (void)first->call(describe);
+    describe.id = "describe-2";
+    check(second->call(describe).id == "describe-2", "a cached describe should carry the caller's id");
+    check(upstream_calls == 2, "describe responses should be cached");
+
+    bt::model_service_request start;
+    start.id = "start";
+    start.op = bt::model_service_operation::start;
+    start.capability = "cap.vla.action_chunk.v1";
+    check(bt::model_service_dedup_key(start).empty(), "session ops should have no dedup key");
+    (void)first->call(start);
+    (void)second->call(start);
+    check(upstream_calls == 4, "session ops should never be shared");
+
+    bt::runtime_host host;
+    host.set_model_service_client(cfg, bt::make_unix_model_service_client(cfg));
+    req.id = "via-host";
+    const bt::model_service_response hosted = host.call_model_service(req);
+    check(hosted.status == bt::model_service_status::success && hosted.validation_ok && hosted.id == "via-host",
+          "the runtime host should call through the mux");
+    host.clear_model_service_client();
+
+    const bt::model_service_mux_stats stats = mux->stats();
+    check(stats.clients_accepted >= 2 && stats.deduplicated == 1 && stats.cache_hits == 1,
+          "mux stats should count deduplicated calls and cache hits");
+
+    mux.reset();
+    check(!std::filesystem::exists(socket_path), "the mux should remove its socket when destroyed");
+    req.id = "after";
+    check(first->call(req).status == bt::model_service_status::unavailable,
+          "calls should be unavailable once the mux is gone");
+#endif
+}
+
+void test_replay_store_index_and_journal() {
+#if !defined(_WIN32)
+    const std::filesystem::path dir = temp_file_path("replay_store", "");
+    std::filesystem::remove_all(dir);
+    {
+        std::shared_ptr<bt::replay_store> store = bt::replay_store::open(dir);
+        store->put(30, "thirty");
+        store->put(10, "ten");
+        store->put(20, "");
+        check(store->size() == 3, "replay store should count journal entries");
+        check(store->find(10) == std::optional<std::string>("ten"), "journal entries should be found");
+        check(store->find(20) == std::optional<std::string>(""), "empty payloads should round-trip");
+        check(!store->find(40).has_value(), "unknown keys should miss");
+        store->compact();
+        check(std::filesystem::file_size(dir / "replay.journal") == 0, "compact should empty the journal");
+        store->put(10, "ten again");
+        store->put(40, "forty");
+        check(store->size() == 4, "a key stored twice should count once");
+    }
+    {
+        std::shared_ptr<bt::replay_store> store = bt::replay_store::open(dir);
+        check(store->find(10) == std::optional<std::string>("ten again"), "the later put should win after reopening");
+        check(store->find(30) == std::optional<std::string>("thirty"), "indexed entries should be read from the map");
+        check(store->find(40) == std::optional<std::string>("forty"), "journal entries should survive reopening");
+        store->compact();
+        check(store->size() == 4 && store->find(10) == std::optional<std::string>("ten again"),
+              "compact should keep the newest payload of each key");
+        store->put(50, std::string(100000, 'z'));
+        check(store->find(50).value_or("").size() == 100000, "payloads appended after mapping should be read back");
+    }
+    {
+        std::ofstream(dir / "replay.journal", std::ios::binary | std::ios::app) << "torn";
+        std::shared_ptr<bt::replay_store> store = bt::replay_store::open(dir);
+        check(store->size() == 5, "a torn journal tail should be ignored");
+    }
+    {
+        std::ofstream(dir / "replay.index", std::ios::binary | std::ios::trunc) << "not an index at all!!!!!!";
+        bool rejected = false;
+        try {
+            (void)bt::replay_store::open(dir);
+        } catch (const std::runtime_error&) {
+            rejected = true;
+        }
+        check(rejected, "a foreign replay.index should be rejected");
+    }
+    std::filesystem::remove_all(dir);
+#endif
+}
+
+void test_vla_request_hash_streams_canonical_text() {
+    bt::vla_request req;
+    req.capability = "vla.rt2";
+    req.task_id = "task-7";
+    req.instruction = std::string(4096, 'x') + " pick up the cup";
+    req.observation.timestamp_ms = -12;
+    req.observation.frame_id = "wrist";
+    req.observation.image = bt::image_handle_ref{.id = 3};
+    req.observation.blob = bt::blob_handle_ref{.id = 9};
+    req.observation.state = {0.0, -0.5, 1e-7, 123456789.0, 1.0 / 3.0, std::numeric_limits<double>::infinity()};
+    req.action_space.dims = 2;
+    req.action_space.bounds = {{-1.0, 1.0}, {-2.5, 2.5e10}};
+    req.model.name = "rt2-stub";
+    req.model.version = "stub-1";
+    req.deadline_ms = 25;
+    req.constraints.max_abs_value = 0.75;
+    req.constraints.max_delta = 0.125;
+
+    const std::string canonical = bt::vla_service::canonical_request(req);
+    check(canonical.find("state:0,-0.5,1e-07,1.23457e+08,0.333333,inf,") != std::string::npos,
+          "canonical request text should keep the ostream number format");
+    check(bt::vla_service::hash_request(req) == bt::vla_service::hash64(canonical),
+          "hash_request should equal hash64 of the canonical request text");
+
+    req.observation.image.reset();
+    req.observation.blob.reset();
+    req.observation.state.clear();
+    req.action_space.bounds.clear();
+    check(bt::vla_service::hash_request(req) == bt::vla_service::hash64(bt::vla_service::canonical_request(req)),
+          "hash_request should match the canonical text without optional fields");
+    check((bt::hash64_stream{} << std::string_view("ab") << 'c').value() == bt::vla_service::hash64("abc"),
+          "hash64_stream pieces should hash like the whole text");
+}
+
+void test_vla_response_cache_lru_ttl_and_stats() {
+    using clock = bt::vla_response_cache::clock;
+    const auto key = [](std::uint64_t shard, std::uint64_t n) { return (n << 36) | (shard << 32) | n; };
+    const auto response = [](double u) {
+        bt::vla_response out;
+        out.status = bt::vla_status::ok;
+        out.action.u = {u};
+        return out;
+    };
+    const auto t0 = clock::now();
+    const auto far = t0 + std::chrono::hours(1);
+
+    bt::vla_response_cache cache(3);
+    cache.insert(key(0, 1), response(1.0), far);
+    cache.insert(key(0, 2), response(2.0), far);
+    cache.insert(key(0, 3), response(3.0), far);
+    const std::optional<bt::vla_response> first = cache.find(key(0, 1), t0);
+    check(first.has_value() && first->action.u[0] == 1.0, "a cached response should be found");
+    cache.insert(key(0, 4), response(4.0), far);
+    check(!cache.find(key(0, 2), t0).has_value(), "the least recently used entry should be evicted");
+    check(cache.find(key(0, 1), t0).has_value() && cache.find(key(0, 4), t0).has_value(),
+          "recently used entries should survive eviction");
+    bt::vla_cache_stats stats = cache.stats();
+    check(stats.hits == 3 && stats.misses == 1 && stats.evictions == 1 && stats.size == 3 && stats.capacity == 3,
+          "cache counters should track hits, misses and evictions");
+
+    cache.insert(key(1, 5), response(5.0), t0 + std::chrono::milliseconds(10));
+    check(cache.stats().size == 3, "capacity should bound entries across shards");
+    check(cache.find(key(1, 5), t0).has_value(), "an entry should be live before its TTL");
+    check(!cache.find(key(1, 5), t0 + std::chrono::milliseconds(10)).has_value(), "an entry should expire at its TTL");
+    stats = cache.stats();
+    check(stats.expirations == 1 && stats.size == 2, "an expired entry should be counted and dropped");
+
+    cache.set_capacity(1);
+    check(cache.stats().size == 1, "shrinking the capacity should evict down to it");
+    cache.set_capacity(0);
+    cache.insert(key(2, 6), response(6.0), far);
+    check(cache.stats().size == 0, "a zero capacity should cache nothing");
+
+    cache.set_capacity(10000);
+    for (std::uint64_t n = 0; n < 20000; ++n) {
+        cache.insert(bt::vla_service::hash64(std::to_string(n)), response(0.0), far);
+    }
+    stats = cache.stats();
+    check(stats.size == 10000 && stats.evictions >= 10000, "a large cache should hold exactly its capacity");
+    check(cache.find(bt::vla_service::hash64("19999"), t0).has_value(), "the newest entry should be cached");
+    cache.clear();
+    check(cache.stats().size == 0, "clear should drop every entry");
+}
+
+void test_vla_builtins_submit_poll_cancel_and_caps() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
+
+    value caps = eval_text("(cap.list)", env);
+    check(is_proper_list(caps), "cap.list should return list");
+    bool saw_vla = false;
+    for (value cap_name : vector_from_list(caps)) {
+        if (is_string(cap_name) && string_value(cap_name).find("vla.") != std::string::npos) {
+            saw_vla = true;
+        }
+    }
+    check(saw_vla, "cap.list should include vla capability");
+    check(is_map(eval_text("(cap.describe \"vla.rt2\")", env)), "cap.describe should return map");
+
+    (void)eval_text(
+        "(define req (map.make))"
+        "(map.set! req 'task_id \"task-demo\")"
+        "(map.set! req 'instruction \"move right\")"
+        "(map.set! req 'deadline_ms 250)"
+        "(map.set! req 'seed 42)"
+        "(let ((obs (map.make)))"
+        "  (map.set! obs 'state (list 0.1))"
+        "  (map.set! obs 'timestamp_ms 1000)"
+        "  (map.set! obs 'frame_id \"base\")"
+        "  (map.set! req 'observation obs))"
+        "(let ((space (map.make)))"
+        "  (map.set! space 'type ':continuous)"
+        "  (map.set! space 'dims 1)"
+        "  (map.set! space 'bounds (list (list -1.0 1.0)))"
+        "  (map.set! req 'action_space space))"
+        "(let ((con (map.make)))"
+        "  (map.set! con 'max_abs_value 1.0)"
+        "  (map.set! con 'max_delta 1.0)"
+        "  (map.set! req 'constraints con))"
+        "(let ((m (map.make)))"
+        "  (map.set! m 'name \"rt2-stub\")"
+        "  (map.set! m 'version \"stub-1\")"
+        "  (map.set! req 'model m))",
+        env);
+
+    value job = eval_text("(vla.submit req)", env);
+    check(is_integer(job) && integer_value(job) > 0, "vla.submit should return positive job id");
+    const std::int64_t job_id = integer_value(job);
+
+    bool done = false;
+    for (int i = 0; i < 250; ++i) {
+        value st = eval_text("(map.get (vla.poll " + std::to_string(job_id) + ") 'status ':none)", env);
+        check(is_symbol(st), "vla.poll status should be symbol");
+        const std::string name = symbol_name(st);
+        if (name == ":done") {
+            done = true;
+            break;
+        }
+        if (name == ":error" || name == ":timeout" || name == ":cancelled") {
+            throw std::runtime_error("vla.poll unexpectedly reached terminal non-done state: " + name);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    check(done, "vla job should complete");
+
+    value final_status =
+        eval_text("(map.get (map.get (vla.poll " + std::to_string(job_id) + ") 'final (map.make)) 'status ':none)", env);
+    check(is_symbol(final_status) && symbol_name(final_status) == ":ok", "vla final status should be :ok");
+    value final_action =
+        eval_text("(map.get (map.get (map.get (vla.poll " + std::to_string(job_id) + ") 'final (map.make)) 'action (map.make)) 'u nil)",
+                  env);
+    check(is_proper_list(final_action), "vla final action.u should be list");
+    const std::vector<value> action_items = vector_from_list(final_action);
+    check(action_items.size() == 1 && is_float(action_items[0]), "vla final action should be one float");
+    check(float_value(action_items[0]) >= -1.0 && float_value(action_items[0]) <= 1.0, "vla final action out of bounds");
+
+    value job2 = eval_text("(vla.submit req)", env);
+    check(is_integer(job2) && integer_value(job2) > 0, "second vla.submit should return positive job id");
+    value cancelled = eval_text("(vla.cancel " + std::to_string(integer_value(job2)) + ")", env);
+    check(is_boolean(cancelled), "vla.cancel should return boolean");
+
+    (void)eval_text(
+        "(define bad-req (map.make))"
+        "(map.set! bad-req 'task_id \"bad\")"
+        "(map.set! bad-req 'deadline_ms 20)"
+        "(let ((obs (map.make)))"
+        "  (map.set! obs 'state (list 0.0))"
+        "  (map.set! obs 'timestamp_ms 1000)"
+        "  (map.set! obs 'frame_id \"base\")"
+        "  (map.set! bad-req 'observation obs))"
+        "(let ((space (map.make)))"
+        "  (map.set! space 'type ':continuous)"
+        "  (map.set! space 'dims 1)"
+        "  (map.set! space 'bounds (list (list -1.0 1.0)))"
+        "  (map.set! bad-req 'action_space space))"
+        "(let ((con (map.make)))"
+        "  (map.set! con 'max_abs_value 1.0)"
+        "  (map.set! con 'max_delta 1.0)"
+        "  (map.set! bad-req 'constraints con))"
+        "(let ((m (map.make)))"
+        "  (map.set! m 'name \"rt2-stub\")"
+        "  (map.set! m 'version \"stub-1\")"
+        "  (map.set! bad-req 'model m))",
+        env);
+    value bad_job = eval_text("(vla.submit bad-req)", env);
+    check(is_integer(bad_job) && integer_value(bad_job) > 0, "bad request submit should still return job id");
+    value bad_status = eval_text("(map.get (vla.poll " + std::to_string(integer_value(bad_job)) + ") 'status ':none)", env);
+    check(is_symbol(bad_status) && symbol_name(bad_status) == ":error", "bad request should become error immediately");
+
+    value vla_events = eval_text("(events.dump 80)", env);
+    check(is_proper_list(vla_events), "events.dump should return list");
+    const auto vla_rows = vector_from_list(vla_events);
+    bool saw_vla_result = false;
+    bool saw_task_id = false;
+    bool saw_validation_error = false;
+    for (const value& row : vla_rows) {
+        if (!is_string(row)) {
+            continue;
+        }
+        const std::string line = string_value(row);
+        if (line.find("\"type\":\"vla_result\"") != std::string::npos) {
+            saw_vla_result = true;
+        }
+        if (line.find("\"task_id\"") != std::string::npos) {
+            saw_task_id = true;
+        }
+        if (line.find("request.instruction is required") != std::string::npos) {
+            saw_validation_error = true;
+        }
+    }
+    check(saw_vla_result, "events should include vla_result");
+    check(saw_task_id, "vla events should contain task_id");
+    check(bt::default_runtime_host().dump_vla_records().find("\"cache\":{\"hits\":") != std::string::npos,
+          "vla records should carry the response cache counters");
+    check(saw_validation_error, "vla events should include immediate validation errors");
+}
+
+void test_vla_bt_nodes_flow_and_cancel() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
+
+    (void)eval_text(
+        "(define flow-tree "
+        "  (bt.compile "
+        "    '(sel "
+        "       (seq "
+        "         (vla-wait :name \"flow\" :job_key flow-job :action_key flow-action :meta_key flow-meta) "
+        "         (succeed)) "
+        "       (seq "
+        "         (act bb-put-float fallback-action 0.0) "
+        "         (vla-request :name \"flow\" :job_key flow-job :instruction \"move right\" "
+        "                      :state_key state :deadline_ms 30 :dims 1 :bound_lo -1.0 :bound_hi 1.0) "
+        "         (running)))))",
+        env);
+    (void)eval_text("(define flow-inst (bt.new-instance flow-tree))", env);
+
+    bool reached_success = false;
+    for (int i = 0; i < 80; ++i) {
+        value st = eval_text("(bt.tick flow-inst '((state 0.0)))", env);
+        check(is_symbol(st), "flow tree tick should return symbol");
+        const std::string name = symbol_name(st);
+        if (name == "success") {
+            reached_success = true;
+            break;
+        }
+        check(name == "running", "flow tree should be running until success");
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    check(reached_success, "flow tree should eventually succeed");
+
+    bt::runtime_host& host = bt::default_runtime_host();
+    bt::instance* flow_inst = host.find_instance(bt_handle(eval_text("flow-inst", env)));
+    check(flow_inst != nullptr, "flow instance should exist");
+    const bt::bb_entry* action_entry = flow_inst->bb.get("flow-action");
+    check(action_entry != nullptr, "vla-wait should write flow-action");
+
+    (void)eval_text(
+        "(define cancel-tree "
+        "  (bt.compile "
+        "    '(sel "
+        "       (seq (cond bb-has stop) (vla-cancel :name \"cancel-flow\" :job_key c-job) (succeed)) "
+        "       (vla-request :name \"cancel-flow\" :job_key c-job :instruction \"move\" "
+        "                    :state_key state :deadline_ms 50 :dims 1 :bound_lo -1.0 :bound_hi 1.0))))",
+        env);
+    (void)eval_text("(define cancel-inst (bt.new-instance cancel-tree))", env);
+
+    value first = eval_text("(bt.tick cancel-inst '((state 0.0)))", env);
+    check(is_symbol(first) && symbol_name(first) == "running", "cancel tree first tick should run request");
+    value second = eval_text("(bt.tick cancel-inst '((state 0.0) (stop #t)))", env);
+    check(is_symbol(second) && symbol_name(second) == "success", "cancel tree second tick should cancel and succeed");
+
+    value cancel_events = eval_text("(events.dump 120)", env);
+    check(is_proper_list(cancel_events), "events.dump should return list for cancel outcome test");
+    bool saw_cancel_acknowledged = false;
+    for (const value& row : vector_from_list(cancel_events)) {
+        if (!is_string(row)) {
+            continue;
+        }
+        const std::string line = string_value(row);
+        if (line.find("\"type\":\"cancel_acknowledged\"") != std::string::npos &&
+            line.find("\"schema_version\":\"runtime_outcome.v1\"") != std::string::npos) {
+            saw_cancel_acknowledged = true;
+        }
+    }
+    check(saw_cancel_acknowledged, "VLA cancel should emit compact cancel_acknowledged outcome");
+}
+
+void test_vla_bt_prefetch_hit_and_supersede() {
+    using namespace muslisp;
+
+    // Holds every job until it is cancelled, so the test decides which prefetches get consumed.
+    class held_backend final : public bt::vla_backend {
+    public:
+        bt::vla_response infer(const bt::vla_request& request,
+                               std::function<bool(const bt::vla_partial&)>,
+                               std::atomic<bool>& cancel_flag) override {
+            const auto until = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+            while (!cancel_flag.load() && std::chrono::steady_clock::now() < until) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            bt::vla_response out;
+            out.status = cancel_flag.load() ? bt::vla_status::cancelled : bt::vla_status::ok;
+            out.model = request.model;
+            out.action.u = {0.0};
+            return out;
+        }
+    };
+
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
+    bt::runtime_host& host = bt::default_runtime_host();
+    host.vla_ref().register_backend("prefetch-held", std::make_shared<held_backend>());
+
+    (void)eval_text(
+        "(define pf-tree "
+        "  (bt.compile "
+        "    '(sel "
+        "       (seq (cond bb-truthy go) "
+        "            (vla-request :name \"pf\" :job_key pf-job :instruction \"move\" :state_key state "
+        "                         :prefetch_key pf-now :prefetch_state_key next-state :model_name \"prefetch-held\" "
+        "                         :deadline_ms 5000 :dims 1)) "
+        "       (succeed))))",
+        env);
+    (void)eval_text("(define pf-inst (bt.new-instance pf-tree))", env);
+    bt::instance* inst = host.find_instance(bt_handle(eval_text("pf-inst", env)));
+    check(inst != nullptr, "prefetch instance should exist");
+
+    (void)eval_text("(bt.tick pf-inst '((state 0.0) (next-state 0.5) (pf-now #t)))", env);
+    check(inst->vla_prefetches.size() == 1, "a true :prefetch_key should submit ahead of the node");
+    const std::uint64_t prefetched = inst->vla_prefetches.begin()->second.job;
+    (void)eval_text("(bt.tick pf-inst '((state 0.0) (next-state 0.5) (pf-now #t)))", env);
+    check(inst->vla_prefetches.begin()->second.job == prefetched, "an unchanged prediction should not resubmit");
+
+    value st = eval_text("(bt.tick pf-inst '((state 0.5) (go #t)))", env);
+    check(is_symbol(st) && symbol_name(st) == "running", "the node should run on the adopted prefetch");
+    const bt::bb_entry* job = inst->bb.get("pf-job");
+    check(job != nullptr && std::get<std::int64_t>(job->value) == static_cast<std::int64_t>(prefetched),
+          "a matching request should consume the prefetched job");
+    check(inst->vla_prefetches.empty(), "a consumed prefetch should be forgotten");
+    (void)host.vla_ref().cancel(prefetched);
+
+    (void)eval_text("(bt.tick pf-inst '((pf-job #f) (go #f) (next-state 0.9)))", env);
+    check(inst->vla_prefetches.size() == 1, "the node should prefetch again once its job key is cleared");
+    const std::uint64_t stale = inst->vla_prefetches.begin()->second.job;
+    check(stale != prefetched, "a new prediction should submit a new job");
+    (void)eval_text("(bt.tick pf-inst '((state 0.1) (go #t) (pf-now #f)))", env);
+    job = inst->bb.get("pf-job");
+    check(job != nullptr && std::get<std::int64_t>(job->value) != static_cast<std::int64_t>(stale),
+          "a mismatched request should submit afresh");
+    const auto until = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    bt::vla_poll polled = host.vla_ref().poll(stale);
+    while (!polled.final.has_value() && std::chrono::steady_clock::now() < until) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        polled = host.vla_ref().poll(stale);
+    }
+    check(polled.status == bt::vla_job_status::cancelled, "the stale prefetch should be superseded");
+    (void)host.vla_ref().cancel(static_cast<bt::vla_service::vla_job_id>(std::get<std::int64_t>(job->value)));
+}
+
+void test_vla_chunk_executor() {
+    using namespace muslisp;
+
+    // Answers every request with a four-step chunk 0, 1, 2, 3, each held 100 ms.
+    class chunk_backend final : public bt::vla_backend {
+    public:
+        explicit chunk_backend(std::atomic<int>& counter) : calls(counter) {}
+        bt::vla_response infer(const bt::vla_request& request,
+                               std::function<bool(const bt::vla_partial&)>,
+                               std::atomic<bool>&) override {
+            ++calls;
+            bt::vla_response out;
+            out.status = bt::vla_status::ok;
+            out.model = request.model;
+            out.action.u = {0.0};
+            for (int k = 0; k < 4; ++k) {
+                out.chunk.push_back(bt::vla_chunk_step{.u = {static_cast<double>(k)}, .dt_ms = 100.0});
+            }
+            return out;
+        }
+        std::atomic<int>& calls;
+    };
+
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
+    bt::runtime_host& host = bt::default_runtime_host();
+    std::atomic<int> calls{0};
+    host.vla_ref().register_backend("chunk-test", std::make_shared<chunk_backend>(calls));
+    bt::sim_clock& clock = host.enable_simulated_time();
+
+    (void)eval_text(
+        "(define chunk-tree "
+        "  (bt.compile "
+        "    '(vla-chunk :name \"arm\" :instruction \"move\" :state_key state :model_name \"chunk-test\" "
+        "               :deadline_ms 5000 :dims 1 :bound_lo -10.0 :bound_hi 10.0 :max_abs 10.0 :max_delta 10.0 "
+        "               :refill_below 1)))",
+        env);
+    check(print_value(eval_text("(bt.to-dsl chunk-tree)", env)).starts_with("(vla-chunk :name"),
+          "vla-chunk should round-trip through bt.to-dsl");
+    (void)eval_text("(define chunk-inst (bt.new-instance chunk-tree))", env);
+    bt::instance* inst = host.find_instance(bt_handle(eval_text("chunk-inst", env)));
+    check(inst != nullptr, "chunk instance should exist");
+
+    const auto wait_for_job = [&] {
+        check(inst->vla_chunks.size() == 1 && inst->vla_chunks.begin()->second.job != 0, "a chunk request should be in flight");
+        const std::uint64_t job = inst->vla_chunks.begin()->second.job;
+        const auto until = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!host.vla_ref().poll(job).final.has_value() && std::chrono::steady_clock::now() < until) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    };
+    const auto action = [&] { return std::get<double>(inst->bb.get("action")->value); };
+
+    value st = eval_text("(bt.tick chunk-inst '((state 0.0)))", env);
+    check(is_symbol(st) && symbol_name(st) == "running", "vla-chunk should run until its first chunk arrives");
+    wait_for_job();
+    st = eval_text("(bt.tick chunk-inst '((state 0.0)))", env);
+    check(is_symbol(st) && symbol_name(st) == "success" && action() == 0.0, "the first step should apply on arrival");
+    check(inst->vla_chunks.begin()->second.job == 0, "a full buffer should not request the next chunk");
+
+    clock.advance(std::chrono::milliseconds(150));
+    (void)eval_text("(bt.tick chunk-inst '((state 0.0)))", env);
+    check(std::abs(action() - 1.5) < 1e-9, "actions should be interpolated between steps");
+
+    clock.advance(std::chrono::milliseconds(200));
+    (void)eval_text("(bt.tick chunk-inst '((state 1.5)))", env);
+    check(action() == 3.0, "the last step should be held without interpolation");
+    wait_for_job();
+    check(calls == 2, "the next chunk should be requested once the buffer runs low");
+
+    clock.advance(std::chrono::milliseconds(20));
+    st = eval_text("(bt.tick chunk-inst '((state 3.0)))", env);
+    check(is_symbol(st) && symbol_name(st) == "success" && action() == 0.0, "an arrived chunk should replace the old one");
+    check(calls == 2, "four steps should be served per model call");
+    host.disable_simulated_time();
+
+    // The model-service gate checks every action of a chunk, not only the first.
+    bt::model_service_request chunk_req;
+    chunk_req.op = bt::model_service_operation::invoke;
+    chunk_req.capability = "cap.vla.action_chunk.v1";
+    bt::model_service_response chunk_resp;
+    chunk_resp.status = bt::model_service_status::action_chunk;
+    chunk_resp.output_json =
+        "{\"actions\":[{\"type\":\"joint_targets\",\"values\":[0.1],\"dt_ms\":33},"
+        "{\"type\":\"joint_targets\",\"values\":[0.1,0.2],\"dt_ms\":33}]}";
+    bt::validate_model_service_response(chunk_req, chunk_resp);
+    check(!chunk_resp.validation_ok && chunk_resp.validation_reason_code == "model_service_action_dims_mismatch",
+          "a chunk whose later action changes dimension should be rejected");
+}
+
+void test_bt_compile_checks() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
+    try {
+        (void)eval_text("(bt.compile '(seq))", env);
+        throw std::runtime_error("expected bt.compile arity check failure");
+    } catch (const lisp_error&) {
+    }
+
+    try {
+        (void)eval_text("(bt.compile '(unknown foo))", env);
+        throw std::runtime_error("expected bt.compile unknown-form failure");
+    } catch (const lisp_error&) {
+    }
+
+    try {
+        (void)eval_text("(bt.compile '(invert (succeed) (fail)))", env);
+        throw std::runtime_error("expected bt.compile invert arity failure");
+    } catch (const lisp_error&) {
+    }
+
+    try {
+        (void)eval_text("(bt.compile '(repeat -1 (succeed)))", env);
+        throw std::runtime_error("expected bt.compile negative repeat count failure");
+    } catch (const lisp_error&) {
+    }
+
+    try {
+        (void)eval_text("(bt.compile '(plan-action :budget_ms))", env);
+        throw std::runtime_error("expected bt.compile plan-action key/value validation failure");
+    } catch (const lisp_error&) {
+    }
+
+    try {
+        (void)eval_text("(bt.compile '(vla-request :instruction))", env);
+        throw std::runtime_error("expected bt.compile vla-request key/value validation failure");
+    } catch (const lisp_error&) {
+    }
+
+    (void)eval_text("(bt.compile '(mem-seq (succeed)))", env);
+    (void)eval_text("(bt.compile '(mem-sel (succeed)))", env);
+    (void)eval_text("(bt.compile '(async-seq (succeed)))", env);
+    (void)eval_text("(bt.compile '(reactive-seq (succeed)))", env);
+    (void)eval_text("(bt.compile '(reactive-sel (succeed)))", env);
+}
+
+void test_bt_new_composite_dsl_roundtrip() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
+    (void)eval_text(
+        "(define tree "
+        "  (bt.compile "
+        "    '(reactive-sel "
+        "       (reactive-seq (cond always-true) (async-seq (act always-success) (act always-success))) "
+        "       (mem-seq (act always-success) (mem-sel (act always-fail) (succeed))))))",
+        env);
+    value dsl = eval_text("(bt.to-dsl tree)", env);
+    check(is_cons(dsl), "bt.to-dsl should return a list");
+    check(print_value(dsl).find("reactive-sel") != std::string::npos, "dsl should include reactive-sel");
+    check(print_value(dsl).find("mem-seq") != std::string::npos, "dsl should include mem-seq");
+    check(print_value(dsl).find("mem-sel") != std::string::npos, "dsl should include mem-sel");
+    check(print_value(dsl).find("async-seq") != std::string::npos, "dsl should include async-seq");
+    check(print_value(dsl).find("reactive-seq") != std::string::npos, "dsl should include reactive-seq");
+
+    const std::filesystem::path dsl_path = temp_file_path("bt_new_nodes", ".lisp");
+    const std::filesystem::path mbt_path = temp_file_path("bt_new_nodes", ".mbt");
+    const std::string dsl_literal = lisp_string_literal(dsl_path.string());
+    const std::string mbt_literal = lisp_string_literal(mbt_path.string());
+
+    (void)eval_text("(bt.save-dsl tree " + dsl_literal + ")", env);
+    (void)eval_text("(define tree-from-dsl (bt.load-dsl " + dsl_literal + "))", env);
+    const value dsl_from_dsl = eval_text("(bt.to-dsl tree-from-dsl)", env);
+    check(print_value(dsl_from_dsl) == print_value(dsl), "new nodes should roundtrip through bt.save-dsl/bt.load-dsl");
+
+    (void)eval_text("(bt.save tree " + mbt_literal + ")", env);
+    (void)eval_text("(define tree-from-mbt (bt.load " + mbt_literal + "))", env);
+    const value dsl_from_mbt = eval_text("(bt.to-dsl tree-from-mbt)", env);
+    check(print_value(dsl_from_mbt) == print_value(dsl), "new nodes should roundtrip through bt.save/bt.load");
+
+    std::error_code ec;
+    std::filesystem::remove(dsl_path, ec);
+    std::filesystem::remove(mbt_path, ec);
+}
+
+void test_bt_mem_seq_semantics() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
+    int setup_calls = 0;
+    int fail_once_calls = 0;
+    int run_then_success_calls = 0;
+
+    host.callbacks().register_action(
+        "test-ms-setup",
+        [&setup_calls](bt::tick_context&, bt::node_id, bt::node_memory&, std::span<const muslisp::value>) {
+            ++setup_calls;
+            return bt::status::success;
+        });
+    host.callbacks().register_action(
+        "test-ms-run-then-success",
+        [&run_then_success_calls](bt::tick_context&, bt::node_id, bt::node_memory& mem, std::span<const muslisp::value>) {
+            ++run_then_success_calls;
+            if (mem.i0 == 0) {
+                mem.i0 = 1;
+                return bt::status::running;
+            }
+            mem.i0 = 0;
+            return bt::status::success;
+        });
+    host.callbacks().register_action(
+        "test-ms-fail-once",
+        [&fail_once_calls](bt::tick_context&, bt::node_id, bt::node_memory& mem, std::span<const muslisp::value>) {
+            ++fail_once_calls;
+            if (mem.i0 == 0) {
+                mem.i0 = 1;
+                return bt::status::failure;
+            }
+            mem.i0 = 0;
+            return bt::status::success;
+        });
+
+    env_ptr env = create_global_env();
+
+    (void)eval_text("(define tree-a (bt.compile '(mem-seq (act always-success) (act always-success) (act always-success))))", env);
+    (void)eval_text("(define inst-a (bt.new-instance tree-a))", env);
+    check(symbol_name(eval_text("(bt.tick inst-a)", env)) == "success", "mem-seq all-success should succeed");
+    check(symbol_name(eval_text("(bt.tick inst-a)", env)) == "success", "mem-seq should reset after success");
+
+    setup_calls = 0;
+    run_then_success_calls = 0;
+    (void)eval_text(
+        "(define tree-b (bt.compile '(mem-seq (act test-ms-setup) (act test-ms-run-then-success) (act always-success))))",
+        env);
+    (void)eval_text("(define inst-b (bt.new-instance tree-b))", env);
+    check(symbol_name(eval_text("(bt.tick inst-b)", env)) == "running", "mem-seq should return running");
+    check(setup_calls == 1, "mem-seq should tick setup exactly once before running");
+    check(symbol_name(eval_text("(bt.tick inst-b)", env)) == "success", "mem-seq should resume and succeed");
+    check(setup_calls == 1, "mem-seq should resume at running child");
+    check(run_then_success_calls == 2, "mem-seq running child should be revisited");
+
+    setup_calls = 0;
+    fail_once_calls = 0;
+    (void)eval_text("(define tree-c (bt.compile '(mem-seq (act test-ms-setup) (act test-ms-fail-once) (act always-success))))", env);
+    (void)eval_text("(define inst-c (bt.new-instance tree-c))", env);
+    check(symbol_name(eval_text("(bt.tick inst-c)", env)) == "failure", "mem-seq should fail when child fails");
+    check(symbol_name(eval_text("(bt.tick inst-c)", env)) == "success", "mem-seq should resume failing child next tick");
+    check(setup_calls == 1, "mem-seq should not rerun prior success child after failure");
+    check(fail_once_calls == 2, "mem-seq should retick failing child");
+}
+
+void test_bt_mem_sel_semantics() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
+    int fail_a_calls = 0;
+    int fail_b_calls = 0;
+    int run_then_success_calls = 0;
+
+    host.callbacks().register_action(
+        "test-msel-fail-a",
+        [&fail_a_calls](bt::tick_context&, bt::node_id, bt::node_memory&, std::span<const muslisp::value>) {
+            ++fail_a_calls;
+            return bt::status::failure;
+        });
+    host.callbacks().register_action(
+        "test-msel-fail-b",
+        [&fail_b_calls](bt::tick_context&, bt::node_id, bt::node_memory&, std::span<const muslisp::value>) {
+            ++fail_b_calls;
+            return bt::status::failure;
+        });
+    host.callbacks().register_action(
+        "test-msel-run-then-success",
+        [&run_then_success_calls](bt::tick_context&, bt::node_id, bt::node_memory& mem, std::span<const muslisp::value>) {
+            ++run_then_success_calls;
+            if (mem.i0 == 0) {
+                mem.i0 = 1;
+                return bt::status::running;
+            }
+            mem.i0 = 0;
+            return bt::status::success;
+        });
+
+    env_ptr env = create_global_env();
+
+    (void)eval_text(
+        "(define tree-a (bt.compile '(mem-sel (act test-msel-fail-a) (act test-msel-fail-b) (act test-msel-run-then-success))))",
+        env);
+    (void)eval_text("(define inst-a (bt.new-instance tree-a))", env);
+    check(symbol_name(eval_text("(bt.tick inst-a)", env)) == "running", "mem-sel should run lower-priority child");
+    check(fail_a_calls == 1 && fail_b_calls == 1, "mem-sel should evaluate failed higher priorities once");
+    check(symbol_name(eval_text("(bt.tick inst-a)", env)) == "success", "mem-sel should resume running child");
+    check(fail_a_calls == 1 && fail_b_calls == 1, "mem-sel should not retry earlier failed children while running");
+    check(run_then_success_calls == 2, "mem-sel running child should complete");
+
+    fail_a_calls = 0;
+    fail_b_calls = 0;
+    (void)eval_text("(define tree-b (bt.compile '(mem-sel (act test-msel-fail-a) (act test-msel-fail-b))))", env);
+    (void)eval_text("(define inst-b (bt.new-instance tree-b))", env);
+    check(symbol_name(eval_text("(bt.tick inst-b)", env)) == "failure", "mem-sel all-failure should fail");
+    check(symbol_name(eval_text("(bt.tick inst-b)", env)) == "failure", "mem-sel should reset after all-failure");
+    check(fail_a_calls == 2 && fail_b_calls == 2, "mem-sel reset should restart from child 0");
+}
+
+void test_bt_async_seq_semantics() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
+    int first_calls = 0;
+    int second_calls = 0;
+
+    host.callbacks().register_action(
+        "test-async-seq-first",
+        [&first_calls](bt::tick_context&, bt::node_id, bt::node_memory&, std::span<const muslisp::value>) {
+            ++first_calls;
+            return bt::status::success;
+        });
+    host.callbacks().register_action(
+        "test-async-seq-second",
+        [&second_calls](bt::tick_context&, bt::node_id, bt::node_memory&, std::span<const muslisp::value>) {
+            ++second_calls;
+            return bt::status::success;
+        });
+
+    env_ptr env = create_global_env();
+    (void)eval_text("(define tree (bt.compile '(async-seq (act test-async-seq-first) (act test-async-seq-second))))", env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    check(symbol_name(eval_text("(bt.tick inst)", env)) == "running", "async-seq should yield running between children");
+    check(first_calls == 1, "async-seq first child should run once");
+    check(second_calls == 0, "async-seq should not tick second child on first tick");
+    check(symbol_name(eval_text("(bt.tick inst)", env)) == "success", "async-seq should complete on second tick");
+    check(first_calls == 1, "async-seq should not rerun first child on second tick");
+    check(second_calls == 1, "async-seq should tick second child on resume");
+}
+
+void test_bt_reactive_preemption_and_memoryless_regressions() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
+    int seq_setup_calls = 0;
+    int sel_fail_calls = 0;
+
+    host.callbacks().register_action(
+        "test-seq-setup",
+        [&seq_setup_calls](bt::tick_context&, bt::node_id, bt::node_memory&, std::span<const muslisp::value>) {
+            ++seq_setup_calls;
+            return bt::status::success;
+        });
+    host.callbacks().register_action(
+        "test-sel-fail",
+        [&sel_fail_calls](bt::tick_context&, bt::node_id, bt::node_memory&, std::span<const muslisp::value>) {
+            ++sel_fail_calls;
+            return bt::status::failure;
+        });
+    host.callbacks().register_condition("test-gate",
+                                        [](bt::tick_context& ctx, std::span<const muslisp::value>) -> bool {
+                                            const bt::bb_entry* entry = ctx.bb_get("gate");
+                                            if (!entry) {
+                                                return false;
+                                            }
+                                            if (const bool* b = std::get_if<bool>(&entry->value)) {
+                                                return *b;
+                                            }
+                                            return false;
+                                        });
+    host.callbacks().register_condition("test-high-priority",
+                                        [](bt::tick_context& ctx, std::span<const muslisp::value>) -> bool {
+                                            const bt::bb_entry* entry = ctx.bb_get("high");
+                                            if (!entry) {
+                                                return false;
+                                            }
+                                            if (const bool* b = std::get_if<bool>(&entry->value)) {
+                                                return *b;
+                                            }
+                                            return false;
+                                        });
+
+    env_ptr env = create_global_env();
+
+    (void)eval_text("(define seq-tree (bt.compile '(seq (act test-seq-setup) (act running-then-success))))", env);
+    (void)eval_text("(define seq-inst (bt.new-instance seq-tree))", env);
+    check(symbol_name(eval_text("(bt.tick seq-inst)", env)) == "running", "seq tick1 should be running");
+    check(symbol_name(eval_text("(bt.tick seq-inst)", env)) == "success", "seq tick2 should succeed");
+    check(seq_setup_calls == 2, "seq should remain memoryless and restart from child 0");
+
+    (void)eval_text("(define sel-tree (bt.compile '(sel (act test-sel-fail) (act running-then-success))))", env);
+    (void)eval_text("(define sel-inst (bt.new-instance sel-tree))", env);
+    check(symbol_name(eval_text("(bt.tick sel-inst)", env)) == "running", "sel tick1 should be running");
+    check(symbol_name(eval_text("(bt.tick sel-inst)", env)) == "success", "sel tick2 should succeed");
+    check(sel_fail_calls == 2, "sel should remain memoryless and retry first child");
+
+    (void)eval_text("(define rseq-tree (bt.compile '(reactive-seq (cond test-gate) (act async-sleep-ms 200))))", env);
+    (void)eval_text("(define rseq-inst (bt.new-instance rseq-tree))", env);
+    check(symbol_name(eval_text("(bt.tick rseq-inst '((gate #t)))", env)) == "running", "reactive-seq tick1 should run");
+    check(symbol_name(eval_text("(bt.tick rseq-inst '((gate #f)))", env)) == "failure",
+          "reactive-seq tick2 should fail and preempt");
+
+    (void)eval_text("(define rsel-tree (bt.compile '(reactive-sel (cond test-high-priority) (act async-sleep-ms 200))))", env);
+    (void)eval_text("(define rsel-inst (bt.new-instance rsel-tree))", env);
+    check(symbol_name(eval_text("(bt.tick rsel-inst '((high #f)))", env)) == "running",
+          "reactive-sel tick1 should run low-priority child");
+    check(symbol_name(eval_text("(bt.tick rsel-inst '((high #t)))", env)) == "success",
+          "reactive-sel tick2 should switch to high-priority success");
+}
+
+void test_bt_seq_and_running_semantics() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
+
+    (void)eval_text("(define tree (bt.compile '(seq (cond always-true) (act running-then-success))))", env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
+
+    value first = eval_text("(bt.tick inst)", env);
+    check(is_symbol(first) && symbol_name(first) == "running", "first tick should be running");
+
+    value second = eval_text("(bt.tick inst)", env);
+    check(is_symbol(second) && symbol_name(second) == "success", "second tick should be success");
+}
+
+void test_bt_decorator_semantics() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
+
+    (void)eval_text("(define invert-tree (bt.compile '(invert (cond always-false))))", env);
+    (void)eval_text("(define invert-inst (bt.new-instance invert-tree))", env);
+    check(symbol_name(eval_text("(bt.tick invert-inst)", env)) == "success", "invert should flip failure to success");
 
-    value budget_out = eval_text(
-        "(begin "
-        "  (define req (map.make)) "
-        "  (map.set! req 'schema_version \"planner.request.v1\") "
-        "  (map.set! req 'planner \"mcts\") "
-        "  (map.set! req 'model_service \"toy-1d\") "
-        "  (map.set! req 'state 0.0) "
-        "  (map.set! req 'seed 99) "
-        "  (map.set! req 'budget_ms 1) "
-        "  (map.set! req 'work_max 100000) "
-        "  (define r (planner.plan req)) "
-        "  (list (map.get r 'status 'none) "
-        "        (map.get (map.get r 'stats nil) 'time_used_ms 0) "
-        "        (map.get (map.get r 'stats nil) 'work_done 0)))",
-        env);
+    (void)eval_text("(define invert-running-tree (bt.compile '(invert (running))))", env);
+    (void)eval_text("(define invert-running-inst (bt.new-instance invert-running-tree))", env);
+    check(symbol_name(eval_text("(bt.tick invert-running-inst)", env)) == "running",
+          "invert should leave running unchanged");
 
-    const std::vector<value> budget_fields = vector_from_list(budget_out);
-    check(budget_fields.size() == 3, "planner.plan budget output shape mismatch");
-    check(is_symbol(budget_fields[0]), "planner.plan budget status should be symbol");
-    check(is_integer(budget_fields[1]), "planner.plan budget time should be integer");
-    check(integer_value(budget_fields[1]) <= 40, "planner.plan should honor bounded-time budget");
-    check(is_integer(budget_fields[2]) && integer_value(budget_fields[2]) > 0,
-          "planner.plan budget run should still perform work");
+    (void)eval_text("(define rtree (bt.compile '(repeat 3 (act always-success))))", env);
+    (void)eval_text("(define rinst (bt.new-instance rtree))", env);
+    check(symbol_name(eval_text("(bt.tick rinst)", env)) == "running", "repeat tick1 should be running");
+    check(symbol_name(eval_text("(bt.tick rinst)", env)) == "running", "repeat tick2 should be running");
+    check(symbol_name(eval_text("(bt.tick rinst)", env)) == "success", "repeat tick3 should be success");
 
-    value mppi_det = eval_text(
-        "(begin "
-        "  (define req (map.make)) "
-        "  (map.set! req 'schema_version \"planner.request.v1\") "
-        "  (map.set! req 'planner \"mppi\") "
-        "  (map.set! req 'model_service \"toy-1d\") "
-        "  (map.set! req 'state 0.0) "
-        "  (map.set! req 'seed 123) "
-        "  (map.set! req 'budget_ms 16) "
-        "  (map.set! req 'work_max 128) "
-        "  (map.set! req 'horizon 12) "
-        "  (define cfg (map.make)) "
-        "  (map.set! cfg 'lambda 0.8) "
-        "  (map.set! cfg 'sigma (list 0.35)) "
-        "  (map.set! cfg 'n_samples 128) "
-        "  (map.set! req 'mppi cfg) "
-        "  (define r1 (planner.plan req)) "
-        "  (define r2 (planner.plan req)) "
-        "  (list (car (map.get (map.get r1 'action nil) 'u (list 0.0))) "
-        "        (car (map.get (map.get r2 'action nil) 'u (list 0.0))) "
-        "        (map.get r1 'status ':none)))",
-        env);
-    const std::vector<value> mppi_fields = vector_from_list(mppi_det);
-    check(mppi_fields.size() == 3, "planner.plan mppi deterministic shape mismatch");
-    check(is_float(mppi_fields[0]) && is_float(mppi_fields[1]), "planner.plan mppi actions should be float");
-    check_close(float_value(mppi_fields[0]), float_value(mppi_fields[1]), 1e-12,
-                "planner.plan mppi should be deterministic for fixed seed");
-    check(is_symbol(mppi_fields[2]) && (symbol_name(mppi_fields[2]) == ":ok" || symbol_name(mppi_fields[2]) == ":timeout"),
-          "planner.plan mppi status should be :ok or :timeout");
+    (void)eval_text("(define retry-tree (bt.compile '(retry 2 (act always-fail))))", env);
+    (void)eval_text("(define retry-inst (bt.new-instance retry-tree))", env);
+    check(symbol_name(eval_text("(bt.tick retry-inst)", env)) == "running", "retry tick1 should be running");
+    check(symbol_name(eval_text("(bt.tick retry-inst)", env)) == "running", "retry tick2 should be running");
+    check(symbol_name(eval_text("(bt.tick retry-inst)", env)) == "failure", "retry tick3 should be failure");
+}
 
-    value ilqr_ok = eval_text(
-        "(begin "
-        "  (define req (map.make)) "
-        "  (map.set! req 'schema_version \"planner.request.v1\") "
-        "  (map.set! req 'planner \"ilqr\") "
-        "  (map.set! req 'model_service \"toy-1d\") "
-        "  (map.set! req 'state -1.0) "
-        "  (map.set! req 'seed 9) "
-        "  (map.set! req 'budget_ms 20) "
-        "  (map.set! req 'work_max 20) "
-        "  (map.set! req 'horizon 12) "
-        "  (define cfg (map.make)) "
-        "  (map.set! cfg 'max_iters 20) "
-        "  (map.set! cfg 'derivatives \"analytic\") "
-        "  (map.set! req 'ilqr cfg) "
-        "  (define r (planner.plan req)) "
-        "  (list (map.get r 'status ':none) "
-        "        (car (map.get (map.get r 'action nil) 'u (list 0.0)))))",
-        env);
-    const std::vector<value> ilqr_ok_fields = vector_from_list(ilqr_ok);
-    check(ilqr_ok_fields.size() == 2, "planner.plan ilqr output shape mismatch");
-    check(is_symbol(ilqr_ok_fields[0]) && (symbol_name(ilqr_ok_fields[0]) == ":ok" || symbol_name(ilqr_ok_fields[0]) == ":timeout"),
-          "planner.plan ilqr status should be :ok or :timeout");
-    check(is_float(ilqr_ok_fields[1]) && float_value(ilqr_ok_fields[1]) > 0.0,
-          "planner.plan ilqr should move positive from x=-1.0");
+void test_bt_reset_clears_phase4_state() {
+    using namespace muslisp;
 
-    value ilqr_missing_deriv = eval_text(
-        "(begin "
-        "  (define req (map.make)) "
-        "  (map.set! req 'schema_version \"planner.request.v1\") "
-        "  (map.set! req 'planner \"ilqr\") "
-        "  (map.set! req 'model_service \"ptz-track\") "
-        "  (map.set! req 'state (list 0.0 0.0 0.0 0.0)) "
-        "  (map.set! req 'budget_ms 8) "
-        "  (map.set! req 'work_max 4) "
-        "  (map.set! req 'horizon 4) "
-        "  (define cfg (map.make)) "
-        "  (map.set! cfg 'derivatives \"analytic\") "
-        "  (map.set! req 'ilqr cfg) "
-        "  (planner.plan req))",
-        env);
-    check(is_map(ilqr_missing_deriv), "planner.plan ilqr missing-derivatives should return map");
-    check(symbol_name(eval_text("(map.get (planner.plan req) 'status ':none)", env)) == ":error",
-          "planner.plan ilqr analytic without derivatives should return :error");
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
 
-    value sanity = eval_text(
-        "(begin "
-        "  (define (step x u) (+ x (* 0.25 (clamp u -1.0 1.0)))) "
-        "  (define (run req x n) "
-        "    (if (= n 0) "
-        "        x "
-        "        (begin "
-        "          (map.set! req 'state x) "
-        "          (define r (planner.plan req)) "
-        "          (define u (car (map.get (map.get r 'action nil) 'u (list 0.0)))) "
-        "          (run req (step x u) (- n 1))))) "
-        "  (define mreq (map.make)) "
-        "  (map.set! mreq 'schema_version \"planner.request.v1\") "
-        "  (map.set! mreq 'planner \"mppi\") "
-        "  (map.set! mreq 'model_service \"toy-1d\") "
-        "  (map.set! mreq 'budget_ms 12) "
-        "  (map.set! mreq 'work_max 96) "
-        "  (map.set! mreq 'horizon 10) "
-        "  (define mcfg (map.make)) "
-        "  (map.set! mcfg 'lambda 1.0) "
-        "  (map.set! mcfg 'sigma (list 0.3)) "
-        "  (map.set! mcfg 'n_samples 96) "
-        "  (map.set! mreq 'mppi mcfg) "
-        "  (define ireq (map.make)) "
-        "  (map.set! ireq 'schema_version \"planner.request.v1\") "
-        "  (map.set! ireq 'planner \"ilqr\") "
-        "  (map.set! ireq 'model_service \"toy-1d\") "
-        "  (map.set! ireq 'budget_ms 20) "
-        "  (map.set! ireq 'work_max 16) "
-        "  (map.set! ireq 'horizon 10) "
-        "  (define icfg (map.make)) "
-        "  (map.set! icfg 'max_iters 16) "
-        "  (map.set! icfg 'derivatives \"analytic\") "
-        "  (map.set! ireq 'ilqr icfg) "
-        "  (list (run mreq -1.0 8) (run ireq -1.0 8)))",
-        env);
-    const std::vector<value> sanity_fields = vector_from_list(sanity);
-    check(sanity_fields.size() == 2, "planner sanity output shape mismatch");
-    check(is_float(sanity_fields[0]) && float_value(sanity_fields[0]) > -0.95, "mppi should improve 1D integrator");
-    check(is_float(sanity_fields[1]) && float_value(sanity_fields[1]) > -0.95, "ilqr should improve 1D integrator");
+    (void)eval_text("(define rtree (bt.compile '(repeat 2 (act always-success))))", env);
+    (void)eval_text("(define rinst (bt.new-instance rtree))", env);
+    check(symbol_name(eval_text("(bt.tick rinst)", env)) == "running", "repeat pre-reset tick should be running");
+    check(is_nil(eval_text("(bt.reset rinst)", env)), "bt.reset should return nil");
+    check(symbol_name(eval_text("(bt.tick rinst)", env)) == "running", "repeat should restart after reset");
+    check(symbol_name(eval_text("(bt.tick rinst)", env)) == "success", "repeat should complete after restart");
 
-    value uni = eval_text(
-        "(begin "
-        "  (define req (map.make)) "
-        "  (map.set! req 'schema_version \"planner.request.v1\") "
-        "  (map.set! req 'planner \"mppi\") "
-        "  (map.set! req 'model_service \"toy-unicycle\") "
-        "  (map.set! req 'state (list 0.0 0.0 0.0 1.0 0.0)) "
-        "  (map.set! req 'budget_ms 12) "
-        "  (map.set! req 'work_max 96) "
-        "  (map.set! req 'horizon 12) "
-        "  (define cfg (map.make)) "
-        "  (map.set! cfg 'lambda 1.0) "
-        "  (map.set! cfg 'sigma (list 0.25 0.35)) "
-        "  (map.set! cfg 'n_samples 96) "
-        "  (map.set! req 'mppi cfg) "
-        "  (define r (planner.plan req)) "
-        "  (list (map.get r 'status ':none) "
-        "        (car (map.get (map.get r 'action nil) 'u (list 0.0)))))",
-        env);
-    const std::vector<value> uni_fields = vector_from_list(uni);
-    check(uni_fields.size() == 2, "toy-unicycle planner output shape mismatch");
-    check(is_symbol(uni_fields[0]) && (symbol_name(uni_fields[0]) == ":ok" || symbol_name(uni_fields[0]) == ":timeout"),
-          "toy-unicycle mppi status should be :ok or :timeout");
-    check(is_float(uni_fields[1]) && float_value(uni_fields[1]) > 0.0, "toy-unicycle mppi should command forward velocity");
+    (void)eval_text("(define btree (bt.compile '(cond bb-has foo)))", env);
+    (void)eval_text("(define binst (bt.new-instance btree))", env);
+    check(symbol_name(eval_text("(bt.tick binst '((foo 1)))", env)) == "success",
+          "tick input should make bb-has succeed");
+    (void)eval_text("(bt.reset binst)", env);
+    check(symbol_name(eval_text("(bt.tick binst)", env)) == "failure", "reset should clear blackboard entries");
+}
+
+void test_bt_halt_visits_only_live_memory() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
+    bt::runtime_host& host = bt::default_runtime_host();
+
+    (void)eval_text("(define inst (bt.new-instance (bt.compile '(reactive-sel (cond bb-has stop) "
+                    "(seq (invert (fail)) (invert (fail)) (invert (fail)) (invert (fail)) "
+                    "(act async-sleep-ms 500))))))",
+                    env);
+    check(symbol_name(eval_text("(bt.tick inst)", env)) == "running", "guarded branch should be running");
+    bt::instance* inst = host.find_instance(bt_handle(eval_text("inst", env)));
+    const bt::definition& def = *inst->def;
+    const auto touched_count = [&]() {
+        return static_cast<std::uint32_t>(std::count(inst->memory_touched.begin(), inst->memory_touched.end(), 1u));
+    };
+    check(inst->live_memory_nodes[def.root] == touched_count(), "root should count every node with touched memory");
+
+    const bt::node& branch = def.nodes[def.nodes[def.root].children[1]];
+    const bt::node_id sleeper = branch.children.back();
+    const auto job = static_cast<bt::job_id>(inst->memory[sleeper].i0);
+    check(inst->live_memory_nodes[branch.id] == 1u, "only the running leaf of the branch should hold memory");
+
+    inst->trace.clear();
+    check(symbol_name(eval_text("(bt.tick inst '((stop #t)))", env)) == "success", "guard should pre-empt the branch");
+    std::vector<bt::node_id> halted;
+    for (const bt::trace_event& ev : inst->trace.snapshot()) {
+        if (ev.kind == bt::trace_event_kind::node_halt) {
+            halted.push_back(ev.node);
+        }
+    }
+    check(halted.size() == 2u && std::find(halted.begin(), halted.end(), sleeper) != halted.end(),
+          "pre-emption should halt the branch root and its running leaf only");
+    check(inst->live_memory_nodes[branch.id] == 0u && inst->memory_touched[sleeper] == 0u,
+          "halted branch should hold no live memory");
+    check(inst->live_memory_nodes[def.root] == touched_count(), "ancestors should stop counting halted nodes");
+    bt::job_status job_status = host.scheduler_ref().get_info(job).status;
+    for (int i = 0; i < 200 && job_status == bt::job_status::running; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        job_status = host.scheduler_ref().get_info(job).status;
+    }
+    check(job_status == bt::job_status::cancelled, "halted leaf's job should be cancelled");
+    check(inst->live_memory_nodes[def.root] == 0u && touched_count() == 0u,
+          "a finished tree should hold no live memory");
+
+    // Nodes that finish with their memory reset stop counting; the repeat keeps its count past finishing.
+    (void)eval_text("(define done (bt.new-instance (bt.compile '(seq (act async-sleep-ms 5) (repeat 2 (succeed))))))",
+                    env);
+    std::string done_status = "running";
+    for (int i = 0; i < 200 && done_status == "running"; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        done_status = symbol_name(eval_text("(bt.tick done)", env));
+    }
+    check(done_status == "success", "finished tree should succeed");
+    bt::instance* done = host.find_instance(bt_handle(eval_text("done", env)));
+    const bt::node& done_root = done->def->nodes[done->def->root];
+    check(done->live_memory_nodes[done_root.children[0]] == 0u && done->live_memory_nodes[done_root.children[1]] == 1u,
+          "a finished leaf should stop counting while the repeat keeps its count");
+    done->trace.clear();
+    bt::services svc;
+    svc.sched = &host.scheduler_ref();
+    bt::halt_subtree(*done, host.callbacks(), svc, done_root.id);
+    std::size_t halt_count = 0;
+    for (const bt::trace_event& ev : done->trace.snapshot()) {
+        halt_count += ev.kind == bt::trace_event_kind::node_halt ? 1u : 0u;
+    }
+    check(halt_count == 2u, "halting the finished tree should skip its finished leaf");
+}
+
+void test_bt_par_node_thresholds_and_concurrent_conditions() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
+    bt::runtime_host& host = bt::default_runtime_host();
+
+    std::mutex threads_mutex;
+    std::vector<std::thread::id> threads;
+    host.callbacks().register_native_condition(
+        "test-slow-flag",
+        [&](bt::tick_context& ctx, std::string_view key) {
+            {
+                std::lock_guard<std::mutex> lock(threads_mutex);
+                if (std::find(threads.begin(), threads.end(), std::this_thread::get_id()) == threads.end()) {
+                    threads.push_back(std::this_thread::get_id());
+                }
+            }
+            if (key == "boom") {
+                throw std::runtime_error("boom");
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            const bt::bb_entry* entry = ctx.bb_get(key);
+            return entry && std::holds_alternative<bool>(entry->value) && std::get<bool>(entry->value);
+        },
+        bt::condition_reads{.key_args = {0}, .keys = {}, .thread_safe = true});
+
+    (void)eval_text("(define all (bt.compile '(par 3 (cond test-slow-flag a) (cond test-slow-flag b) "
+                    "(cond test-slow-flag c))))",
+                    env);
+    check(print_value(eval_text("(bt.to-dsl all)", env)) ==
+              "(par 3 1 (cond test-slow-flag a) (cond test-slow-flag b) (cond test-slow-flag c))",
+          "par should print both thresholds");
+    (void)eval_text("(define inst (bt.new-instance all))", env);
+    check(symbol_name(eval_text("(bt.tick inst '((a #t) (b #t) (c #t)))", env)) == "success",
+          "par should succeed once every child succeeded");
+    check(threads.size() >= 2, "thread-safe conditions should run on more than one thread");
+    check(symbol_name(eval_text("(bt.tick inst '((b #f)))", env)) == "failure",
+          "default failure threshold should fail as soon as success is out of reach");
+
+    // A throwing condition counts as a failure, as it does when ticked serially.
+    (void)eval_text("(define quorum (bt.new-instance (bt.compile '(par 2 2 (cond test-slow-flag a) "
+                    "(cond test-slow-flag boom) (cond test-slow-flag c)))))",
+                    env);
+    check(symbol_name(eval_text("(bt.tick quorum '((a #t) (c #t)))", env)) == "success",
+          "two of three successes should meet the threshold");
+    check(symbol_name(eval_text("(bt.tick quorum '((c #f)))", env)) == "failure",
+          "a thrown condition and a false one should meet the failure threshold");
+
+    // Completing the par halts children that are still running. The short sleep is submitted first so
+    // it also finishes first on a one-worker scheduler.
+    (void)eval_text("(define racing (bt.new-instance (bt.compile '(par 1 (act async-sleep-ms 10) "
+                    "(act async-sleep-ms 500)))))",
+                    env);
+    check(symbol_name(eval_text("(bt.tick racing)", env)) == "running", "par should wait for a first success");
+    bt::instance* racing = host.find_instance(bt_handle(eval_text("racing", env)));
+    bt::node_id sleeper = 0;
+    for (const bt::node& n : racing->def->nodes) {
+        if (n.leaf_name == "async-sleep-ms" && n.args[0].int_v == 500) {
+            sleeper = n.id;
+        }
+    }
+    const auto job = static_cast<bt::job_id>(racing->memory[sleeper].i0);
+    check(racing->memory[sleeper].b0 && job > 0, "sleeping child should hold a scheduler job");
+    std::string result = "running";
+    for (int i = 0; i < 200 && result == "running"; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        result = symbol_name(eval_text("(bt.tick racing)", env));
+    }
+    check(result == "success", "shorter child's success should complete the par");
+    check(!racing->memory[sleeper].b0, "par should halt the still-running child");
+    bt::job_status job_status = host.scheduler_ref().get_info(job).status;
+    for (int i = 0; i < 200 && job_status == bt::job_status::running; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        job_status = host.scheduler_ref().get_info(job).status;
+    }
+    check(job_status == bt::job_status::cancelled, "halted child's job should be cancelled");
+
+    expect_lisp_error_message("(bt.compile '(par 0 (succeed)))",
+                              env,
+                              "bt.compile: par: success threshold must be between 1 and the child count",
+                              "par zero threshold");
+    expect_lisp_error_message("(bt.compile '(par 1 3 (succeed) (fail)))",
+                              env,
+                              "bt.compile: par: failure threshold must be between 1 and the child count",
+                              "par failure threshold above child count");
+    expect_lisp_error_message("(bt.compile '(par (succeed)))",
+                              env,
+                              "bt.compile: par: expected a success threshold and at least one child",
+                              "par without threshold");
+}
+
+void test_bt_swap_definition_keeps_matching_node_state() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
+    bt::runtime_host& host = bt::default_runtime_host();
+
+    const auto async_node = [](const bt::definition& def) {
+        for (const bt::node& n : def.nodes) {
+            if (n.leaf_name == "async-sleep-ms") {
+                return n.id;
+            }
+        }
+        return bt::node_id{0};
+    };
+
+    (void)eval_text("(define a (bt.compile '(mem-seq (seq (act always-success)) (act async-sleep-ms 40) "
+                    "(act bb-put-int done 1))))",
+                    env);
+    // Same path to the async leaf, but the extra node in front of it shifts its node id.
+    (void)eval_text("(define b (bt.compile '(mem-seq (seq (act always-success) (act always-success)) "
+                    "(act async-sleep-ms 40) (act bb-put-int done 2) (act always-success))))",
+                    env);
+    (void)eval_text("(define inst (bt.new-instance a))", env);
+    (void)eval_text("(bt.tick inst '((keep 7)))", env);
+
+    bt::instance* inst = host.find_instance(bt_handle(eval_text("inst", env)));
+    const bt::node_id old_async = async_node(*inst->def);
+    const std::int64_t job = inst->memory[old_async].i0;
+    check(inst->memory[old_async].b0 && job > 0, "async leaf should hold a scheduler job before the swap");
+
+    check(integer_value(eval_text("(bt.swap-definition inst b)", env)) == 1,
+          "swap should halt only the changed leaf");
+    const bt::node_id new_async = async_node(*inst->def);
+    check(new_async != old_async, "test tree should move the async leaf to a new node id");
+    check(inst->memory[new_async].b0 && inst->memory[new_async].i0 == job,
+          "swap should carry the running job over to the matching node");
+
+    std::string result = "running";
+    for (int i = 0; i < 200 && result == "running"; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        result = symbol_name(eval_text("(bt.tick inst)", env));
+    }
+    check(result == "success", "swapped instance should finish the carried job and the new tail");
+    check(integer_value(eval_text("(bt.blackboard.get inst 'done -1)", env)) == 2,
+          "swapped instance should run the new definition's leaves");
+    check(integer_value(eval_text("(bt.blackboard.get inst 'keep -1)", env)) == 7,
+          "swap should keep the blackboard");
+    check(host.scheduler_ref().get_info(static_cast<bt::job_id>(job)).status == bt::job_status::done,
+          "carried job should complete rather than be resubmitted");
+
+    // Changing the running leaf itself halts it and cancels its job.
+    (void)eval_text("(define c (bt.compile '(mem-seq (seq (act always-success)) (act async-sleep-ms 41) "
+                    "(act bb-put-int done 1))))",
+                    env);
+    (void)eval_text("(define inst2 (bt.new-instance a))", env);
+    (void)eval_text("(bt.tick inst2)", env);
+    bt::instance* inst2 = host.find_instance(bt_handle(eval_text("inst2", env)));
+    const std::int64_t job2 = inst2->memory[async_node(*inst2->def)].i0;
+    check(integer_value(eval_text("(bt.swap-definition inst2 c)", env)) == 1, "swap should halt the changed leaf");
+    // Cancellation is cooperative: a running sleep notices it within a millisecond.
+    bt::job_status job2_status = bt::job_status::running;
+    for (int i = 0; i < 200 && (job2_status == bt::job_status::queued || job2_status == bt::job_status::running); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        job2_status = host.scheduler_ref().get_info(static_cast<bt::job_id>(job2)).status;
+    }
+    check(job2_status == bt::job_status::cancelled, "halting a changed leaf should cancel its job");
+    check(symbol_name(eval_text("(bt.tick inst2)", env)) == "running", "changed leaf should start a new job");
+
+    expect_lisp_error_message(
+        "(bt.swap-definition a b)", env, "bt.swap-definition: expected bt_instance", "swap on a definition");
 }
 
-void test_plan_action_node_blackboard_meta_and_logs() {
+void test_bt_instance_checkpoint_restore_and_fork() {
     using namespace muslisp;
 
     reset_bt_runtime_host();
     env_ptr env = create_global_env();
+    bt::runtime_host& host = bt::default_runtime_host();
 
-    check(is_nil(eval_text("(planner.set-base-seed 4242)", env)), "planner.set-base-seed should return nil");
-    check(is_integer(eval_text("(planner.get-base-seed)", env)) &&
-              integer_value(eval_text("(planner.get-base-seed)", env)) == 4242,
-          "planner.get-base-seed should return configured value");
+    (void)eval_text("(define tree (bt.compile '(mem-seq (act bb-put-int a 1) (act running-then-success 2) "
+                    "(act bb-put-int b 2))))",
+                    env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    check(symbol_name(eval_text("(bt.tick inst '((speed 0.5) (label \"north\")))", env)) == "running",
+          "first tick should stop in the running leaf");
+
+    const auto path = temp_file_path("instance_checkpoint", ".mbts");
+    (void)eval_text("(bt.checkpoint inst \"" + path.string() + "\")", env);
+
+    // A fresh instance needs three ticks; the restored one resumes inside the mem-seq and needs two.
+    (void)eval_text("(define restored (bt.new-instance tree))", env);
+    check(boolean_value(eval_text("(bt.restore restored \"" + path.string() + "\")", env)),
+          "restore should return #t");
+    const bt::instance* original = host.find_instance(bt_handle(eval_text("inst", env)));
+    const bt::instance* copy = host.find_instance(bt_handle(eval_text("restored", env)));
+    check(copy->tick_index == original->tick_index, "restore should carry the tick index");
+    check(float_value(eval_text("(bt.blackboard.get restored 'speed 0.0)", env)) == 0.5,
+          "restore should carry float entries");
+    check(string_value(eval_text("(bt.blackboard.get restored 'label \"\")", env)) == "north",
+          "restore should carry string entries");
+    check(integer_value(eval_text("(bt.blackboard.get restored 'a -1)", env)) == 1,
+          "restore should carry entries written by leaves");
+    for (const char* name : {"inst", "restored"}) {
+        const std::string inst_name(name);
+        check(symbol_name(eval_text("(bt.tick " + inst_name + ")", env)) == "running",
+              inst_name + " should still be running on its second tick");
+        check(symbol_name(eval_text("(bt.tick " + inst_name + ")", env)) == "success",
+              inst_name + " should finish on its third tick");
+        check(integer_value(eval_text("(bt.blackboard.get " + inst_name + " 'b -1)", env)) == 2,
+              inst_name + " should run the tail of the mem-seq");
+    }
 
-    (void)eval_text(
-        "(define tree "
-        "  (bt.compile "
-        "    '(seq "
-        "       (plan-action :name \"toy-plan\" :planner :mcts :budget_ms 20 :work_max 300 "
-        "                    :model_service \"toy-1d\" :state_key state :action_key action :meta_key plan-meta) "
-        "       (act apply-planned-1d state action state))))",
-        env);
-    check(string_value(eval_text("(write-to-string (bt.to-dsl tree))", env)).find("(plan-action") != std::string::npos,
-          "bt.to-dsl should include plan-action node");
-    (void)eval_text("(define inst-a (bt.new-instance tree))", env);
-    (void)eval_text("(define inst-b (bt.new-instance tree))", env);
+    (void)eval_text("(define other (bt.new-instance (bt.compile '(seq (act always-success)))))", env);
+    expect_lisp_error_message("(bt.restore other \"" + path.string() + "\")",
+                              env,
+                              "bt.restore: checkpoint was taken from a different tree",
+                              "restore into another tree");
+    std::filesystem::remove(path);
+
+    // A fork continues from the same state and writes to its own copy of the blackboard.
+    (void)eval_text("(define live (bt.new-instance tree))", env);
+    (void)eval_text("(bt.tick live '((speed 1.5)))", env);
+    (void)eval_text("(define branch (bt.fork live))", env);
+    check(symbol_name(eval_text("(bt.tick branch '((speed 9.0)))", env)) == "running", "fork should resume mid-tree");
+    check(symbol_name(eval_text("(bt.tick branch)", env)) == "success", "fork should keep the leaf counter");
+    check(float_value(eval_text("(bt.blackboard.get live 'speed 0.0)", env)) == 1.5,
+          "writes in a fork should not reach the original");
+    check(integer_value(eval_text("(bt.blackboard.get live 'b -1)", env)) == -1,
+          "leaves ticked in a fork should not write the original");
+    check(symbol_name(eval_text("(bt.tick live)", env)) == "running", "original should tick independently");
+
+    expect_lisp_error_message("(bt.fork tree)", env, "bt.fork: expected bt_instance", "fork of a definition");
+
+    bt::blackboard bb;
+    const auto now = std::chrono::steady_clock::now();
+    for (std::int64_t i = 0; i < 40; ++i) {
+        bb.put(std::string("k").append(std::to_string(i)), bt::bb_value{i}, 1, now, 0, "test");
+    }
+    bt::blackboard forked = bb.fork();
+    check(forked.write_count() == bb.write_count(), "fork should keep the write counter");
+    forked.put("k3", bt::bb_value{std::int64_t{-3}}, 2, now, 0, "test");
+    forked.put("extra", bt::bb_value{true}, 2, now, 0, "test");
+    check(std::get<std::int64_t>(bb.get("k3")->value) == 3, "fork writes should copy the shared page");
+    check(std::get<std::int64_t>(forked.get("k3")->value) == -3, "fork should see its own write");
+    check(!bb.has("extra") && forked.has("extra"), "keys interned in a fork should stay in the fork");
+    check(std::get<std::int64_t>(forked.get("k39")->value) == 39, "untouched pages should stay shared");
+}
 
-    check(symbol_name(eval_text("(bt.tick inst-a '((state 0.0)))", env)) == "success",
-          "plan-action tree tick should succeed");
-    check(symbol_name(eval_text("(bt.tick inst-b '((state 0.0)))", env)) == "success",
-          "plan-action tree tick on second instance should succeed");
+void test_bt_instance_pool_recycles_released_instances() {
+    using namespace muslisp;
 
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
     bt::runtime_host& host = bt::default_runtime_host();
-    const std::int64_t inst_a_handle = bt_handle(eval_text("inst-a", env));
-    const std::int64_t inst_b_handle = bt_handle(eval_text("inst-b", env));
-    bt::instance* inst_a = host.find_instance(inst_a_handle);
-    bt::instance* inst_b = host.find_instance(inst_b_handle);
-    check(inst_a && inst_b, "plan-action test instances should exist");
 
-    const bt::bb_entry* action_a = inst_a->bb.get("action");
-    const bt::bb_entry* action_b = inst_b->bb.get("action");
-    check(action_a && action_b, "plan-action should write action key");
+    (void)eval_text("(define tree (bt.compile '(mem-seq (act bb-put-int a 1) (act running-then-success 2) "
+                    "(act bb-put-int b 2))))",
+                    env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    (void)eval_text("(bt.tick inst '((speed 0.5)))", env);
+    (void)eval_text("(bt.tick inst)", env);
+    const std::int64_t def_handle = bt_handle(eval_text("tree", env));
+    const bt::instance* used = host.find_instance(bt_handle(eval_text("inst", env)));
+    check(used->tick_index == 2 && used->trace.size() > 0, "instance should have ticked and traced");
 
-    double action_a_value = 0.0;
-    double action_b_value = 0.0;
-    if (const double* f = std::get_if<double>(&action_a->value)) {
-        action_a_value = *f;
-    } else if (const std::vector<double>* vec = std::get_if<std::vector<double>>(&action_a->value)) {
-        check(!vec->empty(), "plan-action vector action should not be empty");
-        action_a_value = (*vec)[0];
-    } else {
-        throw std::runtime_error("plan-action action value should be numeric");
+    (void)eval_text("(bt.release-instance inst)", env);
+    check(host.idle_instance_count(def_handle) == 1, "released instance should wait in the pool");
+    expect_lisp_error_message(
+        "(bt.tick inst)", env, "bt.tick: tick_instance: unknown instance handle", "tick after release");
+    expect_lisp_error_message(
+        "(bt.release-instance inst)", env, "bt.release-instance: release_instance: unknown instance handle", "double release");
+
+    (void)eval_text("(define again (bt.new-instance tree))", env);
+    const bt::instance* reused = host.find_instance(bt_handle(eval_text("again", env)));
+    check(reused == used, "new instance should reuse the released one");
+    check(host.idle_instance_count(def_handle) == 0, "pool should hand its idle instance out");
+    check(reused->tick_index == 0 && reused->tree_stats.tick_count == 0 && reused->trace.size() == 0,
+          "recycled instance should start with no ticks or trace");
+    check(reused->tree_stats.configured_tick_budget == std::chrono::milliseconds(20),
+          "recycled instance should get the default tick budget");
+    for (std::size_t id = 0; id < reused->memory.size(); ++id) {
+        const bt::node_memory& mem = reused->memory[id];
+        check(mem.i0 == 0 && mem.i1 == 0 && !mem.b0 && reused->memory_touched[id] == 0u &&
+                  reused->live_memory_nodes[id] == 0u,
+              "recycled instance should hold no node memory");
+        check(reused->node_stats[id].success_returns == 0 && reused->node_stats[id].running_returns == 0,
+              "recycled instance should hold no node stats");
     }
-    if (const double* f = std::get_if<double>(&action_b->value)) {
-        action_b_value = *f;
-    } else if (const std::vector<double>* vec = std::get_if<std::vector<double>>(&action_b->value)) {
-        check(!vec->empty(), "plan-action vector action should not be empty");
-        action_b_value = (*vec)[0];
-    } else {
-        throw std::runtime_error("plan-action action value should be numeric");
+    check(integer_value(eval_text("(bt.blackboard.get again 'a -1)", env)) == -1 &&
+              float_value(eval_text("(bt.blackboard.get again 'speed -1.0)", env)) == -1.0,
+          "recycled instance should start with an empty blackboard");
+    check(symbol_name(eval_text("(bt.tick again)", env)) == "running", "recycled instance should tick from the start");
+    check(symbol_name(eval_text("(bt.tick again)", env)) == "running", "recycled leaf counter should start at zero");
+    check(symbol_name(eval_text("(bt.tick again)", env)) == "success", "recycled instance should finish on tick three");
+
+    // Releasing halts running leaves, so their scheduler jobs are cancelled.
+    (void)eval_text("(define sleeper (bt.new-instance (bt.compile '(act async-sleep-ms 200))))", env);
+    (void)eval_text("(bt.tick sleeper)", env);
+    const bt::instance* sleeping = host.find_instance(bt_handle(eval_text("sleeper", env)));
+    const std::int64_t job = sleeping->memory[sleeping->def->root].i0;
+    check(job > 0, "sleeping leaf should hold a scheduler job");
+    (void)eval_text("(bt.release-instance sleeper)", env);
+    bt::job_status job_status = bt::job_status::running;
+    for (int i = 0; i < 200 && (job_status == bt::job_status::queued || job_status == bt::job_status::running); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        job_status = host.scheduler_ref().get_info(static_cast<bt::job_id>(job)).status;
     }
-    check_close(action_a_value, action_b_value, 1e-12,
-                "plan-action should be deterministic for same base seed/node/tick/state");
+    check(job_status == bt::job_status::cancelled, "release should cancel the running job");
+
+    // Trace rings follow the configured capacity and are allocated by the first traced event.
+    (void)eval_text("(bt.set-trace-capacity 16)", env);
+    check(host.idle_instance_count(def_handle) == 0, "changing the trace capacity should free idle instances");
+    (void)eval_text("(define small (bt.new-instance tree))", env);
+    const bt::instance* small = host.find_instance(bt_handle(eval_text("small", env)));
+    check(small->trace.capacity() == 16 && !small->trace.allocated(), "trace ring should not be allocated up front");
+    (void)eval_text("(bt.tick small)", env);
+    check(small->trace.allocated() && small->trace.size() <= 16, "first tick should allocate the trace ring");
+
+    bt::instance_pool pool(host.find_definition(def_handle), nullptr, 0, 1);
+    std::unique_ptr<bt::instance> first = pool.acquire();
+    std::unique_ptr<bt::instance> second = pool.acquire();
+    bt::instance* first_ptr = first.get();
+    pool.release(std::move(first));
+    pool.release(std::move(second));
+    check(pool.idle_count() == 1, "pool should free instances beyond max_idle");
+    check(pool.acquire().get() == first_ptr, "pool should hand out the instance it kept");
+}
 
-    const bt::bb_entry* state_a = inst_a->bb.get("state");
-    check(state_a, "apply-planned-1d should update state");
-    check(std::holds_alternative<double>(state_a->value), "updated state should be float");
-    check(std::get<double>(state_a->value) > 0.0, "planned action should move state toward goal");
+void test_bt_instance_flat_node_slots() {
+    using namespace muslisp;
 
-    const bt::bb_entry* meta_a = inst_a->bb.get("plan-meta");
-    check(meta_a && std::holds_alternative<std::string>(meta_a->value), "plan-action should write meta key");
-    check(std::get<std::string>(meta_a->value).find("\"status\"") != std::string::npos,
-          "plan-action meta should include status");
+    reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
+    int halt_calls = 0;
+    host.callbacks().register_action(
+        "test-halt-counting",
+        [](bt::tick_context&, bt::node_id, bt::node_memory& mem, std::span<const value>) {
+            mem.b0 = true;
+            return bt::status::running;
+        },
+        [&halt_calls](bt::tick_context&, bt::node_id, bt::node_memory&) { ++halt_calls; });
+    env_ptr env = create_global_env();
 
-    value planner_events = eval_text("(events.dump 200)", env);
-    check(is_proper_list(planner_events), "events.dump should return list");
-    const auto planner_rows = vector_from_list(planner_events);
-    bool saw_planner_v1 = false;
-    bool saw_planner_schema = false;
-    bool saw_planner_node = false;
-    for (const value& row : planner_rows) {
-        if (!is_string(row)) {
-            continue;
+    (void)eval_text("(define tree (bt.compile '(sel (cond always-true) (act test-halt-counting))))", env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    bt::instance* inst = host.find_instance(bt_handle(eval_text("inst", env)));
+    check(inst != nullptr, "flat slots test should resolve instance");
+    check(inst->memory.size() == inst->def->nodes.size(), "instance memory slab should match node count");
+    check(inst->node_stats.size() == inst->def->nodes.size(), "instance stats slab should match node count");
+
+    check(symbol_name(eval_text("(bt.tick inst)", env)) == "success", "selector should succeed on first child");
+    const std::string stats = string_value(eval_text("(bt.stats inst)", env));
+    check(stats.find("(always-true)") != std::string::npos, "stats should include ticked condition");
+    check(stats.find("(test-halt-counting)") == std::string::npos, "stats should omit nodes that were never ticked");
+
+    bt::services svc;
+    svc.sched = &host.scheduler_ref();
+    bt::halt_subtree(*inst, host.callbacks(), svc, inst->def->root);
+    check(halt_calls == 0, "halt hook should not run for never-ticked action slots");
+
+    (void)eval_text("(bt.reset inst)", env);
+    check(inst->memory.size() == inst->def->nodes.size(), "reset should keep memory slab allocated");
+}
+
+void test_node_payload_inline_and_boxed_storage() {
+    using namespace muslisp;
+
+    struct waypoint_progress {
+        std::array<double, 6> target{};
+        std::int64_t steps = 0;
+    };
+    struct oversized_state {
+        std::array<double, 32> samples{};
+    };
+    static int live_counters = 0;
+    struct counted {
+        counted() noexcept { ++live_counters; }
+        counted(counted&&) noexcept { ++live_counters; }
+        ~counted() { --live_counters; }
+    };
+
+    bt::node_payload payload;
+    check(!payload.has_value() && payload.get<waypoint_progress>() == nullptr, "an empty payload should hold nothing");
+    payload.emplace<waypoint_progress>().steps = 3;
+    check(payload.is_inline() && payload.holds<waypoint_progress>(), "small state should live in the slot");
+    check(payload.get<oversized_state>() == nullptr, "get should reject a different type");
+    bt::node_payload moved = std::move(payload);
+    check(!payload.has_value() && moved.get<waypoint_progress>()->steps == 3, "moving should carry the inline value");
+
+    moved.emplace<oversized_state>().samples[31] = 2.5;
+    check(!moved.is_inline() && moved.get<oversized_state>()->samples[31] == 2.5, "oversized state should be boxed");
+    payload = std::move(moved);
+    check(payload.get<oversized_state>()->samples[31] == 2.5, "moving should carry the boxed value");
+
+    payload.emplace<counted>();
+    check(live_counters == 1, "emplace should replace the previous value");
+    {
+        std::vector<bt::node_memory> slots(2);
+        slots[0].payload = std::move(payload);
+        slots.resize(64);
+        check(live_counters == 1 && slots[0].payload.holds<counted>(), "growing node memory should relocate payloads");
+    }
+    check(live_counters == 0, "destroying node memory should destroy its payload");
+
+    reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
+    host.callbacks().register_action("payload-steps", [](bt::tick_context&, bt::node_id, bt::node_memory& mem, std::span<const value>) {
+        waypoint_progress* progress = mem.payload.get<waypoint_progress>();
+        if (!progress) {
+            progress = &mem.payload.emplace<waypoint_progress>();
         }
-        const std::string line = string_value(row);
-        if (line.find("\"type\":\"planner_v1\"") != std::string::npos) {
-            saw_planner_v1 = true;
+        return ++progress->steps < 3 ? bt::status::running : bt::status::success;
+    });
+    env_ptr env = create_global_env();
+    (void)eval_text("(define tree (bt.compile '(act payload-steps)))", env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    check(symbol_name(eval_text("(bt.tick inst)", env)) == "running", "payload leaf should start running");
+    check(symbol_name(eval_text("(bt.tick inst)", env)) == "running", "payload leaf should keep its progress");
+    check(symbol_name(eval_text("(bt.tick inst)", env)) == "success", "payload leaf should finish on its third tick");
+    (void)eval_text("(bt.reset inst)", env);
+    const bt::instance* inst = host.find_instance(bt_handle(eval_text("inst", env)));
+    check(!inst->memory[0].payload.has_value(), "reset should clear node payloads");
+}
+
+void test_bt_leaf_args_materialised_once() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
+    env_ptr env = create_global_env();
+
+    (void)eval_text("(define tree (bt.compile '(seq (act bb-put-int foo 42) (act bb-put-int bar 7) (cond bb-has foo))))", env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    const std::int64_t handle = bt_handle(eval_text("inst", env));
+
+    check(host.tick_instance(handle) == bt::status::success, "pre-materialised args tree should succeed");
+    default_gc().collect();
+    check(host.tick_instance(handle) == bt::status::success, "leaf args should survive a full collection");
+
+    const std::size_t allocated_before = default_gc().stats().total_allocated_objects;
+    for (int i = 0; i < 16; ++i) {
+        (void)host.tick_instance(handle);
+    }
+    check(default_gc().stats().total_allocated_objects == allocated_before,
+          "ticking a tree with static leaf args should not allocate Lisp objects");
+
+    const bt::instance* inst = host.find_instance(handle);
+    check(inst->leaf_args(0).size() == 2, "first leaf should expose two materialised args");
+    check(is_integer(inst->leaf_args(0)[1]) && integer_value(inst->leaf_args(0)[1]) == 42,
+          "materialised integer arg should keep its value");
+}
+
+void test_bt_blackboard_interned_slots() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
+    env_ptr env = create_global_env();
+
+    (void)eval_text("(define tree (bt.compile '(seq (act bb-put-int foo 42) (plan-action :state_key pose :action_key cmd))))",
+                    env);
+    const bt::definition* def = host.find_definition(bt_handle(eval_text("tree", env)));
+    check(def->bb_keys.size() == 3, "definition should intern leaf and planner keys");
+    check(def->bb_keys[0] == "foo" && def->bb_keys[1] == "cmd" && def->bb_keys[2] == "pose",
+          "definition keys should be interned in node order");
+    check(def->nodes[1].state_key == 2, "plan-action should reference its state key slot");
+
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    bt::instance* inst = host.find_instance(bt_handle(eval_text("inst", env)));
+    check(inst->bb_key_slot(0) == inst->bb.find_slot("foo"), "instance should pre-intern definition keys");
+    check(!inst->bb.has("foo") && inst->bb.snapshot().empty(), "interned keys should not be present before a write");
+
+    const auto now = std::chrono::steady_clock::now();
+    const bt::bb_slot foo = inst->bb_key_slot(0);
+    inst->bb.put(foo, bt::bb_value{std::int64_t{5}}, 1, now, 0, "test");
+    const bt::bb_entry* by_name = inst->bb.get("foo");
+    check(by_name && by_name == inst->bb.get(foo), "string and slot lookups should share storage");
+    check(std::get<std::int64_t>(by_name->value) == 5, "slot write should be visible by name");
+
+    inst->bb.put("late", bt::bb_value{true}, 1, now, 0, "test");
+    check(inst->bb.get(foo) == by_name, "new keys should not move existing entries");
+
+    inst->bb.clear();
+    check(!inst->bb.has(foo) && inst->bb.find_slot("foo") == foo, "clear should keep slots but drop values");
+}
+
+void test_bt_blackboard_vector_storage() {
+    using namespace muslisp;
+
+    const bt::bb_vector small{1.0, 2.0, 3.0};
+    check(small.is_inline() && small.size() == 3 && small[2] == 3.0, "short vectors should be stored inline");
+
+    std::vector<double> raw(32, 0.5);
+    const double* raw_data = raw.data();
+    const bt::bb_vector large(std::move(raw));
+    check(!large.is_inline() && large.size() == 32, "long vectors should use a shared buffer");
+    check(large.data() == raw_data, "moving a long vector in should adopt its buffer");
+
+    const bt::bb_value boxed{large};
+    const bt::bb_value copy = boxed;
+    check(std::get<bt::bb_vector>(copy).data() == large.data(), "copying a long vector value should share its buffer");
+    check(std::get<bt::bb_vector>(copy) == large, "shared vectors should compare equal");
+
+    reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
+    env_ptr env = create_global_env();
+    (void)eval_text("(define tree (bt.compile '(cond bb-has pose)))", env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    (void)eval_text("(bt.tick inst '((pose (1 2.5 3))))", env);
+    const bt::bb_entry* pose = host.find_instance(bt_handle(eval_text("inst", env)))->bb.get("pose");
+    const auto* pose_vec = pose ? std::get_if<bt::bb_vector>(&pose->value) : nullptr;
+    check(pose_vec && pose_vec->size() == 3 && (*pose_vec)[1] == 2.5, "tick inputs should store numeric lists as vectors");
+}
+
+void test_bt_blackboard_read_view() {
+    using namespace muslisp;
+
+    bt::blackboard bb;
+    const auto now = std::chrono::steady_clock::now();
+    bb.put("count", bt::bb_value{std::int64_t{1}}, 3, now, 0, "test");
+    bb.put("grid", bt::bb_value{bt::bb_vector(std::vector<double>(4096, 0.25))}, 3, now, 0, "test");
+    bb.put("other", bt::bb_value{true}, 3, now, 0, "test");
+
+    const std::array<std::string_view, 3> keys{"grid", "count", "never-written"};
+    const bt::bb_read_view view = bb.read_view(keys);
+    check(view.size() == 2 && view.write_count() == bb.write_count(), "view should cover interned keys only");
+    check(view.get("other") == nullptr, "view should leave out keys that were not asked for");
+    const bt::bb_entry* grid = view.get("grid");
+    check(grid && std::get<bt::bb_vector>(grid->value).data() ==
+                      std::get<bt::bb_vector>(bb.get("grid")->value).data(),
+          "view should share large vectors with the blackboard");
+    check(view.get(bb.find_slot("count"))->last_write_tick == 3, "view should keep the write tick");
+
+    // Writes after the view copy the page, so a reader on another thread keeps seeing the old values
+    // while the tick thread moves on.
+    std::atomic<bool> stop{false};
+    std::atomic<int> mismatches{0};
+    std::thread reader([&] {
+        while (!stop.load(std::memory_order_relaxed)) {
+            const bt::bb_entry* count = view.get("count");
+            if (!count || std::get<std::int64_t>(count->value) != 1 || count->last_write_tick != 3 ||
+                std::get<bt::bb_vector>(view.get("grid")->value).size() != 4096) {
+                mismatches.fetch_add(1, std::memory_order_relaxed);
+            }
         }
-        if (line.find("\"schema_version\":\"planner.v1\"") != std::string::npos) {
-            saw_planner_schema = true;
+    });
+    for (std::int64_t i = 2; i < 20000; ++i) {
+        bb.put("count", bt::bb_value{i}, static_cast<std::uint64_t>(i), now, 0, "test");
+        if (i % 1000 == 0) {
+            bb.put("grid", bt::bb_value{bt::bb_vector{1.0}}, static_cast<std::uint64_t>(i), now, 0, "test");
+            bb.put(std::string("k").append(std::to_string(i)), bt::bb_value{i}, static_cast<std::uint64_t>(i), now, 0,
+                   "test");
         }
-        if (line.find("\"node_name\":\"toy-plan\"") != std::string::npos) {
-            saw_planner_node = true;
+    }
+    stop.store(true, std::memory_order_relaxed);
+    reader.join();
+    check(mismatches.load() == 0, "view should not see writes made after it was taken");
+    check(std::get<std::int64_t>(bb.get("count")->value) == 19999, "blackboard should keep its own writes");
+    check(view.write_version(bb.find_slot("count")) < bb.write_version(bb.find_slot("count")),
+          "write versions should show the view is stale");
+
+    const bt::bb_slot count_slot = bb.find_slot("count");
+    const bt::bb_read_view by_slot = bb.read_view(std::span<const bt::bb_slot>(&count_slot, 1));
+    check(std::get<std::int64_t>(by_slot.get(count_slot)->value) == 19999 && by_slot.get("grid") == nullptr,
+          "slot views should read the current values of their slots");
+}
+
+void test_bt_blackboard_history_windows() {
+    using namespace muslisp;
+
+    // Incremental whole-ring aggregates against a scan, over enough pushes to wrap the ring a few times
+    // and with non-numeric writes mixed in.
+    bt::bb_history history(5);
+    const auto now = std::chrono::steady_clock::now();
+    std::vector<double> written;
+    for (std::int64_t i = 0; i < 23; ++i) {
+        const double x = static_cast<double>((i * 7) % 11) - 4.5;
+        if (i % 6 == 5) {
+            history.push(static_cast<std::uint64_t>(i * 2), now, bt::bb_value{std::string("skip")});
+            written.push_back(std::nan(""));
+        } else {
+            history.push(static_cast<std::uint64_t>(i * 2), now, bt::bb_value{x});
+            written.push_back(x);
+        }
+        bt::bb_window_stats scan;
+        const std::size_t first = written.size() > 5 ? written.size() - 5 : 0;
+        for (std::size_t j = first; j < written.size(); ++j) {
+            if (std::isnan(written[j])) {
+                continue;
+            }
+            scan.min = scan.count == 0 ? written[j] : std::min(scan.min, written[j]);
+            scan.max = scan.count == 0 ? written[j] : std::max(scan.max, written[j]);
+            scan.sum += written[j];
+            ++scan.count;
         }
+        const bt::bb_window_stats ring = history.window();
+        check(ring.count == scan.count && ring.min == scan.min && ring.max == scan.max &&
+                  std::abs(ring.sum - scan.sum) < 1e-9,
+              "incremental history aggregates should match a scan after push " + std::to_string(i));
     }
-    check(saw_planner_v1, "events should include planner_v1");
-    check(saw_planner_schema, "planner_v1 should include stable planner schema");
-    check(saw_planner_node, "planner_v1 should include node name");
+    check(history.size() == 5 && history.capacity() == 5, "history should hold at most its capacity");
+    check(std::get<double>(history.recent(0).value) == written.back() && history.recent(4).tick == 36,
+          "recent should count back from the newest sample");
+    const bt::bb_window_stats last_two = history.window(2);
+    check(last_two.count == 2 && last_two.sum == written[21] + written[22], "short windows should cover the newest k");
+    check(history.at_tick(41)->tick == 40 && history.at_tick(44)->tick == 44 && history.at_tick(35) == nullptr,
+          "at_tick should find the newest sample at or before the tick");
+
+    // Histories are opt-in per key, emptied by clear() and copied on write by forks.
+    bt::blackboard bb;
+    const bt::bb_slot speed = bb.intern("speed");
+    check(bb.history(speed) == nullptr, "keys should keep no history until asked");
+    bb.set_history(speed, 3);
+    bb.put(speed, bt::bb_value{1.0}, 1, now, 0, "test");
+    bb.put("other", bt::bb_value{std::int64_t{5}}, 1, now, 0, "test");
+    bt::blackboard forked = bb.fork();
+    bb.put(speed, bt::bb_value{2.0}, 2, now, 0, "test");
+    check(bb.history(speed)->size() == 2 && forked.history(speed)->size() == 1,
+          "a fork should not see history written after it");
+    forked.put(speed, bt::bb_value{9.0}, 2, now, 0, "test");
+    check(bb.history(speed)->window().max == 2.0 && forked.history(speed)->window().max == 9.0,
+          "forks should keep separate histories");
+    bb.clear();
+    check(bb.history(speed) && bb.history(speed)->size() == 0 && bb.history(speed)->capacity() == 3,
+          "clear should empty histories and keep tracking");
+    check(forked.history(speed)->size() == 2, "clearing one blackboard should leave its fork's history alone");
 
-    (void)eval_text(
-        "(define bad-tree "
-        "  (bt.compile "
-        "    '(plan-action :name \"bad\" :model_service \"toy-1d\" :state_key missing :action_key action)))",
-        env);
-    (void)eval_text("(define bad-inst (bt.new-instance bad-tree))", env);
-    check(symbol_name(eval_text("(bt.tick bad-inst)", env)) == "failure",
-          "plan-action should fail on missing state key");
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
+    (void)eval_text("(define inst (bt.new-instance (bt.compile '(succeed))))", env);
+    expect_lisp_error_message("(bt.blackboard.window-mean inst 'speed)",
+                              env,
+                              "bt.blackboard.window-mean: key has no history: speed",
+                              "history queries should need a tracked key");
+    (void)eval_text("(bt.blackboard.track-history inst 'speed 4)", env);
+    check(is_nil(eval_text("(bt.blackboard.window-mean inst 'speed)", env)), "empty history should have no mean");
+    for (const char* speed_text : {"1.0", "3", "2.0", "8.0", "4.0"}) {
+        (void)eval_text(std::string("(bt.tick inst '((speed ") + speed_text + ")))", env);
+    }
+    check(print_value(eval_text("(bt.blackboard.history inst 'speed)", env)) == "(4.0 8.0 2.0 3)",
+          "history should list the newest samples first");
+    check(print_value(eval_text("(bt.blackboard.history inst 'speed 2)", env)) == "(4.0 8.0)",
+          "history should take an optional count");
+    check(print_value(eval_text("(bt.blackboard.window-mean inst 'speed)", env)) == "4.25",
+          "window-mean should average the ring");
+    check(print_value(eval_text("(bt.blackboard.window-min inst 'speed 2)", env)) == "4.0",
+          "window-min should take an optional window");
+    check(print_value(eval_text("(bt.blackboard.window-max inst 'speed)", env)) == "8.0",
+          "window-max should cover the ring");
+    check(print_value(eval_text("(bt.blackboard.at-tick inst 'speed 3)", env)) == "2.0",
+          "at-tick should return the value written on that tick");
+    check(symbol_name(eval_text("(bt.blackboard.at-tick inst 'speed 1 'gone)", env)) == "gone",
+          "at-tick should return the default for evicted ticks");
 }
 
-void test_plan_action_node_with_all_planner_backends() {
+void test_bt_blackboard_events_and_stats_builtins() {
     using namespace muslisp;
 
     reset_bt_runtime_host();
     env_ptr env = create_global_env();
 
-    (void)eval_text(
-        "(define tree-mcts "
-        "  (bt.compile '(plan-action :name \"mcts-node\" :planner :mcts :budget_ms 24 :work_max 240 "
-        "                          :model_service \"toy-1d\" :state_key state :action_key action)))",
-        env);
-    (void)eval_text(
-        "(define tree-mppi "
-        "  (bt.compile '(plan-action :name \"mppi-node\" :planner :mppi :budget_ms 24 :work_max 96 "
-        "                          :horizon 10 :lambda 1.0 :sigma 0.3 :n_samples 96 "
-        "                          :model_service \"toy-1d\" :state_key state :action_key action)))",
-        env);
-    (void)eval_text(
-        "(define tree-ilqr "
-        "  (bt.compile '(plan-action :name \"ilqr-node\" :planner :ilqr :budget_ms 24 :work_max 12 "
-        "                          :horizon 10 :max_iters 12 :derivatives :analytic "
-        "                          :model_service \"toy-1d\" :state_key state :action_key action)))",
-        env);
-
-    (void)eval_text("(define inst-mcts (bt.new-instance tree-mcts))", env);
-    (void)eval_text("(define inst-mppi (bt.new-instance tree-mppi))", env);
-    (void)eval_text("(define inst-ilqr (bt.new-instance tree-ilqr))", env);
+    (void)eval_text("(define tree (bt.compile '(seq (act bb-put-int foo 42) (cond bb-has foo))))", env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    check(symbol_name(eval_text("(bt.tick inst)", env)) == "success", "bb tree should tick to success");
 
-    check(symbol_name(eval_text("(bt.tick inst-mcts '((state -1.0)))", env)) == "success",
-          "plan-action mcts backend should succeed");
-    check(symbol_name(eval_text("(bt.tick inst-mppi '((state -1.0)))", env)) == "success",
-          "plan-action mppi backend should succeed");
-    check(symbol_name(eval_text("(bt.tick inst-ilqr '((state -1.0)))", env)) == "success",
-          "plan-action ilqr backend should succeed");
+    value bb_dump = eval_text("(bt.blackboard.dump inst)", env);
+    check(is_string(bb_dump), "bt.blackboard.dump should return string");
+    check(string_value(bb_dump).find("foo=42") != std::string::npos, "blackboard dump missing foo=42");
+    check(string_value(bb_dump).find("type=int64") != std::string::npos, "blackboard dump missing type metadata");
+    check(string_value(bb_dump).find("ts_ns=") != std::string::npos, "blackboard dump missing timestamp metadata");
+    check(string_value(bb_dump).find("writer_name=bb-put-int") != std::string::npos,
+          "blackboard dump missing writer metadata");
 
-    bt::runtime_host& host = bt::default_runtime_host();
-    const std::int64_t h_mcts = bt_handle(eval_text("inst-mcts", env));
-    const std::int64_t h_mppi = bt_handle(eval_text("inst-mppi", env));
-    const std::int64_t h_ilqr = bt_handle(eval_text("inst-ilqr", env));
-    bt::instance* i_mcts = host.find_instance(h_mcts);
-    bt::instance* i_mppi = host.find_instance(h_mppi);
-    bt::instance* i_ilqr = host.find_instance(h_ilqr);
-    check(i_mcts && i_mppi && i_ilqr, "backend test instances should exist");
-    check(i_mcts->bb.get("action") != nullptr, "mcts backend should publish action");
-    check(i_mppi->bb.get("action") != nullptr, "mppi backend should publish action");
-    check(i_ilqr->bb.get("action") != nullptr, "ilqr backend should publish action");
+    value events_dump = eval_text("(events.dump 40)", env);
+    check(is_proper_list(events_dump), "events.dump should return list");
+    bool saw_tick_begin = false;
+    bool saw_node_status = false;
+    bool saw_bb_write = false;
+    bool saw_tick_end = false;
+    for (const value& row : vector_from_list(events_dump)) {
+        if (!is_string(row)) {
+            continue;
+        }
+        const std::string line = string_value(row);
+        if (line.find("\"type\":\"tick_begin\"") != std::string::npos) {
+            saw_tick_begin = true;
+        }
+        if (line.find("\"type\":\"node_status\"") != std::string::npos) {
+            saw_node_status = true;
+        }
+        if (line.find("\"type\":\"bb_write\"") != std::string::npos) {
+            saw_bb_write = true;
+        }
+        if (line.find("\"type\":\"tick_end\"") != std::string::npos) {
+            saw_tick_end = true;
+        }
+    }
+    check(saw_tick_begin, "events should include tick_begin");
+    check(saw_node_status, "events should include node_status");
+    check(saw_bb_write, "events should include bb_write");
+    check(saw_tick_end, "events should include tick_end");
+
+    value stats_dump = eval_text("(bt.stats inst)", env);
+    check(is_string(stats_dump), "bt.stats should return string");
+    check(string_value(stats_dump).find("tick_count=1") != std::string::npos, "stats should include tick_count=1");
+
+    (void)eval_text("(bt.set-tick-budget-ms inst 1)", env);
+    (void)eval_text("(bt.tick inst)", env);
+    events_dump = eval_text("(events.dump 80)", env);
+    check(is_proper_list(events_dump), "events.dump should return list after retick");
 }
 
-void test_hash64_builtin() {
+void test_bt_blackboard_get_builtin() {
     using namespace muslisp;
 
+    reset_bt_runtime_host();
     env_ptr env = create_global_env();
-    value h1 = eval_text("(hash64 \"planner-seed\")", env);
-    value h2 = eval_text("(hash64 \"planner-seed\")", env);
-    value h3 = eval_text("(hash64 \"planner-seed-2\")", env);
 
-    check(is_integer(h1) && is_integer(h2) && is_integer(h3), "hash64 should return integer");
-    check(integer_value(h1) == integer_value(h2), "hash64 should be deterministic");
-    check(integer_value(h1) != integer_value(h3), "hash64 should vary with input");
+    (void)eval_text("(define tree (bt.compile '(seq (act bb-put-int foo 42) (succeed))))", env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    check(symbol_name(eval_text("(bt.tick inst)", env)) == "success", "bb tree should tick to success");
+
+    value foo_value = eval_text("(bt.blackboard.get inst 'foo -1)", env);
+    check(is_integer(foo_value) && integer_value(foo_value) == 42, "bt.blackboard.get should read integer entry");
+
+    value missing_default = eval_text("(bt.blackboard.get inst 'missing 77)", env);
+    check(is_integer(missing_default) && integer_value(missing_default) == 77,
+          "bt.blackboard.get should return caller default for missing key");
+
+    value missing_nil = eval_text("(bt.blackboard.get inst 'missing)", env);
+    check(is_nil(missing_nil), "bt.blackboard.get without default should return nil");
 }
 
-void test_json_and_handle_builtins() {
+void test_bt_scheduler_backed_action() {
     using namespace muslisp;
 
     reset_bt_runtime_host();
     env_ptr env = create_global_env();
 
-    value img = eval_text("(image.make 320 240 3 \"rgb8\" 1234 \"cam0\")", env);
-    check(is_image_handle(img), "image.make should return image_handle");
-    value img_info = eval_text("(image.info (image.make 64 48 1 \"gray8\" 222 \"cam1\"))", env);
-    check(is_map(img_info), "image.info should return map");
-    check(integer_value(eval_text("(map.get (image.info (image.make 10 20 3 \"rgb8\" 555 \"cam2\")) 'w -1)", env)) == 10,
-          "image.info width mismatch");
+    (void)eval_text("(define tree (bt.compile '(act async-sleep-ms 10)))", env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
 
-    value blob = eval_text("(blob.make 1024 \"application/octet-stream\" 777 \"snapshot\")", env);
-    check(is_blob_handle(blob), "blob.make should return blob_handle");
-    check(integer_value(eval_text("(map.get (blob.info (blob.make 99 \"text/plain\" 111 \"note\")) 'size_bytes -1)", env)) == 99,
-          "blob.info size mismatch");
+    value st = eval_text("(bt.tick inst)", env);
+    check(is_symbol(st) && symbol_name(st) == "running", "first async tick should be running");
 
-    value json_out = eval_text(
-        "(begin "
-        "  (define m (map.make)) "
-        "  (map.set! m 'a 1) "
-        "  (map.set! m 'b (list 2 3)) "
-        "  (define s (json.encode m)) "
-        "  (define d (json.decode s)) "
-        "  (list s (map.get d \"a\" -1) (map.get d \"b\" nil)))",
-        env);
-    const std::vector<value> fields = vector_from_list(json_out);
-    check(fields.size() == 3, "json roundtrip shape mismatch");
-    check(is_string(fields[0]), "json.encode should return string");
-    check(integer_value(fields[1]) == 1, "json.decode object key/value mismatch");
-    check(print_value(fields[2]) == "(2 3)", "json.decode array mismatch");
+    bool done = false;
+    for (int i = 0; i < 40; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        st = eval_text("(bt.tick inst)", env);
+        if (is_symbol(st) && symbol_name(st) == "success") {
+            done = true;
+            break;
+        }
+    }
+    check(done, "async action should eventually succeed");
+
+    value events_dump = eval_text("(events.dump 60)", env);
+    bool saw_sched_submit = false;
+    bool saw_sched_finish = false;
+    for (const value& row : vector_from_list(events_dump)) {
+        if (!is_string(row)) {
+            continue;
+        }
+        const std::string line = string_value(row);
+        if (line.find("\"type\":\"sched_submit\"") != std::string::npos) {
+            saw_sched_submit = true;
+        }
+        if (line.find("\"type\":\"sched_finish\"") != std::string::npos) {
+            saw_sched_finish = true;
+        }
+    }
+    check(saw_sched_submit, "events should include sched_submit");
+    check(saw_sched_finish, "events should include sched_finish");
+
+    value sched_stats = eval_text("(bt.scheduler.stats)", env);
+    check(is_string(sched_stats), "bt.scheduler.stats should return string");
+    check(string_value(sched_stats).find("submitted=") != std::string::npos, "scheduler stats missing submitted");
 }
 
-void test_capability_registry_call_echo() {
+void test_async_leaves_wait_on_completion_notifications() {
     using namespace muslisp;
 
+    bt::completion_queue queue;
+    std::vector<std::thread> producers;
+    for (int p = 0; p < 4; ++p) {
+        producers.emplace_back([&queue, p] {
+            for (int i = 0; i < 250; ++i) {
+                queue.push(static_cast<bt::job_id>(i), static_cast<std::uint64_t>(p));
+            }
+        });
+    }
+    for (std::thread& t : producers) {
+        t.join();
+    }
+    std::vector<bt::completion_queue::notification> drained;
+    queue.drain(drained);
+    check(drained.size() == 1000 && queue.empty(), "drain should return every pushed notification");
+    std::array<bt::job_id, 4> last{};
+    bool ordered = true;
+    for (const auto& note : drained) {
+        ordered = ordered && (note.job == 0 || note.job == last[note.tag] + 1);
+        last[note.tag] = note.job;
+    }
+    check(ordered, "drain should keep each producer's notifications in push order");
+
+    auto notifications_for = [](bt::scheduler& sched) {
+        auto completions = std::make_shared<bt::completion_queue>();
+        bt::job_request req{.task_name = "notify", .fn = [] { return bt::job_result{}; }};
+        req.completions = completions;
+        req.completion_tag = 7;
+        const bt::job_id id = sched.submit(std::move(req));
+        std::vector<bt::completion_queue::notification> out;
+        for (int i = 0; i < 2000 && out.size() < 2; ++i) {
+            completions->drain(out);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return out.size() == 2 && out[0].job == id && out[1].job == id && out[0].tag == 7 &&
+               sched.get_info(id).status == bt::job_status::done;
+    };
+    {
+        bt::thread_pool_scheduler sched(1);
+        check(notifications_for(sched), "thread pool jobs should notify on start and finish");
+    }
+    {
+        bt::work_stealing_scheduler sched(1);
+        check(notifications_for(sched), "work-stealing jobs should notify on start and finish");
+    }
+
+    // Counts lookups so the test can tell whether the async leaf polled.
+    class counting_scheduler final : public bt::scheduler {
+    public:
+        explicit counting_scheduler(bt::scheduler& inner) : inner_(inner) {}
+        bt::job_id submit(bt::job_request req) override { return inner_.submit(std::move(req)); }
+        bt::job_info get_info(bt::job_id id) const override {
+            ++lookups;
+            return inner_.get_info(id);
+        }
+        bool try_get_result(bt::job_id id, bt::job_result& out) override { return inner_.try_get_result(id, out); }
+        bool cancel(bt::job_id id) override { return inner_.cancel(id); }
+        bt::scheduler_profile_stats stats_snapshot() const override { return inner_.stats_snapshot(); }
+        mutable int lookups = 0;
+
+    private:
+        bt::scheduler& inner_;
+    };
+
     reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
     env_ptr env = create_global_env();
+    (void)eval_text("(define tree (bt.compile '(act async-sleep-ms 40)))", env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    bt::instance* inst = host.find_instance(bt_handle(eval_text("inst", env)));
+    check(inst != nullptr, "completion test should resolve its instance");
+
+    counting_scheduler counter(host.scheduler_ref());
+    bt::services svc;
+    svc.sched = &counter;
+    int ticks = 0;
+    bt::status st = bt::status::running;
+    while (st == bt::status::running && ticks < 2000) {
+        st = bt::tick(*inst, host.callbacks(), svc);
+        ++ticks;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    check(st == bt::status::success, "the notified async leaf should still succeed");
+    check(ticks > 10, "the async leaf should stay running while its job sleeps");
+    check(counter.lookups <= 2, "the async leaf should only poll after its job started or finished");
+}
 
-    value caps = eval_text("(cap.list)", env);
-    check(is_proper_list(caps), "cap.list should return list");
-    bool saw_echo = false;
-    for (value cap_name : vector_from_list(caps)) {
-        if (is_string(cap_name) && string_value(cap_name) == "cap.echo.v1") {
-            saw_echo = true;
+void test_cancel_tokens_stop_running_jobs() {
+    auto cancel_spinning_job = [](bt::scheduler& sched) {
+        std::atomic<bool> started{false};
+        const bt::job_id id = sched.submit(bt::job_request{
+            .task_name = "spin", .fn = [&started](const bt::cancel_token& cancel) {
+                started.store(true);
+                const auto give_up = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+                while (!cancel.cancelled() && std::chrono::steady_clock::now() < give_up) {
+                    std::this_thread::yield();
+                }
+                return bt::job_result{};
+            }});
+        while (!started.load()) {
+            std::this_thread::yield();
+        }
+        const auto cancelled_at = std::chrono::steady_clock::now();
+        check(sched.cancel(id), "a running job should accept a cancel request");
+        while (sched.get_info(id).status == bt::job_status::running) {
+            std::this_thread::yield();
+        }
+        return sched.get_info(id).status == bt::job_status::cancelled &&
+               std::chrono::steady_clock::now() - cancelled_at < std::chrono::seconds(1);
+    };
+    {
+        bt::thread_pool_scheduler sched(1);
+        check(cancel_spinning_job(sched), "thread pool jobs should see cancellation through their token");
+    }
+    {
+        bt::work_stealing_scheduler sched(1);
+        check(cancel_spinning_job(sched), "work-stealing jobs should see cancellation through their token");
+    }
+
+    // A caller-owned flag is shared between cancel() and the caller's own cancellation.
+    {
+        bt::thread_pool_scheduler sched(1);
+        auto flag = std::make_shared<std::atomic<bool>>(false);
+        std::atomic<bool> saw_cancel{false};
+        bt::job_request req{.task_name = "shared", .fn = [&saw_cancel](const bt::cancel_token& cancel) {
+                                while (!cancel.cancelled()) {
+                                    std::this_thread::yield();
+                                }
+                                saw_cancel.store(true);
+                                return bt::job_result{};
+                            }};
+        req.cancel_flag = flag;
+        const bt::job_id id = sched.submit(std::move(req));
+        flag->store(true);
+        while (sched.get_info(id).status != bt::job_status::done) {
+            std::this_thread::yield();
         }
+        check(saw_cancel.load(), "the token should read a caller-supplied cancel flag");
     }
-    check(saw_echo, "cap.list should include cap.echo.v1");
 
-    value desc = eval_text("(cap.describe \"cap.echo.v1\")", env);
-    check(is_map(desc), "cap.describe cap.echo.v1 should return map");
-    check(string_value(eval_text("(map.get (cap.describe \"cap.echo.v1\") 'name \"\")", env)) == "cap.echo.v1",
-          "cap.describe echo name mismatch");
-    check(string_value(eval_text("(map.get (cap.describe \"cap.echo.v1\") 'safety_class \"\")", env)) == "safe",
-          "cap.describe echo safety_class mismatch");
+    // MCTS stops at its next time_check_interval once the token fires.
+    bt::planner_service planner;
+    bt::thread_pool_scheduler sched(1);
+    bt::planner_request request;
+    request.planner = bt::planner_backend::mcts;
+    request.model_service = "toy-1d";
+    request.state = {0.5};
+    request.budget_ms = 10000;
+    request.work_max = 1000000000;
+    const bt::job_id id = sched.submit(bt::job_request{
+        .task_name = "plan", .fn = [&planner, request](const bt::cancel_token& cancel) {
+            return bt::job_result{.payload = planner.plan(request, cancel)};
+        }});
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    const auto cancelled_at = std::chrono::steady_clock::now();
+    check(sched.cancel(id), "a running plan should accept a cancel request");
+    while (sched.get_info(id).status == bt::job_status::running) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    check(std::chrono::steady_clock::now() - cancelled_at < std::chrono::seconds(2),
+          "a cancelled plan should stop well before its budget");
+    const std::vector<bt::planner_record> records = planner.recent_records(1);
+    check(records.size() == 1 && records[0].note == "cancelled", "a cancelled plan should note the cancellation");
+}
 
-    value response = eval_text(
-        "(begin "
-        "  (define req (map.make)) "
-        "  (define payload (map.make)) "
-        "  (map.set! payload 'message \"hello\") "
-        "  (map.set! payload 'n 7) "
-        "  (map.set! req 'schema_version \"cap.echo.request.v1\") "
-        "  (map.set! req 'capability \"cap.echo.v1\") "
-        "  (map.set! req 'operation \"echo\") "
-        "  (map.set! req 'request_id \"echo-1\") "
-        "  (map.set! req 'payload payload) "
-        "  (define response (cap.call req)) "
-        "  response)",
-        env);
-    check(is_map(response), "cap.call should return map");
-    check(symbol_name(eval_text("(map.get response 'status ':none)", env)) == ":ok", "cap.call echo status mismatch");
-    check(string_value(eval_text("(map.get response 'request_id \"\")", env)) == "echo-1",
-          "cap.call should preserve request_id");
-    check(string_value(eval_text("(map.get (map.get response 'echo (map.make)) 'message \"\")", env)) == "hello",
-          "cap.call should echo payload");
-    check(integer_value(eval_text("(map.get (map.get response 'echo (map.make)) 'n -1)", env)) == 7,
-          "cap.call should preserve payload fields");
+struct coroutine_probe {
+    int frames_alive = 0;
+    int phase = 0;
+    bool job_cancelled_seen = false;
+};
 
-    value model_desc = eval_text("(cap.describe \"cap.model.world.rollout.v1\")", env);
-    check(is_map(model_desc), "cap.describe model rollout should return map");
-    check(string_value(eval_text("(map.get (cap.describe \"cap.model.world.rollout.v1\") 'name \"\")", env)) ==
-              "cap.model.world.rollout.v1",
-          "cap.describe model rollout name mismatch");
+coroutine_probe g_coroutine_probe;
 
-    bt::default_runtime_host().events().clear_ring();
-    (void)eval_text(
-        "(define model_response "
-        " (begin "
-        "  (define input (map.make)) "
-        "  (map.set! input 'state (map.make)) "
-        "  (map.set! input 'actions (list)) "
-        "  (define req (map.make)) "
-        "  (map.set! req 'capability \"cap.model.world.rollout.v1\") "
-        "  (map.set! req 'operation \"invoke\") "
-        "  (map.set! req 'request_id \"rollout-1\") "
-        "  (map.set! req 'deadline_ms 25) "
-        "  (map.set! req 'input input) "
-        "  (cap.call req)))",
-        env);
-    value model_response = eval_text("model_response", env);
-    check(is_map(model_response), "model-service cap.call should return map");
-    check(symbol_name(eval_text("(map.get model_response 'status ':none)", env)) == ":unavailable",
-          "unconfigured model-service cap.call should return :unavailable");
-    check(string_value(eval_text("(map.get model_response 'error_code \"\")", env)) == "model_service_unconfigured",
-          "unconfigured model-service cap.call error code mismatch");
-    check(!string_value(eval_text("(map.get model_response 'request_hash \"\")", env)).empty(),
-          "model-service cap.call should expose request_hash");
-    check(!string_value(eval_text("(map.get model_response 'response_hash \"\")", env)).empty(),
-          "model-service cap.call should expose response_hash");
-    check(!boolean_value(eval_text("(map.get model_response 'replay_cache_hit true)", env)),
-          "unconfigured model-service cap.call should not be a replay cache hit");
-    check(symbol_name(eval_text("(map.get model_response 'validation_status ':missing)", env)) == ":not_checked",
-          "unconfigured model-service cap.call should not run output validation");
-    check(!boolean_value(eval_text("(map.get model_response 'host_reached true)", env)),
-          "unconfigured model-service cap.call must not reach host");
-    const std::vector<std::string> cap_events = bt::default_runtime_host().events().snapshot();
-    bool saw_cap_start = false;
-    bool saw_cap_end = false;
-    for (const std::string& line : cap_events) {
-        saw_cap_start = saw_cap_start || line.find("\"type\":\"cap_call_start\"") != std::string::npos;
-        saw_cap_end = saw_cap_end || line.find("\"type\":\"cap_call_end\"") != std::string::npos;
+struct coroutine_frame_guard {
+    coroutine_frame_guard() { ++g_coroutine_probe.frames_alive; }
+    ~coroutine_frame_guard() { --g_coroutine_probe.frames_alive; }
+};
+
+bt::action_task coroutine_phases(bt::action_context co) {
+    coroutine_frame_guard guard;
+    g_coroutine_probe.phase = 1;
+    co_await bt::next_tick{};
+    g_coroutine_probe.phase = 2;
+    co_await bt::sleep_for{std::chrono::milliseconds(5)};
+    g_coroutine_probe.phase = 3;
+    co_await bt::wait_until{[](bt::tick_context& ctx) { return ctx.bb_get("go") != nullptr; }};
+    g_coroutine_probe.phase = 4;
+    const std::int64_t delay_ms = co.args().empty() ? 0 : muslisp::integer_value(co.args()[0]);
+    bt::job_request req{.task_name = "co-job", .fn = [delay_ms](const bt::cancel_token& cancel) {
+                            const auto give_up = std::chrono::steady_clock::now() + std::chrono::milliseconds(delay_ms);
+                            while (!cancel.cancelled() && std::chrono::steady_clock::now() < give_up) {
+                                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                            }
+                            return bt::job_result{.payload = std::int64_t{21}};
+                        }};
+    bt::job_outcome out = co_await bt::run_job{std::move(req)};
+    if (out.status != bt::job_status::done) {
+        co_return bt::status::failure;
     }
-    check(saw_cap_start, "model-service cap.call should emit cap_call_start");
-    check(saw_cap_end, "model-service cap.call should emit cap_call_end");
-    value check_result = eval_text("(model-service.check)", env);
-    check(is_map(check_result), "model-service.check should return map");
-    check(!boolean_value(eval_text("(map.get (model-service.check) 'compatible true)", env)),
-          "unconfigured model-service.check should be incompatible");
-    check(string_value(eval_text("(map.get (model-service.check) 'error_code \"\")", env)) ==
-              "model_service_unconfigured",
-          "unconfigured model-service.check should report model_service_unconfigured");
+    g_coroutine_probe.phase = 5;
+    co.tick().bb_put("answer", std::any_cast<std::int64_t>(out.result.payload) * 2, "co-phases");
+    co_return bt::status::success;
+}
 
-    value rejected = eval_text(
-        "(begin "
-        "  (define req (map.make)) "
-        "  (map.set! req 'schema_version \"cap.echo.request.v1\") "
-        "  (map.set! req 'capability \"cap.echo.v1\") "
-        "  (map.set! req 'operation \"nope\") "
-        "  (define rejected (cap.call req)) "
-        "  rejected)",
-        env);
-    check(is_map(rejected), "cap.call rejected operation should return map");
-    check(symbol_name(eval_text("(map.get rejected 'status ':none)", env)) == ":rejected",
-          "cap.call unsupported operation should return :rejected");
+bt::action_task coroutine_throws(bt::action_context) {
+    coroutine_frame_guard guard;
+    co_await bt::next_tick{};
+    throw std::runtime_error("coroutine boom");
+}
 
-    expect_lisp_error_message(
-        "(begin "
-        "  (define req (map.make)) "
-        "  (map.set! req 'schema_version \"cap.echo.request.v1\") "
-        "  (map.set! req 'capability \"cap.unknown.v1\") "
-        "  (map.set! req 'operation \"echo\") "
-        "  (cap.call req))",
-        env,
-        "cap.call: unknown capability",
-        "cap.call unknown capability");
+void test_coroutine_actions_suspend_in_node_memory() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
+    host.callbacks().register_coroutine_action("co-phases", coroutine_phases);
+    host.callbacks().register_coroutine_action("co-throws", coroutine_throws);
+    env_ptr env = create_global_env();
+    (void)eval_text("(define tree (bt.compile '(act co-phases 30)))", env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    bt::instance* inst = host.find_instance(bt_handle(eval_text("inst", env)));
+    check(inst != nullptr, "coroutine test should resolve its instance");
+
+    bt::services svc;
+    svc.sched = &host.scheduler_ref();
+    g_coroutine_probe = {};
+    check(bt::tick(*inst, host.callbacks(), svc) == bt::status::running, "the first tick should suspend at next_tick");
+    check(g_coroutine_probe.phase == 1 && g_coroutine_probe.frames_alive == 1, "the frame should live in node memory");
+    (void)bt::tick(*inst, host.callbacks(), svc);
+    check(g_coroutine_probe.phase == 2, "next_tick should resume on the following tick");
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    (void)bt::tick(*inst, host.callbacks(), svc);
+    check(g_coroutine_probe.phase == 3, "sleep_for should resume once the tick clock has passed its deadline");
+    (void)bt::tick(*inst, host.callbacks(), svc);
+    check(g_coroutine_probe.phase == 3, "wait_until should hold while its condition is false");
+    inst->bb.put("go", true, 0, std::chrono::steady_clock::now(), 0, "test");
+    bt::status st = bt::tick(*inst, host.callbacks(), svc);
+    check(st == bt::status::running && g_coroutine_probe.phase == 4, "wait_until should resume and submit the job");
+    for (int i = 0; i < 2000 && st == bt::status::running; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        st = bt::tick(*inst, host.callbacks(), svc);
+    }
+    check(st == bt::status::success && g_coroutine_probe.phase == 5, "run_job should resume with the job's result");
+    const bt::bb_entry* answer = inst->bb.get("answer");
+    check(answer && std::get<std::int64_t>(answer->value) == 42, "the coroutine should see the job payload");
+    check(g_coroutine_probe.frames_alive == 0, "a finished coroutine should destroy its frame");
+
+    // Halting while the job runs destroys the frame and cancels the job.
+    (void)eval_text("(define tree-slow (bt.compile '(act co-phases 10000)))", env);
+    (void)eval_text("(define inst-slow (bt.new-instance tree-slow))", env);
+    bt::instance* slow = host.find_instance(bt_handle(eval_text("inst-slow", env)));
+    slow->bb.put("go", true, 0, std::chrono::steady_clock::now(), 0, "test");
+    g_coroutine_probe = {};
+    (void)bt::tick(*slow, host.callbacks(), svc);
+    (void)bt::tick(*slow, host.callbacks(), svc);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    (void)bt::tick(*slow, host.callbacks(), svc);
+    check(g_coroutine_probe.phase == 4 && slow->memory[0].b0, "the slow coroutine should be waiting on its job");
+    const bt::job_id job = static_cast<bt::job_id>(slow->memory[0].i0);
+    bt::halt_subtree(*slow, host.callbacks(), svc, 0, "test");
+    check(g_coroutine_probe.frames_alive == 0, "halting should destroy the coroutine frame");
+    bt::job_status job_st = svc.sched->get_info(job).status;
+    for (int i = 0; i < 2000 && job_st == bt::job_status::running; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        job_st = svc.sched->get_info(job).status;
+    }
+    check(job_st == bt::job_status::cancelled, "halting should cancel the job the coroutine awaits");
+    g_coroutine_probe = {};
+    check(bt::tick(*slow, host.callbacks(), svc) == bt::status::running && g_coroutine_probe.phase == 1,
+          "a halted coroutine action should restart from the top");
+    bt::reset(*slow);
+    check(g_coroutine_probe.frames_alive == 0, "resetting the instance should destroy the coroutine frame");
+
+    // An exception from the body fails the node and frees the frame.
+    (void)eval_text("(define tree-throw (bt.compile '(act co-throws)))", env);
+    (void)eval_text("(define inst-throw (bt.new-instance tree-throw))", env);
+    bt::instance* throwing = host.find_instance(bt_handle(eval_text("inst-throw", env)));
+    g_coroutine_probe = {};
+    check(bt::tick(*throwing, host.callbacks(), svc) == bt::status::running, "the throwing coroutine should suspend first");
+    check(bt::tick(*throwing, host.callbacks(), svc) == bt::status::failure, "a throwing coroutine should fail its node");
+    check(g_coroutine_probe.frames_alive == 0, "a throwing coroutine should destroy its frame");
 }
 
-void test_model_service_protocol_skeleton() {
-    bt::model_service_request request;
-    request.id = "req-1";
-    request.op = bt::model_service_operation::invoke;
-    request.capability = "cap.model.world.rollout.v1";
-    request.deadline_ms = 100;
 
-    bt::unavailable_model_service_client client;
-    bt::model_service_response response = client.call(request);
+void test_latency_histograms_report_tail_percentiles() {
+    using namespace muslisp;
 
-    check(std::string(bt::model_service_operation_name(request.op)) == "invoke",
-          "model service operation name mismatch");
-    const std::string envelope = bt::model_service_request_to_json(request);
-    check(envelope.find("\"version\":\"0.2\"") != std::string::npos, "model service envelope version missing");
-    check(envelope.find("\"op\":\"invoke\"") != std::string::npos, "model service envelope operation missing");
-    check(envelope.find("\"capability\":\"cap.model.world.rollout.v1\"") != std::string::npos,
-          "model service envelope capability missing");
+    using ns = std::chrono::nanoseconds;
+    bool bounds_ok = true;
+    for (std::int64_t v : {0, 1, 7, 8, 15, 16, 17, 1000, 123456, 999999999}) {
+        const std::size_t bucket = bt::latency_histogram::bucket_index(ns(v));
+        const std::int64_t upper = bt::latency_histogram::bucket_upper_bound(bucket).count();
+        const std::int64_t lower = bucket == 0 ? 0 : bt::latency_histogram::bucket_upper_bound(bucket - 1).count() + 1;
+        bounds_ok = bounds_ok && lower <= v && v <= upper && (upper - lower) * 8 <= std::max<std::int64_t>(v, 8);
+    }
+    check(bounds_ok, "each sample should land in a bucket at most 1/8 of its value wide");
+    check(bt::latency_histogram::bucket_index(ns(std::int64_t{1} << 50)) == bt::latency_histogram::k_bucket_count - 1,
+          "huge samples should clamp to the last bucket");
 
-    const bt::model_service_response parsed = bt::model_service_response_from_json(
-        "{\"version\":\"0.2\",\"id\":\"req-1\",\"status\":\"action_chunk\","
-        "\"output\":{\"actions\":[{\"type\":\"joint_targets\",\"values\":[0.1],\"dt_ms\":33}]},"
-        "\"session_id\":\"sess-1\",\"error\":null,"
-        "\"metadata\":{\"capability\":\"cap.vla.action_chunk.v1\",\"backend\":\"smolvla\"}}");
-    check(parsed.id == "req-1", "model service parsed response id mismatch");
-    check(parsed.status == bt::model_service_status::action_chunk, "model service parsed status mismatch");
-    check(parsed.output_json.find("\"actions\"") != std::string::npos,
-          "model service parsed output should preserve raw actions JSON");
-    check(parsed.session_id == "sess-1", "model service parsed session id mismatch");
-    check(parsed.metadata_json.find("\"smolvla\"") != std::string::npos,
-          "model service parsed metadata should preserve raw JSON");
+    bt::duration_stats stats;
+    for (int i = 1; i <= 990; ++i) {
+        stats.observe(ns(1000 + i));
+    }
+    for (int i = 0; i < 10; ++i) {
+        stats.observe(ns(5'000'000));
+    }
+    check(stats.histogram.count() == 1000, "every observation should be counted");
+    check(stats.percentile(0.5).count() >= 1495 && stats.percentile(0.5).count() <= 1500 * 9 / 8,
+          "p50 should be within one bucket of the median");
+    check(stats.percentile(0.99).count() <= 2000 * 9 / 8, "p99 should stay below the 1% tail");
+    check(stats.percentile(0.999).count() == 5'000'000, "p999 should reach the tail, capped at max");
+
+    bt::duration_stats other;
+    other.observe(ns(5'000'000));
+    bt::latency_histogram merged = stats.histogram;
+    merged.merge(other.histogram);
+    check(merged.count() == 1001 && stats.histogram.count() == 1000, "merge should add into a copy only");
 
-    check(std::string(bt::model_service_status_name(response.status)) == "unavailable",
-          "model service unavailable status mismatch");
-    check(bt::model_service_status_terminal(response.status), "unavailable should be terminal");
-    check(response.id == "req-1", "model service response should preserve request id");
-    check(response.error_code == "model_service_unconfigured",
-          "model service unavailable error code mismatch");
-    check(!response.host_reached, "unconfigured model service must not reach host execution");
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
+    (void)eval_text("(define tree (bt.compile '(seq (cond always-true) (act always-success))))", env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    for (int i = 0; i < 20; ++i) {
+        (void)eval_text("(bt.tick inst)", env);
+    }
+    const std::string inst_stats = string_value(eval_text("(bt.stats inst)", env));
+    check(inst_stats.find("tick_p99_ns=") != std::string::npos, "bt.stats should report tick percentiles");
+    check(inst_stats.find(" p999_ns=") != std::string::npos, "bt.stats should report node percentiles");
+
+    value buckets = eval_text("(bt.latency-histogram inst)", env);
+    std::int64_t total = 0;
+    for (value it = buckets; is_cons(it); it = cdr(it)) {
+        total += integer_value(car(cdr(car(it))));
+    }
+    check(total == 20, "bt.latency-histogram should cover every tree tick");
+    value node_buckets = eval_text("(bt.latency-histogram inst 1)", env);
+    check(is_cons(node_buckets), "bt.latency-histogram should return node buckets");
 
-    struct fake_describe_client final : bt::model_service_client {
-        bt::model_service_response call(const bt::model_service_request& req) override {
-            bt::model_service_response out;
-            out.id = req.id;
-            out.status = bt::model_service_status::success;
-            out.output_json =
-                "{\"capabilities\":["
-                "{\"id\":\"cap.model.world.rollout.v1\",\"mode\":\"invoke\","
-                "\"input_schema\":\"mms://schemas/cap.model.world.rollout.request.v1\","
-                "\"output_schema\":\"mms://schemas/cap.model.world.rollout.result.v1\","
-                "\"supports_cancel\":false,\"supports_deadline\":true,\"freshness\":{},"
-                "\"replay\":{\"supported\":true}},"
-                "{\"id\":\"cap.model.world.score_trajectory.v1\",\"mode\":\"invoke\","
-                "\"input_schema\":\"mms://schemas/cap.model.world.score_trajectory.request.v1\","
-                "\"output_schema\":\"mms://schemas/cap.model.world.score_trajectory.result.v1\","
-                "\"supports_cancel\":false,\"supports_deadline\":true,\"freshness\":{},"
-                "\"replay\":{\"supported\":true}},"
-                "{\"id\":\"cap.vla.action_chunk.v1\",\"mode\":\"session\","
-                "\"input_schema\":\"mms://schemas/cap.vla.action_chunk.request.v1\","
-                "\"output_schema\":\"mms://schemas/cap.vla.action_chunk.result.v1\","
-                "\"supports_cancel\":true,\"supports_deadline\":true,"
-                "\"freshness\":{\"expects_fresh_observation\":true},"
-                "\"replay\":{\"supported\":false}},"
-                "{\"id\":\"cap.vla.propose_nav_goal.v1\",\"mode\":\"invoke\","
-                "\"input_schema\":\"mms://schemas/cap.vla.propose_nav_goal.request.v1\","
-                "\"output_schema\":\"mms://schemas/cap.vla.propose_nav_goal.result.v1\","
-                "\"supports_cancel\":false,\"supports_deadline\":true,\"freshness\":{},"
-                "\"replay\":{\"supported\":true}}"
-                "]}";
-            return out;
+    (void)eval_text("(define d (bt.compile '(act async-sleep-ms 1)))", env);
+    (void)eval_text("(define ai (bt.new-instance d))", env);
+    for (int i = 0; i < 2000 && symbol_name(eval_text("(bt.tick ai)", env)) == "running"; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    const std::string sched_stats = string_value(eval_text("(bt.scheduler.stats)", env));
+    check(sched_stats.find("queue_delay_p99_ns=") != std::string::npos && sched_stats.find("run_time_p50_ns=") != std::string::npos,
+          "bt.scheduler.stats should report queue delay and run time percentiles");
+    check(is_cons(eval_text("(bt.latency-histogram 'run-time)", env)), "the run-time histogram should hold the job");
+}
+
+void test_node_profiling_modes_and_profile_clock() {
+    using namespace muslisp;
+
+    const bt::profile_clock& clock = bt::profile_clock::shared();
+    const auto steady_start = std::chrono::steady_clock::now();
+    const auto clock_start = clock.now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    const auto clock_elapsed = clock.now() - clock_start;
+    const auto steady_elapsed = std::chrono::steady_clock::now() - steady_start;
+    check(clock_elapsed > std::chrono::milliseconds(15) && clock_elapsed < steady_elapsed + std::chrono::milliseconds(5),
+          "the profile clock should track steady_clock over short intervals");
+    const bt::profile_clock fallback(bt::profile_clock::source::steady);
+    check(fallback.active_source() == bt::profile_clock::source::steady, "the steady source should always be available");
+
+    reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
+    env_ptr env = create_global_env();
+    (void)eval_text("(define tree (bt.compile '(seq (cond always-true) (act always-success))))", env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    bt::instance* inst = host.find_instance(bt_handle(eval_text("inst", env)));
+    const bt::node_id root = inst->def->root;
+    auto tick_n = [&](int n) {
+        for (int i = 0; i < n; ++i) {
+            (void)eval_text("(bt.tick inst)", env);
         }
     };
-    fake_describe_client compatible_client;
-    const bt::model_service_compatibility_result compatible =
-        bt::check_model_service_compatibility(compatible_client);
-    check(compatible.compatible, "complete describe response should be compatible");
-    check(compatible.missing_capabilities.empty(), "compatible describe should not report missing capabilities");
-    check(compatible.invalid_capabilities.empty(), "compatible describe should not report invalid capabilities");
-    check(compatible.descriptor_errors.empty(), "compatible describe should not report descriptor errors");
 
-    struct missing_describe_client final : bt::model_service_client {
-        bt::model_service_response call(const bt::model_service_request& req) override {
-            bt::model_service_response out;
-            out.id = req.id;
-            out.status = bt::model_service_status::success;
-            out.output_json = "{\"capabilities\":[{\"id\":\"cap.model.world.rollout.v1\"}]}";
-            return out;
+    tick_n(4);
+    check(inst->node_stats[root].tick_duration.count == 4, "full profiling should time every visit");
+
+    (void)eval_text("(bt.set-node-profiling inst 'off)", env);
+    tick_n(4);
+    check(inst->node_stats[root].tick_duration.count == 4 && inst->node_stats[root].success_returns == 8,
+          "profiling off should count returns without timing");
+    check(string_value(eval_text("(bt.stats inst)", env)).find("node_profiling=off") != std::string::npos,
+          "bt.stats should report the profiling mode");
+
+    (void)eval_text("(bt.set-node-profiling inst 'sampled 4)", env);
+    tick_n(8);
+    check(inst->node_stats[root].tick_duration.count == 6, "sampling every 4th tick should time two of eight visits");
+
+    (void)eval_text("(bt.set-node-profiling inst 'sampled 1 50)", env);
+    const std::uint64_t before = inst->node_stats[root].tick_duration.count;
+    tick_n(400);
+    const std::uint64_t timed = inst->node_stats[root].tick_duration.count - before;
+    check(timed > 100 && timed < 300, "node sampling should time roughly the requested share of visits");
+
+    bt::set_node_profiling(*inst, bt::node_profiling_options{});
+    check(inst->node_profiling.mode == bt::node_profiling_mode::full, "set_node_profiling should restore full timing");
+    bool rejected = false;
+    try {
+        bt::set_node_profiling(*inst, bt::node_profiling_options{.mode = bt::node_profiling_mode::sampled, .every_n_ticks = 0});
+    } catch (const std::invalid_argument&) {
+        rejected = true;
+    }
+    check(rejected, "a zero tick interval should be rejected");
+    expect_lisp_error_message("(bt.set-node-profiling inst 'sampled 1 101)",
+                              env,
+                              "bt.set-node-profiling: node percentage must be at most 100",
+                              "bt.set-node-profiling percentage");
+}
+void test_flamegraph_dump_attributes_self_time_to_node_paths() {
+    using namespace muslisp;
+
+    // Every read moves 100 ns, so each leaf visit takes 100 ns and the root spends 300 ns of its own.
+    class stepping_clock final : public bt::clock_interface {
+    public:
+        std::chrono::steady_clock::time_point now() const override {
+            ticks_ += 100;
+            return std::chrono::steady_clock::time_point(std::chrono::nanoseconds(ticks_));
         }
+
+    private:
+        mutable std::int64_t ticks_ = 0;
     };
-    missing_describe_client missing_client;
-    const bt::model_service_compatibility_result missing =
-        bt::check_model_service_compatibility(missing_client);
-    check(!missing.compatible, "missing describe response should be incompatible");
-    check(missing.error_code == "model_service_capability_missing",
-          "missing describe response should report capability_missing");
-    check(!missing.missing_capabilities.empty(), "missing describe response should list missing capabilities");
+    const stepping_clock timer;
 
-    struct invalid_descriptor_client final : bt::model_service_client {
-        bt::model_service_response call(const bt::model_service_request& req) override {
-            bt::model_service_response out;
-            out.id = req.id;
-            out.status = bt::model_service_status::success;
-            out.output_json =
-                "{\"capabilities\":["
-                "{\"id\":\"cap.model.world.rollout.v1\",\"mode\":\"invoke\","
-                "\"input_schema\":\"mms://schemas/cap.model.world.rollout.request.v1\","
-                "\"output_schema\":\"mms://schemas/cap.model.world.rollout.result.v1\","
-                "\"supports_cancel\":false,\"supports_deadline\":true,\"freshness\":{},"
-                "\"replay\":{\"supported\":true}},"
-                "{\"id\":\"cap.model.world.score_trajectory.v1\",\"mode\":\"invoke\","
-                "\"input_schema\":\"mms://schemas/cap.model.world.score_trajectory.request.v1\","
-                "\"output_schema\":\"mms://schemas/cap.model.world.score_trajectory.result.v1\","
-                "\"supports_cancel\":false,\"supports_deadline\":true,\"freshness\":{},"
-                "\"replay\":{\"supported\":true}},"
-                "{\"id\":\"cap.vla.action_chunk.v1\",\"mode\":\"invoke\","
-                "\"input_schema\":\"mms://schemas/cap.vla.action_chunk.request.v1\","
-                "\"output_schema\":\"mms://schemas/cap.vla.action_chunk.result.v1\","
-                "\"supports_cancel\":false,\"supports_deadline\":true,"
-                "\"freshness\":{\"expects_fresh_observation\":false},"
-                "\"replay\":{\"supported\":false}},"
-                "{\"id\":\"cap.vla.propose_nav_goal.v1\",\"mode\":\"invoke\","
-                "\"input_schema\":\"mms://schemas/cap.vla.propose_nav_goal.request.v1\","
-                "\"output_schema\":\"mms://schemas/cap.vla.propose_nav_goal.result.v1\","
-                "\"supports_cancel\":false,\"supports_deadline\":true,\"freshness\":{},"
-                "\"replay\":{\"supported\":true}}"
-                "]}";
-            return out;
+    reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
+    env_ptr env = create_global_env();
+    (void)eval_text("(define tree (bt.compile '(seq (cond always-true) (act always-success))))", env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    const std::int64_t handle = bt_handle(eval_text("inst", env));
+    bt::instance* inst = host.find_instance(handle);
+    bt::set_node_profiling(*inst, bt::node_profiling_options{.timer = &timer});
+    for (int i = 0; i < 4; ++i) {
+        (void)eval_text("(bt.tick inst)", env);
+    }
+
+    const std::string root = "seq#" + std::to_string(inst->def->root);
+    const std::string stacks = string_value(eval_text("(bt.flamegraph inst)", env));
+    check(stacks.find(root + " 1200\n") != std::string::npos, "the root should keep its own time only");
+    check(stacks.find(root + ";cond:always-true 400\n") != std::string::npos, "the condition should sit under the root");
+    check(stacks.find(root + ";act:always-success 400\n") != std::string::npos, "the action should sit under the root");
+
+    const std::string all = string_value(eval_text("(bt.flamegraph)", env));
+    check(all.find("inst-" + std::to_string(handle) + ";" + root + ";act:always-success 400\n") != std::string::npos,
+          "the host-wide dump should root each instance at its handle");
+    bt::set_node_profiling(*inst, bt::node_profiling_options{});
+    expect_lisp_error_message("(bt.flamegraph 1 2)", env, "bt.flamegraph: expected 0 or 1 arguments", "bt.flamegraph arity");
+}
+#if !defined(_WIN32)
+std::string http_get_local(std::uint16_t port, const std::string& path) {
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    check(fd >= 0, "test socket should open");
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    check(::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0, "metrics endpoint should accept");
+    const std::string request = "GET " + path + " HTTP/1.0\r\nHost: localhost\r\n\r\n";
+    check(::send(fd, request.data(), request.size(), 0) == static_cast<ssize_t>(request.size()), "request should send");
+    std::string response;
+    char buffer[4096];
+    for (ssize_t got = 0; (got = ::recv(fd, buffer, sizeof(buffer), 0)) > 0;) {
+        response.append(buffer, static_cast<std::size_t>(got));
+    }
+    ::close(fd);
+    return response;
+}
+#endif
+
+void test_runtime_metrics_render_and_serve_openmetrics() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
+    env_ptr env = create_global_env();
+    (void)eval_text("(define tree (bt.compile '(seq (cond always-true) (act always-success))))", env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    (void)eval_text("(define other (bt.new-instance tree))", env);
+
+    (void)eval_text("(bt.tick inst)", env);
+    check(string_value(eval_text("(bt.metrics)", env)).find("muesli_bt_tick_duration_seconds_count 0\n") != std::string::npos,
+          "ticks should not be recorded while metrics are disabled");
+
+    (void)eval_text("(bt.set-metrics-enabled #t)", env);
+    for (int i = 0; i < 3; ++i) {
+        (void)eval_text("(bt.tick inst)", env);
+    }
+    (void)eval_text("(bt.tick-all (list inst other))", env);
+    default_gc().collect();
+    const std::string text = string_value(eval_text("(bt.metrics)", env));
+    check(text.find("# TYPE muesli_bt_tick_duration_seconds histogram\n") != std::string::npos, "tick histogram family");
+    check(text.find("muesli_bt_tick_duration_seconds_count 5\n") != std::string::npos,
+          "host ticks and wave ticks should both be recorded");
+    check(text.find("muesli_bt_tick_duration_seconds_bucket{le=\"+Inf\"} 5\n") != std::string::npos, "+Inf bucket");
+    check(text.find("muesli_bt_gc_pause_seconds_count 0\n") == std::string::npos, "GC pauses should be recorded");
+    check(text.find("muesli_bt_scheduler_jobs_in_flight ") != std::string::npos, "scheduler gauge");
+    check(text.find("muesli_bt_vla_cache_hits_total ") != std::string::npos, "VLA cache counter");
+    check(text.size() >= 6 && text.compare(text.size() - 6, 6, "# EOF\n") == 0, "OpenMetrics text should end with # EOF");
+
+#if !defined(_WIN32)
+    const std::int64_t port = integer_value(eval_text("(bt.metrics-serve 0)", env));
+    check(port > 0 && host.metrics_endpoint_port() == static_cast<std::uint16_t>(port), "endpoint should report its port");
+    const std::string scraped = http_get_local(static_cast<std::uint16_t>(port), "/metrics");
+    check(scraped.starts_with("HTTP/1.0 200 OK\r\n"), "scrape should succeed");
+    check(scraped.find("Content-Type: application/openmetrics-text") != std::string::npos, "OpenMetrics content type");
+    check(scraped.find("muesli_bt_tick_duration_seconds_count 5\n") != std::string::npos, "scrape should carry the metrics");
+    check(http_get_local(static_cast<std::uint16_t>(port), "/").starts_with("HTTP/1.0 404"), "other paths should 404");
+    (void)eval_text("(bt.metrics-stop)", env);
+    check(host.metrics_endpoint_port() == 0u, "bt.metrics-stop should close the endpoint");
+    expect_lisp_error_message("(bt.metrics-serve 0 \"localhost\")",
+                              env,
+                              "bt.metrics-serve: metrics endpoint: expected an IPv4 address, got localhost",
+                              "bt.metrics-serve bind address");
+#endif
+
+    reset_bt_runtime_host();
+    check(!host.metrics_enabled(), "clearing the host should disable metrics");
+}
+
+void test_snapshot_restores_global_bindings_into_a_fresh_env() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
+    (void)eval_text("(define (fact n) (if (< n 2) 1 (* n (fact (- n 1)))))", env);
+    (void)eval_text("(define make-counter (lambda () (let ((hits (vec.make))) (lambda () (begin (vec.push! hits 1) (vec.len hits))))))", env);
+    (void)eval_text("(define counter (make-counter))", env);
+    (void)eval_text("(counter)", env);
+    (void)eval_text("(define cfg (map.make))", env);
+    (void)eval_text("(map.set! cfg 'speed 1.5)", env);
+    (void)eval_text("(define layered (pvec.push (pvec.make) (pmap.set (pmap.make) \"path\" (list 1 2 3))))", env);
+    (void)eval_text("(define self-ref (vec.make))", env);
+    (void)eval_text("(vec.push! self-ref self-ref)", env);
+    (void)eval_text("(define big 9000000000000000000)", env);
+    (void)eval_text("(define first car)", env);
+    (void)eval_text("(define tree (bt.compile '(seq (cond always-true) (act always-success))))", env);
+
+    const auto path = temp_file_path("global_env", ".snapshot");
+    const std::string path_lisp = lisp_string_literal(path.string());
+    check(integer_value(eval_text("(snapshot.save " + path_lisp + ")", env)) >= 10,
+          "snapshot.save should count the saved bindings");
+
+    reset_bt_runtime_host();
+    env_ptr restored = create_global_env();
+    check(integer_value(eval_text("(snapshot.load " + path_lisp + ")", restored)) >= 10,
+          "snapshot.load should count the restored bindings");
+    check(integer_value(eval_text("(fact 10)", restored)) == 3628800, "restored recursive closures should run");
+    check(integer_value(eval_text("(counter)", restored)) == 2, "closures should keep their captured state");
+    check(float_value(eval_text("(map.get cfg 'speed 0)", restored)) == 1.5, "maps should round-trip");
+    check(print_value(eval_text("(pmap.get (pvec.get layered 0) \"path\" 0)", restored)) == "(1 2 3)",
+          "nested persistent collections should round-trip");
+    check(is_boolean(eval_text("(eq? (vec.get self-ref 0) self-ref)", restored)) &&
+              boolean_value(eval_text("(eq? (vec.get self-ref 0) self-ref)", restored)),
+          "shared and cyclic structure should be preserved");
+    check(integer_value(eval_text("big", restored)) == 9000000000000000000, "boxed integers should round-trip");
+    check(integer_value(eval_text("(first '(7 8))", restored)) == 7, "primitives should be rebound by name");
+    check(symbol_name(eval_text("(bt.tick (bt.new-instance tree))", restored)) == "success",
+          "BT definitions should be restored into the runtime host");
+
+    (void)eval_text("(define inst (bt.new-instance tree))", restored);
+    expect_lisp_error_message("(snapshot.save " + path_lisp + ")",
+                              restored,
+                              "snapshot.save: cannot save bt_instance values; create them after loading",
+                              "snapshot.save of a live instance");
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << "MLS1";
+    }
+    expect_lisp_error_message(
+        "(snapshot.load " + path_lisp + ")", restored, "snapshot.load: truncated snapshot", "truncated snapshot");
+    std::filesystem::remove(path);
+}
+
+void test_thread_pool_scheduler_recycles_bounded_job_slots() {
+    auto wait_terminal = [](bt::scheduler& sched, bt::job_id id) {
+        for (int i = 0; i < 2000; ++i) {
+            const bt::job_status st = sched.get_info(id).status;
+            if (st != bt::job_status::queued && st != bt::job_status::running) {
+                return st;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
         }
+        return bt::job_status::unknown;
+    };
+    auto quick_job = [](int value) {
+        return bt::job_request{.task_name = "quick", .fn = [value] { return bt::job_result{.payload = value}; }};
     };
-    invalid_descriptor_client invalid_descriptor;
-    const bt::model_service_compatibility_result invalid_compatibility =
-        bt::check_model_service_compatibility(invalid_descriptor);
-    check(!invalid_compatibility.compatible, "invalid descriptor response should be incompatible");
-    check(invalid_compatibility.error_code == "model_service_descriptor_invalid",
-          "invalid descriptor response should report descriptor_invalid");
-    check(invalid_compatibility.invalid_capabilities.size() == 1 &&
-              invalid_compatibility.invalid_capabilities.front() == "cap.vla.action_chunk.v1",
-          "invalid descriptor response should report the invalid capability");
-    check(!invalid_compatibility.descriptor_errors.empty(),
-          "invalid descriptor response should include descriptor diagnostics");
 
-    struct replay_fake_client final : bt::model_service_client {
-        int calls = 0;
-        bt::model_service_response call(const bt::model_service_request& req) override {
-            ++calls;
-            bt::model_service_response out;
-            out.id = req.id;
-            out.status = bt::model_service_status::success;
-            out.output_json = "{\"predicted_states\":[{\"vector\":[0.0]}]}";
-            out.metadata_json = "{\"backend\":\"fake\"}";
-            out.raw_json = bt::model_service_response_to_json(out);
-            return out;
+    {
+        bt::thread_pool_scheduler sched(2, bt::scheduler_limits{.max_jobs = 8, .max_retained_finished = 4});
+        const bt::job_id first = sched.submit(quick_job(1));
+        check(wait_terminal(sched, first) == bt::job_status::done, "first job should finish");
+        std::vector<bt::job_id> ids;
+        for (int i = 0; i < 200; ++i) {
+            ids.push_back(sched.submit(quick_job(i)));
+            (void)wait_terminal(sched, ids.back());
         }
-    };
+        check(sched.slot_count() <= 8, "job slots should stay within max_jobs over a long run");
+        check(sched.get_info(first).status == bt::job_status::unknown, "recycled job ids should report unknown");
+        bt::job_result stale;
+        check(!sched.try_get_result(first, stale) && !sched.cancel(first), "recycled job ids should not reach the new job");
+        bt::job_result latest;
+        check(sched.try_get_result(ids.back(), latest) && std::any_cast<int>(latest.payload) == 199,
+              "recently finished jobs should keep their result");
+        check(ids.back() != ids[ids.size() - 5], "reused slots should hand out fresh job ids");
+        check(sched.stats_snapshot().queue_overflow == 0, "recycling finished jobs should not count as overflow");
+    }
 
-    bt::runtime_host host;
-    const std::filesystem::path cache_dir = temp_file_path("model_service_replay_cache", "");
-    std::filesystem::remove_all(cache_dir);
-    bt::model_service_config record_cfg;
-    record_cfg.replay_mode = "record";
-    record_cfg.replay_cache_path = cache_dir.string();
-    auto record_client = std::make_unique<replay_fake_client>();
-    replay_fake_client* record_client_ptr = record_client.get();
-    host.set_model_service_client(record_cfg, std::move(record_client));
+    std::atomic<bool> release{false};
+    auto blocking_job = [&release] {
+        return bt::job_request{.task_name = "block", .fn = [&release] {
+                                   while (!release.load()) {
+                                       std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                                   }
+                                   return bt::job_result{};
+                               }};
+    };
+    {
+        bt::thread_pool_scheduler sched(1, bt::scheduler_limits{.max_jobs = 3, .max_retained_finished = 2});
+        std::vector<bt::job_id> live;
+        for (int i = 0; i < 3; ++i) {
+            live.push_back(sched.submit(blocking_job()));
+        }
+        bool threw = false;
+        try {
+            (void)sched.submit(quick_job(0));
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        check(threw, "the reject policy should refuse a submit when every slot is live");
+        check(sched.stats_snapshot().queue_overflow == 1, "a rejected submit should count as queue overflow");
+        check(sched.cancel(live[2]), "a queued job should be cancellable");
+        const bt::job_id reused = sched.submit(quick_job(0));
+        check(sched.get_info(live[2]).status == bt::job_status::unknown && sched.get_info(reused).status == bt::job_status::queued,
+              "a full table should recycle finished jobs before overflowing");
+        release.store(true);
+        check(wait_terminal(sched, reused) == bt::job_status::done, "the recycled slot should run its new job");
+    }
 
-    bt::model_service_request cache_request;
-    cache_request.id = "cache-1";
-    cache_request.op = bt::model_service_operation::invoke;
-    cache_request.capability = "cap.model.world.rollout.v1";
-    cache_request.input_json = "{\"state\":{\"vector\":[0.0]},\"actions\":[]}";
-    const bt::model_service_response recorded = host.call_model_service(cache_request);
-    check(recorded.status == bt::model_service_status::success, "recorded model-service call should succeed");
-    check(recorded.validation_checked, "recorded model-service call should run validation");
-    check(recorded.validation_ok, "recorded model-service call should pass validation");
-    check(!recorded.request_hash.empty(), "recorded model-service call should have request hash");
-    check(!recorded.response_hash.empty(), "recorded model-service call should have response hash");
-    check(record_client_ptr->calls == 1, "recording should call live model-service client once");
-    check(std::filesystem::exists(cache_dir / (recorded.request_hash + ".json")),
-          "recording should write replay cache file");
+    release.store(false);
+    {
+        bt::thread_pool_scheduler sched(
+            1, bt::scheduler_limits{.max_jobs = 2, .max_retained_finished = 2, .overflow = bt::queue_overflow_policy::grow});
+        std::vector<bt::job_id> live;
+        for (int i = 0; i < 4; ++i) {
+            live.push_back(sched.submit(blocking_job()));
+        }
+        check(sched.slot_count() == 4 && sched.stats_snapshot().queue_overflow == 2, "the grow policy should add counted slots");
+        release.store(true);
+        for (const bt::job_id id : live) {
+            check(wait_terminal(sched, id) == bt::job_status::done || sched.get_info(id).status == bt::job_status::unknown,
+                  "grown slots should run their jobs");
+        }
+    }
 
-    bt::model_service_config replay_cfg;
-    replay_cfg.replay_mode = "replay";
-    replay_cfg.replay_cache_path = cache_dir.string();
-    host.set_model_service_client(replay_cfg, nullptr);
-    const bt::model_service_response replayed = host.call_model_service(cache_request);
-    check(replayed.status == bt::model_service_status::success, "replayed model-service call should succeed");
-    check(replayed.validation_checked, "replayed model-service call should run validation");
-    check(replayed.validation_ok, "replayed model-service call should pass validation");
-    check(replayed.replay_cache_hit, "replayed model-service call should report cache hit");
-    check(replayed.request_hash == recorded.request_hash, "replayed model-service request hash mismatch");
-    check(replayed.response_hash == recorded.response_hash, "replayed model-service response hash mismatch");
-    std::filesystem::remove_all(cache_dir);
+    bool threw = false;
+    try {
+        bt::thread_pool_scheduler invalid(1, bt::scheduler_limits{.max_retained_finished = 0});
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    check(threw, "a zero retention limit should be rejected");
+}
 
-    struct invalid_output_client final : bt::model_service_client {
-        bt::model_service_response call(const bt::model_service_request& req) override {
-            bt::model_service_response out;
-            out.id = req.id;
-            out.status = bt::model_service_status::success;
-            out.output_json = "{\"score\":1.0}";
-            out.raw_json = bt::model_service_response_to_json(out);
-            return out;
+void test_scheduler_worker_thread_options() {
+#if defined(__linux__)
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    check(sched_getaffinity(0, sizeof(allowed), &allowed) == 0, "the test process should report its cpu affinity");
+    int cpu = 0;
+    while (cpu < CPU_SETSIZE && !CPU_ISSET(cpu, &allowed)) {
+        ++cpu;
+    }
+
+    struct worker_view {
+        std::string name;
+        int cpu_count = 0;
+        bool on_cpu = false;
+    };
+    auto probe = [cpu] {
+        return bt::job_request{.task_name = "probe", .fn = [cpu] {
+                                   worker_view view;
+                                   char name[16] = {};
+                                   (void)pthread_getname_np(pthread_self(), name, sizeof(name));
+                                   view.name = name;
+                                   cpu_set_t set;
+                                   CPU_ZERO(&set);
+                                   if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+                                       view.cpu_count = CPU_COUNT(&set);
+                                       view.on_cpu = CPU_ISSET(cpu, &set);
+                                   }
+                                   return bt::job_result{.payload = view};
+                               }};
+    };
+    auto wait_view = [](bt::scheduler& sched, bt::job_id id) {
+        bt::job_result result;
+        for (int i = 0; i < 2000 && !sched.try_get_result(id, result); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
         }
+        check(result.payload.has_value(), "probe job should finish");
+        return std::any_cast<worker_view>(result.payload);
     };
-    host.set_model_service_client(bt::model_service_config{}, std::make_unique<invalid_output_client>());
-    const bt::model_service_response invalid = host.call_model_service(cache_request);
-    check(invalid.status == bt::model_service_status::invalid_output,
-          "world rollout missing predicted_states should be invalid_output");
-    check(invalid.validation_checked, "invalid model-service output should run validation");
-    check(!invalid.validation_ok, "invalid model-service output should fail validation");
-    check(invalid.validation_reason_code == "model_service_missing_predicted_states",
-          "invalid model-service output reason mismatch");
-    check(!invalid.host_reached, "invalid model-service output must not reach host");
 
-    struct unsafe_output_client final : bt::model_service_client {
-        bt::model_service_response call(const bt::model_service_request& req) override {
-            bt::model_service_response out;
-            out.id = req.id;
-            out.status = bt::model_service_status::success;
-            out.output_json = "{\"predicted_states\":[],\"unsafe\":true}";
-            out.raw_json = bt::model_service_response_to_json(out);
-            return out;
+    const bt::scheduler_thread_options pinned{.name_prefix = "mbt-test-worker-long", .cpus = {cpu}};
+    {
+        bt::thread_pool_scheduler sched(1, bt::scheduler_limits{}, pinned);
+        const worker_view view = wait_view(sched, sched.submit(probe()));
+        check(view.name == "mbt-test-work-0", "thread pool workers should carry the truncated name prefix");
+        check(view.cpu_count == 1 && view.on_cpu, "thread pool workers should be pinned to the listed cpu");
+        check(sched.thread_setup_errors().empty(), "valid thread options should not report setup errors");
+    }
+    {
+        bt::work_stealing_scheduler sched(1, pinned);
+        const worker_view view = wait_view(sched, sched.submit(probe()));
+        check(view.name == "mbt-test-work-0" && view.cpu_count == 1 && view.on_cpu,
+              "work-stealing workers should apply the same thread options");
+    }
+    {
+        bt::thread_pool_scheduler sched(1, bt::scheduler_limits{}, bt::scheduler_thread_options{.cpus = {-1}});
+        const worker_view view = wait_view(sched, sched.submit(probe()));
+        check(view.name == "mbt-sched-0", "the default name prefix should apply");
+        const std::vector<std::string> errors = sched.thread_setup_errors();
+        check(errors.size() == 1 && errors[0].find("worker 0: cpu affinity -1") == 0,
+              "an invalid cpu should be reported without stopping the worker");
+    }
+
+    bt::runtime_host host(bt::runtime_host_options{.scheduler_workers = 2, .scheduler_threads = pinned});
+    const std::string stats = host.dump_scheduler_stats();
+    check(stats.find("workers=2\n") != std::string::npos &&
+              stats.find("worker_cpus=" + std::to_string(cpu) + "\n") != std::string::npos,
+          "runtime_host should build its scheduler from the host options");
+#endif
+}
+
+void test_scheduler_dispatches_by_priority_and_deadline() {
+    auto wait_terminal = [](bt::scheduler& sched, bt::job_id id) {
+        for (int i = 0; i < 2000; ++i) {
+            const bt::job_status st = sched.get_info(id).status;
+            if (st != bt::job_status::queued && st != bt::job_status::running) {
+                return st;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
         }
+        return bt::job_status::unknown;
     };
-    host.set_model_service_client(bt::model_service_config{}, std::make_unique<unsafe_output_client>());
-    const bt::model_service_response unsafe = host.call_model_service(cache_request);
-    check(unsafe.status == bt::model_service_status::unsafe_output,
-          "unsafe model-service output should be unsafe_output");
-    check(unsafe.validation_reason_code == "model_service_unsafe_output",
-          "unsafe model-service output reason mismatch");
-    check(!unsafe.host_reached, "unsafe model-service output must not reach host");
-
-    struct fault_schedule_live_client final : bt::model_service_client {
-        int calls = 0;
-        bt::model_service_response call(const bt::model_service_request& req) override {
-            ++calls;
-            bt::model_service_response out;
-            out.id = req.id;
-            out.status = bt::model_service_status::success;
-            out.output_json = "{\"predicted_states\":[{\"vector\":[1.0]}]}";
-            out.raw_json = bt::model_service_response_to_json(out);
-            return out;
+    std::atomic<bool> release{false};
+    auto blocking_job = [&release] {
+        return bt::job_request{.task_name = "block", .fn = [&release] {
+                                   while (!release.load()) {
+                                       std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                                   }
+                                   return bt::job_result{};
+                               }};
+    };
+    auto wait_running = [](bt::scheduler& sched, bt::job_id id) {
+        for (int i = 0; i < 2000 && sched.get_info(id).status != bt::job_status::running; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
         }
     };
-    bt::model_service_config fault_cfg;
-    fault_cfg.fault_schedule = {
-        "invalid_output",
-        "unsafe_output",
-        "stale_result",
-        "timeout",
-        "unavailable",
-        "none",
+
+    std::mutex order_mutex;
+    std::vector<std::string> order;
+    const auto now = std::chrono::steady_clock::now();
+    auto recording_job = [&](std::string name, bt::job_priority priority, std::optional<std::chrono::milliseconds> due) {
+        bt::job_request req;
+        req.task_name = name;
+        req.priority = priority;
+        if (due.has_value()) {
+            req.deadline = now + *due;
+        }
+        req.fn = [&order_mutex, &order, name] {
+            std::lock_guard<std::mutex> lock(order_mutex);
+            order.push_back(name);
+            return bt::job_result{};
+        };
+        return req;
     };
-    auto fault_client = std::make_unique<fault_schedule_live_client>();
-    fault_schedule_live_client* fault_client_ptr = fault_client.get();
-    host.set_model_service_client(fault_cfg, std::move(fault_client));
 
-    const bt::model_service_response fault_invalid = host.call_model_service(cache_request);
-    check(fault_invalid.status == bt::model_service_status::invalid_output,
-          "fault invalid_output should produce invalid_output");
-    check(fault_invalid.validation_reason_code == "model_service_missing_predicted_states",
-          "fault invalid_output reason mismatch");
+    {
+        bt::thread_pool_scheduler sched(1);
+        const bt::job_id blocker = sched.submit(blocking_job());
+        wait_running(sched, blocker);
+        std::vector<bt::job_id> ids;
+        ids.push_back(sched.submit(recording_job("low", bt::job_priority::low, std::nullopt)));
+        ids.push_back(sched.submit(recording_job("normal-fifo", bt::job_priority::normal, std::nullopt)));
+        ids.push_back(sched.submit(recording_job("normal-late", bt::job_priority::normal, std::chrono::seconds(20))));
+        ids.push_back(sched.submit(recording_job("normal-early", bt::job_priority::normal, std::chrono::seconds(10))));
+        ids.push_back(sched.submit(recording_job("high", bt::job_priority::high, std::nullopt)));
+        const bt::job_id expiring =
+            sched.submit(recording_job("expiring", bt::job_priority::high, std::chrono::milliseconds(1)));
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        release.store(true);
+        for (const bt::job_id id : ids) {
+            check(wait_terminal(sched, id) == bt::job_status::done, "prioritised jobs should finish");
+        }
+        check(wait_terminal(sched, expiring) == bt::job_status::cancelled, "a job queued past its deadline should be cancelled");
+        check(sched.get_info(expiring).error_text.find("deadline") != std::string::npos,
+              "an expired job should say why it was cancelled");
+        check(order == std::vector<std::string>{"high", "normal-early", "normal-late", "normal-fifo", "low"},
+              "dispatch should follow priority class, then earliest deadline, then submission order");
+
+        const bt::scheduler_profile_stats stats = sched.stats_snapshot();
+        check(stats.expired == 1 && stats.cancelled == 1, "stats should count the expired job");
+        check(stats.queue_delay_by_priority[static_cast<std::size_t>(bt::job_priority::high)].count == 1 &&
+                  stats.queue_delay_by_priority[static_cast<std::size_t>(bt::job_priority::normal)].count == 4 &&
+                  stats.queue_delay_by_priority[static_cast<std::size_t>(bt::job_priority::low)].count == 1,
+              "queue delay should be reported per priority class");
+    }
 
-    const bt::model_service_response fault_unsafe = host.call_model_service(cache_request);
-    check(fault_unsafe.status == bt::model_service_status::unsafe_output,
-          "fault unsafe_output should produce unsafe_output");
-    check(fault_unsafe.validation_reason_code == "model_service_unsafe_output",
-          "fault unsafe_output reason mismatch");
+    release.store(false);
+    {
+        bt::work_stealing_scheduler sched(1);
+        const bt::job_id blocker = sched.submit(blocking_job());
+        wait_running(sched, blocker);
+        const bt::job_id expiring = sched.submit(recording_job("ws-expiring", bt::job_priority::low, std::chrono::milliseconds(1)));
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        release.store(true);
+        check(wait_terminal(sched, expiring) == bt::job_status::cancelled, "work stealing should also expire late jobs");
+        const bt::scheduler_profile_stats stats = sched.stats_snapshot();
+        check(stats.expired == 1 && stats.queue_delay_by_priority[static_cast<std::size_t>(bt::job_priority::normal)].count == 1,
+              "work-stealing stats should count expiry and per-class delay");
+    }
 
-    const bt::model_service_response fault_stale = host.call_model_service(cache_request);
-    check(fault_stale.status == bt::model_service_status::invalid_output,
-          "fault stale_result should produce invalid_output");
-    check(fault_stale.validation_reason_code == "model_service_stale_result",
-          "fault stale_result reason mismatch");
+    bt::job_priority parsed = bt::job_priority::normal;
+    check(bt::parse_job_priority("high", parsed) && parsed == bt::job_priority::high, "priority names should parse");
+    check(!bt::parse_job_priority("urgent", parsed), "unknown priority names should be rejected");
+}
 
-    const bt::model_service_response fault_timeout = host.call_model_service(cache_request);
-    check(fault_timeout.status == bt::model_service_status::timeout,
-          "fault timeout should produce timeout");
-    check(fault_timeout.error_code == "model_service_fault_timeout",
-          "fault timeout error code mismatch");
+void test_scheduler_typed_results_move_once() {
+    // Counts copies, so the test can tell a moved result from a copied one.
+    struct tracked {
+        std::vector<double> values;
+        int* copies = nullptr;
+        tracked(std::vector<double> v, int* c) : values(std::move(v)), copies(c) {}
+        tracked(const tracked& other) : values(other.values), copies(other.copies) { ++*copies; }
+        tracked(tracked&&) noexcept = default;
+        tracked& operator=(const tracked&) = delete;
+        tracked& operator=(tracked&&) noexcept = default;
+    };
 
-    const bt::model_service_response fault_unavailable = host.call_model_service(cache_request);
-    check(fault_unavailable.status == bt::model_service_status::unavailable,
-          "fault unavailable should produce unavailable");
-    check(fault_unavailable.error_code == "model_service_fault_unavailable",
-          "fault unavailable error code mismatch");
+    const auto exercise = [](bt::scheduler& sched, const char* name) {
+        int copies = 0;
+        const bt::typed_job<tracked> job = sched.submit_typed<tracked>(
+            bt::job_request{.task_name = "typed"},
+            [&copies] { return tracked(std::vector<double>(4096, 1.5), &copies); });
+        const auto until = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (sched.get_info(job.id).status != bt::job_status::done && std::chrono::steady_clock::now() < until) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::optional<tracked> taken = sched.take(job);
+        check(taken.has_value() && taken->values.size() == 4096 && taken->values.back() == 1.5,
+              std::string(name) + ": a typed result should come back intact");
+        check(copies == 0, std::string(name) + ": a typed result should be moved, never copied");
+        check(!sched.take(job).has_value(), std::string(name) + ": a result should be taken only once");
+        bt::job_result untyped;
+        check(!sched.try_get_result(job.id, untyped), std::string(name) + ": a taken result should be gone");
+
+        const bt::typed_job<std::string> cancellable = sched.submit_typed<std::string>(
+            bt::job_request{.task_name = "typed-cancel"}, [](const bt::cancel_token& cancel) {
+                while (!cancel.cancelled()) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                return std::string("late");
+            });
+        (void)sched.cancel(cancellable.id);
+        check(!sched.take(cancellable).has_value(), std::string(name) + ": a cancelled job should have no result");
+    };
 
-    const bt::model_service_response fault_passthrough = host.call_model_service(cache_request);
-    check(fault_passthrough.status == bt::model_service_status::success,
-          "fault none should call live model-service client");
-    check(fault_passthrough.validation_ok, "fault none live result should validate");
-    check(fault_client_ptr->calls == 1, "fault schedule should only call live client for passthrough fault");
+    bt::thread_pool_scheduler pool(2);
+    exercise(pool, "thread pool");
+    bt::work_stealing_scheduler stealing(2);
+    exercise(stealing, "work stealing");
 }
 
-void test_vla_builtins_submit_poll_cancel_and_caps() {
-    using namespace muslisp;
+void test_work_stealing_scheduler_lifecycle_and_nested_jobs() {
+    bt::work_stealing_scheduler sched(3);
+    check(sched.worker_count() == 3, "work-stealing scheduler should start the requested workers");
 
-    reset_bt_runtime_host();
-    env_ptr env = create_global_env();
+    auto wait_terminal = [&sched](bt::job_id id) {
+        for (int i = 0; i < 2000; ++i) {
+            const bt::job_status st = sched.get_info(id).status;
+            if (st == bt::job_status::done || st == bt::job_status::failed || st == bt::job_status::cancelled) {
+                return st;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return bt::job_status::unknown;
+    };
 
-    value caps = eval_text("(cap.list)", env);
-    check(is_proper_list(caps), "cap.list should return list");
-    bool saw_vla = false;
-    for (value cap_name : vector_from_list(caps)) {
-        if (is_string(cap_name) && string_value(cap_name).find("vla.") != std::string::npos) {
-            saw_vla = true;
+    // Jobs that submit jobs push onto their worker's deque; idle workers steal them.
+    std::atomic<int> leaf_runs{0};
+    std::vector<bt::job_id> parents;
+    for (int p = 0; p < 8; ++p) {
+        parents.push_back(sched.submit(bt::job_request{
+            .task_name = "parent",
+            .fn =
+                [&sched, &leaf_runs] {
+                    std::vector<bt::job_id> children;
+                    for (int c = 0; c < 16; ++c) {
+                        children.push_back(sched.submit(bt::job_request{.task_name = "leaf", .fn = [&leaf_runs] {
+                                                                            leaf_runs.fetch_add(1);
+                                                                            return bt::job_result{.payload = 1};
+                                                                        }}));
+                    }
+                    return bt::job_result{.payload = children};
+                },
+        }));
+    }
+    for (const bt::job_id parent : parents) {
+        check(wait_terminal(parent) == bt::job_status::done, "parent jobs should finish");
+        bt::job_result result;
+        check(sched.try_get_result(parent, result), "parent result should be readable");
+        for (const bt::job_id child : std::any_cast<std::vector<bt::job_id>>(result.payload)) {
+            check(wait_terminal(child) == bt::job_status::done, "nested jobs should finish");
         }
     }
-    check(saw_vla, "cap.list should include vla capability");
-    check(is_map(eval_text("(cap.describe \"vla.rt2\")", env)), "cap.describe should return map");
-
-    (void)eval_text(
-        "(define req (map.make))"
-        "(map.set! req 'task_id \"task-demo\")"
-        "(map.set! req 'instruction \"move right\")"
-        "(map.set! req 'deadline_ms 250)"
-        "(map.set! req 'seed 42)"
-        "(let ((obs (map.make)))"
-        "  (map.set! obs 'state (list 0.1))"
-        "  (map.set! obs 'timestamp_ms 1000)"
-        "  (map.set! obs 'frame_id \"base\")"
-        "  (map.set! req 'observation obs))"
-        "(let ((space (map.make)))"
-        "  (map.set! space 'type ':continuous)"
-        "  (map.set! space 'dims 1)"
-        "  (map.set! space 'bounds (list (list -1.0 1.0)))"
-        "  (map.set! req 'action_space space))"
-        "(let ((con (map.make)))"
-        "  (map.set! con 'max_abs_value 1.0)"
-        "  (map.set! con 'max_delta 1.0)"
-        "  (map.set! req 'constraints con))"
-        "(let ((m (map.make)))"
-        "  (map.set! m 'name \"rt2-stub\")"
-        "  (map.set! m 'version \"stub-1\")"
-        "  (map.set! req 'model m))",
-        env);
+    check(leaf_runs.load() == 8 * 16, "every nested job should run exactly once");
+
+    // Submits from several threads at once get distinct ids and all run.
+    std::atomic<int> external_runs{0};
+    std::vector<std::thread> submitters;
+    std::vector<std::vector<bt::job_id>> submitted(4);
+    for (std::size_t t = 0; t < submitted.size(); ++t) {
+        submitters.emplace_back([&, t] {
+            for (int i = 0; i < 50; ++i) {
+                submitted[t].push_back(sched.submit(bt::job_request{.task_name = "external", .fn = [&external_runs] {
+                                                                        external_runs.fetch_add(1);
+                                                                        return bt::job_result{};
+                                                                    }}));
+            }
+        });
+    }
+    for (std::thread& thread : submitters) {
+        thread.join();
+    }
+    for (const auto& ids : submitted) {
+        for (const bt::job_id id : ids) {
+            check(wait_terminal(id) == bt::job_status::done, "externally submitted jobs should finish");
+        }
+    }
+    check(external_runs.load() == 200, "every external job should run exactly once");
+
+    // Cancel while queued, cancel while running, and failures.
+    std::atomic<bool> release{false};
+    std::vector<bt::job_id> blockers;
+    for (int i = 0; i < 3; ++i) {
+        blockers.push_back(sched.submit(bt::job_request{.task_name = "block", .fn = [&release] {
+                                                            while (!release.load()) {
+                                                                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                                                            }
+                                                            return bt::job_result{.payload = 7};
+                                                        }}));
+    }
+    for (const bt::job_id id : blockers) {
+        for (int i = 0; i < 2000 && sched.get_info(id).status != bt::job_status::running; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    const bt::job_id queued = sched.submit(bt::job_request{.task_name = "queued", .fn = [] { return bt::job_result{}; }});
+    check(sched.get_info(queued).status == bt::job_status::queued, "a job behind busy workers should be queued");
+    check(sched.get_info(queued).task_name == "queued", "get_info should report the task name");
+    check(sched.cancel(queued), "queued jobs should be cancellable");
+    check(sched.get_info(queued).status == bt::job_status::cancelled, "a cancelled queued job should report cancelled");
+    check(!sched.cancel(queued), "cancelling twice should report false");
+    check(sched.cancel(blockers[0]) && sched.cancel(blockers[0]), "running jobs should accept repeated cancel requests");
+    release.store(true);
+    check(wait_terminal(blockers[0]) == bt::job_status::cancelled, "a job cancelled while running should end cancelled");
+    check(wait_terminal(blockers[1]) == bt::job_status::done, "other running jobs should finish");
+    bt::job_result discarded;
+    check(!sched.try_get_result(blockers[0], discarded), "cancelled jobs should not expose a result");
+
+    const bt::job_id failing = sched.submit(bt::job_request{.task_name = "fail", .fn = []() -> bt::job_result {
+                                                                throw std::runtime_error("boom");
+                                                            }});
+    check(wait_terminal(failing) == bt::job_status::failed, "throwing jobs should fail");
+    check(sched.get_info(failing).error_text == "boom", "failed jobs should keep the error text");
+    check(sched.get_info(999999).status == bt::job_status::unknown, "unknown ids should report unknown");
+
+    const bt::scheduler_profile_stats stats = sched.stats_snapshot();
+    check(stats.submitted == 8 + 8 * 16 + 200 + 3 + 1 + 1, "stats should count every submit");
+    check(stats.cancelled == 2 && stats.failed == 1, "stats should count cancellations and failures");
+    check(stats.completed == 8 + 8 * 16 + 200 + 2 && stats.started == stats.completed + 2,
+          "stats should count started and completed jobs");
+}
 
-    value job = eval_text("(vla.submit req)", env);
-    check(is_integer(job) && integer_value(job) > 0, "vla.submit should return positive job id");
-    const std::int64_t job_id = integer_value(job);
+void test_work_stealing_scheduler_recycles_job_slots() {
+    bt::work_stealing_scheduler sched(2);
+    auto wait_terminal = [&sched](bt::job_id id) {
+        for (int i = 0; i < 200000; ++i) {
+            const bt::job_status st = sched.get_info(id).status;
+            if (st != bt::job_status::queued && st != bt::job_status::running) {
+                return st;
+            }
+            std::this_thread::yield();
+        }
+        return bt::job_status::unknown;
+    };
+    auto quick_job = [](int value) {
+        return bt::job_request{.task_name = "quick", .fn = [value] { return bt::job_result{.payload = value}; }};
+    };
 
-    bool done = false;
-    for (int i = 0; i < 250; ++i) {
-        value st = eval_text("(map.get (vla.poll " + std::to_string(job_id) + ") 'status ':none)", env);
-        check(is_symbol(st), "vla.poll status should be symbol");
-        const std::string name = symbol_name(st);
-        if (name == ":done") {
-            done = true;
-            break;
+    // Taking a result frees the slot for the next submit.
+    const bt::job_id first = sched.submit(quick_job(-1));
+    check(wait_terminal(first) == bt::job_status::done, "first job should finish");
+    bt::job_result taken;
+    check(sched.take_result(first, taken) && std::any_cast<int>(taken.payload) == -1, "first result should be taken");
+    check(!sched.take_result(first, taken), "a result should only be taken once");
+    for (int i = 0; i < 200; ++i) {
+        const bt::job_id id = sched.submit(quick_job(i));
+        check(id != first, "reused slots should hand out fresh job ids");
+        check(wait_terminal(id) == bt::job_status::done, "quick jobs should finish");
+        bt::job_result result;
+        check(sched.take_result(id, result) && std::any_cast<int>(result.payload) == i, "results should be taken");
+    }
+    check(sched.slot_count() <= 64, "taken jobs should give their slot back");
+
+    // Results nobody takes are kept for the last k_retained_finished jobs only.
+    const std::size_t retained = bt::work_stealing_scheduler::k_retained_finished;
+    std::vector<bt::job_id> ids;
+    for (int batch = 0; batch < 8; ++batch) {
+        ids.clear();
+        for (int i = 0; i < 1000; ++i) {
+            ids.push_back(sched.submit(quick_job(i)));
         }
-        if (name == ":error" || name == ":timeout" || name == ":cancelled") {
-            throw std::runtime_error("vla.poll unexpectedly reached terminal non-done state: " + name);
+        for (const bt::job_id id : ids) {
+            check(wait_terminal(id) == bt::job_status::done, "untaken jobs should finish");
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(2));
     }
-    check(done, "vla job should complete");
+    check(sched.slot_count() <= retained + 1000 + 64, "untaken results should not be kept without limit");
+    check(sched.get_info(first).status == bt::job_status::unknown, "recycled job ids should report unknown");
+    bt::job_result stale;
+    check(!sched.try_get_result(first, stale) && !sched.cancel(first), "recycled job ids should not reach the new job");
+    bt::job_result latest;
+    check(sched.try_get_result(ids.back(), latest) && std::any_cast<int>(latest.payload) == 999,
+          "recently finished jobs should keep their result");
+
+    const bt::scheduler_profile_stats stats = sched.stats_snapshot();
+    check(stats.submitted == 1 + 200 + 8000 && stats.completed == stats.submitted, "stats should count every job");
+}
 
-    value final_status =
-        eval_text("(map.get (map.get (vla.poll " + std::to_string(job_id) + ") 'final (map.make)) 'status ':none)", env);
-    check(is_symbol(final_status) && symbol_name(final_status) == ":ok", "vla final status should be :ok");
-    value final_action =
-        eval_text("(map.get (map.get (map.get (vla.poll " + std::to_string(job_id) + ") 'final (map.make)) 'action (map.make)) 'u nil)",
-                  env);
-    check(is_proper_list(final_action), "vla final action.u should be list");
-    const std::vector<value> action_items = vector_from_list(final_action);
-    check(action_items.size() == 1 && is_float(action_items[0]), "vla final action should be one float");
-    check(float_value(action_items[0]) >= -1.0 && float_value(action_items[0]) <= 1.0, "vla final action out of bounds");
+void test_canonical_event_stream_builtins() {
+    using namespace muslisp;
 
-    value job2 = eval_text("(vla.submit req)", env);
-    check(is_integer(job2) && integer_value(job2) > 0, "second vla.submit should return positive job id");
-    value cancelled = eval_text("(vla.cancel " + std::to_string(integer_value(job2)) + ")", env);
-    check(is_boolean(cancelled), "vla.cancel should return boolean");
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
 
-    (void)eval_text(
-        "(define bad-req (map.make))"
-        "(map.set! bad-req 'task_id \"bad\")"
-        "(map.set! bad-req 'deadline_ms 20)"
-        "(let ((obs (map.make)))"
-        "  (map.set! obs 'state (list 0.0))"
-        "  (map.set! obs 'timestamp_ms 1000)"
-        "  (map.set! obs 'frame_id \"base\")"
-        "  (map.set! bad-req 'observation obs))"
-        "(let ((space (map.make)))"
-        "  (map.set! space 'type ':continuous)"
-        "  (map.set! space 'dims 1)"
-        "  (map.set! space 'bounds (list (list -1.0 1.0)))"
-        "  (map.set! bad-req 'action_space space))"
-        "(let ((con (map.make)))"
-        "  (map.set! con 'max_abs_value 1.0)"
-        "  (map.set! con 'max_delta 1.0)"
-        "  (map.set! bad-req 'constraints con))"
-        "(let ((m (map.make)))"
-        "  (map.set! m 'name \"rt2-stub\")"
-        "  (map.set! m 'version \"stub-1\")"
-        "  (map.set! bad-req 'model m))",
-        env);
-    value bad_job = eval_text("(vla.submit bad-req)", env);
-    check(is_integer(bad_job) && integer_value(bad_job) > 0, "bad request submit should still return job id");
-    value bad_status = eval_text("(map.get (vla.poll " + std::to_string(integer_value(bad_job)) + ") 'status ':none)", env);
-    check(is_symbol(bad_status) && symbol_name(bad_status) == ":error", "bad request should become error immediately");
+    check(is_nil(eval_text("(events.enable #t)", env)), "events.enable should return nil");
+    check(is_nil(eval_text("(events.set-flush-each-message #t)", env)),
+          "events.set-flush-each-message should return nil");
+    check(is_nil(eval_text("(events.set-ring-size 256)", env)), "events.set-ring-size should return nil");
 
-    value vla_events = eval_text("(events.dump 80)", env);
-    check(is_proper_list(vla_events), "events.dump should return list");
-    const auto vla_rows = vector_from_list(vla_events);
-    bool saw_vla_result = false;
-    bool saw_task_id = false;
-    bool saw_validation_error = false;
-    for (const value& row : vla_rows) {
-        if (!is_string(row)) {
-            continue;
-        }
+    (void)eval_text("(define tree (bt.compile '(seq (act bb-put-int foo 42) (cond bb-has foo))))", env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    check(symbol_name(eval_text("(bt.tick inst)", env)) == "success", "event stream test tree should succeed");
+    (void)eval_text("(events.snapshot-bb)", env);
+    (void)eval_text("(bt.tick inst)", env);
+
+    value dumped = eval_text("(events.dump 20)", env);
+    check(is_proper_list(dumped), "events.dump should return list");
+    const auto rows = vector_from_list(dumped);
+    check(!rows.empty(), "events.dump should return at least one event");
+    bool saw_schema = false;
+    bool saw_tick_begin = false;
+    bool saw_tick_end = false;
+    bool saw_node_status = false;
+    bool saw_bb_write = false;
+    bool saw_bb_snapshot = false;
+    for (const auto& row : rows) {
+        check(is_string(row), "events.dump rows should be JSON strings");
         const std::string line = string_value(row);
-        if (line.find("\"type\":\"vla_result\"") != std::string::npos) {
-            saw_vla_result = true;
+        if (line.find("\"schema\":\"mbt.evt.v1\"") != std::string::npos) {
+            saw_schema = true;
         }
-        if (line.find("\"task_id\"") != std::string::npos) {
-            saw_task_id = true;
+        if (line.find("\"type\":\"tick_begin\"") != std::string::npos) {
+            saw_tick_begin = true;
         }
-        if (line.find("request.instruction is required") != std::string::npos) {
-            saw_validation_error = true;
+        if (line.find("\"type\":\"tick_end\"") != std::string::npos) {
+            saw_tick_end = true;
+        }
+        if (line.find("\"type\":\"node_status\"") != std::string::npos) {
+            saw_node_status = true;
+        }
+        if (line.find("\"type\":\"bb_write\"") != std::string::npos) {
+            saw_bb_write = true;
+        }
+        if (line.find("\"type\":\"bb_snapshot\"") != std::string::npos) {
+            saw_bb_snapshot = true;
         }
     }
-    check(saw_vla_result, "events should include vla_result");
-    check(saw_task_id, "vla events should contain task_id");
-    check(saw_validation_error, "vla events should include immediate validation errors");
+
+    check(saw_schema, "events should include schema envelope");
+    check(saw_tick_begin, "events should include tick_begin");
+    check(saw_tick_end, "events should include tick_end");
+    check(saw_node_status, "events should include node_status");
+    check(saw_bb_write, "events should include bb_write");
+    check(saw_bb_snapshot, "events should include bb_snapshot");
 }
 
-void test_vla_bt_nodes_flow_and_cancel() {
+void test_tick_audit_event_emission() {
     using namespace muslisp;
 
     reset_bt_runtime_host();
     env_ptr env = create_global_env();
 
-    (void)eval_text(
-        "(define flow-tree "
-        "  (bt.compile "
-        "    '(sel "
-        "       (seq "
-        "         (vla-wait :name \"flow\" :job_key flow-job :action_key flow-action :meta_key flow-meta) "
-        "         (succeed)) "
-        "       (seq "
-        "         (act bb-put-float fallback-action 0.0) "
-        "         (vla-request :name \"flow\" :job_key flow-job :instruction \"move right\" "
-        "                      :state_key state :deadline_ms 30 :dims 1 :bound_lo -1.0 :bound_hi 1.0) "
-        "         (running)))))",
-        env);
-    (void)eval_text("(define flow-inst (bt.new-instance flow-tree))", env);
+    check(is_nil(eval_text("(events.enable #t)", env)), "events.enable should return nil for tick audit test");
+    check(is_nil(eval_text("(events.enable-tick-audit #t)", env)),
+          "events.enable-tick-audit should return nil when enabling");
+    check(is_nil(eval_text("(events.set-ring-size 128)", env)), "events.set-ring-size should return nil");
 
-    bool reached_success = false;
-    for (int i = 0; i < 80; ++i) {
-        value st = eval_text("(bt.tick flow-inst '((state 0.0)))", env);
-        check(is_symbol(st), "flow tree tick should return symbol");
-        const std::string name = symbol_name(st);
-        if (name == "success") {
-            reached_success = true;
-            break;
+    (void)eval_text("(define tree (bt.compile '(seq (act bb-put-int foo 42) (cond bb-has foo))))", env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    check(symbol_name(eval_text("(bt.tick inst)", env)) == "success", "tick audit test tree should succeed");
+
+    value dumped = eval_text("(events.dump 80)", env);
+    check(is_proper_list(dumped), "events.dump should return list for tick audit test");
+    bool saw_tick_audit = false;
+    bool saw_schema = false;
+    bool saw_tick_id = false;
+    bool saw_root_status = false;
+    bool saw_node_path = false;
+    bool saw_logging_mode = false;
+    bool saw_audit_mode = false;
+    bool saw_tick_ok = false;
+    for (const auto& row : vector_from_list(dumped)) {
+        check(is_string(row), "tick audit events.dump rows should be JSON strings");
+        const std::string line = string_value(row);
+        if (line.find("\"type\":\"tick_ok\"") != std::string::npos) {
+            saw_tick_ok = true;
         }
-        check(name == "running", "flow tree should be running until success");
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if (line.find("\"type\":\"tick_audit\"") == std::string::npos) {
+            continue;
+        }
+        saw_tick_audit = true;
+        saw_schema = saw_schema || line.find("\"schema_version\":\"tick_audit.v1\"") != std::string::npos;
+        saw_tick_id = saw_tick_id || line.find("\"tick_id\":1") != std::string::npos;
+        saw_root_status = saw_root_status || line.find("\"root_status\":\"success\"") != std::string::npos;
+        saw_node_path = saw_node_path || line.find("\"node_path\":[2,1],\"terminal_node_id\":1") != std::string::npos;
+        saw_logging_mode = saw_logging_mode || line.find("\"logging_mode\":{") != std::string::npos;
+        saw_audit_mode = saw_audit_mode || line.find("\"audit_mode\":{") != std::string::npos;
     }
-    check(reached_success, "flow tree should eventually succeed");
 
-    bt::runtime_host& host = bt::default_runtime_host();
-    bt::instance* flow_inst = host.find_instance(bt_handle(eval_text("flow-inst", env)));
-    check(flow_inst != nullptr, "flow instance should exist");
-    const bt::bb_entry* action_entry = flow_inst->bb.get("flow-action");
-    check(action_entry != nullptr, "vla-wait should write flow-action");
+    check(saw_tick_audit, "events should include tick_audit when enabled");
+    check(saw_schema, "tick_audit should include schema version");
+    check(saw_tick_id, "tick_audit should include tick_id");
+    check(saw_root_status, "tick_audit should include root status");
+    check(saw_node_path, "tick_audit should include the deepest node_path and its terminal node");
+    check(saw_logging_mode, "tick_audit should include logging_mode");
+    check(saw_audit_mode, "tick_audit should include audit_mode");
+    check(saw_tick_ok, "events should include compact tick_ok outcome");
 
+    check(is_nil(eval_text("(events.enable-tick-audit #f)", env)),
+          "events.enable-tick-audit should return nil when disabling");
+}
+
+void test_tick_audit_reports_budget_ledger() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
+    host.callbacks().register_action(
+        "test-ledger-sleep", [](bt::tick_context&, bt::node_id, bt::node_memory&, std::span<const value>) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(3));
+            return bt::status::success;
+        });
+    env_ptr env = create_global_env();
+    (void)eval_text("(events.enable #t)", env);
+    (void)eval_text("(events.enable-tick-audit #t)", env);
+    (void)eval_text("(events.set-ring-size 256)", env);
     (void)eval_text(
-        "(define cancel-tree "
-        "  (bt.compile "
-        "    '(sel "
-        "       (seq (cond bb-has stop) (vla-cancel :name \"cancel-flow\" :job_key c-job) (succeed)) "
-        "       (vla-request :name \"cancel-flow\" :job_key c-job :instruction \"move\" "
-        "                    :state_key state :deadline_ms 50 :dims 1 :bound_lo -1.0 :bound_hi 1.0))))",
+        "(define tree (bt.compile '(seq (act test-ledger-sleep) (act bb-put-int count 1) "
+        "  (plan-action :name \"ledger-plan\" :planner :mcts :budget_ms 1000 :work_max 32 "
+        "               :model_service \"toy-1d\" :state_key state :action_key action))))",
         env);
-    (void)eval_text("(define cancel-inst (bt.new-instance cancel-tree))", env);
-
-    value first = eval_text("(bt.tick cancel-inst '((state 0.0)))", env);
-    check(is_symbol(first) && symbol_name(first) == "running", "cancel tree first tick should run request");
-    value second = eval_text("(bt.tick cancel-inst '((state 0.0) (stop #t)))", env);
-    check(is_symbol(second) && symbol_name(second) == "success", "cancel tree second tick should cancel and succeed");
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    check(symbol_name(eval_text("(bt.tick inst '((state 0.0)))", env)) == "success", "ledger tick should succeed");
 
-    value cancel_events = eval_text("(events.dump 120)", env);
-    check(is_proper_list(cancel_events), "events.dump should return list for cancel outcome test");
-    bool saw_cancel_acknowledged = false;
-    for (const value& row : vector_from_list(cancel_events)) {
-        if (!is_string(row)) {
-            continue;
-        }
+    std::string audit;
+    for (const auto& row : vector_from_list(eval_text("(events.dump 200)", env))) {
         const std::string line = string_value(row);
-        if (line.find("\"type\":\"cancel_acknowledged\"") != std::string::npos &&
-            line.find("\"schema_version\":\"runtime_outcome.v1\"") != std::string::npos) {
-            saw_cancel_acknowledged = true;
+        if (line.find("\"type\":\"tick_audit\"") != std::string::npos) {
+            audit = line;
         }
     }
-    check(saw_cancel_acknowledged, "VLA cancel should emit compact cancel_acknowledged outcome");
+    check(audit.find("\"budget_ledger\":{\"wall_ns\":") != std::string::npos, "tick_audit should carry the budget ledger");
+    const auto ledger_ns = [&](std::string_view category) -> std::uint64_t {
+        std::string key;
+        key.reserve(category.size() + 3);
+        key.append(1, '"').append(category).append("\":");
+        const std::size_t at = audit.find(key, audit.find("\"budget_ledger\""));
+        return at == std::string::npos ? 0u : std::stoull(audit.substr(at + key.size()));
+    };
+    check(ledger_ns("lisp_leaves") >= 3'000'000u, "the sleeping leaf's time should be charged to lisp_leaves");
+    check(ledger_ns("planner") > 0u, "the plan should be charged to planner");
+    check(ledger_ns("bb_write") > 0u, "blackboard writes should be charged to bb_write");
+    check(ledger_ns("events") > 0u, "event emission should be charged to events");
+    std::uint64_t claimed = 0;
+    for (std::size_t i = 0; i < bt::k_ledger_category_count; ++i) {
+        claimed += ledger_ns(bt::ledger_category_name(static_cast<bt::ledger_category>(i)));
+    }
+    check(claimed == ledger_ns("wall_ns"), "ledger categories should add up to the tick's wall time");
+
+    const std::string stats = string_value(eval_text("(bt.stats inst)", env));
+    check(stats.find("ledger_ticks=1\n") != std::string::npos && stats.find("ledger planner total_ns=") != std::string::npos,
+          "bt.stats should report the rolling ledger");
+    (void)eval_text("(events.enable-tick-audit #f)", env);
 }
 
-void test_bt_compile_checks() {
+void test_node_allocations_are_attributed_to_the_allocating_leaf() {
     using namespace muslisp;
 
     reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
+    host.callbacks().register_action(
+        "test-alloc-three", [](bt::tick_context&, bt::node_id, bt::node_memory&, std::span<const value>) {
+            for (int i = 0; i < 3; ++i) {
+                (void)make_string("allocating leaf");
+            }
+            return bt::status::success;
+        });
     env_ptr env = create_global_env();
-    try {
-        (void)eval_text("(bt.compile '(seq))", env);
-        throw std::runtime_error("expected bt.compile arity check failure");
-    } catch (const lisp_error&) {
-    }
-
-    try {
-        (void)eval_text("(bt.compile '(unknown foo))", env);
-        throw std::runtime_error("expected bt.compile unknown-form failure");
-    } catch (const lisp_error&) {
-    }
-
-    try {
-        (void)eval_text("(bt.compile '(invert (succeed) (fail)))", env);
-        throw std::runtime_error("expected bt.compile invert arity failure");
-    } catch (const lisp_error&) {
-    }
+    (void)eval_text("(events.enable #t)", env);
+    (void)eval_text("(events.enable-tick-audit #t)", env);
+    (void)eval_text("(events.set-ring-size 128)", env);
+    (void)eval_text("(define tree (bt.compile '(seq (act always-success) (act test-alloc-three))))", env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    (void)eval_text("(bt.tick inst)", env);
+    (void)eval_text("(bt.tick inst)", env);
 
-    try {
-        (void)eval_text("(bt.compile '(repeat -1 (succeed)))", env);
-        throw std::runtime_error("expected bt.compile negative repeat count failure");
-    } catch (const lisp_error&) {
-    }
+    const bt::instance* inst = host.find_instance(bt_handle(eval_text("inst", env)));
+    const bt::node_profile_stats& root = inst->node_stats[inst->def->root];
+    check(inst->node_stats[1].alloc_objects == 6, "the allocating leaf should own its six allocations");
+    check(inst->node_stats[1].alloc_bytes > 0, "the allocating leaf should own their bytes");
+    check(inst->node_stats[0].alloc_objects == 0, "a non-allocating leaf should own no allocations");
+    check(root.alloc_objects == 0 && root.alloc_bytes == 0, "the parent should not be charged for its child");
 
-    try {
-        (void)eval_text("(bt.compile '(plan-action :budget_ms))", env);
-        throw std::runtime_error("expected bt.compile plan-action key/value validation failure");
-    } catch (const lisp_error&) {
-    }
+    const std::string stats = string_value(eval_text("(bt.stats inst)", env));
+    check(stats.find("(test-alloc-three) success=2 failure=0 running=0 alloc_objects=6 alloc_bytes=") != std::string::npos,
+          "bt.stats should report per-node allocations");
 
-    try {
-        (void)eval_text("(bt.compile '(vla-request :instruction))", env);
-        throw std::runtime_error("expected bt.compile vla-request key/value validation failure");
-    } catch (const lisp_error&) {
+    bool saw_allocating_node = false;
+    for (const auto& row : vector_from_list(eval_text("(events.dump 80)", env))) {
+        const std::string line = string_value(row);
+        saw_allocating_node = saw_allocating_node ||
+                              (line.find("\"type\":\"tick_audit\"") != std::string::npos &&
+                               line.find("\"allocating_nodes\":[{\"node_id\":1,\"allocation_count\":3,") != std::string::npos);
     }
-
-    (void)eval_text("(bt.compile '(mem-seq (succeed)))", env);
-    (void)eval_text("(bt.compile '(mem-sel (succeed)))", env);
-    (void)eval_text("(bt.compile '(async-seq (succeed)))", env);
-    (void)eval_text("(bt.compile '(reactive-seq (succeed)))", env);
-    (void)eval_text("(bt.compile '(reactive-sel (succeed)))", env);
+    check(saw_allocating_node, "tick_audit should list the nodes that allocated during the tick");
+    (void)eval_text("(events.enable-tick-audit #f)", env);
 }
 
-void test_bt_new_composite_dsl_roundtrip() {
+void test_tick_audit_marks_in_tick_gc_as_violation() {
     using namespace muslisp;
 
     reset_bt_runtime_host();
-    env_ptr env = create_global_env();
-    (void)eval_text(
-        "(define tree "
-        "  (bt.compile "
-        "    '(reactive-sel "
-        "       (reactive-seq (cond always-true) (async-seq (act always-success) (act always-success))) "
-        "       (mem-seq (act always-success) (mem-sel (act always-fail) (succeed))))))",
-        env);
-    value dsl = eval_text("(bt.to-dsl tree)", env);
-    check(is_cons(dsl), "bt.to-dsl should return a list");
-    check(print_value(dsl).find("reactive-sel") != std::string::npos, "dsl should include reactive-sel");
-    check(print_value(dsl).find("mem-seq") != std::string::npos, "dsl should include mem-seq");
-    check(print_value(dsl).find("mem-sel") != std::string::npos, "dsl should include mem-sel");
-    check(print_value(dsl).find("async-seq") != std::string::npos, "dsl should include async-seq");
-    check(print_value(dsl).find("reactive-seq") != std::string::npos, "dsl should include reactive-seq");
+    default_gc().set_policy(gc_policy::default_policy);
+    bt::runtime_host& host = bt::default_runtime_host();
+    host.callbacks().register_action(
+        "test-force-gc",
+        [](bt::tick_context&, bt::node_id, bt::node_memory&, std::span<const muslisp::value>) {
+            muslisp::default_gc().collect();
+            return bt::status::success;
+        });
 
-    const std::filesystem::path dsl_path = temp_file_path("bt_new_nodes", ".lisp");
-    const std::filesystem::path mbt_path = temp_file_path("bt_new_nodes", ".mbt");
-    const std::string dsl_literal = lisp_string_literal(dsl_path.string());
-    const std::string mbt_literal = lisp_string_literal(mbt_path.string());
+    env_ptr env = create_global_env();
+    check(is_nil(eval_text("(events.enable #t)", env)), "events.enable should return nil for in-tick GC audit test");
+    check(is_nil(eval_text("(events.enable-tick-audit #t)", env)),
+          "events.enable-tick-audit should return nil for in-tick GC audit test");
+    check(is_nil(eval_text("(events.set-ring-size 256)", env)), "events.set-ring-size should return nil");
 
-    (void)eval_text("(bt.save-dsl tree " + dsl_literal + ")", env);
-    (void)eval_text("(define tree-from-dsl (bt.load-dsl " + dsl_literal + "))", env);
-    const value dsl_from_dsl = eval_text("(bt.to-dsl tree-from-dsl)", env);
-    check(print_value(dsl_from_dsl) == print_value(dsl), "new nodes should roundtrip through bt.save-dsl/bt.load-dsl");
+    (void)eval_text("(define tree (bt.compile '(seq (act test-force-gc) (succeed))))", env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    check(symbol_name(eval_text("(bt.tick inst)", env)) == "success", "forced-GC tick should complete in default policy");
 
-    (void)eval_text("(bt.save tree " + mbt_literal + ")", env);
-    (void)eval_text("(define tree-from-mbt (bt.load " + mbt_literal + "))", env);
-    const value dsl_from_mbt = eval_text("(bt.to-dsl tree-from-mbt)", env);
-    check(print_value(dsl_from_mbt) == print_value(dsl), "new nodes should roundtrip through bt.save/bt.load");
+    bool saw_gc_begin_in_tick = false;
+    bool saw_gc_end_in_tick = false;
+    bool saw_tick_gc_violation = false;
+    for (const auto& row : vector_from_list(eval_text("(events.dump 120)", env))) {
+        check(is_string(row), "in-tick GC audit rows should be strings");
+        const std::string line = string_value(row);
+        if (line.find("\"type\":\"gc_begin\"") != std::string::npos &&
+            line.find("\"in_tick\":true") != std::string::npos) {
+            saw_gc_begin_in_tick = true;
+        }
+        if (line.find("\"type\":\"gc_end\"") != std::string::npos &&
+            line.find("\"in_tick\":true") != std::string::npos) {
+            saw_gc_end_in_tick = true;
+        }
+        if (line.find("\"type\":\"tick_audit\"") != std::string::npos &&
+            line.find("\"gc_collections_delta\":1") != std::string::npos &&
+            line.find("\"violation\":\"tick_gc\"") != std::string::npos) {
+            saw_tick_gc_violation = true;
+        }
+    }
 
-    std::error_code ec;
-    std::filesystem::remove(dsl_path, ec);
-    std::filesystem::remove(mbt_path, ec);
+    check(saw_gc_begin_in_tick, "forced GC should emit gc_begin with in_tick=true");
+    check(saw_gc_end_in_tick, "forced GC should emit gc_end with in_tick=true");
+    check(saw_tick_gc_violation, "tick_audit should classify in-tick GC as tick_gc violation");
+    default_gc().set_policy(gc_policy::default_policy);
 }
 
-void test_bt_mem_seq_semantics() {
+void test_fail_on_tick_gc_prevents_in_tick_gc_lifecycle() {
     using namespace muslisp;
 
     reset_bt_runtime_host();
+    default_gc().set_policy(gc_policy::default_policy);
     bt::runtime_host& host = bt::default_runtime_host();
-    int setup_calls = 0;
-    int fail_once_calls = 0;
-    int run_then_success_calls = 0;
-
-    host.callbacks().register_action(
-        "test-ms-setup",
-        [&setup_calls](bt::tick_context&, bt::node_id, bt::node_memory&, std::span<const muslisp::value>) {
-            ++setup_calls;
-            return bt::status::success;
-        });
-    host.callbacks().register_action(
-        "test-ms-run-then-success",
-        [&run_then_success_calls](bt::tick_context&, bt::node_id, bt::node_memory& mem, std::span<const muslisp::value>) {
-            ++run_then_success_calls;
-            if (mem.i0 == 0) {
-                mem.i0 = 1;
-                return bt::status::running;
-            }
-            mem.i0 = 0;
-            return bt::status::success;
-        });
     host.callbacks().register_action(
-        "test-ms-fail-once",
-        [&fail_once_calls](bt::tick_context&, bt::node_id, bt::node_memory& mem, std::span<const muslisp::value>) {
-            ++fail_once_calls;
-            if (mem.i0 == 0) {
-                mem.i0 = 1;
-                return bt::status::failure;
-            }
-            mem.i0 = 0;
+        "test-force-gc-strict",
+        [](bt::tick_context&, bt::node_id, bt::node_memory&, std::span<const muslisp::value>) {
+            muslisp::default_gc().collect();
             return bt::status::success;
         });
 
     env_ptr env = create_global_env();
+    check(is_nil(eval_text("(events.enable #t)", env)), "events.enable should return nil for strict GC test");
+    check(is_nil(eval_text("(events.enable-tick-audit #t)", env)),
+          "events.enable-tick-audit should return nil for strict GC test");
+    check(is_nil(eval_text("(events.set-ring-size 256)", env)), "events.set-ring-size should return nil");
+    (void)eval_text("(define tree (bt.compile '(seq (act test-force-gc-strict) (succeed))))", env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
 
-    (void)eval_text("(define tree-a (bt.compile '(mem-seq (act always-success) (act always-success) (act always-success))))", env);
-    (void)eval_text("(define inst-a (bt.new-instance tree-a))", env);
-    check(symbol_name(eval_text("(bt.tick inst-a)", env)) == "success", "mem-seq all-success should succeed");
-    check(symbol_name(eval_text("(bt.tick inst-a)", env)) == "success", "mem-seq should reset after success");
+    default_gc().collect();
+    host.events().clear_ring();
+    default_gc().set_policy(gc_policy::fail_on_tick_gc);
 
-    setup_calls = 0;
-    run_then_success_calls = 0;
-    (void)eval_text(
-        "(define tree-b (bt.compile '(mem-seq (act test-ms-setup) (act test-ms-run-then-success) (act always-success))))",
-        env);
-    (void)eval_text("(define inst-b (bt.new-instance tree-b))", env);
-    check(symbol_name(eval_text("(bt.tick inst-b)", env)) == "running", "mem-seq should return running");
-    check(setup_calls == 1, "mem-seq should tick setup exactly once before running");
-    check(symbol_name(eval_text("(bt.tick inst-b)", env)) == "success", "mem-seq should resume and succeed");
-    check(setup_calls == 1, "mem-seq should resume at running child");
-    check(run_then_success_calls == 2, "mem-seq running child should be revisited");
+    check(symbol_name(eval_text("(bt.tick inst)", env)) == "failure",
+          "fail-on-tick-gc callback error should fail the tick");
+    default_gc().set_policy(gc_policy::default_policy);
 
-    setup_calls = 0;
-    fail_once_calls = 0;
-    (void)eval_text("(define tree-c (bt.compile '(mem-seq (act test-ms-setup) (act test-ms-fail-once) (act always-success))))", env);
-    (void)eval_text("(define inst-c (bt.new-instance tree-c))", env);
-    check(symbol_name(eval_text("(bt.tick inst-c)", env)) == "failure", "mem-seq should fail when child fails");
-    check(symbol_name(eval_text("(bt.tick inst-c)", env)) == "success", "mem-seq should resume failing child next tick");
-    check(setup_calls == 1, "mem-seq should not rerun prior success child after failure");
-    check(fail_once_calls == 2, "mem-seq should retick failing child");
+    bool saw_in_tick_gc_lifecycle = false;
+    bool saw_strict_audit = false;
+    bool saw_gc_contract_error = false;
+    for (const auto& row : vector_from_list(eval_text("(events.dump 120)", env))) {
+        check(is_string(row), "strict GC audit rows should be strings");
+        const std::string line = string_value(row);
+        if ((line.find("\"type\":\"gc_begin\"") != std::string::npos ||
+             line.find("\"type\":\"gc_end\"") != std::string::npos) &&
+            line.find("\"in_tick\":true") != std::string::npos) {
+            saw_in_tick_gc_lifecycle = true;
+        }
+        if (line.find("\"type\":\"tick_audit\"") != std::string::npos &&
+            line.find("\"strict_gc\":true") != std::string::npos &&
+            line.find("\"gc_policy\":\"fail-on-tick-gc\"") != std::string::npos &&
+            line.find("\"gc_collections_delta\":0") != std::string::npos) {
+            saw_strict_audit = true;
+        }
+        if (line.find("\"type\":\"error\"") != std::string::npos &&
+            line.find("forced collection during tick under fail-on-tick-gc policy") != std::string::npos) {
+            saw_gc_contract_error = true;
+        }
+    }
+
+    check(saw_gc_contract_error, "fail-on-tick-gc rejection should be logged as a runtime error");
+    check(!saw_in_tick_gc_lifecycle, "fail-on-tick-gc must prevent in-tick GC lifecycle events");
+    check(saw_strict_audit, "strict GC rejection should still leave a zero-GC tick_audit record");
 }
 
-void test_bt_mem_sel_semantics() {
+void test_strict_gc_representative_ticks_have_zero_gc_delta() {
     using namespace muslisp;
 
     reset_bt_runtime_host();
+    default_gc().set_policy(gc_policy::default_policy);
     bt::runtime_host& host = bt::default_runtime_host();
-    int fail_a_calls = 0;
-    int fail_b_calls = 0;
-    int run_then_success_calls = 0;
-
-    host.callbacks().register_action(
-        "test-msel-fail-a",
-        [&fail_a_calls](bt::tick_context&, bt::node_id, bt::node_memory&, std::span<const muslisp::value>) {
-            ++fail_a_calls;
-            return bt::status::failure;
-        });
-    host.callbacks().register_action(
-        "test-msel-fail-b",
-        [&fail_b_calls](bt::tick_context&, bt::node_id, bt::node_memory&, std::span<const muslisp::value>) {
-            ++fail_b_calls;
-            return bt::status::failure;
-        });
-    host.callbacks().register_action(
-        "test-msel-run-then-success",
-        [&run_then_success_calls](bt::tick_context&, bt::node_id, bt::node_memory& mem, std::span<const muslisp::value>) {
-            ++run_then_success_calls;
-            if (mem.i0 == 0) {
-                mem.i0 = 1;
-                return bt::status::running;
-            }
-            mem.i0 = 0;
-            return bt::status::success;
-        });
-
     env_ptr env = create_global_env();
+    check(is_nil(eval_text("(events.enable #t)", env)), "events.enable should return nil for strict representative test");
+    check(is_nil(eval_text("(events.enable-tick-audit #t)", env)),
+          "events.enable-tick-audit should return nil for strict representative test");
+    check(is_nil(eval_text("(events.set-ring-size 512)", env)), "events.set-ring-size should return nil");
 
+    (void)eval_text("(define seq-tree (bt.compile '(seq (act always-success) (cond always-true) (succeed))))", env);
+    (void)eval_text("(define sel-tree (bt.compile '(sel (cond always-false) (act always-success))))", env);
     (void)eval_text(
-        "(define tree-a (bt.compile '(mem-sel (act test-msel-fail-a) (act test-msel-fail-b) (act test-msel-run-then-success))))",
+        "(define reactive-tree "
+        "  (bt.compile '(reactive-seq (cond always-true) (mem-sel (act always-fail) (act always-success)))))",
         env);
-    (void)eval_text("(define inst-a (bt.new-instance tree-a))", env);
-    check(symbol_name(eval_text("(bt.tick inst-a)", env)) == "running", "mem-sel should run lower-priority child");
-    check(fail_a_calls == 1 && fail_b_calls == 1, "mem-sel should evaluate failed higher priorities once");
-    check(symbol_name(eval_text("(bt.tick inst-a)", env)) == "success", "mem-sel should resume running child");
-    check(fail_a_calls == 1 && fail_b_calls == 1, "mem-sel should not retry earlier failed children while running");
-    check(run_then_success_calls == 2, "mem-sel running child should complete");
+    (void)eval_text("(define seq-inst (bt.new-instance seq-tree))", env);
+    (void)eval_text("(define sel-inst (bt.new-instance sel-tree))", env);
+    (void)eval_text("(define reactive-inst (bt.new-instance reactive-tree))", env);
 
-    fail_a_calls = 0;
-    fail_b_calls = 0;
-    (void)eval_text("(define tree-b (bt.compile '(mem-sel (act test-msel-fail-a) (act test-msel-fail-b))))", env);
-    (void)eval_text("(define inst-b (bt.new-instance tree-b))", env);
-    check(symbol_name(eval_text("(bt.tick inst-b)", env)) == "failure", "mem-sel all-failure should fail");
-    check(symbol_name(eval_text("(bt.tick inst-b)", env)) == "failure", "mem-sel should reset after all-failure");
-    check(fail_a_calls == 2 && fail_b_calls == 2, "mem-sel reset should restart from child 0");
+    default_gc().collect();
+    host.events().clear_ring();
+    default_gc().set_policy(gc_policy::fail_on_tick_gc);
+    check(symbol_name(eval_text("(bt.tick seq-inst)", env)) == "success", "strict seq representative tick should succeed");
+    check(symbol_name(eval_text("(bt.tick sel-inst)", env)) == "success", "strict sel representative tick should succeed");
+    check(symbol_name(eval_text("(bt.tick reactive-inst)", env)) == "success",
+          "strict reactive representative tick should succeed");
+    default_gc().set_policy(gc_policy::default_policy);
+
+    std::size_t audit_count = 0;
+    bool saw_in_tick_gc_lifecycle = false;
+    bool saw_tick_gc_violation = false;
+    bool all_strict_zero_delta = true;
+    for (const auto& row : vector_from_list(eval_text("(events.dump 200)", env))) {
+        check(is_string(row), "strict representative event rows should be strings");
+        const std::string line = string_value(row);
+        if ((line.find("\"type\":\"gc_begin\"") != std::string::npos ||
+             line.find("\"type\":\"gc_end\"") != std::string::npos) &&
+            line.find("\"in_tick\":true") != std::string::npos) {
+            saw_in_tick_gc_lifecycle = true;
+        }
+        if (line.find("\"type\":\"tick_audit\"") == std::string::npos) {
+            continue;
+        }
+        ++audit_count;
+        if (line.find("\"violation\":\"tick_gc\"") != std::string::npos) {
+            saw_tick_gc_violation = true;
+        }
+        all_strict_zero_delta = all_strict_zero_delta &&
+                                line.find("\"strict_gc\":true") != std::string::npos &&
+                                line.find("\"gc_policy\":\"fail-on-tick-gc\"") != std::string::npos &&
+                                line.find("\"gc_collections_delta\":0") != std::string::npos;
+    }
+
+    check(audit_count == 3, "strict representative run should emit one tick_audit per tick");
+    check(!saw_in_tick_gc_lifecycle, "strict representative run should not emit in-tick GC lifecycle events");
+    check(!saw_tick_gc_violation, "strict representative run should not report tick_gc violations");
+    check(all_strict_zero_delta, "strict representative tick_audit rows should report zero GC delta");
 }
 
-void test_bt_async_seq_semantics() {
+void test_bt_tick_with_blackboard_input() {
     using namespace muslisp;
 
     reset_bt_runtime_host();
-    bt::runtime_host& host = bt::default_runtime_host();
-    int first_calls = 0;
-    int second_calls = 0;
+    env_ptr env = create_global_env();
 
-    host.callbacks().register_action(
-        "test-async-seq-first",
-        [&first_calls](bt::tick_context&, bt::node_id, bt::node_memory&, std::span<const muslisp::value>) {
-            ++first_calls;
-            return bt::status::success;
-        });
-    host.callbacks().register_action(
-        "test-async-seq-second",
-        [&second_calls](bt::tick_context&, bt::node_id, bt::node_memory&, std::span<const muslisp::value>) {
-            ++second_calls;
-            return bt::status::success;
+    (void)eval_text("(define tree (bt.compile '(cond bb-has foo)))", env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    check(symbol_name(eval_text("(bt.tick inst)", env)) == "failure", "bb key should not exist before input");
+    check(symbol_name(eval_text("(bt.tick inst '((foo 1)))", env)) == "success", "tick input should seed blackboard");
+}
+
+void test_phase5_ring_buffer_bounds() {
+    bt::trace_buffer trace(3);
+
+    bt::trace_event a{};
+    a.kind = bt::trace_event_kind::tick_begin;
+    trace.push(a);
+    bt::trace_event b{};
+    b.kind = bt::trace_event_kind::node_enter;
+    trace.push(b);
+    bt::trace_event c{};
+    c.kind = bt::trace_event_kind::node_exit;
+    trace.push(c);
+    bt::trace_event d{};
+    d.kind = bt::trace_event_kind::tick_end;
+    trace.push(d);
+
+    const auto trace_events = trace.snapshot();
+    check(trace_events.size() == 3, "trace ring should cap at configured capacity");
+    check(trace_events.front().sequence == 2, "trace ring should evict oldest event first");
+    check(trace_events.back().sequence == 4, "trace ring should keep newest event");
+
+    bt::memory_log_sink logs(2);
+    bt::log_record r1{};
+    r1.message = "one";
+    logs.write(r1);
+    bt::log_record r2{};
+    r2.message = "two";
+    logs.write(r2);
+    bt::log_record r3{};
+    r3.message = "three";
+    logs.write(r3);
+
+    const auto log_records = logs.snapshot();
+    check(log_records.size() == 2, "log ring should cap at configured capacity");
+    check(log_records.front().sequence == 2, "log ring should evict oldest record first");
+    check(log_records.back().sequence == 3, "log ring should keep newest record");
+}
+
+void test_memory_log_sink_deferred_and_rate_limited() {
+    bt::memory_log_sink logs(64);
+    const auto t0 = std::chrono::steady_clock::time_point(std::chrono::seconds(10));
+    bt::log_origin origin{.ts = t0, .level = bt::log_level::info, .tick_index = 4, .node = 7};
+    const std::vector<double> action{0.5, -1.25};
+    const bt::log_arg args[] = {std::string_view("mppi"), action, 0.75, std::int64_t{-3}, std::uint64_t{12}};
+    logs.write_deferred(origin, "planner", "planner={} action={} confidence={} work={} job={} extra={}", args);
+    logs.write_deferred(origin, "bt", "{}", std::span<const bt::log_arg>());
+    const bt::log_arg long_arg[] = {std::string_view(std::string(400, 'x'))};
+    logs.write_deferred(origin, "bt", "long: {}", long_arg);
+
+    std::vector<bt::log_record> records = logs.snapshot();
+    check(records.size() == 3, "deferred log records should be retained");
+    check(records[0].message == "planner=mppi action=0.5,-1.25 confidence=0.75 work=-3 job=12 extra={}",
+          "deferred log message should be formatted on read");
+    check(records[0].category == "planner" && records[0].node == 7 && records[0].tick_index == 4,
+          "deferred log record should keep its origin");
+    check(records[1].message == "{}", "a placeholder without an argument should be kept");
+    const std::size_t cut_size = std::string_view("long: ").size() + bt::memory_log_sink::k_text_bytes_per_record - 2;
+    check(records[2].message.size() == cut_size + 3 && records[2].message.ends_with("xx..."),
+          "text longer than a slot should be cut and marked");
+
+    logs.clear();
+    logs.set_rate_limit(3, std::chrono::seconds(1));
+    int admitted = 0;
+    for (int i = 0; i < 10; ++i) {
+        admitted += logs.admit(origin, "vla") ? 1 : 0;
+    }
+    check(admitted == 3 && logs.suppressed() == 7, "repeated messages beyond the burst should be suppressed");
+    check(logs.admit(bt::log_origin{.ts = t0, .node = 8}, "vla"), "another node should have its own limit");
+    check(logs.snapshot().empty(), "suppressing messages should not write anything yet");
+    origin.ts = t0 + std::chrono::seconds(1);
+    check(logs.admit(origin, "vla"), "a new window should admit messages again");
+    records = logs.snapshot();
+    check(records.size() == 1 && records[0].message == "suppressed 7 repeated log messages" &&
+              records[0].level == bt::log_level::warn && records[0].category == "vla" && records[0].node == 7,
+          "a new window should report the suppressed count");
+
+    bt::memory_log_sink shared(64);
+    std::atomic<bool> writing{true};
+    std::thread reader([&] {
+        while (writing.load()) {
+            const std::vector<bt::log_record> seen = shared.snapshot();
+            for (std::size_t i = 1; i < seen.size(); ++i) {
+                check(seen[i - 1].sequence < seen[i].sequence, "log snapshot should be ordered by sequence");
+            }
+        }
+    });
+    std::vector<std::thread> writers;
+    for (int w = 0; w < 4; ++w) {
+        writers.emplace_back([&shared, w] {
+            for (int i = 0; i < 1000; ++i) {
+                const bt::log_arg arg[] = {std::int64_t{i}};
+                shared.write_deferred(bt::log_origin{.node = static_cast<bt::node_id>(w)}, "w", "i={}", arg);
+            }
         });
+    }
+    for (std::thread& writer : writers) {
+        writer.join();
+    }
+    writing.store(false);
+    reader.join();
+    records = shared.snapshot();
+    check(records.size() == 64 && records.back().sequence == 4000,
+          "concurrent writers should fill the ring without losing the newest records");
+}
 
-    env_ptr env = create_global_env();
-    (void)eval_text("(define tree (bt.compile '(async-seq (act test-async-seq-first) (act test-async-seq-second))))", env);
-    (void)eval_text("(define inst (bt.new-instance tree))", env);
-    check(symbol_name(eval_text("(bt.tick inst)", env)) == "running", "async-seq should yield running between children");
-    check(first_calls == 1, "async-seq first child should run once");
-    check(second_calls == 0, "async-seq should not tick second child on first tick");
-    check(symbol_name(eval_text("(bt.tick inst)", env)) == "success", "async-seq should complete on second tick");
-    check(first_calls == 1, "async-seq should not rerun first child on second tick");
-    check(second_calls == 1, "async-seq should tick second child on resume");
+void test_trace_buffer_formats_blackboard_values_lazily() {
+    bt::trace_buffer trace(8);
+    bt::trace_record rec{};
+    rec.kind = bt::trace_event_kind::bb_write;
+    std::vector<double> samples(64);
+    for (std::size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = static_cast<double>(i) + 0.5;
+    }
+    trace.set_value_preview(3);
+    trace.push_value(rec, "samples", bt::bb_value{bt::bb_vector(samples)});
+    trace.push_value(rec, "short", bt::bb_value{bt::bb_vector{1.0, 2.0}});
+    trace.push_value(rec, "label", bt::bb_value{std::string("abcdef")});
+    trace.push_value(rec, "count", bt::bb_value{std::int64_t{-42}});
+    trace.push_value(rec, "gain", bt::bb_value{0.25});
+    trace.push_value(rec, "flag", bt::bb_value{true});
+    trace.push_value(rec, "frame", bt::bb_value{bt::image_handle_ref{7}});
+    trace.push_value(rec, "none", bt::bb_value{});
+
+    const std::vector<bt::trace_event> events = trace.snapshot();
+    check(events.size() == 8, "every blackboard value record should be retained");
+    check(events[0].key == "samples" && events[0].value_repr == "[0.5,1.5,2.5,...]",
+          "long vectors should decode to a cut preview");
+    check(events[1].value_repr == "[1,2]", "short vectors should decode in full");
+    check(events[2].value_repr == "abc...", "long strings should decode to a cut preview");
+    check(events[3].value_repr == "-42" && events[4].value_repr == "0.25" && events[5].value_repr == "#t",
+          "scalar values should decode like bb_value_repr");
+    check(events[6].value_repr == "image_handle(7)" && events[7].value_repr == "nil",
+          "handles and nil should decode like bb_value_repr");
 }
 
-void test_bt_reactive_preemption_and_memoryless_regressions() {
-    using namespace muslisp;
+void test_trace_buffer_text_ring_and_concurrent_snapshot() {
+    bt::trace_buffer trace(4);
+    bt::trace_record rec{};
+    rec.kind = bt::trace_event_kind::bb_write;
+    for (int i = 0; i < 6; ++i) {
+        rec.node = static_cast<bt::node_id>(i);
+        trace.push(rec, "key" + std::to_string(i), "value", {});
+    }
+    std::vector<bt::trace_event> events = trace.snapshot();
+    check(events.size() == 4 && events.front().sequence == 3 && events.back().sequence == 6,
+          "trace ring should keep the newest records in order");
+    check(events.front().key == "key2" && events.front().value_repr == "value" && events.back().node == 5,
+          "trace records should decode their text and fields");
+
+    const std::string long_text(3 * bt::trace_buffer::k_text_bytes_per_event, 'x');
+    rec.kind = bt::trace_event_kind::error;
+    trace.push(rec, {}, {}, long_text);
+    trace.push(rec, {}, {}, long_text);
+    events = trace.snapshot();
+    check(events.size() == 4 && events[1].key == "<evicted>", "records whose text was overwritten should say so");
+    check(events.back().message == long_text, "the newest record's text should survive");
+
+    const std::string huge_text(8 * bt::trace_buffer::k_text_bytes_per_event, 'y');
+    trace.push(rec, {}, {}, huge_text);
+    check(trace.snapshot().back().message.size() == 4 * bt::trace_buffer::k_text_bytes_per_event,
+          "text longer than the text ring should be cut to fit");
+
+    trace.clear();
+    check(trace.size() == 0 && trace.snapshot().empty(), "clear should drop retained records");
+    trace.push(rec, "k");
+    check(trace.snapshot().size() == 1 && trace.snapshot().front().sequence == 10,
+          "sequence numbers should keep counting across clear");
+
+    bt::trace_buffer shared(64);
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+        bt::trace_record r{};
+        r.kind = bt::trace_event_kind::node_exit;
+        for (std::uint32_t i = 0; i < 200000; ++i) {
+            r.node = i;
+            r.tick_index = i;
+            shared.push(r, "same", std::to_string(i));
+        }
+        done.store(true);
+    });
+    bool consistent = true;
+    while (!done.load()) {
+        for (const bt::trace_event& ev : shared.snapshot()) {
+            consistent = consistent && ev.node == ev.tick_index && ev.sequence == ev.node + 1u &&
+                         (ev.value_repr == "<evicted>" || ev.value_repr == std::to_string(ev.node));
+        }
+    }
+    writer.join();
+    check(consistent, "snapshots taken during pushes should only return whole records");
+}
 
-    reset_bt_runtime_host();
-    bt::runtime_host& host = bt::default_runtime_host();
-    int seq_setup_calls = 0;
-    int sel_fail_calls = 0;
+void test_event_log_deterministic_mode_and_canonical_serialisation() {
+    bt::event_log events(16);
+    events.set_run_id("fixture-run");
+    events.set_deterministic_time(1735689600000, 3);
 
-    host.callbacks().register_action(
-        "test-seq-setup",
-        [&seq_setup_calls](bt::tick_context&, bt::node_id, bt::node_memory&, std::span<const muslisp::value>) {
-            ++seq_setup_calls;
-            return bt::status::success;
-        });
-    host.callbacks().register_action(
-        "test-sel-fail",
-        [&sel_fail_calls](bt::tick_context&, bt::node_id, bt::node_memory&, std::span<const muslisp::value>) {
-            ++sel_fail_calls;
-            return bt::status::failure;
-        });
-    host.callbacks().register_condition("test-gate",
-                                        [](bt::tick_context& ctx, std::span<const muslisp::value>) -> bool {
-                                            const bt::bb_entry* entry = ctx.bb_get("gate");
-                                            if (!entry) {
-                                                return false;
-                                            }
-                                            if (const bool* b = std::get_if<bool>(&entry->value)) {
-                                                return *b;
-                                            }
-                                            return false;
-                                        });
-    host.callbacks().register_condition("test-high-priority",
-                                        [](bt::tick_context& ctx, std::span<const muslisp::value>) -> bool {
-                                            const bt::bb_entry* entry = ctx.bb_get("high");
-                                            if (!entry) {
-                                                return false;
-                                            }
-                                            if (const bool* b = std::get_if<bool>(&entry->value)) {
-                                                return *b;
-                                            }
-                                            return false;
-                                        });
+    std::vector<std::string> callback_lines;
+    events.set_line_listener([&callback_lines](const std::string& line) { callback_lines.push_back(line); });
 
-    env_ptr env = create_global_env();
+    const std::uint64_t seq1 = events.emit("tick_begin", 1, "{\"root\":1}");
+    const std::uint64_t seq2 = events.emit("tick_end", 1, "{\"status\":\"success\"}");
+    check(seq1 == 1, "event log should start sequence at 1 after set_run_id");
+    check(seq2 == 2, "event log should increment sequence for each event");
+    check(callback_lines.size() == 2, "line listener should receive canonical line for each event");
 
-    (void)eval_text("(define seq-tree (bt.compile '(seq (act test-seq-setup) (act running-then-success))))", env);
-    (void)eval_text("(define seq-inst (bt.new-instance seq-tree))", env);
-    check(symbol_name(eval_text("(bt.tick seq-inst)", env)) == "running", "seq tick1 should be running");
-    check(symbol_name(eval_text("(bt.tick seq-inst)", env)) == "success", "seq tick2 should succeed");
-    check(seq_setup_calls == 2, "seq should remain memoryless and restart from child 0");
+    const std::string expected_first = bt::event_log::serialise_event_line(
+        "tick_begin", "fixture-run", 1735689600000, 1, 1, "{\"root\":1}");
+    const std::string expected_second = bt::event_log::serialise_event_line(
+        "tick_end", "fixture-run", 1735689600003, 2, 1, "{\"status\":\"success\"}");
+    check(callback_lines[0] == expected_first, "line listener should receive canonical serialised tick_begin line");
+    check(callback_lines[1] == expected_second, "line listener should receive canonical serialised tick_end line");
 
-    (void)eval_text("(define sel-tree (bt.compile '(sel (act test-sel-fail) (act running-then-success))))", env);
-    (void)eval_text("(define sel-inst (bt.new-instance sel-tree))", env);
-    check(symbol_name(eval_text("(bt.tick sel-inst)", env)) == "running", "sel tick1 should be running");
-    check(symbol_name(eval_text("(bt.tick sel-inst)", env)) == "success", "sel tick2 should succeed");
-    check(sel_fail_calls == 2, "sel should remain memoryless and retry first child");
+    const auto ring = events.snapshot();
+    check(ring.size() == 2, "event ring should contain emitted events");
+    check(ring == callback_lines, "event ring and callback lines should match canonical serialisation");
+}
 
-    (void)eval_text("(define rseq-tree (bt.compile '(reactive-seq (cond test-gate) (act async-sleep-ms 200))))", env);
-    (void)eval_text("(define rseq-inst (bt.new-instance rseq-tree))", env);
-    check(symbol_name(eval_text("(bt.tick rseq-inst '((gate #t)))", env)) == "running", "reactive-seq tick1 should run");
-    check(symbol_name(eval_text("(bt.tick rseq-inst '((gate #f)))", env)) == "failure",
-          "reactive-seq tick2 should fail and preempt");
+void test_event_log_structured_emit_matches_string_emit() {
+    bt::json_writer& writer = bt::event_log::payload_writer();
+    writer.begin_object()
+        .field("name", "a\"b\n")
+        .field("count", std::uint32_t{7})
+        .field("delta", std::int64_t{-3})
+        .field("ratio", 0.25)
+        .field("missing", std::numeric_limits<double>::quiet_NaN())
+        .field("ok", true)
+        .key("path")
+        .begin_array()
+        .value(1)
+        .value(2)
+        .begin_object()
+        .end_object()
+        .end_array()
+        .key("nested")
+        .begin_object()
+        .field("status", "running")
+        .end_object()
+        .end_object();
+    const std::string expected =
+        "{\"name\":\"a\\\"b\\n\",\"count\":7,\"delta\":-3,\"ratio\":0.25,\"missing\":null,\"ok\":true,"
+        "\"path\":[1,2,{}],\"nested\":{\"status\":\"running\"}}";
+    check(std::string(writer.view()) == expected, "json_writer should place separators and escape strings");
+
+    bt::event_log structured(2);
+    bt::event_log plain(2);
+    for (bt::event_log* events : {&structured, &plain}) {
+        events->set_run_id("structured-run");
+        events->set_deterministic_time(1735689604000, 1);
+    }
+    for (std::uint64_t tick = 1; tick <= 3; ++tick) {
+        bt::json_writer& data = bt::event_log::payload_writer();
+        data.begin_object().field("tick", tick).end_object();
+        (void)structured.emit("tick_end", tick, data);
+        (void)plain.emit("tick_end", tick, "{\"tick\":" + std::to_string(tick) + "}");
+    }
+    const std::vector<std::string> lines = structured.snapshot();
+    check(lines == plain.snapshot(), "structured emit should serialise the same line as string emit");
+    check(lines.size() == 2 && lines[1].find("\"seq\":3") != std::string::npos,
+          "ring-only structured emit should write the newest line into the oldest slot");
+}
 
-    (void)eval_text("(define rsel-tree (bt.compile '(reactive-sel (cond test-high-priority) (act async-sleep-ms 200))))", env);
-    (void)eval_text("(define rsel-inst (bt.new-instance rsel-tree))", env);
-    check(symbol_name(eval_text("(bt.tick rsel-inst '((high #f)))", env)) == "running",
-          "reactive-sel tick1 should run low-priority child");
-    check(symbol_name(eval_text("(bt.tick rsel-inst '((high #t)))", env)) == "success",
-          "reactive-sel tick2 should switch to high-priority success");
+void test_event_log_capture_stats_without_serialised_sink() {
+    bt::event_log events(0);
+    events.set_run_id("stats-run");
+    events.set_deterministic_time(1735689602000, 5);
+    events.set_capture_stats_enabled(true);
+
+    const std::string payload = "{\"node_id\":7}";
+    const std::uint64_t seq = events.emit("node_enter", 4, payload);
+    check(seq == 1, "capture stats path should still advance event sequence");
+
+    const bt::event_log_stats stats = events.capture_stats();
+    check(stats.event_count == 1, "capture stats should count emitted events");
+    const std::size_t expected_size =
+        bt::event_log::serialise_event_line("node_enter", "stats-run", 1735689602000, 1, 4, payload).size();
+    check(stats.byte_count == expected_size, "capture stats should match canonical serialised line size");
+    check(events.snapshot().empty(), "zero-capacity ring should not retain canonical lines");
 }
 
-void test_bt_seq_and_running_semantics() {
-    using namespace muslisp;
+void test_event_log_file_sink_reuses_stream_and_reopens_on_path_change() {
+    const std::filesystem::path first_path = temp_file_path("event_log_first", ".jsonl");
+    const std::filesystem::path second_path = temp_file_path("event_log_second", ".jsonl");
 
-    reset_bt_runtime_host();
-    env_ptr env = create_global_env();
+    bt::event_log events(0);
+    events.set_run_id("file-run");
+    events.set_deterministic_time(1735689603000, 1);
+    events.set_path(first_path.string());
+    events.set_file_enabled(true);
+    events.set_flush_on_tick_end(false);
+    events.set_flush_each_message(true);
 
-    (void)eval_text("(define tree (bt.compile '(seq (cond always-true) (act running-then-success))))", env);
-    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    (void)events.emit("tick_begin", 1, "{\"status\":\"one\"}");
+    {
+        std::ifstream in(first_path);
+        check(in.good(), "expected flushed event log file to exist after first write");
+        std::string first_line;
+        std::getline(in, first_line);
+        check(first_line.find("\"status\":\"one\"") != std::string::npos,
+              "flush-each-message should make the first event visible immediately");
+    }
+    (void)events.emit("tick_end", 1, "{\"status\":\"two\"}");
 
-    value first = eval_text("(bt.tick inst)", env);
-    check(is_symbol(first) && symbol_name(first) == "running", "first tick should be running");
+    events.set_path(second_path.string());
+    (void)events.emit("tick_end", 2, "{\"status\":\"three\"}");
+    events.set_file_enabled(false);
+    (void)events.emit("tick_end", 3, "{\"status\":\"four\"}");
 
-    value second = eval_text("(bt.tick inst)", env);
-    check(is_symbol(second) && symbol_name(second) == "success", "second tick should be success");
-}
+    auto read_lines = [](const std::filesystem::path& path) {
+        std::ifstream in(path);
+        check(in.good(), "expected event log file to exist: " + path.string());
+        std::vector<std::string> lines;
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!line.empty()) {
+                lines.push_back(line);
+            }
+        }
+        return lines;
+    };
 
-void test_bt_decorator_semantics() {
-    using namespace muslisp;
+    const auto first_lines = read_lines(first_path);
+    const auto second_lines = read_lines(second_path);
 
-    reset_bt_runtime_host();
-    env_ptr env = create_global_env();
+    check(first_lines.size() == 2, "first event log file should contain two events");
+    check(second_lines.size() == 1, "second event log file should contain one event");
+    check(first_lines[0].find("\"status\":\"one\"") != std::string::npos, "first file first event mismatch");
+    check(first_lines[1].find("\"status\":\"two\"") != std::string::npos, "first file second event mismatch");
+    check(second_lines[0].find("\"status\":\"three\"") != std::string::npos, "second file event mismatch");
+    check(second_lines[0].find("\"status\":\"four\"") == std::string::npos,
+          "disabled file logging should not append further events");
 
-    (void)eval_text("(define invert-tree (bt.compile '(invert (cond always-false))))", env);
-    (void)eval_text("(define invert-inst (bt.new-instance invert-tree))", env);
-    check(symbol_name(eval_text("(bt.tick invert-inst)", env)) == "success", "invert should flip failure to success");
+    std::error_code ec;
+    std::filesystem::remove(first_path, ec);
+    std::filesystem::remove(second_path, ec);
+}
 
-    (void)eval_text("(define invert-running-tree (bt.compile '(invert (running))))", env);
-    (void)eval_text("(define invert-running-inst (bt.new-instance invert-running-tree))", env);
-    check(symbol_name(eval_text("(bt.tick invert-running-inst)", env)) == "running",
-          "invert should leave running unchanged");
+void test_event_log_async_file_sink_writes_or_counts_every_line() {
+    const std::filesystem::path first_path = temp_file_path("event_log_async_first", ".jsonl");
+    const std::filesystem::path second_path = temp_file_path("event_log_async_second", ".jsonl");
+    auto read_lines = [](const std::filesystem::path& path) {
+        std::ifstream in(path);
+        std::vector<std::string> lines;
+        std::string line;
+        while (std::getline(in, line)) {
+            lines.push_back(line);
+        }
+        return lines;
+    };
 
-    (void)eval_text("(define rtree (bt.compile '(repeat 3 (act always-success))))", env);
-    (void)eval_text("(define rinst (bt.new-instance rtree))", env);
-    check(symbol_name(eval_text("(bt.tick rinst)", env)) == "running", "repeat tick1 should be running");
-    check(symbol_name(eval_text("(bt.tick rinst)", env)) == "running", "repeat tick2 should be running");
-    check(symbol_name(eval_text("(bt.tick rinst)", env)) == "success", "repeat tick3 should be success");
+    bt::event_log events(0);
+    events.set_run_id("async-run");
+    events.set_deterministic_time(1735689605000, 1);
+    events.set_path(first_path.string());
+    events.set_file_enabled(true);
+    (void)events.emit("tick_begin", 1, "{\"status\":\"sync\"}");
+    events.set_file_async(true, 64);
+    check(events.file_async(), "event log should report the async file sink as enabled");
+    for (std::uint64_t tick = 1; tick <= 50; ++tick) {
+        (void)events.emit("tick_end", tick, "{\"status\":\"async\"}");
+    }
+    events.drain_file_async();
+    std::vector<std::string> lines = read_lines(first_path);
+    check(lines.size() == 51 && lines[0].find("\"status\":\"sync\"") != std::string::npos,
+          "lines buffered before switching to the async sink should be written first");
+    check(lines.back().find("\"seq\":51") != std::string::npos, "async sink should write lines in emit order");
+    check(events.capture_stats().dropped_line_count == 0, "a queue larger than the burst should drop nothing");
 
-    (void)eval_text("(define retry-tree (bt.compile '(retry 2 (act always-fail))))", env);
-    (void)eval_text("(define retry-inst (bt.new-instance retry-tree))", env);
-    check(symbol_name(eval_text("(bt.tick retry-inst)", env)) == "running", "retry tick1 should be running");
-    check(symbol_name(eval_text("(bt.tick retry-inst)", env)) == "running", "retry tick2 should be running");
-    check(symbol_name(eval_text("(bt.tick retry-inst)", env)) == "failure", "retry tick3 should be failure");
+    events.set_path(second_path.string());
+    events.set_file_async(true, 1);
+    events.clear_capture_stats();
+    constexpr std::uint64_t kBurst = 5000;
+    for (std::uint64_t tick = 1; tick <= kBurst; ++tick) {
+        (void)events.emit("tick_end", tick, "{}");
+    }
+    events.set_file_async(false);
+    lines = read_lines(second_path);
+    check(lines.size() + events.capture_stats().dropped_line_count == kBurst,
+          "every async line should be either written or counted as dropped");
+    auto seq_of = [](const std::string& line) {
+        const std::size_t at = line.find("\"seq\":");
+        return at == std::string::npos ? 0ull : std::stoull(line.substr(at + 6));
+    };
+    for (std::size_t i = 1; i < lines.size(); ++i) {
+        check(seq_of(lines[i - 1]) < seq_of(lines[i]), "lines that survive a full queue should stay in emit order");
+    }
+
+    std::error_code ec;
+    std::filesystem::remove(first_path, ec);
+    std::filesystem::remove(second_path, ec);
 }
 
-void test_bt_reset_clears_phase4_state() {
+void test_event_log_net_sink_streams_frames_and_counts_drops() {
+#if !defined(_WIN32)
     using namespace muslisp;
 
+    const int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    check(listener >= 0, "collector socket should open");
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    check(::bind(listener, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0, "collector should bind");
+    check(::listen(listener, 1) == 0, "collector should listen");
+    socklen_t addr_len = sizeof(addr);
+    check(::getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &addr_len) == 0, "collector port");
+    const std::string endpoint = "tcp://127.0.0.1:" + std::to_string(ntohs(addr.sin_port));
+
+    bt::event_log events(0);
+    events.set_run_id("net-run");
+    events.set_deterministic_time(1735689605000, 1);
+    bt::net_sink_options options;
+    options.endpoint = endpoint;
+    options.batch_bytes = 512;
+    options.batch_interval = std::chrono::milliseconds(5);
+    options.compress = false;
+    events.set_net_sink(options);
+    const int conn = ::accept(listener, nullptr, nullptr);
+    check(conn >= 0, "the sink should connect to the collector");
+    timeval recv_timeout{2, 0};
+    (void)::setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &recv_timeout, sizeof(recv_timeout));
+
+    constexpr std::uint64_t kLines = 200;
+    for (std::uint64_t tick = 1; tick <= kLines; ++tick) {
+        (void)events.emit("tick_end", tick, "{\"status\":\"net\"}");
+    }
+    check(events.flush_net_sink(std::chrono::seconds(2)), "a connected sink should deliver every line");
+
+    auto recv_exact = [&](std::string& out, std::size_t size) {
+        out.resize(size);
+        std::size_t got = 0;
+        while (got < size) {
+            const ssize_t n = ::recv(conn, out.data() + got, size - got, 0);
+            check(n > 0, "collector should receive the whole frame");
+            got += static_cast<std::size_t>(n);
+        }
+    };
+    auto le = [](const std::string& bytes, std::size_t at, int width) {
+        std::uint64_t v = 0;
+        for (int i = width - 1; i >= 0; --i) {
+            v = (v << 8) | static_cast<unsigned char>(bytes[at + static_cast<std::size_t>(i)]);
+        }
+        return v;
+    };
+    std::vector<std::string> lines;
+    std::uint64_t frames = 0;
+    std::string header;
+    std::string payload;
+    while (lines.size() < kLines) {
+        recv_exact(header, bt::net_event_sink::k_frame_header_bytes);
+        check(header.compare(0, 4, "MBTN") == 0 && header[4] == 1, "frame header should carry magic and version");
+        check(header[5] == bt::net_event_sink::k_codec_raw, "compression was turned off");
+        check(le(header, 8, 8) == frames, "frame seq should count from 0 without gaps");
+        check(le(header, 32, 8) == 0, "nothing should have been dropped");
+        const std::uint64_t count = le(header, 16, 4);
+        recv_exact(payload, static_cast<std::size_t>(le(header, 24, 4)));
+        check(payload.size() == le(header, 20, 4), "raw frames should carry their raw size");
+        std::istringstream in(payload);
+        for (std::string line; std::getline(in, line);) {
+            lines.push_back(line);
+        }
+        check(lines.size() <= kLines && count != 0, "frames should hold whole lines");
+        ++frames;
+    }
+    check(frames > 1, "512-byte batches should split 200 lines into several frames");
+    for (std::uint64_t i = 0; i < kLines; ++i) {
+        check(lines[i].find("\"seq\":" + std::to_string(i + 1) + ",") != std::string::npos,
+              "lines should arrive in emit order");
+    }
+    std::optional<bt::net_sink_stats> stats = events.net_stats();
+    check(stats && stats->connected && stats->lines_sent == kLines && stats->frames_sent == frames &&
+              stats->dropped_lines() == 0,
+          "stats should count every delivered line and frame");
+    events.close_net_sink();
+    check(!events.net_stats(), "closing the sink should drop its stats");
+    ::close(conn);
+    ::close(listener);
+
+    // Nobody listens any more: frames pile up against the buffer bound and the policy sheds them.
+    auto wait_for = [](const std::function<bool()>& done) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (!done() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return done();
+    };
+    options.batch_bytes = 128;
+    options.max_buffered_bytes = 1024;
+    options.reconnect_interval = std::chrono::milliseconds(1000);
+    events.set_net_sink(options);
+    for (std::uint64_t tick = 1; tick <= 500; ++tick) {
+        (void)events.emit("tick_end", tick, "{\"status\":\"offline\"}");
+    }
+    check(wait_for([&] { return events.net_stats()->dropped_overflow > 0; }),
+          "drop_oldest should discard frames past the buffer bound");
+    stats = events.net_stats();
+    check(stats->buffered_bytes <= options.max_buffered_bytes && stats->lines_sent == 0,
+          "the backlog should stay within its bound");
+
+    options.overflow = bt::net_overflow_policy::sample;
+    options.sample_every = 4;
+    events.set_net_sink(options);
+    for (std::uint64_t tick = 1; tick <= 500; ++tick) {
+        (void)events.emit("tick_end", tick, "{\"status\":\"offline\"}");
+    }
+    check(wait_for([&] { return events.net_stats()->dropped_sampled > 0; }),
+          "sample should thin lines once the backlog nears its bound");
+    check(events.net_stats()->sampling, "the sink should report that it is sampling");
+    events.close_net_sink();
+
     reset_bt_runtime_host();
     env_ptr env = create_global_env();
-
-    (void)eval_text("(define rtree (bt.compile '(repeat 2 (act always-success))))", env);
-    (void)eval_text("(define rinst (bt.new-instance rtree))", env);
-    check(symbol_name(eval_text("(bt.tick rinst)", env)) == "running", "repeat pre-reset tick should be running");
-    check(is_nil(eval_text("(bt.reset rinst)", env)), "bt.reset should return nil");
-    check(symbol_name(eval_text("(bt.tick rinst)", env)) == "running", "repeat should restart after reset");
-    check(symbol_name(eval_text("(bt.tick rinst)", env)) == "success", "repeat should complete after restart");
-
-    (void)eval_text("(define btree (bt.compile '(cond bb-has foo)))", env);
-    (void)eval_text("(define binst (bt.new-instance btree))", env);
-    check(symbol_name(eval_text("(bt.tick binst '((foo 1)))", env)) == "success",
-          "tick input should make bb-has succeed");
-    (void)eval_text("(bt.reset binst)", env);
-    check(symbol_name(eval_text("(bt.tick binst)", env)) == "failure", "reset should clear blackboard entries");
+    check(is_nil(eval_text("(events.net-stats)", env)), "events.net-stats should be nil without a sink");
+    expect_lisp_error_message("(events.set-net-sink \"udp://127.0.0.1:9\")",
+                              env,
+                              "events.set-net-sink: net_event_sink: endpoint must look like tcp://host:port",
+                              "events.set-net-sink endpoint");
+    (void)eval_text("(define net-opts (map.make))", env);
+    (void)eval_text("(map.set! net-opts 'overflow 'newest)", env);
+    expect_lisp_error_message("(events.set-net-sink \"tcp://127.0.0.1:9\" net-opts)",
+                              env,
+                              "events.set-net-sink: overflow must be drop-oldest or sample",
+                              "events.set-net-sink overflow");
+    (void)eval_text("(map.set! net-opts 'overflow 'sample)", env);
+    (void)eval_text("(map.set! net-opts 'batch-ms 10)", env);
+    (void)eval_text("(events.set-net-sink \"tcp://127.0.0.1:9\" net-opts)", env);
+    check(is_map(eval_text("(events.net-stats)", env)), "events.net-stats should report an open sink");
+    (void)eval_text("(events.set-net-sink nil)", env);
+    check(is_nil(eval_text("(events.net-stats)", env)), "events.set-net-sink nil should close the sink");
+#endif
 }
 
-void test_bt_blackboard_events_and_stats_builtins() {
-    using namespace muslisp;
+void test_event_log_binary_sink_transcodes_to_identical_jsonl() {
+    const std::filesystem::path jsonl_path = temp_file_path("event_log_binary", ".jsonl");
+    const std::filesystem::path binary_path = temp_file_path("event_log_binary", ".mbtb");
+    auto read_bytes = [](const std::filesystem::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    };
 
-    reset_bt_runtime_host();
-    env_ptr env = create_global_env();
+    bt::event_log events(0);
+    events.set_run_id("binary-run");
+    events.set_deterministic_time(1735689605000, 3);
+    events.set_path(jsonl_path.string());
+    events.set_file_enabled(true);
+    events.set_binary_path(binary_path.string());
+    check(events.binary_path() == binary_path.string(), "event log should report the binary sink path");
+
+    (void)events.emit("run_start", std::nullopt, "{\"tick_hz\":20.0,\"host\":\"h-01\"}");
+    for (std::uint64_t tick = 1; tick <= 200; ++tick) {
+        (void)events.emit("tick_begin", tick, "{\"root\":1}");
+        const std::string node_exit = "{\"node_id\":" + std::to_string(tick % 7) + ",\"dur_ms\":" +
+                                      std::to_string(tick * 3) + ",\"status\":\"running\"}";
+        (void)events.emit("node_exit", tick, node_exit);
+        (void)events.emit("tick_end", tick, "{\"status\":\"success\",\"tick_ms\":0.125,\"skew\":-3}");
+    }
+    (void)events.emit("error", std::nullopt, "{\"message\":\"tab\\there \\u0001 1e3\",\"values\":[1e3,-0,18446744073709551615]}");
+    events.set_binary_path("");
+    events.set_file_enabled(false);
+    check(events.binary_path().empty(), "an empty path should close the binary sink");
 
-    (void)eval_text("(define tree (bt.compile '(seq (act bb-put-int foo 42) (cond bb-has foo))))", env);
-    (void)eval_text("(define inst (bt.new-instance tree))", env);
-    check(symbol_name(eval_text("(bt.tick inst)", env)) == "success", "bb tree should tick to success");
+    const std::string jsonl = read_bytes(jsonl_path);
+    const std::string binary = read_bytes(binary_path);
+    check(!jsonl.empty() && bt::transcode_event_binary_to_jsonl(binary) == jsonl,
+          "binary event stream should transcode to byte-identical JSONL");
+    check(binary.size() * 4 < jsonl.size(), "binary event stream should be much smaller than JSONL");
 
-    value bb_dump = eval_text("(bt.blackboard.dump inst)", env);
-    check(is_string(bb_dump), "bt.blackboard.dump should return string");
-    check(string_value(bb_dump).find("foo=42") != std::string::npos, "blackboard dump missing foo=42");
-    check(string_value(bb_dump).find("type=int64") != std::string::npos, "blackboard dump missing type metadata");
-    check(string_value(bb_dump).find("ts_ns=") != std::string::npos, "blackboard dump missing timestamp metadata");
-    check(string_value(bb_dump).find("writer_name=bb-put-int") != std::string::npos,
-          "blackboard dump missing writer metadata");
+    bool threw = false;
+    try {
+        (void)bt::transcode_event_binary_to_jsonl(std::string_view(binary).substr(0, binary.size() - 1));
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    check(threw, "a truncated binary event stream should be rejected");
 
-    value events_dump = eval_text("(events.dump 40)", env);
-    check(is_proper_list(events_dump), "events.dump should return list");
-    bool saw_tick_begin = false;
-    bool saw_node_status = false;
-    bool saw_bb_write = false;
-    bool saw_tick_end = false;
-    for (const value& row : vector_from_list(events_dump)) {
-        if (!is_string(row)) {
-            continue;
+    std::error_code ec;
+    std::filesystem::remove(jsonl_path, ec);
+    std::filesystem::remove(binary_path, ec);
+}
+
+void test_event_log_index_sidecar_and_rotation() {
+    const std::filesystem::path base = temp_file_path("event_log_index", ".jsonl");
+    auto read_lines = [](const std::filesystem::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        std::vector<std::string> lines;
+        for (std::string line; std::getline(in, line);) {
+            lines.push_back(line);
         }
-        const std::string line = string_value(row);
-        if (line.find("\"type\":\"tick_begin\"") != std::string::npos) {
-            saw_tick_begin = true;
+        return lines;
+    };
+
+    bt::event_log events(0);
+    events.set_run_id("index-run");
+    events.set_deterministic_time(1735689605000, 1);
+    events.set_path(base.string());
+    events.set_file_layout(bt::event_file_layout{.index_every = 4, .rotate_bytes = 6000});
+    events.set_file_enabled(true);
+    bool threw = false;
+    try {
+        events.set_file_async(true);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    check(threw, "the asynchronous sink should refuse an active file layout");
+
+    (void)events.emit("run_start", std::nullopt, "{\"tick_hz\":20.0}");
+    for (std::uint64_t tick = 1; tick <= 120; ++tick) {
+        (void)events.emit("tick_begin", tick, "{\"root\":1}");
+        (void)events.emit("node_exit", tick, "{\"node_id\":3,\"status\":\"running\"}");
+        (void)events.emit("tick_end", tick, "{\"status\":\"running\"}");
+    }
+    check(events.file_segment_path() != base.string(), "a long run should have rotated past the first segment");
+    events.set_file_enabled(false);
+
+    std::size_t segments = 0;
+    std::uint64_t total_events = 0;
+    std::uint64_t next_seq = 1;
+    for (std::uint64_t k = 0;; ++k) {
+        std::filesystem::path segment = base;
+        if (k != 0) {
+            segment = base.parent_path() / (base.stem().string() + "." + std::to_string(k) + base.extension().string());
         }
-        if (line.find("\"type\":\"node_status\"") != std::string::npos) {
-            saw_node_status = true;
+        if (!std::filesystem::exists(segment)) {
+            break;
         }
-        if (line.find("\"type\":\"bb_write\"") != std::string::npos) {
-            saw_bb_write = true;
+        ++segments;
+        std::ifstream raw(segment, std::ios::binary);
+        const std::string bytes((std::istreambuf_iterator<char>(raw)), std::istreambuf_iterator<char>());
+        const std::vector<std::string> lines = read_lines(segment);
+        check(bytes.size() <= 6000, "segments should respect the size limit");
+        check(lines.front().find("\"type\":\"run_start\",\"run_id\":\"index-run\"") != std::string::npos,
+              "every segment should start with the run_start line");
+
+        const std::vector<std::string> index = read_lines(segment.string() + ".idx");
+        check(index.size() >= 3 && index.front() == "{\"schema\":\"mbt.evt.idx.v1\",\"segment\":\"" +
+                                                        segment.filename().string() + "\",\"segment_index\":" +
+                                                        std::to_string(k) + ",\"index_every\":4}",
+              "sidecar should start with a header naming its segment");
+        std::size_t entries = 0;
+        for (std::size_t i = 1; i + 1 < index.size(); ++i) {
+            unsigned long long seq = 0;
+            unsigned long long offset = 0;
+            check(std::sscanf(index[i].c_str(), "{\"seq\":%llu,\"offset\":%llu", &seq, &offset) == 2,
+                  "index entries should carry seq and offset");
+            const std::size_t end = bytes.find('\n', offset);
+            check((offset == 0 || bytes[offset - 1] == '\n') &&
+                      bytes.substr(offset, end - offset).find(",\"seq\":" + std::to_string(seq) + ",") != std::string::npos,
+                  "index offsets should point at the start of the indexed event");
+            check(k == 0 || i != 1 || index[i].find("\"tick\":") != std::string::npos,
+                  "the first entry of a later segment should carry the tick reached so far");
+            ++entries;
         }
-        if (line.find("\"type\":\"tick_end\"") != std::string::npos) {
-            saw_tick_end = true;
+        check(entries == (lines.size() + 3) / 4, "every fourth event should be indexed");
+        check(index.back().starts_with("{\"events\":" + std::to_string(lines.size()) +
+                                       ",\"bytes\":" + std::to_string(bytes.size()) + ",\"counts\":{"),
+              "sidecar should end with the segment's event and byte counts");
+        check(index.back().find("\"run_start\":1") != std::string::npos, "counts should include the run_start copy");
+
+        for (std::size_t i = k == 0 ? 0 : 1; i < lines.size(); ++i) {
+            check(lines[i].find(",\"seq\":" + std::to_string(next_seq) + ",") != std::string::npos,
+                  "segments should hold the event stream in order without gaps");
+            ++next_seq;
         }
+        total_events += lines.size() - (k == 0 ? 0 : 1);
+        std::error_code ec;
+        std::filesystem::remove(segment, ec);
+        std::filesystem::remove(segment.string() + ".idx", ec);
     }
-    check(saw_tick_begin, "events should include tick_begin");
-    check(saw_node_status, "events should include node_status");
-    check(saw_bb_write, "events should include bb_write");
-    check(saw_tick_end, "events should include tick_end");
+    check(segments > 2 && total_events == 361, "rotation should split the run across segments");
+}
 
-    value stats_dump = eval_text("(bt.stats inst)", env);
-    check(is_string(stats_dump), "bt.stats should return string");
-    check(string_value(stats_dump).find("tick_count=1") != std::string::npos, "stats should include tick_count=1");
+void test_event_log_validator_streams_chunks() {
+    const bt::event_schema schema = bt::event_schema::parse(R"({
+        "type": "object",
+        "required": ["schema", "type", "seq"],
+        "properties": {
+            "schema": {"const": "mbt.evt.v1"},
+            "type": {"type": "string", "minLength": 1},
+            "seq": {"type": "integer", "minimum": 1},
+            "tick": {"type": "integer", "minimum": 0},
+            "data": {"type": "object"}
+        },
+        "additionalProperties": false
+    })");
+    bool threw = false;
+    try {
+        (void)bt::event_schema::parse(R"({"type": "string", "pattern": "^a"})");
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    check(threw, "unsupported schema keywords should be rejected at load time");
+
+    auto make_log = [](std::uint64_t ticks) {
+        std::string out;
+        std::uint64_t seq = 0;
+        auto line = [&](std::string_view type, std::uint64_t tick, std::string_view data) {
+            out += "{\"schema\":\"mbt.evt.v1\",\"type\":\"" + std::string(type) + "\",\"seq\":" +
+                   std::to_string(++seq) + ",\"tick\":" + std::to_string(tick) + ",\"data\":" + std::string(data) +
+                   "}\n";
+        };
+        for (std::uint64_t tick = 1; tick <= ticks; ++tick) {
+            line("tick_begin", tick, "{}");
+            line("node_exit", tick, "{\"node_id\":2,\"status\":\"success\"}");
+            line("tick_end", tick, "{\"tick_budget_ms\":10.0,\"tick_time_ms\":1.5}");
+        }
+        return out;
+    };
 
-    (void)eval_text("(bt.set-tick-budget-ms inst 1)", env);
-    (void)eval_text("(bt.tick inst)", env);
-    events_dump = eval_text("(events.dump 80)", env);
-    check(is_proper_list(events_dump), "events.dump should return list after retick");
+    bt::event_log_check_options options;
+    options.schema = &schema;
+    options.threads = 3;
+    options.chunk_bytes = 4096;
+    {
+        std::istringstream in(make_log(400));
+        const bt::event_log_check_report report = bt::check_event_log(in, options);
+        check(report.passed && report.violations.empty(), "a well-formed log should pass across many chunks");
+        check(report.total_events == 1200 && report.completed_ticks == 400, "every event and tick should be counted");
+        check(report.first_seq == 1 && report.last_seq == 1200 && report.distinct_nodes == 1,
+              "the summary should cover the whole stream");
+    }
+
+    std::string log = make_log(400);
+    const std::size_t cut = log.find('\n', 3000) + 1;
+    const std::string replayed = log.substr(cut, log.find('\n', cut) + 1 - cut);
+    log = log.substr(0, cut) + replayed + "{\"schema\":\n" + log.substr(cut);
+    log += "{\"schema\":\"mbt.evt.v1\",\"type\":\"\",\"seq\":0.5,\"extra\":1}\n";
+    log += "{\"schema\":\"mbt.evt.v1\",\"type\":\"tick_begin\",\"seq\":5000,\"tick\":401}\n";
+    std::istringstream in(log);
+    const bt::event_log_check_report report = bt::check_event_log(in, options);
+    auto count = [&](std::string_view code) {
+        return std::count_if(report.violations.begin(), report.violations.end(), [&](const auto& v) {
+            return v.code == code;
+        });
+    };
+    check(!report.passed, "broken invariants should fail the log");
+    check(count("invalid_json") == 1, "a line cut short should be reported as invalid JSON");
+    check(count("schema_violation") == 4, "the malformed event should report each failing keyword");
+    check(count("duplicate_seq") == 1 && count("non_monotonic_seq") >= 1, "a replayed line should break the seq checks");
+    check(count("missing_tick_end") == 1, "the open final tick should be reported");
+
+    options.tolerate_incomplete_tail = true;
+    options.schema = nullptr;
+    std::istringstream tail(make_log(3) + "{\"type\":\"tick_begin\",\"seq\":10,\"tick\":4}\n");
+    const bt::event_log_check_report tolerant = bt::check_event_log(tail, options);
+    check(tolerant.passed && tolerant.trace_truncated, "a tolerated open tail should pass as truncated");
 }
 
-void test_bt_blackboard_get_builtin() {
+void test_log_replay_reinjects_recorded_results() {
     using namespace muslisp;
 
     reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
     env_ptr env = create_global_env();
+    host.events().set_enabled(true);
+    host.events().set_ring_capacity(16384);
+    (void)eval_text("(events.set-bb-deltas 4)", env);
+
+    const std::string plan_leaf =
+        "(plan-action :name \"p\" :planner :mcts :budget_ms 20 :work_max 32 :model_service \"toy-1d\" "
+        ":state_key state :action_key plan-out)";
+    const auto tree_text = [](const std::string& leaf) {
+        return "(bt (sel (seq (vla-wait :name \"flow\" :job_key flow-job :action_key flow-action) " + leaf +
+               " (succeed)) (seq (vla-request :name \"flow\" :job_key flow-job :instruction \"move right\" "
+               ":state_key state :deadline_ms 30 :dims 1 :bound_lo -1.0 :bound_hi 1.0) (running))))";
+    };
+    (void)eval_text("(define recorded (bt.new-instance " + tree_text(plan_leaf) + "))", env);
+    bool reached_success = false;
+    for (int i = 0; i < 80 && !reached_success; ++i) {
+        const std::string state = std::to_string(0.01 * static_cast<double>(i) + 0.1234567);
+        reached_success = symbol_name(eval_text("(bt.tick recorded '((state " + state + ")))", env)) == "success";
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    check(reached_success, "the recorded run should finish");
 
-    (void)eval_text("(define tree (bt.compile '(seq (act bb-put-int foo 42) (succeed))))", env);
-    (void)eval_text("(define inst (bt.new-instance tree))", env);
-    check(symbol_name(eval_text("(bt.tick inst)", env)) == "success", "bb tree should tick to success");
+    const auto log_path = temp_file_path("log_replay", ".jsonl");
+    {
+        std::ofstream out(log_path);
+        for (const std::string& line : host.events().snapshot()) {
+            out << line << '\n';
+        }
+    }
 
-    value foo_value = eval_text("(bt.blackboard.get inst 'foo -1)", env);
-    check(is_integer(foo_value) && integer_value(foo_value) == 42, "bt.blackboard.get should read integer entry");
+    (void)eval_text("(define replayed (bt.new-instance " + tree_text(plan_leaf) + "))", env);
+    (void)eval_text("(define report (bt.replay-log replayed \"" + log_path.string() + "\"))", env);
+    check(eval_text("(map.get report 'diverged nil)", env) == make_boolean(false), "an unchanged tree should not diverge");
+    check(integer_value(eval_text("(map.get report 'replayed_ticks 0)", env)) ==
+              integer_value(eval_text("(map.get report 'recorded_ticks 0)", env)),
+          "every recorded tick should be replayed");
+    check(integer_value(eval_text("(map.get report 'injected_vla_results 0)", env)) == 1 &&
+              integer_value(eval_text("(map.get report 'injected_planner_results 0)", env)) == 1,
+          "the VLA completion and the plan should come from the log");
+    check(integer_value(eval_text("(map.get report 'injected_bb_writes 0)", env)) > 0,
+          "host writes to state should be restored from the log");
+
+    bt::instance* recorded = host.find_instance(bt_handle(eval_text("recorded", env)));
+    bt::instance* replayed = host.find_instance(bt_handle(eval_text("replayed", env)));
+    for (const char* key : {"state", "flow-action", "plan-out"}) {
+        const bt::bb_entry* a = recorded->bb.get(key);
+        const bt::bb_entry* b = replayed->bb.get(key);
+        const double* x = a ? std::get_if<double>(&a->value) : nullptr;
+        const double* y = b ? std::get_if<double>(&b->value) : nullptr;
+        check(x && y && *x == *y, std::string("replay should reproduce ") + key + " exactly");
+    }
 
-    value missing_default = eval_text("(bt.blackboard.get inst 'missing 77)", env);
-    check(is_integer(missing_default) && integer_value(missing_default) == 77,
-          "bt.blackboard.get should return caller default for missing key");
+    (void)eval_text("(define changed (bt.new-instance " + tree_text("(fail)") + "))", env);
+    (void)eval_text("(define report (bt.replay-log changed \"" + log_path.string() + "\"))", env);
+    check(eval_text("(map.get report 'diverged nil)", env) == make_boolean(true), "a changed tree should diverge");
+    check(print_value(eval_text("(map.get (map.get report 'divergence nil) 'kind nil)", env)) == ":node_status",
+          "the changed leaf should report another status");
+    check(integer_value(eval_text("(map.get (map.get report 'divergence nil) 'tick nil)", env)) ==
+              static_cast<std::int64_t>(recorded->tick_index),
+          "the divergence should be the tick the leaf first ran");
+    std::filesystem::remove(log_path);
+}
 
-    value missing_nil = eval_text("(bt.blackboard.get inst 'missing)", env);
-    check(is_nil(missing_nil), "bt.blackboard.get without default should return nil");
+void test_runtime_host_deterministic_test_mode() {
+    bt::runtime_host host;
+    host.enable_deterministic_test_mode(4242, "deterministic-host", 1735689601000, 7);
+    check(host.deterministic_test_mode_enabled(), "runtime host should report deterministic mode enabled");
+    check(host.planner_ref().base_seed() == 4242, "deterministic mode should set fixed planner base seed");
+
+    (void)host.events().emit("tick_begin", 1, "{\"root\":1}");
+    const auto events = host.events().snapshot();
+    check(events.size() == 1, "deterministic mode smoke should emit one event");
+    check(events.front().find("\"run_id\":\"deterministic-host\"") != std::string::npos,
+          "deterministic mode should pin event run_id");
+    check(events.front().find("\"unix_ms\":1735689601000") != std::string::npos,
+          "deterministic mode should pin event timestamp progression");
+    check(events.front().find("\"seq\":1") != std::string::npos, "deterministic mode should preserve stable sequence ordering");
+
+    host.disable_deterministic_test_mode();
+    check(!host.deterministic_test_mode_enabled(), "runtime host should report deterministic mode disabled");
 }
 
-void test_bt_scheduler_backed_action() {
+void test_phase6_sample_wrappers_tree() {
     using namespace muslisp;
 
     reset_bt_runtime_host();
     env_ptr env = create_global_env();
 
-    (void)eval_text("(define tree (bt.compile '(act async-sleep-ms 10)))", env);
+    (void)eval_text(
+        "(define tree "
+        "  (bt.compile "
+        "    '(sel "
+        "       (seq "
+        "         (cond battery-ok) "
+        "         (cond target-visible) "
+        "         (act approach-target) "
+        "         (act grasp)) "
+        "       (act search-target))))",
+        env);
     (void)eval_text("(define inst (bt.new-instance tree))", env);
 
-    value st = eval_text("(bt.tick inst)", env);
-    check(is_symbol(st) && symbol_name(st) == "running", "first async tick should be running");
+    check(symbol_name(eval_text("(bt.tick inst)", env)) == "success",
+          "tick1 should use search-target fallback and succeed");
+    check(symbol_name(eval_text("(bt.tick inst)", env)) == "running",
+          "tick2 should run approach-target once target is visible");
+    check(symbol_name(eval_text("(bt.tick inst)", env)) == "success",
+          "tick3 should complete approach-target and grasp");
+}
 
-    bool done = false;
-    for (int i = 0; i < 40; ++i) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(2));
-        st = eval_text("(bt.tick inst)", env);
-        if (is_symbol(st) && symbol_name(st) == "success") {
-            done = true;
-            break;
-        }
+class test_robot_service final : public bt::robot_interface {
+public:
+    bool battery_ok(bt::tick_context&) override {
+        ++battery_checks;
+        return true;
     }
-    check(done, "async action should eventually succeed");
 
-    value events_dump = eval_text("(events.dump 60)", env);
-    bool saw_sched_submit = false;
-    bool saw_sched_finish = false;
-    for (const value& row : vector_from_list(events_dump)) {
-        if (!is_string(row)) {
-            continue;
-        }
-        const std::string line = string_value(row);
-        if (line.find("\"type\":\"sched_submit\"") != std::string::npos) {
-            saw_sched_submit = true;
-        }
-        if (line.find("\"type\":\"sched_finish\"") != std::string::npos) {
-            saw_sched_finish = true;
-        }
+    bool target_visible(bt::tick_context&) override {
+        ++visibility_checks;
+        return visible;
     }
-    check(saw_sched_submit, "events should include sched_submit");
-    check(saw_sched_finish, "events should include sched_finish");
-
-    value sched_stats = eval_text("(bt.scheduler.stats)", env);
-    check(is_string(sched_stats), "bt.scheduler.stats should return string");
-    check(string_value(sched_stats).find("submitted=") != std::string::npos, "scheduler stats missing submitted");
-}
-
-void test_canonical_event_stream_builtins() {
-    using namespace muslisp;
-
-    reset_bt_runtime_host();
-    env_ptr env = create_global_env();
 
-    check(is_nil(eval_text("(events.enable #t)", env)), "events.enable should return nil");
-    check(is_nil(eval_text("(events.set-flush-each-message #t)", env)),
-          "events.set-flush-each-message should return nil");
-    check(is_nil(eval_text("(events.set-ring-size 256)", env)), "events.set-ring-size should return nil");
+    bt::status approach_target(bt::tick_context&, bt::node_memory&) override {
+        ++approach_calls;
+        return bt::status::success;
+    }
 
-    (void)eval_text("(define tree (bt.compile '(seq (act bb-put-int foo 42) (cond bb-has foo))))", env);
-    (void)eval_text("(define inst (bt.new-instance tree))", env);
-    check(symbol_name(eval_text("(bt.tick inst)", env)) == "success", "event stream test tree should succeed");
-    (void)eval_text("(events.snapshot-bb)", env);
-    (void)eval_text("(bt.tick inst)", env);
+    bt::status grasp(bt::tick_context&, bt::node_memory&) override {
+        ++grasp_calls;
+        return bt::status::success;
+    }
 
-    value dumped = eval_text("(events.dump 20)", env);
-    check(is_proper_list(dumped), "events.dump should return list");
-    const auto rows = vector_from_list(dumped);
-    check(!rows.empty(), "events.dump should return at least one event");
-    bool saw_schema = false;
-    bool saw_tick_begin = false;
-    bool saw_tick_end = false;
-    bool saw_node_status = false;
-    bool saw_bb_write = false;
-    bool saw_bb_snapshot = false;
-    for (const auto& row : rows) {
-        check(is_string(row), "events.dump rows should be JSON strings");
-        const std::string line = string_value(row);
-        if (line.find("\"schema\":\"mbt.evt.v1\"") != std::string::npos) {
-            saw_schema = true;
-        }
-        if (line.find("\"type\":\"tick_begin\"") != std::string::npos) {
-            saw_tick_begin = true;
-        }
-        if (line.find("\"type\":\"tick_end\"") != std::string::npos) {
-            saw_tick_end = true;
-        }
-        if (line.find("\"type\":\"node_status\"") != std::string::npos) {
-            saw_node_status = true;
-        }
-        if (line.find("\"type\":\"bb_write\"") != std::string::npos) {
-            saw_bb_write = true;
-        }
-        if (line.find("\"type\":\"bb_snapshot\"") != std::string::npos) {
-            saw_bb_snapshot = true;
-        }
+    bt::status search_target(bt::tick_context&, bt::node_memory&) override {
+        ++search_calls;
+        visible = true;
+        return bt::status::success;
     }
 
-    check(saw_schema, "events should include schema envelope");
-    check(saw_tick_begin, "events should include tick_begin");
-    check(saw_tick_end, "events should include tick_end");
-    check(saw_node_status, "events should include node_status");
-    check(saw_bb_write, "events should include bb_write");
-    check(saw_bb_snapshot, "events should include bb_snapshot");
-}
+    bool visible = false;
+    int battery_checks = 0;
+    int visibility_checks = 0;
+    int approach_calls = 0;
+    int grasp_calls = 0;
+    int search_calls = 0;
+};
 
-void test_tick_audit_event_emission() {
+void test_phase6_custom_robot_interface() {
     using namespace muslisp;
 
     reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
+    test_robot_service robot;
+    host.set_robot_interface(&robot);
+
     env_ptr env = create_global_env();
+    (void)eval_text(
+        "(define tree "
+        "  (bt.compile "
+        "    '(sel "
+        "       (seq "
+        "         (cond battery-ok) "
+        "         (cond target-visible) "
+        "         (act approach-target) "
+        "         (act grasp)) "
+        "       (act search-target))))",
+        env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
 
-    check(is_nil(eval_text("(events.enable #t)", env)), "events.enable should return nil for tick audit test");
-    check(is_nil(eval_text("(events.enable-tick-audit #t)", env)),
-          "events.enable-tick-audit should return nil when enabling");
-    check(is_nil(eval_text("(events.set-ring-size 128)", env)), "events.set-ring-size should return nil");
+    check(symbol_name(eval_text("(bt.tick inst)", env)) == "success", "custom robot tick1 should search and succeed");
+    check(symbol_name(eval_text("(bt.tick inst)", env)) == "success", "custom robot tick2 should approach/grasp and succeed");
 
-    (void)eval_text("(define tree (bt.compile '(seq (act bb-put-int foo 42) (cond bb-has foo))))", env);
-    (void)eval_text("(define inst (bt.new-instance tree))", env);
-    check(symbol_name(eval_text("(bt.tick inst)", env)) == "success", "tick audit test tree should succeed");
+    check(robot.search_calls == 1, "custom robot search-target should be called once");
+    check(robot.approach_calls == 1, "custom robot approach-target should be called once");
+    check(robot.grasp_calls == 1, "custom robot grasp should be called once");
+    check(robot.battery_checks >= 2, "custom robot battery-ok should be checked each tick");
+    check(robot.visibility_checks >= 2, "custom robot target-visible should be checked each tick");
 
-    value dumped = eval_text("(events.dump 80)", env);
-    check(is_proper_list(dumped), "events.dump should return list for tick audit test");
-    bool saw_tick_audit = false;
-    bool saw_schema = false;
-    bool saw_tick_id = false;
-    bool saw_root_status = false;
-    bool saw_node_path = false;
-    bool saw_logging_mode = false;
-    bool saw_audit_mode = false;
-    bool saw_tick_ok = false;
-    for (const auto& row : vector_from_list(dumped)) {
-        check(is_string(row), "tick audit events.dump rows should be JSON strings");
-        const std::string line = string_value(row);
-        if (line.find("\"type\":\"tick_ok\"") != std::string::npos) {
-            saw_tick_ok = true;
-        }
-        if (line.find("\"type\":\"tick_audit\"") == std::string::npos) {
-            continue;
+    host.set_robot_interface(nullptr);
+}
+
+#if MUESLI_BT_WITH_PYBULLET_INTEGRATION
+class mock_racecar_adapter final : public bt::racecar_sim_adapter {
+public:
+    bt::racecar_state get_state() override {
+        ++get_state_calls;
+        if (throw_get_state_at > 0 && get_state_calls == throw_get_state_at) {
+            throw std::runtime_error("forced get_state failure");
         }
-        saw_tick_audit = true;
-        saw_schema = saw_schema || line.find("\"schema_version\":\"tick_audit.v1\"") != std::string::npos;
-        saw_tick_id = saw_tick_id || line.find("\"tick_id\":1") != std::string::npos;
-        saw_root_status = saw_root_status || line.find("\"root_status\":\"success\"") != std::string::npos;
-        saw_node_path = saw_node_path || line.find("\"node_path\":[") != std::string::npos;
-        saw_logging_mode = saw_logging_mode || line.find("\"logging_mode\":{") != std::string::npos;
-        saw_audit_mode = saw_audit_mode || line.find("\"audit_mode\":{") != std::string::npos;
+        bt::racecar_state state;
+        state.state_schema = "racecar_state.v1";
+        state.x = 0.05 * static_cast<double>(get_state_calls);
+        state.y = 0.0;
+        state.yaw = 0.0;
+        state.speed = 0.1;
+        state.goal = {10.0, 0.0};
+        state.rays = {3.0, 3.0, 3.0, 3.0, 3.0};
+        state.state_vec = {state.x, state.y, state.yaw, state.speed, state.goal[0], state.goal[1],
+                           state.rays[0], state.rays[1], state.rays[2], state.rays[3], state.rays[4]};
+        state.collision_imminent = false;
+        state.collision_count = collision_count;
+        state.t_ms = get_state_calls * 50;
+        return state;
     }
 
-    check(saw_tick_audit, "events should include tick_audit when enabled");
-    check(saw_schema, "tick_audit should include schema version");
-    check(saw_tick_id, "tick_audit should include tick_id");
-    check(saw_root_status, "tick_audit should include root status");
-    check(saw_node_path, "tick_audit should include node_path");
-    check(saw_logging_mode, "tick_audit should include logging_mode");
-    check(saw_audit_mode, "tick_audit should include audit_mode");
-    check(saw_tick_ok, "events should include compact tick_ok outcome");
+    void apply_action(double steering, double throttle) override {
+        ++apply_calls;
+        actions.emplace_back(steering, throttle);
+        last_action = {steering, throttle};
+    }
 
-    check(is_nil(eval_text("(events.enable-tick-audit #f)", env)),
-          "events.enable-tick-audit should return nil when disabling");
-}
+    void step(std::int64_t steps) override {
+        ++step_calls;
+        step_args.push_back(steps);
+    }
 
-void test_tick_audit_marks_in_tick_gc_as_violation() {
-    using namespace muslisp;
+    void reset() override {}
 
-    reset_bt_runtime_host();
-    default_gc().set_policy(gc_policy::default_policy);
-    bt::runtime_host& host = bt::default_runtime_host();
-    host.callbacks().register_action(
-        "test-force-gc",
-        [](bt::tick_context&, bt::node_id, bt::node_memory&, std::span<const muslisp::value>) {
-            muslisp::default_gc().collect();
-            return bt::status::success;
-        });
+    void on_tick_record(const bt::racecar_tick_record& record) override {
+        ++tick_record_calls;
+        tick_records.push_back(record);
+    }
 
-    env_ptr env = create_global_env();
-    check(is_nil(eval_text("(events.enable #t)", env)), "events.enable should return nil for in-tick GC audit test");
-    check(is_nil(eval_text("(events.enable-tick-audit #t)", env)),
-          "events.enable-tick-audit should return nil for in-tick GC audit test");
-    check(is_nil(eval_text("(events.set-ring-size 256)", env)), "events.set-ring-size should return nil");
+    void on_tick_records(const bt::racecar_tick_columns& batch) override {
+        tick_record_batches.push_back(batch.size());
+        bt::racecar_sim_adapter::on_tick_records(batch);
+    }
 
-    (void)eval_text("(define tree (bt.compile '(seq (act test-force-gc) (succeed))))", env);
-    (void)eval_text("(define inst (bt.new-instance tree))", env);
-    check(symbol_name(eval_text("(bt.tick inst)", env)) == "success", "forced-GC tick should complete in default policy");
+    std::int64_t throw_get_state_at = -1;
+    std::int64_t get_state_calls = 0;
+    std::int64_t apply_calls = 0;
+    std::int64_t step_calls = 0;
+    std::int64_t tick_record_calls = 0;
+    std::int64_t collision_count = 0;
+    std::vector<std::int64_t> step_args{};
+    std::vector<std::pair<double, double>> actions{};
+    std::array<double, 2> last_action{0.0, 0.0};
+    std::vector<bt::racecar_tick_record> tick_records{};
+    std::vector<std::size_t> tick_record_batches{};
+};
+#endif
 
-    bool saw_gc_begin_in_tick = false;
-    bool saw_gc_end_in_tick = false;
-    bool saw_tick_gc_violation = false;
-    for (const auto& row : vector_from_list(eval_text("(events.dump 120)", env))) {
-        check(is_string(row), "in-tick GC audit rows should be strings");
-        const std::string line = string_value(row);
-        if (line.find("\"type\":\"gc_begin\"") != std::string::npos &&
-            line.find("\"in_tick\":true") != std::string::npos) {
-            saw_gc_begin_in_tick = true;
+muslisp::map_key test_symbol_key(const std::string& name) {
+    muslisp::map_key key;
+    key.type = muslisp::map_key_type::symbol;
+    key.text_data = name;
+    return key;
+}
+
+void test_map_set_symbol(muslisp::value map_obj, const std::string& key, muslisp::value v) {
+    map_obj->map_data()[test_symbol_key(key)] = v;
+    muslisp::default_gc().write_barrier(map_obj, v);
+}
+
+class test_loop_backend final : public muslisp::env_backend {
+public:
+    explicit test_loop_backend(bool supports_reset, std::int64_t done_after_steps)
+        : supports_reset_(supports_reset), done_after_steps_(done_after_steps) {}
+
+    [[nodiscard]] muslisp::env_backend_supports supports() const override {
+        muslisp::env_backend_supports out;
+        out.reset = supports_reset_;
+        out.debug_draw = false;
+        out.headless = true;
+        out.realtime_pacing = false;
+        out.deterministic_seed = true;
+        out.simulated_time = reports_simulated_time;
+        return out;
+    }
+
+    void configure(muslisp::value opts) override {
+        if (!muslisp::is_map(opts)) {
+            throw std::runtime_error("configure: expected map");
         }
-        if (line.find("\"type\":\"gc_end\"") != std::string::npos &&
-            line.find("\"in_tick\":true") != std::string::npos) {
-            saw_gc_end_in_tick = true;
+        ++configure_calls;
+    }
+
+    [[nodiscard]] muslisp::value reset(std::optional<std::int64_t> seed) override {
+        if (!supports_reset_) {
+            throw std::runtime_error("reset unsupported");
         }
-        if (line.find("\"type\":\"tick_audit\"") != std::string::npos &&
-            line.find("\"gc_collections_delta\":1") != std::string::npos &&
-            line.find("\"violation\":\"tick_gc\"") != std::string::npos) {
-            saw_tick_gc_violation = true;
+        ++reset_calls;
+        if (seed.has_value()) {
+            last_seed = *seed;
         }
+        steps_in_episode = 0;
+        return observe();
     }
 
-    check(saw_gc_begin_in_tick, "forced GC should emit gc_begin with in_tick=true");
-    check(saw_gc_end_in_tick, "forced GC should emit gc_end with in_tick=true");
-    check(saw_tick_gc_violation, "tick_audit should classify in-tick GC as tick_gc violation");
-    default_gc().set_policy(gc_policy::default_policy);
-}
+    [[nodiscard]] muslisp::value observe() override {
+        ++observe_calls;
+        muslisp::value obs = muslisp::make_map();
+        muslisp::gc_root_scope roots(muslisp::default_gc());
+        roots.add(&obs);
 
-void test_fail_on_tick_gc_prevents_in_tick_gc_lifecycle() {
-    using namespace muslisp;
+        test_map_set_symbol(obs, "obs_schema", muslisp::make_string("test.loop.obs.v1"));
+        test_map_set_symbol(obs, "t_ms", muslisp::make_integer(global_steps * 10));
+        test_map_set_symbol(obs, "done", muslisp::make_boolean(steps_in_episode >= done_after_steps_));
+        return obs;
+    }
 
-    reset_bt_runtime_host();
-    default_gc().set_policy(gc_policy::default_policy);
-    bt::runtime_host& host = bt::default_runtime_host();
-    host.callbacks().register_action(
-        "test-force-gc-strict",
-        [](bt::tick_context&, bt::node_id, bt::node_memory&, std::span<const muslisp::value>) {
-            muslisp::default_gc().collect();
-            return bt::status::success;
-        });
+    void act(muslisp::value action) override {
+        if (!muslisp::is_map(action)) {
+            throw std::runtime_error("act: expected action map");
+        }
+        ++act_calls;
+    }
 
-    env_ptr env = create_global_env();
-    check(is_nil(eval_text("(events.enable #t)", env)), "events.enable should return nil for strict GC test");
-    check(is_nil(eval_text("(events.enable-tick-audit #t)", env)),
-          "events.enable-tick-audit should return nil for strict GC test");
-    check(is_nil(eval_text("(events.set-ring-size 256)", env)), "events.set-ring-size should return nil");
-    (void)eval_text("(define tree (bt.compile '(seq (act test-force-gc-strict) (succeed))))", env);
-    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    [[nodiscard]] bool step() override {
+        ++step_calls;
+        ++steps_in_episode;
+        ++global_steps;
+        return true;
+    }
+
+    bool supports_reset_ = false;
+    std::int64_t done_after_steps_ = 0;
+    // t_ms advances 10 ms per step; when set, the backend reports it as simulation time.
+    bool reports_simulated_time = false;
+    std::int64_t configure_calls = 0;
+    std::int64_t reset_calls = 0;
+    std::int64_t observe_calls = 0;
+    std::int64_t act_calls = 0;
+    std::int64_t step_calls = 0;
+    std::int64_t steps_in_episode = 0;
+    std::int64_t global_steps = 0;
+    std::int64_t last_seed = 0;
+};
 
-    default_gc().collect();
-    host.events().clear_ring();
-    default_gc().set_policy(gc_policy::fail_on_tick_gc);
+class test_loop_extension final : public muslisp::extension {
+public:
+    explicit test_loop_extension(std::shared_ptr<muslisp::env_backend> backend) : backend_(std::move(backend)) {
+        if (!backend_) {
+            throw muslisp::lisp_error("test backend registration requires non-null backend");
+        }
+    }
 
-    check(symbol_name(eval_text("(bt.tick inst)", env)) == "failure",
-          "fail-on-tick-gc callback error should fail the tick");
-    default_gc().set_policy(gc_policy::default_policy);
+    [[nodiscard]] std::string name() const override {
+        return "tests.loop-backend";
+    }
 
-    bool saw_in_tick_gc_lifecycle = false;
-    bool saw_strict_audit = false;
-    bool saw_gc_contract_error = false;
-    for (const auto& row : vector_from_list(eval_text("(events.dump 120)", env))) {
-        check(is_string(row), "strict GC audit rows should be strings");
-        const std::string line = string_value(row);
-        if ((line.find("\"type\":\"gc_begin\"") != std::string::npos ||
-             line.find("\"type\":\"gc_end\"") != std::string::npos) &&
-            line.find("\"in_tick\":true") != std::string::npos) {
-            saw_in_tick_gc_lifecycle = true;
-        }
-        if (line.find("\"type\":\"tick_audit\"") != std::string::npos &&
-            line.find("\"strict_gc\":true") != std::string::npos &&
-            line.find("\"gc_policy\":\"fail-on-tick-gc\"") != std::string::npos &&
-            line.find("\"gc_collections_delta\":0") != std::string::npos) {
-            saw_strict_audit = true;
-        }
-        if (line.find("\"type\":\"error\"") != std::string::npos &&
-            line.find("forced collection during tick under fail-on-tick-gc policy") != std::string::npos) {
-            saw_gc_contract_error = true;
-        }
+    void register_lisp(muslisp::registrar& reg) const override {
+        (void)reg;
+        muslisp::env_api_register_backend("loop-test", backend_);
     }
 
-    check(saw_gc_contract_error, "fail-on-tick-gc rejection should be logged as a runtime error");
-    check(!saw_in_tick_gc_lifecycle, "fail-on-tick-gc must prevent in-tick GC lifecycle events");
-    check(saw_strict_audit, "strict GC rejection should still leave a zero-GC tick_audit record");
+private:
+    std::shared_ptr<muslisp::env_backend> backend_;
+};
+
+muslisp::env_ptr create_env_with_test_loop_backend(const std::shared_ptr<muslisp::env_backend>& backend) {
+    muslisp::runtime_config config;
+    config.register_extension(std::make_unique<test_loop_extension>(backend));
+    return muslisp::create_global_env(std::move(config));
 }
 
-void test_strict_gc_representative_ticks_have_zero_gc_delta() {
+#if MUESLI_BT_WITH_PYBULLET_INTEGRATION
+void test_racecar_loop_contract() {
     using namespace muslisp;
 
     reset_bt_runtime_host();
-    default_gc().set_policy(gc_policy::default_policy);
     bt::runtime_host& host = bt::default_runtime_host();
+    bt::install_racecar_demo_callbacks(host);
     env_ptr env = create_global_env();
-    check(is_nil(eval_text("(events.enable #t)", env)), "events.enable should return nil for strict representative test");
-    check(is_nil(eval_text("(events.enable-tick-audit #t)", env)),
-          "events.enable-tick-audit should return nil for strict representative test");
-    check(is_nil(eval_text("(events.set-ring-size 512)", env)), "events.set-ring-size should return nil");
 
-    (void)eval_text("(define seq-tree (bt.compile '(seq (act always-success) (cond always-true) (succeed))))", env);
-    (void)eval_text("(define sel-tree (bt.compile '(sel (cond always-false) (act always-success))))", env);
     (void)eval_text(
-        "(define reactive-tree "
-        "  (bt.compile '(reactive-seq (cond always-true) (mem-sel (act always-fail) (act always-success)))))",
+        "(define tree "
+        "  (bt.compile '(seq (act constant-drive action 0.1 0.3) (act apply-action action) (running))))",
         env);
-    (void)eval_text("(define seq-inst (bt.new-instance seq-tree))", env);
-    (void)eval_text("(define sel-inst (bt.new-instance sel-tree))", env);
-    (void)eval_text("(define reactive-inst (bt.new-instance reactive-tree))", env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    const std::int64_t inst_handle = bt_handle(eval_text("inst", env));
 
-    default_gc().collect();
-    host.events().clear_ring();
-    default_gc().set_policy(gc_policy::fail_on_tick_gc);
-    check(symbol_name(eval_text("(bt.tick seq-inst)", env)) == "success", "strict seq representative tick should succeed");
-    check(symbol_name(eval_text("(bt.tick sel-inst)", env)) == "success", "strict sel representative tick should succeed");
-    check(symbol_name(eval_text("(bt.tick reactive-inst)", env)) == "success",
-          "strict reactive representative tick should succeed");
-    default_gc().set_policy(gc_policy::default_policy);
+    auto adapter = std::make_shared<mock_racecar_adapter>();
+    bt::set_racecar_sim_adapter(adapter);
 
-    std::size_t audit_count = 0;
-    bool saw_in_tick_gc_lifecycle = false;
-    bool saw_tick_gc_violation = false;
-    bool all_strict_zero_delta = true;
-    for (const auto& row : vector_from_list(eval_text("(events.dump 200)", env))) {
-        check(is_string(row), "strict representative event rows should be strings");
-        const std::string line = string_value(row);
-        if ((line.find("\"type\":\"gc_begin\"") != std::string::npos ||
-             line.find("\"type\":\"gc_end\"") != std::string::npos) &&
-            line.find("\"in_tick\":true") != std::string::npos) {
-            saw_in_tick_gc_lifecycle = true;
-        }
-        if (line.find("\"type\":\"tick_audit\"") == std::string::npos) {
-            continue;
-        }
-        ++audit_count;
-        if (line.find("\"violation\":\"tick_gc\"") != std::string::npos) {
-            saw_tick_gc_violation = true;
-        }
-        all_strict_zero_delta = all_strict_zero_delta &&
-                                line.find("\"strict_gc\":true") != std::string::npos &&
-                                line.find("\"gc_policy\":\"fail-on-tick-gc\"") != std::string::npos &&
-                                line.find("\"gc_collections_delta\":0") != std::string::npos;
+    bt::racecar_loop_options opts;
+    opts.tick_hz = 1000.0;
+    opts.max_ticks = 5;
+    opts.state_key = "state";
+    opts.action_key = "action";
+    opts.steps_per_tick = 3;
+    opts.mode = "bt_basic";
+    opts.run_id = "test-run";
+
+    const bt::racecar_loop_result result = bt::run_racecar_loop(host, inst_handle, opts);
+    check(result.status == bt::racecar_loop_status::stopped, "run-loop should stop on max ticks");
+    check(result.ticks == 5, "run-loop should execute max ticks");
+    check(adapter->get_state_calls == 5, "run-loop should observe exactly once per tick");
+    check(adapter->apply_calls == 5, "run-loop should apply exactly once per tick");
+    check(adapter->step_calls == 5, "run-loop should step exactly once per tick");
+    check(adapter->tick_record_calls == 5, "run-loop should emit exactly one tick record per tick");
+    check(result.fallback_count == 0, "run-loop should not use fallback when action is valid");
+    for (std::int64_t arg : adapter->step_args) {
+        check(arg == 3, "run-loop should preserve configured steps_per_tick");
     }
+    check(!adapter->tick_records.empty(), "run-loop should collect tick records");
+    check(adapter->tick_records.front().run_id == "test-run", "run-loop record should carry run_id");
 
-    check(audit_count == 3, "strict representative run should emit one tick_audit per tick");
-    check(!saw_in_tick_gc_lifecycle, "strict representative run should not emit in-tick GC lifecycle events");
-    check(!saw_tick_gc_violation, "strict representative run should not report tick_gc violations");
-    check(all_strict_zero_delta, "strict representative tick_audit rows should report zero GC delta");
+    bt::clear_racecar_demo_state();
 }
 
-void test_bt_tick_with_blackboard_input() {
+void test_racecar_loop_batches_tick_records() {
     using namespace muslisp;
 
     reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
+    bt::install_racecar_demo_callbacks(host);
     env_ptr env = create_global_env();
 
-    (void)eval_text("(define tree (bt.compile '(cond bb-has foo)))", env);
+    (void)eval_text(
+        "(define tree "
+        "  (bt.compile '(seq (act constant-drive action 0.1 0.3) (act apply-action action) (running))))",
+        env);
     (void)eval_text("(define inst (bt.new-instance tree))", env);
-    check(symbol_name(eval_text("(bt.tick inst)", env)) == "failure", "bb key should not exist before input");
-    check(symbol_name(eval_text("(bt.tick inst '((foo 1)))", env)) == "success", "tick input should seed blackboard");
-}
-
-void test_phase5_ring_buffer_bounds() {
-    bt::trace_buffer trace(3);
-
-    bt::trace_event a{};
-    a.kind = bt::trace_event_kind::tick_begin;
-    trace.push(a);
-    bt::trace_event b{};
-    b.kind = bt::trace_event_kind::node_enter;
-    trace.push(b);
-    bt::trace_event c{};
-    c.kind = bt::trace_event_kind::node_exit;
-    trace.push(c);
-    bt::trace_event d{};
-    d.kind = bt::trace_event_kind::tick_end;
-    trace.push(d);
-
-    const auto trace_events = trace.snapshot();
-    check(trace_events.size() == 3, "trace ring should cap at configured capacity");
-    check(trace_events.front().sequence == 2, "trace ring should evict oldest event first");
-    check(trace_events.back().sequence == 4, "trace ring should keep newest event");
-
-    bt::memory_log_sink logs(2);
-    bt::log_record r1{};
-    r1.message = "one";
-    logs.write(r1);
-    bt::log_record r2{};
-    r2.message = "two";
-    logs.write(r2);
-    bt::log_record r3{};
-    r3.message = "three";
-    logs.write(r3);
-
-    const auto log_records = logs.snapshot();
-    check(log_records.size() == 2, "log ring should cap at configured capacity");
-    check(log_records.front().sequence == 2, "log ring should evict oldest record first");
-    check(log_records.back().sequence == 3, "log ring should keep newest record");
-}
-
-void test_event_log_deterministic_mode_and_canonical_serialisation() {
-    bt::event_log events(16);
-    events.set_run_id("fixture-run");
-    events.set_deterministic_time(1735689600000, 3);
-
-    std::vector<std::string> callback_lines;
-    events.set_line_listener([&callback_lines](const std::string& line) { callback_lines.push_back(line); });
-
-    const std::uint64_t seq1 = events.emit("tick_begin", 1, "{\"root\":1}");
-    const std::uint64_t seq2 = events.emit("tick_end", 1, "{\"status\":\"success\"}");
-    check(seq1 == 1, "event log should start sequence at 1 after set_run_id");
-    check(seq2 == 2, "event log should increment sequence for each event");
-    check(callback_lines.size() == 2, "line listener should receive canonical line for each event");
-
-    const std::string expected_first = bt::event_log::serialise_event_line(
-        "tick_begin", "fixture-run", 1735689600000, 1, 1, "{\"root\":1}");
-    const std::string expected_second = bt::event_log::serialise_event_line(
-        "tick_end", "fixture-run", 1735689600003, 2, 1, "{\"status\":\"success\"}");
-    check(callback_lines[0] == expected_first, "line listener should receive canonical serialised tick_begin line");
-    check(callback_lines[1] == expected_second, "line listener should receive canonical serialised tick_end line");
-
-    const auto ring = events.snapshot();
-    check(ring.size() == 2, "event ring should contain emitted events");
-    check(ring == callback_lines, "event ring and callback lines should match canonical serialisation");
-}
-
-void test_event_log_capture_stats_without_serialised_sink() {
-    bt::event_log events(0);
-    events.set_run_id("stats-run");
-    events.set_deterministic_time(1735689602000, 5);
-    events.set_capture_stats_enabled(true);
-
-    const std::string payload = "{\"node_id\":7}";
-    const std::uint64_t seq = events.emit("node_enter", 4, payload);
-    check(seq == 1, "capture stats path should still advance event sequence");
-
-    const bt::event_log_stats stats = events.capture_stats();
-    check(stats.event_count == 1, "capture stats should count emitted events");
-    const std::size_t expected_size =
-        bt::event_log::serialise_event_line("node_enter", "stats-run", 1735689602000, 1, 4, payload).size();
-    check(stats.byte_count == expected_size, "capture stats should match canonical serialised line size");
-    check(events.snapshot().empty(), "zero-capacity ring should not retain canonical lines");
-}
+    const std::int64_t inst_handle = bt_handle(eval_text("inst", env));
 
-void test_event_log_file_sink_reuses_stream_and_reopens_on_path_change() {
-    const std::filesystem::path first_path = temp_file_path("event_log_first", ".jsonl");
-    const std::filesystem::path second_path = temp_file_path("event_log_second", ".jsonl");
+    auto adapter = std::make_shared<mock_racecar_adapter>();
+    bt::set_racecar_sim_adapter(adapter);
 
-    bt::event_log events(0);
-    events.set_run_id("file-run");
-    events.set_deterministic_time(1735689603000, 1);
-    events.set_path(first_path.string());
-    events.set_file_enabled(true);
-    events.set_flush_on_tick_end(false);
-    events.set_flush_each_message(true);
+    bt::racecar_loop_options opts;
+    opts.tick_hz = 1000.0;
+    opts.max_ticks = 5;
+    opts.steps_per_tick = 1;
+    opts.run_id = "batched-run";
+    opts.tick_record_batch = 2;
 
-    (void)events.emit("tick_begin", 1, "{\"status\":\"one\"}");
-    {
-        std::ifstream in(first_path);
-        check(in.good(), "expected flushed event log file to exist after first write");
-        std::string first_line;
-        std::getline(in, first_line);
-        check(first_line.find("\"status\":\"one\"") != std::string::npos,
-              "flush-each-message should make the first event visible immediately");
+    const bt::racecar_loop_result result = bt::run_racecar_loop(host, inst_handle, opts);
+    check(result.ticks == 5, "batched run-loop should execute max ticks");
+    check(adapter->tick_record_batches == std::vector<std::size_t>{2, 2, 1},
+          "tick records should arrive in batches, with the rest flushed at the end");
+    check(adapter->tick_records.size() == 5, "every tick should still produce one record");
+    check(adapter->tick_records.front().run_id == "batched-run" && adapter->tick_records.back().tick_index == 5,
+          "replayed records should keep run_id and tick order");
+    check(std::fabs(adapter->tick_records[2].state.x - 0.15) < 1e-12 && adapter->tick_records[2].state.goal.size() == 2,
+          "replayed records should keep the state columns");
+
+    opts.tick_record_batch = 0;
+    bool rejected = false;
+    try {
+        (void)bt::run_racecar_loop(host, inst_handle, opts);
+    } catch (const std::runtime_error& e) {
+        rejected = std::string(e.what()).find(":tick_record_batch") != std::string::npos;
     }
-    (void)events.emit("tick_end", 1, "{\"status\":\"two\"}");
+    check(rejected, "tick_record_batch must be positive");
 
-    events.set_path(second_path.string());
-    (void)events.emit("tick_end", 2, "{\"status\":\"three\"}");
-    events.set_file_enabled(false);
-    (void)events.emit("tick_end", 3, "{\"status\":\"four\"}");
+    bt::clear_racecar_demo_state();
+}
 
-    auto read_lines = [](const std::filesystem::path& path) {
-        std::ifstream in(path);
-        check(in.good(), "expected event log file to exist: " + path.string());
-        std::vector<std::string> lines;
-        std::string line;
-        while (std::getline(in, line)) {
-            if (!line.empty()) {
-                lines.push_back(line);
-            }
-        }
-        return lines;
-    };
+void test_racecar_loop_error_safe_action() {
+    using namespace muslisp;
 
-    const auto first_lines = read_lines(first_path);
-    const auto second_lines = read_lines(second_path);
+    reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
+    bt::install_racecar_demo_callbacks(host);
+    env_ptr env = create_global_env();
 
-    check(first_lines.size() == 2, "first event log file should contain two events");
-    check(second_lines.size() == 1, "second event log file should contain one event");
-    check(first_lines[0].find("\"status\":\"one\"") != std::string::npos, "first file first event mismatch");
-    check(first_lines[1].find("\"status\":\"two\"") != std::string::npos, "first file second event mismatch");
-    check(second_lines[0].find("\"status\":\"three\"") != std::string::npos, "second file event mismatch");
-    check(second_lines[0].find("\"status\":\"four\"") == std::string::npos,
-          "disabled file logging should not append further events");
+    (void)eval_text(
+        "(define tree "
+        "  (bt.compile '(seq (act constant-drive action 0.2 0.4) (act apply-action action) (running))))",
+        env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
+    const std::int64_t inst_handle = bt_handle(eval_text("inst", env));
 
-    std::error_code ec;
-    std::filesystem::remove(first_path, ec);
-    std::filesystem::remove(second_path, ec);
-}
+    auto adapter = std::make_shared<mock_racecar_adapter>();
+    adapter->throw_get_state_at = 2;
+    bt::set_racecar_sim_adapter(adapter);
 
-void test_runtime_host_deterministic_test_mode() {
-    bt::runtime_host host;
-    host.enable_deterministic_test_mode(4242, "deterministic-host", 1735689601000, 7);
-    check(host.deterministic_test_mode_enabled(), "runtime host should report deterministic mode enabled");
-    check(host.planner_ref().base_seed() == 4242, "deterministic mode should set fixed planner base seed");
+    bt::racecar_loop_options opts;
+    opts.tick_hz = 1000.0;
+    opts.max_ticks = 10;
+    opts.state_key = "state";
+    opts.action_key = "action";
+    opts.steps_per_tick = 2;
+    opts.safe_action = {0.33, 0.0};
+    opts.mode = "bt_basic";
+    opts.run_id = "error-run";
 
-    (void)host.events().emit("tick_begin", 1, "{\"root\":1}");
-    const auto events = host.events().snapshot();
-    check(events.size() == 1, "deterministic mode smoke should emit one event");
-    check(events.front().find("\"run_id\":\"deterministic-host\"") != std::string::npos,
-          "deterministic mode should pin event run_id");
-    check(events.front().find("\"unix_ms\":1735689601000") != std::string::npos,
-          "deterministic mode should pin event timestamp progression");
-    check(events.front().find("\"seq\":1") != std::string::npos, "deterministic mode should preserve stable sequence ordering");
+    const bt::racecar_loop_result result = bt::run_racecar_loop(host, inst_handle, opts);
+    check(result.status == bt::racecar_loop_status::error, "run-loop should return :error when adapter throws");
+    check(result.ticks == 2, "run-loop error path should emit final error tick record");
+    check(adapter->apply_calls == 2, "run-loop error path should apply safe action once");
+    check(adapter->step_calls == 2, "run-loop error path should step once after safe action");
+    check_close(adapter->last_action[0], 0.33, 1e-9, "safe action steering mismatch");
+    check_close(adapter->last_action[1], 0.0, 1e-9, "safe action throttle mismatch");
+    check(adapter->tick_records.size() == 2, "run-loop error path should emit final error record");
+    check(adapter->tick_records.back().is_error_record, "final record should be marked as error");
+    check(result.fallback_count == 0, "error-safe-action should not change fallback_count");
 
-    host.disable_deterministic_test_mode();
-    check(!host.deterministic_test_mode_enabled(), "runtime host should report deterministic mode disabled");
+    bt::clear_racecar_demo_state();
 }
 
-void test_phase6_sample_wrappers_tree() {
+void test_racecar_planner_model_and_env_api_contract() {
     using namespace muslisp;
 
     reset_bt_runtime_host();
-    env_ptr env = create_global_env();
+    bt::runtime_host& host = bt::default_runtime_host();
+    env_ptr env = create_env_with_pybullet_extension();
+    check(host.planner_ref().has_model("racecar-kinematic-v1"), "planner should register racecar-kinematic-v1 model");
+    check(host.planner_ref().has_model("flagship-goal-shared-v1"),
+          "planner should register flagship-goal-shared-v1 model");
+
+    auto adapter = std::make_shared<mock_racecar_adapter>();
+    bt::set_racecar_sim_adapter(adapter);
+
+    (void)eval_text("(env.attach \"pybullet\")", env);
+    value state_meta = eval_text(
+        "(begin "
+        "  (define s (env.reset nil)) "
+        "  (define info (map.get s 'info (map.make))) "
+        "  (list (map.get info 'state_schema \"none\") "
+        "        (map.get info 'x -1.0) "
+        "        (map.get info 'collision_count -1)))",
+        env);
+    const auto state_fields = vector_from_list(state_meta);
+    check(state_fields.size() == 3, "env.reset info metadata shape mismatch");
+    check(is_string(state_fields[0]) && string_value(state_fields[0]) == "racecar_state.v1",
+          "env.reset info should expose state_schema");
+    check(is_float(state_fields[1]), "env.reset info should expose x as float");
+    check(is_integer(state_fields[2]) && integer_value(state_fields[2]) == 0,
+          "env.reset info should expose collision_count as int");
 
     (void)eval_text(
         "(define tree "
         "  (bt.compile "
-        "    '(sel "
-        "       (seq "
-        "         (cond battery-ok) "
-        "         (cond target-visible) "
-        "         (act approach-target) "
-        "         (act grasp)) "
-        "       (act search-target))))",
+        "    '(seq "
+        "       (plan-action :name \"race\" :planner :mcts :budget_ms 20 :work_max 240 "
+        "                    :model_service \"racecar-kinematic-v1\" :state_key state :action_key action :meta_key plan-meta) "
+        "       (act apply-action action))))",
         env);
     (void)eval_text("(define inst (bt.new-instance tree))", env);
+    value st = eval_text("(bt.tick inst '((state (0.0 0.0 0.0 0.0 7.0 3.0 3.0 3.0 3.0))))", env);
+    check(is_symbol(st) && symbol_name(st) == "success", "plan-action with racecar model should succeed");
 
-    check(symbol_name(eval_text("(bt.tick inst)", env)) == "success",
-          "tick1 should use search-target fallback and succeed");
-    check(symbol_name(eval_text("(bt.tick inst)", env)) == "running",
-          "tick2 should run approach-target once target is visible");
-    check(symbol_name(eval_text("(bt.tick inst)", env)) == "success",
-          "tick3 should complete approach-target and grasp");
+    bt::instance* inst = host.find_instance(bt_handle(eval_text("inst", env)));
+    check(inst != nullptr, "racecar plan-action instance should exist");
+    const bt::bb_entry* action_entry = inst->bb.get("action");
+    check(action_entry != nullptr, "racecar plan-action should publish action");
+    const auto* action_vec = std::get_if<bt::bb_vector>(&action_entry->value);
+    check(action_vec && action_vec->size() >= 2, "racecar plan-action should output [steering throttle]");
+
+    (void)eval_text(
+        "(define flagship-tree "
+        "  (bt.compile "
+        "    '(seq "
+        "       (plan-action :name \"flagship-race\" :planner :mcts :budget_ms 20 :work_max 240 "
+        "                    :model_service \"flagship-goal-shared-v1\" :state_key planner_state "
+        "                    :action_key shared_action :meta_key plan-meta :action_schema \"flagship.cmd.v1\") "
+        "       (act apply-action shared_action))))",
+        env);
+    (void)eval_text("(define flagship-inst (bt.new-instance flagship-tree))", env);
+    value flagship_st = eval_text("(bt.tick flagship-inst '((planner_state (1.2 0.35 0.25 0.10))))", env);
+    check(is_symbol(flagship_st) && symbol_name(flagship_st) == "success",
+          "plan-action with flagship shared model should succeed");
+
+    bt::instance* flagship_inst = host.find_instance(bt_handle(eval_text("flagship-inst", env)));
+    check(flagship_inst != nullptr, "flagship plan-action instance should exist");
+    const bt::bb_entry* shared_action_entry = flagship_inst->bb.get("shared_action");
+    check(shared_action_entry != nullptr, "flagship plan-action should publish shared action");
+    const auto* shared_action_vec = std::get_if<bt::bb_vector>(&shared_action_entry->value);
+    check(shared_action_vec && shared_action_vec->size() >= 2, "flagship plan-action should output [linear_x angular_z]");
+    check((*shared_action_vec)[0] >= -1.0 && (*shared_action_vec)[0] <= 1.0,
+          "flagship linear_x should stay within shared command range");
+    check((*shared_action_vec)[1] >= -1.0 && (*shared_action_vec)[1] <= 1.0,
+          "flagship angular_z should stay within shared command range");
+
+    bt::clear_racecar_demo_state();
 }
 
-class test_robot_service final : public bt::robot_interface {
-public:
-    bool battery_ok(bt::tick_context&) override {
-        ++battery_checks;
-        return true;
-    }
+#endif
 
-    bool target_visible(bt::tick_context&) override {
-        ++visibility_checks;
-        return visible;
-    }
+void test_shared_flagship_planner_model_in_core_runtime() {
+    reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
 
-    bt::status approach_target(bt::tick_context&, bt::node_memory&) override {
-        ++approach_calls;
-        return bt::status::success;
-    }
+    check(host.planner_ref().has_model("flagship-goal-shared-v1"),
+          "core runtime should register flagship-goal-shared-v1 model");
 
-    bt::status grasp(bt::tick_context&, bt::node_memory&) override {
-        ++grasp_calls;
-        return bt::status::success;
-    }
+    bt::planner_request request;
+    request.schema_version = "planner.request.v1";
+    request.planner = bt::planner_backend::mcts;
+    request.model_service = "flagship-goal-shared-v1";
+    request.action_schema = "flagship.cmd.v1";
+    request.state = {1.0, 0.2, 0.1, 0.0};
+    // Keep this check robust under sanitiser overhead. The intent is to validate
+    // that the shared model is registered and returns a valid shared action, not
+    // to exercise a tight wall-clock budget.
+    request.budget_ms = 40;
+    request.work_max = 240;
 
-    bt::status search_target(bt::tick_context&, bt::node_memory&) override {
-        ++search_calls;
-        visible = true;
-        return bt::status::success;
-    }
+    const bt::planner_result result = host.planner_ref().plan(request);
+    check(result.status == bt::planner_status::ok, "core runtime flagship planner request should succeed");
+    check(result.action.u.size() == 2, "core runtime flagship planner should emit [linear_x angular_z]");
+    check(result.action.u[0] >= -1.0 && result.action.u[0] <= 1.0,
+          "core runtime flagship planner linear_x should stay in range");
+    check(result.action.u[1] >= -1.0 && result.action.u[1] <= 1.0,
+          "core runtime flagship planner angular_z should stay in range");
+}
 
-    bool visible = false;
-    int battery_checks = 0;
-    int visibility_checks = 0;
-    int approach_calls = 0;
-    int grasp_calls = 0;
-    int search_calls = 0;
-};
+void test_env_run_loop_multi_episode_reset_true() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    auto backend = std::make_shared<test_loop_backend>(true, 1000);
+    env_ptr env = create_env_with_test_loop_backend(backend);
+
+    (void)eval_text("(env.attach \"loop-test\")", env);
+    (void)eval_text(
+        "(define on-tick-loop "
+        "  (lambda (obs) "
+        "    (begin "
+        "      (define a (map.make)) "
+        "      (map.set! a 'action_schema \"test.loop.action.v1\") "
+        "      (map.set! a 'u (list 0.0)) "
+        "      a)))",
+        env);
+
+    (void)eval_text(
+        "(define loop-multi-result "
+        "  (env.run-loop "
+        "    (begin "
+        "      (define cfg (map.make)) "
+        "      (map.set! cfg 'tick_hz 1000) "
+        "      (map.set! cfg 'max_ticks 99) "
+        "      (map.set! cfg 'step_max 2) "
+        "      (map.set! cfg 'episode_max 3) "
+        "      (map.set! cfg 'stop_on_success #f) "
+        "      cfg) "
+        "    on-tick-loop))",
+        env);
+
+    check(symbol_name(eval_text("(map.get loop-multi-result 'status ':none)", env)) == ":stopped",
+          "multi-episode run-loop should stop on episode_max");
+    check(integer_value(eval_text("(map.get loop-multi-result 'episodes_completed -1)", env)) == 3,
+          "multi-episode run-loop episodes_completed mismatch");
+    check(integer_value(eval_text("(map.get loop-multi-result 'steps_total -1)", env)) == 6,
+          "multi-episode run-loop steps_total mismatch");
+    check(integer_value(eval_text("(map.get loop-multi-result 'last_episode_steps -1)", env)) == 2,
+          "multi-episode run-loop last_episode_steps mismatch");
+    check(integer_value(eval_text("(map.get loop-multi-result 'episodes -1)", env)) == 3,
+          "multi-episode compatibility key episodes mismatch");
+    check(integer_value(eval_text("(map.get loop-multi-result 'ticks -1)", env)) == 6,
+          "multi-episode compatibility key ticks mismatch");
+    check(backend->reset_calls == 3, "multi-episode run-loop should reset at episode start");
+    check(backend->step_calls == 6, "multi-episode run-loop step count mismatch");
+}
 
-void test_phase6_custom_robot_interface() {
+void test_env_run_loop_multi_episode_reset_false() {
     using namespace muslisp;
 
     reset_bt_runtime_host();
-    bt::runtime_host& host = bt::default_runtime_host();
-    test_robot_service robot;
-    host.set_robot_interface(&robot);
+    auto backend = std::make_shared<test_loop_backend>(false, 1000);
+    env_ptr env = create_env_with_test_loop_backend(backend);
 
-    env_ptr env = create_global_env();
+    (void)eval_text("(env.attach \"loop-test\")", env);
     (void)eval_text(
-        "(define tree "
-        "  (bt.compile "
-        "    '(sel "
-        "       (seq "
-        "         (cond battery-ok) "
-        "         (cond target-visible) "
-        "         (act approach-target) "
-        "         (act grasp)) "
-        "       (act search-target))))",
+        "(define on-tick-loop-unsupported "
+        "  (lambda (obs) "
+        "    (begin "
+        "      (define a (map.make)) "
+        "      (map.set! a 'action_schema \"test.loop.action.v1\") "
+        "      (map.set! a 'u (list 0.0)) "
+        "      a)))",
         env);
-    (void)eval_text("(define inst (bt.new-instance tree))", env);
 
-    check(symbol_name(eval_text("(bt.tick inst)", env)) == "success", "custom robot tick1 should search and succeed");
-    check(symbol_name(eval_text("(bt.tick inst)", env)) == "success", "custom robot tick2 should approach/grasp and succeed");
-
-    check(robot.search_calls == 1, "custom robot search-target should be called once");
-    check(robot.approach_calls == 1, "custom robot approach-target should be called once");
-    check(robot.grasp_calls == 1, "custom robot grasp should be called once");
-    check(robot.battery_checks >= 2, "custom robot battery-ok should be checked each tick");
-    check(robot.visibility_checks >= 2, "custom robot target-visible should be checked each tick");
+    (void)eval_text(
+        "(define loop-unsupported-result "
+        "  (env.run-loop "
+        "    (begin "
+        "      (define cfg (map.make)) "
+        "      (map.set! cfg 'tick_hz 1000) "
+        "      (map.set! cfg 'max_ticks 10) "
+        "      (map.set! cfg 'step_max 2) "
+        "      (map.set! cfg 'episode_max 2) "
+        "      cfg) "
+        "    on-tick-loop-unsupported))",
+        env);
 
-    host.set_robot_interface(nullptr);
+    check(symbol_name(eval_text("(map.get loop-unsupported-result 'status ':none)", env)) == ":unsupported",
+          "run-loop should return :unsupported when episode_max > 1 without reset support");
+    check(integer_value(eval_text("(map.get loop-unsupported-result 'episodes_completed -1)", env)) == 0,
+          "unsupported run-loop should not complete episodes");
+    check(integer_value(eval_text("(map.get loop-unsupported-result 'steps_total -1)", env)) == 0,
+          "unsupported run-loop should not step");
+    const std::string message = string_value(eval_text("(map.get loop-unsupported-result 'message \"\")", env));
+    check(message.find("requires env.reset capability") != std::string::npos,
+          "unsupported run-loop message should mention reset requirement");
 }
 
-#if MUESLI_BT_WITH_PYBULLET_INTEGRATION
-class mock_racecar_adapter final : public bt::racecar_sim_adapter {
-public:
-    bt::racecar_state get_state() override {
-        ++get_state_calls;
-        if (throw_get_state_at > 0 && get_state_calls == throw_get_state_at) {
-            throw std::runtime_error("forced get_state failure");
-        }
-        bt::racecar_state state;
-        state.state_schema = "racecar_state.v1";
-        state.x = 0.05 * static_cast<double>(get_state_calls);
-        state.y = 0.0;
-        state.yaw = 0.0;
-        state.speed = 0.1;
-        state.goal = {10.0, 0.0};
-        state.rays = {3.0, 3.0, 3.0, 3.0, 3.0};
-        state.state_vec = {state.x, state.y, state.yaw, state.speed, state.goal[0], state.goal[1],
-                           state.rays[0], state.rays[1], state.rays[2], state.rays[3], state.rays[4]};
-        state.collision_imminent = false;
-        state.collision_count = collision_count;
-        state.t_ms = get_state_calls * 50;
-        return state;
-    }
-
-    void apply_action(double steering, double throttle) override {
-        ++apply_calls;
-        actions.emplace_back(steering, throttle);
-        last_action = {steering, throttle};
-    }
-
-    void step(std::int64_t steps) override {
-        ++step_calls;
-        step_args.push_back(steps);
-    }
-
-    void reset() override {}
-
-    void on_tick_record(const bt::racecar_tick_record& record) override {
-        ++tick_record_calls;
-        tick_records.push_back(record);
-    }
-
-    std::int64_t throw_get_state_at = -1;
-    std::int64_t get_state_calls = 0;
-    std::int64_t apply_calls = 0;
-    std::int64_t step_calls = 0;
-    std::int64_t tick_record_calls = 0;
-    std::int64_t collision_count = 0;
-    std::vector<std::int64_t> step_args{};
-    std::vector<std::pair<double, double>> actions{};
-    std::array<double, 2> last_action{0.0, 0.0};
-    std::vector<bt::racecar_tick_record> tick_records{};
-};
-#endif
-
-muslisp::map_key test_symbol_key(const std::string& name) {
-    muslisp::map_key key;
-    key.type = muslisp::map_key_type::symbol;
-    key.text_data = name;
-    return key;
-}
+void test_env_run_loop_multi_episode_canonical_summary_events() {
+    using namespace muslisp;
 
-void test_map_set_symbol(muslisp::value map_obj, const std::string& key, muslisp::value v) {
-    map_obj->map_data[test_symbol_key(key)] = v;
-}
+    reset_bt_runtime_host();
+    auto backend = std::make_shared<test_loop_backend>(true, 1000);
+    env_ptr env = create_env_with_test_loop_backend(backend);
 
-class test_loop_backend final : public muslisp::env_backend {
-public:
-    explicit test_loop_backend(bool supports_reset, std::int64_t done_after_steps)
-        : supports_reset_(supports_reset), done_after_steps_(done_after_steps) {}
+    (void)eval_text("(env.attach \"loop-test\")", env);
+    (void)eval_text(
+        "(define on-tick-loop-events "
+        "  (lambda (obs) "
+        "    (begin "
+        "      (define a (map.make)) "
+        "      (map.set! a 'action_schema \"test.loop.action.v1\") "
+        "      (map.set! a 'u (list 0.0)) "
+        "      a)))",
+        env);
 
-    [[nodiscard]] muslisp::env_backend_supports supports() const override {
-        muslisp::env_backend_supports out;
-        out.reset = supports_reset_;
-        out.debug_draw = false;
-        out.headless = true;
-        out.realtime_pacing = false;
-        out.deterministic_seed = true;
-        return out;
-    }
+    const std::filesystem::path event_log_path = temp_file_path("env_runloop_multi_episode", ".jsonl");
+    const std::string event_log_lisp = lisp_string_literal(event_log_path.string());
 
-    void configure(muslisp::value opts) override {
-        if (!muslisp::is_map(opts)) {
-            throw std::runtime_error("configure: expected map");
-        }
-        ++configure_calls;
-    }
+    (void)eval_text(
+        "(env.run-loop "
+        "  (begin "
+        "    (define cfg (map.make)) "
+        "    (map.set! cfg 'tick_hz 1000) "
+        "    (map.set! cfg 'max_ticks 99) "
+        "    (map.set! cfg 'step_max 2) "
+        "    (map.set! cfg 'episode_max 3) "
+        "    (map.set! cfg 'stop_on_success #f) "
+        "    (map.set! cfg 'event_log_path " +
+            event_log_lisp +
+            ") "
+            "    cfg) "
+            "  on-tick-loop-events)",
+        env);
 
-    [[nodiscard]] muslisp::value reset(std::optional<std::int64_t> seed) override {
-        if (!supports_reset_) {
-            throw std::runtime_error("reset unsupported");
-        }
-        ++reset_calls;
-        if (seed.has_value()) {
-            last_seed = *seed;
+    std::ifstream in(event_log_path);
+    check(in.good(), "expected env.run-loop multi-episode canonical event log to exist");
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty()) {
+            lines.push_back(line);
         }
-        steps_in_episode = 0;
-        return observe();
     }
 
-    [[nodiscard]] muslisp::value observe() override {
-        ++observe_calls;
-        muslisp::value obs = muslisp::make_map();
-        muslisp::gc_root_scope roots(muslisp::default_gc());
-        roots.add(&obs);
-
-        test_map_set_symbol(obs, "obs_schema", muslisp::make_string("test.loop.obs.v1"));
-        test_map_set_symbol(obs, "t_ms", muslisp::make_integer(global_steps * 10));
-        test_map_set_symbol(obs, "done", muslisp::make_boolean(steps_in_episode >= done_after_steps_));
-        return obs;
-    }
-
-    void act(muslisp::value action) override {
-        if (!muslisp::is_map(action)) {
-            throw std::runtime_error("act: expected action map");
+    auto count_type = [&](std::string_view type) {
+        std::size_t count = 0;
+        const std::string needle = "\"type\":\"" + std::string(type) + "\"";
+        for (const std::string& item : lines) {
+            if (item.find(needle) != std::string::npos) {
+                ++count;
+            }
         }
-        ++act_calls;
-    }
+        return count;
+    };
 
-    [[nodiscard]] bool step() override {
-        ++step_calls;
-        ++steps_in_episode;
-        ++global_steps;
-        return true;
-    }
+    check(count_type("run_start") == 1, "multi-episode canonical log should emit one run_start");
+    check(count_type("episode_begin") == 3, "multi-episode canonical log should emit three episode_begin events");
+    check(count_type("tick_begin") == 6, "multi-episode canonical log should emit six tick_begin events");
+    check(count_type("tick_end") == 6, "multi-episode canonical log should emit six tick_end events");
+    check(count_type("episode_end") == 3, "multi-episode canonical log should emit three episode_end events");
+    check(count_type("run_end") == 1, "multi-episode canonical log should emit one run_end");
 
-    bool supports_reset_ = false;
-    std::int64_t done_after_steps_ = 0;
-    std::int64_t configure_calls = 0;
-    std::int64_t reset_calls = 0;
-    std::int64_t observe_calls = 0;
-    std::int64_t act_calls = 0;
-    std::int64_t step_calls = 0;
-    std::int64_t steps_in_episode = 0;
-    std::int64_t global_steps = 0;
-    std::int64_t last_seed = 0;
-};
+    const std::string& last = lines.back();
+    check(last.find("\"type\":\"run_end\"") != std::string::npos, "last event should be run_end");
+    check(last.find("\"episodes_completed\":3") != std::string::npos, "run_end should record episodes_completed");
+    check(last.find("\"steps_total\":6") != std::string::npos, "run_end should record steps_total");
+    check(last.find("\"last_episode_steps\":2") != std::string::npos, "run_end should record last_episode_steps");
+    check(last.find("\"status\":\"stopped\"") != std::string::npos, "run_end should record final status");
+    check(last.find("\"reason\":\"episode_max reached\"") != std::string::npos, "run_end should record final reason");
 
-class test_loop_extension final : public muslisp::extension {
-public:
-    explicit test_loop_extension(std::shared_ptr<muslisp::env_backend> backend) : backend_(std::move(backend)) {
-        if (!backend_) {
-            throw muslisp::lisp_error("test backend registration requires non-null backend");
+    std::error_code ec;
+    std::filesystem::remove(event_log_path, ec);
+}
+
+void test_latest_mailbox_hands_over_newest_value() {
+    struct sample {
+        std::uint64_t seq = 0;
+        std::uint64_t check = 0;
+        std::string tag;
+    };
+
+    bt::latest_mailbox<sample> mailbox;
+    check(mailbox.read() == nullptr, "mailbox should be empty before the first publish");
+    mailbox.back() = sample{.seq = 1, .check = 3, .tag = "odd"};
+    mailbox.publish();
+    check(mailbox.fresh(), "a publish should mark the mailbox fresh");
+    const sample* first = mailbox.read();
+    check(first != nullptr && first->seq == 1 && first->tag == "odd", "read should return the published value");
+    check(!mailbox.fresh() && mailbox.read() == first, "a read without a new publish should keep the same value");
+
+    constexpr std::uint64_t kPublishes = 200000;
+    std::thread producer([&] {
+        for (std::uint64_t seq = 2; seq <= kPublishes; ++seq) {
+            sample& slot = mailbox.back();
+            slot.seq = seq;
+            slot.check = seq * 3;
+            slot.tag.assign(seq % 2 == 0 ? "even" : "odd");
+            mailbox.publish();
         }
+    });
+    std::uint64_t last_seq = 1;
+    bool torn = false;
+    bool backwards = false;
+    while (last_seq < kPublishes) {
+        const sample* latest = mailbox.read();
+        torn = torn || latest->check != latest->seq * 3 || latest->tag != (latest->seq % 2 == 0 ? "even" : "odd");
+        backwards = backwards || latest->seq < last_seq;
+        last_seq = latest->seq;
     }
+    producer.join();
+    check(!torn, "mailbox reads should never see a partially written value");
+    check(!backwards, "mailbox reads should never go back to an older value");
+    check(mailbox.read()->seq == kPublishes, "mailbox should end on the last published value");
+}
 
-    [[nodiscard]] std::string name() const override {
-        return "tests.loop-backend";
-    }
+void test_loop_pacer_overrun_policies() {
+    using namespace std::chrono_literals;
+    const auto total_jitter_samples = [](const bt::loop_pacer& pacer) {
+        std::uint64_t total = 0;
+        for (const std::uint64_t count : pacer.stats().jitter_histogram) {
+            total += count;
+        }
+        return total;
+    };
 
-    void register_lisp(muslisp::registrar& reg) const override {
-        (void)reg;
-        muslisp::env_api_register_backend("loop-test", backend_);
+    bt::loop_pacer skip({.period = 2ms, .policy = bt::overrun_policy::skip});
+    const auto started = bt::loop_pacer::clock::now();
+    for (int i = 0; i < 10; ++i) {
+        (void)skip.wait_next();
     }
+    const auto elapsed = bt::loop_pacer::clock::now() - started;
+    check(elapsed >= 20ms && elapsed < 40ms, "loop pacer should release ten ticks on a 2 ms grid");
+    check(skip.stats().overruns == 0 && skip.stats().ticks == 10, "idle ticks should not overrun");
+    std::this_thread::sleep_for(7ms);
+    (void)skip.wait_next();
+    check(skip.stats().overruns == 1 && skip.stats().skipped_ticks >= 3, "skip should drop the missed ticks");
+    check(total_jitter_samples(skip) == skip.stats().ticks, "every tick should land in the jitter histogram");
+
+    bt::loop_pacer catch_up({.period = 5ms, .policy = bt::overrun_policy::catch_up, .max_catch_up = 4});
+    (void)catch_up.wait_next();
+    std::this_thread::sleep_for(7ms);
+    const auto released = bt::loop_pacer::clock::now();
+    (void)catch_up.wait_next();
+    check(bt::loop_pacer::clock::now() - released < 2ms, "catch-up should release a late tick at once");
+    check(catch_up.stats().caught_up_ticks == 1 && catch_up.stats().skipped_ticks == 0,
+          "catch-up should run the missed tick instead of dropping it");
+
+    bt::loop_pacer degrade(
+        {.period = 2ms, .policy = bt::overrun_policy::degrade, .degrade_max_factor = 4, .degrade_recover_ticks = 2});
+    (void)degrade.wait_next();
+    std::this_thread::sleep_for(5ms);
+    (void)degrade.wait_next();
+    check(degrade.stats().degrade_factor == 2 && degrade.period() == 4ms, "degrade should double the period");
+    for (int i = 0; i < 3; ++i) {
+        (void)degrade.wait_next();
+    }
+    check(degrade.stats().degrade_factor == 1 && degrade.period() == 2ms,
+          "degrade should restore the period after on-time ticks");
 
-private:
-    std::shared_ptr<muslisp::env_backend> backend_;
-};
-
-muslisp::env_ptr create_env_with_test_loop_backend(const std::shared_ptr<muslisp::env_backend>& backend) {
-    muslisp::runtime_config config;
-    config.register_extension(std::make_unique<test_loop_extension>(backend));
-    return muslisp::create_global_env(std::move(config));
+    check(bt::parse_overrun_policy("catch-up") == bt::overrun_policy::catch_up, "catch-up should parse");
+    check(!bt::parse_overrun_policy("drop").has_value(), "unknown policies should be rejected");
 }
 
-#if MUESLI_BT_WITH_PYBULLET_INTEGRATION
-void test_racecar_loop_contract() {
+void test_env_run_loop_realtime_pacing_reported() {
     using namespace muslisp;
 
     reset_bt_runtime_host();
-    bt::runtime_host& host = bt::default_runtime_host();
-    bt::install_racecar_demo_callbacks(host);
-    env_ptr env = create_global_env();
+    auto backend = std::make_shared<test_loop_backend>(true, 1000);
+    env_ptr env = create_env_with_test_loop_backend(backend);
 
+    (void)eval_text("(env.attach \"loop-test\")", env);
+    (void)eval_text("(events.enable-tick-audit #t)", env);
+    (void)eval_text("(define tree (bt.compile '(seq (act bb-put-int foo 42) (cond bb-has foo))))", env);
+    (void)eval_text("(define inst (bt.new-instance tree))", env);
     (void)eval_text(
-        "(define tree "
-        "  (bt.compile '(seq (act constant-drive action 0.1 0.3) (act apply-action action) (running))))",
+        "(define on-tick-paced "
+        "  (lambda (obs) "
+        "    (begin "
+        "      (bt.tick inst) "
+        "      (define a (map.make)) "
+        "      (map.set! a 'action_schema \"test.loop.action.v1\") "
+        "      (map.set! a 'u (list 0.0)) "
+        "      a)))",
         env);
-    (void)eval_text("(define inst (bt.new-instance tree))", env);
-    const std::int64_t inst_handle = bt_handle(eval_text("inst", env));
 
-    auto adapter = std::make_shared<mock_racecar_adapter>();
-    bt::set_racecar_sim_adapter(adapter);
+    const std::filesystem::path event_log_path = temp_file_path("env_runloop_pacing", ".jsonl");
+    const std::string event_log_lisp = lisp_string_literal(event_log_path.string());
+    (void)eval_text(
+        "(define paced-result "
+        "  (env.run-loop "
+        "    (begin "
+        "      (define cfg (map.make)) "
+        "      (map.set! cfg 'tick_hz 500) "
+        "      (map.set! cfg 'max_ticks 5) "
+        "      (map.set! cfg 'realtime #t) "
+        "      (map.set! cfg 'overrun_policy \"catch-up\") "
+        "      (map.set! cfg 'event_log_path " +
+            event_log_lisp +
+            ") "
+            "      cfg) "
+            "    on-tick-paced))",
+        env);
+    (void)eval_text("(events.enable-tick-audit #f)", env);
 
-    bt::racecar_loop_options opts;
-    opts.tick_hz = 1000.0;
-    opts.max_ticks = 5;
-    opts.state_key = "state";
-    opts.action_key = "action";
-    opts.steps_per_tick = 3;
-    opts.mode = "bt_basic";
-    opts.run_id = "test-run";
+    check(integer_value(eval_text("(map.get (map.get paced-result 'pacing (map.make)) 'ticks -1)", env)) == 5,
+          "env.run-loop should report one paced wait per tick");
+    check(string_value(eval_text("(map.get (map.get paced-result 'pacing (map.make)) 'policy \"\")", env)) == "catch-up",
+          "env.run-loop should report the overrun policy");
+    check(vector_from_list(eval_text("(map.get (map.get paced-result 'pacing (map.make)) 'jitter_histogram nil)", env))
+                  .size() == bt::loop_pacer_stats::k_jitter_bounds_us.size() + 1,
+          "env.run-loop should report the jitter histogram buckets");
 
-    const bt::racecar_loop_result result = bt::run_racecar_loop(host, inst_handle, opts);
-    check(result.status == bt::racecar_loop_status::stopped, "run-loop should stop on max ticks");
-    check(result.ticks == 5, "run-loop should execute max ticks");
-    check(adapter->get_state_calls == 5, "run-loop should observe exactly once per tick");
-    check(adapter->apply_calls == 5, "run-loop should apply exactly once per tick");
-    check(adapter->step_calls == 5, "run-loop should step exactly once per tick");
-    check(adapter->tick_record_calls == 5, "run-loop should emit exactly one tick record per tick");
-    check(result.fallback_count == 0, "run-loop should not use fallback when action is valid");
-    for (std::int64_t arg : adapter->step_args) {
-        check(arg == 3, "run-loop should preserve configured steps_per_tick");
+    std::ifstream in(event_log_path);
+    check(in.good(), "expected paced env.run-loop event log to exist");
+    std::size_t audits_with_pacing = 0;
+    std::string run_end;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.find("\"type\":\"tick_audit\"") != std::string::npos &&
+            line.find("\"loop_pacing\":{\"policy\":\"catch-up\"") != std::string::npos) {
+            ++audits_with_pacing;
+        }
+        if (line.find("\"type\":\"run_end\"") != std::string::npos) {
+            run_end = line;
+        }
     }
-    check(!adapter->tick_records.empty(), "run-loop should collect tick records");
-    check(adapter->tick_records.front().run_id == "test-run", "run-loop record should carry run_id");
+    check(audits_with_pacing == 5, "tick_audit should carry loop_pacing while env.run-loop paces");
+    check(run_end.find("\"pacing\":") != std::string::npos, "run_end should carry the pacing summary");
+    check(bt::default_runtime_host().events().audit_loop_pacer() == nullptr,
+          "env.run-loop should unregister its pacer when the run ends");
 
-    bt::clear_racecar_demo_state();
+    std::error_code ec;
+    std::filesystem::remove(event_log_path, ec);
 }
 
-void test_racecar_loop_error_safe_action() {
-    using namespace muslisp;
+class test_pipelined_observation final : public muslisp::env_observation {
+public:
+    explicit test_pipelined_observation(std::int64_t seq) : seq_(seq) {}
 
-    reset_bt_runtime_host();
-    bt::runtime_host& host = bt::default_runtime_host();
-    bt::install_racecar_demo_callbacks(host);
-    env_ptr env = create_global_env();
+    [[nodiscard]] muslisp::value to_value() const override {
+        muslisp::value obs = muslisp::make_map();
+        muslisp::gc_root_scope roots(muslisp::default_gc());
+        roots.add(&obs);
+        test_map_set_symbol(obs, "obs_schema", muslisp::make_string("test.pipeline.obs.v1"));
+        test_map_set_symbol(obs, "seq", muslisp::make_integer(seq_));
+        return obs;
+    }
 
-    (void)eval_text(
-        "(define tree "
-        "  (bt.compile '(seq (act constant-drive action 0.2 0.4) (act apply-action action) (running))))",
-        env);
-    (void)eval_text("(define inst (bt.new-instance tree))", env);
-    const std::int64_t inst_handle = bt_handle(eval_text("inst", env));
+private:
+    std::int64_t seq_ = 0;
+};
 
-    auto adapter = std::make_shared<mock_racecar_adapter>();
-    adapter->throw_get_state_at = 2;
-    bt::set_racecar_sim_adapter(adapter);
+class test_pipelined_backend final : public muslisp::env_backend {
+public:
+    [[nodiscard]] muslisp::env_backend_supports supports() const override {
+        muslisp::env_backend_supports out;
+        out.headless = true;
+        out.pipelined_observe = true;
+        return out;
+    }
 
-    bt::racecar_loop_options opts;
-    opts.tick_hz = 1000.0;
-    opts.max_ticks = 10;
-    opts.state_key = "state";
-    opts.action_key = "action";
-    opts.steps_per_tick = 2;
-    opts.safe_action = {0.33, 0.0};
-    opts.mode = "bt_basic";
-    opts.run_id = "error-run";
+    void configure(muslisp::value) override {}
 
-    const bt::racecar_loop_result result = bt::run_racecar_loop(host, inst_handle, opts);
-    check(result.status == bt::racecar_loop_status::error, "run-loop should return :error when adapter throws");
-    check(result.ticks == 2, "run-loop error path should emit final error tick record");
-    check(adapter->apply_calls == 2, "run-loop error path should apply safe action once");
-    check(adapter->step_calls == 2, "run-loop error path should step once after safe action");
-    check_close(adapter->last_action[0], 0.33, 1e-9, "safe action steering mismatch");
-    check_close(adapter->last_action[1], 0.0, 1e-9, "safe action throttle mismatch");
-    check(adapter->tick_records.size() == 2, "run-loop error path should emit final error record");
-    check(adapter->tick_records.back().is_error_record, "final record should be marked as error");
-    check(result.fallback_count == 0, "error-safe-action should not change fallback_count");
+    [[nodiscard]] muslisp::value reset(std::optional<std::int64_t>) override {
+        return observe();
+    }
 
-    bt::clear_racecar_demo_state();
-}
+    [[nodiscard]] muslisp::value observe() override {
+        return test_pipelined_observation(-1).to_value();
+    }
 
-void test_racecar_planner_model_and_env_api_contract() {
-    using namespace muslisp;
+    [[nodiscard]] std::unique_ptr<muslisp::env_observation> acquire_observation() override {
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        acquire_thread = std::this_thread::get_id();
+        return std::make_unique<test_pipelined_observation>(acquisitions.fetch_add(1));
+    }
 
-    reset_bt_runtime_host();
-    bt::runtime_host& host = bt::default_runtime_host();
-    env_ptr env = create_env_with_pybullet_extension();
-    check(host.planner_ref().has_model("racecar-kinematic-v1"), "planner should register racecar-kinematic-v1 model");
-    check(host.planner_ref().has_model("flagship-goal-shared-v1"),
-          "planner should register flagship-goal-shared-v1 model");
+    void act(muslisp::value) override {}
 
-    auto adapter = std::make_shared<mock_racecar_adapter>();
-    bt::set_racecar_sim_adapter(adapter);
+    [[nodiscard]] bool step() override {
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        return true;
+    }
 
-    (void)eval_text("(env.attach \"pybullet\")", env);
-    value state_meta = eval_text(
-        "(begin "
-        "  (define s (env.reset nil)) "
-        "  (define info (map.get s 'info (map.make))) "
-        "  (list (map.get info 'state_schema \"none\") "
-        "        (map.get info 'x -1.0) "
-        "        (map.get info 'collision_count -1)))",
-        env);
-    const auto state_fields = vector_from_list(state_meta);
-    check(state_fields.size() == 3, "env.reset info metadata shape mismatch");
-    check(is_string(state_fields[0]) && string_value(state_fields[0]) == "racecar_state.v1",
-          "env.reset info should expose state_schema");
-    check(is_float(state_fields[1]), "env.reset info should expose x as float");
-    check(is_integer(state_fields[2]) && integer_value(state_fields[2]) == 0,
-          "env.reset info should expose collision_count as int");
+    std::atomic<std::int64_t> acquisitions{0};
+    std::thread::id acquire_thread{};
+};
+
+void test_env_run_loop_pipelined_observe() {
+    using namespace muslisp;
 
+    reset_bt_runtime_host();
+    auto backend = std::make_shared<test_pipelined_backend>();
+    env_ptr env = create_env_with_test_loop_backend(backend);
+    (void)eval_text("(env.attach \"loop-test\")", env);
+    check(boolean_value(eval_text("(map.get (map.get (env.info) 'supports (map.make)) 'pipelined_observe #f)", env)),
+          "env.info should report pipelined_observe support");
     (void)eval_text(
-        "(define tree "
-        "  (bt.compile "
-        "    '(seq "
-        "       (plan-action :name \"race\" :planner :mcts :budget_ms 20 :work_max 240 "
-        "                    :model_service \"racecar-kinematic-v1\" :state_key state :action_key action :meta_key plan-meta) "
-        "       (act apply-action action))))",
+        "(define on-tick-pipelined "
+        "  (lambda (obs) "
+        "    (begin "
+        "      (define a (map.make)) "
+        "      (map.set! a 'action_schema \"test.pipeline.action.v1\") "
+        "      (map.set! a 'u (list (map.get obs 'seq -2))) "
+        "      a)))",
         env);
-    (void)eval_text("(define inst (bt.new-instance tree))", env);
-    value st = eval_text("(bt.tick inst '((state (0.0 0.0 0.0 0.0 7.0 3.0 3.0 3.0 3.0))))", env);
-    check(is_symbol(st) && symbol_name(st) == "success", "plan-action with racecar model should succeed");
-
-    bt::instance* inst = host.find_instance(bt_handle(eval_text("inst", env)));
-    check(inst != nullptr, "racecar plan-action instance should exist");
-    const bt::bb_entry* action_entry = inst->bb.get("action");
-    check(action_entry != nullptr, "racecar plan-action should publish action");
-    const auto* action_vec = std::get_if<std::vector<double>>(&action_entry->value);
-    check(action_vec && action_vec->size() >= 2, "racecar plan-action should output [steering throttle]");
 
+    const std::filesystem::path event_log_path = temp_file_path("env_runloop_pipelined", ".jsonl");
+    const std::string event_log_lisp = lisp_string_literal(event_log_path.string());
+    const auto started = std::chrono::steady_clock::now();
     (void)eval_text(
-        "(define flagship-tree "
-        "  (bt.compile "
-        "    '(seq "
-        "       (plan-action :name \"flagship-race\" :planner :mcts :budget_ms 20 :work_max 240 "
-        "                    :model_service \"flagship-goal-shared-v1\" :state_key planner_state "
-        "                    :action_key shared_action :meta_key plan-meta :action_schema \"flagship.cmd.v1\") "
-        "       (act apply-action shared_action))))",
+        "(define pipelined-result "
+        "  (env.run-loop "
+        "    (begin "
+        "      (define cfg (map.make)) "
+        "      (map.set! cfg 'tick_hz 10) "
+        "      (map.set! cfg 'max_ticks 4) "
+        "      (map.set! cfg 'pipeline_observe #t) "
+        "      (map.set! cfg 'event_log_path " +
+            event_log_lisp +
+            ") "
+            "      cfg) "
+            "    on-tick-pipelined))",
         env);
-    (void)eval_text("(define flagship-inst (bt.new-instance flagship-tree))", env);
-    value flagship_st = eval_text("(bt.tick flagship-inst '((planner_state (1.2 0.35 0.25 0.10))))", env);
-    check(is_symbol(flagship_st) && symbol_name(flagship_st) == "success",
-          "plan-action with flagship shared model should succeed");
+    const auto elapsed = std::chrono::steady_clock::now() - started;
 
-    bt::instance* flagship_inst = host.find_instance(bt_handle(eval_text("flagship-inst", env)));
-    check(flagship_inst != nullptr, "flagship plan-action instance should exist");
-    const bt::bb_entry* shared_action_entry = flagship_inst->bb.get("shared_action");
-    check(shared_action_entry != nullptr, "flagship plan-action should publish shared action");
-    const auto* shared_action_vec = std::get_if<std::vector<double>>(&shared_action_entry->value);
-    check(shared_action_vec && shared_action_vec->size() >= 2, "flagship plan-action should output [linear_x angular_z]");
-    check((*shared_action_vec)[0] >= -1.0 && (*shared_action_vec)[0] <= 1.0,
-          "flagship linear_x should stay within shared command range");
-    check((*shared_action_vec)[1] >= -1.0 && (*shared_action_vec)[1] <= 1.0,
-          "flagship angular_z should stay within shared command range");
+    check(integer_value(eval_text("(map.get pipelined-result 'ticks -1)", env)) == 4, "pipelined run-loop ticks mismatch");
+    check(integer_value(eval_text("(map.get (map.get pipelined-result 'final_obs (map.make)) 'seq -1)", env)) == 3,
+          "each tick should consume the next pipelined snapshot");
+    check(backend->acquire_thread != std::thread::id{} && backend->acquire_thread != std::this_thread::get_id(),
+          "observations should be acquired off the interpreter thread");
+    // Sequentially, four ticks of 30 ms acquire + 30 ms step take 240 ms; pipelined, about 150 ms.
+    check(elapsed < std::chrono::milliseconds(210), "pipelined acquisition should overlap step");
 
-    bt::clear_racecar_demo_state();
-}
+    std::ifstream in(event_log_path);
+    check(in.good(), "expected pipelined env.run-loop event log to exist");
+    std::vector<std::string> obs_steps;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.find("\"type\":\"tick_begin\"") == std::string::npos) {
+            continue;
+        }
+        check(line.find("\"obs_pipelined\":true") != std::string::npos, "tick_begin should mark pipelined observations");
+        const std::size_t at = line.find("\"obs_step\":");
+        check(at != std::string::npos, "tick_begin should record the observation step");
+        obs_steps.push_back(line.substr(at + 11, 1));
+    }
+    check(obs_steps == std::vector<std::string>{"0", "0", "1", "2"},
+          "pipelined observations should be stamped with the step they were acquired at");
 
-#endif
+    auto plain = std::make_shared<test_loop_backend>(false, 1000);
+    env_ptr plain_env = create_env_with_test_loop_backend(plain);
+    (void)eval_text("(env.attach \"loop-test\")", plain_env);
+    expect_lisp_error_message(
+        "(env.run-loop "
+        "  (begin (define cfg (map.make)) (map.set! cfg 'tick_hz 10) (map.set! cfg 'max_ticks 1) "
+        "         (map.set! cfg 'pipeline_observe #t) cfg) "
+        "  (lambda (obs) (map.make)))",
+        plain_env,
+        "env.run-loop :pipeline_observe: backend does not support pipelined observation",
+        "pipeline_observe on an unsupported backend");
 
-void test_shared_flagship_planner_model_in_core_runtime() {
-    reset_bt_runtime_host();
-    bt::runtime_host& host = bt::default_runtime_host();
+    std::error_code ec;
+    std::filesystem::remove(event_log_path, ec);
+}
 
-    check(host.planner_ref().has_model("flagship-goal-shared-v1"),
-          "core runtime should register flagship-goal-shared-v1 model");
+class test_typed_observe_backend final : public muslisp::env_backend {
+public:
+    [[nodiscard]] muslisp::env_backend_supports supports() const override {
+        muslisp::env_backend_supports out;
+        out.headless = true;
+        out.typed_observe = true;
+        return out;
+    }
 
-    bt::planner_request request;
-    request.schema_version = "planner.request.v1";
-    request.planner = bt::planner_backend::mcts;
-    request.model_service = "flagship-goal-shared-v1";
-    request.action_schema = "flagship.cmd.v1";
-    request.state = {1.0, 0.2, 0.1, 0.0};
-    // Keep this check robust under sanitiser overhead. The intent is to validate
-    // that the shared model is registered and returns a valid shared action, not
-    // to exercise a tight wall-clock budget.
-    request.budget_ms = 40;
-    request.work_max = 240;
+    void configure(muslisp::value) override {}
+
+    [[nodiscard]] muslisp::value reset(std::optional<std::int64_t>) override {
+        return observe();
+    }
 
-    const bt::planner_result result = host.planner_ref().plan(request);
-    check(result.status == bt::planner_status::ok, "core runtime flagship planner request should succeed");
-    check(result.action.u.size() == 2, "core runtime flagship planner should emit [linear_x angular_z]");
-    check(result.action.u[0] >= -1.0 && result.action.u[0] <= 1.0,
-          "core runtime flagship planner linear_x should stay in range");
-    check(result.action.u[1] >= -1.0 && result.action.u[1] <= 1.0,
-          "core runtime flagship planner angular_z should stay in range");
-}
+    [[nodiscard]] muslisp::value observe() override {
+        ++map_observations;
+        return muslisp::make_map();
+    }
 
-void test_env_run_loop_multi_episode_reset_true() {
+    void observe_into(muslisp::env_observation_sink& sink) override {
+        const double x = static_cast<double>(typed_observations++);
+        const double state_vec[] = {x, x * 2.0, 0.5};
+        sink.put_string("obs_schema", "test.typed.obs.v1");
+        sink.put_number("x", x);
+        sink.put_vector("state_vec", state_vec);
+        sink.put_integer("seq", typed_observations);
+        sink.put_bool("done", false);
+    }
+
+    void act(muslisp::value) override {}
+
+    [[nodiscard]] bool step() override {
+        return true;
+    }
+
+    std::int64_t typed_observations = 0;
+    std::int64_t map_observations = 0;
+};
+
+void test_env_run_loop_typed_observe_into_blackboard() {
     using namespace muslisp;
 
     reset_bt_runtime_host();
-    auto backend = std::make_shared<test_loop_backend>(true, 1000);
+    auto backend = std::make_shared<test_typed_observe_backend>();
     env_ptr env = create_env_with_test_loop_backend(backend);
-
     (void)eval_text("(env.attach \"loop-test\")", env);
+    check(boolean_value(eval_text("(map.get (map.get (env.info) 'supports (map.make)) 'typed_observe #f)", env)),
+          "env.info should report typed_observe support");
+    check(is_nil(eval_text("(env.observation)", env)), "env.observation should be nil before a typed run");
+
+    (void)eval_text("(define typed-inst (bt.new-instance (bt.compile '(succeed))))", env);
     (void)eval_text(
-        "(define on-tick-loop "
+        "(define typed-seen (map.make)) "
+        "(define on-tick-typed "
         "  (lambda (obs) "
         "    (begin "
+        "      (map.set! typed-seen 'has_x (map.has? obs 'x)) "
+        "      (map.set! typed-seen 'obs_schema (map.get obs 'obs_schema \"\")) "
+        "      (map.set! typed-seen 'step (map.get obs 'step -1)) "
         "      (define a (map.make)) "
-        "      (map.set! a 'action_schema \"test.loop.action.v1\") "
+        "      (map.set! a 'action_schema \"test.typed.action.v1\") "
         "      (map.set! a 'u (list 0.0)) "
         "      a)))",
         env);
 
+    const std::filesystem::path event_log_path = temp_file_path("env_runloop_typed", ".jsonl");
     (void)eval_text(
-        "(define loop-multi-result "
+        "(define typed-result "
         "  (env.run-loop "
         "    (begin "
         "      (define cfg (map.make)) "
         "      (map.set! cfg 'tick_hz 1000) "
-        "      (map.set! cfg 'max_ticks 99) "
-        "      (map.set! cfg 'step_max 2) "
-        "      (map.set! cfg 'episode_max 3) "
-        "      (map.set! cfg 'stop_on_success #f) "
-        "      cfg) "
-        "    on-tick-loop))",
+        "      (map.set! cfg 'max_ticks 3) "
+        "      (map.set! cfg 'observe_into typed-inst) "
+        "      (map.set! cfg 'event_log_path " +
+            lisp_string_literal(event_log_path.string()) +
+            ") "
+            "      cfg) "
+            "    on-tick-typed))",
         env);
 
-    check(symbol_name(eval_text("(map.get loop-multi-result 'status ':none)", env)) == ":stopped",
-          "multi-episode run-loop should stop on episode_max");
-    check(integer_value(eval_text("(map.get loop-multi-result 'episodes_completed -1)", env)) == 3,
-          "multi-episode run-loop episodes_completed mismatch");
-    check(integer_value(eval_text("(map.get loop-multi-result 'steps_total -1)", env)) == 6,
-          "multi-episode run-loop steps_total mismatch");
-    check(integer_value(eval_text("(map.get loop-multi-result 'last_episode_steps -1)", env)) == 2,
-          "multi-episode run-loop last_episode_steps mismatch");
-    check(integer_value(eval_text("(map.get loop-multi-result 'episodes -1)", env)) == 3,
-          "multi-episode compatibility key episodes mismatch");
-    check(integer_value(eval_text("(map.get loop-multi-result 'ticks -1)", env)) == 6,
-          "multi-episode compatibility key ticks mismatch");
-    check(backend->reset_calls == 3, "multi-episode run-loop should reset at episode start");
-    check(backend->step_calls == 6, "multi-episode run-loop step count mismatch");
+    check(integer_value(eval_text("(map.get typed-result 'ticks -1)", env)) == 3, "typed run-loop ticks mismatch");
+    check(backend->typed_observations == 3 && backend->map_observations == 0,
+          "typed run-loop should observe through observe_into only");
+    check(!boolean_value(eval_text("(map.get typed-seen 'has_x #t)", env)), "on_tick should receive the metadata view only");
+    check(string_value(eval_text("(map.get typed-seen 'obs_schema \"\")", env)) == "test.typed.obs.v1",
+          "metadata view should carry obs_schema");
+    check(integer_value(eval_text("(map.get typed-seen 'step -1)", env)) == 2, "metadata view should carry step");
+
+    const bt::instance* inst =
+        bt::default_runtime_host().find_instance(bt_handle(eval_text("typed-inst", env)));
+    check(inst != nullptr, "typed observe instance should exist");
+    const bt::bb_entry* x = inst->bb.get("x");
+    check(x != nullptr && std::get<double>(x->value) == 2.0, "observe_into should write numbers to the blackboard");
+    const bt::bb_entry* state_vec = inst->bb.get("state_vec");
+    check(state_vec != nullptr && std::get<bt::bb_vector>(state_vec->value) == bt::bb_vector({2.0, 4.0, 0.5}),
+          "observe_into should write vectors to the blackboard");
+    check(x->last_writer_name == "env.observe", "typed observation writes should be attributed to env.observe");
+
+    check(float_value(eval_text("(map.get (env.observation) 'x -1.0)", env)) == 2.0,
+          "env.observation should build the full map on demand");
+    check(integer_value(eval_text("(map.get (env.observation) 'seq -1)", env)) == 3,
+          "env.observation should carry every typed field");
+
+    std::ifstream in(event_log_path);
+    std::string line;
+    std::size_t tick_begins = 0;
+    while (std::getline(in, line)) {
+        if (line.find("\"type\":\"tick_begin\"") == std::string::npos) {
+            continue;
+        }
+        ++tick_begins;
+        check(line.find("\"obs_fields\":{\"obs_schema\":\"test.typed.obs.v1\",\"x\":") != std::string::npos,
+              "tick_begin should record typed observation fields");
+    }
+    check(tick_begins == 3, "typed run-loop should emit one tick_begin per tick");
+
+    auto plain = std::make_shared<test_loop_backend>(false, 1000);
+    env_ptr plain_env = create_env_with_test_loop_backend(plain);
+    (void)eval_text("(env.attach \"loop-test\")", plain_env);
+    (void)eval_text("(define plain-inst (bt.new-instance (bt.compile '(succeed))))", plain_env);
+    expect_lisp_error_message(
+        "(env.run-loop "
+        "  (begin (define cfg (map.make)) (map.set! cfg 'tick_hz 10) (map.set! cfg 'max_ticks 1) "
+        "         (map.set! cfg 'observe_into plain-inst) cfg) "
+        "  (lambda (obs) (map.make)))",
+        plain_env,
+        "env.run-loop :observe_into: backend does not support typed observation",
+        "observe_into on an unsupported backend");
+
+    std::error_code ec;
+    std::filesystem::remove(event_log_path, ec);
 }
 
-void test_env_run_loop_multi_episode_reset_false() {
+void test_env_run_loop_simulated_time() {
     using namespace muslisp;
 
     reset_bt_runtime_host();
-    auto backend = std::make_shared<test_loop_backend>(false, 1000);
-    env_ptr env = create_env_with_test_loop_backend(backend);
+    bt::runtime_host& host = bt::default_runtime_host();
+    const bt::clock_interface* wall_clock = host.clock_interface_ptr();
+
+    // The sleep spans three 10 ms steps of simulated time, so it succeeds on the fourth tick no
+    // matter how quickly the loop runs.
+    const std::string on_tick =
+        "(lambda (obs) "
+        "  (begin "
+        "    (map.set! sim-seen (map.get obs 'step -1) (bt.tick sim-inst)) "
+        "    (define a (map.make)) "
+        "    (map.set! a 'action_schema \"test.loop.action.v1\") "
+        "    (map.set! a 'u (list 0.0)) "
+        "    a))";
+    const std::string config =
+        "(begin (define cfg (map.make)) (map.set! cfg 'tick_hz 100) (map.set! cfg 'max_ticks 5) "
+        "       (map.set! cfg 'simulated_time #t) cfg)";
+
+    for (const bool backend_clock : {true, false}) {
+        auto backend = std::make_shared<test_loop_backend>(false, 1000);
+        backend->reports_simulated_time = backend_clock;
+        env_ptr env = create_env_with_test_loop_backend(backend);
+        (void)eval_text("(env.attach \"loop-test\")", env);
+        check(boolean_value(eval_text("(map.get (map.get (env.info) 'supports (map.make)) 'simulated_time #f)", env)) ==
+                  backend_clock,
+              "env.info should report simulated_time support");
+        (void)eval_text("(define sim-inst (bt.new-instance (bt.compile '(act async-sleep-ms 25)))) "
+                        "(define sim-seen (map.make))",
+                        env);
+        (void)eval_text("(define sim-result (env.run-loop " + config + " " + on_tick + "))", env);
+
+        const std::string label = backend_clock ? "backend clock: " : "tick clock: ";
+        check(integer_value(eval_text("(map.get sim-result 'ticks -1)", env)) == 5, label + "simulated run tick count");
+        for (int step = 0; step < 3; ++step) {
+            check(symbol_name(eval_text("(map.get sim-seen " + std::to_string(step) + " nil)", env)) == "running",
+                  label + "async-sleep-ms should wait on simulated time");
+        }
+        check(symbol_name(eval_text("(map.get sim-seen 3 nil)", env)) == "success",
+              label + "async-sleep-ms should finish once simulated time passes its deadline");
+        check(integer_value(eval_text("(map.get sim-result 'overrun_count -1)", env)) == 0,
+              label + "simulated ticks should not overrun on wall time");
+        const double sim_ms = float_value(eval_text("(map.get sim-result 'sim_time_ms -1.0)", env));
+        check(sim_ms == (backend_clock ? 40.0 : 50.0), label + "sim_time_ms mismatch");
+        check(float_value(eval_text("(map.get sim-result 'realtime_factor -1.0)", env)) > 0.0,
+              label + "realtime_factor should be reported");
+        check(host.simulated_clock() == nullptr && host.clock_interface_ptr() == wall_clock,
+              label + "the wall clock should be back after the run");
+
+        expect_lisp_error_message(
+            "(env.run-loop (begin (define cfg (map.make)) (map.set! cfg 'tick_hz 10) (map.set! cfg 'max_ticks 1) "
+            "                     (map.set! cfg 'simulated_time #t) (map.set! cfg 'realtime #t) cfg) "
+            "  (lambda (obs) (map.make)))",
+            env,
+            "env.run-loop :simulated_time: cannot be combined with :realtime",
+            "simulated_time with realtime");
+    }
+
+    bt::thread_pool_scheduler sched(1);
+    bt::job_request req;
+    req.task_name = "settle";
+    req.fn = [] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        return bt::job_result{};
+    };
+    const bt::job_id id = sched.submit(std::move(req));
+    check(sched.wait_idle(std::chrono::seconds(5)), "wait_idle should return once the job finishes");
+    check(sched.get_info(id).status == bt::job_status::done, "wait_idle should not return before the job is done");
+    check(sched.wait_idle(std::chrono::milliseconds(0)), "an idle scheduler should report idle at once");
+}
+
+class test_batched_backend final : public muslisp::env_backend {
+public:
+    [[nodiscard]] muslisp::env_backend_supports supports() const override {
+        muslisp::env_backend_supports out;
+        out.headless = true;
+        out.typed_observe = true;
+        out.batched_step = true;
+        return out;
+    }
+
+    void configure(muslisp::value) override {}
+
+    [[nodiscard]] muslisp::value reset(std::optional<std::int64_t>) override {
+        return muslisp::make_map();
+    }
+
+    [[nodiscard]] muslisp::value observe() override {
+        return muslisp::make_map();
+    }
+
+    void act(muslisp::value) override {}
+
+    [[nodiscard]] bool step() override {
+        return true;
+    }
+
+    [[nodiscard]] std::size_t env_count() const override {
+        return positions.size();
+    }
+
+    // Copy i is done once its position reaches i + 1.
+    void observe_batch_into(std::span<muslisp::env_observation_sink* const> sinks) override {
+        for (std::size_t i = 0; i < sinks.size(); ++i) {
+            sinks[i]->put_number("x", positions[i]);
+            sinks[i]->put_bool("done", positions[i] >= static_cast<double>(i + 1));
+        }
+    }
+
+    void act_batch(std::span<const std::span<const double>> actions) override {
+        for (std::size_t i = 0; i < actions.size(); ++i) {
+            if (!actions[i].empty()) {
+                velocities[i] = actions[i][0];
+            }
+        }
+    }
+
+    [[nodiscard]] bool step_batch() override {
+        ++batch_steps;
+        for (std::size_t i = 0; i < positions.size(); ++i) {
+            positions[i] += velocities[i];
+        }
+        return true;
+    }
+
+    std::vector<double> positions = std::vector<double>(3, 0.0);
+    std::vector<double> velocities = std::vector<double>(3, 0.0);
+    std::int64_t batch_steps = 0;
+};
+
+void test_env_run_batch_steps_copies_together() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    bt::runtime_host& host = bt::default_runtime_host();
+    host.callbacks().register_action(
+        "test-batch-push", [](bt::tick_context& ctx, bt::node_id, bt::node_memory&, std::span<const muslisp::value>) {
+            ctx.bb_put("action", bt::bb_value{std::vector<double>{1.0}}, "test-batch-push");
+            return bt::status::success;
+        });
 
+    auto backend = std::make_shared<test_batched_backend>();
+    env_ptr env = create_env_with_test_loop_backend(backend);
     (void)eval_text("(env.attach \"loop-test\")", env);
+    check(integer_value(eval_text("(map.get (env.info) 'env_count -1)", env)) == 3, "env.info should report env_count");
     (void)eval_text(
-        "(define on-tick-loop-unsupported "
-        "  (lambda (obs) "
-        "    (begin "
-        "      (define a (map.make)) "
-        "      (map.set! a 'action_schema \"test.loop.action.v1\") "
-        "      (map.set! a 'u (list 0.0)) "
-        "      a)))",
+        "(define batch-tree (bt (act test-batch-push))) "
+        "(define batch-insts (list (bt.new-instance batch-tree) (bt.new-instance batch-tree) "
+        "                          (bt.new-instance batch-tree)))",
         env);
-
     (void)eval_text(
-        "(define loop-unsupported-result "
-        "  (env.run-loop "
-        "    (begin "
-        "      (define cfg (map.make)) "
-        "      (map.set! cfg 'tick_hz 1000) "
-        "      (map.set! cfg 'max_ticks 10) "
-        "      (map.set! cfg 'step_max 2) "
-        "      (map.set! cfg 'episode_max 2) "
-        "      cfg) "
-        "    on-tick-loop-unsupported))",
+        "(define batch-result "
+        "  (env.run-batch "
+        "    (begin (define cfg (map.make)) (map.set! cfg 'max_ticks 10) (map.set! cfg 'safe_action (list 0.0)) cfg) "
+        "    batch-insts))",
         env);
 
-    check(symbol_name(eval_text("(map.get loop-unsupported-result 'status ':none)", env)) == ":unsupported",
-          "run-loop should return :unsupported when episode_max > 1 without reset support");
-    check(integer_value(eval_text("(map.get loop-unsupported-result 'episodes_completed -1)", env)) == 0,
-          "unsupported run-loop should not complete episodes");
-    check(integer_value(eval_text("(map.get loop-unsupported-result 'steps_total -1)", env)) == 0,
-          "unsupported run-loop should not step");
-    const std::string message = string_value(eval_text("(map.get loop-unsupported-result 'message \"\")", env));
-    check(message.find("requires env.reset capability") != std::string::npos,
-          "unsupported run-loop message should mention reset requirement");
+    check(symbol_name(eval_text("(map.get batch-result 'status nil)", env)) == ":ok",
+          "run-batch should finish once every copy is done");
+    check(integer_value(eval_text("(map.get batch-result 'ticks -1)", env)) == 3, "run-batch tick count mismatch");
+    check(integer_value(eval_text("(map.get batch-result 'env_ticks -1)", env)) == 6,
+          "done copies should stop ticking their BT");
+    check(integer_value(eval_text("(map.get batch-result 'envs_done -1)", env)) == 3, "every copy should be done");
+    check(backend->batch_steps == 3, "copies should advance with one step_batch per tick");
+    check(backend->positions == std::vector<double>({1.0, 2.0, 3.0}),
+          "done copies should receive safe_action while the others keep moving");
+    check(integer_value(eval_text("(map.get (car (cdr (map.get batch-result 'copies nil))) 'ticks -1)", env)) == 2,
+          "per-copy ticks should count BT ticks until done");
+
+    const bt::instance* third =
+        host.find_instance(bt_handle(eval_text("(car (cdr (cdr batch-insts)))", env)));
+    const bt::bb_entry* x = third != nullptr ? third->bb.get("x") : nullptr;
+    check(x != nullptr && std::get<double>(x->value) == 3.0, "each copy should be observed into its own blackboard");
+
+    expect_lisp_error_message(
+        "(env.run-batch (begin (define cfg (map.make)) (map.set! cfg 'max_ticks 1) cfg) "
+        "               (list (car batch-insts)))",
+        env,
+        "env.run-batch: backend runs 3 copies but 1 bt_instance values were given",
+        "run-batch instance count mismatch");
+
+    auto plain = std::make_shared<test_loop_backend>(false, 1000);
+    env_ptr plain_env = create_env_with_test_loop_backend(plain);
+    (void)eval_text("(env.attach \"loop-test\")", plain_env);
+    expect_lisp_error_message("(env.run-batch (map.make) (list))",
+                              plain_env,
+                              "env.run-batch: backend does not support batched stepping",
+                              "run-batch on an unsupported backend");
 }
 
-void test_env_run_loop_multi_episode_canonical_summary_events() {
+#if MUESLI_BT_WITH_PYBULLET_INTEGRATION
+void test_pybullet_run_batch_parallel_adapter() {
     using namespace muslisp;
 
     reset_bt_runtime_host();
-    auto backend = std::make_shared<test_loop_backend>(true, 1000);
-    env_ptr env = create_env_with_test_loop_backend(backend);
+    bt::runtime_host& host = bt::default_runtime_host();
+    bt::install_racecar_demo_callbacks(host);
+    env_ptr env = create_env_with_pybullet_extension();
 
-    (void)eval_text("(env.attach \"loop-test\")", env);
+    auto first = std::make_shared<mock_racecar_adapter>();
+    auto second = std::make_shared<mock_racecar_adapter>();
+    bt::set_racecar_sim_adapter(bt::make_racecar_parallel_adapter({first, second}));
+
+    (void)eval_text("(env.attach \"pybullet\")", env);
+    check(integer_value(eval_text("(map.get (env.info) 'env_count -1)", env)) == 2,
+          "pybullet env_count should follow the adapter");
     (void)eval_text(
-        "(define on-tick-loop-events "
-        "  (lambda (obs) "
-        "    (begin "
-        "      (define a (map.make)) "
-        "      (map.set! a 'action_schema \"test.loop.action.v1\") "
-        "      (map.set! a 'u (list 0.0)) "
-        "      a)))",
+        "(define drive-tree (bt (act constant-drive))) "
+        "(define drive-insts (list (bt.new-instance drive-tree) (bt.new-instance drive-tree)))",
         env);
-
-    const std::filesystem::path event_log_path = temp_file_path("env_runloop_multi_episode", ".jsonl");
-    const std::string event_log_lisp = lisp_string_literal(event_log_path.string());
-
     (void)eval_text(
-        "(env.run-loop "
-        "  (begin "
-        "    (define cfg (map.make)) "
-        "    (map.set! cfg 'tick_hz 1000) "
-        "    (map.set! cfg 'max_ticks 99) "
-        "    (map.set! cfg 'step_max 2) "
-        "    (map.set! cfg 'episode_max 3) "
-        "    (map.set! cfg 'stop_on_success #f) "
-        "    (map.set! cfg 'event_log_path " +
-            event_log_lisp +
-            ") "
-            "    cfg) "
-            "  on-tick-loop-events)",
+        "(define drive-result "
+        "  (env.run-batch "
+        "    (begin (define cfg (map.make)) (map.set! cfg 'max_ticks 3) cfg) "
+        "    drive-insts))",
         env);
 
-    std::ifstream in(event_log_path);
-    check(in.good(), "expected env.run-loop multi-episode canonical event log to exist");
-    std::vector<std::string> lines;
-    std::string line;
-    while (std::getline(in, line)) {
-        if (!line.empty()) {
-            lines.push_back(line);
-        }
-    }
+    check(integer_value(eval_text("(map.get drive-result 'env_ticks -1)", env)) == 6,
+          "both cars should tick their BT every tick");
+    check(first->step_calls == 3 && second->step_calls == 3, "the parallel adapter should step every copy");
+    check(first->apply_calls == 3 && second->apply_calls == 3, "each copy should receive its own action");
+    check(second->last_action == std::array<double, 2>{0.0, 0.45}, "copy actions should come from their BT");
+
+    second->throw_get_state_at = second->get_state_calls + 1;
+    check(symbol_name(eval_text("(map.get (env.run-batch (begin (define cfg (map.make)) (map.set! cfg 'max_ticks 1) cfg) "
+                                "drive-insts) 'status nil)",
+                                env)) == ":error",
+          "a failing copy should end the batch with :error");
+    bt::clear_racecar_demo_state();
+}
+#endif
 
-    auto count_type = [&](std::string_view type) {
-        std::size_t count = 0;
-        const std::string needle = "\"type\":\"" + std::string(type) + "\"";
-        for (const std::string& item : lines) {
-            if (item.find(needle) != std::string::npos) {
-                ++count;
+void test_env_shm_backend_lockstep_with_host_thread() {
+#if !defined(_WIN32)
+    using namespace muslisp;
+
+    const std::string name = "muesli-bt-shm-test-" + std::to_string(static_cast<long long>(::getpid()));
+    const std::shared_ptr<bt::shm_exchange> host_side = bt::shm_exchange::create(name, 4, 2);
+
+    // A host that integrates u[0] into obs[0], restarts at the seed on reset and ends the episode at 3.
+    std::thread host([host_side] {
+        bt::shm_message action;
+        std::vector<double> state{0.0, 0.0};
+        std::int64_t t_ms = 0;
+        std::uint64_t seen = 0;
+        while (host_side->wait(bt::shm_channel::action, seen, std::chrono::seconds(5))) {
+            if (!host_side->read(bt::shm_channel::action, action)) {
+                break;
+            }
+            seen = action.seq;
+            if ((action.flags & bt::shm_message::k_flag_reset) != 0) {
+                state = {(action.flags & bt::shm_message::k_flag_seed) != 0 ? static_cast<double>(action.aux) : 0.0,
+                         0.0};
+                t_ms = 0;
+            } else if (!action.values.empty()) {
+                state[0] += action.values[0];
+                state[1] = static_cast<double>(action.values.size());
             }
+            t_ms += 10;
+            (void)host_side->publish(bt::shm_channel::observation, state, t_ms,
+                                     state[0] >= 3.0 ? bt::shm_message::k_flag_done : 0u);
         }
-        return count;
-    };
+    });
+    struct host_guard {
+        bt::shm_exchange& exchange;
+        std::thread& thread;
+        ~host_guard() {
+            exchange.close();
+            thread.join();
+        }
+    } guard{*host_side, host};
 
-    check(count_type("run_start") == 1, "multi-episode canonical log should emit one run_start");
-    check(count_type("episode_begin") == 3, "multi-episode canonical log should emit three episode_begin events");
-    check(count_type("tick_begin") == 6, "multi-episode canonical log should emit six tick_begin events");
-    check(count_type("tick_end") == 6, "multi-episode canonical log should emit six tick_end events");
-    check(count_type("episode_end") == 3, "multi-episode canonical log should emit three episode_end events");
-    check(count_type("run_end") == 1, "multi-episode canonical log should emit one run_end");
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
+    (void)eval_text("(env.attach \"shm\")", env);
+    (void)eval_text(
+        "(begin "
+        "  (define cfg (map.make)) "
+        "  (map.set! cfg 'shm_name \"" + name + "\") "
+        "  (map.set! cfg 'timeout_ms 5000) "
+        "  (env.configure cfg))",
+        env);
+    check(boolean_value(eval_text("(map.get (map.get (env.info) 'supports (map.make)) 'typed_observe #f)", env)),
+          "shm backend should support typed observe");
+    check(integer_value(eval_text("(map.get (env.info) 'obs_capacity -1)", env)) == 4,
+          "env.info should report the exchange's obs_capacity");
 
-    const std::string& last = lines.back();
-    check(last.find("\"type\":\"run_end\"") != std::string::npos, "last event should be run_end");
-    check(last.find("\"episodes_completed\":3") != std::string::npos, "run_end should record episodes_completed");
-    check(last.find("\"steps_total\":6") != std::string::npos, "run_end should record steps_total");
-    check(last.find("\"last_episode_steps\":2") != std::string::npos, "run_end should record last_episode_steps");
-    check(last.find("\"status\":\"stopped\"") != std::string::npos, "run_end should record final status");
-    check(last.find("\"reason\":\"episode_max reached\"") != std::string::npos, "run_end should record final reason");
+    (void)eval_text("(define obs0 (env.reset 1))", env);
+    check(float_value(eval_text("(car (map.get obs0 'obs nil))", env)) == 1.0, "reset should forward the seed");
+    check(integer_value(eval_text("(map.get obs0 't_ms -1)", env)) == 10, "observation t_ms comes from the host");
 
-    std::error_code ec;
-    std::filesystem::remove(event_log_path, ec);
+    (void)eval_text(
+        "(begin "
+        "  (define a (map.make)) "
+        "  (map.set! a 'u (list 0.5 0.0)) "
+        "  (env.act a))",
+        env);
+    check(boolean_value(eval_text("(env.step)", env)), "env.step should return true while the host runs");
+    (void)eval_text("(define obs1 (env.observe))", env);
+    check(float_value(eval_text("(car (map.get obs1 'obs nil))", env)) == 1.5, "step should apply the action");
+    check(float_value(eval_text("(car (cdr (map.get obs1 'obs nil)))", env)) == 2.0,
+          "the host should receive every action entry");
+
+    // A step without an action publishes an empty one, which the host treats as hold.
+    check(boolean_value(eval_text("(env.step)", env)), "env.step without an action should still step");
+    check(float_value(eval_text("(car (map.get (env.observe) 'obs nil))", env)) == 1.5,
+          "an empty action should hold the state");
+
+    value result = eval_text(
+        "(begin "
+        "  (define cfg (map.make)) "
+        "  (map.set! cfg 'tick_hz 1000) "
+        "  (map.set! cfg 'max_ticks 20) "
+        "  (map.set! cfg 'episode_max 1) "
+        "  (env.run-loop cfg "
+        "    (lambda (obs) "
+        "      (begin "
+        "        (define a (map.make)) "
+        "        (map.set! a 'action_schema \"shm.action.v1\") "
+        "        (map.set! a 'u (list 0.5)) "
+        "        a))))",
+        env);
+    check(is_map(result), "env.run-loop over shm should return a result map");
+    check(boolean_value(eval_text("(map.get (env.observe) 'done #f)", env)), "the run should reach the host's done flag");
+
+    host_side->close();
+    check(!boolean_value(eval_text("(env.step)", env)), "env.step should stop once the host closes the exchange");
+
+    try {
+        (void)eval_text("(begin (define a (map.make)) (map.set! a 'u (list 1 2 3)) (env.act a))", env);
+        throw std::runtime_error("expected env.act to reject an action larger than act_capacity");
+    } catch (const lisp_error& e) {
+        check(std::string(e.what()).find("act_capacity") != std::string::npos, "oversized action error mismatch");
+    }
+    env_api_detach();
+#endif
 }
 
 void test_env_core_interface_unattached() {
@@ -4339,6 +11331,36 @@ void test_env_core_interface_unattached() {
     }
 }
 
+void test_env_backend_factory_builds_on_first_attach() {
+    using namespace muslisp;
+
+    reset_bt_runtime_host();
+    env_ptr env = create_global_env();
+
+    int built = 0;
+    env_api_register_backend_factory("lazy-test", [&built] {
+        ++built;
+        return std::make_shared<test_loop_backend>(true, 1000);
+    });
+    const std::vector<std::string> names = env_api_registered_backends();
+    check(std::find(names.begin(), names.end(), "lazy-test") != names.end(),
+          "a factory backend should be listed before it is built");
+    check(built == 0, "registering a factory should not build the backend");
+
+    (void)eval_text("(env.attach \"lazy-test\")", env);
+    check(built == 1 && env_api_attached_backend_name() == "lazy-test", "the first attach should build the backend");
+    const std::shared_ptr<env_backend> first = env_api_attached_backend();
+    env_api_detach();
+    (void)eval_text("(env.attach \"lazy-test\")", env);
+    check(built == 1 && env_api_attached_backend() == first, "later attaches should reuse the built backend");
+    env_api_detach();
+
+    env_api_register_backend_factory("null-test", [] { return std::shared_ptr<env_backend>{}; });
+    expect_lisp_error_message("(env.attach \"null-test\")", env, "env.attach: backend factory returned null: null-test",
+                              "env.attach null factory");
+    check(!env_api_is_attached(), "a failed factory should leave nothing attached");
+}
+
 #if MUESLI_BT_WITH_PYBULLET_INTEGRATION
 void test_env_generic_pybullet_backend_contract() {
     using namespace muslisp;
@@ -5206,38 +12228,91 @@ int main() {
         {"tail-call optimisation smoke", test_tail_call_optimisation_smoke},
         {"tail-call optimisation deep recursion", test_tail_call_optimisation_deep_recursion},
         {"compiled closure path", test_compiled_closure_path},
+        {"compiled forms match evaluator", test_compiled_forms_match_evaluator},
+        {"compiled call site caches", test_compiled_call_site_caches},
         {"tail-call optimisation through and/or", test_tail_call_optimisation_and_or},
         {"gc env root stack regression", test_gc_env_root_stack_regression},
+        {"gc minor collections respect write barrier", test_gc_minor_collections_respect_write_barrier},
+        {"immediate numbers round-trip without allocating", test_immediate_numbers_round_trip_without_allocating},
+        {"gc pools recycle swept cells", test_gc_pools_recycle_swept_cells},
+        {"gc incremental policy runs in slices", test_gc_incremental_policy_runs_in_slices},
         {"gc duplicate env roots are stack-like", test_gc_duplicate_env_roots_are_stack_like},
         {"evaluator error messages stable", test_evaluator_error_messages_stable},
         {"bt authoring sugar", test_bt_authoring_sugar},
         {"load/write/save and roundtrip", test_load_write_save_and_roundtrip},
+        {"printer streams large structures", test_printer_streams_large_structures},
         {"load resolves nested relative paths", test_load_resolves_nested_relative_paths_from_loaded_file},
         {"bt dsl save/load roundtrip", test_bt_dsl_save_load_roundtrip},
+        {"bt compile shares structurally identical definitions", test_bt_compile_shares_structurally_identical_definitions},
         {"bt representative dsl roundtrip shapes", test_bt_dsl_roundtrip_representative_shapes},
         {"bt dsl hashes logged for compiled and loaded definitions",
          test_bt_dsl_hashes_are_logged_for_compiled_and_loaded_definitions},
         {"bt export-dot builtin", test_bt_export_dot_builtin},
         {"bt binary save/load roundtrip and validation", test_bt_binary_save_load_roundtrip_and_validation},
+        {"bt flat binary view and shared leaf args", test_bt_flat_binary_view_and_shared_leaf_args},
+        {"bt leaf bindings follow registry generation", test_bt_leaf_bindings_follow_registry_generation},
+        {"bt native leaf callbacks decode args at link time", test_bt_native_leaf_callbacks_decode_args_at_link_time},
+        {"bt incremental tick skips unchanged guards", test_bt_incremental_tick_skips_unchanged_guards},
+        {"bt tick on demand wakes on read keys, jobs and timer", test_bt_tick_on_demand_wakes_on_read_keys_jobs_and_timer},
+        {"bt memory report accounts instances", test_bt_memory_report_accounts_instances},
+        {"bt load-dsl-files compiles in parallel", test_bt_load_dsl_files_compiles_in_parallel},
+        {"bt tick program matches recursive interpreter", test_bt_tick_program_matches_recursive_interpreter},
+        {"bt tick program dispatches guard selectors", test_bt_tick_program_dispatches_guard_selectors},
+        {"bt compiled tree matches interpreter", test_bt_compiled_tree_matches_interpreter},
+        {"bt tick-all ticks instances as one wave", test_bt_tick_all_ticks_instances_as_one_wave},
+        {"bt parallel tick-all matches sequential waves", test_bt_parallel_tick_all_matches_sequential_waves},
+        {"bt tick arena backs tick event payloads", test_bt_tick_arena_backs_tick_event_payloads},
         {"list and predicate builtins", test_list_and_predicate_builtins},
         {"gc and stats builtins", test_gc_and_stats_builtins},
         {"gc lifecycle events", test_gc_lifecycle_events},
+        {"gc heap limits", test_gc_heap_limits},
+        {"runtime contexts are isolated", test_runtime_contexts_are_isolated},
         {"gc during argument evaluation", test_gc_during_argument_evaluation},
         {"math/time builtins and domain errors", test_math_time_and_domain_errors},
         {"rng determinism and ranges", test_rng_determinism_and_ranges},
+        {"rng bulk fills match scalar draws", test_rng_bulk_fills_match_scalar_draws},
+        {"f64vec arithmetic and conversions", test_f64vec_arithmetic_and_conversions},
         {"vec gc/growth/fuzz", test_vec_gc_growth_and_fuzz},
         {"map gc/rehash/ops", test_map_gc_rehash_and_ops},
+        {"persistent pmap/pvec share and seal", test_persistent_pmap_pvec_share_and_seal},
         {"pq builtins gc/errors", test_pq_builtins_gc_and_errors},
+        {"pq handles update remove and heapify", test_pq_handles_update_remove_and_heapify},
         {"continuous mcts smoke deterministic", test_continuous_mcts_smoke_deterministic},
+        {"mcts tree reuse warm start", test_mcts_tree_reuse_warm_starts_from_executed_action},
+        {"mcts parallel modes reproducible", test_mcts_parallel_modes_are_reproducible},
+        {"mppi batched rollouts match per-sample", test_mppi_batched_rollouts_match_per_sample_rollouts},
+        {"mppi threads match serial", test_mppi_threads_match_serial_result},
+        {"ilqr finite diff threads/batches match serial", test_ilqr_finite_diff_threads_and_batches_match_serial},
+        {"planner linalg kernels", test_planner_linalg_kernels_match_reference},
+        {"ilqr warm start shifts previous solution", test_ilqr_warm_start_shifts_previous_solution},
+        {"planner.define-model compiles lisp dynamics", test_planner_define_model_compiles_lisp_dynamics},
+        {"planner progress streams anytime results", test_planner_progress_streams_anytime_results},
+        {"planner result cache keyed by quantised state", test_planner_result_cache_quantised_state},
+        {"planner records ring and jsonl writer", test_planner_records_ring_and_jsonl_writer},
+        {"planner vector inline and heap storage", test_planner_vector_inline_and_heap_storage},
         {"planner.plan determinism/bounds/budget/sanity", test_planner_plan_builtin_determinism_bounds_budget_and_sanity},
         {"plan-action node blackboard/meta/logs", test_plan_action_node_blackboard_meta_and_logs},
         {"plan-action node all planner backends", test_plan_action_node_with_all_planner_backends},
         {"hash64 builtin", test_hash64_builtin},
         {"json and handle builtins", test_json_and_handle_builtins},
+        {"adopted handle payload lifetime", test_adopted_handle_payload_lifetime},
+        {"payload pool recycles frames", test_payload_pool_recycles_frames},
+        {"json codec string scan and numbers", test_json_codec_string_scan_and_numbers},
         {"capability registry call echo", test_capability_registry_call_echo},
         {"model service protocol skeleton", test_model_service_protocol_skeleton},
+        {"model service output policy", test_model_service_output_policy},
+        {"model service VLA batching", test_model_service_vla_batching},
+        {"model service frame ring", test_model_service_frame_ring},
+        {"model service hedged invoke", test_model_service_hedged_invoke},
+        {"model service check on first use", test_model_service_check_on_first_use},
+        {"model service mux", test_model_service_mux},
+        {"replay store index and journal", test_replay_store_index_and_journal},
+        {"vla request hash streams canonical text", test_vla_request_hash_streams_canonical_text},
+        {"vla response cache lru, ttl and stats", test_vla_response_cache_lru_ttl_and_stats},
         {"vla builtins submit/poll/cancel/caps", test_vla_builtins_submit_poll_cancel_and_caps},
         {"vla bt nodes flow and cancel", test_vla_bt_nodes_flow_and_cancel},
+        {"vla bt prefetch hit and supersede", test_vla_bt_prefetch_hit_and_supersede},
+        {"vla chunk executor", test_vla_chunk_executor},
         {"bt compile checks", test_bt_compile_checks},
         {"bt new composite dsl roundtrip", test_bt_new_composite_dsl_roundtrip},
         {"bt mem-seq semantics", test_bt_mem_seq_semantics},
@@ -5247,23 +12322,70 @@ int main() {
         {"bt seq/running semantics", test_bt_seq_and_running_semantics},
         {"bt decorator semantics", test_bt_decorator_semantics},
         {"bt reset clears phase4 state", test_bt_reset_clears_phase4_state},
+        {"bt swap definition keeps matching node state", test_bt_swap_definition_keeps_matching_node_state},
+        {"bt instance checkpoint restore and fork", test_bt_instance_checkpoint_restore_and_fork},
+        {"bt instance pool recycles released instances", test_bt_instance_pool_recycles_released_instances},
+        {"bt par node thresholds and concurrent conditions", test_bt_par_node_thresholds_and_concurrent_conditions},
+        {"bt halt visits only live memory", test_bt_halt_visits_only_live_memory},
+        {"bt instance flat node slots", test_bt_instance_flat_node_slots},
+        {"node payload inline and boxed storage", test_node_payload_inline_and_boxed_storage},
+        {"bt leaf args materialised once", test_bt_leaf_args_materialised_once},
+        {"bt blackboard interned slots", test_bt_blackboard_interned_slots},
+        {"bt blackboard vector storage", test_bt_blackboard_vector_storage},
+        {"bt blackboard read view", test_bt_blackboard_read_view},
+        {"bt blackboard history windows", test_bt_blackboard_history_windows},
         {"bt blackboard/events/stats builtins", test_bt_blackboard_events_and_stats_builtins},
         {"bt blackboard.get builtin", test_bt_blackboard_get_builtin},
         {"bt scheduler-backed action", test_bt_scheduler_backed_action},
+        {"async leaves wait on completion notifications", test_async_leaves_wait_on_completion_notifications},
+        {"cancel tokens stop running jobs", test_cancel_tokens_stop_running_jobs},
+        {"coroutine actions suspend in node memory", test_coroutine_actions_suspend_in_node_memory},
+        {"latency histograms report tail percentiles", test_latency_histograms_report_tail_percentiles},
+        {"node profiling modes and profile clock", test_node_profiling_modes_and_profile_clock},
+        {"flamegraph dump attributes self time to node paths", test_flamegraph_dump_attributes_self_time_to_node_paths},
+        {"runtime metrics render and serve openmetrics", test_runtime_metrics_render_and_serve_openmetrics},
+        {"snapshot restores global bindings into a fresh env", test_snapshot_restores_global_bindings_into_a_fresh_env},
+        {"thread pool scheduler recycles bounded job slots", test_thread_pool_scheduler_recycles_bounded_job_slots},
+        {"scheduler workers apply thread options", test_scheduler_worker_thread_options},
+        {"work-stealing scheduler lifecycle and nested jobs", test_work_stealing_scheduler_lifecycle_and_nested_jobs},
+        {"work-stealing scheduler recycles job slots", test_work_stealing_scheduler_recycles_job_slots},
+        {"scheduler typed results move once", test_scheduler_typed_results_move_once},
+        {"scheduler dispatches by priority and deadline", test_scheduler_dispatches_by_priority_and_deadline},
         {"canonical event stream builtins", test_canonical_event_stream_builtins},
         {"tick audit event emission", test_tick_audit_event_emission},
+        {"tick audit reports budget ledger", test_tick_audit_reports_budget_ledger},
+        {"node allocations are attributed to the allocating leaf", test_node_allocations_are_attributed_to_the_allocating_leaf},
         {"tick audit marks in-tick GC as violation", test_tick_audit_marks_in_tick_gc_as_violation},
         {"fail-on-tick-gc prevents in-tick GC lifecycle", test_fail_on_tick_gc_prevents_in_tick_gc_lifecycle},
         {"strict GC representative ticks have zero GC delta", test_strict_gc_representative_ticks_have_zero_gc_delta},
         {"bt tick with blackboard input", test_bt_tick_with_blackboard_input},
         {"env core interface unattached", test_env_core_interface_unattached},
+        {"env backend factory builds on first attach", test_env_backend_factory_builds_on_first_attach},
         {"env run-loop multi-episode reset=true", test_env_run_loop_multi_episode_reset_true},
         {"env run-loop multi-episode reset=false", test_env_run_loop_multi_episode_reset_false},
         {"env run-loop multi-episode canonical summary events",
          test_env_run_loop_multi_episode_canonical_summary_events},
+        {"latest mailbox hands over newest value", test_latest_mailbox_hands_over_newest_value},
+        {"loop pacer overrun policies", test_loop_pacer_overrun_policies},
+        {"env run-loop realtime pacing reported", test_env_run_loop_realtime_pacing_reported},
+        {"env run-loop pipelined observe", test_env_run_loop_pipelined_observe},
+        {"env run-loop typed observe into blackboard", test_env_run_loop_typed_observe_into_blackboard},
+        {"env run-loop simulated time", test_env_run_loop_simulated_time},
+        {"env run-batch steps copies together", test_env_run_batch_steps_copies_together},
+        {"env shm backend lockstep with host thread", test_env_shm_backend_lockstep_with_host_thread},
         {"event log deterministic mode + canonical serialisation", test_event_log_deterministic_mode_and_canonical_serialisation},
         {"event log capture stats without serialised sink", test_event_log_capture_stats_without_serialised_sink},
         {"event log file sink reuses stream and reopens on path change", test_event_log_file_sink_reuses_stream_and_reopens_on_path_change},
+        {"event log async file sink writes or counts every line", test_event_log_async_file_sink_writes_or_counts_every_line},
+        {"event log net sink streams frames and counts drops", test_event_log_net_sink_streams_frames_and_counts_drops},
+        {"event log binary sink transcodes to identical jsonl", test_event_log_binary_sink_transcodes_to_identical_jsonl},
+        {"event log index sidecar and rotation", test_event_log_index_sidecar_and_rotation},
+        {"event log validator streams chunks", test_event_log_validator_streams_chunks},
+        {"log replay reinjects recorded results", test_log_replay_reinjects_recorded_results},
+        {"event log emission policy filters before payloads", test_event_log_emission_policy_filters_before_payloads},
+        {"event log bb deltas and keyframes", test_event_log_bb_deltas_and_keyframes},
+        {"event log compact ids", test_event_log_compact_ids},
+        {"event log structured emit matches string emit", test_event_log_structured_emit_matches_string_emit},
         {"runtime host deterministic test mode", test_runtime_host_deterministic_test_mode},
         {"pybullet backend absent in core env", test_pybullet_backend_absent_in_core_env},
         {"ros2 backend absent in core env", test_ros2_backend_absent_in_core_env},
@@ -5273,8 +12395,10 @@ int main() {
         {"env run-loop canonical event log", test_env_run_loop_emits_canonical_event_log},
         {"pybullet backend present with extension", test_pybullet_backend_present_with_extension},
         {"racecar run-loop contract", test_racecar_loop_contract},
+        {"racecar run-loop batches tick records", test_racecar_loop_batches_tick_records},
         {"racecar run-loop error safe-action", test_racecar_loop_error_safe_action},
         {"racecar planner model + env.api contract", test_racecar_planner_model_and_env_api_contract},
+        {"pybullet run-batch parallel adapter", test_pybullet_run_batch_parallel_adapter},
 #endif
         {"shared flagship planner model in core runtime", test_shared_flagship_planner_model_in_core_runtime},
 #if MUESLI_BT_WITH_ROS2_INTEGRATION
@@ -5287,6 +12411,9 @@ int main() {
         {"ros2 cleanup with live transport peer", test_ros2_cleanup_with_live_transport_peer},
 #endif
         {"phase5 ring buffer bounds", test_phase5_ring_buffer_bounds},
+        {"memory log sink deferred and rate limited", test_memory_log_sink_deferred_and_rate_limited},
+        {"trace buffer text ring and concurrent snapshot", test_trace_buffer_text_ring_and_concurrent_snapshot},
+        {"trace buffer formats blackboard values lazily", test_trace_buffer_formats_blackboard_values_lazily},
         {"phase6 sample wrappers tree", test_phase6_sample_wrappers_tree},
         {"phase6 custom robot interface", test_phase6_custom_robot_interface},
     };
@@ -1,10 +1,12 @@
 #include "bt/model_service.hpp"
 #include "bt/runtime_host.hpp"
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <cstdlib>
 #include <filesystem>
+#include <future>
 #include <iostream>
 #include <memory>
 #include <string>
@@ -12,6 +14,15 @@
 #include <utility>
 #include <vector>
 
+#if !defined(_WIN32)
+#include <mutex>
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
 namespace {
 
 void check(bool condition, const std::string& message) {
@@ -152,6 +163,233 @@ bt::vla_poll run_model_service_vla_with_faults(std::vector<std::string> faults)
     return wait_for_terminal_vla(host, job);
 }
 
+#if !defined(_WIN32)
+// Minimal websocket MMSP server on 127.0.0.1. Each response echoes the request id; when a second
+// request arrives within a few milliseconds of the first, the second is answered first, so clients
+// must correlate responses by id.
+class local_websocket_service {
+public:
+    local_websocket_service() {
+        listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        const int on = 1;
+        (void)::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        check(::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0, "local service bind");
+        check(::listen(listen_fd_, 8) == 0, "local service listen");
+        socklen_t len = sizeof(addr);
+        (void)::getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+        port_ = ntohs(addr.sin_port);
+        accept_thread_ = std::thread([this] { accept_loop(); });
+    }
+
+    ~local_websocket_service() {
+        stopping_.store(true);
+        drop_connections();
+        accept_thread_.join();
+        for (std::thread& worker : workers_) {
+            worker.join();
+        }
+        (void)::close(listen_fd_);
+    }
+
+    [[nodiscard]] std::string endpoint() const { return "ws://127.0.0.1:" + std::to_string(port_) + "/v1/ws"; }
+    [[nodiscard]] int accepted() const { return accepted_.load(); }
+
+    void drop_connections() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const int fd : open_fds_) {
+            (void)::shutdown(fd, SHUT_RDWR);
+        }
+    }
+
+private:
+    static bool wait_readable(int fd, int timeout_ms) {
+        pollfd pfd{fd, POLLIN, 0};
+        return ::poll(&pfd, 1, timeout_ms) > 0;
+    }
+
+    static bool read_exact(int fd, char* out, std::size_t count) {
+        std::size_t got = 0;
+        while (got < count) {
+            const ssize_t n = ::recv(fd, out + got, count - got, 0);
+            if (n <= 0) {
+                return false;
+            }
+            got += static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    static bool read_client_frame(int fd, std::string& payload) {
+        unsigned char header[2];
+        if (!read_exact(fd, reinterpret_cast<char*>(header), 2)) {
+            return false;
+        }
+        std::uint64_t length = header[1] & 0x7f;
+        if (length == 126) {
+            unsigned char ext[2];
+            if (!read_exact(fd, reinterpret_cast<char*>(ext), 2)) {
+                return false;
+            }
+            length = (static_cast<std::uint64_t>(ext[0]) << 8) | ext[1];
+        } else if (length == 127) {
+            unsigned char ext[8];
+            if (!read_exact(fd, reinterpret_cast<char*>(ext), 8)) {
+                return false;
+            }
+            length = 0;
+            for (const unsigned char byte : ext) {
+                length = (length << 8) | byte;
+            }
+        }
+        unsigned char mask[4];
+        if (!read_exact(fd, reinterpret_cast<char*>(mask), 4)) {
+            return false;
+        }
+        payload.assign(static_cast<std::size_t>(length), '\0');
+        if (!read_exact(fd, payload.data(), payload.size())) {
+            return false;
+        }
+        for (std::size_t i = 0; i < payload.size(); ++i) {
+            payload[i] = static_cast<char>(payload[i] ^ mask[i % 4]);
+        }
+        return (header[0] & 0x0f) == 0x1;
+    }
+
+    static void reply(int fd, const std::string& request_json) {
+        const std::size_t at = request_json.find("\"id\":\"") + 6;
+        const std::string id = request_json.substr(at, request_json.find('"', at) - at);
+        const std::string body = "{\"version\":\"0.2\",\"id\":\"" + id + "\",\"status\":\"success\",\"output\":{\"echo\":\"" +
+                                 id + "\"},\"error\":null}";
+        std::string frame;
+        frame.push_back(static_cast<char>(0x81));
+        frame.push_back(static_cast<char>(126));
+        frame.push_back(static_cast<char>((body.size() >> 8) & 0xff));
+        frame.push_back(static_cast<char>(body.size() & 0xff));
+        frame += body;
+        (void)::send(fd, frame.data(), frame.size(), MSG_NOSIGNAL);
+    }
+
+    void accept_loop() {
+        while (!stopping_.load()) {
+            if (!wait_readable(listen_fd_, 10)) {
+                continue;
+            }
+            const int fd = ::accept(listen_fd_, nullptr, nullptr);
+            if (fd < 0) {
+                continue;
+            }
+            accepted_.fetch_add(1);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                open_fds_.push_back(fd);
+            }
+            workers_.emplace_back([this, fd] { serve(fd); });
+        }
+    }
+
+    void serve(int fd) {
+        std::string headers;
+        char ch = 0;
+        while (headers.find("\r\n\r\n") == std::string::npos && read_exact(fd, &ch, 1)) {
+            headers.push_back(ch);
+        }
+        const std::string accept = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n\r\n";
+        (void)::send(fd, accept.data(), accept.size(), MSG_NOSIGNAL);
+        std::string first;
+        while (!stopping_.load() && read_client_frame(fd, first)) {
+            std::string second;
+            if (wait_readable(fd, 20) && read_client_frame(fd, second)) {
+                reply(fd, second);
+            }
+            reply(fd, first);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            open_fds_.erase(std::find(open_fds_.begin(), open_fds_.end(), fd));
+        }
+        (void)::close(fd);
+    }
+
+    int listen_fd_ = -1;
+    int port_ = 0;
+    std::atomic<bool> stopping_{false};
+    std::atomic<int> accepted_{0};
+    std::mutex mutex_;
+    std::vector<int> open_fds_;
+    std::thread accept_thread_;
+    std::vector<std::thread> workers_;
+};
+
+void test_pooled_websocket_client() {
+    local_websocket_service service;
+    bt::model_service_config cfg;
+    cfg.endpoint = service.endpoint();
+    cfg.connect_timeout_ms = 1000;
+    cfg.request_timeout_ms = 1000;
+    cfg.connection_pool_size = 1;
+    auto client = bt::make_websocket_model_service_client(cfg);
+
+    const auto describe = [&](const std::string& id) {
+        bt::model_service_request request;
+        request.id = id;
+        request.op = bt::model_service_operation::describe;
+        return client->call(request);
+    };
+
+    for (int i = 0; i < 5; ++i) {
+        const std::string id = "seq-" + std::to_string(i);
+        const bt::model_service_response response = describe(id);
+        check(response.status == bt::model_service_status::success, "pooled client call should succeed");
+        check(response.id == id && response.output_json.find(id) != std::string::npos,
+              "pooled client should return the response for its own request");
+    }
+    check(service.accepted() == 1, "sequential calls should reuse one kept-alive connection");
+
+    bt::model_service_response first;
+    bt::model_service_response second;
+    std::thread other([&] { first = describe("pipelined-a"); });
+    second = describe("pipelined-b");
+    other.join();
+    check(first.status == bt::model_service_status::success && first.id == "pipelined-a" &&
+              first.output_json.find("pipelined-a") != std::string::npos,
+          "pipelined call a should be matched by request id");
+    check(second.status == bt::model_service_status::success && second.id == "pipelined-b" &&
+              second.output_json.find("pipelined-b") != std::string::npos,
+          "pipelined call b should be matched by request id");
+    check(service.accepted() == 1, "concurrent calls should be pipelined over the pooled connection");
+
+    // One thread can keep many requests in flight; the client's event loop completes the futures.
+    std::vector<std::future<bt::model_service_response>> futures;
+    for (int i = 0; i < 16; ++i) {
+        bt::model_service_request request;
+        request.id = "async-" + std::to_string(i);
+        request.op = bt::model_service_operation::describe;
+        futures.push_back(client->call_async(request));
+    }
+    for (int i = 0; i < 16; ++i) {
+        const bt::model_service_response response = futures[static_cast<std::size_t>(i)].get();
+        check(response.status == bt::model_service_status::success && response.id == "async-" + std::to_string(i),
+              "async call should complete with its own response");
+    }
+    check(service.accepted() == 1, "async calls should share the pooled connection");
+
+    service.drop_connections();
+    bool reconnected = false;
+    for (int i = 0; i < 200 && !reconnected; ++i) {
+        reconnected = describe("after-drop-" + std::to_string(i)).status == bt::model_service_status::success;
+        if (!reconnected) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+    check(reconnected, "pooled client should reconnect after the service drops the connection");
+    check(service.accepted() == 2, "reconnect should open exactly one new connection");
+}
+#endif
+
 }  // namespace
 
 int main() {
@@ -172,6 +410,10 @@ int main() {
     check(response.error_retryable, "unreachable optional bridge should be retryable");
     check(!response.host_reached, "unreachable optional bridge must not reach host execution");
 
+#if !defined(_WIN32)
+    test_pooled_websocket_client();
+#endif
+
     if (const char* endpoint = std::getenv("MUESLI_BT_MODEL_SERVICE_TEST_ENDPOINT")) {
         bt::model_service_config live_cfg;
         live_cfg.endpoint = endpoint;
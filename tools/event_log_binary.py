@@ -0,0 +1,381 @@
+#!/usr/bin/env python3
+"""Convert between mbt.evt.v1 JSONL and the compact mbt.evt.v1-bin stream.
+
+The binary layout is documented in include/bt/event_binary.hpp; this module mirrors
+bt::event_binary_encoder and bt::transcode_event_binary_to_jsonl so that either side can read
+what the other wrote. Decoding always reproduces the original JSONL byte for byte.
+"""
+
+from __future__ import annotations
+
+import argparse
+import pathlib
+import re
+import sys
+
+
+MAGIC = b"MBTB"
+FORMAT_VERSION = 1
+MAX_STRINGS = 8192
+
+RECORD_STRING = 0x01
+RECORD_RAW_LINE = 0x02
+RECORD_EVENT = 0x10
+EVENT_HAS_TICK = 0x01
+EVENT_TEMPLATED = 0x02
+NUMBER_MARKER = 0x01
+
+_STRING = rb'((?:[^"\\]|\\.)*)'
+ENVELOPE = re.compile(
+    rb'\{"schema":"mbt\.evt\.v1","contract_version":"' + _STRING
+    + rb'","type":"' + _STRING
+    + rb'","run_id":"' + _STRING
+    + rb'","unix_ms":(-?[0-9]+),"seq":([0-9]+)(?:,"tick":([0-9]+))?,"data":(.*)\}',
+    re.DOTALL,
+)
+_ESCAPES = {b"\\": b"\\\\", b'"': b'\\"', b"\n": b"\\n", b"\r": b"\\r", b"\t": b"\\t"}
+_UNESCAPES = {b"\\": b"\\", b'"': b'"', b"n": b"\n", b"r": b"\r", b"t": b"\t"}
+_NUMBER_CHARS = frozenset(b"0123456789-+.eE")
+_INT64_MIN = -(1 << 63)
+_INT64_MAX = (1 << 63) - 1
+_UINT64_MAX = (1 << 64) - 1
+
+
+class FormatError(ValueError):
+    pass
+
+
+def escape(text: bytes) -> bytes:
+    return re.sub(rb'[\\"\n\r\t]', lambda m: _ESCAPES[m.group(0)], text)
+
+
+def unescape(text: bytes) -> bytes | None:
+    out = bytearray()
+    i = 0
+    while i < len(text):
+        c = text[i : i + 1]
+        if c == b"\\":
+            replacement = _UNESCAPES.get(text[i + 1 : i + 2])
+            if replacement is None:
+                return None
+            out += replacement
+            i += 2
+        else:
+            out += c
+            i += 1
+    return bytes(out)
+
+
+def zigzag(value: int) -> int:
+    return ((value << 1) ^ (value >> 63)) & _UINT64_MAX
+
+
+def unzigzag(value: int) -> int:
+    return (value >> 1) ^ -(value & 1)
+
+
+def wrap_int64(value: int) -> int:
+    value &= _UINT64_MAX
+    return value - (1 << 64) if value > _INT64_MAX else value
+
+
+def append_varint(out: bytearray, value: int) -> None:
+    while value >= 0x80:
+        out.append((value & 0x7F) | 0x80)
+        value >>= 7
+    out.append(value)
+
+
+def canonical_integer(text: bytes) -> int | None:
+    try:
+        value = int(text)
+    except ValueError:
+        return None
+    if str(value).encode() != text or not _INT64_MIN <= value <= _INT64_MAX:
+        return None
+    if zigzag(value) >> 63:
+        return None
+    return value
+
+
+def canonical_unsigned(text: bytes) -> int | None:
+    value = int(text)
+    if str(value).encode() != text or value > _UINT64_MAX:
+        return None
+    return value
+
+
+class Encoder:
+    def __init__(self) -> None:
+        self.strings: dict[bytes, int] = {}
+        self.prev_unix_ms = 0
+        self.prev_seq = 0
+        self.prev_tick = 0
+
+    def begin_stream(self, out: bytearray) -> None:
+        self.__init__()
+        out += MAGIC
+        out.append(FORMAT_VERSION)
+
+    def intern(self, out: bytearray, text: bytes) -> int:
+        found = self.strings.get(text)
+        if found is not None:
+            return found
+        string_id = len(self.strings)
+        self.strings[text] = string_id
+        out.append(RECORD_STRING)
+        append_varint(out, len(text))
+        out += text
+        return string_id
+
+    @staticmethod
+    def split_payload(data: bytes) -> tuple[bytes, bytes] | None:
+        template = bytearray()
+        tokens = bytearray()
+        in_string = False
+        i = 0
+        while i < len(data):
+            c = data[i]
+            if c == NUMBER_MARKER:
+                return None
+            if in_string:
+                template.append(c)
+                if c == 0x5C and i + 1 < len(data):
+                    template.append(data[i + 1])
+                    i += 2
+                    continue
+                in_string = c != 0x22
+                i += 1
+                continue
+            if c == 0x22:
+                in_string = True
+                template.append(c)
+                i += 1
+                continue
+            if c == 0x2D or 0x30 <= c <= 0x39:
+                end = i + 1
+                while end < len(data) and data[end] in _NUMBER_CHARS:
+                    end += 1
+                number = data[i:end]
+                integer = canonical_integer(number)
+                if integer is not None:
+                    append_varint(tokens, zigzag(integer) << 1)
+                else:
+                    append_varint(tokens, (len(number) << 1) | 1)
+                    tokens += number
+                template.append(NUMBER_MARKER)
+                i = end
+                continue
+            template.append(c)
+            i += 1
+        return bytes(template), bytes(tokens)
+
+    def encode_line(self, out: bytearray, line: bytes) -> None:
+        match = ENVELOPE.fullmatch(line)
+        fields = None
+        if match is not None:
+            strings = [unescape(match.group(n)) for n in (1, 2, 3)]
+            unix_ms = int(match.group(4))
+            seq = canonical_unsigned(match.group(5))
+            tick = canonical_unsigned(match.group(6)) if match.group(6) is not None else None
+            if (
+                all(s is not None and escape(s) == match.group(n) for n, s in zip((1, 2, 3), strings))
+                and str(unix_ms).encode() == match.group(4)
+                and _INT64_MIN <= unix_ms <= _INT64_MAX
+                and seq is not None
+                and (match.group(6) is None or tick is not None)
+            ):
+                fields = (strings, unix_ms, seq, tick, match.group(7))
+        if fields is None:
+            out.append(RECORD_RAW_LINE)
+            append_varint(out, len(line))
+            out += line
+            return
+        (contract_version, event_type, run_id), unix_ms, seq, tick, data = fields
+        self.encode(out, contract_version, event_type, run_id, unix_ms, seq, tick, data)
+
+    def encode(
+        self,
+        out: bytearray,
+        contract_version: bytes,
+        event_type: bytes,
+        run_id: bytes,
+        unix_ms: int,
+        seq: int,
+        tick: int | None,
+        data: bytes,
+    ) -> None:
+        contract_id = self.intern(out, contract_version)
+        type_id = self.intern(out, event_type)
+        run_id_id = self.intern(out, run_id)
+
+        split = self.split_payload(data)
+        template_id = 0
+        if split is not None:
+            found = self.strings.get(split[0])
+            if found is not None:
+                template_id = found
+            elif len(self.strings) < MAX_STRINGS:
+                template_id = self.intern(out, split[0])
+            else:
+                split = None
+
+        tag = RECORD_EVENT
+        if tick is not None:
+            tag |= EVENT_HAS_TICK
+        if split is not None:
+            tag |= EVENT_TEMPLATED
+        out.append(tag)
+        append_varint(out, contract_id)
+        append_varint(out, type_id)
+        append_varint(out, run_id_id)
+        append_varint(out, zigzag(wrap_int64(unix_ms - self.prev_unix_ms)))
+        append_varint(out, zigzag(wrap_int64(seq - self.prev_seq)))
+        self.prev_unix_ms = unix_ms
+        self.prev_seq = seq
+        if tick is not None:
+            append_varint(out, zigzag(wrap_int64(tick - self.prev_tick)))
+            self.prev_tick = tick
+        if split is not None:
+            append_varint(out, template_id)
+            out += split[1]
+        else:
+            append_varint(out, len(data))
+            out += data
+
+
+def encode_jsonl(jsonl: bytes) -> bytes:
+    """Encodes newline-terminated JSONL; a final line without a newline is kept as is."""
+    out = bytearray()
+    encoder = Encoder()
+    encoder.begin_stream(out)
+    lines = jsonl.split(b"\n")
+    if lines[-1] != b"":
+        raise FormatError("JSONL input must end with a newline")
+    for line in lines[:-1]:
+        encoder.encode_line(out, line)
+    return bytes(out)
+
+
+class _Reader:
+    def __init__(self, data: bytes) -> None:
+        self.data = data
+        self.pos = 0
+
+    def done(self) -> bool:
+        return self.pos == len(self.data)
+
+    def byte(self) -> int:
+        if self.pos >= len(self.data):
+            raise FormatError("mbt.evt.v1-bin: truncated stream")
+        self.pos += 1
+        return self.data[self.pos - 1]
+
+    def varint(self) -> int:
+        value = 0
+        for shift in range(0, 64, 7):
+            b = self.byte()
+            value |= (b & 0x7F) << shift
+            if not b & 0x80:
+                return value & _UINT64_MAX
+        raise FormatError("mbt.evt.v1-bin: varint is too long")
+
+    def bytes(self, count: int) -> bytes:
+        if count > len(self.data) - self.pos:
+            raise FormatError("mbt.evt.v1-bin: truncated stream")
+        self.pos += count
+        return self.data[self.pos - count : self.pos]
+
+
+def decode_to_jsonl(data: bytes) -> bytes:
+    reader = _Reader(data)
+    if reader.bytes(len(MAGIC)) != MAGIC:
+        raise FormatError("mbt.evt.v1-bin: missing stream header")
+    if reader.byte() != FORMAT_VERSION:
+        raise FormatError("mbt.evt.v1-bin: unsupported format version")
+
+    strings: list[bytes] = []
+
+    def string_at(string_id: int) -> bytes:
+        if string_id >= len(strings):
+            raise FormatError("mbt.evt.v1-bin: string id out of range")
+        return strings[string_id]
+
+    out = bytearray()
+    unix_ms = 0
+    seq = 0
+    tick = 0
+    while not reader.done():
+        tag = reader.byte()
+        if tag == RECORD_STRING:
+            strings.append(reader.bytes(reader.varint()))
+            continue
+        if tag == RECORD_RAW_LINE:
+            out += reader.bytes(reader.varint())
+            out += b"\n"
+            continue
+        if tag & ~(EVENT_HAS_TICK | EVENT_TEMPLATED) != RECORD_EVENT:
+            raise FormatError("mbt.evt.v1-bin: unknown record tag")
+        contract_version = string_at(reader.varint())
+        event_type = string_at(reader.varint())
+        run_id = string_at(reader.varint())
+        unix_ms = wrap_int64(unix_ms + unzigzag(reader.varint()))
+        seq = (seq + unzigzag(reader.varint())) & _UINT64_MAX
+        event_tick = None
+        if tag & EVENT_HAS_TICK:
+            tick = (tick + unzigzag(reader.varint())) & _UINT64_MAX
+            event_tick = tick
+
+        if tag & EVENT_TEMPLATED:
+            payload = bytearray()
+            for c in string_at(reader.varint()):
+                if c != NUMBER_MARKER:
+                    payload.append(c)
+                    continue
+                token = reader.varint()
+                if token & 1:
+                    payload += reader.bytes(token >> 1)
+                else:
+                    payload += str(unzigzag(token >> 1)).encode()
+            payload_bytes = bytes(payload)
+        else:
+            payload_bytes = reader.bytes(reader.varint())
+
+        out += b'{"schema":"mbt.evt.v1","contract_version":"' + escape(contract_version)
+        out += b'","type":"' + escape(event_type)
+        out += b'","run_id":"' + escape(run_id)
+        out += b'","unix_ms":' + str(unix_ms).encode()
+        out += b',"seq":' + str(seq).encode()
+        if event_tick is not None:
+            out += b',"tick":' + str(event_tick).encode()
+        out += b',"data":' + payload_bytes + b"}\n"
+    return bytes(out)
+
+
+def parse_args(argv: list[str]) -> argparse.Namespace:
+    parser = argparse.ArgumentParser(description="Convert between mbt.evt.v1 JSONL and mbt.evt.v1-bin.")
+    sub = parser.add_subparsers(dest="command", required=True)
+    encode = sub.add_parser("encode", help="JSONL -> mbt.evt.v1-bin")
+    encode.add_argument("input", type=pathlib.Path)
+    encode.add_argument("output", type=pathlib.Path)
+    decode = sub.add_parser("decode", help="mbt.evt.v1-bin -> JSONL")
+    decode.add_argument("input", type=pathlib.Path)
+    decode.add_argument("output", type=pathlib.Path)
+    return parser.parse_args(argv)
+
+
+def main(argv: list[str]) -> int:
+    args = parse_args(argv)
+    try:
+        data = args.input.read_bytes()
+        converted = encode_jsonl(data) if args.command == "encode" else decode_to_jsonl(data)
+    except (OSError, FormatError) as exc:
+        print(f"event_log_binary: {exc}", file=sys.stderr)
+        return 1
+    args.output.write_bytes(converted)
+    print(f"{args.input} ({len(data)} bytes) -> {args.output} ({len(converted)} bytes)")
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main(sys.argv[1:]))
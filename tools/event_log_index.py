@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+"""Seek into mbt.evt.v1 JSONL logs through their `.idx` sidecars.
+
+The runtime writes a sidecar next to each log segment when `events.set-file-index` is on (see
+bt::event_file_layout in include/bt/event_log.hpp):
+
+    {"schema":"mbt.evt.idx.v1","segment":"run.jsonl","segment_index":0,"index_every":N}
+    {"seq":S,"offset":O,"tick":T}        every N events; tick is the newest tick written so far
+    {"events":E,"bytes":B,"counts":{...}}  when the segment closes; the last one covers the segment
+
+Segments after the first are named `run.1.jsonl`, `run.2.jsonl`, ... and start with a copy of the
+run's `run_start` line. `build` writes the same sidecar for a log recorded without one.
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import pathlib
+import re
+import sys
+from collections.abc import Iterator
+
+
+SCHEMA = "mbt.evt.idx.v1"
+DEFAULT_EVERY = 1024
+
+_STRING = rb'((?:[^"\\]|\\.)*)'
+ENVELOPE = re.compile(
+    rb'^\{"schema":"mbt\.evt\.v1","contract_version":"(?:[^"\\]|\\.)*","type":"' + _STRING
+    + rb'","run_id":"(?:[^"\\]|\\.)*","unix_ms":-?[0-9]+,"seq":([0-9]+)(?:,"tick":([0-9]+))?,"data":'
+)
+
+
+class IndexFormatError(ValueError):
+    pass
+
+
+def line_fields(line: bytes) -> tuple[str, int | None, int | None]:
+    """(type, seq, tick) of one event line, taken from the envelope without parsing the payload."""
+    match = ENVELOPE.match(line)
+    if match:
+        tick = int(match.group(3)) if match.group(3) is not None else None
+        return json.loads(b'"' + match.group(1) + b'"'), int(match.group(2)), tick
+    event = json.loads(line)
+    seq = event.get("seq")
+    tick = event.get("tick")
+    return (
+        str(event.get("type", "")),
+        seq if isinstance(seq, int) else None,
+        tick if isinstance(tick, int) else None,
+    )
+
+
+def segment_path(base: pathlib.Path, index: int) -> pathlib.Path:
+    if index == 0:
+        return base
+    return base.with_name(f"{base.stem}.{index}{base.suffix}")
+
+
+def segment_paths(base: pathlib.Path) -> list[pathlib.Path]:
+    out = []
+    while segment_path(base, len(out)).exists():
+        out.append(segment_path(base, len(out)))
+    return out
+
+
+def build_index(log: bytes, segment: str, segment_index: int = 0, every: int = DEFAULT_EVERY) -> bytes:
+    """Sidecar bytes for one segment, as the runtime would have written them."""
+    if every <= 0:
+        raise IndexFormatError("index interval must be positive")
+    header = {"schema": SCHEMA, "segment": segment, "segment_index": segment_index, "index_every": every}
+    out = [json.dumps(header, separators=(",", ":"))]
+    counts: dict[str, int] = {}
+    last_tick: int | None = None
+    offset = 0
+    events = 0
+    for line in log.splitlines(keepends=True):
+        event_type, seq, tick = line_fields(line.rstrip(b"\n"))
+        if tick is not None:
+            last_tick = tick
+        if events % every == 0:
+            entry = f'{{"seq":{seq if seq is not None else 0},"offset":{offset}'
+            out.append(entry + (f',"tick":{last_tick}}}' if last_tick is not None else "}"))
+        counts[event_type] = counts.get(event_type, 0) + 1
+        offset += len(line)
+        events += 1
+    counts_json = json.dumps(dict(sorted(counts.items())), separators=(",", ":"))
+    out.append(f'{{"events":{events},"bytes":{offset},"counts":{counts_json}}}')
+    return ("\n".join(out) + "\n").encode()
+
+
+def read_index(path: pathlib.Path) -> tuple[dict, list[dict], dict | None]:
+    """(header, entries, counts record) of a sidecar; the counts record is None until the segment closed."""
+    records = [json.loads(line) for line in path.read_text(encoding="utf-8").splitlines() if line.strip()]
+    if not records or records[0].get("schema") != SCHEMA:
+        raise IndexFormatError(f"{path} is not an {SCHEMA} sidecar")
+    entries = [record for record in records[1:] if "offset" in record]
+    closes = [record for record in records[1:] if "counts" in record]
+    return records[0], entries, closes[-1] if closes else None
+
+
+def _start_offset(entries: list[dict], tick: int) -> int:
+    # Every event before an entry has a tick at or before the entry's, so the last entry whose tick is
+    # older than the target is a safe place to start scanning.
+    offset = 0
+    for entry in entries:
+        if entry.get("tick") is not None and entry["tick"] >= tick:
+            break
+        offset = entry["offset"]
+    return offset
+
+
+def lines_from_tick(base: pathlib.Path, tick: int) -> Iterator[bytes]:
+    """Event lines of the log at `base`, starting with the first one on or after `tick`."""
+    segments = segment_paths(base)
+    if not segments:
+        raise IndexFormatError(f"{base} does not exist")
+    indexes = []
+    for path in segments:
+        sidecar = pathlib.Path(str(path) + ".idx")
+        indexes.append(read_index(sidecar)[1] if sidecar.exists() else [])
+
+    # Start in the last segment that opened before the target tick.
+    first = 0
+    for i in range(1, len(segments)):
+        opened_at = indexes[i][0].get("tick") if indexes[i] else None
+        if opened_at is None or opened_at >= tick:
+            break
+        first = i
+
+    found = False
+    for i in range(first, len(segments)):
+        with segments[i].open("rb") as stream:
+            if i == first:
+                stream.seek(_start_offset(indexes[i], tick))
+            elif i > 0:
+                stream.readline()  # run_start copy
+            for line in stream:
+                if not found:
+                    line_tick = line_fields(line.rstrip(b"\n"))[2]
+                    if line_tick is None or line_tick < tick:
+                        continue
+                    found = True
+                yield line
+
+
+def total_counts(base: pathlib.Path) -> dict[str, int]:
+    """Per-type event counts over every segment, not counting the run_start copies."""
+    counts: dict[str, int] = {}
+    for i, path in enumerate(segment_paths(base)):
+        closed = read_index(pathlib.Path(str(path) + ".idx"))[2]
+        if closed is None:
+            raise IndexFormatError(f"{path}.idx has no counts record; the segment was not closed")
+        for event_type, count in closed["counts"].items():
+            counts[event_type] = counts.get(event_type, 0) + count - (1 if i > 0 and event_type == "run_start" else 0)
+    return counts
+
+
+def parse_args(argv: list[str]) -> argparse.Namespace:
+    parser = argparse.ArgumentParser(description="Build and use mbt.evt.v1 JSONL tick indexes.")
+    sub = parser.add_subparsers(dest="command", required=True)
+    build = sub.add_parser("build", help="write <log>.idx for a log recorded without one")
+    build.add_argument("log", type=pathlib.Path)
+    build.add_argument("--every", type=int, default=DEFAULT_EVERY)
+    seek = sub.add_parser("from-tick", help="print events starting at a tick")
+    seek.add_argument("log", type=pathlib.Path)
+    seek.add_argument("tick", type=int)
+    seek.add_argument("--limit", type=int, default=0, help="stop after this many lines (0: no limit)")
+    counts = sub.add_parser("counts", help="print per-type event counts from the sidecars")
+    counts.add_argument("log", type=pathlib.Path)
+    return parser.parse_args(argv)
+
+
+def main(argv: list[str]) -> int:
+    args = parse_args(argv)
+    try:
+        if args.command == "build":
+            index = build_index(args.log.read_bytes(), args.log.name, 0, args.every)
+            pathlib.Path(str(args.log) + ".idx").write_bytes(index)
+        elif args.command == "from-tick":
+            for n, line in enumerate(lines_from_tick(args.log, args.tick)):
+                if args.limit and n >= args.limit:
+                    break
+                sys.stdout.buffer.write(line)
+        else:
+            print(json.dumps(total_counts(args.log), indent=2, sort_keys=True))
+    except (OSError, ValueError) as exc:
+        print(f"event_log_index: {exc}", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main(sys.argv[1:]))
@@ -0,0 +1,213 @@
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bt/event_log_validator.hpp"
+#include "bt/json_writer.hpp"
+
+// Native counterpart of `tools/validate_log.py` plus `tools/validate_trace.py check`: one streaming
+// pass checks every line against the event schema and the cross-event trace rules. Exit codes follow
+// validate_trace.py: 0 pass, 1 fail, 2 usage or I/O error.
+
+namespace {
+
+constexpr const char* k_default_schema = "schemas/event_log/v1/mbt.evt.v1.schema.json";
+constexpr const char* k_validator_version = "0.1.0";
+
+void print_usage(std::ostream& out) {
+    out << "usage: muesli_evt_validate [--schema PATH | --no-schema] [--no-trace] [--tolerate-incomplete-tail]\n"
+           "                           [--threads N] [--report PATH] LOG...\n"
+           "LOG is a JSONL event log or an artefact directory containing events.jsonl.\n";
+}
+
+std::string resolve_log_path(const std::string& arg) {
+    const std::filesystem::path path(arg);
+    return std::filesystem::is_directory(path) ? (path / "events.jsonl").string() : arg;
+}
+
+void write_optional(bt::json_writer& out, std::string_view name, const std::optional<std::int64_t>& v) {
+    out.key(name);
+    if (v) {
+        out.value(*v);
+    } else {
+        out.null();
+    }
+}
+
+void write_violation(bt::json_writer& out, const bt::event_log_violation& v, const std::string& file_name) {
+    out.begin_object();
+    out.field("code", v.code);
+    out.field("severity", v.severity);
+    out.field("file_name", file_name);
+    out.field("message", v.message);
+    out.field("line_no", v.line_no);
+    if (v.seq) {
+        out.field("seq", *v.seq);
+    }
+    if (v.tick) {
+        out.field("tick", *v.tick);
+    }
+    out.end_object();
+}
+
+// The shape of trace_validator.ValidationReport.to_dict() for `check` mode.
+void write_report(bt::json_writer& out,
+                  const bt::event_log_check_report& report,
+                  const std::string& path,
+                  bool tolerate_incomplete_tail) {
+    std::map<std::string, std::size_t> counts;
+    for (const bt::event_log_violation& v : report.violations) {
+        ++counts[v.code];
+    }
+    out.begin_object();
+    out.field("validator_version", k_validator_version);
+    out.field("mode", "check");
+    out.key("input_files").begin_array().value(path).end_array();
+    out.field("passed", report.passed);
+    out.field("trace_truncated", report.trace_truncated);
+    out.key("summary").begin_object();
+    out.field("total_events", report.total_events);
+    out.field("completed_ticks", report.completed_ticks);
+    out.field("distinct_nodes", report.distinct_nodes);
+    out.field("async_jobs", report.async_jobs);
+    write_optional(out, "first_seq", report.first_seq);
+    write_optional(out, "last_seq", report.last_seq);
+    out.end_object();
+    out.key("violation_counts").begin_object();
+    for (const auto& [code, count] : counts) {
+        out.field(code, count);
+    }
+    out.end_object();
+    out.key("first_violation_by_type").begin_object();
+    for (const auto& [code, count] : counts) {
+        (void)count;
+        for (const bt::event_log_violation& v : report.violations) {
+            if (v.code == code) {
+                out.key(code);
+                write_violation(out, v, path);
+                break;
+            }
+        }
+    }
+    out.end_object();
+    out.key("violations").begin_array();
+    for (const bt::event_log_violation& v : report.violations) {
+        write_violation(out, v, path);
+    }
+    out.end_array();
+    out.key("normalisation").begin_object();
+    out.field("profile", "strict_runtime");
+    out.field("tolerate_incomplete_tail", tolerate_incomplete_tail);
+    out.key("ignore_event_types").begin_array().end_array();
+    out.key("drop_fields").begin_array().end_array();
+    out.end_object();
+    out.end_object();
+}
+
+void print_summary(const bt::event_log_check_report& report, const std::string& path) {
+    std::cout << (report.passed ? "PASS: " : "FAIL: ") << path << " (events=" << report.total_events
+              << ", completed_ticks=" << report.completed_ticks << ", violations=" << report.violations.size()
+              << ")\n";
+    if (report.trace_truncated) {
+        std::cout << "  note: tolerant incomplete-tail handling was used; final open tick was accepted as truncated\n";
+    }
+    for (std::size_t i = 0; i < report.violations.size() && i < 5; ++i) {
+        const bt::event_log_violation& v = report.violations[i];
+        std::cout << "  " << v.code << ": " << path << ":" << v.line_no << ": " << v.message << "\n";
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::string schema_path = k_default_schema;
+    bool use_schema = true;
+    std::string report_path;
+    bt::event_log_check_options options;
+    std::vector<std::string> logs;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument(arg + " needs a value");
+            }
+            return argv[++i];
+        };
+        try {
+            if (arg == "-h" || arg == "--help") {
+                print_usage(std::cout);
+                return 0;
+            } else if (arg == "--schema") {
+                schema_path = next();
+            } else if (arg == "--no-schema") {
+                use_schema = false;
+            } else if (arg == "--no-trace") {
+                options.check_trace = false;
+            } else if (arg == "--tolerate-incomplete-tail") {
+                options.tolerate_incomplete_tail = true;
+            } else if (arg == "--threads") {
+                options.threads = static_cast<std::size_t>(std::stoul(next()));
+            } else if (arg == "--report") {
+                report_path = next();
+            } else if (!arg.empty() && arg.front() == '-') {
+                throw std::invalid_argument("unknown option " + arg);
+            } else {
+                logs.push_back(arg);
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "muesli_evt_validate: " << e.what() << "\n";
+            print_usage(std::cerr);
+            return 2;
+        }
+    }
+    if (logs.empty()) {
+        print_usage(std::cerr);
+        return 2;
+    }
+
+    try {
+        bt::event_schema schema;
+        if (use_schema) {
+            schema = bt::event_schema::load(schema_path);
+            options.schema = &schema;
+        }
+
+        bool passed = true;
+        bt::json_writer report;
+        if (logs.size() > 1) {
+            report.begin_array();
+        }
+        for (const std::string& arg : logs) {
+            const std::string path = resolve_log_path(arg);
+            const bt::event_log_check_report result = bt::check_event_log_file(path, options);
+            print_summary(result, path);
+            write_report(report, result, path, options.tolerate_incomplete_tail);
+            passed = passed && result.passed;
+        }
+        if (logs.size() > 1) {
+            report.end_array();
+        }
+        if (!report_path.empty()) {
+            const std::filesystem::path out_path(report_path);
+            if (out_path.has_parent_path()) {
+                std::filesystem::create_directories(out_path.parent_path());
+            }
+            std::ofstream out(out_path);
+            out << report.view() << "\n";
+            if (!out) {
+                throw std::runtime_error("cannot write report " + report_path);
+            }
+        }
+        return passed ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << "muesli_evt_validate: " << e.what() << "\n";
+        return 2;
+    }
+}
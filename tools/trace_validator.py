@@ -65,6 +65,8 @@ PROFILE_PRESETS: dict[str, dict[str, Any]] = {
 
 TERMINAL_NODE_STATUSES = {"success", "failure"}
 TERMINAL_VLA_STATUSES = {"done", "cancelled", "error", "timeout"}
+# compact-ids profile: status_id indexes this list; key ids come from bt_def string tables.
+COMPACT_STATUS_NAMES = ("success", "failure", "running")
 
 
 class UsageError(RuntimeError):
@@ -262,12 +264,43 @@ def load_config(path: str | None, profile: str) -> CheckConfig:
     )
 
 
+def _expand_compact_ids(raw: Any, keys: dict[int, str]) -> Any:
+    """Rewrites a compact-ids event into its canonical form, learning key ids from bt_def."""
+    if not isinstance(raw, dict) or not isinstance(raw.get("data"), dict):
+        return raw
+    data = raw["data"]
+    event_type = raw.get("type")
+    if event_type == "run_start":
+        keys.clear()
+        return raw
+    if event_type == "bt_def":
+        table = data.get("string_table")
+        if isinstance(table, dict) and isinstance(table.get("key_base"), int) and isinstance(table.get("keys"), list):
+            for offset, text in enumerate(table["keys"]):
+                if isinstance(text, str):
+                    keys[table["key_base"] + offset] = text
+        return raw
+    if "status_id" not in data and "key_id" not in data:
+        return raw
+    expanded: dict[str, Any] = {}
+    for name, value in data.items():
+        if name == "status_id" and isinstance(value, int) and 0 <= value < len(COMPACT_STATUS_NAMES):
+            expanded["status"] = COMPACT_STATUS_NAMES[value]
+        elif name == "key_id" and isinstance(value, int) and value in keys:
+            expanded["key"] = keys[value]
+        else:
+            expanded[name] = value
+    raw["data"] = expanded
+    return raw
+
+
 def load_trace(path_arg: str) -> list[TraceEvent]:
     log_path = resolve_log_path(path_arg)
     if not log_path.is_file():
         raise UsageError(f"log file not found: {log_path}")
 
     events: list[TraceEvent] = []
+    compact_keys: dict[int, str] = {}
     with log_path.open("r", encoding="utf-8") as handle:
         for line_no, line in enumerate(handle, start=1):
             text = line.strip()
@@ -277,6 +310,7 @@ def load_trace(path_arg: str) -> list[TraceEvent]:
                 raw = json.loads(text)
             except json.JSONDecodeError as exc:
                 raise UsageError(f"{log_path}:{line_no}: invalid JSON: {exc}") from exc
+            raw = _expand_compact_ids(raw, compact_keys)
             data = raw.get("data")
             node_id: int | None = None
             status: str | None = None
@@ -978,7 +1012,7 @@ def _host_capability(data: dict[str, Any]) -> str | None:
 
 
 def _blackboard_key(event_type: str | None, data: dict[str, Any]) -> str | None:
-    if event_type not in {"bb_write", "bb_delete", "bb_snapshot"}:
+    if event_type not in {"bb_write", "bb_delete", "bb_snapshot", "bb_delta"}:
         return None
     key = data.get("key")
     if key is not None: